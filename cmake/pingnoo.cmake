@@ -260,6 +260,7 @@ macro(pingnoo_end_component)
     pingnoo_set_component_outputs()
 
     add_logging_library()
+    add_profiler_library()
 
     target_include_directories(${pingnooCurrentProjectName} PRIVATE ".")
 
@@ -300,6 +301,7 @@ macro(pingnoo_end_shared_library)
     pingnoo_set_library_outputs()
 
     add_logging_library()
+    add_profiler_library()
 
     target_include_directories(${pingnooCurrentProjectName} PRIVATE ".")
 
@@ -331,6 +333,7 @@ macro(pingnoo_end_static_library)
     endif()
 
     add_logging_library()
+    add_profiler_library()
 
     target_include_directories(${pingnooCurrentProjectName} PRIVATE ".")
 
@@ -376,6 +379,7 @@ macro(pingnoo_end_executable)
     endif()
 
     add_logging_library()
+    add_profiler_library()
 
     target_include_directories(${pingnooCurrentProjectName} PRIVATE ".")
 
@@ -396,6 +400,30 @@ macro(add_logging_library)
     target_link_libraries(${PROJECT_NAME} spdlog::spdlog_header_only)
 endmacro(add_logging_library)
 
+# the profiling zones in <Profiler> are only compiled in when a profiler is selected with Pingnoo_Profiler.
+
+macro(add_profiler_library)
+    if (Pingnoo_Profiler STREQUAL "Tracy")
+        find_package(Tracy CONFIG REQUIRED)
+
+        target_compile_definitions(${PROJECT_NAME} PRIVATE PINGNOO_PROFILER_TRACY)
+
+        target_link_libraries(${PROJECT_NAME} Tracy::TracyClient)
+    elseif (Pingnoo_Profiler STREQUAL "ITT")
+        find_path(PINGNOO_ITT_INCLUDE_DIR ittnotify.h PATH_SUFFIXES include)
+        find_library(PINGNOO_ITT_LIBRARY NAMES ittnotify libittnotify)
+
+        if (NOT PINGNOO_ITT_INCLUDE_DIR OR NOT PINGNOO_ITT_LIBRARY)
+            message(FATAL_ERROR "Pingnoo_Profiler is ITT but ittnotify could not be found.")
+        endif()
+
+        target_compile_definitions(${PROJECT_NAME} PRIVATE PINGNOO_PROFILER_ITT)
+
+        target_include_directories(${PROJECT_NAME} PRIVATE ${PINGNOO_ITT_INCLUDE_DIR})
+        target_link_libraries(${PROJECT_NAME} ${PINGNOO_ITT_LIBRARY} ${CMAKE_DL_LIBS})
+    endif()
+endmacro(add_profiler_library)
+
 macro(pingnoo_use_qt_libraries)
     set(pingnooFindPackageList "")
     set(pingnooLinkPackageList "")
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PingAgent.h"
+
+#include "PingAgentSession.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <spdlog/spdlog.h>
+
+#if defined(Q_OS_UNIX)
+#include <QFile>
+#include <grp.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+Nedrysoft::PingAgent::PingAgent::PingAgent(Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory) :
+        m_pingEngineFactory(pingEngineFactory),
+        m_localServer(nullptr),
+        m_tcpServer(nullptr) {
+
+}
+
+Nedrysoft::PingAgent::PingAgent::~PingAgent() {
+    /**
+     * the sessions are children of the agent, they are deleted (and their engines with them) before the
+     * component that provides the engine factory is unloaded.
+     */
+
+    qDeleteAll(findChildren<PingAgentSession *>(QString(), Qt::FindDirectChildrenOnly));
+}
+
+auto Nedrysoft::PingAgent::PingAgent::listenLocal(const QString &name, const QString &group) -> bool {
+    m_localServer = new QLocalServer(this);
+
+    m_localServer->setSocketOptions(QLocalServer::UserAccessOption | QLocalServer::GroupAccessOption);
+
+    QLocalServer::removeServer(name);
+
+    if (!m_localServer->listen(name)) {
+        SPDLOG_ERROR(QString("Unable to listen on %1. (%2)").arg(name).arg(m_localServer->errorString()).toStdString());
+
+        return false;
+    }
+
+    if (!group.isEmpty()) {
+#if defined(Q_OS_UNIX)
+        auto groupEntry = getgrnam(group.toLocal8Bit().constData());
+
+        if ((!groupEntry) ||
+            (chown(QFile::encodeName(m_localServer->fullServerName()).constData(), -1, groupEntry->gr_gid)==-1)) {
+
+            SPDLOG_ERROR(QString("Unable to give %1 to the group %2.").arg(name).arg(group).toStdString());
+
+            m_localServer->close();
+
+            return false;
+        }
+#else
+        SPDLOG_WARN("The group of the local socket can only be set on Linux and macOS.");
+#endif
+    }
+
+    connect(m_localServer, &QLocalServer::newConnection, this, [=]() {
+        while (m_localServer->hasPendingConnections()) {
+            auto socket = m_localServer->nextPendingConnection();
+            auto session = new PingAgentSession(m_pingEngineFactory, socket);
+
+            session->setParent(this);
+
+            connect(socket, &QLocalSocket::disconnected, session, &PingAgentSession::deleteLater);
+        }
+    });
+
+    return true;
+}
+
+auto Nedrysoft::PingAgent::PingAgent::listenTcp(
+        const QHostAddress &address,
+        quint16 port,
+        const QByteArray &secret) -> bool {
+
+    // the engine sends with the privileges of the agent, so it is never offered to unauthenticated peers.
+
+    if (secret.isEmpty()) {
+        SPDLOG_ERROR("A secret is required to listen for TCP clients.");
+
+        return false;
+    }
+
+    m_secret = secret;
+    m_tcpServer = new QTcpServer(this);
+
+    if (!m_tcpServer->listen(address, port)) {
+        SPDLOG_ERROR(QString("Unable to listen on %1:%2. (%3)")
+                .arg(address.toString())
+                .arg(port)
+                .arg(m_tcpServer->errorString()).toStdString());
+
+        return false;
+    }
+
+    connect(m_tcpServer, &QTcpServer::newConnection, this, [=]() {
+        while (m_tcpServer->hasPendingConnections()) {
+            auto socket = m_tcpServer->nextPendingConnection();
+            auto session = new PingAgentSession(m_pingEngineFactory, socket, m_secret);
+
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+            session->setParent(this);
+
+            connect(socket, &QTcpSocket::disconnected, session, &PingAgentSession::deleteLater);
+        }
+    });
+
+    return true;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_AGENT_PINGAGENT_H
+#define PINGNOO_AGENT_PINGAGENT_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QTcpServer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngineFactory;
+}}
+
+namespace Nedrysoft { namespace PingAgent {
+    /**
+     * @brief       The PingAgent class accepts connections from ping clients.
+     *
+     * @details     The agent runs with the privileges required to open raw sockets, clients connect over a local
+     *              socket (or TCP for a remote vantage point) and each is served by a PingAgentSession.
+     *
+     *              The local socket is only accessible to the user and group of the agent, a TCP client must
+     *              prove that it knows the shared secret before the agent will act on any of its messages.
+     *
+     * @note        The TCP connection is not encrypted, the secret is never sent but the targets and results are.
+     */
+    class PingAgent :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a PingAgent.
+             *
+             * @param[in]   pingEngineFactory the factory used to create the engines for clients.
+             */
+            explicit PingAgent(Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory);
+
+            /**
+             * @brief       Destroys the PingAgent.
+             */
+            ~PingAgent();
+
+            /**
+             * @brief       Listens for clients on a local socket.
+             *
+             * @details     The socket is accessible to the user and group of the agent, giving the socket to a
+             *              group (for example pingnoo) lets its members use the agent without elevated privileges.
+             *
+             * @param[in]   name the name of the local socket.
+             * @param[in]   group the group to give the socket to, empty to keep the group of the agent.
+             *
+             * @returns     true if listening; otherwise false.
+             */
+            auto listenLocal(const QString &name, const QString &group = QString()) -> bool;
+
+            /**
+             * @brief       Listens for clients on a TCP port.
+             *
+             * @param[in]   address the address to bind to.
+             * @param[in]   port the port to listen on.
+             * @param[in]   secret the secret that clients must prove they know, the agent will not listen without.
+             *
+             * @returns     true if listening; otherwise false.
+             */
+            auto listenTcp(const QHostAddress &address, quint16 port, const QByteArray &secret) -> bool;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::IPingEngineFactory *m_pingEngineFactory;
+            QLocalServer *m_localServer;
+            QTcpServer *m_tcpServer;
+            QByteArray m_secret;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_AGENT_PINGAGENT_H
@@ -0,0 +1,475 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PingAgentSession.h"
+
+#include <IPingEngineFactory>
+#include <IPingTarget>
+#include <QIODevice>
+#include <QLocalSocket>
+#include <SharedResultRing>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+constexpr auto BatchInterval = 20;
+constexpr auto SingleShotPollInterval = 10;
+constexpr auto MaximumPendingBytes = 4*1024*1024;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto MinimumInterval = 100;
+constexpr auto MinimumTimeout = 100;
+constexpr auto MaximumTargets = 1024;
+constexpr auto MaximumPendingSingleShots = 256;
+
+using MessageType = Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType;
+using RemotePingProtocol = Nedrysoft::RemotePingEngine::RemotePingProtocol;
+
+Nedrysoft::PingAgent::PingAgentSession::PingAgentSession(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+        QIODevice *socket,
+        const QByteArray &secret ) :
+            m_pingEngineFactory(pingEngineFactory),
+            m_pingEngine(nullptr),
+            m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+            m_isRunning(false),
+            m_socket(socket),
+            m_secret(secret),
+            m_challenge(RemotePingProtocol::createChallenge()),
+            m_authenticated(secret.isEmpty()),
+            m_batchTimer(new QTimer(this)),
+            m_sharedRing(nullptr),
+            m_singleShotTimer(new QTimer(this)) {
+
+    m_socket->setParent(this);
+
+    m_batchTimer->setSingleShot(true);
+    m_batchTimer->setInterval(BatchInterval);
+
+    m_singleShotTimer->setInterval(SingleShotPollInterval);
+
+    connect(m_batchTimer, &QTimer::timeout, this, &PingAgentSession::sendResults);
+    connect(m_singleShotTimer, &QTimer::timeout, this, &PingAgentSession::pollSingleShots);
+    connect(m_socket, &QIODevice::readyRead, this, &PingAgentSession::onReadyRead);
+
+    send(MessageType::Hello, RemotePingProtocol::encodeHello(m_challenge));
+}
+
+Nedrysoft::PingAgent::PingAgentSession::~PingAgentSession() {
+    disconnect(m_socket, nullptr, this, nullptr);
+
+    deleteEngine();
+
+    delete m_sharedRing;
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::onReadyRead() -> void {
+    m_receiveBuffer.append(m_socket->readAll());
+
+    MessageType type;
+    QByteArray payload;
+
+    while (true) {
+        auto status = RemotePingProtocol::takeFrame(m_receiveBuffer, type, payload);
+
+        if (status==RemotePingProtocol::FrameStatus::Incomplete) {
+            return;
+        }
+
+        if ((status==RemotePingProtocol::FrameStatus::Invalid) || (!processMessage(type, payload))) {
+            SPDLOG_WARN("Invalid message received from client, closing connection.");
+
+            m_socket->close();
+
+            deleteLater();
+
+            return;
+        }
+    }
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::processMessage(MessageType type, const QByteArray &payload) -> bool {
+    if (!m_authenticated) {
+        if ((type!=MessageType::Authenticate) ||
+            (!RemotePingProtocol::verifyAuthentication(payload, m_secret, m_challenge))) {
+
+            SPDLOG_WARN("Client did not authenticate.");
+
+            return false;
+        }
+
+        m_authenticated = true;
+
+        return true;
+    }
+
+    switch (type) {
+        case MessageType::Subscribe: {
+            RemotePingProtocol::Subscription subscription;
+
+            if (!RemotePingProtocol::decodeSubscription(payload, subscription)) {
+                return false;
+            }
+
+            subscribe(subscription);
+
+            return true;
+        }
+
+        case MessageType::AddTarget: {
+            RemotePingProtocol::Target target;
+
+            if (!RemotePingProtocol::decodeTarget(payload, target)) {
+                return false;
+            }
+
+            if ((!m_targets.contains(target.id)) && (m_targets.count()>=MaximumTargets)) {
+                SPDLOG_WARN(QString("Client exceeded the limit of %1 targets.").arg(MaximumTargets).toStdString());
+
+                return false;
+            }
+
+            m_targets[target.id] = target;
+
+            addTarget(target);
+
+            return true;
+        }
+
+        case MessageType::RemoveTarget: {
+            quint32 id;
+
+            if (!RemotePingProtocol::decodeTargetId(payload, id)) {
+                return false;
+            }
+
+            m_targets.remove(id);
+
+            auto pingTarget = m_pingTargets.take(id);
+
+            if ((pingTarget) && (m_pingEngine)) {
+                m_pingEngine->removeTarget(pingTarget);
+            }
+
+            return true;
+        }
+
+        case MessageType::Start: {
+            m_isRunning = true;
+
+            if (m_pingEngine) {
+                m_pingEngine->start();
+            }
+
+            return true;
+        }
+
+        case MessageType::Stop: {
+            m_isRunning = false;
+
+            if (m_pingEngine) {
+                m_pingEngine->stop();
+            }
+
+            return true;
+        }
+
+        case MessageType::SingleShot: {
+            RemotePingProtocol::SingleShotRequest request;
+
+            if ((!RemotePingProtocol::decodeSingleShot(payload, request)) || (!m_pingEngine)) {
+                return false;
+            }
+
+            if (m_singleShots.count()>=MaximumPendingSingleShots) {
+                SPDLOG_WARN(QString("Client exceeded the limit of %1 outstanding single shot requests.")
+                        .arg(MaximumPendingSingleShots).toStdString());
+
+                return false;
+            }
+
+            auto timeout = qMax(request.timeout, MinimumTimeout)/MillisecondsInSecond;
+
+            auto singleShot = new SingleShot {
+                request.id,
+                (request.flowIdentifier==-1) ?
+                    m_pingEngine->singleShotAsync(request.hostAddress, request.ttl, timeout) :
+                    m_pingEngine->singleShotFlowAsync(
+                            request.hostAddress,
+                            request.ttl,
+                            timeout,
+                            static_cast<uint16_t>(request.flowIdentifier) )
+            };
+
+            m_singleShots.append(singleShot);
+
+            if (!m_singleShotTimer->isActive()) {
+                m_singleShotTimer->start();
+            }
+
+            return true;
+        }
+
+        case MessageType::AttachSharedRing: {
+            int capacity;
+
+            if (!RemotePingProtocol::decodeSharedRing(payload, capacity)) {
+                return false;
+            }
+
+            attachSharedRing(capacity);
+
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::subscribe(const RemotePingProtocol::Subscription &subscription) -> void {
+    if ((m_pingEngine) && (m_ipVersion!=subscription.ipVersion)) {
+        deleteEngine();
+    }
+
+    auto createdEngine = false;
+
+    if (!m_pingEngine) {
+        m_ipVersion = subscription.ipVersion;
+        m_pingEngine = m_pingEngineFactory->createEngine(m_ipVersion);
+
+        m_pingEngine->setResultBatching(true);
+
+        connect(m_pingEngine, &Nedrysoft::RouteAnalyser::IPingEngine::result,
+                this, [=](Nedrysoft::RouteAnalyser::PingResult result) {
+
+            queueResults(QVector<Nedrysoft::RouteAnalyser::PingResult>() << result);
+        });
+
+        connect(m_pingEngine, &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+                this, &PingAgentSession::queueResults);
+
+        createdEngine = true;
+    }
+
+    m_pingEngine->setInterval(qMax(subscription.interval, MinimumInterval));
+    m_pingEngine->setTimeout(qMax(subscription.timeout, MinimumTimeout));
+    m_pingEngine->setPayloadSize(subscription.payloadSize);
+    m_pingEngine->setDontFragment(subscription.dontFragment);
+    m_pingEngine->setFlowStable(subscription.flowStable);
+
+    if (createdEngine) {
+        for (auto &target : m_targets) {
+            addTarget(target);
+        }
+
+        if (m_isRunning) {
+            m_pingEngine->start();
+        }
+    }
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::addTarget(const RemotePingProtocol::Target &target) -> void {
+    if (!m_pingEngine) {
+        return;
+    }
+
+    auto pingTarget = m_pingEngine->addTarget(target.hostAddress, target.ttl);
+
+    pingTarget->setPayloadSize(target.payloadSize);
+    pingTarget->setUserData(reinterpret_cast<void *>(static_cast<quintptr>(target.id)));
+
+    m_pingTargets[target.id] = pingTarget;
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::deleteEngine() -> void {
+    if (!m_pingEngine) {
+        return;
+    }
+
+    m_singleShotTimer->stop();
+
+    for (auto singleShot : m_singleShots) {
+        singleShot->result.wait();
+    }
+
+    qDeleteAll(m_singleShots);
+
+    m_singleShots.clear();
+
+    m_pingEngine->stop();
+
+    m_pingEngineFactory->deleteEngine(m_pingEngine);
+
+    m_pingEngine = nullptr;
+
+    m_pingTargets.clear();
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::queueResults(
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    for (auto &result : results) {
+        if (!result.target()) {
+            continue;
+        }
+
+        m_pendingResults.append(RemotePingProtocol::ResultRecord {
+            static_cast<quint32>(reinterpret_cast<quintptr>(result.target()->userData())),
+            result
+        });
+    }
+
+    if ((!m_pendingResults.isEmpty()) && (!m_batchTimer->isActive())) {
+        m_batchTimer->start();
+    }
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::attachSharedRing(int capacity) -> void {
+    delete m_sharedRing;
+
+    m_sharedRing = nullptr;
+
+    /**
+     * the agent creates the segment itself, it never maps memory that the client could resize underneath it.  The
+     * descriptor travels with the reply, which is written directly to the socket so it must not be queued behind
+     * anything still buffered.
+     */
+
+    auto localSocket = qobject_cast<QLocalSocket *>(m_socket);
+
+    if (localSocket) {
+        localSocket->flush();
+    }
+
+    if ((localSocket) && (localSocket->bytesToWrite()==0)) {
+        auto ring = Nedrysoft::RemotePingEngine::SharedResultRing::create(capacity);
+
+        if (ring) {
+            auto reply = RemotePingProtocol::frame(
+                    MessageType::SharedRingAttached,
+                    RemotePingProtocol::encodeSharedRingStatus(true) );
+
+            auto written = Nedrysoft::RemotePingEngine::SharedResultRing::sendDescriptor(
+                    localSocket->socketDescriptor(),
+                    reply,
+                    ring->descriptor() );
+
+            if (written>0) {
+                if (written<reply.size()) {
+                    m_socket->write(reply.mid(static_cast<int>(written)));
+                }
+
+                ring->closeDescriptor();
+
+                m_sharedRing = ring;
+
+                return;
+            }
+
+            delete ring;
+        }
+    }
+
+    SPDLOG_WARN("Unable to create a shared ring, results will be sent on the socket.");
+
+    send(MessageType::SharedRingAttached, RemotePingProtocol::encodeSharedRingStatus(false));
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::sendResults() -> void {
+    if (m_pendingResults.isEmpty()) {
+        return;
+    }
+
+    if (m_sharedRing) {
+        auto written = 0;
+
+        for (auto &record : m_pendingResults) {
+            if (!m_sharedRing->write(record.id, record.result)) {
+                break;
+            }
+
+            written++;
+        }
+
+        m_sharedRing->publish();
+
+        // as with the socket, a client that is not reading its results loses them rather than stalling the agent.
+
+        if (written<m_pendingResults.count()) {
+            SPDLOG_WARN(QString("Client is not reading results, discarding %1 results.")
+                    .arg(m_pendingResults.count()-written).toStdString());
+        }
+
+        m_pendingResults.clear();
+
+        return;
+    }
+
+    /**
+     * a client that is not reading its results would otherwise cause the agent to buffer without limit, the
+     * results are discarded until the client catches up.
+     */
+
+    if (m_socket->bytesToWrite()>MaximumPendingBytes) {
+        SPDLOG_WARN(QString("Client is not reading results, discarding %1 results.")
+                .arg(m_pendingResults.count()).toStdString());
+    } else {
+        send(MessageType::Results, RemotePingProtocol::encodeResults(m_pendingResults));
+    }
+
+    m_pendingResults.clear();
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::pollSingleShots() -> void {
+    auto completed = QVector<RemotePingProtocol::ResultRecord>();
+
+    for (auto iterator = m_singleShots.begin(); iterator!=m_singleShots.end();) {
+        auto singleShot = *iterator;
+
+        if (singleShot->result.wait_for(std::chrono::seconds(0))!=std::future_status::ready) {
+            iterator++;
+
+            continue;
+        }
+
+        completed.append(RemotePingProtocol::ResultRecord {singleShot->id, singleShot->result.get()});
+
+        delete singleShot;
+
+        iterator = m_singleShots.erase(iterator);
+    }
+
+    if (!completed.isEmpty()) {
+        send(MessageType::SingleShotResult, RemotePingProtocol::encodeResults(completed));
+    }
+
+    if (m_singleShots.isEmpty()) {
+        m_singleShotTimer->stop();
+    }
+}
+
+auto Nedrysoft::PingAgent::PingAgentSession::send(MessageType type, const QByteArray &payload) -> void {
+    m_socket->write(RemotePingProtocol::frame(type, payload));
+}
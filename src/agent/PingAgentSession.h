@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_AGENT_PINGAGENTSESSION_H
+#define PINGNOO_AGENT_PINGAGENTSESSION_H
+
+#include <IPingEngine>
+#include <RemotePingProtocol>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QVector>
+#include <future>
+
+class QIODevice;
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngineFactory;
+    class IPingTarget;
+}}
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    class SharedResultRing;
+}}
+
+namespace Nedrysoft { namespace PingAgent {
+    /**
+     * @brief       The PingAgentSession class serves a single client of the ping agent.
+     *
+     * @details     Each client is given its own engine which is configured by the messages it sends, the results
+     *              of the engine are collected and sent to the client in batches.  The session deletes itself
+     *              if the client sends an invalid message, the agent deletes it when the client disconnects.
+     *
+     *              A client on the same host may ask for a shared memory ring, the agent creates the ring and
+     *              passes it to the client over the local socket, the batches are then written into the ring
+     *              rather than encoded onto the socket.
+     *
+     *              The engine sends with the privileges of the agent, so every client is limited: the interval and
+     *              timeout are raised to a minimum and the number of targets and outstanding single shot requests
+     *              is capped.  A client that must authenticate (one connected over TCP) is disconnected if any
+     *              message other than a correct answer to the challenge comes first.
+     */
+    class PingAgentSession :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a PingAgentSession for a connected client.
+             *
+             * @param[in]   pingEngineFactory the factory used to create the engine for the client.
+             * @param[in]   socket the connection to the client, the session takes ownership of the socket.
+             * @param[in]   secret the secret the client must prove it knows, empty if it need not authenticate.
+             */
+            PingAgentSession(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                    QIODevice *socket,
+                    const QByteArray &secret = QByteArray() );
+
+            /**
+             * @brief       Destroys the PingAgentSession.
+             */
+            ~PingAgentSession();
+
+        private:
+            /**
+             * @brief       Processes the frames received from the client.
+             */
+            auto onReadyRead() -> void;
+
+            /**
+             * @brief       Processes a single message from the client.
+             *
+             * @param[in]   type the type of message.
+             * @param[in]   payload the payload of the message.
+             *
+             * @returns     true if the message was valid; otherwise false.
+             */
+            auto processMessage(
+                    Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType type,
+                    const QByteArray &payload ) -> bool;
+
+            /**
+             * @brief       Applies new engine settings, the engine is created (or recreated for a new IP version)
+             *              as required.
+             *
+             * @param[in]   subscription the settings.
+             */
+            auto subscribe(const Nedrysoft::RemotePingEngine::RemotePingProtocol::Subscription &subscription) -> void;
+
+            /**
+             * @brief       Adds a target to the engine.
+             *
+             * @param[in]   target the target.
+             */
+            auto addTarget(const Nedrysoft::RemotePingEngine::RemotePingProtocol::Target &target) -> void;
+
+            /**
+             * @brief       Stops and deletes the engine, waiting for any single shot requests to complete.
+             */
+            auto deleteEngine() -> void;
+
+            /**
+             * @brief       Queues results from the engine to be sent in the next batch.
+             *
+             * @param[in]   results the results.
+             */
+            auto queueResults(const QVector<Nedrysoft::RouteAnalyser::PingResult> &results) -> void;
+
+            /**
+             * @brief       Creates a shared memory ring for the client and replies with the outcome, the ring is passed
+             *              to the client with the reply.
+             *
+             * @param[in]   capacity the number of results the ring should hold.
+             */
+            auto attachSharedRing(int capacity) -> void;
+
+            /**
+             * @brief       Sends the queued results to the client.
+             */
+            auto sendResults() -> void;
+
+            /**
+             * @brief       Sends the results of any single shot requests that have completed.
+             */
+            auto pollSingleShots() -> void;
+
+            /**
+             * @brief       Sends a message to the client.
+             *
+             * @param[in]   type the type of message.
+             * @param[in]   payload the payload of the message.
+             */
+            auto send(
+                    Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType type,
+                    const QByteArray &payload = QByteArray() ) -> void;
+
+        private:
+            //! @cond
+
+            struct SingleShot {
+                quint32 id;
+                std::future<Nedrysoft::RouteAnalyser::PingResult> result;
+            };
+
+            Nedrysoft::RouteAnalyser::IPingEngineFactory *m_pingEngineFactory;
+            Nedrysoft::RouteAnalyser::IPingEngine *m_pingEngine;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            bool m_isRunning;
+
+            QIODevice *m_socket;
+            QByteArray m_receiveBuffer;
+
+            QByteArray m_secret;
+            QByteArray m_challenge;
+            bool m_authenticated;
+
+            QMap<quint32, Nedrysoft::RemotePingEngine::RemotePingProtocol::Target> m_targets;
+            QMap<quint32, Nedrysoft::RouteAnalyser::IPingTarget *> m_pingTargets;
+
+            QVector<Nedrysoft::RemotePingEngine::RemotePingProtocol::ResultRecord> m_pendingResults;
+            QTimer *m_batchTimer;
+
+            Nedrysoft::RemotePingEngine::SharedResultRing *m_sharedRing;
+
+            QList<SingleShot *> m_singleShots;
+            QTimer *m_singleShotTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_AGENT_PINGAGENTSESSION_H
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PingAgent.h"
+
+#include <Component>
+#include <IComponentManager>
+#include <IPingEngineFactory>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QProcessEnvironment>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+constexpr auto DefaultLocalName = "pingnoo-agent";
+constexpr auto ReflectorEnvironmentVariable = "PINGNOO_TWAMP_REFLECTOR";
+
+/**
+ * the agent only needs the ping engines, the remote ping engine is excluded as the agent would be its own client.
+ */
+static auto isAgentComponent(Nedrysoft::ComponentSystem::Component *component) -> bool {
+    auto name = component->name();
+
+    if ((name=="Core") || (name=="RouteAnalyser")) {
+        return true;
+    }
+
+    return name.endsWith("PingEngine") && (name!="RemotePingEngine");
+}
+
+int main(int argc, char **argv) {
+    QCoreApplication applicationInstance(argc, argv);
+
+    QCoreApplication::setApplicationName("Pingnoo");
+    QCoreApplication::setOrganizationName("Nedrysoft");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription(QObject::tr("Sends pings on behalf of Pingnoo clients."));
+    parser.addHelpOption();
+
+    QCommandLineOption localOption("local", QObject::tr("Listen on the local socket <name>."), "name",
+                                   DefaultLocalName);
+    QCommandLineOption listenOption("listen", QObject::tr("Also listen for TCP clients on <address:port>."),
+                                    "address:port");
+    QCommandLineOption engineOption("engine", QObject::tr("Use the ping engine matching <name>."), "name");
+    QCommandLineOption reflectorOption("reflector", QObject::tr("Also reflect TWAMP test packets on <port>."),
+                                       "port");
+    QCommandLineOption groupOption("local-group", QObject::tr("Give the local socket to the group <name>."), "name");
+    QCommandLineOption secretOption("secret-file", QObject::tr("Read the secret for TCP clients from <path>."),
+                                    "path");
+
+    parser.addOptions({localOption, listenOption, engineOption, reflectorOption, groupOption, secretOption});
+
+    parser.process(applicationInstance);
+
+    // the secret is read from a file so that it does not appear in the process list.
+
+    QByteArray secret;
+
+    if (parser.isSet(secretOption)) {
+        QFile secretFile(parser.value(secretOption));
+
+        if (!secretFile.open(QFile::ReadOnly)) {
+            SPDLOG_ERROR(QString("Unable to read the secret from %1.").arg(secretFile.fileName()).toStdString());
+
+            return 1;
+        }
+
+        secret = secretFile.readAll().trimmed();
+    }
+
+    // the reflector is started by the TWAMP component when it is initialised.
+
+    if (parser.isSet(reflectorOption)) {
+        qputenv(ReflectorEnvironmentVariable, parser.value(reflectorOption).toUtf8());
+    }
+
+    auto componentLoader = new Nedrysoft::ComponentSystem::ComponentLoader;
+    auto applicationDir = QDir(QCoreApplication::applicationDirPath());
+
+    Nedrysoft::ComponentSystem::IComponentManager::getInstance()->addObject(componentLoader);
+
+    QStringList componentLocations = QStringList() << "APPDIR" << "PINGNOO_COMPONENT_DIR";
+
+    for(auto dirName : componentLocations) {
+        if (QProcessEnvironment::systemEnvironment().contains(dirName)) {
+            componentLoader->addComponents(QProcessEnvironment::systemEnvironment().value(dirName) + "/Components");
+        }
+    }
+
+    if (applicationDir.exists("Components")) {
+        componentLoader->addComponents(applicationDir.absoluteFilePath("Components"));
+    }
+
+    componentLoader->loadComponents([](Nedrysoft::ComponentSystem::Component *component) -> bool {
+        return isAgentComponent(component);
+    });
+
+    auto factories = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>();
+    auto engineName = parser.value(engineOption);
+
+    factories.erase(std::remove_if(factories.begin(), factories.end(), [engineName](auto factory) {
+        return (!factory->available()) ||
+               ((!engineName.isEmpty()) && (!factory->description().contains(engineName, Qt::CaseInsensitive)));
+    }), factories.end());
+
+    auto factory = std::max_element(factories.begin(), factories.end(), [](auto first, auto second) {
+        return first->priority()<second->priority();
+    });
+
+    if (factory==factories.end()) {
+        SPDLOG_ERROR("No ping engine is available. (please check Components are installed correctly)");
+
+        componentLoader->unloadComponents();
+
+        delete componentLoader;
+
+        return 1;
+    }
+
+    auto pingAgent = new Nedrysoft::PingAgent::PingAgent(*factory);
+    auto listening = pingAgent->listenLocal(parser.value(localOption), parser.value(groupOption));
+
+    if (parser.isSet(listenOption)) {
+        auto listenAddress = parser.value(listenOption);
+        auto separator = listenAddress.lastIndexOf(':');
+
+        listening = (separator!=-1) && pingAgent->listenTcp(
+                QHostAddress(listenAddress.left(separator).remove('[').remove(']')),
+                listenAddress.mid(separator+1).toUShort(),
+                secret ) && listening;
+    }
+
+    auto exitCode = 1;
+
+    if (listening) {
+        SPDLOG_INFO(QString("Ping agent started using %1.").arg((*factory)->description()).toStdString());
+
+        exitCode = QCoreApplication::exec();
+    }
+
+    delete pingAgent;
+
+    componentLoader->unloadComponents();
+
+    delete componentLoader;
+
+    return exitCode;
+}
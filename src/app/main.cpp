@@ -30,6 +30,7 @@
 #include <QApplication>
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QIcon>
 #include <QJsonDocument>
@@ -47,6 +48,8 @@
 #endif
 
 auto constexpr SplashscreenTimeout = 3000;
+auto constexpr TraceOption = "--trace";
+auto constexpr TraceEnvironmentVariable = "PINGNOO_TRACE";
 
 int main(int argc, char **argv) {
     qApp->setApplicationName("Pingnoo");
@@ -60,6 +63,22 @@ int main(int argc, char **argv) {
 
     auto applicationInstance = new QApplication(argc, argv);
 
+    QElapsedTimer startupTimer;
+
+    startupTimer.start();
+
+    /**
+     * the tracer lives in the core component and reads its output file from the environment, so the command line
+     * option is passed on through the environment before any component is loaded.
+     */
+
+    auto arguments = QCoreApplication::arguments();
+    auto traceIndex = arguments.indexOf(TraceOption);
+
+    if ((traceIndex!=-1) && (traceIndex+1<arguments.count())) {
+        qputenv(TraceEnvironmentVariable, arguments.at(traceIndex+1).toLocal8Bit());
+    }
+
     Nedrysoft::ThemeSupport::ThemeSupport::initialisePlatform(false);
 
     auto themeSupport = Nedrysoft::ThemeSupport::ThemeSupport::getInstance();
@@ -81,6 +100,25 @@ int main(int argc, char **argv) {
 
     auto componentLoader = new Nedrysoft::ComponentSystem::ComponentLoader;
 
+    /**
+     * each search path is timed so that the startup report shows where a slow cold start is spent, a path on a
+     * network share or a folder full of stale libraries stands out.
+     */
+
+    auto scanTime = qint64(0);
+
+    auto addComponents = [componentLoader, &scanTime](const QString &path) {
+        QElapsedTimer scanTimer;
+
+        scanTimer.start();
+
+        componentLoader->addComponents(path);
+
+        scanTime += scanTimer.elapsed();
+
+        SPDLOG_DEBUG(QString("Scanned %1 for components in %2ms.").arg(path).arg(scanTimer.elapsed()).toStdString());
+    };
+
     auto applicationDir = QDir(qApp->applicationDirPath());
     QString translationsPath;
 
@@ -139,7 +177,7 @@ int main(int argc, char **argv) {
         componentPath = applicationPath + "/Contents/PlugIns";
     }
 
-    componentLoader->addComponents(componentPath);
+    addComponents(componentPath);
 
     auto extraLibrarySearchPaths = QStringList() << "Frameworks" << "PlugIns";
 
@@ -160,7 +198,7 @@ int main(int argc, char **argv) {
         auto folderName = searchPath + "/" + qApp->organizationName() + "/" + qApp->applicationName() + "/PlugIns";
 
         if (QDir(folderName).exists()) {
-            componentLoader->addComponents(folderName);
+            addComponents(folderName);
         }
     }
 #else
@@ -172,14 +210,14 @@ int main(int argc, char **argv) {
                                 .arg(dirName)
                                 .arg(QProcessEnvironment::systemEnvironment().value(dirName)).toStdString());
 
-            componentLoader->addComponents(QProcessEnvironment::systemEnvironment().value(dirName) + "/Components");
+            addComponents(QProcessEnvironment::systemEnvironment().value(dirName) + "/Components");
         }
     }
 
     if (applicationDir.exists("Components")) {
         auto componentsPath = applicationDir.absoluteFilePath("Components");
 
-        componentLoader->addComponents(componentsPath);
+        addComponents(componentsPath);
     }
 #endif
     QString settingsPath;
@@ -210,6 +248,10 @@ int main(int argc, char **argv) {
         }
     }
 
+    QElapsedTimer loadTimer;
+
+    loadTimer.start();
+
     componentLoader->loadComponents([disabledComponents](Nedrysoft::ComponentSystem::Component *component) -> bool {
         if (!component->canBeDisabled()) {
             return true;
@@ -222,6 +264,23 @@ int main(int argc, char **argv) {
         return true;
     });
 
+    auto loadTime = loadTimer.elapsed();
+
+    for (auto component : componentLoader->components()) {
+        SPDLOG_DEBUG(QString("Component %1.%2 load status %3.")
+                .arg(component->name())
+                .arg(component->vendor())
+                .arg(static_cast<int>(component->loadStatus()))
+                .toStdString() );
+    }
+
+    SPDLOG_INFO(QString("Started in %1ms (%2 components, scanning %3ms, loading %4ms).")
+            .arg(startupTimer.elapsed())
+            .arg(componentLoader->components().count())
+            .arg(scanTime)
+            .arg(loadTime)
+            .toStdString() );
+
     int exitCode;
 
     if (Nedrysoft::ComponentSystem::getObject<QMainWindow>()) {
@@ -231,7 +290,12 @@ int main(int argc, char **argv) {
         qApp->setWindowIcon(QIcon(":/app/images/appicon/colour/appicon-512x512@2x.png"));
 #endif
 
-        QTimer::singleShot(SplashscreenTimeout, [=]() {
+        /**
+         * the splash screen is shown for a minimum time from startup rather than for a fixed time after loading,
+         * so a slow start does not keep it up any longer.
+         */
+
+        QTimer::singleShot(qMax(0, static_cast<int>(SplashscreenTimeout-startupTimer.elapsed())), [=]() {
             splashScreen->deleteLater();
         });
 
@@ -0,0 +1,578 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <CaptureAnalyser>
+#include <Component>
+#include <HopStatistics>
+#include <HopTimeSeries>
+#include <IComponentManager>
+#include <IMetricsExporter>
+#include <IPingEngine>
+#include <IPingEngineFactory>
+#include <IPingTarget>
+#include <IResultSink>
+#include <IRouteEngine>
+#include <IRouteEngineFactory>
+#include <LatencySettings>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+#include <QSaveFile>
+#include <QTextStream>
+#include <RouteReportWriter>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <memory>
+
+constexpr auto DefaultInterval = 1000;
+constexpr auto CommentCharacter = '#';
+constexpr auto DefaultMetricsAddress = "127.0.0.1";
+constexpr auto ReportOption = "--report";
+constexpr auto PlatformVariable = "QT_QPA_PLATFORM";
+constexpr auto OffscreenPlatform = "offscreen";
+constexpr auto NanosecondsInSecond = 1.0e9;
+
+/**
+ * the components that are required to discover routes, ping the hops and export the results, every other
+ * component provides user interface and is not loaded.
+ */
+static auto isHeadlessComponent(Nedrysoft::ComponentSystem::Component *component) -> bool {
+    auto name = component->name();
+
+    if ((name=="Core") || (name=="RouteAnalyser") || (name=="RouteEngine")) {
+        return true;
+    }
+
+    return name.endsWith("PingEngine") || name.endsWith("Exporter");
+}
+
+template <typename T>
+static auto selectFactory(const QString &description) -> T * {
+    auto factories = Nedrysoft::ComponentSystem::getObjects<T>();
+
+    if (!description.isEmpty()) {
+        factories.erase(std::remove_if(factories.begin(), factories.end(), [description](T *factory) {
+            return !factory->description().contains(description, Qt::CaseInsensitive);
+        }), factories.end());
+    }
+
+    auto factory = std::max_element(factories.begin(), factories.end(), [](T *first, T *second) {
+        return first->priority()<second->priority();
+    });
+
+    if (factory==factories.end()) {
+        return nullptr;
+    }
+
+    return *factory;
+}
+
+static auto readTargets(const QString &filename, QStringList &targets) -> bool {
+    QFile targetsFile(filename);
+
+    if (!targetsFile.open(QFile::ReadOnly | QFile::Text)) {
+        return false;
+    }
+
+    while (!targetsFile.atEnd()) {
+        auto line = QString::fromUtf8(targetsFile.readLine());
+
+        line = line.left(line.indexOf(CommentCharacter)).trimmed();
+
+        if (!line.isEmpty()) {
+            targets.append(line);
+        }
+    }
+
+    return true;
+}
+
+static auto resultCode(Nedrysoft::RouteAnalyser::PingResult::ResultCode code) -> QString {
+    switch (code) {
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok: {
+            return "ok";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded: {
+            return "timeexceeded";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable: {
+            return "unreachable";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited: {
+            return "prohibited";
+        }
+
+        default: {
+            return "noreply";
+        }
+    }
+}
+
+/**
+ * compares two session captures and writes the report to the output file or stdout, the format is taken from the
+ * format option if one was given, or from the extension of the output file.
+ */
+static auto compareCaptures(
+        const QString &beforeFilename,
+        const QString &afterFilename,
+        const QString &formatName,
+        const QString &outputFilename ) -> int {
+
+    auto before = Nedrysoft::RouteAnalyser::CaptureAnalyser::analyse(beforeFilename);
+    auto after = Nedrysoft::RouteAnalyser::CaptureAnalyser::analyse(afterFilename);
+
+    for (auto analysis : {&before, &after}) {
+        if (!analysis->valid) {
+            SPDLOG_ERROR(QString("Unable to read %1.").arg(analysis->filename).toStdString());
+
+            return 1;
+        }
+    }
+
+    auto report = Nedrysoft::RouteAnalyser::CaptureAnalyser::compare(
+            before,
+            after,
+            Nedrysoft::RouteAnalyser::CaptureAnalyser::format(formatName) );
+
+    if (outputFilename.isEmpty()) {
+        QFile outputFile;
+
+        outputFile.open(stdout, QFile::WriteOnly);
+
+        return (outputFile.write(report)==report.size()) ? 0 : 1;
+    }
+
+    QSaveFile outputFile(outputFilename);
+
+    if ((!outputFile.open(QFile::WriteOnly)) || (outputFile.write(report)!=report.size()) || (!outputFile.commit())) {
+        SPDLOG_ERROR(QString("Unable to write %1.").arg(outputFilename).toStdString());
+
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    /**
+     * drawing a report needs a gui application, which is created on the offscreen platform so that a scheduled
+     * report can be written without a display.  the options have not been parsed yet, so the arguments are checked
+     * directly.
+     */
+
+    auto reportRequested = false;
+
+    for (auto index=1;index<argc;index++) {
+        if (QString(argv[index]).startsWith(ReportOption)) {
+            reportRequested = true;
+        }
+    }
+
+    if ((reportRequested) && (!qEnvironmentVariableIsSet(PlatformVariable))) {
+        qputenv(PlatformVariable, OffscreenPlatform);
+    }
+
+    auto applicationInstance = std::unique_ptr<QCoreApplication>(
+            reportRequested ? new QGuiApplication(argc, argv) : new QCoreApplication(argc, argv) );
+
+    QCoreApplication::setApplicationName("Pingnoo");
+    QCoreApplication::setOrganizationName("Nedrysoft");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription(QObject::tr("Traces the route to each target and pings every hop."));
+    parser.addHelpOption();
+    parser.addPositionalArgument("targets", QObject::tr("The hosts to analyse."), "[targets...]");
+
+    QCommandLineOption targetsFileOption("targets-file", QObject::tr("Read targets from <file>, one per line."), "file");
+    QCommandLineOption intervalOption("interval", QObject::tr("The interval between pings in ms."), "ms",
+                                      QString::number(DefaultInterval));
+    QCommandLineOption ipv6Option("ipv6", QObject::tr("Use IPv6 rather than IPv4."));
+    QCommandLineOption engineOption("engine", QObject::tr("Use the ping engine matching <name>."), "name");
+    QCommandLineOption outputOption("output", QObject::tr("Write results to <file> rather than stdout."), "file");
+    QCommandLineOption formatOption("format", QObject::tr("The output format, csv or json."), "format", "csv");
+    QCommandLineOption countOption("count", QObject::tr("Exit after <n> results, 0 runs until killed."), "n", "0");
+    QCommandLineOption metricsPortOption("metrics-port", QObject::tr("Serve live metrics on <port>."), "port");
+    QCommandLineOption metricsAddressOption("metrics-address", QObject::tr("Serve live metrics on <address>."),
+                                            "address", DefaultMetricsAddress);
+    QCommandLineOption reportOption("report", QObject::tr("Write a PDF report to <file> on exit."), "file");
+    QCommandLineOption compareOption("compare", QObject::tr("Compare the capture given as the target with <capture>."),
+                                     "capture");
+
+    parser.addOptions({targetsFileOption, intervalOption, ipv6Option, engineOption, outputOption, formatOption,
+                       countOption, metricsPortOption, metricsAddressOption, reportOption, compareOption});
+
+    parser.process(*applicationInstance);
+
+    auto targets = parser.positionalArguments();
+
+    if (parser.isSet(compareOption)) {
+        if (targets.count()!=1) {
+            parser.showHelp(1);
+        }
+
+        return compareCaptures(
+                parser.value(compareOption),
+                targets.first(),
+                parser.isSet(formatOption) ? parser.value(formatOption) : parser.value(outputOption),
+                parser.value(outputOption) );
+    }
+
+    if (parser.isSet(targetsFileOption)) {
+        if (!readTargets(parser.value(targetsFileOption), targets)) {
+            SPDLOG_ERROR(QString("Unable to read targets from %1.").arg(parser.value(targetsFileOption)).toStdString());
+
+            return 1;
+        }
+    }
+
+    if (targets.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    auto jsonFormat = (parser.value(formatOption).compare("json", Qt::CaseInsensitive)==0);
+    auto interval = std::max(parser.value(intervalOption).toInt(), 1);
+    auto maximumResults = parser.value(countOption).toULongLong();
+    auto ipVersion = parser.isSet(ipv6Option) ? Nedrysoft::Core::IPVersion::V6 : Nedrysoft::Core::IPVersion::V4;
+
+    QFile outputFile;
+
+    if (parser.isSet(outputOption)) {
+        outputFile.setFileName(parser.value(outputOption));
+
+        if (!outputFile.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+            SPDLOG_ERROR(QString("Unable to open %1 for writing.").arg(outputFile.fileName()).toStdString());
+
+            return 1;
+        }
+    } else {
+        outputFile.open(stdout, QFile::WriteOnly | QFile::Text);
+    }
+
+    QTextStream outputStream(&outputFile);
+
+    auto componentLoader = new Nedrysoft::ComponentSystem::ComponentLoader;
+    auto applicationDir = QDir(QCoreApplication::applicationDirPath());
+
+    Nedrysoft::ComponentSystem::IComponentManager::getInstance()->addObject(componentLoader);
+
+    QStringList componentLocations = QStringList() << "APPDIR" << "PINGNOO_COMPONENT_DIR";
+
+    for(auto dirName : componentLocations) {
+        if (QProcessEnvironment::systemEnvironment().contains(dirName)) {
+            componentLoader->addComponents(QProcessEnvironment::systemEnvironment().value(dirName) + "/Components");
+        }
+    }
+
+    if (applicationDir.exists("Components")) {
+        componentLoader->addComponents(applicationDir.absoluteFilePath("Components"));
+    }
+
+    componentLoader->loadComponents([](Nedrysoft::ComponentSystem::Component *component) -> bool {
+        return isHeadlessComponent(component);
+    });
+
+    auto pingEngineFactory = selectFactory<Nedrysoft::RouteAnalyser::IPingEngineFactory>(
+            parser.value(engineOption) );
+
+    auto routeEngineFactory = selectFactory<Nedrysoft::RouteAnalyser::IRouteEngineFactory>(QString());
+
+    if ((!pingEngineFactory) || (!routeEngineFactory)) {
+        SPDLOG_ERROR("No ping or route engine is available. (please check Components are installed correctly)");
+
+        componentLoader->unloadComponents();
+
+        delete componentLoader;
+
+        return 1;
+    }
+
+    /**
+     * the metrics exporter is optional, it is only required if the metrics were asked for.  every result sink
+     * (including the exporter) is given the results.
+     */
+
+    if (parser.isSet(metricsPortOption)) {
+        auto metricsExporter = Nedrysoft::ComponentSystem::getObject<Nedrysoft::RouteAnalyser::IMetricsExporter>();
+        auto metricsPort = parser.value(metricsPortOption).toUShort();
+        auto metricsAddress = QHostAddress(parser.value(metricsAddressOption));
+
+        if ((!metricsExporter) || (!metricsPort) || (!metricsExporter->listen(metricsAddress, metricsPort))) {
+            SPDLOG_ERROR("Unable to serve metrics. (please check the port and the MetricsExporter component)");
+
+            componentLoader->unloadComponents();
+
+            delete componentLoader;
+
+            return 1;
+        }
+    }
+
+    auto resultSinks = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IResultSink>();
+
+    /**
+     * a single engine pings the hops of every target, each ping target carries the target host and hop number
+     * in its user data so that results can be labelled.
+     */
+
+    struct HopLabel {
+        QString host;
+        int hop;
+        QString address;
+        std::unique_ptr<Nedrysoft::RouteAnalyser::HopTimeSeries> timeSeries;
+        Nedrysoft::RouteAnalyser::HopStatistics statistics;
+    };
+
+    auto pingEngine = pingEngineFactory->createEngine(ipVersion);
+    auto hopLabels = QList<HopLabel *>();
+    auto routeEngines = QList<Nedrysoft::RouteAnalyser::IRouteEngine *>();
+    quint64 resultCount = 0;
+
+    pingEngine->setInterval(interval);
+    pingEngine->setFlowStable(true);
+
+    if (!jsonFormat) {
+        outputStream << "timestamp,host,hop,address,rtt,code" << "\n";
+    }
+
+    QObject::connect(pingEngine, &Nedrysoft::RouteAnalyser::IPingEngine::result,
+            [&](Nedrysoft::RouteAnalyser::PingResult result) {
+
+        auto hopLabel = static_cast<HopLabel *>(result.target()->userData());
+        auto timestamp = QDateTime::fromMSecsSinceEpoch(result.requestTimestamp()/1000000).toString(Qt::ISODateWithMs);
+        auto roundTripTime = (result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) ?
+                -1.0 : result.roundTripTime()*1000.0;
+
+        if (jsonFormat) {
+            auto resultObject = QJsonObject {
+                {"timestamp", timestamp},
+                {"host", hopLabel->host},
+                {"hop", hopLabel->hop},
+                {"address", result.hostAddress().toString()},
+                {"rtt", roundTripTime},
+                {"code", resultCode(result.code())}
+            };
+
+            outputStream << QJsonDocument(resultObject).toJson(QJsonDocument::Compact) << "\n";
+        } else {
+            outputStream << timestamp << "," << hopLabel->host << "," << hopLabel->hop << ","
+                         << result.hostAddress().toString() << "," << roundTripTime << ","
+                         << resultCode(result.code()) << "\n";
+        }
+
+        outputStream.flush();
+
+        if (hopLabel->timeSeries) {
+            hopLabel->timeSeries->append(
+                    static_cast<double>(result.requestTimestamp())/NanosecondsInSecond,
+                    result.roundTripTime(),
+                    result.code() );
+
+            if (result.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) {
+                hopLabel->address = result.hostAddress().toString();
+            }
+        }
+
+        if (!resultSinks.isEmpty()) {
+            hopLabel->statistics.add(result);
+
+            for (auto resultSink : resultSinks) {
+                resultSink->update(hopLabel->host, hopLabel->hop, hopLabel->statistics, {result});
+            }
+        }
+
+        resultCount++;
+
+        if ((maximumResults) && (resultCount>=maximumResults)) {
+            QCoreApplication::quit();
+        }
+    });
+
+    for (auto &target : targets) {
+        auto routeEngine = routeEngineFactory->createEngine();
+
+        routeEngines.append(routeEngine);
+
+        QObject::connect(routeEngine, &Nedrysoft::RouteAnalyser::IRouteEngine::result,
+                [&, target](const QHostAddress &routeHostAddress,
+                            const Nedrysoft::RouteAnalyser::RouteList &route,
+                            bool completed,
+                            int totalHops,
+                            int maximumHops) {
+
+            Q_UNUSED(totalHops)
+            Q_UNUSED(maximumHops)
+
+            if (!completed) {
+                return;
+            }
+
+            if (route.isEmpty()) {
+                SPDLOG_ERROR(QString("Unable to find a route to %1.").arg(target).toStdString());
+
+                return;
+            }
+
+            for (auto hop=1;hop<=route.count();hop++) {
+                auto hopLabel = new HopLabel {target, hop};
+
+                if (parser.isSet(reportOption)) {
+                    hopLabel->timeSeries.reset(new Nedrysoft::RouteAnalyser::HopTimeSeries);
+                }
+                auto pingTarget = pingEngine->addTarget(routeHostAddress, hop);
+
+                pingTarget->setUserData(hopLabel);
+
+                hopLabels.append(hopLabel);
+            }
+
+            pingEngine->start();
+        });
+
+        routeEngine->findRoute(pingEngineFactory, target, ipVersion);
+    }
+
+    /**
+     * the report has a section for each target, the graphs cover the whole run and are decimated to the width of
+     * the page.  the latency levels are those configured in the application.
+     */
+
+    auto writeReport = [&](const QString &filename) -> bool {
+        Nedrysoft::RouteAnalyser::LatencySettings latencySettings;
+
+        latencySettings.loadFromFile();
+
+        auto snapshots = QVector<Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot>();
+        auto pageWidth = Nedrysoft::RouteAnalyser::RouteReportWriter::pageWidth();
+        auto columns = Nedrysoft::RouteAnalyser::RouteImageRenderer::graphColumns(pageWidth);
+
+        for (auto &target : targets) {
+            auto snapshot = Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot();
+
+            snapshot.target = target;
+            snapshot.start = -1;
+            snapshot.end = -1;
+            snapshot.warningLatency = latencySettings.warningValue();
+            snapshot.criticalLatency = latencySettings.criticalValue();
+            snapshot.idealColour = latencySettings.idealColour();
+            snapshot.warningColour = latencySettings.warningColour();
+            snapshot.criticalColour = latencySettings.criticalColour();
+            snapshot.content = Nedrysoft::RouteAnalyser::RouteImageRenderer::Table |
+                               Nedrysoft::RouteAnalyser::RouteImageRenderer::Graphs;
+            snapshot.width = pageWidth;
+            snapshot.dpi = 0;
+
+            for (auto hopLabel : hopLabels) {
+                auto timeSeries = hopLabel->timeSeries.get();
+
+                if ((hopLabel->host!=target) || (!timeSeries) || (!timeSeries->count())) {
+                    continue;
+                }
+
+                if ((snapshot.start<0) || (timeSeries->firstTime()<snapshot.start)) {
+                    snapshot.start = timeSeries->firstTime();
+                }
+
+                snapshot.end = std::max(snapshot.end, timeSeries->lastTime());
+            }
+
+            for (auto hopLabel : hopLabels) {
+                if ((hopLabel->host!=target) || (!hopLabel->timeSeries)) {
+                    continue;
+                }
+
+                auto timeSeries = hopLabel->timeSeries.get();
+                auto summary = timeSeries->summarise(snapshot.start, snapshot.end);
+                auto sketch = timeSeries->sketch(snapshot.start, snapshot.end);
+                auto hop = Nedrysoft::RouteAnalyser::RouteImageRenderer::Hop();
+
+                hop.hop = hopLabel->hop;
+                hop.valid = (summary.count>0);
+                hop.address = hopLabel->address;
+                hop.averageLatency = summary.mean();
+                hop.minimumLatency = summary.count ? summary.minimum : -1;
+                hop.maximumLatency = summary.count ? summary.maximum : -1;
+                hop.currentLatency = timeSeries->count() ? timeSeries->roundTripTime(timeSeries->count()-1) : -1;
+                hop.packetLoss = (summary.count+summary.lost) ? summary.loss()*100.0 : -1;
+                hop.medianLatency = sketch.quantile(0.50);
+                hop.p95Latency = sketch.quantile(0.95);
+                hop.p99Latency = sketch.quantile(0.99);
+
+                if ((hop.valid) && (snapshot.end>snapshot.start)) {
+                    hop.columns = timeSeries->decimate(snapshot.start, snapshot.end, columns);
+                }
+
+                snapshot.hops.append(hop);
+            }
+
+            if (!snapshot.hops.isEmpty()) {
+                snapshots.append(snapshot);
+            }
+        }
+
+        QSaveFile reportFile(filename);
+
+        if (!reportFile.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+
+        auto reportWriter = Nedrysoft::RouteAnalyser::RouteReportWriter(&reportFile);
+
+        reportWriter.setTitle(targets.join(", "));
+
+        return (reportWriter.write(snapshots)) && (reportFile.commit());
+    };
+
+    auto exitCode = QCoreApplication::exec();
+
+    pingEngine->stop();
+
+    qDeleteAll(routeEngines);
+
+    pingEngineFactory->deleteEngine(pingEngine);
+
+    if ((parser.isSet(reportOption)) && (!writeReport(parser.value(reportOption), targets, hopLabels))) {
+        SPDLOG_ERROR(QString("Unable to write the report to %1.").arg(parser.value(reportOption)).toStdString());
+
+        exitCode = 1;
+    }
+
+    qDeleteAll(hopLabels);
+
+    componentLoader->unloadComponents();
+
+    delete componentLoader;
+
+    return exitCode;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CancellationToken.h"
+
+Nedrysoft::Core::CancellationToken::CancellationToken() :
+        m_state(std::make_shared<State>()) {
+
+}
+
+auto Nedrysoft::Core::CancellationToken::cancel() -> void {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    m_state->cancelled = true;
+}
+
+auto Nedrysoft::Core::CancellationToken::cancelAndWait() -> void {
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+
+    m_state->cancelled = true;
+
+    m_state->idle.wait(lock, [this]() {
+        return m_state->running==0;
+    });
+}
+
+auto Nedrysoft::Core::CancellationToken::isCancelled() const -> bool {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    return m_state->cancelled;
+}
+
+auto Nedrysoft::Core::CancellationToken::begin() const -> bool {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    if (m_state->cancelled) {
+        return false;
+    }
+
+    m_state->running++;
+
+    return true;
+}
+
+auto Nedrysoft::Core::CancellationToken::end() const -> void {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        m_state->running--;
+    }
+
+    m_state->idle.notify_all();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_CANCELLATIONTOKEN_H
+#define PINGNOO_COMPONENTS_CORE_CANCELLATIONTOKEN_H
+
+#include "CoreSpec.h"
+
+#include <QtGlobal>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The CancellationToken class ties background tasks to the lifetime of the object that queued them.
+     *
+     * @details     A token is shared by copying it, every copy refers to the same state.  The owner keeps a token,
+     *              passes it with each task it submits to the TaskPool and cancels it when it is destroyed; a task
+     *              that has not started by then is discarded, and a long task can check isCancelled() to stop
+     *              early.
+     *
+     *              An owner whose tasks use the owner itself calls cancelAndWait(), which also waits for tasks that
+     *              are already running, once it returns no task of the token touches the owner again.
+     *
+     * @class       Nedrysoft::Core::CancellationToken CancellationToken.h <CancellationToken>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC CancellationToken {
+        public:
+            /**
+             * @brief       Constructs a new token that has not been cancelled.
+             */
+            CancellationToken();
+
+            /**
+             * @brief       Cancels the token, tasks that have not started will not be run.
+             */
+            auto cancel() -> void;
+
+            /**
+             * @brief       Cancels the token and waits for the tasks of the token that are running to finish.
+             *
+             * @note        Must not be called from a task of the token, the call would wait for itself.
+             */
+            auto cancelAndWait() -> void;
+
+            /**
+             * @brief       Returns whether the token has been cancelled.
+             *
+             * @returns     true if the token has been cancelled; otherwise false.
+             */
+            auto isCancelled() const -> bool;
+
+            /**
+             * @brief       Marks a task of the token as started.
+             *
+             * @note        Called by the TaskPool before a task is run.
+             *
+             * @returns     true if the task may run; otherwise false if the token has been cancelled.
+             */
+            auto begin() const -> bool;
+
+            /**
+             * @brief       Marks a task of the token as finished.
+             *
+             * @note        Called by the TaskPool after a task that was allowed to start has run.
+             */
+            auto end() const -> void;
+
+        private:
+            //! @cond
+
+            struct State {
+                std::mutex mutex;
+                std::condition_variable idle;
+                bool cancelled = false;
+                int running = 0;
+            };
+
+            std::shared_ptr<State> m_state;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_CANCELLATIONTOKEN_H
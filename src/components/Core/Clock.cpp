@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Clock.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <atomic>
+
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto NanosecondsInSecond = 1000000000ll;
+
+//! @cond
+
+static std::atomic<Nedrysoft::Core::Clock *> installedClock(nullptr);
+
+//! @endcond
+
+Nedrysoft::Core::Clock::~Clock() {
+    // a clock that is destroyed while installed is replaced by the system clock rather than left dangling.
+
+    auto expectedClock = this;
+
+    installedClock.compare_exchange_strong(expectedClock, nullptr);
+}
+
+auto Nedrysoft::Core::Clock::getInstance() -> Nedrysoft::Core::Clock * {
+    static Nedrysoft::Core::SystemClock systemClock;
+
+    auto clock = installedClock.load(std::memory_order_acquire);
+
+    return clock ? clock : &systemClock;
+}
+
+auto Nedrysoft::Core::Clock::setInstance(Nedrysoft::Core::Clock *clock) -> void {
+    installedClock.store(clock, std::memory_order_release);
+}
+
+auto Nedrysoft::Core::Clock::realInterval(qint64 interval) const -> qint64 {
+    return interval;
+}
+
+auto Nedrysoft::Core::Clock::currentDateTime() const -> QDateTime {
+    return QDateTime::fromMSecsSinceEpoch(currentMSecsSinceEpoch());
+}
+
+auto Nedrysoft::Core::Clock::currentDateTimeUtc() const -> QDateTime {
+    return QDateTime::fromMSecsSinceEpoch(currentMSecsSinceEpoch(), Qt::UTC);
+}
+
+auto Nedrysoft::Core::Clock::currentMSecsSinceEpoch() const -> qint64 {
+    return now()/NanosecondsInMillisecond;
+}
+
+auto Nedrysoft::Core::Clock::currentSecsSinceEpoch() const -> qint64 {
+    return now()/NanosecondsInSecond;
+}
+
+Nedrysoft::Core::SystemClock::SystemClock() {
+    m_monotonicTimer.start();
+
+    m_anchor = QDateTime::currentMSecsSinceEpoch()*NanosecondsInMillisecond;
+}
+
+auto Nedrysoft::Core::SystemClock::now() const -> qint64 {
+    return m_anchor+m_monotonicTimer.nsecsElapsed();
+}
+
+Nedrysoft::Core::VirtualClock::VirtualClock(qint64 startTime, double rate) :
+        m_time(startTime),
+        m_rate(rate) {
+
+    m_realTimer.start();
+}
+
+auto Nedrysoft::Core::VirtualClock::currentTime() const -> qint64 {
+    return m_time+static_cast<qint64>(static_cast<double>(m_realTimer.nsecsElapsed())*m_rate);
+}
+
+auto Nedrysoft::Core::VirtualClock::now() const -> qint64 {
+    QMutexLocker locker(&m_mutex);
+
+    return currentTime();
+}
+
+auto Nedrysoft::Core::VirtualClock::realInterval(qint64 interval) const -> qint64 {
+    QMutexLocker locker(&m_mutex);
+
+    if (m_rate<=0) {
+        return -1;
+    }
+
+    return static_cast<qint64>(static_cast<double>(interval)/m_rate);
+}
+
+auto Nedrysoft::Core::VirtualClock::advance(qint64 interval) -> void {
+    if (interval<=0) {
+        return;
+    }
+
+    m_mutex.lock();
+
+    m_time += interval;
+
+    m_mutex.unlock();
+
+    Q_EMIT timeChanged();
+}
+
+auto Nedrysoft::Core::VirtualClock::setTime(qint64 time) -> void {
+    m_mutex.lock();
+
+    auto interval = time-currentTime();
+
+    m_mutex.unlock();
+
+    advance(interval);
+}
+
+auto Nedrysoft::Core::VirtualClock::setRate(double rate) -> void {
+    m_mutex.lock();
+
+    // the time reached at the old rate is kept so that the clock does not jump when the rate changes.
+
+    m_time = currentTime();
+    m_rate = std::max(rate, 0.0);
+
+    m_realTimer.restart();
+
+    m_mutex.unlock();
+
+    Q_EMIT timeChanged();
+}
+
+auto Nedrysoft::Core::VirtualClock::rate() const -> double {
+    QMutexLocker locker(&m_mutex);
+
+    return m_rate;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_CLOCK_H
+#define PINGNOO_COMPONENTS_CORE_CLOCK_H
+
+#include "CoreSpec.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The Clock class is the source of time for the application.
+     *
+     * @details     Scheduling, timeouts, rollups and cache expiry read the time from the installed clock rather
+     *              than from the system, so a simulation or a test can install a VirtualClock and run hours of
+     *              monitoring in moments.  Times are nanoseconds since the unix epoch and never go backwards.
+     *
+     *              Code that measures how long the application itself takes (tracing, diagnostics, frame timing
+     *              and the round trip time of a real probe) keeps using the system clock.
+     *
+     * @class       Nedrysoft::Core::Clock Clock.h <Clock>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC Clock :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Destroys the Clock.
+             */
+            ~Clock() override;
+
+            /**
+             * @brief       Returns the installed clock.
+             *
+             * @returns     the clock; the system clock if no other clock has been installed.
+             */
+            static auto getInstance() -> Nedrysoft::Core::Clock *;
+
+            /**
+             * @brief       Installs a clock.
+             *
+             * @details     The clock should be installed before any component is loaded, timers that were started
+             *              on one clock give meaningless results when read on another.  The caller keeps ownership
+             *              of the clock and must reinstall the system clock before destroying it.
+             *
+             * @param[in]   clock the clock; or nullptr to install the system clock.
+             */
+            static auto setInstance(Nedrysoft::Core::Clock *clock) -> void;
+
+            /**
+             * @brief       Returns the current time.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            virtual auto now() const -> qint64 = 0;
+
+            /**
+             * @brief       Returns how long a thread must sleep for this clock to advance by an interval.
+             *
+             * @param[in]   interval the interval in nanoseconds.
+             *
+             * @returns     the real time in nanoseconds; or -1 if the clock only advances when it is told to, in
+             *              which case the thread should sleep until timeChanged() is emitted.
+             */
+            virtual auto realInterval(qint64 interval) const -> qint64;
+
+            /**
+             * @brief       Returns the current date and time in the local time zone.
+             *
+             * @returns     the date and time.
+             */
+            auto currentDateTime() const -> QDateTime;
+
+            /**
+             * @brief       Returns the current date and time in UTC.
+             *
+             * @returns     the date and time.
+             */
+            auto currentDateTimeUtc() const -> QDateTime;
+
+            /**
+             * @brief       Returns the number of milliseconds since the unix epoch.
+             *
+             * @returns     the time in milliseconds.
+             */
+            auto currentMSecsSinceEpoch() const -> qint64;
+
+            /**
+             * @brief       Returns the number of seconds since the unix epoch.
+             *
+             * @returns     the time in seconds.
+             */
+            auto currentSecsSinceEpoch() const -> qint64;
+
+            /**
+             * @brief       This signal is emitted when the clock is moved other than by the passing of real time.
+             *
+             * @details     The signal is emitted on the thread that moved the clock, threads that are sleeping
+             *              until a deadline should connect with Qt::DirectConnection and wake themselves.
+             */
+            Q_SIGNAL void timeChanged();
+    };
+
+    /**
+     * @brief       The SystemClock class reads the time from the monotonic clock of the system.
+     *
+     * @details     The monotonic clock is offset by a single reading of the system clock taken when the clock is
+     *              created, so the time can be shown as a wall clock time but is unaffected by the system clock
+     *              being changed while the application is running.
+     */
+    class NEDRYSOFT_CORE_DLLSPEC SystemClock :
+            public Nedrysoft::Core::Clock {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a SystemClock.
+             */
+            SystemClock();
+
+            /**
+             * @brief       Returns the current time.
+             *
+             * @see         Nedrysoft::Core::Clock::now
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            auto now() const -> qint64 override;
+
+        private:
+            //! @cond
+
+            QElapsedTimer m_monotonicTimer;
+            qint64 m_anchor;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The VirtualClock class provides a clock that is moved by its owner.
+     *
+     * @details     The clock is either stepped with advance() and setTime(), or runs at a multiple of real time
+     *              once a rate has been set, so a simulation can fast forward through days of monitoring.
+     *
+     * @note        All functions are thread safe.
+     */
+    class NEDRYSOFT_CORE_DLLSPEC VirtualClock :
+            public Nedrysoft::Core::Clock {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a VirtualClock.
+             *
+             * @param[in]   startTime the initial time in nanoseconds since the unix epoch.
+             * @param[in]   rate the number of virtual seconds that pass in each real second; or 0 if the clock
+             *              only moves when it is told to.
+             */
+            explicit VirtualClock(qint64 startTime=0, double rate=0);
+
+            /**
+             * @brief       Returns the current time.
+             *
+             * @see         Nedrysoft::Core::Clock::now
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            auto now() const -> qint64 override;
+
+            /**
+             * @brief       Returns how long a thread must sleep for this clock to advance by an interval.
+             *
+             * @see         Nedrysoft::Core::Clock::realInterval
+             *
+             * @param[in]   interval the interval in nanoseconds.
+             *
+             * @returns     the real time in nanoseconds; or -1 if the clock is stepped.
+             */
+            auto realInterval(qint64 interval) const -> qint64 override;
+
+            /**
+             * @brief       Moves the clock forward.
+             *
+             * @param[in]   interval the interval in nanoseconds.
+             */
+            auto advance(qint64 interval) -> void;
+
+            /**
+             * @brief       Sets the time, the clock is not moved backwards.
+             *
+             * @param[in]   time the time in nanoseconds since the unix epoch.
+             */
+            auto setTime(qint64 time) -> void;
+
+            /**
+             * @brief       Sets the rate at which the clock runs.
+             *
+             * @param[in]   rate the number of virtual seconds that pass in each real second; or 0 to stop the
+             *              clock.
+             */
+            auto setRate(double rate) -> void;
+
+            /**
+             * @brief       Returns the rate at which the clock runs.
+             *
+             * @returns     the number of virtual seconds that pass in each real second.
+             */
+            auto rate() const -> double;
+
+        private:
+            /**
+             * @brief       Returns the current time, the caller must hold the lock.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            auto currentTime() const -> qint64;
+
+        private:
+            //! @cond
+
+            mutable QMutex m_mutex;
+
+            QElapsedTimer m_realTimer;
+            qint64 m_time;
+            double m_rate;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_CLOCK_H
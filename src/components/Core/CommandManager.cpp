@@ -26,6 +26,7 @@
 #include "Command.h"
 #include "ICore.h"
 #include "CoreConstants.h"
+#include "Tracer.h"
 
 #include <QMenu>
 #include <QMenuBar>
@@ -42,6 +43,8 @@ auto Nedrysoft::Core::CommandManager::registerAction(
         QString id,
         const Nedrysoft::Core::ContextList &contexts) -> Nedrysoft::Core::ICommand * {
 
+    Nedrysoft::Core::TraceScope traceScope("ui", QString("CommandManager::registerAction %1").arg(id));
+
     if (m_commandMap.contains(id)) {
         auto command = m_commandMap[id];
 
@@ -125,6 +128,8 @@ auto Nedrysoft::Core::CommandManager::createMenu(
         return m_menuMap[identifier];
     }
 
+    Nedrysoft::Core::TraceScope traceScope("ui", QString("CommandManager::createMenu %1").arg(identifier));
+
     if (!parentMenu) {
         auto mainWindow = Nedrysoft::Core::mainWindow();
 
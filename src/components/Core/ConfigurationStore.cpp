@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ConfigurationStore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+
+constexpr auto DebounceInterval = 500;
+constexpr auto MaximumDelay = 5000;
+
+Nedrysoft::Core::ConfigurationStore::ConfigurationStore() :
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_debounceTimer(new QTimer(this)),
+        m_failed(false) {
+
+    m_debounceTimer->setSingleShot(true);
+
+    connect(m_debounceTimer, &QTimer::timeout, this, [this]() {
+        commit();
+    });
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
+}
+
+Nedrysoft::Core::ConfigurationStore::~ConfigurationStore() {
+    flush();
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+}
+
+auto Nedrysoft::Core::ConfigurationStore::save(const QString &filename, const QJsonObject &configuration) -> void {
+    queue(filename, PendingFile{configuration, QByteArray(), true});
+}
+
+auto Nedrysoft::Core::ConfigurationStore::saveData(const QString &filename, const QByteArray &data) -> void {
+    queue(filename, PendingFile{QJsonObject(), data, false});
+}
+
+auto Nedrysoft::Core::ConfigurationStore::queue(const QString &filename, const PendingFile &file) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_pending[filename] = file;
+
+    /**
+     * the timer belongs to the thread that created the store, a save from any other thread restarts it there.
+     */
+
+    QMetaObject::invokeMethod(this, [this]() {
+        schedule();
+    }, Qt::AutoConnection);
+}
+
+auto Nedrysoft::Core::ConfigurationStore::flush() -> bool {
+    m_debounceTimer->stop();
+
+    commit();
+
+    /**
+     * the writer thread handles its work in order, so once this returns every file committed above is written.
+     */
+
+    QMetaObject::invokeMethod(m_context, []() { }, Qt::BlockingQueuedConnection);
+
+    QMutexLocker locker(&m_mutex);
+
+    auto succeeded = !m_failed;
+
+    m_failed = false;
+
+    return succeeded;
+}
+
+auto Nedrysoft::Core::ConfigurationStore::schedule() -> void {
+    if (!m_pendingTime.isValid()) {
+        m_pendingTime.start();
+    }
+
+    /**
+     * the timer is restarted by every save so that a burst of changes is written once it ends, a setting that
+     * keeps changing is still written every few seconds.
+     */
+
+    if ((m_debounceTimer->isActive()) && (m_pendingTime.elapsed()>=MaximumDelay)) {
+        return;
+    }
+
+    m_debounceTimer->start(DebounceInterval);
+}
+
+auto Nedrysoft::Core::ConfigurationStore::commit() -> void {
+    auto pending = QMap<QString, PendingFile>();
+
+    m_mutex.lock();
+
+    pending.swap(m_pending);
+
+    m_mutex.unlock();
+
+    m_pendingTime.invalidate();
+
+    for (auto file=pending.begin();file!=pending.end();file++) {
+        auto filename = file.key();
+        auto pendingFile = file.value();
+
+        QMetaObject::invokeMethod(m_context, [this, filename, pendingFile]() {
+            auto data = pendingFile.isJson ? QJsonDocument(pendingFile.configuration).toJson() : pendingFile.data;
+
+            if (!write(filename, data)) {
+                QMutexLocker locker(&m_mutex);
+
+                m_failed = true;
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+auto Nedrysoft::Core::ConfigurationStore::write(const QString &filename, const QByteArray &data) -> bool {
+    auto folder = QFileInfo(filename).absolutePath();
+
+    if (!QDir().mkpath(folder)) {
+        SPDLOG_WARN(QString("Unable to create %1.").arg(folder).toStdString());
+
+        return false;
+    }
+
+    QSaveFile configurationFile(filename);
+
+    if (!configurationFile.open(QFile::WriteOnly)) {
+        SPDLOG_WARN(QString("Unable to write %1. (%2)")
+                .arg(filename)
+                .arg(configurationFile.errorString()).toStdString());
+
+        return false;
+    }
+
+    configurationFile.write(data);
+
+    if (!configurationFile.commit()) {
+        SPDLOG_WARN(QString("Unable to write %1. (%2)")
+                .arg(filename)
+                .arg(configurationFile.errorString()).toStdString());
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_CONFIGURATIONSTORE_H
+#define PINGNOO_COMPONENTS_CORE_CONFIGURATIONSTORE_H
+
+#include "CoreSpec.h"
+#include "ElapsedTimer.h"
+#include "IConfigurationStore.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+
+class QThread;
+class QTimer;
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The ConfigurationStore class writes configuration files on a background thread.
+     *
+     * @details     Saved configurations are kept by file name until no save has arrived for a short while (or
+     *              until saves have been arriving for a few seconds), then every pending file is handed to the
+     *              writer thread, which serialises the JSON and writes it with a QSaveFile.  Rapid changes to a
+     *              setting cost one write rather than one per change.  Pending files are written when the store is
+     *              destroyed.
+     */
+    class NEDRYSOFT_CORE_DLLSPEC ConfigurationStore :
+            public Nedrysoft::Core::IConfigurationStore {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::Core::IConfigurationStore)
+
+        public:
+            /**
+             * @brief       Constructs a new ConfigurationStore and starts its writer thread.
+             */
+            ConfigurationStore();
+
+            /**
+             * @brief       Writes the pending files, stops the thread and destroys the ConfigurationStore.
+             */
+            ~ConfigurationStore() override;
+
+            /**
+             * @brief       Saves a configuration file.
+             *
+             * @see         Nedrysoft::Core::IConfigurationStore::save
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   configuration the configuration to write.
+             */
+            auto save(const QString &filename, const QJsonObject &configuration) -> void override;
+
+            /**
+             * @brief       Saves a data file.
+             *
+             * @see         Nedrysoft::Core::IConfigurationStore::saveData
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   data the contents of the file.
+             */
+            auto saveData(const QString &filename, const QByteArray &data) -> void override;
+
+            /**
+             * @brief       Writes every pending configuration now.
+             *
+             * @see         Nedrysoft::Core::IConfigurationStore::flush
+             *
+             * @returns     true if every file was written; otherwise false.
+             */
+            auto flush() -> bool override;
+
+        private:
+            /**
+             * @brief       Restarts the debounce timer, called on the thread that owns the store.
+             */
+            auto schedule() -> void;
+
+            /**
+             * @brief       A file waiting to be written, JSON is only serialised on the writer thread.
+             */
+            struct PendingFile {
+                QJsonObject configuration;
+                QByteArray data;
+                bool isJson;
+            };
+
+            /**
+             * @brief       Adds a file to the pending files and schedules the write.
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   file the contents of the file.
+             */
+            auto queue(const QString &filename, const PendingFile &file) -> void;
+
+            /**
+             * @brief       Hands the pending files to the writer thread.
+             */
+            auto commit() -> void;
+
+            /**
+             * @brief       Writes a file, called on the writer thread.
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   data the contents of the file.
+             *
+             * @returns     true if the file was written; otherwise false.
+             */
+            auto write(const QString &filename, const QByteArray &data) -> bool;
+
+        private:
+            //! @cond
+
+            QThread *m_thread;
+            QObject *m_context;
+            QTimer *m_debounceTimer;
+            Nedrysoft::Core::ElapsedTimer m_pendingTime;
+
+            QMutex m_mutex;
+            QMap<QString, PendingFile> m_pending;
+            bool m_failed;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_CONFIGURATIONSTORE_H
@@ -30,18 +30,24 @@
 #include "ThemeSupport"
 
 Nedrysoft::Core::Core::Core() :
-        m_mainWindow(new Nedrysoft::Core::MainWindow) {
+        m_mainWindow(Nedrysoft::Core::headless() ? nullptr : new Nedrysoft::Core::MainWindow) {
 
-    Nedrysoft::ComponentSystem::addObject(m_mainWindow);
+    if (m_mainWindow) {
+        Nedrysoft::ComponentSystem::addObject(m_mainWindow);
+    }
 
     m_randomGenerator = new std::mt19937(m_randomDevice());
 }
 
 Nedrysoft::Core::Core::~Core() {
-    Nedrysoft::ComponentSystem::removeObject(m_mainWindow);
-
     delete m_randomGenerator;
 
+    if (!m_mainWindow) {
+        return;
+    }
+
+    Nedrysoft::ComponentSystem::removeObject(m_mainWindow);
+
     delete m_mainWindow;
 
     delete Nedrysoft::ThemeSupport::ThemeSupport::getInstance();
@@ -74,5 +80,9 @@ auto Nedrysoft::Core::Core::storageFolder() -> QString {
 }
 
 auto Nedrysoft::Core::Core::applicationContextMenu() -> IMenu * {
+    if (!m_mainWindow) {
+        return nullptr;
+    }
+
     return m_mainWindow->applicationContextMenu();
 }
\ No newline at end of file
@@ -25,17 +25,21 @@
 
 #include "ClipboardRibbonGroup.h"
 #include "CommandManager.h"
+#include "ConfigurationStore.h"
 #include "ContextManager.h"
 #include "Core.h"
 #include "CoreConstants.h"
 #include "HostMaskerManager.h"
 #include "HostMaskerSettingsPage.h"
 #include "HostMaskingRibbonGroup.h"
+#include "HostResolver.h"
 #include "IRibbonPage.h"
 #include "MainWindow.h"
 #include "RibbonBarManager.h"
+#include "StatusbarManager.h"
 #include "SystemTrayIconManager.h"
 #include "ThemeSettingsPage.h"
+#include "Tracer.h"
 
 #include <QHostAddress>
 
@@ -46,7 +50,11 @@ CoreComponent::CoreComponent() :
         m_ribbonBarManager(nullptr),
         m_hostMaskerSettingsPage(nullptr),
         m_themeSettingsPage(nullptr),
-        m_hostMaskerManager(nullptr) {
+        m_systemTrayIconManager(nullptr),
+        m_hostMaskerManager(nullptr),
+        m_hostResolver(nullptr),
+        m_configurationStore(nullptr),
+        m_statusbarManager(nullptr) {
 
 }
 
@@ -54,6 +62,8 @@ CoreComponent::~CoreComponent() {
 }
 
 auto CoreComponent::initialiseEvent() -> void {
+    Nedrysoft::Core::TraceScope traceScope("component", "Core::initialiseEvent");
+
     qRegisterMetaType<QHostAddress>("QHostAddress");
 
     qRegisterMetaType<Nedrysoft::Core::IPVersion>("Nedrysoft::Core::IPVersion");
@@ -61,6 +71,21 @@ auto CoreComponent::initialiseEvent() -> void {
     m_core = new Nedrysoft::Core::Core();
     Nedrysoft::ComponentSystem::addObject(m_core);
 
+    m_hostResolver = new Nedrysoft::Core::HostResolver();
+    Nedrysoft::ComponentSystem::addObject(m_hostResolver);
+
+    m_configurationStore = new Nedrysoft::Core::ConfigurationStore();
+    Nedrysoft::ComponentSystem::addObject(m_configurationStore);
+
+    /**
+     * a headless application only needs the core services (storage location, random numbers), everything else
+     * provided by this component is user interface.
+     */
+
+    if (Nedrysoft::Core::headless()) {
+        return;
+    }
+
     m_contextManager = new Nedrysoft::Core::ContextManager();
     Nedrysoft::ComponentSystem::addObject(m_contextManager);
 
@@ -82,6 +107,9 @@ auto CoreComponent::initialiseEvent() -> void {
     m_ribbonBarManager = new Nedrysoft::Core::RibbonBarManager();
     Nedrysoft::ComponentSystem::addObject(m_ribbonBarManager);
 
+    m_statusbarManager = new Nedrysoft::Core::StatusbarManager();
+    Nedrysoft::ComponentSystem::addObject(m_statusbarManager);
+
     auto mainWindow =
         qobject_cast<Nedrysoft::Core::MainWindow *>(Nedrysoft::Core::ICore::getInstance()->mainWindow());
 
@@ -89,22 +117,32 @@ auto CoreComponent::initialiseEvent() -> void {
 }
 
 auto CoreComponent::initialisationFinishedEvent() -> void {
-    auto core = Nedrysoft::ComponentSystem::getObject<Nedrysoft::Core::Core>();
+    Nedrysoft::Core::TraceScope traceScope("component", "Core::initialisationFinishedEvent");
 
-    connect(
-        Nedrysoft::Core::IContextManager::getInstance(),
-        &Nedrysoft::Core::IContextManager::contextChanged,
-        [&](int newContext, int oldContext) {
-            Q_UNUSED(oldContext)
+    auto core = Nedrysoft::ComponentSystem::getObject<Nedrysoft::Core::Core>();
 
-            Nedrysoft::Core::ICommandManager::getInstance()->setContext(newContext);
-        }
-    );
+    if (m_contextManager) {
+        connect(
+            m_contextManager,
+            &Nedrysoft::Core::IContextManager::contextChanged,
+            [&](int newContext, int oldContext) {
+                Q_UNUSED(oldContext)
+
+                Nedrysoft::Core::ICommandManager::getInstance()->setContext(newContext);
+            }
+        );
+    }
 
     core->open();
 }
 
 auto CoreComponent::finaliseEvent() -> void {
+    /**
+     * the core is the last component to be finalised, so the trace covers the whole run by the time it is written.
+     */
+
+    Nedrysoft::Core::Tracer::getInstance()->write();
+
     if (m_ribbonBarManager) {
         delete m_ribbonBarManager;
     }
@@ -113,6 +151,23 @@ auto CoreComponent::finaliseEvent() -> void {
         delete m_hostMaskerManager;
     }
 
+    if (m_statusbarManager) {
+        delete m_statusbarManager;
+    }
+
+    if (m_hostResolver) {
+        delete m_hostResolver;
+    }
+
+    /**
+     * the store writes any configuration that is still pending as it is destroyed, every other component has
+     * already been finalised by now.
+     */
+
+    if (m_configurationStore) {
+        delete m_configurationStore;
+    }
+
     if (m_hostMaskerSettingsPage) {
         delete m_hostMaskerSettingsPage;
     }
@@ -30,12 +30,15 @@
 namespace Nedrysoft { namespace Core {
     class ClipboardRibbonGroup;
     class CommandManager;
+    class ConfigurationStore;
     class ContextManager;
     class Core;
     class HostMaskerManager;
+    class HostResolver;
     class HostMaskingRibbonGroup;
     class HostMaskerSettingsPage;
     class RibbonBarManager;
+    class StatusbarManager;
     class SystemTrayIconManager;
     class ThemeSettingsPage;
 }}
@@ -112,6 +115,9 @@ class NEDRYSOFT_CORE_DLLSPEC CoreComponent :
         Nedrysoft::Core::HostMaskingRibbonGroup *m_hostMaskingRibbonGroupWidget;
         Nedrysoft::Core::ClipboardRibbonGroup *m_clipboardRibbonGroupWidget;
         Nedrysoft::Core::HostMaskerManager *m_hostMaskerManager;
+        Nedrysoft::Core::HostResolver *m_hostResolver;
+        Nedrysoft::Core::ConfigurationStore *m_configurationStore;
+        Nedrysoft::Core::StatusbarManager *m_statusbarManager;
 
         //! @endcond
 };
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Diagnostics.h"
+
+#include <QMutexLocker>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+constexpr auto FirstBucketBound = 0.125;
+constexpr auto BucketCount = 18;
+
+Nedrysoft::Core::Diagnostics::Diagnostics() :
+        m_enabled(false) {
+
+}
+
+auto Nedrysoft::Core::Diagnostics::getInstance() -> Nedrysoft::Core::Diagnostics * {
+    static Diagnostics diagnostics;
+
+    return &diagnostics;
+}
+
+auto Nedrysoft::Core::Diagnostics::bucketBounds() -> const QVector<double> & {
+    /**
+     * the bounds double from 1/8th of a millisecond, so a 16ms frame and a multi second stall both land in a
+     * bucket of useful resolution.
+     */
+
+    static const QVector<double> bounds = []() {
+        auto bounds = QVector<double>();
+        auto bound = FirstBucketBound;
+
+        for (auto bucket=0;bucket<BucketCount-1;bucket++) {
+            bounds.append(bound);
+
+            bound *= 2;
+        }
+
+        bounds.append(std::numeric_limits<double>::infinity());
+
+        return bounds;
+    }();
+
+    return bounds;
+}
+
+auto Nedrysoft::Core::Diagnostics::setEnabled(bool enabled) -> void {
+    m_enabled = enabled;
+}
+
+auto Nedrysoft::Core::Diagnostics::isEnabled() const -> bool {
+    return m_enabled;
+}
+
+auto Nedrysoft::Core::Diagnostics::record(const char *probe, double value) -> void {
+    if (!m_enabled) {
+        return;
+    }
+
+    auto &bounds = bucketBounds();
+    auto bucket = static_cast<int>(std::lower_bound(bounds.begin(), bounds.end(), value)-bounds.begin());
+
+    QMutexLocker locker(&m_mutex);
+
+    auto &histogram = m_histograms[QString::fromLatin1(probe)];
+
+    if (histogram.buckets.isEmpty()) {
+        histogram.buckets.resize(bounds.count());
+    }
+
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.sum += value;
+    histogram.maximum = std::max(histogram.maximum, value);
+}
+
+auto Nedrysoft::Core::Diagnostics::histograms() -> QMap<QString, Nedrysoft::Core::Diagnostics::Histogram> {
+    QMutexLocker locker(&m_mutex);
+
+    return m_histograms;
+}
+
+auto Nedrysoft::Core::Diagnostics::reset() -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_histograms.clear();
+}
+
+auto Nedrysoft::Core::Diagnostics::Histogram::percentile(double percentile) const -> double {
+    if (!count) {
+        return 0;
+    }
+
+    auto &bounds = bucketBounds();
+    auto target = static_cast<quint64>(std::ceil((percentile/100.0)*static_cast<double>(count)));
+    auto total = quint64(0);
+
+    for (auto bucket=0;bucket<buckets.count();bucket++) {
+        total += buckets.at(bucket);
+
+        if (total>=target) {
+            return std::min(bounds.at(bucket), maximum);
+        }
+    }
+
+    return maximum;
+}
+
+Nedrysoft::Core::DiagnosticsScope::DiagnosticsScope(const char *probe) :
+        m_probe(nullptr) {
+
+    if (Nedrysoft::Core::Diagnostics::getInstance()->isEnabled()) {
+        m_probe = probe;
+
+        m_timer.start();
+    }
+}
+
+Nedrysoft::Core::DiagnosticsScope::~DiagnosticsScope() {
+    if (!m_probe) {
+        return;
+    }
+
+    Nedrysoft::Core::Diagnostics::getInstance()->record(
+        m_probe,
+        static_cast<double>(m_timer.nsecsElapsed())/1000000.0 );
+}
+
+auto Nedrysoft::Core::Diagnostics::memoryUsage() -> QVector<Nedrysoft::Core::Diagnostics::MemoryUsage> {
+    QMap<QPair<QString, QString>, MemoryUsage> usage;
+
+    QMutexLocker locker(&m_mutex);
+
+    for (auto counter : m_memoryCounters) {
+        auto &entry = usage[qMakePair(counter->m_subsystem, counter->m_owner)];
+
+        entry.subsystem = counter->m_subsystem;
+        entry.owner = counter->m_owner;
+        entry.bytes += counter->bytes();
+        entry.allocations += counter->allocations();
+    }
+
+    return usage.values().toVector();
+}
+
+Nedrysoft::Core::MemoryCounter::MemoryCounter(const QString &subsystem, const QString &owner) :
+        m_subsystem(subsystem),
+        m_owner(owner),
+        m_bytes(0),
+        m_allocations(0) {
+
+    auto diagnostics = Nedrysoft::Core::Diagnostics::getInstance();
+
+    QMutexLocker locker(&diagnostics->m_mutex);
+
+    diagnostics->m_memoryCounters.append(this);
+}
+
+Nedrysoft::Core::MemoryCounter::~MemoryCounter() {
+    auto diagnostics = Nedrysoft::Core::Diagnostics::getInstance();
+
+    QMutexLocker locker(&diagnostics->m_mutex);
+
+    diagnostics->m_memoryCounters.removeOne(this);
+}
+
+auto Nedrysoft::Core::MemoryCounter::setOwner(const QString &owner) -> void {
+    // the owner is read under the diagnostics lock when the usage is collected.
+
+    QMutexLocker locker(&Nedrysoft::Core::Diagnostics::getInstance()->m_mutex);
+
+    m_owner = owner;
+}
+
+auto Nedrysoft::Core::MemoryCounter::add(qint64 bytes, qint64 allocations) -> void {
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_allocations.fetch_add(allocations, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::Core::MemoryCounter::remove(qint64 bytes, qint64 allocations) -> void {
+    m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    m_allocations.fetch_sub(allocations, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::Core::MemoryCounter::set(qint64 bytes, qint64 allocations) -> void {
+    m_bytes.store(bytes, std::memory_order_relaxed);
+    m_allocations.store(allocations, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::Core::MemoryCounter::bytes() const -> qint64 {
+    return m_bytes.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::Core::MemoryCounter::allocations() const -> qint64 {
+    return m_allocations.load(std::memory_order_relaxed);
+}
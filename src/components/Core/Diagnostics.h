@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_DIAGNOSTICS_H
+#define PINGNOO_COMPONENTS_CORE_DIAGNOSTICS_H
+
+#include "CoreSpec.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+namespace Nedrysoft { namespace Core {
+    class MemoryCounter;
+
+    /**
+     * @brief       The Diagnostics class collects histograms of timings and queue depths from instrumented code.
+     *
+     * @details     Recording is off until a diagnostics consumer (the diagnostics component) enables it, until then
+     *              a probe costs a single test.  Values are collected into fixed logarithmic buckets so that a
+     *              probe on a hot path does not allocate.
+     *
+     *              The memory used by each subsystem is accounted by MemoryCounter instances, these are always
+     *              maintained (an update is a pair of atomic additions) so the figures are available whether or not
+     *              recording is enabled.
+     *
+     * @class       Nedrysoft::Core::Diagnostics Diagnostics.h <Diagnostics>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC Diagnostics {
+        public:
+            /**
+             * @brief       A histogram of the values recorded by a probe.
+             */
+            struct Histogram {
+                QVector<quint64> buckets;
+                quint64 count = 0;
+                double sum = 0;
+                double maximum = 0;
+
+                /**
+                 * @brief       Returns the upper bound of the bucket containing the given percentile.
+                 *
+                 * @param[in]   percentile the percentile (0 to 100).
+                 *
+                 * @returns     the estimated value.
+                 */
+                auto percentile(double percentile) const -> double;
+            };
+
+            /**
+             * @brief       The memory accounted to a subsystem, optionally on behalf of an owner such as an editor.
+             */
+            struct MemoryUsage {
+                QString subsystem;
+                QString owner;
+                qint64 bytes = 0;
+                qint64 allocations = 0;
+            };
+
+        private:
+            /**
+             * @brief       Constructs the Diagnostics.
+             */
+            Diagnostics();
+
+        public:
+            /**
+             * @brief       Returns the Diagnostics instance.
+             *
+             * @returns     the diagnostics.
+             */
+            static auto getInstance() -> Nedrysoft::Core::Diagnostics *;
+
+            /**
+             * @brief       Returns the upper bound of each histogram bucket, the last bucket is unbounded.
+             *
+             * @returns     the bucket bounds.
+             */
+            static auto bucketBounds() -> const QVector<double> &;
+
+            /**
+             * @brief       Enables or disables recording.
+             *
+             * @param[in]   enabled true to record values; otherwise false.
+             */
+            auto setEnabled(bool enabled) -> void;
+
+            /**
+             * @brief       Returns whether values are being recorded.
+             *
+             * @returns     true if enabled; otherwise false.
+             */
+            auto isEnabled() const -> bool;
+
+            /**
+             * @brief       Records a value for a probe.
+             *
+             * @details     May be called from any thread.
+             *
+             * @param[in]   probe the name of the probe.
+             * @param[in]   value the value, timings are in milliseconds.
+             */
+            auto record(const char *probe, double value) -> void;
+
+            /**
+             * @brief       Returns a copy of the histograms recorded so far.
+             *
+             * @returns     the histograms keyed by probe name.
+             */
+            auto histograms() -> QMap<QString, Nedrysoft::Core::Diagnostics::Histogram>;
+
+            /**
+             * @brief       Discards the recorded values.
+             */
+            auto reset() -> void;
+
+            /**
+             * @brief       Returns the memory accounted by the memory counters.
+             *
+             * @details     Counters with the same subsystem and owner are combined.  May be called from any thread.
+             *
+             * @returns     the usage, ordered by subsystem and then owner.
+             */
+            auto memoryUsage() -> QVector<Nedrysoft::Core::Diagnostics::MemoryUsage>;
+
+        private:
+            friend class MemoryCounter;
+
+            //! @cond
+
+            std::atomic<bool> m_enabled;
+            QMutex m_mutex;
+            QMap<QString, Histogram> m_histograms;
+            QList<Nedrysoft::Core::MemoryCounter *> m_memoryCounters;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The DiagnosticsScope class records the duration of its lifetime as a diagnostics value.
+     *
+     * @class       Nedrysoft::Core::DiagnosticsScope Diagnostics.h <Diagnostics>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC DiagnosticsScope {
+        public:
+            /**
+             * @brief       Constructs a DiagnosticsScope which starts timing.
+             *
+             * @param[in]   probe the name of the probe.
+             */
+            explicit DiagnosticsScope(const char *probe);
+
+            /**
+             * @brief       Destroys the DiagnosticsScope, recording the elapsed time in milliseconds.
+             */
+            ~DiagnosticsScope();
+
+            DiagnosticsScope(const DiagnosticsScope &) = delete;
+            auto operator=(const DiagnosticsScope &) -> DiagnosticsScope & = delete;
+
+        private:
+            //! @cond
+
+            const char *m_probe;
+            QElapsedTimer m_timer;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The MemoryCounter class accounts the memory used by a subsystem.
+     *
+     * @details     A counter registers itself with the diagnostics for its lifetime, the owner of the memory adds
+     *              and removes bytes and allocations as they are made and released, or sets the totals when they
+     *              are measured periodically.  Updates may be made from any thread and never block.
+     *
+     * @class       Nedrysoft::Core::MemoryCounter Diagnostics.h <Diagnostics>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC MemoryCounter {
+        public:
+            /**
+             * @brief       Constructs a MemoryCounter.
+             *
+             * @param[in]   subsystem the name of the subsystem that the memory is accounted to.
+             * @param[in]   owner the owner within the subsystem, empty for memory shared by the whole process.
+             */
+            explicit MemoryCounter(const QString &subsystem, const QString &owner = QString());
+
+            /**
+             * @brief       Destroys the MemoryCounter, its memory is no longer accounted.
+             */
+            ~MemoryCounter();
+
+            MemoryCounter(const MemoryCounter &) = delete;
+            auto operator=(const MemoryCounter &) -> MemoryCounter & = delete;
+
+            /**
+             * @brief       Sets the owner that the memory is accounted to.
+             *
+             * @param[in]   owner the owner, empty for memory shared by the whole process.
+             */
+            auto setOwner(const QString &owner) -> void;
+
+            /**
+             * @brief       Accounts memory that has been allocated.
+             *
+             * @param[in]   bytes the number of bytes.
+             * @param[in]   allocations the number of allocations (or objects).
+             */
+            auto add(qint64 bytes, qint64 allocations = 1) -> void;
+
+            /**
+             * @brief       Accounts memory that has been released.
+             *
+             * @param[in]   bytes the number of bytes.
+             * @param[in]   allocations the number of allocations (or objects).
+             */
+            auto remove(qint64 bytes, qint64 allocations = 1) -> void;
+
+            /**
+             * @brief       Sets the measured totals.
+             *
+             * @param[in]   bytes the number of bytes in use.
+             * @param[in]   allocations the number of allocations (or objects) in use.
+             */
+            auto set(qint64 bytes, qint64 allocations) -> void;
+
+            /**
+             * @brief       Returns the number of bytes in use.
+             *
+             * @returns     the number of bytes.
+             */
+            auto bytes() const -> qint64;
+
+            /**
+             * @brief       Returns the number of allocations in use.
+             *
+             * @returns     the number of allocations.
+             */
+            auto allocations() const -> qint64;
+
+        private:
+            //! @cond
+
+            QString m_subsystem;
+            QString m_owner;
+            std::atomic<qint64> m_bytes;
+            std::atomic<qint64> m_allocations;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_DIAGNOSTICS_H
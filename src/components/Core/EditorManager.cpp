@@ -27,10 +27,12 @@
 
 #include "IContextManager.h"
 #include "IEditor.h"
+#include "Tracer.h"
 
 #include <QCheckBox>
 #include <QTabBar>
 #include <QTabWidget>
+#include <QTimer>
 #include <ThemeSupport>
 
 constexpr auto MacStylesheet = R"(
@@ -158,7 +160,8 @@ constexpr auto LinuxLightStylesheet = R"(
 
 Nedrysoft::Core::EditorManager::EditorManager(EditorManagerTabWidget *tabWidget) :
         m_tabWidget(tabWidget),
-        m_previousIndex(-1) {
+        m_previousIndex(-1),
+        m_editorOpened(false) {
 
     m_tabWidget->setTabsClosable(true);
     m_tabWidget->setDocumentMode(true);
@@ -192,6 +195,8 @@ Nedrysoft::Core::EditorManager::EditorManager(EditorManagerTabWidget *tabWidget)
 }
 
 auto Nedrysoft::Core::EditorManager::openEditor(IEditor *editor) -> int {
+    Nedrysoft::Core::TraceScope traceScope("ui", QString("EditorManager::openEditor %1").arg(editor->displayName()));
+
     m_editorMap[editor->widget()] = editor;
 
     auto tabIndex = m_tabWidget->addTab(editor->widget(), editor->displayName());
@@ -220,6 +225,19 @@ auto Nedrysoft::Core::EditorManager::openEditor(IEditor *editor) -> int {
         m_editorMap.remove(editor->widget());
     });
 
+    /**
+     * the trace is written once the first editor is on screen (after this event has been recorded) so that a
+     * startup trace is available without having to quit the application.
+     */
+
+    if (!m_editorOpened) {
+        m_editorOpened = true;
+
+        QTimer::singleShot(0, []() {
+            Nedrysoft::Core::Tracer::getInstance()->write();
+        });
+    }
+
     return 0;
 }
 
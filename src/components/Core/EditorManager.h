@@ -77,6 +77,7 @@ namespace Nedrysoft { namespace Core {
             EditorManagerTabWidget *m_tabWidget;
             int m_previousIndex;
             QMap<QWidget *, IEditor *> m_editorMap;
+            bool m_editorOpened;
 
             //! @endcond
     };
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ElapsedTimer.h"
+
+#include "Clock.h"
+
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto InvalidTime = -1;
+
+Nedrysoft::Core::ElapsedTimer::ElapsedTimer() :
+        m_startTime(InvalidTime) {
+
+}
+
+auto Nedrysoft::Core::ElapsedTimer::start() -> void {
+    m_startTime = Nedrysoft::Core::Clock::getInstance()->now();
+}
+
+auto Nedrysoft::Core::ElapsedTimer::restart() -> qint64 {
+    auto currentTime = Nedrysoft::Core::Clock::getInstance()->now();
+    auto elapsedTime = (currentTime-m_startTime)/NanosecondsInMillisecond;
+
+    m_startTime = currentTime;
+
+    return elapsedTime;
+}
+
+auto Nedrysoft::Core::ElapsedTimer::invalidate() -> void {
+    m_startTime = InvalidTime;
+}
+
+auto Nedrysoft::Core::ElapsedTimer::isValid() const -> bool {
+    return m_startTime!=InvalidTime;
+}
+
+auto Nedrysoft::Core::ElapsedTimer::elapsed() const -> qint64 {
+    return nsecsElapsed()/NanosecondsInMillisecond;
+}
+
+auto Nedrysoft::Core::ElapsedTimer::nsecsElapsed() const -> qint64 {
+    return Nedrysoft::Core::Clock::getInstance()->now()-m_startTime;
+}
+
+auto Nedrysoft::Core::ElapsedTimer::hasExpired(qint64 timeout) const -> bool {
+    return (timeout>=0) && (elapsed()>timeout);
+}
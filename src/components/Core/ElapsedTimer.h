@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_ELAPSEDTIMER_H
+#define PINGNOO_COMPONENTS_CORE_ELAPSEDTIMER_H
+
+#include "CoreSpec.h"
+
+#include <QtGlobal>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The ElapsedTimer class measures intervals on the installed clock.
+     *
+     * @details     The timer is a replacement for QElapsedTimer in code that schedules work or expires data, so
+     *              that it follows a virtual clock when one is installed.
+     *
+     * @class       Nedrysoft::Core::ElapsedTimer ElapsedTimer.h <ElapsedTimer>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC ElapsedTimer {
+        public:
+            /**
+             * @brief       Constructs an invalid ElapsedTimer.
+             */
+            ElapsedTimer();
+
+            /**
+             * @brief       Starts the timer.
+             */
+            auto start() -> void;
+
+            /**
+             * @brief       Restarts the timer.
+             *
+             * @returns     the number of milliseconds since the timer was last started.
+             */
+            auto restart() -> qint64;
+
+            /**
+             * @brief       Marks the timer as invalid.
+             */
+            auto invalidate() -> void;
+
+            /**
+             * @brief       Returns whether the timer has been started.
+             *
+             * @returns     true if the timer has been started; otherwise false.
+             */
+            auto isValid() const -> bool;
+
+            /**
+             * @brief       Returns the time since the timer was started.
+             *
+             * @returns     the time in milliseconds.
+             */
+            auto elapsed() const -> qint64;
+
+            /**
+             * @brief       Returns the time since the timer was started.
+             *
+             * @returns     the time in nanoseconds.
+             */
+            auto nsecsElapsed() const -> qint64;
+
+            /**
+             * @brief       Returns whether an interval has passed since the timer was started.
+             *
+             * @param[in]   timeout the interval in milliseconds.
+             *
+             * @returns     true if the interval has passed; otherwise false.
+             */
+            auto hasExpired(qint64 timeout) const -> bool;
+
+        private:
+            //! @cond
+
+            qint64 m_startTime;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_ELAPSEDTIMER_H
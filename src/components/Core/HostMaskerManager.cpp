@@ -23,10 +23,17 @@
 
 #include "HostMaskerManager.h"
 
+#include "IHostMasker.h"
+
 #include <QMetaEnum>
 #include <QSettings>
 
-Nedrysoft::Core::HostMaskerManager::HostMaskerManager() {
+constexpr auto MaximumCachedResults = 4096;
+
+Nedrysoft::Core::HostMaskerManager::HostMaskerManager() :
+        m_results(MaximumCachedResults),
+        m_generation(0) {
+
     QSettings settings;
 
     m_maskingState[Nedrysoft::Core::HostMaskType::Screen] = settings.value("HostMaskerManager/Screen",true).toBool();
@@ -71,13 +78,65 @@ auto Nedrysoft::Core::HostMaskerManager::enabled(Nedrysoft::Core::HostMaskType t
 auto Nedrysoft::Core::HostMaskerManager::add(Nedrysoft::Core::IHostMasker *hostMasker) -> void {
     if (!m_maskers.contains(hostMasker)) {
         m_maskers.append(hostMasker);
+
+        invalidate();
     }
 }
 
 auto Nedrysoft::Core::HostMaskerManager::remove(Nedrysoft::Core::IHostMasker *hostMasker) -> void {
-    m_maskers.removeAll(hostMasker);
+    if (m_maskers.removeAll(hostMasker)) {
+        invalidate();
+    }
 }
 
 auto Nedrysoft::Core::HostMaskerManager::maskers() -> QList<Nedrysoft::Core::IHostMasker *> {
     return m_maskers;
-}
\ No newline at end of file
+}
+
+auto Nedrysoft::Core::HostMaskerManager::mask(
+        int hop,
+        const QString &hostName,
+        const QString &hostAddress,
+        QString &maskedHostName,
+        QString &maskedHostAddress ) -> bool {
+
+    /**
+     * the generation is part of the key so that a result computed with an old configuration can never be
+     * returned, even if the cache has not yet been cleared.
+     */
+
+    auto key = QString("%1|%2|%3|%4").arg(m_generation).arg(hop).arg(hostName).arg(hostAddress);
+    auto result = m_results.object(key);
+
+    if (!result) {
+        result = new MaskResult{hostName, hostAddress, false};
+
+        for (auto masker : m_maskers) {
+            auto name = hostName;
+            auto address = hostAddress;
+
+            if (masker->mask(hop, hostName, hostAddress, name, address)) {
+                result->maskedHostName = name;
+                result->maskedHostAddress = address;
+                result->masked = true;
+
+                break;
+            }
+        }
+
+        m_results.insert(key, result);
+    }
+
+    maskedHostName = result->maskedHostName;
+    maskedHostAddress = result->maskedHostAddress;
+
+    return result->masked;
+}
+
+auto Nedrysoft::Core::HostMaskerManager::invalidate() -> void {
+    m_generation++;
+
+    m_results.clear();
+
+    Q_EMIT maskersChanged();
+}
@@ -29,8 +29,9 @@
 #include "IHostMaskerManager.h"
 
 #include <IInterface>
-#include <QObject>
+#include <QCache>
 #include <QMap>
+#include <QObject>
 
 namespace Nedrysoft { namespace Core {
     class IHostMasker;
@@ -99,9 +100,48 @@ namespace Nedrysoft { namespace Core {
              */
             virtual auto maskers() -> QList<Nedrysoft::Core::IHostMasker *>;
 
+            /**
+             * @brief       Masks a host name/ip using the registered host maskers.
+             *
+             * @see         Nedrysoft::Core::IHostMaskerManager::mask
+             *
+             * @param[in]   hop the hop number.
+             * @param[in]   hostName the host name to be checked.
+             * @param[in]   hostAddress the host IP to be checked.
+             * @param[out]  maskedHostName the masked host name.
+             * @param[out]  maskedHostAddress the masked host IP.
+             *
+             * @returns     returns true on replacement; otherwise false.
+             */
+            virtual auto mask(
+                    int hop,
+                    const QString &hostName,
+                    const QString &hostAddress,
+                    QString &maskedHostName,
+                    QString &maskedHostAddress ) -> bool;
+
+            /**
+             * @brief       Discards any remembered masking results.
+             *
+             * @see         Nedrysoft::Core::IHostMaskerManager::invalidate
+             */
+            virtual auto invalidate() -> void;
+
         private:
+            //! @cond
+
+            struct MaskResult {
+                QString maskedHostName;
+                QString maskedHostAddress;
+                bool masked;
+            };
+
             QMap<Nedrysoft::Core::HostMaskType, bool> m_maskingState;
             QList<Nedrysoft::Core::IHostMasker *> m_maskers;
+            QCache<QString, MaskResult> m_results;
+            quint64 m_generation;
+
+            //! @endcond
     };
 }}
 
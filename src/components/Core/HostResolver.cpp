@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostResolver.h"
+
+#include <QHostInfo>
+#include <QMetaObject>
+
+constexpr auto MaximumConcurrentLookups = 4;
+constexpr auto PositiveCacheTime = 60*60*1000;
+constexpr auto NegativeCacheTime = 5*60*1000;
+
+Nedrysoft::Core::HostResolver::HostResolver() :
+        m_activeLookups(0) {
+
+    m_clock.start();
+}
+
+Nedrysoft::Core::HostResolver::~HostResolver() {
+    m_cancellationToken.cancel();
+}
+
+auto Nedrysoft::Core::HostResolver::cachedHostName(const QHostAddress &address, QString &hostName) -> bool {
+    auto entry = m_cache.find(address);
+
+    if (entry==m_cache.end()) {
+        return false;
+    }
+
+    if (entry->expires<m_clock.elapsed()) {
+        m_cache.erase(entry);
+
+        return false;
+    }
+
+    hostName = entry->hostName.isEmpty() ? address.toString() : entry->hostName;
+
+    return true;
+}
+
+auto Nedrysoft::Core::HostResolver::resolve(
+        const QHostAddress &address,
+        QObject *context,
+        Nedrysoft::Core::HostResolverFunction function ) -> void {
+
+    if (address.isNull()) {
+        return;
+    }
+
+    auto hostName = QString();
+
+    if (cachedHostName(address, hostName)) {
+        function(address, hostName);
+
+        return;
+    }
+
+    /**
+     * an address that is already queued or being looked up gets the request attached to it, a route that is
+     * re-discovered only ever has one lookup per address in flight.
+     */
+
+    auto isPending = m_requests.contains(address);
+
+    m_requests[address].append(Request{context, function});
+
+    if (!isPending) {
+        m_queue.append(address);
+
+        startLookups();
+    }
+}
+
+auto Nedrysoft::Core::HostResolver::clear() -> void {
+    m_cache.clear();
+}
+
+auto Nedrysoft::Core::HostResolver::startLookups() -> void {
+    while ((m_activeLookups<MaximumConcurrentLookups) && (!m_queue.isEmpty())) {
+        auto address = m_queue.takeFirst();
+
+        m_activeLookups++;
+
+        /**
+         * a lookup can block for seconds, so it runs on Qt's lookup threads rather than the TaskPool where it would
+         * hold up the statistics.  The result is delivered to this object, the token also drops a result that
+         * arrives while the resolver is being destroyed.
+         */
+
+        auto token = m_cancellationToken;
+
+        QHostInfo::lookupHost(address.toString(), this, [this, address, token](const QHostInfo &hostInfo) {
+            if (token.isCancelled()) {
+                return;
+            }
+
+            m_activeLookups--;
+
+            auto hostName = QString();
+
+            if ((hostInfo.error()==QHostInfo::NoError) && (hostInfo.hostName()!=address.toString())) {
+                hostName = hostInfo.hostName();
+            }
+
+            finishLookup(address, hostName);
+
+            startLookups();
+        });
+    }
+}
+
+auto Nedrysoft::Core::HostResolver::finishLookup(const QHostAddress &address, const QString &hostName) -> void {
+    auto cacheTime = hostName.isEmpty() ? NegativeCacheTime : PositiveCacheTime;
+
+    m_cache[address] = CacheEntry{hostName, m_clock.elapsed()+cacheTime};
+
+    auto resolvedName = hostName.isEmpty() ? address.toString() : hostName;
+
+    for (auto &request : m_requests.take(address)) {
+        if (!request.context) {
+            continue;
+        }
+
+        auto function = request.function;
+
+        QMetaObject::invokeMethod(request.context, [function, address, resolvedName]() {
+            function(address, resolvedName);
+        });
+    }
+
+    Q_EMIT resolved(address, resolvedName);
+}
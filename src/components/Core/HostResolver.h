@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_HOSTRESOLVER_H
+#define PINGNOO_COMPONENTS_CORE_HOSTRESOLVER_H
+
+#include "CancellationToken.h"
+#include "CoreSpec.h"
+#include "ElapsedTimer.h"
+#include "IHostResolver.h"
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The HostResolver class resolves host names asynchronously.
+     *
+     * @details     Lookups are queued and a limited number are run at the same time so that a long route does not
+     *              flood the system resolver, requests for an address that is already being looked up are attached
+     *              to the outstanding lookup.  Names are cached for an hour, addresses without a name are cached for
+     *              a shorter period so that a name that appears later is eventually picked up.
+     *
+     *              The lookups run on Qt's lookup threads, never on the TaskPool, as a lookup can block its thread
+     *              for seconds.
+     */
+    class NEDRYSOFT_CORE_DLLSPEC HostResolver :
+            public Nedrysoft::Core::IHostResolver {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::Core::IHostResolver)
+
+        public:
+            /**
+             * @brief       Constructs a new HostResolver.
+             */
+            HostResolver();
+
+            /**
+             * @brief       Destroys the HostResolver.
+             */
+            ~HostResolver() override;
+
+            /**
+             * @brief       Returns the cached host name of an address.
+             *
+             * @see         Nedrysoft::Core::IHostResolver::cachedHostName
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  hostName the host name if one was cached; otherwise unchanged.
+             *
+             * @returns     true if the cache held a (non-expired) result; otherwise false.
+             */
+            auto cachedHostName(const QHostAddress &address, QString &hostName) -> bool override;
+
+            /**
+             * @brief       Resolves the host name of an address.
+             *
+             * @see         Nedrysoft::Core::IHostResolver::resolve
+             *
+             * @param[in]   address the address to resolve.
+             * @param[in]   context the object that the lifetime of the request is tied to.
+             * @param[in]   function the function called with the result.
+             */
+            auto resolve(
+                const QHostAddress &address,
+                QObject *context,
+                Nedrysoft::Core::HostResolverFunction function
+            ) -> void override;
+
+            /**
+             * @brief       Discards all cached results.
+             *
+             * @see         Nedrysoft::Core::IHostResolver::clear
+             */
+            auto clear() -> void override;
+
+        private:
+            /**
+             * @brief       Starts queued lookups until the concurrency limit is reached.
+             */
+            auto startLookups() -> void;
+
+            /**
+             * @brief       Stores the result of a lookup and notifies the waiting requests.
+             *
+             * @param[in]   address the address that was looked up.
+             * @param[in]   hostName the resolved name, or an empty string if the address has no name.
+             */
+            auto finishLookup(const QHostAddress &address, const QString &hostName) -> void;
+
+        private:
+            //! @cond
+
+            struct CacheEntry {
+                QString hostName;
+                qint64 expires;
+            };
+
+            struct Request {
+                QPointer<QObject> context;
+                Nedrysoft::Core::HostResolverFunction function;
+            };
+
+            QHash<QHostAddress, CacheEntry> m_cache;
+            QHash<QHostAddress, QList<Request> > m_requests;
+            QList<QHostAddress> m_queue;
+            Nedrysoft::Core::ElapsedTimer m_clock;
+            Nedrysoft::Core::CancellationToken m_cancellationToken;
+            int m_activeLookups;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_HOSTRESOLVER_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_IASNPROVIDER_H
+#define PINGNOO_COMPONENTS_CORE_IASNPROVIDER_H
+
+#include <IInterface>
+#include "CoreSpec.h"
+
+#include <QHostAddress>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       Interface definition of an autonomous system (AS) provider.
+     *
+     * @details     An AS provider maps an address to the autonomous system that announces it, the lookup is
+     *              answered locally without any network traffic.
+     *
+     * @class       Nedrysoft::Core::IASNProvider IASNProvider.h <IASNProvider>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC IASNProvider :
+            public Nedrysoft::ComponentSystem::IInterface {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
+
+        public:
+            /**
+             * @brief       Destroys the IASNProvider.
+             */
+            virtual ~IASNProvider() = default;
+
+            /**
+             * @brief       Returns the Nedrysoft::Core::IASNProvider instance.
+             */
+            static auto getInstance() -> IASNProvider * {
+                return ComponentSystem::getObject<IASNProvider>();
+            }
+
+            /**
+             * @brief       Finds the autonomous system that an address belongs to.
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  asNumber the AS number.
+             * @param[out]  owner the name of the organisation that owns the AS.
+             *
+             * @returns     true if the address is announced by an AS; otherwise false.
+             */
+            virtual auto lookup(const QHostAddress &address, quint32 &asNumber, QString &owner) -> bool = 0;
+
+            /**
+             * @brief       Signals that the AS data has been loaded or replaced.
+             *
+             * @details     Addresses that were previously looked up may now give a different result.
+             */
+            Q_SIGNAL void databaseChanged();
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::Core::IASNProvider, "com.nedrysoft.core.IASNProvider/1.0.0")
+
+#endif // PINGNOO_COMPONENTS_CORE_IASNPROVIDER_H
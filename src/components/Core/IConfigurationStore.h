@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_ICONFIGURATIONSTORE_H
+#define PINGNOO_COMPONENTS_CORE_ICONFIGURATIONSTORE_H
+
+#include <IInterface>
+#include "CoreSpec.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       Interface definition of the configuration store.
+     *
+     * @details     The configuration store persists JSON configuration files without blocking the caller.  A
+     *              saved configuration is held until changes have stopped for a short while, only the most
+     *              recent configuration of each file is written, and files are written on a background thread
+     *              to a temporary file which replaces the original once it is complete, so a file is never
+     *              left partially written.
+     *
+     * @class       Nedrysoft::Core::IConfigurationStore IConfigurationStore.h <IConfigurationStore>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC IConfigurationStore :
+            public Nedrysoft::ComponentSystem::IInterface {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
+
+        public:
+            /**
+             * @brief       Destroys the IConfigurationStore.
+             */
+            virtual ~IConfigurationStore() = default;
+
+            /**
+             * @brief       Returns the Nedrysoft::Core::IConfigurationStore instance.
+             */
+            static auto getInstance() -> IConfigurationStore * {
+                return ComponentSystem::getObject<IConfigurationStore>();
+            }
+
+            /**
+             * @brief       Saves a configuration file.
+             *
+             * @details     The file is written once changes have settled, a configuration saved again before then
+             *              replaces the earlier one.  The folder that holds the file is created if required.  May
+             *              be called from any thread.
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   configuration the configuration to write.
+             */
+            virtual auto save(const QString &filename, const QJsonObject &configuration) -> void = 0;
+
+            /**
+             * @brief       Saves a data file.
+             *
+             * @details     Behaves as save() for files that are not JSON, the data is written as given.  May be
+             *              called from any thread.
+             *
+             * @param[in]   filename the path of the file.
+             * @param[in]   data the contents of the file.
+             */
+            virtual auto saveData(const QString &filename, const QByteArray &data) -> void = 0;
+
+            /**
+             * @brief       Writes every pending configuration now.
+             *
+             * @details     Returns once the files have been written, used when a file must exist before the
+             *              caller continues (for example when exporting).  Must be called from the thread that
+             *              created the store.
+             *
+             * @returns     true if every file was written; otherwise false.
+             */
+            virtual auto flush() -> bool = 0;
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::Core::IConfigurationStore, "com.nedrysoft.core.IConfigurationStore/1.0.0")
+
+#endif // PINGNOO_COMPONENTS_CORE_ICONFIGURATIONSTORE_H
@@ -29,6 +29,7 @@
 #include "IMenu.h"
 #include <IInterface>
 
+#include <QApplication>
 #include <QDebug>
 #include <QMainWindow>
 #include <QObject>
@@ -135,6 +136,18 @@ namespace Nedrysoft { namespace Core {
 
         return nullptr;
     }
+
+    /**
+     * @brief       Returns whether the application is running without a user interface.
+     *
+     * @details     A headless application creates a QCoreApplication rather than a QApplication, components
+     *              must not create windows, widgets or actions when running headless.
+     *
+     * @returns     true if headless; otherwise false.
+     */
+    inline auto headless() -> bool {
+        return qobject_cast<QApplication *>(QCoreApplication::instance())==nullptr;
+    }
 }}
 
 Q_DECLARE_INTERFACE(Nedrysoft::Core::ICore, "com.nedrysoft.core.ICore/1.0.0")
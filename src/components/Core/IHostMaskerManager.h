@@ -107,6 +107,35 @@ namespace Nedrysoft { namespace Core {
              */
              virtual auto maskers() -> QList<Nedrysoft::Core::IHostMasker *> = 0;
 
+            /**
+             * @brief       Masks a host name/ip using the registered host maskers.
+             *
+             * @details     The maskers are tried in the order they were registered and the first one that makes a
+             *              replacement provides the result.  Results are remembered until the configuration of
+             *              a masker changes, so masking the same host again does not run the maskers.
+             *
+             * @param[in]   hop the hop number.
+             * @param[in]   hostName the host name to be checked.
+             * @param[in]   hostAddress the host IP to be checked.
+             * @param[out]  maskedHostName the masked host name.
+             * @param[out]  maskedHostAddress the masked host IP.
+             *
+             * @returns     returns true on replacement; otherwise false.
+             */
+            virtual auto mask(
+                    int hop,
+                    const QString &hostName,
+                    const QString &hostAddress,
+                    QString &maskedHostName,
+                    QString &maskedHostAddress ) -> bool = 0;
+
+            /**
+             * @brief       Discards any remembered masking results.
+             *
+             * @details     Must be called by a host masker whenever its configuration changes.
+             */
+            virtual auto invalidate() -> void = 0;
+
             // Classes with virtual functions should not have a public non-virtual destructor:
             virtual ~IHostMaskerManager() = default;
 
@@ -117,6 +146,12 @@ namespace Nedrysoft { namespace Core {
              * @parampin]   state true to mask the type; otherwise false.
              */
             Q_SIGNAL void maskStateChanged(Nedrysoft::Core::HostMaskType type, bool state);
+
+            /**
+             * @brief       This signal is emitted when the maskers or their configuration change, any masked values
+             *              held by the caller should be masked again.
+             */
+            Q_SIGNAL void maskersChanged();
     };
 }}
 
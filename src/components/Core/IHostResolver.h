@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_IHOSTRESOLVER_H
+#define PINGNOO_COMPONENTS_CORE_IHOSTRESOLVER_H
+
+#include <IInterface>
+#include "CoreSpec.h"
+
+#include <QHostAddress>
+#include <functional>
+
+namespace Nedrysoft { namespace Core {
+    using HostResolverFunction = std::function<void(const QHostAddress &, const QString &)>;
+
+    /**
+     * @brief       Interface definition of the host name resolver.
+     *
+     * @details     The host resolver performs reverse (PTR) lookups of addresses without blocking the caller, the
+     *              results are cached so that addresses which appear on many routes are only resolved once.
+     *
+     * @class       Nedrysoft::Core::IHostResolver IHostResolver.h <IHostResolver>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC IHostResolver :
+            public Nedrysoft::ComponentSystem::IInterface {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
+
+        public:
+            /**
+             * @brief       Destroys the IHostResolver.
+             */
+            virtual ~IHostResolver() = default;
+
+            /**
+             * @brief       Returns the Nedrysoft::Core::IHostResolver instance.
+             */
+            static auto getInstance() -> IHostResolver * {
+                return ComponentSystem::getObject<IHostResolver>();
+            }
+
+            /**
+             * @brief       Returns the cached host name of an address.
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  hostName the host name if one was cached; otherwise unchanged.
+             *
+             * @returns     true if the cache held a (non-expired) result; otherwise false.
+             */
+            virtual auto cachedHostName(const QHostAddress &address, QString &hostName) -> bool = 0;
+
+            /**
+             * @brief       Resolves the host name of an address.
+             *
+             * @details     The function is called on the thread of the context object once the name is known, if
+             *              the address has no name then the function receives the address as text.  A cached result
+             *              is delivered before this function returns.  The function is not called if the context
+             *              object is destroyed before the lookup completes.
+             *
+             * @param[in]   address the address to resolve.
+             * @param[in]   context the object that the lifetime of the request is tied to.
+             * @param[in]   function the function called with the result.
+             */
+            virtual auto resolve(
+                const QHostAddress &address,
+                QObject *context,
+                Nedrysoft::Core::HostResolverFunction function
+            ) -> void = 0;
+
+            /**
+             * @brief       Discards all cached results.
+             */
+            virtual auto clear() -> void = 0;
+
+            /**
+             * @brief       Signals that the host name of an address has been resolved.
+             *
+             * @param[out]  address the address that was resolved.
+             * @param[out]  hostName the host name, or the address as text if the address has no name.
+             */
+            Q_SIGNAL void resolved(const QHostAddress &address, const QString &hostName);
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::Core::IHostResolver, "com.nedrysoft.core.IHostResolver/1.0.0")
+
+#endif // PINGNOO_COMPONENTS_CORE_IHOSTRESOLVER_H
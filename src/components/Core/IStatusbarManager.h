@@ -29,6 +29,8 @@
 
 #include <IInterface>
 
+class QWidget;
+
 namespace Nedrysoft { namespace Core {
     /**
      * @brief       The IStatusbarManager describes a manager for status bars.
@@ -56,6 +58,24 @@ namespace Nedrysoft { namespace Core {
             static auto getInstance() -> IStatusbarManager * {
                 return ComponentSystem::getObject<IStatusbarManager>();
             }
+
+            /**
+             * @brief       Adds a widget to the status bar which is shown regardless of the current context.
+             *
+             * @note        The status bar takes ownership of the widget.
+             *
+             * @param[in]   widget the widget to add.
+             */
+            virtual auto addPermanentWidget(QWidget *widget) -> void = 0;
+
+            /**
+             * @brief       Removes a widget from the status bar.
+             *
+             * @note        Ownership of the widget passes back to the caller.
+             *
+             * @param[in]   widget the widget to remove.
+             */
+            virtual auto removeWidget(QWidget *widget) -> void = 0;
     };
 }}
 
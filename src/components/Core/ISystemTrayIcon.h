@@ -79,6 +79,17 @@ namespace Nedrysoft { namespace Core {
              */
             virtual auto geometry() -> QRect = 0;
 
+            /**
+             * @brief       Shows a notification balloon from the system tray icon.
+             *
+             * @note        Not every platform can show a notification from the icon, in which case the
+             *              message is discarded.
+             *
+             * @param[in]   title the title of the notification.
+             * @param[in]   message the body of the notification.
+             */
+            virtual auto showMessage(const QString &title, const QString &message) -> void = 0;
+
 #if defined(Q_OS_MACOS)
             /**
              * @brief       Returns the menu bar icon.
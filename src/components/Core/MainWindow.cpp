@@ -36,6 +36,7 @@
 #include "IRibbonPage.h"
 #include "RibbonBarManager.h"
 #include "SystemTrayIcon.h"
+#include "Tracer.h"
 #include "ui_MainWindow.h"
 
 #include <Component>
@@ -176,6 +177,8 @@ auto Nedrysoft::Core::MainWindow::updateTitlebar() -> void {
 }
 
 auto Nedrysoft::Core::MainWindow::initialise() -> void {
+    Nedrysoft::Core::TraceScope traceScope("ui", "MainWindow::initialise");
+
     auto ribbonBarManager = Nedrysoft::Core::IRibbonBarManager::getInstance();
 
     ribbonBarManager->setRibbonBar(ui->ribbonBar);
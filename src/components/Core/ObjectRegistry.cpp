@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ObjectRegistry.h"
+
+#include <IComponentManager>
+
+Nedrysoft::Core::ObjectRegistry::ObjectRegistry() :
+        m_valid(false) {
+
+}
+
+auto Nedrysoft::Core::ObjectRegistry::getInstance() -> Nedrysoft::Core::ObjectRegistry * {
+    static ObjectRegistry registry;
+
+    return &registry;
+}
+
+auto Nedrysoft::Core::ObjectRegistry::addObject(QObject *object) -> void {
+    Nedrysoft::ComponentSystem::addObject(object);
+
+    /**
+     * an object that is deleted without being removed would otherwise be left in the cached lists.
+     */
+
+    connect(object, &QObject::destroyed, this, [this]() {
+        invalidate();
+    });
+
+    invalidate();
+}
+
+auto Nedrysoft::Core::ObjectRegistry::removeObject(QObject *object) -> void {
+    disconnect(object, nullptr, this, nullptr);
+
+    Nedrysoft::ComponentSystem::removeObject(object);
+
+    invalidate();
+}
+
+auto Nedrysoft::Core::ObjectRegistry::validate() -> void {
+    auto objects = Nedrysoft::ComponentSystem::IComponentManager::getInstance()->allObjects();
+
+    if ((m_valid) && (objects.count()==m_objects.count())) {
+        return;
+    }
+
+    m_cache.clear();
+
+    m_objects = objects;
+    m_valid = true;
+}
+
+auto Nedrysoft::Core::ObjectRegistry::invalidate() -> void {
+    {
+        QMutexLocker locker(&m_mutex);
+
+        m_cache.clear();
+
+        m_valid = false;
+    }
+
+    Q_EMIT objectsChanged();
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_OBJECTREGISTRY_H
+#define PINGNOO_COMPONENTS_CORE_OBJECTREGISTRY_H
+
+#include "CoreSpec.h"
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <functional>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The ObjectRegistry class provides cached, typed lists of the objects in the component system.
+     *
+     * @details     ComponentSystem::getObjects walks the whole object pool and casts every object each time it is
+     *              called, the registry does that once per interface and keeps the result until an object is added
+     *              or removed.  Objects should be added and removed through the registry so that the lists are
+     *              invalidated and subscribers are told, an object added directly to the component system is
+     *              still picked up as the size of the pool is checked on every lookup.
+     *
+     * @class       Nedrysoft::Core::ObjectRegistry ObjectRegistry.h <ObjectRegistry>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC ObjectRegistry :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs the ObjectRegistry.
+             */
+            ObjectRegistry();
+
+        public:
+            /**
+             * @brief       Returns the ObjectRegistry instance.
+             *
+             * @returns     the registry.
+             */
+            static auto getInstance() -> Nedrysoft::Core::ObjectRegistry *;
+
+            /**
+             * @brief       Adds an object to the component system.
+             *
+             * @param[in]   object the object to add.
+             */
+            auto addObject(QObject *object) -> void;
+
+            /**
+             * @brief       Removes an object from the component system.
+             *
+             * @param[in]   object the object to remove.
+             */
+            auto removeObject(QObject *object) -> void;
+
+            /**
+             * @brief       Returns the objects that implement the given type.
+             *
+             * @returns     the list of objects.
+             */
+            template <class T>
+            auto objects() -> QList<T *> {
+                QMutexLocker locker(&m_mutex);
+
+                validate();
+
+                auto it = m_cache.find(std::type_index(typeid(T)));
+
+                if (it!=m_cache.end()) {
+                    return static_cast<CacheEntry<T> *>(it->second.get())->objects;
+                }
+
+                auto entry = new CacheEntry<T>;
+
+                for (auto object : m_objects) {
+                    auto castObject = qobject_cast<T *>(object);
+
+                    if (castObject) {
+                        entry->objects.append(castObject);
+                    }
+                }
+
+                m_cache[std::type_index(typeid(T))].reset(entry);
+
+                return entry->objects;
+            }
+
+            /**
+             * @brief       Returns the first object that implements the given type.
+             *
+             * @returns     the object if found; otherwise nullptr.
+             */
+            template <class T>
+            auto object() -> T * {
+                auto list = objects<T>();
+
+                if (list.isEmpty()) {
+                    return nullptr;
+                }
+
+                return list.first();
+            }
+
+            /**
+             * @brief       Calls a function with the objects of the given type whenever an object is added or
+             *              removed.
+             *
+             * @param[in]   context the subscription is removed when this object is destroyed.
+             * @param[in]   function the function to call with the new list of objects.
+             *
+             * @returns     the connection, which can be used to unsubscribe.
+             */
+            template <class T>
+            auto subscribe(QObject *context, std::function<void(const QList<T *> &)> function) ->
+                    QMetaObject::Connection {
+
+                return connect(this, &ObjectRegistry::objectsChanged, context, [this, function]() {
+                    function(objects<T>());
+                });
+            }
+
+            /**
+             * @brief       This signal is emitted when an object has been added or removed.
+             */
+            Q_SIGNAL void objectsChanged();
+
+        private:
+            /**
+             * @brief       Clears the cached lists if the object pool has changed since they were built.
+             *
+             * @note        Must be called with the mutex held.
+             */
+            auto validate() -> void;
+
+            /**
+             * @brief       Clears the cached lists and notifies subscribers.
+             */
+            auto invalidate() -> void;
+
+        private:
+            //! @cond
+
+            struct CacheEntryBase {
+                virtual ~CacheEntryBase() = default;
+            };
+
+            template <class T>
+            struct CacheEntry :
+                    CacheEntryBase {
+
+                QList<T *> objects;
+            };
+
+            QMutex m_mutex;
+            QList<QObject *> m_objects;
+            std::map<std::type_index, std::unique_ptr<CacheEntryBase> > m_cache;
+            bool m_valid;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_OBJECTREGISTRY_H
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_PROFILER_H
+#define PINGNOO_COMPONENTS_CORE_PROFILER_H
+
+/**
+ * @file        Profiler.h
+ *
+ * @brief       Profiling zones for an external profiler.
+ *
+ * @details     The zones are compiled in by configuring with Pingnoo_Profiler set to Tracy or ITT, a profiler
+ *              (the Tracy server, or VTune for ITT) can then be attached to a running session.  In a normal build
+ *              every macro expands to nothing, or to the plain operation it wraps, so the zones cost nothing.
+ *
+ *              PINGNOO_PROFILE_ZONE(name) times the rest of the enclosing scope, the name must be a string literal.
+ *
+ *              PINGNOO_PROFILE_LOCK(name, mutex) locks a mutex, a zone is only recorded when the mutex was held by
+ *              another thread, so the profile shows the time spent waiting rather than every acquisition.
+ *
+ *              PINGNOO_PROFILE_THREAD(name) names the calling thread in the profile.
+ *
+ *              PINGNOO_PROFILE_FRAME() marks the end of a drawn frame.
+ */
+
+#define PINGNOO_PROFILE_CONCAT_INNER(a, b) a##b
+#define PINGNOO_PROFILE_CONCAT(a, b) PINGNOO_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(PINGNOO_PROFILER_TRACY)
+
+#include <tracy/Tracy.hpp>
+
+#define PINGNOO_PROFILE_ZONE(name) ZoneScopedN(name)
+#define PINGNOO_PROFILE_THREAD(name) tracy::SetThreadName(name)
+#define PINGNOO_PROFILE_FRAME() FrameMark
+
+#elif defined(PINGNOO_PROFILER_ITT)
+
+#include <ittnotify.h>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The ProfileZone class records an ITT task covering its lifetime.
+     *
+     * @class       Nedrysoft::Core::ProfileZone Profiler.h <Profiler>
+     */
+    class ProfileZone {
+        public:
+            /**
+             * @brief       Constructs a ProfileZone which begins the task.
+             *
+             * @param[in]   name the name of the task.
+             */
+            explicit ProfileZone(__itt_string_handle *name) {
+                __itt_task_begin(domain(), __itt_null, __itt_null, name);
+            }
+
+            /**
+             * @brief       Destroys the ProfileZone, ending the task.
+             */
+            ~ProfileZone() {
+                __itt_task_end(domain());
+            }
+
+            ProfileZone(const ProfileZone &) = delete;
+            auto operator=(const ProfileZone &) -> ProfileZone & = delete;
+
+            /**
+             * @brief       Returns the domain that the tasks are recorded in.
+             *
+             * @returns     the domain.
+             */
+            static auto domain() -> __itt_domain * {
+                static auto domain = __itt_domain_create("Pingnoo");
+
+                return domain;
+            }
+    };
+}}
+
+#define PINGNOO_PROFILE_ZONE(name) \
+    static auto PINGNOO_PROFILE_CONCAT(profileName, __LINE__) = __itt_string_handle_create(name); \
+    Nedrysoft::Core::ProfileZone PINGNOO_PROFILE_CONCAT(profileZone, __LINE__)( \
+        PINGNOO_PROFILE_CONCAT(profileName, __LINE__))
+#define PINGNOO_PROFILE_THREAD(name) __itt_thread_set_name(name)
+#define PINGNOO_PROFILE_FRAME()
+
+#endif
+
+#if defined(PINGNOO_PROFILER_TRACY) || defined(PINGNOO_PROFILER_ITT)
+
+#define PINGNOO_PROFILE_LOCK(name, mutex) \
+    do { \
+        if (!(mutex).tryLock()) { \
+            PINGNOO_PROFILE_ZONE(name); \
+            (mutex).lock(); \
+        } \
+    } while (0)
+
+#else
+
+#define PINGNOO_PROFILE_ZONE(name)
+#define PINGNOO_PROFILE_LOCK(name, mutex) (mutex).lock()
+#define PINGNOO_PROFILE_THREAD(name)
+#define PINGNOO_PROFILE_FRAME()
+
+#endif
+
+#endif // PINGNOO_COMPONENTS_CORE_PROFILER_H
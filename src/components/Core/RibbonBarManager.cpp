@@ -26,6 +26,7 @@
 #include "ICommandManager.h"
 #include "RibbonActionProxy.h"
 #include "RibbonPage.h"
+#include "Tracer.h"
 
 constexpr auto RibbonOrderProperty = "nedrysoft.ribbon.order";
 
@@ -39,6 +40,8 @@ Nedrysoft::Core::RibbonBarManager::RibbonBarManager() :
 }
 
 auto Nedrysoft::Core::RibbonBarManager::addPage(QString title, QString id, float order) -> Nedrysoft::Core::IRibbonPage * {
+    Nedrysoft::Core::TraceScope traceScope("ui", QString("RibbonBarManager::addPage %1").arg(id));
+
     auto ribbonPage = new Nedrysoft::Core::RibbonPage(this);
     int tabIndex = -1;
 
@@ -23,4 +23,28 @@
 
 #include "StatusbarManager.h"
 
+#include "ICore.h"
+
+#include <QStatusBar>
+
 Nedrysoft::Core::StatusbarManager::StatusbarManager() = default;
+
+auto Nedrysoft::Core::StatusbarManager::addPermanentWidget(QWidget *widget) -> void {
+    auto mainWindow = Nedrysoft::Core::mainWindow();
+
+    if (!mainWindow) {
+        return;
+    }
+
+    mainWindow->statusBar()->addPermanentWidget(widget);
+}
+
+auto Nedrysoft::Core::StatusbarManager::removeWidget(QWidget *widget) -> void {
+    auto mainWindow = Nedrysoft::Core::mainWindow();
+
+    if (!mainWindow) {
+        return;
+    }
+
+    mainWindow->statusBar()->removeWidget(widget);
+}
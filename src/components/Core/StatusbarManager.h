@@ -38,6 +38,24 @@ namespace Nedrysoft { namespace Core {
              * @brief       Constructs a status bar manager.
              */
             StatusbarManager();
+
+            /**
+             * @brief       Adds a widget to the status bar which is shown regardless of the current context.
+             *
+             * @see         Nedrysoft::Core::IStatusbarManager::addPermanentWidget
+             *
+             * @param[in]   widget the widget to add.
+             */
+            auto addPermanentWidget(QWidget *widget) -> void override;
+
+            /**
+             * @brief       Removes a widget from the status bar.
+             *
+             * @see         Nedrysoft::Core::IStatusbarManager::removeWidget
+             *
+             * @param[in]   widget the widget to remove.
+             */
+            auto removeWidget(QWidget *widget) -> void override;
     };
 }}
 
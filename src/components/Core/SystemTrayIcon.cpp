@@ -118,6 +118,17 @@ auto Nedrysoft::Core::SystemTrayIcon::geometry() -> QRect {
 #endif
 }
 
+auto Nedrysoft::Core::SystemTrayIcon::showMessage(const QString &title, const QString &message) -> void {
+#if defined(Q_OS_MACOS)
+    Q_UNUSED(title)
+    Q_UNUSED(message)
+#else
+    if (QSystemTrayIcon::supportsMessages()) {
+        m_systemTrayIcon->showMessage(title, message);
+    }
+#endif
+}
+
 auto Nedrysoft::Core::SystemTrayIcon::setVisible(bool visible) -> void {
     m_visible = visible;
 
@@ -98,6 +98,16 @@ namespace Nedrysoft { namespace Core {
              */
             auto geometry() -> QRect override;
 
+            /**
+             * @brief       Shows a notification balloon from the system tray icon.
+             *
+             * @see         Nedrysoft::Core::ISystemTrayIcon::showMessage
+             *
+             * @param[in]   title the title of the notification.
+             * @param[in]   message the body of the notification.
+             */
+            auto showMessage(const QString &title, const QString &message) -> void override;
+
 #if defined(Q_OS_MACOS)
             /**
              * @brief       Shows the supplied menu.
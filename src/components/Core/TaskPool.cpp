@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TaskPool.h"
+
+#include <QThread>
+#include <algorithm>
+
+constexpr auto MinimumWorkers = 2;
+constexpr auto MaximumWorkers = 8;
+constexpr auto AffinityMultiplier = Q_UINT64_C(0x9e3779b97f4a7c15);
+constexpr auto BulkWorkerDivisor = 4;
+
+Nedrysoft::Core::TaskPool::TaskPool() :
+        m_queued(0),
+        m_backgroundLimit(0),
+        m_stopping(false) {
+
+    /**
+     * one core is left for the user interface and the engine threads.  There are always at least two workers, so
+     * that one can be kept back from normal and bulk work even on a machine with one or two cores.
+     */
+
+    auto workers = std::min(std::max(QThread::idealThreadCount()-1, MinimumWorkers), MaximumWorkers);
+
+    for (auto index=0;index<workers;index++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    /**
+     * normal and bulk work between them always leave a worker for interactive work and the affinity queues, bulk
+     * work only ever has a share of the pool.
+     */
+
+    m_lanes[static_cast<size_t>(Priority::Interactive)].limit = workers;
+    m_lanes[static_cast<size_t>(Priority::Normal)].limit = workers-1;
+    m_lanes[static_cast<size_t>(Priority::Bulk)].limit = std::max(workers/BulkWorkerDivisor, 1);
+
+    m_backgroundLimit = workers-1;
+
+    for (auto index=0;index<workers;index++) {
+        m_workers[index]->thread = std::thread([this, index]() {
+            run(index);
+        });
+    }
+}
+
+Nedrysoft::Core::TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto &worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+auto Nedrysoft::Core::TaskPool::getInstance() -> Nedrysoft::Core::TaskPool * {
+    static TaskPool taskPool;
+
+    return &taskPool;
+}
+
+auto Nedrysoft::Core::TaskPool::submit(quintptr affinity, std::function<void()> task) -> void {
+    /**
+     * affinities are often pointers, whose low bits are the same for every object, so the value is mixed before
+     * it is used to choose a worker.
+     */
+
+    auto hash = (static_cast<quint64>(affinity)*AffinityMultiplier) >> 32;
+    auto &worker = m_workers[static_cast<size_t>(hash % m_workers.size())];
+
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+
+        worker->tasks.push_back(std::move(task));
+    }
+
+    // the count is raised under the wake mutex so that a worker about to sleep cannot miss the task.
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_queued++;
+    }
+
+    m_wake.notify_one();
+}
+
+auto Nedrysoft::Core::TaskPool::submit(
+        Priority priority,
+        std::function<void()> task,
+        const Nedrysoft::Core::CancellationToken &token ) -> void {
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_lanes[static_cast<size_t>(priority)].tasks.push_back(LaneTask{std::move(task), token});
+    }
+
+    m_wake.notify_one();
+}
+
+auto Nedrysoft::Core::TaskPool::workerCount() const -> int {
+    return static_cast<int>(m_workers.size());
+}
+
+auto Nedrysoft::Core::TaskPool::take(int index, std::function<void()> &task) -> bool {
+    auto count = static_cast<int>(m_workers.size());
+
+    // a worker runs its own queue oldest first and steals the newest task of another queue.
+
+    for (auto offset=0;offset<count;offset++) {
+        auto &worker = m_workers[static_cast<size_t>((index+offset) % count)];
+
+        std::lock_guard<std::mutex> lock(worker->mutex);
+
+        if (worker->tasks.empty()) {
+            continue;
+        }
+
+        if (offset==0) {
+            task = std::move(worker->tasks.front());
+
+            worker->tasks.pop_front();
+        } else {
+            task = std::move(worker->tasks.back());
+
+            worker->tasks.pop_back();
+        }
+
+        m_queued--;
+
+        return true;
+    }
+
+    return false;
+}
+
+auto Nedrysoft::Core::TaskPool::runLane(Priority priority) -> bool {
+    auto &lane = m_lanes[static_cast<size_t>(priority)];
+    auto laneTask = LaneTask();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // tasks whose owner has gone are dropped here without taking up one of the workers of the lane.
+
+        while (true) {
+            if ((lane.tasks.empty()) || (!canStart(priority))) {
+                return false;
+            }
+
+            laneTask = std::move(lane.tasks.front());
+
+            lane.tasks.pop_front();
+
+            if (!laneTask.token.isCancelled()) {
+                break;
+            }
+        }
+
+        lane.running++;
+    }
+
+    if (laneTask.token.begin()) {
+        laneTask.task();
+
+        laneTask.token.end();
+    }
+
+    laneTask = LaneTask();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        lane.running--;
+    }
+
+    // a worker may be waiting for a place in the lane.
+
+    m_wake.notify_one();
+
+    return true;
+}
+
+auto Nedrysoft::Core::TaskPool::canStart(Priority priority) const -> bool {
+    auto &lane = m_lanes[static_cast<size_t>(priority)];
+
+    if (lane.running>=lane.limit) {
+        return false;
+    }
+
+    if (priority==Priority::Interactive) {
+        return true;
+    }
+
+    auto background = m_lanes[static_cast<size_t>(Priority::Normal)].running+
+                      m_lanes[static_cast<size_t>(Priority::Bulk)].running;
+
+    return background<m_backgroundLimit;
+}
+
+auto Nedrysoft::Core::TaskPool::hasLaneWork() const -> bool {
+    for (auto priority : {Priority::Interactive, Priority::Normal, Priority::Bulk}) {
+        if ((!m_lanes[static_cast<size_t>(priority)].tasks.empty()) && (canStart(priority))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Nedrysoft::Core::TaskPool::run(int index) -> void {
+    auto task = std::function<void()>();
+
+    while (true) {
+        if (runLane(Priority::Interactive)) {
+            continue;
+        }
+
+        if (take(index, task)) {
+            task();
+
+            task = nullptr;
+
+            continue;
+        }
+
+        if ((runLane(Priority::Normal)) || (runLane(Priority::Bulk))) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_wake.wait(lock, [this]() {
+            return (m_stopping) || (m_queued>0) || (hasLaneWork());
+        });
+
+        if (m_stopping) {
+            return;
+        }
+    }
+}
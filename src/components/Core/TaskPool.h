@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_TASKPOOL_H
+#define PINGNOO_COMPONENTS_CORE_TASKPOOL_H
+
+#include "CancellationToken.h"
+#include "CoreSpec.h"
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The TaskPool class runs short background tasks on a fixed number of worker threads.
+     *
+     * @details     Each worker has its own queue, a task is queued on the worker chosen by its affinity so that
+     *              the work for one owner (for example the statistics of one target) keeps returning to the same
+     *              thread while its data is still in that core's cache.  A worker that runs out of work steals
+     *              from the back of the other queues, so a busy owner does not hold up the rest.
+     *
+     *              The number of workers is bounded by the number of cores (with a minimum of two), however many
+     *              owners submit work, and tasks run in no particular order between owners.  An owner that needs its
+     *              tasks to run one at a time should only have one queued at once.
+     *
+     *              Work that does not need a particular worker is submitted to one of the priority lanes instead,
+     *              a free worker takes interactive work first, then the affinity queues, then normal and bulk work.
+     *              Each lane is limited to a number of workers and normal and bulk work together never take the last
+     *              worker, so slow background work always leaves a worker for interactive work and the affinity
+     *              queues, and bulk work (such as exports) cannot occupy the pool.  Work that blocks (such as name
+     *              lookups) does not belong in the pool at all.
+     *              A task in a lane may be given the cancellation token of its owner, so work queued by an object
+     *              that has been destroyed is discarded rather than run.
+     *
+     * @class       Nedrysoft::Core::TaskPool TaskPool.h <TaskPool>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC TaskPool {
+        public:
+            /**
+             * @brief       The lanes that work without an affinity is queued in.
+             */
+            enum class Priority {
+                Interactive,
+                Normal,
+                Bulk
+            };
+
+        private:
+            /**
+             * @brief       Constructs the TaskPool and starts the workers.
+             */
+            TaskPool();
+
+        public:
+            /**
+             * @brief       Destroys the TaskPool, tasks that have not started are discarded.
+             */
+            ~TaskPool();
+
+            /**
+             * @brief       Returns the TaskPool instance.
+             *
+             * @returns     the task pool.
+             */
+            static auto getInstance() -> Nedrysoft::Core::TaskPool *;
+
+            /**
+             * @brief       Queues a task.
+             *
+             * @param[in]   affinity a value identifying the owner of the task, tasks with the same affinity are
+             *              queued on the same worker.
+             * @param[in]   task the task to run.
+             */
+            auto submit(quintptr affinity, std::function<void()> task) -> void;
+
+            /**
+             * @brief       Queues a task in a priority lane.
+             *
+             * @details     Tasks in a lane are started in the order they were queued, up to the number of workers
+             *              that the lane is limited to.
+             *
+             * @param[in]   priority the lane to queue the task in.
+             * @param[in]   task the task to run.
+             * @param[in]   token the token of the owner of the task, the task is not run if it has been cancelled.
+             */
+            auto submit(
+                Priority priority,
+                std::function<void()> task,
+                const Nedrysoft::Core::CancellationToken &token = Nedrysoft::Core::CancellationToken()
+            ) -> void;
+
+            /**
+             * @brief       Returns the number of worker threads.
+             *
+             * @returns     the number of workers.
+             */
+            auto workerCount() const -> int;
+
+        private:
+            //! @cond
+
+            struct Worker {
+                std::mutex mutex;
+                std::deque<std::function<void()> > tasks;
+                std::thread thread;
+            };
+
+            struct LaneTask {
+                std::function<void()> task;
+                Nedrysoft::Core::CancellationToken token;
+            };
+
+            struct Lane {
+                std::deque<LaneTask> tasks;
+                int running = 0;
+                int limit = 0;
+            };
+
+            auto run(int index) -> void;
+
+            auto take(int index, std::function<void()> &task) -> bool;
+
+            auto runLane(Priority priority) -> bool;
+
+            auto canStart(Priority priority) const -> bool;
+
+            auto hasLaneWork() const -> bool;
+
+            std::vector<std::unique_ptr<Worker> > m_workers;
+
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::atomic<int> m_queued;
+            std::array<Lane, 3> m_lanes;
+            int m_backgroundLimit;
+            bool m_stopping;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_TASKPOOL_H
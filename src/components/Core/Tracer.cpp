@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tracer.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <spdlog/spdlog.h>
+
+constexpr auto TraceEnvironmentVariable = "PINGNOO_TRACE";
+
+Nedrysoft::Core::Tracer::Tracer() :
+        m_filename(QString::fromLocal8Bit(qgetenv(TraceEnvironmentVariable))) {
+
+    m_clock.start();
+}
+
+auto Nedrysoft::Core::Tracer::getInstance() -> Nedrysoft::Core::Tracer * {
+    static Tracer tracer;
+
+    return &tracer;
+}
+
+auto Nedrysoft::Core::Tracer::isEnabled() const -> bool {
+    return !m_filename.isEmpty();
+}
+
+auto Nedrysoft::Core::Tracer::timestamp() const -> double {
+    return static_cast<double>(m_clock.nsecsElapsed())/1000.0;
+}
+
+auto Nedrysoft::Core::Tracer::addEvent(
+        const char *category,
+        const QString &name,
+        double start,
+        double duration) -> void {
+
+    if (!isEnabled()) {
+        return;
+    }
+
+    auto threadId = QThread::currentThreadId();
+
+    QMutexLocker locker(&m_mutex);
+
+    /**
+     * threads are numbered in the order they are first seen, the main thread records the first event so it is
+     * always thread 0 and the viewer lists it at the top.
+     */
+
+    auto thread = m_threads.indexOf(threadId);
+
+    if (thread==-1) {
+        thread = m_threads.count();
+
+        auto threadName = QThread::currentThread()->objectName();
+
+        if (threadName.isEmpty()) {
+            threadName = (QThread::currentThread()==qApp->thread()) ? QString("Main") : QString("Thread %1").arg(thread);
+        }
+
+        m_threads.append(threadId);
+        m_threadNames.append(threadName);
+    }
+
+    m_events.push_back(Event{category, name, start, duration, thread});
+}
+
+auto Nedrysoft::Core::Tracer::write() -> bool {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto processId = static_cast<int>(QCoreApplication::applicationPid());
+    QJsonArray traceEvents;
+
+    for (auto thread=0; thread<m_threadNames.count(); thread++) {
+        traceEvents.append(QJsonObject{
+            {"name", "thread_name"},
+            {"ph", "M"},
+            {"pid", processId},
+            {"tid", thread},
+            {"args", QJsonObject{{"name", m_threadNames.at(thread)}}}
+        });
+    }
+
+    for (const auto &event : m_events) {
+        traceEvents.append(QJsonObject{
+            {"name", event.name},
+            {"cat", event.category},
+            {"ph", "X"},
+            {"ts", event.start},
+            {"dur", event.duration},
+            {"pid", processId},
+            {"tid", event.thread}
+        });
+    }
+
+    QSaveFile traceFile(m_filename);
+
+    if (!traceFile.open(QFile::WriteOnly)) {
+        SPDLOG_WARN(QString("Unable to open trace file %1.").arg(m_filename).toStdString());
+
+        return false;
+    }
+
+    traceFile.write(QJsonDocument(QJsonObject{
+        {"traceEvents", traceEvents},
+        {"displayTimeUnit", "ms"}
+    }).toJson(QJsonDocument::Compact));
+
+    if (!traceFile.commit()) {
+        SPDLOG_WARN(QString("Unable to write trace file %1.").arg(m_filename).toStdString());
+
+        return false;
+    }
+
+    return true;
+}
+
+Nedrysoft::Core::TraceScope::TraceScope(const char *category, const QString &name) :
+        m_category(category),
+        m_start(-1) {
+
+    auto tracer = Nedrysoft::Core::Tracer::getInstance();
+
+    if (tracer->isEnabled()) {
+        m_name = name;
+        m_start = tracer->timestamp();
+    }
+}
+
+Nedrysoft::Core::TraceScope::~TraceScope() {
+    if (m_start<0) {
+        return;
+    }
+
+    auto tracer = Nedrysoft::Core::Tracer::getInstance();
+
+    tracer->addEvent(m_category, m_name, m_start, tracer->timestamp()-m_start);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_CORE_TRACER_H
+#define PINGNOO_COMPONENTS_CORE_TRACER_H
+
+#include "CoreSpec.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+namespace Nedrysoft { namespace Core {
+    /**
+     * @brief       The Tracer class records timed trace events and writes them in the Chrome trace event format.
+     *
+     * @details     Tracing is enabled by setting PINGNOO_TRACE to the name of the file to write (the application
+     *              sets it from the --trace command line option), the file can be opened in chrome://tracing or
+     *              the Perfetto UI.  When tracing is disabled a trace scope costs a single test.
+     *
+     * @class       Nedrysoft::Core::Tracer Tracer.h <Tracer>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC Tracer {
+        private:
+            /**
+             * @brief       Constructs the Tracer.
+             */
+            Tracer();
+
+        public:
+            /**
+             * @brief       Returns the Tracer instance.
+             *
+             * @returns     the tracer.
+             */
+            static auto getInstance() -> Nedrysoft::Core::Tracer *;
+
+            /**
+             * @brief       Returns whether tracing is enabled.
+             *
+             * @returns     true if trace events are recorded; otherwise false.
+             */
+            auto isEnabled() const -> bool;
+
+            /**
+             * @brief       Returns the time since the tracer was created.
+             *
+             * @returns     the time in microseconds.
+             */
+            auto timestamp() const -> double;
+
+            /**
+             * @brief       Records a complete event.
+             *
+             * @details     May be called from any thread, the event is attributed to the calling thread.
+             *
+             * @param[in]   category the category of the event.
+             * @param[in]   name the name of the event.
+             * @param[in]   start the start time of the event in microseconds.
+             * @param[in]   duration the duration of the event in microseconds.
+             */
+            auto addEvent(const char *category, const QString &name, double start, double duration) -> void;
+
+            /**
+             * @brief       Writes the events recorded so far to the trace file.
+             *
+             * @details     The whole file is rewritten, so this can be called at points of interest (such as when
+             *              the first editor has opened) as well as at exit.
+             *
+             * @returns     true if the file was written; otherwise false.
+             */
+            auto write() -> bool;
+
+        private:
+            //! @cond
+
+            struct Event {
+                const char *category;
+                QString name;
+                double start;
+                double duration;
+                int thread;
+            };
+
+            QElapsedTimer m_clock;
+            QString m_filename;
+            QMutex m_mutex;
+            std::vector<Event> m_events;
+            QList<Qt::HANDLE> m_threads;
+            QStringList m_threadNames;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The TraceScope class records a trace event covering its lifetime.
+     *
+     * @class       Nedrysoft::Core::TraceScope Tracer.h <Tracer>
+     */
+    class NEDRYSOFT_CORE_DLLSPEC TraceScope {
+        public:
+            /**
+             * @brief       Constructs a TraceScope which starts timing the event.
+             *
+             * @param[in]   category the category of the event.
+             * @param[in]   name the name of the event.
+             */
+            TraceScope(const char *category, const QString &name);
+
+            /**
+             * @brief       Destroys the TraceScope, recording the event.
+             */
+            ~TraceScope();
+
+            TraceScope(const TraceScope &) = delete;
+            auto operator=(const TraceScope &) -> TraceScope & = delete;
+
+        private:
+            //! @cond
+
+            const char *m_category;
+            QString m_name;
+            double m_start;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_CORE_TRACER_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DiagnosticsComponent.h"
+
+#include "DiagnosticsStatusWidget.h"
+#include "EventLoopMonitor.h"
+
+#include <Diagnostics>
+#include <ICore>
+#include <IStatusbarManager>
+
+DiagnosticsComponent::DiagnosticsComponent() :
+        m_eventLoopMonitor(nullptr),
+        m_statusWidget(nullptr) {
+
+}
+
+DiagnosticsComponent::~DiagnosticsComponent() {
+
+}
+
+auto DiagnosticsComponent::initialiseEvent() -> void {
+    Nedrysoft::Core::Diagnostics::getInstance()->setEnabled(true);
+
+    m_eventLoopMonitor = new Nedrysoft::Diagnostics::EventLoopMonitor;
+}
+
+auto DiagnosticsComponent::initialisationFinishedEvent() -> void {
+    if (Nedrysoft::Core::headless()) {
+        return;
+    }
+
+    auto statusbarManager = Nedrysoft::Core::IStatusbarManager::getInstance();
+
+    if (statusbarManager) {
+        m_statusWidget = new Nedrysoft::Diagnostics::DiagnosticsStatusWidget;
+
+        statusbarManager->addPermanentWidget(m_statusWidget);
+    }
+}
+
+auto DiagnosticsComponent::finaliseEvent() -> void {
+    Nedrysoft::Core::Diagnostics::getInstance()->setEnabled(false);
+
+    if (m_statusWidget) {
+        auto statusbarManager = Nedrysoft::Core::IStatusbarManager::getInstance();
+
+        if (statusbarManager) {
+            statusbarManager->removeWidget(m_statusWidget);
+        }
+
+        delete m_statusWidget;
+    }
+
+    if (m_eventLoopMonitor) {
+        delete m_eventLoopMonitor;
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSCOMPONENT_H
+#define PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSCOMPONENT_H
+
+#include <IComponent>
+#include "DiagnosticsSpec.h"
+
+namespace Nedrysoft { namespace Diagnostics {
+    class DiagnosticsStatusWidget;
+    class EventLoopMonitor;
+}}
+
+/**
+ * @brief       The DiagnosticsComponent class enables the diagnostics probes and measures the event loop lag,
+ *              a summary is shown in the status bar.
+ */
+class NEDRYSOFT_DIAGNOSTICS_DLLSPEC DiagnosticsComponent :
+        public QObject,
+        public Nedrysoft::ComponentSystem::IComponent {
+
+    private:
+        Q_OBJECT
+
+        Q_PLUGIN_METADATA(IID NedrysoftComponentInterfaceIID FILE "metadata.json")
+
+        Q_INTERFACES(Nedrysoft::ComponentSystem::IComponent)
+
+    public:
+        /**
+         * @brief       Constructs the DiagnosticsComponent.
+         */
+        DiagnosticsComponent();
+
+        /**
+         * @brief       Destroys the DiagnosticsComponent.
+         */
+        ~DiagnosticsComponent();
+
+    public:
+        /**
+         * @brief       The initialiseEvent is called by the component loader to initialise the component.
+         *
+         * @details     Called by the component loader after all components have been loaded, called in load order.
+         *
+         * @see         Nedrysoft::ComponentSystem::IComponent::initialiseEvent
+         */
+        auto initialiseEvent() -> void override;
+
+        /**
+         * @brief       The initialisationFinishedEvent function is called by the component loader after all
+         *              components have been initialised.
+         *
+         * @details     The status bar is only available once the core component has created the main window.
+         *
+         * @see         Nedrysoft::ComponentSystem::IComponent::initialisationFinishedEvent
+         */
+        auto initialisationFinishedEvent() -> void override;
+
+        /**
+         *  @brief       The finaliseEvent is called by the component loader to de-initialise the component.
+         *
+         *  @details    Called by the component loader in reverse load order to shutdown the component.
+         *
+         *  @see         Nedrysoft::ComponentSystem::IComponent::finaliseEvent
+         */
+        auto finaliseEvent() -> void override;
+
+    private:
+        //! @cond
+
+        Nedrysoft::Diagnostics::EventLoopMonitor *m_eventLoopMonitor;
+        Nedrysoft::Diagnostics::DiagnosticsStatusWidget *m_statusWidget;
+
+        //! @endcond
+};
+
+#endif // PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSCOMPONENT_H
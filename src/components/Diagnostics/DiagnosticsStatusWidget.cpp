@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DiagnosticsStatusWidget.h"
+
+#include <Diagnostics>
+#include <ICore>
+#include <IPingEngineFactory>
+#include <ObjectRegistry>
+#include <QContextMenuEvent>
+#include <QFileDialog>
+#include <QMenu>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QTimer>
+#include <limits>
+
+constexpr auto UpdateInterval = 1000;
+constexpr auto SummaryPercentile = 99.0;
+
+constexpr auto EventLoopLagProbe = "Event loop lag (ms)";
+constexpr auto TablePaintProbe = "Route table cell paint (ms)";
+constexpr auto PlotReplotProbe = "Plot replot (ms)";
+constexpr auto QueueDepthProbe = "Statistics queue depth";
+constexpr auto SchedulingLagProbe = "Ping scheduling lag (ms)";
+constexpr auto BytesPerMegabyte = 1024.0*1024.0;
+
+Nedrysoft::Diagnostics::DiagnosticsStatusWidget::DiagnosticsStatusWidget(QWidget *parent) :
+        QLabel(parent),
+        m_updateTimer(new QTimer(this)) {
+
+    connect(m_updateTimer, &QTimer::timeout, this, [this]() {
+        updateText();
+    });
+
+    m_updateTimer->start(UpdateInterval);
+
+    updateText();
+}
+
+auto Nedrysoft::Diagnostics::DiagnosticsStatusWidget::updateText() -> void {
+    auto histograms = Nedrysoft::Core::Diagnostics::getInstance()->histograms();
+
+    auto percentile = [&histograms](const char *probe) {
+        return histograms.value(probe).percentile(SummaryPercentile);
+    };
+
+    auto statistics = Nedrysoft::RouteAnalyser::PingEngineStatistics();
+
+    for (auto factory :
+            Nedrysoft::Core::ObjectRegistry::getInstance()->objects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+
+        statistics += factory->statistics();
+    }
+
+    auto memoryUsage = Nedrysoft::Core::Diagnostics::getInstance()->memoryUsage();
+    qint64 totalMemory = 0;
+
+    for (auto &usage : memoryUsage) {
+        totalMemory += usage.bytes;
+    }
+
+    setText(tr("Lag %1 ms  Paint %2 ms  Replot %3 ms  Queue %4  Send %5 ms  Drops %6  Memory %7 MB")
+            .arg(percentile(EventLoopLagProbe), 0, 'f', 1)
+            .arg(percentile(TablePaintProbe), 0, 'f', 2)
+            .arg(percentile(PlotReplotProbe), 0, 'f', 1)
+            .arg(histograms.value(QueueDepthProbe).maximum, 0, 'f', 0)
+            .arg(percentile(SchedulingLagProbe), 0, 'f', 2)
+            .arg(statistics.receiveDrops+statistics.evictedRequests+statistics.sendErrors)
+            .arg(static_cast<double>(totalMemory)/BytesPerMegabyte, 0, 'f', 1) );
+
+    auto toolTip = tr("99th percentile since the diagnostics were last reset, right click to export or reset.");
+
+    /**
+     * the engine counters are cumulative and are not cleared by a reset, a rising drop count means that loss is
+     * being caused by this host rather than the network.
+     */
+
+    if (statistics.valid) {
+        toolTip += "\n\n"+tr("Ping engines: %1 sent, %2 send errors, %3 received, %4 late, %5 duplicated, "
+                              "%6 reordered, %7 unmatched, %8 timed out, %9 outstanding, %10 evicted, "
+                              "%11 dropped by the kernel.")
+                .arg(statistics.packetsSent)
+                .arg(statistics.sendErrors)
+                .arg(statistics.packetsReceived)
+                .arg(statistics.lateReplies)
+                .arg(statistics.duplicateReplies)
+                .arg(statistics.reorderedReplies)
+                .arg(statistics.unmatchedReplies)
+                .arg(statistics.timedOut)
+                .arg(statistics.outstandingRequests)
+                .arg(statistics.evictedRequests)
+                .arg(statistics.receiveDrops);
+    }
+
+    /**
+     * the memory is only what the subsystems account for themselves, it is a breakdown to find which of them is
+     * growing rather than the size of the process.
+     */
+
+    if (!memoryUsage.isEmpty()) {
+        toolTip += "\n\n"+tr("Memory:");
+
+        for (auto &usage : memoryUsage) {
+            auto name = usage.subsystem;
+
+            if (!usage.owner.isEmpty()) {
+                name = QString("%1 (%2)").arg(usage.subsystem).arg(usage.owner);
+            }
+
+            toolTip += "\n"+tr("%1: %2 MB in %3 allocations")
+                    .arg(name)
+                    .arg(static_cast<double>(usage.bytes)/BytesPerMegabyte, 0, 'f', 2)
+                    .arg(usage.allocations);
+        }
+    }
+
+    setToolTip(toolTip);
+}
+
+auto Nedrysoft::Diagnostics::DiagnosticsStatusWidget::contextMenuEvent(QContextMenuEvent *event) -> void {
+    QMenu menu;
+
+    auto exportAction = menu.addAction(tr("Export Histograms..."));
+    auto resetAction = menu.addAction(tr("Reset"));
+
+    auto selectedAction = menu.exec(event->globalPos());
+
+    if (selectedAction==exportAction) {
+        auto filename = QFileDialog::getSaveFileName(
+                Nedrysoft::Core::mainWindow(),
+                tr("Export Histograms"),
+                QString(),
+                tr("CSV Files (*.csv)") );
+
+        if (!filename.isEmpty()) {
+            exportHistograms(filename);
+        }
+    } else if (selectedAction==resetAction) {
+        Nedrysoft::Core::Diagnostics::getInstance()->reset();
+
+        updateText();
+    }
+}
+
+auto Nedrysoft::Diagnostics::DiagnosticsStatusWidget::exportHistograms(const QString &filename) -> bool {
+    QSaveFile file(filename);
+
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        return false;
+    }
+
+    auto histograms = Nedrysoft::Core::Diagnostics::getInstance()->histograms();
+    auto &bounds = Nedrysoft::Core::Diagnostics::bucketBounds();
+
+    QTextStream stream(&file);
+
+    /**
+     * one row per bucket, the upper bound of the last bucket is written as inf so that the file can be loaded
+     * straight into a spreadsheet or a plotting script.
+     */
+
+    stream << "probe,upper_bound,count\n";
+
+    for (auto histogram=histograms.constBegin();histogram!=histograms.constEnd();histogram++) {
+        for (auto bucket=0;bucket<histogram->buckets.count();bucket++) {
+            auto bound = bounds.at(bucket);
+
+            stream << "\"" << histogram.key() << "\","
+                   << ((bound==std::numeric_limits<double>::infinity()) ? QString("inf") : QString::number(bound))
+                   << "," << histogram->buckets.at(bucket) << "\n";
+        }
+    }
+
+    stream.flush();
+
+    return file.commit();
+}
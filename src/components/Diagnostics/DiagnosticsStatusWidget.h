@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSSTATUSWIDGET_H
+#define PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSSTATUSWIDGET_H
+
+#include <QLabel>
+
+class QTimer;
+
+namespace Nedrysoft { namespace Diagnostics {
+    /**
+     * @brief       The DiagnosticsStatusWidget class shows a summary of the diagnostics in the status bar.
+     *
+     * @details     The 99th percentile of the event loop lag, route table paint, plot replot and ping scheduling
+     *              times are shown along with the largest result queue depth and the number of packets lost by
+     *              the ping engines on this host, the full histograms can be exported from the context menu.
+     */
+    class DiagnosticsStatusWidget :
+            public QLabel {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a DiagnosticsStatusWidget.
+             *
+             * @param[in]   parent the owner widget.
+             */
+            explicit DiagnosticsStatusWidget(QWidget *parent=nullptr);
+
+            /**
+             * @brief       Writes the histograms to a CSV file.
+             *
+             * @param[in]   filename the file to write.
+             *
+             * @returns     true if the file was written; otherwise false.
+             */
+            static auto exportHistograms(const QString &filename) -> bool;
+
+        protected:
+            /**
+             * @brief       Reimplements: QWidget::contextMenuEvent(QContextMenuEvent *event).
+             *
+             * @param[in]   event the context menu event.
+             */
+            auto contextMenuEvent(QContextMenuEvent *event) -> void override;
+
+        private:
+            /**
+             * @brief       Updates the summary text.
+             */
+            auto updateText() -> void;
+
+        private:
+            //! @cond
+
+            QTimer *m_updateTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_DIAGNOSTICS_DIAGNOSTICSSTATUSWIDGET_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EventLoopMonitor.h"
+
+#include <Diagnostics>
+#include <QTimer>
+#include <algorithm>
+
+constexpr auto SampleInterval = 50;
+constexpr auto NanosecondsPerMillisecond = 1000000.0;
+
+Nedrysoft::Diagnostics::EventLoopMonitor::EventLoopMonitor(QObject *parent) :
+        QObject(parent),
+        m_timer(new QTimer(this)),
+        m_lastLag(0) {
+
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(SampleInterval);
+
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        measure();
+    });
+
+    m_elapsedTimer.start();
+    m_timer->start();
+}
+
+Nedrysoft::Diagnostics::EventLoopMonitor::~EventLoopMonitor() = default;
+
+auto Nedrysoft::Diagnostics::EventLoopMonitor::lastLag() const -> double {
+    return m_lastLag;
+}
+
+auto Nedrysoft::Diagnostics::EventLoopMonitor::measure() -> void {
+    auto elapsed = static_cast<double>(m_elapsedTimer.nsecsElapsed())/NanosecondsPerMillisecond;
+
+    m_elapsedTimer.restart();
+
+    /**
+     * a timeout can be delivered slightly early, that is timer jitter rather than a negative lag.
+     */
+
+    m_lastLag = std::max(0.0, elapsed-SampleInterval);
+
+    Nedrysoft::Core::Diagnostics::getInstance()->record("Event loop lag (ms)", m_lastLag);
+}
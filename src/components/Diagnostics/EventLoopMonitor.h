@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_DIAGNOSTICS_EVENTLOOPMONITOR_H
+#define PINGNOO_COMPONENTS_DIAGNOSTICS_EVENTLOOPMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+namespace Nedrysoft { namespace Diagnostics {
+    /**
+     * @brief       The EventLoopMonitor class measures how late the event loop of its thread runs a timer.
+     *
+     * @details     A precise timer is started at a fixed interval, the time by which each timeout is later than
+     *              the interval is the time the event loop spent busy with other work (painting, model updates,
+     *              signals from the engine threads) and is recorded as the event loop lag.
+     */
+    class EventLoopMonitor :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs an EventLoopMonitor for the calling thread.
+             *
+             * @param[in]   parent the owner of this object.
+             */
+            explicit EventLoopMonitor(QObject *parent=nullptr);
+
+            /**
+             * @brief       Destroys the EventLoopMonitor.
+             */
+            ~EventLoopMonitor() override;
+
+            /**
+             * @brief       Returns the most recent lag.
+             *
+             * @returns     the lag in milliseconds.
+             */
+            auto lastLag() const -> double;
+
+        private:
+            /**
+             * @brief       Records the lag of the timeout that has just been delivered.
+             */
+            auto measure() -> void;
+
+        private:
+            //! @cond
+
+            QTimer *m_timer;
+            QElapsedTimer m_elapsedTimer;
+            double m_lastLag;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_DIAGNOSTICS_EVENTLOOPMONITOR_H
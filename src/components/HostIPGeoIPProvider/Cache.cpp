@@ -23,20 +23,57 @@
 
 #include "Cache.h"
 
+#include <Clock>
 #include <ICore>
 
 #include <QDateTime>
 #include <QDir>
+#include <QJsonDocument>
 #include <QJsonArray>
+#include <QMetaObject>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlResult>
+#include <QThread>
 #include <spdlog/spdlog.h>
 
 constexpr auto CacheDatabase = "Nedrysoft::HostIPGeoIPProvider::Cache";
+constexpr auto WriterDatabase = "Nedrysoft::HostIPGeoIPProvider::Cache::Writer";
+constexpr auto RecentEntries = 1024;
+constexpr auto FlushInterval = 2000;
+constexpr auto FlushThreshold = 32;
+constexpr auto MemorySubsystem = "hostip.info GeoIP cache";
+constexpr auto RecordSizeGain = 16;
+constexpr auto MaximumAge = 30*24*60*60;
+constexpr auto CompactionInterval = 60*60*1000;
+
+Nedrysoft::HostIPGeoIPProvider::Cache::Cache() :
+        m_recent(RecentEntries),
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_recordSize(0),
+        m_memory(MemorySubsystem) {
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushInterval);
+
+    QObject::connect(&m_flushTimer, &QTimer::timeout, [this]() {
+        flush();
+    });
+
+    m_compactionTimer.setInterval(CompactionInterval);
+
+    QObject::connect(&m_compactionTimer, &QTimer::timeout, [this]() {
+        QMetaObject::invokeMethod(m_context, [this]() {
+            compact();
+        }, Qt::QueuedConnection);
+    });
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
 
-Nedrysoft::HostIPGeoIPProvider::Cache::Cache() {
     auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
 
     auto dbFileInfo = QFileInfo(storageLocation, "host-ip-cache.db");
@@ -63,6 +100,12 @@ Nedrysoft::HostIPGeoIPProvider::Cache::Cache() {
 
     QSqlQuery query(database);
 
+    // readers are not blocked by the writer in write ahead log mode, the mode is stored in the database file.
+
+    if ((!query.exec("PRAGMA journal_mode=WAL")) || (!query.exec("PRAGMA synchronous=NORMAL"))) {
+        SPDLOG_WARN(QString("error enabling write ahead log. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
     auto result = query.exec(R"(CREATE TABLE IF NOT EXISTS ip (
                                   id INTEGER PRIMARY KEY,
                                   name TEXT,
@@ -77,40 +120,189 @@ Nedrysoft::HostIPGeoIPProvider::Cache::Cache() {
         SPDLOG_WARN(QString("error creating table. (%1)").arg(query.lastError().text()).toStdString());
     }
 
+    /**
+     * older databases allowed the same host to be stored more than once, only the newest record is kept so that
+     * the name can be given a unique index.
+     */
+
+    result = query.exec("DELETE FROM ip WHERE id NOT IN (SELECT MAX(id) FROM ip GROUP BY name)");
+
+    if (result) {
+        result = query.exec("CREATE UNIQUE INDEX IF NOT EXISTS ip_name ON ip (name)");
+    }
+
+    if (!result) {
+        SPDLOG_WARN(QString("error creating index. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
     query.finish();
+
+    auto filename = dbFileInfo.absoluteFilePath();
+
+    QMetaObject::invokeMethod(m_context, [this, filename]() {
+        openWriter(filename);
+
+        compact();
+    }, Qt::QueuedConnection);
+
+    m_compactionTimer.start();
 }
 
 Nedrysoft::HostIPGeoIPProvider::Cache::~Cache() {
+    flush();
+
+    m_compactionTimer.stop();
+
+    // the records flushed above are written before the writer is closed, the thread works in order.
+
+    QMetaObject::invokeMethod(m_context, []() {
+        QSqlDatabase::removeDatabase(WriterDatabase);
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+
     QSqlDatabase::removeDatabase(CacheDatabase);
 }
 
 auto Nedrysoft::HostIPGeoIPProvider::Cache::add(QJsonObject object) -> void {
-    QSqlDatabase database = QSqlDatabase::database(CacheDatabase);
+    auto record = QJsonObject();
+
+    record["name"] = object["ip"];
+    record["creationTime"] = QJsonValue::fromVariant(Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch());
+    record["country"] = object["country_name"];
+    record["countryCode"] = object["country_code"];
+    record["city"] = object["city"];
+
+    auto recentRecord = new QJsonObject(record);
+
+    recentRecord->remove("name");
+
+    m_recent.insert(record["name"].toString(), recentRecord);
+
+    m_pendingRecords.append(record);
+
+    updateMemory(record);
+
+    if (m_pendingRecords.count()>=FlushThreshold) {
+        flush();
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+auto Nedrysoft::HostIPGeoIPProvider::Cache::flush() -> void {
+    m_flushTimer.stop();
+
+    if (m_pendingRecords.isEmpty()) {
+        return;
+    }
+
+    auto records = m_pendingRecords;
+
+    m_pendingRecords.clear();
+
+    QMetaObject::invokeMethod(m_context, [this, records]() {
+        write(records);
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::HostIPGeoIPProvider::Cache::openWriter(const QString &filename) -> void {
+    auto database = QSqlDatabase::addDatabase("QSQLITE", WriterDatabase);
+
+    database.setDatabaseName(filename);
+
+    if (!database.open()) {
+        SPDLOG_ERROR(QString("error opening database. (%1)").arg(database.lastError().text()).toStdString());
+
+        return;
+    }
+
     QSqlQuery query(database);
 
-    query.prepare("INSERT INTO ip (name, creationTime, country, countryCode, city) "
+    if (!query.exec("PRAGMA synchronous=NORMAL")) {
+        SPDLOG_WARN(QString("error setting synchronous mode. (%1)").arg(query.lastError().text()).toStdString());
+    }
+}
+
+auto Nedrysoft::HostIPGeoIPProvider::Cache::write(const QList<QJsonObject> &records) -> void {
+    QSqlDatabase database = QSqlDatabase::database(WriterDatabase);
+
+    if (!database.isOpen()) {
+        return;
+    }
+
+    database.transaction();
+
+    QSqlQuery query(database);
+
+    query.prepare("INSERT OR REPLACE INTO ip (name, creationTime, country, countryCode, city) "
                   "VALUES (:name, :creationTime, :country, :countryCode, :city)");
 
-    query.bindValue(":name", object["ip"].toVariant());
-#if (QT_VERSION_MAJOR>=6)
-    query.bindValue(":creationTime", QDateTime::currentDateTimeUtc().toSecsSinceEpoch());
-#else
-    query.bindValue(":creationTime", QDateTime::currentDateTimeUtc().toTime_t());
-#endif
-    query.bindValue(":country", object["country_name"].toVariant());
-    query.bindValue(":countryCode", object["country_code"].toVariant());
-    query.bindValue(":city", object["city"].toVariant());
+    for (const auto &record : records) {
+        for (auto it = record.begin(); it != record.end(); it++) {
+            query.bindValue(":"+it.key(), it.value().toVariant());
+        }
 
-    auto result = query.exec();
+        if (!query.exec()) {
+            SPDLOG_WARN(QString("error adding record. (%1)").arg(query.lastError().text()).toStdString());
+        }
+    }
 
-    if (!result) {
-        SPDLOG_WARN(QString("error adding record. (%1)").arg(query.lastError().text()).toStdString());
+    query.finish();
+
+    if (!database.commit()) {
+        SPDLOG_WARN(QString("error committing records. (%1)").arg(database.lastError().text()).toStdString());
+    }
+}
+
+auto Nedrysoft::HostIPGeoIPProvider::Cache::compact() -> void {
+    QSqlDatabase database = QSqlDatabase::database(WriterDatabase);
+
+    if (!database.isOpen()) {
+        return;
+    }
+
+    QSqlQuery query(database);
+
+    query.prepare("DELETE FROM ip WHERE creationTime<:expiryTime");
+    query.bindValue(":expiryTime", Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch()-MaximumAge);
+
+    if (!query.exec()) {
+        SPDLOG_WARN(QString("error removing expired records. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
+    if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+        SPDLOG_WARN(QString("error checkpointing database. (%1)").arg(query.lastError().text()).toStdString());
     }
 
     query.finish();
 }
 
+auto Nedrysoft::HostIPGeoIPProvider::Cache::isExpired(const QJsonObject &object) -> bool {
+    auto creationTime = object["creationTime"].toVariant().toLongLong();
+
+    return creationTime<Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch()-MaximumAge;
+}
+
 auto Nedrysoft::HostIPGeoIPProvider::Cache::find(const QString &name, QJsonObject &object) -> bool {
+    auto recentRecord = m_recent.object(name);
+
+    if (recentRecord) {
+        if (isExpired(*recentRecord)) {
+            m_recent.remove(name);
+
+            return false;
+        }
+
+        object = *recentRecord;
+
+        return true;
+    }
+
     QSqlDatabase database = QSqlDatabase::database(CacheDatabase);
     QSqlQuery query(database);
     bool queryResult = false;
@@ -125,7 +317,13 @@ auto Nedrysoft::HostIPGeoIPProvider::Cache::find(const QString &name, QJsonObjec
             object["countryCode"] = QJsonValue::fromVariant(query.value("countryCode"));
             object["city"] = QJsonValue::fromVariant(query.value("city"));
 
-            queryResult = true;
+            if (!isExpired(object)) {
+                m_recent.insert(name, new QJsonObject(object));
+
+                updateMemory(object);
+
+                queryResult = true;
+            }
         }
     }
 
@@ -133,3 +331,17 @@ auto Nedrysoft::HostIPGeoIPProvider::Cache::find(const QString &name, QJsonObjec
 
     return queryResult;
 }
+
+auto Nedrysoft::HostIPGeoIPProvider::Cache::updateMemory(const QJsonObject &record) -> void {
+    auto size = static_cast<qint64>(sizeof(QJsonObject))+QJsonDocument(record).toJson(QJsonDocument::Compact).size();
+
+    if (!m_recordSize) {
+        m_recordSize = size;
+    } else {
+        m_recordSize += (size-m_recordSize)/RecordSizeGain;
+    }
+
+    auto records = static_cast<qint64>(m_recent.count()+m_pendingRecords.count());
+
+    m_memory.set(records*m_recordSize, records);
+}
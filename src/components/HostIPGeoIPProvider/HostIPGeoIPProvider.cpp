@@ -24,13 +24,15 @@
 #include "HostIPGeoIPProvider.h"
 #include "Cache.h"
 
+#include <Clock>
 #include <QJsonDocument>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
 
 Nedrysoft::HostIPGeoIPProvider::HostIPGeoIPProvider::HostIPGeoIPProvider() :
-        m_cache(new Nedrysoft::HostIPGeoIPProvider::Cache()) {
+        m_cache(new Nedrysoft::HostIPGeoIPProvider::Cache()),
+        m_networkAccessManager(new QNetworkAccessManager(this)) {
 
 }
 
@@ -46,48 +48,62 @@ auto Nedrysoft::HostIPGeoIPProvider::HostIPGeoIPProvider::lookup(
 
     if (m_cache->find(host, cacheResultObject)) {
         function(host, cacheResultObject.toVariantMap());
-    } else {
-        auto manager = new QNetworkAccessManager();
 
-        connect(manager, &QNetworkAccessManager::finished, [this, host, function](QNetworkReply *reply) {
-            if (reply->error() == QNetworkReply::NoError) {
-                auto resultMap = QVariantMap();
+        return;
+    }
+
+    /**
+     * a host that already has a request in flight just waits for that reply, every hop of a route that is
+     * re-discovered would otherwise send its own request for the same address.
+     */
+
+    if (m_pendingLookups.contains(host)) {
+        m_pendingLookups[host].append(function);
+
+        return;
+    }
+
+    m_pendingLookups[host].append(function);
+
+    auto reply = m_networkAccessManager->get(
+        QNetworkRequest(QUrl("https://api.hostip.info/get_json.php?ip=" + host))
+    );
 
-                auto jsonDocument = QJsonDocument::fromJson(reply->readAll());
+    connect(reply, &QNetworkReply::finished, this, [this, host, reply]() {
+        auto functions = m_pendingLookups.take(host);
 
-                if (jsonDocument.isObject()) {
-                    auto requiredFields = QStringList() << "country_name" << "city" << "country_code";
-                    auto responseValid = true;
+        if (reply->error() == QNetworkReply::NoError) {
+            auto resultMap = QVariantMap();
 
-                    for (const auto &field : requiredFields) {
-                        if (!jsonDocument.object().contains(field)) {
-                            responseValid = false;
-                            break;
-                        }
+            auto jsonDocument = QJsonDocument::fromJson(reply->readAll());
+
+            if (jsonDocument.isObject()) {
+                auto requiredFields = QStringList() << "country_name" << "city" << "country_code";
+                auto responseValid = true;
+
+                for (const auto &field : requiredFields) {
+                    if (!jsonDocument.object().contains(field)) {
+                        responseValid = false;
+                        break;
                     }
+                }
+
+                if (responseValid) {
+                    m_cache->add(jsonDocument.object());
 
-                    if (responseValid) {
-                        m_cache->add(jsonDocument.object());
-
-                        resultMap["creationTime"] = jsonDocument.object()["country_name"].toVariant();
-                        resultMap["city"] = jsonDocument.object()["city"].toVariant();
-                        resultMap["countryCode"] = jsonDocument.object()["country_code"].toVariant();
-#if (QT_VERSION_MAJOR>=6)
-                        resultMap["creationTime"] = QDateTime::currentDateTimeUtc().toSecsSinceEpoch();
-#else
-                        resultMap["creationTime"] = QDateTime::currentDateTimeUtc().toTime_t();
-#endif
+                    resultMap["creationTime"] = jsonDocument.object()["country_name"].toVariant();
+                    resultMap["city"] = jsonDocument.object()["city"].toVariant();
+                    resultMap["countryCode"] = jsonDocument.object()["country_code"].toVariant();
+                    resultMap["creationTime"] = Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch();
+                    for (const auto &function : functions) {
                         function(host, resultMap);
                     }
                 }
             }
+        }
 
-            reply->manager()->deleteLater();
-            reply->deleteLater();
-        });
-
-        manager->get(QNetworkRequest(QUrl("https://api.hostip.info/get_json.php?ip=" + host)));
-    }
+        reply->deleteLater();
+    });
 }
 
 auto Nedrysoft::HostIPGeoIPProvider::HostIPGeoIPProvider::lookup(const QString host) -> void {
@@ -28,9 +28,13 @@
 
 #include <IInterface>
 #include <IGeoIPProvider>
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QVariantMap>
 
+class QNetworkAccessManager;
+
 namespace Nedrysoft { namespace HostIPGeoIPProvider {
     class Cache;
     /**
@@ -84,6 +88,8 @@ namespace Nedrysoft { namespace HostIPGeoIPProvider {
             //! @cond
 
             Nedrysoft::HostIPGeoIPProvider::Cache *m_cache;
+            QNetworkAccessManager *m_networkAccessManager;
+            QHash<QString, QList<Nedrysoft::Core::GeoFunction> > m_pendingLookups;
 
             //! @endcond
     };
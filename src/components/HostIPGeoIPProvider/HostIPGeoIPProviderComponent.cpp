@@ -25,6 +25,7 @@
 #include "HostIPGeoIPProviderComponent.h"
 
 #include <IComponentManager>
+#include <ObjectRegistry>
 
 HostIPGeoIPProviderComponent::HostIPGeoIPProviderComponent() :
         m_provider(nullptr) {
@@ -38,12 +39,12 @@ HostIPGeoIPProviderComponent::~HostIPGeoIPProviderComponent() {
 auto HostIPGeoIPProviderComponent::initialiseEvent() -> void {
     m_provider = new Nedrysoft::HostIPGeoIPProvider::HostIPGeoIPProvider();
 
-    Nedrysoft::ComponentSystem::addObject(m_provider);
+    Nedrysoft::Core::ObjectRegistry::getInstance()->addObject(m_provider);
 }
 
 auto HostIPGeoIPProviderComponent::finaliseEvent() -> void {
     if (m_provider) {
-        Nedrysoft::ComponentSystem::removeObject(m_provider);
+        Nedrysoft::Core::ObjectRegistry::getInstance()->removeObject(m_provider);
 
         delete m_provider;
     }
@@ -26,7 +26,9 @@
 #include "ICMPAPIPingTarget.h"
 #include "ICMPAPIPingTransmitter.h"
 
+#include <Clock>
 #include <QMutex>
+#include <QMutexLocker>
 #include <QThread>
 #include <WS2tcpip.h>
 
@@ -38,7 +40,10 @@
 constexpr auto DefaultTransmitTimeout = 1000;
 constexpr auto DefaultReplyTimeout = 3000;
 constexpr auto PingPayloadLength = 64;
+constexpr auto MaximumPayloadSize = 65500;
+constexpr auto PingPayloadPattern = "pingnoo ping ";
 constexpr auto NanosecondsInMillisecond = 1.0e6;
+constexpr auto IcmpErrorDataSize = 8;
 
 /**
  * @brief       Private class to store the engines instance data.
@@ -55,10 +60,83 @@ class Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngineData {
                 m_transmitter(nullptr),
                 m_transmitterThread(nullptr),
                 m_timeout(DefaultReplyTimeout),
-                m_ipVersion(Nedrysoft::Core::IPVersion::V4) {
+                m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+                m_payloadSize(PingPayloadLength),
+                m_dontFragment(false),
+                m_ipv4Handle(INVALID_HANDLE_VALUE),
+                m_ipv6Handle(INVALID_HANDLE_VALUE) {
 
         }
 
+        /**
+         * @brief       Destroys the ICMPAPIPingEngineData, closing any cached ICMP handles.
+         */
+        ~ICMPAPIPingEngineData() {
+            if (m_ipv4Handle != INVALID_HANDLE_VALUE) {
+                IcmpCloseHandle(m_ipv4Handle);
+            }
+
+            if (m_ipv6Handle != INVALID_HANDLE_VALUE) {
+                IcmpCloseHandle(m_ipv6Handle);
+            }
+        }
+
+        /**
+         * @brief       Takes a reply buffer from the pool.
+         *
+         * @details     Buffers are only ever grown, so once the engine has run for a round no further heap
+         *              allocations are made for replies.
+         *
+         * @param[in]   size the minimum size of the buffer.
+         *
+         * @returns     the buffer, which should be returned with releaseReplyBuffer().
+         */
+        auto acquireReplyBuffer(int size) -> QByteArray {
+            QByteArray replyBuffer;
+
+            m_bufferMutex.lock();
+
+            if (!m_replyBuffers.isEmpty()) {
+                replyBuffer = m_replyBuffers.takeLast();
+            }
+
+            m_bufferMutex.unlock();
+
+            if (replyBuffer.length() < size) {
+                replyBuffer.resize(size);
+            }
+
+            return replyBuffer;
+        }
+
+        /**
+         * @brief       Returns a reply buffer to the pool.
+         *
+         * @param[in]   replyBuffer the buffer.
+         */
+        auto releaseReplyBuffer(const QByteArray &replyBuffer) -> void {
+            QMutexLocker locker(&m_bufferMutex);
+
+            m_replyBuffers.append(replyBuffer);
+        }
+
+        /**
+         * @brief       Returns the request payload for the given size.
+         *
+         * @param[in]   payloadSize the number of bytes of payload.
+         *
+         * @returns     the payload; the data is shared with the cached copy.
+         */
+        auto requestData(int payloadSize) -> QByteArray {
+            QMutexLocker locker(&m_bufferMutex);
+
+            if (m_requestData.length() != payloadSize) {
+                m_requestData = Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::payloadData(payloadSize);
+            }
+
+            return m_requestData;
+        }
+
         friend class ICMPAPIPingEngine;
 
     private:
@@ -74,6 +152,16 @@ class Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngineData {
 
         int m_timeout;
         int m_interval;
+        int m_payloadSize;
+        bool m_dontFragment;
+
+        QMutex m_handleMutex;
+        HANDLE m_ipv4Handle;
+        HANDLE m_ipv6Handle;
+
+        QMutex m_bufferMutex;
+        QList<QByteArray> m_replyBuffers;
+        QByteArray m_requestData;
 };
 
 Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::ICMPAPIPingEngine(Nedrysoft::Core::IPVersion version) :
@@ -161,6 +249,30 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::setTimeout(int timeout) ->
     return true;
 }
 
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::setPayloadSize(int payloadSize) -> bool {
+    if ((payloadSize < 0) || (payloadSize > MaximumPayloadSize)) {
+        return false;
+    }
+
+    d->m_payloadSize = payloadSize;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::payloadSize() -> int {
+    return d->m_payloadSize;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::setDontFragment(bool dontFragment) -> bool {
+    d->m_dontFragment = dontFragment;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::dontFragment() -> bool {
+    return d->m_dontFragment;
+}
+
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::saveConfiguration() -> QJsonObject {
     return QJsonObject();
 }
@@ -172,7 +284,31 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::loadConfiguration(QJsonObj
 }
 
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::epoch() -> QDateTime {
-    return QDateTime::currentDateTime();
+    return Nedrysoft::Core::Clock::getInstance()->currentDateTime();
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::icmpHandle(Nedrysoft::Core::IPVersion version) -> void * {
+    QMutexLocker locker(&d->m_handleMutex);
+
+    if (version == Nedrysoft::Core::IPVersion::V4) {
+        if (d->m_ipv4Handle == INVALID_HANDLE_VALUE) {
+            d->m_ipv4Handle = IcmpCreateFile();
+        }
+
+        return d->m_ipv4Handle;
+    }
+
+    if (d->m_ipv6Handle == INVALID_HANDLE_VALUE) {
+        d->m_ipv6Handle = Icmp6CreateFile();
+    }
+
+    return d->m_ipv6Handle;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::payloadData(int payloadSize) -> QByteArray {
+    QByteArray pattern(PingPayloadPattern);
+
+    return pattern.repeated(( payloadSize / pattern.length() ) + 1).left(payloadSize);
 }
 
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
@@ -180,7 +316,16 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
         int ttl,
         double timeout ) -> Nedrysoft::RouteAnalyser::PingResult {
 
-    QByteArray dataBuffer = QString("pingnoo ping").toLatin1();
+    return singleShot(hostAddress, ttl, timeout, d->m_payloadSize);
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout,
+        int payloadSize ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    QByteArray dataBuffer = d->requestData(payloadSize);
     QByteArray replyBuffer;
     HANDLE icmpHandle;
     Nedrysoft::RouteAnalyser::PingResult::ResultCode resultCode =
@@ -192,7 +337,7 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
     int returnValue;
     sockaddr_in6 sourceAddress, targetAddress;
 
-    auto epoch = QDateTime::currentDateTime();
+    auto epoch = Nedrysoft::Core::Clock::getInstance()->currentDateTime();
 
 #if defined(_WIN64)
     IP_OPTION_INFORMATION32 options;
@@ -201,21 +346,27 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
 #endif
 
     options.Ttl = ttl;
-    options.Flags = 0;
+    options.Flags = d->m_dontFragment ? IP_FLAG_DF : 0;
     options.OptionsData = nullptr;
     options.OptionsSize = 0;
     options.Tos = 0;
 
     PIP_OPTION_INFORMATION pipOptions = reinterpret_cast<PIP_OPTION_INFORMATION>(&options);
 
+    // the reply buffer must also have room for an ICMP error message, which is 8 bytes.
+
     if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
-        icmpHandle = IcmpCreateFile();
+        icmpHandle = this->icmpHandle(Nedrysoft::Core::IPVersion::V4);
 
-        replyBuffer.resize(sizeof(ICMP_ECHO_REPLY) + dataBuffer.length());
+        replyBuffer = d->acquireReplyBuffer(
+            static_cast<int>(sizeof(ICMP_ECHO_REPLY)) + dataBuffer.length() + IcmpErrorDataSize
+        );
     } else {
-        icmpHandle = Icmp6CreateFile();
+        icmpHandle = this->icmpHandle(Nedrysoft::Core::IPVersion::V6);
 
-        replyBuffer.resize(sizeof(ICMPV6_ECHO_REPLY) + dataBuffer.length());
+        replyBuffer = d->acquireReplyBuffer(
+            static_cast<int>(sizeof(ICMPV6_ECHO_REPLY)) + dataBuffer.length() + IcmpErrorDataSize
+        );
 
         IN6ADDR_SETANY(&sourceAddress);
         IN6ADDR_SETANY(&targetAddress);
@@ -231,8 +382,8 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
             nullptr,
             nullptr,
             nullptr,
-            hostAddress.toIPv4Address(),
-            dataBuffer.data(),
+            htonl(hostAddress.toIPv4Address()),
+            const_cast<char *>(dataBuffer.constData()),
             static_cast<WORD>(dataBuffer.length()),
             pipOptions,
             replyBuffer.data(),
@@ -247,7 +398,7 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
             nullptr,
             &sourceAddress,
             &targetAddress,
-            dataBuffer.data(),
+            const_cast<char *>(dataBuffer.constData()),
             static_cast<WORD>(dataBuffer.length()),
             pipOptions,
             replyBuffer.data(), static_cast<DWORD>(replyBuffer.length()),
@@ -289,7 +440,7 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::singleShot(
         }
     }
 
-    IcmpCloseHandle(icmpHandle);
+    d->releaseReplyBuffer(replyBuffer);
 
     return Nedrysoft::RouteAnalyser::PingResult(
         0,
@@ -314,7 +465,7 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::targets() -> QList<Nedryso
 
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::doStop() -> void {
     if (d->m_transmitter) {
-        d->m_transmitter->m_isRunning = false;
+        d->m_transmitter->stop();
     }
 
     if (d->m_transmitterThread) {
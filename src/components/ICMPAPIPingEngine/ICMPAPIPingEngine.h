@@ -85,6 +85,46 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
              */
             auto setTimeout(int timeout) -> bool override;
 
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setPayloadSize(int payloadSize) -> bool override;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setDontFragment
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool override;
+
+            /**
+             * @brief       Returns whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::dontFragment
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            auto dontFragment() -> bool override;
+
             /**
              * @brief       Starts ping operations for this engine instance.
              *
@@ -142,6 +182,33 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
                     int ttl,
                     double timeout ) -> Nedrysoft::RouteAnalyser::PingResult override;
 
+            /**
+             * @brief       Transmits a single ping with the given payload size.
+             *
+             * @note        This is a blocking function.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   payloadSize the number of bytes of payload in the echo request.
+             *
+             * @returns     the result of the ping.
+             */
+            auto singleShot(
+                    QHostAddress hostAddress,
+                    int ttl,
+                    double timeout,
+                    int payloadSize ) -> Nedrysoft::RouteAnalyser::PingResult;
+
+            /**
+             * @brief       Returns the echo request payload for the given size.
+             *
+             * @param[in]   payloadSize the number of bytes of payload.
+             *
+             * @returns     the payload, filled with the engine's pattern.
+             */
+            static auto payloadData(int payloadSize) -> QByteArray;
+
             /**
              * @brief       Removes a ping target from this engine instance.
              *
@@ -175,6 +242,21 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
              */
             auto doStop() -> void;
 
+        protected:
+            /**
+             * @brief       Returns the engine's ICMP handle for the given address family.
+             *
+             * @details     The handle is created the first time it is requested and is shared by the transmitter
+             *              and single shot requests until the engine is destroyed.
+             *
+             * @param[in]   version the IP version.
+             *
+             * @returns     the handle; INVALID_HANDLE_VALUE if the handle could not be created.
+             */
+            auto icmpHandle(Nedrysoft::Core::IPVersion version) -> void *;
+
+            friend class ICMPAPIPingTransmitter;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
@@ -45,7 +45,8 @@ class Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTargetData {
                 m_engine(nullptr),
                 m_id(( QRandomGenerator::global()->generate() % ( UINT16_MAX - 1 )) + 1),
                 m_userData(nullptr),
-                m_ttl(0) {
+                m_ttl(0),
+                m_payloadSize(0) {
 
         }
 
@@ -60,6 +61,7 @@ class Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTargetData {
         uint16_t m_id;
         void *m_userData;
         unsigned int m_ttl;
+        int m_payloadSize;
 };
 
 Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::ICMPAPIPingTarget(
@@ -72,6 +74,10 @@ Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::ICMPAPIPingTarget(
     d->m_hostAddress = hostAddress;
     d->m_engine = engine;
     d->m_ttl = ttl;
+
+    if (engine) {
+        d->m_payloadSize = engine->payloadSize();
+    }
 }
 
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::setHostAddress(QHostAddress hostAddress) -> void {
@@ -102,6 +108,22 @@ auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::ttl() -> unsigned short {
     return d->m_ttl;
 }
 
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::setPayloadSize(int payloadSize) -> void {
+    d->m_payloadSize = payloadSize;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::payloadSize() -> int {
+    return d->m_payloadSize;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::probeBackoff() -> int {
+    return 1;
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::setSamplingDivisor(int divisor) -> void {
+    Q_UNUSED(divisor)
+}
+
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget::saveConfiguration() -> QJsonObject {
     return QJsonObject();
 }
@@ -111,6 +111,42 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
              */
             auto ttl() -> uint16_t override;
 
+            /**
+             * @brief       Sets the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            auto setPayloadSize(int payloadSize) -> void override;
+
+            /**
+             * @brief       Returns the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Returns how many sample rounds the engine has backed this target off by.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::probeBackoff
+             *
+             * @returns     1 if the target is sent in every round; otherwise the target is sent once every n rounds.
+             */
+            auto probeBackoff() -> int override;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setSamplingDivisor
+             *
+             * @param[in]   divisor the target is sent once every divisor rounds.
+             */
+            auto setSamplingDivisor(int divisor) -> void override;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
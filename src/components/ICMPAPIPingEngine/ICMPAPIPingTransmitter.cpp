@@ -25,26 +25,82 @@
 
 #include "ICMPAPIPingEngine.h"
 #include "ICMPAPIPingTarget.h"
-#include "ICMPAPIPingWorker.h"
 
+#include <Clock>
+#include <QElapsedTimer>
 #include <QThread>
 #include <cstdint>
 
+#define PIO_APC_ROUTINE_DEFINED
+
+#include <WS2tcpip.h>
+#include <WinSock2.h>
+#include <winternl.h>
+#include <iphlpapi.h>
+#include <IcmpAPI.h>
+
 constexpr auto DefaultTransmitInterval = 1000;
 constexpr auto DefaultReplyTimeout = 3000;
 constexpr auto DefaultTransmitTimeout = 3000;
+constexpr auto IcmpErrorDataSize = 8;
+
+/**
+ * @brief       The state of an asynchronous echo request.
+ *
+ * @details     Records are recycled between rounds, the reply buffer is kept so that it only needs to grow when a
+ *              target's payload size increases.
+ */
+class Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest {
+    public:
+        /**
+         * @brief       Called by the system when an asynchronous request completes.
+         *
+         * @note        The APC is queued to the thread that issued the request and runs when that thread next
+         *              enters an alertable wait.
+         *
+         * @param[in]   context the request that completed.
+         * @param[in]   ioStatusBlock the status of the request.
+         * @param[in]   reserved unused.
+         */
+        static VOID NTAPI onComplete(PVOID context, PIO_STATUS_BLOCK ioStatusBlock, ULONG reserved) {
+            Q_UNUSED(ioStatusBlock)
+            Q_UNUSED(reserved)
+
+            auto request = static_cast<Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *>(context);
+
+            request->m_transmitter->completeRequest(request, true);
+        }
+
+        Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter *m_transmitter;
+        Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget *m_target;
+
+        unsigned long m_sampleNumber;
+        bool m_isIPv4;
+
+        QByteArray m_requestBuffer;
+        QByteArray m_replyBuffer;
+
+        QDateTime m_epoch;
+        QElapsedTimer m_timer;
+};
 
 Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::ICMPAPIPingTransmitter(
         Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine *engine) :
 
             m_engine(engine),
             m_interval(DefaultTransmitInterval),
-            m_isRunning(false) {
+            m_isRunning(false),
+            m_stopped(false),
+            m_threadHandle(nullptr),
+            m_pendingRequests(0),
+            m_ipv4Handle(INVALID_HANDLE_VALUE),
+            m_ipv6Handle(INVALID_HANDLE_VALUE) {
 
 }
 
 Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::~ICMPAPIPingTransmitter() {
     qDeleteAll(m_targets);
+    qDeleteAll(m_requests);
 }
 
 
@@ -54,52 +110,264 @@ void Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::addTarget(
     m_targets.append(target);
 }
 
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::stop() -> void {
+    QMutexLocker locker(&m_stopMutex);
+
+    m_stopped = true;
+    m_isRunning = false;
+
+    // an empty APC is enough to end the SleepEx that the transmitter thread is waiting in.
+
+    if (m_threadHandle) {
+        QueueUserAPC([](ULONG_PTR) {}, static_cast<HANDLE>(m_threadHandle), 0);
+    }
+}
+
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::doWork() -> void {
     unsigned long sampleNumber = 0;
     QElapsedTimer timer;
 
-    m_isRunning = true;
+    m_ipv4Handle = m_engine->icmpHandle(Nedrysoft::Core::IPVersion::V4);
+    m_ipv6Handle = m_engine->icmpHandle(Nedrysoft::Core::IPVersion::V6);
 
-    while (m_isRunning) {
-        timer.restart();
-
-        m_targetsMutex.lock();
+    m_stopMutex.lock();
 
-        for (auto target : m_targets) {
-            auto pingWorker = new Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingWorker(m_engine, sampleNumber, target);
+    HANDLE threadHandle = nullptr;
 
-            auto pingThread = new QThread();
+    if (DuplicateHandle(
+            GetCurrentProcess(),
+            GetCurrentThread(),
+            GetCurrentProcess(),
+            &threadHandle,
+            0,
+            FALSE,
+            DUPLICATE_SAME_ACCESS )) {
 
-            connect(pingThread, &QThread::started, pingWorker, &ICMPAPIPingWorker::doWork);
+        m_threadHandle = threadHandle;
+    }
 
-            pingWorker->moveToThread(pingThread);
+    m_isRunning = !m_stopped;
 
-            connect(pingWorker, &ICMPAPIPingWorker::destroyed, [=]() {
-                pingThread->quit();
-            });
+    m_stopMutex.unlock();
 
-            connect(pingThread, &QThread::finished, pingThread, &QThread::deleteLater, Qt::DirectConnection);
+    while (m_isRunning) {
+        timer.restart();
 
-            connect(pingWorker,
-                &ICMPAPIPingWorker::result,
-                this,
-                &ICMPAPIPingTransmitter::result,
-                Qt::DirectConnection
-            );
+        m_targetsMutex.lock();
 
-            pingThread->start();
+        for (auto target : m_targets) {
+            sendRequest(target, sampleNumber);
         }
 
         m_targetsMutex.unlock();
 
+        // the completions for this round (and any stragglers from previous rounds) are delivered while we wait
+        // for the next round to begin.
+
         auto duration = timer.elapsed();
 
-        if (duration < m_interval) {
-            QThread::msleep(m_interval - duration);
+        while (m_isRunning && (duration < m_interval)) {
+            waitForCompletions(static_cast<int>(m_interval - duration));
+
+            duration = timer.elapsed();
         }
 
         sampleNumber++;
     }
+
+    // the reply buffers are owned by the in-flight requests, so they must all complete before the records can be
+    // released.  Each request is bounded by its timeout.  The handles belong to the engine.
+
+    while (m_pendingRequests) {
+        waitForCompletions(DefaultTransmitTimeout);
+    }
+
+    QMutexLocker locker(&m_stopMutex);
+
+    if (m_threadHandle) {
+        CloseHandle(static_cast<HANDLE>(m_threadHandle));
+
+        m_threadHandle = nullptr;
+    }
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::sendRequest(
+        Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget *target,
+        unsigned long sampleNumber) -> void {
+
+    Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *request;
+
+    if (m_freeRequests.isEmpty()) {
+        request = new Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest;
+
+        request->m_transmitter = this;
+
+        m_requests.append(request);
+    } else {
+        request = m_freeRequests.takeLast();
+    }
+
+    auto hostAddress = target->hostAddress();
+    auto payloadSize = target->payloadSize();
+
+    request->m_target = target;
+    request->m_sampleNumber = sampleNumber;
+    request->m_isIPv4 = (hostAddress.protocol() == QAbstractSocket::IPv4Protocol);
+
+    if (request->m_requestBuffer.length() != payloadSize) {
+        request->m_requestBuffer = Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingEngine::payloadData(payloadSize);
+    }
+
+    // the buffer must hold the reply structure, the echoed data, an ICMP error message and the status block
+    // that is written by the asynchronous completion.
+
+    auto replySize = static_cast<int>(
+        (request->m_isIPv4 ? sizeof(ICMP_ECHO_REPLY) : sizeof(ICMPV6_ECHO_REPLY)) +
+        static_cast<size_t>(payloadSize) + IcmpErrorDataSize + sizeof(IO_STATUS_BLOCK)
+    );
+
+    if (request->m_replyBuffer.length() < replySize) {
+        request->m_replyBuffer.resize(replySize);
+    }
+
+#if defined(_WIN64)
+    IP_OPTION_INFORMATION32 options;
+#else
+    IP_OPTION_INFORMATION options;
+#endif
+
+    options.Ttl = static_cast<UCHAR>(target->ttl());
+    options.Flags = m_engine->dontFragment() ? IP_FLAG_DF : 0;
+    options.OptionsData = nullptr;
+    options.OptionsSize = 0;
+    options.Tos = 0;
+
+    auto pipOptions = reinterpret_cast<PIP_OPTION_INFORMATION>(&options);
+
+    m_pendingRequests++;
+
+    request->m_epoch = Nedrysoft::Core::Clock::getInstance()->currentDateTime();
+    request->m_timer.restart();
+
+    DWORD returnValue;
+
+    if (request->m_isIPv4) {
+        returnValue = IcmpSendEcho2(
+            m_ipv4Handle,
+            nullptr,
+            &Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest::onComplete,
+            request,
+            htonl(hostAddress.toIPv4Address()),
+            request->m_requestBuffer.data(),
+            static_cast<WORD>(request->m_requestBuffer.length()),
+            pipOptions,
+            request->m_replyBuffer.data(),
+            static_cast<DWORD>(request->m_replyBuffer.length()),
+            DefaultTransmitTimeout
+        ); // NOLINT(cppcoreguidelines-pro-type-union-access)
+    } else {
+        sockaddr_in6 sourceAddress, targetAddress;
+
+        IN6ADDR_SETANY(&sourceAddress);
+        IN6ADDR_SETANY(&targetAddress);
+
+        memcpy(targetAddress.sin6_addr.u.Word, hostAddress.toIPv6Address().c, sizeof(targetAddress.sin6_addr));
+
+        returnValue = Icmp6SendEcho2(
+            m_ipv6Handle,
+            nullptr,
+            &Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest::onComplete,
+            request,
+            &sourceAddress,
+            &targetAddress,
+            request->m_requestBuffer.data(),
+            static_cast<WORD>(request->m_requestBuffer.length()),
+            pipOptions,
+            request->m_replyBuffer.data(),
+            static_cast<DWORD>(request->m_replyBuffer.length()),
+            DefaultTransmitTimeout
+        );  // NOLINT(cppcoreguidelines-pro-type-union-access)
+    }
+
+    // an asynchronous request returns zero with ERROR_IO_PENDING, anything else means that no completion will be
+    // delivered so the request is completed here.
+
+    if ((returnValue == 0) && (GetLastError() == ERROR_IO_PENDING)) {
+        return;
+    }
+
+    completeRequest(request, false);
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::completeRequest(
+        Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *request,
+        bool replied) -> void {
+
+    auto roundTripTime = request->m_timer.nsecsElapsed();
+    auto resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+    QHostAddress replyHost;
+
+    m_pendingRequests--;
+
+    if (replied) {
+        auto replyBuffer = request->m_replyBuffer.data();
+        auto replySize = static_cast<DWORD>(request->m_replyBuffer.length());
+
+        if (request->m_isIPv4) {
+            if (IcmpParseReplies(replyBuffer, replySize)) {
+                auto echoReply = reinterpret_cast<PICMP_ECHO_REPLY>(replyBuffer);
+
+                replyHost = QHostAddress(ntohl(echoReply->Address));
+
+                if (echoReply->Status == IP_SUCCESS) {
+                    resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok;
+                } else if (echoReply->Status == IP_TTL_EXPIRED_TRANSIT) {
+                    resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+                }
+            }
+        } else {
+            if (Icmp6ParseReplies(replyBuffer, replySize)) {
+                auto echoReply = reinterpret_cast<PICMPV6_ECHO_REPLY>(replyBuffer);
+
+                sockaddr_in6 replySocketAddress;
+
+                memcpy(
+                    replySocketAddress.sin6_addr.u.Word,
+                    echoReply->Address.sin6_addr,
+                    sizeof(echoReply->Address.sin6_addr)
+                );
+
+                replyHost.setAddress(replySocketAddress.sin6_addr.u.Byte);
+
+                if (echoReply->Status == IP_SUCCESS) {
+                    resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok;
+                } else if (echoReply->Status == IP_TTL_EXPIRED_TRANSIT) {
+                    resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+                }
+            }
+        }
+    }
+
+    Q_EMIT result(Nedrysoft::RouteAnalyser::PingResult(
+        request->m_sampleNumber,
+        resultCode,
+        replyHost,
+        request->m_epoch,
+        roundTripTime/1e9,
+        request->m_target,
+        -1
+    ));
+
+    request->m_target = nullptr;
+
+    m_freeRequests.append(request);
+}
+
+auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::waitForCompletions(int timeout) -> void {
+    // SleepEx returns early with WAIT_IO_COMPLETION each time an APC is delivered, the caller re-evaluates how
+    // long is left to wait.
+
+    SleepEx(static_cast<DWORD>(timeout), TRUE);
 }
 
 auto Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTransmitter::setInterval(int interval) -> bool {
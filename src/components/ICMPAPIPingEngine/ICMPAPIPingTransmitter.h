@@ -26,18 +26,26 @@
 
 #include <PingResult>
 
+#include <QList>
 #include <QMutex>
 #include <QObject>
+#include <atomic>
 
 namespace Nedrysoft { namespace ICMPAPIPingEngine {
     class ICMPAPIPingEngine;
+    class ICMPAPIPingRequest;
     class ICMPAPIPingTarget;
 
     /**
      * @brief       The ICMPAPIPingTransmitter class provides a thread for transmitting ICMP packets.
      *
      * @details     and used by the ICMPAPI engine, the transmitter thread creates requests for the associated
-     *              targets and sends them at the given period
+     *              targets and sends them at the given period.
+     *
+     *              Requests are issued with the asynchronous form of IcmpSendEcho2/Icmp6SendEcho2, the completion
+     *              is delivered as an APC to the transmitter thread, which waits in an alertable state between
+     *              rounds.  Each in-flight request costs a pooled request record with its own reply buffer, no
+     *              threads are created per request.
      */
     class ICMPAPIPingTransmitter :
             public QObject {
@@ -71,6 +79,15 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
              */
             Q_SLOT void doWork(void);
 
+            /**
+             * @brief       Stops the transmitter.
+             *
+             * @details     The transmitter thread is woken from its alertable wait so that it does not sleep out the
+             *              remainder of the interval, this may be called from any thread and before doWork has been
+             *              entered.
+             */
+            auto stop() -> void;
+
             /**
              * @brief       Signslled when a result is available.
              *
@@ -86,6 +103,36 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
             void addTarget(Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget *target);
 
             friend class ICMPAPIPingEngine;
+            friend class ICMPAPIPingRequest;
+
+        private:
+            /**
+             * @brief       Sends an echo request to a target.
+             *
+             * @param[in]   target the target.
+             * @param[in]   sampleNumber the sample number of the current round.
+             */
+            auto sendRequest(
+                Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget *target,
+                unsigned long sampleNumber
+            ) -> void;
+
+            /**
+             * @brief       Processes a completed request and returns its record to the pool.
+             *
+             * @note        This is called from the APC, which always runs on the transmitter thread.
+             *
+             * @param[in]   request the request that has completed.
+             * @param[in]   replied true if the request was sent and the reply buffer should be parsed.
+             */
+            auto completeRequest(Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *request, bool replied) -> void;
+
+            /**
+             * @brief       Waits in an alertable state so that completions can be delivered.
+             *
+             * @param[in]   timeout the maximum time to wait in milliseconds.
+             */
+            auto waitForCompletions(int timeout) -> void;
 
         private:
             //! @cond
@@ -95,7 +142,18 @@ namespace Nedrysoft { namespace ICMPAPIPingEngine {
 
             QList<Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingTarget *> m_targets;
             QMutex m_targetsMutex;
-            bool m_isRunning;
+            std::atomic<bool> m_isRunning;
+
+            QMutex m_stopMutex;
+            bool m_stopped;
+            void *m_threadHandle;
+
+            QList<Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *> m_requests;
+            QList<Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingRequest *> m_freeRequests;
+            int m_pendingRequests;
+
+            void *m_ipv4Handle;
+            void *m_ipv6Handle;
 
             //! @endcond
     };
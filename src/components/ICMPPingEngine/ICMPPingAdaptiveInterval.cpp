@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingAdaptiveInterval.h"
+
+#include <cmath>
+
+constexpr auto SmoothingFactor = 0.125;
+constexpr auto VariationFactor = 0.25;
+constexpr auto DeviationThreshold = 4.0;
+constexpr auto RelativeThreshold = 0.25;
+constexpr auto WarmupSamples = 4;
+constexpr auto StableSamplesBeforeBackoff = 8ul;
+constexpr auto DefaultMinimumInterval = 250000000ll;
+constexpr auto DefaultMaximumInterval = 10000000000ll;
+
+Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval::ICMPPingAdaptiveInterval() :
+        m_minimumInterval(DefaultMinimumInterval),
+        m_maximumInterval(DefaultMaximumInterval),
+        m_interval(DefaultMinimumInterval),
+        m_lastChangeSample(0),
+        m_lastBackoffSample(0) {
+
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval::setRange(
+        qint64 minimumInterval,
+        qint64 maximumInterval) -> void {
+
+    m_minimumInterval = minimumInterval;
+    m_maximumInterval = qMax(minimumInterval, maximumInterval);
+
+    m_targetStatistics.clear();
+
+    m_lastChangeSample = 0;
+    m_lastBackoffSample = 0;
+
+    m_interval.store(m_minimumInterval, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval::interval() -> qint64 {
+    return m_interval.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval::addResult(
+        Nedrysoft::ICMPPingEngine::ICMPPingTarget *target,
+        unsigned long sampleNumber,
+        double roundTripTime,
+        bool replied) -> void {
+
+    auto changed = false;
+
+    if (!m_targetStatistics.contains(target)) {
+        m_targetStatistics.insert(target, TargetStatistics{roundTripTime, roundTripTime/2, 0, replied});
+    }
+
+    auto &statistics = m_targetStatistics[target];
+
+    if (replied != statistics.replied) {
+        changed = true;
+
+        statistics.replied = replied;
+    }
+
+    if (replied) {
+        auto deviation = std::fabs(roundTripTime - statistics.smoothedRoundTripTime);
+
+        if (statistics.samples >= WarmupSamples) {
+            auto threshold = qMax(
+                DeviationThreshold * statistics.roundTripTimeVariation,
+                RelativeThreshold * statistics.smoothedRoundTripTime
+            );
+
+            if (deviation > threshold) {
+                changed = true;
+            }
+        }
+
+        statistics.roundTripTimeVariation += VariationFactor * (deviation - statistics.roundTripTimeVariation);
+        statistics.smoothedRoundTripTime += SmoothingFactor * (roundTripTime - statistics.smoothedRoundTripTime);
+        statistics.samples++;
+    }
+
+    if (changed) {
+        m_lastChangeSample = sampleNumber;
+        m_lastBackoffSample = sampleNumber;
+
+        m_interval.store(m_minimumInterval, std::memory_order_relaxed);
+
+        return;
+    }
+
+    // results can arrive out of order, a late result from before the last adjustment is not counted.
+
+    if ((sampleNumber < m_lastBackoffSample) ||
+        (sampleNumber - m_lastChangeSample < StableSamplesBeforeBackoff) ||
+        (sampleNumber - m_lastBackoffSample < StableSamplesBeforeBackoff)) {
+
+        return;
+    }
+
+    m_lastBackoffSample = sampleNumber;
+
+    m_interval.store(
+        qMin(m_interval.load(std::memory_order_relaxed) * 2, m_maximumInterval),
+        std::memory_order_relaxed
+    );
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval::removeTarget(
+        Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void {
+
+    m_targetStatistics.remove(target);
+}
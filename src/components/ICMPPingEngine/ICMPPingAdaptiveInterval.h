@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGADAPTIVEINTERVAL_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGADAPTIVEINTERVAL_H
+
+#include <QHash>
+#include <QtGlobal>
+#include <atomic>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingTarget;
+
+    /**
+     * @brief       The ICMPPingAdaptiveInterval class adjusts the probe interval to the behaviour of the route.
+     *
+     * @details     A smoothed round trip time and mean deviation are kept for each target (in the same manner as
+     *              the TCP retransmission timer in RFC 6298).  A sample that falls well outside of the expected
+     *              range, or a hop that starts or stops responding, is treated as a change and the interval drops
+     *              straight to the minimum so that the event is captured in detail.  While every hop remains stable
+     *              the interval is doubled after each run of stable samples until it reaches the maximum.
+     *
+     *              Results are added from the receiver thread, the interval may be read from any thread.
+     */
+    class ICMPPingAdaptiveInterval {
+        public:
+            /**
+             * @brief       Constructs an ICMPPingAdaptiveInterval.
+             */
+            ICMPPingAdaptiveInterval();
+
+            /**
+             * @brief       Sets the range that the interval is adapted within and resets the statistics.
+             *
+             * @note        The interval restarts at the minimum.  This must not be called while results are being
+             *              added, i.e. while the engine is running.
+             *
+             * @param[in]   minimumInterval the interval used while the route is changing in nanoseconds.
+             * @param[in]   maximumInterval the interval used once the route is stable in nanoseconds.
+             */
+            auto setRange(qint64 minimumInterval, qint64 maximumInterval) -> void;
+
+            /**
+             * @brief       Returns the current interval.
+             *
+             * @returns     the interval in nanoseconds.
+             */
+            auto interval() -> qint64;
+
+            /**
+             * @brief       Updates the statistics for a target with a new result.
+             *
+             * @param[in]   target the target that the result is for.
+             * @param[in]   sampleNumber the sample number of the result.
+             * @param[in]   roundTripTime the round trip time in seconds, ignored if there was no reply.
+             * @param[in]   replied true if a reply was received; otherwise false.
+             */
+            auto addResult(
+                Nedrysoft::ICMPPingEngine::ICMPPingTarget *target,
+                unsigned long sampleNumber,
+                double roundTripTime,
+                bool replied
+            ) -> void;
+
+            /**
+             * @brief       Removes the statistics held for a target.
+             *
+             * @param[in]   target the target.
+             */
+            auto removeTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void;
+
+        private:
+            //! @cond
+
+            struct TargetStatistics {
+                double smoothedRoundTripTime;
+                double roundTripTimeVariation;
+                int samples;
+                bool replied;
+            };
+
+            QHash<Nedrysoft::ICMPPingEngine::ICMPPingTarget *, TargetStatistics> m_targetStatistics;
+
+            qint64 m_minimumInterval;
+            qint64 m_maximumInterval;
+            std::atomic<qint64> m_interval;
+
+            unsigned long m_lastChangeSample;
+            unsigned long m_lastBackoffSample;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGADAPTIVEINTERVAL_H
@@ -0,0 +1,494 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingCapture.h"
+
+#include <QtEndian>
+#include <chrono>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+constexpr auto CaptureEnvironmentVariable = "PINGNOO_CAPTURE";
+constexpr auto RingCapacity = 4096u;
+constexpr auto RingMask = RingCapacity-1;
+constexpr auto WriterInterval = std::chrono::milliseconds(20);
+constexpr auto MaximumRequests = 65536;
+constexpr auto RequestRetention = 60000000000ll;
+constexpr auto NanosecondsInMillisecond = 1000000.0;
+constexpr auto SequenceBits = 16;
+
+constexpr uint32_t SectionHeaderBlock = 0x0a0d0d0a;
+constexpr uint32_t InterfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t InterfaceStatisticsBlock = 0x00000005;
+constexpr uint32_t EnhancedPacketBlock = 0x00000006;
+constexpr uint32_t ByteOrderMagic = 0x1a2b3c4d;
+constexpr uint16_t MajorVersion = 1;
+constexpr uint16_t MinorVersion = 0;
+constexpr uint16_t LinkTypeRaw = 101;
+constexpr uint16_t OptionEnd = 0;
+constexpr uint16_t OptionComment = 1;
+constexpr uint16_t OptionApplication = 4;
+constexpr uint16_t OptionInterfaceName = 2;
+constexpr uint16_t OptionTimestampResolution = 9;
+constexpr uint16_t OptionPacketFlags = 2;
+constexpr uint16_t OptionInterfaceDrops = 5;
+constexpr uint32_t InboundFlag = 1;
+constexpr uint32_t OutboundFlag = 2;
+constexpr uint8_t NanosecondResolution = 9;
+
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv6HeaderLength = 40;
+constexpr auto IPv4AddressLength = 4;
+constexpr auto IPv6AddressLength = 16;
+constexpr auto ICMPv6Protocol = 58;
+
+static_assert((RingCapacity & RingMask) == 0, "capture ring capacity must be a power of 2");
+
+/**
+ * @brief       Appends a little endian value to a block.
+ *
+ * @param[in]   block the block.
+ * @param[in]   value the value.
+ */
+template <typename T>
+static auto append(QByteArray &block, T value) -> void {
+    char buffer[sizeof(T)];
+
+    qToLittleEndian<T>(value, buffer);
+
+    block.append(buffer, sizeof(T));
+}
+
+/**
+ * @brief       Appends zero bytes to a block so that its length is a multiple of 4.
+ *
+ * @param[in]   block the block.
+ */
+static auto pad(QByteArray &block) -> void {
+    while (block.length() % 4) {
+        block.append('\0');
+    }
+}
+
+/**
+ * @brief       Appends an option to a block.
+ *
+ * @param[in]   block the block.
+ * @param[in]   code the option code.
+ * @param[in]   value the value of the option.
+ */
+static auto appendOption(QByteArray &block, uint16_t code, const QByteArray &value) -> void {
+    append<uint16_t>(block, code);
+    append<uint16_t>(block, static_cast<uint16_t>(value.length()));
+
+    block.append(value);
+
+    pad(block);
+}
+
+/**
+ * @brief       Creates a block from its body.
+ *
+ * @param[in]   type the block type.
+ * @param[in]   body the body of the block, which must be padded to a multiple of 4 bytes.
+ *
+ * @returns     the block.
+ */
+static auto makeBlock(uint32_t type, const QByteArray &body) -> QByteArray {
+    QByteArray block;
+    auto totalLength = static_cast<uint32_t>(body.length() + 12);
+
+    append<uint32_t>(block, type);
+    append<uint32_t>(block, totalLength);
+
+    block.append(body);
+
+    append<uint32_t>(block, totalLength);
+
+    return block;
+}
+
+/**
+ * @brief       Returns a description of a result code.
+ *
+ * @param[in]   resultCode the result code.
+ *
+ * @returns     the description.
+ */
+static auto describe(Nedrysoft::ICMPPacket::ResultCode resultCode) -> QString {
+    switch (resultCode) {
+        case Nedrysoft::ICMPPacket::EchoReply: return QStringLiteral("echo reply");
+        case Nedrysoft::ICMPPacket::TimeExceeded: return QStringLiteral("time exceeded");
+        case Nedrysoft::ICMPPacket::PortUnreachable: return QStringLiteral("port unreachable");
+        case Nedrysoft::ICMPPacket::ProbeReply: return QStringLiteral("probe reply");
+        case Nedrysoft::ICMPPacket::DestinationUnreachable: return QStringLiteral("destination unreachable");
+        case Nedrysoft::ICMPPacket::AdministrativelyProhibited: return QStringLiteral("prohibited");
+        case Nedrysoft::ICMPPacket::PacketTooBig: return QStringLiteral("packet too big");
+        case Nedrysoft::ICMPPacket::ParameterProblem: return QStringLiteral("parameter problem");
+        default: return QStringLiteral("not decoded");
+    }
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingCapture::ICMPPingCapture() :
+        m_records(new Record[RingCapacity]),
+        m_enqueuePosition(0),
+        m_dequeuePosition(0),
+        m_dropped(0),
+        m_isRunning(false) {
+
+    auto fileName = QString::fromLocal8Bit(qgetenv(CaptureEnvironmentVariable));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    for (auto index = 0u; index < RingCapacity; index++) {
+        m_records[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        SPDLOG_ERROR(QString("Unable to open the capture file %1.").arg(fileName).toStdString());
+
+        return;
+    }
+
+    QByteArray sectionHeader, interfaceDescription;
+
+    append<uint32_t>(sectionHeader, ByteOrderMagic);
+    append<uint16_t>(sectionHeader, MajorVersion);
+    append<uint16_t>(sectionHeader, MinorVersion);
+    append<int64_t>(sectionHeader, -1);
+    appendOption(sectionHeader, OptionApplication, QByteArrayLiteral("Pingnoo"));
+    append<uint32_t>(sectionHeader, OptionEnd);
+
+    append<uint16_t>(interfaceDescription, LinkTypeRaw);
+    append<uint16_t>(interfaceDescription, 0);
+    append<uint32_t>(interfaceDescription, IPv6HeaderLength + SnapLength);
+    appendOption(interfaceDescription, OptionInterfaceName, QByteArrayLiteral("pingnoo"));
+    appendOption(
+        interfaceDescription,
+        OptionTimestampResolution,
+        QByteArray(1, static_cast<char>(NanosecondResolution)) );
+    append<uint32_t>(interfaceDescription, OptionEnd);
+
+    m_file.write(makeBlock(SectionHeaderBlock, sectionHeader));
+    m_file.write(makeBlock(InterfaceDescriptionBlock, interfaceDescription));
+
+    m_isRunning = true;
+
+    m_writerThread = std::thread([this]() {
+        writePackets();
+    });
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingCapture::~ICMPPingCapture() {
+    if (!m_writerThread.joinable()) {
+        return;
+    }
+
+    m_isRunning = false;
+
+    m_writerThread.join();
+
+    // the number of packets that could not be queued is reported as the drop count of the interface.
+
+    QByteArray statistics, drops;
+    auto timestamp = static_cast<quint64>(Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp());
+
+    append<quint64>(drops, m_dropped.load());
+
+    append<uint32_t>(statistics, 0);
+    append<uint32_t>(statistics, static_cast<uint32_t>(timestamp >> 32));
+    append<uint32_t>(statistics, static_cast<uint32_t>(timestamp));
+    appendOption(statistics, OptionInterfaceDrops, drops);
+    append<uint32_t>(statistics, OptionEnd);
+
+    m_file.write(makeBlock(InterfaceStatisticsBlock, statistics));
+    m_file.close();
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingCapture * {
+    static ICMPPingCapture capture;
+
+    return capture.m_isRunning ? &capture : nullptr;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::claim() -> Record * {
+    auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto record = &m_records[position & RingMask];
+        auto sequence = record->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - position);
+
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                return record;
+            }
+        } else if (difference < 0) {
+            // the writer has not yet released this slot, so the ring is full.
+
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return nullptr;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::publish(Record *record) -> void {
+    record->sequence.store(record->sequence.load(std::memory_order_relaxed)+1, std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::copyPacket(Record *record, const QByteArray &buffer) -> void {
+    record->length = buffer.length();
+    record->capturedLength = qMin(buffer.length(), SnapLength);
+
+    memcpy(record->data, buffer.constData(), static_cast<size_t>(record->capturedLength));
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::recordSent(
+        const Nedrysoft::ICMPSocket::Datagram &datagram,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        Nedrysoft::ICMPPacket::Protocol protocol,
+        uint16_t id,
+        uint16_t sequence,
+        unsigned long sampleNumber,
+        qint64 timestamp) -> void {
+
+    auto record = claim();
+
+    if (!record) {
+        return;
+    }
+
+    record->timestamp = timestamp;
+    record->direction = Direction::Sent;
+    record->version = version;
+    record->protocol = protocol;
+    record->resultCode = Nedrysoft::ICMPPacket::Invalid;
+    record->ttl = datagram.ttl;
+    record->id = id;
+    record->packetSequence = sequence;
+    record->sampleNumber = sampleNumber;
+    record->address = datagram.socketAddress.isNull() ?
+        Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(datagram.hostAddress) : datagram.socketAddress;
+
+    copyPacket(record, datagram.buffer);
+
+    publish(record);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::recordReceived(
+        const Nedrysoft::ICMPSocket::Datagram &datagram,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        Nedrysoft::ICMPPacket::Protocol protocol,
+        Nedrysoft::ICMPPacket::ICMPPacket &packet) -> void {
+
+    auto record = claim();
+
+    if (!record) {
+        return;
+    }
+
+    record->timestamp = ( datagram.timestamp >= 0 ) ?
+        datagram.timestamp : Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    record->direction = Direction::Received;
+    record->version = version;
+    record->protocol = protocol;
+    record->resultCode = packet.resultCode();
+    record->ttl = packet.ttl();
+    record->id = packet.id();
+    record->packetSequence = packet.sequence();
+    record->sampleNumber = 0;
+    record->address = datagram.socketAddress;
+
+    copyPacket(record, datagram.buffer);
+
+    publish(record);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::writePackets() -> void {
+    while (true) {
+        auto isRunning = m_isRunning.load(std::memory_order_acquire);
+        auto written = 0;
+
+        while (true) {
+            auto &record = m_records[m_dequeuePosition & RingMask];
+
+            if (record.sequence.load(std::memory_order_acquire) != m_dequeuePosition+1) {
+                break;
+            }
+
+            writeRecord(record);
+
+            record.sequence.store(m_dequeuePosition+RingCapacity, std::memory_order_release);
+
+            m_dequeuePosition++;
+
+            written++;
+        }
+
+        if (written) {
+            m_file.flush();
+        }
+
+        if (!isRunning) {
+            break;
+        }
+
+        if (!written) {
+            std::this_thread::sleep_for(WriterInterval);
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::writeRecord(const Record &record) -> void {
+    QByteArray header, body;
+
+    // received IPv4 packets already start with the IP header, a header is constructed for everything else.
+
+    auto hasHeader = (record.direction == Direction::Received) &&
+                     (record.version == Nedrysoft::ICMPSocket::V4);
+
+    if (!hasHeader) {
+        auto ipProtocol = static_cast<uint8_t>(record.protocol);
+        auto ttl = static_cast<uint8_t>(qBound(0, record.ttl, 255));
+        auto addressOffset = ( record.direction == Direction::Sent ) ? 1 : 0;
+
+        if (record.version == Nedrysoft::ICMPSocket::V4) {
+            header.fill(0, IPv4HeaderLength);
+
+            header[0] = 0x45;
+            header[8] = static_cast<char>(ttl);
+            header[9] = static_cast<char>(ipProtocol);
+
+            qToBigEndian<uint16_t>(static_cast<uint16_t>(IPv4HeaderLength + record.length), header.data() + 2);
+
+            // the source is at offset 12 and the destination at offset 16.
+
+            memcpy(
+                header.data() + 12 + ( addressOffset * IPv4AddressLength ),
+                record.address.address,
+                IPv4AddressLength );
+
+            auto checksum = Nedrysoft::ICMPPacket::ICMPPacket::checksum(header.data(), IPv4HeaderLength);
+
+            memcpy(header.data() + 10, &checksum, sizeof(checksum));
+        } else {
+            if (record.protocol == Nedrysoft::ICMPPacket::ICMP) {
+                ipProtocol = ICMPv6Protocol;
+            }
+
+            header.fill(0, IPv6HeaderLength);
+
+            header[0] = 0x60;
+            header[6] = static_cast<char>(ipProtocol);
+            header[7] = static_cast<char>(ttl);
+
+            qToBigEndian<uint16_t>(static_cast<uint16_t>(record.length), header.data() + 4);
+
+            // the source is at offset 8 and the destination at offset 24.
+
+            memcpy(
+                header.data() + 8 + ( addressOffset * IPv6AddressLength ),
+                record.address.address,
+                IPv6AddressLength );
+        }
+    }
+
+    auto timestamp = static_cast<quint64>(record.timestamp);
+    auto flags = ( record.direction == Direction::Sent ) ? OutboundFlag : InboundFlag;
+
+    append<uint32_t>(body, 0);
+    append<uint32_t>(body, static_cast<uint32_t>(timestamp >> 32));
+    append<uint32_t>(body, static_cast<uint32_t>(timestamp));
+    append<uint32_t>(body, static_cast<uint32_t>(header.length() + record.capturedLength));
+    append<uint32_t>(body, static_cast<uint32_t>(header.length() + record.length));
+
+    body.append(header);
+    body.append(reinterpret_cast<const char *>(record.data), record.capturedLength);
+
+    pad(body);
+
+    appendOption(body, OptionComment, comment(record).toUtf8());
+
+    append<uint16_t>(body, OptionPacketFlags);
+    append<uint16_t>(body, sizeof(flags));
+    append<uint32_t>(body, flags);
+    append<uint32_t>(body, OptionEnd);
+
+    m_file.write(makeBlock(EnhancedPacketBlock, body));
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingCapture::comment(const Record &record) -> QString {
+    auto key = (static_cast<uint32_t>(record.id) << SequenceBits) | record.packetSequence;
+
+    if (record.direction == Direction::Sent) {
+        // old requests are forgotten so that the table does not grow without limit if replies are lost.
+
+        if (m_requests.count() >= MaximumRequests) {
+            for (auto request = m_requests.begin(); request != m_requests.end(); ) {
+                if (record.timestamp - request->timestamp > RequestRetention) {
+                    request = m_requests.erase(request);
+                } else {
+                    ++request;
+                }
+            }
+        }
+
+        m_requests[key] = Request{record.address, record.ttl, record.sampleNumber, record.timestamp};
+
+        return QString("request to %1 ttl=%2 id=%3 seq=%4 sample=%5")
+                .arg(record.address.toHostAddress().toString())
+                .arg(record.ttl)
+                .arg(record.id)
+                .arg(record.packetSequence)
+                .arg(record.sampleNumber);
+    }
+
+    auto text = QString("%1 from %2 id=%3 seq=%4")
+            .arg(describe(record.resultCode))
+            .arg(record.address.toHostAddress().toString())
+            .arg(record.id)
+            .arg(record.packetSequence);
+
+    auto request = m_requests.find(key);
+
+    if ((record.resultCode == Nedrysoft::ICMPPacket::Invalid) || (request == m_requests.end())) {
+        return text;
+    }
+
+    text += QString(" for request to %1 ttl=%2 sample=%3 rtt=%4ms")
+            .arg(request->target.toHostAddress().toString())
+            .arg(request->ttl)
+            .arg(request->sampleNumber)
+            .arg(static_cast<double>(record.timestamp - request->timestamp) / NanosecondsInMillisecond, 0, 'f', 3);
+
+    m_requests.erase(request);
+
+    return text;
+}
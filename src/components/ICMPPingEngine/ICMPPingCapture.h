@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGCAPTURE_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGCAPTURE_H
+
+#include "ICMPPacket/ICMPPacket.h"
+#include "ICMPSocket/ICMPSocket.h"
+
+#include <QFile>
+#include <QHash>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       The ICMPPingCapture class records the packets sent and received by the engines to a pcapng file.
+     *
+     * @details     The capture is enabled by setting the PINGNOO_CAPTURE environment variable to the name of the
+     *              file to write.  Each packet is written with its timestamp (the kernel receive time for replies)
+     *              and a comment that names the target, ttl, id, sequence and sample number of the request, a
+     *              reply is annotated with the request it answers and its round trip time.
+     *
+     *              The sending and receiving threads copy the start of each packet into a slot of a fixed size
+     *              multiple producer ring and return, a background thread formats the blocks and writes them.  If
+     *              the writer falls behind then packets are dropped from the capture rather than delaying a probe,
+     *              the number dropped is recorded in the file when the capture is closed.
+     *
+     *              Packets are captured as raw IP, an IP header is constructed for the packets that the sockets
+     *              send and receive without one.  The address of this host is not known to the engine, so it is
+     *              left unspecified in the constructed headers.
+     */
+    class ICMPPingCapture {
+        private:
+            /**
+             * @brief       Constructs the ICMPPingCapture and opens the file if capture is enabled.
+             */
+            ICMPPingCapture();
+
+        public:
+            /**
+             * @brief       Destroys the ICMPPingCapture, the packets that have been queued are written first.
+             */
+            ~ICMPPingCapture();
+
+            /**
+             * @brief       Returns the ICMPPingCapture instance if capture is enabled.
+             *
+             * @returns     the capture; otherwise nullptr if capture is not enabled.
+             */
+            static auto getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingCapture *;
+
+            /**
+             * @brief       Records a request that has been sent.
+             *
+             * @note        May be called from any thread.
+             *
+             * @param[in]   datagram the datagram that was sent.
+             * @param[in]   version the IP version of the request.
+             * @param[in]   protocol the protocol of the request.
+             * @param[in]   id the id of the request.
+             * @param[in]   sequence the sequence number of the request.
+             * @param[in]   sampleNumber the sample round of the request.
+             * @param[in]   timestamp the time the request was sent in nanoseconds since the unix epoch.
+             */
+            auto recordSent(
+                const Nedrysoft::ICMPSocket::Datagram &datagram,
+                Nedrysoft::ICMPSocket::IPVersion version,
+                Nedrysoft::ICMPPacket::Protocol protocol,
+                uint16_t id,
+                uint16_t sequence,
+                unsigned long sampleNumber,
+                qint64 timestamp
+            ) -> void;
+
+            /**
+             * @brief       Records a packet that has been received.
+             *
+             * @note        May be called from any thread.
+             *
+             * @param[in]   datagram the datagram that was received.
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   protocol the protocol of the socket.
+             * @param[in]   packet the decoded packet.
+             */
+            auto recordReceived(
+                const Nedrysoft::ICMPSocket::Datagram &datagram,
+                Nedrysoft::ICMPSocket::IPVersion version,
+                Nedrysoft::ICMPPacket::Protocol protocol,
+                Nedrysoft::ICMPPacket::ICMPPacket &packet
+            ) -> void;
+
+        private:
+            /**
+             * @brief       The direction of a captured packet.
+             */
+            enum class Direction : uint8_t {
+                Sent,
+                Received
+            };
+
+            /**
+             * @brief       The number of bytes of each packet that are captured.
+             */
+            static constexpr int SnapLength = 256;
+
+            /**
+             * @brief       A slot in the ring.
+             *
+             * @details     The sequence of a slot tells the producers and the consumer whose turn it is, a slot
+             *              is free for the producer that claims position p when its sequence is p and is ready for
+             *              the consumer when its sequence is p+1.
+             */
+            struct Record {
+                std::atomic<uint64_t> sequence;
+                qint64 timestamp;
+                Direction direction;
+                Nedrysoft::ICMPSocket::IPVersion version;
+                Nedrysoft::ICMPPacket::Protocol protocol;
+                Nedrysoft::ICMPPacket::ResultCode resultCode;
+                int ttl;
+                uint16_t id;
+                uint16_t packetSequence;
+                unsigned long sampleNumber;
+                Nedrysoft::ICMPSocket::SocketAddress address;
+                int length;
+                int capturedLength;
+                uint8_t data[SnapLength];
+            };
+
+            /**
+             * @brief       The details of a request that are used to annotate its reply.
+             */
+            struct Request {
+                Nedrysoft::ICMPSocket::SocketAddress target;
+                int ttl;
+                unsigned long sampleNumber;
+                qint64 timestamp;
+            };
+
+            /**
+             * @brief       Claims a slot in the ring.
+             *
+             * @returns     the slot; otherwise nullptr if the ring is full.
+             */
+            auto claim() -> Record *;
+
+            /**
+             * @brief       Makes a claimed slot available to the writer.
+             *
+             * @param[in]   record the slot.
+             */
+            auto publish(Record *record) -> void;
+
+            /**
+             * @brief       Copies a packet into a claimed slot.
+             *
+             * @param[in]   record the slot.
+             * @param[in]   buffer the packet.
+             */
+            static auto copyPacket(Record *record, const QByteArray &buffer) -> void;
+
+            /**
+             * @brief       The writer thread, writes the queued packets until the capture is destroyed.
+             */
+            auto writePackets() -> void;
+
+            /**
+             * @brief       Writes a queued packet to the file.
+             *
+             * @param[in]   record the slot holding the packet.
+             */
+            auto writeRecord(const Record &record) -> void;
+
+            /**
+             * @brief       Returns the comment for a captured packet.
+             *
+             * @param[in]   record the slot holding the packet.
+             *
+             * @returns     the comment.
+             */
+            auto comment(const Record &record) -> QString;
+
+        private:
+            //! @cond
+
+            QFile m_file;
+
+            std::unique_ptr<Record[]> m_records;
+            std::atomic<uint64_t> m_enqueuePosition;
+            uint64_t m_dequeuePosition;
+            std::atomic<quint64> m_dropped;
+
+            QHash<uint32_t, Request> m_requests;
+
+            std::atomic<bool> m_isRunning;
+            std::thread m_writerThread;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGCAPTURE_H
@@ -23,11 +23,21 @@
 
 #include "ICMPPingComponent.h"
 #include "ICMPPingEngineFactory.h"
+#include "ICMPPingReceiverWorker.h"
+#include "ICMPPingScheduler.h"
+#include "ICMPPingShard.h"
+#include "TCPPingEngineFactory.h"
+#include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketXDP.h"
+#include "UDPPingEngineFactory.h"
 
 #include <IComponentManager>
 
+constexpr auto XDPInterfaceEnvironmentVariable = "PINGNOO_XDP_INTERFACE";
+constexpr auto XDPQueueEnvironmentVariable = "PINGNOO_XDP_QUEUE";
+
 ICMPPingComponent::ICMPPingComponent() :
-        m_engineFactory(nullptr) {
+        m_xdpSocket(nullptr) {
 
 }
 
@@ -36,15 +46,78 @@ ICMPPingComponent::~ICMPPingComponent() {
 }
 
 auto ICMPPingComponent::finaliseEvent() -> void {
-    if (m_engineFactory) {
-        Nedrysoft::ComponentSystem::removeObject(m_engineFactory);
+    for (auto engineFactory : m_engineFactories) {
+        Nedrysoft::ComponentSystem::removeObject(engineFactory);
+
+        delete engineFactory;
+    }
+
+    m_engineFactories.clear();
+
+    // the schedulers and receivers are shared by the engines of every factory, so are only removed once all of the
+    // engines have been deleted.
+
+    for (auto shard = 0; shard < Nedrysoft::ICMPPingEngine::ICMPPingShard::count(); shard++) {
+        auto scheduler = Nedrysoft::ICMPPingEngine::ICMPPingScheduler::getInstance(true, shard);
+
+        if (scheduler) {
+            delete scheduler;
+        }
+
+        auto receiverWorker = Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(true, shard);
+
+        if (receiverWorker) {
+            delete receiverWorker;
+        }
+    }
+
+    if (m_xdpSocket) {
+        Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(nullptr);
+
+        delete m_xdpSocket;
 
-        delete m_engineFactory;
+        m_xdpSocket = nullptr;
     }
 }
 
 auto ICMPPingComponent::initialiseEvent() -> void {
-    m_engineFactory = new Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory();
+    auto xdpInterface = QString::fromLocal8Bit(qgetenv(XDPInterfaceEnvironmentVariable));
+
+    if (!xdpInterface.isEmpty()) {
+        m_xdpSocket = new Nedrysoft::ICMPSocket::ICMPSocketXDP(
+            xdpInterface,
+            qEnvironmentVariableIntValue(XDPQueueEnvironmentVariable) );
+
+        if (m_xdpSocket->isValid()) {
+            Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(m_xdpSocket);
+        } else {
+            delete m_xdpSocket;
+
+            m_xdpSocket = nullptr;
+        }
+    }
+
+    auto icmpEngineFactory = new Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory();
+
+    m_engineFactories.append(icmpEngineFactory);
+
+    // the AF_XDP socket only carries ICMP over IPv4, the UDP and TCP engines would have their probes dropped.
+
+    if (!m_xdpSocket) {
+        m_engineFactories.append(new Nedrysoft::ICMPPingEngine::UDPPingEngineFactory());
+        m_engineFactories.append(new Nedrysoft::ICMPPingEngine::TCPPingEngineFactory());
+    }
+
+    for (auto engineFactory : m_engineFactories) {
+        Nedrysoft::ComponentSystem::addObject(engineFactory);
+    }
+
+    // the ICMP engine is the default, so its sockets and threads are readied once the application is running
+    // rather than when the first editor is opened.
 
-    Nedrysoft::ComponentSystem::addObject(m_engineFactory);
+    QMetaObject::invokeMethod(icmpEngineFactory, [icmpEngineFactory]() {
+        if (icmpEngineFactory->available()) {
+            icmpEngineFactory->prewarm();
+        }
+    }, Qt::QueuedConnection);
 }
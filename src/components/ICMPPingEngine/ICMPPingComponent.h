@@ -27,11 +27,16 @@
 #include "ICMPPingEngineSpec.h"
 
 #include <IComponent>
+#include <QList>
 
 namespace Nedrysoft { namespace ICMPPingEngine {
     class ICMPPingEngineFactory;
 }}
 
+namespace Nedrysoft { namespace ICMPSocket {
+    class ICMPSocketXDP;
+}}
+
 /**
  * @brief       The ICMPPingComponent class provides a socket based ICMP ping engine for all platforms.
  */
@@ -79,7 +84,9 @@ class NEDRYSOFT_ICMPPINGENGINE_DLLSPEC ICMPPingComponent :
     private:
         //! @cond
 
-        Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory *m_engineFactory;
+        QList<Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory *> m_engineFactories;
+
+        Nedrysoft::ICMPSocket::ICMPSocketXDP *m_xdpSocket;
 
         //! @endcond
 };
@@ -23,27 +23,109 @@
 
 #include "ICMPPingEngine.h"
 
+#include "ICMPPingAdaptiveInterval.h"
+#include "ICMPPingIdentifierTable.h"
 #include "ICMPPingItem.h"
+#include "ICMPPingItemPool.h"
+#include "ICMPPingRateLimitDetector.h"
 #include "ICMPPingReceiverWorker.h"
+#include "ICMPPingRequestTable.h"
+#include "ICMPPingResultQueue.h"
+#include "ICMPPingScheduler.h"
+#include "ICMPPingSequenceMap.h"
+#include "ICMPPingShard.h"
 #include "ICMPPingTarget.h"
-#include "ICMPPingTimeout.h"
+#include "ICMPPingTraceLog.h"
 #include "ICMPPingTransmitter.h"
 #include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketClock.h"
 #include "ICMPPacket/ICMPPacket.h"
-#include "Utils.h"
+#include "ICMPPacket/ICMPPacketTemplate.h"
+#include "ICMPPacket/ProbePacketTemplate.h"
 
+#include <Diagnostics>
+#include <Profiler>
 #include <QElapsedTimer>
 #include <QMap>
 #include <QMutex>
-#include <QThread>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSet>
+#include <atomic>
 #include <cstdint>
+#include <future>
 
 constexpr auto DefaultReceiveTimeout = 1000;
-constexpr auto DefaultTerminateThreadTimeout = 5000;
 constexpr auto DefaultTransmitInterval = 2500;
+constexpr auto DefaultPayloadSize = 52;
+constexpr auto MaximumPayloadSize = 65507;
+constexpr auto NanosecondsInSecond = 1.0e9;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto MinimumPreciseInterval = 100000ll;
+constexpr auto DefaultMinimumAdaptiveInterval = 250000000ll;
+constexpr auto MinimumAdaptiveTimeout = 50000000ll;
+constexpr auto MaximumAdaptiveTimeoutFactor = 4;
+constexpr auto DefaultUDPDestinationPort = 33434;
+constexpr auto DefaultTCPDestinationPort = 80;
+constexpr auto ProbeSourcePortBase = 0x8000;
+constexpr auto ProbeSourcePortMask = 0x7fff;
+constexpr auto DefaultFlowIdentifier = 0x5041;
+constexpr auto TargetIdWords = 65536/64;
+constexpr auto SchedulingLagProbe = "Ping scheduling lag (ms)";
+constexpr auto MaximumProbesPerRound = 64;
+constexpr auto MaximumEmbeddedTimestampSkew = 50000000ll;
 
-constexpr auto SecondsToMs(double seconds) {
-    return seconds*1000;
+/**
+ * @brief       An outstanding single shot request.
+ */
+struct SingleShotRequest {
+    std::shared_ptr<std::promise<Nedrysoft::RouteAnalyser::PingResult> > promise;
+    uint16_t id;
+    qint64 transmitTimestamp;
+    qint64 deadline;
+    int ttl;
+};
+
+/**
+ * @brief       Returns the round trip time measured from the timestamps taken by the kernel or network adapter.
+ *
+ * @details     The adapter times exclude the host entirely but are taken from the clock of the adapter, so they
+ *              are only used as a pair.  Otherwise the kernel transmit time is used, which excludes the time spent
+ *              building and sending the request.  A timestamp that does not fall between the request being created
+ *              and the reply being received is left over from an earlier use of the sequence number.
+ *
+ * @param[in]   requestTimestamp the time the request was created in nanoseconds since the unix epoch.
+ * @param[in]   receiveTimestamp the kernel receive time of the reply.
+ * @param[in]   hardwareReceiveTimestamp the adapter receive time of the reply; or -1.
+ * @param[in]   transmitTimestamp the kernel transmit time of the request; or -1.
+ * @param[in]   hardwareTransmitTimestamp the adapter transmit time of the request; or -1.
+ *
+ * @returns     the round trip time in nanoseconds; or -1 if the timestamps cannot be used.
+ */
+static auto kernelRoundTripTime(
+        qint64 requestTimestamp,
+        qint64 receiveTimestamp,
+        qint64 hardwareReceiveTimestamp,
+        qint64 transmitTimestamp,
+        qint64 hardwareTransmitTimestamp) -> qint64 {
+
+    if ((requestTimestamp < 0) || (receiveTimestamp < requestTimestamp)) {
+        return -1;
+    }
+
+    if ((hardwareTransmitTimestamp >= 0) && (hardwareReceiveTimestamp >= hardwareTransmitTimestamp)) {
+        auto roundTripTime = hardwareReceiveTimestamp - hardwareTransmitTimestamp;
+
+        if (roundTripTime <= receiveTimestamp - requestTimestamp) {
+            return roundTripTime;
+        }
+    }
+
+    if ((transmitTimestamp >= requestTimestamp) && (transmitTimestamp <= receiveTimestamp)) {
+        return receiveTimestamp - transmitTimestamp;
+    }
+
+    return -1;
 }
 
 /**
@@ -59,14 +141,154 @@ class Nedrysoft::ICMPPingEngine::ICMPPingEngineData {
         ICMPPingEngineData(Nedrysoft::ICMPPingEngine::ICMPPingEngine *parent) :
                 m_pingEngine(parent),
                 m_transmitterWorker(nullptr),
-                m_timeoutWorker(nullptr),
-                m_transmitterThread(nullptr),
-                m_timeoutThread(nullptr),
                 m_timeout(DefaultReceiveTimeout),
-                m_epoch(QDateTime::currentDateTime()),
+                m_adaptiveTimeout(true),
+                m_epoch(Nedrysoft::ICMPSocket::ICMPSocketClock::now()),
                 m_receiverWorker(nullptr),
-                m_interval(DefaultTransmitInterval) {
+                m_shard(0),
+                m_interval(DefaultTransmitInterval * NanosecondsInMillisecond),
+                m_payloadSize(DefaultPayloadSize),
+                m_dontFragment(false),
+                m_embedTimestamps(true),
+                m_pacing(false),
+                m_jitter(0),
+                m_probesPerRound(1),
+                m_rateWeight(1),
+                m_adaptive(false),
+                m_minimumInterval(DefaultMinimumAdaptiveInterval),
+                m_requestTable(&m_itemPool),
+                m_singleShotId(0),
+                m_protocol(Nedrysoft::ICMPPingEngine::Protocol::ICMP),
+                m_destinationPort(0),
+                m_flowStable(false),
+                m_flowIdentifier(DefaultFlowIdentifier),
+                m_aligned(false),
+                m_resultBatching(false),
+                m_deliveryPending(false),
+                m_targetIds(new std::atomic<uint64_t>[TargetIdWords]),
+                m_packetsSent(0),
+                m_sendErrors(0),
+                m_packetsReceived(0),
+                m_unmatchedReplies(0),
+                m_duplicateReplies(0),
+                m_reorderedReplies(0),
+                m_lateReplies(0),
+                m_timedOut(0),
+                m_schedulingLagCount(0),
+                m_schedulingLagSum(0),
+                m_schedulingLagMaximum(0) {
+
+            for (auto word = 0; word < TargetIdWords; word++) {
+                m_targetIds[word].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief       Marks an id as belonging to one of this engine's targets.
+         *
+         * @details     Ids are never unmarked, a reply that arrives after its target was removed is still ours.
+         *              Once attached, the id is also added to the receiver so that its replies pass the filter on
+         *              the read sockets.
+         *
+         * @param[in]   id the ICMP id of the target.
+         */
+        auto addTargetId(uint16_t id) -> void {
+            m_targetIds[id / 64].fetch_or(1ull << (id % 64), std::memory_order_relaxed);
+
+            if (m_receiverWorker) {
+                m_receiverWorker->addIdentifier(id);
+            }
+        }
+
+        /**
+         * @brief       Returns whether an id belongs to one of this engine's targets.
+         *
+         * @param[in]   id the ICMP id.
+         *
+         * @returns     true if the id is ours; otherwise false.
+         */
+        auto isTargetId(uint16_t id) -> bool {
+            return m_targetIds[id / 64].load(std::memory_order_relaxed) & (1ull << (id % 64));
+        }
+
+        /**
+         * @brief       Returns the shortest timeout that any request can be given.
+         *
+         * @returns     the timeout in nanoseconds.
+         */
+        auto minimumTimeout() -> qint64 {
+            auto timeout = static_cast<qint64>(m_timeout) * NanosecondsInMillisecond;
+
+            if (m_adaptiveTimeout) {
+                return qMin(timeout, MinimumAdaptiveTimeout);
+            }
+
+            return timeout;
+        }
+
+        /**
+         * @brief       Returns the longest timeout that any request can be given.
+         *
+         * @returns     the timeout in nanoseconds.
+         */
+        auto maximumTimeout() -> qint64 {
+            auto timeout = static_cast<qint64>(m_timeout) * NanosecondsInMillisecond;
 
+            if (m_adaptiveTimeout) {
+                return timeout * MaximumAdaptiveTimeoutFactor;
+            }
+
+            return timeout;
+        }
+
+        /**
+         * @brief       Deletes removed targets that can no longer be referenced by an in-flight request.
+         *
+         * @param[in]   all if true, all removed targets are deleted regardless of their grace period.
+         */
+        auto reclaimTargets(bool all) -> void {
+            auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+            auto it = m_retiredTargets.begin();
+
+            while (it != m_retiredTargets.end()) {
+                if (all || (timestamp >= it->first)) {
+                    delete it->second;
+
+                    it = m_retiredTargets.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+
+        /**
+         * @brief       Completes a single shot request with the given result.
+         *
+         * @param[in]   request the request.
+         * @param[in]   pingResult the result to deliver to the caller.
+         */
+        static auto completeSingleShot(
+                const SingleShotRequest &request,
+                const Nedrysoft::RouteAnalyser::PingResult &pingResult) -> void {
+
+            request.promise->set_value(pingResult);
+        }
+
+        /**
+         * @brief       Completes a single shot request as having received no reply.
+         *
+         * @param[in]   request the request.
+         */
+        static auto expireSingleShot(const SingleShotRequest &request) -> void {
+            completeSingleShot(request, Nedrysoft::RouteAnalyser::PingResult(
+                0,
+                Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+                QHostAddress(),
+                request.transmitTimestamp,
+                -1ll,
+                nullptr,
+                -1
+            ));
         }
 
         friend class ICMPPingEngine;
@@ -76,38 +298,121 @@ class Nedrysoft::ICMPPingEngine::ICMPPingEngineData {
         Nedrysoft::ICMPPingEngine::ICMPPingEngine *m_pingEngine;
 
         Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *m_transmitterWorker;
-        Nedrysoft::ICMPPingEngine::ICMPPingTimeout *m_timeoutWorker;
-
-        QThread *m_transmitterThread;
-        QThread *m_timeoutThread;
 
-        QMap<uint32_t, Nedrysoft::ICMPPingEngine::ICMPPingItem *> m_pingRequests;
-        QMutex m_requestsMutex;
+        Nedrysoft::ICMPPingEngine::ICMPPingItemPool m_itemPool;
+        Nedrysoft::ICMPPingEngine::ICMPPingRequestTable m_requestTable;
+        Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap m_sequenceMap;
 
         QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> m_targetList;
+        QList<QPair<qint64, Nedrysoft::ICMPPingEngine::ICMPPingTarget *> > m_retiredTargets;
 
         int m_timeout;
+        bool m_adaptiveTimeout;
+
+        std::atomic<qint64> m_interval;
+
+        int m_payloadSize;
+        bool m_dontFragment;
+        bool m_embedTimestamps;
+
+        bool m_pacing;
+        double m_jitter;
+        int m_probesPerRound;
+
+        std::atomic<double> m_rateWeight;
+
+        bool m_adaptive;
+        qint64 m_minimumInterval;
+        Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval m_adaptiveInterval;
 
-        int m_interval;
+        Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector m_rateLimitDetector;
 
-        QDateTime m_epoch;
+        qint64 m_epoch;
 
         Nedrysoft::Core::IPVersion m_version;
 
         Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *m_receiverWorker;
+        int m_shard;
+
+        uint16_t m_singleShotId;
+        QMap<uint16_t, SingleShotRequest> m_singleShotRequests;
+        QSet<uint16_t> m_singleShotFlows;
+        QMutex m_singleShotMutex;
+
+        Nedrysoft::ICMPPingEngine::Protocol m_protocol;
+        uint16_t m_destinationPort;
+
+        bool m_flowStable;
+        uint16_t m_flowIdentifier;
+        bool m_aligned;
+
+        QString m_source;
+
+        Nedrysoft::ICMPPingEngine::ICMPPingResultQueue m_resultQueue;
+        std::atomic<bool> m_resultBatching;
+        std::atomic<bool> m_deliveryPending;
+
+        std::unique_ptr<std::atomic<uint64_t>[]> m_targetIds;
+
+        std::atomic<quint64> m_packetsSent;
+        std::atomic<quint64> m_sendErrors;
+        std::atomic<quint64> m_packetsReceived;
+        std::atomic<quint64> m_unmatchedReplies;
+        std::atomic<quint64> m_duplicateReplies;
+        std::atomic<quint64> m_reorderedReplies;
+        std::atomic<quint64> m_lateReplies;
+        std::atomic<quint64> m_timedOut;
+        std::atomic<quint64> m_schedulingLagCount;
+        std::atomic<qint64> m_schedulingLagSum;
+        std::atomic<qint64> m_schedulingLagMaximum;
 };
 
-Nedrysoft::ICMPPingEngine::ICMPPingEngine::ICMPPingEngine(Nedrysoft::Core::IPVersion version) :
-        d(std::make_shared<Nedrysoft::ICMPPingEngine::ICMPPingEngineData>(this)) {
+Nedrysoft::ICMPPingEngine::ICMPPingEngine::ICMPPingEngine(
+        Nedrysoft::Core::IPVersion version,
+        Nedrysoft::ICMPPingEngine::Protocol protocol) :
+
+            d(std::make_shared<Nedrysoft::ICMPPingEngine::ICMPPingEngineData>(this)) {
 
     d->m_version = version;
+    d->m_protocol = protocol;
+    d->m_shard = Nedrysoft::ICMPPingEngine::ICMPPingShard::next();
+
+    if (protocol == Nedrysoft::ICMPPingEngine::Protocol::UDP) {
+        d->m_destinationPort = DefaultUDPDestinationPort;
+    } else if (protocol == Nedrysoft::ICMPPingEngine::Protocol::TCP) {
+        d->m_destinationPort = DefaultTCPDestinationPort;
+    }
+
+    // the single shot id is used as the source port of probes, which is kept out of the well known port range.
+
+    if (protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+        d->m_singleShotId = Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->allocate(
+            this,
+            ProbeSourcePortBase,
+            UINT16_MAX
+        );
+    } else {
+        d->m_singleShotId = Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->allocate(
+            this,
+            1,
+            UINT16_MAX-1
+        );
+    }
 
     qRegisterMetaType<QElapsedTimer>("QElapsedTimer");
 }
 
 Nedrysoft::ICMPPingEngine::ICMPPingEngine::~ICMPPingEngine() {
+    // once the ids are released the receiver no longer passes packets to the engine.
+
+    Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->releaseAll(this);
+
     doStop();
 
+    qDeleteAll(d->m_targetList);
+
+    d->reclaimTargets(true);
+
     d.reset();
 }
 
@@ -116,7 +421,12 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::addTarget(
 
     auto target = new Nedrysoft::ICMPPingEngine::ICMPPingTarget(this, hostAddress);
 
-    d->m_transmitterWorker->addTarget(target);
+    d->m_targetList.append(target);
+    d->addTargetId(target->id());
+
+    if (d->m_transmitterWorker) {
+        d->m_transmitterWorker->addTarget(target);
+    }
 
     return target;
 }
@@ -128,122 +438,153 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::addTarget(
     auto target = new Nedrysoft::ICMPPingEngine::ICMPPingTarget(this, hostAddress, ttl);
 
     d->m_targetList.append(target);
+    d->addTargetId(target->id());
+
+    if (d->m_transmitterWorker) {
+        d->m_transmitterWorker->addTarget(target);
+    }
 
     return target;
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::removeTarget(Nedrysoft::RouteAnalyser::IPingTarget *target) -> bool {
-    Q_UNUSED(target)
+    Nedrysoft::ICMPPingEngine::ICMPPingTarget *pingTarget = nullptr;
+
+    for (auto candidate : d->m_targetList) {
+        if (static_cast<Nedrysoft::RouteAnalyser::IPingTarget *>(candidate) == target) {
+            pingTarget = candidate;
+
+            break;
+        }
+    }
+
+    if (!pingTarget) {
+        return false;
+    }
+
+    d->m_targetList.removeOne(pingTarget);
+
+    if (d->m_transmitterWorker) {
+        d->m_transmitterWorker->removeTarget(pingTarget);
+    }
+
+    pingTarget->setRemoved();
+
+    if (d->m_adaptive) {
+        d->m_adaptiveInterval.removeTarget(pingTarget);
+    }
+
+    d->m_rateLimitDetector.removeTarget(pingTarget);
+
+    // the target may still be referenced by the round being sent or by requests that are in flight, so it is
+    // only deleted once those requests are guaranteed to have timed out.
+
+    auto gracePeriod = d->maximumTimeout() + transmitInterval();
+
+    d->m_retiredTargets.append(qMakePair(
+        Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp() + gracePeriod,
+        pingTarget
+    ));
+
+    d->reclaimTargets(false);
 
     return true;
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::start() -> bool {
-    // timeout thread
-
-    d->m_timeoutWorker = new Nedrysoft::ICMPPingEngine::ICMPPingTimeout(this);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::attachReceiver() -> void {
+    // connect to the receiver thread, which also handles request timeouts
 
-    d->m_timeoutThread = new QThread();
+    if (!d->m_receiverWorker) {
+        d->m_receiverWorker = Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(false, d->m_shard);
 
-    d->m_timeoutWorker->moveToThread(d->m_timeoutThread);
+        d->m_receiverWorker->enableProtocol(static_cast<Nedrysoft::ICMPSocket::Protocol>(d->m_protocol));
 
-    connect(d->m_timeoutThread, &QThread::started, d->m_timeoutWorker,
-            &Nedrysoft::ICMPPingEngine::ICMPPingTimeout::doWork);
+        if (!d->m_source.isEmpty()) {
+            d->m_receiverWorker->enableSource(d->m_source);
+        }
 
-    connect(d->m_timeoutWorker, &Nedrysoft::ICMPPingEngine::ICMPPingTimeout::result, this,
-            &Nedrysoft::ICMPPingEngine::ICMPPingEngine::result);
+        // the read sockets drop replies for identifiers they have not been given.
 
-    d->m_timeoutThread->start();
+        d->m_receiverWorker->addIdentifier(d->m_singleShotId);
 
-    // connect to the receiver thread
+        for (auto target : d->m_targetList) {
+            d->m_receiverWorker->addIdentifier(target->id());
+        }
+    }
 
-    d->m_receiverWorker = Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance();
+    d->m_receiverWorker->addEngine(this);
+}
 
-    connect(d->m_receiverWorker,
-            &Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::packetReceived,
-            this,
-            &Nedrysoft::ICMPPingEngine::ICMPPingEngine::onPacketReceived,
-            Qt::DirectConnection
-    );
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::start() -> bool {
+    attachReceiver();
 
-    // transmitter thread
+    // the transmitter is driven by the shared scheduler thread
 
     d->m_transmitterWorker = new Nedrysoft::ICMPPingEngine::ICMPPingTransmitter(this);
 
-    d->m_transmitterThread = new QThread();
+    d->m_adaptiveInterval.setRange(d->m_minimumInterval, d->m_interval);
 
-    d->m_transmitterWorker->moveToThread(d->m_transmitterThread);
-
-    d->m_transmitterWorker->setInterval(d->m_interval);
+    d->m_transmitterWorker->setPacing(d->m_pacing, d->m_jitter);
+    d->m_transmitterWorker->setProbesPerRound(d->m_probesPerRound);
 
     for (auto target : d->m_targetList) {
         d->m_transmitterWorker->addTarget(target);
     }
 
-    connect(d->m_transmitterThread, &QThread::started, d->m_transmitterWorker,
-            &Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::doWork);
-
     connect(d->m_transmitterWorker, &Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::result, this,
             &Nedrysoft::ICMPPingEngine::ICMPPingEngine::result);
 
-    d->m_transmitterThread->start();
+    setEpoch(Nedrysoft::ICMPSocket::ICMPSocketClock::now());
+
+    // the first round of an aligned engine starts on a multiple of the interval, so that engines probing the
+    // same target over different sources or IP versions send their rounds together.
+
+    auto alignment = aligned() ? d->m_interval.load() : 0;
+
+    Nedrysoft::ICMPPingEngine::ICMPPingScheduler::getInstance(false, d->m_shard)->addTransmitter(
+        d->m_transmitterWorker,
+        alignment );
 
     return true;
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::doStop() -> bool {
     if (d->m_transmitterWorker) {
-        d->m_transmitterWorker->m_isRunning = false;
-    }
-
-    if (d->m_transmitterThread) {
-        d->m_transmitterThread->quit();
-    }
+        auto scheduler = Nedrysoft::ICMPPingEngine::ICMPPingScheduler::getInstance(true, d->m_shard);
 
-    if (d->m_timeoutWorker) {
-        d->m_timeoutWorker->m_isRunning = false;
+        if (scheduler) {
+            scheduler->removeTransmitter(d->m_transmitterWorker);
+        }
     }
 
-    if (d->m_timeoutThread) {
-        d->m_timeoutThread->quit();
-    }
+    delete d->m_transmitterWorker;
 
-    if (d->m_transmitterThread) {
-        d->m_transmitterThread->wait(DefaultTerminateThreadTimeout);
+    d->m_transmitterWorker = nullptr;
 
-        if (d->m_transmitterThread->isRunning()) {
-            d->m_transmitterThread->terminate();
-        }
+    if (d->m_receiverWorker) {
+        d->m_receiverWorker->removeEngine(this);
+    }
 
-        delete d->m_transmitterThread;
+    d->m_requestTable.clear();
 
-        d->m_transmitterThread = nullptr;
-    }
+    d->m_rateLimitDetector.clear();
 
-    if (d->m_timeoutThread) {
-        d->m_timeoutThread->wait(DefaultTerminateThreadTimeout);
+    d->reclaimTargets(true);
 
-        if (d->m_timeoutThread->isRunning()) {
-            d->m_timeoutThread->terminate();
-        }
+    // the engine no longer receives replies or timeouts, so any single shot requests still waiting are failed.
 
-        delete d->m_timeoutThread;
+    d->m_singleShotMutex.lock();
 
-        d->m_timeoutThread = nullptr;
-    }
+    auto singleShotRequests = d->m_singleShotRequests;
 
-    delete d->m_transmitterWorker;
-    delete d->m_timeoutWorker;
+    d->m_singleShotRequests.clear();
 
-    d->m_transmitterWorker = nullptr;
-    d->m_timeoutWorker = nullptr;
+    d->m_singleShotMutex.unlock();
 
-    for (auto request : d->m_pingRequests) {
-        delete request;
+    for (auto &request : singleShotRequests) {
+        d->expireSingleShot(request);
     }
 
-    d->m_pingRequests.clear();
-
     return true;
 }
 
@@ -252,88 +593,299 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::stop() -> bool {
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::addRequest(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void {
-    QMutexLocker locker(&d->m_requestsMutex);
+    auto timeout = static_cast<qint64>(d->m_timeout) * NanosecondsInMillisecond;
+
+    // each target is given a timeout from its own round trip time, bounded so that a close hop is not declared
+    // lost by a little jitter and a lost hop does not hold its requests for too long.
+
+    if (d->m_adaptiveTimeout) {
+        timeout = qBound(
+            d->minimumTimeout(),
+            pingItem->target()->retransmitTimeout(timeout),
+            d->maximumTimeout()
+        );
+    }
 
-    auto id = Nedrysoft::Utils::fzMake32(pingItem->id(), pingItem->sequenceId());
+    auto deadline = pingItem->transmitTimestamp() + timeout;
 
-    d->m_pingRequests[id] = pingItem;
+    d->m_sequenceMap.transmitted(pingItem->sequenceId());
+
+    d->m_requestTable.insert(pingItem, deadline);
+
+    if (d->m_receiverWorker) {
+        d->m_receiverWorker->scheduleTimeout(deadline);
+    }
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::removeRequest(
         Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem ) -> void {
 
-    QMutexLocker locker(&d->m_requestsMutex);
+    d->m_itemPool.release(d->m_requestTable.take(pingItem->id(), pingItem->sequenceId()));
+}
 
-    auto id = Nedrysoft::Utils::fzMake32(pingItem->id(), pingItem->sequenceId());
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::allocateRequest() -> Nedrysoft::ICMPPingEngine::ICMPPingItem * {
+    return d->m_itemPool.acquire();
+}
 
-    if (d->m_pingRequests.contains(id)) {
-        d->m_pingRequests.remove(id);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::releaseRequest(
+        Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void {
 
-        delete pingItem;
-    }
+    d->m_itemPool.release(pingItem);
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::getRequest(uint32_t id) -> Nedrysoft::ICMPPingEngine::ICMPPingItem * {
-    QMutexLocker locker(&d->m_requestsMutex);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::takeRequest(
+        uint16_t id,
+        uint16_t sequence) -> Nedrysoft::ICMPPingEngine::ICMPPingItem * {
 
-    if (d->m_pingRequests.contains(id)) {
-        return d->m_pingRequests[id];
-    }
-
-    return nullptr;
+    return d->m_requestTable.take(id, sequence);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setInterval(int interval) -> bool {
+    return setPreciseInterval(static_cast<qint64>(interval) * NanosecondsInMillisecond);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setPreciseInterval(qint64 interval) -> bool {
+    if (interval < MinimumPreciseInterval) {
+        return false;
+    }
+
     d->m_interval = interval;
 
     return true;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::preciseInterval() -> qint64 {
+    return d->m_interval;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setAdaptiveInterval(bool adaptive, qint64 minimumInterval) -> bool {
+    if (minimumInterval < MinimumPreciseInterval) {
+        return false;
+    }
+
+    d->m_adaptive = adaptive;
+    d->m_minimumInterval = minimumInterval;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::adaptiveInterval() -> bool {
+    return d->m_adaptive;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::transmitInterval() -> qint64 {
+    if (d->m_adaptive) {
+        return d->m_adaptiveInterval.interval();
+    }
+
+    return d->m_interval;
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setTimeout(int timeout) -> bool {
     d->m_timeout = timeout;
 
     return true;
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::timeoutRequests() -> void {
-    QMutexLocker locker(&d->m_requestsMutex);
-    QMutableMapIterator<uint32_t, Nedrysoft::ICMPPingEngine::ICMPPingItem *> i(d->m_pingRequests);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setAdaptiveTimeout(bool adaptive) -> void {
+    d->m_adaptiveTimeout = adaptive;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::adaptiveTimeout() -> bool {
+    return d->m_adaptiveTimeout;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setPayloadSize(int payloadSize) -> bool {
+    if ((payloadSize < 0) || (payloadSize > MaximumPayloadSize)) {
+        return false;
+    }
+
+    d->m_payloadSize = payloadSize;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::payloadSize() -> int {
+    return d->m_payloadSize;
+}
 
-    while (i.hasNext()) {
-        i.next();
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setDontFragment(bool dontFragment) -> bool {
+    d->m_dontFragment = dontFragment;
 
-        auto pingItem = i.value();
+    return true;
+}
 
-        auto elapsedTime = pingItem->elapsedTime();
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::dontFragment() -> bool {
+    return d->m_dontFragment;
+}
 
-        if ((elapsedTime/1e6) > d->m_timeout) {
-            if (pingItem->lock()) {
-                if (!pingItem->serviced()) {
-                    QHostAddress hostAddress;
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setEmbeddedTimestamps(bool embedTimestamps) -> void {
+    d->m_embedTimestamps = embedTimestamps;
+}
 
-                    pingItem->setServiced(true);
-                    pingItem->unlock();
-#pragma message("should this /1000?")
-                    Nedrysoft::RouteAnalyser::PingResult pingResult(
-                            pingItem->sampleNumber(),
-                            Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
-                            hostAddress,
-                            pingItem->transmitEpoch(),
-                            pingItem->elapsedTime()/1e9,
-                            pingItem->target(),
-                            -1);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::embeddedTimestamps() -> bool {
+    return d->m_embedTimestamps;
+}
 
-                    Q_EMIT result(pingResult);
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setPacing(bool pacing, double jitter) -> void {
+    d->m_pacing = pacing;
+    d->m_jitter = qBound(0.0, jitter, 1.0);
 
-                    i.remove();
-                } else {
-                    pingItem->unlock();
-                }
+    if (d->m_transmitterWorker) {
+        d->m_transmitterWorker->setPacing(d->m_pacing, d->m_jitter);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::pacing() -> bool {
+    return d->m_pacing;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::jitter() -> double {
+    return d->m_jitter;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setRateWeight(double weight) -> void {
+    d->m_rateWeight = qMax(0.0, weight);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::rateWeight() -> double {
+    return d->m_rateWeight;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::timeoutRequests(qint64 timestamp) -> qint64 {
+    auto expiredRequests = d->m_requestTable.takeExpired(timestamp, d->minimumTimeout());
+
+    d->m_timedOut.fetch_add(static_cast<quint64>(expiredRequests.count()), std::memory_order_relaxed);
+
+    for (auto pingItem : expiredRequests) {
+        QHostAddress hostAddress;
+
+        d->m_sequenceMap.expired(pingItem->sequenceId());
+
+        if (pingItem->target()->isRemoved()) {
+            d->m_itemPool.release(pingItem);
+
+            continue;
+        }
+
+        Nedrysoft::RouteAnalyser::PingResult pingResult(
+                pingItem->sampleNumber(),
+                Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+                hostAddress,
+                pingItem->transmitTimestamp(),
+                timestamp - pingItem->transmitTimestamp(),
+                pingItem->target(),
+                -1);
+
+        reportResult(pingResult);
+
+        if (d->m_adaptive) {
+            d->m_adaptiveInterval.addResult(pingItem->target(), pingItem->sampleNumber(), 0, false);
+        }
+
+        d->m_rateLimitDetector.addResult(pingItem->target(), true);
+
+        pingItem->target()->backoffTimeout();
+
+        d->m_itemPool.release(pingItem);
+    }
+
+    // single shot requests each have their own timeout, there are normally only a handful outstanding so
+    // they are simply scanned.
+
+    QList<SingleShotRequest> expiredSingleShots;
+
+    auto nextDeadline = static_cast<qint64>(-1);
+
+    d->m_singleShotMutex.lock();
+
+    auto it = d->m_singleShotRequests.begin();
+
+    while (it != d->m_singleShotRequests.end()) {
+        if (timestamp >= it->deadline) {
+            expiredSingleShots.append(*it);
+
+            it = d->m_singleShotRequests.erase(it);
+        } else {
+            if ((nextDeadline < 0) || (it->deadline < nextDeadline)) {
+                nextDeadline = it->deadline;
             }
+
+            it++;
+        }
+    }
+
+    d->m_singleShotMutex.unlock();
+
+    for (auto &request : expiredSingleShots) {
+        d->expireSingleShot(request);
+    }
+
+    auto requestDeadline = d->m_requestTable.nextDeadline();
+
+    if ((requestDeadline >= 0) && ((nextDeadline < 0) || (requestDeadline < nextDeadline))) {
+        nextDeadline = requestDeadline;
+    }
+
+    return nextDeadline;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setResultBatching(bool batching) -> bool {
+    d->m_resultBatching = batching;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::resultBatching() -> bool {
+    return d->m_resultBatching;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::reportResult(const Nedrysoft::RouteAnalyser::PingResult &pingResult) -> void {
+    if (!d->m_resultBatching) {
+        Q_EMIT result(pingResult);
+
+        return;
+    }
+
+    if (!d->m_resultQueue.push(pingResult)) {
+        auto traceLog = Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::getInstance();
+
+        if (traceLog) {
+            traceLog->log(Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::Event::ResultDiscarded);
         }
     }
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::publishResults() -> void {
+    if (d->m_resultQueue.isEmpty()) {
+        return;
+    }
+
+    // only one delivery is posted at a time, results that arrive before it runs are picked up by the same
+    // delivery so a busy receiver thread produces a single event per batch rather than one per result.
+
+    if (d->m_deliveryPending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, [this]() {
+        deliverResults();
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::deliverResults() -> void {
+    // the flag is cleared before the queue is drained, so results published during the drain post a new
+    // delivery rather than being left in the queue.
+
+    d->m_deliveryPending.store(false, std::memory_order_release);
+
+    auto results = d->m_resultQueue.drain();
+
+    if (!results.isEmpty()) {
+        Q_EMIT resultsReady(results);
+    }
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::saveConfiguration() -> QJsonObject {
     return QJsonObject();
 }
@@ -344,73 +896,321 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::loadConfiguration(QJsonObject co
     return false;
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setEpoch(QDateTime epoch) -> void {
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setEpoch(qint64 epoch) -> void {
     d->m_epoch = epoch;
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::epoch() -> QDateTime {
-    return d->m_epoch;
+    return Nedrysoft::ICMPSocket::ICMPSocketClock::toDateTime(d->m_epoch);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::version() -> Nedrysoft::Core::IPVersion {
     return d->m_version;
 }
 
-void Nedrysoft::ICMPPingEngine::ICMPPingEngine::onPacketReceived(
-        QElapsedTimer receiveTimer,
-        QByteArray receiveBuffer,
-        QHostAddress receiveAddress ) {
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::protocol() -> Nedrysoft::ICMPPingEngine::Protocol {
+    return d->m_protocol;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setDestinationPort(uint16_t port) -> void {
+    d->m_destinationPort = port;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::destinationPort() -> uint16_t {
+    return d->m_destinationPort;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setFlowIdentifier(uint16_t flowIdentifier) -> void {
+    d->m_flowIdentifier = flowIdentifier;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::flowIdentifier() -> uint16_t {
+    return d->m_flowIdentifier;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setFlowStable(bool flowStable) -> bool {
+    d->m_flowStable = flowStable;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::flowStable() -> bool {
+    return d->m_flowStable;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setSource(const QString &source) -> bool {
+    if (d->m_receiverWorker) {
+        return false;
+    }
+
+    d->m_source = source;
+
+    // engines that send from a source share the first shard, so that a single scheduler aligns their rounds.
+
+    if (!source.isEmpty()) {
+        d->m_shard = 0;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::source() -> QString {
+    return d->m_source;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setAligned(bool aligned) -> bool {
+    if (d->m_receiverWorker) {
+        return false;
+    }
+
+    d->m_aligned = aligned;
+
+    // aligned engines share the first shard, so that a single scheduler sends their rounds together.
+
+    if (aligned) {
+        d->m_shard = 0;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::aligned() -> bool {
+    return d->m_source.isEmpty() ? d->m_aligned : true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::setProbesPerRound(int probes) -> bool {
+    d->m_probesPerRound = qBound(1, probes, MaximumProbesPerRound);
+
+    if (d->m_transmitterWorker) {
+        d->m_transmitterWorker->setProbesPerRound(d->m_probesPerRound);
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::probesPerRound() -> int {
+    return d->m_probesPerRound;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::receivePacket(
+        Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *receiverWorker,
+        int version,
+        const Nedrysoft::ICMPPacket::ICMPPacket &responsePacket,
+        qint64 receiveTimestamp,
+        qint64 hardwareReceiveTimestamp,
+        const Nedrysoft::ICMPSocket::SocketAddress &receiveAddress ) -> void {
+
+    // a shared flow id is registered by engines on other shards, their receivers also read the reply.
+
+    if ((receiverWorker != d->m_receiverWorker) || (version != static_cast<int>(this->version()))) {
+        return;
+    }
 
     Nedrysoft::RouteAnalyser::PingResult::ResultCode resultCode =
         Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
 
-    auto responsePacket = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
-        receiveBuffer,
-        static_cast<Nedrysoft::ICMPPacket::IPVersion>(this->version())
-    );
+    // the ids of the IPv4 and IPv6 engines and of each protocol are allocated from the same table, but a flow id
+    // may be shared with an engine of another protocol.
 
-    if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::Invalid) {
+    if (responsePacket.protocol() != static_cast<Nedrysoft::ICMPPacket::Protocol>(d->m_protocol)) {
         return;
     }
 
-    if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::EchoReply) {
-        resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok;
+    switch (responsePacket.resultCode()) {
+        case Nedrysoft::ICMPPacket::EchoReply:
+        case Nedrysoft::ICMPPacket::PortUnreachable:
+        case Nedrysoft::ICMPPacket::ProbeReply: {
+            resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok;
+            break;
+        }
+
+        case Nedrysoft::ICMPPacket::TimeExceeded: {
+            resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+            break;
+        }
+
+        // errors complete the request as soon as they arrive instead of leaving it to time out.
+
+        case Nedrysoft::ICMPPacket::DestinationUnreachable:
+        case Nedrysoft::ICMPPacket::PacketTooBig:
+        case Nedrysoft::ICMPPacket::ParameterProblem: {
+            resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable;
+            break;
+        }
+
+        case Nedrysoft::ICMPPacket::AdministrativelyProhibited: {
+            resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited;
+            break;
+        }
+
+        default: {
+            break;
+        }
     }
 
-    if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::TimeExceeded) {
-        resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+    auto pingItem = takeRequest(responsePacket.id(), responsePacket.sequence());
+
+    // transmit timestamps are only taken on the ICMP sockets, probe replies are timed from userspace.
+
+    auto transmitTimestamp = qint64(-1);
+    auto hardwareTransmitTimestamp = qint64(-1);
+
+    if ((responsePacket.protocol() == Nedrysoft::ICMPPacket::ICMP) && (d->m_receiverWorker)) {
+        d->m_receiverWorker->transmitTimestamp(
+            responsePacket.id(),
+            responsePacket.sequence(),
+            transmitTimestamp,
+            hardwareTransmitTimestamp
+        );
     }
 
-    auto pingItem = this->getRequest(Nedrysoft::Utils::fzMake32(responsePacket.id(), responsePacket.sequence()));
+    if (!pingItem) {
+        PINGNOO_PROFILE_LOCK("Wait for the single shot mutex", d->m_singleShotMutex);
 
-    if (pingItem) {
-        auto elapsedTime = pingItem->elapsedTime();
+        auto it = d->m_singleShotRequests.find(responsePacket.sequence());
 
-        pingItem->lock();
+        if ((it == d->m_singleShotRequests.end()) || (it->id != responsePacket.id())) {
+            d->m_singleShotMutex.unlock();
 
-        if (!pingItem->serviced()) {
-            auto pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                pingItem->sampleNumber(),
-                resultCode,
-                receiveAddress,
-                pingItem->transmitEpoch(),
-                elapsedTime,
-                pingItem->target(),
-                -1
-            );
+            // a shared flow id passes a reply to every engine using it, only replies to our target ids are
+            // accounted for.  a late reply is not counted as lost, its request is taken off the timed out count.
+
+            if (d->isTargetId(responsePacket.id())) {
+                switch (d->m_sequenceMap.classify(responsePacket.sequence())) {
+                    case Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::Arrival::Duplicate: {
+                        d->m_duplicateReplies.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+
+                    case Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::Arrival::Late: {
+                        d->m_lateReplies.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+
+                    default: {
+                        d->m_unmatchedReplies.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+
+            return;
+        }
+
+        auto request = *it;
+
+        d->m_singleShotRequests.erase(it);
+
+        d->m_singleShotMutex.unlock();
+
+        auto hopsToTarget = -1;
+
+        if (responsePacket.ttl() != -1) {
+            hopsToTarget = request.ttl - responsePacket.ttl();
+        }
+
+        auto roundTripTime = kernelRoundTripTime(
+            request.transmitTimestamp,
+            receiveTimestamp,
+            hardwareReceiveTimestamp,
+            transmitTimestamp,
+            hardwareTransmitTimestamp
+        );
+
+        if (roundTripTime < 0) {
+            roundTripTime = receiveTimestamp - request.transmitTimestamp;
+        }
+
+        d->completeSingleShot(request, Nedrysoft::RouteAnalyser::PingResult(
+            0,
+            resultCode,
+            receiveAddress.toHostAddress(),
+            request.transmitTimestamp,
+            roundTripTime,
+            nullptr,
+            hopsToTarget
+        ));
+
+        return;
+    }
 
-            Q_EMIT Nedrysoft::ICMPPingEngine::ICMPPingEngine::result(pingResult);
+    d->m_sequenceMap.answered(responsePacket.sequence());
 
-            pingItem->setServiced(true);
-            pingItem->unlock();
+    if (pingItem->target()->isRemoved()) {
+        d->m_itemPool.release(pingItem);
+
+        return;
+    }
+
+    d->m_packetsReceived.fetch_add(1, std::memory_order_relaxed);
+
+    if (!pingItem->target()->addSequence(responsePacket.sequence())) {
+        d->m_reorderedReplies.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto roundTripTime = kernelRoundTripTime(
+        pingItem->transmitTimestamp(),
+        receiveTimestamp,
+        hardwareReceiveTimestamp,
+        transmitTimestamp,
+        hardwareTransmitTimestamp
+    );
+
+    if (roundTripTime < 0) {
+        /**
+         * the embedded timestamp is only trusted if it belongs to this request, the sample number must match and
+         * it must have been taken just before the request was sent, a stale or forged payload is ignored.
+         */
+
+        auto embeddedTimestamp = responsePacket.transmitTimestamp();
+        auto itemTimestamp = pingItem->transmitTimestamp();
+
+        auto embeddedIsValid = (embeddedTimestamp >= 0) &&
+                               (receiveTimestamp >= embeddedTimestamp) &&
+                               (responsePacket.sampleNumber() == static_cast<uint32_t>(pingItem->sampleNumber())) &&
+                               (itemTimestamp >= 0) &&
+                               (qAbs(itemTimestamp - embeddedTimestamp) <= MaximumEmbeddedTimestampSkew);
+
+        if (embeddedIsValid) {
+            roundTripTime = receiveTimestamp - embeddedTimestamp;
         } else {
-            pingItem->unlock();
+            roundTripTime = pingItem->roundTripTime(receiveTimestamp);
         }
     }
+
+    auto pingResult = Nedrysoft::RouteAnalyser::PingResult(
+        pingItem->sampleNumber(),
+        resultCode,
+        receiveAddress.toHostAddress(),
+        pingItem->transmitTimestamp(),
+        roundTripTime,
+        pingItem->target(),
+        -1
+    );
+
+    reportResult(pingResult);
+
+    if (d->m_adaptive) {
+        d->m_adaptiveInterval.addResult(
+            pingItem->target(),
+            pingItem->sampleNumber(),
+            static_cast<double>(roundTripTime) / NanosecondsInSecond,
+            !Nedrysoft::RouteAnalyser::PingResult::isLost(resultCode)
+        );
+    }
+
+    d->m_rateLimitDetector.addResult(
+        pingItem->target(),
+        Nedrysoft::RouteAnalyser::PingResult::isLost(resultCode)
+    );
+
+    pingItem->target()->addRoundTripTime(roundTripTime);
+
+    d->m_itemPool.release(pingItem);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::interval() -> int {
-    return d->m_transmitterWorker->interval();
+    return static_cast<int>(d->m_interval / NanosecondsInMillisecond);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> {
@@ -423,113 +1223,210 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::targets() -> QList<Nedrysoft::Ro
     return list;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+    Nedrysoft::RouteAnalyser::PingEngineStatistics statistics;
+
+    statistics.valid = true;
+    statistics.packetsSent = d->m_packetsSent.load(std::memory_order_relaxed);
+    statistics.sendErrors = d->m_sendErrors.load(std::memory_order_relaxed);
+    statistics.packetsReceived = d->m_packetsReceived.load(std::memory_order_relaxed);
+    statistics.unmatchedReplies = d->m_unmatchedReplies.load(std::memory_order_relaxed);
+    statistics.duplicateReplies = d->m_duplicateReplies.load(std::memory_order_relaxed);
+    statistics.reorderedReplies = d->m_reorderedReplies.load(std::memory_order_relaxed);
+    statistics.lateReplies = d->m_lateReplies.load(std::memory_order_relaxed);
+    statistics.timedOut = d->m_timedOut.load(std::memory_order_relaxed);
+
+    // a reply that arrived after its request timed out was not lost.
+
+    statistics.timedOut -= qMin(statistics.timedOut, statistics.lateReplies);
+
+    statistics.evictedRequests = d->m_requestTable.evictions();
+    statistics.outstandingRequests = d->m_requestTable.occupancy();
+    statistics.schedulingLagCount = d->m_schedulingLagCount.load(std::memory_order_relaxed);
+    statistics.schedulingLagSum = static_cast<double>(d->m_schedulingLagSum.load(std::memory_order_relaxed)) /
+                                  NanosecondsInSecond;
+    statistics.schedulingLagMaximum = static_cast<double>(d->m_schedulingLagMaximum.load(std::memory_order_relaxed)) /
+                                      NanosecondsInSecond;
+
+    auto receiverWorker = Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(true, d->m_shard);
+
+    if (receiverWorker) {
+        statistics.receiveDrops = receiverWorker->receiveDrops();
+    }
+
+    return statistics;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::recordTransmitted(int sent, int failed) -> void {
+    d->m_packetsSent.fetch_add(static_cast<quint64>(sent), std::memory_order_relaxed);
+    d->m_sendErrors.fetch_add(static_cast<quint64>(failed), std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::recordSchedulingLag(qint64 lag) -> void {
+    lag = qMax<qint64>(lag, 0);
+
+    d->m_schedulingLagCount.fetch_add(1, std::memory_order_relaxed);
+    d->m_schedulingLagSum.fetch_add(lag, std::memory_order_relaxed);
+
+    // only the transmitter thread records lag, so the maximum does not need a compare-and-swap loop.
+
+    if (lag > d->m_schedulingLagMaximum.load(std::memory_order_relaxed)) {
+        d->m_schedulingLagMaximum.store(lag, std::memory_order_relaxed);
+    }
+
+    Nedrysoft::Core::Diagnostics::getInstance()->record(
+        SchedulingLagProbe,
+        static_cast<double>(lag) / NanosecondsInMillisecond );
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::singleShot(
         QHostAddress hostAddress,
         int ttl,
         double timeout ) -> Nedrysoft::RouteAnalyser::PingResult {
 
-    Nedrysoft::ICMPSocket::ICMPSocket *writeSocket;
-    Nedrysoft::ICMPSocket::ICMPSocket *readSocket;
+    return singleShotAsync(hostAddress, ttl, timeout).get();
+}
 
-    Nedrysoft::RouteAnalyser::PingResult pingResult;
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::singleShotAsync(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
 
-    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
-        writeSocket = Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(ttl, Nedrysoft::ICMPSocket::V4);
-    } else if (hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
-        writeSocket = Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(ttl, Nedrysoft::ICMPSocket::V6);
-    }
+    return sendSingleShot(hostAddress, ttl, timeout, d->m_flowStable ? d->m_flowIdentifier : -1);
+}
 
-    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
-        readSocket = Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(Nedrysoft::ICMPSocket::V4);
-    } else if (hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
-        readSocket = Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(Nedrysoft::ICMPSocket::V6);
-    }
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::singleShotFlowAsync(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout,
+        uint16_t flowIdentifier ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+    return sendSingleShot(hostAddress, ttl, timeout, flowIdentifier);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngine::sendSingleShot(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout,
+        int flowIdentifier ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
 
-    QByteArray receiveBuffer;
+    SingleShotRequest request;
 
-    // TODO: fix
+    request.promise = std::make_shared<std::promise<Nedrysoft::RouteAnalyser::PingResult> >();
+    request.ttl = ttl;
 
-    int id = 6666;
-    int sequenceId = 5555 + ttl;
+    auto future = request.promise->get_future();
 
-    auto buffer = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
-        id,
-        sequenceId,
-        52,
-        hostAddress,
-        static_cast<Nedrysoft::ICMPPacket::IPVersion>(version())
+    auto writeSocket = Nedrysoft::ICMPSocket::ICMPSocket::sharedProbeSocket(
+        static_cast<Nedrysoft::ICMPSocket::Protocol>(d->m_protocol),
+        static_cast<Nedrysoft::ICMPSocket::IPVersion>(version()),
+        d->m_dontFragment,
+        d->m_source
     );
 
-    auto transmitEpoch = QDateTime::currentDateTime();
+    if (!writeSocket) {
+        request.promise->set_value(Nedrysoft::RouteAnalyser::PingResult());
 
-    writeSocket->sendto(buffer, hostAddress);
+        return future;
+    }
+
+    attachReceiver();
 
-    QHostAddress receiveAddress;
+    auto sequenceId = Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::nextSequence();
 
-    QElapsedTimer timer;
+    Nedrysoft::ICMPSocket::Datagram datagram;
 
-    timer.start();
+    request.id = d->m_singleShotId;
 
-    while(timer.elapsed()<(SecondsToMs(timeout))) {
-        auto remaining = DefaultReceiveTimeout-timer.elapsed();
+    if (d->m_protocol == Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+        datagram.buffer = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            request.id,
+            sequenceId,
+            d->m_payloadSize,
+            hostAddress,
+            static_cast<Nedrysoft::ICMPPacket::IPVersion>(version())
+        );
 
-        if (remaining<=0) {
-            return pingResult;
+        // the flow of an echo request is its checksum, which is fixed by adjusting the payload.
+
+        if (flowIdentifier != -1) {
+            Nedrysoft::ICMPPacket::ICMPPacketTemplate::balance(datagram.buffer, static_cast<uint16_t>(flowIdentifier));
         }
+    } else {
+        // the flow of a probe is its port pair, the destination port is fixed so the source port selects it.
 
-        if (readSocket->recvfrom(receiveBuffer, receiveAddress, remaining)) {
-            auto responseTime = QDateTime::currentDateTime();
-            auto roundTripTime = timer.nsecsElapsed();
+        if (flowIdentifier != -1) {
+            request.id = ProbeSourcePortBase | ( flowIdentifier & ProbeSourcePortMask );
 
-            Nedrysoft::RouteAnalyser::PingResult::ResultCode resultCode;
+            // a flow is claimed the first time it is used and held until the engine is destroyed, the table is not
+            // locked while holding the single shot mutex as the receive thread takes them in the opposite order.
 
-            if (!receiveBuffer.length()) {
-                continue;
-            }
+            d->m_singleShotMutex.lock();
 
-            auto responsePacket = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
-                receiveBuffer,
-                static_cast<Nedrysoft::ICMPPacket::IPVersion>(this->version())
-            );
+            auto isNewFlow = !d->m_singleShotFlows.contains(request.id);
 
-            if ((responsePacket.id()!=id) || (responsePacket.sequence()!=sequenceId)) {
-                continue;
-            }
+            d->m_singleShotFlows.insert(request.id);
 
-            if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::Invalid) {
-                continue;
-            }
+            d->m_singleShotMutex.unlock();
 
-            if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::EchoReply) {
-                resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok;
-            }
+            if (isNewFlow) {
+                Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->claim(this, request.id);
 
-            if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::TimeExceeded) {
-                resultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+                d->m_receiverWorker->addIdentifier(request.id);
             }
+        }
 
-            int hopsToTarget = -1;
+        datagram.buffer = Nedrysoft::ICMPPacket::ProbePacketTemplate(
+            static_cast<Nedrysoft::ICMPPacket::Protocol>(d->m_protocol),
+            request.id,
+            d->m_destinationPort,
+            d->m_payloadSize,
+            Nedrysoft::ICMPSocket::ICMPSocket::sourceAddress(hostAddress, d->m_source),
+            hostAddress,
+            static_cast<Nedrysoft::ICMPPacket::IPVersion>(version())
+        ).packet(sequenceId);
+    }
 
-            if (responsePacket.ttl()!=-1) {
-                hopsToTarget = ttl-responsePacket.ttl();
-            }
+    datagram.hostAddress = hostAddress;
+    datagram.ttl = ttl;
 
-            pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                0,
-                resultCode,
-                receiveAddress,
-                transmitEpoch,
-                roundTripTime/1e9,
-                nullptr,
-                hopsToTarget
-            );
+    request.transmitTimestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    request.deadline = request.transmitTimestamp + static_cast<qint64>(timeout * NanosecondsInSecond);
 
-            break;
+    // the request is registered before it is sent so that an early reply cannot be missed, if the sequence has
+    // wrapped onto a request that is still outstanding then that request is failed rather than abandoned.
+
+    d->m_singleShotMutex.lock();
+
+    auto previousRequest = d->m_singleShotRequests.find(sequenceId);
+
+    if (previousRequest != d->m_singleShotRequests.end()) {
+        d->expireSingleShot(*previousRequest);
+    }
+
+    d->m_singleShotRequests.insert(sequenceId, request);
+
+    d->m_singleShotMutex.unlock();
+
+    QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+
+    datagrams.append(datagram);
+
+    if (writeSocket->sendmmsg(datagrams) != 1) {
+        QMutexLocker locker(&d->m_singleShotMutex);
+
+        auto it = d->m_singleShotRequests.find(sequenceId);
+
+        if ((it != d->m_singleShotRequests.end()) && (it->promise == request.promise)) {
+            d->m_singleShotRequests.erase(it);
+
+            d->expireSingleShot(request);
         }
+
+        return future;
     }
 
-    delete writeSocket;
-    delete readSocket;
+    d->m_receiverWorker->scheduleTimeout(request.deadline);
 
-    return pingResult;
-}
\ No newline at end of file
+    return future;
+}
@@ -31,13 +31,37 @@
 #include <QDateTime>
 #include <memory>
 
+namespace Nedrysoft { namespace ICMPPacket {
+    class ICMPPacket;
+}}
+
+namespace Nedrysoft { namespace ICMPSocket {
+    struct SocketAddress;
+}}
+
 namespace Nedrysoft { namespace ICMPPingEngine {
     class ICMPPingEngineData;
     class ICMPPingTransitter;
     class ICMPPingItem;
+    class ICMPPingReceiverWorker;
+
+    /**
+     * @brief       The protocol used to probe targets, the values are the IP protocol numbers.
+     */
+    enum class Protocol {
+        ICMP = 1,
+        TCP = 6,
+        UDP = 17
+    };
 
     /**
      * @brief       THe ICMPPingEngine provides a ICMP socket ping engine implementation.
+     *
+     * @details     Targets may also be probed with UDP datagrams or TCP SYN segments, the probes of a target are
+     *              sent from a fixed source port to a fixed destination port so that every probe follows the same
+     *              path through load balancers that hash on the flow.  The replies are the ICMP errors generated by
+     *              routers (and a port unreachable or TCP response from the target itself), so the transmitter,
+     *              receiver and request tracking are shared with ICMP echo requests.
      */
     class ICMPPingEngine :
             public Nedrysoft::RouteAnalyser::IPingEngine {
@@ -50,14 +74,143 @@ namespace Nedrysoft { namespace ICMPPingEngine {
         public:
             /**
              * @brief       Constructs an ICMPPingEngine for the given IP version.
+             *
+             * @param[in]   version the IP version of the engine.
+             * @param[in]   protocol the protocol used to probe targets.
              */
-            explicit ICMPPingEngine(Nedrysoft::Core::IPVersion version);
+            explicit ICMPPingEngine(
+                Nedrysoft::Core::IPVersion version,
+                Nedrysoft::ICMPPingEngine::Protocol protocol = Nedrysoft::ICMPPingEngine::Protocol::ICMP
+            );
 
             /**
              * @brief       Destroys the ICMPPingEngine.
              */
             ~ICMPPingEngine();
 
+            /**
+             * @brief       Returns the protocol used to probe targets.
+             *
+             * @returns     the protocol.
+             */
+            auto protocol() -> Nedrysoft::ICMPPingEngine::Protocol;
+
+            /**
+             * @brief       Sets the destination port for UDP and TCP probes.
+             *
+             * @details     The port only applies to targets added after it is set.  The default is 33434 for UDP
+             *              (the traditional traceroute port) and 80 for TCP.
+             *
+             * @param[in]   port the destination port.
+             */
+            auto setDestinationPort(uint16_t port) -> void;
+
+            /**
+             * @brief       Returns the destination port for UDP and TCP probes.
+             *
+             * @returns     the destination port.
+             */
+            auto destinationPort() -> uint16_t;
+
+            /**
+             * @brief       Sets the flow used when the engine is flow stable.
+             *
+             * @details     For ICMP the identifier is the checksum carried by every echo request, for UDP and TCP
+             *              the low 15 bits select the source port.  Engines with the same identifier, protocol and
+             *              destination port send their probes on the same flow.  The identifier only applies to
+             *              targets added after it is set.
+             *
+             * @param[in]   flowIdentifier the flow identifier.
+             */
+            auto setFlowIdentifier(uint16_t flowIdentifier) -> void;
+
+            /**
+             * @brief       Returns the flow used when the engine is flow stable.
+             *
+             * @returns     the flow identifier.
+             */
+            auto flowIdentifier() -> uint16_t;
+
+            /**
+             * @brief       Sets whether probes are kept on a single flow.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setFlowStable
+             *
+             * @param[in]   flowStable true to keep probes on a single flow; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setFlowStable(bool flowStable) -> bool override;
+
+            /**
+             * @brief       Returns whether probes are kept on a single flow.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::flowStable
+             *
+             * @returns     true if flow stable; otherwise false.
+             */
+            auto flowStable() -> bool override;
+
+            /**
+             * @brief       Sets the source that requests are sent from.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setSource
+             *
+             * @param[in]   source the source address or interface name, empty for the default route.
+             *
+             * @returns     true if the source was set; otherwise false if the engine has already been started.
+             */
+            auto setSource(const QString &source) -> bool override;
+
+            /**
+             * @brief       Returns the source that requests are sent from.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::source
+             *
+             * @returns     the source address or interface name; otherwise an empty string for the default route.
+             */
+            auto source() -> QString override;
+
+            /**
+             * @brief       Sets whether the rounds of the engine are aligned with other aligned engines.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setAligned
+             *
+             * @param[in]   aligned true to align the rounds; otherwise false.
+             *
+             * @returns     true if set; otherwise false if the engine has already been started.
+             */
+            auto setAligned(bool aligned) -> bool override;
+
+            /**
+             * @brief       Returns whether the rounds of the engine are aligned with other aligned engines.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::aligned
+             *
+             * @returns     true if aligned; otherwise false.
+             */
+            auto aligned() -> bool override;
+
+            /**
+             * @brief       Sets the number of requests sent to each target in every round.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setProbesPerRound
+             *
+             * @param[in]   probes the number of requests per target per round.
+             *
+             * @returns     true.
+             */
+            auto setProbesPerRound(int probes) -> bool override;
+
+            /**
+             * @brief       Returns the number of requests sent to each target in every round.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::probesPerRound
+             *
+             * @returns     the number of requests per target per round.
+             */
+            auto probesPerRound() -> int override;
+
             /**
              * @brief       Sets the measurement interval for this engine instance.
              *
@@ -78,6 +231,49 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto interval() -> int override;
 
+            /**
+             * @brief       Sets the measurement interval with nanosecond resolution.
+             *
+             * @details     This allows intervals below a millisecond for high rate sampling, the interval may not
+             *              be shorter than 100 microseconds.
+             *
+             * @param[in]   interval the interval in nanoseconds.
+             *
+             * @returns     true if the interval was set; otherwise false.
+             */
+            auto setPreciseInterval(qint64 interval) -> bool;
+
+            /**
+             * @brief       Returns the measurement interval with nanosecond resolution.
+             *
+             * @returns     the interval in nanoseconds.
+             */
+            auto preciseInterval() -> qint64;
+
+            /**
+             * @brief       Enables or disables the adaptive interval.
+             *
+             * @details     When enabled, the engine samples at the minimum interval while the latency or loss of
+             *              any hop is changing and backs off towards the configured interval while the route is
+             *              stable, this reduces the number of packets sent by long running monitors without losing
+             *              detail during an incident.  The setting takes effect when the engine is started.
+             *
+             * @see         Nedrysoft::ICMPPingEngine::ICMPPingAdaptiveInterval
+             *
+             * @param[in]   adaptive true to enable the adaptive interval; otherwise false.
+             * @param[in]   minimumInterval the interval used while the route is changing in nanoseconds.
+             *
+             * @returns     true if the setting was applied; otherwise false.
+             */
+            auto setAdaptiveInterval(bool adaptive, qint64 minimumInterval) -> bool;
+
+            /**
+             * @brief       Returns whether the adaptive interval is enabled.
+             *
+             * @returns     true if enabled; otherwise false.
+             */
+            auto adaptiveInterval() -> bool;
+
             /**
              * @brief       Sets the reply timeout for this engine instance.
              *
@@ -89,6 +285,89 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto setTimeout(int timeout) -> bool override;
 
+            /**
+             * @brief       Enables or disables the adaptive timeout.
+             *
+             * @details     When enabled, each target is given a timeout from an estimate of its own round trip
+             *              time, in the same way as a TCP retransmission timer.  Losses at close hops are detected
+             *              sooner and fewer requests are held in the request table, while hops with a long round
+             *              trip time may wait longer than the configured timeout before a reply is declared lost.
+             *              The configured timeout is used for a target until it has replied.  The adaptive timeout
+             *              is enabled by default.
+             *
+             * @param[in]   adaptive true to enable the adaptive timeout; otherwise false.
+             */
+            auto setAdaptiveTimeout(bool adaptive) -> void;
+
+            /**
+             * @brief       Returns whether the adaptive timeout is enabled.
+             *
+             * @returns     true if enabled; otherwise false.
+             */
+            auto adaptiveTimeout() -> bool;
+
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setPayloadSize(int payloadSize) -> bool override;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setDontFragment
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool override;
+
+            /**
+             * @brief       Returns whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::dontFragment
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            auto dontFragment() -> bool override;
+
+            /**
+             * @brief       Sets whether results are delivered in batches.
+             *
+             * @details     When enabled, replies and timeouts are passed from the receiver thread to the engine's
+             *              thread through a lock-free queue.  The queue is published once per pass of the receiver
+             *              loop, so all results from that pass are delivered by a single resultsReady() signal.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setResultBatching
+             *
+             * @param[in]   batching true to deliver results in batches; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setResultBatching(bool batching) -> bool override;
+
+            /**
+             * @brief       Returns whether results are delivered in batches.
+             *
+             * @returns     true if results are batched; otherwise false.
+             */
+            auto resultBatching() -> bool;
+
             /**
              * @brief       Starts ping operations for this engine instance.
              *
@@ -135,6 +414,8 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              *
              * @note        This is a blocking function.
              *
+             * @see         Nedrysoft::ICMPPingEngine::ICMPPingEngine::singleShotAsync
+             *
              * @param[in]   hostAddress the target host address.
              * @param[in]   ttl time to live for this packet.
              * @param[in]   timeout time in seconds to wait for response.
@@ -147,10 +428,55 @@ namespace Nedrysoft { namespace ICMPPingEngine {
                 double timeout
             ) -> Nedrysoft::RouteAnalyser::PingResult override;
 
+            /**
+             * @brief       Transmits a single ping without blocking the caller.
+             *
+             * @details     The request is sent on the shared write socket and the reply is picked up by the shared
+             *              receiver thread, so no sockets are created per request.  Each request is given a unique
+             *              sequence number under an id reserved for single shot requests, which allows any number
+             *              of requests to be in flight at once; the receiver thread also handles the timeouts.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::singleShotAsync
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto singleShotAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> override;
+
+            /**
+             * @brief       Transmits a single ping on the given flow without blocking the caller.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::singleShotFlowAsync
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   flowIdentifier the flow to send the probe on.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto singleShotFlowAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout,
+                uint16_t flowIdentifier
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> override;
+
             /**
              * @brief       Removes a ping target from this engine instance.
              *
-             * @see         Nedrysoft::RouteAnalyser::IPingEngine::addTarget
+             * @details     Targets may be added and removed while the engine is running, the change takes effect
+             *              from the next transmission.  No further results are reported for a removed target, it
+             *              is deleted once any requests still in flight for it have timed out.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::removeTarget
              *
              * @param[in]   target the ping target to remove.
              *
@@ -174,6 +500,80 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> override;
 
+            /**
+             * @brief       Returns the health counters of the engine.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::statistics
+             *
+             * @returns     the statistics.
+             */
+            auto statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics override;
+
+            /**
+             * @brief       Sets whether the transmit timestamp is embedded in the echo payload.
+             *
+             * @details     When enabled, the transmit timestamp and sample number are written into the start of the
+             *              payload and read back from the reply, the round trip time is then calculated from the
+             *              packet itself rather than the state held for the request.  Targets with a payload smaller
+             *              than the timestamp block fall back to the request state.
+             *
+             * @param[in]   embedTimestamps true to embed timestamps; otherwise false.
+             */
+            auto setEmbeddedTimestamps(bool embedTimestamps) -> void;
+
+            /**
+             * @brief       Returns whether the transmit timestamp is embedded in the echo payload.
+             *
+             * @returns     true if timestamps are embedded; otherwise false.
+             */
+            auto embeddedTimestamps() -> bool;
+
+            /**
+             * @brief       Sets whether transmissions are paced across the interval.
+             *
+             * @details     When pacing is disabled (the default) all hops are sent back to back at the start of
+             *              each interval.  Routers commonly rate limit the ICMP messages they generate, so a burst
+             *              can show as loss on intermediate hops; when pacing is enabled the hops are spread evenly
+             *              across the interval, each offset by a random amount of up to jitter times its slot.
+             *
+             * @param[in]   pacing true to spread transmissions across the interval; otherwise false.
+             * @param[in]   jitter the maximum random offset as a fraction (0 to 1) of each hop's slot.
+             */
+            auto setPacing(bool pacing, double jitter = 0) -> void;
+
+            /**
+             * @brief       Returns whether transmissions are paced across the interval.
+             *
+             * @returns     true if pacing is enabled; otherwise false.
+             */
+            auto pacing() -> bool;
+
+            /**
+             * @brief       Returns the maximum random offset used when pacing.
+             *
+             * @returns     the jitter as a fraction of each hop's slot.
+             */
+            auto jitter() -> double;
+
+            /**
+             * @brief       Sets the weight of the engine when sharing the process wide probe rate budget.
+             *
+             * @details     The budget is shared per target, an engine with a weight of 2 is given twice the rate
+             *              per target of an engine with a weight of 1 when the budget is oversubscribed.
+             *
+             * @see         Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor
+             *
+             * @param[in]   weight the weight, the default is 1.
+             */
+            auto setRateWeight(double weight) -> void;
+
+            /**
+             * @brief       Returns the weight of the engine when sharing the process wide probe rate budget.
+             *
+             * @returns     the weight.
+             */
+            auto rateWeight() -> double;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
@@ -197,25 +597,92 @@ namespace Nedrysoft { namespace ICMPPingEngine {
 
         private:
             /**
-             * @brief       Called when a ICMP packet is available for processing.
+             * @brief       Processes a reply carrying one of the engine's ids.
+             *
+             * @details     Called on the receive thread, which has already decoded the packet and looked up the
+             *              engine from its id.
+             *
+             * @param[in]   receiverWorker the receiver that read the packet.
+             * @param[in]   version the IP version of the socket that received the packet.
+             * @param[in]   responsePacket the decoded packet.
+             * @param[in]   receiveTimestamp the time the packet was received in nanoseconds since the unix epoch.
+             * @param[in]   hardwareReceiveTimestamp the time the network adapter received the packet; or -1.
+             * @param[in]   receiveAddress the IP address that the response came from (may be different to target),
+             *              it is only converted to a QHostAddress if the reply matches a request.
+             */
+            auto receivePacket(
+                Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *receiverWorker,
+                int version,
+                const Nedrysoft::ICMPPacket::ICMPPacket &responsePacket,
+                qint64 receiveTimestamp,
+                qint64 hardwareReceiveTimestamp,
+                const Nedrysoft::ICMPSocket::SocketAddress &receiveAddress ) -> void;
+
+            /**
+             * @brief       Connects the engine to the shared receiver thread.
              *
-             * @param[in]   receiveTimer a timer started when the packet was received.
-             * @param[in]   receiveBuffer the actual packet data.
-             * @param[in]   receiveAddress the IP address that the response came from (may be different to target).
+             * @details     This may be called more than once, the engine is only connected the first time.
              */
-            Q_SLOT void onPacketReceived(
-                QElapsedTimer receiveTimer,
-                QByteArray receiveBuffer,
-                QHostAddress receiveAddress
-            );
+            auto attachReceiver() -> void;
+
+            /**
+             * @brief       Sends a single shot request.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   flowIdentifier the flow to send the probe on; otherwise -1 for no fixed flow.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto sendSingleShot(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout,
+                int flowIdentifier
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult>;
+
+            /**
+             * @brief       Reports a result either directly or through the result queue.
+             *
+             * @note        This must only be called from the receiver thread.
+             *
+             * @param[in]   pingResult the result.
+             */
+            auto reportResult(const Nedrysoft::RouteAnalyser::PingResult &pingResult) -> void;
+
+            /**
+             * @brief       Emits the results waiting in the result queue.
+             *
+             * @note        This is called in the engine's thread.
+             */
+            auto deliverResults() -> void;
 
         protected:
             /**
              * @brief       Checks for any timed out requests and removes and signals that a timeout occurred.
              *
-             * @see         Nedrysoft::ICMPPingEngine::ICMPPingTimeout
+             * @details     Only requests that have expired are visited, the sweep stops at the first request that
+             *              is still within the timeout.  Outstanding single shot requests are also expired here.
+             *              This is called from the receiver thread.
+             *
+             * @see         Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker
+             *
+             * @param[in]   timestamp the current time in nanoseconds since the unix epoch.
+             *
+             * @returns     the time at which the next request will expire; -1 if there are no outstanding requests.
+             */
+            auto timeoutRequests(qint64 timestamp) -> qint64;
+
+            /**
+             * @brief       Schedules delivery of any queued results to the engine's thread.
+             *
+             * @details     This is called from the receiver thread at the end of each pass of its loop, if a
+             *              delivery is already pending then the new results are picked up by it.
+             *
+             * @see         Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker
              */
-            auto timeoutRequests(void) -> void;
+            auto publishResults() -> void;
 
             /**
              * @brief       Adds a ping request to the engine so it can be tracked.
@@ -228,9 +695,9 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             auto addRequest(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void;
 
             /**
-             * @brief       Removes a tracked request and deletes the item.
+             * @brief       Removes a tracked request and returns the item to the pool.
              *
-             * @details     Removes a tracked request and deletes the item, when a ping response (either an echo reply
+             * @details     Removes a tracked request and returns the item to the pool, when a ping response (either an echo reply
              *              or ttl exceeded) is received the request can be removed from the engine.
              *
              * @param[in]   pingItem is the item to be removed.
@@ -238,19 +705,60 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             auto removeRequest(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void;
 
             /**
-             * @brief       Returns a tracked request by id.
+             * @brief       Returns a request item from the engine's pool.
+             *
+             * @details     Request items are recycled rather than allocated for each request, the item should be
+             *              passed to addRequest() once it is populated.
+             *
+             * @note        This must only be called from the transmitter thread.
+             *
+             * @returns     the request item.
+             */
+            auto allocateRequest() -> Nedrysoft::ICMPPingEngine::ICMPPingItem *;
+
+            /**
+             * @brief       Returns a request item to the engine's pool.
              *
-             * @details     Finds the request by the id that was received in the packet, as the engine needs to
-             *              figure out which response relates to a request to figure out the round trip time it uses
-             *              this identifier which is constructed from the ICMP header in the following manner:
+             * @param[in]   pingItem the item that is no longer required.
+             */
+            auto releaseRequest(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void;
+
+            /**
+             * @brief       Removes a tracked request by id and sequence and returns it.
              *
-             *                  (icmp_id<<16) | icmp_sequence_id
+             * @details     Finds the request by the id and sequence number that were received in the packet, the
+             *              request is removed from the table and ownership passes to the caller, who must return it
+             *              with releaseRequest().  If the request has already been claimed (for example, by the
+             *              timeout sweep) then nullptr is returned, so each request is reported exactly once.
              *
-             * @param[in]   id is the request to find.
+             * @param[in]   id the ICMP id of the response.
+             * @param[in]   sequence the ICMP sequence number of the response.
              *
              * @returns     returns the request if found; nullptr otherwise.
              */
-            auto getRequest(uint32_t id) -> Nedrysoft::ICMPPingEngine::ICMPPingItem *;
+            auto takeRequest(uint16_t id, uint16_t sequence) -> Nedrysoft::ICMPPingEngine::ICMPPingItem *;
+
+            /**
+             * @brief       Returns the interval to use for the next transmission round.
+             *
+             * @returns     the adaptive interval if enabled; otherwise the configured interval, in nanoseconds.
+             */
+            auto transmitInterval() -> qint64;
+
+            /**
+             * @brief       Records the outcome of sending a batch of requests.
+             *
+             * @param[in]   sent the number of requests that were sent.
+             * @param[in]   failed the number of requests that could not be sent.
+             */
+            auto recordTransmitted(int sent, int failed) -> void;
+
+            /**
+             * @brief       Records how late a transmission started compared to its deadline.
+             *
+             * @param[in]   lag the time in nanoseconds between the deadline and the start of the transmission.
+             */
+            auto recordSchedulingLag(qint64 lag) -> void;
 
             /**
              * @brief       Sets the transmission epoch.
@@ -258,9 +766,9 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              * @brief       Sets the transmission epoch, this is a timestamp that is used to calculate time difference
              *              when transmitting.
              *
-             * @param[in]   epoch is the epoch.
+             * @param[in]   epoch is the epoch in nanoseconds since the unix epoch, see ICMPSocketClock.
              */
-            auto setEpoch(QDateTime epoch) -> void;
+            auto setEpoch(qint64 epoch) -> void;
 
             /**
              * @brief       Returns the IP version of the engine.
@@ -284,7 +792,6 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             auto doStop() -> bool;
 
             friend class ICMPPingTransmitter;
-            friend class ICMPPingTimeout;
             friend class ICMPPingReceiverWorker;
 
         protected:
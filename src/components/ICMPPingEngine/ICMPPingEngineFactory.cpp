@@ -24,6 +24,14 @@
 #include "ICMPPingEngineFactory.h"
 #include "ICMPPingEngine.h"
 #include "ICMPPingReceiverWorker.h"
+#include "ICMPPingScheduler.h"
+#include "ICMPPingShard.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
+constexpr auto SpareEnginesPerVersion = 2;
 
 /**
  * @brief       Private class to store the ping engines instance data.
@@ -36,8 +44,25 @@ class Nedrysoft::ICMPPingEngine::ICMPPingEngineFactoryData {
          * @param[in]   parent the ICMPPingEngineFactory instance that this data belongs to.
          */
         ICMPPingEngineFactoryData(Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory *parent) :
-                m_factory(parent) {
+                m_factory(parent),
+                m_protocol(Nedrysoft::ICMPPingEngine::Protocol::ICMP),
+                m_prewarmed(false) {
+
+        }
+
+        /**
+         * @brief       Constructs spare engines until there are enough for the given IP version.
+         *
+         * @param[in]   version the IP version of the engines.
+         */
+        auto refill(Nedrysoft::Core::IPVersion version) -> void {
+            QMutexLocker locker(&m_engineListMutex);
+
+            auto &spareEngines = m_spareEngines[version];
 
+            while (spareEngines.count() < SpareEnginesPerVersion) {
+                spareEngines.append(new Nedrysoft::ICMPPingEngine::ICMPPingEngine(version, m_protocol));
+            }
         }
 
         friend class ICMPPingEngineFactory;
@@ -45,7 +70,12 @@ class Nedrysoft::ICMPPingEngine::ICMPPingEngineFactoryData {
     private:
         Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory *m_factory;
 
+        Nedrysoft::ICMPPingEngine::Protocol m_protocol;
+
         QList<Nedrysoft::ICMPPingEngine::ICMPPingEngine *> m_engineList;
+        QMap<Nedrysoft::Core::IPVersion, QList<Nedrysoft::ICMPPingEngine::ICMPPingEngine *> > m_spareEngines;
+        QMutex m_engineListMutex;
+        bool m_prewarmed;
 };
 
 Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::ICMPPingEngineFactory() :
@@ -53,13 +83,19 @@ Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::ICMPPingEngineFactory() :
 
 }
 
+Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::ICMPPingEngineFactory(
+        Nedrysoft::ICMPPingEngine::Protocol protocol) :
+
+            d(std::make_shared<Nedrysoft::ICMPPingEngine::ICMPPingEngineFactoryData>(this)) {
+
+    d->m_protocol = protocol;
+}
+
 Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::~ICMPPingEngineFactory() {
     qDeleteAll(d->m_engineList);
 
-    auto receiverWorker = Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(true);
-
-    if (receiverWorker) {
-        delete receiverWorker;
+    for (auto &spareEngines : d->m_spareEngines) {
+        qDeleteAll(spareEngines);
     }
 
     d.reset();
@@ -68,13 +104,50 @@ Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::~ICMPPingEngineFactory() {
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::createEngine(
         Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::IPingEngine * {
 
-    auto engineInstance = new Nedrysoft::ICMPPingEngine::ICMPPingEngine(version);
+    QMutexLocker locker(&d->m_engineListMutex);
+
+    Nedrysoft::ICMPPingEngine::ICMPPingEngine *engineInstance = nullptr;
+
+    auto &spareEngines = d->m_spareEngines[version];
+
+    if (!spareEngines.isEmpty()) {
+        engineInstance = spareEngines.takeFirst();
+
+        // the spare is replaced from the event loop, so the caller does not pay for constructing it.
+
+        auto factoryData = d;
+
+        QMetaObject::invokeMethod(this, [factoryData, version]() {
+            factoryData->refill(version);
+        }, Qt::QueuedConnection);
+    } else {
+        engineInstance = new Nedrysoft::ICMPPingEngine::ICMPPingEngine(version, d->m_protocol);
+    }
 
     d->m_engineList.append(engineInstance);
 
     return engineInstance;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::prewarm() -> void {
+    if (d->m_prewarmed) {
+        return;
+    }
+
+    d->m_prewarmed = true;
+
+    auto protocol = static_cast<Nedrysoft::ICMPSocket::Protocol>(d->m_protocol);
+
+    for (auto shard = 0; shard < Nedrysoft::ICMPPingEngine::ICMPPingShard::count(); shard++) {
+        Nedrysoft::ICMPPingEngine::ICMPPingScheduler::getInstance(false, shard);
+        Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(false, shard)->enableProtocol(protocol);
+    }
+
+    for (auto version : {Nedrysoft::Core::IPVersion::V4, Nedrysoft::Core::IPVersion::V6}) {
+        d->refill(version);
+    }
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::saveConfiguration() -> QJsonObject {
     return QJsonObject();
 }
@@ -105,6 +178,24 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::priority() -> double {
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::available() -> bool {
+    if (d->m_protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+        // probes need a raw socket of their protocol to send and a raw ICMP socket to receive the errors.
+
+        auto socket = Nedrysoft::ICMPSocket::ICMPSocket::createProbeSocket(
+            static_cast<Nedrysoft::ICMPSocket::Protocol>(d->m_protocol),
+            Nedrysoft::ICMPSocket::V4,
+            true
+        );
+
+        if (!socket) {
+            return false;
+        }
+
+        delete socket;
+
+        return !Nedrysoft::ICMPSocket::ICMPSocket::usesDatagramSockets();
+    }
+
 #if defined(Q_OS_LINUX)
     auto socket = Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(Nedrysoft::ICMPSocket::V4);
 
@@ -124,6 +215,8 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::deleteEngine(
 
     auto pingEngine = qobject_cast<Nedrysoft::ICMPPingEngine::ICMPPingEngine *>(engine);
 
+    QMutexLocker locker(&d->m_engineListMutex);
+
     if (d->m_engineList.contains(pingEngine)) {
         engine->stop();
         d->m_engineList.removeAll(pingEngine);
@@ -133,3 +226,14 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::deleteEngine(
     return true;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory::statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+    QMutexLocker locker(&d->m_engineListMutex);
+
+    Nedrysoft::RouteAnalyser::PingEngineStatistics statistics;
+
+    for (auto engine : d->m_engineList) {
+        statistics += engine->statistics();
+    }
+
+    return statistics;
+}
@@ -24,6 +24,7 @@
 #ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGENGINEFACTORY_H
 #define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGENGINEFACTORY_H
 
+#include "ICMPPingEngine.h"
 #include "ICMPSocket/ICMPSocket.h"
 
 #include <IInterface>
@@ -37,7 +38,8 @@ namespace Nedrysoft { namespace ICMPPingEngine {
     /**
      * @brief       Factory class for ICMPPingEngine
      *
-     * @details     The factory class for creating instances of the ICMPPingEngine type
+     * @details     The factory class for creating instances of the ICMPPingEngine type, the UDP and TCP probe
+     *              factories derive from this class and create engines for their protocol.
      */
     class ICMPPingEngineFactory :
             public Nedrysoft::RouteAnalyser::IPingEngineFactory {
@@ -58,6 +60,14 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             ~ICMPPingEngineFactory();
 
+        protected:
+            /**
+             * @brief       Constructs an ICMPPingEngineFactory which creates engines for the given protocol.
+             *
+             * @param[in]   protocol the protocol used by the created engines.
+             */
+            explicit ICMPPingEngineFactory(Nedrysoft::ICMPPingEngine::Protocol protocol);
+
         public:
             /**
              * @brief       Creates a ICMPPingEngine instance.
@@ -106,6 +116,28 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto deleteEngine(Nedrysoft::RouteAnalyser::IPingEngine *engine) -> bool override;
 
+            /**
+             * @brief      Returns the combined health counters of the engines created by this instance.
+             *
+             * @see        Nedrysoft::RouteAnalyser::IPingEngineFactory::statistics
+             *
+             * @returns    the statistics.
+             */
+            auto statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics override;
+
+            /**
+             * @brief      Prepares the factory so that the first engines it creates can start without delay.
+             *
+             * @details    The scheduler and receiver of every shard are created, which opens the read sockets and
+             *             starts their threads, and a small number of engines are constructed for each IP version.
+             *             createEngine() hands out one of these spare engines and replaces it once the event loop
+             *             is idle, so opening an editor does not wait for the sockets or the identifier table.
+             *
+             * @note       The spare engines are constructed but not attached to a receiver, so they can still be
+             *             configured with a source or any other setting before they are started.
+             */
+            auto prewarm() -> void;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
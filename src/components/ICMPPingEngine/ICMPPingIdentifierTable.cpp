@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ICMPPingIdentifierTable.h"
+
+#include <ICore>
+#include <QWriteLocker>
+
+constexpr auto IdentifierCount = 65536;
+
+Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::ICMPPingIdentifierTable() :
+        m_slots(new QVector<Claim>[IdentifierCount]),
+        m_nextIdentifier(static_cast<uint16_t>(Nedrysoft::Core::ICore::getInstance()->random(0, UINT16_MAX))) {
+
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance() ->
+        Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable * {
+
+    static ICMPPingIdentifierTable identifierTable;
+
+    return &identifierTable;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::allocate(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine,
+        uint16_t first,
+        uint16_t last) -> uint16_t {
+
+    QWriteLocker locker(&m_lock);
+
+    auto rangeSize = static_cast<int>(last) - static_cast<int>(first) + 1;
+    auto offset = (static_cast<int>(m_nextIdentifier) - static_cast<int>(first) + rangeSize) % rangeSize;
+    auto identifier = static_cast<uint16_t>(first + offset);
+
+    // the search starts from a random point so that two instances running on the same host are unlikely to use the
+    // same ids.
+
+    for (auto attempt = 0; attempt < rangeSize; attempt++) {
+        auto candidate = static_cast<uint16_t>(first + ((offset + attempt) % rangeSize));
+
+        if (m_slots[candidate].isEmpty()) {
+            identifier = candidate;
+
+            break;
+        }
+    }
+
+    m_nextIdentifier = static_cast<uint16_t>(identifier + 1);
+
+    m_slots[identifier].append(Claim{engine, 1});
+
+    return identifier;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::claim(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine,
+        uint16_t identifier) -> void {
+
+    QWriteLocker locker(&m_lock);
+
+    auto &claims = m_slots[identifier];
+
+    for (auto &claim : claims) {
+        if (claim.engine == engine) {
+            claim.references++;
+
+            return;
+        }
+    }
+
+    claims.append(Claim{engine, 1});
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::release(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine,
+        uint16_t identifier) -> void {
+
+    QWriteLocker locker(&m_lock);
+
+    auto &claims = m_slots[identifier];
+
+    for (auto index = 0; index < claims.count(); index++) {
+        if (claims[index].engine == engine) {
+            if (--claims[index].references == 0) {
+                claims.remove(index);
+            }
+
+            return;
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::releaseAll(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void {
+
+    QWriteLocker locker(&m_lock);
+
+    for (auto identifier = 0; identifier < IdentifierCount; identifier++) {
+        auto &claims = m_slots[identifier];
+
+        for (auto index = claims.count() - 1; index >= 0; index--) {
+            if (claims[index].engine == engine) {
+                claims.remove(index);
+            }
+        }
+    }
+}
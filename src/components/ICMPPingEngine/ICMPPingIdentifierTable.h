@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGIDENTIFIERTABLE_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGIDENTIFIERTABLE_H
+
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QVector>
+#include <cstdint>
+#include <memory>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingEngine;
+
+    /**
+     * @brief       The ICMPPingIdentifierTable class allocates the ICMP ids and probe source ports used by the engines
+     *              and maps them back to the engine that owns them.
+     *
+     * @details     Every engine shares the same read sockets, so the id of a reply is the only way to know which
+     *              engine sent the request.  Ids are handed out without collisions, the receiver looks up the id of
+     *              a reply in the table and passes the packet to the owning engine alone.
+     *
+     *              An id may still be claimed by more than one engine.  Flow stable probes use the flow identifier
+     *              as their source port and engines are free to choose the same flow, the packet is then passed to
+     *              each of them and the sequence number tells them apart.
+     *
+     *              Ids are allocated on the threads that manage engines and looked up on the receive thread.
+     */
+    class ICMPPingIdentifierTable {
+        private:
+            /**
+             * @brief       Constructs the ICMPPingIdentifierTable.
+             */
+            ICMPPingIdentifierTable();
+
+        public:
+            /**
+             * @brief       Returns the ICMPPingIdentifierTable instance.
+             *
+             * @returns     the table.
+             */
+            static auto getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable *;
+
+            /**
+             * @brief       Allocates an id that no other target or engine is using.
+             *
+             * @details     The search continues from the previously allocated id, so a released id is not reused
+             *              until the rest of the range has been.  If every id in the range is in use then an id is
+             *              shared.
+             *
+             * @param[in]   engine the engine that owns the id.
+             * @param[in]   first the first id of the range to allocate from.
+             * @param[in]   last the last id of the range to allocate from.
+             *
+             * @returns     the id.
+             */
+            auto allocate(
+                Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine,
+                uint16_t first,
+                uint16_t last ) -> uint16_t;
+
+            /**
+             * @brief       Claims a fixed id for an engine.
+             *
+             * @details     Claims are counted, each claim must be matched by a call to release().
+             *
+             * @param[in]   engine the engine.
+             * @param[in]   identifier the id.
+             */
+            auto claim(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine, uint16_t identifier) -> void;
+
+            /**
+             * @brief       Releases an id that was allocated or claimed by an engine.
+             *
+             * @param[in]   engine the engine.
+             * @param[in]   identifier the id.
+             */
+            auto release(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine, uint16_t identifier) -> void;
+
+            /**
+             * @brief       Releases every id held by an engine.
+             *
+             * @details     If a packet is being passed to the engine this waits for it to be processed, once this
+             *              returns the engine will not be passed any more packets.
+             *
+             * @param[in]   engine the engine.
+             */
+            auto releaseAll(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void;
+
+            /**
+             * @brief       Calls a function for each engine that owns an id.
+             *
+             * @note        The function must not allocate or release ids.
+             *
+             * @param[in]   identifier the id.
+             * @param[in]   function the function, which is passed the engine.
+             *
+             * @returns     the number of engines that the function was called for.
+             */
+            template <class F>
+            auto dispatch(uint16_t identifier, F function) -> int {
+                QReadLocker locker(&m_lock);
+
+                auto &claims = m_slots[identifier];
+
+                for (auto &claim : claims) {
+                    function(claim.engine);
+                }
+
+                return claims.count();
+            }
+
+        private:
+            //! @cond
+
+            struct Claim {
+                Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine = nullptr;
+                int references = 0;
+            };
+
+            QReadWriteLock m_lock;
+            std::unique_ptr<QVector<Claim>[]> m_slots;
+            uint16_t m_nextIdentifier;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGIDENTIFIERTABLE_H
@@ -23,21 +23,34 @@
 
 #include "ICMPPingItem.h"
 
+#include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketClock.h"
+
 #include <QTimer>
 
 Nedrysoft::ICMPPingEngine::ICMPPingItem::ICMPPingItem() :
+        m_transmitTimestamp(-1),
         m_id(0),
         m_sequenceId(0),
-        m_serviced(false),
         m_target(nullptr),
-        m_sampleNumber(0) {
+        m_sampleNumber(0),
+        m_nextFree(nullptr) {
 
 }
 
 Nedrysoft::ICMPPingEngine::ICMPPingItem::~ICMPPingItem() {
-    //m_mutex.unlock();
+
 };
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingItem::reset() -> void {
+    m_transmitTimestamp = -1;
+    m_id = 0;
+    m_sequenceId = 0;
+    m_target = nullptr;
+    m_sampleNumber = 0;
+    m_nextFree = nullptr;
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::setId(uint16_t id) -> void {
     m_id = id;
 }
@@ -52,21 +65,13 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingItem::sequenceId() -> uint16_t {
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::startTimer() -> void {
     m_elapsedTimer.restart();
-    m_transmitEpoch = QDateTime::currentDateTime();
+    m_transmitTimestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::stopTimer() -> void {
     m_elapsedTime = m_elapsedTimer.nsecsElapsed();
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingItem::setServiced(bool serviced) -> void {
-    m_serviced = serviced;
-}
-
-auto Nedrysoft::ICMPPingEngine::ICMPPingItem::serviced() -> bool {
-    return m_serviced;
-}
-
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::id() -> uint16_t {
     return m_id;
 }
@@ -83,8 +88,20 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingItem::elapsedTime() -> double {
     return static_cast<double>(m_elapsedTimer.nsecsElapsed())/static_cast<double>(1e9);
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingItem::transmitTimestamp() -> qint64 {
+    return m_transmitTimestamp;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingItem::roundTripTime(qint64 receiveTimestamp) -> qint64 {
+    if ((m_transmitTimestamp < 0) || (receiveTimestamp < m_transmitTimestamp)) {
+        return m_elapsedTimer.nsecsElapsed();
+    }
+
+    return receiveTimestamp - m_transmitTimestamp;
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::transmitEpoch() -> QDateTime {
-    return m_transmitEpoch;
+    return Nedrysoft::ICMPSocket::ICMPSocketClock::toDateTime(m_transmitTimestamp);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::setSampleNumber(unsigned long sampleNumber) -> void {
@@ -94,11 +111,3 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingItem::setSampleNumber(unsigned long samp
 auto Nedrysoft::ICMPPingEngine::ICMPPingItem::sampleNumber() -> unsigned long {
     return m_sampleNumber;
 }
-
-auto Nedrysoft::ICMPPingEngine::ICMPPingItem::lock() -> bool {
-    return m_mutex.tryLock();
-}
-
-auto Nedrysoft::ICMPPingEngine::ICMPPingItem::unlock() -> void {
-    m_mutex.unlock();
-}
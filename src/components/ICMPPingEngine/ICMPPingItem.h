@@ -26,10 +26,10 @@
 
 #include <QDateTime>
 #include <QElapsedTimer>
-#include <QMutex>
 #include <QObject>
 
 namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingItemPool;
     class ICMPPingTarget;
 
     /**
@@ -38,6 +38,8 @@ namespace Nedrysoft { namespace ICMPPingEngine {
      * @details     The ICMPPingTransmitter instance registers each ping request with the engine, this class holds the
      *              required information to allow replies to be matched to requests (and timed) and also to allow
      *              timeouts to be discovered.
+     *
+     *              Items are recycled through an ICMPPingItemPool rather than being allocated for each request.
      */
     class ICMPPingItem :
             public QObject {
@@ -84,23 +86,6 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto sequenceId() -> uint16_t;
 
-            /**
-             * @brief       Set whether this request has been serviced.
-             *
-             * @details     Marks the request as being serviced, prevents a packet being flagged as both replied to
-             *              and timeout in race condition situations.
-             *
-             * @param[in]   serviced true if serviced; otherwise false.
-             */
-            auto setServiced(bool serviced) -> void;
-
-            /**
-             * @brief       Returns the serviced status of the request.
-             *
-             * @returns     true if request has been serviced; otherwise false.
-             */
-            auto serviced() -> bool;
-
             /**
              * @brief       Sets the sample number for this request.
              *
@@ -157,42 +142,58 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             auto roundTripTime() -> double;
 
             /**
-             * @brief       Returns the epoch at which the request was transmitted.
+             * @brief       Returns the time at which the request was transmitted.
              *
-             * @returns     the epoch when the request was sent.
+             * @note        This uses the same time base as the socket receive timestamps so that the round trip
+             *              time can be calculated from the time the reply arrived at the socket.
+             *
+             * @returns     the transmit time in nanoseconds since the unix epoch.
              */
-            auto transmitEpoch() -> QDateTime;
+            auto transmitTimestamp() -> qint64;
 
             /**
-             * @brief       Locks the item for exclusive access.
+             * @brief       Returns the round trip time using the time the reply was received.
+             *
+             * @param[in]   receiveTimestamp the time the reply was received in nanoseconds since the unix epoch.
              *
-             * @returns     returns true if the item was locked; otherwise false.
+             * @returns     the round trip time in nanoseconds.
              */
-            auto lock(void) -> bool;
+            auto roundTripTime(qint64 receiveTimestamp) -> qint64;
 
             /**
-             * @brief       Unlocks the item that was previous locked.
+             * @brief       Returns the epoch at which the request was transmitted.
+             *
+             * @note        The date/time is derived from the transmit timestamp, transmitTimestamp() should be used
+             *              where a QDateTime is not required.
+             *
+             * @returns     the epoch when the request was sent.
              */
-            auto unlock(void) -> void;
+            auto transmitEpoch() -> QDateTime;
+
+            friend class ICMPPingItemPool;
+
+        private:
+            /**
+             * @brief       Resets the item to its default state so that it can be reused.
+             */
+            auto reset() -> void;
 
         private:
             //! @cond
 
             QElapsedTimer m_elapsedTimer;
-            QDateTime m_transmitEpoch;
+            qint64 m_transmitTimestamp;
 
             int64_t m_elapsedTime;
 
             uint16_t m_id;
             uint16_t m_sequenceId;
 
-            bool m_serviced;
-
             Nedrysoft::ICMPPingEngine::ICMPPingTarget *m_target;
 
             unsigned long m_sampleNumber;
 
-            QMutex m_mutex;
+            Nedrysoft::ICMPPingEngine::ICMPPingItem *m_nextFree;
 
             //! @endcond
     };
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingItemPool.h"
+
+#include "ICMPPingItem.h"
+
+constexpr auto PoolBlockSize = 256;
+constexpr auto MemorySubsystem = "ICMP ping items";
+
+Nedrysoft::ICMPPingEngine::ICMPPingItemPool::ICMPPingItemPool() :
+        m_freeList(nullptr),
+        m_memory(MemorySubsystem) {
+
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingItemPool::~ICMPPingItemPool() {
+    for (auto block : m_blocks) {
+        delete[] block;
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingItemPool::acquire() -> Nedrysoft::ICMPPingEngine::ICMPPingItem * {
+    // there is only a single consumer, so an item can't be popped and pushed back between reading the head
+    // and the exchange below, which means the stack is not subject to the ABA problem.
+
+    auto pingItem = m_freeList.load(std::memory_order_acquire);
+
+    while (pingItem) {
+        if (m_freeList.compare_exchange_weak(
+                pingItem,
+                pingItem->m_nextFree,
+                std::memory_order_acquire,
+                std::memory_order_acquire)) {
+
+            pingItem->reset();
+
+            m_memory.add(0, 1);
+
+            return pingItem;
+        }
+    }
+
+    auto block = new Nedrysoft::ICMPPingEngine::ICMPPingItem[PoolBlockSize];
+
+    m_blocks.append(block);
+
+    // the block is accounted along with its first item, which is the one handed out.
+
+    m_memory.add(static_cast<qint64>(sizeof(Nedrysoft::ICMPPingEngine::ICMPPingItem))*PoolBlockSize, 1);
+
+    // the first item of the block is returned, the remainder are chained together and pushed onto the free list.
+
+    for (auto index = 1; index < PoolBlockSize-1; index++) {
+        block[index].m_nextFree = &block[index+1];
+    }
+
+    auto head = m_freeList.load(std::memory_order_relaxed);
+
+    do {
+        block[PoolBlockSize-1].m_nextFree = head;
+    } while (!m_freeList.compare_exchange_weak(
+            head,
+            &block[1],
+            std::memory_order_release,
+            std::memory_order_relaxed));
+
+    return &block[0];
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingItemPool::release(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void {
+    if (!pingItem) {
+        return;
+    }
+
+    m_memory.remove(0, 1);
+
+    auto head = m_freeList.load(std::memory_order_relaxed);
+
+    do {
+        pingItem->m_nextFree = head;
+    } while (!m_freeList.compare_exchange_weak(
+            head,
+            pingItem,
+            std::memory_order_release,
+            std::memory_order_relaxed));
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGITEMPOOL_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGITEMPOOL_H
+
+#include <Diagnostics>
+#include <QList>
+#include <atomic>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingItem;
+
+    /**
+     * @brief       The ICMPPingItemPool class recycles ICMPPingItem instances.
+     *
+     * @details     Items are allocated in blocks and handed out from a free list, once a request has been
+     *              answered or has timed out the item is returned to the pool and reused for a later request.  The
+     *              memory used by the pool is bounded by the peak number of requests in flight.
+     *
+     *              Items are acquired by a single thread (the transmitter) and may be released from any thread,
+     *              the free list is a lock-free stack so releasing an item from the receiver never blocks.
+     *
+     *              The blocks are accounted as memory and the items in use as allocations, so a count of items that
+     *              keeps rising while the number of requests in flight does not indicates that items are leaking.
+     */
+    class ICMPPingItemPool {
+        public:
+            /**
+             * @brief       Constructs an empty ICMPPingItemPool.
+             */
+            ICMPPingItemPool();
+
+            /**
+             * @brief       Destroys the ICMPPingItemPool and all of the items owned by it.
+             *
+             * @note        All items must have been released back to the pool before it is destroyed.
+             */
+            ~ICMPPingItemPool();
+
+            /**
+             * @brief       Returns an item from the pool, allocating a new block if the pool is empty.
+             *
+             * @note        This must only be called from a single thread.
+             *
+             * @returns     the item in its default state.
+             */
+            auto acquire() -> Nedrysoft::ICMPPingEngine::ICMPPingItem *;
+
+            /**
+             * @brief       Returns an item to the pool.
+             *
+             * @param[in]   pingItem the item to return, nullptr is ignored.
+             */
+            auto release(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem) -> void;
+
+        private:
+            //! @cond
+
+            std::atomic<Nedrysoft::ICMPPingEngine::ICMPPingItem *> m_freeList;
+
+            QList<Nedrysoft::ICMPPingEngine::ICMPPingItem *> m_blocks;
+
+            Nedrysoft::Core::MemoryCounter m_memory;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGITEMPOOL_H
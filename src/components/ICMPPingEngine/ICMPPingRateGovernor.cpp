@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ICMPPingRateGovernor.h"
+
+#include "ICMPSocket/ICMPSocketClock.h"
+
+#include <QMutexLocker>
+#include <QtGlobal>
+#include <cmath>
+
+constexpr auto PacketBudgetEnvironmentVariable = "PINGNOO_RATE_PACKETS";
+constexpr auto ByteBudgetEnvironmentVariable = "PINGNOO_RATE_BYTES";
+
+constexpr auto NanosecondsInSecond = 1.0e9;
+constexpr auto BurstDuration = 0.25;
+constexpr auto MinimumShare = 0.001;
+constexpr auto AllocationIterations = 48;
+
+Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::ICMPPingRateGovernor() :
+        m_demandsChanged(false),
+        m_packetBudget(0),
+        m_byteBudget(0),
+        m_packetTokens(0),
+        m_byteTokens(0),
+        m_lastRefill(Nedrysoft::ICMPSocket::ICMPSocketClock::now()) {
+
+    setBudget(
+        qEnvironmentVariable(PacketBudgetEnvironmentVariable).toDouble(),
+        qEnvironmentVariable(ByteBudgetEnvironmentVariable).toDouble() );
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::getInstance() ->
+        Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor * {
+
+    static ICMPPingRateGovernor rateGovernor;
+
+    return &rateGovernor;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::setBudget(
+        double packetsPerSecond,
+        double bytesPerSecond) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    m_packetBudget = qMax(0.0, packetsPerSecond);
+    m_byteBudget = qMax(0.0, bytesPerSecond);
+
+    // the bucket starts full so that a new budget does not hold back the rounds that are already due.
+
+    m_packetTokens = m_packetBudget * BurstDuration;
+    m_byteTokens = m_byteBudget * BurstDuration;
+    m_lastRefill = Nedrysoft::ICMPSocket::ICMPSocketClock::now();
+
+    allocate();
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::packetBudget() -> double {
+    QMutexLocker locker(&m_mutex);
+
+    return m_packetBudget;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::byteBudget() -> double {
+    QMutexLocker locker(&m_mutex);
+
+    return m_byteBudget;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::shareInterval(
+        Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter,
+        double packets,
+        int packetLength,
+        double weight,
+        qint64 interval) -> qint64 {
+
+    QMutexLocker locker(&m_mutex);
+
+    auto &demand = m_demands[transmitter];
+
+    auto packetRate = (interval > 0) ? (packets * NanosecondsInSecond) / static_cast<double>(interval) : 0;
+    auto byteRate = packetRate * packetLength;
+    auto demandWeight = qMax(weight, 0.0) * qMax(packets, 1.0);
+
+    if ((!qFuzzyCompare(demand.packetRate + 1, packetRate + 1)) ||
+        (!qFuzzyCompare(demand.byteRate + 1, byteRate + 1)) ||
+        (!qFuzzyCompare(demand.weight + 1, demandWeight + 1))) {
+
+        demand.packetRate = packetRate;
+        demand.byteRate = byteRate;
+        demand.weight = demandWeight;
+
+        m_demandsChanged = true;
+    }
+
+    if (m_demandsChanged) {
+        allocate();
+    }
+
+    auto share = m_demands[transmitter].share;
+
+    if (share >= 1) {
+        return interval;
+    }
+
+    return static_cast<qint64>(static_cast<double>(interval) / share);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::acquire(int packets, int bytes) -> qint64 {
+    QMutexLocker locker(&m_mutex);
+
+    if ((m_packetBudget <= 0) && (m_byteBudget <= 0)) {
+        return 0;
+    }
+
+    refill(Nedrysoft::ICMPSocket::ICMPSocketClock::now());
+
+    if ((m_packetTokens >= 0) && (m_byteTokens >= 0)) {
+        // a resource without a budget is never charged, so its bucket stays empty rather than going into debt.
+
+        if (m_packetBudget > 0) {
+            m_packetTokens -= packets;
+        }
+
+        if (m_byteBudget > 0) {
+            m_byteTokens -= bytes;
+        }
+
+        return 0;
+    }
+
+    // wait until both buckets are out of debt, whichever takes longer.
+
+    auto wait = 0.0;
+
+    if (m_packetTokens < 0) {
+        wait = qMax(wait, -m_packetTokens / m_packetBudget);
+    }
+
+    if (m_byteTokens < 0) {
+        wait = qMax(wait, -m_byteTokens / m_byteBudget);
+    }
+
+    return qMax(static_cast<qint64>(1), static_cast<qint64>(std::ceil(wait * NanosecondsInSecond)));
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::removeTransmitter(
+        Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_demands.remove(transmitter)) {
+        allocate();
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::allocate() -> void {
+    m_demandsChanged = false;
+
+    /**
+     * each transmitter's load is the fraction of the budget used by its dominant resource, and it is allocated
+     * min(load, weight * level).  The level is raised until the allocations fill whichever resource runs out
+     * first, transmitters below the level keep their full rate and the rest are scaled back in proportion to
+     * their weight.
+     */
+
+    auto maximumLevel = 0.0;
+
+    for (auto &demand : m_demands) {
+        demand.share = 1;
+
+        auto load = 0.0;
+
+        if (m_packetBudget > 0) {
+            load = qMax(load, demand.packetRate / m_packetBudget);
+        }
+
+        if (m_byteBudget > 0) {
+            load = qMax(load, demand.byteRate / m_byteBudget);
+        }
+
+        if ((load > 0) && (demand.weight > 0)) {
+            maximumLevel = qMax(maximumLevel, load / demand.weight);
+        }
+    }
+
+    if (maximumLevel <= 0) {
+        return;
+    }
+
+    auto fits = [this](double level, bool apply) -> bool {
+        auto packetRate = 0.0;
+        auto byteRate = 0.0;
+
+        for (auto &demand : m_demands) {
+            auto load = 0.0;
+
+            if (m_packetBudget > 0) {
+                load = qMax(load, demand.packetRate / m_packetBudget);
+            }
+
+            if (m_byteBudget > 0) {
+                load = qMax(load, demand.byteRate / m_byteBudget);
+            }
+
+            auto share = 1.0;
+
+            if (load > 0) {
+                share = qBound(MinimumShare, (demand.weight * level) / load, 1.0);
+            }
+
+            if (apply) {
+                demand.share = share;
+            }
+
+            packetRate += demand.packetRate * share;
+            byteRate += demand.byteRate * share;
+        }
+
+        return ((m_packetBudget <= 0) || (packetRate <= m_packetBudget)) &&
+               ((m_byteBudget <= 0) || (byteRate <= m_byteBudget));
+    };
+
+    if (fits(maximumLevel, false)) {
+        return;
+    }
+
+    auto lowerLevel = 0.0;
+    auto upperLevel = maximumLevel;
+
+    for (auto iteration = 0; iteration < AllocationIterations; iteration++) {
+        auto level = (lowerLevel + upperLevel) / 2;
+
+        if (fits(level, false)) {
+            lowerLevel = level;
+        } else {
+            upperLevel = level;
+        }
+    }
+
+    fits(lowerLevel, true);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::refill(qint64 currentTime) -> void {
+    auto elapsed = static_cast<double>(currentTime - m_lastRefill) / NanosecondsInSecond;
+
+    if (elapsed <= 0) {
+        return;
+    }
+
+    m_lastRefill = currentTime;
+
+    m_packetTokens = qMin(m_packetTokens + (m_packetBudget * elapsed), m_packetBudget * BurstDuration);
+    m_byteTokens = qMin(m_byteTokens + (m_byteBudget * elapsed), m_byteBudget * BurstDuration);
+}
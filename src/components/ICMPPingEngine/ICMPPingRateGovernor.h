@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATEGOVERNOR_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATEGOVERNOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <cstdint>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingTransmitter;
+
+    /**
+     * @brief       The ICMPPingRateGovernor class limits the combined rate at which every engine in the process
+     *              sends requests.
+     *
+     * @details     The budget is a number of packets and bytes per second, either may be 0 for no limit.  Each
+     *              transmitter reports the rate it would like to send at and the budget is divided between them
+     *              by weighted max-min fairness on their dominant resource, a transmitter that asks for less
+     *              than its share keeps its rate and the remainder is shared by the others.  The weight of a
+     *              transmitter is its engine's weight multiplied by its number of targets, so that the share
+     *              is equal per target across engines.
+     *
+     *              A transmitter that is given less than it asked for has its interval stretched, so an overloaded
+     *              budget lowers the sampling rate of every engine instead of queueing or dropping packets.  A
+     *              token bucket shared by every transmitter then enforces the budget over short periods, a round
+     *              that would exceed it is deferred until enough tokens have been added.
+     *
+     *              The initial budget is read from the PINGNOO_RATE_PACKETS and PINGNOO_RATE_BYTES environment
+     *              variables.
+     *
+     * @note        All functions are thread safe, the governor is shared by the scheduler of every shard.
+     */
+    class ICMPPingRateGovernor {
+        private:
+            /**
+             * @brief       Constructs the ICMPPingRateGovernor.
+             */
+            ICMPPingRateGovernor();
+
+        public:
+            /**
+             * @brief       Returns the ICMPPingRateGovernor instance.
+             *
+             * @returns     the governor.
+             */
+            static auto getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor *;
+
+            /**
+             * @brief       Sets the budget.
+             *
+             * @param[in]   packetsPerSecond the maximum number of packets per second; or 0 for no limit.
+             * @param[in]   bytesPerSecond the maximum number of bytes per second; or 0 for no limit.
+             */
+            auto setBudget(double packetsPerSecond, double bytesPerSecond) -> void;
+
+            /**
+             * @brief       Returns the packet budget.
+             *
+             * @returns     the maximum number of packets per second; or 0 if there is no limit.
+             */
+            auto packetBudget() -> double;
+
+            /**
+             * @brief       Returns the byte budget.
+             *
+             * @returns     the maximum number of bytes per second; or 0 if there is no limit.
+             */
+            auto byteBudget() -> double;
+
+            /**
+             * @brief       Updates the rate a transmitter would like to send at and returns the interval it may use.
+             *
+             * @param[in]   transmitter the transmitter.
+             * @param[in]   packets the average number of packets sent each interval.
+             * @param[in]   packetLength the length of each packet in bytes.
+             * @param[in]   weight the weight of the transmitter's engine.
+             * @param[in]   interval the interval the transmitter would like to use in nanoseconds.
+             *
+             * @returns     the interval in nanoseconds, which is never shorter than the requested interval.
+             */
+            auto shareInterval(
+                Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter,
+                double packets,
+                int packetLength,
+                double weight,
+                qint64 interval ) -> qint64;
+
+            /**
+             * @brief       Takes the tokens needed to send a number of packets.
+             *
+             * @details     The bucket may be overdrawn by a single request so that a round larger than the bucket
+             *              can still be sent, the following requests wait for the debt to be repaid.
+             *
+             * @param[in]   packets the number of packets.
+             * @param[in]   bytes the total length of the packets in bytes.
+             *
+             * @returns     0 if the packets may be sent now; otherwise the number of nanoseconds to wait before
+             *              asking again.
+             */
+            auto acquire(int packets, int bytes) -> qint64;
+
+            /**
+             * @brief       Removes a transmitter, its share is returned to the other transmitters.
+             *
+             * @param[in]   transmitter the transmitter.
+             */
+            auto removeTransmitter(Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter) -> void;
+
+        private:
+            /**
+             * @brief       Divides the budget between the transmitters.
+             *
+             * @note        Must be called with the mutex held.
+             */
+            auto allocate() -> void;
+
+            /**
+             * @brief       Adds the tokens accumulated since the last refill.
+             *
+             * @note        Must be called with the mutex held.
+             *
+             * @param[in]   currentTime the current time in nanoseconds.
+             */
+            auto refill(qint64 currentTime) -> void;
+
+        private:
+            //! @cond
+
+            struct Demand {
+                double packetRate = 0;
+                double byteRate = 0;
+                double weight = 1;
+                double share = 1;
+            };
+
+            QMutex m_mutex;
+            QHash<Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *, Demand> m_demands;
+            bool m_demandsChanged;
+
+            double m_packetBudget;
+            double m_byteBudget;
+            double m_packetTokens;
+            double m_byteTokens;
+            qint64 m_lastRefill;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATEGOVERNOR_H
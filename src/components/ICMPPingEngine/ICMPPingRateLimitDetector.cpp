@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ICMPPingRateLimitDetector.h"
+
+#include "ICMPPingTarget.h"
+
+#include <QMutexLocker>
+
+constexpr auto WindowResults = 20;
+constexpr auto RateLimitedLoss = 0.1;
+constexpr auto CleanLoss = 0.0;
+constexpr auto MaximumBackoff = 8;
+constexpr auto CleanWindowsBeforeRetry = 4;
+
+Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::ICMPPingRateLimitDetector() = default;
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::addResult(
+        Nedrysoft::ICMPPingEngine::ICMPPingTarget *target,
+        bool lost) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    auto &statistics = m_targetStatistics[target];
+
+    statistics.ttl = target->ttl();
+    statistics.results++;
+
+    if (lost) {
+        statistics.lost++;
+    }
+
+    if (statistics.results < WindowResults) {
+        return;
+    }
+
+    statistics.windowLoss = static_cast<double>(statistics.lost) / statistics.results;
+    statistics.results = 0;
+    statistics.lost = 0;
+
+    closeWindow(target, statistics);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::closeWindow(
+        Nedrysoft::ICMPPingEngine::ICMPPingTarget *target,
+        TargetStatistics &statistics) -> void {
+
+    // the final hop (ttl 0) is the destination, there is nothing after it to compare against.
+
+    if ((statistics.uncorrelated) || (statistics.ttl == 0)) {
+        return;
+    }
+
+    if (statistics.windowLoss >= RateLimitedLoss) {
+        statistics.cleanWindows = 0;
+
+        if (!downstreamClean(statistics.ttl)) {
+            return;
+        }
+
+        if (statistics.backoff >= MaximumBackoff) {
+            // the loss did not go away when the rate was lowered, so it is not caused by a rate limit.
+
+            statistics.uncorrelated = true;
+            statistics.backoff = 1;
+        } else {
+            statistics.backoff *= 2;
+        }
+
+        target->setProbeBackoff(statistics.backoff);
+
+        return;
+    }
+
+    if ((statistics.backoff == 1) || (statistics.windowLoss > CleanLoss)) {
+        return;
+    }
+
+    statistics.cleanWindows++;
+
+    if (statistics.cleanWindows < CleanWindowsBeforeRetry) {
+        return;
+    }
+
+    statistics.cleanWindows = 0;
+    statistics.backoff /= 2;
+
+    target->setProbeBackoff(statistics.backoff);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::downstreamClean(int ttl) -> bool {
+    for (auto &statistics : m_targetStatistics) {
+        // a ttl of 0 is the destination, which is always after the intermediate hops.
+
+        auto isDownstream = (statistics.ttl == 0) || (statistics.ttl > ttl);
+
+        if ((isDownstream) && (statistics.windowLoss >= 0) && (statistics.windowLoss <= CleanLoss)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::removeTarget(
+        Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    m_targetStatistics.remove(target);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRateLimitDetector::clear() -> void {
+    QMutexLocker locker(&m_mutex);
+
+    for (auto it = m_targetStatistics.begin(); it != m_targetStatistics.end(); ++it) {
+        it.key()->setProbeBackoff(1);
+    }
+
+    m_targetStatistics.clear();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATELIMITDETECTOR_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATELIMITDETECTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QtGlobal>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingTarget;
+
+    /**
+     * @brief       The ICMPPingRateLimitDetector class detects hops that rate limit their ICMP responses and backs
+     *              off the rate at which they are probed.
+     *
+     * @details     Routers commonly limit the rate at which they generate time exceeded messages, so a hop can
+     *              show loss even though the packets it forwards are not lost.  Results are counted in windows for
+     *              each target, when a window shows loss while a hop further along the route answered every probe
+     *              in its last window the hop is assumed to be rate limiting and is probed half as often.
+     *
+     *              If the loss clears at the lower rate the hop stays backed off, after a number of clean windows
+     *              the rate is doubled again to check that the limit still applies.  If the hop is still losing
+     *              probes at the lowest rate then the loss does not depend on the probe rate, the hop is returned
+     *              to the full rate and is not backed off again.
+     *
+     *              Results are added from the receiver thread.
+     */
+    class ICMPPingRateLimitDetector {
+        public:
+            /**
+             * @brief       Constructs an ICMPPingRateLimitDetector.
+             */
+            ICMPPingRateLimitDetector();
+
+            /**
+             * @brief       Updates the statistics for a target with a new result.
+             *
+             * @param[in]   target the target that the result is for.
+             * @param[in]   lost true if the probe was lost; otherwise false.
+             */
+            auto addResult(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target, bool lost) -> void;
+
+            /**
+             * @brief       Removes the statistics held for a target.
+             *
+             * @param[in]   target the target.
+             */
+            auto removeTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void;
+
+            /**
+             * @brief       Removes the statistics held for every target and returns them to the full rate.
+             */
+            auto clear() -> void;
+
+        private:
+            //! @cond
+
+            struct TargetStatistics {
+                int ttl = 0;
+                int results = 0;
+                int lost = 0;
+                double windowLoss = -1;
+                int backoff = 1;
+                int cleanWindows = 0;
+                bool uncorrelated = false;
+            };
+
+            /**
+             * @brief       Returns whether a hop after the given TTL answered every probe in its last window.
+             *
+             * @param[in]   ttl the TTL of the hop.
+             *
+             * @returns     true if a later hop is clean; otherwise false.
+             */
+            auto downstreamClean(int ttl) -> bool;
+
+            /**
+             * @brief       Decides whether to change the rate of a target once its window is full.
+             *
+             * @param[in]   target the target.
+             * @param[in]   statistics the statistics of the target.
+             */
+            auto closeWindow(
+                Nedrysoft::ICMPPingEngine::ICMPPingTarget *target,
+                TargetStatistics &statistics ) -> void;
+
+            QMutex m_mutex;
+            QHash<Nedrysoft::ICMPPingEngine::ICMPPingTarget *, TargetStatistics> m_targetStatistics;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRATELIMITDETECTOR_H
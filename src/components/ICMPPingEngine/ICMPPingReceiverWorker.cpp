@@ -23,26 +23,60 @@
 
 #include "ICMPPingReceiverWorker.h"
 
-#include "ICMPPacket/ICMPPacket.h"
+#include "ICMPPacket/ICMPPacketCodec.h"
+#include "ICMPPingCapture.h"
 #include "ICMPPingEngine.h"
+#include "ICMPPingIdentifierTable.h"
 #include "ICMPPingItem.h"
+#include "ICMPPingShard.h"
 #include "ICMPPingTarget.h"
+#include "ICMPPingTraceLog.h"
 #include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketReactor.h"
+#include "ICMPSocket/ICMPSocketRing.h"
 
+#include <PowerProfile>
+#include <Profiler>
 #include <QHostAddress>
+#include <QMutexLocker>
 #include <QThread>
 #include <QtEndian>
+#include <limits>
 #include <spdlog/spdlog.h>
 
-constexpr auto DefaultReplyTimeout = 1000;
+constexpr auto MaximumReceiveBatch = 64;
+constexpr auto NoDeadline = std::numeric_limits<qint64>::max();
+constexpr auto NanosecondsInMillisecond = 1000000;
+constexpr auto TransmitRecordCount = 65536;
+constexpr auto SequenceBits = 16;
+constexpr auto RingEnvironmentVariable = "PINGNOO_IO_URING";
 
-Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::ICMPPingReceiverWorker() :
+Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::ICMPPingReceiverWorker(int shard) :
         m_engine(nullptr),
         m_receiveWorker(nullptr),
         m_receiverThread(nullptr),
-        m_socket(nullptr),
+        m_reactor(new Nedrysoft::ICMPSocket::ICMPSocketReactor),
+        m_ring(nullptr),
+        m_tcpEnabled(false),
+        m_nextDeadline(NoDeadline),
+        m_shard(shard),
         m_isRunning(false) {
 
+    /**
+     * the ring collects every packet that has arrived in the same call that waits, the reactor is kept for kernels
+     * without multishot receives, versions of Windows without registered I/O and for the simulator, whose sockets
+     * have no descriptor.
+     */
+
+    if ((!Nedrysoft::ICMPSocket::ICMPSocket::simulator()) && (qgetenv(RingEnvironmentVariable) != "0")) {
+        m_ring = new Nedrysoft::ICMPSocket::ICMPSocketRing;
+
+        if (!m_ring->isValid()) {
+            delete m_ring;
+
+            m_ring = nullptr;
+        }
+    }
 }
 
 Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::~ICMPPingReceiverWorker() {
@@ -53,19 +87,36 @@ Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::~ICMPPingReceiverWorker() {
     if (m_receiveWorker) {
         m_receiveWorker->m_isRunning = false;
 
+        wakeup();
+
         m_receiverThread->quit();
         m_receiverThread->wait();
 
         delete m_receiverThread;
     }
 
-    if (m_socket) {
-        delete m_socket;
+    // the shared sockets are owned by the library.
+
+    for (auto socket : m_sockets) {
+        if ((!socket->isDatagram()) || (socket->protocol() != Nedrysoft::ICMPSocket::ICMP)) {
+            delete socket;
+        }
     }
+
+    // registered I/O cannot cancel a posted receive, the sockets are closed first so that none are left using the
+    // buffers of the ring.
+
+    delete m_ring;
+    delete m_reactor;
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(bool returnNull) -> Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker * {
-    static Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *instance = nullptr;
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(
+        bool returnNull,
+        int shard ) -> Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker * {
+
+    static Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *instances[ICMPPingShard::MaximumShards] = {};
+
+    auto &instance = instances[shard];
 
     if (instance) {
         return instance;
@@ -75,7 +126,74 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(bool returnN
         return nullptr;
     }
 
-    instance = new Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker;
+    instance = new Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker(shard);
+
+    // the read sockets are created before the thread is started, so that a request sent as soon as this
+    // returns is guaranteed to have a socket listening for its reply.
+
+    for (auto version : {Nedrysoft::ICMPSocket::V4, Nedrysoft::ICMPSocket::V6}) {
+        if (Nedrysoft::ICMPSocket::ICMPSocket::usesDatagramSockets()) {
+            // datagram sockets only receive the replies to requests that were sent from them, so the shared
+            // sockets used for sending are read instead.
+
+            for (auto dontFragment : {false, true}) {
+                auto socket = Nedrysoft::ICMPSocket::ICMPSocket::sharedWriteSocket(version, dontFragment);
+
+                if (socket) {
+                    instance->m_sockets.append(socket);
+
+                    instance->watchSocket(socket);
+
+                    socket->enableTransmitTimestamps();
+                } else {
+                    SPDLOG_ERROR(QString("Unable to create IPv%1 ICMP datagram socket.").arg(version).toStdString());
+                }
+            }
+
+            continue;
+        }
+
+        // a raw read socket only receives, the transmit timestamps are queued on the shared sockets that send.
+        // the error queue of a socket can only be drained by one reader, so only the first shard reads it.
+
+        for (auto dontFragment : {false, true}) {
+            if (shard != 0) {
+                break;
+            }
+
+            auto socket = Nedrysoft::ICMPSocket::ICMPSocket::sharedWriteSocket(version, dontFragment);
+
+            if ((socket) && (socket->enableTransmitTimestamps())) {
+                instance->m_timestampSockets.append(socket);
+
+                instance->watchSocket(socket);
+            }
+        }
+
+        auto socket = Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(version);
+
+        if (socket) {
+            // until an engine adds its identifiers the filter drops everything.
+
+            socket->setIdentifierFilter(QList<uint16_t>());
+
+            instance->m_sockets.append(socket);
+
+            instance->watchSocket(socket);
+        } else {
+            SPDLOG_ERROR(QString("Unable to create IPv%1 ICMP read socket.").arg(version).toStdString());
+        }
+    }
+
+    auto transmitTimestamps = !instance->m_timestampSockets.isEmpty();
+
+    for (auto socket : instance->m_sockets) {
+        transmitTimestamps |= socket->transmitTimestampsEnabled();
+    }
+
+    if (transmitTimestamps) {
+        instance->m_transmitRecords.resize(TransmitRecordCount);
+    }
 
     instance->m_receiverThread = new QThread;
 
@@ -91,27 +209,396 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::getInstance(bool returnN
 }
 
 void Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::doWork() {
-    QByteArray receiveBuffer;
+    QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+
+    // the receiver takes the odd core, next to the scheduler of the same shard.
+
+    ICMPPingShard::pinThread(m_shard*2+1);
+
+    PINGNOO_PROFILE_THREAD("Ping receiver");
+
+    m_socketsMutex.lock();
 
-    m_socket =  Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(
-        static_cast<Nedrysoft::ICMPSocket::IPVersion>(Nedrysoft::ICMPSocket::V4)
-    );
+    auto hasSockets = !m_sockets.isEmpty();
 
-    QHostAddress receiveAddress;
+    m_socketsMutex.unlock();
+
+    if (!hasSockets) {
+        return;
+    }
 
     m_isRunning = true;
 
     while (QThread::currentThread()->isRunning() && (m_isRunning)) {
-        QElapsedTimer receiveTimer;
+        auto waitTimeout = -1;
+        auto deadline = m_nextDeadline.load(std::memory_order_acquire);
+
+        if (deadline != NoDeadline) {
+            auto wakeupSlack = Nedrysoft::RouteAnalyser::PowerProfile::wakeupSlack();
+
+            // when saving power the timeouts are swept at the end of a slot, so nearby timeouts share a wakeup.
+
+            if (wakeupSlack > 0) {
+                deadline = ((deadline / wakeupSlack) + 1) * wakeupSlack;
+            }
 
-        auto result = m_socket->recvfrom(receiveBuffer, receiveAddress, DefaultReplyTimeout);
+            auto remaining = deadline - Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
 
-        receiveTimer.restart();
+            if (remaining > 0) {
+                waitTimeout = static_cast<int>((remaining + NanosecondsInMillisecond - 1) / NanosecondsInMillisecond);
+            } else {
+                waitTimeout = 0;
+            }
+        }
+
+        auto readySockets = m_ring ? m_ring->wait(waitTimeout) : m_reactor->wait(waitTimeout);
+
+        // the transmit timestamps are read first, so that a reply that arrived in the same wait can use them.
+
+        for (auto socket : readySockets) {
+            if (m_timestampSockets.contains(socket)) {
+                receiveTransmitTimestamps(socket);
+            }
+        }
+
+        for (auto socket : readySockets) {
+            if (m_timestampSockets.contains(socket)) {
+                continue;
+            }
+
+            datagrams.clear();
+
+            auto result = m_ring ?
+                m_ring->receive(socket, datagrams) :
+                socket->recvmmsg(datagrams, MaximumReceiveBatch, 0);
+
+            receiveTransmitTimestamps(socket);
+
+            if (result!=-1) {
+                if (socket->version() == Nedrysoft::ICMPSocket::V4) {
+                    dispatchDatagrams<Nedrysoft::ICMPPacket::V4>(socket, datagrams);
+                } else {
+                    dispatchDatagrams<Nedrysoft::ICMPPacket::V6>(socket, datagrams);
+                }
+            }
+        }
+
+        if (m_nextDeadline.load(std::memory_order_acquire) <= Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp()) {
+            processTimeouts();
+        }
 
-        if (result!=-1) {
-            SPDLOG_TRACE("ICMP Packet Received");
+        PINGNOO_PROFILE_LOCK("Wait for the engines mutex", m_enginesMutex);
 
-            Q_EMIT packetReceived(receiveTimer, receiveBuffer, receiveAddress);
+        for (auto engine : m_engines) {
+            engine->publishResults();
         }
+
+        m_enginesMutex.unlock();
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::watchSocket(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+
+    if (m_ring) {
+        m_ring->addSocket(socket);
+    } else {
+        m_reactor->addSocket(socket);
     }
-}
\ No newline at end of file
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::wakeup() -> void {
+    if (m_ring) {
+        m_ring->wakeup();
+    } else {
+        m_reactor->wakeup();
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::addEngine(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void {
+
+    QMutexLocker locker(&m_enginesMutex);
+
+    if (!m_engines.contains(engine)) {
+        m_engines.append(engine);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::removeEngine(
+        Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void {
+
+    QMutexLocker locker(&m_enginesMutex);
+
+    m_engines.removeAll(engine);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::scheduleTimeout(qint64 deadline) -> void {
+    auto currentDeadline = m_nextDeadline.load(std::memory_order_relaxed);
+
+    while (deadline < currentDeadline) {
+        if (m_nextDeadline.compare_exchange_weak(
+                currentDeadline,
+                deadline,
+                std::memory_order_acq_rel,
+                std::memory_order_relaxed)) {
+
+            wakeup();
+
+            break;
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::enableProtocol(
+        Nedrysoft::ICMPSocket::Protocol protocol) -> bool {
+
+    if (protocol != Nedrysoft::ICMPSocket::TCP) {
+        return true;
+    }
+
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (m_tcpEnabled) {
+        return true;
+    }
+
+    auto socketCount = 0;
+
+    for (auto version : {Nedrysoft::ICMPSocket::V4, Nedrysoft::ICMPSocket::V6}) {
+        auto socket = Nedrysoft::ICMPSocket::ICMPSocket::createProbeSocket(protocol, version);
+
+        if (socket) {
+            m_sockets.append(socket);
+
+            watchSocket(socket);
+
+            socketCount++;
+        } else {
+            SPDLOG_ERROR(QString("Unable to create IPv%1 TCP read socket.").arg(version).toStdString());
+        }
+    }
+
+    m_tcpEnabled = (socketCount != 0);
+
+    return m_tcpEnabled;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::enableSource(const QString &source) -> void {
+    if (!Nedrysoft::ICMPSocket::ICMPSocket::usesDatagramSockets()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (m_sources.contains(source)) {
+        return;
+    }
+
+    m_sources.insert(source);
+
+    for (auto version : {Nedrysoft::ICMPSocket::V4, Nedrysoft::ICMPSocket::V6}) {
+        for (auto dontFragment : {false, true}) {
+            auto socket = Nedrysoft::ICMPSocket::ICMPSocket::sharedWriteSocket(version, dontFragment, source);
+
+            if (!socket) {
+                SPDLOG_ERROR(
+                    QString("Unable to create IPv%1 ICMP datagram socket on %2.")
+                        .arg(version)
+                        .arg(source)
+                        .toStdString() );
+
+                continue;
+            }
+
+            // the transmit records are only allocated when the receiver is created, so timestamps are only
+            // requested if they will be read.
+
+            if (!m_transmitRecords.isEmpty()) {
+                socket->enableTransmitTimestamps();
+            }
+
+            m_sockets.append(socket);
+
+            watchSocket(socket);
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::addIdentifier(uint16_t identifier) -> void {
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (m_identifiers.contains(identifier)) {
+        return;
+    }
+
+    m_identifiers.insert(identifier);
+
+    auto identifiers = m_identifiers.values();
+
+    for (auto socket : m_sockets) {
+        socket->setIdentifierFilter(identifiers);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::receiveDrops() -> quint64 {
+    QMutexLocker locker(&m_socketsMutex);
+
+    quint64 receiveDrops = 0;
+
+    for (auto socket : m_sockets) {
+        receiveDrops += socket->receiveDrops();
+    }
+
+    return receiveDrops;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::receiveTransmitTimestamps(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+
+    if ((m_transmitRecords.isEmpty()) || (!socket->transmitTimestampsEnabled())) {
+        return;
+    }
+
+    m_transmitTimestamps.clear();
+
+    socket->receiveTransmitTimestamps(m_transmitTimestamps);
+
+    /**
+     * the kernel and the adapter timestamps for a request are reported separately, they are merged into the
+     * record for the sequence number, a record left over from an earlier use of the sequence number is replaced.
+     */
+
+    for (auto &transmitTimestamp : m_transmitTimestamps) {
+        auto key = (static_cast<uint32_t>(transmitTimestamp.id) << SequenceBits) | transmitTimestamp.sequence;
+        auto &record = m_transmitRecords[transmitTimestamp.sequence];
+
+        if (record.key != key) {
+            record = TransmitRecord();
+
+            record.key = key;
+        }
+
+        if (transmitTimestamp.timestamp >= 0) {
+            record.timestamp = transmitTimestamp.timestamp;
+        }
+
+        if (transmitTimestamp.hardwareTimestamp >= 0) {
+            record.hardwareTimestamp = transmitTimestamp.hardwareTimestamp;
+        }
+    }
+}
+
+template <Nedrysoft::ICMPPacket::IPVersion Version>
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::dispatchDatagrams(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket,
+        const QList<Nedrysoft::ICMPSocket::Datagram> &datagrams) -> void {
+
+    PINGNOO_PROFILE_ZONE("Receive dispatch");
+
+    auto identifierTable = Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance();
+    auto protocol = static_cast<Nedrysoft::ICMPPacket::Protocol>(socket->protocol());
+    auto capture = Nedrysoft::ICMPPingEngine::ICMPPingCapture::getInstance();
+    auto traceLog = Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::getInstance();
+
+    for (auto &datagram : datagrams) {
+        if (traceLog) {
+            traceLog->log(
+                Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::Event::Received,
+                datagram.socketAddress,
+                datagram.buffer.length() );
+        }
+
+        // the packet is decoded once and only passed to the engine that owns its id.
+
+        auto responsePacket = Nedrysoft::ICMPPacket::ICMPPacketCodec<Version>::decode(datagram.buffer, protocol);
+
+        if (responsePacket.resultCode() == Nedrysoft::ICMPPacket::Invalid) {
+            continue;
+        }
+
+        if (capture) {
+            capture->recordReceived(
+                datagram,
+                static_cast<Nedrysoft::ICMPSocket::IPVersion>(Version),
+                protocol,
+                responsePacket );
+        }
+
+        identifierTable->dispatch(
+            responsePacket.id(),
+            [&](Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) {
+                engine->receivePacket(
+                    this,
+                    Version,
+                    responsePacket,
+                    datagram.timestamp,
+                    datagram.hardwareTimestamp,
+                    datagram.socketAddress
+                );
+            }
+        );
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::transmitTimestamp(
+        uint16_t id,
+        uint16_t sequence,
+        qint64 &timestamp,
+        qint64 &hardwareTimestamp) -> bool {
+
+    timestamp = -1;
+    hardwareTimestamp = -1;
+
+    if (m_transmitRecords.isEmpty()) {
+        return false;
+    }
+
+    auto &record = m_transmitRecords[sequence];
+
+    if (record.key != ((static_cast<uint32_t>(id) << SequenceBits) | sequence)) {
+        return false;
+    }
+
+    timestamp = record.timestamp;
+    hardwareTimestamp = record.hardwareTimestamp;
+
+    record = TransmitRecord();
+
+    return (timestamp >= 0) || (hardwareTimestamp >= 0);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker::processTimeouts() -> void {
+    // the deadline is cleared before the engines are swept, a request added during the sweep will lower it
+    // again so that it is not missed.
+
+    m_nextDeadline.store(NoDeadline, std::memory_order_release);
+
+    PINGNOO_PROFILE_ZONE("Process timeouts");
+
+    auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    auto earliestDeadline = NoDeadline;
+
+    PINGNOO_PROFILE_LOCK("Wait for the engines mutex", m_enginesMutex);
+
+    for (auto engine : m_engines) {
+        auto nextDeadline = engine->timeoutRequests(timestamp);
+
+        if ((nextDeadline >= 0) && (nextDeadline < earliestDeadline)) {
+            earliestDeadline = nextDeadline;
+        }
+    }
+
+    m_enginesMutex.unlock();
+
+    // this thread is about to wait again, so the deadline is lowered without waking the reactor.
+
+    auto currentDeadline = m_nextDeadline.load(std::memory_order_relaxed);
+
+    while ((earliestDeadline < currentDeadline) && !m_nextDeadline.compare_exchange_weak(
+            currentDeadline,
+            earliestDeadline,
+            std::memory_order_acq_rel,
+            std::memory_order_relaxed)) {
+    }
+}
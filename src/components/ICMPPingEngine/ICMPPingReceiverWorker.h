@@ -24,14 +24,24 @@
 #ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRECEIVERWORKER_H
 #define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRECEIVERWORKER_H
 
+#include "ICMPPacket/ICMPPacket.h"
+#include "ICMPSocket/ICMPSocket.h"
+
 #include <QObject>
 #include <QByteArray>
-#include <QElapsedTimer>
 #include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QSet>
 #include <QThread>
+#include <QVector>
+#include <atomic>
+
+class ICMPPingComponent;
 
 namespace Nedrysoft { namespace ICMPSocket {
-    class ICMPSocket;
+    class ICMPSocketReactor;
+    class ICMPSocketRing;
 }}
 
 namespace Nedrysoft { namespace ICMPPingEngine {
@@ -41,8 +51,24 @@ namespace Nedrysoft { namespace ICMPPingEngine {
     /**
      * @brief       The ICMP packet receiver class.
      *
-     * @details     This is a singleton class, there is a single receive thread which reads packets as they arrive
-     *              and then signals that a packet is available, other objects can then process the packet.
+     * @details     This is a singleton class, there is a single receive thread which reads packets as they arrive,
+     *              decodes them and passes each one to the engine that owns its id in the ICMPPingIdentifierTable.
+     *
+     *              The receiver owns a read socket for both IPv4 and IPv6 and services them from the same
+     *              wait, each packet is passed on with the IP version of the socket it arrived on so that
+     *              engines only process replies for their own address family.  TCP replies are not ICMP
+     *              messages, so read sockets for TCP are only created once an engine enables the protocol.
+     *
+     *              Request timeouts are also driven from the receive thread, the wait is bounded by the earliest
+     *              deadline of the registered engines and each engine is swept when its deadline has passed, so
+     *              no engine requires a thread of its own to detect lost packets.
+     *
+     *              Where the platform supports it, the time each request left the host is read back from the
+     *              kernel on the same thread and held until the reply arrives, see transmitTimestamp().
+     *
+     *              When the engines are sharded there is one receiver per shard, each with its own raw read
+     *              sockets that only accept the identifiers of the engines on that shard, see ICMPPingShard.
+     *              Transmit timestamps are only read by the receiver of the first shard.
      */
     class ICMPPingReceiverWorker :
             public QObject {
@@ -55,8 +81,10 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              * @brief       Constructs a ICMPPingReceiverWorker.
              *
              * @note        Hidden as this is a singleton class and should be accessed through getInstance().
+             *
+             * @param[in]   shard the shard that the receiver serves.
              */
-            ICMPPingReceiverWorker();
+            ICMPPingReceiverWorker(int shard);
 
             /**
              * @brief       Destroys the ICMPPingReceiverWorker.
@@ -65,29 +93,108 @@ namespace Nedrysoft { namespace ICMPPingEngine {
 
         public:
             /**
-             * @brief       Returns the ICMPPingReceiverWorker singleton instance.
+             * @brief       Returns the ICMPPingReceiverWorker singleton instance for a shard.
              *
              * @param[in]   returnNull if the singleton has not been allocated, then return null if true.
+             * @param[in]   shard the shard.
              *
              * @returns     the singleton instance.
              */
-            static auto getInstance(bool returnNull=false) -> Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *;
+            static auto getInstance(
+                bool returnNull=false,
+                int shard=0 ) -> Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *;
+
+            /**
+             * @brief       Registers an engine so that its requests are checked for timeouts.
+             *
+             * @param[in]   engine the engine.
+             */
+            auto addEngine(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void;
+
+            /**
+             * @brief       Unregisters an engine.
+             *
+             * @details     Once this returns the receive thread will no longer access the engine.
+             *
+             * @param[in]   engine the engine.
+             */
+            auto removeEngine(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) -> void;
+
+            /**
+             * @brief       Ensures that the engines are swept for timeouts no later than the given deadline.
+             *
+             * @details     If the deadline is earlier than the one currently scheduled then the receive thread is
+             *              woken so that it can shorten its wait.
+             *
+             * @param[in]   deadline the deadline in nanoseconds since the unix epoch.
+             */
+            auto scheduleTimeout(qint64 deadline) -> void;
+
+            /**
+             * @brief       Ensures that replies for the given protocol are received.
+             *
+             * @details     ICMP and UDP probes are answered with ICMP messages which are already received, for TCP
+             *              the read sockets are created on first use and added to the running receive thread.
+             *
+             * @param[in]   protocol the protocol.
+             *
+             * @returns     true if replies for the protocol can be received; otherwise false.
+             */
+            auto enableProtocol(Nedrysoft::ICMPSocket::Protocol protocol) -> bool;
+
+            /**
+             * @brief       Ensures that replies to requests sent from the given source are received.
+             *
+             * @details     The raw read sockets receive replies on every interface, datagram sockets only receive
+             *              the replies to their own requests so the shared sockets bound to the source are added to
+             *              the running receive thread.
+             *
+             * @param[in]   source the source address or interface name.
+             */
+            auto enableSource(const QString &source) -> void;
+
+            /**
+             * @brief       Ensures that replies carrying the given identifier are received.
+             *
+             * @details     The raw read sockets drop every packet that does not carry a registered identifier in
+             *              the kernel, an identifier must be added before the first request using it is sent.
+             *              Identifiers are never removed, a late reply to a removed target is still received.
+             *
+             * @param[in]   identifier the ICMP id, or the source port of a UDP or TCP probe.
+             */
+            auto addIdentifier(uint16_t identifier) -> void;
 
             /**
-             * @brief       This signal is emitted when an ICMP packet has been received.
+             * @brief       Returns the number of packets the kernel dropped before they could be read.
              *
-             * @param[in]   receiveTimer a timer started from when the packet was received.
-             * @param[in]   receiveBuffer the packet data.
-             * @param[in]   receiveAddress the address the packet was received from (this may differ from the target).
+             * @details     The drops are summed over the read sockets, as the sockets are shared the count covers
+             *              the replies of every engine.
+             *
+             * @returns     the number of dropped packets.
              */
-            Q_SIGNAL void packetReceived(
-                QElapsedTimer receiveTimer,
-                QByteArray receiveBuffer,
-                QHostAddress receiveAddress
-            );
+            auto receiveDrops() -> quint64;
+
+            /**
+             * @brief       Returns the time that the kernel (and network adapter) reported a request was sent.
+             *
+             * @details     The timestamp is consumed, so it is only returned for the first reply to a request.  This
+             *              must be called from the receive thread, which is the thread replies are passed to the engines on.
+             *
+             * @param[in]   id the id of the request.
+             * @param[in]   sequence the sequence number of the request.
+             * @param[out]  timestamp the transmit time taken by the kernel; or -1.
+             * @param[out]  hardwareTimestamp the transmit time taken by the network adapter; or -1.
+             *
+             * @returns     true if a transmit timestamp was found; otherwise false.
+             */
+            auto transmitTimestamp(
+                uint16_t id,
+                uint16_t sequence,
+                qint64 &timestamp,
+                qint64 &hardwareTimestamp ) -> bool;
 
             friend class ICMPPingEngine;
-            friend class ICMPPingEngineFactory;
+            friend class ::ICMPPingComponent;
 
         private:
             /**
@@ -95,13 +202,76 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto doWork() -> void;
 
+            /**
+             * @brief       Sweeps each registered engine for timed out requests and schedules the next deadline.
+             */
+            auto processTimeouts() -> void;
+
+            /**
+             * @brief       Reads the transmit timestamps reported on a socket and holds them for transmitTimestamp().
+             *
+             * @param[in]   socket the socket.
+             */
+            auto receiveTransmitTimestamps(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void;
+
+            /**
+             * @brief       Decodes a batch of datagrams and passes each one to the engine that owns its id.
+             *
+             * @details     The decoder is specialised on the address family of the socket, the version is selected
+             *              once per batch so the per packet decode is inlined without a branch on the version.
+             *
+             * @tparam      Version the ip version of the socket.
+             * @param[in]   socket the socket that the datagrams were received on.
+             * @param[in]   datagrams the received datagrams.
+             */
+            template <Nedrysoft::ICMPPacket::IPVersion Version>
+            auto dispatchDatagrams(
+                Nedrysoft::ICMPSocket::ICMPSocket *socket,
+                const QList<Nedrysoft::ICMPSocket::Datagram> &datagrams
+            ) -> void;
+
+            /**
+             * @brief       Registers a socket with the ring if one is in use; otherwise with the reactor.
+             *
+             * @param[in]   socket the socket.
+             */
+            auto watchSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void;
+
+            /**
+             * @brief       Interrupts the receive thread if it is waiting for packets.
+             */
+            auto wakeup() -> void;
+
         private:
             //! @cond
 
+            struct TransmitRecord {
+                uint32_t key = 0;
+                qint64 timestamp = -1;
+                qint64 hardwareTimestamp = -1;
+            };
+
             Nedrysoft::ICMPPingEngine::ICMPPingEngine *m_engine;
             Nedrysoft::ICMPPingEngine::ICMPPingReceiverWorker *m_receiveWorker;
             QThread *m_receiverThread;
-            Nedrysoft::ICMPSocket::ICMPSocket *m_socket;
+            QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_sockets;
+            QMutex m_socketsMutex;
+            bool m_tcpEnabled;
+            QSet<QString> m_sources;
+            QSet<uint16_t> m_identifiers;
+            Nedrysoft::ICMPSocket::ICMPSocketReactor *m_reactor;
+            Nedrysoft::ICMPSocket::ICMPSocketRing *m_ring;
+
+            QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_timestampSockets;
+            QVector<TransmitRecord> m_transmitRecords;
+            QList<Nedrysoft::ICMPSocket::TransmitTimestamp> m_transmitTimestamps;
+
+            QList<Nedrysoft::ICMPPingEngine::ICMPPingEngine *> m_engines;
+            QMutex m_enginesMutex;
+
+            std::atomic<qint64> m_nextDeadline;
+
+            int m_shard;
 
             bool m_isRunning;
 
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingRequestTable.h"
+
+#include "ICMPPingItem.h"
+#include "ICMPPingItemPool.h"
+#include "Utils.h"
+
+constexpr auto RequestTableCapacity = 16384u;
+constexpr auto RequestTableMask = RequestTableCapacity-1;
+constexpr auto SlotOccupied = 1ull;
+constexpr auto SlotKeyShift = 32;
+constexpr auto GenerationMask = 0x7fffffffu;
+
+static_assert((RequestTableCapacity & RequestTableMask) == 0, "request table capacity must be a power of 2");
+
+/**
+ * @brief       Builds the state word for an occupied slot.
+ *
+ * @details     The key is stored in the upper 32 bits, the generation in bits 1..31 and the occupied flag in
+ *              bit 0.  The generation changes on every insert so that a state word is never reused while a
+ *              reader may still hold a stale copy of it.
+ *
+ * @param[in]   key the request key.
+ * @param[in]   generation the insert generation.
+ *
+ * @returns     the state word.
+ */
+static constexpr auto slotState(uint32_t key, uint32_t generation) -> uint64_t {
+    return (static_cast<uint64_t>(key) << SlotKeyShift) |
+           (static_cast<uint64_t>(generation & GenerationMask) << 1) |
+           SlotOccupied;
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::ICMPPingRequestTable(
+        Nedrysoft::ICMPPingEngine::ICMPPingItemPool *pool) :
+        m_slots(new Slot[RequestTableCapacity]),
+        m_pool(pool),
+        m_generation(0),
+        m_headSequence(0),
+        m_expirySequence(0),
+        m_nextDeadline(-1),
+        m_occupancy(0),
+        m_evictions(0) {
+
+    for (auto index = 0u; index < RequestTableCapacity; index++) {
+        m_slots[index].state.store(0, std::memory_order_relaxed);
+        m_slots[index].item.store(nullptr, std::memory_order_relaxed);
+        m_slots[index].timestamp.store(0, std::memory_order_relaxed);
+        m_slots[index].deadline.store(0, std::memory_order_relaxed);
+    }
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::~ICMPPingRequestTable() {
+    clear();
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::insert(
+        Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem,
+        qint64 deadline) -> void {
+
+    auto &slot = m_slots[pingItem->sequenceId() & RequestTableMask];
+
+    // claim the slot first, if an unanswered request from a previous sequence wrap is still present then
+    // we now own it and it can be returned to the pool.
+
+    auto previousState = slot.state.exchange(0, std::memory_order_acq_rel);
+
+    if (previousState & SlotOccupied) {
+        m_pool->release(slot.item.load(std::memory_order_relaxed));
+
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_occupancy.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot.item.store(pingItem, std::memory_order_relaxed);
+    slot.timestamp.store(pingItem->transmitTimestamp(), std::memory_order_relaxed);
+    slot.deadline.store(deadline, std::memory_order_relaxed);
+
+    m_generation++;
+
+    slot.state.store(
+        slotState(Nedrysoft::Utils::fzMake32(pingItem->id(), pingItem->sequenceId()), m_generation),
+        std::memory_order_release
+    );
+
+    m_headSequence.store(static_cast<uint16_t>(pingItem->sequenceId()+1), std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::take(
+        uint16_t id,
+        uint16_t sequence) -> Nedrysoft::ICMPPingEngine::ICMPPingItem * {
+
+    auto &slot = m_slots[sequence & RequestTableMask];
+
+    auto state = slot.state.load(std::memory_order_acquire);
+
+    if (!(state & SlotOccupied) || ((state >> SlotKeyShift) != Nedrysoft::Utils::fzMake32(id, sequence))) {
+        return nullptr;
+    }
+
+    // the item is read before the exchange, if the slot has been modified in the meantime the state word
+    // will differ and the compare will fail, so a successful exchange guarantees the item is the one we read.
+
+    auto pingItem = slot.item.load(std::memory_order_relaxed);
+
+    if (!slot.state.compare_exchange_strong(state, 0, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    m_occupancy.fetch_sub(1, std::memory_order_relaxed);
+
+    return pingItem;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::takeExpired(
+        qint64 timestamp,
+        qint64 minimumTimeout) -> QList<Nedrysoft::ICMPPingEngine::ICMPPingItem *> {
+
+    QList<Nedrysoft::ICMPPingEngine::ICMPPingItem *> expiredList;
+
+    auto headSequence = m_headSequence.load(std::memory_order_acquire);
+
+    // if the sweep has fallen more than a table's worth behind then the older slots have already been
+    // reused, so skip straight to the oldest sequence number that can still be present.
+
+    if (static_cast<uint16_t>(headSequence-m_expirySequence) > RequestTableCapacity) {
+        m_expirySequence = static_cast<uint16_t>(headSequence-RequestTableCapacity);
+    }
+
+    m_nextDeadline = -1;
+
+    // the cursor only advances past empty slots, a request that has not expired holds it in place while the
+    // scan carries on to later requests that may have shorter deadlines.
+
+    auto advance = true;
+    auto sequence = m_expirySequence;
+
+    while (sequence != headSequence) {
+        auto &slot = m_slots[sequence & RequestTableMask];
+
+        auto state = slot.state.load(std::memory_order_acquire);
+
+        if (!(state & SlotOccupied)) {
+            if (advance) {
+                m_expirySequence++;
+            }
+
+            sequence++;
+
+            continue;
+        }
+
+        // no request sent after this one can have expired yet.
+
+        auto earliestDeadline = slot.timestamp.load(std::memory_order_relaxed) + minimumTimeout;
+
+        if (timestamp < earliestDeadline) {
+            if ((m_nextDeadline < 0) || (earliestDeadline < m_nextDeadline)) {
+                m_nextDeadline = earliestDeadline;
+            }
+
+            break;
+        }
+
+        auto deadline = slot.deadline.load(std::memory_order_relaxed);
+
+        if (timestamp < deadline) {
+            if ((m_nextDeadline < 0) || (deadline < m_nextDeadline)) {
+                m_nextDeadline = deadline;
+            }
+
+            advance = false;
+
+            sequence++;
+
+            continue;
+        }
+
+        auto pingItem = slot.item.load(std::memory_order_relaxed);
+
+        // if the exchange fails the slot was either answered or reused, so it is examined again rather than
+        // skipped in case it now holds a newer request.
+
+        if (slot.state.compare_exchange_strong(state, 0, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            expiredList.append(pingItem);
+
+            m_occupancy.fetch_sub(1, std::memory_order_relaxed);
+
+            if (advance) {
+                m_expirySequence++;
+            }
+
+            sequence++;
+        }
+    }
+
+    return expiredList;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::nextDeadline() -> qint64 {
+    return m_nextDeadline;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::clear() -> void {
+    for (auto index = 0u; index < RequestTableCapacity; index++) {
+        auto &slot = m_slots[index];
+
+        auto previousState = slot.state.exchange(0, std::memory_order_acq_rel);
+
+        if (previousState & SlotOccupied) {
+            m_pool->release(slot.item.load(std::memory_order_relaxed));
+
+            m_occupancy.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::occupancy() const -> quint64 {
+    return static_cast<quint64>(qMax<int64_t>(m_occupancy.load(std::memory_order_relaxed), 0));
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingRequestTable::evictions() const -> quint64 {
+    return m_evictions.load(std::memory_order_relaxed);
+}
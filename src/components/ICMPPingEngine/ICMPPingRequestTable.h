@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGREQUESTTABLE_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGREQUESTTABLE_H
+
+#include <QList>
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingItem;
+    class ICMPPingItemPool;
+
+    /**
+     * @brief       The ICMPPingRequestTable class tracks the outstanding requests of a ping engine.
+     *
+     * @details     A fixed capacity table indexed directly by the ICMP sequence number.  Each slot carries an
+     *              atomic state word holding the request key, a generation count and an occupied flag; ownership
+     *              of a request is transferred by a single compare-and-swap on that word, so a lookup from the
+     *              receiver thread never waits on the transmitter or on the timeout sweep.
+     *
+     *              Requests are inserted by a single producer (the transmitter thread), any number of threads
+     *              may take requests concurrently.  The thread that successfully takes a request owns it and
+     *              is responsible for returning it to the pool.
+     *
+     *              Sequence numbers are allocated in transmit order, so the slots form a queue ordered by transmit
+     *              time.  Each request carries its own deadline, but none can expire sooner than the minimum timeout
+     *              after it was sent, so the expiry sweep keeps a cursor to the oldest outstanding sequence number
+     *              and stops at the first request sent less than the minimum timeout ago.  The cost of a sweep is
+     *              proportional to the number of requests in flight for longer than the minimum timeout rather than
+     *              the size of the table.  The sweep must only be run from a single thread.
+     */
+    class ICMPPingRequestTable {
+        public:
+            /**
+             * @brief       Constructs an empty ICMPPingRequestTable.
+             *
+             * @param[in]   pool the pool that discarded requests are returned to.
+             */
+            explicit ICMPPingRequestTable(Nedrysoft::ICMPPingEngine::ICMPPingItemPool *pool);
+
+            /**
+             * @brief       Destroys the ICMPPingRequestTable, releasing any requests still outstanding.
+             */
+            ~ICMPPingRequestTable();
+
+            /**
+             * @brief       Adds a request to the table.
+             *
+             * @details     The request is stored in the slot selected by its sequence number, if that slot still
+             *              holds a request from a previous wrap of the sequence then the old request is discarded.
+             *              The table takes ownership of the item.
+             *
+             * @note        The item's timer must have been started, the transmit timestamp and deadline are
+             *              captured so that the timeout sweep does not need to dereference the item.
+             *
+             * @param[in]   pingItem the request to track.
+             * @param[in]   deadline the time in nanoseconds after which the request has timed out.
+             */
+            auto insert(Nedrysoft::ICMPPingEngine::ICMPPingItem *pingItem, qint64 deadline) -> void;
+
+            /**
+             * @brief       Removes the request matching the id and sequence from the table.
+             *
+             * @details     This is wait-free, either the request is claimed with a single compare-and-swap or
+             *              nullptr is returned because it was not present or another thread claimed it first.
+             *
+             * @param[in]   id the ICMP id of the response.
+             * @param[in]   sequence the ICMP sequence number of the response.
+             *
+             * @returns     the request, now owned by the caller; nullptr if not found.
+             */
+            auto take(uint16_t id, uint16_t sequence) -> Nedrysoft::ICMPPingEngine::ICMPPingItem *;
+
+            /**
+             * @brief       Removes all requests whose deadline has passed.
+             *
+             * @param[in]   timestamp the current time in nanoseconds.
+             * @param[in]   minimumTimeout the shortest time in nanoseconds that any request may be outstanding for.
+             *
+             * @returns     the expired requests, now owned by the caller.
+             */
+            auto takeExpired(
+                qint64 timestamp,
+                qint64 minimumTimeout ) -> QList<Nedrysoft::ICMPPingEngine::ICMPPingItem *>;
+
+            /**
+             * @brief       Returns the earliest time that a request still in the table can expire.
+             *
+             * @details     The time is found by the last call to takeExpired(), it may be earlier than the real
+             *              deadline but is never later.
+             *
+             * @note        This must be called from the same thread as takeExpired().
+             *
+             * @returns     the deadline in nanoseconds; -1 if there are no outstanding requests.
+             */
+            auto nextDeadline() -> qint64;
+
+            /**
+             * @brief       Removes all outstanding requests and returns them to the pool.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of requests currently in the table.
+             *
+             * @details     May be called from any thread, the count is approximate while requests are being
+             *              inserted or taken.
+             *
+             * @returns     the number of outstanding requests.
+             */
+            auto occupancy() const -> quint64;
+
+            /**
+             * @brief       Returns the number of requests discarded because their slot was needed by a newer request.
+             *
+             * @details     A non zero count means that the table is too small for the rate and timeout in use.
+             *
+             * @returns     the number of evicted requests.
+             */
+            auto evictions() const -> quint64;
+
+        private:
+            //! @cond
+
+            struct Slot {
+                std::atomic<uint64_t> state;
+                std::atomic<Nedrysoft::ICMPPingEngine::ICMPPingItem *> item;
+                std::atomic<qint64> timestamp;
+                std::atomic<qint64> deadline;
+            };
+
+            std::unique_ptr<Slot[]> m_slots;
+
+            Nedrysoft::ICMPPingEngine::ICMPPingItemPool *m_pool;
+
+            uint32_t m_generation;
+
+            std::atomic<uint16_t> m_headSequence;
+            uint16_t m_expirySequence;
+            qint64 m_nextDeadline;
+
+            std::atomic<int64_t> m_occupancy;
+            std::atomic<uint64_t> m_evictions;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGREQUESTTABLE_H
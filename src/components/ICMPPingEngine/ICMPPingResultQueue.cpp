@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingResultQueue.h"
+
+constexpr auto ResultQueueCapacity = 16384u;
+constexpr auto ResultQueueMask = ResultQueueCapacity-1;
+
+static_assert((ResultQueueCapacity & ResultQueueMask) == 0, "result queue capacity must be a power of 2");
+
+Nedrysoft::ICMPPingEngine::ICMPPingResultQueue::ICMPPingResultQueue() :
+        m_results(new Nedrysoft::RouteAnalyser::PingResult[ResultQueueCapacity]),
+        m_head(0),
+        m_tail(0) {
+
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingResultQueue::~ICMPPingResultQueue() = default;
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingResultQueue::push(const Nedrysoft::RouteAnalyser::PingResult &result) -> bool {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+
+    if ((tail - m_head.load(std::memory_order_acquire)) >= ResultQueueCapacity) {
+        return false;
+    }
+
+    m_results[tail & ResultQueueMask] = result;
+
+    m_tail.store(tail+1, std::memory_order_release);
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingResultQueue::drain() -> QVector<Nedrysoft::RouteAnalyser::PingResult> {
+    QVector<Nedrysoft::RouteAnalyser::PingResult> results;
+
+    auto head = m_head.load(std::memory_order_relaxed);
+    auto tail = m_tail.load(std::memory_order_acquire);
+
+    results.reserve(static_cast<int>(tail - head));
+
+    while (head != tail) {
+        auto &slot = m_results[head & ResultQueueMask];
+
+        results.append(slot);
+
+        // the slot is cleared so that it does not hold on to the result's shared data until it is reused.
+
+        slot = Nedrysoft::RouteAnalyser::PingResult();
+
+        head++;
+    }
+
+    m_head.store(head, std::memory_order_release);
+
+    return results;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingResultQueue::isEmpty() -> bool {
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRESULTQUEUE_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRESULTQUEUE_H
+
+#include <PingResult>
+#include <QVector>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       The ICMPPingResultQueue class passes results from the receiver thread to the engine's thread.
+     *
+     * @details     A fixed capacity single producer, single consumer ring buffer.  The producer and consumer each
+     *              own one of the indices, so neither side ever waits on the other; a result is published by
+     *              the release store of the tail index after it has been written to its slot.
+     *
+     *              Results are pushed by the receiver thread as replies and timeouts are processed, the owning
+     *              thread drains the queue in a single pass when it is notified that results are available.
+     */
+    class ICMPPingResultQueue {
+        public:
+            /**
+             * @brief       Constructs an empty ICMPPingResultQueue.
+             */
+            ICMPPingResultQueue();
+
+            /**
+             * @brief       Destroys the ICMPPingResultQueue.
+             */
+            ~ICMPPingResultQueue();
+
+            /**
+             * @brief       Adds a result to the queue.
+             *
+             * @note        This must only be called from the producer thread.
+             *
+             * @param[in]   result the result to add.
+             *
+             * @returns     true if the result was added; otherwise false if the queue is full.
+             */
+            auto push(const Nedrysoft::RouteAnalyser::PingResult &result) -> bool;
+
+            /**
+             * @brief       Removes all of the results currently in the queue.
+             *
+             * @note        This must only be called from the consumer thread.
+             *
+             * @returns     the results in the order they were pushed.
+             */
+            auto drain() -> QVector<Nedrysoft::RouteAnalyser::PingResult>;
+
+            /**
+             * @brief       Returns whether the queue is empty.
+             *
+             * @returns     true if there are no results waiting; otherwise false.
+             */
+            auto isEmpty() -> bool;
+
+        private:
+            //! @cond
+
+            std::unique_ptr<Nedrysoft::RouteAnalyser::PingResult[]> m_results;
+
+            std::atomic<uint32_t> m_head;
+            std::atomic<uint32_t> m_tail;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGRESULTQUEUE_H
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingScheduler.h"
+
+#include "ICMPPingShard.h"
+#include "ICMPPingTransmitter.h"
+
+#include <Clock>
+#include <PowerProfile>
+#include <Profiler>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+
+Nedrysoft::ICMPPingEngine::ICMPPingScheduler::ICMPPingScheduler(int shard) :
+        m_schedulerThread(nullptr),
+        m_activeTransmitter(nullptr),
+        m_shard(shard),
+        m_isRunning(true) {
+
+    m_clock.start();
+
+    // a virtual clock that is stepped wakes the scheduler so that the rounds that have become due are sent.
+
+    connect(Nedrysoft::Core::Clock::getInstance(), &Nedrysoft::Core::Clock::timeChanged, this, [this]() {
+        QMutexLocker locker(&m_scheduleMutex);
+
+        m_scheduleChanged.wakeAll();
+    }, Qt::DirectConnection);
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingScheduler::~ICMPPingScheduler() {
+    m_scheduleMutex.lock();
+
+    m_isRunning = false;
+
+    m_scheduleChanged.wakeAll();
+
+    m_scheduleMutex.unlock();
+
+    if (m_schedulerThread) {
+        m_schedulerThread->quit();
+        m_schedulerThread->wait();
+
+        delete m_schedulerThread;
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingScheduler::getInstance(
+        bool returnNull,
+        int shard ) -> Nedrysoft::ICMPPingEngine::ICMPPingScheduler * {
+
+    static Nedrysoft::ICMPPingEngine::ICMPPingScheduler *instances[ICMPPingShard::MaximumShards] = {};
+
+    auto &instance = instances[shard];
+
+    if (instance) {
+        return instance;
+    }
+
+    if (returnNull) {
+        return nullptr;
+    }
+
+    instance = new Nedrysoft::ICMPPingEngine::ICMPPingScheduler(shard);
+
+    instance->m_schedulerThread = new QThread;
+
+    instance->moveToThread(instance->m_schedulerThread);
+
+    connect(instance->m_schedulerThread, &QThread::started, instance, &Nedrysoft::ICMPPingEngine::ICMPPingScheduler::doWork);
+
+    instance->m_schedulerThread->start();
+
+    return instance;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingScheduler::addTransmitter(
+        Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter,
+        qint64 alignment) -> void {
+
+    QMutexLocker locker(&m_scheduleMutex);
+
+    if (m_transmitters.contains(transmitter)) {
+        return;
+    }
+
+    m_transmitters.insert(transmitter);
+
+    auto deadline = m_clock.nsecsElapsed();
+
+    if (alignment > 0) {
+        deadline = ((deadline / alignment) + 1) * alignment;
+    }
+
+    m_schedule.insert(deadline, transmitter);
+
+    m_scheduleChanged.wakeAll();
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingScheduler::removeTransmitter(
+        Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter) -> void {
+
+    QMutexLocker locker(&m_scheduleMutex);
+
+    m_transmitters.remove(transmitter);
+
+    auto it = m_schedule.begin();
+
+    while (it != m_schedule.end()) {
+        if (it.value() == transmitter) {
+            it = m_schedule.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    while (m_activeTransmitter == transmitter) {
+        m_transmitFinished.wait(&m_scheduleMutex);
+    }
+}
+
+void Nedrysoft::ICMPPingEngine::ICMPPingScheduler::doWork() {
+    // each shard's scheduler and receiver are given a core of their own, the scheduler takes the even core.
+
+    ICMPPingShard::pinThread(m_shard*2);
+
+    PINGNOO_PROFILE_THREAD("Ping scheduler");
+
+    m_scheduleMutex.lock();
+
+    while (m_isRunning) {
+        if (m_schedule.isEmpty()) {
+            m_scheduleChanged.wait(&m_scheduleMutex);
+
+            continue;
+        }
+
+        auto nextRound = m_schedule.begin();
+        auto deadline = nextRound.key();
+        auto currentTime = m_clock.nsecsElapsed();
+        auto wakeupSlack = Nedrysoft::RouteAnalyser::PowerProfile::wakeupSlack();
+
+        /**
+         * when saving power the rounds that are due within the slack of this wakeup are sent in it rather than
+         * each waking the thread.  The deadlines themselves are unchanged, so no round is skipped and the rounds
+         * keep their spacing.
+         */
+
+        if (deadline > currentTime + wakeupSlack) {
+            auto sleepTime = Nedrysoft::Core::Clock::getInstance()->realInterval(deadline - currentTime);
+
+            if (sleepTime < 0) {
+                m_scheduleChanged.wait(&m_scheduleMutex);
+
+                continue;
+            }
+
+            // unless saving power a precise deadline is used so that paced transmissions are not rounded to the
+            // coarse timer slack.
+
+            auto timerType = wakeupSlack ? Qt::CoarseTimer : Qt::PreciseTimer;
+
+            QDeadlineTimer deadlineTimer(timerType);
+
+            deadlineTimer.setPreciseRemainingTime(0, sleepTime, timerType);
+
+            m_scheduleChanged.wait(&m_scheduleMutex, deadlineTimer);
+
+            continue;
+        }
+
+        auto transmitter = nextRound.value();
+
+        m_schedule.erase(nextRound);
+
+        m_activeTransmitter = transmitter;
+
+        m_scheduleMutex.unlock();
+
+        auto nextDeadline = transmitter->transmit(deadline, m_clock.nsecsElapsed());
+
+        PINGNOO_PROFILE_LOCK("Wait for the schedule mutex", m_scheduleMutex);
+
+        m_activeTransmitter = nullptr;
+
+        m_transmitFinished.wakeAll();
+
+        // the transmitter may have been removed while it was sending, in which case it is not requeued.
+
+        if (m_isRunning && m_transmitters.contains(transmitter)) {
+            m_schedule.insert(nextDeadline, transmitter);
+        }
+    }
+
+    m_scheduleMutex.unlock();
+}
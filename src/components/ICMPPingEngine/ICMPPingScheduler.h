@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSCHEDULER_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSCHEDULER_H
+
+#include <ElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+
+class ICMPPingComponent;
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    class ICMPPingTransmitter;
+
+    /**
+     * @brief       The ICMPPingScheduler class transmits the ping rounds of every engine from a single thread.
+     *
+     * @details     This is a singleton class, each running engine registers its transmitter and the scheduler
+     *              keeps a queue of transmitters ordered by the time their next transmission is due.  The
+     *              scheduler thread sleeps until the earliest deadline, lets that transmitter send and then requeues
+     *              it at the deadline it returns, so the number of threads is constant regardless of the number of
+     *              engines.  Deadlines are held in nanoseconds and waited on with a precise timer.
+     *
+     *              When the engines are sharded there is one scheduler per shard, see ICMPPingShard.
+     */
+    class ICMPPingScheduler :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs a ICMPPingScheduler.
+             *
+             * @note        Hidden as this is a singleton class and should be accessed through getInstance().
+             *
+             * @param[in]   shard the shard that the scheduler serves.
+             */
+            ICMPPingScheduler(int shard);
+
+            /**
+             * @brief       Destroys the ICMPPingScheduler.
+             */
+            ~ICMPPingScheduler();
+
+        public:
+            /**
+             * @brief       Returns the ICMPPingScheduler singleton instance for a shard.
+             *
+             * @param[in]   returnNull if the singleton has not been allocated, then return null if true.
+             * @param[in]   shard the shard.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance(
+                bool returnNull=false,
+                int shard=0 ) -> Nedrysoft::ICMPPingEngine::ICMPPingScheduler *;
+
+            /**
+             * @brief       Adds a transmitter to the schedule.
+             *
+             * @details     The first round is sent immediately unless an alignment is given, in which case it is
+             *              sent at the next multiple of the alignment on the scheduler's clock.  Transmitters that
+             *              are aligned to the same interval therefore send their rounds together.
+             *
+             * @param[in]   transmitter the transmitter.
+             * @param[in]   alignment the alignment of the first round in nanoseconds, 0 to send immediately.
+             */
+            auto addTransmitter(
+                Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter,
+                qint64 alignment = 0
+            ) -> void;
+
+            /**
+             * @brief       Removes a transmitter from the schedule.
+             *
+             * @details     If the transmitter is currently sending a round then this waits for it to complete,
+             *              once this returns the scheduler will no longer access the transmitter.
+             *
+             * @param[in]   transmitter the transmitter.
+             */
+            auto removeTransmitter(Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *transmitter) -> void;
+
+            friend class ::ICMPPingComponent;
+
+        private:
+            /**
+             * @brief       The scheduler thread worker.
+             */
+            Q_SLOT void doWork();
+
+        private:
+            //! @cond
+
+            QThread *m_schedulerThread;
+
+            QMultiMap<qint64, Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *> m_schedule;
+            QSet<Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *> m_transmitters;
+            Nedrysoft::ICMPPingEngine::ICMPPingTransmitter *m_activeTransmitter;
+
+            QMutex m_scheduleMutex;
+            QWaitCondition m_scheduleChanged;
+            QWaitCondition m_transmitFinished;
+
+            Nedrysoft::Core::ElapsedTimer m_clock;
+
+            int m_shard;
+
+            bool m_isRunning;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSCHEDULER_H
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingSequenceMap.h"
+
+constexpr auto SequenceMapWords = 65536/64;
+
+/**
+ * @brief       Returns the bit of a sequence number within its bitmap word.
+ *
+ * @param[in]   sequence the sequence number.
+ *
+ * @returns     the bit mask.
+ */
+static constexpr auto sequenceBit(uint16_t sequence) -> uint64_t {
+    return 1ull << (sequence % 64);
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::ICMPPingSequenceMap() :
+        m_answered(new std::atomic<uint64_t>[SequenceMapWords]),
+        m_expired(new std::atomic<uint64_t>[SequenceMapWords]) {
+
+    for (auto word = 0; word < SequenceMapWords; word++) {
+        m_answered[word].store(0, std::memory_order_relaxed);
+        m_expired[word].store(0, std::memory_order_relaxed);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::transmitted(uint16_t sequence) -> void {
+    m_answered[sequence / 64].fetch_and(~sequenceBit(sequence), std::memory_order_relaxed);
+    m_expired[sequence / 64].fetch_and(~sequenceBit(sequence), std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::answered(uint16_t sequence) -> void {
+    m_answered[sequence / 64].fetch_or(sequenceBit(sequence), std::memory_order_acq_rel);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::expired(uint16_t sequence) -> void {
+    m_expired[sequence / 64].fetch_or(sequenceBit(sequence), std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingSequenceMap::classify(uint16_t sequence) -> Arrival {
+    auto previous = m_answered[sequence / 64].fetch_or(sequenceBit(sequence), std::memory_order_acq_rel);
+
+    if (previous & sequenceBit(sequence)) {
+        return Arrival::Duplicate;
+    }
+
+    if (m_expired[sequence / 64].load(std::memory_order_acquire) & sequenceBit(sequence)) {
+        return Arrival::Late;
+    }
+
+    // neither answered nor expired, the request was evicted or was never ours, so the bit is put back.
+
+    m_answered[sequence / 64].fetch_and(~sequenceBit(sequence), std::memory_order_relaxed);
+
+    return Arrival::Unmatched;
+}
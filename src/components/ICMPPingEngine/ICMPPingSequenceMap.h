@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSEQUENCEMAP_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSEQUENCEMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       The ICMPPingSequenceMap class records what has happened to each sequence number of an engine.
+     *
+     * @details     Two bitmaps cover the whole 16 bit sequence space, one marks the sequences that have been
+     *              answered and the other the sequences whose request timed out.  Once a request has left the
+     *              request table a reply for it can still be accounted for, a second reply to an answered
+     *              sequence is a duplicate and the first reply to a timed out sequence arrived late.
+     *
+     *              The bits are set with a single atomic or, so the receiver and the timeout sweep never wait on
+     *              each other.  The bits of a sequence are cleared when it is transmitted again after the sequence
+     *              wraps.
+     */
+    class ICMPPingSequenceMap {
+        public:
+            /**
+             * @brief       How a reply that did not match an outstanding request was accounted for.
+             */
+            enum class Arrival {
+                Unmatched,              //!< the sequence was neither answered nor timed out.
+                Duplicate,              //!< the sequence had already been answered.
+                Late                    //!< the request timed out before the reply arrived.
+            };
+
+            /**
+             * @brief       Constructs an ICMPPingSequenceMap with no sequences recorded.
+             */
+            ICMPPingSequenceMap();
+
+            /**
+             * @brief       Clears anything recorded for a sequence number from a previous wrap.
+             *
+             * @param[in]   sequence the sequence number of the request being sent.
+             */
+            auto transmitted(uint16_t sequence) -> void;
+
+            /**
+             * @brief       Records that the request for a sequence number was answered.
+             *
+             * @param[in]   sequence the sequence number of the reply.
+             */
+            auto answered(uint16_t sequence) -> void;
+
+            /**
+             * @brief       Records that the request for a sequence number timed out.
+             *
+             * @param[in]   sequence the sequence number of the request.
+             */
+            auto expired(uint16_t sequence) -> void;
+
+            /**
+             * @brief       Accounts for a reply that did not match an outstanding request.
+             *
+             * @details     The sequence is marked as answered, so only the first reply after a timeout is late and
+             *              any further copies are duplicates.
+             *
+             * @param[in]   sequence the sequence number of the reply.
+             *
+             * @returns     how the reply was accounted for.
+             */
+            auto classify(uint16_t sequence) -> Arrival;
+
+        private:
+            //! @cond
+
+            std::unique_ptr<std::atomic<uint64_t>[]> m_answered;
+            std::unique_ptr<std::atomic<uint64_t>[]> m_expired;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSEQUENCEMAP_H
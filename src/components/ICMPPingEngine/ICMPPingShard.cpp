@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ICMPPingShard.h"
+
+#include "ICMPSocket/ICMPSocket.h"
+
+#include <QThread>
+#include <QtGlobal>
+#include <atomic>
+
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+constexpr auto ShardsEnvironmentVariable = "PINGNOO_SHARDS";
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingShard::count() -> int {
+    static const int shardCount = []() {
+        if ((Nedrysoft::ICMPSocket::ICMPSocket::simulator()) ||
+            (Nedrysoft::ICMPSocket::ICMPSocket::usesDatagramSockets())) {
+
+            return 1;
+        }
+
+        auto requestedCount = qEnvironmentVariableIntValue(ShardsEnvironmentVariable);
+
+        return qBound(1, qMin(requestedCount, QThread::idealThreadCount()), MaximumShards);
+    }();
+
+    return shardCount;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingShard::next() -> int {
+    static std::atomic<unsigned int> nextShard(0);
+
+    return static_cast<int>(nextShard.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned int>(count()));
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingShard::pinThread(int core) -> void {
+    if (count() <= 1) {
+        return;
+    }
+
+#if defined(Q_OS_LINUX)
+    cpu_set_t cpuSet;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core % QThread::idealThreadCount(), &cpuSet);
+
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#else
+    Q_UNUSED(core)
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSHARD_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSHARD_H
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       The ICMPPingShard class decides how many scheduler and receiver threads the engines are spread
+     *              across.
+     *
+     * @details     By default there is a single shard, every engine transmits from the one scheduler thread and
+     *              every reply is read by the one receiver thread.  Setting PINGNOO_SHARDS to a number greater
+     *              than one creates that many scheduler and receiver pairs, each pinned to its own cores with its
+     *              own read sockets, and engines are assigned to them in turn.  An engine keeps its request table,
+     *              statistics and targets, so each shard runs independently of the others.
+     *
+     *              Only raw sockets can be sharded, the replies to a datagram socket can only be read from the
+     *              socket that sent the request, so there is a single shard when datagram sockets or the
+     *              simulator are in use.
+     */
+    class ICMPPingShard {
+        public:
+            /**
+             * @brief       The largest number of shards that may be configured.
+             */
+            static constexpr int MaximumShards = 16;
+
+            /**
+             * @brief       Returns the number of shards.
+             *
+             * @details     The count is read from the environment the first time this is called and does not
+             *              change afterwards, it is limited to the number of cores.
+             *
+             * @returns     the number of shards.
+             */
+            static auto count() -> int;
+
+            /**
+             * @brief       Returns the shard that the next engine should be assigned to.
+             *
+             * @returns     the shard index.
+             */
+            static auto next() -> int;
+
+            /**
+             * @brief       Pins the calling thread to a core.
+             *
+             * @details     Nothing is done unless there is more than one shard, or on platforms other than Linux.
+             *
+             * @param[in]   core the core, which wraps around the number of cores.
+             */
+            static auto pinThread(int core) -> void;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGSHARD_H
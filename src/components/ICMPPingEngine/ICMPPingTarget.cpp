@@ -23,11 +23,23 @@
 
 #include "ICMPPingTarget.h"
 #include "ICMPPingEngine.h"
+#include "ICMPPingIdentifierTable.h"
+#include "ICMPPacket/ICMPPacketTemplate.h"
+#include "ICMPPacket/ProbePacketTemplate.h"
 #include "ICMPSocket/ICMPSocket.h"
 
 #include <QHostAddress>
+#include <atomic>
 #include <cassert>
 
+constexpr auto DefaultPayloadSize = 52;
+constexpr auto ProbeSourcePortBase = 0x8000;
+constexpr auto ProbeSourcePortMask = 0x7fff;
+constexpr auto SmoothingDivisor = 8;
+constexpr auto DeviationDivisor = 4;
+constexpr auto DeviationMultiplier = 4;
+constexpr auto MaximumTimeoutBackoff = 6;
+
 /**
  * @brief       Private class to store the ping targets instance data.
  */
@@ -41,11 +53,62 @@ class Nedrysoft::ICMPPingEngine::ICMPPingTargetData {
         ICMPPingTargetData(Nedrysoft::ICMPPingEngine::ICMPPingTarget *parent) :
                 m_pingTarget(parent),
                 m_engine(nullptr),
-                m_socket(nullptr),
                 m_userData(nullptr),
                 m_ttl(0),
-                m_id(Nedrysoft::Core::ICore::getInstance()->random(1.0, UINT16_MAX-1)) {
+                m_payloadSize(DefaultPayloadSize),
+                m_removed(false),
+                m_probeBackoff(1),
+                m_samplingDivisor(1),
+                m_smoothedRoundTripTime(-1),
+                m_roundTripTimeDeviation(0),
+                m_timeoutBackoff(0),
+                m_highestSequence(0),
+                m_sequenceReceived(false),
+                m_id(0),
+                m_protocol(Nedrysoft::ICMPPingEngine::Protocol::ICMP),
+                m_destinationPort(0),
+                m_flowChecksum(-1) {
+
+        }
+
+        /**
+         * @brief       Rebuilds the echo request or probe template for the current host address.
+         */
+        auto updatePacketTemplate() -> void {
+            auto version = Nedrysoft::ICMPPacket::Unknown;
+
+            m_socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(m_hostAddress);
+
+            if (m_hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+                version = Nedrysoft::ICMPPacket::V4;
+            } else if (m_hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+                version = Nedrysoft::ICMPPacket::V6;
+            }
+
+            if (m_protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+                // the id is used as the source port, so together with the destination port it forms the flow.
+
+                m_probeTemplate = Nedrysoft::ICMPPacket::ProbePacketTemplate(
+                    static_cast<Nedrysoft::ICMPPacket::Protocol>(m_protocol),
+                    m_id,
+                    m_destinationPort,
+                    m_payloadSize,
+                    Nedrysoft::ICMPSocket::ICMPSocket::sourceAddress(m_hostAddress, m_source),
+                    m_hostAddress,
+                    version
+                );
+
+                return;
+            }
 
+            m_packetTemplate = Nedrysoft::ICMPPacket::ICMPPacketTemplate(
+                m_id,
+                m_payloadSize,
+                m_hostAddress,
+                version
+            );
+
+            m_packetTemplate.setFlowChecksum(m_flowChecksum);
         }
 
         friend class ICMPPingTarget;
@@ -54,11 +117,30 @@ class Nedrysoft::ICMPPingEngine::ICMPPingTargetData {
         Nedrysoft::ICMPPingEngine::ICMPPingTarget *m_pingTarget;
 
         QHostAddress m_hostAddress;
+        Nedrysoft::ICMPSocket::SocketAddress m_socketAddress;
         Nedrysoft::ICMPPingEngine::ICMPPingEngine *m_engine;
-        Nedrysoft::ICMPSocket::ICMPSocket *m_socket;
         uint16_t m_id;
         void *m_userData;
         int m_ttl;
+        int m_payloadSize;
+        std::atomic<bool> m_removed;
+        std::atomic<int> m_probeBackoff;
+        std::atomic<int> m_samplingDivisor;
+
+        std::atomic<qint64> m_smoothedRoundTripTime;
+        std::atomic<qint64> m_roundTripTimeDeviation;
+        std::atomic<int> m_timeoutBackoff;
+
+        uint16_t m_highestSequence;
+        bool m_sequenceReceived;
+
+        Nedrysoft::ICMPPingEngine::Protocol m_protocol;
+        uint16_t m_destinationPort;
+        int m_flowChecksum;
+        QString m_source;
+
+        Nedrysoft::ICMPPacket::ICMPPacketTemplate m_packetTemplate;
+        Nedrysoft::ICMPPacket::ProbePacketTemplate m_probeTemplate;
 };
 
 Nedrysoft::ICMPPingEngine::ICMPPingTarget::ICMPPingTarget(
@@ -71,11 +153,55 @@ Nedrysoft::ICMPPingEngine::ICMPPingTarget::ICMPPingTarget(
     d->m_hostAddress = std::move(hostAddress);
     d->m_engine = engine;
     d->m_ttl = ttl;
+
+    if (engine) {
+        d->m_source = engine->source();
+        d->m_payloadSize = engine->payloadSize();
+        d->m_protocol = engine->protocol();
+        d->m_destinationPort = engine->destinationPort();
+    }
+
+    auto isProbe = (d->m_protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP);
+
+    if ((engine) && (engine->flowStable())) {
+        // every target of a flow stable engine is probed on the engine's flow, ICMP targets keep their own id as
+        // it is not part of the flow.
+
+        if (!isProbe) {
+            d->m_flowChecksum = engine->flowIdentifier();
+        }
+    }
+
+    if (!engine) {
+        d->m_id = static_cast<uint16_t>(Nedrysoft::Core::ICore::getInstance()->random(1, UINT16_MAX-1));
+
+        if (isProbe) {
+            d->m_id |= ProbeSourcePortBase;
+        }
+    } else if ((isProbe) && (engine->flowStable())) {
+        d->m_id = ProbeSourcePortBase | (engine->flowIdentifier() & ProbeSourcePortMask);
+
+        Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->claim(engine, d->m_id);
+    } else if (isProbe) {
+        d->m_id = Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->allocate(
+            engine,
+            ProbeSourcePortBase,
+            UINT16_MAX
+        );
+    } else {
+        d->m_id = Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->allocate(
+            engine,
+            1,
+            UINT16_MAX-1
+        );
+    }
+
+    d->updatePacketTemplate();
 }
 
 Nedrysoft::ICMPPingEngine::ICMPPingTarget::~ICMPPingTarget() {
-    if (d->m_socket) {
-        delete d->m_socket;
+    if (d->m_engine) {
+        Nedrysoft::ICMPPingEngine::ICMPPingIdentifierTable::getInstance()->release(d->m_engine, d->m_id);
     }
 
     d.reset();
@@ -83,40 +209,147 @@ Nedrysoft::ICMPPingEngine::ICMPPingTarget::~ICMPPingTarget() {
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::setHostAddress(QHostAddress hostAddress) -> void {
     d->m_hostAddress = hostAddress;
+
+    d->updatePacketTemplate();
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::hostAddress() -> QHostAddress {
     return d->m_hostAddress;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::socketAddress() -> const Nedrysoft::ICMPSocket::SocketAddress & {
+    return d->m_socketAddress;
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::engine() -> Nedrysoft::RouteAnalyser::IPingEngine * {
     return d->m_engine;
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::socket() -> Nedrysoft::ICMPSocket::ICMPSocket * {
-    if (d->m_socket==nullptr) {
-        if (d->m_hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
-            d->m_socket = Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
-                    d->m_ttl,
-                    Nedrysoft::ICMPSocket::V4 );
-        } else if (d->m_hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
-            d->m_socket = Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
-                    d->m_ttl,
-                    Nedrysoft::ICMPSocket::V6);
-        }
+    auto dontFragment = d->m_engine ? d->m_engine->dontFragment() : false;
+
+    auto protocol = static_cast<Nedrysoft::ICMPSocket::Protocol>(d->m_protocol);
+    auto version = Nedrysoft::ICMPSocket::V4;
+
+    if (d->m_hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        version = Nedrysoft::ICMPSocket::V6;
+    } else if (d->m_hostAddress.protocol() != QAbstractSocket::IPv4Protocol) {
+        return nullptr;
     }
 
-    return d->m_socket;
+    return Nedrysoft::ICMPSocket::ICMPSocket::sharedProbeSocket(protocol, version, dontFragment, d->m_source);
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::id() -> uint16_t {
     return d->m_id;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::pingPacket(uint16_t sequence) -> QByteArray {
+    if (d->m_protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+        return d->m_probeTemplate.packet(sequence);
+    }
+
+    return d->m_packetTemplate.packet(d->m_id, sequence);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::pingPacket(
+        uint16_t sequence,
+        qint64 timestamp,
+        uint32_t sampleNumber) -> QByteArray {
+
+    // routers only quote the transport header of a probe, so a timestamp in the payload would never be seen.
+
+    if (d->m_protocol != Nedrysoft::ICMPPingEngine::Protocol::ICMP) {
+        return d->m_probeTemplate.packet(sequence);
+    }
+
+    return d->m_packetTemplate.packet(d->m_id, sequence, timestamp, sampleNumber);
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::ttl() -> uint16_t {
     return d->m_ttl;
 }
 
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::setPayloadSize(int payloadSize) -> void {
+    d->m_payloadSize = payloadSize;
+
+    d->updatePacketTemplate();
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::payloadSize() -> int {
+    return d->m_payloadSize;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::probeBackoff() -> int {
+    return d->m_probeBackoff.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::setSamplingDivisor(int divisor) -> void {
+    d->m_samplingDivisor.store(qMax(divisor, 1), std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::roundsPerProbe() -> int {
+    return d->m_samplingDivisor.load(std::memory_order_relaxed) * d->m_probeBackoff.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::addRoundTripTime(qint64 roundTripTime) -> void {
+    if (roundTripTime < 0) {
+        return;
+    }
+
+    auto smoothedRoundTripTime = d->m_smoothedRoundTripTime.load(std::memory_order_relaxed);
+    auto roundTripTimeDeviation = d->m_roundTripTimeDeviation.load(std::memory_order_relaxed);
+
+    if (smoothedRoundTripTime < 0) {
+        smoothedRoundTripTime = roundTripTime;
+        roundTripTimeDeviation = roundTripTime / 2;
+    } else {
+        // the deviation is updated first as it is measured against the previous estimate.
+
+        roundTripTimeDeviation += (qAbs(roundTripTime - smoothedRoundTripTime) - roundTripTimeDeviation) /
+                                  DeviationDivisor;
+
+        smoothedRoundTripTime += (roundTripTime - smoothedRoundTripTime) / SmoothingDivisor;
+    }
+
+    d->m_roundTripTimeDeviation.store(roundTripTimeDeviation, std::memory_order_relaxed);
+    d->m_smoothedRoundTripTime.store(smoothedRoundTripTime, std::memory_order_relaxed);
+    d->m_timeoutBackoff.store(0, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::addSequence(uint16_t sequence) -> bool {
+    // the difference is taken as signed so that the comparison holds across the sequence wrapping.
+
+    if ((d->m_sequenceReceived) && (static_cast<int16_t>(sequence-d->m_highestSequence) < 0)) {
+        return false;
+    }
+
+    d->m_highestSequence = sequence;
+    d->m_sequenceReceived = true;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::backoffTimeout() -> void {
+    auto backoff = d->m_timeoutBackoff.load(std::memory_order_relaxed);
+
+    if (backoff < MaximumTimeoutBackoff) {
+        d->m_timeoutBackoff.store(backoff + 1, std::memory_order_relaxed);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::retransmitTimeout(qint64 initialTimeout) -> qint64 {
+    auto smoothedRoundTripTime = d->m_smoothedRoundTripTime.load(std::memory_order_relaxed);
+    auto timeout = initialTimeout;
+
+    if (smoothedRoundTripTime >= 0) {
+        timeout = smoothedRoundTripTime +
+                  DeviationMultiplier * d->m_roundTripTimeDeviation.load(std::memory_order_relaxed);
+    }
+
+    return timeout << d->m_timeoutBackoff.load(std::memory_order_relaxed);
+}
+
 auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::userData() -> void * {
     return d->m_userData;
 }
@@ -134,3 +367,15 @@ auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::loadConfiguration(QJsonObject co
 
     return false;
 }
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::setRemoved() -> void {
+    d->m_removed.store(true, std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::isRemoved() -> bool {
+    return d->m_removed.load(std::memory_order_acquire);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTarget::setProbeBackoff(int backoff) -> void {
+    d->m_probeBackoff.store(qMax(backoff, 1), std::memory_order_relaxed);
+}
@@ -26,6 +26,8 @@
 
 #include <IPingTarget>
 
+#include <QByteArray>
+
 #if defined(Q_OS_WIN)
 #include <WS2tcpip.h>
 #include <WinSock2.h>
@@ -34,6 +36,7 @@
 
 namespace Nedrysoft { namespace ICMPSocket {
     class ICMPSocket;
+    struct SocketAddress;
 }}
 
 namespace Nedrysoft { namespace ICMPPingEngine {
@@ -87,6 +90,16 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto hostAddress() -> QHostAddress override;
 
+            /**
+             * @brief       Returns the host address in the compact form that the socket sends to.
+             *
+             * @details     The address is converted once when the host address is set, so that sending does not
+             *              convert it for every packet.
+             *
+             * @returns     the socket address of the target.
+             */
+            auto socketAddress() -> const Nedrysoft::ICMPSocket::SocketAddress &;
+
             /**
              * @brief       Returns the Nedrysoft::RouteAnalyser::IPingEngine that created this target.
              *
@@ -123,6 +136,42 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto ttl() -> uint16_t override;
 
+            /**
+             * @brief       Sets the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            auto setPayloadSize(int payloadSize) -> void override;
+
+            /**
+             * @brief       Returns the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Returns how many sample rounds the engine has backed this target off by.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::probeBackoff
+             *
+             * @returns     1 if the target is sent in every round; otherwise the target is sent once every n rounds.
+             */
+            auto probeBackoff() -> int override;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setSamplingDivisor
+             *
+             * @param[in]   divisor the target is sent once every divisor rounds.
+             */
+            auto setSamplingDivisor(int divisor) -> void override;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
@@ -145,6 +194,9 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             /**
              * @brief       Returns socket to be used to send ICMP packets.
              *
+             * @note        The socket is shared between all targets of the same address family, the TTL of the
+             *              target is applied to each datagram as it is sent.
+             *
              * @returns     the socket.
              */
             auto socket() -> Nedrysoft::ICMPSocket::ICMPSocket *;
@@ -156,6 +208,109 @@ namespace Nedrysoft { namespace ICMPPingEngine {
              */
             auto id() -> uint16_t;
 
+            /**
+             * @brief       Returns an echo request (or UDP/TCP probe) for this target.
+             *
+             * @details     The packet is generated from a template that is built when the host address is set, only
+             *              the sequence is stamped in and the checksum adjusted.
+             *
+             * @param[in]   sequence the sequence id of the request.
+             *
+             * @returns     the raw packet.
+             */
+            auto pingPacket(uint16_t sequence) -> QByteArray;
+
+            /**
+             * @brief       Returns an echo request for this target with an embedded transmit timestamp.
+             *
+             * @note        Probes are returned without a timestamp as routers only quote their transport header.
+             *
+             * @param[in]   sequence the sequence id of the request.
+             * @param[in]   timestamp the transmit timestamp in nanoseconds.
+             * @param[in]   sampleNumber the sample number of the request.
+             *
+             * @returns     the raw packet.
+             */
+            auto pingPacket(uint16_t sequence, qint64 timestamp, uint32_t sampleNumber) -> QByteArray;
+
+            /**
+             * @brief       Marks the target as removed from the engine.
+             *
+             * @details     A removed target is kept alive until any requests that are still in flight for it have
+             *              timed out, but no further results are reported for it.
+             */
+            auto setRemoved() -> void;
+
+            /**
+             * @brief       Returns whether the target has been removed from the engine.
+             *
+             * @returns     true if removed; otherwise false.
+             */
+            auto isRemoved() -> bool;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @param[in]   backoff the target is sent once every backoff rounds.
+             */
+            auto setProbeBackoff(int backoff) -> void;
+
+            /**
+             * @brief       Returns how many sample rounds pass between each probe of this target.
+             *
+             * @details     Combines the sampling divisor chosen by the caller with the engine's own back off.
+             *
+             * @returns     the target is sent once every this number of rounds.
+             */
+            auto roundsPerProbe() -> int;
+
+            /**
+             * @brief       Updates the round trip time estimate of this target with a new sample.
+             *
+             * @details     The smoothed round trip time and its mean deviation are maintained in the same way as
+             *              a TCP retransmission timer (RFC 6298), and any back off from earlier timeouts is cleared.
+             *
+             * @note        This must only be called from the receive thread.
+             *
+             * @param[in]   roundTripTime the round trip time of a reply in nanoseconds.
+             */
+            auto addRoundTripTime(qint64 roundTripTime) -> void;
+
+            /**
+             * @brief       Doubles the timeout of this target after a request has timed out.
+             *
+             * @note        This must only be called from the receive thread.
+             */
+            auto backoffTimeout() -> void;
+
+            /**
+             * @brief       Records the sequence number of a reply to this target.
+             *
+             * @details     Sequence numbers are allocated in transmit order, so a reply with a sequence number older
+             *              than one already received for this target has been reordered on the way back.
+             *
+             * @note        This must only be called from the receive thread.
+             *
+             * @param[in]   sequence the sequence number of the reply.
+             *
+             * @returns     true if the reply arrived in order; otherwise false.
+             */
+            auto addSequence(uint16_t sequence) -> bool;
+
+            /**
+             * @brief       Returns the timeout for the next request sent to this target.
+             *
+             * @details     The timeout is the smoothed round trip time plus four times its mean deviation, scaled
+             *              by any back off.  The caller is responsible for bounding the result.
+             *
+             * @param[in]   initialTimeout the timeout in nanoseconds used until a reply has been received.
+             *
+             * @returns     the timeout in nanoseconds.
+             */
+            auto retransmitTimeout(qint64 initialTimeout) -> qint64;
+
+            friend class ICMPPingEngine;
+            friend class ICMPPingRateLimitDetector;
             friend class ICMPPingTransmitter;
 
         protected:
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPingTraceLog.h"
+
+#include <QHostAddress>
+#include <QString>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+constexpr auto TraceEnvironmentVariable = "PINGNOO_TRACE";
+constexpr auto RingCapacity = 8192u;
+constexpr auto RingMask = RingCapacity-1;
+constexpr auto LoggerInterval = std::chrono::milliseconds(20);
+
+static_assert((RingCapacity & RingMask) == 0, "trace ring capacity must be a power of 2");
+
+namespace {
+    /**
+     * @brief       The level and format of an event, the format is given the address and then the arguments.
+     */
+    struct EventFormat {
+        spdlog::level::level_enum level;
+        const char *format;
+        int placeholders;
+    };
+
+    /**
+     * @brief       The formats of the events, indexed by event id.
+     */
+    constexpr EventFormat EventFormats[] = {
+        {spdlog::level::trace, "Preparing ping set to %1 (targets=%2, sample=%3)", 3},
+        {spdlog::level::trace, "Sent ping to %1 (TTL=%2, Result=%3)", 3},
+        {spdlog::level::err, "Unable to send packet to %1 (TTL=%2, Result=%3)", 3},
+        {spdlog::level::trace, "ICMP packet received from %1 (length=%2)", 2},
+        {spdlog::level::warn, "Result queue is full, ping result discarded.", 0}
+    };
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::ICMPPingTraceLog() :
+        m_records(new Record[RingCapacity]),
+        m_enqueuePosition(0),
+        m_dequeuePosition(0),
+        m_dropped(0),
+        m_isRunning(false) {
+
+    if (qgetenv(TraceEnvironmentVariable).isEmpty()) {
+        return;
+    }
+
+    for (auto index = 0u; index < RingCapacity; index++) {
+        m_records[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    m_isRunning = true;
+
+    m_loggingThread = std::thread([this]() {
+        logEvents();
+    });
+}
+
+Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::~ICMPPingTraceLog() {
+    if (!m_loggingThread.joinable()) {
+        return;
+    }
+
+    m_isRunning = false;
+
+    m_loggingThread.join();
+
+    auto dropped = m_dropped.load();
+
+    if (dropped) {
+        spdlog::warn("{} trace events were dropped as the trace log fell behind.", dropped);
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingTraceLog * {
+    static ICMPPingTraceLog traceLog;
+
+    return traceLog.m_isRunning ? &traceLog : nullptr;
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::log(
+        Event event,
+        const Nedrysoft::ICMPSocket::SocketAddress &address,
+        qint64 firstArgument,
+        qint64 secondArgument) -> void {
+
+    auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Record *record;
+
+    while (true) {
+        record = &m_records[position & RingMask];
+
+        auto sequence = record->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - position);
+
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // the logging thread has not yet released this slot, so the ring is full.
+
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    record->event = event;
+    record->address = address;
+    record->arguments[0] = firstArgument;
+    record->arguments[1] = secondArgument;
+
+    record->sequence.store(position+1, std::memory_order_release);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::logEvents() -> void {
+    while (true) {
+        auto isRunning = m_isRunning.load(std::memory_order_acquire);
+        auto logged = 0;
+
+        while (true) {
+            auto &record = m_records[m_dequeuePosition & RingMask];
+
+            if (record.sequence.load(std::memory_order_acquire) != m_dequeuePosition+1) {
+                break;
+            }
+
+            logRecord(record);
+
+            record.sequence.store(m_dequeuePosition+RingCapacity, std::memory_order_release);
+
+            m_dequeuePosition++;
+
+            logged++;
+        }
+
+        if (!isRunning) {
+            break;
+        }
+
+        if (!logged) {
+            std::this_thread::sleep_for(LoggerInterval);
+        }
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::logRecord(const Record &record) -> void {
+    auto logger = spdlog::default_logger_raw();
+    auto &eventFormat = EventFormats[static_cast<int>(record.event)];
+
+    if ((!logger) || (!logger->should_log(eventFormat.level))) {
+        return;
+    }
+
+    auto text = QString(eventFormat.format);
+
+    if (eventFormat.placeholders>0) {
+        text = text.arg(record.address.isNull() ? QString() : record.address.toHostAddress().toString());
+    }
+
+    for (auto index = 1; index < eventFormat.placeholders; index++) {
+        text = text.arg(record.arguments[index-1]);
+    }
+
+    // the event is logged with the time that it occurred rather than the time that it was formatted.
+
+    auto logTime = spdlog::log_clock::time_point(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(record.timestamp)) );
+
+    logger->log(logTime, spdlog::source_loc(), eventFormat.level, text.toStdString());
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGTRACELOG_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGTRACELOG_H
+
+#include "ICMPSocket/ICMPSocket.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       The ICMPPingTraceLog class logs the events of the send and receive paths asynchronously.
+     *
+     * @details     The trace log is enabled by setting the PINGNOO_TRACE environment variable.  A thread that logs
+     *              an event only stores its id, timestamp, address and integer arguments in a slot of a fixed size
+     *              multiple producer ring and returns, no strings are built or allocated.  A background thread
+     *              formats the queued events and passes them to the default spdlog logger with the time that the
+     *              event occurred.  If the background thread falls behind then events are dropped rather than
+     *              delaying a probe, the number dropped is logged when the trace log is destroyed.
+     */
+    class ICMPPingTraceLog {
+        public:
+            /**
+             * @brief       The events that can be logged.
+             */
+            enum class Event : uint8_t {
+                PreparingRound,         //!< a round is about to be sent, arguments: targets, sample number.
+                Sent,                   //!< a request was sent, arguments: ttl, result.
+                SendFailed,             //!< a request could not be sent, arguments: ttl, result.
+                Received,               //!< a packet was received, arguments: length.
+                ResultDiscarded         //!< the result queue was full and a result was discarded.
+            };
+
+        private:
+            /**
+             * @brief       Constructs the ICMPPingTraceLog and starts the background thread if it is enabled.
+             */
+            ICMPPingTraceLog();
+
+        public:
+            /**
+             * @brief       Destroys the ICMPPingTraceLog, the events that have been queued are logged first.
+             */
+            ~ICMPPingTraceLog();
+
+            /**
+             * @brief       Returns the ICMPPingTraceLog instance if the trace log is enabled.
+             *
+             * @returns     the trace log; otherwise nullptr if the trace log is not enabled.
+             */
+            static auto getInstance() -> Nedrysoft::ICMPPingEngine::ICMPPingTraceLog *;
+
+            /**
+             * @brief       Queues an event to be logged.
+             *
+             * @note        May be called from any thread.
+             *
+             * @param[in]   event the event.
+             * @param[in]   address the address that the event relates to.
+             * @param[in]   firstArgument the first argument of the event.
+             * @param[in]   secondArgument the second argument of the event.
+             */
+            auto log(
+                Event event,
+                const Nedrysoft::ICMPSocket::SocketAddress &address = Nedrysoft::ICMPSocket::SocketAddress(),
+                qint64 firstArgument = 0,
+                qint64 secondArgument = 0
+            ) -> void;
+
+        private:
+            /**
+             * @brief       A slot in the ring.
+             *
+             * @details     The sequence of a slot tells the producers and the consumer whose turn it is, a slot
+             *              is free for the producer that claims position p when its sequence is p and is ready for
+             *              the consumer when its sequence is p+1.
+             */
+            struct Record {
+                std::atomic<uint64_t> sequence;
+                qint64 timestamp;
+                Event event;
+                Nedrysoft::ICMPSocket::SocketAddress address;
+                qint64 arguments[2];
+            };
+
+            /**
+             * @brief       The logging thread, logs the queued events until the trace log is destroyed.
+             */
+            auto logEvents() -> void;
+
+            /**
+             * @brief       Formats and logs a queued event.
+             *
+             * @param[in]   record the slot holding the event.
+             */
+            auto logRecord(const Record &record) -> void;
+
+        private:
+            //! @cond
+
+            std::unique_ptr<Record[]> m_records;
+            std::atomic<uint64_t> m_enqueuePosition;
+            uint64_t m_dequeuePosition;
+            std::atomic<quint64> m_dropped;
+
+            std::atomic<bool> m_isRunning;
+            std::thread m_loggingThread;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_ICMPPINGTRACELOG_H
@@ -23,18 +23,28 @@
 
 #include "ICMPPingTransmitter.h"
 
-#include "ICMPPacket/ICMPPacket.h"
+#include "ICMPPingCapture.h"
 #include "ICMPPingEngine.h"
 #include "ICMPPingItem.h"
+#include "ICMPPingRateGovernor.h"
 #include "ICMPPingTarget.h"
+#include "ICMPPingTraceLog.h"
 #include "ICMPSocket/ICMPSocket.h"
 
-#include <QThread>
+#include <Profiler>
+#include <QMap>
+#include <QMutexLocker>
+#include <QRandomGenerator>
 #include <QtEndian>
+#include <algorithm>
 #include <cstdint>
-#include <spdlog/spdlog.h>
 
-constexpr auto DefaultTransmitInterval = 10000;
+
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv6HeaderLength = 40;
+constexpr auto ICMPHeaderLength = 8;
+constexpr auto TCPHeaderLength = 20;
+constexpr auto ProbeWindow = 0.25;
 
 //! @cond
 uint16_t Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::m_sequenceId = 1;
@@ -42,95 +52,353 @@ QMutex Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::m_sequenceMutex;
 //! @endcond
 
 Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::ICMPPingTransmitter(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) :
-        m_interval(DefaultTransmitInterval),
         m_engine(engine),
-        m_isRunning(false) {
+        m_targets(std::make_shared<const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> >()),
+        m_sampleNumber(0),
+        m_pacing(false),
+        m_jitter(0),
+        m_probesPerRound(1),
+        m_roundStart(0),
+        m_roundProbe(0),
+        m_nextTarget(0) {
 
 }
 
 Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::~ICMPPingTransmitter() {
-    qDeleteAll(m_targets);
+    Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::getInstance()->removeTransmitter(this);
 }
 
-void Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::doWork() {
-    QElapsedTimer elapsedTimer;
-    unsigned long sampleNumber = 0;
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::packetLength() -> int {
+    auto headerLength = IPv6HeaderLength;
 
-    m_isRunning = true;
+    if (m_engine->version() == Nedrysoft::Core::IPVersion::V4) {
+        headerLength = IPv4HeaderLength;
+    }
 
-    m_engine->setEpoch(QDateTime::currentDateTime());
+    if (m_engine->protocol() == Nedrysoft::ICMPPingEngine::Protocol::TCP) {
+        return headerLength + TCPHeaderLength + m_engine->payloadSize();
+    }
 
-    while (m_isRunning) {
-        if (!m_targets.isEmpty()) {
-            SPDLOG_TRACE("Preparing ping set to " + m_targets.last()->hostAddress().toString().toStdString());
-        }
+    // the UDP header is the same length as the ICMP echo header.
 
-        elapsedTimer.restart();
+    return headerLength + ICMPHeaderLength + m_engine->payloadSize();
+}
 
-        m_targetsMutex.lock();
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::isDue(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> bool {
+    /**
+     * hops that are sampled less often, or that rate limit their responses, are only sent in some rounds.  The
+     * ttl offsets the rounds that each hop is sent in so that the skipped hops do not all fall due together.
+     */
 
-        for (auto target : m_targets) {
-            auto socket = target->socket();
+    auto roundsPerProbe = static_cast<unsigned long>(target->roundsPerProbe());
 
-            auto pingItem = new Nedrysoft::ICMPPingEngine::ICMPPingItem();
+    return ((m_sampleNumber + target->ttl()) % roundsPerProbe) == 0;
+}
 
-            m_sequenceMutex.lock();
-            uint16_t currentSequenceId = m_sequenceId++;
-            m_sequenceMutex.unlock();
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::transmit(qint64 deadline, qint64 currentTime) -> qint64 {
+    PINGNOO_PROFILE_ZONE("Transmit round");
 
-            pingItem->setTarget(target);
-            pingItem->setId(target->id());
-            pingItem->setSequenceId(currentSequenceId);
-            pingItem->setSampleNumber(sampleNumber);
+    auto rateGovernor = Nedrysoft::ICMPPingEngine::ICMPPingRateGovernor::getInstance();
 
-            m_engine->addRequest(pingItem);
+    m_engine->recordSchedulingLag(currentTime - deadline);
 
-            auto buffer = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
-                    target->id(),
-                    currentSequenceId,
-                    52,
-                    target->hostAddress(),
-                    static_cast<Nedrysoft::ICMPPacket::IPVersion>(m_engine->version()) );
+    // take a reference to the current snapshot, targets added or removed while we are sending will be
+    // picked up by the next transmission.
 
-            auto result = socket->sendto(buffer, target->hostAddress());
+    auto targetSnapshot = std::atomic_load(&m_targets);
+    auto &targets = *targetSnapshot;
 
-            pingItem->startTimer();
+    // the governor stretches the interval when the process wide budget is oversubscribed, and defers the
+    // send if the budget has been used up by other engines in the short term.
+
+    auto length = packetLength();
+    auto probesPerRound = m_probesPerRound.load();
+    auto packetsPerRound = 0.0;
+
+    for (auto target : targets) {
+        packetsPerRound += static_cast<double>(probesPerRound) / target->roundsPerProbe();
+    }
 
-            SPDLOG_TRACE(
-                    QString("Sent ping to %1 (TTL=%2, Result=%3)")
-                    .arg(target->hostAddress().toString())
-                    .arg(socket->ttl()).arg(result)
-                    .toStdString() );
+    auto interval = rateGovernor->shareInterval(
+        this,
+        packetsPerRound,
+        length,
+        m_engine->rateWeight(),
+        m_engine->transmitInterval() );
 
-            if (result != buffer.length()) {
-                SPDLOG_ERROR("Unable to send packet to "+target->hostAddress().toString().toStdString());
+    if ((!m_pacing) || (targets.count() <= 1)) {
+        QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> dueTargets;
+
+        for (auto target : targets) {
+            if (isDue(target)) {
+                dueTargets.append(target);
             }
         }
 
-        m_targetsMutex.unlock();
+        if (!dueTargets.isEmpty()) {
+            auto delay = rateGovernor->acquire(
+                static_cast<int>(dueTargets.count()),
+                static_cast<int>(dueTargets.count()) * length );
+
+            if (delay) {
+                return currentTime + delay;
+            }
+        }
+
+        m_nextTarget = 0;
+        m_offsets.clear();
+
+        if ((m_roundProbe == 0) || (m_roundProbe >= probesPerRound)) {
+            m_roundStart = deadline;
+            m_roundProbe = 0;
+        }
+
+        sendTargets(dueTargets);
+
+        // the bursts of a round are spread evenly across the start of the interval, they share a sample number.
+
+        if (++m_roundProbe < probesPerRound) {
+            return std::max(
+                currentTime,
+                m_roundStart + static_cast<qint64>((interval * ProbeWindow * m_roundProbe) / probesPerRound) );
+        }
+
+        m_roundProbe = 0;
+        m_sampleNumber++;
+
+        // the next round is due one interval after this one was, if we have fallen behind by more than an
+        // interval then the missed rounds are skipped rather than sent in a burst.
+
+        auto nextDeadline = m_roundStart + interval;
+
+        if (nextDeadline <= currentTime) {
+            nextDeadline = currentTime + interval;
+        }
+
+        return nextDeadline;
+    }
+
+    /**
+     * in paced mode each target is given an equal slot of the interval (one for each request of the round) and is
+     * sent at the start of its slot plus a random offset of up to the jitter fraction of the slot.  The offsets are
+     * chosen afresh every round, so every target is still sent the same number of times per interval but the sends
+     * are spread out rather than being a burst that an intermediate router may rate limit.
+     */
+
+    auto slotCount = static_cast<int>(targets.count()) * probesPerRound;
+    auto slotLength = interval / slotCount;
+
+    m_roundProbe = 0;
+
+    if ((m_nextTarget >= slotCount) || (m_offsets.count() != slotCount)) {
+        beginRound(slotCount, deadline, slotLength);
+    }
+
+    // a target that has been backed off keeps its slot in the rounds it is not sent in.
+
+    auto target = targets.at(m_nextTarget % targets.count());
 
-        auto elapsedTime = elapsedTimer.elapsed();
+    if (isDue(target)) {
+        auto delay = rateGovernor->acquire(1, length);
 
-        if (elapsedTime < m_interval) {
-            QThread::msleep(m_interval - elapsedTime);
+        if (delay) {
+            return currentTime + delay;
         }
 
-        sampleNumber++;
+        sendTargets(QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *>() << target);
     }
+
+    m_nextTarget++;
+
+    if (m_nextTarget >= slotCount) {
+        auto nextRoundStart = m_roundStart + interval;
+
+        if (nextRoundStart <= currentTime) {
+            nextRoundStart = currentTime;
+        }
+
+        m_sampleNumber++;
+
+        beginRound(slotCount, nextRoundStart, slotLength);
+    }
+
+    return m_roundStart + (slotLength * m_nextTarget) + m_offsets.at(m_nextTarget);
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::setInterval(int interval) -> bool {
-    m_interval = interval;
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::beginRound(
+        int slotCount,
+        qint64 roundStart,
+        qint64 slotLength) -> void {
 
-    return true;
+    auto maximumOffset = static_cast<qint64>(static_cast<double>(slotLength) * m_jitter);
+
+    m_roundStart = roundStart;
+    m_nextTarget = 0;
+
+    m_offsets.clear();
+
+    for (auto index = 0; index < slotCount; index++) {
+        m_offsets.append(static_cast<qint64>(QRandomGenerator::global()->generateDouble() * maximumOffset));
+    }
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::sendTargets(
+        const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> &targets) -> void {
+
+    auto sampleNumber = m_sampleNumber;
+    auto traceLog = Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::getInstance();
+
+    // the trace log only queues the event and its arguments, they are formatted away from the send path.
+
+    if ((traceLog) && (!targets.isEmpty())) {
+        traceLog->log(
+            Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::Event::PreparingRound,
+            targets.last()->socketAddress(),
+            targets.count(),
+            static_cast<qint64>(sampleNumber) );
+    }
+
+    /**
+     * the packets for the whole sample round are built up front and grouped by socket, each group is then
+     * handed to the socket as a single batch which reduces the number of system calls and the skew between
+     * the transmit times of each hop.  Targets share a socket per address family and carry their TTL in
+     * the datagram, so a round is normally a single batch.
+     */
+
+    auto capture = Nedrysoft::ICMPPingEngine::ICMPPingCapture::getInstance();
+
+    QMap<Nedrysoft::ICMPSocket::ICMPSocket *, QList<Nedrysoft::ICMPSocket::Datagram> > datagramMap;
+    QMap<Nedrysoft::ICMPSocket::ICMPSocket *, QList<Nedrysoft::ICMPPingEngine::ICMPPingItem *> > pingItemMap;
+
+    for (auto target : targets) {
+        auto socket = target->socket();
+
+        if (!socket) {
+            continue;
+        }
+
+        auto pingItem = m_engine->allocateRequest();
+
+        auto currentSequenceId = nextSequence();
+
+        pingItem->setTarget(target);
+        pingItem->setId(target->id());
+        pingItem->setSequenceId(currentSequenceId);
+        pingItem->setSampleNumber(sampleNumber);
+
+        Nedrysoft::ICMPSocket::Datagram datagram;
+
+        if (m_engine->embeddedTimestamps()) {
+            datagram.buffer = target->pingPacket(
+                currentSequenceId,
+                Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp(),
+                static_cast<uint32_t>(sampleNumber)
+            );
+        } else {
+            datagram.buffer = target->pingPacket(currentSequenceId);
+        }
+
+        datagram.hostAddress = target->hostAddress();
+        datagram.socketAddress = target->socketAddress();
+        datagram.ttl = target->ttl();
+
+        datagramMap[socket].append(datagram);
+        pingItemMap[socket].append(pingItem);
+    }
+
+    for (auto socket : datagramMap.keys()) {
+        auto &datagrams = datagramMap[socket];
+        auto &pingItems = pingItemMap[socket];
+
+        for (auto pingItem : pingItems) {
+            pingItem->startTimer();
+
+            m_engine->addRequest(pingItem);
+        }
+
+        socket->sendmmsg(datagrams);
+
+        auto failed = 0;
+
+        for (auto index = 0; index < datagrams.count(); index++) {
+            auto &datagram = datagrams.at(index);
+
+            auto sent = (datagram.result == datagram.buffer.length());
+
+            if (traceLog) {
+                traceLog->log(
+                    sent ? Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::Event::Sent :
+                           Nedrysoft::ICMPPingEngine::ICMPPingTraceLog::Event::SendFailed,
+                    datagram.socketAddress,
+                    datagram.ttl,
+                    datagram.result );
+            }
+
+            if (!sent) {
+                failed++;
+
+                continue;
+            }
+
+            if (capture) {
+                auto pingItem = pingItems.at(index);
+
+                capture->recordSent(
+                    datagram,
+                    socket->version(),
+                    static_cast<Nedrysoft::ICMPPacket::Protocol>(socket->protocol()),
+                    pingItem->id(),
+                    pingItem->sequenceId(),
+                    pingItem->sampleNumber(),
+                    pingItem->transmitTimestamp() );
+            }
+        }
+
+        m_engine->recordTransmitted(datagrams.count()-failed, failed);
+    }
 }
 
 auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::addTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void {
     QMutexLocker locker(&m_targetsMutex);
 
-    m_targets.append(target);
+    auto targets = QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *>(*std::atomic_load(&m_targets));
+
+    targets.append(target);
+
+    std::atomic_store(
+        &m_targets,
+        std::make_shared<const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> >(std::move(targets))
+    );
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::removeTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> bool {
+    QMutexLocker locker(&m_targetsMutex);
+
+    auto targets = QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *>(*std::atomic_load(&m_targets));
+
+    if (!targets.removeOne(target)) {
+        return false;
+    }
+
+    std::atomic_store(
+        &m_targets,
+        std::make_shared<const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> >(std::move(targets))
+    );
+
+    return true;
 }
 
-auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::interval() -> int {
-    return m_interval;
-}
\ No newline at end of file
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::setPacing(bool pacing, double jitter) -> void {
+    m_pacing = pacing;
+    m_jitter = qBound(0.0, jitter, 1.0);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::setProbesPerRound(int probes) -> void {
+    m_probesPerRound = std::max(1, probes);
+}
+
+auto Nedrysoft::ICMPPingEngine::ICMPPingTransmitter::nextSequence() -> uint16_t {
+    QMutexLocker locker(&m_sequenceMutex);
+
+    return m_sequenceId++;
+}
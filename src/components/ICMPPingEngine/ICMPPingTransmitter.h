@@ -26,8 +26,11 @@
 
 #include <PingResult>
 
+#include <QList>
 #include <QMutex>
 #include <QObject>
+#include <atomic>
+#include <memory>
 
 namespace Nedrysoft { namespace ICMPPingEngine {
     class ICMPPingEngine;
@@ -37,6 +40,12 @@ namespace Nedrysoft { namespace ICMPPingEngine {
     /**
      * @brief       The ICMPPingTransmitter class sends pings to the target (and intermediate nodes) at a prescribed
      *              interval.
+     *
+     * @details     The transmitter does not own a thread, each round is sent by the shared ICMPPingScheduler
+     *              when it becomes due.  The interval is read from the engine at the start of every round so that
+     *              changes (including those made by the adaptive interval) take effect immediately.
+     *
+     *              The interval and each send are subject to the process wide ICMPPingRateGovernor.
      */
     class ICMPPingTransmitter :
             public QObject {
@@ -59,33 +68,115 @@ namespace Nedrysoft { namespace ICMPPingEngine {
             ~ICMPPingTransmitter();
 
             /**
-             * @brief       Sets the interval between a set of pings.
+             * @brief       Adds a ping target to the transmitter.
+             *
+             * @details     The target list is published as an immutable snapshot, the change is picked up at the
+             *              start of the next round and the transmitter never locks the list while sending.
+             *
+             * @param[in]   target the target to ping.
              *
-             * @param[in]   interval the interval in milliseconds.
              */
-            auto setInterval(int interval) -> bool;
+            auto addTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void;
 
             /**
-             * @brief       Returns the ping interval.
+             * @brief       Removes a ping target from the transmitter.
+             *
+             * @note        The transmitter may still be sending a round that uses the previous snapshot, so the
+             *              caller must not delete the target straight away.
              *
-             * @returns     the interval in milliseconds.
+             * @param[in]   target the target to remove.
+             *
+             * @returns     true if the target was removed; otherwise false.
              */
-            auto interval() -> int;
+            auto removeTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> bool;
 
             /**
-             * @brief       Adds a ping target to the transmitter.
+             * @brief       Enables or disables paced transmission.
              *
-             * @param[in]   target the target to ping.
+             * @details     By default every target is sent back to back at the start of the interval, when pacing
+             *              is enabled the targets are spread evenly across the interval instead, each one offset
+             *              from the start of its slot by a random amount of up to jitter times the slot length.
              *
+             * @param[in]   pacing true to spread transmissions across the interval; otherwise false.
+             * @param[in]   jitter the maximum random offset as a fraction (0 to 1) of each target's slot.
              */
-            auto addTarget(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> void;
+            auto setPacing(bool pacing, double jitter) -> void;
+
+            /**
+             * @brief       Sets the number of requests sent to each target in every round.
+             *
+             * @details     In burst mode the requests of a round are sent as that many bursts spread evenly across
+             *              the first quarter of the interval, in paced mode each target is given that many slots in
+             *              the interval.  Every request of a round carries the same sample number.
+             *
+             * @param[in]   probes the number of requests per target per round.
+             */
+            auto setProbesPerRound(int probes) -> void;
+
+            /**
+             * @brief       Sends the pings that are due.
+             *
+             * @details     Sends the next burst of the round in burst mode, or the next slot in paced mode.
+             *
+             * @note        This is called from the scheduler thread.
+             *
+             * @param[in]   deadline the time the transmission was scheduled for in nanoseconds.
+             * @param[in]   currentTime the current scheduler time in nanoseconds.
+             *
+             * @returns     the time at which transmit should next be called in nanoseconds.
+             */
+            auto transmit(qint64 deadline, qint64 currentTime) -> qint64;
+
+            /**
+             * @brief       Returns the next sequence number.
+             *
+             * @details     The sequence is shared by every transmitter and by single shot requests, so that two
+             *              requests sharing an id (for example probes on the same flow from different engines)
+             *              are still distinguished by their sequence.
+             *
+             * @returns     the sequence number.
+             */
+            static auto nextSequence() -> uint16_t;
 
         private:
+            /**
+             * @brief       Sends a ping to each of the given targets as a single batch per socket.
+             *
+             * @param[in]   targets the targets to send to.
+             */
+            auto sendTargets(const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> &targets) -> void;
+
+            /**
+             * @brief       Starts a new paced round and chooses the random offset for each slot.
+             *
+             * @param[in]   slotCount the number of slots in the round.
+             * @param[in]   roundStart the start time of the round in nanoseconds.
+             * @param[in]   slotLength the length of each target's slot in nanoseconds.
+             */
+            auto beginRound(
+                int slotCount,
+                qint64 roundStart,
+                qint64 slotLength
+            ) -> void;
 
             /**
-             * @brief       The transmitter thread worker.
+             * @brief       Returns the length of each request on the wire.
+             *
+             * @details     The length includes the IP and transport headers and is used to charge the request
+             *              against the byte budget of the ICMPPingRateGovernor.
+             *
+             * @returns     the length in bytes.
              */
-            Q_SLOT void doWork();
+            auto packetLength() -> int;
+
+            /**
+             * @brief       Returns whether a target is sent in the current round.
+             *
+             * @param[in]   target the target.
+             *
+             * @returns     true if the target is sent; otherwise false.
+             */
+            auto isDue(Nedrysoft::ICMPPingEngine::ICMPPingTarget *target) -> bool;
 
         public:
             /**
@@ -100,20 +191,26 @@ namespace Nedrysoft { namespace ICMPPingEngine {
         private:
             //! @cond
 
-            int m_interval;
             Nedrysoft::ICMPPingEngine::ICMPPingEngine *m_engine;
 
-            QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> m_targets;
+            std::shared_ptr<const QList<Nedrysoft::ICMPPingEngine::ICMPPingTarget *> > m_targets;
             QMutex m_targetsMutex;
 
             QDateTime m_epoch;
 
+            unsigned long m_sampleNumber;
+
+            std::atomic<bool> m_pacing;
+            std::atomic<double> m_jitter;
+            std::atomic<int> m_probesPerRound;
+            qint64 m_roundStart;
+            int m_roundProbe;
+            int m_nextTarget;
+            QList<qint64> m_offsets;
+
             static QMutex m_sequenceMutex;
             static uint16_t m_sequenceId;
 
-        protected:
-            bool m_isRunning;
-
             //! @endcond
     };
 }}
@@ -1,11 +1,11 @@
 /*
- * Copyright (C) 2021 Adrian Carpenter
+ * Copyright (C) 2020 Adrian Carpenter
  *
  * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
  *
  * An open-source cross-platform traceroute analyser.
  *
- * Created by Adrian Carpenter on 20/04/2021.
+ * Created by Adrian Carpenter on 27/03/2020.
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -21,22 +21,23 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "ICMPAPIPingResult.h"
+#include "TCPPingEngineFactory.h"
 
-#include <IPingTarget>
+constexpr auto TCPProbePriority = 0.6;
+
+Nedrysoft::ICMPPingEngine::TCPPingEngineFactory::TCPPingEngineFactory() :
+        ICMPPingEngineFactory(Nedrysoft::ICMPPingEngine::Protocol::TCP) {
 
-Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingResult::ICMPAPIPingResult(Nedrysoft::RouteAnalyser::PingResult result) {
-    m_code = result.code();
-    m_target = result.target();
-    m_hostAddress = result.hostAddress();
-    m_requestTime = result.requestTime();
-    m_roundTripTime = result.roundTripTime();
 }
 
-void Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingResult::setSampleNumber(int sampleNumber) {
-    m_sampleNumber = sampleNumber;
+auto Nedrysoft::ICMPPingEngine::TCPPingEngineFactory::description() -> QString {
+    return tr("TCP SYN Probe");
 }
 
-void Nedrysoft::ICMPAPIPingEngine::ICMPAPIPingResult::setTarget(Nedrysoft::RouteAnalyser::IPingTarget *target) {
-    m_target = target;
-}
\ No newline at end of file
+auto Nedrysoft::ICMPPingEngine::TCPPingEngineFactory::priority() -> double {
+    if (!available()) {
+        return 0;
+    }
+
+    return TCPProbePriority;
+}
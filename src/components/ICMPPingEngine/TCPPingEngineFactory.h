@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ICMPPINGENGINE_TCPPINGENGINEFACTORY_H
+#define PINGNOO_COMPONENTS_ICMPPINGENGINE_TCPPINGENGINEFACTORY_H
+
+#include "ICMPPingEngineFactory.h"
+
+namespace Nedrysoft { namespace ICMPPingEngine {
+    /**
+     * @brief       Factory class for TCP probe engines.
+     *
+     * @details     Creates ICMPPingEngine instances that probe targets with TCP SYN segments to a fixed destination port, which are often permitted by firewalls that filter ICMP and UDP.
+     */
+    class TCPPingEngineFactory :
+            public Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPingEngineFactory)
+
+        public:
+            /**
+             * @brief       Constructs a TCPPingEngineFactory.
+             */
+            TCPPingEngineFactory();
+
+        public:
+            /**
+             * @brief       Returns the descriptive name of the factory.
+             *
+             * @returns     the descriptive name of the ping engine.
+             */
+            auto description() -> QString override;
+
+            /**
+             * @brief       Priority of the ping engine.
+             *
+             * @details     TCP probes are ranked below ICMP and UDP, a SYN is answered by the target with a
+             *              SYN-ACK or a RST which the operating system may log as a half open connection.
+             *
+             * @returns     the priority.
+             */
+            auto priority() -> double override;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ICMPPINGENGINE_TCPPINGENGINEFACTORY_H
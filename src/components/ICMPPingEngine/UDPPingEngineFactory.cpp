@@ -21,26 +21,23 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "ICMPPingTimeout.h"
+#include "UDPPingEngineFactory.h"
 
-#include "ICMPPingEngine.h"
+constexpr auto UDPProbePriority = 0.7;
 
-#include <QThread>
-
-constexpr auto DefaultSleepTime = 1000;
-
-Nedrysoft::ICMPPingEngine::ICMPPingTimeout::ICMPPingTimeout(Nedrysoft::ICMPPingEngine::ICMPPingEngine *engine) :
-        m_engine(engine),
-        m_isRunning(false) {
+Nedrysoft::ICMPPingEngine::UDPPingEngineFactory::UDPPingEngineFactory() :
+        ICMPPingEngineFactory(Nedrysoft::ICMPPingEngine::Protocol::UDP) {
 
 }
 
-void Nedrysoft::ICMPPingEngine::ICMPPingTimeout::doWork() {
-    m_isRunning = true;
-
-    while (m_isRunning) {
-        m_engine->timeoutRequests();
+auto Nedrysoft::ICMPPingEngine::UDPPingEngineFactory::description() -> QString {
+    return tr("UDP Probe");
+}
 
-        QThread::msleep(DefaultSleepTime);
+auto Nedrysoft::ICMPPingEngine::UDPPingEngineFactory::priority() -> double {
+    if (!available()) {
+        return 0;
     }
+
+    return UDPProbePriority;
 }
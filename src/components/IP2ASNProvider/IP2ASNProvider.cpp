@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IP2ASNProvider.h"
+
+#include "PrefixTrie.h"
+
+#include <ICore>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <spdlog/spdlog.h>
+
+constexpr auto TrieFilename = "ip2asn.trie";
+
+/**
+ * the names that the iptoasn.com dumps are distributed with (once decompressed), the combined dump covers both
+ * address families and is preferred.
+ */
+
+constexpr const char *DumpFilenames[] = {
+    "ip2asn-combined.tsv",
+    "ip2asn-v4.tsv",
+    "ip2asn-v6.tsv"
+};
+
+Nedrysoft::IP2ASNProvider::IP2ASNProvider::IP2ASNProvider() :
+        m_trie(new Nedrysoft::IP2ASNProvider::PrefixTrie),
+        m_initialised(false) {
+
+}
+
+Nedrysoft::IP2ASNProvider::IP2ASNProvider::~IP2ASNProvider() {
+    if (m_compile.valid()) {
+        m_compile.wait();
+    }
+
+    delete m_trie;
+}
+
+auto Nedrysoft::IP2ASNProvider::IP2ASNProvider::initialise() -> void {
+    if (m_initialised) {
+        return;
+    }
+
+    m_initialised = true;
+
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+    auto trieInfo = QFileInfo(storageFolder, TrieFilename);
+    auto dumpInfo = QFileInfo();
+
+    for (auto filename : DumpFilenames) {
+        dumpInfo = QFileInfo(storageFolder, filename);
+
+        if (dumpInfo.exists()) {
+            break;
+        }
+    }
+
+    if (trieInfo.exists()) {
+        openTrie(trieInfo.absoluteFilePath());
+    }
+
+    if ((!dumpInfo.exists()) || ((trieInfo.exists()) && (trieInfo.lastModified()>=dumpInfo.lastModified()))) {
+        return;
+    }
+
+    /**
+     * compiling a full table takes a few seconds, the current trie (if any) carries on answering lookups until
+     * the new one is ready.
+     */
+
+    auto dumpFilename = dumpInfo.absoluteFilePath();
+    auto trieFilename = trieInfo.absoluteFilePath();
+
+    m_compile = std::async(std::launch::async, [this, dumpFilename, trieFilename]() {
+        auto compiled = Nedrysoft::IP2ASNProvider::PrefixTrie::compile(dumpFilename, trieFilename);
+
+        QMetaObject::invokeMethod(this, [this, compiled, dumpFilename, trieFilename]() {
+            if (!compiled) {
+                SPDLOG_WARN(QString("unable to compile AS database. (%1)").arg(dumpFilename).toStdString());
+
+                return;
+            }
+
+            openTrie(trieFilename);
+        });
+    });
+}
+
+auto Nedrysoft::IP2ASNProvider::IP2ASNProvider::openTrie(const QString &filename) -> void {
+    auto trie = new Nedrysoft::IP2ASNProvider::PrefixTrie;
+
+    if (!trie->open(filename)) {
+        SPDLOG_WARN(QString("unable to open AS database. (%1)").arg(filename).toStdString());
+
+        delete trie;
+
+        return;
+    }
+
+    delete m_trie;
+
+    m_trie = trie;
+
+    SPDLOG_INFO(QString("loaded AS database. (%1)").arg(filename).toStdString());
+
+    Q_EMIT databaseChanged();
+}
+
+auto Nedrysoft::IP2ASNProvider::IP2ASNProvider::lookup(
+        const QHostAddress &address,
+        quint32 &asNumber,
+        QString &owner ) -> bool {
+
+    uint32_t number;
+
+    initialise();
+
+    if (!m_trie->lookup(address, number, owner)) {
+        return false;
+    }
+
+    asNumber = number;
+
+    return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_IP2ASNPROVIDER_IP2ASNPROVIDER_H
+#define PINGNOO_COMPONENTS_IP2ASNPROVIDER_IP2ASNPROVIDER_H
+
+#include "IP2ASNProviderSpec.h"
+
+#include <IASNProvider>
+#include <IInterface>
+#include <QObject>
+#include <future>
+
+namespace Nedrysoft { namespace IP2ASNProvider {
+    class PrefixTrie;
+
+    /**
+     * @brief       The IP2ASNProvider class provides an offline address to autonomous system lookup.
+     *
+     * @details     An ip2asn range dump (from iptoasn.com) placed in the application storage folder is compiled
+     *              into a prefix trie the first time it is seen, later runs map the compiled trie directly.
+     *              The trie is recompiled in the background whenever the dump is newer than it.  Nothing is
+     *              opened until the first lookup, so the provider adds nothing to startup.
+     */
+    class IP2ASNProvider :
+            public Nedrysoft::Core::IASNProvider {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::Core::IASNProvider)
+
+        public:
+            /**
+             * @brief       Constructs an IP2ASNProvider.
+             */
+            IP2ASNProvider();
+
+            /**
+             * @brief       Destroys the IP2ASNProvider.
+             */
+            ~IP2ASNProvider();
+
+            /**
+             * @brief       Finds the autonomous system that an address belongs to.
+             *
+             * @see         Nedrysoft::Core::IASNProvider::lookup
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  asNumber the AS number.
+             * @param[out]  owner the name of the organisation that owns the AS.
+             *
+             * @returns     true if the address is announced by an AS; otherwise false.
+             */
+            auto lookup(const QHostAddress &address, quint32 &asNumber, QString &owner) -> bool override;
+
+        private:
+            /**
+             * @brief       Opens the compiled trie, compiling it first if the dump is newer.
+             *
+             * @details     Called on the first lookup rather than at startup.
+             */
+            auto initialise() -> void;
+
+            /**
+             * @brief       Opens a compiled trie, replacing the current one.
+             *
+             * @param[in]   filename the compiled trie file.
+             */
+            auto openTrie(const QString &filename) -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::IP2ASNProvider::PrefixTrie *m_trie;
+            std::future<void> m_compile;
+            bool m_initialised;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_IP2ASNPROVIDER_IP2ASNPROVIDER_H
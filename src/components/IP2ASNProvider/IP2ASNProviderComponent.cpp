@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IP2ASNProvider.h"
+#include "IP2ASNProviderComponent.h"
+
+#include <IComponentManager>
+
+IP2ASNProviderComponent::IP2ASNProviderComponent() :
+        m_provider(nullptr) {
+
+}
+
+IP2ASNProviderComponent::~IP2ASNProviderComponent() {
+
+}
+
+auto IP2ASNProviderComponent::initialiseEvent() -> void {
+    m_provider = new Nedrysoft::IP2ASNProvider::IP2ASNProvider();
+
+    Nedrysoft::ComponentSystem::addObject(m_provider);
+}
+
+auto IP2ASNProviderComponent::finaliseEvent() -> void {
+    if (m_provider) {
+        Nedrysoft::ComponentSystem::removeObject(m_provider);
+
+        delete m_provider;
+    }
+}
+
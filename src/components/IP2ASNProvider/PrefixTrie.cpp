@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrefixTrie.h"
+
+#include <QHash>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+constexpr auto TrieMagic = "PNGASN01";
+constexpr auto TrieMagicLength = 8;
+constexpr auto LeafFlag = 0x80000000u;
+constexpr auto KeyBits = 128;
+constexpr auto MaximumDepth = KeyBits+1;
+constexpr auto MinimumDumpFields = 5;
+
+using KeyArray = std::array<uint8_t, 16>;
+
+/**
+ * addresses are stored as IPv6 with IPv4 addresses mapped into ::ffff:0:0/96, so both families share one trie.
+ */
+
+static auto addressKey(const QHostAddress &address, KeyArray &key) -> bool {
+    auto isIPv4 = false;
+    auto ipv4Address = address.toIPv4Address(&isIPv4);
+
+    if (isIPv4) {
+        key.fill(0);
+
+        key[10] = 0xff;
+        key[11] = 0xff;
+        key[12] = static_cast<uint8_t>(ipv4Address >> 24);
+        key[13] = static_cast<uint8_t>(ipv4Address >> 16);
+        key[14] = static_cast<uint8_t>(ipv4Address >> 8);
+        key[15] = static_cast<uint8_t>(ipv4Address);
+
+        return true;
+    }
+
+    if (address.protocol()!=QAbstractSocket::IPv6Protocol) {
+        return false;
+    }
+
+    auto ipv6Address = address.toIPv6Address();
+
+    memcpy(key.data(), ipv6Address.c, key.size());
+
+    return true;
+}
+
+static auto keyBit(const uint8_t *key, uint32_t bit) -> int {
+    return (key[bit >> 3] >> (7-(bit & 7))) & 1;
+}
+
+static auto prefixMatches(const uint8_t *key, const uint8_t *prefix, uint32_t prefixLength) -> bool {
+    auto bytes = prefixLength >> 3;
+    auto bits = prefixLength & 7;
+
+    if (memcmp(key, prefix, bytes)) {
+        return false;
+    }
+
+    if (!bits) {
+        return true;
+    }
+
+    auto mask = static_cast<uint8_t>(0xff << (8-bits));
+
+    return (key[bytes] & mask)==(prefix[bytes] & mask);
+}
+
+static auto commonBits(const uint8_t *first, const uint8_t *second) -> uint32_t {
+    for (uint32_t byte=0;byte<16;byte++) {
+        auto difference = static_cast<uint8_t>(first[byte] ^ second[byte]);
+
+        if (difference) {
+            auto bit = 0u;
+
+            while (!(difference & 0x80)) {
+                difference <<= 1;
+                bit++;
+            }
+
+            return byte*8+bit;
+        }
+    }
+
+    return KeyBits;
+}
+
+/**
+ * splits an inclusive address range into the smallest set of prefixes that exactly cover it.
+ */
+
+static auto rangePrefixes(
+        KeyArray start,
+        const KeyArray &end,
+        uint32_t system,
+        std::vector<Nedrysoft::IP2ASNProvider::PrefixTrie::Leaf> &leaves ) -> void {
+
+    while (start<=end) {
+        auto alignment = 0;
+
+        while ((alignment<KeyBits) && (!keyBit(start.data(), KeyBits-1-alignment))) {
+            alignment++;
+        }
+
+        auto high = start;
+
+        for (auto size=alignment;size>=0;size--) {
+            high = start;
+
+            for (auto bit=0;bit<size;bit++) {
+                auto position = KeyBits-1-bit;
+
+                high[position >> 3] |= static_cast<uint8_t>(0x80 >> (position & 7));
+            }
+
+            if (high<=end) {
+                auto leaf = Nedrysoft::IP2ASNProvider::PrefixTrie::Leaf();
+
+                memcpy(leaf.key, start.data(), start.size());
+
+                leaf.prefixLength = static_cast<uint32_t>(KeyBits-size);
+                leaf.system = system;
+
+                leaves.push_back(leaf);
+
+                break;
+            }
+        }
+
+        if (high==end) {
+            break;
+        }
+
+        start = high;
+
+        for (auto byte=15;byte>=0;byte--) {
+            if (++start[byte]) {
+                break;
+            }
+        }
+    }
+}
+
+static auto buildNodes(
+        const std::vector<Nedrysoft::IP2ASNProvider::PrefixTrie::Leaf> &leaves,
+        uint32_t first,
+        uint32_t last,
+        std::vector<Nedrysoft::IP2ASNProvider::PrefixTrie::Node> &nodes ) -> uint32_t {
+
+    if (last-first==1) {
+        return LeafFlag | first;
+    }
+
+    /**
+     * the leaves are sorted, so the bits shared by the first and last are shared by all of them, the first bit
+     * that differs splits the range into a left (0) and right (1) subtree.
+     */
+
+    auto bit = commonBits(leaves[first].key, leaves[last-1].key);
+
+    auto split = std::partition_point(leaves.begin()+first, leaves.begin()+last,
+            [bit](const Nedrysoft::IP2ASNProvider::PrefixTrie::Leaf &leaf) {
+
+        return !keyBit(leaf.key, bit);
+    });
+
+    auto middle = static_cast<uint32_t>(split-leaves.begin());
+    auto index = static_cast<uint32_t>(nodes.size());
+
+    nodes.push_back(Nedrysoft::IP2ASNProvider::PrefixTrie::Node{bit, {0, 0}});
+
+    auto left = buildNodes(leaves, first, middle, nodes);
+    auto right = buildNodes(leaves, middle, last, nodes);
+
+    nodes[index].children[0] = left;
+    nodes[index].children[1] = right;
+
+    return index;
+}
+
+Nedrysoft::IP2ASNProvider::PrefixTrie::PrefixTrie() :
+        m_map(nullptr),
+        m_header(nullptr),
+        m_nodes(nullptr),
+        m_leaves(nullptr),
+        m_systems(nullptr),
+        m_strings(nullptr) {
+
+}
+
+Nedrysoft::IP2ASNProvider::PrefixTrie::~PrefixTrie() {
+    close();
+}
+
+auto Nedrysoft::IP2ASNProvider::PrefixTrie::compile(const QString &dumpFilename, const QString &trieFilename) -> bool {
+    QFile dumpFile(dumpFilename);
+
+    if (!dumpFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    auto leaves = std::vector<Leaf>();
+    auto systems = std::vector<System>();
+    auto systemIndex = QHash<uint32_t, uint32_t>();
+    auto strings = QByteArray();
+
+    while (!dumpFile.atEnd()) {
+        auto fields = QString::fromUtf8(dumpFile.readLine()).trimmed().split('\t');
+
+        if (fields.count()<MinimumDumpFields) {
+            continue;
+        }
+
+        auto asNumber = fields.at(2).toUInt();
+
+        /**
+         * AS 0 marks address space that is not routed, which is the same as having no entry.
+         */
+
+        if (!asNumber) {
+            continue;
+        }
+
+        KeyArray start, end;
+
+        if ((!addressKey(QHostAddress(fields.at(0)), start)) || (!addressKey(QHostAddress(fields.at(1)), end))) {
+            continue;
+        }
+
+        if (end<start) {
+            continue;
+        }
+
+        if (!systemIndex.contains(asNumber)) {
+            auto description = fields.mid(MinimumDumpFields-1).join(' ').toUtf8();
+
+            systemIndex[asNumber] = static_cast<uint32_t>(systems.size());
+
+            systems.push_back(System{
+                asNumber,
+                static_cast<uint32_t>(strings.size()),
+                static_cast<uint32_t>(description.size())
+            });
+
+            strings.append(description);
+        }
+
+        rangePrefixes(start, end, systemIndex[asNumber], leaves);
+    }
+
+    /**
+     * the dump should not contain overlapping ranges, but if it does then the covering prefix is kept and any
+     * prefix inside it is dropped, the trie relies on every prefix being disjoint.
+     */
+
+    std::sort(leaves.begin(), leaves.end(), [](const Leaf &first, const Leaf &second) {
+        auto order = memcmp(first.key, second.key, sizeof(Key));
+
+        if (order) {
+            return order<0;
+        }
+
+        return first.prefixLength<second.prefixLength;
+    });
+
+    auto disjointLeaves = std::vector<Leaf>();
+
+    for (const auto &leaf : leaves) {
+        if ((!disjointLeaves.empty()) &&
+            (prefixMatches(leaf.key, disjointLeaves.back().key, disjointLeaves.back().prefixLength))) {
+
+            continue;
+        }
+
+        disjointLeaves.push_back(leaf);
+    }
+
+    auto nodes = std::vector<Node>();
+    uint32_t root = 0;
+
+    if (!disjointLeaves.empty()) {
+        nodes.reserve(disjointLeaves.size());
+
+        root = buildNodes(disjointLeaves, 0, static_cast<uint32_t>(disjointLeaves.size()), nodes);
+    }
+
+    auto header = Header();
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TrieMagic, TrieMagicLength);
+
+    header.root = root;
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.leafCount = static_cast<uint32_t>(disjointLeaves.size());
+    header.systemCount = static_cast<uint32_t>(systems.size());
+    header.stringsSize = static_cast<uint32_t>(strings.size());
+
+    /**
+     * the trie is written alongside and renamed into place, a provider that has the old file mapped keeps
+     * using it until it reopens.
+     */
+
+    auto temporaryFilename = trieFilename+".tmp";
+    QFile trieFile(temporaryFilename);
+
+    if (!trieFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    auto writeBlock = [&trieFile](const void *data, qint64 length) {
+        return trieFile.write(reinterpret_cast<const char *>(data), length)==length;
+    };
+
+    auto written =
+        writeBlock(&header, sizeof(header)) &&
+        writeBlock(nodes.data(), static_cast<qint64>(nodes.size()*sizeof(Node))) &&
+        writeBlock(disjointLeaves.data(), static_cast<qint64>(disjointLeaves.size()*sizeof(Leaf))) &&
+        writeBlock(systems.data(), static_cast<qint64>(systems.size()*sizeof(System))) &&
+        writeBlock(strings.constData(), strings.size());
+
+    trieFile.close();
+
+    if (!written) {
+        QFile::remove(temporaryFilename);
+
+        return false;
+    }
+
+    QFile::remove(trieFilename);
+
+    return QFile::rename(temporaryFilename, trieFilename);
+}
+
+auto Nedrysoft::IP2ASNProvider::PrefixTrie::open(const QString &filename) -> bool {
+    close();
+
+    m_file.setFileName(filename);
+
+    if ((!m_file.open(QFile::ReadOnly)) || (m_file.size()<static_cast<qint64>(sizeof(Header)))) {
+        close();
+
+        return false;
+    }
+
+    m_map = m_file.map(0, m_file.size());
+
+    if (!m_map) {
+        close();
+
+        return false;
+    }
+
+    auto header = reinterpret_cast<const Header *>(m_map);
+
+    auto expectedSize =
+        sizeof(Header) +
+        static_cast<quint64>(header->nodeCount)*sizeof(Node) +
+        static_cast<quint64>(header->leafCount)*sizeof(Leaf) +
+        static_cast<quint64>(header->systemCount)*sizeof(System) +
+        header->stringsSize;
+
+    if ((memcmp(header->magic, TrieMagic, TrieMagicLength)) || (expectedSize!=static_cast<quint64>(m_file.size()))) {
+        close();
+
+        return false;
+    }
+
+    m_header = header;
+    m_nodes = reinterpret_cast<const Node *>(m_map+sizeof(Header));
+    m_leaves = reinterpret_cast<const Leaf *>(m_nodes+header->nodeCount);
+    m_systems = reinterpret_cast<const System *>(m_leaves+header->leafCount);
+    m_strings = reinterpret_cast<const char *>(m_systems+header->systemCount);
+
+    return true;
+}
+
+auto Nedrysoft::IP2ASNProvider::PrefixTrie::close() -> void {
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+
+    m_file.close();
+
+    m_map = nullptr;
+    m_header = nullptr;
+    m_nodes = nullptr;
+    m_leaves = nullptr;
+    m_systems = nullptr;
+    m_strings = nullptr;
+}
+
+auto Nedrysoft::IP2ASNProvider::PrefixTrie::isOpen() const -> bool {
+    return m_header!=nullptr;
+}
+
+auto Nedrysoft::IP2ASNProvider::PrefixTrie::lookup(
+        const QHostAddress &address,
+        uint32_t &asNumber,
+        QString &owner ) const -> bool {
+
+    KeyArray key;
+
+    if ((!isOpen()) || (!m_header->leafCount) || (!addressKey(address, key))) {
+        return false;
+    }
+
+    auto reference = m_header->root;
+
+    for (auto depth=0;!(reference & LeafFlag);depth++) {
+        if ((reference>=m_header->nodeCount) || (depth>=MaximumDepth) || (m_nodes[reference].bit>=KeyBits)) {
+            return false;
+        }
+
+        reference = m_nodes[reference].children[keyBit(key.data(), m_nodes[reference].bit)];
+    }
+
+    reference &= ~LeafFlag;
+
+    if (reference>=m_header->leafCount) {
+        return false;
+    }
+
+    auto &leaf = m_leaves[reference];
+
+    if ((leaf.prefixLength>KeyBits) || (!prefixMatches(key.data(), leaf.key, leaf.prefixLength))) {
+        return false;
+    }
+
+    if (leaf.system>=m_header->systemCount) {
+        return false;
+    }
+
+    auto &system = m_systems[leaf.system];
+
+    if (static_cast<quint64>(system.descriptionOffset)+system.descriptionLength>m_header->stringsSize) {
+        return false;
+    }
+
+    asNumber = system.asNumber;
+    owner = QString::fromUtf8(m_strings+system.descriptionOffset, static_cast<int>(system.descriptionLength));
+
+    return true;
+}
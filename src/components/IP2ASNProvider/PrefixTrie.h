@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_IP2ASNPROVIDER_PREFIXTRIE_H
+#define PINGNOO_COMPONENTS_IP2ASNPROVIDER_PREFIXTRIE_H
+
+#include <QFile>
+#include <QHostAddress>
+#include <QString>
+#include <cstdint>
+
+namespace Nedrysoft { namespace IP2ASNProvider {
+    /**
+     * @brief       The PrefixTrie class maps addresses to autonomous systems using a compressed (Patricia) trie.
+     *
+     * @details     The trie is compiled once from an IP to ASN range dump (the tab separated format published by
+     *              iptoasn.com) into a flat file which is then memory mapped, so later startups do not parse the
+     *              dump again.  IPv4 addresses are stored as IPv4 mapped IPv6 addresses so that a single trie
+     *              holds both families.
+     *
+     *              The announced prefixes do not overlap, so every prefix is a leaf and the internal nodes only
+     *              record the bit that the two subtrees differ at, a lookup follows one branch per internal node
+     *              and compares the address against the leaf it reaches.
+     *
+     *              The compiled file uses the native byte order, it is a cache of the dump and is rebuilt rather
+     *              than shared between machines.
+     */
+    class PrefixTrie {
+        public:
+            /**
+             * @brief       Constructs a closed PrefixTrie.
+             */
+            PrefixTrie();
+
+            /**
+             * @brief       Destroys the PrefixTrie, unmapping the file.
+             */
+            ~PrefixTrie();
+
+            /**
+             * @brief       Compiles a range dump into a trie file.
+             *
+             * @details     This is slow for a full table and is safe to call from any thread.
+             *
+             * @param[in]   dumpFilename the tab separated range dump.
+             * @param[in]   trieFilename the compiled file to write.
+             *
+             * @returns     true if the file was written; otherwise false.
+             */
+            static auto compile(const QString &dumpFilename, const QString &trieFilename) -> bool;
+
+            /**
+             * @brief       Opens and maps a compiled trie file.
+             *
+             * @param[in]   filename the compiled file.
+             *
+             * @returns     true if the file was mapped and is valid; otherwise false.
+             */
+            auto open(const QString &filename) -> bool;
+
+            /**
+             * @brief       Unmaps and closes the trie.
+             */
+            auto close() -> void;
+
+            /**
+             * @brief       Returns whether the trie is open.
+             *
+             * @returns     true if open; otherwise false.
+             */
+            auto isOpen() const -> bool;
+
+            /**
+             * @brief       Finds the autonomous system that announces an address.
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  asNumber the AS number.
+             * @param[out]  owner the description of the AS.
+             *
+             * @returns     true if the address is announced; otherwise false.
+             */
+            auto lookup(const QHostAddress &address, uint32_t &asNumber, QString &owner) const -> bool;
+
+        public:
+            //! @cond
+
+            using Key = uint8_t[16];
+
+            struct Header {
+                char magic[8];
+                uint32_t root;
+                uint32_t nodeCount;
+                uint32_t leafCount;
+                uint32_t systemCount;
+                uint32_t stringsSize;
+                uint32_t reserved;
+            };
+
+            struct Node {
+                uint32_t bit;
+                uint32_t children[2];
+            };
+
+            struct Leaf {
+                Key key;
+                uint32_t prefixLength;
+                uint32_t system;
+            };
+
+            struct System {
+                uint32_t asNumber;
+                uint32_t descriptionOffset;
+                uint32_t descriptionLength;
+            };
+
+            //! @endcond
+
+        private:
+            //! @cond
+
+            QFile m_file;
+            uchar *m_map;
+            const Header *m_header;
+            const Node *m_nodes;
+            const Leaf *m_leaves;
+            const System *m_systems;
+            const char *m_strings;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_IP2ASNPROVIDER_PREFIXTRIE_H
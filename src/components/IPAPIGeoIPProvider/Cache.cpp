@@ -23,20 +23,57 @@
 
 #include "Cache.h"
 
+#include <Clock>
 #include <ICore>
 
 #include <QDateTime>
 #include <QDir>
+#include <QJsonDocument>
 #include <QJsonArray>
+#include <QMetaObject>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlResult>
+#include <QThread>
 #include <spdlog/spdlog.h>
 
 constexpr auto cacheDatabase = "Nedrysoft::IPAPIGeoIPProvider::Cache";
+constexpr auto writerDatabase = "Nedrysoft::IPAPIGeoIPProvider::Cache::Writer";
+constexpr auto RecentEntries = 1024;
+constexpr auto FlushInterval = 2000;
+constexpr auto FlushThreshold = 32;
+constexpr auto MemorySubsystem = "ip-api.com GeoIP cache";
+constexpr auto RecordSizeGain = 16;
+constexpr auto MaximumAge = 30*24*60*60;
+constexpr auto CompactionInterval = 60*60*1000;
+
+Nedrysoft::IPAPIGeoIPProvider::Cache::Cache() :
+        m_recent(RecentEntries),
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_recordSize(0),
+        m_memory(MemorySubsystem) {
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushInterval);
+
+    QObject::connect(&m_flushTimer, &QTimer::timeout, [this]() {
+        flush();
+    });
+
+    m_compactionTimer.setInterval(CompactionInterval);
+
+    QObject::connect(&m_compactionTimer, &QTimer::timeout, [this]() {
+        QMetaObject::invokeMethod(m_context, [this]() {
+            compact();
+        }, Qt::QueuedConnection);
+    });
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
 
-Nedrysoft::IPAPIGeoIPProvider::Cache::Cache() {
     auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
 
     auto dbFileInfo = QFileInfo(storageLocation, "ip-api-cache.db");
@@ -63,6 +100,15 @@ Nedrysoft::IPAPIGeoIPProvider::Cache::Cache() {
 
     auto query = QSqlQuery(database);
 
+    /**
+     * the journal mode is stored in the database, in write ahead log mode a reader is never blocked by the writer
+     * and a commit only waits for the disk when the log is checkpointed.
+     */
+
+    if ((!query.exec("PRAGMA journal_mode=WAL")) || (!query.exec("PRAGMA synchronous=NORMAL"))) {
+        SPDLOG_WARN(QString("error enabling write ahead log. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
     auto result = query.exec(R"(CREATE TABLE IF NOT EXISTS ip (
                                   id INTEGER PRIMARY KEY,
                                   name TEXT,
@@ -85,46 +131,204 @@ Nedrysoft::IPAPIGeoIPProvider::Cache::Cache() {
         SPDLOG_WARN(QString("error creating table. (%1)").arg(query.lastError().text()).toStdString());
     }
 
+    /**
+     * older databases allowed the same host to be stored more than once, only the newest record is kept so that
+     * the name can be given a unique index.
+     */
+
+    result = query.exec("DELETE FROM ip WHERE id NOT IN (SELECT MAX(id) FROM ip GROUP BY name)");
+
+    if (result) {
+        result = query.exec("CREATE UNIQUE INDEX IF NOT EXISTS ip_name ON ip (name)");
+    }
+
+    if (!result) {
+        SPDLOG_WARN(QString("error creating index. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
     query.finish();
+
+    auto filename = dbFileInfo.absoluteFilePath();
+
+    QMetaObject::invokeMethod(m_context, [this, filename]() {
+        openWriter(filename);
+
+        compact();
+    }, Qt::QueuedConnection);
+
+    m_compactionTimer.start();
 }
 
 Nedrysoft::IPAPIGeoIPProvider::Cache::~Cache() {
+    flush();
+
+    m_compactionTimer.stop();
+
+    /**
+     * the database thread handles its work in order, so the records handed to it above are written before the
+     * writer connection is closed.
+     */
+
+    QMetaObject::invokeMethod(m_context, []() {
+        QSqlDatabase::removeDatabase(writerDatabase);
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+
     QSqlDatabase::removeDatabase(cacheDatabase);
 }
 
 auto Nedrysoft::IPAPIGeoIPProvider::Cache::add(QJsonObject object) -> void {
-    QSqlDatabase database = QSqlDatabase::database(cacheDatabase);
+    auto record = QJsonObject();
+
+    record["name"] = object["query"];
+    record["creationTime"] = QJsonValue::fromVariant(Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch());
+    record["country"] = object["country"];
+    record["countryCode"] = object["countryCode"];
+    record["region"] = object["region"];
+    record["regionName"] = object["regionName"];
+    record["city"] = object["city"];
+    record["zip"] = object["zip"];
+    record["lat"] = object["lat"];
+    record["lon"] = object["lon"];
+    record["timezone"] = object["timezone"];
+    record["isp"] = object["isp"];
+    record["org"] = object["org"];
+    record["asn"] = object["as"];
+
+    auto recentRecord = new QJsonObject(record);
+
+    recentRecord->remove("name");
+
+    m_recent.insert(record["name"].toString(), recentRecord);
+
+    m_pendingRecords.append(record);
+
+    updateMemory(record);
+
+    if (m_pendingRecords.count()>=FlushThreshold) {
+        flush();
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::flush() -> void {
+    m_flushTimer.stop();
+
+    if (m_pendingRecords.isEmpty()) {
+        return;
+    }
+
+    auto records = m_pendingRecords;
+
+    m_pendingRecords.clear();
+
+    QMetaObject::invokeMethod(m_context, [this, records]() {
+        write(records);
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::openWriter(const QString &filename) -> void {
+    auto database = QSqlDatabase::addDatabase("QSQLITE", writerDatabase);
+
+    database.setDatabaseName(filename);
+
+    if (!database.open()) {
+        SPDLOG_ERROR(QString("error opening database. (%1)").arg(database.lastError().text()).toStdString());
+
+        return;
+    }
+
+    QSqlQuery query(database);
+
+    if (!query.exec("PRAGMA synchronous=NORMAL")) {
+        SPDLOG_WARN(QString("error setting synchronous mode. (%1)").arg(query.lastError().text()).toStdString());
+    }
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::write(const QList<QJsonObject> &records) -> void {
+    QSqlDatabase database = QSqlDatabase::database(writerDatabase);
+
+    if (!database.isOpen()) {
+        return;
+    }
+
+    database.transaction();
+
     QSqlQuery query(database);
 
     query.prepare(
-            "INSERT INTO ip (name, creationTime, country, countryCode, region, regionName, city, zip, lat, lon, timezone, isp, org, asn) "
+            "INSERT OR REPLACE INTO ip (name, creationTime, country, countryCode, region, regionName, city, zip, lat, lon, timezone, isp, org, asn) "
             "VALUES (:name, :creationTime, :country, :countryCode, :region, :regionName, :city, :zip, :lat, :lon, :timezone, :isp, :org, :asn)");
 
-    query.bindValue(":name", object["query"].toVariant());
-    query.bindValue(":creationTime", QDateTime::currentDateTimeUtc().toTime_t());
-    query.bindValue(":country", object["country"].toVariant());
-    query.bindValue(":countryCode", object["countryCode"].toVariant());
-    query.bindValue(":region", object["region"].toVariant());
-    query.bindValue(":regionName", object["regionName"].toVariant());
-    query.bindValue(":city", object["city"].toVariant());
-    query.bindValue(":zip", object["zip"].toVariant());
-    query.bindValue(":lat", object["lat"].toVariant());
-    query.bindValue(":lon", object["lon"].toVariant());
-    query.bindValue(":timezone", object["timezone"].toVariant());
-    query.bindValue(":isp", object["isp"].toVariant());
-    query.bindValue(":org", object["org"].toVariant());
-    query.bindValue(":asn", object["as"].toVariant());
-
-    auto result = query.exec();
+    for (const auto &record : records) {
+        for (auto it = record.begin(); it != record.end(); it++) {
+            query.bindValue(":"+it.key(), it.value().toVariant());
+        }
+
+        if (!query.exec()) {
+            SPDLOG_WARN(QString("error adding record.  (%1)").arg(query.lastError().text()).toStdString());
+        }
+    }
 
-    if (!result) {
-        SPDLOG_WARN(QString("error adding record.  (%1)").arg(query.lastError().text()).toStdString());
+    query.finish();
+
+    if (!database.commit()) {
+        SPDLOG_WARN(QString("error committing records.  (%1)").arg(database.lastError().text()).toStdString());
+    }
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::compact() -> void {
+    QSqlDatabase database = QSqlDatabase::database(writerDatabase);
+
+    if (!database.isOpen()) {
+        return;
+    }
+
+    QSqlQuery query(database);
+
+    query.prepare("DELETE FROM ip WHERE creationTime<:expiryTime");
+    query.bindValue(":expiryTime", Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch()-MaximumAge);
+
+    if (!query.exec()) {
+        SPDLOG_WARN(QString("error removing expired records. (%1)").arg(query.lastError().text()).toStdString());
+    }
+
+    // the log is folded back into the database and emptied, so neither file keeps growing.
+
+    if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+        SPDLOG_WARN(QString("error checkpointing database. (%1)").arg(query.lastError().text()).toStdString());
     }
 
     query.finish();
 }
 
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::isExpired(const QJsonObject &object) -> bool {
+    auto creationTime = object["creationTime"].toVariant().toLongLong();
+
+    return creationTime<Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch()-MaximumAge;
+}
+
 auto Nedrysoft::IPAPIGeoIPProvider::Cache::find(const QString &name, QJsonObject &object) -> bool {
+    auto recentRecord = m_recent.object(name);
+
+    if (recentRecord) {
+        if (isExpired(*recentRecord)) {
+            m_recent.remove(name);
+
+            return false;
+        }
+
+        object = *recentRecord;
+
+        return true;
+    }
+
     QSqlDatabase database = QSqlDatabase::database(cacheDatabase);
     QSqlQuery query(database);
     bool queryResult = false;
@@ -148,9 +352,33 @@ auto Nedrysoft::IPAPIGeoIPProvider::Cache::find(const QString &name, QJsonObject
             object["org"] = QJsonValue::fromVariant(query.value("org"));
             object["asn"] = QJsonValue::fromVariant(query.value("asn"));
 
+            // an expired row is left for compaction to remove, the new result replaces it before then anyway.
+
+            if (isExpired(object)) {
+                return false;
+            }
+
+            m_recent.insert(name, new QJsonObject(object));
+
+            updateMemory(object);
+
             queryResult = true;
         }
     }
 
     return queryResult;
 }
+
+auto Nedrysoft::IPAPIGeoIPProvider::Cache::updateMemory(const QJsonObject &record) -> void {
+    auto size = static_cast<qint64>(sizeof(QJsonObject))+QJsonDocument(record).toJson(QJsonDocument::Compact).size();
+
+    if (!m_recordSize) {
+        m_recordSize = size;
+    } else {
+        m_recordSize += (size-m_recordSize)/RecordSizeGain;
+    }
+
+    auto records = static_cast<qint64>(m_recent.count()+m_pendingRecords.count());
+
+    m_memory.set(records*m_recordSize, records);
+}
@@ -24,11 +24,26 @@
 #ifndef PINGNOO_COMPONENTS_IPAPIGEOIPPROVIDER_CACHE_H
 #define PINGNOO_COMPONENTS_IPAPIGEOIPPROVIDER_CACHE_H
 
+#include <Diagnostics>
+#include <QCache>
 #include <QJsonObject>
+#include <QList>
+#include <QTimer>
+
+class QObject;
+class QThread;
 
 namespace Nedrysoft { namespace IPAPIGeoIPProvider {
     /**
      * @brief       The Cache class provides a basic cache for IP results to prevent too many requests being made.
+     *
+     * @details     Recently used results are held in memory so that repeated lookups of the same hop do not touch
+     *              the database, new results are written to the database in batches inside a single transaction.
+     *
+     *              The database is kept in write ahead log mode and every write is made on a thread of its own
+     *              with a second connection, so a lookup only ever reads and is never held up by a commit waiting
+     *              for the disk.  Results older than a month are treated as missing and are removed from the
+     *              database when it is compacted, which is done when the cache is opened and then every hour.
      */
     class Cache {
         public:
@@ -58,6 +73,70 @@ namespace Nedrysoft { namespace IPAPIGeoIPProvider {
              * @returns     returns true if cached; otherwise false.
              */
             auto find(const QString &name, QJsonObject &object) -> bool;
+
+        private:
+            /**
+             * @brief       Hands the pending records to the database thread to be written.
+             */
+            auto flush() -> void;
+
+            /**
+             * @brief       Opens the connection that the database thread writes with.
+             *
+             * @note        Called on the database thread.
+             *
+             * @param[in]   filename the filename of the database.
+             */
+            auto openWriter(const QString &filename) -> void;
+
+            /**
+             * @brief       Writes records to the database in a single transaction.
+             *
+             * @note        Called on the database thread.
+             *
+             * @param[in]   records the records to write.
+             */
+            auto write(const QList<QJsonObject> &records) -> void;
+
+            /**
+             * @brief       Removes expired results and truncates the write ahead log.
+             *
+             * @note        Called on the database thread.
+             */
+            auto compact() -> void;
+
+            /**
+             * @brief       Returns whether a result is too old to be used.
+             *
+             * @param[in]   object the cached result.
+             *
+             * @returns     true if the result has expired; otherwise false.
+             */
+            auto isExpired(const QJsonObject &object) -> bool;
+
+            /**
+             * @brief       Updates the accounted memory after a record has been added.
+             *
+             * @details     QCache does not report evictions, so the size is estimated from the number of records
+             *              held and the average size of the records added.
+             *
+             * @param[in]   record the record that was added.
+             */
+            auto updateMemory(const QJsonObject &record) -> void;
+
+        private:
+            //! @cond
+
+            QCache<QString, QJsonObject> m_recent;
+            QList<QJsonObject> m_pendingRecords;
+            QTimer m_flushTimer;
+            QTimer m_compactionTimer;
+            QThread *m_thread;
+            QObject *m_context;
+            qint64 m_recordSize;
+            Nedrysoft::Core::MemoryCounter m_memory;
+
+            //! @endcond
     };
 }}
 
@@ -25,14 +25,26 @@
 
 #include "Cache.h"
 
+#include <Clock>
+#include <QDateTime>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
 
+constexpr auto BatchEndpoint = "http://ip-api.com/batch";
+constexpr auto BatchWindow = 100;
+constexpr auto MaximumBatchSize = 100;
+
 Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider::IPAPIGeoIPProvider() :
-        m_cache(new Nedrysoft::IPAPIGeoIPProvider::Cache()) {
+        m_cache(new Nedrysoft::IPAPIGeoIPProvider::Cache()),
+        m_networkAccessManager(new QNetworkAccessManager(this)) {
+
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(BatchWindow);
 
+    connect(&m_batchTimer, &QTimer::timeout, this, &IPAPIGeoIPProvider::sendBatch);
 }
 
 Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider::~IPAPIGeoIPProvider() {
@@ -47,53 +59,110 @@ auto Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider::lookup(
 
     if (m_cache->find(host, cacheResultObject)) {
         function(host, cacheResultObject.toVariantMap());
-    } else {
-        const auto mapFields =
-                QStringList() << "creationTime" << "country" << "countryCode" << "region" << "regionName" << "city"
-                              << "zip" << "lat" "lon" << "timezone" << "isp" << "org";
-        auto manager = new QNetworkAccessManager();
 
-        connect(manager, &QNetworkAccessManager::finished, [=](QNetworkReply *reply) {
-            if (reply->error() == QNetworkReply::NoError) {
-                auto resultMap = QVariantMap();
-                auto jsonDocument = QJsonDocument::fromJson(reply->readAll());
+        return;
+    }
 
-                if (!jsonDocument.isObject()) {
-                    auto requiredFields = QStringList(mapFields) << "as";
-                    auto responseValid = true;
+    /**
+     * a host that already has a request in flight just waits for that reply, every hop of a route that is
+     * re-discovered would otherwise send its own request for the same address.
+     */
 
-                    for (const auto &field : requiredFields) {
-                        if (!jsonDocument.object().contains(field)) {
-                            responseValid = false;
-                            break;
-                        }
-                    }
+    if (m_pendingLookups.contains(host)) {
+        m_pendingLookups[host].append(function);
+
+        return;
+    }
 
-                    if (responseValid) {
-                        m_cache->add(jsonDocument.object());
+    m_pendingLookups[host].append(function);
 
-                        for (const auto &field : mapFields) {
-                            resultMap[field] = jsonDocument.object()[field].toVariant();
-                        }
+    /**
+     * lookups are collected for a short window and sent to the batch endpoint together, ip-api rate limits by
+     * request so a whole route costs one request rather than one per hop.
+     */
 
-                        resultMap["creationTime"] = QDateTime::currentDateTimeUtc().toTime_t();
-                        resultMap["asn"] = jsonDocument.object()["as"].toVariant();
+    m_batchQueue.append(host);
 
-                        function(host, resultMap);
+    if (m_batchQueue.count()>=MaximumBatchSize) {
+        sendBatch();
+    } else if (!m_batchTimer.isActive()) {
+        m_batchTimer.start();
+    }
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider::sendBatch() -> void {
+    m_batchTimer.stop();
+
+    while (!m_batchQueue.isEmpty()) {
+        auto hosts = m_batchQueue.mid(0, MaximumBatchSize);
+        auto requestArray = QJsonArray();
+
+        m_batchQueue = m_batchQueue.mid(hosts.count());
+
+        for (const auto &host : hosts) {
+            requestArray.append(host);
+        }
+
+        auto request = QNetworkRequest(QUrl(BatchEndpoint));
+
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+        auto reply = m_networkAccessManager->post(request, QJsonDocument(requestArray).toJson(QJsonDocument::Compact));
+
+        connect(reply, &QNetworkReply::finished, this, [this, hosts, reply]() {
+            if (reply->error() == QNetworkReply::NoError) {
+                auto jsonDocument = QJsonDocument::fromJson(reply->readAll());
+
+                for (const auto &value : jsonDocument.array()) {
+                    if (value.isObject()) {
+                        processResult(value.toObject());
                     }
                 }
             }
 
-            reply->deleteLater();
+            /**
+             * any host that did not get a valid result is dropped so that a later lookup tries again.
+             */
 
-            auto manager = qobject_cast<QNetworkAccessManager *>(sender());
-
-            if (manager) {
-                manager->deleteLater();
+            for (const auto &host : hosts) {
+                m_pendingLookups.remove(host);
             }
+
+            reply->deleteLater();
         });
+    }
+}
+
+auto Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider::processResult(const QJsonObject &object) -> void {
+    const auto mapFields =
+            QStringList() << "creationTime" << "country" << "countryCode" << "region" << "regionName" << "city"
+                          << "zip" << "lat" << "lon" << "timezone" << "isp" << "org";
+
+    auto requiredFields = QStringList(mapFields) << "as" << "query";
+
+    requiredFields.removeAll("creationTime");
+
+    for (const auto &field : requiredFields) {
+        if (!object.contains(field)) {
+            return;
+        }
+    }
+
+    auto host = object["query"].toString();
+    auto functions = m_pendingLookups.take(host);
+    auto resultMap = QVariantMap();
+
+    m_cache->add(object);
+
+    for (const auto &field : mapFields) {
+        resultMap[field] = object[field].toVariant();
+    }
+
+    resultMap["creationTime"] = Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch();
+    resultMap["asn"] = object["as"].toVariant();
 
-        manager->get(QNetworkRequest(QUrl("http://ip-api.com/json/" + host)));
+    for (const auto &function : functions) {
+        function(host, resultMap);
     }
 }
 
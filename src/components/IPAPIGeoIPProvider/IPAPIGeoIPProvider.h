@@ -29,9 +29,16 @@
 #include "IPAPIGeoIPProvider.h"
 #include "IPAPIGeoIPProviderSpec.h"
 
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
 #include <QObject>
+#include <QStringList>
+#include <QTimer>
 #include <QVariantMap>
 
+class QNetworkAccessManager;
+
 namespace Nedrysoft { namespace IPAPIGeoIPProvider {
     class Cache;
 
@@ -84,10 +91,30 @@ namespace Nedrysoft { namespace IPAPIGeoIPProvider {
              */
             auto lookup(const QString host, Nedrysoft::Core::GeoFunction function) -> void override;
 
+        private:
+            /**
+             * @brief       Sends the queued lookups to the batch endpoint.
+             *
+             * @details     Hosts are sent in groups of up to 100 per request, which is the most the endpoint
+             *              accepts.
+             */
+            auto sendBatch() -> void;
+
+            /**
+             * @brief       Caches a result from the batch endpoint and passes it to the waiting functions.
+             *
+             * @param[in]   object the result for a single host.
+             */
+            auto processResult(const QJsonObject &object) -> void;
+
         private:
              //! @cond
 
             Nedrysoft::IPAPIGeoIPProvider::Cache *m_cache;
+            QNetworkAccessManager *m_networkAccessManager;
+            QHash<QString, QList<Nedrysoft::Core::GeoFunction> > m_pendingLookups;
+            QStringList m_batchQueue;
+            QTimer m_batchTimer;
 
              //! @endcond
     };
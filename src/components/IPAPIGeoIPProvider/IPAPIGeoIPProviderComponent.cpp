@@ -24,6 +24,7 @@
 #include "IPAPIGeoIPProviderComponent.h"
 
 #include "ComponentSystem/IComponentManager.h"
+#include <ObjectRegistry>
 
 IPAPIGeoIPProviderComponent::IPAPIGeoIPProviderComponent() :
         m_provider(nullptr) {
@@ -37,12 +38,12 @@ IPAPIGeoIPProviderComponent::~IPAPIGeoIPProviderComponent() {
 auto IPAPIGeoIPProviderComponent::initialiseEvent() -> void {
     m_provider = new Nedrysoft::IPAPIGeoIPProvider::IPAPIGeoIPProvider();
 
-    Nedrysoft::ComponentSystem::addObject(m_provider);
+    Nedrysoft::Core::ObjectRegistry::getInstance()->addObject(m_provider);
 }
 
 auto IPAPIGeoIPProviderComponent::finaliseEvent() -> void {
     if (m_provider) {
-        Nedrysoft::ComponentSystem::removeObject(m_provider);
+        Nedrysoft::Core::ObjectRegistry::getInstance()->removeObject(m_provider);
 
         delete m_provider;
     }
@@ -28,6 +28,8 @@
 
 #pragma warning(pop)
 
+#include <Diagnostics>
+
 constexpr auto RoundedRectangleRadius = 10;
 constexpr auto JitterTargetLineWidth = 1;
 constexpr auto JitterBackgroundColor = qRgb(0x77, 0xdc, 0xef);
@@ -43,6 +45,8 @@ Nedrysoft::JitterPlot::JitterBackgroundLayer::JitterBackgroundLayer(QCustomPlot
 }
 
 auto Nedrysoft::JitterPlot::JitterBackgroundLayer::draw(QCPPainter *painter) -> void {
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Jitter background draw (ms)");
+
     auto rect = parentPlot()->axisRect()->rect();
     auto topLeft = rect.topLeft();
 
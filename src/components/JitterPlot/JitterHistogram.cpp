@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JitterHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr auto MinimumJitter = 0.0001;
+constexpr auto Decades = 4;
+constexpr auto BinsPerDecade = 10;
+constexpr auto BinCount = Decades*BinsPerDecade;
+constexpr auto InitialSnapshotInterval = 10.0;
+constexpr auto MaximumSnapshots = 4096;
+
+Nedrysoft::JitterPlot::JitterHistogram::JitterHistogram() :
+        m_counts(BinCount, 0),
+        m_snapshotInterval(InitialSnapshotInterval),
+        m_count(0) {
+
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::add(double time, double jitter) -> void {
+    /**
+     * the snapshot holds the counts of the values before its time, so it is taken before the value is added.  A
+     * session with a long gap leaves a single snapshot at the end of the gap rather than one per interval.
+     */
+
+    if ((m_snapshots.empty()) || (time>=m_snapshots.back().time+m_snapshotInterval)) {
+        m_snapshots.push_back(Snapshot{time, m_counts});
+
+        if (m_snapshots.size()>static_cast<size_t>(MaximumSnapshots)) {
+            auto kept = std::vector<Snapshot>();
+
+            kept.reserve(MaximumSnapshots/2+1);
+
+            for (size_t index=0;index<m_snapshots.size();index+=2) {
+                kept.push_back(std::move(m_snapshots[index]));
+            }
+
+            m_snapshots.swap(kept);
+            m_snapshotInterval *= 2;
+        }
+    }
+
+    m_counts[static_cast<size_t>(binIndex(jitter))]++;
+    m_count++;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::countsBefore(double time) const -> const std::vector<quint64> & {
+    static const std::vector<quint64> emptyCounts(BinCount, 0);
+
+    auto snapshot = std::upper_bound(
+            m_snapshots.begin(),
+            m_snapshots.end(),
+            time,
+            [](double value, const Snapshot &snapshot) {
+                return value<snapshot.time;
+            } );
+
+    if (snapshot==m_snapshots.begin()) {
+        return emptyCounts;
+    }
+
+    return std::prev(snapshot)->counts;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::counts(double startTime, double endTime) const -> std::vector<quint64> {
+    if (m_snapshots.empty()) {
+        return m_counts;
+    }
+
+    // a period that ends after the last snapshot includes the values that have been added since.
+
+    auto &endCounts = ((endTime<0) || (endTime>=m_snapshots.back().time+m_snapshotInterval)) ?
+            m_counts : countsBefore(endTime);
+
+    if (startTime<0) {
+        return endCounts;
+    }
+
+    auto &startCounts = countsBefore(startTime);
+    auto result = std::vector<quint64>(BinCount, 0);
+
+    for (auto bin=0;bin<BinCount;bin++) {
+        auto index = static_cast<size_t>(bin);
+
+        result[index] = (endCounts[index]>startCounts[index]) ? endCounts[index]-startCounts[index] : 0;
+    }
+
+    return result;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::count() const -> quint64 {
+    return m_count;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::clear() -> void {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+
+    m_snapshots.clear();
+    m_snapshotInterval = InitialSnapshotInterval;
+    m_count = 0;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::binCount() -> int {
+    return BinCount;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::binEdge(int bin) -> double {
+    return MinimumJitter*std::pow(10.0, static_cast<double>(bin)/BinsPerDecade);
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogram::binIndex(double jitter) -> int {
+    if (!(jitter>MinimumJitter)) {
+        return 0;
+    }
+
+    auto bin = static_cast<int>(std::floor(std::log10(jitter/MinimumJitter)*BinsPerDecade));
+
+    return std::min(bin, BinCount-1);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAM_H
+#define NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAM_H
+
+#include <QtGlobal>
+#include <vector>
+
+namespace Nedrysoft { namespace JitterPlot {
+    /**
+     * @brief       The JitterHistogram class counts the jitter of a hop in logarithmically spaced bins.
+     *
+     * @details     Adding a value increments a single bin, so the distribution of a long session costs the same
+     *              to keep up to date as a short one.  A copy of the bins is taken at regular times, the counts
+     *              between two times are the difference between the copies taken at those times, so the
+     *              distribution of any period can be found without revisiting the samples.
+     *
+     *              The number of copies is bounded, when the limit is reached every other copy is discarded and
+     *              the spacing doubles, so the period a distribution covers is accurate to the current spacing.
+     */
+    class JitterHistogram {
+        public:
+            /**
+             * @brief       Constructs an empty JitterHistogram.
+             */
+            JitterHistogram();
+
+            /**
+             * @brief       Adds a value.
+             *
+             * @note        Values must be added in time order.
+             *
+             * @param[in]   time the unix timestamp of the value.
+             * @param[in]   jitter the jitter in seconds.
+             */
+            auto add(double time, double jitter) -> void;
+
+            /**
+             * @brief       Returns the counts of the bins.
+             *
+             * @param[in]   startTime the unix timestamp of the start of the period; or a negative value for the
+             *              start of the session.
+             * @param[in]   endTime the unix timestamp of the end of the period; or a negative value for the end
+             *              of the session.
+             *
+             * @returns     the count of each bin.
+             */
+            auto counts(double startTime=-1, double endTime=-1) const -> std::vector<quint64>;
+
+            /**
+             * @brief       Returns the number of values that have been added.
+             *
+             * @returns     the number of values.
+             */
+            auto count() const -> quint64;
+
+            /**
+             * @brief       Removes every value.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of bins.
+             *
+             * @returns     the number of bins.
+             */
+            static auto binCount() -> int;
+
+            /**
+             * @brief       Returns the lowest value counted by a bin.
+             *
+             * @details     The first bin also counts the values below its lower edge, and the last bin the values
+             *              above its upper edge.
+             *
+             * @param[in]   bin the bin, binCount() returns the upper edge of the last bin.
+             *
+             * @returns     the jitter in seconds.
+             */
+            static auto binEdge(int bin) -> double;
+
+            /**
+             * @brief       Returns the bin that counts a value.
+             *
+             * @param[in]   jitter the jitter in seconds.
+             *
+             * @returns     the bin.
+             */
+            static auto binIndex(double jitter) -> int;
+
+        private:
+            /**
+             * @brief       Returns the counts of the values added before a time.
+             *
+             * @param[in]   time the unix timestamp.
+             *
+             * @returns     the count of each bin.
+             */
+            auto countsBefore(double time) const -> const std::vector<quint64> &;
+
+        private:
+            //! @cond
+
+            struct Snapshot {
+                double time;
+                std::vector<quint64> counts;
+            };
+
+            std::vector<quint64> m_counts;
+            std::vector<Snapshot> m_snapshots;
+
+            double m_snapshotInterval;
+            quint64 m_count;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAM_H
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JitterHistogramPlot.h"
+
+#include <ICore>
+#include <LatencySettings>
+#include <QMenu>
+#include <cmath>
+
+constexpr auto DefaultGraphHeight = 150;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto PercentScale = 100.0;
+constexpr auto MinimumPercentRange = 1.0;
+constexpr auto PercentHeadroom = 1.1;
+
+Nedrysoft::JitterPlot::JitterHistogramPlot::JitterHistogramPlot(const QMargins &margins) :
+        m_customPlot(nullptr),
+        m_targetLine(nullptr),
+        m_margins(margins),
+        m_previousRoundTripTime(-1),
+        m_viewportStart(-1),
+        m_viewportEnd(-1),
+        m_targetJitter(-1),
+        m_viewportOnly(false),
+        m_replotPending(false) {
+
+}
+
+Nedrysoft::JitterPlot::JitterHistogramPlot::~JitterHistogramPlot() {
+
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::widget() -> QWidget * {
+    auto customPlot = new QCustomPlot();
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        if (latencySettings->hardwareAcceleration()) {
+            customPlot->setOpenGl(true);
+        }
+
+        QObject::connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::hardwareAccelerationChanged,
+            customPlot,
+            [customPlot](bool useHardwareAcceleration) {
+                customPlot->setOpenGl(useHardwareAcceleration);
+                customPlot->replot(QCustomPlot::rpQueuedReplot);
+            }
+        );
+    }
+
+    customPlot->setMinimumHeight(DefaultGraphHeight);
+
+    customPlot->addGraph();
+
+    customPlot->axisRect()->setAutoMargins(QCP::msNone);
+    customPlot->axisRect()->setMargins(m_margins);
+
+    // the bins are logarithmically spaced, so the jitter axis is logarithmic and each bin is drawn the same width.
+
+    customPlot->xAxis->setScaleType(QCPAxis::stLogarithmic);
+    customPlot->xAxis->setTicker(QSharedPointer<QCPAxisTickerLog>(new QCPAxisTickerLog));
+    customPlot->xAxis->setLabel(tr("Jitter (ms)"));
+    customPlot->xAxis->setRange(
+            Nedrysoft::JitterPlot::JitterHistogram::binEdge(0)*MillisecondsInSecond,
+            Nedrysoft::JitterPlot::JitterHistogram::binEdge(
+                    Nedrysoft::JitterPlot::JitterHistogram::binCount() )*MillisecondsInSecond );
+
+    customPlot->yAxis->setLabel(tr("Replies (%)"));
+    customPlot->yAxis->setRange(0, MinimumPercentRange);
+    customPlot->yAxis->ticker()->setTickCount(2);
+
+    customPlot->graph(0)->setLineStyle(QCPGraph::lsStepLeft);
+    customPlot->graph(0)->setPen(QPen(Qt::black, 1));
+    customPlot->graph(0)->setBrush(QBrush(QColor(0, 0, 0, 40)));
+
+    m_targetLine = new QCPItemStraightLine(customPlot);
+
+    m_targetLine->setPen(QPen(Qt::darkGreen, 1, Qt::DashLine));
+    m_targetLine->setVisible(false);
+
+    QPalette palette = Nedrysoft::Core::mainWindow()->palette();
+
+    customPlot->setBackground(palette.color(QPalette::Base));
+
+    customPlot->xAxis->setLabelColor(palette.color(QPalette::Text));
+    customPlot->yAxis->setLabelColor(palette.color(QPalette::Text));
+    customPlot->xAxis->setTickLabelColor(palette.color(QPalette::Text));
+    customPlot->yAxis->setTickLabelColor(palette.color(QPalette::Text));
+
+    /**
+     * scroll wheel events, by default QCustomPlot does not propagate these so this code ensures that they cause
+     * the scroll area to scroll.
+     */
+
+    connect(customPlot, &QCustomPlot::mouseWheel, [=](QWheelEvent *event) {
+        auto parentWidget = customPlot->parentWidget();
+
+        while(parentWidget) {
+            auto scrollArea = qobject_cast<QAbstractScrollArea *>(parentWidget);
+
+            if (scrollArea) {
+                scrollArea->verticalScrollBar()->setValue(
+                        scrollArea->verticalScrollBar()->value() - event->angleDelta().y() );
+
+                break;
+            }
+
+            parentWidget = parentWidget->parentWidget();
+        }
+    });
+
+    customPlot->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    connect(customPlot, &QWidget::customContextMenuRequested, [=](const QPoint &point) {
+        QMenu menu;
+
+        auto viewportAction = menu.addAction(tr("Visible Period Only"));
+
+        viewportAction->setCheckable(true);
+        viewportAction->setChecked(m_viewportOnly);
+
+        if (menu.exec(customPlot->mapToGlobal(point))==viewportAction) {
+            setViewportOnly(viewportAction->isChecked());
+        }
+    });
+
+    m_customPlot = customPlot;
+
+    setRange(m_targetJitter, -1);
+
+    updateGraph();
+
+    return customPlot;
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::update(double time, double value) -> void {
+    Sample sample = {time, value};
+
+    updateSamples(&sample, 1);
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::updateSamples(const Sample *samples, int count) -> void {
+    for (auto index=0;index<count;index++) {
+        auto roundTripTime = samples[index].roundTripTime;
+
+        if (m_previousRoundTripTime>=0) {
+            m_histogram.add(samples[index].time, std::fabs(roundTripTime-m_previousRoundTripTime));
+        }
+
+        m_previousRoundTripTime = roundTripTime;
+    }
+
+    if (count) {
+        m_replotPending = true;
+    }
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::updateJitter(double time, double jitter) -> void {
+    Q_UNUSED(time)
+    Q_UNUSED(jitter)
+
+    /**
+     * the smoothed jitter of the hop statistics would hide the spread, the distribution is built from the
+     * replies themselves.
+     */
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::frameReady() -> void {
+    if ((!m_customPlot) || (!m_replotPending)) {
+        return;
+    }
+
+    // a hidden plot keeps its pending replot until it is next visible at the end of a frame.
+
+    if ((m_customPlot->isVisible()) && (!m_customPlot->visibleRegion().isEmpty())) {
+        updateGraph();
+
+        m_customPlot->replot(QCustomPlot::rpQueuedReplot);
+
+        m_replotPending = false;
+    }
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::updateRange(double min, double max) -> void {
+    m_viewportStart = min;
+    m_viewportEnd = max;
+
+    if ((m_customPlot) && (m_viewportOnly)) {
+        updateGraph();
+
+        m_customPlot->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::setRange(double targetJitter, double maximumJitter) -> void {
+    Q_UNUSED(maximumJitter)
+
+    m_targetJitter = targetJitter;
+
+    if (!m_customPlot) {
+        return;
+    }
+
+    m_targetLine->setVisible(m_targetJitter>0);
+
+    if (m_targetJitter>0) {
+        m_targetLine->point1->setCoords(m_targetJitter*MillisecondsInSecond, 0);
+        m_targetLine->point2->setCoords(m_targetJitter*MillisecondsInSecond, 1);
+    }
+
+    m_customPlot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::setViewportOnly(bool viewportOnly) -> void {
+    m_viewportOnly = viewportOnly;
+
+    if (m_customPlot) {
+        updateGraph();
+
+        m_customPlot->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
+
+auto Nedrysoft::JitterPlot::JitterHistogramPlot::updateGraph() -> void {
+    auto counts = m_viewportOnly ? m_histogram.counts(m_viewportStart, m_viewportEnd) : m_histogram.counts();
+    auto binCount = Nedrysoft::JitterPlot::JitterHistogram::binCount();
+    auto total = 0.0;
+
+    for (auto count : counts) {
+        total += static_cast<double>(count);
+    }
+
+    QVector<double> keys(binCount+1);
+    QVector<double> values(binCount+1);
+
+    auto maximumPercent = MinimumPercentRange;
+
+    for (auto bin=0;bin<binCount;bin++) {
+        auto percent = (total>0) ? static_cast<double>(counts[static_cast<size_t>(bin)])*PercentScale/total : 0;
+
+        keys[bin] = Nedrysoft::JitterPlot::JitterHistogram::binEdge(bin)*MillisecondsInSecond;
+        values[bin] = percent;
+
+        maximumPercent = std::max(maximumPercent, percent);
+    }
+
+    // the step graph needs a final point at the upper edge of the last bin to draw it.
+
+    keys[binCount] = Nedrysoft::JitterPlot::JitterHistogram::binEdge(binCount)*MillisecondsInSecond;
+    values[binCount] = values[binCount-1];
+
+    m_customPlot->graph(0)->setData(keys, values, true);
+    m_customPlot->yAxis->setRange(0, maximumPercent*PercentHeadroom);
+}
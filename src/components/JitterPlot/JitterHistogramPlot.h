@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOT_H
+#define NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOT_H
+
+#include "JitterHistogram.h"
+
+#include <IPlot>
+
+#include "QCustomPlot/qcustomplot.h"
+
+namespace Nedrysoft { namespace JitterPlot {
+    /**
+     * @brief       Implementation of a plot of the distribution of the jitter of a hop.
+     *
+     * @details     The jitter of each reply is the difference between its round trip time and that of the previous
+     *              reply (the instantaneous packet delay variation), which is counted in a JitterHistogram.  The plot
+     *              shows either the whole session or only the period shown by the viewport.
+     */
+    class JitterHistogramPlot :
+            public Nedrysoft::RouteAnalyser::IPlot {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPlot)
+
+        public:
+            /**
+             * @brief       Constructs a JitterHistogramPlot.
+             *
+             * @param[in]   margins the margins for rendering the plot.
+             */
+            explicit JitterHistogramPlot(const QMargins &margins);
+
+            /**
+             * @brief       Destroys the JitterHistogramPlot.
+             */
+            ~JitterHistogramPlot();
+
+        public:
+            /**
+             * @brief       Returns the widget for this plot.
+             *
+             * @returns     the widget.
+             */
+            auto widget() -> QWidget * override;
+
+            /**
+             * @brief       Updates the plot with a new result.
+             *
+             * @param[in]   time the unix timestamp for this result.
+             * @param[in]   value the round trip time.
+             */
+            auto update(double time, double value) -> void override;
+
+            /**
+             * @brief       Updates the plot with the replies received since the previous update.
+             *
+             * @param[in]   samples the samples.
+             * @param[in]   count the number of samples.
+             */
+            auto updateSamples(const Sample *samples, int count) -> void override;
+
+            /**
+             * @brief       Updates the plot with the jitter of the hop after a new result.
+             *
+             * @param[in]   time the unix timestamp for this result.
+             * @param[in]   jitter the jitter in seconds.
+             */
+            auto updateJitter(double time, double jitter) -> void override;
+
+            /**
+             * @brief       Redraws the plot if the distribution has changed since the previous frame.
+             */
+            auto frameReady() -> void override;
+
+            /**
+             * @brief       Update the visible area (viewport) of the graph.
+             *
+             * @param[in]   min the minimum displayed value.
+             * @param[in]   max the maximum dispkayed value.
+             */
+            auto updateRange(double min, double max) -> void override;
+
+            /**
+             * @brief       Sets the jitter range.
+             *
+             * @note        The target value is drawn as a line across the distribution.
+             *
+             * @param[in]   targetJitter the target value in seconds.
+             * @param[in]   maximumJitter the maximum value to show on the jitter graph.
+             */
+            auto setRange(double targetJitter, double maximumJitter) -> void override;
+
+            /**
+             * @brief       Sets whether the plot shows only the period shown by the viewport.
+             *
+             * @param[in]   viewportOnly true if only the viewport is shown; otherwise false for the whole session.
+             */
+            auto setViewportOnly(bool viewportOnly) -> void;
+
+        private:
+            /**
+             * @brief       Copies the counts of the bins to the graph.
+             */
+            auto updateGraph() -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::JitterPlot::JitterHistogram m_histogram;
+
+            QCustomPlot *m_customPlot;
+            QCPItemStraightLine *m_targetLine;
+            QMargins m_margins;
+
+            double m_previousRoundTripTime;
+            double m_viewportStart;
+            double m_viewportEnd;
+            double m_targetJitter;
+
+            bool m_viewportOnly;
+            bool m_replotPending;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOT_H
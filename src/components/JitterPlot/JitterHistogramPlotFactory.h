@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 14/03/2021.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOTFACTORY_H
+#define NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOTFACTORY_H
+
+#include <IPlotFactory>
+#include <IPlot>
+#include <QList>
+
+namespace Nedrysoft { namespace JitterPlot {
+    /**
+     * @brief       Factory class for jitter distribution plots
+     */
+    class JitterHistogramPlotFactory :
+            public Nedrysoft::RouteAnalyser::IPlotFactory {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPlotFactory)
+
+        public:
+            /**
+             * @brief       Constructs a JitterHistogramPlotFactory.
+             */
+            JitterHistogramPlotFactory();
+
+            /**
+             * @brief       Destroys the JitterHistogramPlotFactory.
+             */
+            ~JitterHistogramPlotFactory();
+
+        public:
+            /**
+             * @brief       Creates a new jitter distribution plot.
+             *
+             * @param[in]   margins the margins for rendering the plot.
+             *
+             * @returns     the plot.
+             */
+            auto createPlot(const QMargins &margins) -> Nedrysoft::RouteAnalyser::IPlot * override;
+
+        private:
+            //! @cond
+
+            QList<Nedrysoft::RouteAnalyser::IPlot *> m_plots;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_JITTERPLOT_JITTERHISTOGRAMPLOTFACTORY_H
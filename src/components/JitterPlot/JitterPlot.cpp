@@ -24,8 +24,10 @@
 #include "JitterPlot.h"
 
 #include "CPAxisTickerMS.h"
+#include <Clock>
 #include <ICore>
 #include "JitterBackgroundLayer.h"
+#include <LatencySettings>
 
 #include <QLabel>
 #include <cmath>
@@ -34,8 +36,8 @@ constexpr auto DefaultGraphHeight = 150;
 
 Nedrysoft::JitterPlot::JitterPlot::JitterPlot(const QMargins &margins) :
         m_customPlot(0),
-        m_previousValue(-1),
-        m_margins(margins) {
+        m_margins(margins),
+        m_replotPending(false) {
 
 }
 
@@ -52,6 +54,24 @@ auto Nedrysoft::JitterPlot::JitterPlot::widget() -> QWidget * {
 
     customPlot->setCurrentLayer("main");
 
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        if (latencySettings->hardwareAcceleration()) {
+            customPlot->setOpenGl(true);
+        }
+
+        QObject::connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::hardwareAccelerationChanged,
+            customPlot,
+            [customPlot](bool useHardwareAcceleration) {
+                customPlot->setOpenGl(useHardwareAcceleration);
+                customPlot->replot(QCustomPlot::rpQueuedReplot);
+            }
+        );
+    }
+
     customPlot->setMinimumHeight(DefaultGraphHeight);
 
     customPlot->addGraph();
@@ -73,11 +93,7 @@ auto Nedrysoft::JitterPlot::JitterPlot::widget() -> QWidget * {
 
     customPlot->xAxis->setVisible(false);
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
-    auto secondsSinceEpoch = QDateTime::currentSecsSinceEpoch();
-#else
-    auto secondsSinceEpoch = abs(QDateTime::currentDateTime().secsTo(QDateTime(QDate(1970,1,1), QTime(0, 0))));
-#endif
+    auto secondsSinceEpoch = Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch();
 
     customPlot->xAxis->setRange(
             static_cast<double>(secondsSinceEpoch),
@@ -123,18 +139,38 @@ auto Nedrysoft::JitterPlot::JitterPlot::widget() -> QWidget * {
 }
 
 auto Nedrysoft::JitterPlot::JitterPlot::update(double time, double value) -> void {
+    Q_UNUSED(time)
+    Q_UNUSED(value)
+
+    /**
+     * the graph shows the jitter computed by the hop statistics, which arrives through updateJitter.
+     */
+}
+
+auto Nedrysoft::JitterPlot::JitterPlot::updateSamples(const Sample *samples, int count) -> void {
+    Q_UNUSED(samples)
+    Q_UNUSED(count)
+}
+
+auto Nedrysoft::JitterPlot::JitterPlot::updateJitter(double time, double jitter) -> void {
     if (m_customPlot) {
-        if (m_previousValue!=-1) {
-            m_customPlot->graph(0)->addData(time, std::abs(value - m_previousValue));
-        }
+        m_customPlot->graph(0)->addData(time, jitter);
 
-        m_previousValue = value;
+        m_replotPending = true;
+    }
+}
 
-        if (m_customPlot->isVisible()) {
-            if (!m_customPlot->visibleRegion().isEmpty()) {
-                m_customPlot->replot(QCustomPlot::rpQueuedReplot);
-            }
-        }
+auto Nedrysoft::JitterPlot::JitterPlot::frameReady() -> void {
+    if ((!m_customPlot) || (!m_replotPending)) {
+        return;
+    }
+
+    // a hidden plot keeps its pending replot until it is next visible at the end of a frame.
+
+    if ((m_customPlot->isVisible()) && (!m_customPlot->visibleRegion().isEmpty())) {
+        m_customPlot->replot(QCustomPlot::rpQueuedReplot);
+
+        m_replotPending = false;
     }
 }
 
@@ -69,6 +69,27 @@ namespace Nedrysoft { namespace JitterPlot {
              */
             auto update(double time, double value) -> void override;
 
+            /**
+             * @brief       Updates the plot with the replies received since the previous update.
+             *
+             * @param[in]   samples the samples.
+             * @param[in]   count the number of samples.
+             */
+            auto updateSamples(const Sample *samples, int count) -> void override;
+
+            /**
+             * @brief       Updates the plot with the jitter of the hop after a new result.
+             *
+             * @param[in]   time the unix timestamp for this result.
+             * @param[in]   jitter the jitter in seconds.
+             */
+            auto updateJitter(double time, double jitter) -> void override;
+
+            /**
+             * @brief       Redraws the plot if the jitter has changed since the previous frame.
+             */
+            auto frameReady() -> void override;
+
             /**
              * @brief       Update the visible area (viewport) of the graph.
              * @param[in]   min the minimum displayed value.
@@ -91,9 +112,9 @@ namespace Nedrysoft { namespace JitterPlot {
             //! @cond
 
             QCustomPlot *m_customPlot;
-            double m_previousValue;
             Nedrysoft::JitterPlot::JitterBackgroundLayer *m_backgroundLayer;
             QMargins m_margins;
+            bool m_replotPending;
 
             //! @endcond
     };
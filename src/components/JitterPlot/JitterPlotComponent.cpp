@@ -23,12 +23,15 @@
 
 #include "JitterPlotComponent.h"
 
+#include "JitterHistogramPlotFactory.h"
 #include "JitterPlotFactory.h"
 
 #include <IComponentManager>
+#include <ObjectRegistry>
 
 SystemTrayComponent::SystemTrayComponent() :
-        m_plotFactory(nullptr) {
+        m_plotFactory(nullptr),
+        m_histogramPlotFactory(nullptr) {
 
 }
 
@@ -37,8 +40,14 @@ SystemTrayComponent::~SystemTrayComponent() {
 }
 
 auto SystemTrayComponent::finaliseEvent() -> void {
+    if (m_histogramPlotFactory) {
+        Nedrysoft::Core::ObjectRegistry::getInstance()->removeObject(m_histogramPlotFactory);
+
+        delete m_histogramPlotFactory;
+    }
+
     if (m_plotFactory) {
-        Nedrysoft::ComponentSystem::removeObject(m_plotFactory);
+        Nedrysoft::Core::ObjectRegistry::getInstance()->removeObject(m_plotFactory);
 
         delete m_plotFactory;
     }
@@ -47,5 +56,9 @@ auto SystemTrayComponent::finaliseEvent() -> void {
 auto SystemTrayComponent::initialiseEvent() -> void {
     m_plotFactory = new Nedrysoft::JitterPlot::JitterPlotFactory();
 
-    Nedrysoft::ComponentSystem::addObject(m_plotFactory);
+    Nedrysoft::Core::ObjectRegistry::getInstance()->addObject(m_plotFactory);
+
+    m_histogramPlotFactory = new Nedrysoft::JitterPlot::JitterHistogramPlotFactory();
+
+    Nedrysoft::Core::ObjectRegistry::getInstance()->addObject(m_histogramPlotFactory);
 }
@@ -29,6 +29,7 @@
 #include <IComponent>
 
 namespace Nedrysoft { namespace JitterPlot {
+    class JitterHistogramPlotFactory;
     class JitterPlotFactory;
 }}
 
@@ -81,6 +82,7 @@ class NEDRYSOFT_JITTERPLOT_DLLSPEC SystemTrayComponent :
         //! @cond
 
         Nedrysoft::JitterPlot::JitterPlotFactory *m_plotFactory;
+        Nedrysoft::JitterPlot::JitterHistogramPlotFactory *m_histogramPlotFactory;
 
         //! @endcond
 };
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LiveFeedComponent.h"
+
+#include "LiveFeedServer.h"
+
+#include <QHostAddress>
+#include <QSettings>
+
+#include <limits>
+
+constexpr auto PortSettingsKey = "LiveFeed/Port";
+constexpr auto AddressSettingsKey = "LiveFeed/Address";
+constexpr auto DefaultAddress = "127.0.0.1";
+
+LiveFeedComponent::LiveFeedComponent() :
+        m_liveFeedServer(nullptr) {
+
+}
+
+LiveFeedComponent::~LiveFeedComponent() {
+
+}
+
+auto LiveFeedComponent::finaliseEvent() -> void {
+    if (m_liveFeedServer) {
+        Nedrysoft::ComponentSystem::removeObject(m_liveFeedServer);
+
+        delete m_liveFeedServer;
+    }
+}
+
+auto LiveFeedComponent::initialiseEvent() -> void {
+    QSettings settings;
+
+    /**
+     * the server is optional, nothing is created (and no results are routed to it) until a port has been
+     * configured.
+     */
+
+    auto port = settings.value(PortSettingsKey, 0).toUInt();
+
+    if ((!port) || (port>std::numeric_limits<quint16>::max())) {
+        return;
+    }
+
+    m_liveFeedServer = new Nedrysoft::LiveFeed::LiveFeedServer();
+
+    if (!m_liveFeedServer->listen(
+            QHostAddress(settings.value(AddressSettingsKey, DefaultAddress).toString()),
+            static_cast<quint16>(port) )) {
+
+        delete m_liveFeedServer;
+
+        m_liveFeedServer = nullptr;
+
+        return;
+    }
+
+    Nedrysoft::ComponentSystem::addObject(m_liveFeedServer);
+}
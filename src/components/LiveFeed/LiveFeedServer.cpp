@@ -0,0 +1,465 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LiveFeedServer.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+constexpr auto ServerName = "Pingnoo";
+constexpr auto TickGranularity = 250;
+constexpr auto MinimumInterval = TickGranularity;
+constexpr auto MaximumInterval = 60000;
+constexpr auto DefaultInterval = 1000;
+constexpr auto MaximumPendingBytes = 1024*1024;
+constexpr auto MaximumMessageSize = 4096;
+constexpr auto MaximumSubscriptions = 32;
+constexpr auto SnapshotType = "snapshot";
+constexpr auto DeltaType = "delta";
+
+Nedrysoft::LiveFeed::LiveFeedServer::LiveFeedServer() :
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_server(nullptr),
+        m_processQueued(false),
+        m_version(0) {
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
+}
+
+Nedrysoft::LiveFeed::LiveFeedServer::~LiveFeedServer() {
+    /**
+     * the server, the clients and the feed timers belong to the worker thread, so they are destroyed there before
+     * it is stopped.
+     */
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        for (auto feed : m_feeds) {
+            delete feed->timer;
+            delete feed;
+        }
+
+        m_feeds.clear();
+
+        for (auto socket : m_clients) {
+            disconnect(socket, nullptr, m_context, nullptr);
+
+            delete socket;
+        }
+
+        m_clients.clear();
+
+        delete m_server;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::listen(const QHostAddress &address, quint16 port) -> bool {
+    auto listening = false;
+
+    QMetaObject::invokeMethod(m_context, [this, address, port, &listening]() {
+        delete m_server;
+
+        m_server = new QWebSocketServer(ServerName, QWebSocketServer::NonSecureMode, m_context);
+
+        if (!m_server->listen(address, port)) {
+            SPDLOG_ERROR(QString("Unable to serve the live feed on %1:%2. (%3)")
+                    .arg(address.toString())
+                    .arg(port)
+                    .arg(m_server->errorString()).toStdString());
+
+            delete m_server;
+
+            m_server = nullptr;
+
+            return;
+        }
+
+        connect(m_server, &QWebSocketServer::newConnection, m_context, [this]() {
+            while (m_server->hasPendingConnections()) {
+                auto socket = m_server->nextPendingConnection();
+
+                // client messages are small requests, anything larger is refused before it is buffered.
+
+                socket->setMaxAllowedIncomingFrameSize(MaximumMessageSize);
+                socket->setMaxAllowedIncomingMessageSize(MaximumMessageSize);
+
+                m_clients.append(socket);
+
+                connect(socket, &QWebSocket::textMessageReceived, m_context, [this, socket](const QString &message) {
+                    processMessage(socket, message);
+                });
+
+                connect(socket, &QWebSocket::disconnected, m_context, [this, socket]() {
+                    unsubscribe(socket);
+
+                    m_clients.removeAll(socket);
+
+                    socket->deleteLater();
+                });
+            }
+        });
+
+        listening = true;
+    }, Qt::BlockingQueuedConnection);
+
+    return listening;
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::update(
+        const QString &target,
+        int hop,
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    auto address = QHostAddress();
+
+    for (auto result=results.crbegin();result!=results.crend();result++) {
+        if (!Nedrysoft::RouteAnalyser::PingResult::isLost(result->code())) {
+            address = result->hostAddress();
+
+            break;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // the aggregates account for every earlier result, so only the latest of a hop is kept.
+
+    auto &update = m_pending[qMakePair(target, hop)];
+
+    update.statistics = statistics;
+
+    if (!address.isNull()) {
+        update.address = address;
+    }
+
+    queueProcess();
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::removeTarget(const QString &target) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    for (auto iterator=m_pending.begin();iterator!=m_pending.end();) {
+        if (iterator.key().first==target) {
+            iterator = m_pending.erase(iterator);
+        } else {
+            iterator++;
+        }
+    }
+
+    m_removed.append(target);
+
+    queueProcess();
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::queueProcess() -> void {
+    if (m_processQueued) {
+        return;
+    }
+
+    m_processQueued = true;
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        process();
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::process() -> void {
+    auto pending = QMap<QPair<QString, int>, Update>();
+    auto removed = QStringList();
+
+    m_mutex.lock();
+
+    pending.swap(m_pending);
+    removed.swap(m_removed);
+
+    m_processQueued = false;
+
+    m_mutex.unlock();
+
+    for (auto &target : removed) {
+        m_hops.remove(target);
+
+        auto frame = QString::fromUtf8(QJsonDocument(QJsonObject {
+            {"type", "removed"},
+            {"target", target}
+        }).toJson(QJsonDocument::Compact));
+
+        for (auto feed : m_feeds) {
+            if (feed->target!=target) {
+                continue;
+            }
+
+            for (auto socket : feed->subscribers) {
+                send(socket, frame);
+            }
+        }
+    }
+
+    /**
+     * the statistics are only brought up to date here, nothing is encoded until a feed ticks, so a burst of
+     * results between ticks costs one encode per feed.
+     */
+
+    for (auto update=pending.constBegin();update!=pending.constEnd();update++) {
+        auto &state = m_hops[update.key().first][update.key().second];
+        auto &statistics = update->statistics;
+
+        if (!update->address.isNull()) {
+            state.address = update->address;
+        }
+
+        state.latency = statistics.currentLatency();
+        state.average = statistics.replyCount() ? statistics.latencyStatistics().mean() : -1;
+        state.jitter = statistics.jitterStatistics().jitter();
+        state.loss = statistics.packetLoss();
+        state.replies = statistics.replyCount();
+        state.timeouts = statistics.timeoutCount();
+        state.version = ++m_version;
+    }
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::processMessage(QWebSocket *socket, const QString &message) -> void {
+    auto request = QJsonDocument::fromJson(message.toUtf8()).object();
+
+    if (request.contains("subscribe")) {
+        subscribe(socket, request.value("subscribe").toString(), request.value("interval").toInt(DefaultInterval));
+    } else if (request.contains("unsubscribe")) {
+        auto target = request.value("unsubscribe").toString();
+
+        if (!target.isEmpty()) {
+            unsubscribe(socket, target);
+        }
+    } else if (request.contains("targets")) {
+        send(socket, QString::fromUtf8(QJsonDocument(QJsonObject {
+            {"type", "targets"},
+            {"targets", QJsonArray::fromStringList(m_hops.keys())}
+        }).toJson(QJsonDocument::Compact)));
+    }
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::subscribe(QWebSocket *socket, const QString &target, int interval) -> void {
+    if (target.isEmpty()) {
+        return;
+    }
+
+    /**
+     * a feed is only created for a target that is being monitored, and a client can only hold a limited number of
+     * feeds, so a client cannot make the server create timers without bound.
+     */
+
+    if (!m_hops.contains(target)) {
+        sendError(socket, target, "unknown target");
+
+        return;
+    }
+
+    unsubscribe(socket, target);
+
+    auto subscriptions = std::count_if(m_feeds.constBegin(), m_feeds.constEnd(), [socket](const Feed *feed) {
+        return feed->subscribers.contains(socket);
+    });
+
+    if (subscriptions>=MaximumSubscriptions) {
+        sendError(socket, target, "too many subscriptions");
+
+        return;
+    }
+
+    interval = std::clamp(interval, MinimumInterval, MaximumInterval);
+    interval = ((interval+TickGranularity-1)/TickGranularity)*TickGranularity;
+
+    auto key = qMakePair(target, interval);
+    auto feed = m_feeds.value(key, nullptr);
+
+    if (!feed) {
+        feed = new Feed {target, new QTimer(m_context), m_version, {}, {}};
+
+        feed->timer->setInterval(interval);
+
+        connect(feed->timer, &QTimer::timeout, m_context, [this, feed]() {
+            tick(feed);
+        });
+
+        feed->timer->start();
+
+        m_feeds[key] = feed;
+    }
+
+    feed->subscribers.insert(socket);
+
+    // the snapshot brings the client up to date, the deltas of the feed take it on from there.
+
+    if (!send(socket, encode(SnapshotType, target, 0))) {
+        feed->stale.insert(socket);
+    }
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::unsubscribe(QWebSocket *socket, const QString &target) -> void {
+    for (auto iterator=m_feeds.begin();iterator!=m_feeds.end();) {
+        auto feed = iterator.value();
+
+        if ((!target.isEmpty()) && (feed->target!=target)) {
+            iterator++;
+
+            continue;
+        }
+
+        feed->subscribers.remove(socket);
+        feed->stale.remove(socket);
+
+        if (!feed->subscribers.isEmpty()) {
+            iterator++;
+
+            continue;
+        }
+
+        delete feed->timer;
+        delete feed;
+
+        iterator = m_feeds.erase(iterator);
+    }
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::tick(Feed *feed) -> void {
+    auto delta = encode(DeltaType, feed->target, feed->sentVersion);
+    auto snapshot = QString();
+
+    auto subscribers = feed->subscribers;
+
+    feed->sentVersion = m_version;
+
+    for (auto socket : subscribers) {
+        /**
+         * a client that could not take a delta has lost changes, once it has caught up it is sent a snapshot
+         * rather than the delta that everyone else is sent.
+         */
+
+        if (feed->stale.contains(socket)) {
+            if (socket->bytesToWrite()>MaximumPendingBytes) {
+                continue;
+            }
+
+            if (snapshot.isEmpty()) {
+                snapshot = encode(SnapshotType, feed->target, 0);
+            }
+
+            if (send(socket, snapshot)) {
+                feed->stale.remove(socket);
+            }
+
+            continue;
+        }
+
+        if ((!delta.isEmpty()) && (!send(socket, delta))) {
+            feed->stale.insert(socket);
+        }
+    }
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::encode(
+        const QString &type,
+        const QString &target,
+        quint64 version ) -> QString {
+
+    auto hops = QJsonArray();
+
+    if (m_hops.contains(target)) {
+        auto &targetHops = m_hops[target];
+
+        for (auto hop=targetHops.constBegin();hop!=targetHops.constEnd();hop++) {
+            auto &state = hop.value();
+
+            if (state.version<=version) {
+                continue;
+            }
+
+            hops.append(QJsonObject {
+                {"hop", hop.key()},
+                {"address", state.address.toString()},
+                {"latency", state.latency},
+                {"average", state.average},
+                {"jitter", state.jitter},
+                {"replies", static_cast<double>(state.replies)},
+                {"timeouts", static_cast<double>(state.timeouts)},
+                {"loss", state.loss}
+            });
+        }
+    }
+
+    if ((hops.isEmpty()) && (type==DeltaType)) {
+        return QString();
+    }
+
+    return QString::fromUtf8(QJsonDocument(QJsonObject {
+        {"type", type},
+        {"target", target},
+        {"sequence", static_cast<double>(m_version)},
+        {"hops", hops}
+    }).toJson(QJsonDocument::Compact));
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::sendError(
+        QWebSocket *socket,
+        const QString &target,
+        const QString &error ) -> void {
+
+    send(socket, QString::fromUtf8(QJsonDocument(QJsonObject {
+        {"type", "error"},
+        {"target", target},
+        {"error", error}
+    }).toJson(QJsonDocument::Compact)));
+}
+
+auto Nedrysoft::LiveFeed::LiveFeedServer::send(QWebSocket *socket, const QString &frame) -> bool {
+    /**
+     * a client that is not reading is left behind rather than buffered without limit, the caller decides how it
+     * catches up.
+     */
+
+    if (socket->bytesToWrite()>MaximumPendingBytes) {
+        return false;
+    }
+
+    socket->sendTextMessage(frame);
+
+    return true;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_LIVEFEED_LIVEFEEDSERVER_H
+#define PINGNOO_COMPONENTS_LIVEFEED_LIVEFEEDSERVER_H
+
+#include "LiveFeedSpec.h"
+
+#include <HopStatistics>
+#include <IResultSink>
+#include <QHostAddress>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QThread;
+class QTimer;
+class QWebSocket;
+class QWebSocketServer;
+
+namespace Nedrysoft { namespace LiveFeed {
+    /**
+     * @brief       The LiveFeedServer class streams live per hop statistics to WebSocket clients.
+     *
+     * @details     A client subscribes to a target with the interval at which it wants updates, the first message
+     *              it receives is a snapshot of every hop and each one after that is a delta holding only the hops
+     *              that have changed.  The hops in a delta carry their absolute values, so applying a delta twice
+     *              (or after a newer snapshot) is harmless.
+     *
+     *              Subscribers that ask for the same target at the same interval share a feed, each tick of a feed
+     *              encodes its delta once and sends the same frame to every subscriber, so an extra viewer only
+     *              costs the write to its socket.  Intervals are rounded up to a multiple of the tick granularity
+     *              so that dashboards asking for similar rates end up sharing.
+     *
+     *              The hops carry the aggregates maintained by the statistics engine, update() keeps the latest
+     *              aggregates of each hop on the caller's thread and the hop states, the server and the feeds all
+     *              live on a worker thread.
+     *
+     *              Client messages are JSON objects:
+     *
+     *                  {"subscribe": "<target>", "interval": <milliseconds>}
+     *                  {"unsubscribe": "<target>"}
+     *                  {"targets": true}
+     *
+     *              Server messages have a "type" of "snapshot", "delta", "removed", "targets" or "error".  A
+     *              subscription to a target that is not being monitored, or beyond the number of subscriptions
+     *              that a client may hold, is refused with an error.  Client messages larger than a few kilobytes
+     *              are refused by the socket.
+     */
+    class NEDRYSOFT_LIVEFEED_DLLSPEC LiveFeedServer :
+            public Nedrysoft::RouteAnalyser::IResultSink {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IResultSink)
+
+        public:
+            /**
+             * @brief       The live statistics of a single hop.
+             */
+            struct HopState {
+                QHostAddress address;                                   //!< the address that most recently replied.
+                double latency = -1;                                    //!< the most recent round trip time.
+                double average = -1;                                    //!< the mean round trip time.
+                double jitter = -1;                                     //!< the RFC 3550 interarrival jitter.
+                double loss = -1;                                       //!< the percentage of requests lost.
+                quint64 replies = 0;                                    //!< the number of replies.
+                quint64 timeouts = 0;                                   //!< the number of requests with no reply.
+                quint64 version = 0;                                    //!< the change that last touched the hop.
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new LiveFeedServer and starts its thread.
+             */
+            LiveFeedServer();
+
+            /**
+             * @brief       Stops the thread and destroys the LiveFeedServer.
+             */
+            ~LiveFeedServer();
+
+            /**
+             * @brief       Starts accepting WebSocket clients on the given address and port.
+             *
+             * @param[in]   address the address to listen on.
+             * @param[in]   port the port to listen on.
+             *
+             * @returns     true if listening; otherwise false.
+             */
+            auto listen(const QHostAddress &address, quint16 port) -> bool;
+
+            /**
+             * @brief       Replaces the live statistics of a hop with its latest aggregates.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::update
+             *
+             * @param[in]   target the name of the target that the hop belongs to.
+             * @param[in]   hop the hop number.
+             * @param[in]   statistics the aggregates of the hop.
+             * @param[in]   results the results received for the hop since the previous update.
+             */
+            auto update(
+                    const QString &target,
+                    int hop,
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results
+            ) -> void override;
+
+            /**
+             * @brief       Removes the statistics of every hop of a target and tells its subscribers.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::removeTarget
+             *
+             * @param[in]   target the name of the target.
+             */
+            auto removeTarget(const QString &target) -> void override;
+
+        private:
+            /**
+             * @brief       The latest aggregates queued for a hop.
+             */
+            struct Update {
+                QHostAddress address;
+                Nedrysoft::RouteAnalyser::HopStatistics statistics;
+            };
+
+            /**
+             * @brief       The subscribers to a target at one interval.
+             */
+            struct Feed {
+                QString target;                                         //!< the target.
+                QTimer *timer;                                          //!< the tick timer.
+                quint64 sentVersion;                                    //!< the newest change sent.
+                QSet<QWebSocket *> subscribers;                         //!< the subscribed clients.
+                QSet<QWebSocket *> stale;                               //!< clients that missed a delta.
+            };
+
+            /**
+             * @brief       Queues the processing of the pending updates, called with the mutex held.
+             */
+            auto queueProcess() -> void;
+
+            /**
+             * @brief       Applies the pending updates to the hop states, called on the worker thread.
+             */
+            auto process() -> void;
+
+            /**
+             * @brief       Handles a message from a client.
+             *
+             * @param[in]   socket the client.
+             * @param[in]   message the message.
+             */
+            auto processMessage(QWebSocket *socket, const QString &message) -> void;
+
+            /**
+             * @brief       Subscribes a client to a target and sends it a snapshot.
+             *
+             * @details     A client has at most one subscription to a target, subscribing again changes its
+             *              interval.  The target must be one that is being monitored and the client must hold fewer
+             *              than the maximum number of subscriptions; otherwise an error is sent to the client.
+             *
+             * @param[in]   socket the client.
+             * @param[in]   target the target.
+             * @param[in]   interval the requested interval in milliseconds.
+             */
+            auto subscribe(QWebSocket *socket, const QString &target, int interval) -> void;
+
+            /**
+             * @brief       Removes a client from the feed of a target, deleting the feed if it has no subscribers.
+             *
+             * @param[in]   socket the client.
+             * @param[in]   target the target; otherwise an empty string for every target.
+             */
+            auto unsubscribe(QWebSocket *socket, const QString &target = QString()) -> void;
+
+            /**
+             * @brief       Sends the changes since the previous tick to the subscribers of a feed.
+             *
+             * @param[in]   feed the feed.
+             */
+            auto tick(Feed *feed) -> void;
+
+            /**
+             * @brief       Encodes the hops of a target that have changed after the given version.
+             *
+             * @param[in]   type the message type.
+             * @param[in]   target the target.
+             * @param[in]   version the version to compare against; 0 for every hop.
+             *
+             * @returns     the encoded message; otherwise an empty string if nothing has changed.
+             */
+            auto encode(const QString &type, const QString &target, quint64 version) -> QString;
+
+            /**
+             * @brief       Sends an error about a request to a client.
+             *
+             * @param[in]   socket the client.
+             * @param[in]   target the target that the request named.
+             * @param[in]   error the description of the error.
+             */
+            auto sendError(QWebSocket *socket, const QString &target, const QString &error) -> void;
+
+            /**
+             * @brief       Sends a frame to a client unless it has fallen behind.
+             *
+             * @param[in]   socket the client.
+             * @param[in]   frame the encoded message.
+             *
+             * @returns     true if sent; otherwise false.
+             */
+            auto send(QWebSocket *socket, const QString &frame) -> bool;
+
+        private:
+            //! @cond
+
+            QThread *m_thread;
+            QObject *m_context;
+            QWebSocketServer *m_server;
+
+            QMutex m_mutex;
+            QMap<QPair<QString, int>, Update> m_pending;
+            QStringList m_removed;
+            bool m_processQueued;
+
+            QMap<QString, QMap<int, HopState> > m_hops;
+            quint64 m_version;
+
+            QMap<QPair<QString, int>, Feed *> m_feeds;
+            QList<QWebSocket *> m_clients;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_LIVEFEED_LIVEFEEDSERVER_H
@@ -0,0 +1,565 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Database.h"
+
+#include <cstring>
+#include <limits>
+
+constexpr auto MetadataMarker = "\xAB\xCD\xEFMaxMind.com";
+constexpr auto MetadataMarkerLength = 14;
+constexpr auto MetadataSearchLength = 128*1024;
+constexpr auto DataSectionSeparator = 16;
+constexpr auto IPv4StartBit = 96;
+constexpr auto MaximumDepth = 64u;
+
+Nedrysoft::MMDBGeoIPProvider::Database::Database() :
+        m_map(nullptr),
+        m_fileSize(0),
+        m_data(nullptr),
+        m_dataSize(0),
+        m_nodeCount(0),
+        m_recordSize(0),
+        m_ipVersion(0),
+        m_ipv4Start(0),
+        m_rejected(false) {
+
+}
+
+Nedrysoft::MMDBGeoIPProvider::Database::~Database() {
+    close();
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::open(const QString &filename) -> bool {
+    close();
+
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    if ((m_file.size()<=MetadataMarkerLength) || (m_file.size()>std::numeric_limits<uint32_t>::max())) {
+        close();
+
+        return false;
+    }
+
+    m_fileSize = static_cast<uint32_t>(m_file.size());
+    m_map = m_file.map(0, m_fileSize);
+
+    if (!m_map) {
+        close();
+
+        return false;
+    }
+
+    /**
+     * the metadata follows the last occurrence of the marker, which is within the last 128KiB of the file.
+     */
+
+    auto searchEnd = (m_fileSize>MetadataSearchLength) ? m_fileSize-MetadataSearchLength : 0;
+    auto markerOffset = static_cast<int64_t>(m_fileSize)-MetadataMarkerLength;
+
+    for (;markerOffset>=searchEnd;markerOffset--) {
+        if (!memcmp(m_map+markerOffset, MetadataMarker, MetadataMarkerLength)) {
+            break;
+        }
+    }
+
+    if ((markerOffset<searchEnd) || (!readMetadata(static_cast<uint32_t>(markerOffset+MetadataMarkerLength)))) {
+        close();
+
+        return false;
+    }
+
+    auto treeSize = static_cast<uint64_t>(m_nodeCount)*m_recordSize/4;
+
+    if (treeSize+DataSectionSeparator>static_cast<uint64_t>(markerOffset)) {
+        close();
+
+        return false;
+    }
+
+    m_data = m_map+treeSize+DataSectionSeparator;
+    m_dataSize = static_cast<uint32_t>(markerOffset-treeSize-DataSectionSeparator);
+
+    /**
+     * an IPv6 database stores IPv4 addresses in the ::/96 subtree, the node at the bottom of the 96 left branches
+     * is found once here rather than on every lookup.
+     */
+
+    m_ipv4Start = 0;
+
+    if (m_ipVersion==6) {
+        for (auto bit=0;(bit<IPv4StartBit) && (m_ipv4Start<m_nodeCount);bit++) {
+            m_ipv4Start = record(m_ipv4Start, 0);
+        }
+    }
+
+    return true;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::close() -> void {
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+
+    m_file.close();
+
+    m_map = nullptr;
+    m_fileSize = 0;
+    m_data = nullptr;
+    m_dataSize = 0;
+    m_nodeCount = 0;
+    m_rejected = false;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::isOpen() const -> bool {
+    return (m_data!=nullptr) && (!m_rejected);
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::lookup(const QHostAddress &address, uint32_t &offset) const -> bool {
+    if (!isOpen()) {
+        return false;
+    }
+
+    auto isIPv4 = false;
+    auto ipv4Address = address.toIPv4Address(&isIPv4);
+    auto ipv6Address = address.toIPv6Address();
+
+    uchar ipv4Bytes[4] = {
+        static_cast<uchar>(ipv4Address >> 24),
+        static_cast<uchar>(ipv4Address >> 16),
+        static_cast<uchar>(ipv4Address >> 8),
+        static_cast<uchar>(ipv4Address)
+    };
+
+    if ((!isIPv4) && (m_ipVersion!=6)) {
+        return false;
+    }
+
+    auto bytes = isIPv4 ? ipv4Bytes : ipv6Address.c;
+    auto bits = isIPv4 ? 32 : 128;
+    auto node = isIPv4 ? m_ipv4Start : 0;
+
+    for (auto bit=0;(bit<bits) && (node<m_nodeCount);bit++) {
+        node = record(node, (bytes[bit >> 3] >> (7-(bit & 7))) & 1);
+    }
+
+    /**
+     * a record equal to the node count means there is no data for the address, a record beyond it points into
+     * the data section.
+     */
+
+    if (node<=m_nodeCount) {
+        return false;
+    }
+
+    auto dataOffset = node-m_nodeCount-DataSectionSeparator;
+
+    if (dataOffset>=m_dataSize) {
+        return false;
+    }
+
+    offset = dataOffset;
+
+    return true;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::find(
+        uint32_t offset,
+        std::initializer_list<const char *> path,
+        uint32_t &valueOffset ) const -> bool {
+
+    auto current = offset;
+
+    for (auto key : path) {
+        Type type;
+        uint32_t size, payload, pointerEnd;
+
+        if (!decode(current, type, size, payload, pointerEnd)) {
+            return false;
+        }
+
+        auto entry = payload;
+
+        if (type==Type::Map) {
+            auto keyLength = static_cast<uint32_t>(strlen(key));
+            auto found = false;
+
+            for (uint32_t i=0;i<size;i++) {
+                Type keyType;
+                uint32_t keySize, keyPayload, keyPointerEnd;
+
+                if ((!decode(entry, keyType, keySize, keyPayload, keyPointerEnd)) || (keyType!=Type::String)) {
+                    return false;
+                }
+
+                auto value = keyPointerEnd ? keyPointerEnd : keyPayload+keySize;
+
+                if ((keySize==keyLength) && (!memcmp(m_data+keyPayload, key, keyLength))) {
+                    current = value;
+                    found = true;
+                    break;
+                }
+
+                if (!skip(value, entry)) {
+                    return false;
+                }
+            }
+
+            if (!found) {
+                return false;
+            }
+        } else if (type==Type::Array) {
+            char *end = nullptr;
+            auto index = strtoul(key, &end, 10);
+
+            if ((*end) || (index>=size)) {
+                return false;
+            }
+
+            for (uint32_t i=0;i<index;i++) {
+                if (!skip(entry, entry)) {
+                    return false;
+                }
+            }
+
+            current = entry;
+        } else {
+            return false;
+        }
+    }
+
+    valueOffset = current;
+
+    return true;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::string(uint32_t offset, QString &value) const -> bool {
+    Type type;
+    uint32_t size, payload, pointerEnd;
+
+    if ((!decode(offset, type, size, payload, pointerEnd)) || (type!=Type::String)) {
+        return false;
+    }
+
+    value = QString::fromUtf8(reinterpret_cast<const char *>(m_data+payload), static_cast<int>(size));
+
+    return true;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::number(uint32_t offset, double &value) const -> bool {
+    Type type;
+    uint32_t size, payload, pointerEnd;
+
+    if (!decode(offset, type, size, payload, pointerEnd)) {
+        return false;
+    }
+
+    switch (type) {
+        case Type::Double: {
+            if (size!=sizeof(double)) {
+                return false;
+            }
+
+            auto bits = readUnsigned(payload, size);
+
+            memcpy(&value, &bits, sizeof(value));
+
+            return true;
+        }
+
+        case Type::Float: {
+            if (size!=sizeof(float)) {
+                return false;
+            }
+
+            auto bits = static_cast<uint32_t>(readUnsigned(payload, size));
+            float floatValue;
+
+            memcpy(&floatValue, &bits, sizeof(floatValue));
+
+            value = floatValue;
+
+            return true;
+        }
+
+        case Type::UInt16:
+        case Type::UInt32:
+        case Type::UInt64: {
+            if (size>sizeof(uint64_t)) {
+                return false;
+            }
+
+            value = static_cast<double>(readUnsigned(payload, size));
+
+            return true;
+        }
+
+        case Type::Int32: {
+            if (size>sizeof(int32_t)) {
+                return false;
+            }
+
+            value = static_cast<int32_t>(readUnsigned(payload, size));
+
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::decode(
+        uint32_t offset,
+        Type &type,
+        uint32_t &size,
+        uint32_t &payload,
+        uint32_t &pointerEnd ) const -> bool {
+
+    pointerEnd = 0;
+
+    if (offset>=m_dataSize) {
+        return false;
+    }
+
+    auto control = m_data[offset];
+    auto position = offset+1;
+
+    type = static_cast<Type>(control >> 5);
+
+    if (type==Type::Pointer) {
+        auto length = ((control >> 3) & 3)+1;
+        auto value = static_cast<uint32_t>(control & 7);
+
+        if (position+length>m_dataSize) {
+            return false;
+        }
+
+        auto pointer = static_cast<uint32_t>(readUnsigned(position, length));
+
+        switch (length) {
+            case 1: pointer |= value << 8; break;
+            case 2: pointer = (pointer | (value << 16))+2048; break;
+            case 3: pointer = (pointer | (value << 24))+526336; break;
+            default: break;
+        }
+
+        if (pointer>=m_dataSize) {
+            return false;
+        }
+
+        /**
+         * a pointer never points at another pointer, refusing to follow one also stops a corrupt file from
+         * sending a lookup round in circles.
+         */
+
+        auto end = position+length;
+
+        if (static_cast<Type>(m_data[pointer] >> 5)==Type::Pointer) {
+            return false;
+        }
+
+        if (!decode(pointer, type, size, payload, pointerEnd)) {
+            return false;
+        }
+
+        pointerEnd = end;
+
+        return true;
+    }
+
+    if (type==Type::Extended) {
+        if (position>=m_dataSize) {
+            return false;
+        }
+
+        type = static_cast<Type>(7+m_data[position++]);
+    }
+
+    size = control & 0x1f;
+
+    if (size>=29) {
+        auto length = size-28;
+
+        if (position+length>m_dataSize) {
+            return false;
+        }
+
+        auto extra = static_cast<uint32_t>(readUnsigned(position, length));
+
+        switch (length) {
+            case 1: size = 29+extra; break;
+            case 2: size = 285+extra; break;
+            default: size = 65821+extra; break;
+        }
+
+        position += length;
+    }
+
+    payload = position;
+
+    /**
+     * maps, arrays and booleans have no payload of their own (the size is a count or the value), every other type
+     * must fit inside the data section.
+     */
+
+    if ((type!=Type::Map) && (type!=Type::Array) && (type!=Type::Boolean) &&
+        (static_cast<uint64_t>(payload)+size>m_dataSize)) {
+        return false;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::skip(uint32_t offset, uint32_t &next, uint32_t depth) const -> bool {
+    Type type;
+    uint32_t size, payload, pointerEnd;
+
+    if (depth>MaximumDepth) {
+        m_rejected = true;
+
+        return false;
+    }
+
+    if (!decode(offset, type, size, payload, pointerEnd)) {
+        return false;
+    }
+
+    if (pointerEnd) {
+        next = pointerEnd;
+
+        return true;
+    }
+
+    auto entry = payload;
+
+    switch (type) {
+        case Type::Map: {
+            size *= 2;
+
+            [[fallthrough]];
+        }
+
+        case Type::Array: {
+            for (uint32_t i=0;i<size;i++) {
+                if (!skip(entry, entry, depth+1)) {
+                    return false;
+                }
+            }
+
+            next = entry;
+
+            return true;
+        }
+
+        case Type::Boolean: {
+            next = payload;
+
+            return true;
+        }
+
+        default: {
+            next = payload+size;
+
+            return true;
+        }
+    }
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::readUnsigned(uint32_t offset, uint32_t length) const -> uint64_t {
+    uint64_t value = 0;
+
+    for (uint32_t i=0;i<length;i++) {
+        value = (value << 8) | m_data[offset+i];
+    }
+
+    return value;
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::record(uint32_t node, int bit) const -> uint32_t {
+    auto bytes = m_map+static_cast<uint64_t>(node)*m_recordSize/4;
+
+    switch (m_recordSize) {
+        case 24: {
+            bytes += bit*3;
+
+            return (static_cast<uint32_t>(bytes[0]) << 16) | (bytes[1] << 8) | bytes[2];
+        }
+
+        case 28: {
+            if (bit) {
+                return (static_cast<uint32_t>(bytes[3] & 0x0f) << 24) |
+                       (static_cast<uint32_t>(bytes[4]) << 16) | (bytes[5] << 8) | bytes[6];
+            }
+
+            return (static_cast<uint32_t>(bytes[3] & 0xf0) << 20) |
+                   (static_cast<uint32_t>(bytes[0]) << 16) | (bytes[1] << 8) | bytes[2];
+        }
+
+        default: {
+            bytes += bit*4;
+
+            return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+                   (bytes[2] << 8) | bytes[3];
+        }
+    }
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::Database::readMetadata(uint32_t metadata) -> bool {
+    /**
+     * the metadata is encoded in the same way as the data section, so it is decoded by pointing the data section
+     * at it for the moment.
+     */
+
+    m_data = m_map+metadata;
+    m_dataSize = m_fileSize-metadata;
+
+    uint32_t valueOffset;
+    double nodeCount = 0, recordSize = 0, ipVersion = 0;
+
+    auto valid = find(0, {"node_count"}, valueOffset) && number(valueOffset, nodeCount) &&
+                 find(0, {"record_size"}, valueOffset) && number(valueOffset, recordSize) &&
+                 find(0, {"ip_version"}, valueOffset) && number(valueOffset, ipVersion);
+
+    m_data = nullptr;
+    m_dataSize = 0;
+
+    if ((!valid) || (nodeCount<=0)) {
+        return false;
+    }
+
+    m_nodeCount = static_cast<uint32_t>(nodeCount);
+    m_recordSize = static_cast<uint32_t>(recordSize);
+    m_ipVersion = static_cast<uint32_t>(ipVersion);
+
+    if ((m_recordSize!=24) && (m_recordSize!=28) && (m_recordSize!=32)) {
+        return false;
+    }
+
+    return (m_ipVersion==4) || (m_ipVersion==6);
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_DATABASE_H
+#define PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_DATABASE_H
+
+#include <QFile>
+#include <QHostAddress>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+
+namespace Nedrysoft { namespace MMDBGeoIPProvider {
+    /**
+     * @brief       The Database class reads a MaxMind DB (MMDB) file.
+     *
+     * @details     The file is memory mapped and the binary search tree and data section are read in place, a
+     *              lookup walks the tree one bit of the address at a time and does not allocate any memory.  Both
+     *              GeoLite2 and DB-IP databases use this format.
+     */
+    class Database {
+        public:
+            /**
+             * @brief       The data types that can be stored in the data section.
+             */
+            enum class Type {
+                Extended = 0,
+                Pointer = 1,
+                String = 2,
+                Double = 3,
+                Bytes = 4,
+                UInt16 = 5,
+                UInt32 = 6,
+                Map = 7,
+                Int32 = 8,
+                UInt64 = 9,
+                UInt128 = 10,
+                Array = 11,
+                Container = 12,
+                EndMarker = 13,
+                Boolean = 14,
+                Float = 15
+            };
+
+            /**
+             * @brief       Constructs a closed Database.
+             */
+            Database();
+
+            /**
+             * @brief       Destroys the Database, unmapping the file.
+             */
+            ~Database();
+
+            /**
+             * @brief       Opens and maps a database file.
+             *
+             * @param[in]   filename the path to the database.
+             *
+             * @returns     true if the file was mapped and has valid metadata; otherwise false.
+             */
+            auto open(const QString &filename) -> bool;
+
+            /**
+             * @brief       Unmaps and closes the database.
+             */
+            auto close() -> void;
+
+            /**
+             * @brief       Returns whether the database is open.
+             *
+             * @details     A database that has been found to nest values too deeply is no longer open.
+             *
+             * @returns     true if open; otherwise false.
+             */
+            auto isOpen() const -> bool;
+
+            /**
+             * @brief       Finds the data record for an address.
+             *
+             * @param[in]   address the address to look up.
+             * @param[out]  offset the offset of the record in the data section.
+             *
+             * @returns     true if the database holds a record for the address; otherwise false.
+             */
+            auto lookup(const QHostAddress &address, uint32_t &offset) const -> bool;
+
+            /**
+             * @brief       Follows a path of map keys (or array indexes) from a value.
+             *
+             * @details     For example {"country", "names", "en"} from a city record gives the english name of
+             *              the country.
+             *
+             * @param[in]   offset the offset of the starting value in the data section.
+             * @param[in]   path the keys to follow, an array is indexed by a decimal key.
+             * @param[out]  valueOffset the offset of the value at the end of the path.
+             *
+             * @returns     true if every key along the path was found; otherwise false.
+             */
+            auto find(uint32_t offset, std::initializer_list<const char *> path, uint32_t &valueOffset) const -> bool;
+
+            /**
+             * @brief       Reads a string value.
+             *
+             * @param[in]   offset the offset of the value in the data section.
+             * @param[out]  value the string.
+             *
+             * @returns     true if the value is a string; otherwise false.
+             */
+            auto string(uint32_t offset, QString &value) const -> bool;
+
+            /**
+             * @brief       Reads a numeric value.
+             *
+             * @param[in]   offset the offset of the value in the data section.
+             * @param[out]  value the number.
+             *
+             * @returns     true if the value is a number; otherwise false.
+             */
+            auto number(uint32_t offset, double &value) const -> bool;
+
+        private:
+            /**
+             * @brief       Decodes the control byte(s) of a value.
+             *
+             * @details     A pointer is followed to the value it points at, so the returned type is never a pointer.
+             *
+             * @param[in]   offset the offset of the value in the data section.
+             * @param[out]  type the type of the value.
+             * @param[out]  size the size of the value (bytes, or entries for maps and arrays).
+             * @param[out]  payload the offset of the value's payload.
+             * @param[out]  pointerEnd the offset after the pointer if the value was reached through one; otherwise 0.
+             *
+             * @returns     true if the value is within the data section; otherwise false.
+             */
+            auto decode(
+                uint32_t offset,
+                Type &type,
+                uint32_t &size,
+                uint32_t &payload,
+                uint32_t &pointerEnd
+            ) const -> bool;
+
+            /**
+             * @brief       Returns the offset of the value that follows the given value.
+             *
+             * @details     Maps and arrays are skipped recursively, a value nested more than 64 deep cannot be
+             *              skipped and the whole database is rejected, so a crafted file cannot exhaust the stack.
+             *
+             * @param[in]   offset the offset of the value in the data section.
+             * @param[out]  next the offset of the following value.
+             * @param[in]   depth the number of maps and arrays that contain the value.
+             *
+             * @returns     true if the value could be skipped; otherwise false.
+             */
+            auto skip(uint32_t offset, uint32_t &next, uint32_t depth = 0) const -> bool;
+
+            /**
+             * @brief       Reads a big endian unsigned integer of up to 8 bytes from the data section.
+             *
+             * @param[in]   offset the offset in the data section.
+             * @param[in]   length the number of bytes.
+             *
+             * @returns     the value.
+             */
+            auto readUnsigned(uint32_t offset, uint32_t length) const -> uint64_t;
+
+            /**
+             * @brief       Returns the record of a search tree node.
+             *
+             * @param[in]   node the node number.
+             * @param[in]   bit the branch, 0 for left or 1 for right.
+             *
+             * @returns     the record.
+             */
+            auto record(uint32_t node, int bit) const -> uint32_t;
+
+            /**
+             * @brief       Reads the metadata map at the end of the file.
+             *
+             * @param[in]   metadata the offset of the metadata in the file.
+             *
+             * @returns     true if the metadata describes a usable database; otherwise false.
+             */
+            auto readMetadata(uint32_t metadata) -> bool;
+
+        private:
+            //! @cond
+
+            QFile m_file;
+            const uchar *m_map;
+            uint32_t m_fileSize;
+            const uchar *m_data;
+            uint32_t m_dataSize;
+            uint32_t m_nodeCount;
+            uint32_t m_recordSize;
+            uint32_t m_ipVersion;
+            uint32_t m_ipv4Start;
+            mutable std::atomic<bool> m_rejected;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_DATABASE_H
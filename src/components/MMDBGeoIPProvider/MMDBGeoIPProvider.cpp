@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MMDBGeoIPProvider.h"
+
+#include "Database.h"
+
+#include <ICore>
+#include <ObjectRegistry>
+#include <QDir>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <spdlog/spdlog.h>
+
+constexpr auto ReloadDelay = 1000;
+
+/**
+ * the names that the city and country databases are distributed with, the most detailed one found is used.
+ */
+
+constexpr const char *DatabaseFilenames[] = {
+    "GeoLite2-City.mmdb",
+    "dbip-city-lite.mmdb",
+    "GeoLite2-Country.mmdb",
+    "dbip-country-lite.mmdb"
+};
+
+Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::MMDBGeoIPProvider() :
+        m_database(std::make_shared<Nedrysoft::MMDBGeoIPProvider::Database>()),
+        m_databaseSize(-1),
+        m_initialised(false) {
+
+}
+
+Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::~MMDBGeoIPProvider() {
+
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::initialise() -> void {
+    if (m_initialised) {
+        return;
+    }
+
+    m_initialised = true;
+
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+
+    if (QDir(storageFolder).exists()) {
+        m_watcher.addPath(storageFolder);
+    }
+
+    /**
+     * a database is usually replaced by writing a new file and renaming it, which is seen as several changes in
+     * quick succession, so the reload waits for things to settle.
+     */
+
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(ReloadDelay);
+
+    connect(&m_reloadTimer, &QTimer::timeout, this, &MMDBGeoIPProvider::reload);
+
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, [this](const QString &) {
+        m_reloadTimer.start();
+    });
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, [this](const QString &) {
+        m_reloadTimer.start();
+    });
+
+    reload();
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::reload() -> void {
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+    auto fileInfo = QFileInfo();
+
+    for (auto filename : DatabaseFilenames) {
+        fileInfo = QFileInfo(storageFolder, filename);
+
+        if (fileInfo.exists()) {
+            break;
+        }
+    }
+
+    if (!fileInfo.exists()) {
+        return;
+    }
+
+    /**
+     * the storage folder also holds the other providers' caches, so most changes are not to the database and
+     * are ignored.
+     */
+
+    if ((fileInfo.absoluteFilePath()==m_databaseFilename) &&
+        (fileInfo.lastModified()==m_databaseModified) &&
+        (fileInfo.size()==m_databaseSize)) {
+
+        return;
+    }
+
+    auto database = std::make_shared<Nedrysoft::MMDBGeoIPProvider::Database>();
+
+    if (!database->open(fileInfo.absoluteFilePath())) {
+        SPDLOG_WARN(QString("unable to open geo ip database. (%1)").arg(fileInfo.absoluteFilePath()).toStdString());
+
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_databaseMutex);
+
+        m_database = database;
+    }
+
+    m_databaseFilename = fileInfo.absoluteFilePath();
+    m_databaseModified = fileInfo.lastModified();
+    m_databaseSize = fileInfo.size();
+
+    if (!m_watcher.files().contains(m_databaseFilename)) {
+        m_watcher.addPath(m_databaseFilename);
+    }
+
+    SPDLOG_INFO(QString("loaded geo ip database. (%1)").arg(m_databaseFilename).toStdString());
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::find(const QString &host, QVariantMap &result) const -> bool {
+    auto address = QHostAddress(host);
+    uint32_t record, value;
+    QString text;
+    double number;
+
+    // the reference keeps the database mapped even if it is replaced while the record is being read.
+
+    std::shared_ptr<const Nedrysoft::MMDBGeoIPProvider::Database> database;
+
+    {
+        QMutexLocker locker(&m_databaseMutex);
+
+        database = m_database;
+    }
+
+    if ((address.isNull()) || (!database->lookup(address, record))) {
+        return false;
+    }
+
+    if (database->find(record, {"country", "names", "en"}, value) && database->string(value, text)) {
+        result["country"] = text;
+    }
+
+    if (database->find(record, {"country", "iso_code"}, value) && database->string(value, text)) {
+        result["countryCode"] = text;
+    }
+
+    if (database->find(record, {"subdivisions", "0", "iso_code"}, value) && database->string(value, text)) {
+        result["region"] = text;
+    }
+
+    if (database->find(record, {"subdivisions", "0", "names", "en"}, value) && database->string(value, text)) {
+        result["regionName"] = text;
+    }
+
+    if (database->find(record, {"city", "names", "en"}, value) && database->string(value, text)) {
+        result["city"] = text;
+    }
+
+    if (database->find(record, {"postal", "code"}, value) && database->string(value, text)) {
+        result["zip"] = text;
+    }
+
+    if (database->find(record, {"location", "latitude"}, value) && database->number(value, number)) {
+        result["lat"] = number;
+    }
+
+    if (database->find(record, {"location", "longitude"}, value) && database->number(value, number)) {
+        result["lon"] = number;
+    }
+
+    if (database->find(record, {"location", "time_zone"}, value) && database->string(value, text)) {
+        result["timezone"] = text;
+    }
+
+    return !result.isEmpty();
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::lookup(
+        const QString host,
+        Nedrysoft::Core::GeoFunction function ) -> void {
+
+    auto result = QVariantMap();
+
+    initialise();
+
+    if (find(host, result)) {
+        function(host, result);
+
+        return;
+    }
+
+    /**
+     * without a database (or an entry in it) the lookup falls through to the online providers.
+     */
+
+    for (auto provider : Nedrysoft::Core::ObjectRegistry::getInstance()->objects<Nedrysoft::Core::IGeoIPProvider>()) {
+        if (provider!=this) {
+            provider->lookup(host, function);
+
+            return;
+        }
+    }
+}
+
+auto Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider::lookup(const QString host) -> void {
+    lookup(host, [=](const QString &hostAddress, const QVariantMap &result) {
+        Q_EMIT this->result(hostAddress, result);
+    });
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDER_H
+#define PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDER_H
+
+#include "MMDBGeoIPProviderSpec.h"
+
+#include <IInterface>
+#include <IGeoIPProvider>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+#include <memory>
+
+namespace Nedrysoft { namespace MMDBGeoIPProvider {
+    class Database;
+
+    /**
+     * @brief       The MMDBGeoIPProvider class provides a geo lookup from a local MaxMind DB file.
+     *
+     * @details     A GeoLite2 or DB-IP city or country database placed in the application storage folder is used
+     *              to locate addresses without any network traffic.  The file is watched and reloaded when it is
+     *              replaced, if no database is available (or it has no entry for an address) the lookup is passed
+     *              on to the other geo IP providers.
+     */
+    class MMDBGeoIPProvider :
+            public Nedrysoft::Core::IGeoIPProvider {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::Core::IGeoIPProvider)
+
+        public:
+            /**
+             * @brief       Constructs a MMDBGeoIPProvider.
+             */
+            MMDBGeoIPProvider();
+
+            /**
+             * @brief       Destroys the MMDBGeoIPProvider.
+             */
+            ~MMDBGeoIPProvider();
+
+            /**
+             * @brief       Performs a host lookup using IP address or hostname.
+             *
+             * @details     The operation is asynchronous and the result is provided via the
+             *              Nedrysoft::Core::IGeoIPProvider::result signal.
+             *
+             * @see         Nedrysoft::Core::IGeoIPProvider::lookup
+             *
+             * @param[in]   host the host address to be looked up.
+             */
+            auto lookup(const QString host) -> void override;
+
+            /**
+             * @brief       Performs a host lookup using IP address or hostname.
+             *
+             * @details     This overloaded function uses a std::function to obtain the result, this can be
+             *              a callback function or a lambda function.
+             *
+             * @see         Nedrysoft::Core::IGeoIPProvider::lookup
+             *
+             * @param[in]   host the host address to be looked up.
+             * @param[in]   function the function called when a result is available.
+             */
+            auto lookup(const QString host, Nedrysoft::Core::GeoFunction function) -> void override;
+
+        private:
+            /**
+             * @brief       Opens the database and starts watching for it to be replaced.
+             *
+             * @details     The database is opened on the first lookup rather than at startup, an application that
+             *              never looks up a location never maps the database.
+             */
+            auto initialise() -> void;
+
+            /**
+             * @brief       Opens the database if it has been added or replaced since it was last loaded.
+             *
+             * @details     The new database is swapped in under the mutex, a find that is already running keeps its
+             *              own reference to the old one, which is closed when the last reference is released.
+             */
+            auto reload() -> void;
+
+            /**
+             * @brief       Reads the geo information for an address from the database.
+             *
+             * @param[in]   host the address to look up.
+             * @param[out]  result the geo information.
+             *
+             * @returns     true if the database holds an entry for the address; otherwise false.
+             */
+            auto find(const QString &host, QVariantMap &result) const -> bool;
+
+        private:
+            //! @cond
+
+            std::shared_ptr<const Nedrysoft::MMDBGeoIPProvider::Database> m_database;
+            mutable QMutex m_databaseMutex;
+            QFileSystemWatcher m_watcher;
+            QTimer m_reloadTimer;
+            QString m_databaseFilename;
+            QDateTime m_databaseModified;
+            qint64 m_databaseSize;
+            bool m_initialised;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDER_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDERCOMPONENT_H
+#define PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDERCOMPONENT_H
+
+#include "MMDBGeoIPProviderSpec.h"
+
+#include <IComponent>
+#include <ILogger>
+
+namespace Nedrysoft { namespace MMDBGeoIPProvider {
+    class MMDBGeoIPProvider;
+}}
+
+/**
+ * @brief       The MMDBGeoIPProviderComponent class provides a geo location lookup from a local MaxMind DB file.
+ */
+class NEDRYSOFT_MMDBGEOIPPROVIDER_DLLSPEC MMDBGeoIPProviderComponent :
+        public QObject,
+        public Nedrysoft::ComponentSystem::IComponent {
+
+    private:
+    Q_OBJECT
+
+        Q_PLUGIN_METADATA(IID NedrysoftComponentInterfaceIID FILE "metadata.json")
+
+        Q_INTERFACES(Nedrysoft::ComponentSystem::IComponent)
+
+    public:
+        /**
+         * @brief       Constructs a MMDBGeoIPProviderComponent.
+         */
+        MMDBGeoIPProviderComponent();
+
+        /**
+         * @brief       Destroys the MMDBGeoIPProviderComponent.
+         *
+         */
+        ~MMDBGeoIPProviderComponent();
+
+        /**
+         * @brief       The initialiseEvent is called by the component loader to initialise the component.
+         *
+         * @details     Called by the component loader after all components have been loaded, called in load order.
+         *
+         * @see         Nedrysoft::ComponentSystem::IComponent::initialiseEvent
+         */
+        auto initialiseEvent() -> void override;
+
+        /**
+         * @brief       The finaliseEvent method is called before the component is unloaded.
+         *
+         * @note        The event is called in reverse load order for all loaded components, once every component
+         *              has been finalised the component manager then unloads all components in thr same order.
+         */
+        auto finaliseEvent() -> void override;
+
+    private:
+        //! @cond
+
+        Nedrysoft::MMDBGeoIPProvider::MMDBGeoIPProvider *m_provider;
+
+        //! @endcond
+};
+
+#endif // PINGNOO_COMPONENTS_MMDBGEOIPPROVIDER_MMDBGEOIPPROVIDERCOMPONENT_H
@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsExporter.h"
+
+#include <Diagnostics>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPair>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <functional>
+
+constexpr auto MaximumRequestSize = 8192;
+constexpr auto RequestTimeout = 10000;
+constexpr auto RoundTripTimeQuantiles = std::array<double, 4>{0.5, 0.9, 0.95, 0.99};
+constexpr auto HeaderTerminator = "\r\n\r\n";
+constexpr auto MetricsPath = "/metrics";
+constexpr auto OpenMetricsType = "application/openmetrics-text";
+constexpr auto OpenMetricsContentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+constexpr auto PrometheusContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+static auto escapeLabel(const QString &value) -> QByteArray {
+    auto escaped = value.toUtf8();
+
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+
+    return escaped;
+}
+
+static auto formatValue(double value) -> QByteArray {
+    auto text = QByteArray::number(value, 'g', 9);
+
+    /**
+     * OpenMetrics expects floating point values such as summary quantiles to be written with a decimal point.
+     */
+
+    if ((!text.contains('.')) && (!text.contains('e'))) {
+        text.append(".0");
+    }
+
+    return text;
+}
+
+static auto response(int status, const QByteArray &reason, const QByteArray &contentType, const QByteArray &body,
+                     bool includeBody) -> QByteArray {
+
+    auto text = QByteArray("HTTP/1.1 ")+QByteArray::number(status)+" "+reason+"\r\n";
+
+    text += "Content-Type: "+contentType+"\r\n";
+    text += "Content-Length: "+QByteArray::number(body.size())+"\r\n";
+    text += "Connection: close\r\n\r\n";
+
+    if (includeBody) {
+        text += body;
+    }
+
+    return text;
+}
+
+Nedrysoft::MetricsExporter::MetricsExporter::MetricsExporter() :
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_server(nullptr),
+        m_processQueued(false) {
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
+}
+
+Nedrysoft::MetricsExporter::MetricsExporter::~MetricsExporter() {
+    /**
+     * the server and its sockets belong to the worker thread, so they are destroyed there before it is stopped.
+     */
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        delete m_server;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::listen(const QHostAddress &address, quint16 port) -> bool {
+    auto listening = false;
+
+    QMetaObject::invokeMethod(m_context, [this, address, port, &listening]() {
+        delete m_server;
+
+        m_server = new QTcpServer(m_context);
+
+        if (!m_server->listen(address, port)) {
+            SPDLOG_ERROR(QString("Unable to serve metrics on %1:%2. (%3)")
+                    .arg(address.toString())
+                    .arg(port)
+                    .arg(m_server->errorString()).toStdString());
+
+            delete m_server;
+
+            m_server = nullptr;
+
+            return;
+        }
+
+        connect(m_server, &QTcpServer::newConnection, m_context, [this]() {
+            while (m_server->hasPendingConnections()) {
+                auto socket = m_server->nextPendingConnection();
+
+                connect(socket, &QTcpSocket::readyRead, m_context, [this, socket]() {
+                    readRequest(socket);
+                });
+
+                connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+
+                /**
+                 * a client that never completes its request is dropped rather than holding the socket open.
+                 */
+
+                QTimer::singleShot(RequestTimeout, socket, [socket]() {
+                    socket->abort();
+                });
+            }
+        });
+
+        listening = true;
+    }, Qt::BlockingQueuedConnection);
+
+    return listening;
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::update(
+        const QString &target,
+        int hop,
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    auto address = QHostAddress();
+
+    for (auto result=results.crbegin();result!=results.crend();result++) {
+        if (!Nedrysoft::RouteAnalyser::PingResult::isLost(result->code())) {
+            address = result->hostAddress();
+
+            break;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    /**
+     * the aggregates already account for every earlier result, so only the latest of a hop is kept until the worker
+     * takes it.
+     */
+
+    auto &metrics = m_pending[qMakePair(target, hop)];
+
+    metrics.statistics = statistics;
+
+    if (!address.isNull()) {
+        metrics.address = address;
+    }
+
+    queueProcess();
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::removeTarget(const QString &target) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    /**
+     * the removal is applied before the queued updates, so updates for the target that were queued before it was
+     * removed are discarded here rather than recreating its metrics.
+     */
+
+    for (auto iterator=m_pending.begin();iterator!=m_pending.end();) {
+        if (iterator.key().first==target) {
+            iterator = m_pending.erase(iterator);
+        } else {
+            iterator++;
+        }
+    }
+
+    m_removed.append(target);
+
+    queueProcess();
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::queueProcess() -> void {
+    if (m_processQueued) {
+        return;
+    }
+
+    m_processQueued = true;
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        process();
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::process() -> void {
+    auto pending = QMap<QPair<QString, int>, HopMetrics>();
+    auto removed = QStringList();
+
+    m_mutex.lock();
+
+    pending.swap(m_pending);
+    removed.swap(m_removed);
+
+    m_processQueued = false;
+
+    m_mutex.unlock();
+
+    for (auto &target : removed) {
+        m_metrics.remove(target);
+    }
+
+    for (auto update=pending.constBegin();update!=pending.constEnd();update++) {
+        auto &metrics = m_metrics[update.key().first][update.key().second];
+
+        metrics.statistics = update->statistics;
+
+        if (!update->address.isNull()) {
+            metrics.address = update->address;
+        }
+    }
+
+    for (auto &exposition : m_expositions) {
+        exposition.clear();
+    }
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::readRequest(QTcpSocket *socket) -> void {
+    auto request = socket->peek(MaximumRequestSize);
+    auto headerEnd = request.indexOf(HeaderTerminator);
+
+    if (headerEnd<0) {
+        if (socket->bytesAvailable()>=MaximumRequestSize) {
+            socket->write(response(431, "Request Header Fields Too Large", "text/plain", QByteArray(), false));
+            socket->disconnectFromHost();
+        }
+
+        return;
+    }
+
+    socket->read(headerEnd+static_cast<int>(qstrlen(HeaderTerminator)));
+
+    disconnect(socket, &QTcpSocket::readyRead, m_context, nullptr);
+
+    auto lines = request.left(headerEnd).split('\n');
+    auto requestLine = lines.takeFirst().trimmed().split(' ');
+    auto openMetrics = false;
+
+    for (auto &line : lines) {
+        auto separator = line.indexOf(':');
+
+        if ((separator>0) && (line.left(separator).trimmed().toLower()=="accept")) {
+            openMetrics = line.mid(separator+1).contains(OpenMetricsType);
+        }
+    }
+
+    auto method = requestLine.value(0);
+    auto path = requestLine.value(1);
+
+    path = path.left(path.indexOf('?'));
+
+    if ((method!="GET") && (method!="HEAD")) {
+        socket->write(response(405, "Method Not Allowed", "text/plain", QByteArray(), false));
+    } else if (path!=MetricsPath) {
+        socket->write(response(404, "Not Found", "text/plain", QByteArray(), false));
+    } else {
+        auto body = exposition(openMetrics)+engineExposition(openMetrics)+memoryExposition(openMetrics);
+
+        if (openMetrics) {
+            body += "# EOF\n";
+        }
+
+        socket->write(response(
+            200,
+            "OK",
+            openMetrics ? OpenMetricsContentType : PrometheusContentType,
+            body,
+            method=="GET" ));
+    }
+
+    socket->disconnectFromHost();
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::exposition(bool openMetrics) -> QByteArray {
+    auto &text = m_expositions[openMetrics ? 1 : 0];
+
+    if (!text.isEmpty()) {
+        return text;
+    }
+
+    /**
+     * the families are written one after another, each with a sample for every hop, counters are named with the
+     * _total suffix only on their samples in OpenMetrics but on the family as well in the Prometheus format.
+     */
+
+    auto family = [&text](const QByteArray &name, const QByteArray &type, const QByteArray &help) {
+        text += "# HELP "+name+" "+help+"\n";
+        text += "# TYPE "+name+" "+type+"\n";
+    };
+
+    auto counterFamily = [&](const QByteArray &name, const QByteArray &help) -> QByteArray {
+        family(openMetrics ? name : name+"_total", "counter", help);
+
+        return name+"_total";
+    };
+
+    auto forEachHop = [this](const std::function<void(const QByteArray &, const HopMetrics &)> &function) {
+        for (auto target=m_metrics.begin();target!=m_metrics.end();target++) {
+            for (auto hop=target->begin();hop!=target->end();hop++) {
+                auto labels = "target=\""+escapeLabel(target.key())+"\","
+                              "hop=\""+QByteArray::number(hop.key())+"\","
+                              "address=\""+escapeLabel(hop->address.toString())+"\"";
+
+                function(labels, hop.value());
+            }
+        }
+    };
+
+    family("pingnoo_hop_rtt_seconds", "summary", "The round trip time of the replies from the hop.");
+
+    forEachHop([&text](const QByteArray &labels, const HopMetrics &metrics) {
+        auto &latencyStatistics = metrics.statistics.latencyStatistics();
+        auto &latencySketch = metrics.statistics.latencySketch();
+        auto count = latencyStatistics.count();
+
+        if (!latencySketch.isEmpty()) {
+            for (auto quantile : RoundTripTimeQuantiles) {
+                text += "pingnoo_hop_rtt_seconds{"+labels+",quantile=\""+formatValue(quantile)+"\"} "+
+                        formatValue(latencySketch.quantile(quantile))+"\n";
+            }
+        }
+
+        text += "pingnoo_hop_rtt_seconds_sum{"+labels+"} "+
+                formatValue(count ? latencyStatistics.mean()*static_cast<double>(count) : 0.0)+"\n";
+        text += "pingnoo_hop_rtt_seconds_count{"+labels+"} "+QByteArray::number(static_cast<quint64>(count))+"\n";
+    });
+
+    auto replies = counterFamily("pingnoo_hop_replies", "The number of requests that the hop replied to.");
+
+    forEachHop([&text, &replies](const QByteArray &labels, const HopMetrics &metrics) {
+        text += replies+"{"+labels+"} "+QByteArray::number(static_cast<quint64>(metrics.statistics.replyCount()))+"\n";
+    });
+
+    auto timeouts = counterFamily("pingnoo_hop_timeouts", "The number of requests that the hop did not reply to.");
+
+    forEachHop([&text, &timeouts](const QByteArray &labels, const HopMetrics &metrics) {
+        text += timeouts+"{"+labels+"} "+
+                QByteArray::number(static_cast<quint64>(metrics.statistics.timeoutCount()))+"\n";
+    });
+
+    family("pingnoo_hop_latency_seconds", "gauge", "The round trip time of the most recent reply from the hop.");
+
+    forEachHop([&text](const QByteArray &labels, const HopMetrics &metrics) {
+        auto latency = metrics.statistics.currentLatency();
+
+        if (latency>=0) {
+            text += "pingnoo_hop_latency_seconds{"+labels+"} "+formatValue(latency)+"\n";
+        }
+    });
+
+    family("pingnoo_hop_jitter_seconds", "gauge", "The RFC 3550 interarrival jitter of the replies from the hop.");
+
+    forEachHop([&text](const QByteArray &labels, const HopMetrics &metrics) {
+        auto jitter = metrics.statistics.jitterStatistics().jitter();
+
+        if (jitter>=0) {
+            text += "pingnoo_hop_jitter_seconds{"+labels+"} "+formatValue(jitter)+"\n";
+        }
+    });
+
+    return text;
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::engineExposition(bool openMetrics) -> QByteArray {
+    m_mutex.lock();
+
+    auto factories = m_pingEngineFactories;
+
+    m_mutex.unlock();
+
+    /**
+     * the engine counters change with every packet, so unlike the hop metrics they are read afresh for each scrape.
+     */
+
+    auto samples = QVector<QPair<QByteArray, Nedrysoft::RouteAnalyser::PingEngineStatistics> >();
+
+    for (auto factory : factories) {
+        auto statistics = factory->statistics();
+
+        if (statistics.valid) {
+            samples.append(qMakePair("engine=\""+escapeLabel(factory->description())+"\"", statistics));
+        }
+    }
+
+    auto text = QByteArray();
+
+    if (samples.isEmpty()) {
+        return text;
+    }
+
+    auto family = [&text](const QByteArray &name, const QByteArray &type, const QByteArray &help) {
+        text += "# HELP "+name+" "+help+"\n";
+        text += "# TYPE "+name+" "+type+"\n";
+    };
+
+    using Statistics = Nedrysoft::RouteAnalyser::PingEngineStatistics;
+
+    auto counter = [&](const QByteArray &name, const QByteArray &help, quint64 Statistics::*field) {
+        family(openMetrics ? name : name+"_total", "counter", help);
+
+        for (auto &sample : samples) {
+            text += name+"_total{"+sample.first+"} "+QByteArray::number(sample.second.*field)+"\n";
+        }
+    };
+
+    counter("pingnoo_engine_packets_sent", "The number of requests sent.", &Statistics::packetsSent);
+    counter("pingnoo_engine_send_errors", "The number of requests that could not be sent.", &Statistics::sendErrors);
+    counter("pingnoo_engine_packets_received", "The number of replies matched to a request.",
+            &Statistics::packetsReceived);
+    counter("pingnoo_engine_unmatched_replies", "The number of replies that could not be matched to a request.",
+            &Statistics::unmatchedReplies);
+    counter("pingnoo_engine_duplicate_replies", "The number of replies to a request that was already answered.",
+            &Statistics::duplicateReplies);
+    counter("pingnoo_engine_reordered_replies", "The number of replies that overtook a reply sent before them.",
+            &Statistics::reorderedReplies);
+    counter("pingnoo_engine_late_replies", "The number of replies that arrived after their request expired.",
+            &Statistics::lateReplies);
+    counter("pingnoo_engine_timeouts", "The number of requests that expired without a reply.", &Statistics::timedOut);
+    counter("pingnoo_engine_evicted_requests", "The number of requests discarded to make room for newer ones.",
+            &Statistics::evictedRequests);
+    counter("pingnoo_engine_receive_drops", "The number of packets dropped by the kernel before being read.",
+            &Statistics::receiveDrops);
+
+    family("pingnoo_engine_outstanding_requests", "gauge", "The number of requests awaiting a reply.");
+
+    for (auto &sample : samples) {
+        text += "pingnoo_engine_outstanding_requests{"+sample.first+"} "+
+                QByteArray::number(sample.second.outstandingRequests)+"\n";
+    }
+
+    family("pingnoo_engine_scheduling_lag_seconds", "summary", "How late transmissions started after their deadline.");
+
+    for (auto &sample : samples) {
+        text += "pingnoo_engine_scheduling_lag_seconds_sum{"+sample.first+"} "+
+                formatValue(sample.second.schedulingLagSum)+"\n";
+        text += "pingnoo_engine_scheduling_lag_seconds_count{"+sample.first+"} "+
+                QByteArray::number(sample.second.schedulingLagCount)+"\n";
+    }
+
+    family("pingnoo_engine_scheduling_lag_max_seconds", "gauge", "The latest that a transmission has started.");
+
+    for (auto &sample : samples) {
+        text += "pingnoo_engine_scheduling_lag_max_seconds{"+sample.first+"} "+
+                formatValue(sample.second.schedulingLagMaximum)+"\n";
+    }
+
+    return text;
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::memoryExposition(bool openMetrics) -> QByteArray {
+    Q_UNUSED(openMetrics)
+
+    auto memoryUsage = Nedrysoft::Core::Diagnostics::getInstance()->memoryUsage();
+    auto text = QByteArray();
+
+    if (memoryUsage.isEmpty()) {
+        return text;
+    }
+
+    auto labels = [](const Nedrysoft::Core::Diagnostics::MemoryUsage &usage) -> QByteArray {
+        return "subsystem=\""+escapeLabel(usage.subsystem)+"\",owner=\""+escapeLabel(usage.owner)+"\"";
+    };
+
+    text += "# HELP pingnoo_memory_bytes The memory accounted to the subsystem.\n";
+    text += "# TYPE pingnoo_memory_bytes gauge\n";
+
+    for (auto &usage : memoryUsage) {
+        text += "pingnoo_memory_bytes{"+labels(usage)+"} "+QByteArray::number(usage.bytes)+"\n";
+    }
+
+    text += "# HELP pingnoo_memory_allocations The number of allocations or objects held by the subsystem.\n";
+    text += "# TYPE pingnoo_memory_allocations gauge\n";
+
+    for (auto &usage : memoryUsage) {
+        text += "pingnoo_memory_allocations{"+labels(usage)+"} "+QByteArray::number(usage.allocations)+"\n";
+    }
+
+    return text;
+}
+
+auto Nedrysoft::MetricsExporter::MetricsExporter::setPingEngineFactories(
+        const QList<Nedrysoft::RouteAnalyser::IPingEngineFactory *> &factories) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    m_pingEngineFactories = factories;
+}
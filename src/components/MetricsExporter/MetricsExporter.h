@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_METRICSEXPORTER_METRICSEXPORTER_H
+#define PINGNOO_COMPONENTS_METRICSEXPORTER_METRICSEXPORTER_H
+
+#include "MetricsExporterSpec.h"
+
+#include <HopStatistics>
+#include <IMetricsExporter>
+#include <IPingEngineFactory>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <array>
+
+class QTcpServer;
+class QTcpSocket;
+class QThread;
+
+namespace Nedrysoft { namespace MetricsExporter {
+    /**
+     * @brief       The MetricsExporter class serves live per hop metrics over HTTP.
+     *
+     * @details     The exporter serves the aggregates maintained by the statistics engine rather than its own,
+     *              update() keeps the latest aggregates of each hop and a worker thread takes them and serves
+     *              GET /metrics requests.  The text exposition of the aggregates is built on the worker thread when
+     *              a scrape arrives after they have changed and is reused until they change again, so a scrape
+     *              never touches the threads that probe or draw.
+     *
+     *              The Prometheus text format is served unless the scraper asks for OpenMetrics.
+     */
+    class NEDRYSOFT_METRICSEXPORTER_DLLSPEC MetricsExporter :
+            public Nedrysoft::RouteAnalyser::IMetricsExporter {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IResultSink Nedrysoft::RouteAnalyser::IMetricsExporter)
+
+        public:
+            /**
+             * @brief       The aggregates of a single hop.
+             */
+            struct HopMetrics {
+                QHostAddress address;                                   //!< the address that most recently replied.
+                Nedrysoft::RouteAnalyser::HopStatistics statistics;     //!< the aggregates of the hop.
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new MetricsExporter and starts its thread.
+             */
+            MetricsExporter();
+
+            /**
+             * @brief       Stops the thread and destroys the MetricsExporter.
+             */
+            ~MetricsExporter();
+
+            /**
+             * @brief       Starts serving the metrics on the given address and port.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IMetricsExporter::listen
+             *
+             * @param[in]   address the address to listen on.
+             * @param[in]   port the port to listen on.
+             *
+             * @returns     true if the exporter is listening; otherwise false.
+             */
+            auto listen(const QHostAddress &address, quint16 port) -> bool override;
+
+            /**
+             * @brief       Replaces the metrics of a hop with its latest aggregates.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::update
+             *
+             * @param[in]   target the name of the target that the hop belongs to.
+             * @param[in]   hop the hop number.
+             * @param[in]   statistics the aggregates of the hop.
+             * @param[in]   results the results received for the hop since the previous update.
+             */
+            auto update(
+                    const QString &target,
+                    int hop,
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results
+            ) -> void override;
+
+            /**
+             * @brief       Removes the metrics of every hop of a target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::removeTarget
+             *
+             * @param[in]   target the name of the target.
+             */
+            auto removeTarget(const QString &target) -> void override;
+
+            /**
+             * @brief       Sets the ping engine factories whose health counters are served with the hop metrics.
+             *
+             * @details     The counters are read when a scrape arrives, so they are always current.
+             *
+             * @param[in]   factories the factories.
+             */
+            auto setPingEngineFactories(const QList<Nedrysoft::RouteAnalyser::IPingEngineFactory *> &factories) -> void;
+
+        private:
+            /**
+             * @brief       Queues the processing of the pending updates, called with the mutex held.
+             */
+            auto queueProcess() -> void;
+
+            /**
+             * @brief       Takes the pending aggregates, called on the worker thread.
+             */
+            auto process() -> void;
+
+            /**
+             * @brief       Reads a request from a socket and answers it once it is complete.
+             *
+             * @param[in]   socket the client socket.
+             */
+            auto readRequest(QTcpSocket *socket) -> void;
+
+            /**
+             * @brief       Returns the text exposition of the aggregates.
+             *
+             * @param[in]   openMetrics true for the OpenMetrics format; otherwise the Prometheus text format.
+             *
+             * @returns     the exposition.
+             */
+            auto exposition(bool openMetrics) -> QByteArray;
+
+            /**
+             * @brief       Returns the text exposition of the ping engine health counters.
+             *
+             * @param[in]   openMetrics true for the OpenMetrics format; otherwise the Prometheus text format.
+             *
+             * @returns     the exposition.
+             */
+            auto engineExposition(bool openMetrics) -> QByteArray;
+
+            /**
+             * @brief       Returns the text exposition of the memory accounted by each subsystem and editor.
+             *
+             * @param[in]   openMetrics true for the OpenMetrics format; otherwise the Prometheus text format.
+             *
+             * @returns     the exposition.
+             */
+            auto memoryExposition(bool openMetrics) -> QByteArray;
+
+        private:
+            //! @cond
+
+            QThread *m_thread;
+            QObject *m_context;
+            QTcpServer *m_server;
+
+            QMutex m_mutex;
+            QMap<QPair<QString, int>, HopMetrics> m_pending;
+            QStringList m_removed;
+            bool m_processQueued;
+            QList<Nedrysoft::RouteAnalyser::IPingEngineFactory *> m_pingEngineFactories;
+
+            QMap<QString, QMap<int, HopMetrics> > m_metrics;
+            std::array<QByteArray, 2> m_expositions;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_METRICSEXPORTER_METRICSEXPORTER_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsExporterComponent.h"
+
+#include "MetricsExporter.h"
+
+#include <IPingEngineFactory>
+#include <ObjectRegistry>
+#include <QHostAddress>
+#include <QSettings>
+
+#include <limits>
+
+constexpr auto PortSettingsKey = "MetricsExporter/Port";
+constexpr auto AddressSettingsKey = "MetricsExporter/Address";
+constexpr auto DefaultAddress = "127.0.0.1";
+
+MetricsExporterComponent::MetricsExporterComponent() :
+        m_metricsExporter(nullptr) {
+
+}
+
+MetricsExporterComponent::~MetricsExporterComponent() {
+
+}
+
+auto MetricsExporterComponent::finaliseEvent() -> void {
+    if (m_metricsExporter) {
+        Nedrysoft::ComponentSystem::removeObject(m_metricsExporter);
+
+        delete m_metricsExporter;
+    }
+}
+
+auto MetricsExporterComponent::initialiseEvent() -> void {
+    QSettings settings;
+
+    m_metricsExporter = new Nedrysoft::MetricsExporter::MetricsExporter();
+
+    Nedrysoft::ComponentSystem::addObject(m_metricsExporter);
+
+    /**
+     * nothing is served until a port has been configured, the headless runner can also start the exporter from
+     * its command line.
+     */
+
+    auto port = settings.value(PortSettingsKey, 0).toUInt();
+
+    if ((port) && (port<=std::numeric_limits<quint16>::max())) {
+        m_metricsExporter->listen(
+            QHostAddress(settings.value(AddressSettingsKey, DefaultAddress).toString()),
+            static_cast<quint16>(port) );
+    }
+}
+
+auto MetricsExporterComponent::initialisationFinishedEvent() -> void {
+    m_metricsExporter->setPingEngineFactories(
+        Nedrysoft::Core::ObjectRegistry::getInstance()->objects<Nedrysoft::RouteAnalyser::IPingEngineFactory>() );
+}
@@ -25,26 +25,70 @@
 
 #include "PingCommandPingTarget.h"
 
-#include <QElapsedTimer>
-#include <QMutex>
+#include <Clock>
+#include <QDateTime>
+#include <QHostAddress>
 #include <QProcess>
 #include <QRegularExpression>
-#include <QThread>
 
-constexpr auto DefaultReceiveTimeout = 1000;
-constexpr auto DefaultTerminateThreadTimeout = 5000;
+constexpr auto DefaultTransmitInterval = 2500;
 constexpr auto DefaultTTL = 64;
+constexpr auto DefaultPayloadSize = 56;
+constexpr auto MaximumPayloadSize = 65507;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto NanosecondsInMicrosecond = 1000ll;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto MicrosecondDigits = 6;
+
+/**
+ * @brief       The expressions used to parse the output of the ping command.
+ *
+ * @details     These are compiled once and shared, each line of output is matched against them in turn.  The
+ *              timestamp is the one printed by the -D option, the address may be either IPv4 or IPv6.
+ */
+static const QRegularExpression ReplyRegularExpression(
+    R"(^\[(?<seconds>\d+)\.(?<fraction>\d+)\]\s+\d+\s+bytes\s+from\s+(?<ip>[0-9a-fA-F\.:]+?):?\s+)"
+    R"(icmp_seq=(?<sequence>\d+).*time=(?<time>[\d\.]+)\s*ms)"
+);
+
+static const QRegularExpression TtlExceededRegularExpression(
+    R"(^\[(?<seconds>\d+)\.(?<fraction>\d+)\]\s+From\s+(?<ip>[0-9a-fA-F\.:]+?):?\s+)"
+    R"(icmp_seq=(?<sequence>\d+).*exceeded)"
+);
+
+static const QRegularExpression NoAnswerRegularExpression(
+    R"(^\[(?<seconds>\d+)\.(?<fraction>\d+)\]\s+no answer yet for icmp_seq=(?<sequence>\d+))"
+);
+
+/**
+ * @brief       Converts the timestamp captured from a line of ping output to nanoseconds since the epoch.
+ *
+ * @param[in]   match the match containing the seconds and fraction captures.
+ *
+ * @returns     the timestamp in nanoseconds.
+ */
+static auto matchTimestamp(const QRegularExpressionMatch &match) -> qint64 {
+    auto fraction = match.captured("fraction").left(MicrosecondDigits).leftJustified(MicrosecondDigits, '0');
 
-constexpr auto PacketLostRegularExpression = R"(100% packet loss)";
-constexpr auto TtlExceededRegularExpression = R"(From\ (?<ip>[\d\.]*)\ .*exceeded)";
+    return (match.captured("seconds").toLongLong() * NanosecondsInSecond) +
+           (fraction.toLongLong() * NanosecondsInMicrosecond);
+}
+
+Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::PingCommandPingEngine(Nedrysoft::Core::IPVersion version) :
+        m_interval(DefaultTransmitInterval),
+        m_payloadSize(DefaultPayloadSize),
+        m_dontFragment(false),
+        m_isRunning(false) {
 
-Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::PingCommandPingEngine(Nedrysoft::Core::IPVersion version) {
     Q_UNUSED(version)
 
 }
 
 Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::~PingCommandPingEngine() {
+    stop();
 
+    qDeleteAll(m_pingTargets);
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::addTarget(
@@ -65,22 +109,50 @@ auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::addTarget(
 
     m_pingTargets.append(newTarget);
 
+    if (m_isRunning) {
+        newTarget->start();
+    }
+
     return newTarget;
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::removeTarget(
         Nedrysoft::RouteAnalyser::IPingTarget *target ) -> bool {
 
-    Q_UNUSED(target)
+    for (auto pingTarget : m_pingTargets) {
+        if (static_cast<Nedrysoft::RouteAnalyser::IPingTarget *>(pingTarget) == target) {
+            m_pingTargets.removeOne(pingTarget);
 
-    return true;
+            // the process is killed synchronously so no further results can be emitted for the target, but
+            // we may have been called from a slot connected to one of its results.
+
+            pingTarget->stop();
+            pingTarget->deleteLater();
+
+            return true;
+        }
+    }
+
+    return false;
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::start() -> bool {
+    m_isRunning = true;
+
+    for (auto pingTarget : m_pingTargets) {
+        pingTarget->start();
+    }
+
     return true;
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::stop() -> bool {
+    m_isRunning = false;
+
+    for (auto pingTarget : m_pingTargets) {
+        pingTarget->stop();
+    }
+
     return true;
 }
 
@@ -100,8 +172,129 @@ auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::setTimeout(int tim
     return true;
 }
 
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::setPayloadSize(int payloadSize) -> bool {
+    if ((payloadSize < 0) || (payloadSize > MaximumPayloadSize)) {
+        return false;
+    }
+
+    m_payloadSize = payloadSize;
+
+    return true;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::setDontFragment(bool dontFragment) -> bool {
+    m_dontFragment = dontFragment;
+
+    return true;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::dontFragment() -> bool {
+    return m_dontFragment;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::pingArguments(
+        const QHostAddress &hostAddress,
+        int ttl,
+        double timeout,
+        int payloadSize,
+        int interval) -> QStringList {
+
+    auto arguments = QStringList() <<
+            "-W" << QString("%1").arg(timeout) <<
+            "-D" <<
+            "-n";
+
+    if (interval > 0) {
+        arguments << "-O" << "-i" << QString("%1").arg(interval / MillisecondsInSecond);
+    } else {
+        arguments << "-c" << "1";
+    }
+
+    arguments <<
+            "-t" << QString("%1").arg(ttl) <<
+            "-s" << QString("%1").arg(payloadSize);
+
+#if defined(Q_OS_LINUX)
+    if (m_dontFragment) {
+        arguments << "-M" << "do";
+    }
+#endif
+
+    arguments << hostAddress.toString();
+
+    return arguments;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::parseResult(
+        const QString &line,
+        int interval,
+        Nedrysoft::RouteAnalyser::IPingTarget *target,
+        Nedrysoft::RouteAnalyser::PingResult &pingResult) -> bool {
+
+    // ping numbers requests from 1, the sample numbers used by the engines start at 0.
+
+    auto match = ReplyRegularExpression.match(line);
+
+    if (match.hasMatch()) {
+        auto roundTripTime = static_cast<qint64>(match.captured("time").toDouble() * NanosecondsInMillisecond);
+
+        pingResult = Nedrysoft::RouteAnalyser::PingResult(
+            match.captured("sequence").toULong() - 1,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
+            QHostAddress(match.captured("ip")),
+            matchTimestamp(match) - roundTripTime,
+            roundTripTime,
+            target,
+            -1
+        );
+
+        return true;
+    }
+
+    match = TtlExceededRegularExpression.match(line);
+
+    if (match.hasMatch()) {
+        pingResult = Nedrysoft::RouteAnalyser::PingResult(
+            match.captured("sequence").toULong() - 1,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded,
+            QHostAddress(match.captured("ip")),
+            matchTimestamp(match),
+            -1,
+            target,
+            -1
+        );
+
+        return true;
+    }
+
+    match = NoAnswerRegularExpression.match(line);
+
+    if (match.hasMatch()) {
+        // the line is printed when the following request is sent, so the unanswered request went out one
+        // interval earlier.
+
+        pingResult = Nedrysoft::RouteAnalyser::PingResult(
+            match.captured("sequence").toULong() - 1,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+            target ? target->hostAddress() : QHostAddress(),
+            matchTimestamp(match) - (static_cast<qint64>(interval) * NanosecondsInMillisecond),
+            -1,
+            target,
+            -1
+        );
+
+        return true;
+    }
+
+    return false;
+}
+
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::epoch() -> QDateTime {
-    return QDateTime::currentDateTime();
+    return Nedrysoft::Core::Clock::getInstance()->currentDateTime();
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::saveConfiguration() -> QJsonObject {
@@ -138,71 +331,31 @@ auto Nedrysoft::PingCommandPingEngine::PingCommandPingEngine::singleShot(
         double timeout) -> Nedrysoft::RouteAnalyser::PingResult {
 
     QProcess pingProcess;
-    QElapsedTimer timer;
-    QDateTime epoch;
 
-    auto pingArguments = QStringList() <<
-                                       "-W" << QString("%1").arg(timeout) <<
-                                       "-D" <<
-                                       "-c" << "1" <<
-                                       "-t" << QString("%1").arg(ttl) <<
-                                       hostAddress.toString();
+    auto requestTimestamp = Nedrysoft::Core::Clock::getInstance()->now();
 
-    pingProcess.start("ping", pingArguments);
+    pingProcess.start("ping", pingArguments(hostAddress, ttl, timeout, m_payloadSize));
 
     pingProcess.waitForStarted();
-
-    timer.restart();
-
-    epoch = QDateTime::currentDateTime();
-
     pingProcess.waitForFinished();
 
-    auto roundTripTime = timer.elapsed()/1e9;
+    auto commandOutput = QString::fromLocal8Bit(pingProcess.readAllStandardOutput());
 
-    auto commandOutput = pingProcess.readAll();
+    for (const auto &line : commandOutput.split('\n')) {
+        Nedrysoft::RouteAnalyser::PingResult pingResult;
 
-    QRegularExpression ttlExceededRegEx(TtlExceededRegularExpression);
-    QRegularExpression packetLostRegEx(PacketLostRegularExpression);
-
-    Nedrysoft::RouteAnalyser::PingResult pingResult;
-
-    if (pingProcess.exitCode() == 0) {
-        pingResult = Nedrysoft::RouteAnalyser::PingResult(
-            0,
-            Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
-            hostAddress,
-            epoch,
-            roundTripTime,
-            nullptr
-        );
-
-    } else {
-        auto ttlExceededMatch = ttlExceededRegEx.match(commandOutput);
-        auto packetLostMatch = packetLostRegEx.match(commandOutput);
-
-        if (ttlExceededMatch.hasMatch()) {
-            pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                0,
-                Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded,
-                QHostAddress(ttlExceededMatch.captured("ip")),
-                epoch,
-                roundTripTime,
-                nullptr
-            );
-        } else if (packetLostMatch.hasMatch()) {
-            pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                0,
-                Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
-                QHostAddress(packetLostMatch.captured("ip")),
-                epoch,
-                roundTripTime,
-                nullptr
-            );
-        } else {
-            // some other error
+        if (parseResult(line, 0, nullptr, pingResult)) {
+            return pingResult;
         }
     }
 
-    return pingResult;
+    return Nedrysoft::RouteAnalyser::PingResult(
+        0,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+        hostAddress,
+        requestTimestamp,
+        -1,
+        nullptr,
+        -1
+    );
 }
@@ -27,6 +27,7 @@
 #include <IInterface>
 #include <IPingEngine>
 #include <IPingEngineFactory>
+#include <QStringList>
 
 namespace Nedrysoft { namespace PingCommandPingEngine {
     class PingCommandPingTarget;
@@ -84,6 +85,46 @@ namespace Nedrysoft { namespace PingCommandPingEngine {
              */
             auto setTimeout(int timeout) -> bool override;
 
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setPayloadSize(int payloadSize) -> bool override;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setDontFragment
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool override;
+
+            /**
+             * @brief       Returns whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::dontFragment
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            auto dontFragment() -> bool override;
+
             /**
              * @brief       Starts ping operations for this engine instance.
              *
@@ -193,6 +234,48 @@ namespace Nedrysoft { namespace PingCommandPingEngine {
         private:
             auto emitResult(Nedrysoft::RouteAnalyser::PingResult pingResult) -> void;
 
+            /**
+             * @brief       Returns the arguments to pass to the ping command.
+             *
+             * @details     If an interval is given the ping command runs until it is stopped, sending a request
+             *              every interval and reporting requests that went unanswered, otherwise a single request
+             *              is sent.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   payloadSize the number of bytes of payload in the echo request.
+             * @param[in]   interval the interval between requests in milliseconds, or 0 for a single request.
+             *
+             * @returns     the list of arguments.
+             */
+            auto pingArguments(
+                    const QHostAddress &hostAddress,
+                    int ttl,
+                    double timeout,
+                    int payloadSize,
+                    int interval = 0 ) -> QStringList;
+
+            /**
+             * @brief       Parses a line of output from the ping command.
+             *
+             * @details     Lines are expected to have been produced with timestamps enabled (-D), replies, time
+             *              exceeded responses and unanswered requests are recognised, anything else is ignored.
+             *
+             * @param[in]   line the line of output.
+             * @param[in]   interval the interval between requests in milliseconds, used to recover the request
+             *              time of an unanswered request.
+             * @param[in]   target the target that the output belongs to.
+             * @param[out]  pingResult the parsed result.
+             *
+             * @returns     true if the line contained a result; otherwise false.
+             */
+            static auto parseResult(
+                    const QString &line,
+                    int interval,
+                    Nedrysoft::RouteAnalyser::IPingTarget *target,
+                    Nedrysoft::RouteAnalyser::PingResult &pingResult ) -> bool;
+
             friend class PingCommandPingTarget;
 
         private:
@@ -201,6 +284,9 @@ namespace Nedrysoft { namespace PingCommandPingEngine {
             QList<PingCommandPingTarget *> m_pingTargets;
 
             int m_interval;
+            int m_payloadSize;
+            bool m_dontFragment;
+            bool m_isRunning;
 
             //! @endcond
     };
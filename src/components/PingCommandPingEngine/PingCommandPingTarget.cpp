@@ -25,146 +25,97 @@
 
 #include "PingCommandPingEngine.h"
 
-#include <QElapsedTimer>
 #include <QHostAddress>
 #include <QProcess>
-#include <QRegularExpression>
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-#include <QThread>
-#else
-#include <QTimer>
-#include <thread>
-#endif
-#include <cassert>
 
 constexpr auto ReplyTimeout = 3;
-constexpr auto NanosecondsInMillisecond = 1.0e6;
-constexpr auto PacketLostRegularExpression = R"(100% packet loss)";
-constexpr auto TtlExceededRegularExpression = R"(From\ (?<ip>[\d\.]*)\ .*exceeded)";
+constexpr auto TerminateTimeout = 1000;
 
 Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::PingCommandPingTarget(
         Nedrysoft::PingCommandPingEngine::PingCommandPingEngine *engine,
         QHostAddress hostAddress,
         int ttl) :
+            m_process(nullptr),
             m_userdata(nullptr),
-            m_quitThread(false),
             m_engine(engine),
             m_ttl(ttl),
+            m_payloadSize(engine->payloadSize()),
             m_hostAddress(hostAddress) {
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    m_workerThread = QThread::create([=]() {
-#else
-    m_workerThread = new std::thread([=]() {
-#endif
-        auto pingArguments = QStringList() <<
-                "-W" << QString("%1").arg(ReplyTimeout) <<
-                "-D" <<
-                "-c" << "1" <<
-                "-t" << QString("%1").arg(ttl) <<
-                m_hostAddress.toString();
-
-        int sampleNumber = 0;
-
-        while(!m_quitThread) {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-            QThread *pingThread = QThread::create([sampleNumber, pingArguments, engine, pingThread, this]() {
-#else
-            std::thread *pingThread = new std::thread([sampleNumber, pingArguments, engine, pingThread, this]() {
-#endif
-                QProcess pingProcess;
-                qint64 started, finished;
-                QElapsedTimer timer;
-                QDateTime epoch;
-
-               // pingProcess = new QProcess();
-
-                pingProcess.start("ping", pingArguments);
-
-                pingProcess.waitForStarted();
-
-                timer.restart();
-
-                epoch = QDateTime::currentDateTime();
-
-                pingProcess.waitForFinished();
-
-                finished = timer.nsecsElapsed();
-
-                auto roundTripTime = timer.nsecsElapsed()/1e9;
-
-                auto commandOutput = pingProcess.readAll();
-
-                QRegularExpression ttlExceededRegEx(TtlExceededRegularExpression);
-                QRegularExpression packetLostRegEx(PacketLostRegularExpression);
-
-                if (pingProcess.exitCode() == 0) {
-                    auto pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                        sampleNumber,
-                        Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
-                        m_hostAddress,
-                        epoch,
-                        roundTripTime,
-                        this
-                    );
-
-                    engine->emitResult(pingResult);
-                } else {
-                    auto ttlExceededMatch = ttlExceededRegEx.match(commandOutput);
-                    auto packetLostMatch = packetLostRegEx.match(commandOutput);
-
-                    if (ttlExceededMatch.hasMatch()) {
-                        auto pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                            sampleNumber,
-                            Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded,
-                            QHostAddress(ttlExceededMatch.captured("ip")),
-                            epoch,
-                            roundTripTime,
-                            this
-                        );
-
-                        engine->emitResult(pingResult);
-                    } else if (packetLostMatch.hasMatch()) {
-                        auto pingResult = Nedrysoft::RouteAnalyser::PingResult(
-                            sampleNumber,
-                            Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
-                            QHostAddress(packetLostMatch.captured("ip")),
-                            epoch,
-                            roundTripTime,
-                            this
-                        );
-
-                        engine->emitResult(pingResult);
-                    } else {
-                        // some other error
-                    }
-                }
-#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
-                QTimer::singleShot(0, [=]() {
-                    delete pingThread;
-                });
-#endif
-            });
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-            QObject::connect(pingThread, &QThread::finished, pingThread, &QThread::deleteLater);
-
-            pingThread->start();
-
-            QThread::msleep(engine->interval().count());
-#else
-            std::this_thread::sleep_for(std::chrono::milliseconds(engine->interval()));
-#endif
-            sampleNumber++;
-        }
-    });
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    m_workerThread->start();
-#endif
 }
 
 Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::~PingCommandPingTarget() {
+    stop();
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::start() -> bool {
+    if (m_process) {
+        return true;
+    }
+
+    m_process = new QProcess(this);
+
+    m_outputBuffer.clear();
+
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &PingCommandPingTarget::processOutput);
+
+    m_process->start(
+        "ping",
+        m_engine->pingArguments(m_hostAddress, m_ttl, ReplyTimeout, m_payloadSize, m_engine->interval())
+    );
+
+    if (!m_process->waitForStarted()) {
+        delete m_process;
+
+        m_process = nullptr;
+
+        return false;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::stop() -> void {
+    if (!m_process) {
+        return;
+    }
+
+    disconnect(m_process, nullptr, this, nullptr);
+
+    m_process->kill();
+    m_process->waitForFinished(TerminateTimeout);
+
+    // we may be stopped from a slot connected to a result emitted while the process output was being read.
+
+    m_process->deleteLater();
+
+    m_process = nullptr;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::processOutput() -> void {
+    m_outputBuffer.append(m_process->readAllStandardOutput());
+
+    // output may arrive part way through a line, anything after the last newline is kept for the next read.
+
+    auto lineStart = 0;
+    auto lineEnd = m_outputBuffer.indexOf('\n');
+
+    while ((lineEnd != -1) && (m_process)) {
+        processLine(QString::fromLocal8Bit(m_outputBuffer.constData() + lineStart, lineEnd - lineStart));
+
+        lineStart = lineEnd + 1;
+        lineEnd = m_outputBuffer.indexOf('\n', lineStart);
+    }
+
+    m_outputBuffer.remove(0, lineStart);
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::processLine(const QString &line) -> void {
+    Nedrysoft::RouteAnalyser::PingResult pingResult;
 
+    if (PingCommandPingEngine::parseResult(line, m_engine->interval(), this, pingResult)) {
+        m_engine->emitResult(pingResult);
+    }
 }
 
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::setHostAddress(QHostAddress hostAddress) -> void {
@@ -193,6 +144,22 @@ auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::ttl() -> uint16_t
     return m_ttl;
 }
 
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::setPayloadSize(int payloadSize) -> void {
+    m_payloadSize = payloadSize;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::probeBackoff() -> int {
+    return 1;
+}
+
+auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::setSamplingDivisor(int divisor) -> void {
+    Q_UNUSED(divisor)
+}
+
 auto Nedrysoft::PingCommandPingEngine::PingCommandPingTarget::userData() -> void * {
     return m_userdata;
 }
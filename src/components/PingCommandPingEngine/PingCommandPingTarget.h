@@ -26,11 +26,9 @@
 
 #include <IPingTarget>
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-#include <QThread>
-#else
-#include <thread>
-#endif
+#include <QByteArray>
+
+class QProcess;
 
 namespace Nedrysoft { namespace PingCommandPingEngine {
     class PingCommandPingEngine;
@@ -121,6 +119,42 @@ namespace Nedrysoft { namespace PingCommandPingEngine {
              */
             auto ttl() -> uint16_t override;
 
+            /**
+             * @brief       Sets the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            auto setPayloadSize(int payloadSize) -> void override;
+
+            /**
+             * @brief       Returns the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Returns how many sample rounds the engine has backed this target off by.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::probeBackoff
+             *
+             * @returns     1 if the target is sent in every round; otherwise the target is sent once every n rounds.
+             */
+            auto probeBackoff() -> int override;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setSamplingDivisor
+             *
+             * @param[in]   divisor the target is sent once every divisor rounds.
+             */
+            auto setSamplingDivisor(int divisor) -> void override;
+
         public:
             /**
              * @brief       Saves the configuration to a JSON object.
@@ -138,17 +172,46 @@ namespace Nedrysoft { namespace PingCommandPingEngine {
              */
             auto loadConfiguration(QJsonObject configuration) -> bool override;
 
+        protected:
+            /**
+             * @brief       Starts the ping process for this target.
+             *
+             * @details     A single ping process is run for the lifetime of the target, it sends a request every
+             *              engine interval and its output is parsed line by line as it arrives.
+             *
+             * @returns     true if the process was started; otherwise false.
+             */
+            auto start() -> bool;
+
+            /**
+             * @brief       Stops the ping process for this target.
+             */
+            auto stop() -> void;
+
+            friend class PingCommandPingEngine;
+
+        private:
+            /**
+             * @brief       Processes any complete lines of output from the ping process.
+             */
+            auto processOutput() -> void;
+
+            /**
+             * @brief       Parses a single line of ping output and emits the corresponding result.
+             *
+             * @param[in]   line the line of output.
+             */
+            auto processLine(const QString &line) -> void;
+
         private:
             //! @cond
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-            QThread *m_workerThread;
-#else
-            std::thread *m_workerThread;
-#endif
+
+            QProcess *m_process;
+            QByteArray m_outputBuffer;
             void *m_userdata;
-            bool m_quitThread;
             PingCommandPingEngine *m_engine;
             int m_ttl;
+            int m_payloadSize;
             QHostAddress m_hostAddress;
 
             //! @endcond
@@ -23,49 +23,33 @@
 
 #include "PublicIPHostMasker.h"
 
+#include "PublicIPService.h"
+
+#include <IConfigurationStore>
 #include <ICore>
+#include <IHostMaskerManager>
 
 #include <QDir>
-#include <QEventLoop>
 #include <QJsonDocument>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QRegularExpression>
 
 constexpr auto ConfigurationPath = "Components";
 constexpr auto ConfigurationFilename = "PublicIPHostMasker.json";
 
 Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::PublicIPHostMasker() :
-        m_networkManager(nullptr) {
+        m_publicIPService(new PublicIPService(this)) {
 
     loadFromFile();
 
-    m_networkManager = new QNetworkAccessManager();
-
-    QNetworkRequest request;
-
-    connect(m_networkManager, &QNetworkAccessManager::finished, [=](QNetworkReply *reply) {
-        auto responseTest(reply->readAll());
-
-        auto matchExpression = QRegularExpression(
-                R"(Current IP Address: (?<ip>([0-9]{1,3})\.([0-9]{1,3})\.([0-9]{1,3})\.([0-9]{1,3})))");
+    connect(m_publicIPService, &PublicIPService::addressesChanged, this, [=]() {
+        auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
 
-        auto expressionMatch = matchExpression.match(responseTest);
-
-        if (expressionMatch.hasMatch()) {
-            m_publicIP = expressionMatch.captured("ip");
+        if (hostMaskerManager) {
+            hostMaskerManager->invalidate();
         }
     });
-
-    request.setUrl(QUrl("http://checkip.dyndns.com"));
-
-    m_networkManager->get(request);
 }
 
 Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::~PublicIPHostMasker() {
-    if (m_networkManager) {
-        delete m_networkManager;
-    }
 }
 
 auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::loadFromFile() -> bool {
@@ -91,25 +75,9 @@ auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::loadFromFile() -> bool {
 auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::saveToFile() -> void {
     auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
 
-    QFile configurationFile;
-
-    configurationFile.setFileName(QDir::cleanPath(QString("%1/%2/%3").arg(storageLocation).arg(ConfigurationPath).arg(QString(ConfigurationFilename))));
-
-    QDir dir(QString("%1/%2").arg(storageLocation).arg(ConfigurationPath));
-
-    if (!dir.exists()) {
-        dir.mkpath(dir.path());
-    }
-
-    if (configurationFile.open(QFile::WriteOnly)) {
-        QJsonObject configuration = saveConfiguration();
-
-        auto jsonDocument = QJsonDocument(configuration);
-
-        if (jsonDocument.isObject()) {
-            configurationFile.write(jsonDocument.toJson());
-        }
-    }
+    Nedrysoft::Core::IConfigurationStore::getInstance()->save(
+        QDir::cleanPath(QString("%1/%2/%3").arg(storageLocation).arg(ConfigurationPath).arg(ConfigurationFilename)),
+        saveConfiguration() );
 }
 
 auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::mask(
@@ -121,26 +89,21 @@ auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::mask(
 
     Q_UNUSED(hop)
     Q_UNUSED(hostName)
-    Q_UNUSED(hostAddress)
-    Q_UNUSED(maskedHostName)
-    Q_UNUSED(maskedHostAddress)
-
-    // retrieve checkip.dyndns.com
 
-    if (m_publicIP.isNull()) {
-        m_publicIP = getPublicIP();
-    }
-
-    if (hostAddress == m_publicIP) {
+    if (m_publicIPService->contains(hostAddress)) {
         maskedHostName = tr("<hidden>");
         maskedHostAddress = tr("<hidden>");
+
+        return true;
     }
 
-    return true;
+    return false;
 }
 
 auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::getPublicIP() -> QString {
-    return m_publicIP;
+    auto address = m_publicIPService->ipv4Address();
+
+    return address.isNull() ? QString() : address.toString();
 }
 
 auto Nedrysoft::PublicIPHostMasker::PublicIPHostMasker::saveConfiguration() -> QJsonObject {
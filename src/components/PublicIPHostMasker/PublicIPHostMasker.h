@@ -29,11 +29,9 @@
 #include <IHostMasker>
 #include <QObject>
 
-class QEventLoop;
-class QNetworkAccessManager;
-
 namespace Nedrysoft { namespace PublicIPHostMasker {
     class PublicIPHostMaskerSettingsPageWidget;
+    class PublicIPService;
 
     /**
      * @brief       The PublicIPHostMasker class provides a host masker that redacts the public ip.
@@ -99,7 +97,7 @@ namespace Nedrysoft { namespace PublicIPHostMasker {
             /**
              * @brief       Gets the public IP.
              *
-             * @returns     The public IP.
+             * @returns     The public IPv4 address, or an empty string if it is not yet known.
              */
             auto getPublicIP() -> QString;
 
@@ -129,8 +127,7 @@ namespace Nedrysoft { namespace PublicIPHostMasker {
         private:
             //! @cond
 
-            QString m_publicIP;
-            QNetworkAccessManager *m_networkManager;
+            PublicIPService *m_publicIPService;
             bool m_enabled;
 
             //! @endcond
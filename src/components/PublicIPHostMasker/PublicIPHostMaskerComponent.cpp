@@ -62,7 +62,7 @@ auto PublicIPHostMaskerComponent::finaliseEvent() -> void {
         auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
 
         if (hostMaskerManager) {
-            hostMaskerManager->add(m_hostMasker);
+            hostMaskerManager->remove(m_hostMasker);
         }
 
         Nedrysoft::ComponentSystem::removeObject(m_hostMasker);
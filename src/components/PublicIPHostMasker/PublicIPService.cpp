@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PublicIPService.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkInterface>
+#include <QNetworkReply>
+#include <QRegularExpression>
+#include <QSettings>
+
+constexpr auto RefreshInterval = 30*60*1000;
+constexpr auto InterfaceCheckInterval = 10*1000;
+
+constexpr auto DnsQueryName = "myip.opendns.com";
+constexpr auto DnsServerV4 = "208.67.222.222";
+constexpr auto DnsServerV6 = "2620:119:35::35";
+constexpr auto HttpServiceV4 = "http://checkip.dyndns.com";
+constexpr auto HttpServiceV6 = "http://api6.ipify.org";
+
+constexpr auto IPv4SettingsKey = "PublicIPHostMasker/IPv4Address";
+constexpr auto IPv6SettingsKey = "PublicIPHostMasker/IPv6Address";
+
+Nedrysoft::PublicIPHostMasker::PublicIPService::PublicIPService(QObject *parent) :
+        QObject(parent),
+        m_networkAccessManager(new QNetworkAccessManager(this)) {
+
+    QSettings settings;
+
+    /**
+     * the last known addresses are used until discovery completes, so hosts are masked from the first route even
+     * if the lookups are slow or the network is unavailable.
+     */
+
+    m_ipv4Address = QHostAddress(settings.value(IPv4SettingsKey).toString());
+    m_ipv6Address = QHostAddress(settings.value(IPv6SettingsKey).toString());
+
+    for (const auto &address : {m_ipv4Address, m_ipv6Address}) {
+        if (!address.isNull()) {
+            m_addresses.insert(address.toString());
+        }
+    }
+
+    m_interfaceAddresses = interfaceAddresses();
+
+    m_refreshTimer.setInterval(RefreshInterval);
+    m_interfaceTimer.setInterval(InterfaceCheckInterval);
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &PublicIPService::refresh);
+
+    connect(&m_interfaceTimer, &QTimer::timeout, this, [=]() {
+        auto addresses = interfaceAddresses();
+
+        if (addresses!=m_interfaceAddresses) {
+            m_interfaceAddresses = addresses;
+
+            refresh();
+        }
+    });
+
+    m_interfaceTimer.start();
+
+    QTimer::singleShot(0, this, &PublicIPService::refresh);
+}
+
+Nedrysoft::PublicIPHostMasker::PublicIPService::~PublicIPService() {
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::ipv4Address() -> QHostAddress {
+    return m_ipv4Address;
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::ipv6Address() -> QHostAddress {
+    return m_ipv6Address;
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::contains(const QString &hostAddress) -> bool {
+    return m_addresses.contains(hostAddress);
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::refresh() -> void {
+    m_refreshTimer.start();
+
+    lookup(QAbstractSocket::IPv4Protocol);
+    lookup(QAbstractSocket::IPv6Protocol);
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::lookup(QAbstractSocket::NetworkLayerProtocol protocol) -> void {
+    auto isIPv4 = (protocol==QAbstractSocket::IPv4Protocol);
+
+    /**
+     * the OpenDNS resolvers answer myip.opendns.com with the address of the client, this is a single UDP round
+     * trip, the query has to be sent over the same protocol as the address being asked for.
+     */
+
+    auto dnsLookup = new QDnsLookup(
+            isIPv4 ? QDnsLookup::A : QDnsLookup::AAAA,
+            DnsQueryName,
+            QHostAddress(isIPv4 ? DnsServerV4 : DnsServerV6),
+            this );
+
+    connect(dnsLookup, &QDnsLookup::finished, this, [=]() {
+        auto records = dnsLookup->hostAddressRecords();
+
+        dnsLookup->deleteLater();
+
+        if ((dnsLookup->error()!=QDnsLookup::NoError) || (records.isEmpty())) {
+            lookupHttp(protocol);
+
+            return;
+        }
+
+        setAddress(records.first().value());
+    });
+
+    dnsLookup->lookup();
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::lookupHttp(
+        QAbstractSocket::NetworkLayerProtocol protocol ) -> void {
+
+    auto isIPv4 = (protocol==QAbstractSocket::IPv4Protocol);
+    auto reply = m_networkAccessManager->get(QNetworkRequest(QUrl(isIPv4 ? HttpServiceV4 : HttpServiceV6)));
+
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        static const auto addressExpression = QRegularExpression(
+                R"(Current IP Address: (?<ip>[0-9]{1,3}\.[0-9]{1,3}\.[0-9]{1,3}\.[0-9]{1,3}))" );
+
+        reply->deleteLater();
+
+        if (reply->error()!=QNetworkReply::NoError) {
+            return;
+        }
+
+        auto response = QString::fromUtf8(reply->readAll());
+        auto address = QHostAddress();
+
+        /**
+         * the IPv4 service returns a small HTML page, the IPv6 service returns the bare address.
+         */
+
+        if (isIPv4) {
+            auto expressionMatch = addressExpression.match(response);
+
+            if (expressionMatch.hasMatch()) {
+                address = QHostAddress(expressionMatch.captured("ip"));
+            }
+        } else {
+            address = QHostAddress(response.trimmed());
+        }
+
+        if (address.protocol()==protocol) {
+            setAddress(address);
+        }
+    });
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::setAddress(const QHostAddress &address) -> void {
+    auto &currentAddress = (address.protocol()==QAbstractSocket::IPv4Protocol) ? m_ipv4Address : m_ipv6Address;
+
+    if (currentAddress==address) {
+        return;
+    }
+
+    QSettings settings;
+
+    m_addresses.remove(currentAddress.toString());
+
+    currentAddress = address;
+
+    m_addresses.insert(address.toString());
+
+    settings.setValue(
+            (address.protocol()==QAbstractSocket::IPv4Protocol) ? IPv4SettingsKey : IPv6SettingsKey,
+            address.toString() );
+
+    Q_EMIT addressesChanged();
+}
+
+auto Nedrysoft::PublicIPHostMasker::PublicIPService::interfaceAddresses() -> QStringList {
+    auto addresses = QStringList();
+
+    for (const auto &address : QNetworkInterface::allAddresses()) {
+        addresses.append(address.toString());
+    }
+
+    addresses.sort();
+
+    return addresses;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_PUBLICIPHOSTMASKER_PUBLICIPSERVICE_H
+#define PINGNOO_COMPONENTS_PUBLICIPHOSTMASKER_PUBLICIPSERVICE_H
+
+#include <QDnsLookup>
+#include <QHostAddress>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class QNetworkAccessManager;
+
+namespace Nedrysoft { namespace PublicIPHostMasker {
+    /**
+     * @brief       The PublicIPService class discovers and caches the public IPv4 and IPv6 addresses of the machine.
+     *
+     * @details     The addresses are found by asking the OpenDNS resolvers for myip.opendns.com, which answers
+     *              with the address the query came from, the HTTP services are only used if the DNS query fails.
+     *
+     *              The last known addresses are stored in the settings so that they are available as soon as the
+     *              application starts, they are refreshed periodically and whenever the addresses of the local
+     *              network interfaces change.
+     */
+    class PublicIPService :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new PublicIPService.
+             *
+             * @param[in]   parent the owner of the service.
+             */
+            PublicIPService(QObject *parent = nullptr);
+
+            /**
+             * @brief       Destroys the PublicIPService.
+             */
+            ~PublicIPService();
+
+            /**
+             * @brief       Returns the public IPv4 address.
+             *
+             * @returns     the address if known; otherwise a null address.
+             */
+            auto ipv4Address() -> QHostAddress;
+
+            /**
+             * @brief       Returns the public IPv6 address.
+             *
+             * @returns     the address if known; otherwise a null address.
+             */
+            auto ipv6Address() -> QHostAddress;
+
+            /**
+             * @brief       Returns whether the given address is one of the public addresses.
+             *
+             * @param[in]   hostAddress the address as a string.
+             *
+             * @returns     true if the address is public; otherwise false.
+             */
+            auto contains(const QString &hostAddress) -> bool;
+
+            /**
+             * @brief       Starts discovery of the public addresses.
+             */
+            auto refresh() -> void;
+
+            /**
+             * @brief       This signal is emitted when either of the public addresses changes.
+             */
+            Q_SIGNAL void addressesChanged();
+
+        private:
+            /**
+             * @brief       Looks up the address via DNS, falling back to HTTP if the lookup fails.
+             *
+             * @param[in]   protocol the protocol of the address to look up.
+             */
+            auto lookup(QAbstractSocket::NetworkLayerProtocol protocol) -> void;
+
+            /**
+             * @brief       Looks up the address via HTTP.
+             *
+             * @param[in]   protocol the protocol of the address to look up.
+             */
+            auto lookupHttp(QAbstractSocket::NetworkLayerProtocol protocol) -> void;
+
+            /**
+             * @brief       Sets a discovered address.
+             *
+             * @param[in]   address the public address, the protocol of the address selects which is updated.
+             */
+            auto setAddress(const QHostAddress &address) -> void;
+
+            /**
+             * @brief       Returns a summary of the addresses of the local interfaces.
+             *
+             * @returns     the sorted list of interface addresses.
+             */
+            auto interfaceAddresses() -> QStringList;
+
+        private:
+            //! @cond
+
+            QNetworkAccessManager *m_networkAccessManager;
+            QTimer m_refreshTimer;
+            QTimer m_interfaceTimer;
+            QHostAddress m_ipv4Address;
+            QHostAddress m_ipv6Address;
+            QSet<QString> m_addresses;
+            QStringList m_interfaceAddresses;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_PUBLICIPHOSTMASKER_PUBLICIPSERVICE_H
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LiteralMatcher.h"
+
+#include <QQueue>
+
+/**
+ * scans a character class starting at the opening bracket, returns the position after the closing bracket or a
+ * position past the end of the pattern if the class is not terminated.
+ */
+static auto skipClass(const QString &pattern, int position) -> int {
+    auto length = pattern.length();
+
+    position++;
+
+    if ((position<length) && (pattern.at(position)=='^')) {
+        position++;
+    }
+
+    if ((position<length) && (pattern.at(position)==']')) {
+        position++;
+    }
+
+    while ((position<length) && (pattern.at(position)!=']')) {
+        if (pattern.at(position)=='\\') {
+            position++;
+        } else if (pattern.mid(position, 2)=="[:") {
+            auto end = pattern.indexOf(":]", position+2);
+
+            if (end>=0) {
+                position = end+1;
+            }
+        }
+
+        position++;
+    }
+
+    return position+1;
+}
+
+/**
+ * scans a group starting at the opening parenthesis, returns the position after the closing parenthesis or a
+ * position past the end of the pattern if the group is not terminated.
+ */
+static auto skipGroup(const QString &pattern, int position) -> int {
+    auto length = pattern.length();
+    auto depth = 0;
+
+    while (position<length) {
+        auto character = pattern.at(position);
+
+        if (character=='\\') {
+            position += 2;
+
+            continue;
+        }
+
+        if (character=='[') {
+            position = skipClass(pattern, position);
+
+            continue;
+        }
+
+        if (character=='(') {
+            depth++;
+        } else if (character==')') {
+            depth--;
+
+            if (!depth) {
+                return position+1;
+            }
+        }
+
+        position++;
+    }
+
+    return length+1;
+}
+
+/**
+ * checks for a quantifier at the given position, returns the number of characters it occupies (zero if there is
+ * no quantifier) and sets allowsZero if the quantified atom may be absent from a match.
+ */
+static auto parseQuantifier(const QString &pattern, int position, int end, bool &allowsZero) -> int {
+    auto start = position;
+
+    allowsZero = false;
+
+    if (position>=end) {
+        return 0;
+    }
+
+    auto character = pattern.at(position);
+
+    if ((character=='*') || (character=='?')) {
+        allowsZero = true;
+        position++;
+    } else if (character=='+') {
+        position++;
+    } else if (character=='{') {
+        auto minimum = QString();
+
+        position++;
+
+        while ((position<end) && (pattern.at(position).isDigit())) {
+            minimum.append(pattern.at(position++));
+        }
+
+        if ((position<end) && (pattern.at(position)==',')) {
+            position++;
+
+            while ((position<end) && (pattern.at(position).isDigit())) {
+                position++;
+            }
+        }
+
+        if ((position>=end) || (pattern.at(position)!='}') || (position==start+1)) {
+            return 0;
+        }
+
+        position++;
+
+        allowsZero = (minimum.isEmpty() || (minimum.toInt()==0));
+    } else {
+        return 0;
+    }
+
+    if ((position<end) && ((pattern.at(position)=='?') || (pattern.at(position)=='+'))) {
+        position++;
+    }
+
+    return position-start;
+}
+
+/**
+ * returns the longest run of literal characters that every match of pattern[begin, end) must contain, valid is
+ * cleared if the pattern uses a construct that is not understood, in which case nothing can be assumed.
+ */
+static auto longestLiteral(const QString &pattern, int begin, int end, bool &valid) -> QString {
+    auto best = QString();
+    auto current = QString();
+    auto position = begin;
+    auto allowsZero = false;
+
+    auto finishRun = [&best, &current]() {
+        if (current.length()>best.length()) {
+            best = current;
+        }
+
+        current.clear();
+    };
+
+    while (position<end) {
+        auto character = pattern.at(position);
+
+        if (character=='|') {
+            /**
+             * an alternation at this level means no single literal is required.
+             */
+
+            return QString();
+        }
+
+        if (character=='\\') {
+            if (position+1>=end) {
+                valid = false;
+
+                return QString();
+            }
+
+            auto escaped = pattern.at(position+1);
+
+            if (escaped.isLetterOrNumber()) {
+                if (QString("xpPkgNocQE").contains(escaped)) {
+                    valid = false;
+
+                    return QString();
+                }
+
+                finishRun();
+
+                position += 2;
+
+                while ((escaped.isDigit()) && (position<end) && (pattern.at(position).isDigit())) {
+                    position++;
+                }
+
+                position += parseQuantifier(pattern, position, end, allowsZero);
+
+                continue;
+            }
+
+            character = escaped;
+
+            position++;
+        } else if (character=='[') {
+            finishRun();
+
+            position = skipClass(pattern, position);
+
+            if (position>end) {
+                valid = false;
+
+                return QString();
+            }
+
+            position += parseQuantifier(pattern, position, end, allowsZero);
+
+            continue;
+        } else if (character=='(') {
+            auto close = skipGroup(pattern, position);
+
+            if (close>end) {
+                valid = false;
+
+                return QString();
+            }
+
+            auto innerBegin = position+1;
+            auto innerEnd = close-1;
+            auto required = true;
+
+            if ((innerBegin<innerEnd) && (pattern.at(innerBegin)=='?')) {
+                auto type = pattern.mid(innerBegin+1, 2);
+
+                if ((type.startsWith(':')) || (type.startsWith('>'))) {
+                    innerBegin += 2;
+                } else if ((type.startsWith('=')) || (type.startsWith('!')) || (type.startsWith('|')) ||
+                           (type=="<=") || (type=="<!")) {
+                    required = false;
+                } else if ((type.startsWith('<')) || (type.startsWith('\'')) || (type=="P<")) {
+                    auto terminator = type.startsWith('\'') ? QChar('\'') : QChar('>');
+                    auto nameEnd = pattern.indexOf(terminator, innerBegin+2);
+
+                    if ((nameEnd<0) || (nameEnd>=innerEnd)) {
+                        valid = false;
+
+                        return QString();
+                    }
+
+                    innerBegin = nameEnd+1;
+                } else {
+                    valid = false;
+
+                    return QString();
+                }
+            }
+
+            finishRun();
+
+            position = close;
+            position += parseQuantifier(pattern, position, end, allowsZero);
+
+            if ((required) && (!allowsZero)) {
+                auto inner = longestLiteral(pattern, innerBegin, innerEnd, valid);
+
+                if (!valid) {
+                    return QString();
+                }
+
+                if (inner.length()>best.length()) {
+                    best = inner;
+                }
+            }
+
+            continue;
+        } else if ((character=='.') || (character=='^') || (character=='$')) {
+            finishRun();
+
+            position++;
+            position += parseQuantifier(pattern, position, end, allowsZero);
+
+            continue;
+        } else if ((character=='*') || (character=='+') || (character=='?') || (character==')')) {
+            valid = false;
+
+            return QString();
+        }
+
+        position++;
+
+        auto quantifierLength = parseQuantifier(pattern, position, end, allowsZero);
+
+        if (!quantifierLength) {
+            current.append(character);
+
+            continue;
+        }
+
+        if (!allowsZero) {
+            current.append(character);
+        }
+
+        finishRun();
+
+        position += quantifierLength;
+    }
+
+    finishRun();
+
+    return best;
+}
+
+Nedrysoft::RegExHostMasker::LiteralMatcher::LiteralMatcher() {
+    clear();
+}
+
+auto Nedrysoft::RegExHostMasker::LiteralMatcher::clear() -> void {
+    m_nodes.clear();
+
+    m_nodes.append(Node{QHash<QChar, int>(), QVector<int>(), 0});
+}
+
+auto Nedrysoft::RegExHostMasker::LiteralMatcher::add(const QString &literal, int identifier) -> void {
+    if (literal.isEmpty()) {
+        return;
+    }
+
+    auto state = 0;
+
+    for (auto character : literal) {
+        auto next = m_nodes.at(state).transitions.value(character, -1);
+
+        if (next<0) {
+            m_nodes.append(Node{QHash<QChar, int>(), QVector<int>(), 0});
+
+            next = m_nodes.count()-1;
+
+            m_nodes[state].transitions.insert(character, next);
+        }
+
+        state = next;
+    }
+
+    m_nodes[state].identifiers.append(identifier);
+}
+
+auto Nedrysoft::RegExHostMasker::LiteralMatcher::build() -> void {
+    auto queue = QQueue<int>();
+
+    for (auto next : m_nodes.at(0).transitions) {
+        m_nodes[next].failure = 0;
+
+        queue.enqueue(next);
+    }
+
+    /**
+     * breadth first, so the failure state of a node is always complete before its children are processed, the
+     * identifiers of the failure state are merged in so that a match reports every literal that ends there.
+     */
+
+    while (!queue.isEmpty()) {
+        auto state = queue.dequeue();
+        auto transitions = m_nodes.at(state).transitions;
+
+        for (auto it = transitions.constBegin(); it!=transitions.constEnd(); it++) {
+            auto failure = m_nodes.at(state).failure;
+
+            while ((failure) && (!m_nodes.at(failure).transitions.contains(it.key()))) {
+                failure = m_nodes.at(failure).failure;
+            }
+
+            failure = m_nodes.at(failure).transitions.value(it.key(), 0);
+
+            m_nodes[it.value()].failure = failure;
+            m_nodes[it.value()].identifiers.append(m_nodes.at(failure).identifiers);
+
+            queue.enqueue(it.value());
+        }
+    }
+}
+
+auto Nedrysoft::RegExHostMasker::LiteralMatcher::match(const QString &text) const -> QVector<int> {
+    auto identifiers = QVector<int>();
+    auto state = 0;
+
+    for (auto character : text) {
+        auto next = m_nodes.at(state).transitions.constFind(character);
+
+        while ((state) && (next==m_nodes.at(state).transitions.constEnd())) {
+            state = m_nodes.at(state).failure;
+
+            next = m_nodes.at(state).transitions.constFind(character);
+        }
+
+        state = (next==m_nodes.at(state).transitions.constEnd()) ? 0 : next.value();
+
+        identifiers.append(m_nodes.at(state).identifiers);
+    }
+
+    return identifiers;
+}
+
+auto Nedrysoft::RegExHostMasker::LiteralMatcher::requiredLiteral(const QString &pattern) -> QString {
+    /**
+     * quoted sequences can contain unbalanced brackets and parentheses, rather than handle them the pattern is
+     * treated as having no required literal.
+     */
+
+    if (pattern.contains("\\Q")) {
+        return QString();
+    }
+
+    auto valid = true;
+    auto literal = longestLiteral(pattern, 0, pattern.length(), valid);
+
+    return valid ? literal : QString();
+}
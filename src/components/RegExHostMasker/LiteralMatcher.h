@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REGEXHOSTMASKER_LITERALMATCHER_H
+#define PINGNOO_COMPONENTS_REGEXHOSTMASKER_LITERALMATCHER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RegExHostMasker {
+    /**
+     * @brief       The LiteralMatcher class finds which of a set of literal strings occur in a piece of text.
+     *
+     * @details     The literals are compiled into an Aho-Corasick automaton, the text is scanned once regardless
+     *              of the number of literals.  The masker uses this as a prefilter, a rule whose required literal
+     *              does not appear in the host cannot match, so its regular expression is never run.
+     */
+    class LiteralMatcher {
+        public:
+            /**
+             * @brief       Constructs an empty LiteralMatcher.
+             */
+            LiteralMatcher();
+
+            /**
+             * @brief       Removes all of the literals.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Adds a literal to the matcher.
+             *
+             * @note        The automaton must be rebuilt with build() after literals have been added.
+             *
+             * @param[in]   literal the literal string.
+             * @param[in]   identifier the identifier reported when the literal is found.
+             */
+            auto add(const QString &literal, int identifier) -> void;
+
+            /**
+             * @brief       Builds the automaton from the literals that have been added.
+             */
+            auto build() -> void;
+
+            /**
+             * @brief       Returns the identifiers of the literals that occur in the text.
+             *
+             * @param[in]   text the text to scan.
+             *
+             * @returns     the identifiers, each identifier appears once per occurrence of its literal.
+             */
+            auto match(const QString &text) const -> QVector<int>;
+
+            /**
+             * @brief       Returns a literal that must appear in any string matched by a regular expression.
+             *
+             * @details     The pattern is examined conservatively, if a literal cannot be proven to be required
+             *              (for example the pattern has a top level alternation or changes its own options) then
+             *              an empty string is returned and the expression must always be evaluated.
+             *
+             * @param[in]   pattern the regular expression.
+             *
+             * @returns     the longest required literal found; otherwise an empty string.
+             */
+            static auto requiredLiteral(const QString &pattern) -> QString;
+
+        private:
+            //! @cond
+
+            struct Node {
+                QHash<QChar, int> transitions;
+                QVector<int> identifiers;
+                int failure;
+            };
+
+            QVector<Node> m_nodes;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REGEXHOSTMASKER_LITERALMATCHER_H
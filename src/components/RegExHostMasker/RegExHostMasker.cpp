@@ -23,17 +23,32 @@
 
 #include "RegExHostMasker.h"
 
+#include <IConfigurationStore>
 #include <ICore>
+#include <IHostMaskerManager>
 
 #include <QDir>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QRegularExpression>
+#include <algorithm>
 
 constexpr auto ConfigurationPath = "Components";
 constexpr auto ConfigurationFilename = "RegExHostMasker.json";
+constexpr auto MinimumLiteralLength = 3;
+constexpr auto TokenExpression = R"(\$\{\s*(?<named>[^\s}]*)\s*\}|(?<dollar>\$\$)|\$(?<number>\d+))";
+
+static auto invalidateMasks() -> void {
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+
+    if (hostMaskerManager) {
+        hostMaskerManager->invalidate();
+    }
+}
+
+Nedrysoft::RegExHostMasker::RegExHostMasker::RegExHostMasker() :
+        m_matcherBuilt(false) {
 
-Nedrysoft::RegExHostMasker::RegExHostMasker::RegExHostMasker() {
     loadFromFile();
 }
 
@@ -57,6 +72,10 @@ auto Nedrysoft::RegExHostMasker::RegExHostMasker::loadFromFile(QString filename,
         if (jsonDocument.isObject()) {
             if (!append) {
                 m_maskList.clear();
+                m_compiledMaskList.clear();
+                m_matcherBuilt = false;
+
+                invalidateMasks();
             }
 
             loadConfiguration(jsonDocument.object());
@@ -69,35 +88,141 @@ auto Nedrysoft::RegExHostMasker::RegExHostMasker::loadFromFile(QString filename,
 }
 
 auto Nedrysoft::RegExHostMasker::RegExHostMasker::saveToFile(QString filename) -> void {
-    QString storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+    auto configurationStore = Nedrysoft::Core::IConfigurationStore::getInstance();
+    auto isExport = !filename.isNull();
+
+    if (!isExport) {
+        filename = QDir::cleanPath(QString("%1/%2/%3")
+                .arg(Nedrysoft::Core::ICore::getInstance()->storageFolder())
+                .arg(ConfigurationPath)
+                .arg(QString(ConfigurationFilename)));
+    }
 
-    QFile configurationFile;
+    configurationStore->save(filename, saveConfiguration());
 
-    if (filename.isNull()) {
-        configurationFile.setFileName(QDir::cleanPath(
-                QString("%1/%2/%3")
-                        .arg(storageFolder)
-                        .arg(ConfigurationPath)
-                        .arg(QString(ConfigurationFilename))) );
-    } else {
-        configurationFile.setFileName(filename);
+    if (isExport) {
+        configurationStore->flush();
     }
+}
+
+auto Nedrysoft::RegExHostMasker::RegExHostMasker::tokenise(
+        const QString &replacementString ) -> QList<Nedrysoft::RegExHostMasker::TokenReplacement> {
+
+    static const auto tokenExpression = QRegularExpression(TokenExpression);
 
-    QDir dir(storageFolder);
+    auto tokenList = QList<TokenReplacement>();
+    auto tokenIterator = tokenExpression.globalMatch(replacementString);
+    auto position = 0;
+
+    auto appendLiteral = [&tokenList](const QString &text) {
+        if (text.isEmpty()) {
+            return;
+        }
 
-    if (!dir.exists(ConfigurationPath)) {
-         dir.mkpath(ConfigurationPath);
+        if ((!tokenList.isEmpty()) && (tokenList.last().type==TokenReplacement::Type::Literal)) {
+            tokenList.last().value.append(text);
+        } else {
+            tokenList.append(TokenReplacement{TokenReplacement::Type::Literal, text, 0});
+        }
+    };
+
+    while (tokenIterator.hasNext()) {
+        auto match = tokenIterator.next();
+
+        appendLiteral(replacementString.mid(position, match.capturedStart()-position));
+
+        position = match.capturedEnd();
+
+        if (!match.captured("dollar").isNull()) {
+            appendLiteral("$");
+        } else if (!match.captured("number").isNull()) {
+            auto number = match.captured("number").toInt();
+
+            tokenList.append(TokenReplacement{TokenReplacement::Type::Number, QString(), number});
+        } else {
+            tokenList.append(TokenReplacement{TokenReplacement::Type::Named, match.captured("named"), 0});
+        }
     }
 
-    if (configurationFile.open(QFile::WriteOnly)) {
-        QJsonObject configuration = saveConfiguration();
+    appendLiteral(replacementString.mid(position));
 
-        auto jsonDocument = QJsonDocument(configuration);
+    return tokenList;
+}
 
-        if (jsonDocument.isObject()) {
-            configurationFile.write(jsonDocument.toJson());
+auto Nedrysoft::RegExHostMasker::RegExHostMasker::compile(
+        const Nedrysoft::RegExHostMasker::RegExHostMaskerItem &item ) ->
+                Nedrysoft::RegExHostMasker::RegExHostMaskerCompiledItem {
+
+    auto compiledItem = RegExHostMaskerCompiledItem();
+
+    compiledItem.m_expression = QRegularExpression(item.m_matchExpression);
+    compiledItem.m_expression.optimize();
+    compiledItem.m_hostReplacement = tokenise(item.m_hostReplacementString);
+    compiledItem.m_addressReplacement = tokenise(item.m_addressReplacementString);
+    compiledItem.m_literal = LiteralMatcher::requiredLiteral(item.m_matchExpression);
+    compiledItem.m_enabled = item.m_enabled;
+    compiledItem.m_matchFlags = item.m_matchFlags;
+
+    return compiledItem;
+}
+
+auto Nedrysoft::RegExHostMasker::RegExHostMasker::setMaskList(
+        const QList<Nedrysoft::RegExHostMasker::RegExHostMaskerItem> &maskList ) -> void {
+
+    m_maskList = maskList;
+    m_compiledMaskList.clear();
+    m_matcherBuilt = false;
+
+    for (const auto &item : m_maskList) {
+        m_compiledMaskList.append(compile(item));
+    }
+
+    invalidateMasks();
+}
+
+auto Nedrysoft::RegExHostMasker::RegExHostMasker::buildMatcher() -> void {
+    m_literalMatcher.clear();
+    m_unfilteredMasks.clear();
+
+    for (auto index=0; index<m_compiledMaskList.count(); index++) {
+        const auto &maskItem = m_compiledMaskList.at(index);
+
+        if ((!maskItem.m_enabled) ||
+            ((maskItem.m_hostReplacement.isEmpty()) && (maskItem.m_addressReplacement.isEmpty()))) {
+            continue;
+        }
+
+        if (maskItem.m_literal.length()>=MinimumLiteralLength) {
+            m_literalMatcher.add(maskItem.m_literal, index);
+        } else {
+            m_unfilteredMasks.append(index);
         }
     }
+
+    m_literalMatcher.build();
+
+    m_matcherBuilt = true;
+}
+
+auto Nedrysoft::RegExHostMasker::RegExHostMasker::candidates(const QString &text) -> QVector<int> {
+    if (!m_matcherBuilt) {
+        buildMatcher();
+    }
+
+    /**
+     * a mask whose required literal is not in the text cannot match, so only the masks found by the literal scan
+     * and those without a usable literal are evaluated, sorted so that they are still applied in list order.
+     */
+
+    auto candidateList = m_literalMatcher.match(text);
+
+    candidateList.append(m_unfilteredMasks);
+
+    std::sort(candidateList.begin(), candidateList.end());
+
+    candidateList.erase(std::unique(candidateList.begin(), candidateList.end()), candidateList.end());
+
+    return candidateList;
 }
 
 auto Nedrysoft::RegExHostMasker::RegExHostMasker::applyMask(
@@ -109,112 +234,66 @@ auto Nedrysoft::RegExHostMasker::RegExHostMasker::applyMask(
 
     Q_UNUSED(hop)
 
-    auto expressionMatch = QRegularExpressionMatch();
-    auto tokenExpression = QRegularExpression(R"(\$\{\s*(?<named>.*)\s*\}|(?<dollar>\$\$)|\$(?<number>\d+))");
-    auto tokenTypes = QStringList() << "named" << "dollar" << "number";
-    auto searchList = QList<unsigned int>() << static_cast<int>(MatchFlags::MatchHost) << static_cast<int>(MatchFlags::MatchAddress);
-    QString *outputString = nullptr;
+    auto searchList = QList<unsigned int>() <<
+            static_cast<unsigned int>(MatchFlags::MatchHost) <<
+            static_cast<unsigned int>(MatchFlags::MatchAddress);
+
     bool returnValue = false;
 
     maskedHostName = hostName;
     maskedHostAddress = hostAddress;
 
-    auto maskFlags = QList<MatchFlags>() << MatchFlags::MaskHost << MatchFlags::MaskAddress;
+    auto buildOutput = [](const QList<TokenReplacement> &tokenList, const QRegularExpressionMatch &expressionMatch) {
+        auto outputString = QString();
 
-    for (auto matchFlag : searchList) {
-        for (const auto &maskItem : m_maskList) {
-            if (!maskItem.m_enabled) {
-                continue;
-            }
-
-            if (!( maskItem.m_matchFlags & matchFlag )) {
-                continue;
-            }
-
-            auto matchExpression = QRegularExpression(maskItem.m_matchExpression);
-
-            if (!(static_cast<int>(maskItem.m_matchFlags) & static_cast<int>(matchFlag))) {
-                continue;
-            }
-
-            if (matchFlag==static_cast<int>(MatchFlags::MatchHost)) {
-                expressionMatch = matchExpression.match(hostName);
-            } else {
-                expressionMatch = matchExpression.match(hostAddress);
-            }
-
-            QString replacementString;
-
-            for (auto maskFlag : maskFlags) {
-                if (maskFlag == MatchFlags::MaskHost) {
-                    outputString = &maskedHostName;
-                    replacementString = maskItem.m_hostReplacementString;
-                } else if (maskFlag==MatchFlags::MaskAddress) {
-                    outputString = &maskedHostAddress;
-                    replacementString = maskItem.m_addressReplacementString;
-                } else {
-                    continue;
+        for (const auto &token : tokenList) {
+            switch (token.type) {
+                case TokenReplacement::Type::Literal: {
+                    outputString.append(token.value);
+                    break;
                 }
 
-                if (replacementString.isEmpty()) {
-                    continue;
+                case TokenReplacement::Type::Named: {
+                    outputString.append(expressionMatch.captured(token.value));
+                    break;
                 }
 
-                if (expressionMatch.hasMatch()) {
-                    auto tokenIterator = tokenExpression.globalMatch(replacementString);
-                    QList<TokenReplacement> tokenReplacementList;
-
-                    if (!tokenIterator.hasNext()) {
-                        *outputString = replacementString;
-
-                        returnValue = true;
-
-                        continue;
-                    }
+                case TokenReplacement::Type::Number: {
+                    outputString.append(expressionMatch.captured(token.number));
+                    break;
+                }
+            }
+        }
 
-                    while (tokenIterator.hasNext()) {
-                        auto match = tokenIterator.next();
+        return outputString;
+    };
 
-                        if (match.hasMatch()) {
-                            for (auto tokenType : tokenTypes) {
-                                auto identifier = match.captured(tokenType);
+    for (auto matchFlag : searchList) {
+        const auto &subject = (matchFlag==static_cast<unsigned int>(MatchFlags::MatchHost)) ? hostName : hostAddress;
 
-                                if (!identifier.isNull()) {
-                                    TokenReplacement tokenReplacement;
+        for (auto index : candidates(subject)) {
+            const auto &maskItem = m_compiledMaskList.at(index);
 
-                                    tokenReplacement.type = tokenType;
-                                    tokenReplacement.identifier = identifier;
+            if (!(maskItem.m_matchFlags & matchFlag)) {
+                continue;
+            }
 
-                                    if (tokenType=="named") {
-                                        tokenReplacement.value = expressionMatch.captured(identifier);
-                                        tokenReplacement.format = "${%1}";
-                                    } else if (tokenType=="number") {
-                                        tokenReplacement.value  = expressionMatch.captured(identifier.toInt());
-                                        tokenReplacement.format = "$%1";
-                                    } else if (tokenType=="dollar") {
-                                        // we catch $$ regardless, so just ignore it here.
-                                        continue;
-                                    } else {
-                                        // ruh roh!
-                                        continue;
-                                    }
+            auto expressionMatch = maskItem.m_expression.match(subject);
 
-                                    tokenReplacementList.append(tokenReplacement);
-                                }
-                            }
-                        }
-                    }
+            if (!expressionMatch.hasMatch()) {
+                continue;
+            }
 
-                    *outputString = replacementString;
+            if (!maskItem.m_hostReplacement.isEmpty()) {
+                maskedHostName = buildOutput(maskItem.m_hostReplacement, expressionMatch);
 
-                    for (const auto &token : tokenReplacementList) {
-                        (*outputString).replace(token.format.arg(token.identifier), token.value);
-                    }
+                returnValue = true;
+            }
 
-                    (*outputString).replace("$$", "$");
+            if (!maskItem.m_addressReplacement.isEmpty()) {
+                maskedHostAddress = buildOutput(maskItem.m_addressReplacement, expressionMatch);
 
-                    returnValue = true;
-                }
+                returnValue = true;
             }
         }
     }
@@ -251,6 +330,10 @@ auto Nedrysoft::RegExHostMasker::RegExHostMasker::add(
     item.m_enabled = enabled;
 
     m_maskList.append(item);
+    m_compiledMaskList.append(compile(item));
+    m_matcherBuilt = false;
+
+    invalidateMasks();
 }
 
 auto Nedrysoft::RegExHostMasker::RegExHostMasker::saveConfiguration() -> QJsonObject {
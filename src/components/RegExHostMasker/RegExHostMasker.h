@@ -24,10 +24,12 @@
 #ifndef PINGNOO_COMPONENTS_REGEXHOSTMASKER_REGEXHOSTMASKER_H
 #define PINGNOO_COMPONENTS_REGEXHOSTMASKER_REGEXHOSTMASKER_H
 
+#include "LiteralMatcher.h"
 #include "RegExHostMaskerSpec.h"
 
 #include <IHostMasker>
 #include <IInterface>
+#include <QRegularExpression>
 #include <QSet>
 
 namespace Nedrysoft { namespace RegExHostMasker {
@@ -56,15 +58,41 @@ namespace Nedrysoft { namespace RegExHostMasker {
     /**
      * @brief       The TokenReplacement class is used internally by the masker to provide substitution of
      *              capture groups.
+     *
+     * @details     A replacement string is split into a list of tokens when the mask is compiled, each token is
+     *              either literal text or a reference to a named or numbered capture group.
      */
     class TokenReplacement {
         public:
             //! @cond
 
-            QString type;
-            QString identifier;
+            enum class Type {
+                Literal,
+                Named,
+                Number
+            };
+
+            Type type;
             QString value;
-            QString format;
+            int number;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The RegExHostMaskerCompiledItem class holds the compiled form of a RegExHostMaskerItem.
+     */
+    class RegExHostMaskerCompiledItem {
+        public:
+            //! @cond
+
+            QRegularExpression m_expression;
+            QList<TokenReplacement> m_hostReplacement;
+            QList<TokenReplacement> m_addressReplacement;
+            QString m_literal;
+            bool m_enabled;
+
+            unsigned int m_matchFlags;
 
             //! @endcond
     };
@@ -209,12 +237,61 @@ namespace Nedrysoft { namespace RegExHostMasker {
                     QString &maskedHostName,
                     QString &maskedHostAddress ) -> bool;
 
+            /**
+             * @brief       Replaces the list of masks.
+             *
+             * @param[in]   maskList the new list of masks.
+             */
+            auto setMaskList(const QList<RegExHostMaskerItem> &maskList) -> void;
+
+            /**
+             * @brief       Compiles a mask item.
+             *
+             * @details     The match expression is compiled and optimised and the replacement strings are split into
+             *              tokens, so that masking a host is a single match followed by building the output.
+             *
+             * @param[in]   item the mask to compile.
+             *
+             * @returns     the compiled mask.
+             */
+            auto compile(const RegExHostMaskerItem &item) -> RegExHostMaskerCompiledItem;
+
+            /**
+             * @brief       Splits a replacement string into tokens.
+             *
+             * @param[in]   replacementString the replacement string.
+             *
+             * @returns     the list of tokens.
+             */
+            auto tokenise(const QString &replacementString) -> QList<TokenReplacement>;
+
+            /**
+             * @brief       Builds the literal prefilter from the compiled masks.
+             */
+            auto buildMatcher() -> void;
+
+            /**
+             * @brief       Returns the masks that may match the given text.
+             *
+             * @details     Masks with a required literal are only returned if the literal occurs in the text, masks
+             *              without one are always returned.
+             *
+             * @param[in]   text the host name or address being masked.
+             *
+             * @returns     the indexes of the candidate masks in list order.
+             */
+            auto candidates(const QString &text) -> QVector<int>;
+
             friend class RegExHostMaskerSettingsPageWidget;
 
         private:
             //! @cond
 
             QList<RegExHostMaskerItem> m_maskList;
+            QList<RegExHostMaskerCompiledItem> m_compiledMaskList;
+            LiteralMatcher m_literalMatcher;
+            QVector<int> m_unfilteredMasks;
+            bool m_matcherBuilt;
 
             //! @endcond
 
@@ -414,7 +414,7 @@ auto Nedrysoft::RegExHostMasker::RegExHostMaskerSettingsPageWidget::acceptSettin
         itemList.append(currentItem->data(0, Qt::UserRole).value<Nedrysoft::RegExHostMasker::RegExHostMaskerItem>());
     }
 
-    hostMasker->m_maskList = itemList;
+    hostMasker->setMaskList(itemList);
 
     hostMasker->saveToFile();
 }
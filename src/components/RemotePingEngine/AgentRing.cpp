@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AgentRing.h"
+
+constexpr auto PointsPerWeight = 64;
+constexpr auto FnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr auto FnvPrime = 0x100000001b3ull;
+constexpr auto FirstMixMultiplier = 0xff51afd7ed558ccdull;
+constexpr auto SecondMixMultiplier = 0xc4ceb9fe1a85ec53ull;
+
+Nedrysoft::RemotePingEngine::AgentRing::AgentRing() = default;
+
+auto Nedrysoft::RemotePingEngine::AgentRing::addAgent(const QString &agent, int weight) -> void {
+    removeAgent(agent);
+
+    m_weights[agent] = weight;
+
+    auto agentData = agent.toUtf8();
+
+    for (auto point=0;point<weight*PointsPerWeight;point++) {
+        auto position = hash(agentData+"#"+QByteArray::number(point));
+
+        /**
+         * two agents landing on the same point is very unlikely, the point is kept by the agent that sorts first
+         * so that the outcome does not depend on the order the agents joined.
+         */
+
+        if ((m_points.contains(position)) && (m_points[position]<agent)) {
+            continue;
+        }
+
+        m_points[position] = agent;
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::AgentRing::removeAgent(const QString &agent) -> void {
+    if (!m_weights.remove(agent)) {
+        return;
+    }
+
+    for (auto point=m_points.begin();point!=m_points.end();) {
+        if (point.value()==agent) {
+            point = m_points.erase(point);
+        } else {
+            point++;
+        }
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::AgentRing::contains(const QString &agent) const -> bool {
+    return m_weights.contains(agent);
+}
+
+auto Nedrysoft::RemotePingEngine::AgentRing::agents() const -> QStringList {
+    return m_weights.keys();
+}
+
+auto Nedrysoft::RemotePingEngine::AgentRing::agentFor(const QString &key) const -> QString {
+    if (m_points.isEmpty()) {
+        return QString();
+    }
+
+    auto point = m_points.lowerBound(hash(key.toUtf8()));
+
+    // the ring wraps, a key after the last point belongs to the first.
+
+    if (point==m_points.end()) {
+        point = m_points.begin();
+    }
+
+    return point.value();
+}
+
+auto Nedrysoft::RemotePingEngine::AgentRing::hash(const QByteArray &data) -> quint64 {
+    auto value = static_cast<quint64>(FnvOffsetBasis);
+
+    for (auto byte : data) {
+        value ^= static_cast<quint8>(byte);
+        value *= FnvPrime;
+    }
+
+    /**
+     * FNV alone leaves keys that differ only in their last characters (such as consecutive addresses) close
+     * together on the ring, the finalising mix spreads them out.
+     */
+
+    value ^= value >> 33;
+    value *= FirstMixMultiplier;
+    value ^= value >> 33;
+    value *= SecondMixMultiplier;
+    value ^= value >> 33;
+
+    return value;
+}
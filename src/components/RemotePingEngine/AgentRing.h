@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_AGENTRING_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_AGENTRING_H
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    /**
+     * @brief       The AgentRing class assigns targets to ping agents by consistent hashing.
+     *
+     * @details     Each agent is placed on a ring of 64 bit hashes at a number of points proportional to its weight,
+     *              a target belongs to the agent at the first point at or after the hash of its key.  When an agent
+     *              joins or leaves only the targets between its points and the points before them move, the
+     *              assignment of every other target is unchanged, and an agent with twice the weight is given
+     *              roughly twice as many targets.
+     *
+     *              The hash is computed from the bytes of the key and the agent address only, so every client
+     *              that knows the same agents makes the same assignment.
+     */
+    class AgentRing {
+        public:
+            /**
+             * @brief       Constructs an empty AgentRing.
+             */
+            AgentRing();
+
+            /**
+             * @brief       Adds an agent to the ring, or changes the weight of an agent already on it.
+             *
+             * @param[in]   agent the address of the agent.
+             * @param[in]   weight the capacity of the agent relative to the others, an agent with a weight of 0 or
+             *              less is not given any targets.
+             */
+            auto addAgent(const QString &agent, int weight) -> void;
+
+            /**
+             * @brief       Removes an agent from the ring.
+             *
+             * @param[in]   agent the address of the agent.
+             */
+            auto removeAgent(const QString &agent) -> void;
+
+            /**
+             * @brief       Returns whether an agent is on the ring.
+             *
+             * @param[in]   agent the address of the agent.
+             *
+             * @returns     true if the agent is on the ring; otherwise false.
+             */
+            auto contains(const QString &agent) const -> bool;
+
+            /**
+             * @brief       Returns the agents on the ring.
+             *
+             * @returns     the addresses of the agents.
+             */
+            auto agents() const -> QStringList;
+
+            /**
+             * @brief       Returns the agent that a key is assigned to.
+             *
+             * @param[in]   key the key, for example the address of a target.
+             *
+             * @returns     the address of the agent; otherwise an empty string if the ring is empty.
+             */
+            auto agentFor(const QString &key) const -> QString;
+
+        private:
+            /**
+             * @brief       Returns the position of a value on the ring.
+             *
+             * @param[in]   data the value.
+             *
+             * @returns     the hash.
+             */
+            static auto hash(const QByteArray &data) -> quint64;
+
+        private:
+            //! @cond
+
+            QMap<quint64, QString> m_points;
+            QHash<QString, int> m_weights;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_AGENTRING_H
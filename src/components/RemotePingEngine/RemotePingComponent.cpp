@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RemotePingComponent.h"
+
+#include "RemotePingEngineFactory.h"
+
+RemotePingComponent::RemotePingComponent() :
+        m_engineFactory(nullptr) {
+
+}
+
+RemotePingComponent::~RemotePingComponent() {
+
+}
+
+auto RemotePingComponent::finaliseEvent() -> void {
+    for (auto vantageFactory : m_vantageFactories) {
+        Nedrysoft::ComponentSystem::removeObject(vantageFactory);
+
+        delete vantageFactory;
+    }
+
+    m_vantageFactories.clear();
+
+    if (m_engineFactory) {
+        Nedrysoft::ComponentSystem::removeObject(m_engineFactory);
+
+        delete m_engineFactory;
+    }
+}
+
+auto RemotePingComponent::initialiseEvent() -> void {
+    m_engineFactory = new Nedrysoft::RemotePingEngine::RemotePingEngineFactory();
+
+    Nedrysoft::ComponentSystem::addObject(m_engineFactory);
+
+    /**
+     * with a fleet of agents each agent is also offered as a vantage point of its own, so that a target can be
+     * traced from every site at once.
+     */
+
+    auto agents = m_engineFactory->agents();
+
+    if (agents.count()<2) {
+        return;
+    }
+
+    for (auto &agent : agents) {
+        auto vantageFactory = new Nedrysoft::RemotePingEngine::RemotePingEngineFactory(agent);
+
+        Nedrysoft::ComponentSystem::addObject(vantageFactory);
+
+        m_vantageFactories.append(vantageFactory);
+    }
+}
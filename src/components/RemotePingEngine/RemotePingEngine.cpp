@@ -0,0 +1,883 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RemotePingEngine.h"
+
+#include "RemotePingTarget.h"
+#include "SharedRingReceiver.h"
+
+#include <Clock>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QMutexLocker>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+constexpr auto DefaultTransmitInterval = 2500;
+constexpr auto DefaultTimeout = 3000;
+constexpr auto DefaultTTL = 64;
+constexpr auto DefaultPayloadSize = 56;
+constexpr auto MaximumPayloadSize = 65507;
+constexpr auto ReconnectInterval = 5000;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto TcpScheme = "tcp";
+constexpr auto LocalPrefix = "local:";
+constexpr auto SharedRingCapacity = 16384;
+constexpr auto SharedRingReplyTimeout = 2000;
+
+using MessageType = Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType;
+
+/**
+ * @brief       Returns the address of an agent without the secret that a TCP address may carry.
+ *
+ * @param[in]   address the address of the agent.
+ *
+ * @returns     the address to show in the log.
+ */
+static auto displayAddress(const QString &address) -> QString {
+    return QUrl(address).toString(QUrl::RemovePassword);
+}
+
+/**
+ * @brief       Returns whether a receive buffer holds a complete frame of a given type.
+ *
+ * @param[in]   buffer the receive buffer.
+ * @param[in]   frameType the type of message.
+ *
+ * @returns     true if the buffer holds the frame; otherwise false.
+ */
+static auto containsFrame(const QByteArray &buffer, MessageType frameType) -> bool {
+    auto remaining = buffer;
+    auto type = MessageType::Hello;
+    QByteArray payload;
+
+    while (Nedrysoft::RemotePingEngine::RemotePingProtocol::takeFrame(remaining, type, payload)==
+           Nedrysoft::RemotePingEngine::RemotePingProtocol::FrameStatus::Complete) {
+
+        if (type==frameType) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Nedrysoft::RemotePingEngine::RemotePingEngine::RemotePingEngine(
+        Nedrysoft::Core::IPVersion version,
+        const QMap<QString, int> &agents ) :
+            m_nextTargetId(1),
+            m_nextRequestId(1),
+            m_ipVersion(version),
+            m_interval(DefaultTransmitInterval),
+            m_timeout(DefaultTimeout),
+            m_payloadSize(DefaultPayloadSize),
+            m_dontFragment(false),
+            m_flowStable(false),
+            m_resultBatching(false),
+            m_isRunning(false) {
+
+    for (auto address=agents.begin();address!=agents.end();address++) {
+        auto agent = new AgentLink {
+            address.key(),
+            address.value(),
+            nullptr,
+            QByteArray(),
+            false,
+            nullptr,
+            -1,
+            false
+        };
+
+        m_agents[agent->address] = agent;
+
+        connectToAgent(agent);
+    }
+}
+
+Nedrysoft::RemotePingEngine::RemotePingEngine::~RemotePingEngine() {
+    for (auto agent : m_agents) {
+        if (agent->socket) {
+            disconnect(agent->socket, nullptr, this, nullptr);
+        }
+
+        releaseSharedRing(agent);
+    }
+
+    failSingleShots();
+
+    qDeleteAll(m_pingTargets);
+    qDeleteAll(m_agents);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::connectToAgent(AgentLink *agent) -> void {
+    if (agent->socket) {
+        agent->socket->deleteLater();
+    }
+
+    agent->receiveBuffer.clear();
+
+    auto url = QUrl(agent->address);
+
+    if (url.scheme()==TcpScheme) {
+        auto tcpSocket = new QTcpSocket(this);
+
+        connect(tcpSocket, &QTcpSocket::stateChanged, this, [=](QAbstractSocket::SocketState state) {
+            if (state==QAbstractSocket::UnconnectedState) {
+                onDisconnected(agent);
+            }
+        });
+
+        tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        tcpSocket->connectToHost(url.host(), static_cast<quint16>(url.port()));
+
+        agent->socket = tcpSocket;
+    } else {
+        auto localSocket = new QLocalSocket(this);
+        auto serverName = agent->address;
+
+        if (serverName.startsWith(LocalPrefix)) {
+            serverName = serverName.mid(static_cast<int>(strlen(LocalPrefix)));
+        }
+
+        connect(localSocket, &QLocalSocket::stateChanged, this, [=](QLocalSocket::LocalSocketState state) {
+            if (state==QLocalSocket::UnconnectedState) {
+                onDisconnected(agent);
+            }
+        });
+
+        localSocket->connectToServer(serverName);
+
+        agent->socket = localSocket;
+    }
+
+    connect(agent->socket, &QIODevice::readyRead, this, [=]() {
+        onReadyRead(agent);
+    });
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::onConnected(AgentLink *agent) -> void {
+    agent->connected = true;
+
+    /**
+     * the agent knows nothing about this client when the connection is made (the connection may be a
+     * reconnection), so it is sent the settings before the ring gives it any targets.
+     */
+
+    send(agent, MessageType::Subscribe, RemotePingProtocol::encodeSubscription(RemotePingProtocol::Subscription {
+        m_ipVersion,
+        m_interval,
+        m_timeout,
+        m_payloadSize,
+        m_dontFragment,
+        m_flowStable
+    }));
+
+    m_ring.addAgent(agent->address, agent->weight);
+
+    rebalance();
+
+    if (m_isRunning) {
+        send(agent, MessageType::Start);
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::onDisconnected(AgentLink *agent) -> void {
+    if (agent->connected) {
+        SPDLOG_WARN(QString("Lost connection to ping agent %1.").arg(displayAddress(agent->address)).toStdString());
+    }
+
+    agent->connected = false;
+
+    disconnect(agent->socket, nullptr, this, nullptr);
+
+    if (m_ring.contains(agent->address)) {
+        m_ring.removeAgent(agent->address);
+
+        rebalance();
+    }
+
+    failSingleShots(agent->address);
+
+    releaseSharedRing(agent);
+
+    QTimer::singleShot(ReconnectInterval, this, [=]() {
+        connectToAgent(agent);
+    });
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::failSingleShots(const QString &agent) -> void {
+    QMutexLocker locker(&m_singleShotMutex);
+
+    for (auto request=m_singleShots.begin();request!=m_singleShots.end();) {
+        if ((!agent.isEmpty()) && (m_singleShotAgents.value(request.key())!=agent)) {
+            request++;
+
+            continue;
+        }
+
+        request.value()->set_value(Nedrysoft::RouteAnalyser::PingResult());
+
+        m_singleShotAgents.remove(request.key());
+
+        request = m_singleShots.erase(request);
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::onReadyRead(AgentLink *agent) -> void {
+    agent->receiveBuffer.append(agent->socket->readAll());
+
+    RemotePingProtocol::MessageType type;
+    QByteArray payload;
+
+    while (true) {
+        auto status = RemotePingProtocol::takeFrame(agent->receiveBuffer, type, payload);
+
+        if (status==RemotePingProtocol::FrameStatus::Incomplete) {
+            return;
+        }
+
+        if (status==RemotePingProtocol::FrameStatus::Invalid) {
+            SPDLOG_ERROR(QString("Invalid frame received from ping agent %1.")
+                    .arg(displayAddress(agent->address)).toStdString());
+
+            agent->socket->close();
+
+            return;
+        }
+
+        switch (type) {
+            case MessageType::Hello: {
+                quint16 version;
+                QByteArray challenge;
+
+                if ((!RemotePingProtocol::decodeHello(payload, version, challenge)) ||
+                    (version<RemotePingProtocol::MinimumVersion) ||
+                    (version>RemotePingProtocol::Version)) {
+
+                    SPDLOG_ERROR(QString("Ping agent %1 uses an unsupported protocol version.")
+                            .arg(displayAddress(agent->address)).toStdString());
+
+                    agent->socket->close();
+
+                    return;
+                }
+
+                /**
+                 * a TCP agent only accepts messages once the client has answered its challenge, the answer is
+                 * written before the settings that onConnected sends.
+                 */
+
+                auto url = QUrl(agent->address);
+
+                if ((url.scheme()==TcpScheme) && (version>=RemotePingProtocol::AuthenticationVersion)) {
+                    agent->socket->write(RemotePingProtocol::frame(
+                            MessageType::Authenticate,
+                            RemotePingProtocol::encodeAuthentication(
+                                    url.password(QUrl::FullyDecoded).toUtf8(),
+                                    challenge )));
+                }
+
+                onConnected(agent);
+
+                if ((version>=RemotePingProtocol::SharedRingVersion) && (!offerSharedRing(agent))) {
+                    return;
+                }
+
+                break;
+            }
+
+            case MessageType::SharedRingAttached: {
+                auto attached = false;
+                auto descriptor = agent->sharedRingDescriptor;
+
+                agent->sharedRingDescriptor = -1;
+
+                if ((!RemotePingProtocol::decodeSharedRingStatus(payload, attached)) ||
+                    (!attached) ||
+                    (agent->sharedRing)) {
+
+#if defined(Q_OS_LINUX)
+                    if (descriptor!=-1) {
+                        ::close(descriptor);
+                    }
+#endif
+                    break;
+                }
+
+                auto ring = SharedResultRing::open(descriptor);
+
+                if (!ring) {
+                    /**
+                     * the agent is writing its results into a ring that cannot be read, so the connection is made
+                     * again and the results stay on the socket.
+                     */
+
+                    SPDLOG_ERROR(QString("Unable to map the shared ring of ping agent %1.")
+                            .arg(displayAddress(agent->address)).toStdString());
+
+                    agent->sharedRingFailed = true;
+                    agent->socket->close();
+
+                    return;
+                }
+
+                agent->sharedRing = new SharedRingReceiver(ring, this);
+
+                connect(agent->sharedRing, &SharedRingReceiver::resultsAvailable, this, [=]() {
+                    processSharedRing(agent);
+                }, Qt::QueuedConnection);
+
+                break;
+            }
+
+            case MessageType::Results: {
+                processResults(agent, payload);
+                break;
+            }
+
+            case MessageType::SingleShotResult: {
+                processSingleShotResult(payload);
+                break;
+            }
+
+            default: {
+                break;
+            }
+        }
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::send(
+        AgentLink *agent,
+        MessageType type,
+        const QByteArray &payload ) -> void {
+
+    if ((!agent) || (!agent->connected)) {
+        return;
+    }
+
+    agent->socket->write(RemotePingProtocol::frame(type, payload));
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::sendToAll(MessageType type, const QByteArray &payload) -> void {
+    auto frame = RemotePingProtocol::frame(type, payload);
+
+    for (auto agent : m_agents) {
+        if (agent->connected) {
+            agent->socket->write(frame);
+        }
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::sendSubscription() -> void {
+    sendToAll(MessageType::Subscribe, RemotePingProtocol::encodeSubscription(RemotePingProtocol::Subscription {
+        m_ipVersion,
+        m_interval,
+        m_timeout,
+        m_payloadSize,
+        m_dontFragment,
+        m_flowStable
+    }));
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::sendTarget(
+        Nedrysoft::RemotePingEngine::RemotePingTarget *pingTarget ) -> void {
+
+    send(
+        m_agents.value(m_targetAgents.value(pingTarget->id()), nullptr),
+        MessageType::AddTarget,
+        RemotePingProtocol::encodeTarget(RemotePingProtocol::Target {
+            pingTarget->id(),
+            pingTarget->hostAddress(),
+            pingTarget->ttl(),
+            pingTarget->payloadSize()
+        })
+    );
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::rebalance() -> void {
+    auto moved = 0;
+
+    for (auto pingTarget : m_pingTargets) {
+        auto previousAgent = m_targetAgents.value(pingTarget->id());
+        auto agent = m_ring.agentFor(pingTarget->hostAddress().toString());
+
+        if (agent==previousAgent) {
+            continue;
+        }
+
+        /**
+         * an agent that has disconnected has already forgotten the targets of this client, only an agent that is
+         * still connected needs to be told to stop probing a target that has moved away from it.
+         */
+
+        send(
+            m_agents.value(previousAgent, nullptr),
+            MessageType::RemoveTarget,
+            RemotePingProtocol::encodeTargetId(pingTarget->id())
+        );
+
+        m_targetAgents[pingTarget->id()] = agent;
+
+        sendTarget(pingTarget);
+
+        moved++;
+    }
+
+    if (moved) {
+        SPDLOG_INFO(QString("Moved %1 of %2 targets between %3 connected ping agents.")
+                .arg(moved)
+                .arg(m_pingTargets.count())
+                .arg(m_ring.agents().count()).toStdString());
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::agentFor(const QHostAddress &hostAddress) -> AgentLink * {
+    return m_agents.value(m_ring.agentFor(hostAddress.toString()), nullptr);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::processResults(
+        AgentLink *agent,
+        const QByteArray &payload ) -> void {
+
+    auto records = QVector<RemotePingProtocol::ResultRecord>();
+
+    if (!RemotePingProtocol::decodeResults(payload, records)) {
+        return;
+    }
+
+    auto results = QVector<Nedrysoft::RouteAnalyser::PingResult>();
+
+    results.reserve(records.count());
+
+    for (auto &record : records) {
+        auto pingTarget = m_pingTargets.value(record.id, nullptr);
+
+        /**
+         * results for a target that has been removed (or moved to another agent) may already have been in flight.
+         */
+
+        if ((!pingTarget) || (m_targetAgents.value(record.id)!=agent->address)) {
+            continue;
+        }
+
+        results.append(Nedrysoft::RouteAnalyser::PingResult(
+            record.result.sampleNumber(),
+            record.result.code(),
+            record.result.hostAddress(),
+            record.result.requestTimestamp(),
+            record.result.preciseRoundTripTime(),
+            pingTarget,
+            record.result.hops()
+        ));
+    }
+
+    deliverResults(results);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::processSharedRing(AgentLink *agent) -> void {
+    if (!agent->sharedRing) {
+        return;
+    }
+
+    auto results = QVector<Nedrysoft::RouteAnalyser::PingResult>();
+
+    agent->sharedRing->consume([&](const SharedResultRing::Slot &slot) {
+        auto pingTarget = m_pingTargets.value(slot.id, nullptr);
+
+        if ((!pingTarget) || (m_targetAgents.value(slot.id)!=agent->address)) {
+            return;
+        }
+
+        results.append(Nedrysoft::RouteAnalyser::PingResult(
+            slot.sampleNumber,
+            static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(slot.code),
+            SharedResultRing::hostAddress(slot),
+            slot.requestTimestamp,
+            slot.roundTripTime,
+            pingTarget,
+            slot.hops
+        ));
+    });
+
+    deliverResults(results);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::offerSharedRing(AgentLink *agent) -> bool {
+    auto localSocket = qobject_cast<QLocalSocket *>(agent->socket);
+
+    if ((agent->sharedRing) || (agent->sharedRingFailed) || (!localSocket)) {
+        return true;
+    }
+
+#if defined(Q_OS_LINUX)
+    QElapsedTimer timer;
+
+    timer.start();
+
+    send(agent, MessageType::AttachSharedRing, RemotePingProtocol::encodeSharedRing(SharedRingCapacity));
+
+    /**
+     * the descriptor of the ring is attached to the reply and would be discarded if the socket read the reply, so
+     * the request is written out and the reply is read here before control returns to the event loop.  The agent
+     * cannot reply until it has the whole request, so nothing the socket reads while writing is the reply.
+     */
+
+    while ((localSocket->bytesToWrite()) &&
+           (localSocket->waitForBytesWritten(static_cast<int>(SharedRingReplyTimeout-timer.elapsed())))) {
+    }
+
+    agent->receiveBuffer.append(localSocket->readAll());
+
+    while (!containsFrame(agent->receiveBuffer, MessageType::SharedRingAttached)) {
+        auto remaining = SharedRingReplyTimeout-timer.elapsed();
+
+        if ((remaining<=0) ||
+            (SharedResultRing::receiveDescriptor(
+                    localSocket->socketDescriptor(),
+                    static_cast<int>(remaining),
+                    agent->receiveBuffer,
+                    agent->sharedRingDescriptor )<=0)) {
+
+            SPDLOG_ERROR(QString("Ping agent %1 did not reply to the shared ring request.")
+                    .arg(displayAddress(agent->address)).toStdString());
+
+            agent->sharedRingFailed = true;
+            agent->socket->close();
+
+            return false;
+        }
+    }
+#endif
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::releaseSharedRing(AgentLink *agent) -> void {
+    delete agent->sharedRing;
+
+    agent->sharedRing = nullptr;
+
+#if defined(Q_OS_LINUX)
+    if (agent->sharedRingDescriptor!=-1) {
+        ::close(agent->sharedRingDescriptor);
+    }
+#endif
+
+    agent->sharedRingDescriptor = -1;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::deliverResults(
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    if (results.isEmpty()) {
+        return;
+    }
+
+    if (m_resultBatching) {
+        Q_EMIT resultsReady(results);
+    } else {
+        for (auto &pingResult : results) {
+            Q_EMIT result(pingResult);
+        }
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::processSingleShotResult(const QByteArray &payload) -> void {
+    auto records = QVector<RemotePingProtocol::ResultRecord>();
+
+    if (!RemotePingProtocol::decodeResults(payload, records)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_singleShotMutex);
+
+    for (auto &record : records) {
+        auto promise = m_singleShots.take(record.id);
+
+        m_singleShotAgents.remove(record.id);
+
+        if (promise) {
+            promise->set_value(record.result);
+        }
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::requestSingleShot(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout,
+        int flowIdentifier ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+    auto promise = std::make_shared<std::promise<Nedrysoft::RouteAnalyser::PingResult> >();
+    auto future = promise->get_future();
+    auto request = RemotePingProtocol::SingleShotRequest {
+        m_nextRequestId++,
+        hostAddress,
+        ttl,
+        static_cast<int>(timeout*MillisecondsInSecond),
+        flowIdentifier
+    };
+
+    QMutexLocker locker(&m_singleShotMutex);
+
+    m_singleShots[request.id] = promise;
+
+    locker.unlock();
+
+    /**
+     * the request may be made from any thread, the socket belongs to the engine's thread so the request is sent
+     * from there.
+     */
+
+    QMetaObject::invokeMethod(this, [this, request]() {
+        /**
+         * a single shot (such as a probe of route discovery) is sent from the agent that probes the host, so that
+         * the route that is discovered is the route its hops are probed along.
+         */
+
+        auto agent = agentFor(request.hostAddress);
+
+        if ((!agent) || (!agent->connected)) {
+            QMutexLocker locker(&m_singleShotMutex);
+
+            auto promise = m_singleShots.take(request.id);
+
+            if (promise) {
+                promise->set_value(Nedrysoft::RouteAnalyser::PingResult(
+                    0,
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+                    request.hostAddress,
+                    Nedrysoft::Core::Clock::getInstance()->now(),
+                    -1,
+                    nullptr,
+                    -1
+                ));
+            }
+
+            return;
+        }
+
+        QMutexLocker locker(&m_singleShotMutex);
+
+        if (!m_singleShots.contains(request.id)) {
+            return;
+        }
+
+        m_singleShotAgents[request.id] = agent->address;
+
+        locker.unlock();
+
+        send(agent, MessageType::SingleShot, RemotePingProtocol::encodeSingleShot(request));
+    }, Qt::QueuedConnection);
+
+    return future;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::singleShot(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    return requestSingleShot(hostAddress, ttl, timeout, -1).get();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::singleShotAsync(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+    return requestSingleShot(hostAddress, ttl, timeout, -1);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::singleShotFlowAsync(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout,
+        uint16_t flowIdentifier ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+    return requestSingleShot(hostAddress, ttl, timeout, flowIdentifier);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::addTarget(
+        QHostAddress hostAddress ) -> Nedrysoft::RouteAnalyser::IPingTarget * {
+
+    return addTarget(hostAddress, DefaultTTL);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::addTarget(
+        QHostAddress hostAddress,
+        int ttl ) -> Nedrysoft::RouteAnalyser::IPingTarget * {
+
+    auto newTarget = new Nedrysoft::RemotePingEngine::RemotePingTarget(
+        this,
+        m_nextTargetId++,
+        hostAddress,
+        ttl
+    );
+
+    m_pingTargets[newTarget->id()] = newTarget;
+    m_targetAgents[newTarget->id()] = m_ring.agentFor(hostAddress.toString());
+
+    sendTarget(newTarget);
+
+    return newTarget;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::removeTarget(
+        Nedrysoft::RouteAnalyser::IPingTarget *target ) -> bool {
+
+    for (auto pingTarget : m_pingTargets) {
+        if (static_cast<Nedrysoft::RouteAnalyser::IPingTarget *>(pingTarget) == target) {
+            m_pingTargets.remove(pingTarget->id());
+
+            send(
+                m_agents.value(m_targetAgents.take(pingTarget->id()), nullptr),
+                MessageType::RemoveTarget,
+                RemotePingProtocol::encodeTargetId(pingTarget->id())
+            );
+
+            // we may have been called from a slot connected to one of its results.
+
+            pingTarget->deleteLater();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::start() -> bool {
+    m_isRunning = true;
+
+    sendToAll(MessageType::Start);
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::stop() -> bool {
+    m_isRunning = false;
+
+    sendToAll(MessageType::Stop);
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setInterval(int interval) -> bool {
+    m_interval = interval;
+
+    sendSubscription();
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::interval() -> int {
+    return m_interval;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setTimeout(int timeout) -> bool {
+    m_timeout = timeout;
+
+    sendSubscription();
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setPayloadSize(int payloadSize) -> bool {
+    if ((payloadSize < 0) || (payloadSize > MaximumPayloadSize)) {
+        return false;
+    }
+
+    m_payloadSize = payloadSize;
+
+    sendSubscription();
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setDontFragment(bool dontFragment) -> bool {
+    m_dontFragment = dontFragment;
+
+    sendSubscription();
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::dontFragment() -> bool {
+    return m_dontFragment;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setFlowStable(bool flowStable) -> bool {
+    m_flowStable = flowStable;
+
+    sendSubscription();
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::flowStable() -> bool {
+    return m_flowStable;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::setResultBatching(bool batching) -> bool {
+    m_resultBatching = batching;
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::epoch() -> QDateTime {
+    return Nedrysoft::Core::Clock::getInstance()->currentDateTime();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> {
+    QList<Nedrysoft::RouteAnalyser::IPingTarget *> list;
+
+    for (auto target : m_pingTargets) {
+        list.append(target);
+    }
+
+    return list;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::saveConfiguration() -> QJsonObject {
+   return QJsonObject();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngine::loadConfiguration(QJsonObject configuration) -> bool {
+    Q_UNUSED(configuration)
+
+    return true;
+}
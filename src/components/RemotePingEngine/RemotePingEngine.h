@@ -0,0 +1,546 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINE_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINE_H
+
+#include "AgentRing.h"
+#include "RemotePingProtocol.h"
+
+#include <IInterface>
+#include <IPingEngine>
+#include <IPingEngineFactory>
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <future>
+#include <memory>
+
+class QIODevice;
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    class RemotePingTarget;
+    class SharedRingReceiver;
+
+    /**
+     * @brief       The RemotePingEngine provides a ping engine which is driven by a ping agent.
+     *
+     * @details     The agent owns the raw sockets and the scheduler, the engine subscribes to it over a local or
+     *              TCP socket and mirrors its settings and targets to the agent, the results are streamed back in
+     *              batches.  This allows many clients to share a single privileged agent and allows probes to be
+     *              sent from a remote vantage point.
+     *
+     *              The agent address is either tcp://:secret@host:port or local:name for a local socket, an agent
+     *              listening on TCP challenges the client when it connects and the answer is made with the secret
+     *              (which is never sent itself).  If the connection is lost the engine reconnects and sends its
+     *              state again, results are not available while disconnected.
+     *
+     *              An engine may be given a fleet of agents, each with a weight.  The engine connects to all of
+     *              them and assigns each target to one of the connected agents with an AgentRing keyed on the
+     *              target host, so all the hops of a route are probed from the same site.  When an agent
+     *              disconnects its targets move to the remaining agents and when it reconnects they move back,
+     *              the targets of the other agents stay where they are.  The results of every agent are
+     *              delivered by the one engine.
+     *
+     *              On Linux, an agent connected over a local socket is asked for a SharedResultRing, the agent
+     *              creates the ring and passes it back over the socket, it then writes its results into the ring
+     *              and the engine reads them in place, the socket is left to carry the control messages.  If the
+     *              agent cannot create the ring the results stay on the socket.
+     */
+    class RemotePingEngine :
+            public Nedrysoft::RouteAnalyser::IPingEngine {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPingEngine)
+
+        public:
+            /**
+             * @brief       Constructs a RemotePingEngine for the given IP version.
+             *
+             * @param[in]   version the IP version of the engine.
+             * @param[in]   agents the addresses of the agents and their weights.
+             */
+            RemotePingEngine(Nedrysoft::Core::IPVersion version, const QMap<QString, int> &agents);
+
+            /**
+             * @brief       Destroys the RemotePingEngine.
+             */
+            ~RemotePingEngine();
+
+            /**
+             * @brief       Sets the measurement interval for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setInterval
+             *
+             * @param[in]   interval the interval between pings in milliseconds.
+             *
+             * @returns     returns true on success; otherwise false.
+             */
+            auto setInterval(int interval) -> bool override;
+
+            /**
+             * @brief       Returns the measurement interval.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::interval
+             *
+             * @returns     returns the measurement interval.
+             */
+            auto interval() -> int override;
+
+            /**
+             * @brief       Sets the reply timeout for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setTimeout
+             *
+             * @param[in]   timeout the time in milliseconds to wait for a reply.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setTimeout(int timeout) -> bool override;
+
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setPayloadSize(int payloadSize) -> bool override;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setDontFragment
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool override;
+
+            /**
+             * @brief       Returns whether echo requests are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::dontFragment
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            auto dontFragment() -> bool override;
+
+            /**
+             * @brief       Sets whether the agent keeps probes on a single flow.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setFlowStable
+             *
+             * @param[in]   flowStable true to keep probes on a single flow; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setFlowStable(bool flowStable) -> bool override;
+
+            /**
+             * @brief       Returns whether the agent keeps probes on a single flow.
+             *
+             * @returns     true if flow stable; otherwise false.
+             */
+            auto flowStable() -> bool override;
+
+            /**
+             * @brief       Sets whether results are delivered in batches.
+             *
+             * @details     The agent always sends results in batches, when enabled each batch received is
+             *              delivered by a single resultsReady() signal.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setResultBatching
+             *
+             * @param[in]   batching true to deliver results in batches; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setResultBatching(bool batching) -> bool override;
+
+            /**
+             * @brief       Starts ping operations for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::start
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto start() -> bool override;
+
+            /**
+             * @brief       Stops ping operations for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::stop
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto stop() -> bool override;
+
+            /**
+             * @brief       Adds a ping target to this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::addTarget
+             *
+             * @param[in]   hostAddress the host address of the ping target.
+             *
+             * @returns     returns a pointer to the created ping target.
+             */
+            auto addTarget(QHostAddress hostAddress) -> Nedrysoft::RouteAnalyser::IPingTarget * override;
+
+            /**
+             * @brief       Adds a ping target to this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::addTarget
+             *
+             * @param[in]   hostAddress the host address of the ping target.
+             * @param[in]   ttl the time to live to use.
+             *
+             * @returns     returns a pointer to the created ping target.
+             */
+            auto addTarget(QHostAddress hostAddress, int ttl) -> Nedrysoft::RouteAnalyser::IPingTarget * override;
+
+            /**
+             * @brief       Removes a ping target from this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::removeTarget
+             *
+             * @param[in]   target the ping target to remove.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto removeTarget(Nedrysoft::RouteAnalyser::IPingTarget *target) -> bool override;
+
+            /**
+             * @brief       Gets the epoch for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::epoch
+             *
+             * @returns     the time epoch.
+             */
+            auto epoch() -> QDateTime override;
+
+            /**
+             * @brief       Returns the list of ping targets for the engine.
+             *
+             * @returns     a QList containing the list of targets.
+             */
+            auto targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> override;
+
+            /**
+             * @brief       Transmits a single ping from the agent.
+             *
+             * @note        This is a blocking function and must not be called from the thread that owns the engine,
+             *              as the reply is received on that thread.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             *
+             * @returns     the result of the ping.
+             */
+            auto singleShot(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout
+            ) -> Nedrysoft::RouteAnalyser::PingResult override;
+
+            /**
+             * @brief       Transmits a single ping from the agent without blocking the caller.
+             *
+             * @details     The request may be made from any thread, the future is fulfilled when the agent sends the
+             *              result, or with a no reply result if the connection to the agent is lost.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::singleShotAsync
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto singleShotAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> override;
+
+            /**
+             * @brief       Transmits a single ping from the agent on the given flow without blocking the caller.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::singleShotFlowAsync
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   flowIdentifier the flow to send the probe on.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto singleShotFlowAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout,
+                uint16_t flowIdentifier
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> override;
+
+        public:
+            /**
+             * @brief       Saves the configuration to a JSON object.
+             *
+             * @see         Nedrysoft::Core::IConfiguration::saveConfiguration
+             *
+             * @returns     the JSON configuration.
+             */
+            auto saveConfiguration() -> QJsonObject override;
+
+            /**
+             * @brief       Loads the configuration.
+             *
+             * @see         Nedrysoft::Core::IConfiguration::loadConfiguration
+             *
+             * @param[in]   configuration the configuration as JSON object.
+             *
+             * @returns     true if loaded; otherwise false.
+             */
+            auto loadConfiguration(QJsonObject configuration) -> bool override;
+
+        private:
+            /**
+             * @brief       The connection to one of the agents.
+             */
+            struct AgentLink {
+                QString address;                                        //! the address of the agent.
+                int weight;                                             //! the relative capacity of the agent.
+                QIODevice *socket;                                      //! the connection.
+                QByteArray receiveBuffer;                               //! the data received but not yet framed.
+                bool connected;                                         //! whether the connection is open.
+                SharedRingReceiver *sharedRing;                         //! the shared ring, if attached.
+                int sharedRingDescriptor;                               //! the ring received but not yet mapped.
+                bool sharedRingFailed;                                  //! whether the ring could not be used.
+            };
+
+        private:
+            /**
+             * @brief       Opens the connection to an agent.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto connectToAgent(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Adds an agent to the ring once it has said hello and sends it the settings, its share of
+             *              the targets and the running state.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto onConnected(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Removes an agent from the ring, moves its targets to the remaining agents, fails its
+             *              outstanding single shot requests and schedules a reconnection.
+             *
+             * @details     Called when the connection is lost or could not be made.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto onDisconnected(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Fulfils outstanding single shot requests with a no reply result.
+             *
+             * @param[in]   agent the address of the agent whose requests are failed; otherwise an empty string for
+             *              every request.
+             */
+            auto failSingleShots(const QString &agent = QString()) -> void;
+
+            /**
+             * @brief       Processes the frames received from an agent.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto onReadyRead(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Sends a message to an agent if connected.
+             *
+             * @param[in]   agent the agent.
+             * @param[in]   type the type of message.
+             * @param[in]   payload the payload of the message.
+             */
+            auto send(
+                    AgentLink *agent,
+                    Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType type,
+                    const QByteArray &payload = QByteArray() ) -> void;
+
+            /**
+             * @brief       Sends a message to every connected agent.
+             *
+             * @param[in]   type the type of message.
+             * @param[in]   payload the payload of the message.
+             */
+            auto sendToAll(
+                    Nedrysoft::RemotePingEngine::RemotePingProtocol::MessageType type,
+                    const QByteArray &payload = QByteArray() ) -> void;
+
+            /**
+             * @brief       Sends the current settings to every connected agent.
+             */
+            auto sendSubscription() -> void;
+
+            /**
+             * @brief       Sends a target to the agent it is assigned to.
+             *
+             * @param[in]   pingTarget the target.
+             */
+            auto sendTarget(Nedrysoft::RemotePingEngine::RemotePingTarget *pingTarget) -> void;
+
+            /**
+             * @brief       Assigns every target to the agent the ring now gives it, moving the targets whose agent
+             *              has changed.
+             */
+            auto rebalance() -> void;
+
+            /**
+             * @brief       Returns the agent that a host is probed from.
+             *
+             * @details     Every hop of a route is probed towards the same host, so keying on the host keeps a
+             *              route on one agent.
+             *
+             * @param[in]   hostAddress the host.
+             *
+             * @returns     the agent; otherwise nullptr if no agent is connected.
+             */
+            auto agentFor(const QHostAddress &hostAddress) -> AgentLink *;
+
+            /**
+             * @brief       Delivers a batch of results received from an agent.
+             *
+             * @param[in]   agent the agent.
+             * @param[in]   payload the payload of the results message.
+             */
+            auto processResults(AgentLink *agent, const QByteArray &payload) -> void;
+
+            /**
+             * @brief       Delivers the results that an agent has written into its shared ring.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto processSharedRing(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Asks an agent on the same host for a shared ring and waits for its reply.
+             *
+             * @details     Nothing is asked of an agent connected over TCP, or of one whose ring could not be used
+             *              before.  The reply is read into the receive buffer with the descriptor of the ring, the
+             *              connection is closed if the agent does not reply.
+             *
+             * @param[in]   agent the agent.
+             *
+             * @returns     true if the connection is still open; otherwise false.
+             */
+            auto offerSharedRing(AgentLink *agent) -> bool;
+
+            /**
+             * @brief       Releases the shared ring of an agent.
+             *
+             * @param[in]   agent the agent.
+             */
+            auto releaseSharedRing(AgentLink *agent) -> void;
+
+            /**
+             * @brief       Emits results as a batch or individually according to the batching setting.
+             *
+             * @param[in]   results the results.
+             */
+            auto deliverResults(const QVector<Nedrysoft::RouteAnalyser::PingResult> &results) -> void;
+
+            /**
+             * @brief       Fulfils the single shot request that a result belongs to.
+             *
+             * @param[in]   payload the payload of the single shot result message.
+             */
+            auto processSingleShotResult(const QByteArray &payload) -> void;
+
+            /**
+             * @brief       Registers a single shot request and queues it for sending.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   flowIdentifier the flow to send the probe on; otherwise -1.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            auto requestSingleShot(
+                    QHostAddress hostAddress,
+                    int ttl,
+                    double timeout,
+                    int flowIdentifier ) -> std::future<Nedrysoft::RouteAnalyser::PingResult>;
+
+            friend class RemotePingTarget;
+
+        private:
+            //! @cond
+
+            QMap<QString, AgentLink *> m_agents;
+            Nedrysoft::RemotePingEngine::AgentRing m_ring;
+
+            QMap<quint32, RemotePingTarget *> m_pingTargets;
+            QMap<quint32, QString> m_targetAgents;
+            quint32 m_nextTargetId;
+
+            QMutex m_singleShotMutex;
+            QMap<quint32, std::shared_ptr<std::promise<Nedrysoft::RouteAnalyser::PingResult> > > m_singleShots;
+            QMap<quint32, QString> m_singleShotAgents;
+            std::atomic<quint32> m_nextRequestId;
+
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            int m_interval;
+            int m_timeout;
+            int m_payloadSize;
+            bool m_dontFragment;
+            bool m_flowStable;
+            bool m_resultBatching;
+            bool m_isRunning;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINE_H
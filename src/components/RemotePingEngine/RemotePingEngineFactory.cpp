@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RemotePingEngineFactory.h"
+
+#include "RemotePingEngine.h"
+
+#include <QJsonArray>
+#include <QProcessEnvironment>
+
+constexpr auto AgentEnvironmentVariable = "PINGNOO_AGENT";
+constexpr auto AgentConfigurationKey = "agent";
+constexpr auto AgentsConfigurationKey = "agents";
+constexpr auto AddressConfigurationKey = "address";
+constexpr auto WeightConfigurationKey = "weight";
+constexpr auto DefaultAgentWeight = 1;
+
+Nedrysoft::RemotePingEngine::RemotePingEngineFactory::RemotePingEngineFactory() {
+    auto agentAddresses = QProcessEnvironment::systemEnvironment().value(AgentEnvironmentVariable);
+
+    for (auto agentAddress : agentAddresses.split(',')) {
+        agentAddress = agentAddress.trimmed();
+
+        if (!agentAddress.isEmpty()) {
+            m_agents[agentAddress] = DefaultAgentWeight;
+        }
+    }
+}
+
+Nedrysoft::RemotePingEngine::RemotePingEngineFactory::RemotePingEngineFactory(const QString &agentAddress) :
+        m_vantagePoint(agentAddress) {
+
+    m_agents[agentAddress] = DefaultAgentWeight;
+}
+
+Nedrysoft::RemotePingEngine::RemotePingEngineFactory::~RemotePingEngineFactory() {
+
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::createEngine(
+        Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::IPingEngine * {
+
+    return new Nedrysoft::RemotePingEngine::RemotePingEngine(version, m_agents);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::saveConfiguration() -> QJsonObject {
+    auto agents = QJsonArray();
+
+    for (auto agent=m_agents.begin();agent!=m_agents.end();agent++) {
+        agents.append(QJsonObject {
+            {AddressConfigurationKey, agent.key()},
+            {WeightConfigurationKey, agent.value()}
+        });
+    }
+
+    return QJsonObject {
+        {AgentsConfigurationKey, agents}
+    };
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::loadConfiguration(QJsonObject configuration) -> bool {
+    // a single agent factory is created for one site of the fleet and keeps that agent.
+
+    if (!m_vantagePoint.isEmpty()) {
+        return true;
+    }
+
+    if (configuration.contains(AgentsConfigurationKey)) {
+        m_agents.clear();
+
+        for (auto value : configuration[AgentsConfigurationKey].toArray()) {
+            auto agent = value.toObject();
+            auto address = agent[AddressConfigurationKey].toString();
+
+            if (address.isEmpty()) {
+                continue;
+            }
+
+            m_agents[address] = agent[WeightConfigurationKey].toInt(DefaultAgentWeight);
+        }
+    } else if (configuration.contains(AgentConfigurationKey)) {
+        auto address = configuration[AgentConfigurationKey].toString();
+
+        m_agents.clear();
+
+        if (!address.isEmpty()) {
+            m_agents[address] = DefaultAgentWeight;
+        }
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::description() -> QString {
+    if (!m_vantagePoint.isEmpty()) {
+        return tr("Remote Agent (%1)").arg(m_vantagePoint);
+    }
+
+    return tr("Remote Agent");
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::priority() -> double {
+    return 0;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::available() -> bool {
+    return !m_agents.isEmpty();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::deleteEngine(
+        Nedrysoft::RouteAnalyser::IPingEngine *engine) -> bool {
+
+    if (!qobject_cast<Nedrysoft::RemotePingEngine::RemotePingEngine *>(engine)) {
+        return false;
+    }
+
+    engine->stop();
+
+    delete engine;
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::vantagePoint() -> QString {
+    return m_vantagePoint;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingEngineFactory::agents() -> QStringList {
+    return m_agents.keys();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINEFACTORY_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINEFACTORY_H
+
+#include <IInterface.h>
+#include <IPingEngineFactory>
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    class RemotePingEngine;
+
+    /**
+     * @brief       Factory class for RemotePingEngine
+     *
+     * @details     The factory class for creating instances of the RemotePingEngine type, every engine
+     *              created connects to the configured agents.
+     *
+     *              A single agent is configured with the "agent" key, a fleet of agents with the "agents" key, an
+     *              array of objects holding the "address" and (optionally) the "weight" of each agent.  The
+     *              PINGNOO_AGENT environment variable may hold a comma separated list of agent addresses, which
+     *              are given equal weights.
+     */
+    class RemotePingEngineFactory :
+            public Nedrysoft::RouteAnalyser::IPingEngineFactory {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPingEngineFactory)
+
+        public:
+            /**
+             * @brief       Constructs a RemotePingEngineFactory for the configured agents.
+             */
+            RemotePingEngineFactory();
+
+            /**
+             * @brief       Constructs a RemotePingEngineFactory whose engines only probe from a single agent.
+             *
+             * @details     When a fleet of agents is configured a factory is created for each agent, so that a
+             *              target can be traced from each of the sites rather than from the one that the fleet
+             *              assigns it to.
+             *
+             * @param[in]   agentAddress the address of the agent.
+             */
+            explicit RemotePingEngineFactory(const QString &agentAddress);
+
+            /**
+             * @brief       Destroys the RemotePingEngineFactory.
+             */
+            ~RemotePingEngineFactory();
+
+        public:
+            /**
+             * @brief       Creates a RemotePingEngine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngineFactory::createEngine
+             *
+             * @param[in]   version the IP version of the engine.
+             *
+             * @returns     the new RemotePingEngine instance.
+             */
+            auto createEngine(Nedrysoft::Core::IPVersion version) -> Nedrysoft::RouteAnalyser::IPingEngine * override;
+
+            /**
+             * @brief       Returns the descriptive name of the factory.
+             *
+             * @returns     the descriptive name of the ping engine.
+             */
+            auto description() -> QString override;
+
+            /**
+             * @brief       Priority of the ping engine.  The priority is 0=lowest, 1=highest.  This allows
+             *              the application to provide a default engine per platform.
+             *
+             * @returns     the priority.
+             */
+            auto priority() -> double override;
+
+            /**
+             * @brief      Returns whether the ping engine is available for use.
+             *
+             * @note       The engine is only available once at least one agent address has been configured,
+             *             either in the configuration or with the PINGNOO_AGENT environment variable.
+             *
+             * @returns    true if available; otherwise false.
+             */
+            auto available() -> bool override;
+
+            /**
+             * @brief      Deletes a ping engine that was created by this instance.
+             *
+             * @note       If the ping engine is still running, this function will stop it.
+             *
+             * @param[in]  engine the ping engine to be removed.
+             *
+             * @returns    true if the engine was deleted; otherwise false.
+             */
+            auto deleteEngine(Nedrysoft::RouteAnalyser::IPingEngine *engine) -> bool override;
+
+            /**
+             * @brief       Returns the vantage point that the engines probe from.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngineFactory::vantagePoint
+             *
+             * @returns     the address of the agent for a single agent factory; otherwise an empty string.
+             */
+            auto vantagePoint() -> QString override;
+
+            /**
+             * @brief       Returns the addresses of the configured agents.
+             *
+             * @returns     the agent addresses.
+             */
+            auto agents() -> QStringList;
+
+        public:
+            /**
+             * @brief       Saves the configuration to a JSON object.
+             *
+             * @returns     the JSON configuration.
+             */
+            auto saveConfiguration() -> QJsonObject override;
+
+            /**
+             * @brief       Loads the configuration.
+             *
+             * @see         Nedrysoft::Core::IConfiguration::loadConfiguration
+             *
+             * @param[in]   configuration the configuration as JSON object.
+             *
+             * @returns     true if loaded; otherwise false.
+             */
+            auto loadConfiguration(QJsonObject configuration) -> bool override;
+
+        private:
+            //! @cond
+
+            QMap<QString, int> m_agents;
+            QString m_vantagePoint;
+
+            //! @endcond
+    };
+}}
+
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGENGINEFACTORY_H
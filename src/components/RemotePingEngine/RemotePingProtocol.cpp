@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RemotePingProtocol.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+
+constexpr auto FrameHeaderLength = 5;
+constexpr auto MaximumFrameLength = 1024*1024;
+constexpr auto NullAddressFamily = 0;
+constexpr auto IPv4AddressFamily = 4;
+constexpr auto IPv6AddressFamily = 6;
+constexpr auto DontFragmentFlag = 0x01;
+constexpr auto FlowStableFlag = 0x02;
+constexpr auto MaximumSharedRingCapacity = 1<<20;
+constexpr auto ChallengeLength = 32;
+constexpr auto MaximumInterval = 24u*60*60*1000;
+constexpr auto MaximumTimeout = 60u*60*1000;
+constexpr auto MaximumPayloadSize = 65507;
+constexpr auto MaximumFlowIdentifier = 0xffff;
+
+static auto writeAddress(QDataStream &stream, const QHostAddress &hostAddress) -> void {
+    if (hostAddress.protocol()==QAbstractSocket::IPv4Protocol) {
+        stream << static_cast<quint8>(IPv4AddressFamily) << static_cast<quint32>(hostAddress.toIPv4Address());
+    } else if (hostAddress.protocol()==QAbstractSocket::IPv6Protocol) {
+        auto address = hostAddress.toIPv6Address();
+
+        stream << static_cast<quint8>(IPv6AddressFamily);
+        stream.writeRawData(reinterpret_cast<const char *>(address.c), sizeof(address.c));
+    } else {
+        stream << static_cast<quint8>(NullAddressFamily);
+    }
+}
+
+static auto readAddress(QDataStream &stream) -> QHostAddress {
+    quint8 family = NullAddressFamily;
+
+    stream >> family;
+
+    if (family==IPv4AddressFamily) {
+        quint32 address = 0;
+
+        stream >> address;
+
+        return QHostAddress(address);
+    }
+
+    if (family==IPv6AddressFamily) {
+        Q_IPV6ADDR address;
+
+        if (stream.readRawData(reinterpret_cast<char *>(address.c), sizeof(address.c))!=sizeof(address.c)) {
+            stream.setStatus(QDataStream::ReadPastEnd);
+        }
+
+        return QHostAddress(address);
+    }
+
+    if (family!=NullAddressFamily) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    return QHostAddress();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::frame(
+        MessageType type,
+        const QByteArray &payload ) -> QByteArray {
+
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << static_cast<quint32>(payload.length()+1) << static_cast<quint8>(type);
+
+    buffer.append(payload);
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::takeFrame(
+        QByteArray &buffer,
+        MessageType &type,
+        QByteArray &payload ) -> FrameStatus {
+
+    if (buffer.length()<FrameHeaderLength) {
+        return FrameStatus::Incomplete;
+    }
+
+    QDataStream stream(buffer);
+    quint32 length;
+    quint8 messageType;
+
+    stream >> length >> messageType;
+
+    if ((length<1) || (length>MaximumFrameLength)) {
+        return FrameStatus::Invalid;
+    }
+
+    if (static_cast<quint32>(buffer.length())<length+sizeof(quint32)) {
+        return FrameStatus::Incomplete;
+    }
+
+    type = static_cast<MessageType>(messageType);
+    payload = buffer.mid(FrameHeaderLength, static_cast<int>(length-1));
+
+    buffer.remove(0, static_cast<int>(length+sizeof(quint32)));
+
+    return FrameStatus::Complete;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeHello(const QByteArray &challenge) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << Version << challenge;
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeHello(
+        const QByteArray &payload,
+        quint16 &version,
+        QByteArray &challenge ) -> bool {
+
+    QDataStream stream(payload);
+
+    challenge.clear();
+
+    stream >> version;
+
+    if (version>=AuthenticationVersion) {
+        stream >> challenge;
+    }
+
+    return stream.status()==QDataStream::Ok;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::createChallenge() -> QByteArray {
+    QByteArray challenge(ChallengeLength, 0);
+
+    QRandomGenerator::system()->fillRange(
+            reinterpret_cast<quint32 *>(challenge.data()),
+            ChallengeLength/static_cast<int>(sizeof(quint32)) );
+
+    return challenge;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeAuthentication(
+        const QByteArray &secret,
+        const QByteArray &challenge ) -> QByteArray {
+
+    return QMessageAuthenticationCode::hash(challenge, secret, QCryptographicHash::Sha256);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::verifyAuthentication(
+        const QByteArray &payload,
+        const QByteArray &secret,
+        const QByteArray &challenge ) -> bool {
+
+    if ((secret.isEmpty()) || (challenge.isEmpty())) {
+        return false;
+    }
+
+    auto expected = encodeAuthentication(secret, challenge);
+
+    if (payload.length()!=expected.length()) {
+        return false;
+    }
+
+    // every byte is compared, so the time taken does not say how much of the answer was right.
+
+    auto difference = 0;
+
+    for (auto index=0;index<expected.length();index++) {
+        difference |= payload.at(index) ^ expected.at(index);
+    }
+
+    return difference==0;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeSubscription(
+        const Subscription &subscription ) -> QByteArray {
+
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+    quint8 flags = 0;
+
+    if (subscription.dontFragment) {
+        flags |= DontFragmentFlag;
+    }
+
+    if (subscription.flowStable) {
+        flags |= FlowStableFlag;
+    }
+
+    stream << static_cast<quint8>(subscription.ipVersion)
+           << static_cast<quint32>(subscription.interval)
+           << static_cast<quint32>(subscription.timeout)
+           << static_cast<quint16>(subscription.payloadSize)
+           << flags;
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeSubscription(
+        const QByteArray &payload,
+        Subscription &subscription ) -> bool {
+
+    QDataStream stream(payload);
+    quint8 ipVersion, flags;
+    quint32 interval, timeout;
+    quint16 payloadSize;
+
+    stream >> ipVersion >> interval >> timeout >> payloadSize >> flags;
+
+    if ((stream.status()!=QDataStream::Ok) ||
+        (interval==0) || (interval>MaximumInterval) ||
+        (timeout==0) || (timeout>MaximumTimeout) ||
+        (payloadSize>MaximumPayloadSize)) {
+
+        return false;
+    }
+
+    subscription.ipVersion = (ipVersion==static_cast<quint8>(Nedrysoft::Core::IPVersion::V6)) ?
+            Nedrysoft::Core::IPVersion::V6 : Nedrysoft::Core::IPVersion::V4;
+
+    subscription.interval = static_cast<int>(interval);
+    subscription.timeout = static_cast<int>(timeout);
+    subscription.payloadSize = payloadSize;
+    subscription.dontFragment = (flags & DontFragmentFlag);
+    subscription.flowStable = (flags & FlowStableFlag);
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeTarget(const Target &target) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << target.id << static_cast<quint8>(target.ttl) << static_cast<quint16>(target.payloadSize);
+
+    writeAddress(stream, target.hostAddress);
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeTarget(const QByteArray &payload, Target &target) -> bool {
+    QDataStream stream(payload);
+    quint8 ttl;
+    quint16 payloadSize;
+
+    stream >> target.id >> ttl >> payloadSize;
+
+    target.ttl = ttl;
+    target.payloadSize = payloadSize;
+    target.hostAddress = readAddress(stream);
+
+    return stream.status()==QDataStream::Ok;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeTargetId(quint32 id) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << id;
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeTargetId(const QByteArray &payload, quint32 &id) -> bool {
+    QDataStream stream(payload);
+
+    stream >> id;
+
+    return stream.status()==QDataStream::Ok;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeSingleShot(const SingleShotRequest &request) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << request.id
+           << static_cast<quint8>(request.ttl)
+           << static_cast<quint32>(request.timeout)
+           << static_cast<qint32>(request.flowIdentifier);
+
+    writeAddress(stream, request.hostAddress);
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeSingleShot(
+        const QByteArray &payload,
+        SingleShotRequest &request ) -> bool {
+
+    QDataStream stream(payload);
+    quint8 ttl;
+    quint32 timeout;
+    qint32 flowIdentifier;
+
+    stream >> request.id >> ttl >> timeout >> flowIdentifier;
+
+    request.ttl = ttl;
+    request.timeout = static_cast<int>(timeout);
+    request.flowIdentifier = flowIdentifier;
+    request.hostAddress = readAddress(stream);
+
+    return (stream.status()==QDataStream::Ok) &&
+           (ttl!=0) &&
+           (timeout!=0) && (timeout<=MaximumTimeout) &&
+           (flowIdentifier>=-1) && (flowIdentifier<=MaximumFlowIdentifier);
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeResults(const QVector<ResultRecord> &records) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << static_cast<quint32>(records.count());
+
+    for (auto &record : records) {
+        stream << record.id
+               << static_cast<quint32>(record.result.sampleNumber())
+               << static_cast<quint8>(record.result.code())
+               << record.result.requestTimestamp()
+               << record.result.preciseRoundTripTime()
+               << static_cast<qint8>(record.result.hops());
+
+        writeAddress(stream, record.result.hostAddress());
+    }
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeResults(
+        const QByteArray &payload,
+        QVector<ResultRecord> &records ) -> bool {
+
+    QDataStream stream(payload);
+    quint32 count;
+
+    stream >> count;
+
+    if ((stream.status()!=QDataStream::Ok) || (count>static_cast<quint32>(payload.length()))) {
+        return false;
+    }
+
+    records.reserve(records.count()+static_cast<int>(count));
+
+    for (quint32 i=0;i<count;i++) {
+        quint32 id, sampleNumber;
+        quint8 code;
+        qint64 requestTimestamp, roundTripTime;
+        qint8 hops;
+
+        stream >> id >> sampleNumber >> code >> requestTimestamp >> roundTripTime >> hops;
+
+        auto hostAddress = readAddress(stream);
+
+        if ((stream.status()!=QDataStream::Ok) ||
+            (code>static_cast<quint8>(Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited))) {
+            return false;
+        }
+
+        records.append(ResultRecord {
+            id,
+            Nedrysoft::RouteAnalyser::PingResult(
+                sampleNumber,
+                static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(code),
+                hostAddress,
+                requestTimestamp,
+                roundTripTime,
+                nullptr,
+                hops
+            )
+        });
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeSharedRing(int capacity) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << static_cast<quint32>(capacity);
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeSharedRing(
+        const QByteArray &payload,
+        int &capacity ) -> bool {
+
+    QDataStream stream(payload);
+    quint32 value;
+
+    stream >> value;
+
+    if ((stream.status()!=QDataStream::Ok) || (value==0) || (value>MaximumSharedRingCapacity)) {
+        return false;
+    }
+
+    capacity = static_cast<int>(value);
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::encodeSharedRingStatus(bool attached) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << static_cast<quint8>(attached ? 1 : 0);
+
+    return buffer;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingProtocol::decodeSharedRingStatus(
+        const QByteArray &payload,
+        bool &attached ) -> bool {
+
+    QDataStream stream(payload);
+    quint8 status;
+
+    stream >> status;
+
+    attached = (status!=0);
+
+    return stream.status()==QDataStream::Ok;
+}
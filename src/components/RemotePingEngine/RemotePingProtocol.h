@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGPROTOCOL_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGPROTOCOL_H
+
+#include "RemotePingEngineSpec.h"
+
+#include <ICore>
+#include <PingResult>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    /**
+     * @brief       The RemotePingProtocol class provides the wire format used between a ping agent and its clients.
+     *
+     * @details     Every message is a frame of a 32 bit length (covering the type and payload), an 8 bit message
+     *              type and the payload.  All values are big endian, addresses are an 8 bit family (0 for a null
+     *              address, 4 or 6) followed by the 4 or 16 address bytes.
+     *
+     *              Results are sent in batches, each record is 31 bytes for an IPv4 result, so a single frame can
+     *              carry every result produced by a pass of the agent's receiver.  A client on the same host
+     *              may ask the agent to write its results into a SharedResultRing instead, the socket then only
+     *              carries the control messages and single shot results.
+     */
+    class NEDRYSOFT_REMOTEPINGENGINE_DLLSPEC RemotePingProtocol {
+        public:
+            /**
+             * @brief       The version of the protocol, the agent sends this in its hello message.
+             */
+            static constexpr quint16 Version = 4;
+
+            /**
+             * @brief       The oldest version of the protocol that a client can talk to.
+             */
+            static constexpr quint16 MinimumVersion = 1;
+
+            /**
+             * @brief       The first version of the protocol in which the agent creates a shared memory ring and
+             *              passes it to the client.
+             *
+             * @details     Versions 2 and 3 attached to a named segment created by the client, a client does not
+             *              offer a ring to those agents and their results stay on the socket.
+             */
+            static constexpr quint16 SharedRingVersion = 4;
+
+            /**
+             * @brief       The first version of the protocol in which the hello message carries a challenge.
+             *
+             * @details     A client connecting over TCP answers the challenge with an authenticate message before
+             *              any other message, the agent closes the connection if the answer is wrong.
+             */
+            static constexpr quint16 AuthenticationVersion = 3;
+
+            /**
+             * @brief       The types of message, messages from the agent have the top bit set.
+             */
+            enum class MessageType : uint8_t {
+                Subscribe = 0x01,
+                AddTarget = 0x02,
+                RemoveTarget = 0x03,
+                Start = 0x04,
+                Stop = 0x05,
+                SingleShot = 0x06,
+                AttachSharedRing = 0x07,
+                Authenticate = 0x08,
+                Hello = 0x80,
+                Results = 0x81,
+                SingleShotResult = 0x82,
+                SharedRingAttached = 0x83
+            };
+
+            /**
+             * @brief       The result of attempting to take a frame from a receive buffer.
+             */
+            enum class FrameStatus {
+                Incomplete,
+                Complete,
+                Invalid
+            };
+
+            /**
+             * @brief       The engine settings sent by a client when it subscribes.
+             */
+            struct Subscription {
+                Nedrysoft::Core::IPVersion ipVersion;
+                int interval;
+                int timeout;
+                int payloadSize;
+                bool dontFragment;
+                bool flowStable;
+            };
+
+            /**
+             * @brief       A target added by a client.
+             */
+            struct Target {
+                quint32 id;
+                QHostAddress hostAddress;
+                int ttl;
+                int payloadSize;
+            };
+
+            /**
+             * @brief       A single shot request made by a client.
+             */
+            struct SingleShotRequest {
+                quint32 id;
+                QHostAddress hostAddress;
+                int ttl;
+                int timeout;
+                int flowIdentifier;
+            };
+
+            /**
+             * @brief       A result and the id of the target (or single shot request) that it belongs to.
+             *
+             * @note        The target of the result is always null, the receiver maps the id to its own target.
+             */
+            struct ResultRecord {
+                quint32 id;
+                Nedrysoft::RouteAnalyser::PingResult result;
+            };
+
+        public:
+            /**
+             * @brief       Creates a frame containing a message.
+             *
+             * @param[in]   type the type of message.
+             * @param[in]   payload the payload of the message.
+             *
+             * @returns     the frame.
+             */
+            static auto frame(MessageType type, const QByteArray &payload = QByteArray()) -> QByteArray;
+
+            /**
+             * @brief       Removes the first frame from a receive buffer.
+             *
+             * @details     The buffer is left untouched if it does not yet contain a complete frame, a frame that
+             *              exceeds the maximum length is invalid and the connection should be closed.
+             *
+             * @param[in,out]   buffer the data received so far.
+             * @param[out]      type the type of the message.
+             * @param[out]      payload the payload of the message.
+             *
+             * @returns     the status of the buffer.
+             */
+            static auto takeFrame(QByteArray &buffer, MessageType &type, QByteArray &payload) -> FrameStatus;
+
+            /**
+             * @brief       Encodes the hello message sent by the agent when a client connects.
+             *
+             * @param[in]   challenge the random challenge that a client must answer to authenticate.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeHello(const QByteArray &challenge) -> QByteArray;
+
+            /**
+             * @brief       Decodes a hello message.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  version the protocol version of the agent.
+             * @param[out]  challenge the challenge, empty if the agent is older than AuthenticationVersion.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeHello(const QByteArray &payload, quint16 &version, QByteArray &challenge) -> bool;
+
+            /**
+             * @brief       Creates a random challenge for a hello message.
+             *
+             * @returns     the challenge.
+             */
+            static auto createChallenge() -> QByteArray;
+
+            /**
+             * @brief       Encodes an authenticate message.
+             *
+             * @details     The message is an HMAC-SHA256 of the challenge keyed with the shared secret, so the
+             *              secret itself is never sent.
+             *
+             * @param[in]   secret the secret shared by the client and the agent.
+             * @param[in]   challenge the challenge from the hello message.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeAuthentication(const QByteArray &secret, const QByteArray &challenge) -> QByteArray;
+
+            /**
+             * @brief       Checks an authenticate message.
+             *
+             * @details     The comparison takes the same time however much of the answer is correct.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[in]   secret the secret shared by the client and the agent.
+             * @param[in]   challenge the challenge that was sent in the hello message.
+             *
+             * @returns     true if the client knows the secret; otherwise false.
+             */
+            static auto verifyAuthentication(
+                const QByteArray &payload,
+                const QByteArray &secret,
+                const QByteArray &challenge
+            ) -> bool;
+
+            /**
+             * @brief       Encodes a subscribe message.
+             *
+             * @param[in]   subscription the engine settings.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeSubscription(const Subscription &subscription) -> QByteArray;
+
+            /**
+             * @brief       Decodes a subscribe message.
+             *
+             * @details     A message with an interval or timeout of zero or outside the range that the protocol
+             *              allows, or with a payload larger than an IP datagram can carry, is invalid.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  subscription the engine settings.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeSubscription(const QByteArray &payload, Subscription &subscription) -> bool;
+
+            /**
+             * @brief       Encodes an add target message.
+             *
+             * @param[in]   target the target.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeTarget(const Target &target) -> QByteArray;
+
+            /**
+             * @brief       Decodes an add target message.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  target the target.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeTarget(const QByteArray &payload, Target &target) -> bool;
+
+            /**
+             * @brief       Encodes a remove target message.
+             *
+             * @param[in]   id the id of the target.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeTargetId(quint32 id) -> QByteArray;
+
+            /**
+             * @brief       Decodes a remove target message.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  id the id of the target.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeTargetId(const QByteArray &payload, quint32 &id) -> bool;
+
+            /**
+             * @brief       Encodes a single shot message.
+             *
+             * @param[in]   request the request.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeSingleShot(const SingleShotRequest &request) -> QByteArray;
+
+            /**
+             * @brief       Decodes a single shot message.
+             *
+             * @details     A message with a TTL of zero, a timeout of zero or outside the range that the protocol
+             *              allows, or a flow identifier that is neither -1 nor 16 bits, is invalid.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  request the request.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeSingleShot(const QByteArray &payload, SingleShotRequest &request) -> bool;
+
+            /**
+             * @brief       Encodes a batch of results, also used (with a single record) for a single shot result.
+             *
+             * @param[in]   records the results.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeResults(const QVector<ResultRecord> &records) -> QByteArray;
+
+            /**
+             * @brief       Decodes a batch of results.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  records the results.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeResults(const QByteArray &payload, QVector<ResultRecord> &records) -> bool;
+
+            /**
+             * @brief       Encodes an attach shared ring message, sent by a client on the same host as the agent.
+             *
+             * @see         Nedrysoft::RemotePingEngine::SharedResultRing
+             *
+             * @param[in]   capacity the number of results the ring should hold.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeSharedRing(int capacity) -> QByteArray;
+
+            /**
+             * @brief       Decodes an attach shared ring message.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  capacity the number of results the ring should hold.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeSharedRing(const QByteArray &payload, int &capacity) -> bool;
+
+            /**
+             * @brief       Encodes the reply to an attach shared ring message.
+             *
+             * @details     When the ring was created its descriptor is attached to the first byte of the reply.
+             *
+             * @param[in]   attached true if the agent will send results through the ring; otherwise false.
+             *
+             * @returns     the payload.
+             */
+            static auto encodeSharedRingStatus(bool attached) -> QByteArray;
+
+            /**
+             * @brief       Decodes the reply to an attach shared ring message.
+             *
+             * @param[in]   payload the payload of the message.
+             * @param[out]  attached true if the agent will send results through the ring; otherwise false.
+             *
+             * @returns     true if decoded; otherwise false.
+             */
+            static auto decodeSharedRingStatus(const QByteArray &payload, bool &attached) -> bool;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_REMOTEPINGPROTOCOL_H
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RemotePingTarget.h"
+
+#include "RemotePingEngine.h"
+
+Nedrysoft::RemotePingEngine::RemotePingTarget::RemotePingTarget(
+        Nedrysoft::RemotePingEngine::RemotePingEngine *engine,
+        quint32 id,
+        QHostAddress hostAddress,
+        int ttl) :
+            m_engine(engine),
+            m_id(id),
+            m_userdata(nullptr),
+            m_ttl(ttl),
+            m_payloadSize(engine->payloadSize()),
+            m_hostAddress(hostAddress) {
+
+}
+
+Nedrysoft::RemotePingEngine::RemotePingTarget::~RemotePingTarget() = default;
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::id() -> quint32 {
+    return m_id;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::setHostAddress(QHostAddress hostAddress) -> void {
+    m_hostAddress = hostAddress;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::hostAddress() -> QHostAddress {
+    return m_hostAddress;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::engine() -> Nedrysoft::RouteAnalyser::IPingEngine * {
+    return m_engine;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::saveConfiguration() -> QJsonObject {
+    return QJsonObject();
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::loadConfiguration(QJsonObject configuration) -> bool {
+    Q_UNUSED(configuration)
+
+    return false;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::ttl() -> uint16_t {
+    return m_ttl;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::setPayloadSize(int payloadSize) -> void {
+    m_payloadSize = payloadSize;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::probeBackoff() -> int {
+    return 1;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::setSamplingDivisor(int divisor) -> void {
+    Q_UNUSED(divisor)
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::userData() -> void * {
+    return m_userdata;
+}
+
+auto Nedrysoft::RemotePingEngine::RemotePingTarget::setUserData(void *data) -> void {
+    m_userdata = data;
+}
@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharedResultRing.h"
+
+#include <QtEndian>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+constexpr quint32 RingMagic = 0x504e5252;
+constexpr quint32 RingVersion = 1;
+constexpr auto CacheLineSize = 64;
+constexpr auto MaximumCapacity = 1<<20;
+constexpr auto NullAddressFamily = 0;
+constexpr auto IPv4AddressFamily = 4;
+constexpr auto IPv6AddressFamily = 6;
+constexpr auto MillisecondsInSecond = 1000;
+constexpr auto NanosecondsInMillisecond = 1000000;
+constexpr auto ReceiveBufferLength = 4096;
+
+#if defined(Q_OS_LINUX)
+constexpr auto RequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+#endif
+
+/**
+ * the header is shared by both processes, the indices are free running counters and each is written by only one of
+ * the processes, so they are kept on separate cache lines.  The sequence is the futex word, it is advanced every
+ * time results are published so that a consumer which is about to sleep can tell that it has missed a wakeup.
+ */
+
+struct Nedrysoft::RemotePingEngine::SharedResultRing::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 capacity;
+    quint32 slotSize;
+
+    alignas(CacheLineSize) std::atomic<quint32> head;
+    alignas(CacheLineSize) std::atomic<quint32> tail;
+    alignas(CacheLineSize) std::atomic<quint32> sequence;
+    std::atomic<quint32> waiting;
+    std::atomic<quint32> dropped;
+};
+
+static_assert(std::atomic<quint32>::is_always_lock_free, "shared ring indices must be lock free");
+static_assert(sizeof(std::atomic<quint32>)==sizeof(quint32), "the futex word must be 32 bits");
+
+#if defined(Q_OS_LINUX)
+static auto futexWait(std::atomic<quint32> *word, quint32 expected, int timeout) -> void {
+    struct timespec timeSpec = {};
+
+    timeSpec.tv_sec = timeout/MillisecondsInSecond;
+    timeSpec.tv_nsec = static_cast<long>(timeout%MillisecondsInSecond)*NanosecondsInMillisecond;
+
+    // the segment is shared between processes, so the private futex operations cannot be used.
+
+    syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAIT, expected, &timeSpec, nullptr, 0);
+}
+
+static auto futexWake(std::atomic<quint32> *word) -> void {
+    syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+static auto isSealed(int descriptor) -> bool {
+    auto seals = fcntl(descriptor, F_GET_SEALS);
+
+    return (seals!=-1) && ((seals & RequiredSeals)==RequiredSeals);
+}
+#endif
+
+Nedrysoft::RemotePingEngine::SharedResultRing::SharedResultRing(int descriptor, void *memory, size_t length) :
+        m_descriptor(descriptor),
+        m_memory(memory),
+        m_length(length),
+        m_header(static_cast<Header *>(memory)),
+        m_slots(reinterpret_cast<Slot *>(static_cast<char *>(memory)+sizeof(Header))),
+        m_mask(m_header->capacity-1),
+        m_writeIndex(m_header->head.load(std::memory_order_acquire)) {
+
+}
+
+Nedrysoft::RemotePingEngine::SharedResultRing::~SharedResultRing() {
+#if defined(Q_OS_LINUX)
+    munmap(m_memory, m_length);
+#endif
+
+    closeDescriptor();
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::create(int capacity) -> SharedResultRing * {
+#if defined(Q_OS_LINUX)
+    if ((capacity<1) || (capacity>MaximumCapacity)) {
+        return nullptr;
+    }
+
+    quint32 slots = 1;
+
+    while (slots<static_cast<quint32>(capacity)) {
+        slots <<= 1;
+    }
+
+    auto length = sizeof(Header)+sizeof(Slot)*slots;
+    auto descriptor = memfd_create("pingnoo-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (descriptor==-1) {
+        return nullptr;
+    }
+
+    /**
+     * the seals cannot be removed, so once they are in place neither process can change the size of the segment
+     * and a write to a mapped slot can never fault.  They are read back before the segment is mapped in case the
+     * kernel did not apply them.
+     */
+
+    if ((ftruncate(descriptor, static_cast<off_t>(length))==-1) ||
+        (fcntl(descriptor, F_ADD_SEALS, RequiredSeals | F_SEAL_SEAL)==-1) ||
+        (!isSealed(descriptor))) {
+
+        ::close(descriptor);
+
+        return nullptr;
+    }
+
+    auto memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+    if (memory==MAP_FAILED) {
+        ::close(descriptor);
+
+        return nullptr;
+    }
+
+    auto header = new (memory) Header;
+
+    header->magic = RingMagic;
+    header->version = RingVersion;
+    header->capacity = slots;
+    header->slotSize = sizeof(Slot);
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->waiting.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_release);
+
+    return new SharedResultRing(descriptor, memory, length);
+#else
+    Q_UNUSED(capacity)
+
+    return nullptr;
+#endif
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::open(int descriptor) -> SharedResultRing * {
+#if defined(Q_OS_LINUX)
+    if (descriptor==-1) {
+        return nullptr;
+    }
+
+    struct stat status = {};
+
+    if ((!isSealed(descriptor)) ||
+        (fstat(descriptor, &status)==-1) ||
+        (!S_ISREG(status.st_mode)) ||
+        (static_cast<size_t>(status.st_size)<sizeof(Header))) {
+
+        ::close(descriptor);
+
+        return nullptr;
+    }
+
+    auto length = static_cast<size_t>(status.st_size);
+    auto memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+    if (memory==MAP_FAILED) {
+        ::close(descriptor);
+
+        return nullptr;
+    }
+
+    // the segment was written by another process, nothing in it is trusted until the layout has been checked.
+
+    auto header = static_cast<Header *>(memory);
+    auto capacity = header->capacity;
+
+    if ((header->magic!=RingMagic) ||
+        (header->version!=RingVersion) ||
+        (header->slotSize!=sizeof(Slot)) ||
+        (capacity==0) ||
+        (capacity>static_cast<quint32>(MaximumCapacity)) ||
+        (capacity & (capacity-1)) ||
+        (sizeof(Header)+sizeof(Slot)*capacity!=length)) {
+
+        munmap(memory, length);
+
+        ::close(descriptor);
+
+        return nullptr;
+    }
+
+    return new SharedResultRing(descriptor, memory, length);
+#else
+    Q_UNUSED(descriptor)
+
+    return nullptr;
+#endif
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::descriptor() const -> int {
+    return m_descriptor;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::closeDescriptor() -> void {
+#if defined(Q_OS_LINUX)
+    if (m_descriptor!=-1) {
+        ::close(m_descriptor);
+    }
+#endif
+
+    m_descriptor = -1;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::sendDescriptor(
+        qintptr socket,
+        const QByteArray &data,
+        int descriptor ) -> qint64 {
+
+#if defined(Q_OS_LINUX)
+    if (data.isEmpty()) {
+        return -1;
+    }
+
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct iovec vector = {const_cast<char *>(data.constData()), static_cast<size_t>(data.size())};
+    struct msghdr message = {};
+
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto controlMessage = CMSG_FIRSTHDR(&message);
+
+    controlMessage->cmsg_level = SOL_SOCKET;
+    controlMessage->cmsg_type = SCM_RIGHTS;
+    controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+
+    memcpy(CMSG_DATA(controlMessage), &descriptor, sizeof(int));
+
+    auto result = ssize_t(0);
+
+    do {
+        result = sendmsg(static_cast<int>(socket), &message, MSG_NOSIGNAL);
+    } while ((result==-1) && (errno==EINTR));
+
+    return static_cast<qint64>(result);
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(data)
+    Q_UNUSED(descriptor)
+
+    return -1;
+#endif
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::receiveDescriptor(
+        qintptr socket,
+        int timeout,
+        QByteArray &data,
+        int &descriptor ) -> qint64 {
+
+#if defined(Q_OS_LINUX)
+    struct pollfd pollDescriptor = {static_cast<int>(socket), POLLIN, 0};
+
+    if (poll(&pollDescriptor, 1, timeout)<=0) {
+        return -1;
+    }
+
+    char buffer[ReceiveBufferLength];
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct iovec vector = {buffer, sizeof(buffer)};
+    struct msghdr message = {};
+
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto result = ssize_t(0);
+
+    do {
+        result = recvmsg(static_cast<int>(socket), &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while ((result==-1) && (errno==EINTR));
+
+    if (result<=0) {
+        return -1;
+    }
+
+    data.append(buffer, static_cast<int>(result));
+
+    for (auto controlMessage = CMSG_FIRSTHDR(&message);
+         controlMessage;
+         controlMessage = CMSG_NXTHDR(&message, controlMessage)) {
+
+        if ((controlMessage->cmsg_level!=SOL_SOCKET) ||
+            (controlMessage->cmsg_type!=SCM_RIGHTS) ||
+            (controlMessage->cmsg_len!=CMSG_LEN(sizeof(int)))) {
+
+            continue;
+        }
+
+        // a second descriptor from a misbehaving peer is closed rather than leaked.
+
+        if (descriptor!=-1) {
+            ::close(descriptor);
+        }
+
+        memcpy(&descriptor, CMSG_DATA(controlMessage), sizeof(int));
+    }
+
+    return static_cast<qint64>(result);
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(timeout)
+    Q_UNUSED(data)
+    Q_UNUSED(descriptor)
+
+    return -1;
+#endif
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::write(
+        quint32 id,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> bool {
+
+    if (m_writeIndex-m_header->tail.load(std::memory_order_acquire)>m_mask) {
+        m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    auto &slot = m_slots[m_writeIndex & m_mask];
+    auto hostAddress = result.hostAddress();
+
+    slot.id = id;
+    slot.sampleNumber = static_cast<quint32>(result.sampleNumber());
+    slot.requestTimestamp = result.requestTimestamp();
+    slot.roundTripTime = result.preciseRoundTripTime();
+    slot.code = static_cast<quint8>(result.code());
+    slot.hops = static_cast<qint8>(result.hops());
+    slot.reserved = 0;
+
+    memset(slot.address, 0, sizeof(slot.address));
+
+    if (hostAddress.protocol()==QAbstractSocket::IPv4Protocol) {
+        auto address = qToBigEndian(hostAddress.toIPv4Address());
+
+        slot.family = IPv4AddressFamily;
+
+        memcpy(slot.address, &address, sizeof(address));
+    } else if (hostAddress.protocol()==QAbstractSocket::IPv6Protocol) {
+        auto address = hostAddress.toIPv6Address();
+
+        slot.family = IPv6AddressFamily;
+
+        memcpy(slot.address, address.c, sizeof(address.c));
+    } else {
+        slot.family = NullAddressFamily;
+    }
+
+    m_writeIndex++;
+
+    return true;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::publish() -> void {
+    if (m_header->head.load(std::memory_order_relaxed)==m_writeIndex) {
+        return;
+    }
+
+    m_header->head.store(m_writeIndex, std::memory_order_release);
+    m_header->sequence.fetch_add(1, std::memory_order_seq_cst);
+
+    // the system call is only made when the consumer has run out of results and gone to sleep.
+
+    if (m_header->waiting.load(std::memory_order_seq_cst)) {
+#if defined(Q_OS_LINUX)
+        futexWake(&m_header->sequence);
+#endif
+    }
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::wait(int timeout) -> bool {
+    auto sequence = m_header->sequence.load(std::memory_order_seq_cst);
+    auto tail = m_header->tail.load(std::memory_order_relaxed);
+
+    if (m_header->head.load(std::memory_order_acquire)!=tail) {
+        return true;
+    }
+
+    /**
+     * the producer advances the sequence after publishing, so if it publishes after the sequence was read the
+     * futex sees a different value and returns immediately rather than sleeping through the wakeup.
+     */
+
+    m_header->waiting.store(1, std::memory_order_seq_cst);
+
+    if (m_header->head.load(std::memory_order_acquire)==tail) {
+#if defined(Q_OS_LINUX)
+        futexWait(&m_header->sequence, sequence, timeout);
+#else
+        Q_UNUSED(sequence)
+        Q_UNUSED(timeout)
+#endif
+    }
+
+    m_header->waiting.store(0, std::memory_order_relaxed);
+
+    return m_header->head.load(std::memory_order_acquire)!=tail;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::wake() -> void {
+    m_header->sequence.fetch_add(1, std::memory_order_seq_cst);
+
+#if defined(Q_OS_LINUX)
+    futexWake(&m_header->sequence);
+#endif
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::consume(
+        const std::function<void(const Slot &)> &visitor ) -> int {
+
+    auto head = m_header->head.load(std::memory_order_acquire);
+    auto tail = m_header->tail.load(std::memory_order_relaxed);
+
+    // the producer cannot publish more than the capacity, anything else means the segment has been corrupted.
+
+    if (head-tail>m_mask+1) {
+        return 0;
+    }
+
+    for (auto index=tail;index!=head;index++) {
+        visitor(m_slots[index & m_mask]);
+    }
+
+    m_header->tail.store(head, std::memory_order_release);
+
+    return static_cast<int>(head-tail);
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::dropped() const -> quint32 {
+    return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::RemotePingEngine::SharedResultRing::hostAddress(const Slot &slot) -> QHostAddress {
+    if (slot.family==IPv4AddressFamily) {
+        quint32 address;
+
+        memcpy(&address, slot.address, sizeof(address));
+
+        return QHostAddress(qFromBigEndian(address));
+    }
+
+    if (slot.family==IPv6AddressFamily) {
+        Q_IPV6ADDR address;
+
+        memcpy(address.c, slot.address, sizeof(address.c));
+
+        return QHostAddress(address);
+    }
+
+    return QHostAddress();
+}
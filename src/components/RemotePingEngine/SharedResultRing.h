@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRESULTRING_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRESULTRING_H
+
+#include "RemotePingEngineSpec.h"
+
+#include <PingResult>
+#include <QByteArray>
+#include <QHostAddress>
+#include <atomic>
+#include <functional>
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    /**
+     * @brief       The SharedResultRing class is a single producer, single consumer ring of results held in a
+     *              shared memory segment.
+     *
+     * @details     When the ping agent runs on the same machine as its client the results do not need to cross a
+     *              socket, the agent creates an anonymous segment and passes its descriptor to the client over the
+     *              local socket.  The agent writes each result once into a fixed size slot and the client reads
+     *              the slots in place, there is no encoding, no copy through the kernel and no system call per
+     *              batch unless the client is asleep, in which case it is woken with a futex on a word in the
+     *              segment.
+     *
+     *              The segment is sealed against changes in size before either process maps it, a client cannot
+     *              shrink it underneath the agent (which would fault the agent on its next write).  The segment
+     *              has no name and disappears with the last of the two processes.  Shared memory rings are only
+     *              available on Linux, on other platforms create() and open() return nullptr and the results stay
+     *              on the socket.
+     */
+    class NEDRYSOFT_REMOTEPINGENGINE_DLLSPEC SharedResultRing {
+        public:
+            /**
+             * @brief       A result as stored in the ring.
+             *
+             * @details     The slot is plain data so that it has the same layout in both processes.
+             */
+            struct Slot {
+                quint32 id;                                             //! the id of the target.
+                quint32 sampleNumber;                                   //! the sample number of the result.
+                qint64 requestTimestamp;                                //! the request time in nanoseconds.
+                qint64 roundTripTime;                                   //! the round trip time in nanoseconds.
+                quint8 code;                                            //! the result code.
+                qint8 hops;                                             //! the number of hops to the target.
+                quint8 family;                                          //! 0 for a null address, 4 or 6.
+                quint8 reserved;                                        //! padding, always zero.
+                quint8 address[16];                                     //! the address that responded.
+            };
+
+        public:
+            /**
+             * @brief       Destroys the SharedResultRing, unmapping the segment and closing its descriptor.
+             */
+            ~SharedResultRing();
+
+            /**
+             * @brief       Creates a new sealed segment, used by the agent.
+             *
+             * @param[in]   capacity the number of slots, rounded up to a power of 2.
+             *
+             * @returns     the ring; otherwise nullptr if the segment could not be created or sealed.
+             */
+            static auto create(int capacity) -> SharedResultRing *;
+
+            /**
+             * @brief       Maps a segment received from the agent, used by the client.
+             *
+             * @details     The segment must be sealed against changes in size and its header is validated against
+             *              its size before it is used.
+             *
+             * @param[in]   descriptor the descriptor of the segment, the ring takes ownership of the descriptor.
+             *
+             * @returns     the ring; otherwise nullptr if the segment could not be mapped.
+             */
+            static auto open(int descriptor) -> SharedResultRing *;
+
+            /**
+             * @brief       Returns the descriptor of the segment, which the agent passes to the client.
+             *
+             * @returns     the descriptor; otherwise -1 once it has been closed.
+             */
+            auto descriptor() const -> int;
+
+            /**
+             * @brief       Closes the descriptor of the segment, the memory remains mapped.
+             */
+            auto closeDescriptor() -> void;
+
+            /**
+             * @brief       Writes data to a local socket with a descriptor attached to it.
+             *
+             * @details     The caller must have written everything it had buffered for the socket first, as the
+             *              data is written directly to the socket.
+             *
+             * @param[in]   socket the native descriptor of the local socket.
+             * @param[in]   data the data to write, the descriptor is attached to its first byte.
+             * @param[in]   descriptor the descriptor to pass.
+             *
+             * @returns     the number of bytes written; otherwise -1 on error.
+             */
+            static auto sendDescriptor(qintptr socket, const QByteArray &data, int descriptor) -> qint64;
+
+            /**
+             * @brief       Reads data from a local socket, taking any descriptor that was attached to it.
+             *
+             * @details     The data is appended to the buffer, the read waits for up to the timeout if no data is
+             *              available.
+             *
+             * @param[in]   socket the native descriptor of the local socket.
+             * @param[in]   timeout the maximum time to wait in milliseconds.
+             * @param[out]  data the buffer that the data is appended to.
+             * @param[out]  descriptor the descriptor that was received, left unchanged if there was none.
+             *
+             * @returns     the number of bytes read; otherwise -1 on error or if the timeout expired.
+             */
+            static auto receiveDescriptor(qintptr socket, int timeout, QByteArray &data, int &descriptor) -> qint64;
+
+            /**
+             * @brief       Writes a result into the next free slot, the result is not visible to the reader until
+             *              publish() is called.
+             *
+             * @note        Must only be called by the producer.
+             *
+             * @param[in]   id the id of the target.
+             * @param[in]   result the result.
+             *
+             * @returns     true if written; otherwise false if the ring is full.
+             */
+            auto write(quint32 id, const Nedrysoft::RouteAnalyser::PingResult &result) -> bool;
+
+            /**
+             * @brief       Makes the written results visible to the reader and wakes it if it is waiting.
+             *
+             * @note        Must only be called by the producer.
+             */
+            auto publish() -> void;
+
+            /**
+             * @brief       Waits until results are available to read.
+             *
+             * @note        Must only be called by the consumer.
+             *
+             * @param[in]   timeout the maximum time to wait in milliseconds.
+             *
+             * @returns     true if results are available; otherwise false.
+             */
+            auto wait(int timeout) -> bool;
+
+            /**
+             * @brief       Wakes a consumer that is waiting, used to stop the consumer.
+             */
+            auto wake() -> void;
+
+            /**
+             * @brief       Visits every published slot in place and then releases them to the producer.
+             *
+             * @note        Must only be called by the consumer, the slot must not be used after the visitor returns.
+             *
+             * @param[in]   visitor the function called for each slot.
+             *
+             * @returns     the number of slots visited.
+             */
+            auto consume(const std::function<void(const Slot &)> &visitor) -> int;
+
+            /**
+             * @brief       Returns the number of results the producer could not write because the ring was full.
+             *
+             * @returns     the number of results dropped.
+             */
+            auto dropped() const -> quint32;
+
+            /**
+             * @brief       Returns the address stored in a slot.
+             *
+             * @param[in]   slot the slot.
+             *
+             * @returns     the address.
+             */
+            static auto hostAddress(const Slot &slot) -> QHostAddress;
+
+        private:
+            //! @cond
+
+            struct Header;
+
+            //! @endcond
+
+            /**
+             * @brief       Constructs a SharedResultRing over a mapped segment.
+             *
+             * @param[in]   descriptor the descriptor of the segment.
+             * @param[in]   memory the mapped segment.
+             * @param[in]   length the length of the mapping.
+             */
+            SharedResultRing(int descriptor, void *memory, size_t length);
+
+        private:
+            //! @cond
+
+            int m_descriptor;
+            void *m_memory;
+            size_t m_length;
+
+            Header *m_header;
+            Slot *m_slots;
+            quint32 m_mask;
+            quint32 m_writeIndex;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRESULTRING_H
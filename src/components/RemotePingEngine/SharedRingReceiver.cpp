@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharedRingReceiver.h"
+
+constexpr auto WaitTimeout = 250;
+
+Nedrysoft::RemotePingEngine::SharedRingReceiver::SharedRingReceiver(
+        Nedrysoft::RemotePingEngine::SharedResultRing *ring,
+        QObject *parent ) :
+            QObject(parent),
+            m_ring(ring),
+            m_stopping(false) {
+
+    m_thread = std::thread(&SharedRingReceiver::run, this);
+}
+
+Nedrysoft::RemotePingEngine::SharedRingReceiver::~SharedRingReceiver() {
+    m_stopping = true;
+
+    m_ring->wake();
+    m_consumed.release();
+
+    m_thread.join();
+
+    delete m_ring;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedRingReceiver::ring() -> Nedrysoft::RemotePingEngine::SharedResultRing * {
+    return m_ring;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedRingReceiver::consume(
+        const std::function<void(const SharedResultRing::Slot &)> &visitor ) -> int {
+
+    auto count = m_ring->consume(visitor);
+
+    if (!m_consumed.available()) {
+        m_consumed.release();
+    }
+
+    return count;
+}
+
+auto Nedrysoft::RemotePingEngine::SharedRingReceiver::run() -> void {
+    while (!m_stopping) {
+        if (!m_ring->wait(WaitTimeout)) {
+            continue;
+        }
+
+        Q_EMIT resultsAvailable();
+
+        /**
+         * the results stay in the ring until the owner consumes them, waiting on the ring again before then
+         * would return straight away and flood the owner with notifications.
+         */
+
+        while ((!m_stopping) && (!m_consumed.tryAcquire(1, WaitTimeout))) {
+        }
+    }
+}
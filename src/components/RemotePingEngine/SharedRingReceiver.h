@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRINGRECEIVER_H
+#define PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRINGRECEIVER_H
+
+#include "SharedResultRing.h"
+
+#include <QObject>
+#include <QSemaphore>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace Nedrysoft { namespace RemotePingEngine {
+    /**
+     * @brief       The SharedRingReceiver class waits for results to be published into a SharedResultRing and
+     *              notifies the thread that owns it.
+     *
+     * @details     A thread sleeps on the ring's futex and emits resultsAvailable() when the agent publishes, the
+     *              owner then calls consume() on its own thread to read the slots in place.  Only one notification
+     *              is outstanding at a time, the thread does not wait on the ring again until the owner has
+     *              consumed the results it was told about.
+     */
+    class SharedRingReceiver :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a SharedRingReceiver and starts waiting for results.
+             *
+             * @param[in]   ring the ring, the receiver takes ownership of the ring.
+             * @param[in]   parent the owner of the receiver.
+             */
+            SharedRingReceiver(Nedrysoft::RemotePingEngine::SharedResultRing *ring, QObject *parent = nullptr);
+
+            /**
+             * @brief       Destroys the SharedRingReceiver, stopping the thread and releasing the ring.
+             */
+            ~SharedRingReceiver() override;
+
+            /**
+             * @brief       Returns the ring.
+             *
+             * @returns     the ring.
+             */
+            auto ring() -> Nedrysoft::RemotePingEngine::SharedResultRing *;
+
+            /**
+             * @brief       Visits the published results in place and allows the thread to wait for more.
+             *
+             * @param[in]   visitor the function called for each slot.
+             *
+             * @returns     the number of results visited.
+             */
+            auto consume(const std::function<void(const SharedResultRing::Slot &)> &visitor) -> int;
+
+            /**
+             * @brief       Signal emitted (from the receiver thread) when results are available to consume.
+             */
+            Q_SIGNAL void resultsAvailable();
+
+        private:
+            /**
+             * @brief       The body of the receiver thread.
+             */
+            auto run() -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RemotePingEngine::SharedResultRing *m_ring;
+            QSemaphore m_consumed;
+            std::atomic<bool> m_stopping;
+            std::thread m_thread;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_REMOTEPINGENGINE_SHAREDRINGRECEIVER_H
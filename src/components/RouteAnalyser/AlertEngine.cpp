@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AlertEngine.h"
+
+#include "LatencySettings.h"
+
+#include <Clock>
+#include <ISystemTrayIcon>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <spdlog/spdlog.h>
+
+Nedrysoft::RouteAnalyser::AlertEngine::AlertEngine() :
+        m_networkAccessManager(new QNetworkAccessManager(this)) {
+
+    m_clock.start();
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::alertRulesChanged,
+            this,
+            [=]() {
+                setRules(latencySettings->alertRules());
+                setWebhook(QUrl(latencySettings->alertWebhook()));
+            }
+        );
+
+        setRules(latencySettings->alertRules());
+        setWebhook(QUrl(latencySettings->alertWebhook()));
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::getInstance() -> Nedrysoft::RouteAnalyser::AlertEngine * {
+    static Nedrysoft::RouteAnalyser::AlertEngine instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::setRules(const QStringList &rules) -> void {
+    auto compiledRules = QVector<Nedrysoft::RouteAnalyser::AlertRule>();
+
+    for (auto &text : rules) {
+        auto rule = Nedrysoft::RouteAnalyser::AlertRule();
+        auto error = QString();
+
+        if (text.trimmed().isEmpty()) {
+            continue;
+        }
+
+        if (!Nedrysoft::RouteAnalyser::AlertRule::compile(text, rule, error)) {
+            SPDLOG_WARN(QString("Ignoring alert rule \"%1\", %2.").arg(text).arg(error).toStdString());
+
+            continue;
+        }
+
+        compiledRules.append(rule);
+    }
+
+    // the state is indexed by rule, so the alerts of the old rules are cleared before it is thrown away.
+
+    for (auto targetIterator=m_state.constBegin();targetIterator!=m_state.constEnd();targetIterator++) {
+        for (auto hopIterator=targetIterator->constBegin();hopIterator!=targetIterator->constEnd();hopIterator++) {
+            for (auto i=0;i<hopIterator->count();i++) {
+                if (hopIterator->at(i).active) {
+                    Q_EMIT alertCleared(targetIterator.key(), hopIterator.key(), m_rules[i].text());
+                }
+            }
+        }
+    }
+
+    m_state.clear();
+    m_rules = compiledRules;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::setWebhook(const QUrl &url) -> void {
+    m_webhook = url;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::setSystemTrayIcon(
+        Nedrysoft::Core::ISystemTrayIcon *systemTrayIcon ) -> void {
+
+    m_systemTrayIcon = systemTrayIcon;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::evaluate(
+        const QString &target,
+        int hop,
+        bool destination,
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    if (m_rules.isEmpty()) {
+        return;
+    }
+
+    auto &states = m_state[target][hop];
+
+    if (states.isEmpty()) {
+        states.reserve(m_rules.count());
+
+        for (auto &rule : m_rules) {
+            states.append(RuleState{-1, false, Nedrysoft::RouteAnalyser::AlertRule::Window(rule.windowSize())});
+        }
+    }
+
+    auto now = m_clock.elapsed();
+
+    for (auto i=0;i<m_rules.count();i++) {
+        auto &rule = m_rules[i];
+        auto &state = states[i];
+
+        if (!rule.appliesTo(hop, destination)) {
+            continue;
+        }
+
+        if (rule.windowSize()) {
+            rule.addSamples(state.window, results);
+        }
+
+        auto value = rule.value(statistics, state.window);
+
+        if (!state.active) {
+            if (!rule.breached(value)) {
+                state.since = -1;
+
+                continue;
+            }
+
+            if (state.since<0) {
+                state.since = now;
+            }
+
+            if ((now-state.since)>=rule.holdTime()) {
+                state.active = true;
+
+                notify(rule, target, hop, true, rule.formatValue(value));
+            }
+        } else if (rule.recovered(value)) {
+            state.active = false;
+            state.since = -1;
+
+            notify(rule, target, hop, false, rule.formatValue(value));
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::removeTarget(const QString &target) -> void {
+    auto hops = m_state.take(target);
+
+    for (auto hopIterator=hops.constBegin();hopIterator!=hops.constEnd();hopIterator++) {
+        for (auto i=0;i<hopIterator->count();i++) {
+            if (hopIterator->at(i).active) {
+                Q_EMIT alertCleared(target, hopIterator.key(), m_rules[i].text());
+            }
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::AlertEngine::notify(
+        const Nedrysoft::RouteAnalyser::AlertRule &rule,
+        const QString &target,
+        int hop,
+        bool raised,
+        const QString &value ) -> void {
+
+    auto title = raised ? tr("Alert raised for %1").arg(target) : tr("Alert cleared for %1").arg(target);
+    auto message = tr("%1 at hop %2 (%3)").arg(rule.text()).arg(hop).arg(value);
+
+    if (rule.actions() & Nedrysoft::RouteAnalyser::AlertRule::Log) {
+        if (raised) {
+            SPDLOG_WARN(QString("%1, %2.").arg(title).arg(message).toStdString());
+        } else {
+            SPDLOG_INFO(QString("%1, %2.").arg(title).arg(message).toStdString());
+        }
+    }
+
+    if ((rule.actions() & Nedrysoft::RouteAnalyser::AlertRule::Tray) && (m_systemTrayIcon)) {
+        m_systemTrayIcon->showMessage(title, message);
+    }
+
+    if ((rule.actions() & Nedrysoft::RouteAnalyser::AlertRule::Webhook) && (m_webhook.isValid())) {
+        auto payload = QJsonObject();
+
+        payload.insert("state", raised ? "raised" : "cleared");
+        payload.insert("target", target);
+        payload.insert("hop", hop);
+        payload.insert("rule", rule.text());
+        payload.insert("value", value);
+        payload.insert("time", Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc().toString(Qt::ISODate));
+
+        auto request = QNetworkRequest(m_webhook);
+
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+        auto reply = m_networkAccessManager->post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+
+        connect(reply, &QNetworkReply::finished, reply, [=]() {
+            if (reply->error()!=QNetworkReply::NoError) {
+                SPDLOG_WARN(QString("Unable to post the alert to %1, %2.")
+                        .arg(m_webhook.toString())
+                        .arg(reply->errorString()).toStdString());
+            }
+
+            reply->deleteLater();
+        });
+    }
+
+    if (raised) {
+        Q_EMIT alertRaised(target, hop, rule.text(), value);
+    } else {
+        Q_EMIT alertCleared(target, hop, rule.text());
+    }
+}
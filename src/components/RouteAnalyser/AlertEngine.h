@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTENGINE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTENGINE_H
+
+#include "AlertRule.h"
+#include "RouteAnalyserSpec.h"
+
+#include <ElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+class QNetworkAccessManager;
+
+namespace Nedrysoft { namespace Core {
+    class ISystemTrayIcon;
+}}
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The AlertEngine class evaluates the alert rules against the statistics of every hop.
+     *
+     * @details     The rules are compiled once when they are set, the engine is then called with the statistics of
+     *              a hop on every snapshot tick.  Each rule reads the incrementally maintained statistics of the hop
+     *              (or keeps its own fixed size window of samples) so the cost of a tick is proportional to the
+     *              number of rules and the history of the hop is never scanned again.
+     *
+     *              A rule must be breached continuously for its hold time before the alert is raised, and it is
+     *              only cleared once the value has moved back past the threshold by the hysteresis band of the rule
+     *              so that a value hovering around the threshold does not repeatedly raise the alert.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC AlertEngine :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs a new AlertEngine.
+             */
+            AlertEngine();
+
+        public:
+            /**
+             * @brief       Returns the AlertEngine instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> AlertEngine *;
+
+            /**
+             * @brief       Compiles and sets the rules, any alerts that are raised are cleared.
+             *
+             * @details     Rules that cannot be compiled are logged and ignored.
+             *
+             * @param[in]   rules the rule texts.
+             */
+            auto setRules(const QStringList &rules) -> void;
+
+            /**
+             * @brief       Sets the URL that alerts with the webhook action are posted to.
+             *
+             * @param[in]   url the URL; an empty URL disables the webhook.
+             */
+            auto setWebhook(const QUrl &url) -> void;
+
+            /**
+             * @brief       Sets the system tray icon that alerts with the tray action are shown from.
+             *
+             * @param[in]   systemTrayIcon the system tray icon.
+             */
+            auto setSystemTrayIcon(Nedrysoft::Core::ISystemTrayIcon *systemTrayIcon) -> void;
+
+            /**
+             * @brief       Evaluates the rules against the statistics of a hop.
+             *
+             * @param[in]   target the name of the target.
+             * @param[in]   hop the hop number, starting at 1.
+             * @param[in]   destination true if the hop is the destination; otherwise false.
+             * @param[in]   statistics the statistics of the hop.
+             * @param[in]   results the results that have been added to the statistics since the last tick.
+             */
+            auto evaluate(
+                    const QString &target,
+                    int hop,
+                    bool destination,
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void;
+
+            /**
+             * @brief       Forgets the state of every rule for a target, any raised alerts are cleared.
+             *
+             * @param[in]   target the name of the target.
+             */
+            auto removeTarget(const QString &target) -> void;
+
+            /**
+             * @brief       This signal is emitted when an alert is raised.
+             *
+             * @param[in]   target the name of the target.
+             * @param[in]   hop the hop number.
+             * @param[in]   rule the text of the rule.
+             * @param[in]   value the formatted value that breached the rule.
+             */
+            Q_SIGNAL void alertRaised(const QString &target, int hop, const QString &rule, const QString &value);
+
+            /**
+             * @brief       This signal is emitted when an alert is cleared.
+             *
+             * @param[in]   target the name of the target.
+             * @param[in]   hop the hop number.
+             * @param[in]   rule the text of the rule.
+             */
+            Q_SIGNAL void alertCleared(const QString &target, int hop, const QString &rule);
+
+        private:
+            /**
+             * @brief       The state of a single rule for a single hop.
+             */
+            struct RuleState {
+                qint64 since;                                           //!< when the breach started; -1 if none.
+                bool active;                                            //!< true if the alert is raised.
+                Nedrysoft::RouteAnalyser::AlertRule::Window window;     //!< the samples of a windowed rule.
+            };
+
+            /**
+             * @brief       Raises or clears an alert through the actions of its rule.
+             *
+             * @param[in]   rule the rule.
+             * @param[in]   target the name of the target.
+             * @param[in]   hop the hop number.
+             * @param[in]   raised true if the alert was raised; false if cleared.
+             * @param[in]   value the formatted value.
+             */
+            auto notify(
+                    const Nedrysoft::RouteAnalyser::AlertRule &rule,
+                    const QString &target,
+                    int hop,
+                    bool raised,
+                    const QString &value ) -> void;
+
+        private:
+            //! @cond
+
+            QVector<Nedrysoft::RouteAnalyser::AlertRule> m_rules;
+            QHash<QString, QHash<int, QVector<RuleState> > > m_state;
+            Nedrysoft::Core::ElapsedTimer m_clock;
+            QUrl m_webhook;
+            QNetworkAccessManager *m_networkAccessManager;
+            QPointer<Nedrysoft::Core::ISystemTrayIcon> m_systemTrayIcon;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTENGINE_H
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AlertRule.h"
+
+#include <QObject>
+#include <QRegularExpression>
+#include <QStringList>
+
+constexpr auto HysteresisBand = 0.1;
+constexpr auto MaximumWindowSize = 100000;
+constexpr auto LostSample = 100.0;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto MicrosecondsInSecond = 1000000.0;
+constexpr auto MillisecondsInMinute = 60000.0;
+constexpr auto MillisecondsInHour = 3600000.0;
+
+/**
+ * the clauses of a rule must appear in the documented order, every clause after the threshold is optional.
+ */
+
+constexpr auto RulePattern =
+        "^\\s*(?<metric>latency|rtt|mean|avg|min|max|jitter|loss|p(?<quantile>\\d{1,2}(\\.\\d+)?))"
+        "\\s*(?<comparison>>=|<=|>|<)"
+        "\\s*(?<threshold>\\d+(\\.\\d+)?)\\s*(?<unit>us|ms|s|%)?"
+        "(\\s+over\\s+(?<samples>\\d+)\\s+samples?)?"
+        "(\\s+for\\s+(?<duration>\\d+(\\.\\d+)?)\\s*(?<durationUnit>ms|s|m|min|h))?"
+        "(\\s+at\\s+(?<scope>destination|any\\s+hop|hop\\s+(?<hop>\\d+)))?"
+        "(\\s*->\\s*(?<actions>[a-z]+(\\s*,\\s*[a-z]+)*))?\\s*$";
+
+Nedrysoft::RouteAnalyser::AlertRule::Window::Window(int size) :
+        m_values(size, 0),
+        m_next(0),
+        m_count(0),
+        m_sum(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::Window::add(double value) -> void {
+    if (m_values.isEmpty()) {
+        return;
+    }
+
+    if (m_count==m_values.count()) {
+        m_sum -= m_values[m_next];
+    } else {
+        m_count++;
+    }
+
+    m_values[m_next] = value;
+    m_sum += value;
+
+    m_next = (m_next+1)%m_values.count();
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::Window::count() const -> int {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::Window::mean() const -> double {
+    if (!m_count) {
+        return -1;
+    }
+
+    return m_sum/m_count;
+}
+
+Nedrysoft::RouteAnalyser::AlertRule::AlertRule() :
+        m_metric(Metric::Latency),
+        m_quantile(0),
+        m_greater(true),
+        m_threshold(-1),
+        m_windowSize(0),
+        m_holdTime(0),
+        m_scope(Scope::Destination),
+        m_hop(0),
+        m_actions(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::compile(const QString &text, AlertRule &rule, QString &error) -> bool {
+    static const auto expression = QRegularExpression(RulePattern, QRegularExpression::CaseInsensitiveOption);
+
+    auto match = expression.match(text);
+
+    if (!match.hasMatch()) {
+        error = QObject::tr("the rule could not be parsed");
+
+        return false;
+    }
+
+    auto compiled = AlertRule();
+    auto metric = match.captured("metric").toLower();
+    auto unit = match.captured("unit").toLower();
+
+    compiled.m_text = text.trimmed();
+
+    if ((metric=="latency") || (metric=="rtt")) {
+        compiled.m_metric = Metric::Latency;
+    } else if ((metric=="mean") || (metric=="avg")) {
+        compiled.m_metric = Metric::Mean;
+    } else if (metric=="min") {
+        compiled.m_metric = Metric::Minimum;
+    } else if (metric=="max") {
+        compiled.m_metric = Metric::Maximum;
+    } else if (metric=="jitter") {
+        compiled.m_metric = Metric::Jitter;
+    } else if (metric=="loss") {
+        compiled.m_metric = Metric::Loss;
+    } else {
+        compiled.m_metric = Metric::Percentile;
+        compiled.m_quantile = match.captured("quantile").toDouble()/100.0;
+
+        if ((compiled.m_quantile<=0) || (compiled.m_quantile>=1)) {
+            error = QObject::tr("the percentile must be between 0 and 100");
+
+            return false;
+        }
+    }
+
+    // thresholds are held in the units of the statistics, seconds for latencies and a percentage for loss.
+
+    compiled.m_threshold = match.captured("threshold").toDouble();
+
+    if (compiled.m_metric==Metric::Loss) {
+        if ((!unit.isEmpty()) && (unit!="%")) {
+            error = QObject::tr("loss is a percentage");
+
+            return false;
+        }
+    } else if (unit=="%") {
+        error = QObject::tr("only loss is a percentage");
+
+        return false;
+    } else if (unit=="s") {
+        // already in seconds.
+    } else if (unit=="us") {
+        compiled.m_threshold /= MicrosecondsInSecond;
+    } else {
+        compiled.m_threshold /= MillisecondsInSecond;
+    }
+
+    compiled.m_greater = match.captured("comparison").startsWith('>');
+
+    if (!match.captured("samples").isEmpty()) {
+        compiled.m_windowSize = match.captured("samples").toInt();
+
+        if ((compiled.m_metric!=Metric::Loss) && (compiled.m_metric!=Metric::Mean)) {
+            error = QObject::tr("only loss and mean can be taken over a number of samples");
+
+            return false;
+        }
+
+        if ((compiled.m_windowSize<1) || (compiled.m_windowSize>MaximumWindowSize)) {
+            error = QObject::tr("the number of samples must be between 1 and %1").arg(MaximumWindowSize);
+
+            return false;
+        }
+    }
+
+    if (!match.captured("duration").isEmpty()) {
+        auto duration = match.captured("duration").toDouble();
+        auto durationUnit = match.captured("durationUnit").toLower();
+
+        if (durationUnit=="s") {
+            duration *= MillisecondsInSecond;
+        } else if ((durationUnit=="m") || (durationUnit=="min")) {
+            duration *= MillisecondsInMinute;
+        } else if (durationUnit=="h") {
+            duration *= MillisecondsInHour;
+        }
+
+        compiled.m_holdTime = static_cast<qint64>(duration);
+    }
+
+    auto scope = match.captured("scope").toLower();
+
+    if (scope.startsWith("any")) {
+        compiled.m_scope = Scope::AnyHop;
+    } else if (scope.startsWith("hop")) {
+        compiled.m_scope = Scope::Hop;
+        compiled.m_hop = match.captured("hop").toInt();
+    }
+
+    for (auto &action : match.captured("actions").toLower().split(',')) {
+        action = action.trimmed();
+
+        if (action.isEmpty()) {
+            continue;
+        }
+
+        if (action=="tray") {
+            compiled.m_actions |= Tray;
+        } else if (action=="webhook") {
+            compiled.m_actions |= Webhook;
+        } else if (action=="log") {
+            compiled.m_actions |= Log;
+        } else {
+            error = QObject::tr("unknown action \"%1\"").arg(action);
+
+            return false;
+        }
+    }
+
+    if (!compiled.m_actions) {
+        compiled.m_actions = Log;
+    }
+
+    rule = compiled;
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::text() const -> QString {
+    return m_text;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::appliesTo(int hop, bool destination) const -> bool {
+    switch (m_scope) {
+        case Scope::AnyHop: {
+            return true;
+        }
+
+        case Scope::Hop: {
+            return hop==m_hop;
+        }
+
+        default: {
+            return destination;
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::windowSize() const -> int {
+    return m_windowSize;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::addSamples(
+        Window &window,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) const -> void {
+
+    for (auto &result : results) {
+        auto lost = Nedrysoft::RouteAnalyser::PingResult::isLost(result.code());
+
+        if (m_metric==Metric::Loss) {
+            window.add(lost ? LostSample : 0);
+        } else if (!lost) {
+            window.add(result.roundTripTime());
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::value(
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const Window &window ) const -> double {
+
+    if (m_windowSize) {
+        /**
+         * a windowed rule waits until its window is full, otherwise the first few samples of a hop could raise an
+         * alert on their own.
+         */
+
+        if (window.count()<m_windowSize) {
+            return -1;
+        }
+
+        return window.mean();
+    }
+
+    if ((m_metric!=Metric::Loss) && (!statistics.replyCount())) {
+        return -1;
+    }
+
+    switch (m_metric) {
+        case Metric::Latency: {
+            return statistics.currentLatency();
+        }
+
+        case Metric::Mean: {
+            return statistics.latencyStatistics().mean();
+        }
+
+        case Metric::Minimum: {
+            return statistics.minimumLatency();
+        }
+
+        case Metric::Maximum: {
+            return statistics.maximumLatency();
+        }
+
+        case Metric::Percentile: {
+            return statistics.latencySketch().quantile(m_quantile);
+        }
+
+        case Metric::Jitter: {
+            return statistics.jitterStatistics().jitter();
+        }
+
+        case Metric::Loss: {
+            return statistics.lossStatistics().shortWindowLoss();
+        }
+    }
+
+    return -1;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::breached(double value) const -> bool {
+    if (value<0) {
+        return false;
+    }
+
+    return m_greater ? (value>m_threshold) : (value<m_threshold);
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::recovered(double value) const -> bool {
+    if (value<0) {
+        return false;
+    }
+
+    return m_greater ? (value<=m_threshold*(1.0-HysteresisBand)) : (value>=m_threshold*(1.0+HysteresisBand));
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::holdTime() const -> qint64 {
+    return m_holdTime;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::actions() const -> int {
+    return m_actions;
+}
+
+auto Nedrysoft::RouteAnalyser::AlertRule::formatValue(double value) const -> QString {
+    if (m_metric==Metric::Loss) {
+        return QString("%1%").arg(value, 0, 'f', 1);
+    }
+
+    return QString("%1ms").arg(value*MillisecondsInSecond, 0, 'f', 1);
+}
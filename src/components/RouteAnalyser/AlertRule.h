@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTRULE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTRULE_H
+
+#include "HopStatistics.h"
+#include "PingResult.h"
+
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The AlertRule class is a compiled alert condition over the statistics of a hop.
+     *
+     * @details     A rule is written as:
+     *
+     *                  <metric> <comparison> <threshold>[unit] [over <n> samples] [for <duration>]
+     *                  [at hop <n> | at any hop | at destination] [-> <action>[,<action>...]]
+     *
+     *              for example "p95 > 80ms for 2m" or "loss > 5% over 100 samples -> tray,webhook".
+     *
+     *              The metric is one of latency, mean, min, max, jitter, loss or a percentile such as p95.
+     *              Latencies are in milliseconds unless a unit (us, ms or s) is given and loss is a percentage.
+     *              Without a sample window the metric is read from the aggregates the statistics engine already
+     *              keeps (loss is then the short window loss), with one the rule keeps a ring of the last n
+     *              samples of each hop, only loss and mean can be windowed.  The actions are tray, webhook and
+     *              log, a rule without actions is logged.  Rules apply to the destination unless another hop is
+     *              given.
+     *
+     *              Compiling a rule resolves the metric and its units once, so checking a rule is a comparison
+     *              of a value that the statistics already hold.
+     */
+    class AlertRule {
+        public:
+            /**
+             * @brief       The statistic that a rule compares.
+             */
+            enum class Metric {
+                Latency,
+                Mean,
+                Minimum,
+                Maximum,
+                Percentile,
+                Jitter,
+                Loss
+            };
+
+            /**
+             * @brief       The hops that a rule applies to.
+             */
+            enum class Scope {
+                Destination,
+                AnyHop,
+                Hop
+            };
+
+            /**
+             * @brief       The actions taken when a rule raises or clears an alert.
+             */
+            enum Action {
+                Tray = 0x01,
+                Webhook = 0x02,
+                Log = 0x04
+            };
+
+            /**
+             * @brief       The samples of a hop that a windowed rule is evaluated over.
+             */
+            class Window {
+                public:
+                    /**
+                     * @brief       Constructs a Window.
+                     *
+                     * @param[in]   size the number of samples held.
+                     */
+                    explicit Window(int size = 0);
+
+                    /**
+                     * @brief       Adds a sample, replacing the oldest once the window is full.
+                     *
+                     * @param[in]   value the value of the sample.
+                     */
+                    auto add(double value) -> void;
+
+                    /**
+                     * @brief       Returns the number of samples held.
+                     *
+                     * @returns     the number of samples.
+                     */
+                    auto count() const -> int;
+
+                    /**
+                     * @brief       Returns the mean of the samples held.
+                     *
+                     * @returns     the mean; otherwise -1 if the window is empty.
+                     */
+                    auto mean() const -> double;
+
+                private:
+                    //! @cond
+
+                    QVector<double> m_values;
+                    int m_next;
+                    int m_count;
+                    double m_sum;
+
+                    //! @endcond
+            };
+
+        public:
+            /**
+             * @brief       Constructs an empty AlertRule, an empty rule never raises an alert.
+             */
+            AlertRule();
+
+            /**
+             * @brief       Compiles a rule from its text.
+             *
+             * @param[in]   text the text of the rule.
+             * @param[out]  rule the compiled rule.
+             * @param[out]  error the reason the rule could not be compiled.
+             *
+             * @returns     true if compiled; otherwise false.
+             */
+            static auto compile(const QString &text, AlertRule &rule, QString &error) -> bool;
+
+            /**
+             * @brief       Returns the text the rule was compiled from.
+             *
+             * @returns     the text.
+             */
+            auto text() const -> QString;
+
+            /**
+             * @brief       Returns whether the rule applies to a hop.
+             *
+             * @param[in]   hop the hop number.
+             * @param[in]   destination true if the hop is the destination; otherwise false.
+             *
+             * @returns     true if the rule applies; otherwise false.
+             */
+            auto appliesTo(int hop, bool destination) const -> bool;
+
+            /**
+             * @brief       Returns the size of the sample window.
+             *
+             * @returns     the number of samples; otherwise 0 if the rule is not windowed.
+             */
+            auto windowSize() const -> int;
+
+            /**
+             * @brief       Adds the samples of a batch of results to a window of this rule.
+             *
+             * @param[in,out]   window the window.
+             * @param[in]       results the results.
+             */
+            auto addSamples(Window &window, const QVector<Nedrysoft::RouteAnalyser::PingResult> &results) const -> void;
+
+            /**
+             * @brief       Returns the value of the metric.
+             *
+             * @param[in]   statistics the aggregates of the hop.
+             * @param[in]   window the sample window of the hop, only used by windowed rules.
+             *
+             * @returns     the value in the units of the rule; otherwise a negative value if there is no value yet.
+             */
+            auto value(const Nedrysoft::RouteAnalyser::HopStatistics &statistics, const Window &window) const -> double;
+
+            /**
+             * @brief       Returns whether a value breaches the threshold.
+             *
+             * @param[in]   value the value.
+             *
+             * @returns     true if breached; otherwise false.
+             */
+            auto breached(double value) const -> bool;
+
+            /**
+             * @brief       Returns whether a value is far enough back from the threshold to clear an alert.
+             *
+             * @details     The clear threshold is set back from the raise threshold by the hysteresis band, so a
+             *              value that hovers around the threshold does not raise and clear repeatedly.
+             *
+             * @param[in]   value the value.
+             *
+             * @returns     true if recovered; otherwise false.
+             */
+            auto recovered(double value) const -> bool;
+
+            /**
+             * @brief       Returns the time a condition must hold before the alert is raised or cleared.
+             *
+             * @returns     the time in milliseconds.
+             */
+            auto holdTime() const -> qint64;
+
+            /**
+             * @brief       Returns the actions taken by the rule.
+             *
+             * @returns     the actions as a combination of Action flags.
+             */
+            auto actions() const -> int;
+
+            /**
+             * @brief       Formats a value of the metric for display.
+             *
+             * @param[in]   value the value.
+             *
+             * @returns     the formatted value.
+             */
+            auto formatValue(double value) const -> QString;
+
+        private:
+            //! @cond
+
+            QString m_text;
+            Metric m_metric;
+            double m_quantile;
+            bool m_greater;
+            double m_threshold;
+            int m_windowSize;
+            qint64 m_holdTime;
+            Scope m_scope;
+            int m_hop;
+            int m_actions;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ALERTRULE_H
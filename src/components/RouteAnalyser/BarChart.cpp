@@ -23,11 +23,65 @@
 
 #include "BarChart.h"
 
+#include <algorithm>
+
 constexpr auto RoundedRectangleRadius = 10;
+constexpr auto DefaultMergeInterval = 1.5;
 
 Nedrysoft::RouteAnalyser::BarChart::BarChart(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-        QCPBars(keyAxis, valueAxis) {
+        QCPBars(keyAxis, valueAxis),
+        m_mergeInterval(DefaultMergeInterval),
+        m_spanOpen(false) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::addLoss(double key) -> void {
+    auto halfWidth = width()/2;
+
+    if ((m_spanOpen) && (!m_spans.isEmpty()) && (key-m_spans.last().lastLoss<=m_mergeInterval)) {
+        auto &span = m_spans.last();
+
+        span.end = std::max(span.end, key+halfWidth);
+        span.lastLoss = key;
+
+        return;
+    }
+
+    m_spans.append(Span{key-halfWidth, key+halfWidth, key});
 
+    m_spanOpen = true;
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::endSpan() -> void {
+    m_spanOpen = false;
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::setMergeInterval(double interval) -> void {
+    m_mergeInterval = interval;
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::removeBefore(double key) -> void {
+    auto first = 0;
+
+    while ((first<m_spans.count()) && (m_spans.at(first).end<key)) {
+        first++;
+    }
+
+    m_spans.remove(0, first);
+
+    if ((!m_spans.isEmpty()) && (m_spans.first().start<key)) {
+        m_spans.first().start = key;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::clear() -> void {
+    m_spans.clear();
+
+    m_spanOpen = false;
+}
+
+auto Nedrysoft::RouteAnalyser::BarChart::spans() const -> const QVector<Span> & {
+    return m_spans;
 }
 
 void Nedrysoft::RouteAnalyser::BarChart::draw(QCPPainter *painter) {
@@ -41,7 +95,30 @@ void Nedrysoft::RouteAnalyser::BarChart::draw(QCPPainter *painter) {
     painter->save();
     painter->setClipPath(clippingPath);
 
-    QCPBars::draw(painter);
+    /**
+     * only the spans that overlap the visible key range are drawn, the spans are sorted so the first is found by
+     * binary search.
+     */
+
+    auto keyRange = keyAxis()->range();
+    auto top = valueAxis()->coordToPixel(valueAxis()->range().upper);
+    auto bottom = valueAxis()->coordToPixel(0);
+
+    auto span = std::lower_bound(m_spans.cbegin(), m_spans.cend(), keyRange.lower, [](const Span &span, double key) {
+        return span.end<key;
+    });
+
+    applyDefaultAntialiasingHint(painter);
+
+    painter->setPen(pen());
+    painter->setBrush(brush());
+
+    for (;(span!=m_spans.cend()) && (span->start<=keyRange.upper);span++) {
+        auto left = keyAxis()->coordToPixel(span->start);
+        auto right = keyAxis()->coordToPixel(span->end);
+
+        painter->drawRect(QRectF(QPointF(left, top), QPointF(right, bottom)).normalized());
+    }
 
     painter->restore();
-}
\ No newline at end of file
+}
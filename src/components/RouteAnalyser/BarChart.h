@@ -33,11 +33,28 @@
 
 namespace Nedrysoft { namespace RouteAnalyser {
     /**
-     * @brief       The BarChart class is a subclass of QCPBars which clips the chart to a rounded rectangle.
+     * @brief       The BarChart class is a subclass of QCPBars which draws runs of lost packets.
+     *
+     * @details     Consecutive losses are merged into a single span as they are added, so an outage is stored and
+     *              drawn as one rectangle rather than a bar per request, the memory and drawing cost depend on the
+     *              number of loss episodes rather than the number of lost packets.  The spans cover the full height
+     *              of the value axis and the chart is clipped to a rounded rectangle.
+     *
+     *              The data container of QCPBars is not used, the bar width sets the width of an isolated loss.
      */
     class BarChart :
             public QCPBars {
 
+        public:
+            /**
+             * @brief       A run of consecutive losses.
+             */
+            struct Span {
+                double start;                       //! the start of the span in plot coordinates.
+                double end;                         //! the end of the span in plot coordinates.
+                double lastLoss;                    //! the key of the last loss added to the span.
+            };
+
         public:
             /**
              * @brief       Constructs a new BarChart and attaches it to the given axis.
@@ -49,6 +66,47 @@ namespace Nedrysoft { namespace RouteAnalyser {
             // Classes with virtual functions should not have a public non-virtual destructor:
             virtual ~BarChart() = default;
 
+            /**
+             * @brief       Adds a loss to the chart.
+             *
+             * @details     The loss extends the current span if the span has not been ended and the loss follows
+             *              the previous one within the merge interval; otherwise it starts a new span.
+             *
+             * @param[in]   key the time of the loss.
+             */
+            auto addLoss(double key) -> void;
+
+            /**
+             * @brief       Ends the current span, the next loss starts a new span.
+             */
+            auto endSpan() -> void;
+
+            /**
+             * @brief       Sets the largest gap between two losses that are merged into the same span.
+             *
+             * @param[in]   interval the interval in plot coordinates.
+             */
+            auto setMergeInterval(double interval) -> void;
+
+            /**
+             * @brief       Removes the spans (or the parts of them) before the given key.
+             *
+             * @param[in]   key the key.
+             */
+            auto removeBefore(double key) -> void;
+
+            /**
+             * @brief       Removes all spans.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the spans.
+             *
+             * @returns     the spans in key order.
+             */
+            auto spans() const -> const QVector<Span> &;
+
         protected:
             /**
              * @brief       Draws the bar chart to the given painter.
@@ -56,6 +114,15 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @param[in]   painter the QPainter to draw in.
              */
             virtual void draw(QCPPainter *painter);
+
+        private:
+            //! @cond
+
+            QVector<Span> m_spans;
+            double m_mergeInterval;
+            bool m_spanOpen;
+
+            //! @endcond
     };
 }}
 
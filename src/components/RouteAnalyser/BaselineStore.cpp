@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BaselineStore.h"
+
+#include <IConfigurationStore>
+#include <ICore>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+
+constexpr auto ConfigurationPath = "Nedrysoft/Pingnoo/Components/RouteAnalyser";
+constexpr auto ConfigurationFilename = "Baselines.dat";
+constexpr auto FileMagic = quint32(0x504e424c);
+constexpr auto FileVersion = quint32(1);
+constexpr auto SaveInterval = 5*60*1000;
+constexpr auto KeySeparator = '\n';
+
+Nedrysoft::RouteAnalyser::BaselineStore::BaselineStore() :
+        m_saveTimer(new QTimer(this)),
+        m_loaded(false),
+        m_changed(false) {
+
+    m_saveTimer->setSingleShot(true);
+
+    connect(m_saveTimer, &QTimer::timeout, this, [this]() {
+        save();
+    });
+}
+
+Nedrysoft::RouteAnalyser::BaselineStore::~BaselineStore() {
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::getInstance() -> Nedrysoft::RouteAnalyser::BaselineStore * {
+    static Nedrysoft::RouteAnalyser::BaselineStore instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::baseline(
+        const QString &target,
+        const QHostAddress &address ) -> Nedrysoft::RouteAnalyser::HopBaseline * {
+
+    if (!m_loaded) {
+        load();
+    }
+
+    auto &baseline = m_baselines[target.toLower()+KeySeparator+address.toString()];
+
+    if (!baseline) {
+        baseline = std::make_shared<Nedrysoft::RouteAnalyser::HopBaseline>();
+    }
+
+    return baseline.get();
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::setChanged() -> void {
+    m_changed = true;
+
+    /**
+     * the samples are already in memory, the file only needs to catch up every few minutes so that an unexpected
+     * exit loses little.
+     */
+
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start(SaveInterval);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::filePath() -> QString {
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+
+    return QDir::cleanPath(QString("%1/%2/%3")
+            .arg(storageFolder)
+            .arg(ConfigurationPath)
+            .arg(ConfigurationFilename) );
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::load() -> void {
+    m_loaded = true;
+
+    QFile databaseFile(filePath());
+
+    if (!databaseFile.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&databaseFile);
+
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    auto magic = quint32(0);
+    auto version = quint32(0);
+    auto count = quint32(0);
+
+    stream >> magic >> version >> count;
+
+    if ((stream.status()!=QDataStream::Ok) || (magic!=FileMagic) || (version!=FileVersion)) {
+        SPDLOG_WARN(QString("Unable to read %1, the baselines will be rebuilt.").arg(filePath()).toStdString());
+
+        return;
+    }
+
+    for (auto index=quint32(0); index<count; index++) {
+        auto key = QString();
+        auto baseline = std::make_shared<Nedrysoft::RouteAnalyser::HopBaseline>();
+
+        stream >> key;
+
+        if ((stream.status()!=QDataStream::Ok) || (!baseline->load(stream))) {
+            SPDLOG_WARN(QString("Unable to read %1, the baselines will be rebuilt.").arg(filePath()).toStdString());
+
+            m_baselines.clear();
+
+            return;
+        }
+
+        m_baselines.insert(key, baseline);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::BaselineStore::save() -> void {
+    if (!m_changed) {
+        return;
+    }
+
+    m_changed = false;
+
+    m_saveTimer->stop();
+
+    auto data = QByteArray();
+    QBuffer buffer(&data);
+
+    buffer.open(QBuffer::WriteOnly);
+
+    QDataStream stream(&buffer);
+
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    auto count = quint32(0);
+
+    for (const auto &baseline : m_baselines) {
+        if (!baseline->isEmpty()) {
+            count++;
+        }
+    }
+
+    stream << FileMagic << FileVersion << count;
+
+    for (auto baseline=m_baselines.constBegin(); baseline!=m_baselines.constEnd(); baseline++) {
+        if (!baseline.value()->isEmpty()) {
+            stream << baseline.key();
+
+            baseline.value()->save(stream);
+        }
+    }
+
+    buffer.close();
+
+    Nedrysoft::Core::IConfigurationStore::getInstance()->saveData(filePath(), data);
+}
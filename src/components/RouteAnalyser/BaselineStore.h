@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_BASELINESTORE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_BASELINESTORE_H
+
+#include "HopBaseline.h"
+
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The BaselineStore class holds the usual latency of every hop that has been monitored.
+     *
+     * @details     Baselines are keyed by the target and the address of the hop, so a router that appears on the
+     *              routes to several targets has a baseline for each of them.  A baseline is looked up once when
+     *              a hop is discovered and the editor then adds its samples directly, the store only needs to
+     *              be told that something has changed.  The database is loaded when it is first used and written
+     *              through the configuration store a few minutes after it changes.
+     */
+    class BaselineStore :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs the BaselineStore.
+             */
+            BaselineStore();
+
+        public:
+            /**
+             * @brief       Destroys the BaselineStore.
+             */
+            ~BaselineStore();
+
+            /**
+             * @brief       Returns the process wide instance of the store.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> BaselineStore *;
+
+            /**
+             * @brief       Returns the baseline of a hop, creating it if required.
+             *
+             * @note        the baseline remains valid for the lifetime of the store.
+             *
+             * @param[in]   target the target that the route leads to.
+             * @param[in]   address the address of the hop.
+             *
+             * @returns     the baseline.
+             */
+            auto baseline(
+                    const QString &target,
+                    const QHostAddress &address
+            ) -> Nedrysoft::RouteAnalyser::HopBaseline *;
+
+            /**
+             * @brief       Notes that baselines have been updated so that the database is written.
+             */
+            auto setChanged() -> void;
+
+            /**
+             * @brief       Writes the database if it has changed.
+             */
+            auto save() -> void;
+
+        private:
+            /**
+             * @brief       Reads the database.
+             */
+            auto load() -> void;
+
+            /**
+             * @brief       Returns the path of the database.
+             *
+             * @returns     the path.
+             */
+            auto filePath() -> QString;
+
+        private:
+            //! @cond
+
+            QHash<QString, std::shared_ptr<Nedrysoft::RouteAnalyser::HopBaseline> > m_baselines;
+            QTimer *m_saveTimer;
+            bool m_loaded;
+            bool m_changed;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_BASELINESTORE_H
@@ -0,0 +1,529 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CaptureAnalyser.h"
+
+#include "PingResult.h"
+#include "SessionCapture.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <TaskPool>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr auto ChunksPerWorker = 4;
+constexpr auto NanosecondsInSecond = 1.0e9;
+constexpr auto NanosecondsInMillisecond = 1000000;
+constexpr auto MillisecondsInSecond = 1000.0;
+constexpr auto AddressWidth = 40;
+constexpr auto ColumnWidth = 18;
+
+struct ReportQuantile {
+    double quantile;
+    const char *name;
+};
+
+constexpr ReportQuantile ReportQuantiles[] = {{0.5, "p50"}, {0.9, "p90"}, {0.99, "p99"}};
+
+namespace {
+    /**
+     * @brief       The state shared by the tasks that analyse the chunks of a capture.
+     *
+     * @details     The tasks hold the state rather than the caller, so a task that starts after every chunk has
+     *              been taken finds nothing to do and does not touch the reader.
+     */
+    struct AnalysisState {
+        std::atomic<int> nextChunk;
+        int chunkCount;
+        int blocksPerChunk;
+        std::mutex mutex;
+        std::condition_variable finished;
+        int completedChunks;
+        std::vector<QVector<Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop> > partials;
+        std::vector<int> unreadableBlocks;
+    };
+}
+
+/**
+ * @brief       Adds the samples of a range of blocks to the summaries of the hops.
+ *
+ * @param[in]   reader the capture.
+ * @param[in]   first the first block.
+ * @param[in]   last the block after the last block.
+ * @param[out]  hops the summaries of the hops.
+ *
+ * @returns     the number of blocks that could not be read.
+ */
+static auto analyseBlocks(
+        const Nedrysoft::RouteAnalyser::CaptureReader &reader,
+        int first,
+        int last,
+        QVector<Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop> &hops ) -> int {
+
+    auto samples = QVector<Nedrysoft::RouteAnalyser::CaptureSample>();
+    auto unreadable = 0;
+
+    for (auto block=first;block<last;block++) {
+        if (!reader.readBlock(block, samples)) {
+            unreadable++;
+
+            continue;
+        }
+
+        for (auto &sample : samples) {
+            if (sample.hop<1) {
+                continue;
+            }
+
+            if (sample.hop>hops.count()) {
+                hops.resize(sample.hop);
+            }
+
+            auto &hop = hops[sample.hop-1];
+
+            hop.samples++;
+
+            if ((Nedrysoft::RouteAnalyser::PingResult::isLost(sample.code)) || (sample.roundTripTime<0)) {
+                continue;
+            }
+
+            auto latency = static_cast<double>(sample.roundTripTime)/NanosecondsInSecond;
+
+            hop.replies++;
+            hop.sum += latency;
+            hop.minimum = (hop.minimum<0) ? latency : std::min(hop.minimum, latency);
+            hop.maximum = std::max(hop.maximum, latency);
+            hop.latency.add(latency);
+        }
+    }
+
+    return unreadable;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop::merge(const Hop &other) -> void {
+    samples += other.samples;
+    replies += other.replies;
+    sum += other.sum;
+
+    if (other.minimum>=0) {
+        minimum = (minimum<0) ? other.minimum : std::min(minimum, other.minimum);
+    }
+
+    maximum = std::max(maximum, other.maximum);
+
+    latency.merge(other.latency);
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop::loss() const -> double {
+    if (!samples) {
+        return -1;
+    }
+
+    return static_cast<double>(samples-replies)/static_cast<double>(samples);
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop::mean() const -> double {
+    if (!replies) {
+        return -1;
+    }
+
+    return sum/static_cast<double>(replies);
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop::quantile(double quantile) const -> double {
+    if (latency.isEmpty()) {
+        return -1;
+    }
+
+    return latency.quantile(quantile);
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::analyse(
+        const QString &filename ) -> Nedrysoft::RouteAnalyser::CaptureAnalyser::Analysis {
+
+    auto analysis = Analysis();
+    auto reader = Nedrysoft::RouteAnalyser::CaptureReader();
+
+    analysis.filename = filename;
+
+    if (!reader.open(filename)) {
+        return analysis;
+    }
+
+    analysis.valid = true;
+    analysis.target = reader.target();
+    analysis.interval = reader.interval();
+    analysis.startTime = reader.startTime();
+    analysis.endTime = reader.endTime();
+    analysis.route = reader.route();
+    analysis.blocks = reader.blockCount();
+
+    auto taskPool = Nedrysoft::Core::TaskPool::getInstance();
+    auto workers = std::max(taskPool->workerCount(), 1);
+    auto state = std::make_shared<AnalysisState>();
+
+    state->blocksPerChunk = std::max(analysis.blocks/(workers*ChunksPerWorker), 1);
+    state->chunkCount = (analysis.blocks+state->blocksPerChunk-1)/state->blocksPerChunk;
+    state->nextChunk = 0;
+    state->completedChunks = 0;
+    state->partials.resize(static_cast<size_t>(state->chunkCount));
+    state->unreadableBlocks.resize(static_cast<size_t>(state->chunkCount));
+
+    auto readerPointer = &reader;
+    auto blockCount = analysis.blocks;
+
+    auto work = [state, readerPointer, blockCount]() {
+        while (true) {
+            auto chunk = state->nextChunk.fetch_add(1);
+
+            if (chunk>=state->chunkCount) {
+                return;
+            }
+
+            auto first = chunk*state->blocksPerChunk;
+            auto last = std::min(first+state->blocksPerChunk, blockCount);
+
+            state->unreadableBlocks[static_cast<size_t>(chunk)] = analyseBlocks(
+                    *readerPointer,
+                    first,
+                    last,
+                    state->partials[static_cast<size_t>(chunk)] );
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            if (++state->completedChunks==state->chunkCount) {
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    // the helpers are given different affinities so that they are queued on different workers.
+
+    for (auto worker=1;worker<std::min(workers, state->chunkCount);worker++) {
+        taskPool->submit(reinterpret_cast<quintptr>(state.get())+static_cast<quintptr>(worker), work);
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+
+    state->finished.wait(lock, [state]() {
+        return state->completedChunks==state->chunkCount;
+    });
+
+    // the partial summaries are merged in block order, although the result does not depend on the order.
+
+    for (auto chunk=0;chunk<state->chunkCount;chunk++) {
+        auto &partial = state->partials[static_cast<size_t>(chunk)];
+
+        if (partial.count()>analysis.hops.count()) {
+            analysis.hops.resize(partial.count());
+        }
+
+        for (auto hop=0;hop<partial.count();hop++) {
+            analysis.hops[hop].merge(partial.at(hop));
+        }
+
+        analysis.unreadableBlocks += state->unreadableBlocks[static_cast<size_t>(chunk)];
+    }
+
+    if (analysis.route.count()>analysis.hops.count()) {
+        analysis.hops.resize(analysis.route.count());
+    }
+
+    for (auto hop=0;hop<analysis.hops.count();hop++) {
+        analysis.hops[hop].address = analysis.route.value(hop);
+    }
+
+    return analysis;
+}
+
+/**
+ * @brief       Returns a time as an ISO 8601 string.
+ *
+ * @param[in]   time the time in nanoseconds since the unix epoch.
+ *
+ * @returns     the string.
+ */
+static auto formatTime(qint64 time) -> QString {
+    return QDateTime::fromMSecsSinceEpoch(time/NanosecondsInMillisecond).toString(Qt::ISODate);
+}
+
+/**
+ * @brief       Returns a latency in milliseconds for a report.
+ *
+ * @param[in]   latency the latency in seconds, or a negative value if there is none.
+ *
+ * @returns     the latency with two decimal places; or a dash if there is none.
+ */
+static auto formatLatency(double latency) -> QString {
+    if (latency<0) {
+        return "-";
+    }
+
+    return QString::number(latency*MillisecondsInSecond, 'f', 2);
+}
+
+/**
+ * @brief       Returns a loss as a percentage for a report.
+ *
+ * @param[in]   loss the loss (0 to 1), or a negative value if there is none.
+ *
+ * @returns     the percentage with one decimal place; or a dash if there is none.
+ */
+static auto formatLoss(double loss) -> QString {
+    if (loss<0) {
+        return "-";
+    }
+
+    return QString::number(loss*100.0, 'f', 1)+"%";
+}
+
+/**
+ * @brief       Returns the JSON summary of a capture.
+ *
+ * @param[in]   analysis the summary.
+ *
+ * @returns     the object.
+ */
+static auto captureObject(const Nedrysoft::RouteAnalyser::CaptureAnalyser::Analysis &analysis) -> QJsonObject {
+    return QJsonObject{
+        {"filename", analysis.filename},
+        {"target", analysis.target},
+        {"interval", analysis.interval},
+        {"start", formatTime(analysis.startTime)},
+        {"end", formatTime(analysis.endTime)},
+        {"blocks", analysis.blocks},
+        {"unreadableBlocks", analysis.unreadableBlocks}
+    };
+}
+
+/**
+ * @brief       Returns the JSON summary of a hop.
+ *
+ * @param[in]   hop the summary, or nullptr if the hop is not in the capture.
+ *
+ * @returns     the object; or null if the hop is not in the capture.
+ */
+static auto hopValue(const Nedrysoft::RouteAnalyser::CaptureAnalyser::Hop *hop) -> QJsonValue {
+    if (!hop) {
+        return QJsonValue();
+    }
+
+    auto object = QJsonObject{
+        {"address", hop->address.isNull() ? QJsonValue() : QJsonValue(hop->address.toString())},
+        {"samples", static_cast<qint64>(hop->samples)},
+        {"replies", static_cast<qint64>(hop->replies)},
+        {"loss", hop->loss()}
+    };
+
+    if (hop->replies) {
+        object["minimum"] = hop->minimum;
+        object["mean"] = hop->mean();
+        object["maximum"] = hop->maximum;
+
+        for (auto &reportQuantile : ReportQuantiles) {
+            object[reportQuantile.name] = hop->quantile(reportQuantile.quantile);
+        }
+    }
+
+    return object;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::compare(
+        const Analysis &before,
+        const Analysis &after,
+        Format format ) -> QByteArray {
+
+    auto hopCount = std::max(before.hops.count(), after.hops.count());
+
+    auto hopAt = [](const Analysis &analysis, int hop) -> const Hop * {
+        return (hop<analysis.hops.count()) ? &analysis.hops.at(hop) : nullptr;
+    };
+
+    auto routeChanged = [&](int hop) {
+        auto beforeHop = hopAt(before, hop);
+        auto afterHop = hopAt(after, hop);
+
+        return (!beforeHop) || (!afterHop) || (beforeHop->address!=afterHop->address);
+    };
+
+    if (format==Format::Json) {
+        QJsonArray hops;
+
+        for (auto hop=0;hop<hopCount;hop++) {
+            hops.append(QJsonObject{
+                {"hop", hop+1},
+                {"routeChanged", routeChanged(hop)},
+                {"before", hopValue(hopAt(before, hop))},
+                {"after", hopValue(hopAt(after, hop))}
+            });
+        }
+
+        return QJsonDocument(QJsonObject{
+            {"before", captureObject(before)},
+            {"after", captureObject(after)},
+            {"hops", hops}
+        }).toJson();
+    }
+
+    auto text = QString();
+    QTextStream stream(&text);
+
+    auto addressText = [](const Hop *hop) -> QString {
+        if ((!hop) || (hop->address.isNull())) {
+            return "*";
+        }
+
+        return hop->address.toString();
+    };
+
+    auto lossOf = [](const Hop *hop) {
+        return hop ? hop->loss() : -1.0;
+    };
+
+    auto quantileOf = [](const Hop *hop, double quantile) {
+        return hop ? hop->quantile(quantile) : -1.0;
+    };
+
+    if (format==Format::Csv) {
+        stream << "hop,before_address,after_address,route_changed,before_samples,after_samples,"
+                  "before_loss,after_loss";
+
+        for (auto &reportQuantile : ReportQuantiles) {
+            stream << ",before_" << reportQuantile.name << "_ms,after_" << reportQuantile.name << "_ms";
+        }
+
+        stream << "\n";
+
+        for (auto hop=0;hop<hopCount;hop++) {
+            auto beforeHop = hopAt(before, hop);
+            auto afterHop = hopAt(after, hop);
+
+            stream << (hop+1) << ","
+                   << addressText(beforeHop) << ","
+                   << addressText(afterHop) << ","
+                   << (routeChanged(hop) ? "true" : "false") << ","
+                   << (beforeHop ? beforeHop->samples : 0) << ","
+                   << (afterHop ? afterHop->samples : 0) << ","
+                   << lossOf(beforeHop) << ","
+                   << lossOf(afterHop);
+
+            for (auto &reportQuantile : ReportQuantiles) {
+                stream << "," << formatLatency(quantileOf(beforeHop, reportQuantile.quantile))
+                       << "," << formatLatency(quantileOf(afterHop, reportQuantile.quantile));
+            }
+
+            stream << "\n";
+        }
+
+        stream.flush();
+
+        return text.toUtf8();
+    }
+
+    auto describe = [&stream](const QString &label, const Analysis &analysis) {
+        stream << label << analysis.filename;
+
+        if (!analysis.valid) {
+            stream << " (unreadable)\n";
+
+            return;
+        }
+
+        stream << " (" << analysis.target << ", " << formatTime(analysis.startTime) << " to "
+               << formatTime(analysis.endTime) << ", " << analysis.blocks << " blocks";
+
+        if (analysis.unreadableBlocks) {
+            stream << ", " << analysis.unreadableBlocks << " unreadable";
+        }
+
+        stream << ")\n";
+    };
+
+    describe("Before: ", before);
+    describe("After:  ", after);
+
+    stream << "\n" << QString("Hop").leftJustified(5)
+           << QString("Address").leftJustified(AddressWidth)
+           << QString("Loss").leftJustified(ColumnWidth);
+
+    for (auto &reportQuantile : ReportQuantiles) {
+        stream << QString("%1% (ms)").arg(reportQuantile.quantile*100.0).leftJustified(ColumnWidth);
+    }
+
+    stream << "\n";
+
+    for (auto hop=0;hop<hopCount;hop++) {
+        auto beforeHop = hopAt(before, hop);
+        auto afterHop = hopAt(after, hop);
+
+        auto address = addressText(beforeHop);
+
+        if (routeChanged(hop)) {
+            address += " -> "+addressText(afterHop);
+        }
+
+        auto change = [](const QString &beforeValue, const QString &afterValue) {
+            return (beforeValue+" -> "+afterValue).leftJustified(ColumnWidth);
+        };
+
+        stream << QString::number(hop+1).leftJustified(5)
+               << address.leftJustified(AddressWidth)
+               << change(formatLoss(lossOf(beforeHop)), formatLoss(lossOf(afterHop)));
+
+        for (auto &reportQuantile : ReportQuantiles) {
+            stream << change(
+                    formatLatency(quantileOf(beforeHop, reportQuantile.quantile)),
+                    formatLatency(quantileOf(afterHop, reportQuantile.quantile)) );
+        }
+
+        stream << "\n";
+    }
+
+    stream.flush();
+
+    return text.toUtf8();
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureAnalyser::format(const QString &name) -> Format {
+    auto lowerName = name.toLower();
+
+    if ((lowerName=="csv") || (lowerName.endsWith(".csv"))) {
+        return Format::Csv;
+    }
+
+    if ((lowerName=="json") || (lowerName.endsWith(".json"))) {
+        return Format::Json;
+    }
+
+    return Format::Text;
+}
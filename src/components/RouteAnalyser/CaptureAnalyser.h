@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_CAPTUREANALYSER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_CAPTUREANALYSER_H
+
+#include "IRouteEngine.h"
+#include "LatencySketch.h"
+#include "RouteAnalyserSpec.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The CaptureAnalyser class summarises session captures and compares them.
+     *
+     * @details     A capture is scanned by block on the task pool, each block is decompressed straight from the
+     *              mapped file and folded into a partial summary of every hop, the partial summaries are then merged.
+     *              The latency of each hop is held in a LatencySketch, which merges exactly, so the percentiles are
+     *              the same as those of a single pass however the blocks were divided.  The memory used depends on
+     *              the number of hops rather than the size of the capture.
+     *
+     *              No widgets are used, so captures can be compared on a worker thread or by the command line tool.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC CaptureAnalyser {
+        public:
+            /**
+             * @brief       The formats that a comparison can be written in.
+             */
+            enum class Format {
+                Text,
+                Csv,
+                Json
+            };
+
+            /**
+             * @brief       The summary of a hop.
+             */
+            struct Hop {
+                QHostAddress address;
+                quint64 samples = 0;
+                quint64 replies = 0;
+                double minimum = -1;
+                double maximum = -1;
+                double sum = 0;
+                Nedrysoft::RouteAnalyser::LatencySketch latency;
+
+                /**
+                 * @brief       Adds the samples of another summary of the same hop.
+                 *
+                 * @param[in]   other the other summary.
+                 */
+                auto merge(const Hop &other) -> void;
+
+                /**
+                 * @brief       Returns the fraction of the samples that were lost.
+                 *
+                 * @returns     the loss (0 to 1); or -1 if there are no samples.
+                 */
+                auto loss() const -> double;
+
+                /**
+                 * @brief       Returns the mean latency of the replies.
+                 *
+                 * @returns     the latency in seconds; or -1 if there were no replies.
+                 */
+                auto mean() const -> double;
+
+                /**
+                 * @brief       Returns a latency percentile of the replies.
+                 *
+                 * @param[in]   quantile the quantile (0 to 1).
+                 *
+                 * @returns     the latency in seconds; or -1 if there were no replies.
+                 */
+                auto quantile(double quantile) const -> double;
+            };
+
+            /**
+             * @brief       The summary of a capture.
+             */
+            struct Analysis {
+                bool valid = false;
+                QString filename;
+                QString target;
+                int interval = 0;
+                qint64 startTime = 0;
+                qint64 endTime = 0;
+                int blocks = 0;
+                int unreadableBlocks = 0;
+                Nedrysoft::RouteAnalyser::RouteList route;
+                QVector<Hop> hops;
+            };
+
+        public:
+            /**
+             * @brief       Summarises a capture.
+             *
+             * @details     The blocks are divided between the workers of the task pool, the calling thread takes part
+             *              so the analysis completes even when every worker is busy, it may therefore be called from a
+             *              task.
+             *
+             * @param[in]   filename the capture file.
+             *
+             * @returns     the summary, valid is false if the file could not be opened.
+             */
+            static auto analyse(const QString &filename) -> Analysis;
+
+            /**
+             * @brief       Writes the differences between two captures.
+             *
+             * @details     Each hop is compared by its position in the route, a hop whose address differs between
+             *              the captures is marked as a route change.
+             *
+             * @param[in]   before the summary of the capture taken before the change.
+             * @param[in]   after the summary of the capture taken after the change.
+             * @param[in]   format the format of the report.
+             *
+             * @returns     the report.
+             */
+            static auto compare(const Analysis &before, const Analysis &after, Format format) -> QByteArray;
+
+            /**
+             * @brief       Returns the format that matches a file name or format name.
+             *
+             * @param[in]   name a file name with an extension of .csv or .json, or the name csv, json or text.
+             *
+             * @returns     the format, text if the name is not recognised.
+             */
+            static auto format(const QString &name) -> Format;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_CAPTUREANALYSER_H
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChangePointDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr auto WarmupSamples = 30ul;
+constexpr auto Drift = 0.5;
+constexpr auto Threshold = 8.0;
+constexpr auto MinimumDeviationFraction = 0.05;
+constexpr auto MinimumDeviation = 0.0005;
+constexpr auto MaximumChangePoints = 1000;
+
+Nedrysoft::RouteAnalyser::ChangePointDetector::ChangePointDetector() :
+        m_count(0),
+        m_mean(0),
+        m_m2(0),
+        m_upper(0),
+        m_upperStart(0),
+        m_upperSum(0),
+        m_upperCount(0),
+        m_lower(0),
+        m_lowerStart(0),
+        m_lowerSum(0),
+        m_lowerCount(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::ChangePointDetector::add(double time, double roundTripTime) -> bool {
+    auto addToSegment = [this](double value) {
+        m_count++;
+
+        auto delta = value-m_mean;
+
+        m_mean += delta/static_cast<double>(m_count);
+        m_m2 += delta*(value-m_mean);
+    };
+
+    if (m_count<WarmupSamples) {
+        addToSegment(roundTripTime);
+
+        return false;
+    }
+
+    auto deviation = std::max(
+            std::sqrt(m_m2/static_cast<double>(m_count-1)),
+            std::max(m_mean*MinimumDeviationFraction, MinimumDeviation) );
+
+    auto score = (roundTripTime-m_mean)/deviation;
+
+    m_upper = std::max(0.0, m_upper+score-Drift);
+    m_lower = std::max(0.0, m_lower-score-Drift);
+
+    // each run remembers where it started and the samples within it, which become the next segment.
+
+    if (m_upper>0) {
+        if (!m_upperCount) {
+            m_upperStart = time;
+        }
+
+        m_upperSum += roundTripTime;
+        m_upperCount++;
+    } else {
+        m_upperSum = 0;
+        m_upperCount = 0;
+    }
+
+    if (m_lower>0) {
+        if (!m_lowerCount) {
+            m_lowerStart = time;
+        }
+
+        m_lowerSum += roundTripTime;
+        m_lowerCount++;
+    } else {
+        m_lowerSum = 0;
+        m_lowerCount = 0;
+    }
+
+    if ((m_upper>Threshold) || (m_lower>Threshold)) {
+        auto upper = m_upper>Threshold;
+        auto sum = upper ? m_upperSum : m_lowerSum;
+        auto count = upper ? m_upperCount : m_lowerCount;
+
+        if (m_changePoints.count()==MaximumChangePoints) {
+            m_changePoints.removeFirst();
+        }
+
+        m_changePoints.append(ChangePoint{
+            upper ? m_upperStart : m_lowerStart,
+            m_mean,
+            sum/static_cast<double>(count)} );
+
+        restart(sum, count);
+
+        return true;
+    }
+
+    /**
+     * samples that are part of a run may belong to a new level, the segment only learns from samples that do not
+     * look like the start of a shift.
+     */
+
+    if ((m_upper==0) && (m_lower==0)) {
+        addToSegment(roundTripTime);
+    }
+
+    return false;
+}
+
+auto Nedrysoft::RouteAnalyser::ChangePointDetector::restart(double sum, unsigned long count) -> void {
+    auto variance = m_m2/static_cast<double>(m_count-1);
+
+    m_count = count;
+    m_mean = sum/static_cast<double>(count);
+    m_m2 = variance*static_cast<double>(count-1);
+
+    m_upper = 0;
+    m_upperSum = 0;
+    m_upperCount = 0;
+
+    m_lower = 0;
+    m_lowerSum = 0;
+    m_lowerCount = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::ChangePointDetector::clear() -> void {
+    m_count = 0;
+    m_mean = 0;
+    m_m2 = 0;
+
+    m_upper = 0;
+    m_upperSum = 0;
+    m_upperCount = 0;
+
+    m_lower = 0;
+    m_lowerSum = 0;
+    m_lowerCount = 0;
+
+    m_changePoints.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::ChangePointDetector::changePoints() const ->
+        const QVector<Nedrysoft::RouteAnalyser::ChangePoint> & {
+
+    return m_changePoints;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_CHANGEPOINTDETECTOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_CHANGEPOINTDETECTOR_H
+
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The ChangePoint structure describes a detected shift in the latency of a hop.
+     */
+    struct ChangePoint {
+        double time;                        //!< the time the shift started in seconds since the unix epoch.
+        double before;                      //!< the mean latency before the shift in seconds.
+        double after;                       //!< the mean latency after the shift in seconds.
+    };
+
+    /**
+     * @brief       The ChangePointDetector class detects shifts in the latency of a hop as the replies arrive.
+     *
+     * @details     A two sided CUSUM is run over the round trip times standardised against the mean and deviation
+     *              of the current segment.  When either sum crosses its threshold a change point is recorded at
+     *              the start of the run that crossed it and a new segment is started from the samples of that run,
+     *              so the detector adapts to the new level without keeping any history.  Each update is constant
+     *              time.
+     *
+     *              The deviation is floored at a fraction of the mean so that a very stable hop does not report
+     *              changes of a few microseconds.
+     */
+    class ChangePointDetector {
+        public:
+            /**
+             * @brief       Constructs an empty ChangePointDetector.
+             */
+            ChangePointDetector();
+
+            /**
+             * @brief       Adds the round trip time of a reply.
+             *
+             * @param[in]   time the time the request was sent in seconds since the unix epoch.
+             * @param[in]   roundTripTime the round trip time in seconds.
+             *
+             * @returns     true if a change point was detected; otherwise false.
+             */
+            auto add(double time, double roundTripTime) -> bool;
+
+            /**
+             * @brief       Removes all measurements and change points.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the detected change points.
+             *
+             * @note        Only the most recent change points are kept, the oldest are discarded once the limit
+             *              is reached.
+             *
+             * @returns     the change points in time order.
+             */
+            auto changePoints() const -> const QVector<Nedrysoft::RouteAnalyser::ChangePoint> &;
+
+        private:
+            /**
+             * @brief       Starts a new segment from the samples of the run that crossed the threshold.
+             *
+             * @param[in]   sum the sum of the samples in the run.
+             * @param[in]   count the number of samples in the run.
+             */
+            auto restart(double sum, unsigned long count) -> void;
+
+        private:
+            //! @cond
+
+            unsigned long m_count;
+            double m_mean;
+            double m_m2;
+
+            double m_upper;
+            double m_upperStart;
+            double m_upperSum;
+            unsigned long m_upperCount;
+
+            double m_lower;
+            double m_lowerStart;
+            double m_lowerSum;
+            unsigned long m_lowerCount;
+
+            QVector<Nedrysoft::RouteAnalyser::ChangePoint> m_changePoints;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_CHANGEPOINTDETECTOR_H
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CompressedSeries.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr auto MicrosecondsInSecond = 1000000.0;
+constexpr auto CodeChangedFlag = 1;
+constexpr auto NoRoundTripTime = -1.0;
+
+namespace {
+    /**
+     * @brief       Appends a signed value as a zigzag encoded variable length integer.
+     *
+     * @param[in]   data the encoded data.
+     * @param[in]   value the value.
+     */
+    auto writeValue(std::vector<uint8_t> &data, int64_t value) -> void {
+        auto encoded = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+
+        while (encoded>=0x80) {
+            data.push_back(static_cast<uint8_t>(encoded | 0x80));
+
+            encoded >>= 7;
+        }
+
+        data.push_back(static_cast<uint8_t>(encoded));
+    }
+
+    /**
+     * @brief       Reads a zigzag encoded variable length integer.
+     *
+     * @param[in]   data the encoded data.
+     * @param[in,out]   offset the offset of the value, updated to the offset of the next value.
+     *
+     * @returns     the value.
+     */
+    auto readValue(const std::vector<uint8_t> &data, size_t &offset) -> int64_t {
+        uint64_t encoded = 0;
+        auto shift = 0;
+
+        while (offset<data.size()) {
+            auto byte = data[offset++];
+
+            encoded |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+            if (!(byte & 0x80)) {
+                break;
+            }
+
+            shift += 7;
+        }
+
+        return static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+    }
+}
+
+Nedrysoft::RouteAnalyser::CompressedSeries::CompressedSeries(int maximumBlocks) :
+        m_encoderState({0, 0, 0, 0}),
+        m_maximumBlocks(std::max(maximumBlocks, 1)),
+        m_count(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::append(
+        double time,
+        double roundTripTime,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode code ) -> void {
+
+    auto timeMicroseconds = static_cast<int64_t>(std::llround(time*MicrosecondsInSecond));
+
+    if ((m_blocks.empty()) || (m_blocks.back().count==BlockSamples)) {
+        if (!m_blocks.empty()) {
+            m_blocks.back().data.shrink_to_fit();
+        }
+
+        if (static_cast<int>(m_blocks.size())==m_maximumBlocks) {
+            m_count -= m_blocks.front().count;
+
+            m_blocks.pop_front();
+        }
+
+        // each block starts from a fresh state so that it can be decoded without the blocks before it.
+
+        m_blocks.push_back(Block {timeMicroseconds, 0, std::vector<uint8_t>()});
+
+        m_encoderState = DecoderState {timeMicroseconds, 0, 0, 0};
+    }
+
+    auto &block = m_blocks.back();
+    auto interval = timeMicroseconds-m_encoderState.time;
+    auto codeValue = static_cast<uint8_t>(code);
+    auto codeChanged = (codeValue!=m_encoderState.code);
+
+    /**
+     * the change in interval shares its value with the flag that marks a change of result code, at a steady
+     * rate both are zero and the pair fits in a single byte.
+     */
+
+    writeValue(block.data, ((interval-m_encoderState.interval)*2) | (codeChanged ? CodeChangedFlag : 0));
+
+    if (codeChanged) {
+        block.data.push_back(codeValue);
+    }
+
+    if (!Nedrysoft::RouteAnalyser::PingResult::isLost(code)) {
+        auto roundTripMicroseconds = static_cast<int64_t>(std::llround(roundTripTime*MicrosecondsInSecond));
+
+        writeValue(block.data, roundTripMicroseconds-m_encoderState.roundTripTime);
+
+        m_encoderState.roundTripTime = roundTripMicroseconds;
+    }
+
+    m_encoderState.time = timeMicroseconds;
+    m_encoderState.interval = interval;
+    m_encoderState.code = codeValue;
+
+    block.count++;
+
+    m_count++;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::clear() -> void {
+    m_blocks.clear();
+    m_count = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::count() const -> int64_t {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::blockCount() const -> int {
+    return static_cast<int>(m_blocks.size());
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::encodedSize() const -> size_t {
+    auto size = size_t(0);
+
+    for (auto &block : m_blocks) {
+        size += block.data.size()+sizeof(Block);
+    }
+
+    return size;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::setMaximumBlocks(int maximumBlocks) -> void {
+    m_maximumBlocks = std::max(maximumBlocks, 1);
+
+    // the newest block is the one being written to, so it is always the last to go.
+
+    while (static_cast<int>(m_blocks.size())>m_maximumBlocks) {
+        m_count -= m_blocks.front().count;
+
+        m_blocks.pop_front();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::maximumBlocks() const -> int {
+    return m_maximumBlocks;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::decode(int block) const ->
+        Nedrysoft::RouteAnalyser::CompressedSeries::DecodedBlock {
+
+    DecodedBlock decodedBlock;
+
+    if ((block<0) || (block>=blockCount())) {
+        return decodedBlock;
+    }
+
+    auto count = m_blocks[block].count;
+
+    decodedBlock.times.reserve(count);
+    decodedBlock.roundTripTimes.reserve(count);
+    decodedBlock.codes.reserve(count);
+
+    auto last = ConstIterator(this, block+1);
+
+    for (auto sample = ConstIterator(this, block);sample!=last;++sample) {
+        decodedBlock.times.push_back(sample->time);
+        decodedBlock.roundTripTimes.push_back(static_cast<float>(sample->roundTripTime));
+        decodedBlock.codes.push_back(static_cast<uint8_t>(sample->code));
+    }
+
+    return decodedBlock;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::begin() const -> ConstIterator {
+    return ConstIterator(this, 0);
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::end() const -> ConstIterator {
+    return ConstIterator(this, blockCount());
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::lowerBound(double time) const -> ConstIterator {
+    auto timeMicroseconds = static_cast<int64_t>(std::llround(time*MicrosecondsInSecond));
+
+    // the sample is in the last block that starts at or before the time, or the first block if none does.
+
+    auto nextBlock = std::upper_bound(
+            m_blocks.begin(),
+            m_blocks.end(),
+            timeMicroseconds,
+            [](int64_t value, const Block &block) {
+                return value<block.firstTime;
+            } );
+
+    auto block = std::max(static_cast<int>(nextBlock-m_blocks.begin())-1, 0);
+    auto sample = ConstIterator(this, block);
+    auto last = end();
+
+    while ((sample!=last) && (sample->time<time)) {
+        ++sample;
+    }
+
+    return sample;
+}
+
+Nedrysoft::RouteAnalyser::CompressedSeries::ConstIterator::ConstIterator(
+        const Nedrysoft::RouteAnalyser::CompressedSeries *series,
+        int block) :
+
+            m_series(series),
+            m_block(block),
+            m_index(0),
+            m_offset(0),
+            m_state({0, 0, 0, 0}),
+            m_sample({0, NoRoundTripTime, Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok}) {
+
+    if (m_block<m_series->blockCount()) {
+        m_state.time = m_series->m_blocks[m_block].firstTime;
+
+        decode();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::ConstIterator::operator++() -> ConstIterator & {
+    m_index++;
+
+    if (m_index<m_series->m_blocks[m_block].count) {
+        decode();
+
+        return *this;
+    }
+
+    *this = ConstIterator(m_series, m_block+1);
+
+    return *this;
+}
+
+auto Nedrysoft::RouteAnalyser::CompressedSeries::ConstIterator::decode() -> void {
+    auto &data = m_series->m_blocks[m_block].data;
+    auto header = readValue(data, m_offset);
+
+    if (header & CodeChangedFlag) {
+        m_state.code = data[m_offset++];
+    }
+
+    m_state.interval += (header-(header & CodeChangedFlag))/2;
+    m_state.time += m_state.interval;
+
+    m_sample.time = static_cast<double>(m_state.time)/MicrosecondsInSecond;
+    m_sample.code = static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(m_state.code);
+
+    if (Nedrysoft::RouteAnalyser::PingResult::isLost(m_sample.code)) {
+        m_sample.roundTripTime = NoRoundTripTime;
+    } else {
+        m_state.roundTripTime += readValue(data, m_offset);
+
+        m_sample.roundTripTime = static_cast<double>(m_state.roundTripTime)/MicrosecondsInSecond;
+    }
+}
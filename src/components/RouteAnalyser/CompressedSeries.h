@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_COMPRESSEDSERIES_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_COMPRESSEDSERIES_H
+
+#include "PingResult.h"
+#include "RouteAnalyserSpec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The CompressedSeries class stores a result history in a compact encoding.
+     *
+     * @details     Samples are encoded into blocks of a fixed number of samples.  Request times are quantised to
+     *              microseconds and stored as the difference between successive intervals (the delta of delta),
+     *              which is close to zero while the target is probed at a steady rate.  Round trip times are
+     *              quantised to microseconds and stored as the difference from the previous reply, and the result
+     *              code is only stored when it changes.  Each value is written as a zigzag encoded variable length
+     *              integer, so a typical sample takes 3 to 4 bytes rather than the 13 bytes of a raw sample.
+     *
+     *              A block can only be decoded from its start, the samples are read back in order with a
+     *              ConstIterator.  Once the maximum number of blocks is reached the oldest block is discarded.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC CompressedSeries {
+        public:
+            /**
+             * @brief       A decoded sample.
+             */
+            struct Sample {
+                double time;                        //! the request time in seconds since the unix epoch.
+                double roundTripTime;               //! the round trip time in seconds; otherwise -1 if lost.
+                Nedrysoft::RouteAnalyser::PingResult::ResultCode code;      //! the result code.
+            };
+
+            /**
+             * @brief       The samples of a block decoded into separate arrays.
+             */
+            struct DecodedBlock {
+                std::vector<double> times;          //! the request times in seconds since the unix epoch.
+                std::vector<float> roundTripTimes;  //! the round trip times in seconds; otherwise -1 if lost.
+                std::vector<uint8_t> codes;         //! the result codes.
+            };
+
+        private:
+            //! @cond
+
+            struct Block {
+                int64_t firstTime;
+                int count;
+                std::vector<uint8_t> data;
+            };
+
+            struct DecoderState {
+                int64_t time;
+                int64_t interval;
+                int64_t roundTripTime;
+                uint8_t code;
+            };
+
+            //! @endcond
+
+        public:
+            /**
+             * @brief       The ConstIterator class decodes the samples of a series in order.
+             */
+            class ConstIterator {
+                public:
+                    /**
+                     * @brief       Returns the current sample.
+                     *
+                     * @returns     the sample.
+                     */
+                    auto operator*() const -> const Sample & {
+                        return m_sample;
+                    }
+
+                    /**
+                     * @brief       Returns the current sample.
+                     *
+                     * @returns     the sample.
+                     */
+                    auto operator->() const -> const Sample * {
+                        return &m_sample;
+                    }
+
+                    /**
+                     * @brief       Moves to the next sample.
+                     *
+                     * @returns     the iterator.
+                     */
+                    auto operator++() -> ConstIterator &;
+
+                    /**
+                     * @brief       Compares the position of two iterators.
+                     *
+                     * @param[in]   other the other iterator.
+                     *
+                     * @returns     true if the iterators are at the same sample; otherwise false.
+                     */
+                    auto operator==(const ConstIterator &other) const -> bool {
+                        return (m_block==other.m_block) && (m_index==other.m_index);
+                    }
+
+                    /**
+                     * @brief       Compares the position of two iterators.
+                     *
+                     * @param[in]   other the other iterator.
+                     *
+                     * @returns     true if the iterators are at different samples; otherwise false.
+                     */
+                    auto operator!=(const ConstIterator &other) const -> bool {
+                        return !(*this==other);
+                    }
+
+                private:
+                    /**
+                     * @brief       Constructs an iterator at the start of a block.
+                     *
+                     * @param[in]   series the series.
+                     * @param[in]   block the index of the block; or the number of blocks for the end.
+                     */
+                    ConstIterator(const CompressedSeries *series, int block);
+
+                    /**
+                     * @brief       Decodes the sample at the current position.
+                     */
+                    auto decode() -> void;
+
+                    friend class CompressedSeries;
+
+                private:
+                    //! @cond
+
+                    const CompressedSeries *m_series;
+                    int m_block;
+                    int m_index;
+                    size_t m_offset;
+                    DecoderState m_state;
+                    Sample m_sample;
+
+                    //! @endcond
+            };
+
+        public:
+            /**
+             * @brief       Constructs a CompressedSeries.
+             *
+             * @param[in]   maximumBlocks the number of blocks held before the oldest is discarded.
+             */
+            explicit CompressedSeries(int maximumBlocks = DefaultMaximumBlocks);
+
+            /**
+             * @brief       Appends a sample.
+             *
+             * @param[in]   time the request time in seconds since the unix epoch.
+             * @param[in]   roundTripTime the round trip time in seconds, ignored for a result without a reply.
+             * @param[in]   code the result code.
+             */
+            auto append(
+                    double time,
+                    double roundTripTime,
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode code ) -> void;
+
+            /**
+             * @brief       Removes all samples.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of samples held.
+             *
+             * @returns     the number of samples.
+             */
+            auto count() const -> int64_t;
+
+            /**
+             * @brief       Returns the number of blocks held.
+             *
+             * @returns     the number of blocks.
+             */
+            auto blockCount() const -> int;
+
+            /**
+             * @brief       Returns the number of bytes used by the encoded samples.
+             *
+             * @returns     the number of bytes.
+             */
+            auto encodedSize() const -> size_t;
+
+            /**
+             * @brief       Sets the number of blocks held, discarding the oldest blocks if there are more.
+             *
+             * @param[in]   maximumBlocks the number of blocks, at least 1.
+             */
+            auto setMaximumBlocks(int maximumBlocks) -> void;
+
+            /**
+             * @brief       Returns the number of blocks held before the oldest is discarded.
+             *
+             * @returns     the number of blocks.
+             */
+            auto maximumBlocks() const -> int;
+
+            /**
+             * @brief       Decodes all of the samples of a block.
+             *
+             * @param[in]   block the index of the block, 0 is the oldest.
+             *
+             * @returns     the decoded samples.
+             */
+            auto decode(int block) const -> DecodedBlock;
+
+            /**
+             * @brief       Returns an iterator at the oldest sample.
+             *
+             * @returns     the iterator.
+             */
+            auto begin() const -> ConstIterator;
+
+            /**
+             * @brief       Returns an iterator past the newest sample.
+             *
+             * @returns     the iterator.
+             */
+            auto end() const -> ConstIterator;
+
+            /**
+             * @brief       Returns an iterator at the first sample at or after the given time.
+             *
+             * @details     The block is found by binary search of the block start times, only the samples of that
+             *              block are decoded to find the sample.
+             *
+             * @param[in]   time the request time in seconds since the unix epoch.
+             *
+             * @returns     the iterator; otherwise end() if every sample is earlier.
+             */
+            auto lowerBound(double time) const -> ConstIterator;
+
+        public:
+            /**
+             * @brief       The number of samples in a block.
+             */
+            static constexpr int BlockSamples = 1024;
+
+            /**
+             * @brief       The default number of blocks, a week of samples at the default interval.
+             */
+            static constexpr int DefaultMaximumBlocks = 600;
+
+        private:
+            //! @cond
+
+            std::deque<Block> m_blocks;
+            DecoderState m_encoderState;
+            int m_maximumBlocks;
+            int64_t m_count;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_COMPRESSEDSERIES_H
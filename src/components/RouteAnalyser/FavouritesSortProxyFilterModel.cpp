@@ -23,37 +23,39 @@
 
 #include "FavouritesSortProxyFilterModel.h"
 
-#include "rapidfuzz/fuzz.hpp"
+#include "TargetManager.h"
 
 bool Nedrysoft::RouteAnalyser::FavouritesSortProxyFilterModel::filterAcceptsRow(
         int sourceRow,
         const QModelIndex &sourceParent) const {
 
-    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-
     if (m_filterText.isEmpty()) {
         return true;
     }
 
-    auto map = sourceModel()->data(index, Qt::UserRole+1).toMap();
-
-    auto filterText = m_filterText.toStdString();
-
-    auto stringParts = map["name"].toString().toLower().split("/");
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
 
-    for (auto string : stringParts) {
-        double score = rapidfuzz::fuzz::partial_ratio(filterText, string.toStdString());
+    auto storeIndex = sourceModel()->data(index, StoreIndexRole).toInt();
 
-        if (score>90) {
-            return true;
-        }
+    if ((storeIndex<0) || (storeIndex>=m_acceptedIndexes.count())) {
+        return false;
     }
 
-    return false;
+    return m_acceptedIndexes.at(storeIndex);
 }
 
 auto Nedrysoft::RouteAnalyser::FavouritesSortProxyFilterModel::setFilterText(QString text) -> void {
+    const auto &favouritesStore = Nedrysoft::RouteAnalyser::TargetManager::getInstance()->favouritesStore();
+
     m_filterText = text;
 
+    m_acceptedIndexes.fill(false, favouritesStore.count());
+
+    if (!m_filterText.isEmpty()) {
+        for (auto storeIndex : favouritesStore.search(m_filterText)) {
+            m_acceptedIndexes[storeIndex] = true;
+        }
+    }
+
     invalidateFilter();
-}
\ No newline at end of file
+}
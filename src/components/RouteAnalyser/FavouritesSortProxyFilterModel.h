@@ -25,10 +25,15 @@
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_FAVOURITESSORTPROXYFILTERMODEL_H
 
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 namespace Nedrysoft { namespace RouteAnalyser {
     /**
      * @brief       Implements a proxy filter model using rapidfuzz for string matching
+     *
+     * @details     The filter is evaluated once per change of the filter text by searching the favourites store of
+     *              the TargetManager, rows are then accepted by looking up the store position held in the
+     *              StoreIndexRole of the first column of the source model.
      */
     class FavouritesSortProxyFilterModel :
             public QSortFilterProxyModel {
@@ -37,6 +42,11 @@ namespace Nedrysoft { namespace RouteAnalyser {
             Q_OBJECT
 
         public:
+            /**
+             * @brief       The data role of the source model that holds the position of the favourite in the store.
+             */
+            static constexpr int StoreIndexRole = Qt::UserRole+2;
+
             /**
              * @brief       Sets the filter string to be used.
              * @param[in]   text the filter string.
@@ -58,6 +68,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
             //! @cond
 
             QString m_filterText;
+            QVector<bool> m_acceptedIndexes;
 
             //! @endcond
     };
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FavouritesStore.h"
+
+#include "rapidfuzz/fuzz.hpp"
+
+#include <QStringList>
+#include <algorithm>
+
+constexpr auto FuzzyMatchThreshold = 90.0;
+constexpr auto NameSeparator = "/";
+
+auto Nedrysoft::RouteAnalyser::Favourite::fromMap(const QVariantMap &map) -> Nedrysoft::RouteAnalyser::Favourite {
+    auto favourite = Favourite();
+
+    favourite.host = map["host"].toString();
+    favourite.name = map["name"].toString();
+    favourite.description = map["description"].toString();
+    favourite.interval = map["interval"].toInt();
+    favourite.ipVersion = map["ipversion"].value<Nedrysoft::Core::IPVersion>();
+
+    return favourite;
+}
+
+auto Nedrysoft::RouteAnalyser::Favourite::toMap() const -> QVariantMap {
+    auto map = QVariantMap();
+
+    map["host"] = host;
+    map["name"] = name;
+    map["description"] = description;
+    map["interval"] = interval;
+    map["ipversion"] = QVariant::fromValue(ipVersion);
+
+    return map;
+}
+
+auto Nedrysoft::RouteAnalyser::Favourite::fromJson(const QJsonObject &object) -> Nedrysoft::RouteAnalyser::Favourite {
+    auto favourite = Favourite();
+
+    favourite.host = object["host"].toString();
+    favourite.name = object["name"].toString();
+    favourite.description = object["description"].toString();
+    favourite.interval = object["interval"].toInt();
+    favourite.ipVersion = static_cast<Nedrysoft::Core::IPVersion>(object["ipversion"].toInt());
+
+    return favourite;
+}
+
+auto Nedrysoft::RouteAnalyser::Favourite::toJson() const -> QJsonObject {
+    auto object = QJsonObject();
+
+    object["host"] = host;
+    object["name"] = name;
+    object["description"] = description;
+    object["interval"] = interval;
+    object["ipversion"] = static_cast<int>(ipVersion);
+
+    return object;
+}
+
+Nedrysoft::RouteAnalyser::FavouritesStore::FavouritesStore() :
+        m_indexBuilt(false) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::createEntry(
+        const Nedrysoft::RouteAnalyser::Favourite &favourite ) -> Entry {
+
+    auto entry = Entry();
+
+    entry.favourite = favourite;
+    entry.object = favourite.toJson();
+
+    for (const auto &part : favourite.name.toLower().split(NameSeparator)) {
+        entry.nameParts.push_back(part.trimmed().toStdString());
+    }
+
+    return entry;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::count() const -> int {
+    return m_entries.count();
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::at(int index) const -> const Nedrysoft::RouteAnalyser::Favourite & {
+    return m_entries.at(index).favourite;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::setFavourites(
+        const QVector<Nedrysoft::RouteAnalyser::Favourite> &favourites ) -> void {
+
+    m_entries.clear();
+    m_entries.reserve(favourites.count());
+
+    for (const auto &favourite : favourites) {
+        m_entries.append(createEntry(favourite));
+    }
+
+    m_indexBuilt = false;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::clear() -> void {
+    m_entries.clear();
+
+    m_indexBuilt = false;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::append(const Nedrysoft::RouteAnalyser::Favourite &favourite) -> void {
+    m_entries.append(createEntry(favourite));
+
+    m_indexBuilt = false;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::prepend(const Nedrysoft::RouteAnalyser::Favourite &favourite) -> void {
+    auto host = favourite.host;
+
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [host](const Entry &entry) {
+        return entry.favourite.host.compare(host, Qt::CaseInsensitive)==0;
+    }), m_entries.end());
+
+    m_entries.prepend(createEntry(favourite));
+
+    m_indexBuilt = false;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::indexOfHost(const QString &host) const -> int {
+    if (!m_indexBuilt) {
+        buildIndex();
+    }
+
+    return m_hostIndex.value(host.toLower(), -1);
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::buildIndex() const -> void {
+    m_hostIndex.clear();
+    m_prefixIndex.clear();
+
+    for (auto index=0; index<m_entries.count(); index++) {
+        const auto &entry = m_entries.at(index);
+        auto host = entry.favourite.host.toLower();
+
+        if (!m_hostIndex.contains(host)) {
+            m_hostIndex.insert(host, index);
+        }
+
+        m_prefixIndex.emplace_back(host.toStdString(), index);
+
+        for (const auto &part : entry.nameParts) {
+            m_prefixIndex.emplace_back(part, index);
+        }
+    }
+
+    std::sort(m_prefixIndex.begin(), m_prefixIndex.end());
+
+    m_indexBuilt = true;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::search(const QString &text) const -> QVector<int> {
+    auto matches = QVector<int>();
+
+    if (text.isEmpty()) {
+        matches.reserve(m_entries.count());
+
+        for (auto index=0; index<m_entries.count(); index++) {
+            matches.append(index);
+        }
+
+        return matches;
+    }
+
+    if (!m_indexBuilt) {
+        buildIndex();
+    }
+
+    auto query = text.toLower().toStdString();
+    auto matched = std::vector<bool>(m_entries.count(), false);
+
+    /**
+     * the keys that start with the query form a contiguous run in the sorted index, every entry found this way
+     * would score 100 so the fuzzy comparison is only needed for the remaining entries.
+     */
+
+    auto key = std::lower_bound(m_prefixIndex.begin(), m_prefixIndex.end(), std::make_pair(query, -1));
+
+    while ((key!=m_prefixIndex.end()) && (key->first.compare(0, query.size(), query)==0)) {
+        matched[key->second] = true;
+
+        key++;
+    }
+
+    for (auto index=0; index<m_entries.count(); index++) {
+        if (matched[index]) {
+            continue;
+        }
+
+        for (const auto &part : m_entries.at(index).nameParts) {
+            if (rapidfuzz::fuzz::partial_ratio(query, part)>FuzzyMatchThreshold) {
+                matched[index] = true;
+                break;
+            }
+        }
+    }
+
+    for (auto index=0; index<m_entries.count(); index++) {
+        if (matched[index]) {
+            matches.append(index);
+        }
+    }
+
+    return matches;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::toJson() const -> QJsonArray {
+    auto array = QJsonArray();
+
+    for (const auto &entry : m_entries) {
+        array.append(entry.object);
+    }
+
+    return array;
+}
+
+auto Nedrysoft::RouteAnalyser::FavouritesStore::toMaps() const -> QList<QVariantMap> {
+    auto maps = QList<QVariantMap>();
+
+    maps.reserve(m_entries.count());
+
+    for (const auto &entry : m_entries) {
+        maps.append(entry.favourite.toMap());
+    }
+
+    return maps;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FAVOURITESSTORE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FAVOURITESSTORE_H
+
+#include <ICore>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       A favourite (or recent) target.
+     */
+    struct Favourite {
+        QString host;
+        QString name;
+        QString description;
+        int interval = 0;
+        Nedrysoft::Core::IPVersion ipVersion = Nedrysoft::Core::IPVersion::V4;
+
+        /**
+         * @brief       Creates a favourite from the key/value map used by the dialogs.
+         *
+         * @param[in]   map the key/value map of the target.
+         *
+         * @returns     the favourite.
+         */
+        static auto fromMap(const QVariantMap &map) -> Favourite;
+
+        /**
+         * @brief       Returns the favourite as the key/value map used by the dialogs.
+         *
+         * @returns     the key/value map of the target.
+         */
+        auto toMap() const -> QVariantMap;
+
+        /**
+         * @brief       Creates a favourite from its JSON representation.
+         *
+         * @param[in]   object the JSON object.
+         *
+         * @returns     the favourite.
+         */
+        static auto fromJson(const QJsonObject &object) -> Favourite;
+
+        /**
+         * @brief       Returns the JSON representation of the favourite.
+         *
+         * @returns     the JSON object.
+         */
+        auto toJson() const -> QJsonObject;
+    };
+
+    /**
+     * @brief       The FavouritesStore class holds an ordered, indexed list of favourites.
+     *
+     * @details     Entries are held as typed values together with their cached JSON and lower case search keys, a
+     *              host lookup table finds duplicates without a scan and a sorted index of the search keys answers
+     *              prefix searches with a binary search.  Only the entries that do not prefix match are scored
+     *              with rapidfuzz, which keeps filtering interactive with thousands of favourites.  The indexes
+     *              are rebuilt on demand after the list has been changed.
+     */
+    class FavouritesStore {
+        public:
+            /**
+             * @brief       Constructs an empty FavouritesStore.
+             */
+            FavouritesStore();
+
+            /**
+             * @brief       Returns the number of favourites.
+             *
+             * @returns     the number of favourites.
+             */
+            auto count() const -> int;
+
+            /**
+             * @brief       Returns a favourite.
+             *
+             * @param[in]   index the position of the favourite.
+             *
+             * @returns     the favourite.
+             */
+            auto at(int index) const -> const Nedrysoft::RouteAnalyser::Favourite &;
+
+            /**
+             * @brief       Replaces the contents of the store.
+             *
+             * @param[in]   favourites the new list of favourites.
+             */
+            auto setFavourites(const QVector<Nedrysoft::RouteAnalyser::Favourite> &favourites) -> void;
+
+            /**
+             * @brief       Removes all favourites.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Adds a favourite to the end of the list.
+             *
+             * @param[in]   favourite the favourite.
+             */
+            auto append(const Nedrysoft::RouteAnalyser::Favourite &favourite) -> void;
+
+            /**
+             * @brief       Adds a favourite to the top of the list.
+             *
+             * @note        any existing entries for the same host are removed, so the store behaves like a most
+             *              recently used list.
+             *
+             * @param[in]   favourite the favourite.
+             */
+            auto prepend(const Nedrysoft::RouteAnalyser::Favourite &favourite) -> void;
+
+            /**
+             * @brief       Returns the position of the first favourite for a host.
+             *
+             * @param[in]   host the host (case insensitive).
+             *
+             * @returns     the position; otherwise -1.
+             */
+            auto indexOfHost(const QString &host) const -> int;
+
+            /**
+             * @brief       Returns the favourites that match a search string.
+             *
+             * @details     A favourite matches if the search string is a prefix of its host or of any of the
+             *              "/" separated parts of its name, or if it fuzzy matches one of the name parts.
+             *
+             * @param[in]   text the search string, an empty string matches every favourite.
+             *
+             * @returns     the positions of the matching favourites in list order.
+             */
+            auto search(const QString &text) const -> QVector<int>;
+
+            /**
+             * @brief       Returns the favourites as a JSON array.
+             *
+             * @returns     the JSON array.
+             */
+            auto toJson() const -> QJsonArray;
+
+            /**
+             * @brief       Returns the favourites as the key/value maps used by the dialogs.
+             *
+             * @returns     the list of key/value maps.
+             */
+            auto toMaps() const -> QList<QVariantMap>;
+
+        private:
+            /**
+             * @brief       Rebuilds the host lookup table and the prefix index.
+             */
+            auto buildIndex() const -> void;
+
+        private:
+            //! @cond
+
+            /**
+             * @brief       A favourite and the data derived from it.
+             */
+            struct Entry {
+                Nedrysoft::RouteAnalyser::Favourite favourite;
+                QJsonObject object;
+                std::vector<std::string> nameParts;
+            };
+
+            /**
+             * @brief       Creates the entry for a favourite.
+             */
+            static auto createEntry(const Nedrysoft::RouteAnalyser::Favourite &favourite) -> Entry;
+
+            QVector<Entry> m_entries;
+
+            mutable QHash<QString, int> m_hostIndex;
+            mutable std::vector<std::pair<std::string, int> > m_prefixIndex;
+            mutable bool m_indexBuilt;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FAVOURITESSTORE_H
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FidelityGovernor.h"
+
+#include <spdlog/spdlog.h>
+
+constexpr auto EvaluationFrames = 30;
+constexpr auto HeadroomRatio = 0.5;
+constexpr auto StepUpWindows = 4;
+constexpr auto CoarseDecimationFactor = 2;
+constexpr auto ReducedRefreshFactor = 2;
+
+Nedrysoft::RouteAnalyser::FidelityGovernor::FidelityGovernor() :
+        m_level(Level::Full),
+        m_frames(0),
+        m_frameTime(0),
+        m_quietWindows(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance() -> Nedrysoft::RouteAnalyser::FidelityGovernor * {
+    static Nedrysoft::RouteAnalyser::FidelityGovernor instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::recordFrame(double frameTime, double budget) -> void {
+    m_frameTime += frameTime;
+    m_frames++;
+
+    if (m_frames<EvaluationFrames) {
+        return;
+    }
+
+    auto averageFrameTime = m_frameTime/m_frames;
+
+    m_frames = 0;
+    m_frameTime = 0;
+
+    /**
+     * the quality drops as soon as a window overruns, but is only raised after several windows with plenty of
+     * headroom, so that the level does not flip back and forth around the budget.
+     */
+
+    if (averageFrameTime>budget) {
+        m_quietWindows = 0;
+
+        if (m_level!=Level::ReducedRefresh) {
+            setLevel(static_cast<Level>(static_cast<int>(m_level)+1));
+        }
+    } else if (averageFrameTime<budget*HeadroomRatio) {
+        m_quietWindows++;
+
+        if ((m_quietWindows>=StepUpWindows) && (m_level!=Level::Full)) {
+            m_quietWindows = 0;
+
+            setLevel(static_cast<Level>(static_cast<int>(m_level)-1));
+        }
+    } else {
+        m_quietWindows = 0;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::level() -> Level {
+    return m_level;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::gradientsEnabled() -> bool {
+    return m_level<Level::SolidBackgrounds;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::decimationFactor() -> int {
+    return (m_level>=Level::CoarseDecimation) ? CoarseDecimationFactor : 1;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::hiddenPlotsPaused() -> bool {
+    return m_level>=Level::HiddenPlotsPaused;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::refreshFactor() -> int {
+    return (m_level>=Level::ReducedRefresh) ? ReducedRefreshFactor : 1;
+}
+
+auto Nedrysoft::RouteAnalyser::FidelityGovernor::setLevel(Level level) -> void {
+    if (m_level==level) {
+        return;
+    }
+
+    SPDLOG_INFO(QString("Drawing quality changed from level %1 to %2.")
+        .arg(static_cast<int>(m_level))
+        .arg(static_cast<int>(level)).toStdString());
+
+    m_level = level;
+
+    Q_EMIT levelChanged(level);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FIDELITYGOVERNOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FIDELITYGOVERNOR_H
+
+#include "RouteAnalyserSpec.h"
+
+#include <QObject>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The FidelityGovernor class lowers the drawing quality of the editors when frames overrun.
+     *
+     * @details     The frame scheduler reports how long each frame took, including how late it started, and the
+     *              governor compares the average over a window of frames against the frame budget.  While the
+     *              budget is exceeded the quality is stepped down a level per window, each level keeping the
+     *              reductions of the levels above it:
+     *
+     *              - the latency backgrounds are drawn with solid bands rather than gradients.
+     *              - the graphs are decimated to fewer columns than the plot has pixels.
+     *              - plots that are scrolled out of view are not rebuilt until they are scrolled back in.
+     *              - frames are drawn at a fraction of the refresh rate.
+     *
+     *              Once there is plenty of headroom for several windows in a row the quality is stepped back up.
+     *
+     *              The governor must only be used from the main thread.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC FidelityGovernor :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The quality levels, from the highest to the lowest.
+             */
+            enum class Level {
+                Full,
+                SolidBackgrounds,
+                CoarseDecimation,
+                HiddenPlotsPaused,
+                ReducedRefresh
+            };
+
+        private:
+            /**
+             * @brief       Constructs a new FidelityGovernor.
+             */
+            FidelityGovernor();
+
+        public:
+            /**
+             * @brief       Returns the FidelityGovernor instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> FidelityGovernor *;
+
+            /**
+             * @brief       Records the time taken by a frame.
+             *
+             * @param[in]   frameTime the time from when the frame was due until it was drawn in milliseconds.
+             * @param[in]   budget the refresh interval of the screen in milliseconds.
+             */
+            auto recordFrame(double frameTime, double budget) -> void;
+
+            /**
+             * @brief       Returns the current quality level.
+             *
+             * @returns     the level.
+             */
+            auto level() -> Level;
+
+            /**
+             * @brief       Returns whether the latency backgrounds may be drawn with gradients.
+             *
+             * @returns     true if gradients may be drawn; otherwise false.
+             */
+            auto gradientsEnabled() -> bool;
+
+            /**
+             * @brief       Returns the number of pixels that share a decimated column.
+             *
+             * @returns     the number of pixels per column.
+             */
+            auto decimationFactor() -> int;
+
+            /**
+             * @brief       Returns whether plots that are out of view are left unbuilt.
+             *
+             * @returns     true if hidden plots are paused; otherwise false.
+             */
+            auto hiddenPlotsPaused() -> bool;
+
+            /**
+             * @brief       Returns the number of screen refreshes between frames.
+             *
+             * @returns     the number of refreshes per frame.
+             */
+            auto refreshFactor() -> int;
+
+            /**
+             * @brief       This signal is emitted when the quality level changes.
+             *
+             * @param[in]   level the new level.
+             */
+            Q_SIGNAL void levelChanged(Nedrysoft::RouteAnalyser::FidelityGovernor::Level level);
+
+        private:
+            /**
+             * @brief       Changes the quality level.
+             *
+             * @param[in]   level the new level.
+             */
+            auto setLevel(Level level) -> void;
+
+        private:
+            //! @cond
+
+            Level m_level;
+            int m_frames;
+            double m_frameTime;
+            int m_quietWindows;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FIDELITYGOVERNOR_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FlatBufferBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr auto InitialSize = 1024;
+
+Nedrysoft::RouteAnalyser::FlatBufferBuilder::FlatBufferBuilder() :
+        m_buffer(InitialSize),
+        m_size(0),
+        m_minimumAlignment(1),
+        m_tableStart(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::push(const void *data, int length) -> void {
+    if (!length) {
+        return;
+    }
+
+    if (m_size+length>static_cast<int>(m_buffer.size())) {
+        /**
+         * the contents are at the end of the buffer, so they are moved to the end of the enlarged buffer.
+         */
+
+        auto buffer = std::vector<uint8_t>(std::max(m_buffer.size()*2, static_cast<size_t>(m_size+length)));
+
+        std::memcpy(buffer.data()+buffer.size()-m_size, m_buffer.data()+m_buffer.size()-m_size, m_size);
+
+        m_buffer.swap(buffer);
+    }
+
+    m_size += length;
+
+    std::memcpy(m_buffer.data()+m_buffer.size()-m_size, data, length);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::align(int alignment, int length) -> void {
+    static const uint8_t padding[8] = {};
+
+    m_minimumAlignment = std::max(m_minimumAlignment, alignment);
+
+    auto remainder = (m_size+length) % alignment;
+
+    if (remainder) {
+        push(padding, alignment-remainder);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::pushOffset(Offset offset) -> void {
+    align(sizeof(Offset));
+
+    /**
+     * a reference is relative to its own position, which is the size of the buffer once it has been added.
+     */
+
+    auto value = qToLittleEndian<Offset>(static_cast<Offset>(m_size+sizeof(Offset))-offset);
+
+    push(&value, sizeof(Offset));
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::createString(const char *data, int length) -> Offset {
+    static const uint8_t terminator = 0;
+
+    align(sizeof(uint32_t), length+1);
+
+    push(&terminator, 1);
+    push(data, length);
+
+    auto size = qToLittleEndian<uint32_t>(static_cast<uint32_t>(length));
+
+    push(&size, sizeof(size));
+
+    return static_cast<Offset>(m_size);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::createVector(const std::vector<Offset> &offsets) -> Offset {
+    align(sizeof(uint32_t), static_cast<int>(offsets.size()*sizeof(Offset)));
+
+    for (auto offset=offsets.rbegin();offset!=offsets.rend();offset++) {
+        pushOffset(*offset);
+    }
+
+    auto size = qToLittleEndian<uint32_t>(static_cast<uint32_t>(offsets.size()));
+
+    push(&size, sizeof(size));
+
+    return static_cast<Offset>(m_size);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::createStructVector(
+        const void *data,
+        int structSize,
+        int count,
+        int alignment ) -> Offset {
+
+    align(sizeof(uint32_t), structSize*count);
+    align(alignment, structSize*count);
+
+    push(data, structSize*count);
+
+    auto size = qToLittleEndian<uint32_t>(static_cast<uint32_t>(count));
+
+    push(&size, sizeof(size));
+
+    return static_cast<Offset>(m_size);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::startTable() -> void {
+    m_fields.clear();
+
+    m_tableStart = m_size;
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::addOffset(int field, Offset offset) -> void {
+    pushOffset(offset);
+
+    m_fields.emplace_back(field, m_size);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::endTable() -> Offset {
+    static const int32_t placeholder = 0;
+
+    align(sizeof(int32_t));
+
+    push(&placeholder, sizeof(placeholder));
+
+    auto table = m_size;
+    auto slots = 0;
+
+    for (auto &field : m_fields) {
+        slots = std::max(slots, field.first+1);
+    }
+
+    /**
+     * the vtable holds its own size, the size of the table and the position of each field within the table, a
+     * field that was not added has a position of 0 and reads as its default value.
+     */
+
+    auto vtable = std::vector<uint16_t>(2+slots, 0);
+
+    vtable[0] = static_cast<uint16_t>(vtable.size()*sizeof(uint16_t));
+    vtable[1] = static_cast<uint16_t>(table-m_tableStart);
+
+    for (auto &field : m_fields) {
+        vtable[2+field.first] = static_cast<uint16_t>(table-field.second);
+    }
+
+    for (auto entry=vtable.rbegin();entry!=vtable.rend();entry++) {
+        auto value = qToLittleEndian<uint16_t>(*entry);
+
+        push(&value, sizeof(value));
+    }
+
+    /**
+     * the table starts with the distance back to its vtable, which has been written in front of it.
+     */
+
+    auto distance = qToLittleEndian<int32_t>(static_cast<int32_t>(m_size-table));
+
+    std::memcpy(m_buffer.data()+m_buffer.size()-table, &distance, sizeof(distance));
+
+    m_fields.clear();
+
+    return static_cast<Offset>(table);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::finish(Offset root) -> void {
+    align(m_minimumAlignment, sizeof(Offset));
+
+    pushOffset(root);
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::data() const -> const uint8_t * {
+    return m_buffer.data()+m_buffer.size()-m_size;
+}
+
+auto Nedrysoft::RouteAnalyser::FlatBufferBuilder::size() const -> int {
+    return m_size;
+}
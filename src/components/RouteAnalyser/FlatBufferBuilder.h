@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FLATBUFFERBUILDER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FLATBUFFERBUILDER_H
+
+#include <QtEndian>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The FlatBufferBuilder class builds a FlatBuffers encoded buffer.
+     *
+     * @details     A minimal builder for the metadata of formats which are described by FlatBuffers schemas (such
+     *              as the Apache Arrow IPC format) so that they can be written without the FlatBuffers library.
+     *              As with the library, the buffer is built back to front, so strings, vectors and tables must be
+     *              created before the table that refers to them, and tables cannot be nested while being built.
+     */
+    class FlatBufferBuilder {
+        public:
+            /**
+             * @brief       An object in the buffer, measured from the end of the buffer.
+             */
+            using Offset = uint32_t;
+
+        public:
+            /**
+             * @brief       Constructs an empty FlatBufferBuilder.
+             */
+            FlatBufferBuilder();
+
+            /**
+             * @brief       Creates a string.
+             *
+             * @param[in]   data the UTF-8 encoded string.
+             * @param[in]   length the length of the string in bytes.
+             *
+             * @returns     the string.
+             */
+            auto createString(const char *data, int length) -> Offset;
+
+            /**
+             * @brief       Creates a vector of strings, tables or vectors.
+             *
+             * @param[in]   offsets the objects in the vector.
+             *
+             * @returns     the vector.
+             */
+            auto createVector(const std::vector<Offset> &offsets) -> Offset;
+
+            /**
+             * @brief       Creates a vector of structs.
+             *
+             * @param[in]   data the little endian encoded structs.
+             * @param[in]   structSize the size of each struct in bytes.
+             * @param[in]   count the number of structs.
+             * @param[in]   alignment the alignment of the struct.
+             *
+             * @returns     the vector.
+             */
+            auto createStructVector(const void *data, int structSize, int count, int alignment) -> Offset;
+
+            /**
+             * @brief       Starts building a table.
+             */
+            auto startTable() -> void;
+
+            /**
+             * @brief       Adds a scalar field to the table being built.
+             *
+             * @param[in]   field the index of the field in the schema.
+             * @param[in]   value the value.
+             */
+            template <typename T>
+            auto addScalar(int field, T value) -> void {
+                align(sizeof(T));
+
+                auto littleEndian = qToLittleEndian<T>(value);
+
+                push(&littleEndian, sizeof(T));
+
+                m_fields.emplace_back(field, m_size);
+            }
+
+            /**
+             * @brief       Adds a field which refers to a string, vector or table to the table being built.
+             *
+             * @param[in]   field the index of the field in the schema.
+             * @param[in]   offset the object the field refers to.
+             */
+            auto addOffset(int field, Offset offset) -> void;
+
+            /**
+             * @brief       Finishes building the table.
+             *
+             * @returns     the table.
+             */
+            auto endTable() -> Offset;
+
+            /**
+             * @brief       Finishes the buffer with the given root table.
+             *
+             * @param[in]   root the root table.
+             */
+            auto finish(Offset root) -> void;
+
+            /**
+             * @brief       Returns the start of the built buffer.
+             *
+             * @returns     the data.
+             */
+            auto data() const -> const uint8_t *;
+
+            /**
+             * @brief       Returns the size of the built buffer.
+             *
+             * @returns     the size in bytes.
+             */
+            auto size() const -> int;
+
+        private:
+            /**
+             * @brief       Pads the buffer so that it is aligned after a number of bytes are added.
+             *
+             * @param[in]   alignment the required alignment.
+             * @param[in]   length the number of bytes that will be added after the padding.
+             */
+            auto align(int alignment, int length = 0) -> void;
+
+            /**
+             * @brief       Adds bytes to the front of the buffer.
+             *
+             * @param[in]   data the bytes.
+             * @param[in]   length the number of bytes.
+             */
+            auto push(const void *data, int length) -> void;
+
+            /**
+             * @brief       Adds a reference to an object at the front of the buffer.
+             *
+             * @param[in]   offset the object.
+             */
+            auto pushOffset(Offset offset) -> void;
+
+        private:
+            //! @cond
+
+            std::vector<uint8_t> m_buffer;
+            int m_size;
+            int m_minimumAlignment;
+            int m_tableStart;
+            std::vector<std::pair<int, int> > m_fields;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FLATBUFFERBUILDER_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FleetDashboardEditor.h"
+
+#include "FleetDashboardWidget.h"
+#include "RouteAnalyserEditor.h"
+
+#include <IContextManager>
+#include <IEditorManager>
+
+constexpr auto DefaultFleetInterval = 5.0;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+Nedrysoft::RouteAnalyser::FleetDashboardEditor::FleetDashboardEditor() :
+        m_pingEngineFactory(nullptr),
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_interval(DefaultFleetInterval),
+        m_editorWidget(nullptr) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::setPingEngine(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory ) -> void {
+
+    m_pingEngineFactory = pingEngineFactory;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::setTargets(const QStringList &hosts) -> void {
+    m_hosts = hosts;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::setIPVersion(Nedrysoft::Core::IPVersion ipVersion) -> void {
+    m_ipVersion = ipVersion;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::setInterval(double interval) -> void {
+    m_interval = interval;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::widget() -> QWidget * {
+    if (!m_editorWidget) {
+        m_editorWidget = new Nedrysoft::RouteAnalyser::FleetDashboardWidget(
+            m_pingEngineFactory,
+            m_ipVersion,
+            m_hosts,
+            static_cast<int>(m_interval*MillisecondsInSecond)
+        );
+
+        connect(
+            m_editorWidget,
+            &Nedrysoft::RouteAnalyser::FleetDashboardWidget::targetActivated,
+            this,
+            &Nedrysoft::RouteAnalyser::FleetDashboardEditor::openTarget
+        );
+    }
+
+    return m_editorWidget;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::openTarget(const QString &host) -> void {
+    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+    if (!editorManager) {
+        return;
+    }
+
+    auto editor = new Nedrysoft::RouteAnalyser::RouteAnalyserEditor;
+
+    editor->setPingEngine(m_pingEngineFactory);
+    editor->setTarget(host);
+    editor->setIPVersion(m_ipVersion);
+    editor->setInterval(m_interval);
+
+    editorManager->openEditor(editor);
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::displayName() -> QString {
+    return tr("Fleet (%1 targets)").arg(m_hosts.count());
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::activated() -> void {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::deactivated() -> void {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardEditor::contextId() -> int {
+    return Nedrysoft::Core::GlobalContext;
+}
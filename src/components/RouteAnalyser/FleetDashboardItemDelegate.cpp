@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FleetDashboardItemDelegate.h"
+
+#include "FleetDashboardModel.h"
+#include "LatencySettings.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QPainterPath>
+#include <cmath>
+
+constexpr auto SparklineMargin = 3;
+constexpr auto SparklineLineWidth = 1.0;
+
+Nedrysoft::RouteAnalyser::FleetDashboardItemDelegate::FleetDashboardItemDelegate(
+        Nedrysoft::RouteAnalyser::FleetDashboardModel *model,
+        QObject *parent ) :
+
+        QStyledItemDelegate(parent),
+        m_model(model) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardItemDelegate::paint(
+        QPainter *painter,
+        const QStyleOptionViewItem &option,
+        const QModelIndex &index ) const -> void {
+
+    if (index.column()!=Nedrysoft::RouteAnalyser::FleetDashboardModel::TrendColumn) {
+        QStyledItemDelegate::paint(painter, option, index);
+
+        return;
+    }
+
+    auto itemOption = option;
+
+    initStyleOption(&itemOption, index);
+
+    auto style = itemOption.widget ? itemOption.widget->style() : QApplication::style();
+
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &itemOption, painter, itemOption.widget);
+
+    auto &entry = m_model->entry(index.row());
+
+    if (entry.samples.isEmpty()) {
+        return;
+    }
+
+    auto rect = QRectF(option.rect.adjusted(SparklineMargin, SparklineMargin, -SparklineMargin, -SparklineMargin));
+    auto maximum = 0.0f;
+
+    for (auto sample=0;sample<entry.samples.count();sample++) {
+        auto latency = entry.sample(sample).latency;
+
+        if ((!std::isnan(latency)) && (latency>maximum)) {
+            maximum = latency;
+        }
+    }
+
+    /**
+     * the line is scaled from zero to the highest latency of the history, the samples are placed from the right
+     * hand edge so that a target with a short history still ends at the current time.  A sample in which every
+     * request was lost breaks the line and is marked at the bottom of the cell.
+     */
+
+    auto step = rect.width()/(Nedrysoft::RouteAnalyser::FleetDashboardModel::HistoryLength-1);
+    auto left = rect.right()-(step*(entry.samples.count()-1));
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+    auto lossColour = QColor(latencySettings->criticalColour());
+    auto lineColour = (option.state & QStyle::State_Selected) ?
+        option.palette.color(QPalette::HighlightedText) : option.palette.color(QPalette::Text);
+
+    QPainterPath path;
+    auto penDown = false;
+
+    painter->save();
+
+    painter->setRenderHint(QPainter::Antialiasing, true);
+
+    for (auto sample=0;sample<entry.samples.count();sample++) {
+        auto latency = entry.sample(sample).latency;
+        auto x = left+(step*sample);
+
+        if (std::isnan(latency)) {
+            painter->fillRect(QRectF(x-(step/2), rect.bottom()-SparklineMargin, step, SparklineMargin), lossColour);
+
+            penDown = false;
+
+            continue;
+        }
+
+        auto y = (maximum>0) ? rect.bottom()-((latency/maximum)*rect.height()) : rect.bottom();
+
+        if (penDown) {
+            path.lineTo(x, y);
+        } else {
+            path.moveTo(x, y);
+
+            penDown = true;
+        }
+    }
+
+    painter->setPen(QPen(lineColour, SparklineLineWidth));
+    painter->setBrush(Qt::NoBrush);
+
+    painter->drawPath(path);
+
+    painter->restore();
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDITEMDELEGATE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDITEMDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class FleetDashboardModel;
+
+    /**
+     * @brief       The FleetDashboardItemDelegate class draws the sparkline of the fleet dashboard.
+     *
+     * @details     The sparkline is drawn directly from the history of the target, only the cells that the view
+     *              asks to be painted (the visible ones) are drawn, the other columns are drawn as text.
+     */
+    class FleetDashboardItemDelegate :
+            public QStyledItemDelegate {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new FleetDashboardItemDelegate.
+             *
+             * @param[in]   model the model that holds the history of the targets.
+             * @param[in]   parent the owner of the delegate.
+             */
+            explicit FleetDashboardItemDelegate(
+                    Nedrysoft::RouteAnalyser::FleetDashboardModel *model,
+                    QObject *parent = nullptr );
+
+            /**
+             * @brief       Reimplements: QStyledItemDelegate::paint(QPainter *painter,
+             *              const QStyleOptionViewItem &option, const QModelIndex &index).
+             *
+             * @param[in]   painter the painter to draw with.
+             * @param[in]   option the style options of the cell.
+             * @param[in]   index the index of the cell.
+             */
+            auto paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const ->
+                    void override;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::FleetDashboardModel *m_model;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDITEMDELEGATE_H
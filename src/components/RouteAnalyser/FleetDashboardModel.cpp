@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FleetDashboardModel.h"
+
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+constexpr auto PercentileRank = 0.95;
+
+Nedrysoft::RouteAnalyser::FleetDashboardModel::FleetDashboardModel(QObject *parent) :
+        QAbstractTableModel(parent) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::update(
+        const QList<Nedrysoft::RouteAnalyser::FleetTarget> &targets,
+        const QList<Nedrysoft::RouteAnalyser::FleetHop> &hops ) -> void {
+
+    if (targets.count()!=m_entries.count()) {
+        beginResetModel();
+
+        m_entries = QVector<Entry>(targets.count());
+
+        endResetModel();
+    }
+
+    if (m_entries.isEmpty()) {
+        return;
+    }
+
+    QHash<QHostAddress, const Nedrysoft::RouteAnalyser::FleetHop *> destinations;
+
+    for (auto &hop : hops) {
+        destinations.insert(hop.address, &hop);
+    }
+
+    for (auto row=0;row<m_entries.count();row++) {
+        auto &target = targets.at(row);
+        auto &entry = m_entries[row];
+
+        entry.host = target.host;
+        entry.address = target.address;
+        entry.discovered = target.discovered;
+
+        auto hop = destinations.value(target.address, nullptr);
+
+        if (!hop) {
+            continue;
+        }
+
+        // the counters of the monitor are totals, a sample is the change since the previous snapshot.
+
+        if ((hop->replies<entry.replies) || (hop->timeouts<entry.timeouts)) {
+            entry.replies = 0;
+            entry.timeouts = 0;
+        }
+
+        auto sample = Sample();
+
+        sample.replies = hop->replies-entry.replies;
+        sample.timeouts = hop->timeouts-entry.timeouts;
+        sample.latency = sample.replies ?
+            static_cast<float>(hop->latency) : std::numeric_limits<float>::quiet_NaN();
+
+        entry.replies = hop->replies;
+        entry.timeouts = hop->timeouts;
+
+        if ((!sample.replies) && (!sample.timeouts)) {
+            continue;
+        }
+
+        if (entry.samples.count()<HistoryLength) {
+            entry.samples.append(sample);
+        } else {
+            entry.samples[entry.head] = sample;
+            entry.head = (entry.head+1) % HistoryLength;
+        }
+
+        updateStatistics(entry);
+    }
+
+    // a single change is signalled for every row, the view only repaints the cells that are visible.
+
+    Q_EMIT dataChanged(index(0, TargetColumn), index(m_entries.count()-1, LossColumn));
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::updateStatistics(Entry &entry) -> void {
+    QVector<float> latencies;
+    unsigned long replies = 0;
+    unsigned long timeouts = 0;
+
+    latencies.reserve(entry.samples.count());
+
+    entry.latency = -1;
+
+    for (auto index=0;index<entry.samples.count();index++) {
+        auto &sample = entry.sample(index);
+
+        replies += sample.replies;
+        timeouts += sample.timeouts;
+
+        if (!std::isnan(sample.latency)) {
+            latencies.append(sample.latency);
+
+            entry.latency = sample.latency;
+        }
+    }
+
+    entry.loss = -1;
+
+    if (replies+timeouts) {
+        entry.loss = (static_cast<double>(timeouts)*100.0)/static_cast<double>(replies+timeouts);
+    }
+
+    if (latencies.isEmpty()) {
+        entry.percentile = -1;
+
+        return;
+    }
+
+    auto rank = latencies.begin()+static_cast<int>(std::ceil(PercentileRank*latencies.count())-1);
+
+    std::nth_element(latencies.begin(), rank, latencies.end());
+
+    entry.percentile = *rank;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::entry(int row) const -> const Entry & {
+    return m_entries.at(row);
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::rowCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_entries.count();
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::columnCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return ColumnCount;
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::data(const QModelIndex &index, int role) const -> QVariant {
+    if ((!index.isValid()) || (index.row()>=m_entries.count())) {
+        return QVariant();
+    }
+
+    auto &entry = m_entries.at(index.row());
+
+    if (role==Qt::TextAlignmentRole) {
+        if (index.column()==TargetColumn) {
+            return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+        }
+
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role!=Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+        case TargetColumn: {
+            if (!entry.discovered) {
+                return tr("%1 (discovering)").arg(entry.host);
+            }
+
+            return entry.host;
+        }
+
+        case LatencyColumn: {
+            return (entry.latency<0) ? QString() : QString("%1").arg(entry.latency*1000.0, 2, 'f', 2);
+        }
+
+        case PercentileColumn: {
+            return (entry.percentile<0) ? QString() : QString("%1").arg(entry.percentile*1000.0, 2, 'f', 2);
+        }
+
+        case LossColumn: {
+            return (entry.loss<0) ? QString() : QString("%1").arg(entry.loss, 2, 'f', 2);
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return QVariant();
+}
+
+auto Nedrysoft::RouteAnalyser::FleetDashboardModel::headerData(
+        int section,
+        Qt::Orientation orientation,
+        int role ) const -> QVariant {
+
+    if ((orientation!=Qt::Horizontal) || (role!=Qt::DisplayRole)) {
+        return QVariant();
+    }
+
+    switch (section) {
+        case TargetColumn: {
+            return tr("Target");
+        }
+
+        case TrendColumn: {
+            return tr("Trend");
+        }
+
+        case LatencyColumn: {
+            return tr("Cur");
+        }
+
+        case PercentileColumn: {
+            return tr("P95");
+        }
+
+        case LossColumn: {
+            return tr("Loss %");
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return QVariant();
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDMODEL_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDMODEL_H
+
+#include "IFleetMonitor.h"
+
+#include <QAbstractTableModel>
+#include <QHostAddress>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The FleetDashboardModel class provides the model for the fleet dashboard.
+     *
+     * @details     Each row is a target of the fleet.  The model is updated from a snapshot of the fleet monitor
+     *              at a fixed rate rather than on every result, each snapshot adds one sample to the recent history
+     *              of every target (from which the sparkline, percentile and loss are calculated) and signals a
+     *              single change for all of the rows, the view then only repaints the rows that are visible.  As
+     *              with the route table the delegate reads the entry of a row directly with entry().
+     */
+    class FleetDashboardModel :
+            public QAbstractTableModel {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The columns of the dashboard.
+             */
+            enum Column {
+                TargetColumn,
+                TrendColumn,
+                LatencyColumn,
+                PercentileColumn,
+                LossColumn,
+                ColumnCount
+            };
+
+            /**
+             * @brief       The number of snapshots kept for each target.
+             */
+            static constexpr int HistoryLength = 60;
+
+            /**
+             * @brief       A single snapshot of a target.
+             */
+            struct Sample {
+                float latency;                      //!< the round trip time in seconds, NaN if nothing replied.
+                unsigned long replies;              //!< the number of replies since the previous snapshot.
+                unsigned long timeouts;             //!< the number of timeouts since the previous snapshot.
+            };
+
+            /**
+             * @brief       The state of a target.
+             */
+            struct Entry {
+                QString host;                       //!< the host name or address as given.
+                QHostAddress address;               //!< the address that was traced.
+                bool discovered = false;            //!< true once the route has been discovered.
+                QVector<Sample> samples;            //!< the history, a ring once HistoryLength samples are held.
+                int head = 0;                       //!< the index of the oldest sample once the ring is full.
+                unsigned long replies = 0;          //!< the replies of the destination at the previous snapshot.
+                unsigned long timeouts = 0;         //!< the timeouts of the destination at the previous snapshot.
+                double latency = -1;                //!< the most recent round trip time in seconds, -1 if none.
+                double percentile = -1;             //!< the 95th percentile of the history in seconds, -1 if none.
+                double loss = -1;                   //!< the loss over the history as a percentage, -1 if none.
+
+                /**
+                 * @brief       Returns a sample of the history.
+                 *
+                 * @param[in]   index the index of the sample, 0 is the oldest.
+                 *
+                 * @returns     the sample.
+                 */
+                auto sample(int index) const -> const Sample & {
+                    return samples.at((head+index) % samples.count());
+                }
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new FleetDashboardModel.
+             *
+             * @param[in]   parent the owner of the model.
+             */
+            explicit FleetDashboardModel(QObject *parent = nullptr);
+
+            /**
+             * @brief       Adds a snapshot of the fleet to the model.
+             *
+             * @param[in]   targets the targets of the fleet.
+             * @param[in]   hops the hops monitored by the fleet.
+             */
+            auto update(
+                    const QList<Nedrysoft::RouteAnalyser::FleetTarget> &targets,
+                    const QList<Nedrysoft::RouteAnalyser::FleetHop> &hops ) -> void;
+
+            /**
+             * @brief       Returns the state of a target.
+             *
+             * @param[in]   row the row of the target.
+             *
+             * @returns     the entry.
+             */
+            auto entry(int row) const -> const Entry &;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::rowCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of targets.
+             */
+            auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::columnCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of columns.
+             */
+            auto columnCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::data(const QModelIndex &index, int role).
+             *
+             * @details     The trend column is drawn by the delegate and returns no text.
+             *
+             * @param[in]   index the index of the cell.
+             * @param[in]   role the role.
+             *
+             * @returns     the data for the role.
+             */
+            auto data(const QModelIndex &index, int role = Qt::DisplayRole) const -> QVariant override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::headerData(int section, Qt::Orientation orientation,
+             *              int role).
+             *
+             * @param[in]   section the column.
+             * @param[in]   orientation the orientation of the header.
+             * @param[in]   role the role.
+             *
+             * @returns     the data for the role.
+             */
+            auto headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const ->
+                    QVariant override;
+
+        private:
+            /**
+             * @brief       Recalculates the latency, percentile and loss of a target from its history.
+             *
+             * @param[in]   entry the target.
+             */
+            static auto updateStatistics(Entry &entry) -> void;
+
+        private:
+            //! @cond
+
+            QVector<Entry> m_entries;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDMODEL_H
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FleetDashboardWidget.h"
+
+#include "FleetDashboardItemDelegate.h"
+#include "FleetDashboardModel.h"
+#include "IFleetMonitor.h"
+#include "IRouteEngineFactory.h"
+
+#include <ObjectRegistry>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMultiMap>
+#include <QTableView>
+#include <QTimer>
+#include <QVBoxLayout>
+
+constexpr auto MinimumSnapshotInterval = 1000;
+constexpr auto DashboardRowHeight = 22;
+constexpr auto TargetColumnWidth = 240;
+constexpr auto TrendColumnWidth = 180;
+constexpr auto ValueColumnWidth = 80;
+
+Nedrysoft::RouteAnalyser::FleetDashboardWidget::FleetDashboardWidget(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+        Nedrysoft::Core::IPVersion ipVersion,
+        const QStringList &hosts,
+        int interval,
+        QWidget *parent) :
+
+            QWidget(parent),
+            m_fleetMonitor(nullptr),
+            m_model(new Nedrysoft::RouteAnalyser::FleetDashboardModel(this)),
+            m_tableView(new QTableView),
+            m_snapshotTimer(new QTimer(this)) {
+
+    auto verticalLayout = new QVBoxLayout;
+
+#if (QT_VERSION_MAJOR>=6)
+    verticalLayout->setContentsMargins(0, 0, 0, 0);
+#else
+    verticalLayout->setMargin(0);
+#endif
+
+    setLayout(verticalLayout);
+
+    /**
+     * every row has the same fixed height so the view never asks the delegate to measure the rows, with hundreds
+     * of targets only the visible rows are laid out and painted.
+     */
+
+    m_tableView->setModel(m_model);
+    m_tableView->setItemDelegate(new Nedrysoft::RouteAnalyser::FleetDashboardItemDelegate(m_model, m_tableView));
+    m_tableView->setShowGrid(false);
+    m_tableView->setFrameStyle(QFrame::NoFrame);
+    m_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_tableView->verticalHeader()->setVisible(false);
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_tableView->verticalHeader()->setDefaultSectionSize(DashboardRowHeight);
+    m_tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    m_tableView->horizontalHeader()->setStretchLastSection(true);
+
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::FleetDashboardModel::TargetColumn, TargetColumnWidth);
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::FleetDashboardModel::TrendColumn, TrendColumnWidth);
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::FleetDashboardModel::LatencyColumn, ValueColumnWidth);
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::FleetDashboardModel::PercentileColumn, ValueColumnWidth);
+
+    verticalLayout->addWidget(m_tableView);
+
+    connect(m_tableView, &QTableView::activated, this, [=](const QModelIndex &index) {
+        if (index.isValid()) {
+            Q_EMIT targetActivated(m_model->entry(index.row()).host);
+        }
+    });
+
+    // the monitor is provided by the route engine with the highest priority that supports one.
+
+    QMultiMap<double, Nedrysoft::RouteAnalyser::IRouteEngineFactory *> sortedRouteEngines;
+
+    for (auto routeEngine : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IRouteEngineFactory>()) {
+        sortedRouteEngines.insert(1-routeEngine->priority(), routeEngine);
+    }
+
+    for (auto routeEngine : sortedRouteEngines) {
+        m_fleetMonitor = routeEngine->createFleetMonitor();
+
+        if (m_fleetMonitor) {
+            break;
+        }
+    }
+
+    if (!m_fleetMonitor) {
+        auto warningLabel = new QLabel(tr("None of the route engines are able to monitor a fleet of targets."));
+
+        warningLabel->setAlignment(Qt::AlignCenter);
+
+        verticalLayout->insertWidget(0, warningLabel);
+
+        return;
+    }
+
+    m_fleetMonitor->setTargets(hosts);
+    m_fleetMonitor->setInterval(interval);
+
+    /**
+     * the summary signal of the monitor is raised for every batch of results, the dashboard is instead updated
+     * from a snapshot once per interval so that each snapshot adds one point to the sparklines.
+     */
+
+    m_snapshotTimer->setInterval(qMax(interval, MinimumSnapshotInterval));
+
+    connect(m_snapshotTimer, &QTimer::timeout, this, [=]() {
+        m_model->update(m_fleetMonitor->targets(), m_fleetMonitor->hops());
+    });
+
+    if (m_fleetMonitor->start(pingEngineFactory, ipVersion)) {
+        m_model->update(m_fleetMonitor->targets(), m_fleetMonitor->hops());
+
+        m_snapshotTimer->start();
+    }
+}
+
+Nedrysoft::RouteAnalyser::FleetDashboardWidget::~FleetDashboardWidget() {
+    m_snapshotTimer->stop();
+
+    // the monitor is owned by the route engine factory, it is only stopped here.
+
+    if (m_fleetMonitor) {
+        m_fleetMonitor->stop();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDWIDGET_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDWIDGET_H
+
+#include <ICore>
+#include <QStringList>
+#include <QWidget>
+
+class QLabel;
+class QTableView;
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class FleetDashboardModel;
+    class IFleetMonitor;
+    class IPingEngineFactory;
+
+    /**
+     * @brief       The FleetDashboardWidget class shows a summary of every target of a fleet in a single table.
+     *
+     * @details     The targets are monitored by a fleet monitor, which shares one ping engine between all of the
+     *              routes.  A snapshot of the monitor is taken once per interval and drawn by a table view, so only
+     *              the rows that are visible are painted however many targets there are.  Activating a row asks
+     *              for the full route analysis of the target.
+     */
+    class FleetDashboardWidget :
+            public QWidget {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new FleetDashboardWidget.
+             *
+             * @param[in]   pingEngineFactory the factory used to create the shared ping engine.
+             * @param[in]   ipVersion the IP version to monitor.
+             * @param[in]   hosts the host names or addresses of the targets.
+             * @param[in]   interval the interval between requests to each hop in milliseconds.
+             * @param[in]   parent the owner widget.
+             */
+            FleetDashboardWidget(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                    Nedrysoft::Core::IPVersion ipVersion,
+                    const QStringList &hosts,
+                    int interval,
+                    QWidget *parent = nullptr );
+
+            /**
+             * @brief       Destroys the FleetDashboardWidget and stops monitoring.
+             */
+            ~FleetDashboardWidget() override;
+
+            /**
+             * @brief       Signal emitted when a target is activated to show its full route analysis.
+             *
+             * @param[in]   host the host name or address of the target.
+             */
+            Q_SIGNAL void targetActivated(const QString &host);
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::IFleetMonitor *m_fleetMonitor;
+            Nedrysoft::RouteAnalyser::FleetDashboardModel *m_model;
+            QTableView *m_tableView;
+            QTimer *m_snapshotTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FLEETDASHBOARDWIDGET_H
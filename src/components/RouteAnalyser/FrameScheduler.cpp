@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FrameScheduler.h"
+
+#include "FidelityGovernor.h"
+#include "QCustomPlot/qcustomplot.h"
+
+#include <Profiler>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWidget>
+#include <algorithm>
+#include <cmath>
+
+constexpr auto DefaultRefreshRate = 60.0;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+Nedrysoft::RouteAnalyser::FrameScheduler::FrameScheduler() :
+        m_frameDue(0) {
+
+    m_clock.start();
+
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+
+    connect(&m_frameTimer, &QTimer::timeout, this, &FrameScheduler::renderFrame);
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::getInstance() -> Nedrysoft::RouteAnalyser::FrameScheduler * {
+    static Nedrysoft::RouteAnalyser::FrameScheduler instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::replot(QCustomPlot *plot) -> void {
+    if (!plot) {
+        return;
+    }
+
+    m_plots.insert(plot, plot);
+
+    scheduleFrame();
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::replotLayer(QCPLayer *layer) -> void {
+    if (!layer) {
+        return;
+    }
+
+    m_layers.insert(layer, layer);
+
+    scheduleFrame();
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::update(QWidget *widget) -> void {
+    if (!widget) {
+        return;
+    }
+
+    m_widgets.insert(widget, widget);
+
+    scheduleFrame();
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::post(QObject *owner, std::function<void()> apply) -> void {
+    if (!owner) {
+        return;
+    }
+
+    m_states.insert(owner, qMakePair(QPointer<QObject>(owner), apply));
+
+    scheduleFrame();
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::frameInterval() -> int {
+    return refreshInterval()*Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->refreshFactor();
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::refreshInterval() -> int {
+    auto screen = QGuiApplication::primaryScreen();
+    auto refreshRate = screen ? screen->refreshRate() : DefaultRefreshRate;
+
+    if (refreshRate<=0) {
+        refreshRate = DefaultRefreshRate;
+    }
+
+    return std::max(1, static_cast<int>(std::floor(MillisecondsInSecond/refreshRate)));
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::scheduleFrame() -> void {
+    if (m_frameTimer.isActive()) {
+        return;
+    }
+
+    // a frame is drawn as soon as possible if the previous one was at least a frame interval ago.
+
+    auto delay = 0;
+
+    if (m_lastFrame.isValid()) {
+        delay = std::max(0, frameInterval()-static_cast<int>(m_lastFrame.elapsed()));
+    }
+
+    m_frameDue = m_clock.elapsed()+delay;
+
+    m_frameTimer.start(delay);
+}
+
+auto Nedrysoft::RouteAnalyser::FrameScheduler::renderFrame() -> void {
+    m_lastFrame.start();
+
+    // a frame that starts late is counted from when it was due, as a busy event loop is also falling behind.
+
+    auto frameStart = std::min(m_frameDue, m_clock.elapsed());
+
+    /**
+     * the posted state is applied first as it marks the plots and widgets it changes, anything marked while the
+     * frame is being drawn is left for the next frame.
+     */
+
+    auto states = m_states;
+
+    m_states.clear();
+
+    for (auto &state : states) {
+        if (state.first) {
+            state.second();
+        }
+    }
+
+    auto plots = m_plots;
+    auto layers = m_layers;
+    auto widgets = m_widgets;
+
+    m_plots.clear();
+    m_layers.clear();
+    m_widgets.clear();
+
+    for (auto &plot : plots) {
+        if (plot) {
+            PINGNOO_PROFILE_ZONE("Plot replot");
+
+            plot->replot(QCustomPlot::rpQueuedRefresh);
+        }
+    }
+
+    for (auto &layer : layers) {
+        if ((layer) && (!plots.contains(layer->parentPlot()))) {
+            PINGNOO_PROFILE_ZONE("Plot layer replot");
+
+            layer->replot();
+        }
+    }
+
+    for (auto &widget : widgets) {
+        if (widget) {
+            widget->update();
+        }
+    }
+
+    Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->recordFrame(
+        static_cast<double>(m_clock.elapsed()-frameStart),
+        refreshInterval()
+    );
+
+    PINGNOO_PROFILE_FRAME();
+}
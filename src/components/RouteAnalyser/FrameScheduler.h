@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_FRAMESCHEDULER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_FRAMESCHEDULER_H
+
+#include "RouteAnalyserSpec.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <functional>
+
+class QCPLayer;
+class QCustomPlot;
+class QWidget;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The FrameScheduler class repaints the plots and views of every editor at most once per frame.
+     *
+     * @details     Rather than replotting directly, the views mark what needs to be drawn and post state changes
+     *              (such as a new viewport or crosshair position) to the scheduler.  On each frame the latest state
+     *              posted by each owner is applied, then every dirty plot is replotted once, every dirty layer of a
+     *              plot that was not replotted is redrawn and every dirty widget is updated.  However many times a
+     *              plot is marked between two frames, and by however many editors, it is drawn once.
+     *
+     *              Frames are paced to the refresh rate of the primary screen and the clock only runs while there
+     *              is something to draw.  Objects that are destroyed before the next frame are skipped.  The time
+     *              taken by each frame is reported to the FidelityGovernor, which may lower the frame rate.
+     *
+     *              The scheduler must only be used from the main thread.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC FrameScheduler :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs a new FrameScheduler.
+             */
+            FrameScheduler();
+
+        public:
+            /**
+             * @brief       Returns the FrameScheduler instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> FrameScheduler *;
+
+            /**
+             * @brief       Marks a plot to be replotted on the next frame.
+             *
+             * @param[in]   plot the plot.
+             */
+            auto replot(QCustomPlot *plot) -> void;
+
+            /**
+             * @brief       Marks a layer of a plot to be redrawn on the next frame.
+             *
+             * @details     Only the layer is redrawn and composited over the buffers of the other layers, unless the
+             *              whole plot is also replotted on the same frame.
+             *
+             * @param[in]   layer the layer.
+             */
+            auto replotLayer(QCPLayer *layer) -> void;
+
+            /**
+             * @brief       Marks a widget to be updated on the next frame.
+             *
+             * @param[in]   widget the widget.
+             */
+            auto update(QWidget *widget) -> void;
+
+            /**
+             * @brief       Posts a state change to be applied at the start of the next frame.
+             *
+             * @details     Only the latest state posted by an owner is applied, a state posted earlier in the same
+             *              frame is replaced.  The state is discarded if the owner is destroyed first.
+             *
+             * @param[in]   owner the object that the state belongs to.
+             * @param[in]   apply the function that applies the state, this is expected to mark what it changes.
+             */
+            auto post(QObject *owner, std::function<void()> apply) -> void;
+
+            /**
+             * @brief       Returns the interval between frames.
+             *
+             * @returns     the interval in milliseconds.
+             */
+            auto frameInterval() -> int;
+
+        private:
+            /**
+             * @brief       Returns the refresh interval of the primary screen.
+             *
+             * @returns     the interval in milliseconds.
+             */
+            auto refreshInterval() -> int;
+
+            /**
+             * @brief       Starts the clock for the next frame if it is not already running.
+             */
+            auto scheduleFrame() -> void;
+
+            /**
+             * @brief       Applies the posted state and draws everything that has been marked.
+             */
+            auto renderFrame() -> void;
+
+        private:
+            //! @cond
+
+            QTimer m_frameTimer;
+            QElapsedTimer m_lastFrame;
+            QElapsedTimer m_clock;
+            qint64 m_frameDue;
+
+            QHash<QObject *, QPair<QPointer<QObject>, std::function<void()> > > m_states;
+            QHash<QCustomPlot *, QPointer<QCustomPlot> > m_plots;
+            QHash<QCPLayer *, QPointer<QCPLayer> > m_layers;
+            QHash<QWidget *, QPointer<QWidget> > m_widgets;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_FRAMESCHEDULER_H
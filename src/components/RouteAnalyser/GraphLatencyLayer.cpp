@@ -30,7 +30,10 @@
 #pragma warning(pop)
 
 #include "ColourManager.h"
+#include "FidelityGovernor.h"
+#include "PixmapCache.h"
 
+#include <Diagnostics>
 #include <cassert>
 
 constexpr auto RoundedRectangleRadius = 10;
@@ -38,12 +41,18 @@ constexpr auto TinyNumber = 0.0001;
 
 constexpr auto LatencyStopLineColour = Qt::black;
 
-constexpr auto UnusedRemovalTime = 5;
+constexpr auto UnusedRemovalTime = 5000;
+constexpr auto BufferBudget = 32*1024*1024;
+constexpr auto BufferSubsystem = "Latency layer pixmaps";
 
-//! @cond
-QMap<QString, QPixmap> Nedrysoft::RouteAnalyser::GraphLatencyLayer::m_buffers;
-QMap<QString, uint64_t> Nedrysoft::RouteAnalyser::GraphLatencyLayer::m_age;
-//! @endcond
+/**
+ * the buffers are shared by every plot in every editor, so the cache is bounded by size rather than by count.
+ */
+static auto buffers() -> Nedrysoft::RouteAnalyser::PixmapCache & {
+    static Nedrysoft::RouteAnalyser::PixmapCache cache(BufferBudget, BufferSubsystem);
+
+    return cache;
+}
 
 Nedrysoft::RouteAnalyser::GraphLatencyLayer::GraphLatencyLayer(QCustomPlot *customPlot) :
         QCPItemRect(customPlot) {
@@ -51,34 +60,16 @@ Nedrysoft::RouteAnalyser::GraphLatencyLayer::GraphLatencyLayer(QCustomPlot *cust
 }
 
 auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::invalidate() -> void {
-    m_buffers.clear();
-    m_age.clear();
+    buffers().clear();
 }
 
 auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::removeUnused() -> void {
-    QMutableMapIterator<QString, uint64_t> mapIterator(m_age);
-
-    //TODO: this should probably be protected with a mutex.
-
-    while(mapIterator.hasNext()) {
-        mapIterator.next();
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
-        auto secondsSinceEpoch = QDateTime::currentSecsSinceEpoch();
-#else
-        auto secondsSinceEpoch = abs(QDateTime::currentDateTime().secsTo(QDateTime(QDate(1970,1,1), QTime(0, 0))));
-#endif
-
-        if (secondsSinceEpoch-mapIterator.value()>UnusedRemovalTime) {
-            QString key = mapIterator.key();
-
-            m_buffers.remove(key);
-            m_age.remove(key);
-        }
-    }
+    buffers().removeUnused(UnusedRemovalTime);
 }
 
 auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::draw(QCPPainter *painter) -> void {
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Latency background draw (ms)");
+
     auto graphMaxLatency = parentPlot()->yAxis->range().upper;
     auto rect = parentPlot()->axisRect()->rect();
     auto topLeft = rect.topLeft();
@@ -87,19 +78,31 @@ auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::draw(QCPPainter *painter) -> v
 
     assert(latencySettings!=nullptr);
 
+    // gradients are drawn as solid bands while the drawing quality is lowered.
+
+    auto gradientFill = (latencySettings->gradientFill()) &&
+            (Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->gradientsEnabled());
+
     auto idealStop = latencySettings->warningValue()/graphMaxLatency;
     auto warningStop = latencySettings->criticalValue()/graphMaxLatency;
 
-    QString bufferName = QString("%1_%2_%3_%4_%5")
-            .arg(rect.size().width())
-            .arg(rect.size().height())
-            .arg(idealStop)
-            .arg(warningStop).arg(latencySettings->gradientFill());
+    auto bufferKey = quint64();
 
-    if (!m_buffers.contains(bufferName)) {
+    bufferKey = PixmapCache::combineKey(bufferKey, rect.size().width());
+    bufferKey = PixmapCache::combineKey(bufferKey, rect.size().height());
+    bufferKey = PixmapCache::combineKey(bufferKey, idealStop);
+    bufferKey = PixmapCache::combineKey(bufferKey, warningStop);
+    bufferKey = PixmapCache::combineKey(bufferKey, gradientFill);
+    bufferKey = PixmapCache::combineKey(bufferKey, latencySettings->idealColour());
+    bufferKey = PixmapCache::combineKey(bufferKey, latencySettings->warningColour());
+    bufferKey = PixmapCache::combineKey(bufferKey, latencySettings->criticalColour());
+
+    auto bufferedImage = QPixmap();
+
+    if (!buffers().find(bufferKey, &bufferedImage)) {
         rect.translate(-rect.left(), -rect.top());
 
-        QPixmap bufferedImage(rect.size());
+        bufferedImage = QPixmap(rect.size());
 
         QPainter bufferPainter(&bufferedImage);
 
@@ -114,7 +117,7 @@ auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::draw(QCPPainter *painter) -> v
                     graphGradient.setColorAt(0, QColor(latencySettings->idealColour()));
                     graphGradient.setColorAt(1, QColor(latencySettings->warningColour()));
 
-                    if (!latencySettings->gradientFill()) {
+                    if (!gradientFill) {
                         graphGradient.setColorAt(idealStop, QColor(latencySettings->warningColour()));
                         graphGradient.setColorAt(idealStop-TinyNumber, QColor(latencySettings->idealColour()));
                     }
@@ -125,7 +128,7 @@ auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::draw(QCPPainter *painter) -> v
                 graphGradient.setColorAt(warningStop, QColor(latencySettings->criticalColour()));
                 graphGradient.setColorAt(1, QColor(latencySettings->criticalColour()));
 
-                if (!latencySettings->gradientFill()) {
+                if (!gradientFill) {
                     graphGradient.setColorAt(idealStop-TinyNumber, QColor(latencySettings->idealColour()));
                     graphGradient.setColorAt(warningStop-TinyNumber, QColor(latencySettings->warningColour()));
                 }
@@ -167,22 +170,14 @@ auto Nedrysoft::RouteAnalyser::GraphLatencyLayer::draw(QCPPainter *painter) -> v
 
         bufferPainter.end();
 
-        m_buffers[bufferName] = bufferedImage;
+        buffers().insert(bufferKey, bufferedImage);
     }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
-    auto secondsSinceEpoch = QDateTime::currentSecsSinceEpoch();
-#else
-    auto secondsSinceEpoch = abs(QDateTime::currentDateTime().secsTo(QDateTime(QDate(1970,1,1), QTime(0, 0))));
-#endif
-
-    m_age[bufferName] = secondsSinceEpoch;
-
     QPainterPath clippingPath;
 
     clippingPath.addRoundedRect(parentPlot()->axisRect()->rect(), RoundedRectangleRadius, RoundedRectangleRadius);
 
     painter->setClipPath(clippingPath);
 
-    painter->drawPixmap(topLeft, m_buffers[bufferName]);
+    painter->drawPixmap(topLeft, bufferedImage);
 }
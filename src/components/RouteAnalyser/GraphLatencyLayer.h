@@ -44,6 +44,9 @@ namespace Nedrysoft { namespace RouteAnalyser {
 
             /**
              * @brief       Removes buffered offscreen background Pixmaps.
+             *
+             * @details     The buffers are held in a size bounded least recently used cache, this removes the
+             *              buffers that have not been drawn for a few seconds.
              */
             static auto removeUnused() -> void;
 
@@ -59,14 +62,6 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @param[in]   painter the QPainter to draw in.
              */
             auto draw(QCPPainter *painter) -> void;
-
-        private:
-            //! @cond
-
-            static QMap<QString, QPixmap> m_buffers;
-            static QMap<QString, uint64_t> m_age;
-
-            //! @endcond
     };
 }}
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopBaseline.h"
+
+#include <QDataStream>
+
+constexpr auto HoursPerDay = 24;
+constexpr auto MinimumSamples = 30;
+constexpr auto MedianQuantile = 0.5;
+
+Nedrysoft::RouteAnalyser::HopBaseline::HopBaseline() = default;
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::hourOfWeek(const QDateTime &dateTime) -> int {
+    return ((dateTime.date().dayOfWeek()-1)*HoursPerDay)+dateTime.time().hour();
+}
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::add(int hourOfWeek, double latency) -> void {
+    if ((hourOfWeek<0) || (hourOfWeek>=HoursPerWeek) || (latency<0)) {
+        return;
+    }
+
+    m_hours[static_cast<size_t>(hourOfWeek)].add(latency);
+    m_overall.add(latency);
+}
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::expectedLatency(int hourOfWeek) const -> double {
+    if ((hourOfWeek>=0) && (hourOfWeek<HoursPerWeek)) {
+        const auto &hour = m_hours[static_cast<size_t>(hourOfWeek)];
+
+        if (hour.count()>=MinimumSamples) {
+            return hour.quantile(MedianQuantile);
+        }
+    }
+
+    if (m_overall.count()>=MinimumSamples) {
+        return m_overall.quantile(MedianQuantile);
+    }
+
+    return -1;
+}
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::isEmpty() const -> bool {
+    return m_overall.isEmpty();
+}
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::save(QDataStream &stream) const -> void {
+    auto hourCount = quint8(0);
+
+    for (const auto &hour : m_hours) {
+        if (!hour.isEmpty()) {
+            hourCount++;
+        }
+    }
+
+    /**
+     * only the hours that have samples are written, a target that is monitored during working hours leaves most
+     * of the week empty.
+     */
+
+    stream << hourCount;
+
+    for (auto hour=0; hour<HoursPerWeek; hour++) {
+        if (!m_hours[static_cast<size_t>(hour)].isEmpty()) {
+            stream << static_cast<quint8>(hour);
+
+            m_hours[static_cast<size_t>(hour)].save(stream);
+        }
+    }
+
+    m_overall.save(stream);
+}
+
+auto Nedrysoft::RouteAnalyser::HopBaseline::load(QDataStream &stream) -> bool {
+    auto hours = std::array<Nedrysoft::RouteAnalyser::LatencySketch, HoursPerWeek>();
+    auto overall = Nedrysoft::RouteAnalyser::LatencySketch();
+    auto hourCount = quint8(0);
+
+    stream >> hourCount;
+
+    for (auto index=0; index<hourCount; index++) {
+        auto hour = quint8(0);
+
+        stream >> hour;
+
+        if ((stream.status()!=QDataStream::Ok) || (hour>=HoursPerWeek) || (!hours[hour].load(stream))) {
+            return false;
+        }
+    }
+
+    if (!overall.load(stream)) {
+        return false;
+    }
+
+    m_hours.swap(hours);
+    m_overall = overall;
+
+    return true;
+}
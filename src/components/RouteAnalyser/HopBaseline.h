@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPBASELINE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPBASELINE_H
+
+#include "LatencySketch.h"
+
+#include <QDateTime>
+#include <array>
+
+class QDataStream;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopBaseline class holds the usual latency of a hop.
+     *
+     * @details     Latencies are rolled up into one LatencySketch for each hour of the week, so that a hop that is
+     *              always slower during the evening is compared against its evenings rather than against the whole
+     *              week.  An hour that has not seen enough samples falls back to a sketch of every sample.  Adding
+     *              a sample takes constant time.
+     */
+    class HopBaseline {
+        public:
+            /**
+             * @brief       The number of rollup periods, one for each hour of the week.
+             */
+            static constexpr int HoursPerWeek = 7*24;
+
+            /**
+             * @brief       Constructs an empty HopBaseline.
+             */
+            HopBaseline();
+
+            /**
+             * @brief       Returns the rollup period of a time.
+             *
+             * @param[in]   dateTime the local time.
+             *
+             * @returns     the hour of the week, starting at midnight on Monday.
+             */
+            static auto hourOfWeek(const QDateTime &dateTime) -> int;
+
+            /**
+             * @brief       Adds a latency to the baseline.
+             *
+             * @param[in]   hourOfWeek the rollup period that the sample was taken in.
+             * @param[in]   latency the latency in seconds.
+             */
+            auto add(int hourOfWeek, double latency) -> void;
+
+            /**
+             * @brief       Returns the usual latency for a rollup period.
+             *
+             * @param[in]   hourOfWeek the rollup period.
+             *
+             * @returns     the median latency in seconds; otherwise -1 if there are not enough samples.
+             */
+            auto expectedLatency(int hourOfWeek) const -> double;
+
+            /**
+             * @brief       Returns whether the baseline holds any samples.
+             *
+             * @returns     true if no samples have been added; otherwise false.
+             */
+            auto isEmpty() const -> bool;
+
+            /**
+             * @brief       Writes the baseline to a stream.
+             *
+             * @param[in]   stream the stream to write to.
+             */
+            auto save(QDataStream &stream) const -> void;
+
+            /**
+             * @brief       Reads a baseline written by save(), replacing the contents of this baseline.
+             *
+             * @param[in]   stream the stream to read from.
+             *
+             * @returns     true if the baseline was read; otherwise false.
+             */
+            auto load(QDataStream &stream) -> bool;
+
+        private:
+            //! @cond
+
+            std::array<Nedrysoft::RouteAnalyser::LatencySketch, HoursPerWeek> m_hours;
+            Nedrysoft::RouteAnalyser::LatencySketch m_overall;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPBASELINE_H
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopCache.h"
+
+#include "IPingEngine.h"
+#include "IPingEngineFactory.h"
+#include "IPingTarget.h"
+#include "LatencySettings.h"
+#include "OverheadCalibrator.h"
+
+Nedrysoft::RouteAnalyser::HopCache::HopCache() :
+        m_nextSubscription(1),
+        m_overheadCompensation(false) {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        m_overheadCompensation = latencySettings->overheadCompensation();
+
+        connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::overheadCompensationChanged,
+            this,
+            [=](bool compensate) {
+
+            m_overheadCompensation = compensate;
+        });
+    }
+}
+
+Nedrysoft::RouteAnalyser::HopCache::~HopCache() {
+
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::getInstance() -> Nedrysoft::RouteAnalyser::HopCache * {
+    static Nedrysoft::RouteAnalyser::HopCache instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::subscribe(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+        Nedrysoft::Core::IPVersion ipVersion,
+        int interval,
+        int payloadSize,
+        bool dontFragment,
+        const QString &source,
+        bool aligned,
+        int probesPerRound,
+        const QHostAddress &targetAddress,
+        const QHostAddress &hopAddress,
+        int ttl,
+        std::function<void(const Nedrysoft::RouteAnalyser::PingResult &)> handler ) -> quint64 {
+
+    if ((!pingEngineFactory) || (targetAddress.isNull())) {
+        return 0;
+    }
+
+    auto engineKey = QString("%1/%2/%3/%4/%5/%6/%7/%8")
+            .arg(reinterpret_cast<quintptr>(pingEngineFactory))
+            .arg(static_cast<int>(ipVersion))
+            .arg(interval)
+            .arg(payloadSize)
+            .arg(dontFragment)
+            .arg(probesPerRound)
+            .arg(aligned)
+            .arg(source);
+
+    auto hopKey = QString("%1/%2/%3").arg(engineKey).arg(hopAddress.toString()).arg(ttl);
+
+    // a silent hop has no address of its own, it is only the same hop as another on the way to the same target.
+
+    if (hopAddress.isNull()) {
+        hopKey = QString("%1/*%2/%3").arg(engineKey).arg(targetAddress.toString()).arg(ttl);
+    }
+
+    if (!m_hops.contains(hopKey)) {
+        if (!m_engines.contains(engineKey)) {
+            auto engine = Engine();
+
+            engine.factory = pingEngineFactory;
+            engine.engine = pingEngineFactory->createEngine(ipVersion);
+            engine.version = ipVersion;
+
+            if (!engine.engine) {
+                return 0;
+            }
+
+            engine.engine->setInterval(interval);
+            engine.engine->setPayloadSize(payloadSize);
+            engine.engine->setDontFragment(dontFragment);
+
+            if (!source.isEmpty()) {
+                engine.engine->setSource(source);
+            }
+
+            if (aligned) {
+                engine.engine->setAligned(true);
+            }
+
+            if (probesPerRound>1) {
+                engine.engine->setProbesPerRound(probesPerRound);
+            }
+
+            /**
+             * the shared targets must follow the same flow as the route discovery that found the hops, otherwise
+             * a load balancer could send them to a different router at the same distance.
+             */
+
+            engine.engine->setFlowStable(true);
+
+            if (engine.engine->setResultBatching(true)) {
+                connect(
+                    engine.engine,
+                    &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+                    this,
+                    [=](QVector<Nedrysoft::RouteAnalyser::PingResult> results) {
+
+                    for (auto &result : results) {
+                        dispatch(result);
+                    }
+
+                    Q_EMIT resultsDispatched();
+                });
+            } else {
+                connect(
+                    engine.engine,
+                    &Nedrysoft::RouteAnalyser::IPingEngine::result,
+                    this,
+                    [=](Nedrysoft::RouteAnalyser::PingResult result) {
+
+                    dispatch(result);
+
+                    Q_EMIT resultsDispatched();
+                });
+            }
+
+            engine.engine->start();
+
+            Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance()->addEngine(pingEngineFactory, ipVersion);
+
+            m_engines[engineKey] = engine;
+        }
+
+        auto &engine = m_engines[engineKey];
+
+        auto hop = Hop();
+
+        hop.engineKey = engineKey;
+        hop.target = engine.engine->addTarget(targetAddress, ttl);
+
+        if (!hop.target) {
+            return 0;
+        }
+
+        engine.hops++;
+
+        m_targetHops[hop.target] = hopKey;
+        m_hops[hopKey] = hop;
+    }
+
+    auto subscription = m_nextSubscription++;
+
+    m_hops[hopKey].subscribers[subscription] = handler;
+    m_subscriptions[subscription] = hopKey;
+
+    updateSamplingDivisor(hopKey);
+
+    return subscription;
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::unsubscribe(quint64 subscription) -> void {
+    if (!m_subscriptions.contains(subscription)) {
+        return;
+    }
+
+    auto hopKey = m_subscriptions.take(subscription);
+    auto &hop = m_hops[hopKey];
+
+    hop.subscribers.remove(subscription);
+    hop.samplingDivisors.remove(subscription);
+
+    if (!hop.subscribers.isEmpty()) {
+        updateSamplingDivisor(hopKey);
+
+        return;
+    }
+
+    auto &engine = m_engines[hop.engineKey];
+
+    engine.engine->removeTarget(hop.target);
+
+    m_targetHops.remove(hop.target);
+
+    if (--engine.hops==0) {
+        engine.engine->stop();
+
+        engine.factory->deleteEngine(engine.engine);
+
+        Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance()->removeEngine(engine.factory, engine.version);
+
+        m_engines.remove(hop.engineKey);
+    }
+
+    m_hops.remove(hopKey);
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::setSamplingDivisor(quint64 subscription, int divisor) -> void {
+    if (!m_subscriptions.contains(subscription)) {
+        return;
+    }
+
+    auto hopKey = m_subscriptions.value(subscription);
+
+    m_hops[hopKey].samplingDivisors[subscription] = qMax(1, divisor);
+
+    updateSamplingDivisor(hopKey);
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::updateSamplingDivisor(const QString &hopKey) -> void {
+    auto &hop = m_hops[hopKey];
+
+    if (!hop.target) {
+        return;
+    }
+
+    // a subscriber that has not asked for a divisor needs every round.
+
+    auto divisor = 0;
+
+    for (auto subscription : hop.subscribers.keys()) {
+        auto subscriberDivisor = hop.samplingDivisors.value(subscription, 1);
+
+        divisor = divisor ? qMin(divisor, subscriberDivisor) : subscriberDivisor;
+    }
+
+    hop.target->setSamplingDivisor(qMax(1, divisor));
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::hopCount() -> int {
+    return m_hops.count();
+}
+
+auto Nedrysoft::RouteAnalyser::HopCache::dispatch(const Nedrysoft::RouteAnalyser::PingResult &result) -> void {
+    auto hopKey = m_targetHops.find(result.target());
+
+    if (hopKey==m_targetHops.end()) {
+        return;
+    }
+
+    auto hop = m_hops.find(hopKey.value());
+
+    if (hop==m_hops.end()) {
+        return;
+    }
+
+    /**
+     * a handler may unsubscribe, so the subscribers are copied before any of them are called.
+     */
+
+    auto subscribers = hop->subscribers;
+
+    if (m_overheadCompensation) {
+        auto &engine = m_engines[hop->engineKey];
+
+        auto compensatedResult = Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance()->compensate(
+            engine.factory,
+            engine.version,
+            result );
+
+        for (auto &handler : subscribers) {
+            handler(compensatedResult);
+        }
+
+        return;
+    }
+
+    for (auto &handler : subscribers) {
+        handler(result);
+    }
+}
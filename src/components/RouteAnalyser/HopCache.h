@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCACHE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCACHE_H
+
+#include "PingResult.h"
+
+#include <ICore>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngine;
+    class IPingEngineFactory;
+    class IPingTarget;
+
+    /**
+     * @brief       The HopCache class shares the monitoring of hops between route analyser editors.
+     *
+     * @details     Editors whose routes pass through the same router at the same distance would otherwise each
+     *              probe it, the cache keys every monitored hop by its address and TTL and holds a single ping
+     *              target for it, results for the target are passed to every subscriber.  Targets are created
+     *              on one shared engine for each combination of engine settings, a target is removed when its
+     *              last subscriber leaves and an engine is deleted when it has no targets.
+     */
+    class HopCache :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs the HopCache.
+             */
+            HopCache();
+
+        public:
+            /**
+             * @brief       Destroys the HopCache.
+             */
+            ~HopCache();
+
+            /**
+             * @brief       Returns the process wide instance of the cache.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> HopCache *;
+
+            /**
+             * @brief       Subscribes to the results of a hop.
+             *
+             * @details     If the hop is already monitored on an engine with the same settings the existing target
+             *              is shared; otherwise a target is created that probes the given destination with the
+             *              TTL of the hop.
+             *
+             * @param[in]   pingEngineFactory the factory that creates the engine.
+             * @param[in]   ipVersion the IP version of the engine.
+             * @param[in]   interval the interval between requests in milliseconds.
+             * @param[in]   payloadSize the payload size of the requests.
+             * @param[in]   dontFragment true if requests are sent with the don't fragment bit set.
+             * @param[in]   source the source address or interface the requests are sent from, empty for the default.
+             * @param[in]   aligned true if the rounds of the engine are aligned with other aligned engines.
+             * @param[in]   probesPerRound the number of requests sent to the hop in each round.
+             * @param[in]   targetAddress the destination that the hop was discovered on.
+             * @param[in]   hopAddress the address of the hop, or a null address for a hop that has not answered.
+             * @param[in]   ttl the distance of the hop from this host.
+             * @param[in]   handler the function called with each result for the hop.
+             *
+             * @returns     the subscription identifier, 0 if the hop could not be monitored.
+             */
+            auto subscribe(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                    Nedrysoft::Core::IPVersion ipVersion,
+                    int interval,
+                    int payloadSize,
+                    bool dontFragment,
+                    const QString &source,
+                    bool aligned,
+                    int probesPerRound,
+                    const QHostAddress &targetAddress,
+                    const QHostAddress &hopAddress,
+                    int ttl,
+                    std::function<void(const Nedrysoft::RouteAnalyser::PingResult &)> handler
+            ) -> quint64;
+
+            /**
+             * @brief       Removes a subscription.
+             *
+             * @param[in]   subscription the identifier returned by subscribe.
+             */
+            auto unsubscribe(quint64 subscription) -> void;
+
+            /**
+             * @brief       Sets how often a subscriber needs its hop to be probed.
+             *
+             * @details     A hop that is shared is probed as often as its most demanding subscriber requires.
+             *
+             * @param[in]   subscription the identifier returned by subscribe.
+             * @param[in]   divisor the hop is probed once every divisor rounds, 1 to probe it every round.
+             */
+            auto setSamplingDivisor(quint64 subscription, int divisor) -> void;
+
+            /**
+             * @brief       Returns the number of distinct hops being monitored.
+             *
+             * @returns     the number of hops.
+             */
+            auto hopCount() -> int;
+
+            /**
+             * @brief       This signal is emitted after the results of a batch have been passed to the subscribers.
+             *
+             * @details     Subscribers that do per batch work (such as rescaling graphs) can defer it until this
+             *              signal rather than repeating it for every result.
+             */
+            Q_SIGNAL void resultsDispatched();
+
+        private:
+            /**
+             * @brief       Passes a result to the subscribers of the hop that it belongs to.
+             *
+             * @param[in]   result the ping result.
+             */
+            auto dispatch(const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Applies the sampling divisor required by the subscribers of a hop to its target.
+             *
+             * @param[in]   hopKey the key of the hop.
+             */
+            auto updateSamplingDivisor(const QString &hopKey) -> void;
+
+        private:
+            //! @cond
+
+            /**
+             * @brief       A shared engine and the settings that it was created with.
+             */
+            struct Engine {
+                Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;
+                Nedrysoft::RouteAnalyser::IPingEngine *engine = nullptr;
+                Nedrysoft::Core::IPVersion version = Nedrysoft::Core::IPVersion::V4;
+                int hops = 0;
+            };
+
+            /**
+             * @brief       A monitored hop and its subscribers.
+             */
+            struct Hop {
+                QString engineKey;
+                Nedrysoft::RouteAnalyser::IPingTarget *target = nullptr;
+                QHash<quint64, std::function<void(const Nedrysoft::RouteAnalyser::PingResult &)> > subscribers;
+                QHash<quint64, int> samplingDivisors;
+            };
+
+            QHash<QString, Engine> m_engines;
+            QHash<QString, Hop> m_hops;
+            QHash<Nedrysoft::RouteAnalyser::IPingTarget *, QString> m_targetHops;
+            QHash<quint64, QString> m_subscriptions;
+
+            quint64 m_nextSubscription;
+            bool m_overheadCompensation;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCACHE_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopColumns.h"
+
+Nedrysoft::RouteAnalyser::HopColumns::HopColumns() {
+    m_maximumRows.fill(-1);
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::resize(int hopCount) -> void {
+    for (auto &values : m_values) {
+        auto previousCount = values.count();
+
+        values.resize(hopCount);
+
+        for (auto row=previousCount;row<hopCount;row++) {
+            values[row] = -1;
+        }
+    }
+
+    for (auto &maximumRow : m_maximumRows) {
+        if (maximumRow>=hopCount) {
+            maximumRow = -1;
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::hopCount() const -> int {
+    return m_values[0].count();
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::setValue(
+        Nedrysoft::RouteAnalyser::HopColumns::Column column,
+        int row,
+        double value ) -> void {
+
+    auto &values = m_values[static_cast<size_t>(column)];
+
+    if ((row<0) || (row>=values.count())) {
+        return;
+    }
+
+    values[row] = value;
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::value(
+        Nedrysoft::RouteAnalyser::HopColumns::Column column,
+        int row ) const -> double {
+
+    auto &values = m_values[static_cast<size_t>(column)];
+
+    if ((row<0) || (row>=values.count())) {
+        return -1;
+    }
+
+    return values.at(row);
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::updateMaximums() -> QVector<int> {
+    auto changedRows = QVector<int>();
+
+    for (auto column=0;column<ColumnCount;column++) {
+        auto values = m_values[static_cast<size_t>(column)].constData();
+        auto count = m_values[static_cast<size_t>(column)].count();
+        auto maximumRow = -1;
+        auto maximum = 0.0;
+
+        // hops without a value are negative and a zero latency is not worth highlighting, so the scan starts at 0.
+
+        for (auto row=0;row<count;row++) {
+            if (values[row]>maximum) {
+                maximum = values[row];
+                maximumRow = row;
+            }
+        }
+
+        auto &previousRow = m_maximumRows[static_cast<size_t>(column)];
+
+        if (maximumRow==previousRow) {
+            continue;
+        }
+
+        if ((previousRow>=0) && (!changedRows.contains(previousRow))) {
+            changedRows.append(previousRow);
+        }
+
+        if ((maximumRow>=0) && (!changedRows.contains(maximumRow))) {
+            changedRows.append(maximumRow);
+        }
+
+        previousRow = maximumRow;
+    }
+
+    return changedRows;
+}
+
+auto Nedrysoft::RouteAnalyser::HopColumns::isMaximum(
+        Nedrysoft::RouteAnalyser::HopColumns::Column column,
+        int row ) const -> bool {
+
+    return (row>=0) && (m_maximumRows[static_cast<size_t>(column)]==row);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCOLUMNS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCOLUMNS_H
+
+#include <QVector>
+#include <array>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopColumns class holds the frequently updated numeric values of every hop in a route.
+     *
+     * @details     Each column is stored as a contiguous array indexed by row, so that updating a hop touches a
+     *              handful of doubles and finding the maximum of a column is a single linear pass rather than a
+     *              walk over the hop objects.  A negative value means that the hop has no value for the column.
+     */
+    class HopColumns {
+        public:
+            /**
+             * @brief       The columns held for each hop.
+             */
+            enum class Column {
+                AverageLatency,
+                MinimumLatency,
+                MaximumLatency,
+                CurrentLatency
+            };
+
+            /**
+             * @brief       The number of columns.
+             */
+            static constexpr int ColumnCount = 4;
+
+        public:
+            /**
+             * @brief       Constructs an empty HopColumns.
+             */
+            HopColumns();
+
+            /**
+             * @brief       Sets the number of hops, new hops have no values.
+             *
+             * @param[in]   hopCount the number of hops.
+             */
+            auto resize(int hopCount) -> void;
+
+            /**
+             * @brief       Returns the number of hops.
+             *
+             * @returns     the number of hops.
+             */
+            auto hopCount() const -> int;
+
+            /**
+             * @brief       Sets the value of a hop.
+             *
+             * @param[in]   column the column.
+             * @param[in]   row the row of the hop.
+             * @param[in]   value the value, negative if the hop has no value.
+             */
+            auto setValue(Column column, int row, double value) -> void;
+
+            /**
+             * @brief       Returns the value of a hop.
+             *
+             * @param[in]   column the column.
+             * @param[in]   row the row of the hop.
+             *
+             * @returns     the value, negative if the hop has no value.
+             */
+            auto value(Column column, int row) const -> double;
+
+            /**
+             * @brief       Finds the hop holding the maximum of each column.
+             *
+             * @details     Where hops share the maximum the first of them is chosen, so that the highlighted row
+             *              does not move between equal values.
+             *
+             * @returns     the rows whose maximum state has changed.
+             */
+            auto updateMaximums() -> QVector<int>;
+
+            /**
+             * @brief       Returns whether a hop holds the maximum of a column.
+             *
+             * @note        The state is as of the last call to updateMaximums.
+             *
+             * @param[in]   column the column.
+             * @param[in]   row the row of the hop.
+             *
+             * @returns     true if the hop holds the maximum; otherwise false.
+             */
+            auto isMaximum(Column column, int row) const -> bool;
+
+        private:
+            //! @cond
+
+            std::array<QVector<double>, ColumnCount> m_values;
+            std::array<int, ColumnCount> m_maximumRows;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPCOLUMNS_H
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopIdentityTable.h"
+
+#include <IHostMaskerManager>
+
+constexpr auto NoReplyText = "*";
+
+Nedrysoft::RouteAnalyser::HopIdentityTable::HopIdentityTable() :
+        m_generation(0) {
+
+    Identity noReply;
+
+    noReply.hostAddress = NoReplyText;
+    noReply.hostName = NoReplyText;
+    noReply.autonomousSystemResolved = true;
+
+    m_identities.append(noReply);
+    m_masked.append(Masked());
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+
+    if (hostMaskerManager) {
+        connect(
+            hostMaskerManager,
+            &Nedrysoft::Core::IHostMaskerManager::maskersChanged,
+            this,
+            [=]() {
+
+            m_generation++;
+        });
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance() -> Nedrysoft::RouteAnalyser::HopIdentityTable * {
+    static Nedrysoft::RouteAnalyser::HopIdentityTable instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::intern(const QHostAddress &address) -> quint32 {
+    if (address.isNull()) {
+        return NoReply;
+    }
+
+    auto it = m_ids.constFind(address);
+
+    if (it!=m_ids.constEnd()) {
+        return it.value();
+    }
+
+    auto id = static_cast<quint32>(m_identities.count());
+
+    Identity identity;
+
+    identity.address = address;
+    identity.hostAddress = address.toString();
+    identity.hostName = identity.hostAddress;
+
+    m_identities.append(identity);
+    m_masked.append(Masked());
+
+    m_ids.insert(address, id);
+
+    return id;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::identity(
+        quint32 id ) const -> const Nedrysoft::RouteAnalyser::HopIdentityTable::Identity & {
+
+    if (id>=static_cast<quint32>(m_identities.count())) {
+        return m_identities[NoReply];
+    }
+
+    return m_identities[static_cast<int>(id)];
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::setHostName(quint32 id, const QString &hostName) -> void {
+    if ((id==NoReply) || (id>=static_cast<quint32>(m_identities.count()))) {
+        return;
+    }
+
+    m_identities[static_cast<int>(id)].hostName = hostName;
+
+    // the masked name is derived from the host name, so it must be masked again.
+
+    m_masked[static_cast<int>(id)].hop = -1;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::setLocation(quint32 id, const QString &location) -> void {
+    if ((id==NoReply) || (id>=static_cast<quint32>(m_identities.count()))) {
+        return;
+    }
+
+    m_identities[static_cast<int>(id)].location = location;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::setAutonomousSystem(
+        quint32 id,
+        quint32 asNumber,
+        const QString &owner ) -> void {
+
+    if ((id==NoReply) || (id>=static_cast<quint32>(m_identities.count()))) {
+        return;
+    }
+
+    auto &identity = m_identities[static_cast<int>(id)];
+
+    identity.asNumber = asNumber;
+    identity.asOwner = owner;
+    identity.autonomousSystemResolved = true;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::maskedHostName(quint32 id, int hop) -> QString {
+    return masked(id, hop).hostName;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::maskedHostAddress(quint32 id, int hop) -> QString {
+    return masked(id, hop).hostAddress;
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::count() const -> int {
+    return m_identities.count();
+}
+
+auto Nedrysoft::RouteAnalyser::HopIdentityTable::masked(
+        quint32 id,
+        int hop ) -> const Nedrysoft::RouteAnalyser::HopIdentityTable::Masked & {
+
+    if (id>=static_cast<quint32>(m_identities.count())) {
+        id = NoReply;
+    }
+
+    auto &identity = m_identities[static_cast<int>(id)];
+    auto &masked = m_masked[static_cast<int>(id)];
+
+    if ((masked.hop==hop) && (masked.generation==m_generation)) {
+        return masked;
+    }
+
+    masked.hop = hop;
+    masked.generation = m_generation;
+    masked.hostName = identity.hostName;
+    masked.hostAddress = identity.hostAddress;
+
+    // the unanswered hop is never masked, there is nothing in it to hide.
+
+    if (id==NoReply) {
+        return masked;
+    }
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+
+    if (hostMaskerManager) {
+        hostMaskerManager->mask(hop, identity.hostName, identity.hostAddress, masked.hostName, masked.hostAddress);
+    }
+
+    return masked;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPIDENTITYTABLE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPIDENTITYTABLE_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopIdentityTable class interns the identity of every hop address seen by the process.
+     *
+     * @details     Each distinct address is given a compact id that holds its textual address, host name, location
+     *              and autonomous system, rows refer to the id rather than holding their own copies of the strings.
+     *              The masked forms are computed on first use and kept until the hop number changes or the
+     *              maskers are reconfigured, so that repainting a row does not build a masking key.
+     *
+     *              Identities are never removed, the table grows with the number of distinct routers seen during
+     *              the lifetime of the application.  The table must only be used from the GUI thread.
+     */
+    class HopIdentityTable :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The id of the identity used by hops that have not replied.
+             */
+            static constexpr quint32 NoReply = 0;
+
+            /**
+             * @brief       The identity of a hop address.
+             */
+            struct Identity {
+                QHostAddress address;
+                QString hostAddress;
+                QString hostName;
+                QString location;
+                quint32 asNumber = 0;
+                QString asOwner;
+                bool autonomousSystemResolved = false;
+            };
+
+        private:
+            /**
+             * @brief       Constructs the HopIdentityTable.
+             */
+            HopIdentityTable();
+
+        public:
+            /**
+             * @brief       Returns the process wide instance of the table.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> HopIdentityTable *;
+
+            /**
+             * @brief       Returns the id of an address, adding it to the table if it has not been seen before.
+             *
+             * @details     A new identity uses the address as its host name until setHostName is called.
+             *
+             * @param[in]   address the address of the hop, a null address returns NoReply.
+             *
+             * @returns     the id.
+             */
+            auto intern(const QHostAddress &address) -> quint32;
+
+            /**
+             * @brief       Returns the identity for an id.
+             *
+             * @param[in]   id the id returned by intern.
+             *
+             * @returns     the identity, the NoReply identity if the id is unknown.
+             */
+            auto identity(quint32 id) const -> const Identity &;
+
+            /**
+             * @brief       Sets the host name of an identity.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   hostName the resolved host name.
+             */
+            auto setHostName(quint32 id, const QString &hostName) -> void;
+
+            /**
+             * @brief       Sets the location of an identity.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   location the location.
+             */
+            auto setLocation(quint32 id, const QString &location) -> void;
+
+            /**
+             * @brief       Sets the autonomous system of an identity.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   asNumber the AS number, 0 if the address is not in a known AS.
+             * @param[in]   owner the name of the organisation that owns the AS.
+             */
+            auto setAutonomousSystem(quint32 id, quint32 asNumber, const QString &owner) -> void;
+
+            /**
+             * @brief       Returns the masked host name of an identity.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   hop the hop number that the identity is displayed at.
+             *
+             * @returns     the masked host name.
+             */
+            auto maskedHostName(quint32 id, int hop) -> QString;
+
+            /**
+             * @brief       Returns the masked address of an identity.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   hop the hop number that the identity is displayed at.
+             *
+             * @returns     the masked address.
+             */
+            auto maskedHostAddress(quint32 id, int hop) -> QString;
+
+            /**
+             * @brief       Returns the number of identities in the table.
+             *
+             * @returns     the number of identities, including NoReply.
+             */
+            auto count() const -> int;
+
+        private:
+            /**
+             * @brief       The masked forms of an identity.
+             */
+            struct Masked {
+                int hop = -1;
+                quint64 generation = 0;
+                QString hostName;
+                QString hostAddress;
+            };
+
+            /**
+             * @brief       Returns the masked forms of an identity, masking it again if they are out of date.
+             *
+             * @param[in]   id the id returned by intern.
+             * @param[in]   hop the hop number that the identity is displayed at.
+             *
+             * @returns     the masked forms.
+             */
+            auto masked(quint32 id, int hop) -> const Masked &;
+
+        private:
+            //! @cond
+
+            QVector<Identity> m_identities;
+            QVector<Masked> m_masked;
+            QHash<QHostAddress, quint32> m_ids;
+
+            quint64 m_generation;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPIDENTITYTABLE_H
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopRoundSeries.h"
+
+#include <algorithm>
+#include <limits>
+
+constexpr double RoundQuantiles[] = {0, 0.1, 0.25, 0.5, 0.75, 0.9, 1};
+constexpr auto LateRounds = 4ul;
+
+static_assert(
+    sizeof(RoundQuantiles)/sizeof(RoundQuantiles[0])==Nedrysoft::RouteAnalyser::HopRoundSeries::QuantileCount,
+    "the quantile table must match the quantiles held for each round" );
+
+Nedrysoft::RouteAnalyser::HopRoundSeries::HopRoundSeries(int capacity) :
+        m_capacity(std::max(capacity, 1)),
+        m_head(0),
+        m_count(0),
+        m_probesPerRound(1),
+        m_pending(false),
+        m_hasSample(false),
+        m_lastSample(0),
+        m_pendingTime(-1),
+        m_pendingLost(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::setProbesPerRound(int probes) -> void {
+    m_probesPerRound = std::max(probes, 1);
+
+    m_pendingSamples.reserve(m_probesPerRound);
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::add(
+        unsigned long sampleNumber,
+        double time,
+        double roundTripTime,
+        bool lost ) -> bool {
+
+    /**
+     * a result for one of the last few rounds arrives late when its request timed out after the next round had
+     * started, a sample number far behind the newest is an engine that has been restarted and begins a new round.
+     */
+
+    auto late = (m_hasSample) &&
+                ((sampleNumber<m_lastSample) || ((!m_pending) && (sampleNumber==m_lastSample))) &&
+                (m_lastSample-sampleNumber<=LateRounds);
+
+    if (late) {
+        addLate(sampleNumber, lost);
+
+        return false;
+    }
+
+    auto completed = false;
+
+    if ((m_pending) && (sampleNumber!=m_lastSample)) {
+        completeRound();
+
+        completed = true;
+    }
+
+    if (!m_pending) {
+        m_pending = true;
+        m_pendingTime = time;
+        m_pendingLost = 0;
+        m_pendingSamples.clear();
+    }
+
+    m_hasSample = true;
+    m_lastSample = sampleNumber;
+    m_pendingTime = std::min(m_pendingTime, time);
+
+    if (lost) {
+        m_pendingLost++;
+    } else {
+        m_pendingSamples.push_back(static_cast<float>(roundTripTime));
+    }
+
+    if (static_cast<int>(m_pendingSamples.size())+m_pendingLost>=m_probesPerRound) {
+        completeRound();
+
+        completed = true;
+    }
+
+    return completed;
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::completeRound() -> void {
+    m_pending = false;
+
+    if (m_rounds.empty()) {
+        m_rounds.resize(m_capacity);
+    }
+
+    auto next = (m_head+m_count) % m_capacity;
+
+    if (m_count==m_capacity) {
+        m_head = (m_head+1) % m_capacity;
+    } else {
+        m_count++;
+    }
+
+    auto &round = m_rounds[next];
+    auto replies = static_cast<int>(m_pendingSamples.size());
+
+    round.time = m_pendingTime;
+    round.sampleNumber = static_cast<uint32_t>(m_lastSample);
+    round.replies = static_cast<uint16_t>(std::min(replies, static_cast<int>(std::numeric_limits<uint16_t>::max())));
+    round.lost = static_cast<uint16_t>(std::min(m_pendingLost, static_cast<int>(std::numeric_limits<uint16_t>::max())));
+
+    // with only a handful of samples the quantiles are exact, they are interpolated between the sorted samples.
+
+    std::sort(m_pendingSamples.begin(), m_pendingSamples.end());
+
+    for (auto index=0;index<QuantileCount;index++) {
+        if (!replies) {
+            round.quantiles[index] = -1;
+
+            continue;
+        }
+
+        auto position = RoundQuantiles[index]*(replies-1);
+        auto lower = static_cast<int>(position);
+        auto upper = std::min(lower+1, replies-1);
+        auto fraction = static_cast<float>(position-lower);
+
+        round.quantiles[index] = m_pendingSamples[lower]+(m_pendingSamples[upper]-m_pendingSamples[lower])*fraction;
+    }
+
+    m_pendingSamples.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::addLate(unsigned long sampleNumber, bool lost) -> void {
+    // the quantiles of a completed round are not revisited, a late loss is still counted against it.
+
+    if (!lost) {
+        return;
+    }
+
+    auto first = std::max(0, m_count-static_cast<int>(LateRounds)-1);
+
+    for (auto index=m_count-1;index>=first;index--) {
+        auto &round = m_rounds[(m_head+index) % m_capacity];
+
+        if (round.sampleNumber==static_cast<uint32_t>(sampleNumber)) {
+            if (round.lost<std::numeric_limits<uint16_t>::max()) {
+                round.lost++;
+            }
+
+            return;
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::clear() -> void {
+    m_head = 0;
+    m_count = 0;
+    m_pending = false;
+    m_hasSample = false;
+    m_lastSample = 0;
+    m_pendingLost = 0;
+
+    m_pendingSamples.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::count() const -> int {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::round(int index) const -> const Round & {
+    return m_rounds[(m_head+index) % m_capacity];
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::lowerBound(double time) const -> int {
+    auto first = 0;
+    auto last = m_count;
+
+    while (first<last) {
+        auto middle = first+(last-first)/2;
+
+        if (round(middle).time<time) {
+            first = middle+1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+auto Nedrysoft::RouteAnalyser::HopRoundSeries::quantile(int index) -> double {
+    return RoundQuantiles[std::max(0, std::min(index, QuantileCount-1))];
+}
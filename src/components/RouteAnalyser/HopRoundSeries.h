@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPROUNDSERIES_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPROUNDSERIES_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopRoundSeries class stores a summary of each multi-probe round of a hop.
+     *
+     * @details     When the engine sends several requests to a hop in every round the results are grouped by their
+     *              sample number and each round is reduced to a fixed set of quantiles (the median and the bands
+     *              either side of it) as soon as it is complete.  The summaries are held in a fixed capacity ring
+     *              that is allocated when the first round completes, so a hop probed once per round costs nothing.
+     *
+     *              A round is complete when every request has been answered or has timed out, or when a result
+     *              for a later round arrives.  A loss reported after its round was completed is still counted.
+     */
+    class HopRoundSeries {
+        public:
+            /**
+             * @brief       The number of quantiles held for each round.
+             */
+            static constexpr int QuantileCount = 7;
+
+            /**
+             * @brief       The index of the median in the quantiles of a round.
+             */
+            static constexpr int MedianIndex = 3;
+
+            /**
+             * @brief       The summary of one round.
+             */
+            struct Round {
+                double time;                        //! the first request time in seconds since the unix epoch.
+                uint32_t sampleNumber;              //! the sample number of the round.
+                float quantiles[QuantileCount];     //! the round trip time quantiles in seconds, in ascending order.
+                uint16_t replies;                   //! the number of requests that were answered.
+                uint16_t lost;                      //! the number of requests that were not answered.
+
+                /**
+                 * @brief       Returns the median round trip time of the round.
+                 *
+                 * @returns     the median in seconds; otherwise -1 if no request was answered.
+                 */
+                auto median() const -> double {
+                    return replies ? quantiles[MedianIndex] : -1;
+                }
+            };
+
+        public:
+            /**
+             * @brief       Constructs a HopRoundSeries.
+             *
+             * @param[in]   capacity the maximum number of rounds held.
+             */
+            explicit HopRoundSeries(int capacity = DefaultCapacity);
+
+            /**
+             * @brief       Sets the number of requests that make up a round.
+             *
+             * @param[in]   probes the number of requests per round.
+             */
+            auto setProbesPerRound(int probes) -> void;
+
+            /**
+             * @brief       Adds a result to the round that it belongs to.
+             *
+             * @param[in]   sampleNumber the sample number of the result.
+             * @param[in]   time the request time in seconds since the unix epoch.
+             * @param[in]   roundTripTime the round trip time in seconds, ignored for a lost request.
+             * @param[in]   lost true if the request was not answered; otherwise false.
+             *
+             * @returns     true if a round was completed; otherwise false.
+             */
+            auto add(unsigned long sampleNumber, double time, double roundTripTime, bool lost) -> bool;
+
+            /**
+             * @brief       Removes all rounds, including the round being collected.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of completed rounds held.
+             *
+             * @returns     the number of rounds.
+             */
+            auto count() const -> int;
+
+            /**
+             * @brief       Returns a completed round.
+             *
+             * @param[in]   index the index of the round, 0 is the oldest.
+             *
+             * @returns     the round.
+             */
+            auto round(int index) const -> const Round &;
+
+            /**
+             * @brief       Returns the index of the first round at or after the given time.
+             *
+             * @param[in]   time the time in seconds since the unix epoch.
+             *
+             * @returns     the index; otherwise count() if every round is earlier.
+             */
+            auto lowerBound(double time) const -> int;
+
+            /**
+             * @brief       Returns the quantile that is held at an index.
+             *
+             * @param[in]   index the index, 0 to QuantileCount-1.
+             *
+             * @returns     the quantile (0 to 1).
+             */
+            static auto quantile(int index) -> double;
+
+        public:
+            /**
+             * @brief       The default capacity, a day of rounds at one round per second.
+             */
+            static constexpr int DefaultCapacity = 86400;
+
+        private:
+            //! @cond
+
+            auto completeRound() -> void;
+
+            auto addLate(unsigned long sampleNumber, bool lost) -> void;
+
+            std::vector<Round> m_rounds;
+
+            int m_capacity;
+            int m_head;
+            int m_count;
+            int m_probesPerRound;
+
+            bool m_pending;
+            bool m_hasSample;
+            unsigned long m_lastSample;
+            double m_pendingTime;
+            int m_pendingLost;
+            std::vector<float> m_pendingSamples;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPROUNDSERIES_H
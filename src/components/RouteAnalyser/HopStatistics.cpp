@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopStatistics.h"
+
+constexpr auto NanosecondsInSecond = 1.0e9;
+
+Nedrysoft::RouteAnalyser::HopStatistics::HopStatistics() :
+        m_sampleNumber(0),
+        m_replyCount(0),
+        m_timeoutCount(0),
+        m_currentLatency(-1),
+        m_minimumLatency(-1),
+        m_maximumLatency(-1),
+        m_oneWayCount(0),
+        m_currentForwardDelay(-1),
+        m_currentReverseDelay(-1) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::add(const Nedrysoft::RouteAnalyser::PingResult &result) -> void {
+    m_sampleNumber = result.sampleNumber();
+
+    if (Nedrysoft::RouteAnalyser::PingResult::isLost(result.code())) {
+        m_timeoutCount++;
+
+        m_lossStatistics.add(true);
+
+        return;
+    }
+
+    m_lossStatistics.add(false);
+
+    m_currentLatency = result.roundTripTime();
+
+    if ((m_minimumLatency<0) || (m_currentLatency<m_minimumLatency)) {
+        m_minimumLatency = m_currentLatency;
+    }
+
+    if ((m_maximumLatency<0) || (m_currentLatency>m_maximumLatency)) {
+        m_maximumLatency = m_currentLatency;
+    }
+
+    m_latencyStatistics.add(m_currentLatency);
+    m_latencySketch.add(m_currentLatency);
+    m_jitterStatistics.add(m_currentLatency);
+    m_changePointDetector.add(static_cast<double>(result.requestTimestamp())/NanosecondsInSecond, m_currentLatency);
+
+    // the one way delays are offset by any difference between the clocks, the jitter of each direction is not.
+
+    if (result.hasOneWayDelays()) {
+        m_currentForwardDelay = result.forwardDelay();
+        m_currentReverseDelay = result.reverseDelay();
+
+        m_forwardJitterStatistics.add(m_currentForwardDelay);
+        m_reverseJitterStatistics.add(m_currentReverseDelay);
+
+        m_oneWayCount++;
+    }
+
+    m_replyCount++;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::sampleNumber() const -> unsigned long {
+    return m_sampleNumber;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::replyCount() const -> unsigned long {
+    return m_replyCount;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::timeoutCount() const -> unsigned long {
+    return m_timeoutCount;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::currentLatency() const -> double {
+    return m_currentLatency;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::minimumLatency() const -> double {
+    return m_minimumLatency;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::maximumLatency() const -> double {
+    return m_maximumLatency;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::packetLoss() const -> double {
+    if (m_replyCount+m_timeoutCount==0) {
+        return -1;
+    }
+
+    return (static_cast<double>(m_timeoutCount)/static_cast<double>(m_replyCount+m_timeoutCount))*100.0;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::latencyStatistics() const ->
+        const Nedrysoft::RouteAnalyser::RunningStatistics & {
+
+    return m_latencyStatistics;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::latencySketch() const -> const Nedrysoft::RouteAnalyser::LatencySketch & {
+    return m_latencySketch;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::jitterStatistics() const ->
+        const Nedrysoft::RouteAnalyser::JitterStatistics & {
+
+    return m_jitterStatistics;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::lossStatistics() const ->
+        const Nedrysoft::RouteAnalyser::LossStatistics & {
+
+    return m_lossStatistics;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::currentForwardDelay() const -> double {
+    return m_oneWayCount ? m_currentForwardDelay : -1;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::currentReverseDelay() const -> double {
+    return m_oneWayCount ? m_currentReverseDelay : -1;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::forwardJitterStatistics() const ->
+        const Nedrysoft::RouteAnalyser::JitterStatistics & {
+
+    return m_forwardJitterStatistics;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::reverseJitterStatistics() const ->
+        const Nedrysoft::RouteAnalyser::JitterStatistics & {
+
+    return m_reverseJitterStatistics;
+}
+
+auto Nedrysoft::RouteAnalyser::HopStatistics::changePoints() const ->
+        const QVector<Nedrysoft::RouteAnalyser::ChangePoint> & {
+
+    return m_changePointDetector.changePoints();
+}
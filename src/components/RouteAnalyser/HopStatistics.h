@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPSTATISTICS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPSTATISTICS_H
+
+#include "ChangePointDetector.h"
+#include "JitterStatistics.h"
+#include "LatencySketch.h"
+#include "LossStatistics.h"
+#include "PingResult.h"
+#include "RouteAnalyserSpec.h"
+#include "RunningStatistics.h"
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopStatistics class holds the aggregates of the results received for a hop.
+     *
+     * @details     The aggregates are value types with no reference to the table or plots, so they can be
+     *              maintained away from the GUI thread and copied to it as a snapshot.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC HopStatistics {
+        public:
+            /**
+             * @brief       Constructs an empty HopStatistics.
+             */
+            HopStatistics();
+
+            /**
+             * @brief       Adds a result to the aggregates.
+             *
+             * @param[in]   result the result.
+             */
+            auto add(const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Returns the sample number of the most recent result.
+             *
+             * @returns     the sample number.
+             */
+            auto sampleNumber() const -> unsigned long;
+
+            /**
+             * @brief       Returns the number of replies.
+             *
+             * @returns     the number of replies.
+             */
+            auto replyCount() const -> unsigned long;
+
+            /**
+             * @brief       Returns the number of requests that were not answered.
+             *
+             * @returns     the number of timeouts.
+             */
+            auto timeoutCount() const -> unsigned long;
+
+            /**
+             * @brief       Returns the round trip time of the most recent reply.
+             *
+             * @returns     the latency in seconds; otherwise -1 if there have been no replies.
+             */
+            auto currentLatency() const -> double;
+
+            /**
+             * @brief       Returns the minimum round trip time.
+             *
+             * @returns     the latency in seconds; otherwise -1 if there have been no replies.
+             */
+            auto minimumLatency() const -> double;
+
+            /**
+             * @brief       Returns the maximum round trip time.
+             *
+             * @returns     the latency in seconds; otherwise -1 if there have been no replies.
+             */
+            auto maximumLatency() const -> double;
+
+            /**
+             * @brief       Returns the packet loss over the lifetime of the hop.
+             *
+             * @returns     the percentage of requests lost; otherwise -1 if there have been no results.
+             */
+            auto packetLoss() const -> double;
+
+            /**
+             * @brief       Returns the mean and variance of the round trip times.
+             *
+             * @returns     the latency statistics.
+             */
+            auto latencyStatistics() const -> const Nedrysoft::RouteAnalyser::RunningStatistics &;
+
+            /**
+             * @brief       Returns the percentile sketch of the round trip times.
+             *
+             * @returns     the latency sketch.
+             */
+            auto latencySketch() const -> const Nedrysoft::RouteAnalyser::LatencySketch &;
+
+            /**
+             * @brief       Returns the jitter statistics.
+             *
+             * @returns     the jitter statistics.
+             */
+            auto jitterStatistics() const -> const Nedrysoft::RouteAnalyser::JitterStatistics &;
+
+            /**
+             * @brief       Returns the windowed loss and loss burst statistics.
+             *
+             * @returns     the loss statistics.
+             */
+            auto lossStatistics() const -> const Nedrysoft::RouteAnalyser::LossStatistics &;
+
+            /**
+             * @brief       Returns the forward delay of the most recent reply that carried one way delays.
+             *
+             * @returns     the delay in seconds; otherwise -1 if no reply has carried one way delays.
+             */
+            auto currentForwardDelay() const -> double;
+
+            /**
+             * @brief       Returns the reverse delay of the most recent reply that carried one way delays.
+             *
+             * @returns     the delay in seconds; otherwise -1 if no reply has carried one way delays.
+             */
+            auto currentReverseDelay() const -> double;
+
+            /**
+             * @brief       Returns the jitter statistics of the forward delays.
+             *
+             * @returns     the jitter statistics.
+             */
+            auto forwardJitterStatistics() const -> const Nedrysoft::RouteAnalyser::JitterStatistics &;
+
+            /**
+             * @brief       Returns the jitter statistics of the reverse delays.
+             *
+             * @returns     the jitter statistics.
+             */
+            auto reverseJitterStatistics() const -> const Nedrysoft::RouteAnalyser::JitterStatistics &;
+
+            /**
+             * @brief       Returns the change points detected in the latency of the hop.
+             *
+             * @returns     the change points in time order.
+             */
+            auto changePoints() const -> const QVector<Nedrysoft::RouteAnalyser::ChangePoint> &;
+
+        private:
+            //! @cond
+
+            unsigned long m_sampleNumber;
+            unsigned long m_replyCount;
+            unsigned long m_timeoutCount;
+
+            double m_currentLatency;
+            double m_minimumLatency;
+            double m_maximumLatency;
+
+            unsigned long m_oneWayCount;
+            double m_currentForwardDelay;
+            double m_currentReverseDelay;
+
+            Nedrysoft::RouteAnalyser::RunningStatistics m_latencyStatistics;
+            Nedrysoft::RouteAnalyser::LatencySketch m_latencySketch;
+            Nedrysoft::RouteAnalyser::JitterStatistics m_jitterStatistics;
+            Nedrysoft::RouteAnalyser::LossStatistics m_lossStatistics;
+            Nedrysoft::RouteAnalyser::JitterStatistics m_forwardJitterStatistics;
+            Nedrysoft::RouteAnalyser::JitterStatistics m_reverseJitterStatistics;
+            Nedrysoft::RouteAnalyser::ChangePointDetector m_changePointDetector;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPSTATISTICS_H
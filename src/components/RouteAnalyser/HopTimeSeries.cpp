@@ -0,0 +1,612 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HopTimeSeries.h"
+
+#include "SampleKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr auto NoRoundTripTime = -1.0f;
+constexpr double RollupResolutions[] = {1, 10, 60, 600};
+constexpr auto RollupLevels = static_cast<int>(sizeof(RollupResolutions)/sizeof(RollupResolutions[0]));
+constexpr auto FirstSketchLevel = 1;
+constexpr auto MinimumSketchRollups = 30;
+constexpr auto MinimumSummaryRollups = 4;
+
+Nedrysoft::RouteAnalyser::HopTimeSeries::HopTimeSeries(int capacity) :
+        m_capacity(std::max(capacity, 1)),
+        m_head(0),
+        m_count(0) {
+
+    /**
+     * the arrays are allocated up front so that the memory used by the hop is fixed from the start.
+     */
+
+    m_times.resize(m_capacity);
+    m_roundTripTimes.resize(m_capacity);
+    m_codes.resize(m_capacity);
+
+    /**
+     * each resolution holds enough rollups to cover the raw samples at one sample per second.
+     */
+
+    for (auto level=0;level<RollupLevels;level++) {
+        auto rollupCapacity = static_cast<int>(std::ceil(m_capacity/RollupResolutions[level]))+1;
+
+        auto sketchCapacity = (level>=FirstSketchLevel) ? rollupCapacity : 0;
+
+        m_rollupRings.push_back(RollupRing {
+            std::vector<Rollup>(rollupCapacity),
+            std::vector<Nedrysoft::RouteAnalyser::LatencySketch>(sketchCapacity),
+            0,
+            0
+        });
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::position(int index) const -> int {
+    return (m_head+index) % m_capacity;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::append(
+        double time,
+        double roundTripTime,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode code ) -> bool {
+
+    auto discarded = (m_count==m_capacity);
+    auto next = position(m_count % m_capacity);
+
+    // the oldest sample is moved into the compressed archive before its slot is reused.
+
+    m_times[next] = time;
+    m_codes[next] = static_cast<uint8_t>(code);
+
+    if (Nedrysoft::RouteAnalyser::PingResult::isLost(code)) {
+        m_roundTripTimes[next] = NoRoundTripTime;
+    } else {
+        m_roundTripTimes[next] = static_cast<float>(roundTripTime);
+    }
+
+    if (discarded) {
+        m_archive.append(
+                m_times[next],
+                m_roundTripTimes[next],
+                static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(m_codes[next]) );
+
+        m_head = (m_head+1) % m_capacity;
+    } else {
+        m_count++;
+    }
+
+    addToRollups(time, roundTripTime, code);
+
+    return discarded;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::addToRollups(
+        double time,
+        double roundTripTime,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode code ) -> void {
+
+    for (auto level=0;level<RollupLevels;level++) {
+        auto &ring = m_rollupRings[level];
+        auto capacity = static_cast<int>(ring.rollups.size());
+        auto rollupTime = std::floor(time/RollupResolutions[level])*RollupResolutions[level];
+        Rollup *current = nullptr;
+        Nedrysoft::RouteAnalyser::LatencySketch *sketch = nullptr;
+        auto slot = -1;
+
+        if (ring.count) {
+            auto &last = ring.rollups[(ring.head+ring.count-1) % capacity];
+
+            if (last.time==rollupTime) {
+                current = &last;
+                slot = (ring.head+ring.count-1) % capacity;
+            } else if (last.time>rollupTime) {
+                // a late result belongs to an earlier rollup, it is added if that rollup is still held.
+
+                auto index = rollupLowerBound(level, time);
+
+                if ((index>=ring.count) || (rollup(level, index).time!=rollupTime)) {
+                    continue;
+                }
+
+                slot = (ring.head+index) % capacity;
+                current = &ring.rollups[slot];
+            }
+        }
+
+        if (!current) {
+            if (ring.count==capacity) {
+                ring.head = (ring.head+1) % capacity;
+            } else {
+                ring.count++;
+            }
+
+            slot = (ring.head+ring.count-1) % capacity;
+            current = &ring.rollups[slot];
+
+            *current = Rollup {rollupTime, 0, 0, 0, 0, 0};
+
+            if (!ring.sketches.empty()) {
+                ring.sketches[slot].clear();
+            }
+        }
+
+        if (!ring.sketches.empty()) {
+            sketch = &ring.sketches[slot];
+        }
+
+        if (Nedrysoft::RouteAnalyser::PingResult::isLost(code)) {
+            current->lost++;
+
+            continue;
+        }
+
+        auto value = static_cast<float>(roundTripTime);
+
+        if ((!current->count) || (value<current->minimum)) {
+            current->minimum = value;
+        }
+
+        if ((!current->count) || (value>current->maximum)) {
+            current->maximum = value;
+        }
+
+        current->sum += roundTripTime;
+        current->count++;
+
+        if (sketch) {
+            sketch->add(roundTripTime);
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::clear() -> void {
+    m_head = 0;
+    m_count = 0;
+
+    m_archive.clear();
+
+    for (auto &ring : m_rollupRings) {
+        ring.head = 0;
+        ring.count = 0;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::rollupLevels() -> int {
+    return RollupLevels;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::resolution(int level) -> double {
+    return RollupResolutions[std::min(std::max(level, 0), RollupLevels-1)];
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::levelFor(double span, int pixels) -> int {
+    if (pixels<=0) {
+        return -1;
+    }
+
+    auto secondsPerPixel = span/pixels;
+    auto level = -1;
+
+    for (auto current=0;current<RollupLevels;current++) {
+        if (RollupResolutions[current]<=secondsPerPixel) {
+            level = current;
+        }
+    }
+
+    return level;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::rollupCount(int level) const -> int {
+    return m_rollupRings[level].count;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::rollup(int level, int index) const -> const Rollup & {
+    auto &ring = m_rollupRings[level];
+
+    return ring.rollups[(ring.head+index) % static_cast<int>(ring.rollups.size())];
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::rollupLowerBound(int level, double time) const -> int {
+    auto first = 0;
+    auto last = rollupCount(level);
+
+    while (first<last) {
+        auto middle = first+(last-first)/2;
+
+        if (rollup(level, middle).time+RollupResolutions[level]<=time) {
+            first = middle+1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::count() const -> int {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::capacity() const -> int {
+    return m_capacity;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::setCapacity(int capacity) -> void {
+    capacity = std::max(capacity, 1);
+
+    if (capacity==m_capacity) {
+        return;
+    }
+
+    auto discarded = std::max(m_count-capacity, 0);
+
+    for (auto index=0;index<discarded;index++) {
+        auto slot = position(index);
+
+        m_archive.append(
+                m_times[slot],
+                m_roundTripTimes[slot],
+                static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(m_codes[slot]) );
+    }
+
+    /**
+     * the remaining samples are copied into new arrays in time order, new arrays are used rather than resizing so
+     * that the memory is returned when the capacity is reduced.
+     */
+
+    auto count = m_count-discarded;
+    auto times = std::vector<double>(capacity);
+    auto roundTripTimes = std::vector<float>(capacity);
+    auto codes = std::vector<uint8_t>(capacity);
+
+    for (auto index=0;index<count;index++) {
+        auto slot = position(discarded+index);
+
+        times[index] = m_times[slot];
+        roundTripTimes[index] = m_roundTripTimes[slot];
+        codes[index] = m_codes[slot];
+    }
+
+    m_times.swap(times);
+    m_roundTripTimes.swap(roundTripTimes);
+    m_codes.swap(codes);
+
+    m_capacity = capacity;
+    m_head = 0;
+    m_count = count;
+
+    resizeRollups(m_rollupRings[0], static_cast<int>(std::ceil(m_capacity/RollupResolutions[0]))+1);
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::resizeRollups(RollupRing &ring, int capacity) -> void {
+    auto previousCapacity = static_cast<int>(ring.rollups.size());
+
+    if (capacity==previousCapacity) {
+        return;
+    }
+
+    // the newest rollups are kept.
+
+    auto count = std::min(ring.count, capacity);
+    auto first = ring.count-count;
+    auto rollups = std::vector<Rollup>(capacity);
+    auto sketches = std::vector<Nedrysoft::RouteAnalyser::LatencySketch>(ring.sketches.empty() ? 0 : capacity);
+
+    for (auto index=0;index<count;index++) {
+        auto slot = (ring.head+first+index) % previousCapacity;
+
+        rollups[index] = ring.rollups[slot];
+
+        if (!sketches.empty()) {
+            sketches[index] = std::move(ring.sketches[slot]);
+        }
+    }
+
+    ring.rollups.swap(rollups);
+    ring.sketches.swap(sketches);
+    ring.head = 0;
+    ring.count = count;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::setArchiveBlocks(int blocks) -> void {
+    m_archive.setMaximumBlocks(blocks);
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::memoryUsage() const -> size_t {
+    auto size = sizeof(HopTimeSeries)+
+                m_times.capacity()*sizeof(double)+
+                m_roundTripTimes.capacity()*sizeof(float)+
+                m_codes.capacity()*sizeof(uint8_t)+
+                m_archive.encodedSize();
+
+    for (auto &ring : m_rollupRings) {
+        size += ring.rollups.capacity()*sizeof(Rollup);
+
+        for (auto &sketch : ring.sketches) {
+            size += sketch.memoryUsage();
+        }
+    }
+
+    return size;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::sampleSize() -> size_t {
+    return sizeof(double)+sizeof(float)+sizeof(uint8_t)+
+           static_cast<size_t>(std::ceil(sizeof(Rollup)/RollupResolutions[0]));
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::time(int index) const -> double {
+    return m_times[position(index)];
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::roundTripTime(int index) const -> double {
+    return m_roundTripTimes[position(index)];
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::code(int index) const -> Nedrysoft::RouteAnalyser::PingResult::ResultCode {
+    return static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(m_codes[position(index)]);
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::firstTime() const -> double {
+    if (!m_count) {
+        return -1;
+    }
+
+    return time(0);
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::lastTime() const -> double {
+    if (!m_count) {
+        return -1;
+    }
+
+    return time(m_count-1);
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::segments() const -> std::vector<Segment> {
+    auto segments = std::vector<Segment>();
+
+    if (!m_count) {
+        return segments;
+    }
+
+    auto first = std::min(m_count, m_capacity-m_head);
+
+    segments.push_back(Segment{m_times.data()+m_head, m_roundTripTimes.data()+m_head, m_codes.data()+m_head, first});
+
+    if (first<m_count) {
+        segments.push_back(Segment{m_times.data(), m_roundTripTimes.data(), m_codes.data(), m_count-first});
+    }
+
+    return segments;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::lowerBound(double time) const -> int {
+    auto first = 0;
+    auto last = m_count;
+
+    while (first<last) {
+        auto middle = first+(last-first)/2;
+
+        if (this->time(middle)<time) {
+            first = middle+1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::sketch(
+        double start,
+        double end ) const -> Nedrysoft::RouteAnalyser::LatencySketch {
+
+    auto level = FirstSketchLevel;
+
+    for (auto current=FirstSketchLevel;current<RollupLevels;current++) {
+        if ((end-start)/RollupResolutions[current]>=MinimumSketchRollups) {
+            level = current;
+        }
+    }
+
+    auto &ring = m_rollupRings[level];
+    auto capacity = static_cast<int>(ring.rollups.size());
+    auto result = Nedrysoft::RouteAnalyser::LatencySketch();
+
+    for (auto index=rollupLowerBound(level, start);index<ring.count;index++) {
+        if (rollup(level, index).time>end) {
+            break;
+        }
+
+        result.merge(ring.sketches[(ring.head+index) % capacity]);
+    }
+
+    return result;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::decimate(
+        double start,
+        double end,
+        int columns ) const -> std::vector<Column> {
+
+    auto result = std::vector<Column>();
+
+    if ((columns<=0) || (end<=start)) {
+        return result;
+    }
+
+    auto columnWidth = (end-start)/columns;
+    auto level = levelFor(end-start, columns);
+    auto envelope = std::vector<Column>(static_cast<size_t>(columns), Column{0, 0, 0, false, false});
+
+    auto accumulate = [&](double time, double minimum, double maximum, bool replied, bool lost) {
+        auto index = std::min(std::max(static_cast<int>((time-start)/columnWidth), 0), columns-1);
+        auto &column = envelope[static_cast<size_t>(index)];
+
+        if (replied) {
+            if (column.replied) {
+                column.minimum = std::min(column.minimum, minimum);
+                column.maximum = std::max(column.maximum, maximum);
+            } else {
+                column.minimum = minimum;
+                column.maximum = maximum;
+                column.replied = true;
+            }
+        }
+
+        column.lost |= lost;
+    };
+
+    if (level<0) {
+        auto last = lowerBound(end);
+
+        for (auto index=lowerBound(start);index<last;index++) {
+            auto roundTripTime = this->roundTripTime(index);
+
+            accumulate(
+                time(index),
+                roundTripTime,
+                roundTripTime,
+                roundTripTime>=0,
+                Nedrysoft::RouteAnalyser::PingResult::isLost(code(index)) );
+        }
+    } else {
+        auto halfResolution = RollupResolutions[level]/2;
+
+        for (auto index=rollupLowerBound(level, start);index<rollupCount(level);index++) {
+            auto &current = rollup(level, index);
+
+            if (current.time>end) {
+                break;
+            }
+
+            accumulate(current.time+halfResolution, current.minimum, current.maximum, current.count>0, current.lost>0);
+        }
+    }
+
+    for (auto index=0;index<columns;index++) {
+        auto &column = envelope[static_cast<size_t>(index)];
+
+        if ((column.replied) || (column.lost)) {
+            column.time = start+(index+0.5)*columnWidth;
+
+            result.push_back(column);
+        }
+    }
+
+    return result;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::summarise(double start, double end) const -> Rollup {
+    auto summary = Rollup {start, 0, 0, 0, 0, 0};
+
+    if (end<=start) {
+        return summary;
+    }
+
+    auto level = -1;
+
+    for (auto current=0;current<RollupLevels;current++) {
+        if ((end-start)/RollupResolutions[current]>=MinimumSummaryRollups) {
+            level = current;
+        }
+    }
+
+    if (level<0) {
+        summariseSamples(lowerBound(start), lowerBound(end), summary);
+
+        return summary;
+    }
+
+    /**
+     * the rollups cover the whole intervals inside the period, the raw samples cover the partial intervals at
+     * either end.
+     */
+
+    auto resolution = RollupResolutions[level];
+    auto interiorStart = std::ceil(start/resolution)*resolution;
+    auto interiorEnd = std::floor(end/resolution)*resolution;
+
+    summariseSamples(lowerBound(start), lowerBound(interiorStart), summary);
+
+    for (auto index=rollupLowerBound(level, interiorStart);index<rollupCount(level);index++) {
+        auto &current = rollup(level, index);
+
+        if (current.time>=interiorEnd) {
+            break;
+        }
+
+        if (current.count) {
+            if (summary.count) {
+                summary.minimum = std::min(summary.minimum, current.minimum);
+                summary.maximum = std::max(summary.maximum, current.maximum);
+            } else {
+                summary.minimum = current.minimum;
+                summary.maximum = current.maximum;
+            }
+        }
+
+        summary.sum += current.sum;
+        summary.count += current.count;
+        summary.lost += current.lost;
+    }
+
+    summariseSamples(lowerBound(interiorEnd), lowerBound(end), summary);
+
+    return summary;
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::summariseSamples(int first, int last, Rollup &summary) const -> void {
+    if (first>=last) {
+        return;
+    }
+
+    // the samples occupy at most two runs of the ring, each is handed to the kernel as a contiguous array.
+
+    auto start = position(first);
+    auto run = std::min(last-first, m_capacity-start);
+
+    Nedrysoft::RouteAnalyser::SampleKernels::summarise(
+            m_roundTripTimes.data()+start,
+            m_codes.data()+start,
+            run,
+            summary );
+
+    if (run<last-first) {
+        Nedrysoft::RouteAnalyser::SampleKernels::summarise(
+                m_roundTripTimes.data(),
+                m_codes.data(),
+                last-first-run,
+                summary );
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::HopTimeSeries::archive() const -> const Nedrysoft::RouteAnalyser::CompressedSeries & {
+    return m_archive;
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_HOPTIMESERIES_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_HOPTIMESERIES_H
+
+#include "CompressedSeries.h"
+#include "LatencySketch.h"
+#include "PingResult.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The HopTimeSeries class stores the result history of a hop.
+     *
+     * @details     The history is held as separate arrays of request times, round trip times and result codes in
+     *              a fixed capacity ring, once full the oldest sample is moved out for each new one, so the raw
+     *              storage used by a hop is allocated once and does not grow however long the route is monitored.
+     *
+     *              Samples moved out of the ring are kept in a compressed archive at a few bytes each, which
+     *              extends the history that can be exported well beyond the ring at a bounded cost.
+     *
+     *              Samples are indexed from 0 (the oldest) to count()-1 (the newest), results are expected to
+     *              arrive in request order.
+     *
+     *              Alongside the raw samples the series maintains rollups at 1 second, 10 second, 1 minute and
+     *              10 minute resolutions covering the same span, a view that spans more time than it has pixels
+     *              reads the coarsest rollup that still fits its width so the cost of drawing it depends on the
+     *              width rather than the length of the run.
+     *
+     *              The rollups from 10 seconds upwards also hold a latency sketch, the percentiles of a period
+     *              are found by merging the sketches that cover it.
+     */
+    class HopTimeSeries {
+        public:
+            /**
+             * @brief       The summary of the samples in one interval of a rollup.
+             */
+            struct Rollup {
+                double time;                        //! the start of the interval in seconds since the unix epoch.
+                float minimum;                      //! the minimum round trip time in seconds.
+                float maximum;                      //! the maximum round trip time in seconds.
+                double sum;                         //! the sum of the round trip times in seconds.
+                int count;                          //! the number of replies.
+                int lost;                           //! the number of requests that were not answered.
+
+                /**
+                 * @brief       Returns the mean round trip time of the interval.
+                 *
+                 * @returns     the mean in seconds; otherwise -1 if there were no replies.
+                 */
+                auto mean() const -> double {
+                    return count ? sum/count : -1;
+                }
+
+                /**
+                 * @brief       Returns the packet loss of the interval.
+                 *
+                 * @returns     the fraction of requests that were not answered.
+                 */
+                auto loss() const -> double {
+                    return (count+lost) ? static_cast<double>(lost)/(count+lost) : 0;
+                }
+            };
+
+            /**
+             * @brief       The envelope of the samples that fall in one pixel column of a view.
+             */
+            struct Column {
+                double time;                        //! the centre of the column in seconds since the unix epoch.
+                double minimum;                     //! the minimum round trip time in seconds.
+                double maximum;                     //! the maximum round trip time in seconds.
+                bool replied;                       //! true if any request in the column was answered.
+                bool lost;                          //! true if any request in the column was not answered.
+            };
+
+            /**
+             * @brief       A contiguous run of samples in the storage of the series.
+             */
+            struct Segment {
+                const double *times;                //! the request times in seconds since the unix epoch.
+                const float *roundTripTimes;        //! the round trip times in seconds; negative if unknown.
+                const uint8_t *codes;               //! the result codes.
+                int count;                          //! the number of samples in the run.
+            };
+
+        public:
+            /**
+             * @brief       Constructs a HopTimeSeries.
+             *
+             * @param[in]   capacity the maximum number of samples held.
+             */
+            explicit HopTimeSeries(int capacity = DefaultCapacity);
+
+            /**
+             * @brief       Appends a sample, archiving the oldest sample if the series is full.
+             *
+             * @param[in]   time the request time in seconds since the unix epoch.
+             * @param[in]   roundTripTime the round trip time in seconds, ignored for a result without a reply.
+             * @param[in]   code the result code.
+             *
+             * @returns     true if the oldest sample was moved to the archive; otherwise false.
+             */
+            auto append(double time, double roundTripTime, Nedrysoft::RouteAnalyser::PingResult::ResultCode code) -> bool;
+
+            /**
+             * @brief       Removes all samples.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of samples held.
+             *
+             * @returns     the number of samples.
+             */
+            auto count() const -> int;
+
+            /**
+             * @brief       Returns the maximum number of samples held.
+             *
+             * @returns     the capacity.
+             */
+            auto capacity() const -> int;
+
+            /**
+             * @brief       Changes the maximum number of samples held.
+             *
+             * @details     When the capacity is reduced the oldest samples that no longer fit are moved into the
+             *              archive, exactly as they would have been by append.  The finest rollups cover the same
+             *              span as the raw samples and are resized with them, the coarser rollups keep their span
+             *              so the summary of the older history is not lost.
+             *
+             * @param[in]   capacity the maximum number of samples.
+             */
+            auto setCapacity(int capacity) -> void;
+
+            /**
+             * @brief       Sets the number of blocks that the archive holds, discarding the oldest if there are more.
+             *
+             * @param[in]   blocks the number of blocks.
+             */
+            auto setArchiveBlocks(int blocks) -> void;
+
+            /**
+             * @brief       Returns the number of bytes used by the series.
+             *
+             * @returns     the number of bytes used by the samples, rollups, sketches and archive.
+             */
+            auto memoryUsage() const -> size_t;
+
+            /**
+             * @brief       Returns the number of bytes used by each raw sample.
+             *
+             * @details     This includes the share of the finest rollups, which are sized with the raw samples.
+             *
+             * @returns     the number of bytes.
+             */
+            static auto sampleSize() -> size_t;
+
+            /**
+             * @brief       Returns the request time of a sample.
+             *
+             * @param[in]   index the index of the sample.
+             *
+             * @returns     the request time in seconds since the unix epoch.
+             */
+            auto time(int index) const -> double;
+
+            /**
+             * @brief       Returns the round trip time of a sample.
+             *
+             * @param[in]   index the index of the sample.
+             *
+             * @returns     the round trip time in seconds; otherwise -1 if there was no reply.
+             */
+            auto roundTripTime(int index) const -> double;
+
+            /**
+             * @brief       Returns the result code of a sample.
+             *
+             * @param[in]   index the index of the sample.
+             *
+             * @returns     the result code.
+             */
+            auto code(int index) const -> Nedrysoft::RouteAnalyser::PingResult::ResultCode;
+
+            /**
+             * @brief       Returns the request time of the oldest sample.
+             *
+             * @returns     the request time; otherwise -1 if the series is empty.
+             */
+            auto firstTime() const -> double;
+
+            /**
+             * @brief       Returns the request time of the newest sample.
+             *
+             * @returns     the request time; otherwise -1 if the series is empty.
+             */
+            auto lastTime() const -> double;
+
+            /**
+             * @brief       Returns the samples as runs of the underlying storage.
+             *
+             * @details     The samples are held in a ring, so they occupy at most two runs, which are returned in
+             *              time order.  This allows the samples to be written out without being copied.
+             *
+             * @returns     the runs.
+             */
+            auto segments() const -> std::vector<Segment>;
+
+            /**
+             * @brief       Returns the index of the first sample at or after the given time.
+             *
+             * @param[in]   time the request time in seconds since the unix epoch.
+             *
+             * @returns     the index; otherwise count() if every sample is earlier.
+             */
+            auto lowerBound(double time) const -> int;
+
+            /**
+             * @brief       Returns the number of rollup resolutions.
+             *
+             * @returns     the number of resolutions.
+             */
+            static auto rollupLevels() -> int;
+
+            /**
+             * @brief       Returns the interval covered by each rollup of a resolution.
+             *
+             * @param[in]   level the resolution, 0 is the finest.
+             *
+             * @returns     the interval in seconds.
+             */
+            static auto resolution(int level) -> double;
+
+            /**
+             * @brief       Returns the coarsest resolution that provides at least one rollup per pixel.
+             *
+             * @param[in]   span the time covered by the view in seconds.
+             * @param[in]   pixels the width of the view in pixels.
+             *
+             * @returns     the resolution; otherwise -1 if the view should use the raw samples.
+             */
+            static auto levelFor(double span, int pixels) -> int;
+
+            /**
+             * @brief       Returns the number of rollups held at a resolution.
+             *
+             * @param[in]   level the resolution.
+             *
+             * @returns     the number of rollups.
+             */
+            auto rollupCount(int level) const -> int;
+
+            /**
+             * @brief       Returns a rollup.
+             *
+             * @param[in]   level the resolution.
+             * @param[in]   index the index of the rollup, 0 is the oldest.
+             *
+             * @returns     the rollup.
+             */
+            auto rollup(int level, int index) const -> const Rollup &;
+
+            /**
+             * @brief       Returns the index of the first rollup that ends after the given time.
+             *
+             * @param[in]   level the resolution.
+             * @param[in]   time the time in seconds since the unix epoch.
+             *
+             * @returns     the index; otherwise rollupCount() if every rollup ends earlier.
+             */
+            auto rollupLowerBound(int level, double time) const -> int;
+
+            /**
+             * @brief       Returns a latency sketch of the replies received within a period.
+             *
+             * @details     The sketch is merged from the coarsest rollups that still divide the period into a
+             *              reasonable number of intervals, the rollups at either end are included in full.
+             *
+             * @param[in]   start the start of the period in seconds since the unix epoch.
+             * @param[in]   end the end of the period in seconds since the unix epoch.
+             *
+             * @returns     the sketch of the period.
+             */
+            auto sketch(double start, double end) const -> Nedrysoft::RouteAnalyser::LatencySketch;
+
+            /**
+             * @brief       Reduces a period to the minimum and maximum round trip time of each pixel column.
+             *
+             * @details     The samples are read from the coarsest rollup that still provides at least one rollup
+             *              per column (or the raw samples if none does), the start of the period is found by binary
+             *              search, so the cost depends on the number of columns rather than the length of the
+             *              series.  Columns that contain no samples are omitted.
+             *
+             * @param[in]   start the start of the period in seconds since the unix epoch.
+             * @param[in]   end the end of the period in seconds since the unix epoch.
+             * @param[in]   columns the number of columns, normally the width of the view in pixels.
+             *
+             * @returns     the non empty columns in time order.
+             */
+            auto decimate(double start, double end, int columns) const -> std::vector<Column>;
+
+            /**
+             * @brief       Returns the minimum, maximum, sum, reply count and loss count of a period.
+             *
+             * @details     The whole intervals of the coarsest rollup that still divides the period into several
+             *              intervals are merged, only the partial intervals at either end are read from the raw
+             *              samples, so the cost is bounded by the rollup resolution rather than the length of the
+             *              period.
+             *
+             * @param[in]   start the start of the period in seconds since the unix epoch.
+             * @param[in]   end the end of the period in seconds since the unix epoch.
+             *
+             * @returns     the summary of the period, its time is the start of the period.
+             */
+            auto summarise(double start, double end) const -> Rollup;
+
+            /**
+             * @brief       Returns the archive of the samples that have been moved out of the ring.
+             *
+             * @details     The archive holds the samples immediately before the oldest sample of the series.
+             *
+             * @returns     the compressed archive.
+             */
+            auto archive() const -> const Nedrysoft::RouteAnalyser::CompressedSeries &;
+
+        public:
+            /**
+             * @brief       The default capacity, a day of samples at the default interval.
+             */
+            static constexpr int DefaultCapacity = 86400;
+
+        private:
+            //! @cond
+
+            struct RollupRing {
+                std::vector<Rollup> rollups;
+                std::vector<Nedrysoft::RouteAnalyser::LatencySketch> sketches;
+                int head;
+                int count;
+            };
+
+            auto position(int index) const -> int;
+
+            auto resizeRollups(RollupRing &ring, int capacity) -> void;
+
+            auto summariseSamples(int first, int last, Rollup &summary) const -> void;
+
+            auto addToRollups(
+                    double time,
+                    double roundTripTime,
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode code ) -> void;
+
+            std::vector<RollupRing> m_rollupRings;
+
+            std::vector<double> m_times;
+            std::vector<float> m_roundTripTimes;
+            std::vector<uint8_t> m_codes;
+
+            Nedrysoft::RouteAnalyser::CompressedSeries m_archive;
+
+            int m_capacity;
+            int m_head;
+            int m_count;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_HOPTIMESERIES_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_IFLEETMONITOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_IFLEETMONITOR_H
+
+#include "RouteAnalyserSpec.h"
+#include "IRouteEngine.h"
+
+#include <ICore>
+#include <IInterface>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngineFactory;
+
+    /**
+     * @brief       The monitoring state of a single router (or destination) shared by the routes of a fleet.
+     */
+    struct FleetHop {
+        QHostAddress address;                       //!< the address of the hop.
+        int routes = 0;                             //!< the number of targets whose route passes through the hop.
+        double latency = -1;                        //!< the most recent round trip time in seconds, -1 if none.
+        unsigned long replies = 0;                  //!< the number of replies received.
+        unsigned long timeouts = 0;                 //!< the number of requests that timed out.
+    };
+
+    /**
+     * @brief       A single target of a fleet and the route that was discovered to it.
+     */
+    struct FleetTarget {
+        QString host;                               //!< the host name or address as given.
+        QHostAddress address;                       //!< the address that was traced.
+        Nedrysoft::RouteAnalyser::RouteList route;  //!< the discovered route, the last hop is the target.
+        bool discovered = false;                    //!< true once route discovery has completed.
+    };
+
+    /**
+     * @brief       The IFleetMonitor interface describes monitoring of many targets from a single engine.
+     *
+     * @details     The routes to every target are discovered, then each distinct hop address across all of
+     *              the routes is monitored once by a single shared ping engine, so hops that many routes have
+     *              in common (typically the first few) are not probed once per target.  The state is exposed
+     *              as a summary rather than per target editors.
+     *
+     * @class       Nedrysoft::RouteAnalyser::IFleetMonitor IFleetMonitor.h <IFleetMonitor>
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC IFleetMonitor :
+            public Nedrysoft::ComponentSystem::IInterface {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
+
+        public:
+            /**
+             * @brief       Destroys the IFleetMonitor.
+             */
+            virtual ~IFleetMonitor() = default;
+
+            /**
+             * @brief       Sets the list of targets to monitor.
+             *
+             * @note        The targets must be set before the monitor is started.
+             *
+             * @param[in]   hosts the host names or addresses of the targets.
+             */
+            virtual auto setTargets(const QStringList &hosts) -> void = 0;
+
+            /**
+             * @brief       Sets the interval between requests to each monitored hop.
+             *
+             * @param[in]   interval the interval in milliseconds.
+             */
+            virtual auto setInterval(int interval) -> void = 0;
+
+            /**
+             * @brief       Starts route discovery and monitoring of the targets.
+             *
+             * @param[in]   pingEngineFactory the factory used to create the shared ping engine.
+             * @param[in]   ipVersion the IP version to monitor.
+             *
+             * @returns     true if monitoring was started; otherwise false.
+             */
+            virtual auto start(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                    Nedrysoft::Core::IPVersion ipVersion = Nedrysoft::Core::IPVersion::V4
+            ) -> bool = 0;
+
+            /**
+             * @brief       Stops monitoring and releases the shared ping engine.
+             */
+            virtual auto stop() -> void = 0;
+
+            /**
+             * @brief       Returns the targets and their discovered routes.
+             *
+             * @returns     the list of targets in the order they were given.
+             */
+            virtual auto targets() -> QList<Nedrysoft::RouteAnalyser::FleetTarget> = 0;
+
+            /**
+             * @brief       Returns the distinct hops that are being monitored.
+             *
+             * @returns     the list of hops.
+             */
+            virtual auto hops() -> QList<Nedrysoft::RouteAnalyser::FleetHop> = 0;
+
+            /**
+             * @brief       Signal emitted when routes have been discovered or new results have been received.
+             */
+            Q_SIGNAL void summaryChanged();
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IFleetMonitor, "com.nedrysoft.routeanalyser.IFleetMonitor/1.0.0")
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_IFLEETMONITOR_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_IMETRICSEXPORTER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_IMETRICSEXPORTER_H
+
+#include "RouteAnalyserSpec.h"
+#include "IResultSink.h"
+
+#include <QHostAddress>
+#include <QObject>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The IMetricsExporter interface describes a service that publishes live per hop metrics.
+     *
+     * @details     The exporter is a result sink, it maintains its own aggregates of the results that it is given
+     *              (round trip time histograms, loss counters and jitter) and makes them available to a metrics
+     *              scraper.
+     *
+     * @class       Nedrysoft::RouteAnalyser::IMetricsExporter IMetricsExporter.h <IMetricsExporter>
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC IMetricsExporter :
+            public Nedrysoft::RouteAnalyser::IResultSink {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IResultSink)
+
+        public:
+            /**
+             * @brief       Destroys the IMetricsExporter.
+             */
+            virtual ~IMetricsExporter() = default;
+
+            /**
+             * @brief       Starts serving the metrics on the given address and port.
+             *
+             * @param[in]   address the address to listen on.
+             * @param[in]   port the port to listen on.
+             *
+             * @returns     true if the exporter is listening; otherwise false.
+             */
+            virtual auto listen(const QHostAddress &address, quint16 port) -> bool = 0;
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IMetricsExporter, "com.nedrysoft.routeanalyser.IMetricsExporter/1.0.0")
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_IMETRICSEXPORTER_H
@@ -30,11 +30,72 @@
 #include <IConfiguration>
 #include <IInterface>
 #include <QHostAddress>
+#include <QVector>
 #include <chrono>
+#include <future>
 
 namespace Nedrysoft { namespace RouteAnalyser {
     class IPingTarget;
 
+    /**
+     * @brief       The PingEngineStatistics struct holds the counters that describe the health of a ping engine.
+     *
+     * @details     The counters are cumulative from when the engine was created, they allow loss caused by the
+     *              measuring host (late scheduling, a full receive buffer or a full request table) to be told
+     *              apart from loss on the network.
+     */
+    struct PingEngineStatistics {
+        bool valid = false;                     //!< true if the engine provides statistics.
+        quint64 packetsSent = 0;                //!< the number of requests sent.
+        quint64 sendErrors = 0;                 //!< the number of requests that could not be sent.
+        quint64 packetsReceived = 0;            //!< the number of replies matched to a request.
+        quint64 unmatchedReplies = 0;           //!< the number of replies that could not be matched to a request.
+        quint64 duplicateReplies = 0;           //!< the number of replies to a request that was already answered.
+        quint64 reorderedReplies = 0;           //!< the number of replies that overtook a reply sent before them.
+        quint64 lateReplies = 0;                //!< the number of replies that arrived after their request expired.
+        quint64 timedOut = 0;                   //!< the number of requests that expired without a reply.
+        quint64 evictedRequests = 0;            //!< the number of requests discarded to make room for newer ones.
+        quint64 receiveDrops = 0;               //!< the number of packets dropped by the kernel before being read.
+        quint64 outstandingRequests = 0;        //!< the number of requests currently awaiting a reply.
+        quint64 schedulingLagCount = 0;         //!< the number of transmissions measured for scheduling lag.
+        double schedulingLagSum = 0;            //!< the total time in seconds that transmissions started late.
+        double schedulingLagMaximum = 0;        //!< the largest time in seconds that a transmission started late.
+
+        /**
+         * @brief       Adds the counters of another engine to these counters.
+         *
+         * @param[in]   other the statistics to add.
+         *
+         * @returns     this object.
+         */
+        auto operator+=(const PingEngineStatistics &other) -> PingEngineStatistics & {
+            if (!other.valid) {
+                return *this;
+            }
+
+            valid = true;
+            packetsSent += other.packetsSent;
+            sendErrors += other.sendErrors;
+            packetsReceived += other.packetsReceived;
+            unmatchedReplies += other.unmatchedReplies;
+            duplicateReplies += other.duplicateReplies;
+            reorderedReplies += other.reorderedReplies;
+            lateReplies += other.lateReplies;
+            timedOut += other.timedOut;
+            evictedRequests += other.evictedRequests;
+            outstandingRequests += other.outstandingRequests;
+            schedulingLagCount += other.schedulingLagCount;
+            schedulingLagSum += other.schedulingLagSum;
+            schedulingLagMaximum = qMax(schedulingLagMaximum, other.schedulingLagMaximum);
+
+            // the receive path is shared by every engine of a factory, so the drop count is not summed.
+
+            receiveDrops = qMax(receiveDrops, other.receiveDrops);
+
+            return *this;
+        }
+    };
+
     /**
      * @brief       The IPingEngine interface describes a ping engine.
      *
@@ -85,6 +146,61 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             virtual auto setTimeout(int timeout) -> bool = 0;
 
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @details     The payload size can be overridden per target, to sweep sizes for a hop a target is added
+             *              for each size and the results are identified by their target.
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            virtual auto setPayloadSize(int payloadSize) -> bool = 0;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @returns     the payload size in bytes.
+             */
+            virtual auto payloadSize() -> int = 0;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag set.
+             *
+             * @details     With the flag set, requests that are larger than the path MTU are dropped instead of
+             *              being fragmented, combined with the payload size this allows MTU black holes to be found.
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setDontFragment(bool dontFragment) -> bool = 0;
+
+            /**
+             * @brief       Returns whether echo requests are sent with the don't fragment flag set.
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            virtual auto dontFragment() -> bool = 0;
+
+            /**
+             * @brief       Sets whether results are delivered in batches.
+             *
+             * @details     When enabled the engine collects the results produced by its worker threads and delivers
+             *              them through resultsReady() rather than emitting result() for each one, this reduces the
+             *              number of cross thread events when many targets are being pinged.
+             *
+             * @param[in]   batching true to deliver results in batches; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine does not support batching.
+             */
+            virtual auto setResultBatching(bool batching) -> bool {
+                Q_UNUSED(batching)
+
+                return false;
+            }
+
             /**
              * @brief       Starts ping operations for this engine instance.
              *
@@ -135,6 +251,169 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 double timeout
             ) -> Nedrysoft::RouteAnalyser::PingResult = 0;
 
+            /**
+             * @brief       Transmits a single ping without blocking the caller.
+             *
+             * @details     Any number of requests may be outstanding at once, each future is fulfilled when the
+             *              reply arrives or the timeout expires.  The default implementation runs the blocking
+             *              singleShot() on a separate thread, engines that can correlate replies themselves
+             *              should override this.
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            virtual auto singleShotAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+                return std::async(std::launch::async, [this, hostAddress, ttl, timeout]() {
+                    return singleShot(hostAddress, ttl, timeout);
+                });
+            }
+
+            /**
+             * @brief       Sets whether probes are kept on a single flow.
+             *
+             * @details     Routers that balance traffic across equal cost paths choose the path from a hash of
+             *              header fields, if those fields change between probes then consecutive probes to the
+             *              same hop may take different paths, which shows up as flapping hops and false loss.  In
+             *              flow stable mode the engine keeps the hashed fields constant for every probe it sends,
+             *              so that route discovery and monitoring follow the same path.  The setting applies to
+             *              targets added after it is changed.
+             *
+             * @param[in]   flowStable true to keep probes on a single flow; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setFlowStable(bool flowStable) -> bool {
+                Q_UNUSED(flowStable)
+
+                return false;
+            }
+
+            /**
+             * @brief       Returns whether probes are kept on a single flow.
+             *
+             * @returns     true if flow stable; otherwise false.
+             */
+            virtual auto flowStable() -> bool {
+                return false;
+            }
+
+            /**
+             * @brief       Sets the source that requests are sent from.
+             *
+             * @details     The source is either a local address or the name of a network interface, requests leave
+             *              through it rather than the default route so that the same target can be traced over
+             *              several uplinks at once.  Engines with a source are scheduled so that their rounds start
+             *              together, which aligns the probe timing of engines that share an interval.  The source
+             *              must be set before the engine is started.
+             *
+             * @param[in]   source the source address or interface name, empty for the default route.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setSource(const QString &source) -> bool {
+                Q_UNUSED(source)
+
+                return false;
+            }
+
+            /**
+             * @brief       Returns the source that requests are sent from.
+             *
+             * @returns     the source address or interface name; otherwise an empty string for the default route.
+             */
+            virtual auto source() -> QString {
+                return QString();
+            }
+
+            /**
+             * @brief       Sets whether the rounds of the engine are aligned with other aligned engines.
+             *
+             * @details     The first round of an aligned engine starts on a multiple of the interval, so engines
+             *              that share an interval send their rounds together.  This is used to compare the routes
+             *              to a host over different IP versions sample by sample.  Engines with a source are always
+             *              aligned.  Must be set before the engine is started.
+             *
+             * @param[in]   aligned true to align the rounds; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setAligned(bool aligned) -> bool {
+                Q_UNUSED(aligned)
+
+                return false;
+            }
+
+            /**
+             * @brief       Returns whether the rounds of the engine are aligned with other aligned engines.
+             *
+             * @returns     true if aligned; otherwise false.
+             */
+            virtual auto aligned() -> bool {
+                return false;
+            }
+
+            /**
+             * @brief       Sets the number of requests sent to each target in every round.
+             *
+             * @details     By default a single request is sent to each target per interval.  With more than one the
+             *              requests of a round are spread across a short window at the start of the interval and
+             *              share the round's sample number, so a consumer can summarise each round rather than
+             *              being led by a single unlucky sample.
+             *
+             * @param[in]   probes the number of requests per target per round.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setProbesPerRound(int probes) -> bool {
+                Q_UNUSED(probes)
+
+                return false;
+            }
+
+            /**
+             * @brief       Returns the number of requests sent to each target in every round.
+             *
+             * @returns     the number of requests per target per round.
+             */
+            virtual auto probesPerRound() -> int {
+                return 1;
+            }
+
+            /**
+             * @brief       Transmits a single ping on the given flow without blocking the caller.
+             *
+             * @details     Probes sent with the same flow identifier follow the same path through load balancers,
+             *              probes with different identifiers may be balanced onto different paths, this allows
+             *              the parallel paths to a hop to be enumerated.  The default implementation ignores the
+             *              flow and calls singleShotAsync().
+             *
+             * @param[in]   hostAddress the target host address.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             * @param[in]   flowIdentifier the flow to send the probe on.
+             *
+             * @returns     a future that holds the result of the ping.
+             */
+            virtual auto singleShotFlowAsync(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout,
+                uint16_t flowIdentifier
+            ) -> std::future<Nedrysoft::RouteAnalyser::PingResult> {
+
+                Q_UNUSED(flowIdentifier)
+
+                return singleShotAsync(hostAddress, ttl, timeout);
+            }
+
             /**
              * @brief       Removes a ping target from this engine instance.
              *
@@ -158,12 +437,33 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             Q_SIGNAL void result(Nedrysoft::RouteAnalyser::PingResult result);
 
+            /**
+             * @brief       Signal emitted with a batch of results when result batching is enabled.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setResultBatching
+             *
+             * @param[in]   results the results, in the order they were produced.
+             */
+            Q_SIGNAL void resultsReady(QVector<Nedrysoft::RouteAnalyser::PingResult> results);
+
             /**
              * @brief       Returns the list of ping targets for the engine.
              *
              * @returns     a QList containing the list of targets.
              */
             virtual auto targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> = 0;
+
+            /**
+             * @brief       Returns the health counters of the engine.
+             *
+             * @details     May be called from any thread.  The default implementation returns statistics that
+             *              are marked as not valid, for engines that do not collect them.
+             *
+             * @returns     the statistics.
+             */
+            virtual auto statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+                return Nedrysoft::RouteAnalyser::PingEngineStatistics();
+            }
     };
 }}
 
@@ -25,14 +25,13 @@
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_IPINGENGINEFACTORY_H
 
 #include "RouteAnalyserSpec.h"
+#include "IPingEngine.h"
 
 #include <ICore>
 #include <IConfiguration>
 #include <IInterface>
 
 namespace Nedrysoft { namespace RouteAnalyser {
-    class IPingEngine;
-
     /**
      * @brief       The IPingEngineFactory Interface describes a factory for Nedrysoft::RouteAnalyser::IPingEngine
      *              instances.
@@ -101,9 +100,34 @@ namespace Nedrysoft { namespace RouteAnalyser {
               */
              virtual auto deleteEngine(Nedrysoft::RouteAnalyser::IPingEngine *engine) -> bool = 0;
 
+             /**
+              * @brief      Returns the combined health counters of the engines created by this instance.
+              *
+              * @details    May be called from any thread.  The default implementation returns statistics that
+              *             are marked as not valid.
+              *
+              * @returns    the statistics.
+              */
+             virtual auto statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+                 return Nedrysoft::RouteAnalyser::PingEngineStatistics();
+             }
+
+             /**
+              * @brief      Returns the vantage point that the engines created by this instance probe from.
+              *
+              * @details    A factory whose engines probe from one particular remote site returns the name of the
+              *             site, the merged route view traces a target from every factory that has a vantage
+              *             point.  The default implementation returns an empty string.
+              *
+              * @returns    the name of the vantage point; otherwise an empty string.
+              */
+             virtual auto vantagePoint() -> QString {
+                 return QString();
+             }
+
     };
 }}
 
-Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IPingEngineFactory, "com.nedrysoft.routeanalyser.IPingEngineFactory/1.0.0")
+Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IPingEngineFactory, "com.nedrysoft.routeanalyser.IPingEngineFactory/1.1.0")
 
 #endif // PINGNOO_COMPONENTS_CORE_IPINGENGINEFACTORY_H
@@ -98,6 +98,40 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @returns     the ttl value.
              */
             virtual auto ttl() -> uint16_t = 0;
+
+            /**
+             * @brief       Sets the payload size used for this target.
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            virtual auto setPayloadSize(int payloadSize) -> void = 0;
+
+            /**
+             * @brief       Returns the payload size used for this target.
+             *
+             * @returns     the payload size in bytes.
+             */
+            virtual auto payloadSize() -> int = 0;
+
+            /**
+             * @brief       Returns how many sample rounds the engine has backed this target off by.
+             *
+             * @details     An engine may probe a hop less often than the others when the hop rate limits its ICMP
+             *              responses, the loss reported for such a hop is not a property of the forwarding path.
+             *
+             * @returns     1 if the target is sent in every round; otherwise the target is sent once every n rounds.
+             */
+            virtual auto probeBackoff() -> int = 0;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @details     This lets a caller probe some hops less often than others, engines that cannot skip a
+             *              target probe it in every round.
+             *
+             * @param[in]   divisor the target is sent once every divisor rounds.
+             */
+            virtual auto setSamplingDivisor(int divisor) -> void = 0;
     };
 }}
 
@@ -42,6 +42,15 @@ namespace Nedrysoft { namespace RouteAnalyser {
 
             Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
 
+        public:
+            /**
+             * @brief       A reply received by the hop.
+             */
+            struct Sample {
+                double time;                        //! the unix timestamp of the request.
+                double roundTripTime;               //! the round trip time in seconds.
+            };
+
         public:
             /**
              * @brief       Returns the widget for this plot.
@@ -57,6 +66,43 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             virtual auto update(double time, double value) -> void = 0;
 
+            /**
+             * @brief       Updates the plot with the replies received since the previous update.
+             *
+             * @details     The samples are passed as a contiguous array in time order, a plot should add them
+             *              without redrawing and redraw in frameReady.  The default implementation passes each
+             *              sample to update(double, double) so that existing plots continue to work.
+             *
+             * @param[in]   samples the samples.
+             * @param[in]   count the number of samples.
+             */
+            virtual auto updateSamples(const Sample *samples, int count) -> void {
+                for (auto index=0;index<count;index++) {
+                    update(samples[index].time, samples[index].roundTripTime);
+                }
+            }
+
+            /**
+             * @brief       Called once the results of a display frame have been delivered.
+             *
+             * @details     A plot that has received new data since the previous frame should redraw here, so that
+             *              it redraws at most once per frame however many results arrived.
+             */
+            virtual auto frameReady() -> void {
+
+            }
+
+            /**
+             * @brief       Updates the plot with the jitter of the hop after a new result.
+             *
+             * @details     The jitter is the RFC 3550 interarrival jitter maintained by the hop statistics, so
+             *              plots do not need to derive it from the round trip times.
+             *
+             * @param[in]   time the unix timestamp for this result.
+             * @param[in]   jitter the jitter in seconds.
+             */
+            virtual auto updateJitter(double time, double jitter) -> void = 0;
+
             /**
              * @brief       Update the visible area (viewport) of the graph.
              * @param[in]   min the minimum displayed value.
@@ -80,6 +126,6 @@ namespace Nedrysoft { namespace RouteAnalyser {
     };
 }}
 
-Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IPlot, "com.nedrysoft.routeanalyser.IPlot/1.0.0")
+Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IPlot, "com.nedrysoft.routeanalyser.IPlot/1.1.0")
 
 #endif //NEDRYSOFT_ROUTEANALYSER_IPLOT_H
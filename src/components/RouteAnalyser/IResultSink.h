@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_IRESULTSINK_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_IRESULTSINK_H
+
+#include "RouteAnalyserSpec.h"
+#include "HopStatistics.h"
+#include "PingResult.h"
+
+#include <IInterface>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The IResultSink interface describes a consumer of live results, such as a metrics exporter.
+     *
+     * @details     Every sink that is registered receives the results of each hop in batches as they leave the
+     *              statistics engine, together with the aggregates of the hop once they have been added.  A sink
+     *              reports the aggregates rather than computing its own, so every view of a hop agrees with the
+     *              table.  A sink must only queue what it is given, it is called from the thread that publishes
+     *              the results and must never hold up probing or the user interface.
+     *
+     * @class       Nedrysoft::RouteAnalyser::IResultSink IResultSink.h <IResultSink>
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC IResultSink :
+            public Nedrysoft::ComponentSystem::IInterface {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::ComponentSystem::IInterface)
+
+        public:
+            /**
+             * @brief       Destroys the IResultSink.
+             */
+            virtual ~IResultSink() = default;
+
+            /**
+             * @brief       Adds results for a hop.
+             *
+             * @param[in]   target the name of the target that the hop belongs to.
+             * @param[in]   hop the hop number.
+             * @param[in]   statistics the aggregates of the hop, including the results.
+             * @param[in]   results the results received for the hop since the previous update.
+             */
+            virtual auto update(
+                    const QString &target,
+                    int hop,
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results
+            ) -> void = 0;
+
+            /**
+             * @brief       Removes every hop of a target.
+             *
+             * @param[in]   target the name of the target.
+             */
+            virtual auto removeTarget(const QString &target) -> void = 0;
+    };
+}}
+
+Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IResultSink, "com.nedrysoft.routeanalyser.IResultSink/2.0.0")
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_IRESULTSINK_H
@@ -29,12 +29,25 @@
 #include <ICore>
 #include <IInterface>
 #include <QHostAddress>
+#include <QList>
+#include <QMetaType>
 #include <QObject>
 
 namespace Nedrysoft { namespace RouteAnalyser {
     typedef QList<QHostAddress> RouteList;
     class IPingEngineFactory;
 
+    /**
+     * @brief       The addresses found at a single hop by multipath discovery.
+     */
+    struct MultipathHop {
+        QList<QHostAddress> addresses;              //!< the distinct addresses that answered at this hop.
+        int probes = 0;                             //!< the number of probes sent to the hop.
+        double confidence = 0;                      //!< the confidence (0 to 1) that no address was missed.
+    };
+
+    typedef QList<MultipathHop> MultipathRoute;
+
     /**
      * @brief       The IRouteEngine interface describes the mechanism of finding the route to a host.
      *
@@ -69,6 +82,92 @@ namespace Nedrysoft { namespace RouteAnalyser {
                     QString host,
                     Nedrysoft::Core::IPVersion ipVersion ) -> void = 0;
 
+            /**
+             * @brief       Sets whether the parallel paths of the route are enumerated after discovery.
+             *
+             * @details     Load balanced routes may have several next hops at each hop, multipath discovery
+             *              probes each hop on many flows until further next hops can be ruled out with 95%
+             *              confidence (the multipath detection algorithm), the result is reported through
+             *              multipathResult once the route itself has been reported.
+             *
+             * @param[in]   enabled true to enable multipath discovery; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine does not support multipath discovery.
+             */
+            virtual auto setMultipathDiscovery(bool enabled) -> bool {
+                Q_UNUSED(enabled)
+
+                return false;
+            }
+
+            /**
+             * @brief       Sets whether every address of the target is traced rather than only the first.
+             *
+             * @details     Hosts with several addresses of the requested IP version (anycast or multi-homed
+             *              services) are traced to every address in parallel, the result signal carries the
+             *              address so that the paths can be told apart.
+             *
+             * @param[in]   enabled true to trace all addresses; otherwise false.
+             *
+             * @returns     true on success; otherwise false if the engine can only trace a single address.
+             */
+            virtual auto setTraceAllAddresses(bool enabled) -> bool {
+                Q_UNUSED(enabled)
+
+                return false;
+            }
+
+            /**
+             * @brief       Sets the number of consecutive silent hops after which discovery gives up.
+             *
+             * @details     A destination that filters the probes never answers, without a limit discovery would
+             *              wait for every hop up to the maximum.  The silent hops that were found are kept at the
+             *              end of the route.
+             *
+             * @param[in]   gapLimit the number of consecutive hops that may not answer, 0 for no limit.
+             *
+             * @returns     true on success; otherwise false if the engine does not support a gap limit.
+             */
+            virtual auto setGapLimit(int gapLimit) -> bool {
+                Q_UNUSED(gapLimit)
+
+                return false;
+            }
+
+            /**
+             * @brief       Sets the interval at which the route is re-discovered in the background.
+             *
+             * @details     Once the route has been found it is traced again at this interval and compared with
+             *              the current route, routeChanged is emitted when the path differs.
+             *
+             * @param[in]   interval the interval in seconds between re-traces, 0 disables monitoring.
+             *
+             * @returns     true on success; otherwise false if the engine does not support route monitoring.
+             */
+            virtual auto setRouteMonitoring(int interval) -> bool {
+                Q_UNUSED(interval)
+
+                return false;
+            }
+
+            /**
+             * @brief       Sets the source that the route is discovered from.
+             *
+             * @details     The source is a local address or the name of a network interface, the route is traced
+             *              through it rather than the default route.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setSource
+             *
+             * @param[in]   source the source address or interface name, empty for the default route.
+             *
+             * @returns     true on success; otherwise false if the engine does not support the option.
+             */
+            virtual auto setSource(const QString &source) -> bool {
+                Q_UNUSED(source)
+
+                return false;
+            }
+
             /**
              * @brief       Signal emitted when the route discovery is completed.
              *
@@ -86,9 +185,42 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 const int totalHops,
                 const int maximumHops
             );
+
+            /**
+             * @brief       Signal emitted as each hop is enumerated by multipath discovery.
+             *
+             * @param[in]   hostAddress the address of the host that was the target.
+             * @param[in]   route the hops enumerated so far, in hop order.
+             * @param[in]   completed true if every hop has been enumerated; otherwise false.
+             */
+            Q_SIGNAL void multipathResult(
+                const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::MultipathRoute route,
+                const bool completed
+            );
+
+            /**
+             * @brief       Signal emitted when a background re-trace finds that the route has changed.
+             *
+             * @note        A hop that did not answer the re-trace keeps its previous address, only hops that
+             *              answered from a different address, or that were added or removed, are changes.
+             *
+             * @param[in]   hostAddress the address of the host that was the target.
+             * @param[in]   previousRoute the route before the change.
+             * @param[in]   route the new route.
+             * @param[in]   changedHops the hop numbers (starting at 1) that differ between the routes.
+             */
+            Q_SIGNAL void routeChanged(
+                const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList previousRoute,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const QList<int> changedHops
+            );
     };
 }}
 
+Q_DECLARE_METATYPE(Nedrysoft::RouteAnalyser::MultipathRoute)
+
 Q_DECLARE_INTERFACE(Nedrysoft::RouteAnalyser::IRouteEngine, "com.nedrysoft.routeanalyser.IRouteEngine/1.0.0")
 
 #endif // PINGNOO_COMPONENTS_ROUTEANALYSER_IROUTEENGINE_H
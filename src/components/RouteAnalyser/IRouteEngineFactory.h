@@ -31,6 +31,7 @@
 #include <IInterface>
 
 namespace Nedrysoft { namespace RouteAnalyser {
+    class IFleetMonitor;
     class IRouteEngine;
 
     /**
@@ -68,6 +69,18 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             virtual auto createEngine() -> Nedrysoft::RouteAnalyser::IRouteEngine * = 0;
 
+            /**
+             * @brief       Creates a fleet monitor instance.
+             *
+             * @details     Creates and returns a monitor for many targets that shares one ping engine between
+             *              them.  The instance is owned by the factory and is responsible for its life cycle.
+             *
+             * @returns     the fleet monitor instance; otherwise nullptr if the factory does not provide one.
+             */
+            virtual auto createFleetMonitor() -> Nedrysoft::RouteAnalyser::IFleetMonitor * {
+                return nullptr;
+            }
+
             /**
              * @brief       Returns the descriptive name of the route engine.
              *
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JitterStatistics.h"
+
+#include <cmath>
+
+constexpr auto JitterGain = 1.0/16.0;
+
+Nedrysoft::RouteAnalyser::JitterStatistics::JitterStatistics() :
+        m_previousRoundTripTime(-1),
+        m_minimumRoundTripTime(-1),
+        m_jitter(-1),
+        m_ipdv(-1),
+        m_count(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::JitterStatistics::add(double roundTripTime) -> void {
+    if (!m_count) {
+        m_minimumRoundTripTime = roundTripTime;
+    } else if (roundTripTime<m_minimumRoundTripTime) {
+        // the earlier replies were measured against a higher minimum, so their variation grows by the difference.
+
+        m_pdvSketch.shift(m_minimumRoundTripTime-roundTripTime);
+
+        m_minimumRoundTripTime = roundTripTime;
+    }
+
+    m_pdvSketch.add(roundTripTime-m_minimumRoundTripTime);
+
+    if (m_count) {
+        m_ipdv = std::abs(roundTripTime-m_previousRoundTripTime);
+
+        // RFC 3550 section 6.4.1, J(i) = J(i-1) + (|D(i-1,i)| - J(i-1))/16
+
+        if (m_jitter<0) {
+            m_jitter = m_ipdv;
+        } else {
+            m_jitter += (m_ipdv-m_jitter)*JitterGain;
+        }
+    }
+
+    m_previousRoundTripTime = roundTripTime;
+    m_count++;
+}
+
+auto Nedrysoft::RouteAnalyser::JitterStatistics::clear() -> void {
+    m_previousRoundTripTime = -1;
+    m_minimumRoundTripTime = -1;
+    m_jitter = -1;
+    m_ipdv = -1;
+    m_count = 0;
+
+    m_pdvSketch.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::JitterStatistics::jitter() const -> double {
+    return m_jitter;
+}
+
+auto Nedrysoft::RouteAnalyser::JitterStatistics::ipdv() const -> double {
+    return m_ipdv;
+}
+
+auto Nedrysoft::RouteAnalyser::JitterStatistics::pdv(double quantile) const -> double {
+    return m_pdvSketch.quantile(quantile);
+}
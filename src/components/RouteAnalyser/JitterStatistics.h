@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_JITTERSTATISTICS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_JITTERSTATISTICS_H
+
+#include "LatencySketch.h"
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The JitterStatistics class computes the delay variation of a hop incrementally.
+     *
+     * @details     Three measures are maintained from the round trip times of consecutive replies:
+     *
+     *              - the RFC 3550 interarrival jitter, a running estimate smoothed with a gain of 1/16.
+     *              - the IPDV (RFC 5481), the difference in delay between a reply and the previous reply.
+     *              - the PDV (RFC 5481), the delay of each reply above the minimum delay of all the replies,
+     *                held in a sketch so that its percentiles are available.
+     *
+     *              Only the round trip time is known, so the transit time difference of RFC 3550 is taken as
+     *              the difference between consecutive round trip times, each update is constant time.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC JitterStatistics {
+        public:
+            /**
+             * @brief       Constructs an empty JitterStatistics.
+             */
+            JitterStatistics();
+
+            /**
+             * @brief       Adds the round trip time of a reply.
+             *
+             * @note        One way delays may also be added, these can be negative if the clocks at each end are
+             *              not synchronised, which does not affect the variation.
+             *
+             * @param[in]   roundTripTime the round trip time in seconds.
+             */
+            auto add(double roundTripTime) -> void;
+
+            /**
+             * @brief       Removes all measurements.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the RFC 3550 interarrival jitter.
+             *
+             * @returns     the jitter in seconds; otherwise -1 if fewer than two replies have been added.
+             */
+            auto jitter() const -> double;
+
+            /**
+             * @brief       Returns the IPDV of the most recent reply.
+             *
+             * @returns     the absolute delay variation in seconds; otherwise -1 if fewer than two replies have
+             *              been added.
+             */
+            auto ipdv() const -> double;
+
+            /**
+             * @brief       Returns a percentile of the PDV.
+             *
+             * @details     The PDV of every reply is measured against the minimum delay of all the replies added
+             *              since the statistics were cleared, when a lower minimum arrives the sketch is shifted by
+             *              the difference.  Each shift re-bins the earlier values, which can add the 1% accuracy of
+             *              the sketch again, the minimum rarely falls once a hop has a few replies.
+             *
+             * @param[in]   quantile the quantile between 0 and 1.
+             *
+             * @returns     the delay variation in seconds; otherwise -1 if no replies have been added.
+             */
+            auto pdv(double quantile) const -> double;
+
+        private:
+            //! @cond
+
+            double m_previousRoundTripTime;
+            double m_minimumRoundTripTime;
+            double m_jitter;
+            double m_ipdv;
+            unsigned long m_count;
+
+            Nedrysoft::RouteAnalyser::LatencySketch m_pdvSketch;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_JITTERSTATISTICS_H
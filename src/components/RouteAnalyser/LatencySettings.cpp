@@ -24,6 +24,7 @@
 #include "LatencySettings.h"
 
 #include "ColourManager.h"
+#include <IConfigurationStore>
 #include <ICore>
 #include "Utils.h"
 
@@ -34,6 +35,7 @@
 
 auto constexpr WarningDefaultValue = 0.2;
 auto constexpr CriticalDefaultValue = 0.5;
+constexpr auto DefaultMemoryBudget = 1024;
 
 constexpr auto ConfigurationPath = "Nedrysoft/Pingnoo/Components/RouteAnalyser";
 constexpr auto ConfigurationFilename = "LatencySettings.json";
@@ -44,7 +46,13 @@ Nedrysoft::RouteAnalyser::LatencySettings::LatencySettings() :
         m_idealColour(Nedrysoft::RouteAnalyser::ColourManager::getIdealColour()),
         m_warningColour(Nedrysoft::RouteAnalyser::ColourManager::getWarningColour()),
         m_criticalColour(Nedrysoft::RouteAnalyser::ColourManager::getCriticalColour()),
-        m_useGradientFill(true) {
+        m_useGradientFill(true),
+        m_useHardwareAcceleration(false),
+        m_overheadCompensation(false),
+        m_intermediateHopDivisor(1),
+        m_probesPerRound(1),
+        m_powerSaving(true),
+        m_memoryBudget(DefaultMemoryBudget) {
 
 }
 
@@ -74,6 +82,29 @@ auto Nedrysoft::RouteAnalyser::LatencySettings::saveConfiguration() -> QJsonObje
 
     rootObject.insert("colours", coloursObject);
 
+    QJsonObject plotsObject;
+
+    plotsObject.insert("hardwareAcceleration", m_useHardwareAcceleration);
+
+    rootObject.insert("plots", plotsObject);
+
+    QJsonObject measurementObject;
+
+    measurementObject.insert("overheadCompensation", m_overheadCompensation);
+    measurementObject.insert("intermediateHopDivisor", m_intermediateHopDivisor);
+    measurementObject.insert("probesPerRound", m_probesPerRound);
+    measurementObject.insert("powerSaving", m_powerSaving);
+    measurementObject.insert("memoryBudget", m_memoryBudget);
+
+    rootObject.insert("measurement", measurementObject);
+
+    QJsonObject alertsObject;
+
+    alertsObject.insert("rules", QJsonArray::fromStringList(m_alertRules));
+    alertsObject.insert("webhook", m_alertWebhook);
+
+    rootObject.insert("alerts", alertsObject);
+
     return rootObject;
 }
 
@@ -114,6 +145,56 @@ auto Nedrysoft::RouteAnalyser::LatencySettings::loadConfiguration(QJsonObject co
         }
     }
 
+    if (configuration.contains("plots")) {
+        auto plotsObject = configuration["plots"].toObject();
+
+        if (plotsObject.contains("hardwareAcceleration")) {
+            m_useHardwareAcceleration = plotsObject.value("hardwareAcceleration").toBool();
+        }
+    }
+
+    if (configuration.contains("measurement")) {
+        auto measurementObject = configuration["measurement"].toObject();
+
+        if (measurementObject.contains("overheadCompensation")) {
+            m_overheadCompensation = measurementObject.value("overheadCompensation").toBool();
+        }
+
+        if (measurementObject.contains("intermediateHopDivisor")) {
+            m_intermediateHopDivisor = qMax(1, measurementObject.value("intermediateHopDivisor").toInt());
+        }
+
+        if (measurementObject.contains("probesPerRound")) {
+            m_probesPerRound = qMax(1, measurementObject.value("probesPerRound").toInt());
+        }
+
+        if (measurementObject.contains("powerSaving")) {
+            m_powerSaving = measurementObject.value("powerSaving").toBool();
+        }
+
+        if (measurementObject.contains("memoryBudget")) {
+            m_memoryBudget = qMax(0, measurementObject.value("memoryBudget").toInt());
+        }
+    }
+
+    if (configuration.contains("alerts")) {
+        auto alertsObject = configuration["alerts"].toObject();
+
+        if (alertsObject.contains("rules")) {
+            m_alertRules.clear();
+
+            for (auto rule : alertsObject["rules"].toArray()) {
+                m_alertRules.append(rule.toString());
+            }
+        }
+
+        if (alertsObject.contains("webhook")) {
+            m_alertWebhook = alertsObject["webhook"].toString();
+        }
+
+        Q_EMIT alertRulesChanged();
+    }
+
     return true;
 }
 
@@ -157,35 +238,20 @@ auto Nedrysoft::RouteAnalyser::LatencySettings::loadFromFile(QString filename, b
 }
 
 auto Nedrysoft::RouteAnalyser::LatencySettings::saveToFile(QString filename) -> void {
-    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
-
-    QFile configurationFile;
+    auto configurationStore = Nedrysoft::Core::IConfigurationStore::getInstance();
+    auto isExport = !filename.isNull();
 
-    if (filename.isNull()) {
-        auto filePath = QString("%1/%2/%3")
-                .arg(storageFolder)
+    if (!isExport) {
+        filename = QDir::cleanPath(QString("%1/%2/%3")
+                .arg(Nedrysoft::Core::ICore::getInstance()->storageFolder())
                 .arg(ConfigurationPath)
-                .arg(QString(ConfigurationFilename));
-
-        configurationFile.setFileName(QDir::cleanPath(filePath));
-    } else {
-        configurationFile.setFileName(filename);
-    }
-
-    QDir dir(storageFolder);
-
-    if (!dir.exists(ConfigurationPath)) {
-        dir.mkpath(ConfigurationPath);
+                .arg(QString(ConfigurationFilename)));
     }
 
-    if (configurationFile.open(QFile::WriteOnly)) {
-        QJsonObject configuration = saveConfiguration();
+    configurationStore->save(filename, saveConfiguration());
 
-        auto jsonDocument = QJsonDocument(configuration);
-
-        if (jsonDocument.isObject()) {
-            configurationFile.write(jsonDocument.toJson());
-        }
+    if (isExport) {
+        configurationStore->flush();
     }
 }
 
@@ -252,4 +318,114 @@ auto Nedrysoft::RouteAnalyser::LatencySettings::setGradientFill(bool useGradient
 
 auto Nedrysoft::RouteAnalyser::LatencySettings::gradientFill() -> bool {
     return m_useGradientFill;
-}
\ No newline at end of file
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setHardwareAcceleration(bool useHardwareAcceleration) -> void {
+    if (m_useHardwareAcceleration==useHardwareAcceleration) {
+        return;
+    }
+
+    m_useHardwareAcceleration = useHardwareAcceleration;
+
+    Q_EMIT hardwareAccelerationChanged(useHardwareAcceleration);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::hardwareAcceleration() -> bool {
+    return m_useHardwareAcceleration;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setOverheadCompensation(bool compensate) -> void {
+    if (m_overheadCompensation==compensate) {
+        return;
+    }
+
+    m_overheadCompensation = compensate;
+
+    Q_EMIT overheadCompensationChanged(compensate);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::overheadCompensation() -> bool {
+    return m_overheadCompensation;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setIntermediateHopDivisor(int divisor) -> void {
+    divisor = qMax(1, divisor);
+
+    if (m_intermediateHopDivisor==divisor) {
+        return;
+    }
+
+    m_intermediateHopDivisor = divisor;
+
+    Q_EMIT intermediateHopDivisorChanged(divisor);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::intermediateHopDivisor() -> int {
+    return m_intermediateHopDivisor;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setProbesPerRound(int probes) -> void {
+    m_probesPerRound = qMax(1, probes);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::probesPerRound() -> int {
+    return m_probesPerRound;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setPowerSaving(bool powerSaving) -> void {
+    if (m_powerSaving==powerSaving) {
+        return;
+    }
+
+    m_powerSaving = powerSaving;
+
+    Q_EMIT powerSavingChanged(powerSaving);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::powerSaving() -> bool {
+    return m_powerSaving;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setMemoryBudget(int megabytes) -> void {
+    megabytes = qMax(0, megabytes);
+
+    if (m_memoryBudget==megabytes) {
+        return;
+    }
+
+    m_memoryBudget = megabytes;
+
+    Q_EMIT memoryBudgetChanged(megabytes);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::memoryBudget() -> int {
+    return m_memoryBudget;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setAlertRules(const QStringList &rules) -> void {
+    if (m_alertRules==rules) {
+        return;
+    }
+
+    m_alertRules = rules;
+
+    Q_EMIT alertRulesChanged();
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::alertRules() -> QStringList {
+    return m_alertRules;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::setAlertWebhook(const QString &webhook) -> void {
+    if (m_alertWebhook==webhook) {
+        return;
+    }
+
+    m_alertWebhook = webhook;
+
+    Q_EMIT alertRulesChanged();
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySettings::alertWebhook() -> QString {
+    return m_alertWebhook;
+}
@@ -24,10 +24,13 @@
 #ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_LATENCYSETTINGS_H
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_LATENCYSETTINGS_H
 
+#include "RouteAnalyserSpec.h"
+
 #include <IConfiguration>
 #include <IComponentManager>
 #include <QColor>
 #include <QObject>
+#include <QStringList>
 
 namespace Nedrysoft { namespace RouteAnalyser {
     /**
@@ -35,7 +38,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
      *              parameters such as the default values for the latency thresholds and the default colour which
      *              is used for the various boundaries.
      */
-    class LatencySettings : public
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC LatencySettings : public
             QObject,
             Nedrysoft::Core::IConfiguration {
 
@@ -186,6 +189,178 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             Q_SIGNAL void gradientChanged(bool useGradient);
 
+            /**
+             * @brief       Sets whether the plots are drawn with OpenGL.
+             *
+             * @details     OpenGL is only used if the plot library was built with OpenGL support
+             *              (Pingnoo_OpenGL_Plots), otherwise the plots continue to use the raster backend.
+             *
+             * @param[in]   useHardwareAcceleration true to draw with OpenGL; otherwise false.
+             */
+            auto setHardwareAcceleration(bool useHardwareAcceleration) -> void;
+
+            /**
+             * @brief       Returns whether the plots are drawn with OpenGL.
+             *
+             * @returns     true if OpenGL is used; otherwise false.
+             */
+            auto hardwareAcceleration() -> bool;
+
+            /**
+             * @brief       This signal is emitted when the plot backend changes.
+             *
+             * @param[in]   useHardwareAcceleration true if the plots are drawn with OpenGL; otherwise false.
+             */
+            Q_SIGNAL void hardwareAccelerationChanged(bool useHardwareAcceleration);
+
+            /**
+             * @brief       Sets whether the measured overhead of the ping engine is subtracted from round trip times.
+             *
+             * @details     The overhead is measured by the overhead calibrator with probes to the loopback
+             *              address, it is the time that this host adds to every round trip.
+             *
+             * @param[in]   compensate true to subtract the overhead; otherwise false.
+             */
+            auto setOverheadCompensation(bool compensate) -> void;
+
+            /**
+             * @brief       Returns whether the measured overhead of the ping engine is subtracted from round trip times.
+             *
+             * @returns     true if the overhead is subtracted; otherwise false.
+             */
+            auto overheadCompensation() -> bool;
+
+            /**
+             * @brief       This signal is emitted when overhead compensation is enabled or disabled.
+             *
+             * @param[in]   compensate true if the overhead is subtracted; otherwise false.
+             */
+            Q_SIGNAL void overheadCompensationChanged(bool compensate);
+
+            /**
+             * @brief       Sets how often the hops before the destination are probed.
+             *
+             * @details     The destination is always probed every round.  The other hops are probed once every
+             *              divisor rounds, and return to every round while the destination shows loss or a jump in
+             *              latency.  A divisor of 1 probes every hop in every round.
+             *
+             * @param[in]   divisor the number of rounds between probes of an intermediate hop.
+             */
+            auto setIntermediateHopDivisor(int divisor) -> void;
+
+            /**
+             * @brief       Returns how often the hops before the destination are probed.
+             *
+             * @returns     the number of rounds between probes of an intermediate hop.
+             */
+            auto intermediateHopDivisor() -> int;
+
+            /**
+             * @brief       This signal is emitted when the rate that intermediate hops are probed at changes.
+             *
+             * @param[in]   divisor the number of rounds between probes of an intermediate hop.
+             */
+            Q_SIGNAL void intermediateHopDivisorChanged(int divisor);
+
+            /**
+             * @brief       Sets the number of probes sent to each hop in every round.
+             *
+             * @details     With more than one probe per round each round is summarised by its median and the spread
+             *              of its replies is drawn as a smoke band around the median line.  The setting applies to
+             *              targets that are opened after it is changed.
+             *
+             * @param[in]   probes the number of probes per hop per round.
+             */
+            auto setProbesPerRound(int probes) -> void;
+
+            /**
+             * @brief       Returns the number of probes sent to each hop in every round.
+             *
+             * @returns     the number of probes per hop per round.
+             */
+            auto probesPerRound() -> int;
+
+            /**
+             * @brief       Sets whether power is saved while the computer is running from its battery.
+             *
+             * @see         Nedrysoft::RouteAnalyser::PowerProfile
+             *
+             * @param[in]   powerSaving true to save power on battery; otherwise false.
+             */
+            auto setPowerSaving(bool powerSaving) -> void;
+
+            /**
+             * @brief       Returns whether power is saved while the computer is running from its battery.
+             *
+             * @returns     true if power is saved on battery; otherwise false.
+             */
+            auto powerSaving() -> bool;
+
+            /**
+             * @brief       This signal is emitted when power saving is enabled or disabled.
+             *
+             * @param[in]   powerSaving true if power is saved on battery; otherwise false.
+             */
+            Q_SIGNAL void powerSavingChanged(bool powerSaving);
+
+            /**
+             * @brief       Sets the amount of memory that the result history of all open targets may use.
+             *
+             * @see         Nedrysoft::RouteAnalyser::MemoryGovernor
+             *
+             * @param[in]   megabytes the budget in megabytes, 0 for no limit.
+             */
+            auto setMemoryBudget(int megabytes) -> void;
+
+            /**
+             * @brief       Returns the amount of memory that the result history of all open targets may use.
+             *
+             * @returns     the budget in megabytes, 0 for no limit.
+             */
+            auto memoryBudget() -> int;
+
+            /**
+             * @brief       This signal is emitted when the memory budget is changed.
+             *
+             * @param[in]   megabytes the budget in megabytes, 0 for no limit.
+             */
+            Q_SIGNAL void memoryBudgetChanged(int megabytes);
+
+            /**
+             * @brief       Sets the alert rules that are evaluated against the hop statistics.
+             *
+             * @see         Nedrysoft::RouteAnalyser::AlertRule
+             *
+             * @param[in]   rules the rule texts.
+             */
+            auto setAlertRules(const QStringList &rules) -> void;
+
+            /**
+             * @brief       Returns the alert rules that are evaluated against the hop statistics.
+             *
+             * @returns     the rule texts.
+             */
+            auto alertRules() -> QStringList;
+
+            /**
+             * @brief       Sets the URL that alerts with the webhook action are posted to.
+             *
+             * @param[in]   webhook the URL; empty to disable the webhook.
+             */
+            auto setAlertWebhook(const QString &webhook) -> void;
+
+            /**
+             * @brief       Returns the URL that alerts with the webhook action are posted to.
+             *
+             * @returns     the URL; empty if the webhook is disabled.
+             */
+            auto alertWebhook() -> QString;
+
+            /**
+             * @brief       This signal is emitted when the alert rules or the webhook are changed.
+             */
+            Q_SIGNAL void alertRulesChanged();
+
         public:
             /**
               * @brief       Saves the configuration to a JSON object.
@@ -224,6 +399,15 @@ namespace Nedrysoft { namespace RouteAnalyser {
             QRgb m_criticalColour;
 
             bool m_useGradientFill;
+            bool m_useHardwareAcceleration;
+            bool m_overheadCompensation;
+            int m_intermediateHopDivisor;
+            int m_probesPerRound;
+            bool m_powerSaving;
+            int m_memoryBudget;
+
+            QStringList m_alertRules;
+            QString m_alertWebhook;
 
             //! @endcond
     };
@@ -108,6 +108,21 @@ Nedrysoft::RouteAnalyser::LatencySettingsPageWidget::LatencySettingsPageWidget(Q
     }
 
     ui->gradientFillcheckBox->setChecked(latencySettings->gradientFill() ? Qt::Checked : Qt::Unchecked);
+
+    ui->hardwareAccelerationCheckBox->setChecked(
+        latencySettings->hardwareAcceleration() ? Qt::Checked : Qt::Unchecked
+    );
+
+    ui->overheadCompensationCheckBox->setChecked(
+        latencySettings->overheadCompensation() ? Qt::Checked : Qt::Unchecked
+    );
+
+    ui->intermediateHopDivisorSpinBox->setValue(latencySettings->intermediateHopDivisor());
+    ui->probesPerRoundSpinBox->setValue(latencySettings->probesPerRound());
+
+    ui->powerSavingCheckBox->setChecked(latencySettings->powerSaving() ? Qt::Checked : Qt::Unchecked);
+
+    ui->memoryBudgetSpinBox->setValue(latencySettings->memoryBudget());
 }
 
 Nedrysoft::RouteAnalyser::LatencySettingsPageWidget::~LatencySettingsPageWidget() {
@@ -140,6 +155,12 @@ auto Nedrysoft::RouteAnalyser::LatencySettingsPageWidget::acceptSettings() -> vo
     latencySettings->setCriticalColour(ui->criticalWidget->colour().rgb());
 
     latencySettings->setGradientFill(ui->gradientFillcheckBox->isChecked());
+    latencySettings->setHardwareAcceleration(ui->hardwareAccelerationCheckBox->isChecked());
+    latencySettings->setOverheadCompensation(ui->overheadCompensationCheckBox->isChecked());
+    latencySettings->setIntermediateHopDivisor(ui->intermediateHopDivisorSpinBox->value());
+    latencySettings->setProbesPerRound(ui->probesPerRoundSpinBox->value());
+    latencySettings->setPowerSaving(ui->powerSavingCheckBox->isChecked());
+    latencySettings->setMemoryBudget(ui->memoryBudgetSpinBox->value());
 
     latencySettings->saveToFile();
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LatencySketch.h"
+
+#include <QDataStream>
+#include <algorithm>
+#include <cmath>
+
+constexpr auto RelativeAccuracy = 0.01;
+constexpr auto Gamma = (1.0+RelativeAccuracy)/(1.0-RelativeAccuracy);
+constexpr auto MinimumValue = 1e-6;
+constexpr auto MaximumBins = 4096u;
+
+static auto logGamma() -> double {
+    static const auto value = std::log(Gamma);
+
+    return value;
+}
+
+Nedrysoft::RouteAnalyser::LatencySketch::LatencySketch() :
+        m_offset(0),
+        m_zeroCount(0),
+        m_count(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::binIndex(double value) -> int {
+    return static_cast<int>(std::ceil(std::log(value)/logGamma()));
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::binValue(int index) -> double {
+    /**
+     * a bin holds the values in (gamma^(index-1), gamma^index], the estimate that is within the relative
+     * accuracy of every value in the bin is 2*gamma^index/(gamma+1).
+     */
+
+    return 2.0*std::pow(Gamma, index)/(Gamma+1.0);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::ensureBin(int index) -> void {
+    if (m_bins.empty()) {
+        m_bins.resize(1);
+        m_offset = index;
+
+        return;
+    }
+
+    if (index<m_offset) {
+        m_bins.insert(m_bins.begin(), static_cast<size_t>(m_offset-index), 0);
+        m_offset = index;
+    } else if (index>=m_offset+static_cast<int>(m_bins.size())) {
+        m_bins.resize(static_cast<size_t>(index-m_offset+1));
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::addCount(double value, uint64_t count) -> void {
+    if (value<MinimumValue) {
+        m_zeroCount += count;
+
+        return;
+    }
+
+    auto index = binIndex(value);
+
+    ensureBin(index);
+
+    m_bins[index-m_offset] += static_cast<uint32_t>(count);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::add(double value) -> void {
+    m_count++;
+
+    addCount(value, 1);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::merge(const LatencySketch &other) -> void {
+    if (!other.m_bins.empty()) {
+        ensureBin(other.m_offset);
+        ensureBin(other.m_offset+static_cast<int>(other.m_bins.size())-1);
+
+        for (auto bin=0;bin<static_cast<int>(other.m_bins.size());bin++) {
+            m_bins[other.m_offset+bin-m_offset] += other.m_bins[bin];
+        }
+    }
+
+    m_zeroCount += other.m_zeroCount;
+    m_count += other.m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::shift(double offset) -> void {
+    if ((offset<=0) || (!m_count)) {
+        return;
+    }
+
+    auto bins = std::vector<uint32_t>();
+    auto binOffset = m_offset;
+    auto zeroCount = m_zeroCount;
+
+    bins.swap(m_bins);
+
+    m_offset = 0;
+    m_zeroCount = 0;
+
+    if (zeroCount) {
+        addCount(offset, zeroCount);
+    }
+
+    for (auto bin=0;bin<static_cast<int>(bins.size());bin++) {
+        if (bins[bin]) {
+            addCount(binValue(bin+binOffset)+offset, bins[bin]);
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::clear() -> void {
+    m_bins.clear();
+    m_offset = 0;
+    m_zeroCount = 0;
+    m_count = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::count() const -> uint64_t {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::memoryUsage() const -> size_t {
+    return sizeof(LatencySketch)+m_bins.capacity()*sizeof(uint32_t);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::isEmpty() const -> bool {
+    return m_count==0;
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::quantile(double quantile) const -> double {
+    if (!m_count) {
+        return -1;
+    }
+
+    auto rank = static_cast<uint64_t>(std::clamp(quantile, 0.0, 1.0)*static_cast<double>(m_count-1));
+
+    if (rank<m_zeroCount) {
+        return 0;
+    }
+
+    auto seen = m_zeroCount;
+
+    for (auto bin=0;bin<static_cast<int>(m_bins.size());bin++) {
+        seen += m_bins[bin];
+
+        if (seen>rank) {
+            return binValue(bin+m_offset);
+        }
+    }
+
+    return binValue(m_offset+static_cast<int>(m_bins.size())-1);
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::save(QDataStream &stream) const -> void {
+    stream << static_cast<qint32>(m_offset)
+           << static_cast<quint64>(m_zeroCount)
+           << static_cast<quint64>(m_count)
+           << static_cast<quint32>(m_bins.size());
+
+    for (auto bin : m_bins) {
+        stream << static_cast<quint32>(bin);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::LatencySketch::load(QDataStream &stream) -> bool {
+    auto offset = qint32(0);
+    auto zeroCount = quint64(0);
+    auto count = quint64(0);
+    auto binCount = quint32(0);
+
+    stream >> offset >> zeroCount >> count >> binCount;
+
+    if ((stream.status()!=QDataStream::Ok) || (binCount>MaximumBins)) {
+        return false;
+    }
+
+    auto bins = std::vector<uint32_t>(binCount);
+
+    for (auto &bin : bins) {
+        auto value = quint32(0);
+
+        stream >> value;
+
+        bin = value;
+    }
+
+    if (stream.status()!=QDataStream::Ok) {
+        return false;
+    }
+
+    m_bins.swap(bins);
+    m_offset = offset;
+    m_zeroCount = zeroCount;
+    m_count = count;
+
+    return true;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_LATENCYSKETCH_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_LATENCYSKETCH_H
+
+#include "RouteAnalyserSpec.h"
+
+#include <cstdint>
+#include <vector>
+
+class QDataStream;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The LatencySketch class provides a streaming estimate of latency percentiles.
+     *
+     * @details     The sketch is a DDSketch, values are counted in logarithmically sized bins so that any
+     *              percentile is returned within 1% of the true value however many values have been added,
+     *              the bins are held in a dense array covering the range of values seen so adding a value
+     *              takes constant time once its bin exists.
+     *
+     *              Two sketches can be merged by adding their bins, which gives the same result as a single
+     *              sketch of all the values, so the percentiles of a period can be built from sketches of
+     *              smaller periods without revisiting the samples.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC LatencySketch {
+        public:
+            /**
+             * @brief       Constructs an empty LatencySketch.
+             */
+            LatencySketch();
+
+            /**
+             * @brief       Adds a value to the sketch.
+             *
+             * @param[in]   value the latency in seconds.
+             */
+            auto add(double value) -> void;
+
+            /**
+             * @brief       Adds the values of another sketch to this sketch.
+             *
+             * @param[in]   other the sketch to merge.
+             */
+            auto merge(const LatencySketch &other) -> void;
+
+            /**
+             * @brief       Adds an offset to every value in the sketch.
+             *
+             * @details     The count of each bin is moved to the bin of its estimate plus the offset, so each
+             *              shift can add up to the relative accuracy of the sketch to the error of a value.
+             *
+             * @param[in]   offset the offset in seconds, offsets that are not positive are ignored.
+             */
+            auto shift(double offset) -> void;
+
+            /**
+             * @brief       Removes all values from the sketch.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of values added to the sketch.
+             *
+             * @returns     the number of values.
+             */
+            auto count() const -> uint64_t;
+
+            /**
+             * @brief       Returns the number of bytes used by the sketch.
+             *
+             * @returns     the number of bytes, including the bins.
+             */
+            auto memoryUsage() const -> size_t;
+
+            /**
+             * @brief       Returns whether the sketch is empty.
+             *
+             * @returns     true if no values have been added; otherwise false.
+             */
+            auto isEmpty() const -> bool;
+
+            /**
+             * @brief       Returns the estimated value at a quantile.
+             *
+             * @param[in]   quantile the quantile between 0 and 1, i.e 0.95 for the 95th percentile.
+             *
+             * @returns     the latency in seconds; otherwise -1 if the sketch is empty.
+             */
+            auto quantile(double quantile) const -> double;
+
+            /**
+             * @brief       Writes the sketch to a stream.
+             *
+             * @param[in]   stream the stream to write to.
+             */
+            auto save(QDataStream &stream) const -> void;
+
+            /**
+             * @brief       Reads a sketch written by save(), replacing the contents of this sketch.
+             *
+             * @param[in]   stream the stream to read from.
+             *
+             * @returns     true if the sketch was read; otherwise false.
+             */
+            auto load(QDataStream &stream) -> bool;
+
+        private:
+            //! @cond
+
+            static auto binIndex(double value) -> int;
+
+            static auto binValue(int index) -> double;
+
+            auto ensureBin(int index) -> void;
+
+            auto addCount(double value, uint64_t count) -> void;
+
+            //! @endcond
+
+        private:
+            //! @cond
+
+            std::vector<uint32_t> m_bins;
+            int m_offset;
+            uint64_t m_zeroCount;
+            uint64_t m_count;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_LATENCYSKETCH_H
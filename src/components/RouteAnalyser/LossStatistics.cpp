@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LossStatistics.h"
+
+#include <algorithm>
+
+constexpr auto BitsPerWord = 64;
+constexpr auto NoPrevious = -1;
+constexpr auto PreviousReply = 0;
+constexpr auto PreviousLost = 1;
+
+static auto burstBucket(int length) -> int {
+    auto bucket = 0;
+
+    while ((length>>=1) && (bucket<Nedrysoft::RouteAnalyser::LossStatistics::BurstBuckets-1)) {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+Nedrysoft::RouteAnalyser::LossStatistics::LossStatistics(int shortWindow, int longWindow) :
+        m_shortWindow {std::vector<uint64_t>((std::max(shortWindow, 1)+BitsPerWord-1)/BitsPerWord),
+                       std::max(shortWindow, 1), 0, 0, 0},
+        m_longWindow {std::vector<uint64_t>((std::max(longWindow, 1)+BitsPerWord-1)/BitsPerWord),
+                      std::max(longWindow, 1), 0, 0, 0} {
+
+    clear();
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::windowAdd(Window &window, bool lost) -> void {
+    auto &word = window.bits[window.position/BitsPerWord];
+    auto mask = uint64_t(1) << (window.position%BitsPerWord);
+
+    if (window.count==window.size) {
+        if (word & mask) {
+            window.lost--;
+        }
+    } else {
+        window.count++;
+    }
+
+    if (lost) {
+        word |= mask;
+        window.lost++;
+    } else {
+        word &= ~mask;
+    }
+
+    window.position = (window.position+1) % window.size;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::windowLoss(const Window &window) -> double {
+    if (!window.count) {
+        return -1;
+    }
+
+    return (static_cast<double>(window.lost)/window.count)*100.0;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::add(bool lost) -> void {
+    windowAdd(m_shortWindow, lost);
+    windowAdd(m_longWindow, lost);
+
+    if (m_previous==PreviousReply) {
+        m_goodTransitions++;
+
+        if (lost) {
+            m_goodToBad++;
+        }
+    } else if (m_previous==PreviousLost) {
+        m_badTransitions++;
+
+        if (!lost) {
+            m_badToGood++;
+        }
+    }
+
+    if (lost) {
+        if (!m_currentBurst) {
+            m_episodes++;
+        }
+
+        m_currentBurst++;
+        m_longestBurst = std::max(m_longestBurst, m_currentBurst);
+    } else if (m_currentBurst) {
+        m_bursts[burstBucket(m_currentBurst)]++;
+        m_currentBurst = 0;
+    }
+
+    m_previous = lost ? PreviousLost : PreviousReply;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::clear() -> void {
+    for (auto window : {&m_shortWindow, &m_longWindow}) {
+        std::fill(window->bits.begin(), window->bits.end(), 0);
+
+        window->position = 0;
+        window->count = 0;
+        window->lost = 0;
+    }
+
+    m_bursts.fill(0);
+
+    m_currentBurst = 0;
+    m_longestBurst = 0;
+    m_previous = NoPrevious;
+    m_episodes = 0;
+    m_goodTransitions = 0;
+    m_goodToBad = 0;
+    m_badTransitions = 0;
+    m_badToGood = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::shortWindowLoss() const -> double {
+    return windowLoss(m_shortWindow);
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::longWindowLoss() const -> double {
+    return windowLoss(m_longWindow);
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::episodes() const -> uint64_t {
+    return m_episodes;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::bursts(int bucket) const -> uint64_t {
+    if ((bucket<0) || (bucket>=BurstBuckets)) {
+        return 0;
+    }
+
+    return m_bursts[bucket];
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::longestBurst() const -> int {
+    return m_longestBurst;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::goodToBadProbability() const -> double {
+    return m_goodTransitions ? static_cast<double>(m_goodToBad)/m_goodTransitions : 0;
+}
+
+auto Nedrysoft::RouteAnalyser::LossStatistics::badToGoodProbability() const -> double {
+    return m_badTransitions ? static_cast<double>(m_badToGood)/m_badTransitions : 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_LOSSSTATISTICS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_LOSSSTATISTICS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The LossStatistics class tracks recent packet loss and the structure of loss bursts.
+     *
+     * @details     The outcome of the most recent requests is held in bitset rings, one per window, with a
+     *              running count of the lost requests in each, so the loss over a window is available without
+     *              scanning it and an old outage no longer affects the figure once it leaves the window.
+     *
+     *              Runs of consecutive lost requests are counted into a burst length histogram, and the
+     *              transitions between replies and losses provide the parameters of a two state Gilbert-Elliott
+     *              model of the path.  Every update is constant time.
+     */
+    class LossStatistics {
+        public:
+            /**
+             * @brief       The number of burst length histogram buckets.
+             *
+             * @details     Bucket n counts the bursts of 2^n to 2^(n+1)-1 lost requests, the last bucket counts
+             *              every longer burst.
+             */
+            static constexpr int BurstBuckets = 8;
+
+            /**
+             * @brief       The default short window, a minute of requests at the default interval.
+             */
+            static constexpr int DefaultShortWindow = 60;
+
+            /**
+             * @brief       The default long window, 15 minutes of requests at the default interval.
+             */
+            static constexpr int DefaultLongWindow = 900;
+
+        public:
+            /**
+             * @brief       Constructs a LossStatistics.
+             *
+             * @param[in]   shortWindow the number of requests in the short window.
+             * @param[in]   longWindow the number of requests in the long window.
+             */
+            explicit LossStatistics(int shortWindow = DefaultShortWindow, int longWindow = DefaultLongWindow);
+
+            /**
+             * @brief       Adds the outcome of a request.
+             *
+             * @param[in]   lost true if the request was not answered; otherwise false.
+             */
+            auto add(bool lost) -> void;
+
+            /**
+             * @brief       Removes all outcomes.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the loss over the short window.
+             *
+             * @returns     the percentage of requests lost; otherwise -1 if no requests have been added.
+             */
+            auto shortWindowLoss() const -> double;
+
+            /**
+             * @brief       Returns the loss over the long window.
+             *
+             * @returns     the percentage of requests lost; otherwise -1 if no requests have been added.
+             */
+            auto longWindowLoss() const -> double;
+
+            /**
+             * @brief       Returns the number of loss episodes, a run of one or more consecutive losses.
+             *
+             * @returns     the number of episodes.
+             */
+            auto episodes() const -> uint64_t;
+
+            /**
+             * @brief       Returns the number of bursts in a burst length histogram bucket.
+             *
+             * @param[in]   bucket the bucket.
+             *
+             * @returns     the number of completed bursts.
+             */
+            auto bursts(int bucket) const -> uint64_t;
+
+            /**
+             * @brief       Returns the length of the longest burst.
+             *
+             * @returns     the number of consecutive lost requests.
+             */
+            auto longestBurst() const -> int;
+
+            /**
+             * @brief       Returns the Gilbert-Elliott probability of moving from the good to the bad state.
+             *
+             * @returns     the probability that a reply is followed by a loss.
+             */
+            auto goodToBadProbability() const -> double;
+
+            /**
+             * @brief       Returns the Gilbert-Elliott probability of moving from the bad to the good state.
+             *
+             * @returns     the probability that a loss is followed by a reply.
+             */
+            auto badToGoodProbability() const -> double;
+
+        private:
+            //! @cond
+
+            struct Window {
+                std::vector<uint64_t> bits;
+                int size;
+                int position;
+                int count;
+                int lost;
+            };
+
+            static auto windowAdd(Window &window, bool lost) -> void;
+
+            static auto windowLoss(const Window &window) -> double;
+
+            Window m_shortWindow;
+            Window m_longWindow;
+
+            std::array<uint64_t, BurstBuckets> m_bursts;
+
+            int m_currentBurst;
+            int m_longestBurst;
+            int m_previous;
+
+            uint64_t m_episodes;
+            uint64_t m_goodTransitions;
+            uint64_t m_goodToBad;
+            uint64_t m_badTransitions;
+            uint64_t m_badToGood;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_LOSSSTATISTICS_H
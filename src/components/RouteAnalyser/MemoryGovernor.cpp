@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MemoryGovernor.h"
+
+#include "HopTimeSeries.h"
+#include "LatencySettings.h"
+
+#include <algorithm>
+#include <limits>
+
+constexpr auto EnforceInterval = 10000;
+constexpr auto MinimumSamples = 600;
+constexpr auto BytesPerMegabyte = 1024*1024;
+
+Nedrysoft::RouteAnalyser::MemoryGovernor::MemoryGovernor() :
+        m_budget(0) {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        m_budget = static_cast<qint64>(latencySettings->memoryBudget())*BytesPerMegabyte;
+
+        connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::memoryBudgetChanged,
+            this,
+            [=](int megabytes) {
+                setBudget(static_cast<qint64>(megabytes)*BytesPerMegabyte);
+            }
+        );
+    }
+
+    m_timer.setTimerType(Qt::VeryCoarseTimer);
+    m_timer.setInterval(EnforceInterval);
+
+    connect(&m_timer, &QTimer::timeout, this, [=]() {
+        enforce();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance() -> Nedrysoft::RouteAnalyser::MemoryGovernor * {
+    static Nedrysoft::RouteAnalyser::MemoryGovernor instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::setBudget(qint64 bytes) -> void {
+    m_budget = std::max<qint64>(bytes, 0);
+
+    enforce();
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::budget() const -> qint64 {
+    return m_budget;
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::addOwner(
+        QObject *owner,
+        int interval,
+        SeriesFunction series,
+        std::function<void()> trimmed ) -> void {
+
+    if (!owner) {
+        return;
+    }
+
+    if (!m_owners.contains(owner)) {
+        connect(owner, &QObject::destroyed, this, [=](QObject *) {
+            removeOwner(owner);
+        });
+    }
+
+    auto retention = m_owners.value(owner).retention;
+
+    m_owners[owner] = Owner{std::max(interval, 1), series, trimmed, retention};
+
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::removeOwner(QObject *owner) -> void {
+    if (!m_owners.remove(owner)) {
+        return;
+    }
+
+    disconnect(owner, &QObject::destroyed, this, nullptr);
+
+    if (m_owners.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::setRetention(QObject *owner, const Retention &retention) -> void {
+    if (!m_owners.contains(owner)) {
+        return;
+    }
+
+    m_owners[owner].retention = retention;
+
+    enforce();
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::retention(QObject *owner) const -> Retention {
+    return m_owners.value(owner).retention;
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::usage() const -> qint64 {
+    qint64 total = 0;
+
+    for (auto &owner : m_owners) {
+        for (auto series : owner.series()) {
+            total += static_cast<qint64>(series->memoryUsage());
+        }
+    }
+
+    return total;
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::enforce() -> void {
+    QHash<QObject *, bool> trimmed;
+
+    // the retention policy of each owner is applied first, it only ever reduces what is held.
+
+    for (auto it=m_owners.begin();it!=m_owners.end();it++) {
+        auto &retention = it->retention;
+        auto seriesList = it->series();
+
+        if (seriesList.isEmpty()) {
+            continue;
+        }
+
+        switch(retention.type) {
+            case Retention::Type::Time: {
+                auto capacity = static_cast<int>(std::min<qint64>(
+                        std::max<qint64>(retention.value*1000/it->interval, 1),
+                        std::numeric_limits<int>::max() ));
+
+                for (auto series : seriesList) {
+                    if (series->capacity()>capacity) {
+                        series->setCapacity(capacity);
+
+                        trimmed[it.key()] = true;
+                    }
+                }
+
+                break;
+            }
+
+            case Retention::Type::Size: {
+                auto share = retention.value/seriesList.count();
+
+                for (auto series : seriesList) {
+                    if (reduce(series, share)) {
+                        trimmed[it.key()] = true;
+                    }
+                }
+
+                break;
+            }
+
+            case Retention::Type::Budget: {
+                break;
+            }
+        }
+    }
+
+    /**
+     * the global budget is then shared in proportion to what each series uses, so every target gives up the same
+     * fraction of its history rather than the most recently opened target losing everything.
+     */
+
+    auto total = usage();
+
+    if ((m_budget>0) && (total>m_budget)) {
+        auto ratio = static_cast<double>(m_budget)/static_cast<double>(total);
+
+        for (auto it=m_owners.begin();it!=m_owners.end();it++) {
+            for (auto series : it->series()) {
+                auto allowed = static_cast<qint64>(static_cast<double>(series->memoryUsage())*ratio);
+
+                if (reduce(series, allowed)) {
+                    trimmed[it.key()] = true;
+                }
+            }
+        }
+    }
+
+    for (auto owner : trimmed.keys()) {
+        if ((m_owners.contains(owner)) && (m_owners[owner].trimmed)) {
+            m_owners[owner].trimmed();
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::MemoryGovernor::reduce(
+        Nedrysoft::RouteAnalyser::HopTimeSeries *series,
+        qint64 bytes ) -> bool {
+
+    auto excess = static_cast<qint64>(series->memoryUsage())-bytes;
+
+    if (excess<=0) {
+        return false;
+    }
+
+    auto reduced = false;
+
+    // raw samples are demoted into the archive first, the rollups still summarise them at the coarser levels.
+
+    auto capacity = std::max(
+            series->capacity()-static_cast<int>(excess/static_cast<qint64>(HopTimeSeries::sampleSize())),
+            MinimumSamples );
+
+    if (capacity<series->capacity()) {
+        series->setCapacity(capacity);
+
+        reduced = true;
+    }
+
+    // the oldest archive blocks are discarded last, those samples remain in the session journal when it is enabled.
+
+    auto &archive = series->archive();
+
+    while ((static_cast<qint64>(series->memoryUsage())>bytes) && (archive.blockCount()>1)) {
+        series->setArchiveBlocks(archive.blockCount()-1);
+
+        reduced = true;
+    }
+
+    return reduced;
+}
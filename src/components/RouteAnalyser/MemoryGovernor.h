@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_MEMORYGOVERNOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_MEMORYGOVERNOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class HopTimeSeries;
+
+    /**
+     * @brief       The MemoryGovernor class keeps the result history of all open targets within a memory budget.
+     *
+     * @details     Each editor registers the series of its hops with the governor, which periodically measures
+     *              them.  When a retention policy or the global budget is exceeded the oldest raw samples are
+     *              demoted into the compressed archive (their summary remains in the coarser rollups), and if that
+     *              is not enough the oldest archive blocks are discarded, which leaves those samples only in the
+     *              session journal.
+     *
+     *              The global budget is shared in proportion to the memory that each series uses, so a target
+     *              with many hops gives up more than one with few.  The governor must only be used from the GUI
+     *              thread, as that is where the series are updated.
+     */
+    class MemoryGovernor :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       A retention policy for the history of one editor.
+             */
+            struct Retention {
+                /**
+                 * @brief       The kind of limit that the policy applies.
+                 */
+                enum class Type {
+                    Budget,                         //! only the global budget applies.
+                    Time,                           //! the raw samples cover at most value seconds.
+                    Size                            //! the history of the editor uses at most value bytes.
+                };
+
+                Type type = Type::Budget;
+                qint64 value = 0;
+            };
+
+            /**
+             * @brief       Returns the series that belong to an editor.
+             */
+            using SeriesFunction = std::function<QVector<Nedrysoft::RouteAnalyser::HopTimeSeries *>()>;
+
+        private:
+            /**
+             * @brief       Constructs the MemoryGovernor.
+             */
+            MemoryGovernor();
+
+        public:
+            /**
+             * @brief       Returns the process wide instance of the governor.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> MemoryGovernor *;
+
+            /**
+             * @brief       Sets the amount of memory that all of the registered series may use.
+             *
+             * @param[in]   bytes the budget, 0 for no limit.
+             */
+            auto setBudget(qint64 bytes) -> void;
+
+            /**
+             * @brief       Returns the amount of memory that all of the registered series may use.
+             *
+             * @returns     the budget in bytes, 0 for no limit.
+             */
+            auto budget() const -> qint64;
+
+            /**
+             * @brief       Registers the series of an editor.
+             *
+             * @details     The owner is removed automatically when it is destroyed.
+             *
+             * @param[in]   owner the object that owns the series.
+             * @param[in]   interval the interval between samples in milliseconds.
+             * @param[in]   series the function that returns the series of the owner.
+             * @param[in]   trimmed the function called after samples have been removed from the series.
+             */
+            auto addOwner(QObject *owner, int interval, SeriesFunction series, std::function<void()> trimmed) -> void;
+
+            /**
+             * @brief       Removes an owner.
+             *
+             * @param[in]   owner the owner.
+             */
+            auto removeOwner(QObject *owner) -> void;
+
+            /**
+             * @brief       Sets the retention policy of an owner.
+             *
+             * @param[in]   owner the owner.
+             * @param[in]   retention the policy.
+             */
+            auto setRetention(QObject *owner, const Retention &retention) -> void;
+
+            /**
+             * @brief       Returns the retention policy of an owner.
+             *
+             * @param[in]   owner the owner.
+             *
+             * @returns     the policy.
+             */
+            auto retention(QObject *owner) const -> Retention;
+
+            /**
+             * @brief       Returns the memory used by all of the registered series.
+             *
+             * @returns     the number of bytes.
+             */
+            auto usage() const -> qint64;
+
+            /**
+             * @brief       Applies the retention policies and the budget.
+             *
+             * @details     This is called periodically, it may also be called after a policy is changed so that it
+             *              takes effect straight away.
+             */
+            auto enforce() -> void;
+
+        private:
+            /**
+             * @brief       Reduces a series until it uses no more than the given amount of memory.
+             *
+             * @param[in]   series the series.
+             * @param[in]   bytes the amount of memory that the series may use.
+             *
+             * @returns     true if samples were moved or discarded; otherwise false.
+             */
+            auto reduce(Nedrysoft::RouteAnalyser::HopTimeSeries *series, qint64 bytes) -> bool;
+
+        private:
+            //! @cond
+
+            struct Owner {
+                int interval = 1;
+                SeriesFunction series;
+                std::function<void()> trimmed;
+                Retention retention;
+            };
+
+            QHash<QObject *, Owner> m_owners;
+            QTimer m_timer;
+            qint64 m_budget;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_MEMORYGOVERNOR_H
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MergedRouteEditor.h"
+
+#include "MergedRouteWidget.h"
+
+#include <IContextManager>
+
+constexpr auto DefaultMergedInterval = 2.5;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+Nedrysoft::RouteAnalyser::MergedRouteEditor::MergedRouteEditor() :
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_interval(DefaultMergedInterval),
+        m_editorWidget(nullptr) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::setTarget(const QString &host) -> void {
+    m_host = host;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::setIPVersion(Nedrysoft::Core::IPVersion ipVersion) -> void {
+    m_ipVersion = ipVersion;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::setInterval(double interval) -> void {
+    m_interval = interval;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::widget() -> QWidget * {
+    if (!m_editorWidget) {
+        m_editorWidget = new Nedrysoft::RouteAnalyser::MergedRouteWidget(
+            m_host,
+            m_ipVersion,
+            static_cast<int>(m_interval*MillisecondsInSecond)
+        );
+    }
+
+    return m_editorWidget;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::displayName() -> QString {
+    return tr("%1 (merged)").arg(m_host);
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::activated() -> void {
+
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::deactivated() -> void {
+
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteEditor::contextId() -> int {
+    return Nedrysoft::Core::GlobalContext;
+}
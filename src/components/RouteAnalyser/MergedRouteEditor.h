@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEEDITOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEEDITOR_H
+
+#include <ICore>
+#include <IEditor>
+#include <QObject>
+#include <QString>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class MergedRouteWidget;
+
+    /**
+     * @brief       The MergedRouteEditor class provides an editor that shows a target from every vantage point.
+     *
+     * @details     The routes from each vantage point are shown as a single table, aligned where the paths
+     *              converge.
+     */
+    class MergedRouteEditor :
+            public Nedrysoft::Core::IEditor {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::Core::IEditor)
+
+        public:
+            /**
+             * @brief       Constructs a new MergedRouteEditor.
+             */
+            MergedRouteEditor();
+
+            /**
+             * @brief       Sets the target.
+             *
+             * @param[in]   host the host name or address of the target.
+             */
+            auto setTarget(const QString &host) -> void;
+
+            /**
+             * @brief       Sets the IP version used to monitor the target.
+             *
+             * @param[in]   ipVersion the IP version.
+             */
+            auto setIPVersion(Nedrysoft::Core::IPVersion ipVersion) -> void;
+
+            /**
+             * @brief       Sets the interval between requests to each hop.
+             *
+             * @param[in]   interval the interval in seconds.
+             */
+            auto setInterval(double interval) -> void;
+
+            /**
+             * @brief       Returns the widget for the editor.
+             *
+             * @see         Nedrysoft::Core::IEditor::widget
+             *
+             * @returns     the widget.
+             */
+            auto widget() -> QWidget * override;
+
+            /**
+             * @brief       Returns the display name for the editor.
+             *
+             * @see         Nedrysoft::Core::IEditor::displayName
+             *
+             * @returns     the display name of the editor.
+             */
+            auto displayName() -> QString override;
+
+            /**
+             * @brief       The editor manager calls this method when an editor is activated.
+             *
+             * @see         Nedrysoft::Core::IEditor::activated
+             */
+            auto activated() -> void override;
+
+            /**
+             * @brief       The editor manager calls this method when an editor is deactivated.
+             *
+             * @see         Nedrysoft::Core::IEditor::deactivated
+             */
+            auto deactivated() -> void override;
+
+            /**
+             * @brief       Returns the context id for this editor.
+             *
+             * @details     The merged route has no commands of its own, it uses the global context.
+             *
+             * @see         Nedrysoft::Core::IEditor::contextId
+             *
+             * @returns     the context id.
+             */
+            auto contextId() -> int override;
+
+        private:
+            //! @cond
+
+            QString m_host;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            double m_interval;
+            Nedrysoft::RouteAnalyser::MergedRouteWidget *m_editorWidget;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEEDITOR_H
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MergedRouteModel.h"
+
+#include "VantageMerger.h"
+
+#include <QStringList>
+
+constexpr auto MedianRank = 0.5;
+constexpr auto PercentileRank = 0.95;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+Nedrysoft::RouteAnalyser::MergedRouteModel::MergedRouteModel(
+        const Nedrysoft::RouteAnalyser::VantageMerger *merger,
+        const QMap<int, QString> &vantagePoints,
+        QObject *parent ) :
+
+            QAbstractTableModel(parent),
+            m_merger(merger),
+            m_vantagePoints(vantagePoints),
+            m_layoutGeneration(merger->layoutGeneration()),
+            m_rowCount(merger->rows().count()) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteModel::refresh() -> void {
+    if (m_merger->layoutGeneration()!=m_layoutGeneration) {
+        beginResetModel();
+
+        m_layoutGeneration = m_merger->layoutGeneration();
+        m_rowCount = m_merger->rows().count();
+
+        endResetModel();
+
+        return;
+    }
+
+    if (!m_rowCount) {
+        return;
+    }
+
+    // a single change is signalled for every row, the view only repaints the cells that are visible.
+
+    Q_EMIT dataChanged(index(0, LatencyColumn), index(m_rowCount-1, LossColumn));
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteModel::rowCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_rowCount;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteModel::columnCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return ColumnCount;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteModel::data(const QModelIndex &index, int role) const -> QVariant {
+    if ((!index.isValid()) || (index.row()>=m_rowCount) || (index.row()>=m_merger->rows().count())) {
+        return QVariant();
+    }
+
+    auto &row = m_merger->rows().at(index.row());
+    auto &aggregate = row.aggregate;
+
+    if (role==Qt::TextAlignmentRole) {
+        if ((index.column()==HostColumn) || (index.column()==VantageColumn)) {
+            return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+        }
+
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role!=Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+        case HopColumn: {
+            auto hops = QStringList();
+
+            for (auto hop : row.hops) {
+                hops.append(QString::number(hop));
+            }
+
+            return hops.join(", ");
+        }
+
+        case HostColumn: {
+            return row.address.isNull() ? QString("*") : row.address.toString();
+        }
+
+        case VantageColumn: {
+            if (row.hops.count()==m_vantagePoints.count()) {
+                return tr("All");
+            }
+
+            auto vantagePoints = QStringList();
+
+            for (auto vantage : row.hops.keys()) {
+                vantagePoints.append(m_vantagePoints.value(vantage));
+            }
+
+            return vantagePoints.join(", ");
+        }
+
+        case LatencyColumn: {
+            if (aggregate.currentLatency<0) {
+                return QString();
+            }
+
+            return QString("%1").arg(aggregate.currentLatency*MillisecondsInSecond, 2, 'f', 2);
+        }
+
+        case AverageColumn: {
+            if (!aggregate.latency.count()) {
+                return QString();
+            }
+
+            return QString("%1").arg(aggregate.latency.mean()*MillisecondsInSecond, 2, 'f', 2);
+        }
+
+        case MedianColumn: {
+            if (aggregate.sketch.isEmpty()) {
+                return QString();
+            }
+
+            return QString("%1").arg(aggregate.sketch.quantile(MedianRank)*MillisecondsInSecond, 2, 'f', 2);
+        }
+
+        case PercentileColumn: {
+            if (aggregate.sketch.isEmpty()) {
+                return QString();
+            }
+
+            return QString("%1").arg(aggregate.sketch.quantile(PercentileRank)*MillisecondsInSecond, 2, 'f', 2);
+        }
+
+        case LossColumn: {
+            if (!(aggregate.replies+aggregate.timeouts)) {
+                return QString();
+            }
+
+            auto loss = (static_cast<double>(aggregate.timeouts)*100.0)/
+                        static_cast<double>(aggregate.replies+aggregate.timeouts);
+
+            return QString("%1").arg(loss, 2, 'f', 2);
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return QVariant();
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteModel::headerData(
+        int section,
+        Qt::Orientation orientation,
+        int role ) const -> QVariant {
+
+    if ((orientation!=Qt::Horizontal) || (role!=Qt::DisplayRole)) {
+        return QVariant();
+    }
+
+    switch (section) {
+        case HopColumn: {
+            return tr("Hop");
+        }
+
+        case HostColumn: {
+            return tr("Host");
+        }
+
+        case VantageColumn: {
+            return tr("Vantage Points");
+        }
+
+        case LatencyColumn: {
+            return tr("Cur");
+        }
+
+        case AverageColumn: {
+            return tr("Avg");
+        }
+
+        case MedianColumn: {
+            return tr("P50");
+        }
+
+        case PercentileColumn: {
+            return tr("P95");
+        }
+
+        case LossColumn: {
+            return tr("Loss %");
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return QVariant();
+}
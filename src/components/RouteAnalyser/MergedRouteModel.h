@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEMODEL_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QMap>
+#include <QString>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class VantageMerger;
+
+    /**
+     * @brief       The MergedRouteModel class provides the model for the merged route view.
+     *
+     * @details     Each row is a row of a VantageMerger, the model reads the merged aggregates directly from the
+     *              merger rather than copying them.  It is refreshed at a fixed rate, a refresh after the rows have
+     *              been realigned resets the model and otherwise signals a single change for all of the rows.
+     */
+    class MergedRouteModel :
+            public QAbstractTableModel {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The columns of the merged route.
+             */
+            enum Column {
+                HopColumn,
+                HostColumn,
+                VantageColumn,
+                LatencyColumn,
+                AverageColumn,
+                MedianColumn,
+                PercentileColumn,
+                LossColumn,
+                ColumnCount
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new MergedRouteModel.
+             *
+             * @param[in]   merger the merger that holds the rows.
+             * @param[in]   vantagePoints the names of the vantage points keyed by their identifiers.
+             * @param[in]   parent the owner of the model.
+             */
+            MergedRouteModel(
+                    const Nedrysoft::RouteAnalyser::VantageMerger *merger,
+                    const QMap<int, QString> &vantagePoints,
+                    QObject *parent = nullptr );
+
+            /**
+             * @brief       Updates the view from the current state of the merger.
+             */
+            auto refresh() -> void;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::rowCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of rows.
+             */
+            auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::columnCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of columns.
+             */
+            auto columnCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::data(const QModelIndex &index, int role).
+             *
+             * @param[in]   index the index of the cell.
+             * @param[in]   role the role.
+             *
+             * @returns     the data for the role.
+             */
+            auto data(const QModelIndex &index, int role = Qt::DisplayRole) const -> QVariant override;
+
+            /**
+             * @brief       Reimplements: QAbstractTableModel::headerData(int section, Qt::Orientation orientation,
+             *              int role).
+             *
+             * @param[in]   section the column.
+             * @param[in]   orientation the orientation of the header.
+             * @param[in]   role the role.
+             *
+             * @returns     the data for the role.
+             */
+            auto headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const ->
+                    QVariant override;
+
+        private:
+            //! @cond
+
+            const Nedrysoft::RouteAnalyser::VantageMerger *m_merger;
+            QMap<int, QString> m_vantagePoints;
+            quint64 m_layoutGeneration;
+            int m_rowCount;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEMODEL_H
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MergedRouteWidget.h"
+
+#include "HopCache.h"
+#include "IPingEngineFactory.h"
+#include "IRouteEngineFactory.h"
+#include "MergedRouteModel.h"
+#include "VantageMerger.h"
+
+#include <ObjectRegistry>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMap>
+#include <QMultiMap>
+#include <QTableView>
+#include <QTimer>
+#include <QVBoxLayout>
+
+constexpr auto MinimumRefreshInterval = 1000;
+constexpr auto MinimumVantagePoints = 2;
+constexpr auto RouteMonitorInterval = 60;
+constexpr auto DefaultPayloadSize = 52;
+constexpr auto MergedRowHeight = 22;
+constexpr auto HostColumnWidth = 200;
+constexpr auto VantageColumnWidth = 200;
+
+Nedrysoft::RouteAnalyser::MergedRouteWidget::MergedRouteWidget(
+        const QString &host,
+        Nedrysoft::Core::IPVersion ipVersion,
+        int interval,
+        QWidget *parent) :
+
+            QWidget(parent),
+            m_ipVersion(ipVersion),
+            m_interval(interval),
+            m_merger(new Nedrysoft::RouteAnalyser::VantageMerger),
+            m_model(nullptr),
+            m_tableView(new QTableView),
+            m_refreshTimer(new QTimer(this)) {
+
+    auto verticalLayout = new QVBoxLayout;
+
+#if (QT_VERSION_MAJOR>=6)
+    verticalLayout->setContentsMargins(0, 0, 0, 0);
+#else
+    verticalLayout->setMargin(0);
+#endif
+
+    setLayout(verticalLayout);
+
+    auto vantagePoints = QMap<int, QString>();
+
+    for (auto factory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if ((factory->vantagePoint().isEmpty()) || (!factory->available())) {
+            continue;
+        }
+
+        vantagePoints[m_vantages.count()] = factory->vantagePoint();
+
+        auto vantage = Vantage();
+
+        vantage.factory = factory;
+
+        m_vantages.append(vantage);
+    }
+
+    m_model = new Nedrysoft::RouteAnalyser::MergedRouteModel(m_merger, vantagePoints, this);
+
+    m_tableView->setModel(m_model);
+    m_tableView->setShowGrid(false);
+    m_tableView->setFrameStyle(QFrame::NoFrame);
+    m_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableView->verticalHeader()->setVisible(false);
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_tableView->verticalHeader()->setDefaultSectionSize(MergedRowHeight);
+    m_tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    m_tableView->horizontalHeader()->setStretchLastSection(true);
+
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::MergedRouteModel::HostColumn, HostColumnWidth);
+    m_tableView->setColumnWidth(Nedrysoft::RouteAnalyser::MergedRouteModel::VantageColumn, VantageColumnWidth);
+
+    verticalLayout->addWidget(m_tableView);
+
+    if (m_vantages.count()<MinimumVantagePoints) {
+        auto warningLabel = new QLabel(tr("A merged route needs at least two vantage points, configure a fleet of "
+                                          "ping agents to trace the target from each of them."));
+
+        warningLabel->setAlignment(Qt::AlignCenter);
+        warningLabel->setWordWrap(true);
+
+        verticalLayout->insertWidget(0, warningLabel);
+
+        return;
+    }
+
+    // the routes are discovered by the route engine with the highest priority.
+
+    QMultiMap<double, Nedrysoft::RouteAnalyser::IRouteEngineFactory *> sortedRouteEngines;
+
+    for (auto routeEngine : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IRouteEngineFactory>()) {
+        sortedRouteEngines.insert(1-routeEngine->priority(), routeEngine);
+    }
+
+    if (sortedRouteEngines.isEmpty()) {
+        return;
+    }
+
+    for (auto vantage=0;vantage<m_vantages.count();vantage++) {
+        auto routeEngine = sortedRouteEngines.first()->createEngine();
+
+        if (!routeEngine) {
+            continue;
+        }
+
+        m_vantages[vantage].routeEngine = routeEngine;
+
+        connect(
+            routeEngine,
+            &Nedrysoft::RouteAnalyser::IRouteEngine::result,
+            this,
+            [=](const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const bool completed,
+                const int,
+                const int ) {
+
+            if (completed) {
+                setRoute(vantage, hostAddress, route);
+            }
+        });
+
+        connect(
+            routeEngine,
+            &Nedrysoft::RouteAnalyser::IRouteEngine::routeChanged,
+            this,
+            [=](const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const QList<int> ) {
+
+            setRoute(vantage, hostAddress, route);
+        });
+
+        routeEngine->setRouteMonitoring(RouteMonitorInterval);
+        routeEngine->findRoute(m_vantages[vantage].factory, host, ipVersion);
+    }
+
+    /**
+     * the merger is updated with every result, the table only reads it once per interval.
+     */
+
+    m_refreshTimer->setInterval(qMax(interval, MinimumRefreshInterval));
+
+    connect(m_refreshTimer, &QTimer::timeout, this, [=]() {
+        m_model->refresh();
+    });
+
+    m_refreshTimer->start();
+}
+
+Nedrysoft::RouteAnalyser::MergedRouteWidget::~MergedRouteWidget() {
+    m_refreshTimer->stop();
+
+    for (auto vantage=0;vantage<m_vantages.count();vantage++) {
+        unsubscribe(vantage);
+
+        if (m_vantages[vantage].routeEngine) {
+            disconnect(m_vantages[vantage].routeEngine, nullptr, this, nullptr);
+
+            m_vantages[vantage].routeEngine->deleteLater();
+        }
+    }
+
+    delete m_model;
+    delete m_merger;
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteWidget::setRoute(
+        int vantage,
+        const QHostAddress &targetAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> void {
+
+    unsubscribe(vantage);
+
+    m_merger->setRoute(vantage, route);
+
+    auto hopCache = Nedrysoft::RouteAnalyser::HopCache::getInstance();
+
+    for (auto hop=1;hop<=route.count();hop++) {
+        auto subscription = hopCache->subscribe(
+            m_vantages[vantage].factory,
+            m_ipVersion,
+            m_interval,
+            DefaultPayloadSize,
+            false,
+            QString(),
+            false,
+            1,
+            targetAddress,
+            route.at(hop-1),
+            hop,
+            [this, vantage, hop](const Nedrysoft::RouteAnalyser::PingResult &result) {
+                m_merger->add(vantage, hop, result);
+            }
+        );
+
+        if (subscription) {
+            m_vantages[vantage].subscriptions.append(subscription);
+        }
+    }
+
+    m_model->refresh();
+}
+
+auto Nedrysoft::RouteAnalyser::MergedRouteWidget::unsubscribe(int vantage) -> void {
+    auto hopCache = Nedrysoft::RouteAnalyser::HopCache::getInstance();
+
+    for (auto subscription : m_vantages[vantage].subscriptions) {
+        hopCache->unsubscribe(subscription);
+    }
+
+    m_vantages[vantage].subscriptions.clear();
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEWIDGET_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEWIDGET_H
+
+#include "IRouteEngine.h"
+
+#include <ICore>
+#include <QHostAddress>
+#include <QList>
+#include <QVector>
+#include <QWidget>
+
+class QTableView;
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngineFactory;
+    class MergedRouteModel;
+    class VantageMerger;
+
+    /**
+     * @brief       The MergedRouteWidget class shows the routes to one target from several vantage points as a
+     *              single table.
+     *
+     * @details     The target is traced from every ping engine factory that has a vantage point (such as each agent
+     *              of a fleet of ping agents) and the hops of each route are monitored through the hop cache.  The
+     *              results of every vantage point are added to a VantageMerger as they arrive, which aligns the
+     *              routes where they converge and merges the statistics of the shared hops, and the table is
+     *              refreshed from the merger once per interval.
+     */
+    class MergedRouteWidget :
+            public QWidget {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new MergedRouteWidget.
+             *
+             * @param[in]   host the host name or address of the target.
+             * @param[in]   ipVersion the IP version to monitor.
+             * @param[in]   interval the interval between requests to each hop in milliseconds.
+             * @param[in]   parent the owner widget.
+             */
+            MergedRouteWidget(
+                    const QString &host,
+                    Nedrysoft::Core::IPVersion ipVersion,
+                    int interval,
+                    QWidget *parent = nullptr );
+
+            /**
+             * @brief       Destroys the MergedRouteWidget and stops monitoring.
+             */
+            ~MergedRouteWidget() override;
+
+        private:
+            /**
+             * @brief       Sets the route of a vantage point and monitors its hops.
+             *
+             * @param[in]   vantage the index of the vantage point.
+             * @param[in]   targetAddress the address that was traced.
+             * @param[in]   route the route.
+             */
+            auto setRoute(
+                    int vantage,
+                    const QHostAddress &targetAddress,
+                    const Nedrysoft::RouteAnalyser::RouteList &route ) -> void;
+
+            /**
+             * @brief       Stops monitoring the hops of a vantage point.
+             *
+             * @param[in]   vantage the index of the vantage point.
+             */
+            auto unsubscribe(int vantage) -> void;
+
+        private:
+            /**
+             * @brief       A vantage point and the route traced from it.
+             */
+            struct Vantage {
+                Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;     //!< the ping engine factory.
+                Nedrysoft::RouteAnalyser::IRouteEngine *routeEngine = nullptr;      //!< traces the route.
+                QList<quint64> subscriptions;                                       //!< the monitored hops.
+            };
+
+            //! @cond
+
+            QVector<Vantage> m_vantages;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            int m_interval;
+            Nedrysoft::RouteAnalyser::VantageMerger *m_merger;
+            Nedrysoft::RouteAnalyser::MergedRouteModel *m_model;
+            QTableView *m_tableView;
+            QTimer *m_refreshTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_MERGEDROUTEWIDGET_H
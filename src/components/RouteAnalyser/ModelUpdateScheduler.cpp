@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ModelUpdateScheduler.h"
+
+#include "PowerProfile.h"
+
+#include <QAbstractItemModel>
+#include <QTimer>
+#include <algorithm>
+
+constexpr auto UpdateInterval = 1000/30;
+
+Nedrysoft::RouteAnalyser::ModelUpdateScheduler::ModelUpdateScheduler() :
+        m_timer(new QTimer(this)) {
+
+    m_timer->setSingleShot(true);
+
+    Nedrysoft::RouteAnalyser::PowerProfile::getInstance()->manage(m_timer, UpdateInterval);
+
+    connect(m_timer, &QTimer::timeout, this, [=]() {
+        flush();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance() -> Nedrysoft::RouteAnalyser::ModelUpdateScheduler * {
+    static Nedrysoft::RouteAnalyser::ModelUpdateScheduler instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::ModelUpdateScheduler::invalidate(QAbstractItemModel *model, int row) -> void {
+    if (!model) {
+        return;
+    }
+
+    if ((row<0) || (row>=model->rowCount())) {
+        row = -1;
+    }
+
+    auto lastRow = (row<0) ? model->rowCount()-1 : row;
+
+    if (row<0) {
+        row = 0;
+    }
+
+    watch(model);
+
+    auto dirtyRows = m_dirtyRows.find(model);
+
+    if (dirtyRows==m_dirtyRows.end()) {
+        m_dirtyRows[model] = qMakePair(row, lastRow);
+    } else {
+        dirtyRows->first = std::min(dirtyRows->first, row);
+        dirtyRows->second = std::max(dirtyRows->second, lastRow);
+    }
+
+    /**
+     * the timer is not restarted by later changes, so a constant stream of results cannot postpone the update.
+     */
+
+    if ((!m_timer->isActive()) && (!m_suspendedModels.contains(model))) {
+        m_timer->start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::ModelUpdateScheduler::watch(QAbstractItemModel *model) -> void {
+    if (m_models.contains(model)) {
+        return;
+    }
+
+    m_models.insert(model);
+
+    connect(model, &QObject::destroyed, this, [=](QObject *) {
+        m_models.remove(model);
+        m_suspendedModels.remove(model);
+        m_dirtyRows.remove(model);
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::ModelUpdateScheduler::setSuspended(QAbstractItemModel *model, bool suspended) -> void {
+    if (!model) {
+        return;
+    }
+
+    watch(model);
+
+    if (suspended) {
+        m_suspendedModels.insert(model);
+
+        return;
+    }
+
+    m_suspendedModels.remove(model);
+
+    if ((m_dirtyRows.contains(model)) && (!m_timer->isActive())) {
+        m_timer->start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::ModelUpdateScheduler::flush() -> void {
+    auto dirtyRows = QHash<QAbstractItemModel *, QPair<int, int> >();
+
+    dirtyRows.swap(m_dirtyRows);
+
+    for (auto entry=dirtyRows.begin();entry!=dirtyRows.end();entry++) {
+        auto model = entry.key();
+
+        // the rows of a suspended model are held until it is resumed.
+
+        if (m_suspendedModels.contains(model)) {
+            m_dirtyRows.insert(model, entry.value());
+
+            continue;
+        }
+
+        auto lastRow = std::min(entry->second, model->rowCount()-1);
+
+        if ((entry->first>lastRow) || (!model->columnCount())) {
+            continue;
+        }
+
+        Q_EMIT model->dataChanged(
+            model->index(entry->first, 0),
+            model->index(lastRow, model->columnCount()-1)
+        );
+    }
+}
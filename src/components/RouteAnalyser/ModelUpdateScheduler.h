@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_MODELUPDATESCHEDULER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_MODELUPDATESCHEDULER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+
+class QAbstractItemModel;
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The ModelUpdateScheduler class coalesces change notifications for the route tables.
+     *
+     * @details     Rows are marked as changed as results arrive, the scheduler emits a single dataChanged
+     *              covering the changed rows of each model at most 30 times a second, so the table (and the
+     *              graphs drawn by its delegate) is repainted at a fixed rate however fast the hops are probed.
+     */
+    class ModelUpdateScheduler :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs a new ModelUpdateScheduler.
+             */
+            ModelUpdateScheduler();
+
+        public:
+            /**
+             * @brief       Returns the ModelUpdateScheduler instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> ModelUpdateScheduler *;
+
+            /**
+             * @brief       Marks a row of a model as changed.
+             *
+             * @param[in]   model the model.
+             * @param[in]   row the row that has changed; otherwise -1 if every row may have changed.
+             */
+            auto invalidate(QAbstractItemModel *model, int row) -> void;
+
+            /**
+             * @brief       Suspends or resumes the change notifications of a model.
+             *
+             * @details     The rows of a suspended model are still recorded as they change, the notification for
+             *              all of them is emitted once the model is resumed.
+             *
+             * @param[in]   model the model.
+             * @param[in]   suspended true to hold the notifications; otherwise false to emit them.
+             */
+            auto setSuspended(QAbstractItemModel *model, bool suspended) -> void;
+
+        private:
+            /**
+             * @brief       Starts tracking a model so that it is forgotten when it is destroyed.
+             *
+             * @param[in]   model the model.
+             */
+            auto watch(QAbstractItemModel *model) -> void;
+            /**
+             * @brief       Emits the pending change notifications.
+             */
+            auto flush() -> void;
+
+        private:
+            //! @cond
+
+            QTimer *m_timer;
+            QHash<QAbstractItemModel *, QPair<int, int> > m_dirtyRows;
+            QSet<QAbstractItemModel *> m_models;
+            QSet<QAbstractItemModel *> m_suspendedModels;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_MODELUPDATESCHEDULER_H
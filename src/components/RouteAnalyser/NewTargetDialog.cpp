@@ -23,6 +23,7 @@
 #include "NewTargetDialog.h"
 
 #include "LineSyntaxHighlighter.h"
+#include "TargetCompleter.h"
 #include "TargetSettings.h"
 #include "Utils.h"
 
@@ -30,6 +31,7 @@
 
 #include <QLineEdit>
 #include <QPushButton>
+#include <QRegularExpression>
 #include <QStandardItemModel>
 #include <ThemeDialog>
 #include <cassert>
@@ -41,7 +43,8 @@ Nedrysoft::RouteAnalyser::NewTargetDialog::NewTargetDialog(QWidget *parent) :
         Nedrysoft::ThemeSupport::ThemeDialog(parent),
         ui(new Ui::NewTargetDialog),
         m_targetHighlighter(nullptr),
-        m_intervalHighlighter(nullptr) {
+        m_intervalHighlighter(nullptr),
+        m_targetCompleter(nullptr) {
 
     static int minimumLineHeight = 0;
 
@@ -116,6 +119,8 @@ Nedrysoft::RouteAnalyser::NewTargetDialog::NewTargetDialog(QWidget *parent) :
         return returnValue;
     });
 
+    m_targetCompleter = new TargetCompleter(ui->targetLineEdit);
+
     ui->targetLineEdit->setLineWrapMode(QTextEdit::NoWrap);
     ui->targetLineEdit->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     ui->targetLineEdit->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -165,6 +170,13 @@ Nedrysoft::RouteAnalyser::NewTargetDialog::NewTargetDialog(QWidget *parent) :
         updateButtonBoxState();
     });
 
+    // a dual stack target must be a host name, an address literal only has a route over its own IP version.
+
+    connect(ui->dualStackRadioButton, &QRadioButton::toggled, [=](bool checked) {
+        m_targetHighlighter->rehighlight();
+        updateButtonBoxState();
+    });
+
     ui->targetLineEdit->setTabChangesFocus(true);
     ui->intervalLineEdit->setTabChangesFocus(true);
 
@@ -214,13 +226,17 @@ auto Nedrysoft::RouteAnalyser::NewTargetDialog::pingTarget() -> QString {
 }
 
 auto Nedrysoft::RouteAnalyser::NewTargetDialog::ipVersion() -> Nedrysoft::Core::IPVersion {
-    if (ui->ipv4RadioButton->isChecked()) {
-        return Nedrysoft::Core::IPVersion::V4;
-    } else {
+    if (ui->ipV6RadioButton->isChecked()) {
         return Nedrysoft::Core::IPVersion::V6;
+    } else {
+        return Nedrysoft::Core::IPVersion::V4;
     }
 }
 
+auto Nedrysoft::RouteAnalyser::NewTargetDialog::dualStack() -> bool {
+    return ui->dualStackRadioButton->isChecked();
+}
+
 auto Nedrysoft::RouteAnalyser::NewTargetDialog::interval() -> double {
     double intervalTime = 1;
     auto intervalString = ui->intervalLineEdit->toPlainText().isEmpty() ?
@@ -234,6 +250,26 @@ auto Nedrysoft::RouteAnalyser::NewTargetDialog::interval() -> double {
     return intervalTime;
 }
 
+auto Nedrysoft::RouteAnalyser::NewTargetDialog::payloadSize() -> int {
+    return ui->payloadSizeSpinBox->value();
+}
+
+auto Nedrysoft::RouteAnalyser::NewTargetDialog::dontFragment() -> bool {
+    return ui->dontFragmentCheckBox->isChecked();
+}
+
+auto Nedrysoft::RouteAnalyser::NewTargetDialog::sources() -> QStringList {
+    QStringList sources;
+
+    for (auto &source : ui->sourcesLineEdit->text().split(QRegularExpression("[,\\s]+"))) {
+        if ((!source.isEmpty()) && (!sources.contains(source))) {
+            sources.append(source);
+        }
+    }
+
+    return sources;
+}
+
 auto Nedrysoft::RouteAnalyser::NewTargetDialog::checkFieldsValid(QString &string) -> QWidget * {
     double intervalValue;
     QWidget *returnWidget = nullptr;
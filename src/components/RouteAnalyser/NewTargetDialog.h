@@ -27,6 +27,7 @@
 #include "IPingEngineFactory.h"
 
 #include <QDialog>
+#include <QStringList>
 #include <ThemeDialog>
 
 class QTextEdit;
@@ -37,6 +38,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
     }
 
     class LineSyntaxHighlighter;
+    class TargetCompleter;
 
     /**
      * @brief       The NewTargetDialog class is a dialog that is used to create a new target.
@@ -80,10 +82,17 @@ namespace Nedrysoft { namespace RouteAnalyser {
             /**
              * @brief       Returns the selected IP version.
              *
-             * @returns     the ip version, (V4 or V6)
+             * @returns     the ip version, (V4 or V6) V4 if both were selected.
              */
             auto ipVersion() -> Nedrysoft::Core::IPVersion;
 
+            /**
+             * @brief       Returns whether the target is to be traced over both IPv4 and IPv6.
+             *
+             * @returns     true if both IP versions were selected; otherwise false.
+             */
+            auto dualStack() -> bool;
+
             /**
              * @brief       Returns the ping interval.
              *
@@ -94,6 +103,27 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto interval() -> double;
 
+            /**
+             * @brief       Returns the payload size.
+             *
+             * @returns     the number of bytes of payload in each echo request.
+             */
+            auto payloadSize() -> int;
+
+            /**
+             * @brief       Returns whether the don't fragment flag should be set.
+             *
+             * @returns     true if requests should not be fragmented; otherwise false.
+             */
+            auto dontFragment() -> bool;
+
+            /**
+             * @brief       Returns the interfaces or source addresses that the target should be traced from.
+             *
+             * @returns     the list of sources; otherwise an empty list for the default route.
+             */
+            auto sources() -> QStringList;
+
             /**
              * @brief       Updates the button box according to the target text + radio buttons.
              */
@@ -131,6 +161,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
             Ui::NewTargetDialog *ui;
             LineSyntaxHighlighter *m_targetHighlighter;
             LineSyntaxHighlighter *m_intervalHighlighter;
+            TargetCompleter *m_targetCompleter;
 
             //! @endcond
     };
@@ -28,6 +28,7 @@
 #include "IPingEngineFactory.h"
 #include "OpenFavouriteDialog.h"
 #include "RouteAnalyserEditor.h"
+#include "TargetCompleter.h"
 #include "TargetManager.h"
 #include "TargetSettings.h" // TODO: what to do about this?  Separate library I guess...
 #include "Utils.h"
@@ -279,6 +280,8 @@ Nedrysoft::RouteAnalyser::NewTargetRibbonGroup::NewTargetRibbonGroup(QWidget *pa
         ui->targetLineEdit->blockSignals(false);
     });
 
+    m_targetCompleter = new TargetCompleter(ui->targetLineEdit);
+
     validateFields();
 
     ui->targetLineEdit->setMaximumHeight(LineEditHeight);
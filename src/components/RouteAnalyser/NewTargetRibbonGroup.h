@@ -44,6 +44,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
     }
 
     class IPingEngineFactory;
+    class TargetCompleter;
 
     /**
      * @brief       The NewTargetRibbonGroup is a Ribbon group that allows a new target to be created.
@@ -181,6 +182,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
 
             LineSyntaxHighlighter *m_targetHighlighter;
             LineSyntaxHighlighter *m_intervalHighlighter;
+            TargetCompleter *m_targetCompleter;
 
             QMenu *m_recentsMenu;
             QMap<QString, QMenu *> m_favouritesMenuMap;
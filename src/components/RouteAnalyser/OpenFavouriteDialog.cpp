@@ -38,10 +38,16 @@ Nedrysoft::RouteAnalyser::OpenFavouriteDialog::OpenFavouriteDialog(QWidget *pare
 
     connect(ui->closePushButton, &QPushButton::clicked, this, &Nedrysoft::RouteAnalyser::OpenFavouriteDialog::onCloseClicked);
 
-    auto favourites = Nedrysoft::RouteAnalyser::TargetManager::getInstance()->favourites();
+    const auto &favouritesStore = Nedrysoft::RouteAnalyser::TargetManager::getInstance()->favouritesStore();
 
-    for (auto favourite : favourites) {
-        m_itemModel.appendRow(createFavourite(favourite));
+    for (auto storeIndex=0; storeIndex<favouritesStore.count(); storeIndex++) {
+        auto row = createFavourite(favouritesStore.at(storeIndex).toMap());
+
+        if (!row.isEmpty()) {
+            row.first()->setData(storeIndex, FavouritesSortProxyFilterModel::StoreIndexRole);
+
+            m_itemModel.appendRow(row);
+        }
     }
 
     m_filterModel.setSourceModel(&m_itemModel);
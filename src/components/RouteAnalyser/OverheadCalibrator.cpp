@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OverheadCalibrator.h"
+
+#include "IPingEngine.h"
+#include "IPingEngineFactory.h"
+
+#include <QHostAddress>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+
+constexpr auto CalibrationInterval = 60000;
+constexpr auto ProbeInterval = 20;
+constexpr auto CalibrationProbes = 32;
+constexpr auto MinimumSamples = 8;
+constexpr auto ProbeTimeout = 1.0;
+constexpr auto ProbeTtl = 64;
+constexpr auto DistortionFactor = 2;
+constexpr auto DistortionMinimum = 250000ll;
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::Estimate::distorted() const -> bool {
+    if (!valid) {
+        return false;
+    }
+
+    return (median > baseline * DistortionFactor) && ((median - baseline) > DistortionMinimum);
+}
+
+Nedrysoft::RouteAnalyser::OverheadCalibrator::OverheadCalibrator() :
+        m_calibrationTimer(new QTimer(this)),
+        m_probeTimer(new QTimer(this)) {
+
+    m_calibrationTimer->setInterval(CalibrationInterval);
+
+    connect(m_calibrationTimer, &QTimer::timeout, this, [this]() {
+        calibrate();
+    });
+
+    /**
+     * the probes of a calibration are spaced out rather than sent together so that they measure the cost of an
+     * individual request rather than the cost of a burst.
+     */
+
+    m_probeTimer->setInterval(ProbeInterval);
+
+    connect(m_probeTimer, &QTimer::timeout, this, [this]() {
+        probe();
+    });
+}
+
+Nedrysoft::RouteAnalyser::OverheadCalibrator::~OverheadCalibrator() {
+
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance() -> Nedrysoft::RouteAnalyser::OverheadCalibrator * {
+    static Nedrysoft::RouteAnalyser::OverheadCalibrator instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::addEngine(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version ) -> void {
+
+    auto key = QString("%1/%2").arg(reinterpret_cast<quintptr>(factory)).arg(static_cast<int>(version));
+
+    if (m_calibrations.contains(key)) {
+        m_calibrations[key]->references++;
+
+        return;
+    }
+
+    auto engine = factory->createEngine(version);
+
+    if (!engine) {
+        return;
+    }
+
+    auto calibration = std::make_shared<Calibration>();
+
+    calibration->factory = factory;
+    calibration->version = version;
+    calibration->engine = engine;
+    calibration->references = 1;
+    calibration->running = true;
+
+    m_calibrations[key] = calibration;
+
+    m_probeTimer->start();
+
+    if (!m_calibrationTimer->isActive()) {
+        m_calibrationTimer->start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::removeEngine(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version ) -> void {
+
+    auto key = QString("%1/%2").arg(reinterpret_cast<quintptr>(factory)).arg(static_cast<int>(version));
+
+    if (!m_calibrations.contains(key)) {
+        return;
+    }
+
+    auto calibration = m_calibrations[key];
+
+    if (--calibration->references) {
+        return;
+    }
+
+    m_calibrations.remove(key);
+
+    /**
+     * the outstanding probes are discarded before the engine is deleted, for an engine that relies on the default
+     * singleShotAsync() this waits for them to complete or time out.
+     */
+
+    calibration->pending.clear();
+
+    factory->deleteEngine(calibration->engine);
+
+    if (m_calibrations.isEmpty()) {
+        m_calibrationTimer->stop();
+        m_probeTimer->stop();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::estimate(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::OverheadCalibrator::Estimate {
+
+    auto key = QString("%1/%2").arg(reinterpret_cast<quintptr>(factory)).arg(static_cast<int>(version));
+
+    if (!m_calibrations.contains(key)) {
+        return Estimate();
+    }
+
+    return m_calibrations[key]->estimate;
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::compensate(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    if ((result.code() == Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) ||
+        (result.preciseRoundTripTime() < 0)) {
+
+        return result;
+    }
+
+    auto overhead = estimate(factory, version);
+
+    if (!overhead.valid) {
+        return result;
+    }
+
+    return Nedrysoft::RouteAnalyser::PingResult(
+        result.sampleNumber(),
+        result.code(),
+        result.hostAddress(),
+        result.requestTimestamp(),
+        std::max(result.preciseRoundTripTime() - overhead.median, 0ll),
+        result.target(),
+        result.hops()
+    );
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::calibrate() -> void {
+    for (auto &calibration : m_calibrations) {
+        if (calibration->running) {
+            continue;
+        }
+
+        calibration->running = true;
+        calibration->sent = 0;
+        calibration->roundTripTimes.clear();
+    }
+
+    if (!m_calibrations.isEmpty()) {
+        m_probeTimer->start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::OverheadCalibrator::probe() -> void {
+    auto running = false;
+    auto changed = false;
+
+    for (auto &calibration : m_calibrations) {
+        if (!calibration->running) {
+            continue;
+        }
+
+        if (calibration->sent < CalibrationProbes) {
+            auto loopbackAddress = QHostAddress(
+                (calibration->version == Nedrysoft::Core::IPVersion::V4) ? QHostAddress::LocalHost :
+                                                                             QHostAddress::LocalHostIPv6 );
+
+            calibration->pending.push_back(calibration->engine->singleShotAsync(
+                loopbackAddress,
+                ProbeTtl,
+                ProbeTimeout ));
+
+            calibration->sent++;
+        }
+
+        auto &pending = calibration->pending;
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                it++;
+
+                continue;
+            }
+
+            auto result = it->get();
+
+            if (result.code() == Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
+                calibration->roundTripTimes.append(result.preciseRoundTripTime());
+            }
+
+            it = pending.erase(it);
+        }
+
+        if ((calibration->sent < CalibrationProbes) || (!pending.empty())) {
+            running = true;
+
+            continue;
+        }
+
+        calibration->running = false;
+
+        auto &roundTripTimes = calibration->roundTripTimes;
+
+        if (roundTripTimes.count() < MinimumSamples) {
+            continue;
+        }
+
+        std::sort(roundTripTimes.begin(), roundTripTimes.end());
+
+        auto &estimate = calibration->estimate;
+
+        estimate.median = roundTripTimes.at(roundTripTimes.count() / 2);
+        estimate.percentile90 = roundTripTimes.at((roundTripTimes.count() * 9) / 10);
+        estimate.samples = roundTripTimes.count();
+        estimate.baseline = estimate.valid ? std::min(estimate.baseline, estimate.median) : estimate.median;
+        estimate.valid = true;
+
+        changed = true;
+    }
+
+    if (!running) {
+        m_probeTimer->stop();
+    }
+
+    if (changed) {
+        Q_EMIT estimateChanged();
+    }
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_OVERHEADCALIBRATOR_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_OVERHEADCALIBRATOR_H
+
+#include "PingResult.h"
+
+#include <ICore>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <future>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngine;
+    class IPingEngineFactory;
+
+    /**
+     * @brief       The OverheadCalibrator class measures the time that the measuring host adds to a round trip.
+     *
+     * @details     A round trip time includes the time taken by this host to build and send the request and to
+     *              wake up and read the reply, a request to the loopback address takes no time on the network so
+     *              its round trip time is this overhead alone.  Each engine configuration in use is calibrated
+     *              when it is added and then periodically, the median of the first calibrations is kept as the
+     *              baseline so that a rise in the overhead caused by load on the host can be reported.
+     */
+    class OverheadCalibrator :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The measured overhead of an engine configuration.
+             */
+            struct Estimate {
+                bool valid = false;             //!< true once a calibration has completed.
+                qint64 median = 0;              //!< the median loopback round trip time in nanoseconds.
+                qint64 percentile90 = 0;        //!< the 90th percentile loopback round trip time in nanoseconds.
+                qint64 baseline = 0;            //!< the lowest median measured, in nanoseconds.
+                int samples = 0;                //!< the number of replies in the most recent calibration.
+
+                /**
+                 * @brief       Returns whether load on the host is distorting measurements.
+                 *
+                 * @details     The overhead is considered distorted when the current median is more than double
+                 *              the baseline and the increase is larger than a fraction of a millisecond.
+                 *
+                 * @returns     true if the overhead has risen significantly; otherwise false.
+                 */
+                auto distorted() const -> bool;
+            };
+
+        private:
+            /**
+             * @brief       Constructs the OverheadCalibrator.
+             */
+            OverheadCalibrator();
+
+        public:
+            /**
+             * @brief       Destroys the OverheadCalibrator.
+             *
+             * @note        The calibration engines are owned by their factories and are deleted with them.
+             */
+            ~OverheadCalibrator();
+
+            /**
+             * @brief       Returns the OverheadCalibrator instance.
+             *
+             * @returns     the calibrator.
+             */
+            static auto getInstance() -> OverheadCalibrator *;
+
+            /**
+             * @brief       Starts calibrating an engine configuration.
+             *
+             * @details     Configurations are reference counted, a configuration that is already being calibrated
+             *              is not calibrated again until its next periodic calibration.
+             *
+             * @param[in]   factory the factory that creates the engines.
+             * @param[in]   version the IP version of the engines.
+             */
+            auto addEngine(Nedrysoft::RouteAnalyser::IPingEngineFactory *factory, Nedrysoft::Core::IPVersion version)
+                -> void;
+
+            /**
+             * @brief       Stops calibrating an engine configuration once it has no more users.
+             *
+             * @param[in]   factory the factory that creates the engines.
+             * @param[in]   version the IP version of the engines.
+             */
+            auto removeEngine(Nedrysoft::RouteAnalyser::IPingEngineFactory *factory, Nedrysoft::Core::IPVersion version)
+                -> void;
+
+            /**
+             * @brief       Returns the most recent estimate for an engine configuration.
+             *
+             * @param[in]   factory the factory that creates the engines.
+             * @param[in]   version the IP version of the engines.
+             *
+             * @returns     the estimate, which is not valid if the configuration has not been calibrated.
+             */
+            auto estimate(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+                    Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::OverheadCalibrator::Estimate;
+
+            /**
+             * @brief       Returns a result with the measured overhead of its engine removed.
+             *
+             * @param[in]   factory the factory that created the engine that produced the result.
+             * @param[in]   version the IP version of the engine.
+             * @param[in]   result the result.
+             *
+             * @returns     the compensated result; the original result if no estimate is available.
+             */
+            auto compensate(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+                    Nedrysoft::Core::IPVersion version,
+                    const Nedrysoft::RouteAnalyser::PingResult &result ) -> Nedrysoft::RouteAnalyser::PingResult;
+
+            /**
+             * @brief       Calibrates every engine configuration now.
+             */
+            auto calibrate() -> void;
+
+            /**
+             * @brief       This signal is emitted when a calibration has completed.
+             */
+            Q_SIGNAL void estimateChanged();
+
+        private:
+            /**
+             * @brief       Sends the next probes and collects the replies of the calibrations in progress.
+             */
+            auto probe() -> void;
+
+        private:
+            //! @cond
+
+            struct Calibration {
+                Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;
+                Nedrysoft::Core::IPVersion version = Nedrysoft::Core::IPVersion::V4;
+                Nedrysoft::RouteAnalyser::IPingEngine *engine = nullptr;
+                int references = 0;
+                bool running = false;
+                int sent = 0;
+                std::vector<std::future<Nedrysoft::RouteAnalyser::PingResult> > pending;
+                QVector<qint64> roundTripTimes;
+                Estimate estimate;
+            };
+
+            QHash<QString, std::shared_ptr<Calibration> > m_calibrations;
+
+            QTimer *m_calibrationTimer;
+            QTimer *m_probeTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_OVERHEADCALIBRATOR_H
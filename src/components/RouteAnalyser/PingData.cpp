@@ -23,56 +23,102 @@
 
 #include "PingData.h"
 
+#include "HopBaseline.h"
+#include "HopIdentityTable.h"
+#include "HopRoundSeries.h"
+#include "HopTimeSeries.h"
+#include "IPingTarget.h"
 #include "IPlot.h"
 #include "IPlotFactory.h"
+#include "ModelUpdateScheduler.h"
 #include "RouteTableItemDelegate.h"
+#include "RouteTableModel.h"
+#include "SlidingWindowExtrema.h"
 
 #include <IComponentManager>
 #include <IHostMasker>
 #include <IHostMaskerManager>
 #include <QHeaderView>
-#include <QStandardItemModel>
 #include <QTableWidget>
 
-Nedrysoft::RouteAnalyser::PingData::PingData(QStandardItemModel *tableModel, int hop, bool hopValid) :
-        m_tableModel(tableModel),
-        m_customPlot(nullptr),
-        m_jitterPlot(nullptr),
-        m_replyPacketCount(0),
-        m_timeoutPacketCount(0),
-        m_hop(hop),
-        m_hopValid(hopValid),
-        m_count(0),
-        m_currentLatency(-1),
-        m_maximumLatency(-1),
-        m_minimumLatency(-1),
-        m_averageLatency(-1),
-        m_historicalLatency(-1) {
-}
+constexpr auto MinimumRegression = 0.005;
+constexpr auto RegressionRatio = 1.5;
+constexpr auto NanosecondsInSecond = 1000000000.0;
 
-auto Nedrysoft::RouteAnalyser::PingData::runningAverage(double previousAverage, double value, double n) -> double {
-    return (previousAverage*(n-1)+value)/n;
-}
+/**
+ * @brief       Returns the column of the table model that holds a field.
+ *
+ * @param[in]   field the field.
+ * @param[out]  column the column.
+ *
+ * @returns     true if the field is held in a column; otherwise false.
+ */
+static auto columnOf(
+        Nedrysoft::RouteAnalyser::PingData::Fields field,
+        Nedrysoft::RouteAnalyser::HopColumns::Column &column ) -> bool {
 
-auto Nedrysoft::RouteAnalyser::PingData::updateModel() -> void {
-    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+    switch (field) {
+        case Nedrysoft::RouteAnalyser::PingData::Fields::AverageLatency: {
+            column = Nedrysoft::RouteAnalyser::HopColumns::Column::AverageLatency;
 
-    if (hostMaskerManager) {
-        for (auto masker : hostMaskerManager->maskers()) {
-            QString maskedHostName;
-            QString maskedHostAddress;
+            return true;
+        }
 
-            if (masker->mask(m_hop, m_hostName, m_hostAddress, m_maskedHostName, m_maskedHostAddress)) {
-                break;
-            }
+        case Nedrysoft::RouteAnalyser::PingData::Fields::MinimumLatency: {
+            column = Nedrysoft::RouteAnalyser::HopColumns::Column::MinimumLatency;
+
+            return true;
+        }
+
+        case Nedrysoft::RouteAnalyser::PingData::Fields::MaximumLatency: {
+            column = Nedrysoft::RouteAnalyser::HopColumns::Column::MaximumLatency;
+
+            return true;
+        }
+
+        case Nedrysoft::RouteAnalyser::PingData::Fields::CurrentLatency: {
+            column = Nedrysoft::RouteAnalyser::HopColumns::Column::CurrentLatency;
+
+            return true;
+        }
+
+        default: {
+            break;
         }
     }
 
-    if (m_tableModel) {
-        auto topLeft = m_tableModel->index(0, 0);
-        auto bottomRight = topLeft.sibling(m_tableModel->rowCount() - 1, m_tableModel->columnCount() - 1);
+    return false;
+}
 
-        m_tableModel->dataChanged(topLeft, bottomRight);
+Nedrysoft::RouteAnalyser::PingData::PingData(
+        Nedrysoft::RouteAnalyser::RouteTableModel *tableModel,
+        int hop,
+        bool hopValid ) :
+
+            m_tableModel(tableModel),
+            m_customPlot(nullptr),
+            m_jitterPlot(nullptr),
+            m_timeSeries(std::make_shared<Nedrysoft::RouteAnalyser::HopTimeSeries>()),
+            m_roundSeries(std::make_shared<Nedrysoft::RouteAnalyser::HopRoundSeries>()),
+            m_latencyWindow(std::make_shared<Nedrysoft::RouteAnalyser::SlidingWindowExtrema>()),
+            m_hop(hop),
+            m_hopValid(hopValid),
+            m_rateLimited(false),
+            m_count(0),
+            m_identity(Nedrysoft::RouteAnalyser::HopIdentityTable::NoReply),
+            m_historicalLatency(-1),
+            m_baselineLatency(-1),
+            m_addedLatency(-1),
+            m_addedLoss(-1),
+            m_localLoss(false),
+            m_baseline(nullptr),
+            m_windowSummary({0, 0, 0, 0, 0, 0}),
+            m_windowed(false) {
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::updateModel() -> void {
+    if (m_tableModel) {
+        Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->invalidate(m_tableModel, m_hop-1);
     }
 }
 
@@ -82,9 +128,10 @@ auto Nedrysoft::RouteAnalyser::PingData::plotTitle() -> QString {
     QString titleString;
 
     if ((hostMaskerManager) && (hostMaskerManager->enabled(Nedrysoft::Core::HostMaskType::Screen))) {
-        titleString = QString(QObject::tr("Hop %1")).arg(m_hop) + " " + m_maskedHostName + " (" + m_maskedHostAddress + ")";
+        titleString = QString(QObject::tr("Hop %1")).arg(m_hop) + " " + maskedHostName() + " (" +
+                      maskedHostAddress() + ")";
     } else {
-        titleString = QString(QObject::tr("Hop %1")).arg(m_hop) + " " + m_hostName + " (" + m_hostAddress + ")";
+        titleString = QString(QObject::tr("Hop %1")).arg(m_hop) + " " + hostName() + " (" + hostAddress() + ")";
     }
 
     return titleString;
@@ -93,6 +140,8 @@ auto Nedrysoft::RouteAnalyser::PingData::plotTitle() -> QString {
 auto Nedrysoft::RouteAnalyser::PingData::setHop(int hop) -> void {
     m_hop = hop;
 
+    publishColumns();
+
     if (m_tableModel) {
         updateModel();
     }
@@ -102,107 +151,162 @@ auto Nedrysoft::RouteAnalyser::PingData::hop() -> int {
     return m_hop;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setHostAddress(const QString &hostAddress) -> void {
-    m_hostAddress = hostAddress;
+auto Nedrysoft::RouteAnalyser::PingData::setIdentity(quint32 identity) -> void {
+    m_identity = identity;
 
     if (m_tableModel) {
         updateModel();
     }
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::hostAddress() -> QString {
-    return m_hostAddress;
+auto Nedrysoft::RouteAnalyser::PingData::identity() -> quint32 {
+    return m_identity;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setHostName(const QString &hostName) -> void {
-    m_hostName = hostName;
+auto Nedrysoft::RouteAnalyser::PingData::address() -> QHostAddress {
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).address;
+}
 
-    if (m_tableModel) {
-        updateModel();
-    }
+auto Nedrysoft::RouteAnalyser::PingData::hostAddress() -> QString {
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).hostAddress;
 }
 
 auto Nedrysoft::RouteAnalyser::PingData::hostName() -> QString {
-    return m_hostName;
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).hostName;
 }
 
 auto Nedrysoft::RouteAnalyser::PingData::packetLoss() -> double {
-    if (m_replyPacketCount+m_timeoutPacketCount==0) {
-        return -1;
+    if (m_windowed) {
+        if (!(m_windowSummary.count+m_windowSummary.lost)) {
+            return -1;
+        }
+
+        return m_windowSummary.loss()*100.0;
     }
 
-    return (static_cast<double>(m_timeoutPacketCount)/
-            static_cast<double>(m_replyPacketCount+m_timeoutPacketCount))*100.0;
+    return m_statistics.packetLoss();
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::updateItem(Nedrysoft::RouteAnalyser::PingResult result) -> void {
-    m_count = result.sampleNumber();
-
-    if (result.code() == Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) {
-        m_timeoutPacketCount++;
-
-        if (m_tableModel) {
-            updateModel();
-        }
+auto Nedrysoft::RouteAnalyser::PingData::setWindowSummary(
+        const Nedrysoft::RouteAnalyser::HopTimeSeries::Rollup *summary ) -> void {
 
+    if ((!summary) && (!m_windowed)) {
         return;
     }
 
-    m_currentLatency = result.roundTripTime();
+    m_windowed = (summary!=nullptr);
 
-    if (m_minimumLatency < 0) {
-        m_minimumLatency = m_currentLatency;
+    if (summary) {
+        m_windowSummary = *summary;
     }
 
-    if (m_maximumLatency < 0) {
-        m_maximumLatency = m_currentLatency;
-    }
+    publishColumns();
 
-    if (m_currentLatency < m_minimumLatency) {
-        m_minimumLatency = m_currentLatency;
+    if (m_tableModel) {
+        Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->invalidate(m_tableModel, m_hop-1);
     }
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::lossStatistics() const -> const Nedrysoft::RouteAnalyser::LossStatistics & {
+    return m_statistics.lossStatistics();
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::latencyStatistics() const ->
+        const Nedrysoft::RouteAnalyser::RunningStatistics & {
 
-    if (m_currentLatency > m_maximumLatency) {
-        m_maximumLatency = m_currentLatency;
+    return m_statistics.latencyStatistics();
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::statistics() const -> const Nedrysoft::RouteAnalyser::HopStatistics & {
+    return m_statistics;
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::updateItem(Nedrysoft::RouteAnalyser::PingResult result) -> void {
+    m_statistics.add(result);
+
+    applyStatistics(QVector<Nedrysoft::RouteAnalyser::PingResult>() << result);
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::setStatistics(
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    m_statistics = statistics;
+
+    applyStatistics(results);
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::applyStatistics(
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    m_count = m_statistics.sampleNumber();
+
+    publishColumns();
+
+    // results read back from a capture have no target, so the hop keeps whatever state it last had.
+
+    if ((!results.isEmpty()) && (results.last().target())) {
+        m_rateLimited = (results.last().target()->probeBackoff() > 1);
     }
 
-    if (m_maximumLatency > m_tableModel->property("graphMaxLatency").toDouble()) {
-        if (m_tableModel) {
-            m_tableModel->setProperty("graphMaxLatency", QVariant(m_maximumLatency));
-        }
+    if ((m_tableModel) && (m_statistics.maximumLatency()>=0)) {
+        if (m_tableModel->updateLatencyRange(m_statistics.minimumLatency(), m_statistics.maximumLatency())) {
+            // the latency graphs of every row are drawn against the maximum, so all of them need repainting.
 
-        auto headerItem = m_tableModel->horizontalHeaderItem(static_cast<int>(Fields::Graph));
+            Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->invalidate(m_tableModel, -1);
 
-        if (headerItem) {
-            headerItem->setTextAlignment(Qt::AlignRight);
+            m_tableModel->setHeaderData(
+                static_cast<int>(Fields::Graph),
+                Qt::Horizontal,
+                static_cast<int>(Qt::AlignRight),
+                Qt::TextAlignmentRole
+            );
 
-            headerItem->setText(QString(QObject::tr("%1 ms")).arg((m_currentLatency*1000)));
+            m_tableModel->setHeaderData(
+                static_cast<int>(Fields::Graph),
+                Qt::Horizontal,
+                QString(QObject::tr("%1 ms")).arg((m_statistics.currentLatency()*1000))
+            );
         }
     }
 
-    if (m_minimumLatency < m_tableModel->property("graphMinLatency").toDouble()) {
-        if (m_tableModel) {
-            m_tableModel->setProperty("graphMinLatency", QVariant(m_minimumLatency));
+    /**
+     * the jitter is only known after the last result of the batch, so the plots receive it once per batch.
+     */
+
+    auto jitterTime = -1.0;
+    auto samples = QVector<Nedrysoft::RouteAnalyser::IPlot::Sample>();
+
+    if (!m_plots.isEmpty()) {
+        samples.reserve(results.count());
+
+        for (auto &result : results) {
+            if (Nedrysoft::RouteAnalyser::PingResult::isLost(result.code())) {
+                continue;
+            }
+
+            auto requestTime = static_cast<double>(result.requestTimestamp())/NanosecondsInSecond;
+
+            samples.append(Nedrysoft::RouteAnalyser::IPlot::Sample {requestTime, result.roundTripTime()});
+
+            jitterTime = requestTime;
         }
     }
 
-    if (m_averageLatency < 0) {
-        m_averageLatency = m_currentLatency;
-    } else {
-        m_averageLatency = runningAverage(
-                m_averageLatency,
-                m_currentLatency,
-                static_cast<double>(m_replyPacketCount) + 1.0
-        );
-    }
+    // the replies of the batch are handed to each plot at once, the plots redraw when the frame is ready.
 
-    m_replyPacketCount++;
+    if (!samples.isEmpty()) {
+        for (auto plot : m_plots) {
+            plot->updateSamples(samples.constData(), samples.count());
+        }
+    }
 
-    /*auto packetLoss = (static_cast<double>(m_timeoutPacketCount)/
-                static_cast<double>(m_replyPacketCount+m_timeoutPacketCount))*100.0;*/
+    auto jitter = m_statistics.jitterStatistics().jitter();
 
-    for (auto plot : m_plots) {
-        plot->update(result.requestTime().toMSecsSinceEpoch(), result.roundTripTime());
+    if ((jitterTime>=0) && (jitter>=0)) {
+        for (auto plot : m_plots) {
+            plot->updateJitter(jitterTime, jitter);
+        }
     }
 
     if (m_tableModel) {
@@ -218,16 +322,28 @@ auto Nedrysoft::RouteAnalyser::PingData::customPlot() -> QCustomPlot * {
     return m_customPlot;
 }
 
+auto Nedrysoft::RouteAnalyser::PingData::timeSeries() -> Nedrysoft::RouteAnalyser::HopTimeSeries * {
+    return m_timeSeries.get();
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::roundSeries() -> Nedrysoft::RouteAnalyser::HopRoundSeries * {
+    return m_roundSeries.get();
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::latencyWindow() -> Nedrysoft::RouteAnalyser::SlidingWindowExtrema * {
+    return m_latencyWindow.get();
+}
+
 auto Nedrysoft::RouteAnalyser::PingData::location() -> QString {
-    return m_location;
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).location;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setLocation(const QString &location) -> void {
-    m_location = location;
+auto Nedrysoft::RouteAnalyser::PingData::asNumber() -> quint32 {
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).asNumber;
+}
 
-    if (m_tableModel) {
-        updateModel();
-    }
+auto Nedrysoft::RouteAnalyser::PingData::asOwner() -> QString {
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->identity(m_identity).asOwner;
 }
 
 auto Nedrysoft::RouteAnalyser::PingData::hopValid() -> bool {
@@ -250,28 +366,134 @@ auto Nedrysoft::RouteAnalyser::PingData::setHistoricalLatency(double latency) ->
     }
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::latency(int field) -> double {
-    switch (static_cast<Fields>(field)) {
-        case Fields::MinimumLatency: {
-            return m_minimumLatency;
+auto Nedrysoft::RouteAnalyser::PingData::columnValue(Nedrysoft::RouteAnalyser::HopColumns::Column column) -> double {
+    switch (column) {
+        case Nedrysoft::RouteAnalyser::HopColumns::Column::MinimumLatency: {
+            if (m_windowed) {
+                return m_windowSummary.count ? m_windowSummary.minimum : -1;
+            }
+
+            return m_statistics.minimumLatency();
+        }
+
+        case Nedrysoft::RouteAnalyser::HopColumns::Column::MaximumLatency: {
+            if (m_windowed) {
+                return m_windowSummary.count ? m_windowSummary.maximum : -1;
+            }
+
+            return m_statistics.maximumLatency();
         }
 
-        case Fields::MaximumLatency: {
-            return m_maximumLatency;
+        case Nedrysoft::RouteAnalyser::HopColumns::Column::CurrentLatency: {
+            return m_statistics.currentLatency();
         }
 
-        case Fields::CurrentLatency: {
-            return m_currentLatency;
+        case Nedrysoft::RouteAnalyser::HopColumns::Column::AverageLatency: {
+            if (m_windowed) {
+                return m_windowSummary.mean();
+            }
+
+            return m_statistics.latencyStatistics().mean();
         }
+    }
+
+    return -1;
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::publishColumns() -> void {
+    if (!m_tableModel) {
+        return;
+    }
+
+    auto columns = m_tableModel->columns();
+
+    for (auto column=0;column<Nedrysoft::RouteAnalyser::HopColumns::ColumnCount;column++) {
+        auto hopColumn = static_cast<Nedrysoft::RouteAnalyser::HopColumns::Column>(column);
+
+        columns->setValue(hopColumn, m_hop-1, columnValue(hopColumn));
+    }
+}
 
-        case Fields::AverageLatency: {
-            return m_averageLatency;
+auto Nedrysoft::RouteAnalyser::PingData::latency(int field) -> double {
+    auto column = Nedrysoft::RouteAnalyser::HopColumns::Column::AverageLatency;
+
+    // the columns that the route scans for its maximums are read from the table model rather than the hop.
+
+    if (columnOf(static_cast<Fields>(field), column)) {
+        if (m_tableModel) {
+            return m_tableModel->columns()->value(column, m_hop-1);
         }
 
+        return columnValue(column);
+    }
+
+    switch (static_cast<Fields>(field)) {
         case Fields::HistoricalLatency: {
             return m_historicalLatency;
         }
 
+        case Fields::MedianLatency: {
+            return m_statistics.latencySketch().quantile(0.50);
+        }
+
+        case Fields::P95Latency: {
+            return m_statistics.latencySketch().quantile(0.95);
+        }
+
+        case Fields::P99Latency: {
+            return m_statistics.latencySketch().quantile(0.99);
+        }
+
+        case Fields::StandardDeviation: {
+            return m_statistics.latencyStatistics().standardDeviation();
+        }
+
+        case Fields::Jitter: {
+            return m_statistics.jitterStatistics().jitter();
+        }
+
+        case Fields::InterPacketDelayVariation: {
+            return m_statistics.jitterStatistics().ipdv();
+        }
+
+        case Fields::PacketDelayVariation: {
+            return m_statistics.jitterStatistics().pdv(0.95);
+        }
+
+        case Fields::BaselineLatency: {
+            return m_baselineLatency;
+        }
+
+        case Fields::ForwardDelay: {
+            return m_statistics.currentForwardDelay();
+        }
+
+        case Fields::ReverseDelay: {
+            return m_statistics.currentReverseDelay();
+        }
+
+        case Fields::ForwardJitter: {
+            return m_statistics.forwardJitterStatistics().jitter();
+        }
+
+        case Fields::ReverseJitter: {
+            return m_statistics.reverseJitterStatistics().jitter();
+        }
+
+        case Fields::AddedLatency: {
+            return m_addedLatency;
+        }
+
+        case Fields::BaselineDeviation: {
+            auto medianLatency = m_statistics.latencySketch().quantile(0.50);
+
+            if ((m_baselineLatency<0) || (medianLatency<0)) {
+                return -1;
+            }
+
+            return medianLatency-m_baselineLatency;
+        }
+
         default: {
             break;
         }
@@ -280,53 +502,101 @@ auto Nedrysoft::RouteAnalyser::PingData::latency(int field) -> double {
     return 0;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::tableModel() -> QStandardItemModel * {
-    return m_tableModel;
+auto Nedrysoft::RouteAnalyser::PingData::setBaseline(Nedrysoft::RouteAnalyser::HopBaseline *baseline) -> void {
+    m_baseline = baseline;
+    m_baselineLatency = -1;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::count() -> unsigned long  {
-    return m_count;
+auto Nedrysoft::RouteAnalyser::PingData::updateBaseline(
+        int hourOfWeek,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    if (!m_baseline) {
+        return;
+    }
+
+    for (const auto &result : results) {
+        if ((result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) ||
+            (result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded)) {
+
+            m_baseline->add(hourOfWeek, result.roundTripTime());
+        }
+    }
+
+    m_baselineLatency = m_baseline->expectedLatency(hourOfWeek);
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setPlots(QList<Nedrysoft::RouteAnalyser::IPlot *> plots) -> void {
-    m_plots = plots;
+auto Nedrysoft::RouteAnalyser::PingData::isRateLimited() -> bool {
+    return m_rateLimited;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setMaximum(
-        Nedrysoft::RouteAnalyser::PingData::Fields field,
-        bool isMaximum ) -> void {
+auto Nedrysoft::RouteAnalyser::PingData::setAttribution(double addedLatency, double addedLoss, bool localLoss) -> void {
+    if ((m_addedLatency==addedLatency) && (m_addedLoss==addedLoss) && (m_localLoss==localLoss)) {
+        return;
+    }
 
-    m_isMaximum[field] = isMaximum;
-}
+    m_addedLatency = addedLatency;
+    m_addedLoss = addedLoss;
+    m_localLoss = localLoss;
 
-auto Nedrysoft::RouteAnalyser::PingData::isMaximum(Nedrysoft::RouteAnalyser::PingData::Fields field) -> bool {
-    if (m_isMaximum.contains(field)) {
-        return m_isMaximum[field];
+    if (m_tableModel) {
+        Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->invalidate(m_tableModel, m_hop-1);
     }
+}
 
-    return false;
+auto Nedrysoft::RouteAnalyser::PingData::addedLoss() -> double {
+    return m_addedLoss;
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::hasLocalLoss() -> bool {
+    return m_localLoss;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setMaskedHostAddress(const QString &maskedHostAddress) -> void {
-    m_maskedHostAddress = maskedHostAddress;
+auto Nedrysoft::RouteAnalyser::PingData::isRegression() -> bool {
+    /**
+     * a hop is only flagged when it is both proportionally and absolutely slower than usual, so that the small
+     * variations of a hop a millisecond away are not reported.
+     */
 
-    if (m_tableModel) {
-        updateModel();
+    auto deviation = latency(static_cast<int>(Fields::BaselineDeviation));
+
+    if ((m_baselineLatency<0) || (deviation<MinimumRegression)) {
+        return false;
     }
+
+    return (m_baselineLatency+deviation)>(m_baselineLatency*RegressionRatio);
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::maskedHostAddress() -> QString {
-    return m_maskedHostAddress;
+auto Nedrysoft::RouteAnalyser::PingData::tableModel() -> Nedrysoft::RouteAnalyser::RouteTableModel * {
+    return m_tableModel;
 }
 
-auto Nedrysoft::RouteAnalyser::PingData::setMaskedHostName(const QString &maskedHostName) -> void {
-    m_maskedHostName = maskedHostName;
+auto Nedrysoft::RouteAnalyser::PingData::count() -> unsigned long  {
+    return m_count;
+}
 
-    if (m_tableModel) {
-        updateModel();
+auto Nedrysoft::RouteAnalyser::PingData::setPlots(QList<Nedrysoft::RouteAnalyser::IPlot *> plots) -> void {
+    m_plots = plots;
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::plots() -> QList<Nedrysoft::RouteAnalyser::IPlot *> {
+    return m_plots;
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::isMaximum(Nedrysoft::RouteAnalyser::PingData::Fields field) -> bool {
+    auto column = Nedrysoft::RouteAnalyser::HopColumns::Column::AverageLatency;
+
+    if ((!m_tableModel) || (!columnOf(field, column))) {
+        return false;
     }
+
+    return m_tableModel->columns()->isMaximum(column, m_hop-1);
+}
+
+auto Nedrysoft::RouteAnalyser::PingData::maskedHostAddress() -> QString {
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->maskedHostAddress(m_identity, m_hop);
 }
 
 auto Nedrysoft::RouteAnalyser::PingData::maskedHostName() -> QString {
-    return m_maskedHostName;
+    return Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->maskedHostName(m_identity, m_hop);
 }
@@ -24,29 +24,42 @@
 #ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_PINGDATA_H
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_PINGDATA_H
 
+#include "HopColumns.h"
+#include "HopStatistics.h"
+#include "HopTimeSeries.h"
 #include "PingResult.h"
+#include "RouteAnalyserSpec.h"
 
+#include <QHostAddress>
 #include <QPersistentModelIndex>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 #include <cmath>
+#include <memory>
 
 class QCustomPlot;
 
 class QTableView;
 
-class QStandardItemModel;
+namespace Nedrysoft { namespace RouteAnalyser {
+    class RouteTableModel;
+}}
 
 namespace Nedrysoft { namespace RouteAnalyser {
     class RouteItemTableDelegate;
     class IPlot;
+    class HopTimeSeries;
+    class HopRoundSeries;
+    class HopBaseline;
+    class SlidingWindowExtrema;
 
     /**
      * @brief       The PingData class is used to store data for a table model.
      *
      * @details     Holds data about each hop and updates the route table when the object is updated.
      */
-    class PingData {
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC PingData {
         public:
             /**
              * @brief       Column ID's. (columns appear in this order)
@@ -57,36 +70,49 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 IP,
                 HostName,
                 Location,
+                AutonomousSystem,
                 AverageLatency,
                 MinimumLatency,
                 MaximumLatency,
                 CurrentLatency,
                 PacketLoss,
+                RecentPacketLoss,
+                LossEpisodes,
+                MedianLatency,
+                P95Latency,
+                P99Latency,
+                StandardDeviation,
+                Jitter,
+                InterPacketDelayVariation,
+                PacketDelayVariation,
+                BaselineLatency,
+                BaselineDeviation,
+                ForwardDelay,
+                ReverseDelay,
+                ForwardJitter,
+                ReverseJitter,
+                AddedLatency,
+                AddedLoss,
                 Graph,
 
                 HistoricalLatency = 100
             };
 
         public:
-            /**
-             * @brief       Constructs a new PingData instance.
-             */
-            PingData() = default;
-
             /**
              * @brief       Destroys the PingData.
              */
             ~PingData() = default;
 
             /**
-             * @brief       Constructs a new PingData instance copying another PingData.
+             * @brief       A hop is owned by its table model and referred to by pointer, it is never copied.
              */
-            PingData(const PingData &) = default;
+            PingData(const PingData &) = delete;
 
             /**
-             * @brief       Copy operator.
+             * @brief       A hop is owned by its table model and referred to by pointer, it is never copied.
              */
-            PingData &operator=(const PingData &) = default;
+            PingData &operator=(const PingData &) = delete;
 
             /**
              * @brief       Constructs a new PingData and adds the item to a model.
@@ -98,7 +124,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @param[in]   hop the hop number of this item.
              * @param[in]   hopValid true if the hop responds to ping; otherwise false.
              */
-            PingData(QStandardItemModel *tableModel, int hop, bool hopValid);
+            PingData(Nedrysoft::RouteAnalyser::RouteTableModel *tableModel, int hop, bool hopValid);
 
             /**
              * @brief       Sets the historical latency for this point.
@@ -117,9 +143,33 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto updateItem(Nedrysoft::RouteAnalyser::PingResult result) -> void;
 
+            /**
+             * @brief       Updates the route table item from a snapshot of the hop statistics.
+             *
+             * @details     The statistics are maintained by the statistics worker, the results are those received
+             *              since the previous snapshot and are passed on to the additional plots.
+             *
+             * @param[in]   statistics the statistics of the hop.
+             * @param[in]   results the results received since the previous snapshot.
+             */
+            auto setStatistics(
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results
+            ) -> void;
+
+            /**
+             * @brief       Returns the statistics of the hop.
+             *
+             * @returns     the statistics.
+             */
+            auto statistics() const -> const Nedrysoft::RouteAnalyser::HopStatistics &;
+
             /**
              * @brief       Sets the hop number for this item.
              *
+             * @details     The hop number is also the row of the hop in the table model, the values of the hop are
+             *              stored again at the new row.
+             *
              * @param[in]   hop the hop number.
              */
             auto setHop(int hop) -> void;
@@ -132,39 +182,42 @@ namespace Nedrysoft { namespace RouteAnalyser {
             auto hop() -> int;
 
             /**
-             * @brief       Sets the displayed ip address for this route item.
+             * @brief       Sets the identity of the router at this hop.
+             *
+             * @details     The address, names, location and autonomous system of the hop are read from the shared
+             *              HopIdentityTable entry rather than being held by each route item.
              *
-             * @param[in]   hostAddress address for this hop.
+             * @param[in]   identity the id returned by HopIdentityTable::intern.
              */
-            auto setHostAddress(const QString &hostAddress) -> void;
+            auto setIdentity(quint32 identity) -> void;
 
             /**
-             * @brief       Returns the displayed ip address for this route item.
+             * @brief       Returns the identity of the router at this hop.
              *
-             * @returns     the address for this hop.
+             * @returns     the id, HopIdentityTable::NoReply if the hop has not replied.
              */
-            auto hostAddress() -> QString;
+            auto identity() -> quint32;
 
             /**
-             * @brief       Sets the displayed host name for this route item.
+             * @brief       Returns the address of the router at this hop.
              *
-             * @param[in]   hostName the host name.
+             * @returns     the address, a null address if the hop has not replied.
              */
-            auto setHostName(const QString &hostName) -> void;
+            auto address() -> QHostAddress;
 
             /**
-             * @brief       Returns the displayed host name for this route item.
+             * @brief       Returns the displayed ip address for this route item.
              *
-             * @returns     the host name.
+             * @returns     the address for this hop.
              */
-            auto hostName() -> QString;
+            auto hostAddress() -> QString;
 
             /**
-             * @brief       Sets the masked ip address for this route item.
+             * @brief       Returns the displayed host name for this route item.
              *
-             * @param[in]   maskedHostAddress masked address for this hop.
+             * @returns     the host name.
              */
-            auto setMaskedHostAddress(const QString &maskedHostAddress) -> void;
+            auto hostName() -> QString;
 
             /**
              * @brief       Returns the masked ip address for this route item.
@@ -174,32 +227,32 @@ namespace Nedrysoft { namespace RouteAnalyser {
             auto maskedHostAddress() -> QString;
 
             /**
-             * @brief       Sets the masked host name for this route item.
+             * @brief       Returns the masked host name for this route item.
              *
-             * @param[in]   maskedHostName the masked host name.
+             * @returns     the host name.
              */
-            auto setMaskedHostName(const QString &maskedHostName) -> void;
+            auto maskedHostName() -> QString;
 
             /**
-             * @brief       Returns the masked host name for this route item.
+             * @brief       Returns the displayed location.
              *
-             * @returns     the host name.
+             * @returns     the location.
              */
-            auto maskedHostName() -> QString;
+            auto location() -> QString;
 
             /**
-             * @brief       Sets the location position.
+             * @brief       Returns the AS number of the hop.
              *
-             * @param[in]   location the location.
+             * @returns     the AS number, 0 if the hop is not in a known AS.
              */
-            auto setLocation(const QString &location) -> void;
+            auto asNumber() -> quint32;
 
             /**
-             * @brief       Returns the displayed location.
+             * @brief       Returns the name of the organisation that owns the hop's AS.
              *
-             * @returns     the location.
+             * @returns     the owner.
              */
-            auto location() -> QString;
+            auto asOwner() -> QString;
 
             /**
              * @brief       Sets the graph associated with this route item.
@@ -215,6 +268,36 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto customPlot() -> QCustomPlot *;
 
+            /**
+             * @brief       Returns the result history of this route item.
+             *
+             * @details     The history is shared between copies of the item, the plots only hold the samples that
+             *              are in the history.
+             *
+             * @returns     the history; otherwise nullptr for an item that was default constructed.
+             */
+            auto timeSeries() -> Nedrysoft::RouteAnalyser::HopTimeSeries *;
+
+            /**
+             * @brief       Returns the round summaries of this route item.
+             *
+             * @details     The summaries are only collected while the hop is sent more than one probe per round,
+             *              they are shared between copies of the item.
+             *
+             * @returns     the round summaries; otherwise nullptr for an item that was default constructed.
+             */
+            auto roundSeries() -> Nedrysoft::RouteAnalyser::HopRoundSeries *;
+
+            /**
+             * @brief       Returns the extremes of the recent round trip times of this route item.
+             *
+             * @details     The window covers the latest viewport of the plots and is used to scale them, it is
+             *              shared between copies of the item.
+             *
+             * @returns     the window; otherwise nullptr for an item that was default constructed.
+             */
+            auto latencyWindow() -> Nedrysoft::RouteAnalyser::SlidingWindowExtrema *;
+
             /**
              * @brief       Returns whether this hop is valid.
              *
@@ -245,6 +328,32 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto packetLoss() -> double;
 
+            /**
+             * @brief       Sets the summary of the period shown by the plots.
+             *
+             * @details     While a summary is set the minimum, maximum and average latency and the packet loss
+             *              describe the period rather than the whole session.
+             *
+             * @param[in]   summary the summary of the visible period; otherwise nullptr to show the session.
+             */
+            auto setWindowSummary(const Nedrysoft::RouteAnalyser::HopTimeSeries::Rollup *summary) -> void;
+
+            /**
+             * @brief       Returns the windowed loss and loss burst statistics.
+             *
+             * @returns     the loss statistics.
+             */
+            auto lossStatistics() const -> const Nedrysoft::RouteAnalyser::LossStatistics &;
+
+            /**
+             * @brief       Returns the mean and variance of the round trip times.
+             *
+             * @details     The statistics of several hops can be merged to give route level figures.
+             *
+             * @returns     the latency statistics.
+             */
+            auto latencyStatistics() const -> const Nedrysoft::RouteAnalyser::RunningStatistics &;
+
             /**
              * @brief       Sets the plots associated with this.
              *
@@ -253,52 +362,102 @@ namespace Nedrysoft { namespace RouteAnalyser {
             auto setPlots(QList<Nedrysoft::RouteAnalyser::IPlot *> plots) -> void;
 
             /**
-             * @brief       Returns whether this item for the given field is the maximum value.
+             * @brief       Returns the plots associated with this.
              *
-             * @returns     true if the field is maximum; otherwise false.
+             * @returns     the plots.
              */
-            auto isMaximum(Nedrysoft::RouteAnalyser::PingData::Fields field) -> bool;
+            auto plots() -> QList<Nedrysoft::RouteAnalyser::IPlot *>;
 
             /**
-             * @brief       Sets whether this item the given field is the maximum value.
+             * @brief       Sets the baseline that the latency of the hop is compared against.
              *
-             * @param[in]   field the field to set.
-             * @param[in]   isMaximum true if the field is maximum; otherwise false.
+             * @param[in]   baseline the baseline of the hop, nullptr if the hop has none.
              */
-            auto setMaximum(Nedrysoft::RouteAnalyser::PingData::Fields field, bool isMaximum) -> void;
+            auto setBaseline(Nedrysoft::RouteAnalyser::HopBaseline *baseline) -> void;
 
             /**
-             * @brief       Updates the model so that views refresh.
+             * @brief       Adds results to the baseline and updates the usual latency of the hop.
+             *
+             * @param[in]   hourOfWeek the rollup period that the results were received in.
+             * @param[in]   results the results received since the previous update.
              */
-            auto updateModel() -> void;
+            auto updateBaseline(int hourOfWeek, const QVector<Nedrysoft::RouteAnalyser::PingResult> &results) -> void;
 
             /**
-             * @brief       Returns the title string of the associated plot.
+             * @brief       Returns whether the latency of the hop is well above its usual latency.
              *
-             * @returns     the plot title.
+             * @returns     true if the median latency has regressed; otherwise false.
              */
-            auto plotTitle() -> QString;
+            auto isRegression() -> bool;
+
+            /**
+             * @brief       Returns whether the hop is being probed less often because it rate limits its responses.
+             *
+             * @details     The loss shown for a rate limited hop is caused by the hop declining to answer some of
+             *              the probes sent to it, packets that are forwarded by the hop are not being lost.
+             *
+             * @returns     true if the hop is rate limited; otherwise false.
+             */
+            auto isRateLimited() -> bool;
+
+            /**
+             * @brief       Sets the latency and loss that are attributed to this hop.
+             *
+             * @details     The latency added by a hop is the difference between its median latency and that of
+             *              the previous responsive hop.  Loss is only attributed to a hop when it persists at every
+             *              responsive hop downstream, loss that does not is the hop declining to answer probes
+             *              addressed to it rather than the hop dropping the packets that it forwards.
+             *
+             * @param[in]   addedLatency the latency added by the hop in seconds; -1 if unknown.
+             * @param[in]   addedLoss the loss added by the hop as a percentage; -1 if unknown.
+             * @param[in]   localLoss true if the hop shows more loss than persists downstream; otherwise false.
+             */
+            auto setAttribution(double addedLatency, double addedLoss, bool localLoss) -> void;
+
+            /**
+             * @brief       Returns the loss that is attributed to this hop.
+             *
+             * @see         Nedrysoft::RouteAnalyser::PingData::setAttribution
+             *
+             * @returns     the loss as a percentage; otherwise -1 if unknown.
+             */
+            auto addedLoss() -> double;
+
+            /**
+             * @brief       Returns whether the hop shows more loss than persists downstream.
+             *
+             * @returns     true if some of the loss of the hop is local to it; otherwise false.
+             */
+            auto hasLocalLoss() -> bool;
 
-        protected:
             /**
-             * @brief       Calculates a running average.
+             * @brief       Returns whether this item for the given field is the maximum value.
              *
-             * @details     Used to calculate the running average of the latency, does not store previous values.
+             * @note        The maximums of the route are found by RouteTableModel::updateMaximums.
              *
-             * @param[in]   previousAverage the current average.
-             * @param[in]   value the new value to add to the average.
-             * @param[in]   n the number of values (including the new one) used.
+             * @returns     true if the field is maximum; otherwise false.
+             */
+            auto isMaximum(Nedrysoft::RouteAnalyser::PingData::Fields field) -> bool;
+
+            /**
+             * @brief       Updates the model so that views refresh.
+             */
+            auto updateModel() -> void;
+
+            /**
+             * @brief       Returns the title string of the associated plot.
              *
-             * @returns     the average.
+             * @returns     the plot title.
              */
-            static auto runningAverage(double previousAverage, double value, double n) -> double;
+            auto plotTitle() -> QString;
 
+        protected:
             /**
              * @brief       Returns the table model associated with this item.
              *
              * @returns     table model.
              */
-            auto tableModel() -> QStandardItemModel *;
+            auto tableModel() -> Nedrysoft::RouteAnalyser::RouteTableModel *;
 
             /**
              * @brief       Returns the number of samples sent.
@@ -307,36 +466,59 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto count() -> unsigned long ;
 
+            /**
+             * @brief       Updates the displayed values, plots and table from the current statistics.
+             *
+             * @param[in]   results the results that have been added to the statistics.
+             */
+            auto applyStatistics(const QVector<Nedrysoft::RouteAnalyser::PingResult> &results) -> void;
+
+            /**
+             * @brief       Computes the displayed value of a column from the statistics and the window summary.
+             *
+             * @param[in]   column the column.
+             *
+             * @returns     the value, negative if the hop has no value.
+             */
+            auto columnValue(Nedrysoft::RouteAnalyser::HopColumns::Column column) -> double;
+
+            /**
+             * @brief       Stores the displayed values of this hop in the columns of the table model.
+             */
+            auto publishColumns() -> void;
+
             friend class RouteTableItemDelegate;
 
         private:
             //! @cond
 
-            QStandardItemModel *m_tableModel;
+            Nedrysoft::RouteAnalyser::RouteTableModel *m_tableModel;
             QCustomPlot *m_customPlot;
             QCustomPlot *m_jitterPlot;
+            std::shared_ptr<Nedrysoft::RouteAnalyser::HopTimeSeries> m_timeSeries;
+            std::shared_ptr<Nedrysoft::RouteAnalyser::HopRoundSeries> m_roundSeries;
+            std::shared_ptr<Nedrysoft::RouteAnalyser::SlidingWindowExtrema> m_latencyWindow;
             QPersistentModelIndex m_modelIndex;
 
-            unsigned long m_replyPacketCount;
-            unsigned long m_timeoutPacketCount;
-
             int m_hop;
             bool m_hopValid;
+            bool m_rateLimited;
             unsigned long m_count;
 
-            QString m_hostAddress;
-            QString m_hostName;
-            QString m_maskedHostAddress;
-            QString m_maskedHostName;
-            QString m_location;
+            quint32 m_identity;
 
-            double m_currentLatency;
-            double m_maximumLatency;
-            double m_minimumLatency;
-            double m_averageLatency;
             double m_historicalLatency;
+            double m_baselineLatency;
+            double m_addedLatency;
+            double m_addedLoss;
+            bool m_localLoss;
+
+            Nedrysoft::RouteAnalyser::HopBaseline *m_baseline;
+
+            Nedrysoft::RouteAnalyser::HopStatistics m_statistics;
 
-            QMap<Fields, bool> m_isMaximum;
+            Nedrysoft::RouteAnalyser::HopTimeSeries::Rollup m_windowSummary;
+            bool m_windowed;
 
             QList<Nedrysoft::RouteAnalyser::IPlot *> m_plots;
 
@@ -344,7 +526,6 @@ namespace Nedrysoft { namespace RouteAnalyser {
     };
 }}
 
-Q_DECLARE_METATYPE(Nedrysoft::RouteAnalyser::PingData)
 Q_DECLARE_METATYPE(Nedrysoft::RouteAnalyser::PingData *)
 
 #endif // PINGNOO_COMPONENTS_ROUTEANALYSER_PINGDATA_H
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PingEngineBenchmark.h"
+
+#include "IPingEngine.h"
+#include "IPingEngineFactory.h"
+
+#include <Clock>
+#include <IConfigurationStore>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+
+constexpr auto ConfigurationPath = "Nedrysoft/Pingnoo/Components/RouteAnalyser";
+constexpr auto ConfigurationFilename = "EngineBenchmark.json";
+
+constexpr auto ResultLifetime = 7*24*60*60;
+constexpr auto ProbeInterval = 20;
+constexpr auto OverheadProbes = 16;
+constexpr auto BurstProbes = 64;
+constexpr auto MinimumReplies = 8;
+constexpr auto ProbeTimeout = 1.0;
+constexpr auto ProbeTtl = 64;
+constexpr auto NanosecondsPerSecond = 1e9;
+
+static auto resultKey(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version ) -> QString {
+
+    // the results are cached between sessions, so the engine is identified by its class rather than its address.
+
+    return QString("%1/%2").arg(factory->metaObject()->className()).arg(static_cast<int>(version));
+}
+
+Nedrysoft::RouteAnalyser::PingEngineBenchmark::PingEngineBenchmark() :
+        m_probeTimer(new QTimer(this)) {
+
+    m_probeTimer->setInterval(ProbeInterval);
+
+    connect(m_probeTimer, &QTimer::timeout, this, [this]() {
+        probe();
+    });
+
+    load();
+}
+
+Nedrysoft::RouteAnalyser::PingEngineBenchmark::~PingEngineBenchmark() {
+
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::getInstance() -> Nedrysoft::RouteAnalyser::PingEngineBenchmark * {
+    static Nedrysoft::RouteAnalyser::PingEngineBenchmark instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::start() -> void {
+    auto now = Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc();
+    auto versions = {Nedrysoft::Core::IPVersion::V4, Nedrysoft::Core::IPVersion::V6};
+
+    for (auto factory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if ((!factory->available()) || (!factory->vantagePoint().isEmpty())) {
+            continue;
+        }
+
+        for (auto version : versions) {
+            auto key = resultKey(factory, version);
+
+            if ((m_results.contains(key)) && (m_results[key].timestamp.secsTo(now)<ResultLifetime)) {
+                continue;
+            }
+
+            auto queued = std::any_of(m_queue.begin(), m_queue.end(), [factory, version](auto &benchmark) {
+                return (benchmark->factory==factory) && (benchmark->version==version);
+            });
+
+            if ((queued) || ((m_benchmark) && (m_benchmark->factory==factory) && (m_benchmark->version==version))) {
+                continue;
+            }
+
+            auto benchmark = std::make_shared<Benchmark>();
+
+            benchmark->factory = factory;
+            benchmark->version = version;
+
+            m_queue.append(benchmark);
+        }
+    }
+
+    if (!m_benchmark) {
+        startBenchmark();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::result(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::PingEngineBenchmark::Result {
+
+    return m_results.value(resultKey(factory, version));
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::fastestFactory(
+        Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::IPingEngineFactory * {
+
+    Nedrysoft::RouteAnalyser::IPingEngineFactory *fastestFactory = nullptr;
+    auto fastestResult = Result();
+
+    for (auto factory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if ((!factory->available()) || (!factory->vantagePoint().isEmpty())) {
+            continue;
+        }
+
+        auto result = m_results.value(resultKey(factory, version));
+
+        if ((!result.valid) || (!result.working)) {
+            continue;
+        }
+
+        if ((!fastestFactory) ||
+            (result.rate>fastestResult.rate) ||
+            ((result.rate==fastestResult.rate) && (result.overhead<fastestResult.overhead))) {
+
+            fastestFactory = factory;
+            fastestResult = result;
+        }
+    }
+
+    return fastestFactory;
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::probe() -> void {
+    auto benchmark = m_benchmark;
+
+    if (!benchmark) {
+        m_probeTimer->stop();
+
+        return;
+    }
+
+    if (benchmark->phase==Phase::Burst) {
+        if (benchmark->burst.wait_for(std::chrono::seconds(0))==std::future_status::ready) {
+            finishBenchmark();
+        }
+
+        return;
+    }
+
+    auto loopbackAddress = QHostAddress(
+        (benchmark->version==Nedrysoft::Core::IPVersion::V4) ? QHostAddress::LocalHost :
+                                                                 QHostAddress::LocalHostIPv6 );
+
+    /**
+     * the overhead is measured with requests spaced out so that each measures the cost of a single request, the
+     * burst is sent at once so that it measures how quickly the engine works through requests.
+     */
+
+    if (benchmark->sent<OverheadProbes) {
+        benchmark->pending.push_back(benchmark->engine->singleShotAsync(loopbackAddress, ProbeTtl, ProbeTimeout));
+
+        benchmark->sent++;
+    }
+
+    auto &pending = benchmark->pending;
+
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->wait_for(std::chrono::seconds(0))!=std::future_status::ready) {
+            it++;
+
+            continue;
+        }
+
+        auto result = it->get();
+
+        if (result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
+            benchmark->roundTripTimes.append(result.preciseRoundTripTime());
+        }
+
+        it = pending.erase(it);
+    }
+
+    if ((!pending.empty()) || (benchmark->sent<OverheadProbes)) {
+        return;
+    }
+
+    // an engine that does not answer on the loopback address is not given the burst.
+
+    if (benchmark->roundTripTimes.count()<MinimumReplies) {
+        finishBenchmark();
+
+        return;
+    }
+
+    /**
+     * the burst is timed on a thread of its own which waits for every reply, the probe timer only polls for the
+     * outcome so its interval does not limit the rate that can be measured.
+     */
+
+    auto engine = benchmark->engine;
+
+    benchmark->phase = Phase::Burst;
+    benchmark->burst = std::async(std::launch::async, [engine, loopbackAddress]() {
+        auto burstTimer = QElapsedTimer();
+        auto burst = std::vector<std::future<Nedrysoft::RouteAnalyser::PingResult> >();
+        auto replies = 0;
+
+        burstTimer.start();
+
+        for (auto index=0;index<BurstProbes;index++) {
+            burst.push_back(engine->singleShotAsync(loopbackAddress, ProbeTtl, ProbeTimeout));
+        }
+
+        for (auto &request : burst) {
+            if (request.get().code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
+                replies++;
+            }
+        }
+
+        return std::make_pair(replies, burstTimer.nsecsElapsed());
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::finishBenchmark() -> void {
+    auto benchmark = m_benchmark;
+
+    m_benchmark.reset();
+
+    if (benchmark) {
+        auto result = Result();
+
+        result.valid = true;
+        result.timestamp = Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc();
+
+        auto &roundTripTimes = benchmark->roundTripTimes;
+
+        if (benchmark->phase==Phase::Burst) {
+            auto burst = benchmark->burst.get();
+
+            std::sort(roundTripTimes.begin(), roundTripTimes.end());
+
+            result.working = (burst.first>=MinimumReplies);
+            result.overhead = roundTripTimes.at(roundTripTimes.count()/2);
+            result.rate = (burst.second>0) ? (burst.first*NanosecondsPerSecond)/static_cast<double>(burst.second) : 0;
+        }
+
+        benchmark->pending.clear();
+
+        benchmark->factory->deleteEngine(benchmark->engine);
+
+        m_results[resultKey(benchmark->factory, benchmark->version)] = result;
+
+        Q_EMIT resultsChanged();
+    }
+
+    startBenchmark();
+
+    if (!m_benchmark) {
+        save();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::startBenchmark() -> void {
+    while (!m_queue.isEmpty()) {
+        auto next = m_queue.takeFirst();
+
+        next->engine = next->factory->createEngine(next->version);
+
+        if (next->engine) {
+            m_benchmark = next;
+
+            m_probeTimer->start();
+
+            return;
+        }
+    }
+
+    m_probeTimer->stop();
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::filePath() -> QString {
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+
+    return QDir::cleanPath(QString("%1/%2/%3")
+            .arg(storageFolder)
+            .arg(ConfigurationPath)
+            .arg(ConfigurationFilename) );
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::load() -> void {
+    QFile resultsFile(filePath());
+
+    if (!resultsFile.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    auto jsonDocument = QJsonDocument::fromJson(resultsFile.readAll());
+
+    if (!jsonDocument.isObject()) {
+        return;
+    }
+
+    auto engines = jsonDocument.object()["engines"].toObject();
+
+    for (auto key : engines.keys()) {
+        auto engineObject = engines[key].toObject();
+        auto result = Result();
+
+        result.working = engineObject["working"].toBool();
+        result.overhead = static_cast<qint64>(engineObject["overhead"].toDouble());
+        result.rate = engineObject["rate"].toDouble();
+        result.timestamp = QDateTime::fromString(engineObject["timestamp"].toString(), Qt::ISODate);
+        result.valid = result.timestamp.isValid();
+
+        if (result.valid) {
+            m_results[key] = result;
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::PingEngineBenchmark::save() -> void {
+    auto engines = QJsonObject();
+
+    for (auto result=m_results.constBegin();result!=m_results.constEnd();result++) {
+        auto engineObject = QJsonObject();
+
+        engineObject["working"] = result->working;
+        engineObject["overhead"] = static_cast<double>(result->overhead);
+        engineObject["rate"] = result->rate;
+        engineObject["timestamp"] = result->timestamp.toString(Qt::ISODate);
+
+        engines[result.key()] = engineObject;
+    }
+
+    auto rootObject = QJsonObject();
+
+    rootObject["engines"] = engines;
+
+    Nedrysoft::Core::IConfigurationStore::getInstance()->save(filePath(), rootObject);
+}
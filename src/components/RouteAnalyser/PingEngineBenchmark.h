@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_PINGENGINEBENCHMARK_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_PINGENGINEBENCHMARK_H
+
+#include "PingResult.h"
+
+#include <ICore>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngine;
+    class IPingEngineFactory;
+
+    /**
+     * @brief       The PingEngineBenchmark class finds the fastest ping engine that works on this host.
+     *
+     * @details     Whether an engine is available, and how much it costs to send a request and receive the reply,
+     *              depends on the host (raw socket permissions, the ping command in use and so on) rather than on
+     *              the engine alone.  Each available engine is benchmarked against the loopback address in the
+     *              background, first with requests spaced out to measure the overhead of a single request and then
+     *              with a burst of requests to measure the rate that it can sustain.  The results are cached, so an
+     *              engine is only benchmarked again once its result has expired.
+     *
+     *              Engines that probe from a remote vantage point are not benchmarked, their loopback is not this
+     *              host.
+     */
+    class PingEngineBenchmark :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The benchmark result of an engine configuration.
+             */
+            struct Result {
+                bool valid = false;             //!< true once the configuration has been benchmarked.
+                bool working = false;           //!< true if enough requests to the loopback address were answered.
+                qint64 overhead = 0;            //!< the median loopback round trip time in nanoseconds.
+                double rate = 0;                //!< the replies per second received during the burst.
+                QDateTime timestamp;            //!< the time of the benchmark.
+            };
+
+        private:
+            /**
+             * @brief       Constructs the PingEngineBenchmark and loads the cached results.
+             */
+            PingEngineBenchmark();
+
+        public:
+            /**
+             * @brief       Destroys the PingEngineBenchmark.
+             */
+            ~PingEngineBenchmark();
+
+            /**
+             * @brief       Returns the PingEngineBenchmark instance.
+             *
+             * @returns     the benchmark.
+             */
+            static auto getInstance() -> PingEngineBenchmark *;
+
+            /**
+             * @brief       Benchmarks the available engines that do not have a current result.
+             *
+             * @details     The engines are benchmarked one at a time so that they do not disturb each other.
+             */
+            auto start() -> void;
+
+            /**
+             * @brief       Returns the benchmark result of an engine configuration.
+             *
+             * @param[in]   factory the factory that creates the engines.
+             * @param[in]   version the IP version of the engines.
+             *
+             * @returns     the result, which is not valid if the configuration has not been benchmarked.
+             */
+            auto result(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+                    Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::PingEngineBenchmark::Result;
+
+            /**
+             * @brief       Returns the fastest available engine that worked when it was benchmarked.
+             *
+             * @details     The engine that sustained the highest rate is chosen, engines with the same rate are
+             *              ordered by their overhead.
+             *
+             * @param[in]   version the IP version of the engines.
+             *
+             * @returns     the factory of the engine; otherwise nullptr if no engine has been benchmarked.
+             */
+            auto fastestFactory(Nedrysoft::Core::IPVersion version) -> Nedrysoft::RouteAnalyser::IPingEngineFactory *;
+
+            /**
+             * @brief       This signal is emitted when the benchmark of an engine configuration has completed.
+             */
+            Q_SIGNAL void resultsChanged();
+
+        private:
+            /**
+             * @brief       Sends the next requests and collects the replies of the benchmark in progress.
+             */
+            auto probe() -> void;
+
+            /**
+             * @brief       Stores the result of the benchmark in progress and moves on to the next.
+             *
+             * @details     The results are saved once the last queued benchmark has completed.
+             */
+            auto finishBenchmark() -> void;
+
+            /**
+             * @brief       Starts the next queued benchmark.
+             */
+            auto startBenchmark() -> void;
+
+            /**
+             * @brief       Returns the path of the file that the results are cached in.
+             *
+             * @returns     the path.
+             */
+            auto filePath() -> QString;
+
+            /**
+             * @brief       Loads the cached results.
+             */
+            auto load() -> void;
+
+            /**
+             * @brief       Saves the results.
+             */
+            auto save() -> void;
+
+        private:
+            //! @cond
+
+            enum class Phase {
+                Overhead,
+                Burst
+            };
+
+            struct Benchmark {
+                Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;
+                Nedrysoft::Core::IPVersion version = Nedrysoft::Core::IPVersion::V4;
+                Nedrysoft::RouteAnalyser::IPingEngine *engine = nullptr;
+                Phase phase = Phase::Overhead;
+                int sent = 0;
+                std::vector<std::future<Nedrysoft::RouteAnalyser::PingResult> > pending;
+                QVector<qint64> roundTripTimes;
+                std::future<std::pair<int, qint64> > burst;
+            };
+
+            QHash<QString, Result> m_results;
+            QList<std::shared_ptr<Benchmark> > m_queue;
+            std::shared_ptr<Benchmark> m_benchmark;
+
+            QTimer *m_probeTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_PINGENGINEBENCHMARK_H
@@ -21,20 +21,48 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "PingResult.h"
 
+#include <cstring>
+
+constexpr auto NanosecondsInSecond = 1.0e9;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+
+constexpr auto AddressNone = 0;
+constexpr auto AddressIPv4 = 4;
+constexpr auto AddressIPv6 = 6;
+
+/**
+ * @brief       Converts a time in seconds to nanoseconds.
+ *
+ * @param[in]   seconds the time in seconds, negative values indicate that the time is unknown.
+ *
+ * @returns     the time in nanoseconds; -1 if unknown.
+ */
+static auto toNanoseconds(double seconds) -> qint64 {
+    if (seconds < 0) {
+        return -1;
+    }
+
+    return static_cast<qint64>(std::llround(seconds * NanosecondsInSecond));
+}
+
 Nedrysoft::RouteAnalyser::PingResult::PingResult() :
+    m_requestTime(0),
+    m_roundTripTime(-1),
+    m_forwardDelay(0),
+    m_reverseDelay(0),
+    m_target(nullptr),
     m_sampleNumber(0),
+    m_address{},
+    m_hops(-1),
     m_code(PingResult::ResultCode::NoReply),
-    m_hostAddress(QHostAddress()),
-    m_target(nullptr),
-    m_roundTripTime(-1),
-    m_hops(-1) {
+    m_addressProtocol(AddressNone),
+    m_hasOneWayDelays(false) {
 
 }
 
-Nedrysoft::RouteAnalyser::PingResult::~PingResult() = default;
-
 Nedrysoft::RouteAnalyser::PingResult::PingResult(
         unsigned long sampleNumber,
         PingResult::ResultCode code,
@@ -44,40 +72,139 @@ Nedrysoft::RouteAnalyser::PingResult::PingResult(
         Nedrysoft::RouteAnalyser::IPingTarget *target,
         int hops) :
 
+            m_requestTime(requestTime.isValid() ? (requestTime.toMSecsSinceEpoch() * NanosecondsInMillisecond) : 0),
+            m_roundTripTime(toNanoseconds(roundTripTime)),
+            m_forwardDelay(0),
+            m_reverseDelay(0),
+            m_target(target),
             m_sampleNumber(sampleNumber),
+            m_address{},
+            m_hops(static_cast<int16_t>(hops)),
             m_code(code),
-            m_hostAddress(hostAddress),
+            m_addressProtocol(AddressNone),
+            m_hasOneWayDelays(false) {
+
+    setHostAddress(hostAddress);
+}
+
+Nedrysoft::RouteAnalyser::PingResult::PingResult(
+        unsigned long sampleNumber,
+        PingResult::ResultCode code,
+        const QHostAddress &hostAddress,
+        qint64 requestTimestamp,
+        qint64 roundTripTime,
+        Nedrysoft::RouteAnalyser::IPingTarget *target,
+        int hops) :
+
+            m_requestTime(requestTimestamp),
             m_roundTripTime(roundTripTime),
-            m_requestTime(requestTime),
+            m_forwardDelay(0),
+            m_reverseDelay(0),
             m_target(target),
-            m_hops(hops) {
+            m_sampleNumber(sampleNumber),
+            m_address{},
+            m_hops(static_cast<int16_t>(hops)),
+            m_code(code),
+            m_addressProtocol(AddressNone),
+            m_hasOneWayDelays(false) {
 
+    setHostAddress(hostAddress);
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::sampleNumber() -> unsigned long {
-    return m_sampleNumber;
+auto Nedrysoft::RouteAnalyser::PingResult::setHostAddress(const QHostAddress &hostAddress) -> void {
+    memset(m_address, 0, sizeof(m_address));
+
+    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        auto address = hostAddress.toIPv4Address();
+
+        m_address[0] = static_cast<uint8_t>(address >> 24);
+        m_address[1] = static_cast<uint8_t>(address >> 16);
+        m_address[2] = static_cast<uint8_t>(address >> 8);
+        m_address[3] = static_cast<uint8_t>(address);
+
+        m_addressProtocol = AddressIPv4;
+    } else if (hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto address = hostAddress.toIPv6Address();
+
+        memcpy(m_address, &address, sizeof(m_address));
+
+        m_addressProtocol = AddressIPv6;
+    } else {
+        m_addressProtocol = AddressNone;
+    }
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::requestTime() -> QDateTime {
+auto Nedrysoft::RouteAnalyser::PingResult::isLost(Nedrysoft::RouteAnalyser::PingResult::ResultCode code) -> bool {
+    return (code!=ResultCode::Ok) && (code!=ResultCode::TimeExceeded);
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::sampleNumber() const -> unsigned long {
+    return static_cast<unsigned long>(m_sampleNumber);
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::requestTime() const -> QDateTime {
+    return QDateTime::fromMSecsSinceEpoch(m_requestTime / NanosecondsInMillisecond);
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::requestTimestamp() const -> qint64 {
     return m_requestTime;
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::code() -> Nedrysoft::RouteAnalyser::PingResult::ResultCode {
+auto Nedrysoft::RouteAnalyser::PingResult::code() const -> Nedrysoft::RouteAnalyser::PingResult::ResultCode {
     return m_code;
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::hostAddress() -> QHostAddress {
-    return m_hostAddress;
+auto Nedrysoft::RouteAnalyser::PingResult::hostAddress() const -> QHostAddress {
+    if (m_addressProtocol == AddressIPv4) {
+        return QHostAddress(
+            (static_cast<quint32>(m_address[0]) << 24) |
+            (static_cast<quint32>(m_address[1]) << 16) |
+            (static_cast<quint32>(m_address[2]) << 8) |
+            static_cast<quint32>(m_address[3])
+        );
+    }
+
+    if (m_addressProtocol == AddressIPv6) {
+        return QHostAddress(m_address);
+    }
+
+    return QHostAddress();
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::roundTripTime() const -> double {
+    if (m_roundTripTime < 0) {
+        return -1;
+    }
+
+    return static_cast<double>(m_roundTripTime) / NanosecondsInSecond;
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::roundTripTime() -> double {
+auto Nedrysoft::RouteAnalyser::PingResult::preciseRoundTripTime() const -> qint64 {
     return m_roundTripTime;
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::target() -> Nedrysoft::RouteAnalyser::IPingTarget * {
+auto Nedrysoft::RouteAnalyser::PingResult::target() const -> Nedrysoft::RouteAnalyser::IPingTarget * {
     return m_target;
 }
 
-auto Nedrysoft::RouteAnalyser::PingResult::hops() -> int {
+auto Nedrysoft::RouteAnalyser::PingResult::hops() const -> int {
     return m_hops;
-}
\ No newline at end of file
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::setOneWayDelays(qint64 forwardDelay, qint64 reverseDelay) -> void {
+    m_forwardDelay = forwardDelay;
+    m_reverseDelay = reverseDelay;
+    m_hasOneWayDelays = true;
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::hasOneWayDelays() const -> bool {
+    return m_hasOneWayDelays;
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::forwardDelay() const -> double {
+    return static_cast<double>(m_forwardDelay) / NanosecondsInSecond;
+}
+
+auto Nedrysoft::RouteAnalyser::PingResult::reverseDelay() const -> double {
+    return static_cast<double>(m_reverseDelay) / NanosecondsInSecond;
+}
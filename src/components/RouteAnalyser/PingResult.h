@@ -32,6 +32,7 @@
 #include <QObject>
 #include <cmath>
 #include <cstdint>
+#include <type_traits>
 
 namespace Nedrysoft { namespace RouteAnalyser {
     class IPingTarget;
@@ -39,6 +40,11 @@ namespace Nedrysoft { namespace RouteAnalyser {
     /**
      * @brief       The PingResult class provides information about a ping response.
      *
+     * @details     A result is a compact, trivially copyable record so that it can be passed between threads and
+     *              stored in bulk without allocation.  Times are held as integer nanoseconds and the responding
+     *              address is held inline; QDateTime and QHostAddress instances are only constructed when they are
+     *              requested through requestTime() and hostAddress().
+     *
      * @class       Nedrysoft::RouteAnalyser::PingResult PingResult.h <PingResult>
      */
     class NEDRYSOFT_ROUTEANALYSER_DLLSPEC PingResult {
@@ -47,11 +53,16 @@ namespace Nedrysoft { namespace RouteAnalyser {
 
             /**
              * @brief       The result codes for a ping.
+             *
+             * @details     Unreachable and Prohibited are reported when a router or the destination answers the
+             *              request with an ICMP error, the round trip time is the time taken for the error to arrive.
              */
-            enum class ResultCode {
+            enum class ResultCode : uint8_t {
                 Ok,
                 NoReply,
-                TimeExceeded
+                TimeExceeded,
+                Unreachable,
+                Prohibited
             };
 
             /**
@@ -62,7 +73,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
             /**
              * @brief       Destroys the PingResult.
              */
-            ~PingResult();
+            ~PingResult() = default;
 
             /**
              * @brief       Constructs a PingResult with parameters.
@@ -71,7 +82,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @param[in]   code the result code.
              * @param[in]   hostAddress the IP address that responded to the request.
              * @param[in]   requestTime the time the request was sent.
-             * @param[in]   roundTripTime the time taken for the hop to respond.
+             * @param[in]   roundTripTime the time taken for the hop to respond in seconds.
              * @param[in]   target the target that was pinged.
              * @param[in]   hops the number of hops to the target if available; otherwise false.
              */
@@ -85,28 +96,72 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 int hops
             );
 
+            /**
+             * @brief       Constructs a PingResult from raw timestamps.
+             *
+             * @details     This is the constructor used by the engines, no date or time conversions are performed.
+             *
+             * @param[in]   sampleNumber the count which this result is associated with.
+             * @param[in]   code the result code.
+             * @param[in]   hostAddress the IP address that responded to the request.
+             * @param[in]   requestTimestamp the time the request was sent in nanoseconds since the unix epoch.
+             * @param[in]   roundTripTime the time taken for the hop to respond in nanoseconds; -1 if unknown.
+             * @param[in]   target the target that was pinged.
+             * @param[in]   hops the number of hops to the target if available; otherwise false.
+             */
+            PingResult(
+                unsigned long sampleNumber,
+                ResultCode code,
+                const QHostAddress &hostAddress,
+                qint64 requestTimestamp,
+                qint64 roundTripTime,
+                Nedrysoft::RouteAnalyser::IPingTarget *target,
+                int hops
+            );
+
         public:
 
+            /**
+             * @brief       Returns whether a result code means that the request was lost.
+             *
+             * @details     A request is lost if there was no reply or if the request was refused with an error, in
+             *              either case the result carries no latency for the target.
+             *
+             * @param[in]   code the result code.
+             *
+             * @returns     true if the request was lost; otherwise false.
+             */
+            static auto isLost(ResultCode code) -> bool;
+
             /**
              * @brief       Returns the sample number of the request.
              *
              * @returns     the sample number.
              */
-            auto sampleNumber() -> unsigned long;
+            auto sampleNumber() const -> unsigned long;
 
             /**
              * @brief       Returns the time that the request was transmitted at.
              *
+             * @note        A QDateTime is constructed on every call, requestTimestamp() should be preferred.
+             *
              * @returns     the request time.
              */
-            auto requestTime() -> QDateTime;
+            auto requestTime() const -> QDateTime;
+
+            /**
+             * @brief       Returns the time that the request was transmitted at.
+             *
+             * @returns     the request time in nanoseconds since the unix epoch.
+             */
+            auto requestTimestamp() const -> qint64;
 
             /**
              * @brief       The result code for the request (Echo Reply, Timeout).
              *
              * @returns     the result code.
              */
-            auto code() -> ResultCode;
+            auto code() const -> ResultCode;
 
             /**
              * @brief       The host address of the reply.
@@ -117,7 +172,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
              *
              * @returns     the IP address of the host that sent the reply..
              */
-            auto hostAddress() -> QHostAddress;
+            auto hostAddress() const -> QHostAddress;
 
             /**
              * @brief       The round trip time.
@@ -126,35 +181,89 @@ namespace Nedrysoft { namespace RouteAnalyser {
              *
              * @returns     the round trip time in seconds.
              */
-            auto roundTripTime() -> double;
+            auto roundTripTime() const -> double;
+
+            /**
+             * @brief       The round trip time.
+             *
+             * @returns     the round trip time in nanoseconds; -1 if unknown.
+             */
+            auto preciseRoundTripTime() const -> qint64;
 
             /**
              * @brief       The target associated with this result.
              *
              * @returns     the target.
              */
-            auto target() -> Nedrysoft::RouteAnalyser::IPingTarget *;
+            auto target() const -> Nedrysoft::RouteAnalyser::IPingTarget *;
 
             /**
              * @brief       The number of hops to the target.
              *
              * @returns     The number of hops to the target if available; otherwise -1.
              */
-            auto hops() -> int;
+            auto hops() const -> int;
+
+            /**
+             * @brief       Sets the one way delays of the request.
+             *
+             * @details     Engines that timestamp the request at the far end (i.e TWAMP) can split the round trip
+             *              into the delay in each direction.  The delays depend on the clocks of both hosts being
+             *              synchronised and may be negative if they are not, the variation of each is still valid.
+             *
+             * @param[in]   forwardDelay the delay from the sender to the reflector in nanoseconds.
+             * @param[in]   reverseDelay the delay from the reflector to the sender in nanoseconds.
+             */
+            auto setOneWayDelays(qint64 forwardDelay, qint64 reverseDelay) -> void;
+
+            /**
+             * @brief       Returns whether the result carries one way delays.
+             *
+             * @returns     true if the one way delays are available; otherwise false.
+             */
+            auto hasOneWayDelays() const -> bool;
+
+            /**
+             * @brief       The delay from the sender to the target.
+             *
+             * @returns     the forward delay in seconds, only valid if hasOneWayDelays() is true.
+             */
+            auto forwardDelay() const -> double;
+
+            /**
+             * @brief       The delay from the target back to the sender.
+             *
+             * @returns     the reverse delay in seconds, only valid if hasOneWayDelays() is true.
+             */
+            auto reverseDelay() const -> double;
+
+        protected:
+            /**
+             * @brief       Stores a host address in the inline address field.
+             *
+             * @param[in]   hostAddress the address to store.
+             */
+            auto setHostAddress(const QHostAddress &hostAddress) -> void;
 
         protected:
             //! @cond
 
-            unsigned long m_sampleNumber;
-            PingResult::ResultCode m_code;
-            QHostAddress m_hostAddress;
-            double m_roundTripTime;
-            QDateTime m_requestTime;
+            qint64 m_requestTime;
+            qint64 m_roundTripTime;
+            qint64 m_forwardDelay;
+            qint64 m_reverseDelay;
             Nedrysoft::RouteAnalyser::IPingTarget *m_target;
-            int m_hops;
+            uint64_t m_sampleNumber;
+            uint8_t m_address[16];
+            int16_t m_hops;
+            PingResult::ResultCode m_code;
+            uint8_t m_addressProtocol;
+            bool m_hasOneWayDelays;
 
             //! @endcond
     };
+
+    static_assert(std::is_trivially_copyable<PingResult>::value, "PingResult must be trivially copyable");
 }}
 
 #endif // PINGNOO_COMPONENTS_CORE_PINGRESULT_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PixmapCache.h"
+
+#include <QMutexLocker>
+
+Nedrysoft::RouteAnalyser::PixmapCache::PixmapCache(qint64 budget, const QString &subsystem) :
+        m_budget(budget),
+        m_cost(0),
+        m_memory(subsystem) {
+
+    m_clock.start();
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::find(quint64 key, QPixmap *pixmap) -> bool {
+    QMutexLocker locker(&m_mutex);
+
+    auto entry = m_entries.find(key);
+
+    if (entry==m_entries.end()) {
+        return false;
+    }
+
+    m_order.splice(m_order.begin(), m_order, entry->position);
+
+    entry->lastUsed = m_clock.elapsed();
+
+    if (pixmap) {
+        *pixmap = entry->pixmap;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::insert(quint64 key, const QPixmap &pixmap) -> void {
+    auto cost = static_cast<qint64>(pixmap.width())*pixmap.height()*pixmap.depth()/8;
+
+    QMutexLocker locker(&m_mutex);
+
+    auto existing = m_entries.find(key);
+
+    if (existing!=m_entries.end()) {
+        m_cost -= existing->cost;
+        m_order.erase(existing->position);
+        m_entries.erase(existing);
+    }
+
+    if (cost>m_budget) {
+        return;
+    }
+
+    trim(m_budget-cost);
+
+    m_order.push_front(key);
+
+    m_entries.insert(key, Entry{pixmap, cost, m_clock.elapsed(), m_order.begin()});
+
+    m_cost += cost;
+
+    m_memory.set(m_cost, m_entries.count());
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::removeUnused(qint64 age) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    auto now = m_clock.elapsed();
+
+    /**
+     * the order list runs from most to least recently used, so the unused pixmaps are all at the back.
+     */
+
+    while (!m_order.empty()) {
+        auto entry = m_entries.find(m_order.back());
+
+        if (now-entry->lastUsed<=age) {
+            break;
+        }
+
+        m_cost -= entry->cost;
+        m_entries.erase(entry);
+        m_order.pop_back();
+    }
+
+    m_memory.set(m_cost, m_entries.count());
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::clear() -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_entries.clear();
+    m_order.clear();
+    m_cost = 0;
+
+    m_memory.set(0, 0);
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::setBudget(qint64 budget) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_budget = budget;
+
+    trim(m_budget);
+
+    m_memory.set(m_cost, m_entries.count());
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::cost() -> qint64 {
+    QMutexLocker locker(&m_mutex);
+
+    return m_cost;
+}
+
+auto Nedrysoft::RouteAnalyser::PixmapCache::trim(qint64 budget) -> void {
+    while ((m_cost>budget) && (!m_order.empty())) {
+        auto entry = m_entries.find(m_order.back());
+
+        m_cost -= entry->cost;
+        m_entries.erase(entry);
+        m_order.pop_back();
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_PIXMAPCACHE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_PIXMAPCACHE_H
+
+#include <Diagnostics>
+#include <ElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPixmap>
+#include <list>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The PixmapCache class provides a thread safe least recently used pixmap cache.
+     *
+     * @details     Pixmaps are stored against 64 bit keys (see combineKey) and the total size of the stored pixmaps
+     *              is kept within a budget in bytes, when an insertion would exceed the budget the least recently
+     *              used pixmaps are discarded first.  All functions may be called from any thread.
+     */
+    class PixmapCache {
+        public:
+            /**
+             * @brief       Constructs a new PixmapCache.
+             *
+             * @param[in]   budget the maximum total size of the cached pixmaps in bytes.
+             * @param[in]   subsystem the name that the memory used by the cache is accounted to.
+             */
+            PixmapCache(qint64 budget, const QString &subsystem);
+
+            /**
+             * @brief       Looks up a pixmap in the cache.
+             *
+             * @details     A pixmap that is found becomes the most recently used.
+             *
+             * @param[in]   key the key of the pixmap.
+             * @param[out]  pixmap the cached pixmap if found.
+             *
+             * @returns     true if the pixmap was found; otherwise false.
+             */
+            auto find(quint64 key, QPixmap *pixmap) -> bool;
+
+            /**
+             * @brief       Inserts a pixmap into the cache, replacing any pixmap that has the same key.
+             *
+             * @details     A pixmap that is larger than the whole budget is not cached.
+             *
+             * @param[in]   key the key of the pixmap.
+             * @param[in]   pixmap the pixmap.
+             */
+            auto insert(quint64 key, const QPixmap &pixmap) -> void;
+
+            /**
+             * @brief       Removes the pixmaps that have not been used within the given time.
+             *
+             * @param[in]   age the time in milliseconds.
+             */
+            auto removeUnused(qint64 age) -> void;
+
+            /**
+             * @brief       Removes all pixmaps from the cache.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Sets the maximum total size of the cached pixmaps.
+             *
+             * @param[in]   budget the size in bytes.
+             */
+            auto setBudget(qint64 budget) -> void;
+
+            /**
+             * @brief       Returns the total size of the cached pixmaps.
+             *
+             * @returns     the size in bytes.
+             */
+            auto cost() -> qint64;
+
+            /**
+             * @brief       Combines a value into a cache key.
+             *
+             * @param[in]   seed the key so far.
+             * @param[in]   value the value to combine.
+             *
+             * @returns     the new key.
+             */
+            template <typename T>
+            static auto combineKey(quint64 seed, const T &value) -> quint64 {
+                return seed ^ (static_cast<quint64>(qHash(value))+0x9e3779b97f4a7c15ULL+(seed<<6)+(seed>>2));
+            }
+
+        private:
+            /**
+             * @brief       Removes least recently used pixmaps until the total size is within the given size.
+             *
+             * @note        The caller must hold the mutex.
+             *
+             * @param[in]   budget the size in bytes.
+             */
+            auto trim(qint64 budget) -> void;
+
+        private:
+            //! @cond
+
+            struct Entry {
+                QPixmap pixmap;
+                qint64 cost;
+                qint64 lastUsed;
+                std::list<quint64>::iterator position;
+            };
+
+            QMutex m_mutex;
+            QHash<quint64, Entry> m_entries;
+            std::list<quint64> m_order;
+            Nedrysoft::Core::ElapsedTimer m_clock;
+            qint64 m_budget;
+            qint64 m_cost;
+            Nedrysoft::Core::MemoryCounter m_memory;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_PIXMAPCACHE_H
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PowerProfile.h"
+
+#include "LatencySettings.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <atomic>
+
+#if defined(Q_OS_WINDOWS)
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/ps/IOPowerSources.h>
+#include <IOKit/ps/IOPSKeys.h>
+#endif
+
+constexpr auto PollInterval = 30000;
+constexpr auto SavingIntervalFactor = 4;
+constexpr auto VeryCoarseInterval = 1000;
+constexpr qint64 SavingSlack = 50*1000*1000;
+constexpr auto PowerSupplyPath = "/sys/class/power_supply";
+
+namespace {
+    std::atomic<qint64> wakeupSlackNanoseconds(0);
+}
+
+Nedrysoft::RouteAnalyser::PowerProfile::PowerProfile() :
+        m_pollTimer(new QTimer(this)),
+        m_onBattery(false),
+        m_saving(false) {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (latencySettings) {
+        connect(
+            latencySettings,
+            &Nedrysoft::RouteAnalyser::LatencySettings::powerSavingChanged,
+            this,
+            [=](bool /*powerSaving*/) {
+                update();
+            }
+        );
+    }
+
+    // there is no portable notification of the power source changing, it is read again at a leisurely rate.
+
+    m_pollTimer->setTimerType(Qt::VeryCoarseTimer);
+    m_pollTimer->setInterval(PollInterval);
+
+    connect(m_pollTimer, &QTimer::timeout, this, [=]() {
+        update();
+    });
+
+    m_pollTimer->start();
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::getInstance() -> Nedrysoft::RouteAnalyser::PowerProfile * {
+    static Nedrysoft::RouteAnalyser::PowerProfile instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::onBattery() -> bool {
+    return m_onBattery;
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::isSaving() -> bool {
+    return m_saving;
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::wakeupSlack() -> qint64 {
+    return wakeupSlackNanoseconds.load(std::memory_order_relaxed);
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::manage(QTimer *timer, int interval) -> void {
+    if (!timer) {
+        return;
+    }
+
+    if (!m_timers.contains(timer)) {
+        connect(timer, &QObject::destroyed, this, [=](QObject *) {
+            m_timers.remove(timer);
+        });
+    }
+
+    m_timers[timer] = interval;
+
+    apply(timer, interval);
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::update() -> void {
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    m_onBattery = readPowerSource();
+
+    auto saving = (m_onBattery) && (latencySettings) && (latencySettings->powerSaving());
+
+    wakeupSlackNanoseconds.store(saving ? SavingSlack : 0, std::memory_order_relaxed);
+
+    if (saving==m_saving) {
+        return;
+    }
+
+    m_saving = saving;
+
+    for (auto managedTimer=m_timers.constBegin();managedTimer!=m_timers.constEnd();managedTimer++) {
+        apply(managedTimer.key(), managedTimer.value());
+    }
+
+    Q_EMIT savingChanged(saving);
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::apply(QTimer *timer, int interval) -> void {
+    auto isActive = timer->isActive();
+
+    /**
+     * the timers are always allowed some slack so that the system can group them with other wakeups, while saving
+     * the intervals are lengthened and timers of a second or more are rounded to whole seconds.
+     */
+
+    if (m_saving) {
+        interval *= SavingIntervalFactor;
+    }
+
+    timer->setTimerType(((m_saving) && (interval>=VeryCoarseInterval)) ? Qt::VeryCoarseTimer : Qt::CoarseTimer);
+    timer->setInterval(interval);
+
+    if (isActive) {
+        timer->start();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::PowerProfile::readPowerSource() -> bool {
+#if defined(Q_OS_WINDOWS)
+    SYSTEM_POWER_STATUS powerStatus;
+
+    if (!GetSystemPowerStatus(&powerStatus)) {
+        return false;
+    }
+
+    return powerStatus.ACLineStatus==0;
+#elif defined(Q_OS_MACOS)
+    auto powerSourcesInfo = IOPSCopyPowerSourcesInfo();
+
+    if (!powerSourcesInfo) {
+        return false;
+    }
+
+    auto powerSourceType = IOPSGetProvidingPowerSourceType(powerSourcesInfo);
+    auto onBattery = (powerSourceType) &&
+            (CFStringCompare(powerSourceType, CFSTR(kIOPMBatteryPowerKey), 0)==kCFCompareEqualTo);
+
+    CFRelease(powerSourcesInfo);
+
+    return onBattery;
+#else
+    auto readValue = [](const QString &filename) {
+        QFile file(filename);
+
+        if (!file.open(QFile::ReadOnly)) {
+            return QString();
+        }
+
+        return QString::fromLatin1(file.readAll()).trimmed();
+    };
+
+    auto hasBattery = false;
+
+    // the batteries of peripherals such as mice are reported with a device scope and are ignored.
+
+    for (auto &supply : QDir(PowerSupplyPath).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        auto type = readValue(supply.filePath()+"/type");
+
+        if (readValue(supply.filePath()+"/scope")=="Device") {
+            continue;
+        }
+
+        if ((type=="Mains") && (readValue(supply.filePath()+"/online")=="1")) {
+            return false;
+        }
+
+        if (type=="Battery") {
+            hasBattery = true;
+        }
+    }
+
+    return hasBattery;
+#endif
+}
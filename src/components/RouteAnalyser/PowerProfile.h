@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_POWERPROFILE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_POWERPROFILE_H
+
+#include "RouteAnalyserSpec.h"
+
+#include <QHash>
+#include <QObject>
+
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The PowerProfile class lowers the number of wakeups when power saving is in effect.
+     *
+     * @details     Power saving is in effect while the computer runs from its battery and the power saving setting
+     *              is enabled.  The periodic timers of the views are managed by the profile, while saving they are
+     *              given very coarse timers and their intervals are lengthened.  The engines align their probes
+     *              and timeouts to slots of wakeupSlack() so that work which is due at about the same time is done
+     *              in a single wakeup, no probes are skipped.
+     *
+     *              The instance must be created from the main thread, wakeupSlack() may be called from any thread.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC PowerProfile :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs a new PowerProfile.
+             */
+            PowerProfile();
+
+        public:
+            /**
+             * @brief       Returns the PowerProfile instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> PowerProfile *;
+
+            /**
+             * @brief       Returns whether the computer is running from its battery.
+             *
+             * @returns     true if running from the battery; otherwise false.
+             */
+            auto onBattery() -> bool;
+
+            /**
+             * @brief       Returns whether power saving is in effect.
+             *
+             * @returns     true if saving power; otherwise false.
+             */
+            auto isSaving() -> bool;
+
+            /**
+             * @brief       Returns the length of the slots that the engines align their wakeups to.
+             *
+             * @details     Work that is due within the slack of a wakeup is done in that wakeup.
+             *
+             * @returns     the slack in nanoseconds; 0 if power saving is not in effect.
+             */
+            static auto wakeupSlack() -> qint64;
+
+            /**
+             * @brief       Manages the timer type and interval of a periodic timer.
+             *
+             * @details     The interval of the timer is set from the given interval, which is lengthened while
+             *              power saving is in effect.  The timer is updated when power saving starts or stops and
+             *              is forgotten when it is destroyed.
+             *
+             * @param[in]   timer the timer.
+             * @param[in]   interval the interval of the timer in milliseconds when not saving power.
+             */
+            auto manage(QTimer *timer, int interval) -> void;
+
+            /**
+             * @brief       This signal is emitted when power saving starts or stops.
+             *
+             * @param[in]   saving true if power saving is now in effect; otherwise false.
+             */
+            Q_SIGNAL void savingChanged(bool saving);
+
+        private:
+            /**
+             * @brief       Reads the power source and updates whether power saving is in effect.
+             */
+            auto update() -> void;
+
+            /**
+             * @brief       Applies the current profile to a managed timer.
+             *
+             * @param[in]   timer the timer.
+             * @param[in]   interval the interval of the timer in milliseconds when not saving power.
+             */
+            auto apply(QTimer *timer, int interval) -> void;
+
+            /**
+             * @brief       Reads whether the computer is running from its battery.
+             *
+             * @returns     true if running from the battery; otherwise false.
+             */
+            static auto readPowerSource() -> bool;
+
+        private:
+            //! @cond
+
+            QTimer *m_pollTimer;
+            QHash<QTimer *, int> m_timers;
+            bool m_onBattery;
+            bool m_saving;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_POWERPROFILE_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RecordingStage.h"
+
+#include "SessionCapture.h"
+#include "SessionJournal.h"
+
+#include <QMutexLocker>
+
+constexpr auto ChannelCapacity = 16384;
+
+Nedrysoft::RouteAnalyser::RecordingStage::RecordingStage() :
+        Nedrysoft::RouteAnalyser::ResultStage(
+                "Recording queue depth",
+                "Recording results dropped",
+                ChannelCapacity,
+                OverflowPolicy::Block ),
+
+        m_captureWriter(nullptr),
+        m_journal(nullptr) {
+
+}
+
+Nedrysoft::RouteAnalyser::RecordingStage::~RecordingStage() {
+    stop();
+}
+
+auto Nedrysoft::RouteAnalyser::RecordingStage::setCaptureWriter(
+        Nedrysoft::RouteAnalyser::CaptureWriter *captureWriter ) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    m_captureWriter = captureWriter;
+}
+
+auto Nedrysoft::RouteAnalyser::RecordingStage::setJournal(Nedrysoft::RouteAnalyser::SessionJournal *journal) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_journal = journal;
+}
+
+auto Nedrysoft::RouteAnalyser::RecordingStage::process(
+        const QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry> &batch,
+        quint64 epoch ) -> void {
+
+    Q_UNUSED(epoch)
+
+    QMutexLocker locker(&m_mutex);
+
+    if ((!m_captureWriter) && (!m_journal)) {
+        return;
+    }
+
+    for (auto &entry : batch) {
+        if (m_captureWriter) {
+            m_captureWriter->append(entry.hop+1, entry.result);
+        }
+
+        if (m_journal) {
+            m_journal->append(entry.hop+1, entry.result);
+        }
+    }
+}
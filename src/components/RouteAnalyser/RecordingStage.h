@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_RECORDINGSTAGE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_RECORDINGSTAGE_H
+
+#include "ResultStage.h"
+
+#include <QMutex>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class CaptureWriter;
+    class SessionJournal;
+
+    /**
+     * @brief       The RecordingStage class is the stage of the result pipeline which writes the results of a
+     *              target to its session capture and journal.
+     *
+     * @details     The capture and journal are opened and closed by the GUI, which detaches them from the stage
+     *              first, the stage holds a lock while it writes, so once a detach returns the stage is no longer
+     *              using the previous capture or journal and it can be closed or deleted.  A recording has to hold
+     *              every result, so a publisher waits rather than drops a result when the channel is full.
+     *
+     *              Hops are identified by their index, the capture and journal are given the hop number.
+     */
+    class RecordingStage :
+            public Nedrysoft::RouteAnalyser::ResultStage {
+
+        public:
+            /**
+             * @brief       Constructs a new RecordingStage.
+             */
+            RecordingStage();
+
+            /**
+             * @brief       Waits for any running task and destroys the RecordingStage.
+             */
+            ~RecordingStage() override;
+
+            /**
+             * @brief       Sets the capture that results are written to.
+             *
+             * @param[in]   captureWriter the capture; otherwise nullptr to stop writing a capture.
+             */
+            auto setCaptureWriter(Nedrysoft::RouteAnalyser::CaptureWriter *captureWriter) -> void;
+
+            /**
+             * @brief       Sets the journal that results are written to.
+             *
+             * @param[in]   journal the journal; otherwise nullptr to stop writing a journal.
+             */
+            auto setJournal(Nedrysoft::RouteAnalyser::SessionJournal *journal) -> void;
+
+        protected:
+            /**
+             * @brief       Writes a batch of results, called on a task pool thread.
+             *
+             * @see         Nedrysoft::RouteAnalyser::ResultStage::process
+             *
+             * @param[in]   batch the results.
+             * @param[in]   epoch the epoch of the batch.
+             */
+            auto process(const QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry> &batch,
+                         quint64 epoch) -> void override;
+
+        private:
+            //! @cond
+
+            QMutex m_mutex;
+            Nedrysoft::RouteAnalyser::CaptureWriter *m_captureWriter;
+            Nedrysoft::RouteAnalyser::SessionJournal *m_journal;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_RECORDINGSTAGE_H
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultChannel.h"
+
+#include <utility>
+
+Nedrysoft::RouteAnalyser::ResultChannel::ResultChannel(int capacity) :
+        m_mask(0),
+        m_writePosition(0),
+        m_readPosition(0) {
+
+    auto size = static_cast<size_t>(2);
+
+    while (size<static_cast<size_t>(capacity)) {
+        size <<= 1;
+    }
+
+    m_slots.reset(new Slot[size]);
+    m_mask = size-1;
+
+    /**
+     * a slot whose sequence equals a write position is free for that write, the writer then sets it to the position
+     * plus one which marks it as readable by the read at the same position.
+     */
+
+    for (auto slot=static_cast<size_t>(0);slot<size;slot++) {
+        m_slots[slot].sequence.store(slot, std::memory_order_relaxed);
+    }
+}
+
+Nedrysoft::RouteAnalyser::ResultChannel::~ResultChannel() = default;
+
+auto Nedrysoft::RouteAnalyser::ResultChannel::push(const Entry &entry) -> bool {
+    auto position = m_writePosition.load(std::memory_order_relaxed);
+
+    Slot *slot;
+
+    for (;;) {
+        slot = &m_slots[position & m_mask];
+
+        auto sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<ptrdiff_t>(sequence)-static_cast<ptrdiff_t>(position);
+
+        if (difference==0) {
+            if (m_writePosition.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference<0) {
+            return false;
+        } else {
+            position = m_writePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->entry = entry;
+    slot->sequence.store(position+1, std::memory_order_release);
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::ResultChannel::pop(Entry &entry) -> bool {
+    auto position = m_readPosition.load(std::memory_order_relaxed);
+
+    Slot *slot;
+
+    for (;;) {
+        slot = &m_slots[position & m_mask];
+
+        auto sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<ptrdiff_t>(sequence)-static_cast<ptrdiff_t>(position+1);
+
+        if (difference==0) {
+            if (m_readPosition.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference<0) {
+            return false;
+        } else {
+            position = m_readPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry = std::move(slot->entry);
+
+    // the slot becomes free for the write one lap later.
+
+    slot->sequence.store(position+m_mask+1, std::memory_order_release);
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::ResultChannel::isEmpty() const -> bool {
+    return m_readPosition.load(std::memory_order_acquire)>=m_writePosition.load(std::memory_order_acquire);
+}
+
+auto Nedrysoft::RouteAnalyser::ResultChannel::capacity() const -> int {
+    return static_cast<int>(m_mask+1);
+}
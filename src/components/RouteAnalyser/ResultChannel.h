@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTCHANNEL_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTCHANNEL_H
+
+#include "PingResult.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The ResultChannel class is a bounded queue of hop results that can be written and read from any
+     *              number of threads without a lock.
+     *
+     * @details     The channel is a ring of slots, each slot carries a sequence number which tells a writer whether
+     *              the slot is free and a reader whether it holds a result, so a writer and a reader only contend
+     *              when they claim the same position.  The capacity is fixed when the channel is constructed, a
+     *              full channel refuses a result rather than growing, and what happens then is left to the owner.
+     */
+    class ResultChannel {
+        public:
+            /**
+             * @brief       A result and the hop it belongs to.
+             */
+            struct Entry {
+                int hop;                                                    //! the identifier of the hop.
+                Nedrysoft::RouteAnalyser::PingResult result;                //! the result.
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new ResultChannel.
+             *
+             * @param[in]   capacity the minimum number of results the channel holds, it is rounded up to a power
+             *              of two.
+             */
+            explicit ResultChannel(int capacity);
+
+            /**
+             * @brief       Destroys the ResultChannel.
+             */
+            ~ResultChannel();
+
+            /**
+             * @brief       Adds a result to the channel.
+             *
+             * @param[in]   entry the result.
+             *
+             * @returns     true if the result was added; otherwise false if the channel is full.
+             */
+            auto push(const Entry &entry) -> bool;
+
+            /**
+             * @brief       Removes the oldest result from the channel.
+             *
+             * @param[out]  entry the result.
+             *
+             * @returns     true if a result was removed; otherwise false if the channel is empty.
+             */
+            auto pop(Entry &entry) -> bool;
+
+            /**
+             * @brief       Returns whether the channel is empty.
+             *
+             * @note        The answer can be out of date by the time it is used if other threads are writing.
+             *
+             * @returns     true if empty; otherwise false.
+             */
+            auto isEmpty() const -> bool;
+
+            /**
+             * @brief       Returns the number of results the channel can hold.
+             *
+             * @returns     the capacity.
+             */
+            auto capacity() const -> int;
+
+        private:
+            //! @cond
+
+            struct Slot {
+                std::atomic<size_t> sequence;
+                Entry entry;
+            };
+
+            std::unique_ptr<Slot[]> m_slots;
+            size_t m_mask;
+
+            alignas(64) std::atomic<size_t> m_writePosition;
+            alignas(64) std::atomic<size_t> m_readPosition;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTCHANNEL_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTPIPELINE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTPIPELINE_H
+
+#include "PingResult.h"
+
+#include <QList>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class ResultStage;
+
+    /**
+     * @brief       The ResultPipeline class passes the results of the hops of a target to the stages which consume
+     *              them.
+     *
+     * @details     The engines deliver results on the GUI thread, the pipeline hands each one to every stage, which
+     *              only queues it, so the statistics, the result sinks and the recording of a target run on the
+     *              task pool without the engines or the GUI waiting for them.  Each stage has its own channel and
+     *              overflow policy, so a slow sink drops its own results without holding up the statistics.
+     *
+     *              The pipeline does not own its stages and is only used from the GUI thread.
+     */
+    class ResultPipeline {
+        public:
+            /**
+             * @brief       Constructs a new ResultPipeline.
+             */
+            ResultPipeline();
+
+            /**
+             * @brief       Destroys the ResultPipeline.
+             */
+            ~ResultPipeline();
+
+            /**
+             * @brief       Adds a stage to the pipeline.
+             *
+             * @param[in]   stage the stage.
+             */
+            auto addStage(Nedrysoft::RouteAnalyser::ResultStage *stage) -> void;
+
+            /**
+             * @brief       Removes a stage from the pipeline.
+             *
+             * @param[in]   stage the stage.
+             */
+            auto removeStage(Nedrysoft::RouteAnalyser::ResultStage *stage) -> void;
+
+            /**
+             * @brief       Publishes a result for a hop to every stage.
+             *
+             * @param[in]   hop the identifier of the hop.
+             * @param[in]   result the result.
+             */
+            auto publish(int hop, const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+        private:
+            //! @cond
+
+            QList<Nedrysoft::RouteAnalyser::ResultStage *> m_stages;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTPIPELINE_H
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultStage.h"
+
+#include <Diagnostics>
+#include <QMutexLocker>
+#include <TaskPool>
+#include <thread>
+
+constexpr auto MaximumBatchSize = 1024;
+
+Nedrysoft::RouteAnalyser::ResultStage::ResultStage(
+        const char *depthProbe,
+        const char *dropProbe,
+        int capacity,
+        OverflowPolicy policy ) :
+
+        m_channel(capacity),
+        m_policy(policy),
+        m_depthProbe(depthProbe),
+        m_dropProbe(dropProbe),
+        m_scheduled(false),
+        m_stopped(false),
+        m_epoch(0),
+        m_dropped(0),
+        m_unreportedDrops(0) {
+
+}
+
+Nedrysoft::RouteAnalyser::ResultStage::~ResultStage() {
+    stop();
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::publish(
+        int hop,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if (m_stopped) {
+        return;
+    }
+
+    auto entry = Nedrysoft::RouteAnalyser::ResultChannel::Entry{hop, result};
+
+    while (!m_channel.push(entry)) {
+        switch (m_policy) {
+            case OverflowPolicy::Block: {
+                schedule();
+
+                std::this_thread::yield();
+
+                continue;
+            }
+
+            case OverflowPolicy::DropNewest: {
+                m_dropped++;
+                m_unreportedDrops++;
+
+                schedule();
+
+                return;
+            }
+
+            case OverflowPolicy::DropOldest: {
+                auto oldest = Nedrysoft::RouteAnalyser::ResultChannel::Entry();
+
+                if (m_channel.pop(oldest)) {
+                    m_dropped++;
+                    m_unreportedDrops++;
+                }
+
+                continue;
+            }
+        }
+    }
+
+    schedule();
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::dropped() const -> quint64 {
+    return m_dropped;
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::discard() -> void {
+    m_epoch++;
+
+    auto entry = Nedrysoft::RouteAnalyser::ResultChannel::Entry();
+
+    while (m_channel.pop(entry)) {
+        // the result belongs to the previous epoch.
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::epoch() const -> quint64 {
+    return m_epoch;
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::stop() -> void {
+    m_stopped = true;
+
+    QMutexLocker locker(&m_mutex);
+
+    while (m_scheduled) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::schedule() -> void {
+    /**
+     * the task is queued once for everything published before it runs, not once per result.
+     */
+
+    if (m_scheduled.exchange(true)) {
+        return;
+    }
+
+    Nedrysoft::Core::TaskPool::getInstance()->submit(reinterpret_cast<quintptr>(this), [this]() {
+        run();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::ResultStage::run() -> void {
+    /**
+     * the epoch is read before the batch is taken, so a batch which straddles a discard is marked with the old epoch
+     * and is thrown away by the subclass rather than mixed into the new one.
+     */
+
+    auto epoch = m_epoch.load();
+    auto batch = QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry>();
+    auto entry = Nedrysoft::RouteAnalyser::ResultChannel::Entry();
+
+    batch.reserve(MaximumBatchSize);
+
+    while ((batch.count()<MaximumBatchSize) && (m_channel.pop(entry))) {
+        batch.append(std::move(entry));
+    }
+
+    if (!m_stopped) {
+        auto diagnostics = Nedrysoft::Core::Diagnostics::getInstance();
+
+        diagnostics->record(m_depthProbe, batch.count());
+
+        auto drops = m_unreportedDrops.exchange(0);
+
+        if (drops) {
+            diagnostics->record(m_dropProbe, static_cast<double>(drops));
+        }
+
+        if (!batch.isEmpty()) {
+            process(batch, epoch);
+        }
+    }
+
+    /**
+     * results published while this batch was processed are handled by a new task rather than in a loop here, so a
+     * busy stage yields the pool thread to the other stages between batches.  The flag is cleared under the mutex
+     * and nothing is touched after it is released, as stop() may return and the stage be destroyed at that point.
+     */
+
+    QMutexLocker locker(&m_mutex);
+
+    m_scheduled = false;
+
+    if ((!m_stopped) && (!m_channel.isEmpty())) {
+        schedule();
+    } else {
+        m_idle.wakeAll();
+    }
+}
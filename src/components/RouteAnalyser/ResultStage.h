@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTSTAGE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTSTAGE_H
+
+#include "ResultChannel.h"
+
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The ResultStage class is a step of the result pipeline which consumes hop results on the shared
+     *              task pool.
+     *
+     * @details     Results are published into the bounded channel of the stage, a task is queued on the task pool
+     *              when the first result arrives and takes the results from the channel in batches, so a stage has
+     *              at most one task queued or running at a time and its state is only touched by one thread at once.
+     *
+     *              The overflow policy decides what happens when results arrive faster than the stage consumes
+     *              them and the channel fills.  Results that are dropped are counted and recorded as a diagnostics
+     *              value, so a stage that cannot keep up shows up rather than silently losing data.
+     *
+     *              A subclass must call stop() from its destructor, as the queued task calls process() which is
+     *              no longer available once the subclass has been destroyed.
+     */
+    class ResultStage {
+        public:
+            /**
+             * @brief       What a stage does with a result that arrives when its channel is full.
+             */
+            enum class OverflowPolicy {
+                Block,                      /**< the publisher waits for the stage to make room. */
+                DropNewest,                 /**< the arriving result is discarded. */
+                DropOldest                  /**< the oldest queued result is discarded to make room. */
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new ResultStage.
+             *
+             * @param[in]   depthProbe the diagnostics probe that the size of each batch is recorded under.
+             * @param[in]   dropProbe the diagnostics probe that the number of dropped results is recorded under.
+             * @param[in]   capacity the number of results the channel holds.
+             * @param[in]   policy the overflow policy.
+             */
+            ResultStage(const char *depthProbe, const char *dropProbe, int capacity, OverflowPolicy policy);
+
+            /**
+             * @brief       Destroys the ResultStage.
+             */
+            virtual ~ResultStage();
+
+            /**
+             * @brief       Queues a result for a hop.
+             *
+             * @note        A stage with the Block policy must not be published to from a task pool thread, as the
+             *              publisher could be waiting for the only thread that can empty the channel.
+             *
+             * @param[in]   hop the identifier of the hop.
+             * @param[in]   result the result.
+             */
+            auto publish(int hop, const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Returns the number of results that have been dropped since the stage was constructed.
+             *
+             * @returns     the number of dropped results.
+             */
+            auto dropped() const -> quint64;
+
+        protected:
+            /**
+             * @brief       Consumes a batch of results, called on a task pool thread.
+             *
+             * @param[in]   batch the results in the order they were published.
+             * @param[in]   epoch the epoch of the stage when the batch was taken from the channel.
+             */
+            virtual auto process(const QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry> &batch,
+                                 quint64 epoch) -> void = 0;
+
+            /**
+             * @brief       Discards the queued results and starts a new epoch.
+             *
+             * @details     A batch that is being processed while the stage is discarded carries the previous epoch,
+             *              which allows the subclass to throw away its results rather than publish them.
+             */
+            auto discard() -> void;
+
+            /**
+             * @brief       Returns the current epoch.
+             *
+             * @returns     the epoch.
+             */
+            auto epoch() const -> quint64;
+
+            /**
+             * @brief       Stops the stage and waits for the queued or running task to finish.
+             *
+             * @details     Results that have not been processed are discarded and results published afterwards are
+             *              ignored.
+             */
+            auto stop() -> void;
+
+        private:
+            /**
+             * @brief       Queues the task that empties the channel if it is not already queued.
+             */
+            auto schedule() -> void;
+
+            /**
+             * @brief       Takes a batch of results from the channel and processes them, called on a task pool thread.
+             */
+            auto run() -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::ResultChannel m_channel;
+            OverflowPolicy m_policy;
+            const char *m_depthProbe;
+            const char *m_dropProbe;
+
+            std::atomic<bool> m_scheduled;
+            std::atomic<bool> m_stopped;
+            std::atomic<quint64> m_epoch;
+            std::atomic<quint64> m_dropped;
+            std::atomic<quint64> m_unreportedDrops;
+
+            QMutex m_mutex;
+            QWaitCondition m_idle;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_RESULTSTAGE_H
@@ -25,21 +25,31 @@
 
 #include "RouteAnalyserComponent.h"
 
+#include "AlertEngine.h"
+#include "BaselineStore.h"
+#include "CaptureAnalyser.h"
 #include "ColourDialog.h"
+#include "FleetDashboardEditor.h"
 #include "IRouteEngine.h"
 #include "LatencyRibbonGroup.h"
 #include "LatencySettings.h"
 #include "LatencySettingsPage.h"
+#include "MergedRouteEditor.h"
 #include "NewTargetDialog.h"
 #include "NewTargetRibbonGroup.h"
+#include "PingData.h"
+#include "PingEngineBenchmark.h"
 #include "PingResult.h"
+#include "PowerProfile.h"
 #include "RouteAnalyser.h"
 #include "RouteAnalyserConstants.h"
 #include "RouteAnalyserMenuItem.h"
+#include "SessionJournal.h"
 #include "TargetManager.h"
 #include "TargetSettings.h"
 #include "TargetSettingsPage.h"
 #include "ViewportRibbonGroup.h"
+#include "WorkspaceSnapshot.h"
 
 #include <CoreConstants>
 #include <ICommand>
@@ -58,14 +68,27 @@
 #endif
 #include <QDir>
 #include <QDirIterator>
+#include <QFileInfo>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QMessageBox>
 #if !defined(Q_OS_MACOS)
+#include <QApplication>
 #include <QGuiApplication>
 #include <QScreen>
+#include <QTimer>
 #endif
 #include <RibbonAction>
 #include <RibbonDropButton>
+#include <TaskPool>
+#include <Tracer>
 #include <QVBoxLayout>
+#include <QVector>
 #include <PopoverWindow.h>
+#include <algorithm>
 
 #if defined(Q_OS_WINDOWS)
 #include <windows.h>
@@ -73,6 +96,9 @@
 #endif
 
 constexpr auto FontBasePath = ":/Nedrysoft/RouteAnalyser/Roboto_Mono/static";
+constexpr auto TrayStatusInterval = 1000;
+constexpr auto TrayWarningLoss = 1.0;
+constexpr auto TrayCriticalLoss = 10.0;
 
 RouteAnalyserComponent::RouteAnalyserComponent() :
         m_newTargetGroupWidget(nullptr),
@@ -81,7 +107,18 @@ RouteAnalyserComponent::RouteAnalyserComponent() :
         m_latencySettingsPage(nullptr),
         m_targetSettingsPage(nullptr),
         m_newTargetAction(nullptr),
-        m_latencySettings(nullptr) {
+        m_newFleetAction(nullptr),
+        m_newMergedRouteAction(nullptr),
+        m_openCaptureAction(nullptr),
+        m_compareCapturesAction(nullptr),
+        m_recordSessionAction(nullptr),
+        m_showHeatmapAction(nullptr),
+        m_trayModeAction(nullptr),
+        m_latencySettings(nullptr),
+        m_targetSettings(nullptr),
+        m_systemTrayIcon(nullptr),
+        m_trayStatusTimer(nullptr),
+        m_trayMode(false) {
 
 }
 
@@ -90,12 +127,19 @@ RouteAnalyserComponent::~RouteAnalyserComponent() {
 }
 
 auto RouteAnalyserComponent::initialiseEvent() -> void {
+    Nedrysoft::Core::TraceScope traceScope("component", "RouteAnalyser::initialiseEvent");
+
     qRegisterMetaType<Nedrysoft::RouteAnalyser::PingResult>("Nedrysoft::RouteAnalyser::PingResult");
+    qRegisterMetaType<QVector<Nedrysoft::RouteAnalyser::PingResult> >("QVector<Nedrysoft::RouteAnalyser::PingResult>");
     qRegisterMetaType<Nedrysoft::RouteAnalyser::RouteList>("Nedrysoft::RouteAnalyser::RouteList");
     qRegisterMetaType<Nedrysoft::RouteAnalyser::IPingEngineFactory *>("Nedrysoft::RouteAnalyser::IPingEngineFactory *");
 }
 
 auto RouteAnalyserComponent::finaliseEvent() -> void {
+    // the workspace is saved while the editors still hold their history.
+
+    Nedrysoft::RouteAnalyser::WorkspaceSnapshot::getInstance()->save();
+
     auto editorList = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::RouteAnalyserEditor>();
 
     if (!editorList.isEmpty()) {
@@ -138,10 +182,53 @@ auto RouteAnalyserComponent::finaliseEvent() -> void {
         delete m_newTargetAction;
     }
 
+    if (m_openCaptureAction) {
+        delete m_openCaptureAction;
+    }
+
+    if (m_compareCapturesAction) {
+        delete m_compareCapturesAction;
+    }
+
+    if (m_recordSessionAction) {
+        delete m_recordSessionAction;
+    }
+
+    if (m_showHeatmapAction) {
+        delete m_showHeatmapAction;
+    }
+
+    if (m_newFleetAction) {
+        delete m_newFleetAction;
+    }
+
+    if (m_newMergedRouteAction) {
+        delete m_newMergedRouteAction;
+    }
+
+    if (m_trayModeAction) {
+        delete m_trayModeAction;
+    }
+
+    Nedrysoft::RouteAnalyser::BaselineStore::getInstance()->save();
+
     delete Nedrysoft::RouteAnalyser::TargetManager::getInstance();
 }
 
 auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
+    Nedrysoft::Core::TraceScope traceScope("component", "RouteAnalyser::initialisationFinishedEvent");
+
+    if (Nedrysoft::Core::headless()) {
+        return;
+    }
+
+    /**
+     * the engines are benchmarked in the background, a new target uses the fastest of them once the results for
+     * this host are known (see TargetSettings::defaultPingEngine).
+     */
+
+    Nedrysoft::RouteAnalyser::PingEngineBenchmark::getInstance()->start();
+
     auto contextManager = Nedrysoft::Core::IContextManager::getInstance();
 #if defined(Q_OS_MACOS)
     Nedrysoft::MacHelper::MacHelper::disableAppNap(
@@ -162,6 +249,8 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
 
     if (core) {
         connect(core, &Nedrysoft::Core::ICore::coreOpened, [&]() {
+            Nedrysoft::Core::TraceScope traceScope("ui", "RouteAnalyser::coreOpened");
+
             auto commandManager = Nedrysoft::Core::ICommandManager::getInstance();
 
             if (commandManager) {
@@ -182,7 +271,11 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
                             editor->setPingEngine(newTargetDialog.pingEngineFactory());
                             editor->setTarget(newTargetDialog.pingTarget());
                             editor->setIPVersion(newTargetDialog.ipVersion());
+                            editor->setDualStack(newTargetDialog.dualStack());
                             editor->setInterval(newTargetDialog.interval());
+                            editor->setPayloadSize(newTargetDialog.payloadSize());
+                            editor->setDontFragment(newTargetDialog.dontFragment());
+                            editor->setSources(newTargetDialog.sources());
 
                             editorManager->openEditor(editor);
                         }
@@ -200,6 +293,298 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
 
                 menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileNew);
 
+                // create New Fleet Dashboard... action, the targets are monitored with the default target settings.
+
+                m_newFleetAction = new QAction(tr("New Fleet Dashboard..."));
+
+                connect(m_newFleetAction, &QAction::triggered, [=]() {
+                    auto ok = false;
+
+                    auto text = QInputDialog::getMultiLineText(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("New Fleet Dashboard"),
+                            tr("Targets (one per line):"),
+                            QString(),
+                            &ok );
+
+                    QStringList hosts;
+
+                    for (auto &host : text.split(QRegularExpression("[,\\s]+"))) {
+                        if ((!host.isEmpty()) && (!hosts.contains(host))) {
+                            hosts.append(host);
+                        }
+                    }
+
+                    if ((!ok) || (hosts.isEmpty())) {
+                        return;
+                    }
+
+                    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+                    if (!editorManager) {
+                        return;
+                    }
+
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory = nullptr;
+
+                    auto pingEngines =
+                        Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>();
+
+                    for (auto pingEngine : pingEngines) {
+                        if (m_targetSettings->defaultPingEngine()==pingEngine->metaObject()->className()) {
+                            pingEngineFactory = pingEngine;
+                        }
+                    }
+
+                    if ((!pingEngineFactory) && (!pingEngines.isEmpty())) {
+                        pingEngineFactory = pingEngines.first();
+                    }
+
+                    auto editor = new Nedrysoft::RouteAnalyser::FleetDashboardEditor;
+
+                    editor->setPingEngine(pingEngineFactory);
+                    editor->setTargets(hosts);
+                    editor->setIPVersion(m_targetSettings->defaultIPVersion());
+                    editor->setInterval(m_targetSettings->defaultPingInterval());
+
+                    editorManager->openEditor(editor);
+                });
+
+                command = commandManager->registerAction(
+                    m_newFleetAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::NewFleet
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileNew);
+
+                // create New Merged Route... action, the target is traced from every vantage point at once.
+
+                m_newMergedRouteAction = new QAction(tr("New Merged Route..."));
+
+                connect(m_newMergedRouteAction, &QAction::triggered, [=]() {
+                    auto ok = false;
+
+                    auto host = QInputDialog::getText(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("New Merged Route"),
+                            tr("Target:"),
+                            QLineEdit::Normal,
+                            QString(),
+                            &ok ).trimmed();
+
+                    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+                    if ((!ok) || (host.isEmpty()) || (!editorManager)) {
+                        return;
+                    }
+
+                    auto editor = new Nedrysoft::RouteAnalyser::MergedRouteEditor;
+
+                    editor->setTarget(host);
+                    editor->setIPVersion(m_targetSettings->defaultIPVersion());
+                    editor->setInterval(m_targetSettings->defaultPingInterval());
+
+                    editorManager->openEditor(editor);
+                });
+
+                command = commandManager->registerAction(
+                    m_newMergedRouteAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::NewMergedRoute
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileNew);
+
+                // create Open Capture... action, a capture is shown in a new editor without a ping engine.
+
+                m_openCaptureAction = new QAction(tr("Open Capture..."));
+
+                connect(m_openCaptureAction, &QAction::triggered, [=]() {
+                    auto filename = QFileDialog::getOpenFileName(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("Open Capture"),
+                            QString(),
+                            tr("Pingnoo Captures (*.pingcap)") );
+
+                    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+                    if ((filename.isEmpty()) || (!editorManager)) {
+                        return;
+                    }
+
+                    auto editor = new Nedrysoft::RouteAnalyser::RouteAnalyserEditor;
+
+                    editor->setCaptureFile(filename);
+
+                    editorManager->openEditor(editor);
+                });
+
+                command = commandManager->registerAction(
+                    m_openCaptureAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::OpenCapture
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileOpen);
+
+                // create Compare Captures... action, which writes a report of the differences between two captures.
+
+                m_compareCapturesAction = new QAction(tr("Compare Captures..."));
+
+                connect(m_compareCapturesAction, &QAction::triggered, [=]() {
+                    auto beforeFilename = QFileDialog::getOpenFileName(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("Open Earlier Capture"),
+                            QString(),
+                            tr("Pingnoo Captures (*.pingcap)") );
+
+                    if (beforeFilename.isEmpty()) {
+                        return;
+                    }
+
+                    auto afterFilename = QFileDialog::getOpenFileName(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("Open Later Capture"),
+                            QFileInfo(beforeFilename).absolutePath(),
+                            tr("Pingnoo Captures (*.pingcap)") );
+
+                    if (afterFilename.isEmpty()) {
+                        return;
+                    }
+
+                    auto reportFilename = QFileDialog::getSaveFileName(
+                            Nedrysoft::Core::mainWindow(),
+                            tr("Save Comparison"),
+                            QString(),
+                            tr("Text Files (*.txt);;CSV Files (*.csv);;JSON Files (*.json)") );
+
+                    if (reportFilename.isEmpty()) {
+                        return;
+                    }
+
+                    /**
+                     * both captures are scanned on the task pool, the scan of each capture is itself spread over
+                     * the workers a block range at a time, so a large capture does not stall the user interface.
+                     */
+
+                    Nedrysoft::Core::TaskPool::getInstance()->submit(
+                            Nedrysoft::Core::TaskPool::Priority::Bulk,
+                            [beforeFilename, afterFilename, reportFilename]() {
+
+                        auto before = Nedrysoft::RouteAnalyser::CaptureAnalyser::analyse(beforeFilename);
+                        auto after = Nedrysoft::RouteAnalyser::CaptureAnalyser::analyse(afterFilename);
+                        auto error = QString();
+
+                        if (!before.valid) {
+                            error = tr("Unable to read %1.").arg(beforeFilename);
+                        } else if (!after.valid) {
+                            error = tr("Unable to read %1.").arg(afterFilename);
+                        } else {
+                            auto report = Nedrysoft::RouteAnalyser::CaptureAnalyser::compare(
+                                    before,
+                                    after,
+                                    Nedrysoft::RouteAnalyser::CaptureAnalyser::format(reportFilename) );
+
+                            QSaveFile file(reportFilename);
+
+                            if ((!file.open(QIODevice::WriteOnly)) ||
+                                (file.write(report)!=report.size()) ||
+                                (!file.commit())) {
+
+                                error = tr("Unable to write %1.").arg(reportFilename);
+                            }
+                        }
+
+                        if (error.isEmpty()) {
+                            return;
+                        }
+
+                        QMetaObject::invokeMethod(qApp, [error]() {
+                            QMessageBox::warning(Nedrysoft::Core::mainWindow(), tr("Compare Captures"), error);
+                        }, Qt::QueuedConnection);
+                    });
+                });
+
+                command = commandManager->registerAction(
+                    m_compareCapturesAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::CompareCaptures
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileOpen);
+
+                // create Record Session... action, which starts or stops recording the current editor.
+
+                m_recordSessionAction = new QAction(tr("Record Session..."));
+
+                connect(m_recordSessionAction, &QAction::triggered, [=]() {
+                    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+                    if (!editorManager) {
+                        return;
+                    }
+
+                    auto routeAnalyserEditor = qobject_cast<Nedrysoft::RouteAnalyser::RouteAnalyserEditor *>(
+                            editorManager->currentEditor() );
+
+                    if (routeAnalyserEditor) {
+                        routeAnalyserEditor->toggleRecording();
+                    }
+                });
+
+                command = commandManager->registerAction(
+                    m_recordSessionAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::RecordSession,
+                    m_editorContextId
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileSave);
+
+                // create Show Heatmap action, which swaps the plots of the current editor for the heatmap.
+
+                m_showHeatmapAction = new QAction(tr("Show Heatmap"));
+
+                m_showHeatmapAction->setCheckable(true);
+
+                connect(m_showHeatmapAction, &QAction::triggered, [=](bool checked) {
+                    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+                    if (!editorManager) {
+                        return;
+                    }
+
+                    auto routeAnalyserEditor = qobject_cast<Nedrysoft::RouteAnalyser::RouteAnalyserEditor *>(
+                            editorManager->currentEditor() );
+
+                    if (routeAnalyserEditor) {
+                        routeAnalyserEditor->setHeatmapVisible(checked);
+                    }
+                });
+
+                command = commandManager->registerAction(
+                    m_showHeatmapAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::ShowHeatmap,
+                    m_editorContextId
+                );
+
+                auto editMenu = commandManager->findMenu(Nedrysoft::Core::Constants::Menus::Edit);
+
+                if (editMenu) {
+                    editMenu->appendCommand(command);
+                }
+
+                // create Monitor From Tray action, which hides the window while the routes continue to be probed.
+
+                m_trayModeAction = new QAction(tr("Monitor From Tray"));
+
+                connect(m_trayModeAction, &QAction::triggered, [=]() {
+                    setTrayMode(true);
+                });
+
+                command = commandManager->registerAction(
+                    m_trayModeAction,
+                    Nedrysoft::RouteAnalyser::Constants::Commands::TrayMode
+                );
+
+                menu->appendCommand(command, Nedrysoft::Core::Constants::MenuGroups::FileMisc);
+
                 auto ribbonBarManager = Nedrysoft::Core::IRibbonBarManager::getInstance();
 
                 if (ribbonBarManager) {
@@ -229,6 +614,10 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
                         }
                     );
                 }
+
+                recoverSessions();
+
+                Nedrysoft::RouteAnalyser::WorkspaceSnapshot::getInstance()->restore();
             }
         });
 
@@ -244,6 +633,11 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
 
         m_latencySettings->loadFromFile();
 
+        // the power profile and alert engine follow the settings, so they are created once the settings are loaded.
+
+        Nedrysoft::RouteAnalyser::PowerProfile::getInstance();
+        Nedrysoft::RouteAnalyser::AlertEngine::getInstance();
+
         auto ribbonBarManager = Nedrysoft::Core::IRibbonBarManager::getInstance();
 
         if (ribbonBarManager) {
@@ -298,7 +692,13 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
 
     systemTrayIcon->setColour(Qt::black);
 
+    m_systemTrayIcon = systemTrayIcon;
+
+    Nedrysoft::RouteAnalyser::AlertEngine::getInstance()->setSystemTrayIcon(systemTrayIcon);
+
     connect(Nedrysoft::Core::mainWindow(), &QObject::destroyed, [=](QObject *) {
+        m_systemTrayIcon = nullptr;
+
         delete systemTrayIcon;
     });
 
@@ -307,7 +707,9 @@ auto RouteAnalyserComponent::initialisationFinishedEvent() -> void {
         &Nedrysoft::Core::ISystemTrayIcon::clicked,
         [=](Nedrysoft::Core::ISystemTrayIcon::MouseButton button) {
 
-            if (button==Nedrysoft::Core::ISystemTrayIcon::MouseButton::Left) {
+            if ((button==Nedrysoft::Core::ISystemTrayIcon::MouseButton::Left) && (m_trayMode)) {
+                setTrayMode(false);
+            } else if (button==Nedrysoft::Core::ISystemTrayIcon::MouseButton::Left) {
 #if defined(Q_OS_MACOS)
                 auto popover = new Nedrysoft::MacHelper::MacPopover;
 
@@ -489,6 +891,16 @@ auto RouteAnalyserComponent::handleClipboardMenu(QPoint position) -> void {
     menu.addAction(CopyTableAndGraphsAsImage);
     menu.addAction(CopyTableAndGraphsAsPDF);
 
+    menu.addSeparator();
+
+    auto exportTableAsCSV = menu.addAction(tr("Export Table as CSV..."));
+    auto exportSamplesAsCSV = menu.addAction(tr("Export Samples as CSV..."));
+    auto exportSamplesAsJSON = menu.addAction(tr("Export Samples as JSON..."));
+    auto exportSamplesAsArrow = menu.addAction(tr("Export Samples as Arrow..."));
+    auto exportChangePointsAsCSV = menu.addAction(tr("Export Change Points as CSV..."));
+    auto exportTableAndGraphsAsImage = menu.addAction(tr("Export Table and Graphs as Image..."));
+    auto exportReportAsPDF = menu.addAction(tr("Export Report as PDF..."));
+
     auto selectedAction = menu.exec(position);
 
     if (selectedAction==copyTableAsText) {
@@ -531,5 +943,152 @@ auto RouteAnalyserComponent::handleClipboardMenu(QPoint position) -> void {
             Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsPDF,
             Nedrysoft::RouteAnalyser::OutputTarget::Clipboard
         );
+    } else if (selectedAction==exportTableAsCSV) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::TableAsCSV,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportSamplesAsCSV) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::SamplesAsCSV,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportSamplesAsJSON) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::SamplesAsJSON,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportSamplesAsArrow) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::SamplesAsArrow,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportChangePointsAsCSV) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::ChangePointsAsCSV,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportTableAndGraphsAsImage) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsImage,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    } else if (selectedAction==exportReportAsPDF) {
+        routeAnalyserEditor->generateOutput(
+            Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsPDF,
+            Nedrysoft::RouteAnalyser::OutputTarget::File
+        );
+    }
+}
+
+auto RouteAnalyserComponent::recoverSessions() -> void {
+    auto captureFiles = Nedrysoft::RouteAnalyser::SessionJournal::recover();
+    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+    if ((captureFiles.isEmpty()) || (!editorManager)) {
+        return;
+    }
+
+    auto answer = QMessageBox::question(
+            Nedrysoft::Core::mainWindow(),
+            tr("Recover Sessions"),
+            tr("Pingnoo did not close cleanly, %n session(s) were recovered as captures.  Open them now?",
+               nullptr,
+               captureFiles.count()) );
+
+    if (answer!=QMessageBox::Yes) {
+        return;
+    }
+
+    for (auto &captureFile : captureFiles) {
+        auto editor = new Nedrysoft::RouteAnalyser::RouteAnalyserEditor;
+
+        editor->setCaptureFile(captureFile);
+
+        editorManager->openEditor(editor);
+    }
+}
+
+auto RouteAnalyserComponent::setTrayMode(bool trayMode) -> void {
+    if (trayMode==m_trayMode) {
+        return;
+    }
+
+    m_trayMode = trayMode;
+
+    auto editorList = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::RouteAnalyserEditor>();
+
+    if (trayMode) {
+        Nedrysoft::Core::mainWindow()->hide();
+
+        for (auto editor : editorList) {
+            editor->setViewsReleased(true);
+        }
+
+        if (!m_trayStatusTimer) {
+            m_trayStatusTimer = new QTimer(this);
+
+            connect(m_trayStatusTimer, &QTimer::timeout, this, &RouteAnalyserComponent::updateTrayStatus);
+        }
+
+        m_trayStatusTimer->start(TrayStatusInterval);
+
+        updateTrayStatus();
+
+        return;
+    }
+
+    m_trayStatusTimer->stop();
+
+    // the window is shown first so that the editors bind plots to the slots that are visible.
+
+    Nedrysoft::Core::mainWindow()->show();
+
+    for (auto editor : editorList) {
+        editor->setViewsReleased(false);
+    }
+
+    if (m_systemTrayIcon) {
+        m_systemTrayIcon->setColour(Qt::black);
+    }
+}
+
+auto RouteAnalyserComponent::updateTrayStatus() -> void {
+    if (!m_systemTrayIcon) {
+        return;
     }
-}
\ No newline at end of file
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+    auto editorList = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::RouteAnalyserEditor>();
+    auto worstLatency = -1.0;
+    auto worstLoss = -1.0;
+
+    /**
+     * the destinations hold the latest snapshot of their statistics, which the statistics worker keeps publishing
+     * while the plots are released.
+     */
+
+    for (auto editor : editorList) {
+        for (auto pingData : editor->destinations()) {
+            worstLatency = std::max(
+                    worstLatency,
+                    pingData->latency(static_cast<int>(Nedrysoft::RouteAnalyser::PingData::Fields::CurrentLatency)) );
+
+            worstLoss = std::max(worstLoss, pingData->lossStatistics().shortWindowLoss());
+        }
+    }
+
+    if ((worstLatency<0) && (worstLoss<0)) {
+        m_systemTrayIcon->setColour(Qt::black);
+
+        return;
+    }
+
+    if ((worstLatency>=latencySettings->criticalValue()) || (worstLoss>=TrayCriticalLoss)) {
+        m_systemTrayIcon->setColour(QColor(latencySettings->criticalColour()));
+    } else if ((worstLatency>=latencySettings->warningValue()) || (worstLoss>=TrayWarningLoss)) {
+        m_systemTrayIcon->setColour(QColor(latencySettings->warningColour()));
+    } else {
+        m_systemTrayIcon->setColour(QColor(latencySettings->idealColour()));
+    }
+}
@@ -29,6 +29,8 @@
 
 #include <IComponent>
 
+class QTimer;
+
 namespace Nedrysoft { namespace RouteAnalyser {
     class NewTargetRibbonGroup;
     class LatencyRibbonGroup;
@@ -39,6 +41,10 @@ namespace Nedrysoft { namespace RouteAnalyser {
     class ViewportRibbonGroup;
 }}
 
+namespace Nedrysoft { namespace Core {
+    class ISystemTrayIcon;
+}}
+
 namespace Nedrysoft { namespace AppNap {
     class AppNap;
 }}
@@ -82,6 +88,29 @@ class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RouteAnalyserComponent :
          */
         auto handleClipboardMenu(QPoint position) -> void;
 
+        /**
+         * @brief       Recovers the session journals left by a previous run that did not end cleanly.
+         *
+         * @details     The recovered sessions are saved as session captures and the user is offered to open them.
+         */
+        auto recoverSessions() -> void;
+
+        /**
+         * @brief       Enters or leaves the tray monitoring mode.
+         *
+         * @details     In tray mode the main window is hidden and the editors release their plots, the routes
+         *              continue to be probed and the tray icon shows the status of the destinations.  Leaving tray
+         *              mode shows the main window and the plots are rebuilt from the collected results.
+         *
+         * @param[in]   trayMode true to enter tray mode; otherwise false to leave it.
+         */
+        auto setTrayMode(bool trayMode) -> void;
+
+        /**
+         * @brief       Colours the tray icon by the worst latency or loss of the destinations of all editors.
+         */
+        auto updateTrayStatus() -> void;
+
     public:
         /**
          * @brief       The initialiseEvent is called by the component loader to initialise the component.
@@ -124,6 +153,17 @@ class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RouteAnalyserComponent :
         Nedrysoft::RouteAnalyser::TargetSettings *m_targetSettings;
 
         QAction *m_newTargetAction;
+        QAction *m_newFleetAction;
+        QAction *m_newMergedRouteAction;
+        QAction *m_openCaptureAction;
+        QAction *m_compareCapturesAction;
+        QAction *m_recordSessionAction;
+        QAction *m_showHeatmapAction;
+        QAction *m_trayModeAction;
+
+        Nedrysoft::Core::ISystemTrayIcon *m_systemTrayIcon;
+        QTimer *m_trayStatusTimer;
+        bool m_trayMode;
 
         //! @endcond
 };
@@ -27,6 +27,13 @@
 namespace Nedrysoft { namespace RouteAnalyser { namespace Constants {
     namespace Commands {
         constexpr auto NewTarget = "RouteAnalyser.NewTarget";
+        constexpr auto NewFleet = "RouteAnalyser.NewFleet";
+        constexpr auto NewMergedRoute = "RouteAnalyser.NewMergedRoute";
+        constexpr auto OpenCapture = "RouteAnalyser.OpenCapture";
+        constexpr auto CompareCaptures = "RouteAnalyser.CompareCaptures";
+        constexpr auto RecordSession = "RouteAnalyser.RecordSession";
+        constexpr auto ShowHeatmap = "RouteAnalyser.ShowHeatmap";
+        constexpr auto TrayMode = "RouteAnalyser.TrayMode";
     };
 }}};
 
@@ -27,17 +27,60 @@
 #include "PlotScrollArea.h"
 #include "RouteAnalyser.h"
 #include "RouteAnalyserWidget.h"
+#include "RouteExporter.h"
+#include "RouteImageRenderer.h"
+#include "RouteReportWriter.h"
 #include "TargetManager.h"
 #include "ViewportRibbonGroup.h"
 
 #include <IContextManager>
+#include <IHostMaskerManager>
+#include <QApplication>
+#include <QBuffer>
+#include <QClipboard>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QMimeData>
 #include <QObject>
+#include <QSaveFile>
+#include <QSpinBox>
+#include <QSplitter>
+#include <TaskPool>
+#include <algorithm>
 
 constexpr auto DefaultWindowSize = 10.0*60.0;
 constexpr auto ViewportSize = 0.5;
+constexpr auto DefaultPayloadSize = 52;
+constexpr auto DefaultImageWidth = 1600;
+constexpr auto MinimumImageWidth = 400;
+constexpr auto MaximumImageWidth = 8000;
+constexpr auto DefaultImageDpi = 144;
+constexpr auto MinimumImageDpi = 72;
+constexpr auto MaximumImageDpi = 600;
+constexpr auto PdfMimeType = "application/pdf";
+constexpr auto RetentionBudget = "budget";
+constexpr auto RetentionTime = "time";
+constexpr auto RetentionSize = "size";
+
+// the size and resolution of the last image are offered again for the next one.
+
+static auto lastImageWidth = DefaultImageWidth;
+static auto lastImageDpi = DefaultImageDpi;
 
 Nedrysoft::RouteAnalyser::RouteAnalyserEditor::RouteAnalyserEditor() :
+        m_pingEngineFactory(nullptr),
+        m_payloadSize(DefaultPayloadSize),
+        m_dontFragment(false),
+        m_dualStack(false),
+        m_heatmapVisible(false),
         m_editorWidget(nullptr),
+        m_containerWidget(nullptr),
         m_viewportStart(0),
         m_viewportEnd(1) {
 
@@ -55,23 +98,196 @@ Nedrysoft::RouteAnalyser::RouteAnalyserEditor::~RouteAnalyserEditor() {
 }
 
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::saveConfiguration() -> QJsonObject {
-    return QJsonObject();
+    auto rootObject = QJsonObject();
+
+    QJsonObject retentionObject;
+
+    switch(m_retention.type) {
+        case Nedrysoft::RouteAnalyser::MemoryGovernor::Retention::Type::Time: {
+            retentionObject.insert("type", RetentionTime);
+            break;
+        }
+
+        case Nedrysoft::RouteAnalyser::MemoryGovernor::Retention::Type::Size: {
+            retentionObject.insert("type", RetentionSize);
+            break;
+        }
+
+        case Nedrysoft::RouteAnalyser::MemoryGovernor::Retention::Type::Budget: {
+            retentionObject.insert("type", RetentionBudget);
+            break;
+        }
+    }
+
+    retentionObject.insert("value", m_retention.value);
+
+    rootObject.insert("retention", retentionObject);
+
+    return rootObject;
 }
 
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::loadConfiguration(QJsonObject configuration) -> bool {
-    Q_UNUSED(configuration)
+    if (!configuration.contains("retention")) {
+        return false;
+    }
+
+    auto retentionObject = configuration["retention"].toObject();
+    auto type = retentionObject.value("type").toString();
+    auto retention = Nedrysoft::RouteAnalyser::MemoryGovernor::Retention();
+
+    if (type==RetentionTime) {
+        retention.type = Nedrysoft::RouteAnalyser::MemoryGovernor::Retention::Type::Time;
+    } else if (type==RetentionSize) {
+        retention.type = Nedrysoft::RouteAnalyser::MemoryGovernor::Retention::Type::Size;
+    }
+
+    retention.value = qMax<qint64>(0, static_cast<qint64>(retentionObject.value("value").toDouble()));
+
+    setRetention(retention);
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::saveWorkspace(
+        const QString &historyFile,
+        double period ) -> QJsonObject {
+
+    if ((!m_captureFile.isEmpty()) || (!m_pingEngineFactory)) {
+        return QJsonObject();
+    }
+
+    auto workspaceObject = QJsonObject();
+
+    workspaceObject.insert("target", m_pingTarget);
+    workspaceObject.insert("ipVersion", static_cast<int>(m_ipVersion));
+    workspaceObject.insert("interval", m_interval);
+    workspaceObject.insert("payloadSize", m_payloadSize);
+    workspaceObject.insert("dontFragment", m_dontFragment);
+    workspaceObject.insert("dualStack", m_dualStack);
+    workspaceObject.insert("sources", QJsonArray::fromStringList(m_sources));
+    workspaceObject.insert("pingEngine", m_pingEngineFactory->metaObject()->className());
+    workspaceObject.insert("configuration", saveConfiguration());
+
+    // an editor that has not been shown yet still holds the history it was restored with, so none is written.
+
+    auto historyFiles = QStringList();
+
+    for (auto index=0;index<m_editorWidgets.count();index++) {
+        auto filename = QString("%1-%2.pingcap").arg(historyFile).arg(index);
+
+        if (m_editorWidgets.at(index)->saveHistory(filename, period)) {
+            historyFiles.append(filename);
+        } else {
+            historyFiles.append(QString());
+        }
+    }
 
-    return false;
+    workspaceObject.insert("history", QJsonArray::fromStringList(historyFiles));
+
+    return workspaceObject;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::loadWorkspace(const QJsonObject &workspace) -> bool {
+    auto pingEngineName = workspace.value("pingEngine").toString();
+
+    m_pingEngineFactory = nullptr;
+
+    for (auto pingEngine : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if ((pingEngineName==pingEngine->metaObject()->className()) && (pingEngine->available())) {
+            m_pingEngineFactory = pingEngine;
+        }
+    }
+
+    m_pingTarget = workspace.value("target").toString();
+
+    if ((!m_pingEngineFactory) || (m_pingTarget.isEmpty())) {
+        return false;
+    }
+
+    m_ipVersion = static_cast<Nedrysoft::Core::IPVersion>(
+            workspace.value("ipVersion").toInt(static_cast<int>(Nedrysoft::Core::IPVersion::V4)) );
+
+    m_interval = workspace.value("interval").toDouble();
+    m_payloadSize = workspace.value("payloadSize").toInt(DefaultPayloadSize);
+    m_dontFragment = workspace.value("dontFragment").toBool();
+    m_dualStack = workspace.value("dualStack").toBool();
+    m_sources.clear();
+    m_historyFiles.clear();
+
+    for (auto source : workspace.value("sources").toArray()) {
+        m_sources.append(source.toString());
+    }
+
+    for (auto historyFile : workspace.value("history").toArray()) {
+        m_historyFiles.append(historyFile.toString());
+    }
+
+    loadConfiguration(workspace.value("configuration").toObject());
+
+    return true;
 }
 
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::widget() -> QWidget * {
     if (!m_editorWidget) {
-        m_editorWidget = new RouteAnalyserWidget(
-            m_pingTarget,
-            m_ipVersion,
-            m_interval,
-            m_pingEngineFactory
-        );
+        auto isCapture = !m_captureFile.isEmpty();
+        auto sources = isCapture ? QStringList() : m_sources;
+        auto ipVersions = QList<Nedrysoft::Core::IPVersion>() << m_ipVersion;
+
+        if (sources.isEmpty()) {
+            sources.append(QString());
+        }
+
+        // a dual stack editor traces the first source over each IP version rather than each source.
+
+        if ((m_dualStack) && (!isCapture)) {
+            sources = QStringList() << sources.first() << sources.first();
+            ipVersions = QList<Nedrysoft::Core::IPVersion>()
+                    << Nedrysoft::Core::IPVersion::V4
+                    << Nedrysoft::Core::IPVersion::V6;
+        }
+
+        for (auto index=0;index<sources.count();index++) {
+            m_editorWidgets.append(new RouteAnalyserWidget(
+                m_pingTarget,
+                ipVersions.value(index, m_ipVersion),
+                m_interval,
+                isCapture ? nullptr : m_pingEngineFactory,
+                m_payloadSize,
+                m_dontFragment,
+                sources.at(index)
+            ));
+
+            m_editorWidgets.last()->setAligned(m_dualStack);
+            m_editorWidgets.last()->setHeatmapVisible(m_heatmapVisible);
+            m_editorWidgets.last()->setRetention(m_retention);
+
+            if (m_editorWidgets.count()<=m_historyFiles.count()) {
+                m_editorWidgets.last()->setHistoryFile(m_historyFiles.at(m_editorWidgets.count()-1));
+            }
+        }
+
+        m_historyFiles.clear();
+
+        m_editorWidget = m_editorWidgets.first();
+
+        // the analyses of a target traced over several sources are shown side by side.
+
+        if (m_editorWidgets.count() > 1) {
+            auto splitter = new QSplitter(Qt::Horizontal);
+
+            for (auto editorWidget : m_editorWidgets) {
+                splitter->addWidget(editorWidget);
+            }
+
+            m_containerWidget = splitter;
+        }
+
+        if ((isCapture) && (!m_editorWidget->openCapture(m_captureFile))) {
+            QMessageBox::warning(
+                    Nedrysoft::Core::mainWindow(),
+                    tr("Open Capture"),
+                    tr("%1 is not a valid session capture.").arg(m_captureFile) );
+        }
 
         auto viewportWidget = ComponentSystem::getObject<ViewportRibbonGroup>();
         double newViewportSize = DefaultWindowSize;
@@ -80,11 +296,17 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::widget() -> QWidget * {
             newViewportSize = viewportWidget->viewportSize();
         }
 
-        m_editorWidget->setViewportSize(newViewportSize);
+        setViewportSize(newViewportSize);
 
-        auto favouritesManager = Nedrysoft::RouteAnalyser::TargetManager::getInstance();
+        if (!isCapture) {
+            auto favouritesManager = Nedrysoft::RouteAnalyser::TargetManager::getInstance();
 
-        favouritesManager->addRecent(m_pingTarget, m_pingTarget, m_pingTarget, m_ipVersion);
+            favouritesManager->addRecent(m_pingTarget, m_pingTarget, m_pingTarget, m_ipVersion);
+        }
+    }
+
+    if (m_containerWidget) {
+        return m_containerWidget;
     }
 
     return m_editorWidget;
@@ -101,6 +323,10 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setTarget(QString target) ->
 }
 
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::displayName() -> QString {
+    if ((m_dualStack) && (m_captureFile.isEmpty())) {
+        return tr("%1 (IPv4 and IPv6)").arg(m_pingTarget);
+    }
+
     return m_pingTarget;
 }
 
@@ -112,11 +338,66 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setInterval(double interval)
     m_interval = interval;
 }
 
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setPayloadSize(int payloadSize) -> void {
+    m_payloadSize = payloadSize;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setDontFragment(bool dontFragment) -> void {
+    m_dontFragment = dontFragment;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setSources(const QStringList &sources) -> void {
+    m_sources = sources;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setCaptureFile(const QString &filename) -> void {
+    m_captureFile = filename;
+    m_pingTarget = QFileInfo(filename).fileName();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setDualStack(bool dualStack) -> void {
+    m_dualStack = dualStack;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::toggleRecording() -> void {
+    if (!m_editorWidget) {
+        return;
+    }
+
+    if (m_editorWidget->isRecording()) {
+        m_editorWidget->stopRecording();
+
+        return;
+    }
+
+    auto filename = QFileDialog::getSaveFileName(
+            Nedrysoft::Core::mainWindow(),
+            tr("Record Session"),
+            QString(),
+            tr("Pingnoo Captures (*.pingcap)") );
+
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    if (!m_editorWidget->startRecording(filename)) {
+        QMessageBox::warning(
+                Nedrysoft::Core::mainWindow(),
+                tr("Record Session"),
+                tr("Unable to record to %1, the route must be discovered before a session can be recorded.")
+                        .arg(filename) );
+    }
+}
+
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::activated() -> void {
     auto viewportWidget = ComponentSystem::getObject<ViewportRibbonGroup>();
     auto latencyWidget = ComponentSystem::getObject<LatencyRibbonGroup>();
     // unused static auto hasBeenInitialised = false;
 
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setRenderingSuspended(false);
+    }
+
     // TODO: the viewport widget needs to be properly sized when switching editors, currently it reverts to the initial
     // size and when the next data result comes it then changes to the correct size and position.
 
@@ -165,6 +446,12 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::deactivated() -> void {
     auto latencyWidget = ComponentSystem::getObject<LatencyRibbonGroup>();
     auto viewportWidget = ComponentSystem::getObject<ViewportRibbonGroup>();
 
+    // a background editor keeps collecting results but does not draw them until it is activated again.
+
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setRenderingSuspended(true);
+    }
+
     if (latencyWidget) {
         disconnect(
             latencyWidget,
@@ -175,6 +462,9 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::deactivated() -> void {
     }
 
     if (viewportWidget) {
+        viewportWidget->setOverview(nullptr, 0, 0);
+        viewportWidget->setChangePoints(QVector<double>());
+
         disconnect(
             viewportWidget,
             &ViewportRibbonGroup::viewportChanged,
@@ -210,13 +500,15 @@ void Nedrysoft::RouteAnalyser::RouteAnalyserEditor::onDatasetChanged(double star
     } else {
         if (!viewportWidget->isViewportEnabled()) {
             viewportWidget->setViewport((1-ViewportSize), 1.0);
-            m_editorWidget->setViewportPosition(1);
+            setViewportPosition(1);
         }
 
         viewportWidget->setViewportEnabled(true);
     }
 
     viewportWidget->setStartAndEnd(start, end);
+    viewportWidget->setOverview(m_editorWidget->overviewSeries(), start, end);
+    viewportWidget->setChangePoints(m_editorWidget->overviewChangePoints());
 }
 
 void Nedrysoft::RouteAnalyser::RouteAnalyserEditor::onViewportChanged(double start, double end) {
@@ -224,7 +516,7 @@ void Nedrysoft::RouteAnalyser::RouteAnalyserEditor::onViewportChanged(double sta
         double viewportSize = 1.0 - ( end - start );
         double position = start / viewportSize;
 
-        m_editorWidget->setViewportPosition(position);
+        setViewportPosition(position);
     }
 }
 
@@ -232,17 +524,17 @@ void Nedrysoft::RouteAnalyser::RouteAnalyserEditor::onViewportWindowChanged(doub
     auto viewportWidget = ComponentSystem::getObject<ViewportRibbonGroup>();
 
     if (m_editorWidget) {
-        m_editorWidget->setViewportSize(size);
+        setViewportSize(size);
 
         if (m_editorWidget->datasetSize()<m_editorWidget->viewportSize()) {
             auto trimmerSize = (m_editorWidget->datasetSize()/m_editorWidget->viewportSize())*ViewportSize;
 
-            m_editorWidget->setViewportPosition(0);
+            setViewportPosition(0);
             viewportWidget->setViewport(qMin(1.0-ViewportSize, trimmerSize), 1.0);
             viewportWidget->setViewportEnabled(false);
         } else {
             if (!viewportWidget->isViewportEnabled()) {
-                m_editorWidget->setViewportPosition(1.0);
+                setViewportPosition(1.0);
                 viewportWidget->setViewport((1-ViewportSize), 1.0);
             }
 
@@ -257,6 +549,60 @@ void Nedrysoft::RouteAnalyser::RouteAnalyserEditor::onLatencyValueChanged(
 
 }
 
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setHeatmapVisible(bool visible) -> void {
+    m_heatmapVisible = visible;
+
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setHeatmapVisible(visible);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setViewsReleased(bool released) -> void {
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setViewsReleased(released);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setRetention(
+        const Nedrysoft::RouteAnalyser::MemoryGovernor::Retention &retention ) -> void {
+
+    m_retention = retention;
+
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setRetention(retention);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::retention() -> Nedrysoft::RouteAnalyser::MemoryGovernor::Retention {
+    return m_retention;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::destinations() -> QList<Nedrysoft::RouteAnalyser::PingData *> {
+    QList<Nedrysoft::RouteAnalyser::PingData *> destinationList;
+
+    for (auto editorWidget : m_editorWidgets) {
+        auto pingData = editorWidget->destinationData();
+
+        if (pingData) {
+            destinationList.append(pingData);
+        }
+    }
+
+    return destinationList;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setViewportPosition(double position) -> void {
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setViewportPosition(position);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::setViewportSize(double size) -> void {
+    for (auto editorWidget : m_editorWidgets) {
+        editorWidget->setViewportSize(size);
+    }
+}
+
 auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::contextId() -> int {
     return m_contextId;
 }
@@ -265,47 +611,316 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::generateOutput(
         Nedrysoft::RouteAnalyser::OutputType type,
         Nedrysoft::RouteAnalyser::OutputTarget target ) -> void {
 
-    if (type==Nedrysoft::RouteAnalyser::OutputType::TableAsText) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::TableAsPDF) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::TableAsImage) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::TableAsCSV) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::GraphsAsImage) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::GraphsAsPDF) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsImage) {
-    } else if (type==Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsPDF) {
-/*        QPrinter printer(QPrinter::HighResolution);
+    auto isExport = (type==Nedrysoft::RouteAnalyser::OutputType::TableAsText) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::TableAsCSV) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::SamplesAsCSV) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::SamplesAsJSON) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::SamplesAsArrow) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::ChangePointsAsCSV);
+
+    if ((isExport) && (m_editorWidget)) {
+        exportData(type, target);
+
+        return;
+    }
+
+    auto isImage = (type==Nedrysoft::RouteAnalyser::OutputType::TableAsImage) ||
+                   (type==Nedrysoft::RouteAnalyser::OutputType::GraphsAsImage) ||
+                   (type==Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsImage);
+
+    if ((isImage) && (m_editorWidget)) {
+        exportImage(type, target);
+
+        return;
+    }
+
+    auto isReport = (type==Nedrysoft::RouteAnalyser::OutputType::TableAsPDF) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::GraphsAsPDF) ||
+                    (type==Nedrysoft::RouteAnalyser::OutputType::TableAndGraphsAsPDF);
+
+    if ((isReport) && (m_editorWidget)) {
+        exportReport(type, target);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::exportData(
+        Nedrysoft::RouteAnalyser::OutputType type,
+        Nedrysoft::RouteAnalyser::OutputTarget target ) -> void {
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+    auto maskType = (target==OutputTarget::Clipboard) ?
+            Nedrysoft::Core::HostMaskType::Clipboard : Nedrysoft::Core::HostMaskType::Output;
+    auto maskHosts = (hostMaskerManager) && (hostMaskerManager->enabled(maskType));
+
+    auto hops = m_editorWidget->m_pingData;
+
+    std::sort(hops.begin(), hops.end(), [](PingData *a, PingData *b) {
+        return a->hop()<b->hop();
+    });
 
-        printer.setOutputFormat(QPrinter::PdfFormat);
-        printer.setOutputFileName("/Users/adriancarpenter/Desktop/pingnoo.pdf");
+    auto write = [&](QIODevice *device) {
+        auto exporter = RouteExporter(device, maskHosts);
 
-        //printer.setPageMargins(12, 16, 12, 20, QPrinter::Millimeter);
-        //printer.setFullPage(false);
+        switch (type) {
+            case OutputType::TableAsText: {
+                return exporter.writeTableAsText(hops);
+            }
 
-        QPainter painter(&printer);
+            case OutputType::TableAsCSV: {
+                return exporter.writeTableAsCSV(hops);
+            }
 
-        double xscale = printer.pageRect().width() / double(m_editorWidget->width());
-        double yscale = printer.pageRect().height() / double(m_editorWidget->height());
-        double scale = qMin(xscale, yscale);
+            case OutputType::SamplesAsCSV: {
+                return exporter.writeSamplesAsCSV(hops);
+            }
 
-        //painter.translate(printer.paperRect().center());
-        //painter.scale(scale, scale);
-        //painter.translate(-m_editorWidget->width()/ 2, -m_editorWidget->height()/ 2);
+            case OutputType::SamplesAsJSON: {
+                return exporter.writeSamplesAsJSON(m_pingTarget, hops);
+            }
 
-        int yOffset = 0;
+            case OutputType::SamplesAsArrow: {
+                return exporter.writeSamplesAsArrow(hops);
+            }
 
-        painter.scale(4, 4);
+            case OutputType::ChangePointsAsCSV: {
+                return exporter.writeChangePointsAsCSV(hops);
+            }
 
-        QTextDocument doc;
+            default: {
+                break;
+            }
+        }
 
-        for (auto plot : m_editorWidget->m_plotList) {
-plot->setPlottingHint()
-            plot->render(&painter);
-            painter.translate(0, 400);
+        return false;
+    };
+
+    if (target==OutputTarget::Clipboard) {
+        // an Arrow file is binary, so it can only be written to a file.
+
+        if (type==OutputType::SamplesAsArrow) {
+            return;
         }
 
-        //m_editorWidget->m_scrollArea->render(&painter);
-        */
+        QBuffer buffer;
+
+        buffer.open(QIODevice::WriteOnly);
+
+        if (write(&buffer)) {
+            QApplication::clipboard()->setText(QString::fromUtf8(buffer.data()));
+        }
+
+        return;
     }
 
-    qDebug() << "generateOutput";
+    auto filter = tr("CSV Files (*.csv)");
+
+    if (type==OutputType::SamplesAsJSON) {
+        filter = tr("JSON Files (*.json)");
+    } else if (type==OutputType::SamplesAsArrow) {
+        filter = tr("Arrow Files (*.arrow *.feather)");
+    } else if (type==OutputType::TableAsText) {
+        filter = tr("Text Files (*.txt)");
+    }
+
+    auto filename = QFileDialog::getSaveFileName(
+            Nedrysoft::Core::mainWindow(),
+            tr("Export"),
+            QString(),
+            filter );
+
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    /**
+     * the output is written to a temporary file which only replaces the destination once it is complete, a
+     * failure part way through a large export does not leave a truncated file behind.
+     */
+
+    QSaveFile file(filename);
+
+    if ((!file.open(QIODevice::WriteOnly)) || (!write(&file)) || (!file.commit())) {
+        QMessageBox::warning(
+                Nedrysoft::Core::mainWindow(),
+                tr("Export"),
+                tr("Unable to write %1.").arg(filename) );
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::exportImage(
+        Nedrysoft::RouteAnalyser::OutputType type,
+        Nedrysoft::RouteAnalyser::OutputTarget target ) -> void {
+
+    QDialog dialog(Nedrysoft::Core::mainWindow());
+
+    auto layout = new QFormLayout(&dialog);
+    auto widthSpinBox = new QSpinBox(&dialog);
+    auto dpiSpinBox = new QSpinBox(&dialog);
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+
+    widthSpinBox->setRange(MinimumImageWidth, MaximumImageWidth);
+    widthSpinBox->setSuffix(tr(" px"));
+    widthSpinBox->setValue(lastImageWidth);
+
+    dpiSpinBox->setRange(MinimumImageDpi, MaximumImageDpi);
+    dpiSpinBox->setSuffix(tr(" dpi"));
+    dpiSpinBox->setValue(lastImageDpi);
+
+    layout->addRow(tr("Width:"), widthSpinBox);
+    layout->addRow(tr("Resolution:"), dpiSpinBox);
+    layout->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    dialog.setWindowTitle(tr("Image"));
+
+    if (dialog.exec()!=QDialog::Accepted) {
+        return;
+    }
+
+    lastImageWidth = widthSpinBox->value();
+    lastImageDpi = dpiSpinBox->value();
+
+    auto filename = QString();
+
+    if (target==OutputTarget::File) {
+        filename = QFileDialog::getSaveFileName(
+                Nedrysoft::Core::mainWindow(),
+                tr("Export"),
+                QString(),
+                tr("PNG Files (*.png)") );
+
+        if (filename.isEmpty()) {
+            return;
+        }
+    }
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+    auto maskType = (target==OutputTarget::Clipboard) ?
+            Nedrysoft::Core::HostMaskType::Clipboard : Nedrysoft::Core::HostMaskType::Output;
+    auto maskHosts = (hostMaskerManager) && (hostMaskerManager->enabled(maskType));
+
+    auto content = 0;
+
+    if (type!=OutputType::GraphsAsImage) {
+        content |= RouteImageRenderer::Table;
+    }
+
+    if (type!=OutputType::TableAsImage) {
+        content |= RouteImageRenderer::Graphs;
+    }
+
+    /**
+     * the snapshot copies what is needed from the route, the session carries on updating while the image is drawn
+     * and encoded on the task pool.  The result is handed back to the application object rather than the editor,
+     * the editor may have been closed by the time a large image is finished.
+     */
+
+    auto snapshot = m_editorWidget->imageSnapshot(content, lastImageWidth, lastImageDpi, maskHosts, false);
+
+    auto taskPool = Nedrysoft::Core::TaskPool::getInstance();
+
+    taskPool->submit(Nedrysoft::Core::TaskPool::Priority::Bulk, [snapshot, filename]() {
+        auto image = Nedrysoft::RouteAnalyser::RouteImageRenderer::render(snapshot);
+        auto saved = false;
+
+        if (!filename.isEmpty()) {
+            QSaveFile file(filename);
+
+            saved = (file.open(QIODevice::WriteOnly)) && (image.save(&file, "PNG")) && (file.commit());
+        }
+
+        QMetaObject::invokeMethod(qApp, [image, filename, saved]() {
+            if (filename.isEmpty()) {
+                QApplication::clipboard()->setImage(image);
+            } else if (!saved) {
+                QMessageBox::warning(
+                        Nedrysoft::Core::mainWindow(),
+                        tr("Export"),
+                        tr("Unable to write %1.").arg(filename) );
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserEditor::exportReport(
+        Nedrysoft::RouteAnalyser::OutputType type,
+        Nedrysoft::RouteAnalyser::OutputTarget target ) -> void {
+
+    auto filename = QString();
+
+    if (target==OutputTarget::File) {
+        filename = QFileDialog::getSaveFileName(
+                Nedrysoft::Core::mainWindow(),
+                tr("Export"),
+                QString(),
+                tr("PDF Files (*.pdf)") );
+
+        if (filename.isEmpty()) {
+            return;
+        }
+    }
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+    auto maskType = (target==OutputTarget::Clipboard) ?
+            Nedrysoft::Core::HostMaskType::Clipboard : Nedrysoft::Core::HostMaskType::Output;
+    auto maskHosts = (hostMaskerManager) && (hostMaskerManager->enabled(maskType));
+
+    auto content = 0;
+
+    if (type!=OutputType::GraphsAsPDF) {
+        content |= RouteImageRenderer::Table;
+    }
+
+    if (type!=OutputType::TableAsPDF) {
+        content |= RouteImageRenderer::Graphs;
+    }
+
+    // a report covers the whole session, the graphs are decimated to the width of the page.
+
+    auto snapshot = m_editorWidget->imageSnapshot(
+            content,
+            RouteReportWriter::pageWidth(),
+            DefaultImageDpi,
+            maskHosts,
+            true );
+
+    auto taskPool = Nedrysoft::Core::TaskPool::getInstance();
+
+    taskPool->submit(Nedrysoft::Core::TaskPool::Priority::Bulk, [snapshot, filename]() {
+        auto written = false;
+        auto data = QByteArray();
+
+        if (filename.isEmpty()) {
+            QBuffer buffer(&data);
+
+            buffer.open(QIODevice::WriteOnly);
+
+            written = RouteReportWriter(&buffer).write({snapshot});
+        } else {
+            QSaveFile file(filename);
+
+            written = (file.open(QIODevice::WriteOnly)) &&
+                      (RouteReportWriter(&file).write({snapshot})) &&
+                      (file.commit());
+        }
+
+        QMetaObject::invokeMethod(qApp, [data, filename, written]() {
+            if (filename.isEmpty()) {
+                if (written) {
+                    auto mimeData = new QMimeData;
+
+                    mimeData->setData(PdfMimeType, data);
+
+                    QApplication::clipboard()->setMimeData(mimeData);
+                }
+            } else if (!written) {
+                QMessageBox::warning(
+                        Nedrysoft::Core::mainWindow(),
+                        tr("Export"),
+                        tr("Unable to write %1.").arg(filename) );
+            }
+        }, Qt::QueuedConnection);
+    });
 }
@@ -26,18 +26,21 @@
 
 #include "LatencyRibbonGroup.h"
 #include "IPingEngineFactory.h"
+#include "MemoryGovernor.h"
 
 #include <IConfiguration>
 #include <ICore>
 #include <IEditor>
 #include <IInterface>
 #include <QObject>
+#include <QStringList>
 
 namespace Nedrysoft { namespace Core {
     class IPingEngineFactory;
 }}
 
 namespace Nedrysoft { namespace RouteAnalyser {
+    class PingData;
     class RouteAnalyserComponent;
     class RouteAnalyserWidget;
 
@@ -54,7 +57,11 @@ namespace Nedrysoft { namespace RouteAnalyser {
         GraphsAsImage,
         GraphsAsPDF,
         TableAndGraphsAsImage,
-        TableAndGraphsAsPDF
+        TableAndGraphsAsPDF,
+        SamplesAsCSV,
+        SamplesAsJSON,
+        SamplesAsArrow,
+        ChangePointsAsCSV
     };
 
     /**
@@ -110,8 +117,107 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto setInterval(double interval) -> void;
 
+            /**
+             * @brief       Sets the payload size used by this ping target.
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            auto setPayloadSize(int payloadSize) -> void;
+
+            /**
+             * @brief       Sets whether echo requests are sent with the don't fragment flag.
+             *
+             * @param[in]   dontFragment true to prevent fragmentation; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> void;
+
+            /**
+             * @brief       Sets the sources that the target is traced from.
+             *
+             * @details     Each source is a local address or the name of a network interface.  When more than one
+             *              source is given the target is traced over all of them at the same time and the analyses
+             *              are shown side by side, the probes of every source are sent together so that the links
+             *              can be compared sample for sample.  Recording and exporting use the first source.
+             *
+             * @param[in]   sources the sources, an empty list traces over the default route.
+             */
+            auto setSources(const QStringList &sources) -> void;
+
+            /**
+             * @brief       Sets the session capture shown by this instance instead of a live analysis.
+             *
+             * @details     Must be called before the editor is opened, no ping engine is required.
+             *
+             * @param[in]   filename the capture file.
+             */
+            auto setCaptureFile(const QString &filename) -> void;
+
+            /**
+             * @brief       Sets whether the target is traced over both IPv4 and IPv6.
+             *
+             * @details     The target is resolved and traced once for each IP version, both analyses are shown side
+             *              by side and their hops are probed on aligned engines, so the samples of the two routes
+             *              are sent together and can be compared one for one.  Only the first source is used.
+             *
+             * @param[in]   dualStack true to trace both IP versions; otherwise false.
+             */
+            auto setDualStack(bool dualStack) -> void;
+
+            /**
+             * @brief       Starts or stops recording the analysis to a session capture.
+             *
+             * @details     If the analysis is being recorded then recording is stopped, otherwise the user is asked
+             *              for the file to record to.
+             */
+            auto toggleRecording() -> void;
+
+            /**
+             * @brief       Shows the latency of all hops as a heatmap in place of the plots of each hop.
+             *
+             * @param[in]   visible true to show the heatmap; otherwise false to show the plots.
+             */
+            auto setHeatmapVisible(bool visible) -> void;
+
+            /**
+             * @brief       Releases or restores the plots of the editor while the route continues to be probed.
+             *
+             * @see         Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewsReleased
+             *
+             * @param[in]   released true to release the plots; otherwise false to restore them.
+             */
+            auto setViewsReleased(bool released) -> void;
+
+            /**
+             * @brief       Sets how much of the history of the editor is kept in memory.
+             *
+             * @details     The policy is saved with the configuration of the editor.
+             *
+             * @see         Nedrysoft::RouteAnalyser::MemoryGovernor::setRetention
+             *
+             * @param[in]   retention the retention policy.
+             */
+            auto setRetention(const Nedrysoft::RouteAnalyser::MemoryGovernor::Retention &retention) -> void;
+
+            /**
+             * @brief       Returns how much of the history of the editor is kept in memory.
+             *
+             * @returns     the retention policy.
+             */
+            auto retention() -> Nedrysoft::RouteAnalyser::MemoryGovernor::Retention;
+
+            /**
+             * @brief       Returns the destination of each route shown by the editor.
+             *
+             * @returns     the hops that represent the destinations, routes without results are not included.
+             */
+            auto destinations() -> QList<Nedrysoft::RouteAnalyser::PingData *>;
+
             /**
              * @brief       Generates an output to the given destination.
+             *
+             * @details     The table and sample outputs are written by a RouteExporter, a file target asks the
+             *              user for the filename.
+             *
              * @param[in]   type the type of the output.
              * @param[in]   target the target for the output.
              */
@@ -182,6 +288,31 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto loadConfiguration(QJsonObject configuration) -> bool override;
 
+            /**
+             * @brief       Saves what is needed to reopen the editor to a workspace snapshot.
+             *
+             * @details     The settings of the analysis are returned and the recent history of each source is
+             *              written to a capture, so that the editor can be reopened with populated views.
+             *
+             * @param[in]   historyFile the capture file for the history, the index of the source is appended.
+             * @param[in]   period the length of the history to keep in seconds.
+             *
+             * @returns     the editor state; otherwise an empty object if the editor shows a capture.
+             */
+            auto saveWorkspace(const QString &historyFile, double period) -> QJsonObject;
+
+            /**
+             * @brief       Restores the editor from a workspace snapshot.
+             *
+             * @details     Must be called before the editor is opened.  The history is read straight away and is
+             *              added to the views once the route has been discovered.
+             *
+             * @param[in]   workspace the editor state returned by saveWorkspace().
+             *
+             * @returns     true if the editor was restored; otherwise false.
+             */
+            auto loadWorkspace(const QJsonObject &workspace) -> bool;
+
             friend class RouteAnalyserWidget;
 
         private:
@@ -208,6 +339,20 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             void onViewportWindowChanged(double size);
 
+            /**
+             * @brief       Sets the viewport position of every analysis shown by the editor.
+             *
+             * @param[in]   position the new position.
+             */
+            auto setViewportPosition(double position) -> void;
+
+            /**
+             * @brief       Sets the viewport size of every analysis shown by the editor.
+             *
+             * @param[in]   size the new size.
+             */
+            auto setViewportSize(double size) -> void;
+
             /**
              * @brief       Called when one of the latency values has been changed.
              *
@@ -216,6 +361,45 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             void onLatencyValueChanged(LatencyRibbonGroup::LatencyType type, double value);
 
+            /**
+             * @brief       Writes the route table or the sample history to the clipboard or a file.
+             *
+             * @param[in]   type the type of the output, one of the table or sample types.
+             * @param[in]   target the target for the output.
+             */
+            auto exportData(
+                Nedrysoft::RouteAnalyser::OutputType type,
+                Nedrysoft::RouteAnalyser::OutputTarget target
+            ) -> void;
+
+            /**
+             * @brief       Draws the route table and/or graphs to an image on the clipboard or in a file.
+             *
+             * @details     The user chooses the width and resolution of the image, a snapshot of the route is then
+             *              drawn on the task pool so that the session continues to update while a large image is
+             *              being drawn.
+             *
+             * @param[in]   type the type of the output, one of the image types.
+             * @param[in]   target the target for the output.
+             */
+            auto exportImage(
+                Nedrysoft::RouteAnalyser::OutputType type,
+                Nedrysoft::RouteAnalyser::OutputTarget target
+            ) -> void;
+
+            /**
+             * @brief       Writes a PDF report of the whole session to the clipboard or a file.
+             *
+             * @details     The report is written by RouteReportWriter on the task pool from a snapshot of the route.
+             *
+             * @param[in]   type the type of the output, one of the PDF types.
+             * @param[in]   target the target for the output.
+             */
+            auto exportReport(
+                Nedrysoft::RouteAnalyser::OutputType type,
+                Nedrysoft::RouteAnalyser::OutputTarget target
+            ) -> void;
+
         protected:
             //! @cond
 
@@ -224,7 +408,17 @@ namespace Nedrysoft { namespace RouteAnalyser {
             QString m_pingTarget;
             Nedrysoft::Core::IPVersion m_ipVersion;
             double m_interval;
+            int m_payloadSize;
+            bool m_dontFragment;
+            bool m_dualStack;
+            bool m_heatmapVisible;
+            Nedrysoft::RouteAnalyser::MemoryGovernor::Retention m_retention;
+            QString m_captureFile;
+            QStringList m_sources;
+            QStringList m_historyFiles;
             Nedrysoft::RouteAnalyser::RouteAnalyserWidget *m_editorWidget;
+            QList<Nedrysoft::RouteAnalyser::RouteAnalyserWidget *> m_editorWidgets;
+            QWidget *m_containerWidget;
             double m_viewportStart;
             double m_viewportEnd;
             QMetaObject::Connection m_dataChangedConnection;
@@ -23,9 +23,17 @@
 
 #include "RouteAnalyserWidget.h"
 
+#include "AlertEngine.h"
 #include "BarChart.h"
+#include "BaselineStore.h"
 #include "CPAxisTickerMS.h"
+#include "FidelityGovernor.h"
+#include "FrameScheduler.h"
 #include "GraphLatencyLayer.h"
+#include "HopTimeSeries.h"
+#include "HopCache.h"
+#include "HopIdentityTable.h"
+#include "HopRoundSeries.h"
 #include "IPingEngine.h"
 #include "IPingEngineFactory.h"
 #include "IPingTarget.h"
@@ -33,47 +41,109 @@
 #include "IPlotFactory.h"
 #include "IRouteEngineFactory.h"
 #include "LatencySettings.h"
+#include "MemoryGovernor.h"
+#include "ModelUpdateScheduler.h"
+#include "OverheadCalibrator.h"
 #include "PlotScrollArea.h"
+#include "PowerProfile.h"
+#include "RecordingStage.h"
+#include "ResultPipeline.h"
 #include "RouteAnalyser.h"
 #include "RouteDiscoveryWidget.h"
+#include "RouteHeatmapWidget.h"
 #include "RouteTableItemDelegate.h"
-
+#include "RouteTableModel.h"
+#include "SeriesGraph.h"
+#include "SessionCapture.h"
+#include "SessionJournal.h"
+#include "SlidingWindowExtrema.h"
+#include "SmokeChart.h"
+
+#include <Clock>
 #include <CoreConstants>
+#include <Diagnostics>
+#include <IASNProvider>
 #include <ICommand>
 #include <ICommandManager>
 #include <IContextManager>
 #include <IGeoIPProvider>
-#include <IHostMasker>
+#include <IHostResolver>
 #include "IHostMaskerManager"
+#include <ObjectRegistry>
+#include <Profiler>
 #include <QDateTime>
 #include <QHostAddress>
-#include <QHostInfo>
+#include <QLabel>
 #include <QTimer>
+#include <algorithm>
 #include <cassert>
 #include <spdlog/spdlog.h>
 
 constexpr auto RoundTripGraph = 0;
+constexpr auto RawBarWidth = 0.75;
+constexpr auto RawLevel = -1;
+constexpr auto RawMergeFactor = 1.5;
+constexpr auto UnboundLevel = -2;
+constexpr auto PlotBindDistance = 1;
+constexpr auto PlotReleaseDistance = 2;
 constexpr auto DefaultMaxLatency = 0.01;
 constexpr auto DefaultTimeWindow = 60.0*10;
 constexpr auto DefaultGraphHeight = 300;
+constexpr auto ExtraPlotHeight = 150;
 constexpr auto TableRowHeight = 20;
+constexpr auto CrosshairLayer = "overlay";
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMillisecond = 1000000.0;
 constexpr auto NoReplyColour = qRgb(255,0,0);
+constexpr auto SmokeColour = qRgb(96,96,96);
+constexpr auto ChangePointColour = qRgb(255,140,0);
 constexpr auto PlotMargins = QMargins(80, 20, 40, 40);
+constexpr auto RouteMonitorInterval = 60;
+constexpr auto SnapshotInterval = 1000/60;
+constexpr auto CaptureLoadInterval = 10;
+constexpr auto CaptureBlocksPerLoad = 8;
+constexpr auto MinimumEscalationTime = 60000;
+constexpr auto EscalationRounds = 10;
+constexpr auto DestinationWarmupSamples = 10;
+constexpr auto DestinationDeviationThreshold = 3.0;
+constexpr auto SilentHopInitialDivisor = 2;
+constexpr auto SilentHopMaximumDivisor = 64;
+constexpr auto MemoryUpdateInterval = 10000;
+constexpr auto HistoryMemorySubsystem = "Hop history";
+constexpr auto PlotMemorySubsystem = "Plot data";
 
 QMap< Nedrysoft::RouteAnalyser::PingData::Fields, QPair<QString, QString> > &Nedrysoft::RouteAnalyser::RouteAnalyserWidget::headerMap() {
     static QMap<Nedrysoft::RouteAnalyser::PingData::Fields, QPair<QString, QString> > map = QMap<Nedrysoft::RouteAnalyser::PingData::Fields, QPair<QString, QString> >
             {
-                    {PingData::Fields::Hop,            {tr("Hop"),      "XXXXX"}},
-                    {PingData::Fields::Count,          {tr("Count"),    "XXXXX"}},
-                    {PingData::Fields::IP,             {tr("IP"),       "888.888.888.888"}},
-                    {PingData::Fields::HostName,       {tr("Name"),     "XXXXXXXXXXX.XXXXXXXXXX.XXXXXXXXX.XXX"}},
-                    {PingData::Fields::Location,       {tr("Location"), "XXXXXXXXXXXXXXXX"}},
-                    {PingData::Fields::AverageLatency, {tr("Avg"),      "8888.888"}},
-                    {PingData::Fields::CurrentLatency, {tr("Cur"),      "8888.888"}},
-                    {PingData::Fields::MinimumLatency, {tr("Min"),      "8888.888"}},
-                    {PingData::Fields::MaximumLatency, {tr("Max"),      "8888.888"}},
-                    {PingData::Fields::PacketLoss,     {tr("Loss %"),   "8888.888"}},
-                    {PingData::Fields::Graph,          {"",             ""}}
+                    {PingData::Fields::Hop,                       {tr("Hop"),       "XXXXX"}},
+                    {PingData::Fields::Count,                     {tr("Count"),     "XXXXX"}},
+                    {PingData::Fields::IP,                        {tr("IP"),        "888.888.888.888"}},
+                    {PingData::Fields::HostName,                  {tr("Name"),      "XXXXXXXXXXX.XXXXXXXXXX.XXXXXXXXX.XXX"}},
+                    {PingData::Fields::Location,                  {tr("Location"),  "XXXXXXXXXXXXXXXX"}},
+                    {PingData::Fields::AutonomousSystem,          {tr("AS"),        "AS888888 XXXXXXXXXXXX"}},
+                    {PingData::Fields::AverageLatency,            {tr("Avg"),       "8888.888"}},
+                    {PingData::Fields::CurrentLatency,            {tr("Cur"),       "8888.888"}},
+                    {PingData::Fields::MinimumLatency,            {tr("Min"),       "8888.888"}},
+                    {PingData::Fields::MaximumLatency,            {tr("Max"),       "8888.888"}},
+                    {PingData::Fields::PacketLoss,                {tr("Loss %"),    "8888.888"}},
+                    {PingData::Fields::RecentPacketLoss,          {tr("Recent %"),  "8888.888"}},
+                    {PingData::Fields::LossEpisodes,              {tr("Episodes"),  "XXXXX"}},
+                    {PingData::Fields::MedianLatency,             {tr("P50"),       "8888.888"}},
+                    {PingData::Fields::P95Latency,                {tr("P95"),       "8888.888"}},
+                    {PingData::Fields::P99Latency,                {tr("P99"),       "8888.888"}},
+                    {PingData::Fields::StandardDeviation,         {tr("StdDev"),    "8888.888"}},
+                    {PingData::Fields::Jitter,                    {tr("Jitter"),    "8888.888"}},
+                    {PingData::Fields::InterPacketDelayVariation, {tr("IPDV"),      "8888.888"}},
+                    {PingData::Fields::PacketDelayVariation,      {tr("PDV P95"),   "8888.888"}},
+                    {PingData::Fields::BaselineLatency,           {tr("Usual"),     "8888.888"}},
+                    {PingData::Fields::BaselineDeviation,         {tr("vs Usual"),  "+8888.888"}},
+                    {PingData::Fields::ForwardDelay,              {tr("Fwd"),       "+8888.888"}},
+                    {PingData::Fields::ReverseDelay,              {tr("Rev"),       "+8888.888"}},
+                    {PingData::Fields::ForwardJitter,             {tr("Fwd Jitter"), "8888.888"}},
+                    {PingData::Fields::ReverseJitter,             {tr("Rev Jitter"), "8888.888"}},
+                    {PingData::Fields::AddedLatency,              {tr("+Latency"),  "+8888.888"}},
+                    {PingData::Fields::AddedLoss,                 {tr("+Loss %"),   "8888.888 (ICMP only)"}},
+                    {PingData::Fields::Graph,                     {"",              ""}}
             };
 
     return map;
@@ -84,6 +154,9 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
         Nedrysoft::Core::IPVersion ipVersion,
         int interval,
         Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+        int payloadSize,
+        bool dontFragment,
+        const QString &source,
         QWidget *parent) :
 
             QWidget(parent),
@@ -93,26 +166,79 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
             m_viewportPosition(1),
             m_startPoint(-1),
             m_endPoint(0),
+            m_visibleStart(0),
+            m_visibleEnd(0),
             m_interval(1000),
-            m_routeDiscoveryWidget(new Nedrysoft::RouteAnalyser::RouteDiscoveryWidget) {
+            m_payloadSize(payloadSize),
+            m_dontFragment(dontFragment),
+            m_source(source),
+            m_aligned(false),
+            m_ipVersion(ipVersion),
+            m_datasetChanged(false),
+            m_statisticsWorker(new Nedrysoft::RouteAnalyser::StatisticsWorker),
+            m_resultPipeline(new Nedrysoft::RouteAnalyser::ResultPipeline),
+            m_recordingStage(new Nedrysoft::RouteAnalyser::RecordingStage),
+            m_targetHost(targetHost),
+            m_captureWriter(nullptr),
+            m_captureReader(nullptr),
+            m_journal(nullptr),
+            m_captureTimer(nullptr),
+            m_captureBlock(0),
+            m_captureEndBlock(0),
+            m_captureStart(0),
+            m_captureEnd(-1),
+            m_routeDiscoveryWidget(new Nedrysoft::RouteAnalyser::RouteDiscoveryWidget),
+            m_heatmap(new Nedrysoft::RouteAnalyser::RouteHeatmapWidget),
+            m_heatmapVisible(false),
+            m_overheadWarningLabel(new QLabel),
+            m_escalationTimer(nullptr),
+            m_memoryTimer(nullptr),
+            m_historyMemory(HistoryMemorySubsystem),
+            m_plotMemory(PlotMemorySubsystem),
+            m_escalated(false),
+            m_intermediateHopDivisor(1),
+            m_probesPerRound(1),
+            m_renderingSuspended(false),
+            m_rebuildPlots(false),
+            m_viewsReleased(false) {
 
     auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
 
     assert(latencySettings!=nullptr);
 
+    auto resultSinks = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IResultSink>();
+
+    for (auto resultSink : resultSinks) {
+        m_resultSinks.append(resultSink);
+    }
+
+    /**
+     * results from the engines go through the pipeline, the statistics and the recording each consume them on the
+     * task pool at their own pace, the result sinks are given the aggregates by the statistics as they change.
+     */
+
+    m_statisticsWorker->setResultSinks(targetName(), resultSinks);
+
+    m_resultPipeline->addStage(m_statisticsWorker);
+    m_resultPipeline->addStage(m_recordingStage);
+
     auto routeEngines = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IRouteEngineFactory>();
 
-    if (routeEngines.empty()) {
+    if ((pingEngineFactory) && (routeEngines.empty())) {
         return;
     }
 
+    /**
+     * a widget without a ping engine factory shows a session capture (see openCapture), no route is discovered.
+     */
+
     QMultiMap<double, Nedrysoft::RouteAnalyser::IRouteEngineFactory *> sortedRouteEngines;
 
     for(auto routeEngine : routeEngines) {
         sortedRouteEngines.insert(1-routeEngine->priority(), routeEngine);
     }
 
-    auto routeEngine = sortedRouteEngines.first()->createEngine();
+    auto routeEngine = pingEngineFactory ? sortedRouteEngines.first()->createEngine() : nullptr;
 
     if (routeEngine) {
         connect(
@@ -122,6 +248,19 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
             &RouteAnalyserWidget::onRouteResult
         );
 
+        connect(
+            routeEngine,
+            &Nedrysoft::RouteAnalyser::IRouteEngine::routeChanged,
+            this,
+            &RouteAnalyserWidget::onRouteChanged
+        );
+
+        routeEngine->setRouteMonitoring(RouteMonitorInterval);
+
+        if (!source.isEmpty()) {
+            routeEngine->setSource(source);
+        }
+
         m_routeDiscoveryWidget->setTarget(targetHost);
 
         routeEngine->findRoute(pingEngineFactory, targetHost, ipVersion);
@@ -133,6 +272,19 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
 #pragma message("Handle gradiant changed, update anything that uses the graient fills.")
     });
 
+    connect(
+        latencySettings,
+        &Nedrysoft::RouteAnalyser::LatencySettings::hardwareAccelerationChanged,
+        this,
+        [=](bool useHardwareAcceleration) {
+            for (auto plot : m_plotList+m_plotPool) {
+                plot->setOpenGl(useHardwareAcceleration);
+
+                Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->replot(plot);
+            }
+        }
+    );
+
     connect(this, &QObject::destroyed, m_routeGraphDelegate, [this](QObject *) {
         delete m_routeGraphDelegate;
     });
@@ -140,6 +292,34 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
     m_pingEngineFactory = pingEngineFactory;
     m_interval = interval;
 
+    /**
+     * the memory governor may move the oldest samples of the hops out of memory at any time, the plots then drop the
+     * same samples exactly as they do when a series discards its oldest sample.
+     */
+
+    Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance()->addOwner(
+        this,
+        m_interval,
+        [=]() {
+            QVector<Nedrysoft::RouteAnalyser::HopTimeSeries *> seriesList;
+
+            for (auto pingData : m_pingData) {
+                if (pingData->timeSeries()) {
+                    seriesList.append(pingData->timeSeries());
+                }
+            }
+
+            return seriesList;
+        },
+        [=]() {
+            for (auto pingData : m_pingData) {
+                if ((pingData->timeSeries()) && (pingData->timeSeries()->count())) {
+                    trimHistory(pingData);
+                }
+            }
+        }
+    );
+
     m_scrollArea = new PlotScrollArea();
 
     m_splitter = new QSplitter(Qt::Vertical);
@@ -149,19 +329,58 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
     m_scrollArea->setWidget(new QWidget());
     m_scrollArea->widget()->setBackgroundRole(QPalette::Base);
 
+    /**
+     * a plot that is scrolled into view already holds its rendered buffer, only plots that missed a replot while
+     * they were hidden need to be drawn again.
+     */
+
+    m_scrollArea->viewport()->installEventFilter(this);
+
     connect(m_scrollArea, &PlotScrollArea::didScroll, [=](void) {
-        for (auto plot : m_plotList) {
-            if (plot->isVisible()) {
-                if (!plot->visibleRegion().isEmpty()) {
-                    plot->replot();
-                }
+        updateBoundPlots();
+
+        auto pausedPlotShown = false;
+
+        for (auto plot : m_stalePlots.values()) {
+            if ((plot->isVisible()) && (!plot->visibleRegion().isEmpty())) {
+                m_stalePlots.remove(plot);
+
+                pausedPlotShown |= m_pausedPlots.contains(plot);
+
+                Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->replot(plot);
             }
         }
+
+        // a plot that was paused while out of view has not been rebuilt, so the ranges are updated to build it.
+
+        if (pausedPlotShown) {
+            Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->post(this, [this]() {
+                updateRanges();
+            });
+        }
     });
 
-    m_tableModel = new QStandardItemModel();
+    /**
+     * when the drawing quality changes the backgrounds are drawn again and the plots are rebuilt at the new
+     * decimation, the plots that were paused while out of view are built once they are scrolled back in.
+     */
+
+    connect(
+        Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance(),
+        &Nedrysoft::RouteAnalyser::FidelityGovernor::levelChanged,
+        this,
+        [=]() {
+            setGradientEnabled(Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->gradientsEnabled());
+
+            m_rebuildPlots = true;
+
+            Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->post(this, [this]() {
+                updateRanges();
+            });
+        }
+    );
 
-    m_tableModel->setColumnCount(headerMap().count());
+    m_tableModel = new Nedrysoft::RouteAnalyser::RouteTableModel(headerMap().count());
 
     m_tableView = new QTableView();
 
@@ -180,12 +399,8 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
     while (headerIterator.hasNext()) {
         headerIterator.next();
 
-        auto headerItem = new QStandardItem();
-
         auto pair = headerIterator.value();
 
-        headerItem->setText(pair.first);
-
 #if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
         auto maxWidth = qMax(
                 m_tableView->fontMetrics().boundingRect(pair.first).width(),
@@ -197,7 +412,7 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
         );
 #endif
 
-        m_tableModel->setHorizontalHeaderItem(static_cast<int>(headerIterator.key()), headerItem);
+        m_tableModel->setHeaderData(static_cast<int>(headerIterator.key()), Qt::Horizontal, pair.first);
 
         m_tableView->horizontalHeader()->resizeSection(static_cast<int>(headerIterator.key()), maxWidth);
     }
@@ -206,10 +421,14 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
 
     m_splitter->addWidget(m_tableView);
     m_splitter->addWidget(m_scrollArea);
+    m_splitter->addWidget(m_heatmap);
     m_splitter->addWidget(m_routeDiscoveryWidget);
 
     m_routeDiscoveryWidget->setVisible(true);
     m_scrollArea->setVisible(false);
+    m_heatmap->setVisible(false);
+
+    m_heatmap->setColumnInterval(m_interval/1000.0);
 
     m_splitter->setStretchFactor(1, 2);
 
@@ -220,531 +439,899 @@ Nedrysoft::RouteAnalyser::RouteAnalyserWidget::RouteAnalyserWidget(
 #else
     verticalLayout->setMargin(0);
 #endif
+    m_overheadWarningLabel->setVisible(false);
+    m_overheadWarningLabel->setWordWrap(true);
+    m_overheadWarningLabel->setContentsMargins(4, 4, 4, 4);
+
+    if (!source.isEmpty()) {
+        auto sourceLabel = new QLabel(tr("via %1").arg(source));
+
+        sourceLabel->setContentsMargins(4, 4, 4, 4);
+
+        verticalLayout->addWidget(sourceLabel);
+    }
+
+    verticalLayout->addWidget(m_overheadWarningLabel);
     verticalLayout->addWidget(m_splitter);
 
     this->setLayout(verticalLayout);
 
+    connect(
+        Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance(),
+        &Nedrysoft::RouteAnalyser::OverheadCalibrator::estimateChanged,
+        this,
+        [=]() {
+            updateOverheadWarning();
+        }
+    );
+
+    auto powerProfile = Nedrysoft::RouteAnalyser::PowerProfile::getInstance();
+
     m_layerCleanupTimer = new QTimer();
 
-    m_layerCleanupTimer->setInterval(1000);
+    powerProfile->manage(m_layerCleanupTimer, 1000);
 
     connect(m_layerCleanupTimer, &QTimer::timeout, [=]() {
         GraphLatencyLayer::removeUnused();
     });
 
     m_layerCleanupTimer->start();
-}
 
-Nedrysoft::RouteAnalyser::RouteAnalyserWidget::~RouteAnalyserWidget() {
-    if (m_tableView) {
-        delete m_tableView;
-    }
+    // the memory used by the editor is measured rather than tracked, the figures only need to show a trend.
 
-    if (m_tableModel) {
-        delete m_tableModel;
-    }
+    m_historyMemory.setOwner(targetName());
+    m_plotMemory.setOwner(targetName());
 
-    if (m_layerCleanupTimer) {
-        delete m_layerCleanupTimer;
-    }
-}
+    m_memoryTimer = new QTimer();
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onPingResult(Nedrysoft::RouteAnalyser::PingResult result) -> void {
-    auto pingData = static_cast<PingData *>(result.target()->userData());
+    powerProfile->manage(m_memoryTimer, MemoryUpdateInterval);
 
-    static QMap<Nedrysoft::RouteAnalyser::PingData::Fields, PingData *> m_maximumMap;
+    connect(m_memoryTimer, &QTimer::timeout, [=]() {
+        updateMemoryUsage();
+    });
 
-    if (!pingData) {
-        return;
-    }
+    m_memoryTimer->start();
 
-    auto customPlot = pingData->customPlot();
+    /**
+     * the hops before the destination may be probed less often than the destination, they return to the full rate
+     * for a while whenever the destination shows trouble so that the hop responsible is captured in detail.
+     */
 
-    if (!customPlot) {
-        return;
-    }
+    m_intermediateHopDivisor = latencySettings->intermediateHopDivisor();
 
-    switch (result.code()) {
-        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok:
-        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded: {
-            QCPRange graphRange = customPlot->yAxis->range();
-            auto requestTime = static_cast<double>(result.requestTime().toSecsSinceEpoch());
+    m_escalationTimer = new QTimer();
 
-            customPlot->graph(RoundTripGraph)->addData(requestTime, result.roundTripTime());
+    m_escalationTimer->setSingleShot(true);
+    m_escalationTimer->setInterval(qMax(MinimumEscalationTime, m_interval*EscalationRounds));
 
-            if (m_startPoint == -1) {
-                m_startPoint = requestTime;
-            } else {
-                if (requestTime < m_startPoint) {
-                    m_startPoint = requestTime;
-                }
-            }
+    connect(m_escalationTimer, &QTimer::timeout, [=]() {
+        m_escalated = false;
 
-            if (requestTime > m_endPoint) {
-                m_endPoint = requestTime;
-            }
+        updateSamplingDivisors();
+    });
 
-            updateRanges();
+    /**
+     * with several probes per round the graph shows the median of each round and the spread of the round is drawn
+     * as smoke around it, the number of probes is fixed for the lifetime of the editor.
+     */
 
-            Q_EMIT datasetChanged(m_startPoint, m_endPoint);
+    m_probesPerRound = latencySettings->probesPerRound();
 
-            pingData->updateItem(result);
+    connect(
+        latencySettings,
+        &Nedrysoft::RouteAnalyser::LatencySettings::intermediateHopDivisorChanged,
+        this,
+        [=](int divisor) {
+            m_intermediateHopDivisor = divisor;
 
-            switch(m_graphScaleMode) {
-                case ScaleMode::None: {
-                    if (result.roundTripTime()> graphRange.upper) {
-                        customPlot->yAxis->setRange(0, result.roundTripTime());
-                    }
+            updateSamplingDivisors();
+        }
+    );
 
-                    break;
-                }
+    /**
+     * the hop statistics are maintained by the statistics worker, the table and plots are updated from its
+     * snapshots at the display refresh rate rather than as each result arrives.
+     */
 
-                case ScaleMode::Normalised:  {
-                    auto graphMaxLatency = m_tableView->property("graphMaxLatency").toDouble();
+    auto snapshotTimer = new QTimer(this);
 
-                    if (graphMaxLatency>graphRange.upper) {
-                        for (QCustomPlot *currentPlot : m_plotList) {
-                            currentPlot->yAxis->setRange(0, graphMaxLatency);
-                        }
-                    }
+    powerProfile->manage(snapshotTimer, SnapshotInterval);
 
-                    break;
-                }
+    connect(snapshotTimer, &QTimer::timeout, [=]() {
+        applySnapshots();
+    });
 
-                case ScaleMode::Fixed: {
-                    // TODO: Fixed scaling, user sets the max value.
-                    break;
-                }
-            }
+    snapshotTimer->start();
+
+    /**
+     * the AS data may finish loading (or be replaced) after the route is discovered, the hops are annotated
+     * again when it does.
+     */
 
-            auto fields = QList<PingData::Fields>() <<
-                PingData::Fields::MinimumLatency <<
-                PingData::Fields::MaximumLatency <<
-                PingData::Fields::AverageLatency <<
-                PingData::Fields::CurrentLatency;
+    auto asnProvider = Nedrysoft::Core::IASNProvider::getInstance();
 
+    if (asnProvider) {
+        connect(asnProvider, &Nedrysoft::Core::IASNProvider::databaseChanged, this, [=]() {
+            for (auto pingData : m_pingData) {
+                if (pingData->hopValid()) {
+                    setHopAutonomousSystem(pingData);
+                }
+            }
+        });
+    }
+}
 
-            for (auto field : fields) {
-                if (m_maximumMap.contains(field)) {
-                    auto currentMax = m_maximumMap[field];
+Nedrysoft::RouteAnalyser::RouteAnalyserWidget::~RouteAnalyserWidget() {
+    Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance()->removeOwner(this);
 
-                    if (pingData->latency(static_cast<int>(field)) >
-                        currentMax->latency(static_cast<int>(field)) ) {
-                        currentMax->setMaximum(field, false);
+    for (auto subscription : m_hopSubscriptions) {
+        Nedrysoft::RouteAnalyser::HopCache::getInstance()->unsubscribe(subscription);
+    }
 
-                        m_maximumMap[field] = pingData;
+    /**
+     * the stages are stopped first, once they have finished nothing is written to the sinks, capture or journal.
+     */
 
-                        pingData->setMaximum(field, true);
-                    }
-                } else {
-                    m_maximumMap[field] = pingData;
+    delete m_resultPipeline;
+    delete m_statisticsWorker;
+    delete m_recordingStage;
 
-                    pingData->setMaximum(field, true);
-                }
+    if (!m_captureReader) {
+        for (auto &resultSink : m_resultSinks) {
+            if (resultSink) {
+                resultSink->removeTarget(targetName());
             }
+        }
 
-            m_tableView->viewport()->update();
+        Nedrysoft::RouteAnalyser::AlertEngine::getInstance()->removeTarget(targetName());
+    }
 
-            break;
-        }
+    delete m_captureWriter;
+    delete m_captureReader;
+    delete m_journal;
 
-        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply: {
-            auto requestTime = static_cast<double>(result.requestTime().toSecsSinceEpoch());
+    if (m_tableView) {
+        delete m_tableView;
+    }
 
-            QCPBars *barChart = m_barCharts[customPlot];
+    if (m_tableModel) {
+        delete m_tableModel;
+    }
 
-            barChart->addData(requestTime, 1);
+    if (m_layerCleanupTimer) {
+        delete m_layerCleanupTimer;
+    }
 
-            pingData->updateItem(result);
+    if (m_escalationTimer) {
+        delete m_escalationTimer;
+    }
 
-            break;
-        }
+    if (m_memoryTimer) {
+        delete m_memoryTimer;
     }
 }
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onRouteResult(
-        const QHostAddress routeHostAddress,
-        const Nedrysoft::RouteAnalyser::RouteList route,
-        const bool completed,
-        const int totalHops,
-        const int maximumHops ) -> void {
-
-    Nedrysoft::RouteAnalyser::IRouteEngine *routeEngine =
-        qobject_cast<Nedrysoft::RouteAnalyser::IRouteEngine *>(this->sender());
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateDataset() -> void {
+    updateRanges();
 
-    auto hop = 1;
-    auto geoIP = Nedrysoft::ComponentSystem::getObject<Nedrysoft::Core::IGeoIPProvider>();
+    Q_EMIT datasetChanged(m_startPoint, m_endPoint);
 
-    SPDLOG_TRACE("Got route result");
+    Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->update(m_tableView->viewport());
+}
 
-    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::processPingResult(
+        const Nedrysoft::RouteAnalyser::PingResult &result,
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> bool {
 
-    assert(latencySettings!=nullptr);
+    PINGNOO_PROFILE_ZONE("Process ping result");
 
-    if ((completed) && (routeEngine)) {
-        disconnect(
-            routeEngine,
-            &Nedrysoft::RouteAnalyser::IRouteEngine::result,
-            this,
-            &RouteAnalyserWidget::onRouteResult
-        );
+    if (!pingData) {
+        return false;
     }
 
-    if (!m_pingEngineFactory) {
-        return;
-    }
+    auto customPlot = pingData->customPlot();
 
-    if (!completed) {
-        for (int hop=m_tableModel->rowCount();hop<route.count();hop++) {
-            auto host = route.at(hop);
+    /**
+     * the time series is the record of the hop, the plot is only allowed to hold the samples that are still in the
+     * series, so when the series discards its oldest sample the plot data before it is discarded too.  The series
+     * is updated whether or not a plot is currently bound to the hop.
+     */
 
-            auto hostAddress = host.toString();
-            auto hostName = QHostInfo::fromName(host.toString()).hostName();
+    auto timeSeries = pingData->timeSeries();
+    auto trimmed = false;
 
-            auto maskedHostName = hostName;
-            auto maskedHostAddress = hostAddress;
+    if (timeSeries) {
+        auto requestTime = static_cast<double>(result.requestTimestamp() / NanosecondsInSecond);
 
-            auto pingData = new Nedrysoft::RouteAnalyser::PingData(m_tableModel, hop+1, !host.isNull());
+        if (timeSeries->append(requestTime, result.roundTripTime(), result.code())) {
+            trimHistory(pingData);
 
-            m_pingData.append(pingData);
+            trimmed = true;
+        }
+    }
 
-            for (auto masker : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::Core::IHostMasker>()) {
-                masker->mask(hop, hostName, hostAddress, maskedHostName, maskedHostAddress);
-            }
+    auto replied = ((result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) ||
+                    (result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded));
 
-            auto tableItem = new QStandardItem(1, headerMap().count());
+    auto roundSeries = (m_probesPerRound>1) ? pingData->roundSeries() : nullptr;
+    auto roundCompleted = false;
 
-            tableItem->setData(QVariant::fromValue<Nedrysoft::RouteAnalyser::PingData *>(pingData));
+    if (roundSeries) {
+        roundCompleted = roundSeries->add(
+            result.sampleNumber(),
+            static_cast<double>(result.requestTimestamp() / NanosecondsInSecond),
+            result.roundTripTime(),
+            !replied );
+    }
 
-            if (host.isNull()) {
-                pingData->setHostAddress("*");
-                pingData->setHostName("*");
-                pingData->setMaskedHostAddress("*");
-                pingData->setMaskedHostName("*");
-            } else {
-                pingData->setHostName(hostName);
-                pingData->setHostAddress(hostAddress);
-                pingData->setMaskedHostName(maskedHostName);
-                pingData->setMaskedHostAddress(maskedHostAddress);
-            }
+    if (replied) {
+        auto requestTime = static_cast<double>(result.requestTimestamp() / NanosecondsInSecond);
 
-            if (geoIP) {
-                geoIP->lookup(hostAddress, [pingData](const QString &, const QVariantMap &result) mutable {
-                    pingData->setLocation(result["country"].toString());
-                });
+        if (m_startPoint == -1) {
+            m_startPoint = requestTime;
+        } else {
+            if (requestTime < m_startPoint) {
+                m_startPoint = requestTime;
             }
-
-            m_tableModel->appendRow(tableItem);
-
-            m_tableView->setRowHeight(tableItem->index().row(), TableRowHeight);
-
-            connect(m_tableView, &QObject::destroyed, [pingData](QObject *) {
-                delete pingData;
-            });
         }
 
-        m_routeDiscoveryWidget->setProgress(m_tableModel->rowCount(), totalHops, maximumHops);
-        m_routeDiscoveryWidget->update();
+        if (requestTime > m_endPoint) {
+            m_endPoint = requestTime;
+        }
 
-        return;
+        if (pingData->latencyWindow()) {
+            pingData->latencyWindow()->add(requestTime, result.roundTripTime());
+        }
     }
 
-    if (routeHostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
-        m_pingEngine = m_pingEngineFactory->createEngine(Nedrysoft::Core::IPVersion::V4);
-    } else if (routeHostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
-        m_pingEngine = m_pingEngineFactory->createEngine(Nedrysoft::Core::IPVersion::V6);
-    } else {
-        return;
+    // while drawing is suspended the plot is rebuilt from the series when it resumes.
+
+    if ((!customPlot) || (m_renderingSuspended)) {
+        return (replied || trimmed || roundCompleted);
     }
 
-    m_pingEngine->setInterval(m_interval);
+    /**
+     * while the plot shows a rollup resolution its data is rebuilt from the series when the ranges are updated.
+     */
 
-    connect(
-        m_pingEngine,
-        &Nedrysoft::RouteAnalyser::IPingEngine::result,
-        this,
-        &RouteAnalyserWidget::onPingResult
-    );
+    auto plotRaw = (m_plotLevels.value(customPlot, RawLevel)==RawLevel);
 
-    auto verticalLayout = new QVBoxLayout();
+    // in multi-probe mode the graph is drawn from the median of each round rather than from every sample.
 
-    //for (const QHostAddress &host : route) {
-    for (auto hop=1;hop<=route.count();hop++) {
-        auto host = route.at(hop-1);
+    if ((roundCompleted) && (plotRaw)) {
+        auto &round = roundSeries->round(roundSeries->count()-1);
 
-        if (host.isNull()) {
-            continue;
+        if (round.replies) {
+            customPlot->graph(RoundTripGraph)->addData(round.time, round.median());
         }
+    }
 
-        auto hostAddress = host.toString();
-        auto hostName = QHostInfo::fromName(host.toString()).hostName();
-
-        auto maskedHostName = hostName;
-        auto maskedHostAddress = hostAddress;
+    switch (result.code()) {
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok:
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded: {
+            // at the raw resolution the graph draws from the time series, so the new sample is already visible.
 
-        for (auto masker : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::Core::IHostMasker>()) {
-            masker->mask(hop, hostName, hostAddress, maskedHostName, maskedHostAddress);
-        }
+            if (plotRaw) {
+                if (m_barCharts.contains(customPlot)) {
+                    m_barCharts[customPlot]->endSpan();
+                }
+            }
 
-        auto customPlot = new QCustomPlot();
+            // the latency axes are scaled once per update from the sliding windows of the hops, see updateRanges.
 
-        customPlot->addLayer("newBackground", customPlot->layer("grid"), QCustomPlot::limBelow);
+            return true;
+        }
 
-        auto latencyLayer = new GraphLatencyLayer(customPlot);
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply:
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable:
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited: {
+            auto requestTime = static_cast<double>(result.requestTimestamp() / NanosecondsInSecond);
 
-        m_backgroundLayers.append(latencyLayer);
+            auto barChart = m_barCharts.value(customPlot, nullptr);
 
-        connect(
-            latencySettings,
-            &Nedrysoft::RouteAnalyser::LatencySettings::gradientChanged,
-            [=](bool /*useGradient*/) {
-                latencyLayer->invalidate();
+            if ((plotRaw) && (barChart)) {
+                barChart->addLoss(requestTime);
             }
-        );
 
-        customPlot->setCurrentLayer("main");
-
-        customPlot->setMinimumHeight(DefaultGraphHeight);
+            break;
+        }
+    }
 
-        customPlot->addGraph();
+    return (trimmed || roundCompleted);
+}
 
-        // the timeout bar chart uses axis 2 which is a unit axis.  This means it will always draw to the top
-        // of the axis independently of the main axis which may scale up/down depending on latency.
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::applySnapshots() -> void {
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Apply hop statistics (ms)");
 
-        customPlot->yAxis2->setRange(0,1);
-        customPlot->yAxis2->setVisible(true);
+    auto snapshots = m_statisticsWorker->takeSnapshots();
+    auto hourOfWeek = Nedrysoft::RouteAnalyser::HopBaseline::hourOfWeek(
+            Nedrysoft::Core::Clock::getInstance()->currentDateTime() );
 
-        auto barChart = new BarChart(customPlot->xAxis, customPlot->yAxis2);
+    for (auto snapshot=snapshots.begin();snapshot!=snapshots.end();snapshot++) {
+        if ((snapshot.key()<0) || (snapshot.key()>=m_pingData.count())) {
+            continue;
+        }
 
-        barChart->setWidthType(QCPBars::wtPlotCoords);
-        barChart->setBrush(QColor(NoReplyColour));
-        barChart->setPen(QPen(QColor(NoReplyColour)));
+        auto pingData = m_pingData.at(snapshot.key());
 
-        m_barCharts[customPlot] = barChart;
+        pingData->setStatistics(snapshot->statistics, snapshot->results);
 
-        customPlot->yAxis->ticker()->setTickCount(1);
+        if (updateChangePointMarkers(pingData)) {
+            m_datasetChanged = true;
+        }
 
-        QSharedPointer<CPAxisTickerMS> msTicker(new CPAxisTickerMS);
+        if (!m_captureReader) {
+            pingData->updateBaseline(hourOfWeek, snapshot->results);
 
-        customPlot->yAxis->setTicker(msTicker);
-        customPlot->yAxis->setLabel(tr("Latency (ms)"));
-        customPlot->yAxis->setRange(0, DefaultMaxLatency);
+            Nedrysoft::RouteAnalyser::AlertEngine::getInstance()->evaluate(
+                targetName(),
+                snapshot.key()+1,
+                snapshot.key()==m_pingData.count()-1,
+                snapshot->statistics,
+                snapshot->results );
+        }
 
-        QSharedPointer<QCPAxisTickerDateTime> dateTicker(new QCPAxisTickerDateTime);
+        for (auto &result : snapshot->results) {
+            if (processPingResult(result, pingData)) {
+                m_datasetChanged = true;
+            }
 
-        auto locale = QLocale::system();
+            m_heatmap->addResult(
+                snapshot.key(),
+                static_cast<double>(result.requestTimestamp())/NanosecondsInSecond,
+                result.roundTripTime(),
+                (result.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) &&
+                (result.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded) );
+        }
+    }
 
-        dateTicker->setDateTimeFormat(
-            locale.timeFormat(QLocale::LongFormat).remove("t").trimmed() +
-            "\n" +
-            locale.dateFormat(QLocale::ShortFormat)
-        );
+    if (!snapshots.isEmpty()) {
+        m_tableModel->updateMaximums();
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
-        auto secondsSinceEpoch = QDateTime::currentSecsSinceEpoch();
-#else
-        auto secondsSinceEpoch = abs(QDateTime::currentDateTime().secsTo(QDateTime(QDate(1970,1,1), QTime(0, 0))));
-#endif
+        updateAttribution();
+    }
 
-        customPlot->xAxis->setTicker(dateTicker);
-        customPlot->xAxis->setRange(
-            static_cast<double>(secondsSinceEpoch),
-            static_cast<double>(secondsSinceEpoch + m_viewportSize)
-        );
+    if ((!snapshots.isEmpty()) && (!m_captureReader)) {
+        Nedrysoft::RouteAnalyser::BaselineStore::getInstance()->setChanged();
+    }
 
-        customPlot->graph(RoundTripGraph)->setLineStyle(QCPGraph::lsStepCenter);
+    if (m_renderingSuspended) {
+        return;
+    }
 
-        customPlot->setBackground(this->palette().brush(QPalette::Base));
-        customPlot->xAxis->setLabelColor(this->palette().color(QPalette::Text));
-        customPlot->yAxis->setLabelColor(this->palette().color(QPalette::Text));
-        customPlot->xAxis->setTickLabelColor(this->palette().color(QPalette::Text));
-        customPlot->yAxis->setTickLabelColor(this->palette().color(QPalette::Text));
+    if (!snapshots.isEmpty()) {
+        Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->update(m_heatmap);
 
-        customPlot->replot();
+        // the extra plots have been given every result of this frame, so each may now redraw once.
 
-        /**
-         * scroll wheel events, by default QCustomPlot does not propagate these so this code ensures that they cause
-         * the scroll area to scroll.
-         */
+        for (auto plot : m_extraPlots) {
+            plot->frameReady();
+        }
+    }
 
-        connect(customPlot, &QCustomPlot::mouseWheel, [this](QWheelEvent *event) {
-            m_scrollArea->verticalScrollBar()->setValue(
-                m_scrollArea->verticalScrollBar()->value() - event->angleDelta().y()
-            );
-        });
+    // the ranges, signal and repaint are only needed once for all of the snapshots.
 
-        /**
-         *  mouse over event
-         */
+    if (m_datasetChanged) {
+        m_datasetChanged = false;
 
-        auto graphLine = new QCPItemStraightLine(customPlot);
+        updateDataset();
+    }
+}
 
-        graphLine->setPen(QPen(Qt::darkGray, 2, Qt::DotLine));
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::rebuildPlotData(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        int level,
+        double min,
+        double max ) -> void {
 
-        m_graphLines[customPlot] = graphLine;
+    auto customPlot = pingData->customPlot();
 
-        connect(
-            customPlot,
-            &QCustomPlot::mouseMove,
-            [this, customPlot, graphLine, maskedHostName](QMouseEvent *event) {
-                auto x = customPlot->xAxis->pixelToCoord(event->pos().x());
-                auto foundRange = false;
+    if (!customPlot) {
+        return;
+    }
 
-                auto data = customPlot->graph(RoundTripGraph)->data();
+    auto timeSeries = pingData->timeSeries();
+    auto graphData = QVector<QCPGraphData>();
+    auto barChart = m_barCharts.value(customPlot, nullptr);
+    auto decimationFactor = Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->decimationFactor();
+    auto columns = std::max(customPlot->axisRect()->width()/decimationFactor, 1);
 
-                if (!data) {
-                    return;
-                }
+    assert(barChart!=nullptr);
 
-                auto dataRange = data->keyRange(foundRange);
+    /**
+     * the losses are merged into spans as they are added, consecutive losses (or lossy columns) form one span and a
+     * reply (or a column without loss) ends it.
+     */
 
-                graphLine->point1->setCoords(x, 0);
-                graphLine->point2->setCoords(x, 1);
+    barChart->clear();
 
-                customPlot->replot();
+    if (level==RawLevel) {
+        barChart->setWidth(RawBarWidth);
+        barChart->setMergeInterval((m_interval*RawMergeFactor)/1000.0);
 
-                if (( foundRange ) &&
-                    ( x >= dataRange.lower ) &&
-                    ( x <= dataRange.upper )) {
-                    auto valueString = QString();
-                    /*auto valueResultRange = customPlot->graph(RoundTripGraph)->data()->valueRange(
-                            foundRange,
-                            QCP::sdBoth,
-                            QCPRange(x - 1, x +1) );*/
+        auto roundSeries = (m_probesPerRound>1) ? pingData->roundSeries() : nullptr;
 
-                    for (auto currentItem = 0; currentItem < m_tableModel->rowCount(); currentItem++) {
-                        auto pingData = m_tableModel->item(
-                                currentItem,
-                                0
-                        )->data().value<Nedrysoft::RouteAnalyser::PingData *>();
+        // in multi-probe mode the graph shows the round medians from its own data, otherwise it views the series.
 
-                        auto valueRange = QCPRange(x - 1, x + 1);
+        m_seriesGraphs[customPlot]->setSeries(roundSeries ? nullptr : timeSeries);
 
-                        if (pingData->customPlot()) {
-                            auto tempResultRange = pingData->customPlot()->graph(
-                                    RoundTripGraph)->data()->valueRange(foundRange, QCP::sdBoth, valueRange);
+        for (auto index=0;index<timeSeries->count();index++) {
+            auto roundTripTime = timeSeries->roundTripTime(index);
 
-                            pingData->setHistoricalLatency(tempResultRange.upper);
-                        } else {
-                            pingData->setHistoricalLatency(-1);
+            if (roundTripTime>=0) {
+                barChart->endSpan();
+            } else if (Nedrysoft::RouteAnalyser::PingResult::isLost(timeSeries->code(index))) {
+                barChart->addLoss(timeSeries->time(index));
+            }
+        }
 
-                            auto topLeft = m_tableModel->index(0, 0);
-                            auto bottomRight = topLeft.sibling(m_tableModel->rowCount() - 1,
-                                                               m_tableModel->columnCount() - 1);
+        if (roundSeries) {
+            auto firstRound = roundSeries->lowerBound(timeSeries->firstTime());
 
-                            m_tableModel->dataChanged(topLeft, bottomRight);
-                        }
-                    }
+            for (auto index=firstRound;index<roundSeries->count();index++) {
+                auto &round = roundSeries->round(index);
 
-                    this->m_tableModel->setProperty("showHistorical", true);
+                if (round.replies) {
+                    graphData.append(QCPGraphData(round.time, round.median()));
+                }
+            }
+        }
+    } else {
+        /**
+         * each pixel column is drawn as the vertical span from its minimum to its maximum, so spikes remain
+         * visible however many samples share the column.
+         */
 
-                    /*
-                    auto seconds = std::chrono::duration<double>(valueResultRange.upper);
+        m_seriesGraphs[customPlot]->setSeries(nullptr);
 
-                    if (seconds < std::chrono::seconds(1)) {
-                        auto milliseconds =
-                            std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(seconds);
+        barChart->setWidth((max-min)/columns);
+        barChart->setMergeInterval(((max-min)/columns)*RawMergeFactor);
 
-                        valueString = QString(tr("%1ms")).arg(milliseconds.count(), 0, 'f', 2);
-                    } else {
-                        valueString = QString(tr("%1s")).arg(seconds.count(), 0, 'f', 2);
-                    }
+        for (auto &column : timeSeries->decimate(min, max, columns)) {
+            if (column.replied) {
+                graphData.append(QCPGraphData(column.time, column.minimum));
+                graphData.append(QCPGraphData(column.time, column.maximum));
+            }
 
-                    auto dateTime = QDateTime::fromSecsSinceEpoch(static_cast<qint64>(x));
+            if (column.lost) {
+                barChart->addLoss(column.time);
+            } else {
+                barChart->endSpan();
+            }
+        }
+    }
 
-                    m_pointInfoLabel->setText(FontAwesome::richText(QString("[fas fa-stopwatch] %1").arg(valueString)));
-                    m_hopInfoLabel->setText(FontAwesome::richText(QString("[fas fa-project-diagram] %1 %2").arg(tr("hop")).arg(hop)));
-                    m_hostInfoLabel->setText(FontAwesome::richText(QString("[fas fa-server] %1").arg(maskedHostName)));
-                    m_timeInfoLabel->setText(FontAwesome::richText(QString("[far fa-calendar-alt] %1").arg(dateTime.toString())));
-                    */
-                } else {
-                    /*
-                    m_pointInfoLabel->setText("");
-                    m_hopInfoLabel->setText("");
-                    m_hostInfoLabel->setText("");
-                    m_timeInfoLabel->setText("");
-                    */
+    customPlot->graph(RoundTripGraph)->data()->set(graphData, true);
+
+    m_plotLevels[customPlot] = level;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::trimHistory(Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+    auto customPlot = pingData->customPlot();
+    auto firstTime = pingData->timeSeries()->firstTime();
+
+    if (customPlot) {
+        customPlot->graph(RoundTripGraph)->data()->removeBefore(firstTime);
+
+        if (m_barCharts.contains(customPlot)) {
+            m_barCharts[customPlot]->removeBefore(firstTime);
+        }
+    }
+
+    /**
+     * the start of the data set is the oldest sample still held by any hop, for a capture the data set is the
+     * whole capture regardless of which part is loaded.
+     */
+
+    if (m_captureReader) {
+        return;
+    }
+
+    auto startPoint = -1.0;
+
+    for (auto hopData : m_pingData) {
+        auto hopSeries = hopData->timeSeries();
+
+        if ((!hopSeries) || (!hopSeries->count())) {
+            continue;
+        }
+
+        if ((startPoint<0) || (hopSeries->firstTime()<startPoint)) {
+            startPoint = hopSeries->firstTime();
+        }
+    }
+
+    if (startPoint>=0) {
+        m_startPoint = startPoint;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::resetLatencyWindow(
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> void {
+
+    auto latencyWindow = pingData->latencyWindow();
+    auto timeSeries = pingData->timeSeries();
+
+    latencyWindow->clear();
+    latencyWindow->setWindow(m_viewportSize);
+
+    if ((!timeSeries) || (!timeSeries->count())) {
+        return;
+    }
+
+    for (auto index=timeSeries->lowerBound(timeSeries->lastTime()-m_viewportSize);index<timeSeries->count();index++) {
+        auto roundTripTime = timeSeries->roundTripTime(index);
+
+        if (roundTripTime>=0) {
+            latencyWindow->add(timeSeries->time(index), roundTripTime);
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setHopHost(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        const QHostAddress &host ) -> void {
+
+    auto geoIP = Nedrysoft::Core::ObjectRegistry::getInstance()->object<Nedrysoft::Core::IGeoIPProvider>();
+    auto hostResolver = Nedrysoft::Core::IHostResolver::getInstance();
+
+    auto hostAddress = host.toString();
+
+    /**
+     * the baseline is found once per discovered hop, the results of the hop are then added to it directly.  a
+     * replayed capture is not added to the baselines.
+     */
+
+    if ((host.isNull()) || (m_captureReader)) {
+        pingData->setBaseline(nullptr);
+    } else {
+        pingData->setBaseline(Nedrysoft::RouteAnalyser::BaselineStore::getInstance()->baseline(targetName(), host));
+    }
+
+    auto identityTable = Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance();
+    auto identity = identityTable->intern(host);
+
+    pingData->setIdentity(identity);
 
-                    this->m_tableModel->setProperty("showHistorical", false);
+    if (host.isNull()) {
+        return;
+    }
+
+    /**
+     * the identity is shared by every route that passes through the router, so the lookups are only made the
+     * first time that it is seen.  the address is shown as the host name until the reverse lookup completes, a
+     * cached name is used straight away, otherwise the row is updated when the resolver delivers the name.
+     */
+
+    if (!identityTable->identity(identity).autonomousSystemResolved) {
+        setHopAutonomousSystem(pingData);
+    }
+
+    auto hostName = identityTable->identity(identity).hostName;
+
+    if ((hostResolver) && (hostName==hostAddress)) {
+        if ((hostResolver->cachedHostName(host, hostName)) && (hostName!=hostAddress)) {
+            identityTable->setHostName(identity, hostName);
+
+            pingData->updateModel();
+        } else {
+            hostResolver->resolve(host, this, [this, pingData, identity](const QHostAddress &, const QString &name) {
+                Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->setHostName(identity, name);
 
-                    auto topLeft = m_tableModel->index(0, 0);
-                    auto bottomRight = topLeft.sibling(
-                            m_tableModel->rowCount() - 1,
-                            m_tableModel->columnCount() - 1 );
+                /**
+                 * the hop may have been removed or moved to a different router while the lookup was outstanding.
+                 */
 
-                    m_tableModel->dataChanged(topLeft, bottomRight);
+                if ((!m_pingData.contains(pingData)) || (pingData->identity()!=identity)) {
+                    return;
                 }
+
+                pingData->updateModel();
+            });
+        }
+    }
+
+    if ((geoIP) && (identityTable->identity(identity).location.isEmpty())) {
+        geoIP->lookup(hostAddress, [this, pingData, identity](const QString &, const QVariantMap &result) mutable {
+            Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->setLocation(
+                identity,
+                result["country"].toString() );
+
+            // the hop may have left the route while the lookup was outstanding.
+
+            if (m_pingData.contains(pingData)) {
+                pingData->updateModel();
             }
-        );
+        });
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setHopAutonomousSystem(
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> void {
+
+    auto asnProvider = Nedrysoft::Core::IASNProvider::getInstance();
+    auto asNumber = quint32(0);
+    auto owner = QString();
+
+    if (asnProvider) {
+        asnProvider->lookup(pingData->address(), asNumber, owner);
+    }
+
+    Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->setAutonomousSystem(
+        pingData->identity(),
+        asNumber,
+        owner );
+
+    pingData->updateModel();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::appendHop(
+        const QHostAddress &host ) -> Nedrysoft::RouteAnalyser::PingData * {
+
+    auto pingData = insertHop(m_tableModel->rowCount(), host);
+
+    m_heatmap->setHopCount(m_pingData.count());
+
+    return pingData;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::insertHop(
+        int row,
+        const QHostAddress &host ) -> Nedrysoft::RouteAnalyser::PingData * {
+
+    auto pingData = new Nedrysoft::RouteAnalyser::PingData(m_tableModel, row+1, !host.isNull());
+
+    m_pingData.insert(row, pingData);
+
+    // the model owns the hop, it is deleted with the model.
+
+    m_tableModel->insertHop(row, pingData);
+
+    setHopHost(pingData, host);
+
+    m_tableView->setRowHeight(row, TableRowHeight);
+
+    return pingData;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::removeHop(Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+    auto row = m_pingData.indexOf(pingData);
+
+    if (row<0) {
+        return;
+    }
+
+    if (m_hopSubscriptions.contains(pingData)) {
+        Nedrysoft::RouteAnalyser::HopCache::getInstance()->unsubscribe(m_hopSubscriptions.take(pingData));
+    }
+
+    m_silentHops.remove(pingData);
+    m_destinationHops.remove(pingData);
 
-        customPlot->installEventFilter(this);
+    removePlotSlots(pingData);
 
-        m_plotList.append(customPlot);
+    m_pingData.removeAt(row);
 
-        auto plotTitleLabel = new QLabel;
+    m_tableModel->removeHop(row);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onRouteChanged(
+        const QHostAddress routeHostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList previousRoute,
+        const Nedrysoft::RouteAnalyser::RouteList route,
+        const QList<int> changedHops ) -> void {
+
+    Q_UNUSED(previousRoute)
+
+    SPDLOG_INFO(QString("Route to %1 changed at %2 hop(s).")
+            .arg(routeHostAddress.toString())
+            .arg(changedHops.count())
+            .toStdString() );
+
+    /**
+     * the rows are matched to the new route rather than rebuilt, a router that is still on the route keeps its row
+     * (and its statistics and plots) wherever it has moved to.  A position whose router has been replaced, or which
+     * still does not answer, keeps the row that was there as the hop is measured by TTL.
+     */
+
+    auto previousHops = m_pingData;
+    auto hops = QVector<Nedrysoft::RouteAnalyser::PingData *>(route.count(), nullptr);
+    auto keptHops = QSet<Nedrysoft::RouteAnalyser::PingData *>();
+
+    for (auto hop=0;hop<route.count();hop++) {
+        if (route.at(hop).isNull()) {
+            continue;
+        }
+
+        for (auto pingData : previousHops) {
+            if ((!keptHops.contains(pingData)) && (pingData->address()==route.at(hop))) {
+                hops[hop] = pingData;
+
+                keptHops.insert(pingData);
+
+                break;
+            }
+        }
+    }
 
-        QFont labelFont = plotTitleLabel->font();
+    for (auto hop=0;(hop<route.count()) && (hop<previousHops.count());hop++) {
+        if ((hops.at(hop)) || (keptHops.contains(previousHops.at(hop)))) {
+            continue;
+        }
 
-        labelFont.setPointSize(16);
+        hops[hop] = previousHops.at(hop);
 
-        plotTitleLabel->setFont(labelFont);
+        keptHops.insert(previousHops.at(hop));
+    }
 
-        plotTitleLabel->setAlignment(Qt::AlignHCenter);
+    auto previousRows = QVector<int>(route.count(), -1);
 
-        verticalLayout->addWidget(plotTitleLabel);
+    for (auto hop=0;hop<route.count();hop++) {
+        previousRows[hop] = previousHops.indexOf(hops.at(hop));
+    }
 
-        // add any pre-plots.
+    // the hops that have left the route are removed first, so that the hops that remain only have to be moved.
 
-        auto plotFactories = ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPlotFactory>();
+    for (auto row=previousHops.count()-1;row>=0;row--) {
+        if (!keptHops.contains(previousHops.at(row))) {
+            removeHop(previousHops.at(row));
+        }
+    }
 
-        QList<Nedrysoft::RouteAnalyser::IPlot *> plots;
+    for (auto row=0;row<route.count();row++) {
+        if (!hops.at(row)) {
+            hops[row] = insertHop(row, route.at(row));
 
-        for (auto plotFactory : plotFactories) {
-            auto plot = plotFactory->createPlot(PlotMargins);
+            continue;
+        }
 
-            m_extraPlots.append(plot);
+        auto from = m_pingData.indexOf(hops.at(row));
 
-            plots.append(plot);
+        if (from!=row) {
+            m_pingData.move(from, row);
 
-            verticalLayout->addWidget(plot->widget());
+            m_tableModel->moveHop(from, row);
         }
+    }
 
-        customPlot->axisRect()->setAutoMargins(QCP::msNone);
-        customPlot->axisRect()->setMargins(PlotMargins);
+    m_heatmap->moveHops(previousRows);
+    m_statisticsWorker->moveHops(previousRows);
 
-        // add the main plot
+    /**
+     * the monitoring targets probe by TTL, so a hop that has not moved keeps its target and only a hop that is new,
+     * has moved or now answers from a different router is subscribed to the target for its TTL and address.
+     */
 
-        verticalLayout->addWidget(customPlot);
+    auto monitoring = (!m_captureReader) && (!m_routeHostAddress.isNull());
+    auto plotLayout = qobject_cast<QVBoxLayout *>(m_scrollArea->widget()->layout());
 
-        auto pingTarget = m_pingEngine->addTarget(routeHostAddress, hop);
+    for (auto row=0;row<route.count();row++) {
+        auto pingData = m_pingData.at(row);
+        auto host = route.at(row);
+        auto changed = (previousRows.at(row)<0);
 
-        auto pingData = m_pingData.at(hop-1);
+        if (pingData->hop()!=row+1) {
+            pingData->setHop(row+1);
 
-        pingData->setHopValid(true);
-        pingData->setPlots(plots);
-        pingData->setCustomPlot(customPlot);
+            changed = true;
+        }
 
-        pingTarget->setUserData(pingData);
+        if (pingData->address()!=host) {
+            setHopHost(pingData, host);
 
-        if (geoIP) {
-            geoIP->lookup(hostAddress, [pingData](const QString &, const QVariantMap &result) mutable {
-                pingData->setLocation(result["country"].toString());
-            });
+            changed = true;
         }
 
-        auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+        pingData->setHopValid(!host.isNull());
 
-        if (hostMaskerManager) {
-            connect(
-                hostMaskerManager,
-                &Nedrysoft::Core::IHostMaskerManager::maskStateChanged,
-                [pingData, plotTitleLabel](Nedrysoft::Core::HostMaskType type, bool state) {
-                    pingData->updateModel();
-                    plotTitleLabel->setText(pingData->plotTitle());
-            });
+        if ((plotLayout) && (!host.isNull()) && (!m_plotWidgets.contains(pingData))) {
+            createPlotSlots(pingData, plotLayout);
+        }
+
+        if ((changed) && (monitoring)) {
+            subscribeHop(pingData, host);
+        }
+    }
+
+    arrangePlotSlots();
+
+    /**
+     * the hops of a journal segment are fixed by its header, so the journal moves on to a segment for the new route.
+     */
+
+    if (m_journal) {
+        openJournal();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onRouteResult(
+        const QHostAddress routeHostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList route,
+        const bool completed,
+        const int totalHops,
+        const int maximumHops ) -> void {
+
+    Nedrysoft::RouteAnalyser::IRouteEngine *routeEngine =
+        qobject_cast<Nedrysoft::RouteAnalyser::IRouteEngine *>(this->sender());
+
+    auto hop = 1;
+
+    SPDLOG_TRACE("Got route result");
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    assert(latencySettings!=nullptr);
+
+    if ((completed) && (routeEngine)) {
+        disconnect(
+            routeEngine,
+            &Nedrysoft::RouteAnalyser::IRouteEngine::result,
+            this,
+            &RouteAnalyserWidget::onRouteResult
+        );
+    }
+
+    if ((!m_pingEngineFactory) && (!m_captureReader)) {
+        return;
+    }
+
+    if (!completed) {
+        for (int hop=m_tableModel->rowCount();hop<route.count();hop++) {
+            appendHop(route.at(hop));
+        }
+
+        m_routeDiscoveryWidget->setProgress(m_tableModel->rowCount(), totalHops, maximumHops);
+        m_routeDiscoveryWidget->update();
+
+        return;
+    }
+
+    if (routeHostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        m_ipVersion = Nedrysoft::Core::IPVersion::V4;
+    } else if (routeHostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        m_ipVersion = Nedrysoft::Core::IPVersion::V6;
+    } else {
+        return;
+    }
+
+    m_routeHostAddress = routeHostAddress;
+
+    // hops found while the route was being discovered were subscribed before the destination was known.
+
+    for (auto pingData : m_hopSubscriptions.keys()) {
+        if (pingData->address()==m_routeHostAddress) {
+            m_destinationHops.insert(pingData);
+        }
+    }
+
+    updateSamplingDivisors();
+
+    auto verticalLayout = new QVBoxLayout();
+
+    m_plotFactories =
+            Nedrysoft::Core::ObjectRegistry::getInstance()->objects<Nedrysoft::RouteAnalyser::IPlotFactory>();
+
+    //for (const QHostAddress &host : route) {
+    for (auto hop=1;hop<=route.count();hop++) {
+        auto host = route.at(hop-1);
+
+        if (host.isNull()) {
+            if (!m_captureReader) {
+                subscribeHop(m_pingData.at(hop-1), host);
+            }
+
+            continue;
         }
 
-        plotTitleLabel->setText(pingData->plotTitle());
+        auto pingData = m_pingData.at(hop-1);
+
+        pingData->setHopValid(true);
+
+        createPlotSlots(pingData, verticalLayout);
+
+        if (!m_captureReader) {
+            subscribeHop(pingData, host);
+        }
     }
 
     connect(
@@ -782,15 +1369,11 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onRouteResult(
 
                 line->setVisible(event->type() == QEvent::Enter);
 
-                customPlot->replot();
+                Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->replotLayer(line->layer());
 
-                this->m_tableModel->setProperty("showHistorical", false);
+                this->m_tableModel->setShowHistorical(false);
 
-                auto topLeft = m_tableModel->index(0, 0);
-                auto bottomRight = topLeft.sibling(m_tableModel->rowCount() - 1,
-                                                   m_tableModel->columnCount() - 1);
-
-                m_tableModel->dataChanged(topLeft, bottomRight);
+                m_tableModel->invalidate();
             }
         }
     );
@@ -798,67 +1381,1087 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::onRouteResult(
     m_scrollArea->widget()->setLayout(verticalLayout);
 
     m_routeDiscoveryWidget->setVisible(false);
-    m_scrollArea->setVisible(true);
+    m_scrollArea->setVisible(!m_heatmapVisible);
+    m_heatmap->setVisible(m_heatmapVisible);
 
-    update();
+    /**
+     * the slots are only positioned once the layout has been applied, so the first plots are bound afterwards.
+     */
 
-    m_pingEngine->start();
-}
+    QTimer::singleShot(0, this, [this]() {
+        updateBoundPlots();
+    });
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::eventFilter(QObject *watched, QEvent *event) -> bool {
-    Q_EMIT filteredEvent(watched, event);
+    if (!m_captureReader) {
+        loadHistory();
+        openJournal();
+    }
 
-    return QWidget::eventFilter(watched, event);
+    update();
 }
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::paintEvent(QPaintEvent *paintEvent) -> void {
-    QWidget::paintEvent(paintEvent);
-}
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::createPlot() -> QCustomPlot * {
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setGradientEnabled(bool smoothGradient) -> void {
-    for(auto layer : m_backgroundLayers) {
-        layer->invalidate();
-    }
+    assert(latencySettings!=nullptr);
 
-    if (m_routeGraphDelegate) {
-        m_tableView->update();
-    }
-}
+    auto customPlot = new QCustomPlot();
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewportSize(double viewportSize) -> void {
-    m_viewportSize = viewportSize;
+    customPlot->addLayer("newBackground", customPlot->layer("grid"), QCustomPlot::limBelow);
 
-    updateRanges();
-}
+    auto latencyLayer = new GraphLatencyLayer(customPlot);
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::viewportSize(void) -> double {
-    return m_viewportSize;
-}
+    m_backgroundLayers.append(latencyLayer);
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::datasetSize(void) -> double {
-    return m_endPoint - m_startPoint;
-}
+    connect(
+        latencySettings,
+        &Nedrysoft::RouteAnalyser::LatencySettings::gradientChanged,
+        latencyLayer,
+        [=](bool /*useGradient*/) {
+            latencyLayer->invalidate();
+        }
+    );
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewportPosition(double position) -> void {
-    m_viewportPosition = qMin(qMax(0.0, position), 1.0);
+    customPlot->setCurrentLayer("main");
 
-    updateRanges();
-}
+    // the smoke is added before the graph so that the median line is drawn over it.
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::viewportPosition() -> double {
-    return m_viewportPosition;
-}
+    auto smokeChart = new SmokeChart(customPlot->xAxis, customPlot->yAxis);
 
+    smokeChart->setWidthType(QCPBars::wtPlotCoords);
+    smokeChart->setWidth(m_interval/1000.0);
+    smokeChart->setBrush(QColor(SmokeColour));
 
-auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateRanges() -> void {
-    double diff = m_endPoint - m_startPoint;
-    double max, min;
-    double maxVisibleLatency = 0;
+    m_smokeCharts[customPlot] = smokeChart;
 
-    // TODO: m_savedDiff should default to the viewport size
+    /**
+     * with OpenGL the plot is drawn into a framebuffer object by the OpenGL paint engine, if the plot library was
+     * built without OpenGL support the plot stays on the raster backend.
+     */
 
-    min = m_startPoint;
-    max = m_startPoint+m_viewportSize;
+    if (latencySettings->hardwareAcceleration()) {
+        customPlot->setOpenGl(true);
+    }
+
+    customPlot->setMinimumHeight(DefaultGraphHeight);
+
+    // the round trip graph draws the raw samples directly from the time series of the hop without copying them.
+
+    auto seriesGraph = new SeriesGraph(customPlot->xAxis, customPlot->yAxis);
+
+    m_seriesGraphs[customPlot] = seriesGraph;
+
+    // the timeout bar chart uses axis 2 which is a unit axis.  This means it will always draw to the top
+    // of the axis independently of the main axis which may scale up/down depending on latency.
+
+    customPlot->yAxis2->setRange(0,1);
+    customPlot->yAxis2->setVisible(true);
+
+    auto barChart = new BarChart(customPlot->xAxis, customPlot->yAxis2);
+
+    barChart->setWidthType(QCPBars::wtPlotCoords);
+    barChart->setWidth(RawBarWidth);
+    barChart->setMergeInterval((m_interval*RawMergeFactor)/1000.0);
+    barChart->setBrush(QColor(NoReplyColour));
+    barChart->setPen(QPen(QColor(NoReplyColour)));
+
+    m_barCharts[customPlot] = barChart;
+
+    customPlot->yAxis->ticker()->setTickCount(1);
+
+    QSharedPointer<CPAxisTickerMS> msTicker(new CPAxisTickerMS);
+
+    customPlot->yAxis->setTicker(msTicker);
+    customPlot->yAxis->setLabel(tr("Latency (ms)"));
+    customPlot->yAxis->setRange(0, DefaultMaxLatency);
+
+    QSharedPointer<QCPAxisTickerDateTime> dateTicker(new QCPAxisTickerDateTime);
+
+    auto locale = QLocale::system();
+
+    dateTicker->setDateTimeFormat(
+        locale.timeFormat(QLocale::LongFormat).remove("t").trimmed() +
+        "\n" +
+        locale.dateFormat(QLocale::ShortFormat)
+    );
+
+    auto secondsSinceEpoch = Nedrysoft::Core::Clock::getInstance()->currentSecsSinceEpoch();
+
+    customPlot->xAxis->setTicker(dateTicker);
+    customPlot->xAxis->setRange(
+        static_cast<double>(secondsSinceEpoch),
+        static_cast<double>(secondsSinceEpoch + m_viewportSize)
+    );
+
+    customPlot->graph(RoundTripGraph)->setLineStyle(QCPGraph::lsStepCenter);
+
+    customPlot->setBackground(this->palette().brush(QPalette::Base));
+    customPlot->xAxis->setLabelColor(this->palette().color(QPalette::Text));
+    customPlot->yAxis->setLabelColor(this->palette().color(QPalette::Text));
+    customPlot->xAxis->setTickLabelColor(this->palette().color(QPalette::Text));
+    customPlot->yAxis->setTickLabelColor(this->palette().color(QPalette::Text));
+
+    customPlot->replot();
+
+    /**
+     * scroll wheel events, by default QCustomPlot does not propagate these so this code ensures that they cause
+     * the scroll area to scroll.
+     */
+
+    connect(customPlot, &QCustomPlot::mouseWheel, [this](QWheelEvent *event) {
+        m_scrollArea->verticalScrollBar()->setValue(
+            m_scrollArea->verticalScrollBar()->value() - event->angleDelta().y()
+        );
+    });
+
+    /**
+     *  mouse over event
+     */
+
+    auto graphLine = new QCPItemStraightLine(customPlot);
+
+    graphLine->setPen(QPen(Qt::darkGray, 2, Qt::DotLine));
+
+    /**
+     * the line is drawn on the buffered overlay layer, so following the mouse only redraws that layer and
+     * composites it over the cached buffers of the other layers rather than replotting the graph.
+     */
+
+    graphLine->setLayer(CrosshairLayer);
+
+    m_graphLines[customPlot] = graphLine;
+
+    connect(
+        customPlot,
+        &QCustomPlot::mouseMove,
+        [this, customPlot, graphLine](QMouseEvent *event) {
+            auto x = customPlot->xAxis->pixelToCoord(event->pos().x());
+            auto foundRange = false;
+            auto dataRange = QCPRange();
+
+            /**
+             * the extent of the data is taken from the time series of the hop that the plot is bound to, the
+             * decimated plot data does not necessarily reach the first and last samples.
+             */
+
+            for (auto pingData : m_pingData) {
+                if ((pingData->customPlot()==customPlot) && (pingData->timeSeries()->count())) {
+                    dataRange = QCPRange(pingData->timeSeries()->firstTime(), pingData->timeSeries()->lastTime());
+                    foundRange = true;
+
+                    break;
+                }
+            }
+
+            graphLine->point1->setCoords(x, 0);
+            graphLine->point2->setCoords(x, 1);
+
+            Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->replotLayer(graphLine->layer());
+
+            if (( foundRange ) &&
+                ( x >= dataRange.lower ) &&
+                ( x <= dataRange.upper )) {
+                auto valueString = QString();
+                /*auto valueResultRange = customPlot->graph(RoundTripGraph)->data()->valueRange(
+                        foundRange,
+                        QCP::sdBoth,
+                        QCPRange(x - 1, x +1) );*/
+
+                /**
+                 * the latencies are read from the time series rather than the plots, so hops whose plots are not
+                 * currently bound to a widget are included.
+                 */
+
+                for (auto currentItem = 0; currentItem < m_tableModel->rowCount(); currentItem++) {
+                    auto pingData = m_tableModel->hop(currentItem);
+                    auto timeSeries = pingData->timeSeries();
+                    auto historicalLatency = -1.0;
+
+                    if (timeSeries) {
+                        auto last = timeSeries->lowerBound(x + 1);
+
+                        for (auto index = timeSeries->lowerBound(x - 1); index < last; index++) {
+                            historicalLatency = std::max(historicalLatency, timeSeries->roundTripTime(index));
+                        }
+                    }
+
+                    pingData->setHistoricalLatency(historicalLatency);
+                }
+
+                this->m_tableModel->setShowHistorical(true);
+
+                /*
+                auto seconds = std::chrono::duration<double>(valueResultRange.upper);
+
+                if (seconds < std::chrono::seconds(1)) {
+                    auto milliseconds =
+                        std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(seconds);
+
+                    valueString = QString(tr("%1ms")).arg(milliseconds.count(), 0, 'f', 2);
+                } else {
+                    valueString = QString(tr("%1s")).arg(seconds.count(), 0, 'f', 2);
+                }
+
+                auto dateTime = QDateTime::fromSecsSinceEpoch(static_cast<qint64>(x));
+
+                m_pointInfoLabel->setText(FontAwesome::richText(QString("[fas fa-stopwatch] %1").arg(valueString)));
+                m_hopInfoLabel->setText(FontAwesome::richText(QString("[fas fa-project-diagram] %1 %2").arg(tr("hop")).arg(hop)));
+                m_hostInfoLabel->setText(FontAwesome::richText(QString("[fas fa-server] %1").arg(maskedHostName)));
+                m_timeInfoLabel->setText(FontAwesome::richText(QString("[far fa-calendar-alt] %1").arg(dateTime.toString())));
+                */
+            } else {
+                /*
+                m_pointInfoLabel->setText("");
+                m_hopInfoLabel->setText("");
+                m_hostInfoLabel->setText("");
+                m_timeInfoLabel->setText("");
+                */
+
+                this->m_tableModel->setShowHistorical(false);
+
+                m_tableModel->invalidate();
+            }
+        }
+    );
+
+    customPlot->installEventFilter(this);
+
+    connect(customPlot, &QCustomPlot::afterReplot, [customPlot]() {
+        Nedrysoft::Core::Diagnostics::getInstance()->record("Plot replot (ms)", customPlot->replotTime());
+    });
+
+    customPlot->axisRect()->setAutoMargins(QCP::msNone);
+    customPlot->axisRect()->setMargins(PlotMargins);
+
+    return customPlot;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::bindPlot(Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+    auto plotSlot = m_plotSlots.value(pingData, nullptr);
+
+    if ((!plotSlot) || (pingData->customPlot())) {
+        return;
+    }
+
+    createExtraPlots(pingData);
+
+    QCustomPlot *customPlot;
+
+    if (m_plotPool.isEmpty()) {
+        customPlot = createPlot();
+    } else {
+        customPlot = m_plotPool.takeLast();
+    }
+
+    plotSlot->layout()->addWidget(customPlot);
+
+    customPlot->setVisible(true);
+
+    m_graphLines[customPlot]->setVisible(false);
+
+    /**
+     * the plot may have been showing another hop, its data is rebuilt from this hop's time series at the
+     * resolution chosen by the next range update and the latency axis starts from this hop's maximum.
+     */
+
+    m_plotLevels[customPlot] = UnboundLevel;
+
+    auto maximumLatency = pingData->latency(static_cast<int>(PingData::Fields::MaximumLatency));
+
+    customPlot->yAxis->setRange(0, std::max(DefaultMaxLatency, maximumLatency));
+
+    pingData->setCustomPlot(customPlot);
+
+    m_smokeCharts[customPlot]->setSeries((m_probesPerRound>1) ? pingData->roundSeries() : nullptr);
+
+    updateChangePointMarkers(pingData);
+
+    m_plotList.append(customPlot);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::createExtraPlots(
+        Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+
+    auto extraPlotSlot = m_extraPlotSlots.take(pingData);
+
+    if (!extraPlotSlot) {
+        return;
+    }
+
+    auto timeSeries = pingData->timeSeries();
+    auto jitter = pingData->statistics().jitterStatistics().jitter();
+
+    QList<Nedrysoft::RouteAnalyser::IPlot *> plots;
+
+    // the history is gathered once and given to each new plot as a single batch.
+
+    auto samples = QVector<Nedrysoft::RouteAnalyser::IPlot::Sample>();
+
+    if (!m_plotFactories.isEmpty()) {
+        samples.reserve(timeSeries->count());
+
+        for (auto index=0;index<timeSeries->count();index++) {
+            auto roundTripTime = timeSeries->roundTripTime(index);
+
+            if (roundTripTime>=0) {
+                samples.append(Nedrysoft::RouteAnalyser::IPlot::Sample {timeSeries->time(index), roundTripTime});
+            }
+        }
+    }
+
+    for (auto plotFactory : m_plotFactories) {
+        auto plot = plotFactory->createPlot(PlotMargins);
+
+        plot->updateSamples(samples.constData(), samples.count());
+
+        if ((timeSeries->count()) && (jitter>=0)) {
+            plot->updateJitter(timeSeries->lastTime(), jitter);
+        }
+
+        plot->frameReady();
+
+        extraPlotSlot->layout()->addWidget(plot->widget());
+
+        m_extraPlots.append(plot);
+
+        plots.append(plot);
+    }
+
+    extraPlotSlot->setMinimumHeight(0);
+
+    pingData->setPlots(plots);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::releasePlot(Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+    auto customPlot = pingData->customPlot();
+
+    if (!customPlot) {
+        return;
+    }
+
+    pingData->setCustomPlot(nullptr);
+
+    m_plotList.removeAll(customPlot);
+    m_stalePlots.remove(customPlot);
+    m_pausedPlots.remove(customPlot);
+
+    customPlot->setVisible(false);
+    customPlot->parentWidget()->layout()->removeWidget(customPlot);
+
+    customPlot->graph(RoundTripGraph)->data()->clear();
+
+    if (m_barCharts.contains(customPlot)) {
+        m_barCharts[customPlot]->clear();
+    }
+
+    m_smokeCharts[customPlot]->setSeries(nullptr);
+    m_seriesGraphs[customPlot]->setSeries(nullptr);
+
+    removeChangePointMarkers(customPlot);
+
+    m_plotPool.append(customPlot);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::createPlotSlots(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        QVBoxLayout *layout ) -> void {
+
+    auto geoIP = Nedrysoft::Core::ObjectRegistry::getInstance()->object<Nedrysoft::Core::IGeoIPProvider>();
+    auto plotTitleLabel = new QLabel;
+    auto widgets = QList<QWidget *>();
+
+    QFont labelFont = plotTitleLabel->font();
+
+    labelFont.setPointSize(16);
+
+    plotTitleLabel->setFont(labelFont);
+
+    plotTitleLabel->setAlignment(Qt::AlignHCenter);
+
+    layout->addWidget(plotTitleLabel);
+
+    widgets.append(plotTitleLabel);
+
+    /**
+     * any pre-plots are created when the hop is first bound (see createExtraPlots), until then an empty slot
+     * of the expected height holds their place so that the layout does not move when they appear.
+     */
+
+    if (!m_plotFactories.isEmpty()) {
+        auto extraPlotSlot = new QWidget;
+        auto extraPlotSlotLayout = new QVBoxLayout;
+
+        extraPlotSlotLayout->setContentsMargins(0, 0, 0, 0);
+
+        extraPlotSlot->setLayout(extraPlotSlotLayout);
+        extraPlotSlot->setMinimumHeight(ExtraPlotHeight*m_plotFactories.count());
+
+        layout->addWidget(extraPlotSlot);
+
+        widgets.append(extraPlotSlot);
+
+        m_extraPlotSlots[pingData] = extraPlotSlot;
+    }
+
+    /**
+     * the main plot is added to a slot which holds its place in the layout, a plot widget is only bound to the
+     * slot while it is in or near the viewport (see updateBoundPlots).
+     */
+
+    auto plotSlot = new QWidget;
+    auto plotSlotLayout = new QVBoxLayout;
+
+    plotSlotLayout->setContentsMargins(0, 0, 0, 0);
+
+    plotSlot->setLayout(plotSlotLayout);
+    plotSlot->setMinimumHeight(DefaultGraphHeight);
+
+    layout->addWidget(plotSlot);
+
+    widgets.append(plotSlot);
+
+    m_plotSlots[pingData] = plotSlot;
+    m_plotTitles[pingData] = plotTitleLabel;
+    m_plotWidgets[pingData] = widgets;
+
+    if ((geoIP) && (pingData->location().isEmpty())) {
+        auto identity = pingData->identity();
+
+        geoIP->lookup(
+                pingData->hostAddress(),
+                [this, pingData, identity](const QString &, const QVariantMap &result) mutable {
+
+            Nedrysoft::RouteAnalyser::HopIdentityTable::getInstance()->setLocation(
+                identity,
+                result["country"].toString() );
+
+            if (m_pingData.contains(pingData)) {
+                pingData->updateModel();
+            }
+        });
+    }
+
+    auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
+
+    if (hostMaskerManager) {
+        connect(
+            hostMaskerManager,
+            &Nedrysoft::Core::IHostMaskerManager::maskStateChanged,
+            plotTitleLabel,
+            [pingData, plotTitleLabel](Nedrysoft::Core::HostMaskType type, bool state) {
+                pingData->updateModel();
+                plotTitleLabel->setText(pingData->plotTitle());
+        });
+
+        connect(
+            hostMaskerManager,
+            &Nedrysoft::Core::IHostMaskerManager::maskersChanged,
+            plotTitleLabel,
+            [pingData, plotTitleLabel]() {
+                pingData->updateModel();
+                plotTitleLabel->setText(pingData->plotTitle());
+        });
+    }
+
+    plotTitleLabel->setText(pingData->plotTitle());
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::removePlotSlots(
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> void {
+
+    auto customPlot = pingData->customPlot();
+
+    releasePlot(pingData);
+
+    // a released plot is still a child of the slot, it is kept in the pool rather than deleted with the slot.
+
+    if (customPlot) {
+        customPlot->setParent(m_scrollArea->widget());
+    }
+
+    for (auto plot : pingData->plots()) {
+        m_extraPlots.removeAll(plot);
+    }
+
+    pingData->setPlots(QList<Nedrysoft::RouteAnalyser::IPlot *>());
+
+    m_plotSlots.remove(pingData);
+    m_extraPlotSlots.remove(pingData);
+    m_plotTitles.remove(pingData);
+
+    qDeleteAll(m_plotWidgets.take(pingData));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::arrangePlotSlots() -> void {
+    auto layout = qobject_cast<QVBoxLayout *>(m_scrollArea->widget()->layout());
+
+    if (!layout) {
+        return;
+    }
+
+    auto position = 0;
+
+    for (auto pingData : m_pingData) {
+        for (auto widget : m_plotWidgets.value(pingData)) {
+            layout->removeWidget(widget);
+            layout->insertWidget(position++, widget);
+        }
+
+        if (m_plotTitles.contains(pingData)) {
+            m_plotTitles[pingData]->setText(pingData->plotTitle());
+        }
+    }
+
+    // the slots have moved, so the plots are bound again once the layout has been applied.
+
+    QTimer::singleShot(0, this, [this]() {
+        updateBoundPlots();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::deletePlot(QCustomPlot *customPlot) -> void {
+    for (auto index=m_backgroundLayers.count()-1;index>=0;index--) {
+        if (m_backgroundLayers.at(index)->parentPlot()==customPlot) {
+            m_backgroundLayers.removeAt(index);
+        }
+    }
+
+    m_graphLines.remove(customPlot);
+    m_changePointMarkers.remove(customPlot);
+    m_barCharts.remove(customPlot);
+    m_smokeCharts.remove(customPlot);
+    m_seriesGraphs.remove(customPlot);
+    m_plotLevels.remove(customPlot);
+    m_stalePlots.remove(customPlot);
+    m_pausedPlots.remove(customPlot);
+
+    // the layers, charts and items of the plot are owned by it and are deleted with it.
+
+    delete customPlot;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateChangePointMarkers(
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> bool {
+
+    auto customPlot = pingData->customPlot();
+
+    if (!customPlot) {
+        return false;
+    }
+
+    auto &changePoints = pingData->statistics().changePoints();
+    auto &markers = m_changePointMarkers[customPlot];
+
+    // the change points are only ever appended or trimmed from the front, so the last one identifies the set.
+
+    if ((markers.count()==changePoints.count()) &&
+        ((changePoints.isEmpty()) || (markers.last()->point1->coords().x()==changePoints.last().time))) {
+
+        return false;
+    }
+
+    removeChangePointMarkers(customPlot);
+
+    auto &rebuiltMarkers = m_changePointMarkers[customPlot];
+
+    for (auto &changePoint : changePoints) {
+        auto marker = new QCPItemStraightLine(customPlot);
+
+        marker->setPen(QPen(QColor(ChangePointColour), 1, Qt::DashLine));
+        marker->setSelectable(false);
+        marker->point1->setCoords(changePoint.time, 0);
+        marker->point2->setCoords(changePoint.time, 1);
+
+        rebuiltMarkers.append(marker);
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateMemoryUsage() -> void {
+    qint64 historyBytes = 0;
+    qint64 plotBytes = 0;
+    qint64 plotPoints = 0;
+
+    for (auto pingData : m_pingData) {
+        if (pingData->timeSeries()) {
+            historyBytes += static_cast<qint64>(pingData->timeSeries()->memoryUsage());
+        }
+    }
+
+    // the pooled plots are still held by the editor, so they are included.
+
+    auto customPlots = m_plotPool;
+
+    for (auto pingData : m_pingData) {
+        if (pingData->customPlot()) {
+            customPlots.append(pingData->customPlot());
+        }
+    }
+
+    for (auto customPlot : customPlots) {
+        for (auto graph=0;graph<customPlot->graphCount();graph++) {
+            plotPoints += customPlot->graph(graph)->data()->size();
+        }
+    }
+
+    plotBytes = plotPoints*static_cast<qint64>(sizeof(QCPGraphData));
+
+    m_historyMemory.set(historyBytes, m_pingData.count());
+    m_plotMemory.set(plotBytes, customPlots.count());
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::removeChangePointMarkers(QCustomPlot *customPlot) -> void {
+    for (auto marker : m_changePointMarkers.take(customPlot)) {
+        customPlot->removeItem(marker);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateAttribution() -> void {
+    auto isResponsive = [](Nedrysoft::RouteAnalyser::PingData *pingData) {
+        return (pingData->hopValid()) && (pingData->statistics().replyCount());
+    };
+
+    // the loss that persists downstream of a hop is the least loss of it and every responsive hop after it.
+
+    auto persistentLoss = QVector<double>(m_pingData.count(), -1);
+    auto downstreamLoss = -1.0;
+
+    for (auto hop=m_pingData.count()-1;hop>=0;hop--) {
+        auto pingData = m_pingData.at(hop);
+
+        if (!isResponsive(pingData)) {
+            continue;
+        }
+
+        auto packetLoss = pingData->packetLoss();
+
+        if ((downstreamLoss<0) || (packetLoss<downstreamLoss)) {
+            downstreamLoss = packetLoss;
+        }
+
+        persistentLoss[hop] = downstreamLoss;
+    }
+
+    auto previousLatency = 0.0;
+    auto previousLoss = 0.0;
+
+    for (auto hop=0;hop<m_pingData.count();hop++) {
+        auto pingData = m_pingData.at(hop);
+
+        if (!isResponsive(pingData)) {
+            pingData->setAttribution(-1, -1, false);
+
+            continue;
+        }
+
+        auto medianLatency = pingData->statistics().latencySketch().quantile(0.50);
+
+        pingData->setAttribution(
+                medianLatency-previousLatency,
+                std::max(0.0, persistentLoss[hop]-previousLoss),
+                pingData->packetLoss()>persistentLoss[hop] );
+
+        previousLatency = medianLatency;
+        previousLoss = persistentLoss[hop];
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateBoundPlots() -> void {
+    if (m_viewsReleased) {
+        return;
+    }
+
+    auto viewportHeight = m_scrollArea->viewport()->height();
+    auto visibleTop = m_scrollArea->verticalScrollBar()->value();
+    auto visibleBottom = visibleTop+viewportHeight;
+    auto bound = false;
+
+    /**
+     * plots are bound within one viewport of the visible area and only released beyond two, so a plot is not
+     * repeatedly bound and released as the view scrolls back and forth around it.  Plots are released first so
+     * that their widgets can be reused for the plots being bound.
+     */
+
+    for (auto plotSlot=m_plotSlots.constBegin();plotSlot!=m_plotSlots.constEnd();plotSlot++) {
+        auto slotTop = plotSlot.value()->y();
+        auto slotBottom = slotTop+plotSlot.value()->height();
+
+        if ((slotBottom<visibleTop-(viewportHeight*PlotReleaseDistance)) ||
+            (slotTop>visibleBottom+(viewportHeight*PlotReleaseDistance))) {
+            releasePlot(plotSlot.key());
+        }
+    }
+
+    for (auto plotSlot=m_plotSlots.constBegin();plotSlot!=m_plotSlots.constEnd();plotSlot++) {
+        auto slotTop = plotSlot.value()->y();
+        auto slotBottom = slotTop+plotSlot.value()->height();
+
+        if ((slotBottom>=visibleTop-(viewportHeight*PlotBindDistance)) &&
+            (slotTop<=visibleBottom+(viewportHeight*PlotBindDistance)) &&
+            (!plotSlot.key()->customPlot())) {
+            bindPlot(plotSlot.key());
+
+            bound = true;
+        }
+    }
+
+    if (bound) {
+        updateRanges();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::subscribeHop(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        const QHostAddress &hopAddress ) -> void {
+
+    auto hopCache = Nedrysoft::RouteAnalyser::HopCache::getInstance();
+    auto hopIndex = m_pingData.indexOf(pingData);
+
+    if (m_hopSubscriptions.contains(pingData)) {
+        hopCache->unsubscribe(m_hopSubscriptions.take(pingData));
+    }
+
+    /**
+     * a hop that has not answered is only re-tested, its results are not shown until it answers and is monitored
+     * as usual.
+     */
+
+    auto handler = [this, hopIndex, pingData](const Nedrysoft::RouteAnalyser::PingResult &result) {
+        if (m_silentHops.contains(pingData)) {
+            checkSilentHop(pingData, result);
+
+            return;
+        }
+
+        m_resultPipeline->publish(hopIndex, result);
+
+        if (m_destinationHops.contains(pingData)) {
+            checkDestination(pingData, result);
+        }
+    };
+
+    pingData->roundSeries()->setProbesPerRound(m_probesPerRound);
+
+    if (hopAddress.isNull()) {
+        m_silentHops[pingData] = SilentHopInitialDivisor;
+    } else {
+        m_silentHops.remove(pingData);
+    }
+
+    auto subscription = hopCache->subscribe(
+        m_pingEngineFactory,
+        m_ipVersion,
+        m_interval,
+        m_payloadSize,
+        m_dontFragment,
+        m_source,
+        m_aligned,
+        m_probesPerRound,
+        m_routeHostAddress,
+        hopAddress,
+        pingData->hop(),
+        handler
+    );
+
+    if (hopAddress==m_routeHostAddress) {
+        m_destinationHops.insert(pingData);
+    } else {
+        m_destinationHops.remove(pingData);
+    }
+
+    if (subscription) {
+        m_hopSubscriptions[pingData] = subscription;
+
+        updateSamplingDivisors();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setAligned(bool aligned) -> void {
+    m_aligned = aligned;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::targetName() -> QString {
+    if (m_source.isEmpty()) {
+        return m_targetHost;
+    }
+
+    return m_targetHost+"%"+m_source;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateSamplingDivisors() -> void {
+    auto hopCache = Nedrysoft::RouteAnalyser::HopCache::getInstance();
+
+    for (auto pingData : m_hopSubscriptions.keys()) {
+        auto divisor = m_intermediateHopDivisor;
+
+        if (m_silentHops.contains(pingData)) {
+            divisor = m_silentHops[pingData];
+        } else if ((m_escalated) || (m_destinationHops.contains(pingData))) {
+            divisor = 1;
+        }
+
+        hopCache->setSamplingDivisor(m_hopSubscriptions[pingData], divisor);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::checkSilentHop(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if ((Nedrysoft::RouteAnalyser::PingResult::isLost(result.code())) || (result.hostAddress().isNull())) {
+        auto divisor = qMin(m_silentHops[pingData]*2, SilentHopMaximumDivisor);
+
+        if (divisor!=m_silentHops[pingData]) {
+            m_silentHops[pingData] = divisor;
+
+            Nedrysoft::RouteAnalyser::HopCache::getInstance()->setSamplingDivisor(
+                m_hopSubscriptions[pingData],
+                divisor );
+        }
+
+        return;
+    }
+
+    /**
+     * the hop has started to answer, it moves to the hop cache entry for its address and is probed at the full
+     * rate.  The subscription is changed once the hop cache has finished passing on the result.
+     */
+
+    auto hostAddress = result.hostAddress();
+
+    QTimer::singleShot(0, this, [this, pingData, hostAddress]() {
+        if ((!m_pingData.contains(pingData)) || (!m_silentHops.contains(pingData))) {
+            return;
+        }
+
+        pingData->setHopValid(true);
+
+        setHopHost(pingData, hostAddress);
+
+        subscribeHop(pingData, hostAddress);
+
+        pingData->updateModel();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::checkDestination(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if (m_intermediateHopDivisor<=1) {
+        return;
+    }
+
+    auto trouble = Nedrysoft::RouteAnalyser::PingResult::isLost(result.code());
+
+    if (!trouble) {
+        auto &latencyStatistics = pingData->latencyStatistics();
+
+        if (latencyStatistics.count()>=DestinationWarmupSamples) {
+            auto threshold = latencyStatistics.mean() +
+                             (DestinationDeviationThreshold*latencyStatistics.standardDeviation());
+
+            trouble = (result.roundTripTime()>threshold);
+        }
+    }
+
+    if (!trouble) {
+        return;
+    }
+
+    // each further sign of trouble extends the time that the intermediate hops stay at the full rate.
+
+    m_escalationTimer->start();
+
+    if (!m_escalated) {
+        m_escalated = true;
+
+        updateSamplingDivisors();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateOverheadWarning() -> void {
+    if (!m_pingEngineFactory) {
+        return;
+    }
+
+    auto estimate = Nedrysoft::RouteAnalyser::OverheadCalibrator::getInstance()->estimate(
+        m_pingEngineFactory,
+        m_ipVersion );
+
+    if (!estimate.distorted()) {
+        m_overheadWarningLabel->setVisible(false);
+
+        return;
+    }
+
+    m_overheadWarningLabel->setText(
+        tr("This computer is busy and is adding %1 ms to each round trip (normally %2 ms), latencies may be "
+           "overstated.")
+            .arg(static_cast<double>(estimate.median) / NanosecondsInMillisecond, 0, 'f', 2)
+            .arg(static_cast<double>(estimate.baseline) / NanosecondsInMillisecond, 0, 'f', 2) );
+
+    m_overheadWarningLabel->setVisible(true);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::eventFilter(QObject *watched, QEvent *event) -> bool {
+    if (watched==m_scrollArea->viewport()) {
+        if (event->type()==QEvent::Resize) {
+            updateBoundPlots();
+        }
+
+        return QWidget::eventFilter(watched, event);
+    }
+
+    Q_EMIT filteredEvent(watched, event);
+
+    return QWidget::eventFilter(watched, event);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::paintEvent(QPaintEvent *paintEvent) -> void {
+    QWidget::paintEvent(paintEvent);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setGradientEnabled(bool smoothGradient) -> void {
+    for(auto layer : m_backgroundLayers) {
+        layer->invalidate();
+    }
+
+    if (m_routeGraphDelegate) {
+        m_tableView->update();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewportSize(double viewportSize) -> void {
+    m_viewportSize = viewportSize;
+
+    Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->post(this, [this]() {
+        updateRanges();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::viewportSize(void) -> double {
+    return m_viewportSize;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::datasetSize(void) -> double {
+    return m_endPoint - m_startPoint;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::overviewSeries() ->
+        const Nedrysoft::RouteAnalyser::HopTimeSeries * {
+
+    auto pingData = destinationData();
+
+    return pingData ? pingData->timeSeries() : nullptr;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::overviewChangePoints() -> QVector<double> {
+    auto pingData = destinationData();
+    auto times = QVector<double>();
+
+    if (pingData) {
+        for (auto &changePoint : pingData->statistics().changePoints()) {
+            times.append(changePoint.time);
+        }
+    }
+
+    return times;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::destinationData() -> Nedrysoft::RouteAnalyser::PingData * {
+    for (auto hop=m_pingData.count()-1;hop>=0;hop--) {
+        auto timeSeries = m_pingData.at(hop)->timeSeries();
+
+        if ((timeSeries) && (timeSeries->count())) {
+            return m_pingData.at(hop);
+        }
+    }
+
+    return nullptr;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::imageSnapshot(
+        int content,
+        int width,
+        int dpi,
+        bool maskHosts,
+        bool entireSession ) -> Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+    auto snapshot = Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot();
+    auto columns = Nedrysoft::RouteAnalyser::RouteImageRenderer::graphColumns(width);
+
+    snapshot.target = targetName();
+    snapshot.start = entireSession ? m_startPoint : m_visibleStart;
+    snapshot.end = entireSession ? m_endPoint : m_visibleEnd;
+    snapshot.warningLatency = latencySettings->warningValue();
+    snapshot.criticalLatency = latencySettings->criticalValue();
+    snapshot.idealColour = latencySettings->idealColour();
+    snapshot.warningColour = latencySettings->warningColour();
+    snapshot.criticalColour = latencySettings->criticalColour();
+    snapshot.content = content;
+    snapshot.width = width;
+    snapshot.dpi = dpi;
+
+    auto hops = m_pingData;
+
+    std::sort(hops.begin(), hops.end(), [](PingData *a, PingData *b) {
+        return a->hop()<b->hop();
+    });
+
+    for (auto pingData : hops) {
+        auto hop = Nedrysoft::RouteAnalyser::RouteImageRenderer::Hop();
+        auto timeSeries = pingData->timeSeries();
+
+        hop.hop = pingData->hop();
+        hop.valid = pingData->hopValid();
+        hop.address = maskHosts ? pingData->maskedHostAddress() : pingData->hostAddress();
+        hop.host = maskHosts ? pingData->maskedHostName() : pingData->hostName();
+        hop.averageLatency = pingData->latency(static_cast<int>(PingData::Fields::AverageLatency));
+        hop.minimumLatency = pingData->latency(static_cast<int>(PingData::Fields::MinimumLatency));
+        hop.maximumLatency = pingData->latency(static_cast<int>(PingData::Fields::MaximumLatency));
+        hop.currentLatency = pingData->latency(static_cast<int>(PingData::Fields::CurrentLatency));
+        hop.packetLoss = pingData->packetLoss();
+        hop.medianLatency = pingData->latency(static_cast<int>(PingData::Fields::MedianLatency));
+        hop.p95Latency = pingData->latency(static_cast<int>(PingData::Fields::P95Latency));
+        hop.p99Latency = pingData->latency(static_cast<int>(PingData::Fields::P99Latency));
+
+        if ((hop.valid) && (timeSeries) && (snapshot.end>snapshot.start)) {
+            hop.columns = timeSeries->decimate(snapshot.start, snapshot.end, columns);
+        }
+
+        snapshot.hops.append(hop);
+    }
+
+    return snapshot;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewportPosition(double position) -> void {
+    m_viewportPosition = qMin(qMax(0.0, position), 1.0);
+
+    // the viewport may be moved many times per frame while the trimmer is dragged, only the last position is drawn.
+
+    Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->post(this, [this]() {
+        updateRanges();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::viewportPosition() -> double {
+    return m_viewportPosition;
+}
+
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateRanges() -> void {
+    double diff = m_endPoint - m_startPoint;
+    double max, min;
+    double maxVisibleLatency = 0;
+
+    // TODO: m_savedDiff should default to the viewport size
+
+    min = m_startPoint;
+    max = m_startPoint+m_viewportSize;
 
     if (m_viewportPosition == 1) {
         if (diff > m_viewportSize) {
@@ -873,20 +2476,111 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateRanges() -> void {
         }
     }
 
-    for (auto plot : m_plotList) {
-        bool foundRange;
+    m_visibleStart = min;
+    m_visibleEnd = max;
+
+    /**
+     * a plot that spans more seconds than it has pixels is drawn from the coarsest rollup that still provides a
+     * point per pixel, so the cost of a replot depends on the width of the plot rather than the length of the run.
+     */
+
+    auto pauseHiddenPlots = Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->hiddenPlotsPaused();
+
+    for (auto pingData : m_pingData) {
+        auto plot = pingData->customPlot();
+
+        if ((!plot) || (!pingData->timeSeries())) {
+            continue;
+        }
+
+        // while the drawing quality is lowered a plot that is out of view is left until it is scrolled back in.
+
+        if ((pauseHiddenPlots) && ((!plot->isVisible()) || (plot->visibleRegion().isEmpty()))) {
+            m_pausedPlots.insert(plot);
+
+            continue;
+        }
+
+        auto paused = m_pausedPlots.remove(plot);
+        auto level = Nedrysoft::RouteAnalyser::HopTimeSeries::levelFor(max-min, plot->width());
+
+        if ((m_rebuildPlots) || (paused) || (level!=RawLevel) || (m_plotLevels.value(plot, RawLevel)!=RawLevel)) {
+            rebuildPlotData(pingData, level, min, max);
+        }
+    }
+
+    m_rebuildPlots = false;
+
+    /**
+     * while the viewport follows the newest results the sliding window of each hop already holds the extremes of
+     * the visible period, otherwise the visible samples of the graph are scanned.  The latency axes follow the
+     * visible period, so a spike stops affecting the scale once it has scrolled out of view.
+     */
+
+    auto following = ((m_viewportPosition==1) && (!m_captureReader));
+    auto plotMaximums = QMap<QCustomPlot *, double>();
+
+    for (auto pingData : m_pingData) {
+        auto plot = pingData->customPlot();
+        auto latencyWindow = pingData->latencyWindow();
+
+        if ((!plot) || (!latencyWindow)) {
+            continue;
+        }
 
         plot->xAxis->setRange(min, max);
 
-        QCPRange visibleKeyRange = plot->xAxis->range();
+        auto maximumLatency = -1.0;
+
+        if (following) {
+            if (latencyWindow->window()!=m_viewportSize) {
+                resetLatencyWindow(pingData);
+            }
+
+            latencyWindow->expire(max);
+
+            maximumLatency = latencyWindow->maximum();
+        } else {
+            bool foundRange;
+
+            auto valueRange = plot->graph(RoundTripGraph)->getValueRange(
+                    foundRange,
+                    QCP::sdBoth,
+                    plot->xAxis->range() );
+
+            if (foundRange) {
+                maximumLatency = valueRange.upper;
+            }
+        }
+
+        plotMaximums[plot] = maximumLatency;
+
+        if (maximumLatency>maxVisibleLatency) {
+            maxVisibleLatency = maximumLatency;
+        }
+    }
+
+    /**
+     * once the viewport has been moved away from the newest results the table describes the visible period, the
+     * summary is assembled from the rollups so it can be recalculated on every frame of a drag.
+     */
+
+    for (auto pingData : m_pingData) {
+        auto timeSeries = pingData->timeSeries();
 
-        QCPRange valueRange = plot->graph()->getValueRange(foundRange, QCP::sdBoth, visibleKeyRange);
+        if ((following) || (!timeSeries)) {
+            pingData->setWindowSummary(nullptr);
 
-        if (valueRange.upper>maxVisibleLatency) {
-            maxVisibleLatency = valueRange.upper;
+            continue;
         }
+
+        auto summary = timeSeries->summarise(min, max);
+
+        pingData->setWindowSummary(&summary);
     }
 
+    m_tableModel->updateMaximums();
+
     for (auto plot : m_extraPlots) {
         plot->updateRange(min, max);
     }
@@ -894,14 +2588,435 @@ auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::updateRanges() -> void {
     // TODO: go through the bar charts and set to maximum as well.
 
     for (auto plot : m_plotList) {
-        if (m_graphScaleMode==ScaleMode::Normalised) {
-            plot->graph(0)->valueAxis()->setRangeUpper(maxVisibleLatency);
+        switch(m_graphScaleMode) {
+            case ScaleMode::None: {
+                auto maximumLatency = plotMaximums.value(plot, -1);
+
+                if (maximumLatency>0) {
+                    plot->yAxis->setRange(0, maximumLatency);
+                }
+
+                break;
+            }
+
+            case ScaleMode::Normalised: {
+                if (maxVisibleLatency>0) {
+                    plot->graph(RoundTripGraph)->valueAxis()->setRangeUpper(maxVisibleLatency);
+                }
+
+                break;
+            }
+
+            case ScaleMode::Fixed: {
+                // TODO: Fixed scaling, user sets the max value.
+                break;
+            }
+        }
+
+        if ((plot->isVisible()) && (!plot->visibleRegion().isEmpty())) {
+            m_stalePlots.remove(plot);
+
+            Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->replot(plot);
+        } else {
+            m_stalePlots.insert(plot);
+        }
+    }
+
+    if (m_captureReader) {
+        loadCaptureRange(min, max);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::openCapture(const QString &filename) -> bool {
+    if ((m_pingEngineFactory) || (m_captureReader)) {
+        return false;
+    }
+
+    auto captureReader = new Nedrysoft::RouteAnalyser::CaptureReader;
+
+    if ((!captureReader->open(filename)) || (!captureReader->blockCount())) {
+        delete captureReader;
+
+        return false;
+    }
+
+    m_captureReader = captureReader;
+
+    // a capture is already paged from the file, so only the loaded part of it is ever held in memory.
+
+    Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance()->removeOwner(this);
+
+    m_interval = m_captureReader->interval();
+
+    m_heatmap->setColumnInterval(m_interval/1000.0);
+    m_ipVersion = m_captureReader->ipVersion();
+    m_targetHost = m_captureReader->target();
+
+    m_historyMemory.setOwner(targetName());
+    m_plotMemory.setOwner(targetName());
+
+    auto route = m_captureReader->route();
+
+    for (auto &hopAddress : route) {
+        appendHop(hopAddress);
+    }
+
+    /**
+     * the data set covers the whole capture from the start, the samples themselves are only loaded for the part
+     * of the capture that the viewport shows.
+     */
+
+    m_startPoint = static_cast<double>(m_captureReader->startTime() / NanosecondsInSecond);
+    m_endPoint = static_cast<double>(m_captureReader->endTime() / NanosecondsInSecond);
+
+    m_captureTimer = new QTimer(this);
+
+    m_captureTimer->setInterval(CaptureLoadInterval);
+
+    connect(m_captureTimer, &QTimer::timeout, [=]() {
+        loadCaptureBlocks();
+    });
+
+    onRouteResult(m_captureReader->routeHostAddress(), route, true, route.count(), route.count());
+
+    updateDataset();
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::loadCaptureRange(double min, double max) -> void {
+    if ((min>=m_captureStart) && (max<=m_captureEnd)) {
+        return;
+    }
+
+    /**
+     * half a viewport either side of the visible range is loaded as well, so small movements of the viewport do not
+     * cause the capture to be loaded again.
+     */
+
+    auto margin = (max-min)/2;
+
+    m_captureStart = min-margin;
+    m_captureEnd = max+margin;
+
+    m_captureBlock = m_captureReader->lowerBound(static_cast<qint64>(m_captureStart*NanosecondsInSecond));
+    m_captureEndBlock = std::min(
+            m_captureReader->lowerBound(static_cast<qint64>(m_captureEnd*NanosecondsInSecond))+1,
+            m_captureReader->blockCount() );
+
+    /**
+     * the statistics and time series of the hops describe the loaded part of the capture, they are discarded and
+     * rebuilt from the newly queued blocks.
+     */
+
+    m_statisticsWorker->reset();
+
+    for (auto pingData : m_pingData) {
+        if (pingData->timeSeries()) {
+            pingData->timeSeries()->clear();
+        }
+
+        if (pingData->roundSeries()) {
+            pingData->roundSeries()->clear();
+        }
+
+        if (pingData->latencyWindow()) {
+            pingData->latencyWindow()->clear();
+        }
+
+        auto customPlot = pingData->customPlot();
+
+        if (customPlot) {
+            customPlot->graph(RoundTripGraph)->data()->clear();
+
+            if (m_barCharts.contains(customPlot)) {
+                m_barCharts[customPlot]->clear();
+            }
+        }
+    }
+
+    m_heatmap->clear();
+
+    m_captureTimer->start();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::loadCaptureBlocks() -> void {
+    auto route = m_captureReader->route();
+    auto samples = QVector<Nedrysoft::RouteAnalyser::CaptureSample>();
+
+    for (auto loaded=0;(loaded<CaptureBlocksPerLoad) && (m_captureBlock<m_captureEndBlock);loaded++) {
+        if (!m_captureReader->readBlock(m_captureBlock++, samples)) {
+            continue;
         }
 
-        if (plot->isVisible()) {
-            if (!plot->visibleRegion().isEmpty()) {
-                plot->replot(QCustomPlot::rpQueuedReplot);
+        for (auto &sample : samples) {
+            auto hopIndex = sample.hop-1;
+
+            if (hopIndex>=m_pingData.count()) {
+                continue;
             }
+
+            m_statisticsWorker->publish(hopIndex, Nedrysoft::RouteAnalyser::PingResult(
+                0,
+                sample.code,
+                route.value(hopIndex),
+                sample.requestTimestamp,
+                sample.roundTripTime,
+                nullptr,
+                sample.hop
+            ));
+        }
+    }
+
+    if (m_captureBlock>=m_captureEndBlock) {
+        m_captureTimer->stop();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::currentRoute() const -> Nedrysoft::RouteAnalyser::RouteList {
+    auto route = Nedrysoft::RouteAnalyser::RouteList();
+
+    for (auto pingData : m_pingData) {
+        route.append(pingData->hopValid() ? pingData->address() : QHostAddress());
+    }
+
+    return route;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::openJournal() -> void {
+    m_recordingStage->setJournal(nullptr);
+
+    if (!m_journal) {
+        m_journal = new Nedrysoft::RouteAnalyser::SessionJournal;
+    }
+
+    if (!m_journal->open(m_targetHost, m_ipVersion, m_interval, m_routeHostAddress, currentRoute())) {
+        delete m_journal;
+
+        m_journal = nullptr;
+
+        return;
+    }
+
+    m_recordingStage->setJournal(m_journal);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::startRecording(const QString &filename) -> bool {
+    if ((m_captureReader) || (m_routeHostAddress.isNull())) {
+        return false;
+    }
+
+    auto captureWriter = new Nedrysoft::RouteAnalyser::CaptureWriter;
+
+    if (!captureWriter->open(filename, m_targetHost, m_ipVersion, m_interval, m_routeHostAddress, currentRoute())) {
+        delete captureWriter;
+
+        return false;
+    }
+
+    stopRecording();
+
+    m_captureWriter = captureWriter;
+
+    m_recordingStage->setCaptureWriter(m_captureWriter);
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::stopRecording() -> void {
+    m_recordingStage->setCaptureWriter(nullptr);
+
+    delete m_captureWriter;
+
+    m_captureWriter = nullptr;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::isRecording() -> bool {
+    return m_captureWriter!=nullptr;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::saveHistory(const QString &filename, double period) -> bool {
+    if ((m_captureReader) || (m_routeHostAddress.isNull())) {
+        return false;
+    }
+
+    auto results = QVector<QPair<int, Nedrysoft::RouteAnalyser::PingResult> >();
+
+    for (auto hopIndex=0;hopIndex<m_pingData.count();hopIndex++) {
+        auto pingData = m_pingData.at(hopIndex);
+        auto timeSeries = pingData->timeSeries();
+
+        if ((!pingData->hopValid()) || (!timeSeries)) {
+            continue;
+        }
+
+        for (auto index=timeSeries->lowerBound(m_endPoint-period);index<timeSeries->count();index++) {
+            auto roundTripTime = timeSeries->roundTripTime(index);
+
+            results.append(qMakePair(hopIndex+1, Nedrysoft::RouteAnalyser::PingResult(
+                0,
+                timeSeries->code(index),
+                pingData->address(),
+                static_cast<qint64>(timeSeries->time(index)*NanosecondsInSecond),
+                (roundTripTime<0) ? -1 : static_cast<qint64>(roundTripTime*NanosecondsInSecond),
+                nullptr,
+                hopIndex+1
+            )));
+        }
+    }
+
+    // the capture stores the time from the previous record, so the hops are interleaved back into time order.
+
+    std::stable_sort(results.begin(), results.end(), [](const auto &first, const auto &second) {
+        return first.second.requestTimestamp()<second.second.requestTimestamp();
+    });
+
+    Nedrysoft::RouteAnalyser::CaptureWriter captureWriter;
+
+    if (!captureWriter.open(filename, m_targetHost, m_ipVersion, m_interval, m_routeHostAddress, currentRoute())) {
+        return false;
+    }
+
+    for (auto &result : results) {
+        captureWriter.append(result.first, result.second);
+    }
+
+    captureWriter.close();
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setHistoryFile(const QString &filename) -> void {
+    Nedrysoft::RouteAnalyser::CaptureReader captureReader;
+
+    m_history.clear();
+
+    if ((!captureReader.open(filename)) || (captureReader.ipVersion()!=m_ipVersion)) {
+        return;
+    }
+
+    auto route = captureReader.route();
+    auto samples = QVector<Nedrysoft::RouteAnalyser::CaptureSample>();
+
+    for (auto block=0;block<captureReader.blockCount();block++) {
+        if (!captureReader.readBlock(block, samples)) {
+            continue;
+        }
+
+        for (auto &sample : samples) {
+            m_history.append(Nedrysoft::RouteAnalyser::PingResult(
+                0,
+                sample.code,
+                route.value(sample.hop-1),
+                sample.requestTimestamp,
+                sample.roundTripTime,
+                nullptr,
+                sample.hop
+            ));
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::loadHistory() -> void {
+    /**
+     * the history is passed through the statistics worker like the samples of a capture, so the table and the
+     * plots are populated before the first live result arrives.  A hop whose address has changed since the history
+     * was saved starts empty.
+     */
+
+    for (auto &result : m_history) {
+        auto hopIndex = result.hops()-1;
+
+        if ((hopIndex<0) || (hopIndex>=m_pingData.count())) {
+            continue;
+        }
+
+        if (m_pingData.at(hopIndex)->address()!=result.hostAddress()) {
+            continue;
+        }
+
+        m_statisticsWorker->publish(hopIndex, result);
+    }
+
+    m_history.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setRenderingSuspended(bool suspended) -> void {
+    if ((suspended==m_renderingSuspended) || ((!suspended) && (m_viewsReleased))) {
+        return;
+    }
+
+    m_renderingSuspended = suspended;
+
+    Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->setSuspended(m_tableModel, suspended);
+
+    if (suspended) {
+        return;
+    }
+
+    // the results received while suspended are only in the series, the visible state is rebuilt in one pass.
+
+    m_rebuildPlots = true;
+    m_datasetChanged = false;
+
+    updateDataset();
+
+    Nedrysoft::RouteAnalyser::FrameScheduler::getInstance()->update(m_heatmap);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setViewsReleased(bool released) -> void {
+    if (released==m_viewsReleased) {
+        return;
+    }
+
+    if (released) {
+        setRenderingSuspended(true);
+
+        m_viewsReleased = true;
+
+        for (auto pingData : m_pingData) {
+            releasePlot(pingData);
+        }
+
+        for (auto customPlot : m_plotPool) {
+            deletePlot(customPlot);
         }
+
+        m_plotPool.clear();
+
+        return;
+    }
+
+    m_viewsReleased = false;
+
+    // the pool is empty so the plots near the viewport are created again, their data is rebuilt on resuming.
+
+    updateBoundPlots();
+
+    setRenderingSuspended(false);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setRetention(
+        const Nedrysoft::RouteAnalyser::MemoryGovernor::Retention &retention ) -> void {
+
+    Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance()->setRetention(this, retention);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteAnalyserWidget::setHeatmapVisible(bool visible) -> void {
+    m_heatmapVisible = visible;
+
+    // until the route has been discovered the discovery widget is shown in place of either view.
+
+    if (!m_routeDiscoveryWidget->isHidden()) {
+        return;
+    }
+
+    m_heatmap->setVisible(visible);
+    m_scrollArea->setVisible(!visible);
+
+    if (!visible) {
+        QTimer::singleShot(0, this, [this]() {
+            updateBoundPlots();
+        });
     }
 }
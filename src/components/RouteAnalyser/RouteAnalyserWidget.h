@@ -27,13 +27,22 @@
 #pragma warning(push)
 #pragma warning(disable : 4996)
 
+#include "IResultSink.h"
 #include "IRouteEngine.h"
+#include "MemoryGovernor.h"
 #include "PingData.h"
 #include "PingResult.h"
 #include "QCustomPlot/qcustomplot.h"
+#include "RouteAnalyserSpec.h"
+#include "RouteImageRenderer.h"
+#include "StatisticsWorker.h"
 
+#include <Diagnostics>
 #include <QMap>
 #include <QPair>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
 #include <QWidget>
 
 #pragma warning(pop)
@@ -42,20 +51,33 @@ namespace Nedrysoft { namespace Core {
     class IHostMasker;
 }}
 
+class QLabel;
 class QTableView;
-class QStandardItemModel;
 class QSplitter;
 class QScrollArea;
+class QVBoxLayout;
 class Timer;
 
 namespace Nedrysoft { namespace RouteAnalyser {
+    class BarChart;
+    class HopTimeSeries;
+    class SeriesGraph;
+    class SmokeChart;
+    class CaptureReader;
+    class CaptureWriter;
     class GraphLatencyLayer;
     class IPingEngine;
     class IPingEngineFactory;
+    class IPlotFactory;
     class PlotScrollArea;
+    class RecordingStage;
+    class ResultPipeline;
     class RouteTableItemDelegate;
+    class RouteTableModel;
     class RouteDiscoveryWidget;
+    class RouteHeatmapWidget;
     class RouteAnalyserEditor;
+    class SessionJournal;
 
     /**
      * @brief       The RouteAnalyserWidget class provides the main widget for a route analyser.
@@ -63,7 +85,7 @@ namespace Nedrysoft { namespace RouteAnalyser {
      * @details     the widget which is displayed in an editor for a route analysis, includes the table view
      *              showing the current hop information and graphs for all hops which respond.
      */
-    class RouteAnalyserWidget :
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RouteAnalyserWidget :
             public QWidget {
 
         private:
@@ -84,6 +106,10 @@ namespace Nedrysoft { namespace RouteAnalyser {
              * @param[in]   ipVersion the version of ip to be used.
              * @param[in]   interval the interval between pings.
              * @param[in]   pingEngineFactory the ping engine factory to use.
+             * @param[in]   payloadSize the payload size of each echo request.
+             * @param[in]   dontFragment true if echo requests should be sent with the don't fragment flag.
+             * @param[in]   source the source address or interface that requests are sent from, empty for the
+             *              default route.
              * @param[in]   parent the parent widget.
              */
             explicit RouteAnalyserWidget(
@@ -91,6 +117,9 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 Nedrysoft::Core::IPVersion ipVersion,
                 int interval,
                 Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                int payloadSize,
+                bool dontFragment,
+                const QString &source = QString(),
                 QWidget *parent = nullptr
             );
 
@@ -99,13 +128,6 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             ~RouteAnalyserWidget();
 
-            /**
-             * @brief       Called when a ping result is available.
-             *
-             * @param[in]   result the PingResult contains the timing information for the ping.
-             */
-            Q_SLOT void onPingResult(Nedrysoft::RouteAnalyser::PingResult result);
-
             /**
              * @brief       Called when a ping route is available.
              *
@@ -126,6 +148,21 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 const int maximumHops
             );
 
+            /**
+             * @brief       Called when background route monitoring detects that the route has changed.
+             *
+             * @param[in]   routeHostAddress the intended target of the route analysis.
+             * @param[in]   previousRoute the route before the change.
+             * @param[in]   route the new route.
+             * @param[in]   changedHops the hop numbers (starting at 1) that have changed.
+             */
+            Q_SLOT void onRouteChanged(
+                const QHostAddress routeHostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList previousRoute,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const QList<int> changedHops
+            );
+
             /**
              * @brief       This signal is emitted when a watched event on a child fires.
              *
@@ -187,6 +224,169 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto datasetSize(void) -> double;
 
+            /**
+             * @brief       Returns the time series shown as the overview of the session.
+             *
+             * @details     The overview is the destination, or if it has not replied the furthest hop that has.
+             *
+             * @returns     the time series; otherwise nullptr if no hop has any results.
+             */
+            auto overviewSeries() -> const Nedrysoft::RouteAnalyser::HopTimeSeries *;
+
+            /**
+             * @brief       Returns the times of the change points shown on the overview of the session.
+             *
+             * @details     The change points are those of the hop returned by destinationData().
+             *
+             * @returns     the times in seconds since the unix epoch.
+             */
+            auto overviewChangePoints() -> QVector<double>;
+
+            /**
+             * @brief       Returns the hop that represents the destination.
+             *
+             * @details     This is the destination, or if it has not replied the furthest hop that has.
+             *
+             * @returns     the hop; otherwise nullptr if no hop has any results.
+             */
+            auto destinationData() -> Nedrysoft::RouteAnalyser::PingData *;
+
+            /**
+             * @brief       Takes a snapshot of the route for drawing to an image.
+             *
+             * @details     Every hop is included, the graphs cover either the period currently visible in the
+             *              viewport or the whole session and are decimated to the number of columns that fit the
+             *              requested width.  The snapshot is a copy, so it can be drawn by RouteImageRenderer or
+             *              RouteReportWriter on another thread.
+             *
+             * @param[in]   content the parts to draw, a combination of RouteImageRenderer::Content.
+             * @param[in]   width the width of the image in device independent pixels.
+             * @param[in]   dpi the resolution of the image in dots per inch.
+             * @param[in]   maskHosts true if the host names and addresses should be masked; otherwise false.
+             * @param[in]   entireSession true if the graphs should cover the whole session; otherwise false.
+             *
+             * @returns     the snapshot.
+             */
+            auto imageSnapshot(
+                int content,
+                int width,
+                int dpi,
+                bool maskHosts,
+                bool entireSession
+            ) -> Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot;
+
+            /**
+             * @brief       Shows a recorded session capture instead of analysing a live route.
+             *
+             * @details     The widget must have been constructed without a ping engine factory.  The route is
+             *              taken from the capture and the samples are loaded in the background a block at a time,
+             *              only the part of the capture around the viewport is held in memory, moving the viewport
+             *              elsewhere loads that part instead.
+             *
+             * @param[in]   filename the capture file.
+             *
+             * @returns     true if the capture was opened; otherwise false.
+             */
+            auto openCapture(const QString &filename) -> bool;
+
+            /**
+             * @brief       Starts recording the results of the analysis to a session capture.
+             *
+             * @details     The route must have been discovered before recording can start.
+             *
+             * @param[in]   filename the capture file to create.
+             *
+             * @returns     true if recording was started; otherwise false.
+             */
+            auto startRecording(const QString &filename) -> bool;
+
+            /**
+             * @brief       Stops recording and closes the session capture.
+             */
+            auto stopRecording() -> void;
+
+            /**
+             * @brief       Returns whether the results are being recorded.
+             *
+             * @returns     true if recording; otherwise false.
+             */
+            auto isRecording() -> bool;
+
+            /**
+             * @brief       Writes the recent history of a live analysis to a session capture.
+             *
+             * @details     The samples of every hop within the period before the newest sample are written in time
+             *              order, so the capture can be passed to setHistoryFile() when the analysis is reopened.
+             *
+             * @param[in]   filename the capture file to create.
+             * @param[in]   period the length of the history to write in seconds.
+             *
+             * @returns     true if the history was written; otherwise false.
+             */
+            auto saveHistory(const QString &filename, double period) -> bool;
+
+            /**
+             * @brief       Sets whether the hops are probed on engines whose rounds are aligned.
+             *
+             * @details     Analyses of the same target that are aligned and share an interval send their rounds
+             *              together, so their samples can be compared one for one.  Must be called before the
+             *              route has been discovered.
+             *
+             * @param[in]   aligned true to align the rounds; otherwise false.
+             */
+            auto setAligned(bool aligned) -> void;
+
+            /**
+             * @brief       Sets the history that a live analysis starts with.
+             *
+             * @details     The samples are read from the capture straight away, so the file may be removed once
+             *              this returns.  They are added to the hops once the route is known, a hop only receives
+             *              the samples that were recorded for the same address.
+             *
+             * @param[in]   filename the capture written by saveHistory().
+             */
+            auto setHistoryFile(const QString &filename) -> void;
+
+            /**
+             * @brief       Shows the latency of all hops as a heatmap in place of the plots of each hop.
+             *
+             * @details     The heatmap is kept up to date while hidden, so switching views shows the full history.
+             *
+             * @param[in]   visible true to show the heatmap; otherwise false to show the plots.
+             */
+            auto setHeatmapVisible(bool visible) -> void;
+
+            /**
+             * @brief       Suspends or resumes the drawing of the table, plots and heatmap.
+             *
+             * @details     While suspended the results are still added to the time series and statistics of the
+             *              hops, but the plots are not updated or replotted.  On resuming the plot data is rebuilt
+             *              from the time series and the view is updated once.
+             *
+             * @param[in]   suspended true to suspend drawing; otherwise false to resume it.
+             */
+            auto setRenderingSuspended(bool suspended) -> void;
+
+            /**
+             * @brief       Releases or restores the plot widgets of the hops.
+             *
+             * @details     While released drawing is suspended and all of the plot widgets, including the pooled
+             *              ones, are deleted.  Only the time series and statistics of the hops are kept up to date,
+             *              when restored the plots are created again and rebuilt from the time series.
+             *
+             * @param[in]   released true to release the plots; otherwise false to restore them.
+             */
+            auto setViewsReleased(bool released) -> void;
+
+            /**
+             * @brief       Sets how much of the history of the hops is kept in memory.
+             *
+             * @see         Nedrysoft::RouteAnalyser::MemoryGovernor::setRetention
+             *
+             * @param[in]   retention the retention policy.
+             */
+            auto setRetention(const Nedrysoft::RouteAnalyser::MemoryGovernor::Retention &retention) -> void;
+
         protected:
             /**
              * @brief       Reimplements: QObject::eventFilter(QObject *watched, QEvent *event).
@@ -212,6 +412,309 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto updateRanges() -> void;
 
+            /**
+             * @brief       Returns the current route as the address of each hop.
+             *
+             * @returns     the route, a null address for a hop that did not respond.
+             */
+            auto currentRoute() const -> Nedrysoft::RouteAnalyser::RouteList;
+
+            /**
+             * @brief       Starts a new segment of the session journal for the current route.
+             */
+            auto openJournal() -> void;
+
+            /**
+             * @brief       Adds the history set by setHistoryFile() to the hops of the route.
+             */
+            auto loadHistory() -> void;
+
+            /**
+             * @brief       Applies a ping result to the time series and plots.
+             *
+             * @param[in]   result the result to apply.
+             * @param[in]   pingData the hop that the result belongs to.
+             *
+             * @returns     true if the data set was extended and the ranges need updating; otherwise false.
+             */
+            auto processPingResult(
+                    const Nedrysoft::RouteAnalyser::PingResult &result,
+                    Nedrysoft::RouteAnalyser::PingData *pingData
+            ) -> bool;
+
+            /**
+             * @brief       Discards the plot data of a hop that is older than the hop's time series.
+             *
+             * @param[in]   pingData the hop to trim.
+             */
+            auto trimHistory(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Applies the snapshots published by the statistics worker to the table and plots.
+             */
+            auto applySnapshots() -> void;
+
+            /**
+             * @brief       Replaces the plot data of a hop with the samples at the given resolution.
+             *
+             * @details     At a rollup resolution only the rollups within the visible range are plotted, the round
+             *              trip graph shows the minimum and maximum of each pixel column and the timeout bars mark
+             *              columns with loss.
+             *
+             * @param[in]   pingData the hop to update.
+             * @param[in]   level the rollup resolution; otherwise -1 for the raw samples.
+             * @param[in]   min the start of the visible range.
+             * @param[in]   max the end of the visible range.
+             */
+            auto rebuildPlotData(
+                    Nedrysoft::RouteAnalyser::PingData *pingData,
+                    int level,
+                    double min,
+                    double max
+            ) -> void;
+
+            /**
+             * @brief       Refills the latency window of a hop from its time series.
+             *
+             * @details     Called when the length of the viewport changes, as a longer window needs the samples
+             *              that a shorter one has already let go.
+             *
+             * @param[in]   pingData the hop to update.
+             */
+            auto resetLatencyWindow(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Creates a hop plot widget.
+             *
+             * @returns     the new plot.
+             */
+            auto createPlot() -> QCustomPlot *;
+
+            /**
+             * @brief       Binds a plot widget to a hop so that the hop's graph is shown.
+             *
+             * @details     A widget released by another hop is reused if one is available, the plot data is
+             *              rebuilt from the hop's time series.
+             *
+             * @param[in]   pingData the hop to bind.
+             */
+            auto bindPlot(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Creates the extra plots (from the plot factories) for a hop.
+             *
+             * @details     The extra plots are created the first time the hop is bound and then kept, they are
+             *              filled from the hop's time series so that they show the samples received before.
+             *
+             * @param[in]   pingData the hop.
+             */
+            auto createExtraPlots(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Releases the plot widget bound to a hop so that it can be reused by another hop.
+             *
+             * @param[in]   pingData the hop to release.
+             */
+            auto releasePlot(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Adds the title, pre-plot slot and plot slot of a hop to the plot layout.
+             *
+             * @param[in]   pingData the hop.
+             * @param[in]   layout the plot layout, the widgets are added at the end.
+             */
+            auto createPlotSlots(Nedrysoft::RouteAnalyser::PingData *pingData, QVBoxLayout *layout) -> void;
+
+            /**
+             * @brief       Removes the title, pre-plot slot and plot slot of a hop from the plot layout.
+             *
+             * @details     A plot widget bound to the hop is returned to the pool.
+             *
+             * @param[in]   pingData the hop.
+             */
+            auto removePlotSlots(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Places the plot widgets of the hops in the layout in the order of the route.
+             *
+             * @details     The widgets are moved rather than recreated, so the plots of a hop are kept when the
+             *              hops are rearranged by a route change.
+             */
+            auto arrangePlotSlots() -> void;
+
+            /**
+             * @brief       Binds plot widgets to the hops in or near the viewport and releases the others.
+             *
+             * @details     The number of plot widgets (and the cost of replotting them) is proportional to the
+             *              number of hops that are visible rather than the length of the route.
+             */
+            auto updateBoundPlots() -> void;
+
+            /**
+             * @brief       Deletes a plot widget that is not bound to a hop.
+             *
+             * @param[in]   customPlot the plot to delete.
+             */
+            auto deletePlot(QCustomPlot *customPlot) -> void;
+
+            /**
+             * @brief       Updates the change point markers on the plot of a hop.
+             *
+             * @details     The markers are only rebuilt when the change points of the hop differ from those drawn.
+             *
+             * @param[in]   pingData the hop.
+             *
+             * @returns     true if the markers were changed; otherwise false.
+             */
+            auto updateChangePointMarkers(Nedrysoft::RouteAnalyser::PingData *pingData) -> bool;
+
+            /**
+             * @brief       Measures the memory used by the history and plots of the hops for the diagnostics.
+             */
+            auto updateMemoryUsage() -> void;
+
+            /**
+             * @brief       Removes the change point markers from a plot.
+             *
+             * @param[in]   customPlot the plot.
+             */
+            auto removeChangePointMarkers(QCustomPlot *customPlot) -> void;
+
+            /**
+             * @brief       Attributes the latency and loss of the route to the hops that add them.
+             *
+             * @details     Each hop is compared against the previous responsive hop using the aggregates that the
+             *              statistics worker maintains, so a round costs one pass over the hops.
+             *
+             * @see         Nedrysoft::RouteAnalyser::PingData::setAttribution
+             */
+            auto updateAttribution() -> void;
+
+            /**
+             * @brief       Subscribes a hop to the shared hop cache so that it receives results.
+             *
+             * @details     The results are passed to the statistics worker, the plot ranges and table are updated
+             *              when its snapshots are applied.
+             *
+             * @param[in]   pingData the hop to subscribe.
+             * @param[in]   hopAddress the address of the hop, or a null address for a hop that has not answered.
+             */
+            auto subscribeHop(Nedrysoft::RouteAnalyser::PingData *pingData, const QHostAddress &hopAddress) -> void;
+
+            /**
+             * @brief       Sets how often each subscribed hop is probed.
+             *
+             * @details     The destination is probed every round, the other hops are probed at the intermediate
+             *              hop rate from the latency settings unless the destination has recently shown trouble.
+             */
+            auto updateSamplingDivisors() -> void;
+
+            /**
+             * @brief       Returns the name that the results of this widget are reported and baselined under.
+             *
+             * @details     A target traced over several sources at once is reported separately for each one, the
+             *              source is appended to the host in the same way as an IPv6 zone (host%source).
+             *
+             * @returns     the target name.
+             */
+            auto targetName() -> QString;
+
+            /**
+             * @brief       Checks a re-test of a hop that has not answered.
+             *
+             * @details     Each re-test that goes unanswered halves the rate at which the hop is re-tested, down to
+             *              a floor.  Once the hop answers it is monitored at the full rate.
+             *
+             * @param[in]   pingData the silent hop.
+             * @param[in]   result the result.
+             */
+            auto checkSilentHop(
+                Nedrysoft::RouteAnalyser::PingData *pingData,
+                const Nedrysoft::RouteAnalyser::PingResult &result
+            ) -> void;
+
+            /**
+             * @brief       Checks a result for the destination and returns the intermediate hops to the full rate
+             *              if it shows loss or a jump in latency.
+             *
+             * @param[in]   pingData the destination hop.
+             * @param[in]   result the result.
+             */
+            auto checkDestination(
+                Nedrysoft::RouteAnalyser::PingData *pingData,
+                const Nedrysoft::RouteAnalyser::PingResult &result
+            ) -> void;
+
+            /**
+             * @brief       Shows or hides the warning that load on this host is distorting the measurements.
+             */
+            auto updateOverheadWarning() -> void;
+
+            /**
+             * @brief       Updates the plots ranges and notifies listeners that the data set has changed.
+             */
+            auto updateDataset() -> void;
+
+            /**
+             * @brief       Ensures that the part of the capture shown by the viewport is loaded.
+             *
+             * @details     If the visible range is outside of the loaded part of the capture, the hops are cleared
+             *              and the blocks around the visible range are queued for loading.
+             *
+             * @param[in]   min the start of the visible range.
+             * @param[in]   max the end of the visible range.
+             */
+            auto loadCaptureRange(double min, double max) -> void;
+
+            /**
+             * @brief       Decompresses the next queued blocks of the capture and passes their samples to the
+             *              statistics worker.
+             */
+            auto loadCaptureBlocks() -> void;
+
+            /**
+             * @brief       Sets the address, name and location shown for a hop.
+             *
+             * @param[in]   pingData the hop to update.
+             * @param[in]   host the address of the hop, a null address for a hop that did not respond.
+             */
+            auto setHopHost(Nedrysoft::RouteAnalyser::PingData *pingData, const QHostAddress &host) -> void;
+
+            /**
+             * @brief       Sets the autonomous system of a hop from its address.
+             *
+             * @param[in]   pingData the hop to update.
+             */
+            auto setHopAutonomousSystem(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Appends a hop to the route table.
+             *
+             * @param[in]   host the address of the hop, a null address for a hop that did not respond.
+             *
+             * @returns     the data for the new hop.
+             */
+            auto appendHop(const QHostAddress &host) -> Nedrysoft::RouteAnalyser::PingData *;
+
+            /**
+             * @brief       Inserts a hop into the route table.
+             *
+             * @details     The rows below the new hop are not renumbered, the caller updates their hop numbers.
+             *
+             * @param[in]   row the row of the new hop.
+             * @param[in]   host the address of the hop, a null address for a hop that did not respond.
+             *
+             * @returns     the data for the new hop.
+             */
+            auto insertHop(int row, const QHostAddress &host) -> Nedrysoft::RouteAnalyser::PingData *;
+
+            /**
+             * @brief       Removes a hop that has left the route, along with its subscription and plots.
+             *
+             * @param[in]   pingData the hop, it is deleted.
+             */
+            auto removeHop(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
             /**
              * @brief       A map containing the fields that are displayed on the list.
              *
@@ -226,20 +729,69 @@ namespace Nedrysoft { namespace RouteAnalyser {
             QMap<Nedrysoft::RouteAnalyser::IPingTarget *, int> m_targetMap;
             QList<QCustomPlot *> m_plotList;
             QMap<QCustomPlot *, QCPItemStraightLine *> m_graphLines;
-            QMap<QCustomPlot *, QCPBars *> m_barCharts;
-            Nedrysoft::RouteAnalyser::IPingEngine *m_pingEngine = {};
-            QStandardItemModel *m_tableModel;
+            QMap<QCustomPlot *, QList<QCPItemStraightLine *> > m_changePointMarkers;
+            QMap<QCustomPlot *, Nedrysoft::RouteAnalyser::BarChart *> m_barCharts;
+            QMap<QCustomPlot *, Nedrysoft::RouteAnalyser::SmokeChart *> m_smokeCharts;
+            QMap<QCustomPlot *, Nedrysoft::RouteAnalyser::SeriesGraph *> m_seriesGraphs;
+            QMap<QCustomPlot *, int> m_plotLevels;
+            QSet<QCustomPlot *> m_stalePlots;
+            QSet<QCustomPlot *> m_pausedPlots;
+            QMap<PingData *, QWidget *> m_plotSlots;
+            QMap<PingData *, QWidget *> m_extraPlotSlots;
+            QMap<PingData *, QLabel *> m_plotTitles;
+            QMap<PingData *, QList<QWidget *> > m_plotWidgets;
+            QList<Nedrysoft::RouteAnalyser::IPlotFactory *> m_plotFactories;
+            QList<QCustomPlot *> m_plotPool;
+            Nedrysoft::RouteAnalyser::RouteTableModel *m_tableModel;
             QTableView *m_tableView;
             QSplitter *m_splitter;
             PlotScrollArea *m_scrollArea;
             Nedrysoft::RouteAnalyser::RouteDiscoveryWidget *m_routeDiscoveryWidget;
+            Nedrysoft::RouteAnalyser::RouteHeatmapWidget *m_heatmap;
+            bool m_heatmapVisible;
+            QLabel *m_overheadWarningLabel;
             Nedrysoft::RouteAnalyser::IPingEngineFactory *m_pingEngineFactory;
             int m_interval;
+            int m_payloadSize;
+            bool m_dontFragment;
+            QString m_source;
+            bool m_aligned;
             QList<Nedrysoft::RouteAnalyser::GraphLatencyLayer *> m_backgroundLayers;
             Nedrysoft::RouteAnalyser::RouteTableItemDelegate *m_routeGraphDelegate;
             ScaleMode m_graphScaleMode;
             QTimer *m_layerCleanupTimer;
             QList<PingData *> m_pingData;
+            QMap<PingData *, quint64> m_hopSubscriptions;
+            QSet<PingData *> m_destinationHops;
+            QMap<PingData *, int> m_silentHops;
+            QTimer *m_escalationTimer;
+            QTimer *m_memoryTimer;
+            Nedrysoft::Core::MemoryCounter m_historyMemory;
+            Nedrysoft::Core::MemoryCounter m_plotMemory;
+            bool m_escalated;
+            int m_intermediateHopDivisor;
+            int m_probesPerRound;
+            bool m_renderingSuspended;
+            bool m_rebuildPlots;
+            bool m_viewsReleased;
+            QHostAddress m_routeHostAddress;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            bool m_datasetChanged;
+            Nedrysoft::RouteAnalyser::StatisticsWorker *m_statisticsWorker;
+            Nedrysoft::RouteAnalyser::ResultPipeline *m_resultPipeline;
+            Nedrysoft::RouteAnalyser::RecordingStage *m_recordingStage;
+            QString m_targetHost;
+            QList<QPointer<Nedrysoft::RouteAnalyser::IResultSink> > m_resultSinks;
+
+            Nedrysoft::RouteAnalyser::CaptureWriter *m_captureWriter;
+            Nedrysoft::RouteAnalyser::CaptureReader *m_captureReader;
+            Nedrysoft::RouteAnalyser::SessionJournal *m_journal;
+            QVector<Nedrysoft::RouteAnalyser::PingResult> m_history;
+            QTimer *m_captureTimer;
+            int m_captureBlock;
+            int m_captureEndBlock;
+            double m_captureStart;
+            double m_captureEnd;
 
             QList<Nedrysoft::RouteAnalyser::IPlot *> m_extraPlots;
 
@@ -248,6 +800,8 @@ namespace Nedrysoft { namespace RouteAnalyser {
             double m_startPoint;
             double m_endPoint;
             double m_savedDiff;
+            double m_visibleStart;
+            double m_visibleEnd;
 
             //! @endcond
     };
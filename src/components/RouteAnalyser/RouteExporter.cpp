@@ -0,0 +1,819 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteExporter.h"
+
+#include "FlatBufferBuilder.h"
+#include "HopTimeSeries.h"
+#include "PingData.h"
+
+#include <QIODevice>
+#include <QObject>
+#include <QStringList>
+#include <QtEndian>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+constexpr auto ChunkSize = 256*1024;
+constexpr auto NumberBufferSize = 128;
+constexpr auto ColumnSeparator = "  ";
+
+constexpr auto ArrowMagic = "ARROW1";
+constexpr auto ArrowMagicSize = 6;
+constexpr auto ArrowAlignment = 8;
+constexpr auto ArrowContinuation = 0xffffffffu;
+constexpr auto ArrowMetadataVersion = int16_t(4);
+constexpr auto ArrowEndiannessLittle = int16_t(0);
+constexpr auto ArrowEndiannessBig = int16_t(1);
+constexpr auto ArrowHeaderSchema = uint8_t(1);
+constexpr auto ArrowHeaderRecordBatch = uint8_t(3);
+constexpr auto ArrowTypeInt = uint8_t(2);
+constexpr auto ArrowTypeFloatingPoint = uint8_t(3);
+constexpr auto ArrowTypeUtf8 = uint8_t(5);
+constexpr auto ArrowPrecisionSingle = int16_t(1);
+constexpr auto ArrowPrecisionDouble = int16_t(2);
+constexpr auto ArrowBlockSize = 24;
+constexpr auto ArrowColumns = 5;
+
+using FlatBufferOffset = Nedrysoft::RouteAnalyser::FlatBufferBuilder::Offset;
+
+/**
+ * returns the value of a latency in milliseconds as text, an empty string is returned for a latency that is not
+ * yet known.
+ */
+static auto latencyText(double latency) -> QString {
+    if (latency<0) {
+        return QString();
+    }
+
+    return QString("%1").arg(latency*1000.0, 0, 'f', 2);
+}
+
+static auto resultText(Nedrysoft::RouteAnalyser::PingResult::ResultCode code) -> const char * {
+    switch (code) {
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok: {
+            return "ok";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded: {
+            return "time_exceeded";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable: {
+            return "unreachable";
+        }
+
+        case Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited: {
+            return "prohibited";
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return "no_reply";
+}
+
+static auto csvField(const QString &text) -> QByteArray {
+    auto field = text.toUtf8();
+
+    if ((!field.contains(',')) && (!field.contains('"')) && (!field.contains('\n')) && (!field.contains('\r'))) {
+        return field;
+    }
+
+    return "\""+field.replace("\"", "\"\"")+"\"";
+}
+
+static auto jsonString(const QString &text) -> QByteArray {
+    auto string = QByteArray("\"");
+
+    for (auto character : text.toUtf8()) {
+        switch (character) {
+            case '"': {
+                string.append("\\\"");
+                break;
+            }
+
+            case '\\': {
+                string.append("\\\\");
+                break;
+            }
+
+            case '\n': {
+                string.append("\\n");
+                break;
+            }
+
+            case '\r': {
+                string.append("\\r");
+                break;
+            }
+
+            case '\t': {
+                string.append("\\t");
+                break;
+            }
+
+            default: {
+                if (static_cast<unsigned char>(character)<0x20) {
+                    char escape[NumberBufferSize];
+
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(character));
+
+                    string.append(escape);
+                } else {
+                    string.append(character);
+                }
+
+                break;
+            }
+        }
+    }
+
+    return string.append('"');
+}
+
+/**
+ * returns the length rounded up to the alignment of the buffers in an Arrow IPC file.
+ */
+static auto arrowPadded(qint64 length) -> qint64 {
+    return (length+ArrowAlignment-1) & ~static_cast<qint64>(ArrowAlignment-1);
+}
+
+template <typename T>
+static auto appendLittleEndian(std::vector<uint8_t> &data, T value) -> void {
+    auto littleEndian = qToLittleEndian<T>(value);
+    auto bytes = reinterpret_cast<const uint8_t *>(&littleEndian);
+
+    data.insert(data.end(), bytes, bytes+sizeof(T));
+}
+
+static auto arrowInt(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder,
+        int32_t bitWidth,
+        bool isSigned ) -> FlatBufferOffset {
+
+    builder.startTable();
+    builder.addScalar<int32_t>(0, bitWidth);
+    builder.addScalar<uint8_t>(1, isSigned ? 1 : 0);
+
+    return builder.endTable();
+}
+
+static auto arrowFloatingPoint(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder,
+        int16_t precision ) -> FlatBufferOffset {
+
+    builder.startTable();
+    builder.addScalar<int16_t>(0, precision);
+
+    return builder.endTable();
+}
+
+static auto arrowUtf8(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder ) -> FlatBufferOffset {
+
+    builder.startTable();
+
+    return builder.endTable();
+}
+
+static auto arrowField(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder,
+        const char *name,
+        bool nullable,
+        uint8_t typeType,
+        FlatBufferOffset type ) -> FlatBufferOffset {
+
+    auto nameString = builder.createString(name, static_cast<int>(std::strlen(name)));
+
+    // readers expect the children of a field to be present even if there are none.
+
+    auto children = builder.createVector({});
+
+    builder.startTable();
+    builder.addOffset(0, nameString);
+    builder.addScalar<uint8_t>(1, nullable ? 1 : 0);
+    builder.addScalar<uint8_t>(2, typeType);
+    builder.addOffset(3, type);
+    builder.addOffset(5, children);
+
+    return builder.endTable();
+}
+
+/**
+ * the schema is written at the start of the file and again in the footer, the columns are in the order that the
+ * buffers of each record batch are written.
+ */
+static auto arrowSchema(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder ) -> FlatBufferOffset {
+
+    auto fields = builder.createVector({
+        arrowField(
+            builder,
+            "timestamp",
+            false,
+            ArrowTypeFloatingPoint,
+            arrowFloatingPoint(builder, ArrowPrecisionDouble)
+        ),
+        arrowField(builder, "hop", false, ArrowTypeInt, arrowInt(builder, 32, true)),
+        arrowField(builder, "address", false, ArrowTypeUtf8, arrowUtf8(builder)),
+        arrowField(builder, "code", false, ArrowTypeInt, arrowInt(builder, 8, false)),
+        arrowField(builder, "rtt", true, ArrowTypeFloatingPoint, arrowFloatingPoint(builder, ArrowPrecisionSingle))
+    });
+
+    builder.startTable();
+    builder.addScalar<int16_t>(0, (Q_BYTE_ORDER==Q_LITTLE_ENDIAN) ? ArrowEndiannessLittle : ArrowEndiannessBig);
+    builder.addOffset(1, fields);
+
+    return builder.endTable();
+}
+
+static auto arrowMessage(
+        Nedrysoft::RouteAnalyser::FlatBufferBuilder &builder,
+        uint8_t headerType,
+        FlatBufferOffset header,
+        int64_t bodyLength ) -> void {
+
+    builder.startTable();
+    builder.addScalar<int64_t>(3, bodyLength);
+    builder.addOffset(2, header);
+    builder.addScalar<int16_t>(0, ArrowMetadataVersion);
+    builder.addScalar<uint8_t>(1, headerType);
+
+    builder.finish(builder.endTable());
+}
+
+Nedrysoft::RouteAnalyser::RouteExporter::RouteExporter(QIODevice *device, bool maskHosts) :
+        m_device(device),
+        m_maskHosts(maskHosts),
+        m_failed(false),
+        m_position(0) {
+
+    m_buffer.reserve(ChunkSize+NumberBufferSize);
+}
+
+Nedrysoft::RouteAnalyser::RouteExporter::~RouteExporter() {
+    flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::write(const char *data, int length) -> void {
+    m_buffer.append(data, length);
+
+    m_position += length;
+
+    if (m_buffer.size()>=ChunkSize) {
+        flush();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::write(const QString &text) -> void {
+    auto data = text.toUtf8();
+
+    write(data.constData(), data.size());
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::flush() -> bool {
+    if ((!m_failed) && (!m_buffer.isEmpty())) {
+        if (m_device->write(m_buffer)!=m_buffer.size()) {
+            m_failed = true;
+        }
+    }
+
+    /**
+     * resizing rather than clearing keeps the allocation, so the buffer is allocated once per export.
+     */
+
+    m_buffer.resize(0);
+
+    return !m_failed;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::hostAddress(Nedrysoft::RouteAnalyser::PingData *pingData) -> QString {
+    if (!pingData->hopValid()) {
+        return QString();
+    }
+
+    return m_maskHosts ? pingData->maskedHostAddress() : pingData->hostAddress();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::hostName(Nedrysoft::RouteAnalyser::PingData *pingData) -> QString {
+    if (!pingData->hopValid()) {
+        return QString();
+    }
+
+    return m_maskHosts ? pingData->maskedHostName() : pingData->hostName();
+}
+
+/**
+ * the table is held in memory while it is laid out, it only has one row per hop so its size does not depend on
+ * the length of the capture.
+ */
+static auto tableRows(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops,
+        const std::function<QString(Nedrysoft::RouteAnalyser::PingData *)> &address,
+        const std::function<QString(Nedrysoft::RouteAnalyser::PingData *)> &name ) -> QList<QStringList> {
+
+    using Fields = Nedrysoft::RouteAnalyser::PingData::Fields;
+
+    auto rows = QList<QStringList>();
+
+    rows.append(QStringList() <<
+            QObject::tr("Hop") << QObject::tr("Count") << QObject::tr("IP") << QObject::tr("Name") <<
+            QObject::tr("Location") << QObject::tr("AS") << QObject::tr("Avg") << QObject::tr("Min") <<
+            QObject::tr("Max") << QObject::tr("Cur") << QObject::tr("Loss %") << QObject::tr("Median") <<
+            QObject::tr("P95") << QObject::tr("P99") );
+
+    for (auto pingData : hops) {
+        auto row = QStringList() << QString::number(pingData->hop());
+
+        if (!pingData->hopValid()) {
+            rows.append(row);
+
+            continue;
+        }
+
+        row << QString::number(pingData->count()) << address(pingData) << name(pingData) << pingData->location();
+
+        row << (pingData->asNumber() ? QString("AS%1 %2").arg(pingData->asNumber()).arg(pingData->asOwner()) : "");
+
+        for (auto field : {Fields::AverageLatency, Fields::MinimumLatency, Fields::MaximumLatency,
+                           Fields::CurrentLatency}) {
+
+            row << latencyText(pingData->latency(static_cast<int>(field)));
+        }
+
+        row << ((pingData->packetLoss()<0) ? QString() : QString("%1").arg(pingData->packetLoss(), 0, 'f', 2));
+
+        for (auto field : {Fields::MedianLatency, Fields::P95Latency, Fields::P99Latency}) {
+            row << latencyText(pingData->latency(static_cast<int>(field)));
+        }
+
+        rows.append(row);
+    }
+
+    return rows;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeTableAsText(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    auto rows = tableRows(
+            hops,
+            [this](PingData *pingData) { return hostAddress(pingData); },
+            [this](PingData *pingData) { return hostName(pingData); } );
+
+    auto widths = QList<int>();
+
+    for (const auto &row : rows) {
+        for (auto column=0; column<row.count(); column++) {
+            if (column>=widths.count()) {
+                widths.append(0);
+            }
+
+            widths[column] = qMax(widths[column], row.at(column).length());
+        }
+    }
+
+    for (const auto &row : rows) {
+        auto line = QString();
+
+        for (auto column=0; column<row.count(); column++) {
+            if (column) {
+                line.append(ColumnSeparator);
+            }
+
+            line.append(row.at(column).leftJustified(widths.at(column)));
+        }
+
+        write(line.trimmed()+"\n");
+    }
+
+    return flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeTableAsCSV(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    auto rows = tableRows(
+            hops,
+            [this](PingData *pingData) { return hostAddress(pingData); },
+            [this](PingData *pingData) { return hostName(pingData); } );
+
+    for (const auto &row : rows) {
+        auto line = QByteArray();
+
+        for (auto column=0; column<row.count(); column++) {
+            if (column) {
+                line.append(',');
+            }
+
+            line.append(csvField(row.at(column)));
+        }
+
+        line.append('\n');
+
+        write(line.constData(), line.size());
+    }
+
+    return flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeSamplesAsCSV(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    char number[NumberBufferSize];
+
+    write(QString("hop,address,host,time,round_trip_ms,result\n"));
+
+    for (auto pingData : hops) {
+        auto timeSeries = pingData->timeSeries();
+
+        if ((!pingData->hopValid()) || (!timeSeries)) {
+            continue;
+        }
+
+        /**
+         * the columns that are the same for every sample of the hop are formatted once.
+         */
+
+        auto prefix = QByteArray::number(pingData->hop())+","+
+                      csvField(hostAddress(pingData))+","+
+                      csvField(hostName(pingData))+",";
+
+        for (auto index=0; index<timeSeries->count(); index++) {
+            auto roundTripTime = timeSeries->roundTripTime(index);
+            auto code = timeSeries->code(index);
+            int length;
+
+            write(prefix.constData(), prefix.size());
+
+            if (roundTripTime<0) {
+                length = std::snprintf(number, sizeof(number), "%.6f,,%s\n", timeSeries->time(index), resultText(code));
+            } else {
+                length = std::snprintf(
+                        number,
+                        sizeof(number),
+                        "%.6f,%.3f,%s\n",
+                        timeSeries->time(index),
+                        roundTripTime*1000.0,
+                        resultText(code) );
+            }
+
+            write(number, qMin(length, NumberBufferSize-1));
+        }
+
+        if (m_failed) {
+            return false;
+        }
+    }
+
+    return flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeChangePointsAsCSV(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    char number[NumberBufferSize];
+
+    write(QString("hop,address,host,time,before_ms,after_ms\n"));
+
+    for (auto pingData : hops) {
+        if (!pingData->hopValid()) {
+            continue;
+        }
+
+        auto prefix = QByteArray::number(pingData->hop())+","+
+                      csvField(hostAddress(pingData))+","+
+                      csvField(hostName(pingData))+",";
+
+        for (auto &changePoint : pingData->statistics().changePoints()) {
+            auto length = std::snprintf(
+                    number,
+                    sizeof(number),
+                    "%.6f,%.3f,%.3f\n",
+                    changePoint.time,
+                    changePoint.before*1000.0,
+                    changePoint.after*1000.0 );
+
+            write(prefix.constData(), prefix.size());
+            write(number, qMin(length, NumberBufferSize-1));
+        }
+
+        if (m_failed) {
+            return false;
+        }
+    }
+
+    return flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeSamplesAsJSON(
+        const QString &target,
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    char number[NumberBufferSize];
+    auto firstHop = true;
+
+    auto header = "{\n  \"target\": "+jsonString(target)+",\n  \"hops\": [";
+
+    write(header.constData(), header.size());
+
+    for (auto pingData : hops) {
+        auto timeSeries = pingData->timeSeries();
+
+        if ((!pingData->hopValid()) || (!timeSeries)) {
+            continue;
+        }
+
+        auto hopHeader = QByteArray(firstHop ? "\n" : ",\n")+
+                         "    {\n      \"hop\": "+QByteArray::number(pingData->hop())+
+                         ",\n      \"address\": "+jsonString(hostAddress(pingData))+
+                         ",\n      \"host\": "+jsonString(hostName(pingData))+
+                         ",\n      \"samples\": [";
+
+        write(hopHeader.constData(), hopHeader.size());
+
+        firstHop = false;
+
+        for (auto index=0; index<timeSeries->count(); index++) {
+            auto roundTripTime = timeSeries->roundTripTime(index);
+            auto separator = index ? "," : "";
+            auto code = timeSeries->code(index);
+            int length;
+
+            if (roundTripTime<0) {
+                length = std::snprintf(
+                        number,
+                        sizeof(number),
+                        "%s\n        [%.6f, null, \"%s\"]",
+                        separator,
+                        timeSeries->time(index),
+                        resultText(code) );
+            } else {
+                length = std::snprintf(
+                        number,
+                        sizeof(number),
+                        "%s\n        [%.6f, %.3f, \"%s\"]",
+                        separator,
+                        timeSeries->time(index),
+                        roundTripTime*1000.0,
+                        resultText(code) );
+            }
+
+            write(number, qMin(length, NumberBufferSize-1));
+        }
+
+        write(QString(timeSeries->count() ? "\n      ],\n      \"changePoints\": [" : "],\n      \"changePoints\": ["));
+
+        auto &changePoints = pingData->statistics().changePoints();
+
+        for (auto index=0; index<changePoints.count(); index++) {
+            auto length = std::snprintf(
+                    number,
+                    sizeof(number),
+                    "%s\n        [%.6f, %.3f, %.3f]",
+                    index ? "," : "",
+                    changePoints.at(index).time,
+                    changePoints.at(index).before*1000.0,
+                    changePoints.at(index).after*1000.0 );
+
+            write(number, qMin(length, NumberBufferSize-1));
+        }
+
+        write(QString(changePoints.count() ? "\n      ]\n    }" : "]\n    }"));
+
+        if (m_failed) {
+            return false;
+        }
+    }
+
+    write(QString(firstHop ? "]\n}\n" : "\n  ]\n}\n"));
+
+    return flush();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeArrowMessage(
+        const Nedrysoft::RouteAnalyser::FlatBufferBuilder &metadata ) -> int {
+
+    static const char padding[ArrowAlignment] = {};
+
+    /**
+     * a message starts with a continuation marker and the size of the metadata, the metadata is padded so that
+     * the body that follows it is aligned.
+     */
+
+    auto paddedSize = static_cast<int>(arrowPadded(metadata.size()));
+    auto continuation = qToLittleEndian<uint32_t>(ArrowContinuation);
+    auto size = qToLittleEndian<int32_t>(paddedSize);
+
+    write(reinterpret_cast<const char *>(&continuation), sizeof(continuation));
+    write(reinterpret_cast<const char *>(&size), sizeof(size));
+    write(reinterpret_cast<const char *>(metadata.data()), metadata.size());
+    write(padding, paddedSize-metadata.size());
+
+    return static_cast<int>(sizeof(continuation)+sizeof(size))+paddedSize;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteExporter::writeSamplesAsArrow(
+        const QList<Nedrysoft::RouteAnalyser::PingData *> &hops ) -> bool {
+
+    static const char padding[ArrowAlignment] = {};
+
+    struct Buffer {
+        const void *data;
+        qint64 length;
+    };
+
+    auto blocks = std::vector<uint8_t>();
+    auto blockCount = 0;
+
+    write(ArrowMagic, ArrowMagicSize);
+    write(padding, ArrowAlignment-ArrowMagicSize);
+
+    auto schema = Nedrysoft::RouteAnalyser::FlatBufferBuilder();
+
+    arrowMessage(schema, ArrowHeaderSchema, arrowSchema(schema), 0);
+
+    writeArrowMessage(schema);
+
+    for (auto pingData : hops) {
+        auto timeSeries = pingData->timeSeries();
+
+        if ((!pingData->hopValid()) || (!timeSeries)) {
+            continue;
+        }
+
+        auto address = hostAddress(pingData).toUtf8();
+
+        /**
+         * samples that have aged out of the ring are held compressed, they are decoded a block at a time and
+         * written as batches ahead of the raw samples so that the rows remain in time order.
+         */
+
+        auto &archive = timeSeries->archive();
+        auto archived = std::vector<Nedrysoft::RouteAnalyser::CompressedSeries::DecodedBlock>();
+        auto segments = std::vector<Nedrysoft::RouteAnalyser::HopTimeSeries::Segment>();
+
+        for (auto block=0;block<archive.blockCount();block++) {
+            archived.push_back(archive.decode(block));
+        }
+
+        for (auto &decodedBlock : archived) {
+            segments.push_back(Nedrysoft::RouteAnalyser::HopTimeSeries::Segment {
+                decodedBlock.times.data(),
+                decodedBlock.roundTripTimes.data(),
+                decodedBlock.codes.data(),
+                static_cast<int>(decodedBlock.times.size())
+            });
+        }
+
+        for (auto &segment : timeSeries->segments()) {
+            segments.push_back(segment);
+        }
+
+        for (auto &segment : segments) {
+            auto rows = segment.count;
+
+            /**
+             * the hop and address are the same for every row of the batch, only the rtt validity has to be
+             * derived from the samples.
+             */
+
+            auto hopValues = std::vector<int32_t>(rows, pingData->hop());
+            auto addressOffsets = std::vector<int32_t>(rows+1);
+            auto addressData = address.repeated(rows);
+            auto rttValidity = std::vector<uint8_t>((rows+7)/8, 0);
+            auto rttNulls = 0;
+
+            for (auto row=0;row<=rows;row++) {
+                addressOffsets[row] = row*address.size();
+            }
+
+            for (auto row=0;row<rows;row++) {
+                if (segment.roundTripTimes[row]>=0) {
+                    rttValidity[row/8] |= static_cast<uint8_t>(1 << (row%8));
+                } else {
+                    rttNulls++;
+                }
+            }
+
+            Buffer buffers[] = {
+                {nullptr, 0}, {segment.times, rows*static_cast<qint64>(sizeof(double))},
+                {nullptr, 0}, {hopValues.data(), rows*static_cast<qint64>(sizeof(int32_t))},
+                {nullptr, 0}, {addressOffsets.data(), (rows+1)*static_cast<qint64>(sizeof(int32_t))},
+                {addressData.constData(), addressData.size()},
+                {nullptr, 0}, {segment.codes, rows},
+                {rttValidity.data(), rttNulls ? static_cast<qint64>(rttValidity.size()) : 0},
+                {segment.roundTripTimes, rows*static_cast<qint64>(sizeof(float))}
+            };
+
+            auto nodes = std::vector<uint8_t>();
+            auto bufferLayout = std::vector<uint8_t>();
+            auto bodyLength = qint64(0);
+
+            for (auto column=0;column<ArrowColumns;column++) {
+                appendLittleEndian<int64_t>(nodes, rows);
+                appendLittleEndian<int64_t>(nodes, (column==ArrowColumns-1) ? rttNulls : 0);
+            }
+
+            for (auto &buffer : buffers) {
+                appendLittleEndian<int64_t>(bufferLayout, bodyLength);
+                appendLittleEndian<int64_t>(bufferLayout, buffer.length);
+
+                bodyLength += arrowPadded(buffer.length);
+            }
+
+            auto metadata = Nedrysoft::RouteAnalyser::FlatBufferBuilder();
+
+            auto nodeVector = metadata.createStructVector(nodes.data(), 16, ArrowColumns, 8);
+            auto bufferVector = metadata.createStructVector(
+                    bufferLayout.data(),
+                    16,
+                    static_cast<int>(bufferLayout.size()/16),
+                    8 );
+
+            metadata.startTable();
+            metadata.addScalar<int64_t>(0, rows);
+            metadata.addOffset(1, nodeVector);
+            metadata.addOffset(2, bufferVector);
+
+            arrowMessage(metadata, ArrowHeaderRecordBatch, metadata.endTable(), bodyLength);
+
+            auto offset = m_position;
+            auto metadataLength = writeArrowMessage(metadata);
+
+            for (auto &buffer : buffers) {
+                write(static_cast<const char *>(buffer.data), static_cast<int>(buffer.length));
+                write(padding, static_cast<int>(arrowPadded(buffer.length)-buffer.length));
+            }
+
+            appendLittleEndian<int64_t>(blocks, offset);
+            appendLittleEndian<int32_t>(blocks, metadataLength);
+            appendLittleEndian<int32_t>(blocks, 0);
+            appendLittleEndian<int64_t>(blocks, bodyLength);
+
+            blockCount++;
+        }
+
+        if (m_failed) {
+            return false;
+        }
+    }
+
+    /**
+     * the stream is ended with an empty message, followed by the footer which allows the record batches to be
+     * read in any order.
+     */
+
+    auto endOfStream = qToLittleEndian<uint32_t>(ArrowContinuation);
+    auto endOfStreamSize = int32_t(0);
+
+    write(reinterpret_cast<const char *>(&endOfStream), sizeof(endOfStream));
+    write(reinterpret_cast<const char *>(&endOfStreamSize), sizeof(endOfStreamSize));
+
+    auto footer = Nedrysoft::RouteAnalyser::FlatBufferBuilder();
+
+    auto footerSchema = arrowSchema(footer);
+    auto dictionaries = footer.createStructVector(nullptr, ArrowBlockSize, 0, 8);
+    auto recordBatches = footer.createStructVector(blocks.data(), ArrowBlockSize, blockCount, 8);
+
+    footer.startTable();
+    footer.addOffset(1, footerSchema);
+    footer.addOffset(2, dictionaries);
+    footer.addOffset(3, recordBatches);
+    footer.addScalar<int16_t>(0, ArrowMetadataVersion);
+
+    footer.finish(footer.endTable());
+
+    auto footerSize = qToLittleEndian<int32_t>(footer.size());
+
+    write(reinterpret_cast<const char *>(footer.data()), footer.size());
+    write(reinterpret_cast<const char *>(&footerSize), sizeof(footerSize));
+    write(ArrowMagic, ArrowMagicSize);
+
+    return flush();
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEEXPORTER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEEXPORTER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class FlatBufferBuilder;
+    class PingData;
+
+    /**
+     * @brief       The RouteExporter class writes the route table and the sample history of a route to a device.
+     *
+     * @details     Output is built in a fixed size buffer which is written to the device whenever it fills, the
+     *              samples are read straight from the time series of each hop, so the memory used does not depend
+     *              on the length of the capture and a file export runs at the speed of the disk.
+     */
+    class RouteExporter {
+        public:
+            /**
+             * @brief       Constructs a RouteExporter that writes to the given device.
+             *
+             * @param[in]   device the open device to write to.
+             * @param[in]   maskHosts true if the masked host names and addresses should be written.
+             */
+            RouteExporter(QIODevice *device, bool maskHosts);
+
+            /**
+             * @brief       Destroys the RouteExporter, writing any buffered output.
+             */
+            ~RouteExporter();
+
+            /**
+             * @brief       Writes the route table as aligned plain text.
+             *
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeTableAsText(const QList<Nedrysoft::RouteAnalyser::PingData *> &hops) -> bool;
+
+            /**
+             * @brief       Writes the route table as CSV.
+             *
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeTableAsCSV(const QList<Nedrysoft::RouteAnalyser::PingData *> &hops) -> bool;
+
+            /**
+             * @brief       Writes every sample of every hop as CSV, one row per sample.
+             *
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeSamplesAsCSV(const QList<Nedrysoft::RouteAnalyser::PingData *> &hops) -> bool;
+
+            /**
+             * @brief       Writes the change points detected in the latency of every hop as CSV.
+             *
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeChangePointsAsCSV(const QList<Nedrysoft::RouteAnalyser::PingData *> &hops) -> bool;
+
+            /**
+             * @brief       Writes every sample and change point of every hop as a JSON document.
+             *
+             * @param[in]   target the name of the route target.
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeSamplesAsJSON(
+                const QString &target,
+                const QList<Nedrysoft::RouteAnalyser::PingData *> &hops
+            ) -> bool;
+
+            /**
+             * @brief       Writes every sample of every hop as an Apache Arrow IPC file.
+             *
+             * @details     The file has timestamp (seconds since the unix epoch), hop, address, code and rtt
+             *              (seconds, null without a reply) columns.  Each contiguous run of a hop's time series is
+             *              written as a record batch and the timestamp, code and rtt columns are written straight
+             *              from the storage of the series, in the byte order of the host which the schema records.
+             *              The file can be read by pandas (read_feather), pyarrow and DuckDB.
+             *
+             * @param[in]   hops the hops of the route in hop order.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto writeSamplesAsArrow(const QList<Nedrysoft::RouteAnalyser::PingData *> &hops) -> bool;
+
+            /**
+             * @brief       Writes any buffered output to the device.
+             *
+             * @returns     true if the output was written; otherwise false.
+             */
+            auto flush() -> bool;
+
+        private:
+            /**
+             * @brief       Appends raw bytes to the output.
+             *
+             * @param[in]   data the bytes to write.
+             * @param[in]   length the number of bytes.
+             */
+            auto write(const char *data, int length) -> void;
+
+            /**
+             * @brief       Appends a string to the output as UTF-8.
+             *
+             * @param[in]   text the text to write.
+             */
+            auto write(const QString &text) -> void;
+
+            /**
+             * @brief       Writes an Arrow IPC message header, the message body follows it.
+             *
+             * @param[in]   metadata the FlatBuffers encoded message.
+             *
+             * @returns     the size of the header in bytes.
+             */
+            auto writeArrowMessage(const Nedrysoft::RouteAnalyser::FlatBufferBuilder &metadata) -> int;
+
+            /**
+             * @brief       Returns the host address of a hop, masked if required.
+             *
+             * @param[in]   pingData the hop.
+             *
+             * @returns     the address.
+             */
+            auto hostAddress(Nedrysoft::RouteAnalyser::PingData *pingData) -> QString;
+
+            /**
+             * @brief       Returns the host name of a hop, masked if required.
+             *
+             * @param[in]   pingData the hop.
+             *
+             * @returns     the host name.
+             */
+            auto hostName(Nedrysoft::RouteAnalyser::PingData *pingData) -> QString;
+
+        private:
+            //! @cond
+
+            QIODevice *m_device;
+            QByteArray m_buffer;
+            bool m_maskHosts;
+            bool m_failed;
+            qint64 m_position;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEEXPORTER_H
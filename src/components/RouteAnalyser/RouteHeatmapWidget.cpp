@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteHeatmapWidget.h"
+
+#include "LatencySettings.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+constexpr auto HeatmapColumns = 1440;
+constexpr auto EmptyCell = -2.0f;
+constexpr auto LostCell = -1.0f;
+constexpr auto LostColourFactor = 200;
+constexpr auto LabelMargin = 4;
+constexpr auto DefaultColumnInterval = 1.0;
+constexpr auto MinimumHeight = 100;
+
+Nedrysoft::RouteAnalyser::RouteHeatmapWidget::RouteHeatmapWidget(QWidget *parent) :
+        QWidget(parent),
+        m_hopCount(0),
+        m_columnInterval(DefaultColumnInterval),
+        m_newestColumn(0),
+        m_columnCount(0) {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    assert(latencySettings!=nullptr);
+
+    setMinimumHeight(MinimumHeight);
+
+    connect(latencySettings, &Nedrysoft::RouteAnalyser::LatencySettings::coloursChanged, this, [=]() {
+        recolour();
+    });
+
+    connect(latencySettings, &Nedrysoft::RouteAnalyser::LatencySettings::gradientChanged, this, [=](bool) {
+        recolour();
+    });
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::setColumnInterval(double interval) -> void {
+    if (interval>0) {
+        m_columnInterval = interval;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::setHopCount(int hopCount) -> void {
+    if (hopCount==m_hopCount) {
+        return;
+    }
+
+    auto rows = QVector<int>(hopCount);
+
+    for (auto row=0;row<hopCount;row++) {
+        rows[row] = (row<m_hopCount) ? row : -1;
+    }
+
+    moveHops(rows);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::moveHops(const QVector<int> &rows) -> void {
+    auto hopCount = rows.count();
+
+    // the history of the hops that remain is copied into the resized image.
+
+    auto cells = std::vector<float>(static_cast<size_t>(hopCount)*HeatmapColumns, EmptyCell);
+    auto image = QImage(HeatmapColumns, std::max(hopCount, 1), QImage::Format_RGB32);
+
+    image.fill(cellColour(EmptyCell));
+
+    for (auto row=0;row<hopCount;row++) {
+        auto previousRow = rows.at(row);
+
+        if ((previousRow<0) || (previousRow>=m_hopCount)) {
+            continue;
+        }
+
+        std::copy_n(
+            m_cells.begin()+(static_cast<size_t>(previousRow)*HeatmapColumns),
+            HeatmapColumns,
+            cells.begin()+(static_cast<size_t>(row)*HeatmapColumns) );
+
+        memcpy(image.scanLine(row), m_image.constScanLine(previousRow), static_cast<size_t>(image.bytesPerLine()));
+    }
+
+    m_cells = std::move(cells);
+    m_image = image;
+    m_hopCount = hopCount;
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::addResult(
+        int hop,
+        double time,
+        double roundTripTime,
+        bool lost ) -> void {
+
+    if ((hop<0) || (hop>=m_hopCount)) {
+        return;
+    }
+
+    auto column = static_cast<qint64>(std::floor(time/m_columnInterval));
+
+    if (!m_columnCount) {
+        m_newestColumn = column;
+        m_columnCount = 1;
+
+        clearColumn(static_cast<int>(column % HeatmapColumns));
+    } else if (column>m_newestColumn) {
+        // the columns skipped over (rounds in which nothing arrived) are left empty.
+
+        auto advance = std::min<qint64>(column-m_newestColumn, HeatmapColumns);
+
+        for (auto index=advance-1;index>=0;index--) {
+            clearColumn(static_cast<int>((column-index) % HeatmapColumns));
+        }
+
+        m_columnCount = static_cast<int>(std::min<qint64>(m_columnCount+(column-m_newestColumn), HeatmapColumns));
+        m_newestColumn = column;
+    } else if (m_newestColumn-column>=m_columnCount) {
+        return;
+    }
+
+    auto slot = static_cast<int>(column % HeatmapColumns);
+    auto &cell = m_cells[(static_cast<size_t>(hop)*HeatmapColumns)+slot];
+
+    if (lost) {
+        cell = LostCell;
+    } else if ((cell!=LostCell) && (roundTripTime>cell)) {
+        cell = static_cast<float>(roundTripTime);
+    }
+
+    m_image.setPixel(slot, hop, cellColour(cell));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::clearColumn(int slot) -> void {
+    auto colour = cellColour(EmptyCell);
+
+    for (auto hop=0;hop<m_hopCount;hop++) {
+        m_cells[(static_cast<size_t>(hop)*HeatmapColumns)+slot] = EmptyCell;
+
+        m_image.setPixel(slot, hop, colour);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::clear() -> void {
+    std::fill(m_cells.begin(), m_cells.end(), EmptyCell);
+
+    m_image.fill(cellColour(EmptyCell));
+
+    m_columnCount = 0;
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::cellColour(float value) const -> QRgb {
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    if (value==EmptyCell) {
+        return palette().color(QPalette::Base).rgb();
+    }
+
+    if (value==LostCell) {
+        return QColor(latencySettings->criticalColour()).darker(LostColourFactor).rgb();
+    }
+
+    auto warning = latencySettings->warningValue();
+    auto critical = latencySettings->criticalValue();
+
+    if (!latencySettings->gradientFill()) {
+        if (value<warning) {
+            return latencySettings->idealColour();
+        }
+
+        return (value<critical) ? latencySettings->warningColour() : latencySettings->criticalColour();
+    }
+
+    // with the gradient fill the colour is blended between the thresholds, as the graph background is.
+
+    auto blend = [](QRgb from, QRgb to, double factor) {
+        factor = std::max(0.0, std::min(factor, 1.0));
+
+        auto interpolate = [factor](int fromValue, int toValue) {
+            return static_cast<int>(fromValue+((toValue-fromValue)*factor));
+        };
+
+        return qRgb(
+            interpolate(qRed(from), qRed(to)),
+            interpolate(qGreen(from), qGreen(to)),
+            interpolate(qBlue(from), qBlue(to)) );
+    };
+
+    if (value<warning) {
+        return blend(latencySettings->idealColour(), latencySettings->warningColour(), value/warning);
+    }
+
+    if (value<critical) {
+        return blend(
+            latencySettings->warningColour(),
+            latencySettings->criticalColour(),
+            (value-warning)/(critical-warning) );
+    }
+
+    return latencySettings->criticalColour();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::recolour() -> void {
+    for (auto hop=0;hop<m_hopCount;hop++) {
+        for (auto slot=0;slot<HeatmapColumns;slot++) {
+            m_image.setPixel(slot, hop, cellColour(m_cells[(static_cast<size_t>(hop)*HeatmapColumns)+slot]));
+        }
+    }
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteHeatmapWidget::paintEvent(QPaintEvent *event) -> void {
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    if (!m_hopCount) {
+        return;
+    }
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
+    auto labelWidth = fontMetrics().boundingRect(QString::number(m_hopCount)).width()+(LabelMargin*2);
+#else
+    auto labelWidth = fontMetrics().horizontalAdvance(QString::number(m_hopCount))+(LabelMargin*2);
+#endif
+
+    auto mapRect = QRectF(rect().adjusted(labelWidth, 0, 0, 0));
+    auto rowHeight = mapRect.height()/m_hopCount;
+
+    // the hop numbers are only drawn when the rows are tall enough to hold them.
+
+    if (rowHeight>=fontMetrics().height()) {
+        painter.setPen(palette().color(QPalette::Text));
+
+        for (auto hop=0;hop<m_hopCount;hop++) {
+            painter.drawText(
+                QRectF(0, hop*rowHeight, labelWidth-LabelMargin, rowHeight),
+                Qt::AlignRight | Qt::AlignVCenter,
+                QString::number(hop+1) );
+        }
+    }
+
+    if (!m_columnCount) {
+        return;
+    }
+
+    /**
+     * the newest column is drawn at the right hand edge, the ring is unrolled by drawing the columns after the
+     * newest (the oldest) first and then the columns up to and including the newest.
+     */
+
+    auto oldest = static_cast<int>((m_newestColumn+1) % HeatmapColumns);
+    auto columnWidth = mapRect.width()/HeatmapColumns;
+    auto firstPart = HeatmapColumns-oldest;
+
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+    painter.drawImage(
+        QRectF(mapRect.left(), mapRect.top(), columnWidth*firstPart, mapRect.height()),
+        m_image,
+        QRectF(oldest, 0, firstPart, m_hopCount) );
+
+    if (oldest) {
+        painter.drawImage(
+            QRectF(mapRect.left()+(columnWidth*firstPart), mapRect.top(), columnWidth*oldest, mapRect.height()),
+            m_image,
+            QRectF(0, 0, oldest, m_hopCount) );
+    }
+}
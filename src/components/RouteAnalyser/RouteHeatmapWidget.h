@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEHEATMAPWIDGET_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEHEATMAPWIDGET_H
+
+#include <QImage>
+#include <QVector>
+#include <QWidget>
+#include <vector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The RouteHeatmapWidget class shows the latency of every hop of a route in a single image.
+     *
+     * @details     Hops run down the image and time runs across it, each pixel is one round of one hop coloured
+     *              from the latency thresholds, a lost request is drawn in a darkened critical colour.  The image
+     *              holds one pixel per hop per round and is updated a pixel at a time as results arrive, a new
+     *              column is started when the first result of a later round arrives.  The columns are held in a
+     *              ring so that appending never moves the image, the paint event draws the ring in two parts
+     *              scaled to the widget, so the cost of a repaint is fixed however long the route is monitored.
+     */
+    class RouteHeatmapWidget :
+            public QWidget {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new RouteHeatmapWidget.
+             *
+             * @param[in]   parent the owner widget.
+             */
+            explicit RouteHeatmapWidget(QWidget *parent = nullptr);
+
+            /**
+             * @brief       Sets the time covered by each column.
+             *
+             * @param[in]   interval the interval between rounds in seconds.
+             */
+            auto setColumnInterval(double interval) -> void;
+
+            /**
+             * @brief       Sets the number of hops shown, the history of the existing hops is kept.
+             *
+             * @param[in]   hopCount the number of hops.
+             */
+            auto setHopCount(int hopCount) -> void;
+
+            /**
+             * @brief       Rearranges the hops after a route change, the history of each kept hop moves with it.
+             *
+             * @param[in]   rows the previous row of each hop, -1 for a hop that is new to the route.
+             */
+            auto moveHops(const QVector<int> &rows) -> void;
+
+            /**
+             * @brief       Adds a result to the heatmap.
+             *
+             * @details     A column shows the worst result of the round for each hop, a loss is worse than any
+             *              reply.  Results older than the oldest column are ignored.
+             *
+             * @param[in]   hop the index of the hop, 0 is the first hop.
+             * @param[in]   time the request time in seconds since the unix epoch.
+             * @param[in]   roundTripTime the round trip time in seconds, ignored for a lost request.
+             * @param[in]   lost true if the request was not answered; otherwise false.
+             */
+            auto addResult(int hop, double time, double roundTripTime, bool lost) -> void;
+
+            /**
+             * @brief       Removes all columns.
+             */
+            auto clear() -> void;
+
+        protected:
+            /**
+             * @brief       Reimplements: QWidget::paintEvent(QPaintEvent *event).
+             *
+             * @param[in]   event the paint event.
+             */
+            auto paintEvent(QPaintEvent *event) -> void override;
+
+        private:
+            /**
+             * @brief       Returns the colour of a cell.
+             *
+             * @param[in]   value the round trip time of the cell in seconds, or one of the empty or lost markers.
+             *
+             * @returns     the colour.
+             */
+            auto cellColour(float value) const -> QRgb;
+
+            /**
+             * @brief       Redraws every cell of the image, used when the colours or thresholds change.
+             */
+            auto recolour() -> void;
+
+            /**
+             * @brief       Clears the cells of a column.
+             *
+             * @param[in]   slot the column of the image.
+             */
+            auto clearColumn(int slot) -> void;
+
+        private:
+            //! @cond
+
+            QImage m_image;
+            std::vector<float> m_cells;
+            int m_hopCount;
+            double m_columnInterval;
+            qint64 m_newestColumn;
+            int m_columnCount;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEHEATMAPWIDGET_H
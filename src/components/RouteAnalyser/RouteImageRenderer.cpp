@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteImageRenderer.h"
+
+#include <QDateTime>
+#include <QFontMetricsF>
+#include <QObject>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+constexpr auto StandardDpi = 96.0;
+constexpr auto InchesPerMetre = 39.3700787;
+constexpr auto MaximumImageDimension = 32000.0;
+constexpr auto Margin = 16.0;
+constexpr auto TitleHeight = 28.0;
+constexpr auto RowHeight = 20.0;
+constexpr auto CellPadding = 4.0;
+constexpr auto HopColumnWidth = 40.0;
+constexpr auto ValueColumnWidth = 64.0;
+constexpr auto ValueColumns = 8;
+constexpr auto AddressColumnFraction = 0.4;
+constexpr auto SectionSpacing = 12.0;
+constexpr auto GraphTitleHeight = 20.0;
+constexpr auto GraphHeight = 160.0;
+constexpr auto GraphAxisWidth = 56.0;
+constexpr auto GraphTimeHeight = 18.0;
+constexpr auto GraphHeadroom = 1.1;
+constexpr auto LossTickHeight = 4.0;
+constexpr auto MinimumGraphLatency = 0.01;
+constexpr auto BandAlpha = 96;
+constexpr auto HeaderColour = qRgb(0xe0, 0xe0, 0xe0);
+constexpr auto AlternateRowColour = qRgb(0xf4, 0xf4, 0xf4);
+constexpr auto BorderColour = qRgb(0xa0, 0xa0, 0xa0);
+constexpr auto LatencyColour = qRgb(0x20, 0x20, 0x20);
+constexpr auto LossColour = qRgb(0xff, 0x00, 0x00);
+constexpr auto TimeFormat = "yyyy-MM-dd hh:mm:ss";
+
+/**
+ * returns the value of a latency in milliseconds as text, an empty string is returned for a latency that is not
+ * yet known.
+ */
+static auto latencyText(double latency) -> QString {
+    if (latency<0) {
+        return QString();
+    }
+
+    return QString("%1").arg(latency*1000.0, 0, 'f', 2);
+}
+
+static auto timeText(double time) -> QString {
+    return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(time*1000.0)).toString(TimeFormat);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::graphColumns(int width) -> int {
+    return std::max(1, static_cast<int>(width-(Margin*2)-GraphAxisWidth));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::titleHeight() -> double {
+    return TitleHeight;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::rowHeight() -> double {
+    return RowHeight;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::graphHeight() -> double {
+    return GraphTitleHeight+GraphHeight+GraphTimeHeight;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::render(const Snapshot &snapshot) -> QImage {
+    auto drawTable = (snapshot.content & Table)!=0;
+    auto drawGraphs = ((snapshot.content & Graphs)!=0) && (snapshot.end>snapshot.start);
+    auto graphCount = 0;
+
+    for (auto &hop : snapshot.hops) {
+        if (hop.valid) {
+            graphCount++;
+        }
+    }
+
+    auto width = static_cast<double>(snapshot.width);
+    auto height = (Margin*2)+TitleHeight;
+
+    if (drawTable) {
+        height += (RowHeight*(snapshot.hops.count()+1))+SectionSpacing;
+    }
+
+    if (drawGraphs) {
+        height += graphCount*(graphHeight()+SectionSpacing);
+    }
+
+    /**
+     * a painter cannot draw beyond 32767 pixels in either direction, a very long route at a high resolution has its
+     * resolution lowered so that the whole route still fits.
+     */
+
+    auto scale = std::min(
+            snapshot.dpi/StandardDpi,
+            std::min(MaximumImageDimension/width, MaximumImageDimension/height) );
+
+    auto image = QImage(
+            static_cast<int>(std::ceil(width*scale)),
+            static_cast<int>(std::ceil(height*scale)),
+            QImage::Format_ARGB32_Premultiplied );
+
+    image.setDotsPerMeterX(static_cast<int>(scale*StandardDpi*InchesPerMetre));
+    image.setDotsPerMeterY(static_cast<int>(scale*StandardDpi*InchesPerMetre));
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setRenderHint(QPainter::TextAntialiasing, true);
+    painter.scale(scale, scale);
+
+    auto y = Margin;
+    auto contentWidth = width-(Margin*2);
+
+    paintTitle(&painter, snapshot, QRectF(Margin, y, contentWidth, TitleHeight));
+
+    y += TitleHeight;
+
+    if (drawTable) {
+        for (auto row=-1;row<snapshot.hops.count();row++) {
+            paintTableRow(&painter, snapshot, row, QRectF(Margin, y, contentWidth, RowHeight));
+
+            y += RowHeight;
+        }
+
+        y += SectionSpacing;
+    }
+
+    if (drawGraphs) {
+        for (auto &hop : snapshot.hops) {
+            if (!hop.valid) {
+                continue;
+            }
+
+            paintGraph(&painter, snapshot, hop, QRectF(Margin, y, contentWidth, graphHeight()));
+
+            y += graphHeight()+SectionSpacing;
+        }
+    }
+
+    painter.end();
+
+    return image;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::paintTitle(
+        QPainter *painter,
+        const Snapshot &snapshot,
+        const QRectF &rect ) -> void {
+
+    auto font = painter->font();
+
+    painter->save();
+
+    font.setBold(true);
+
+    painter->setFont(font);
+    painter->setPen(Qt::black);
+
+    painter->drawText(
+            rect,
+            Qt::AlignLeft | Qt::AlignVCenter,
+            QString("%1   %2 - %3").arg(snapshot.target).arg(timeText(snapshot.start)).arg(timeText(snapshot.end)) );
+
+    painter->restore();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::paintTableRow(
+        QPainter *painter,
+        const Snapshot &snapshot,
+        int row,
+        const QRectF &rect ) -> void {
+
+    auto cells = QStringList();
+    auto font = painter->font();
+
+    painter->save();
+
+    if (row<0) {
+        font.setBold(true);
+
+        painter->fillRect(rect, QColor(HeaderColour));
+
+        cells << QObject::tr("Hop") << QObject::tr("IP") << QObject::tr("Name") <<
+                 QObject::tr("Avg") << QObject::tr("Min") << QObject::tr("Max") << QObject::tr("Cur") <<
+                 QObject::tr("Loss %") << QObject::tr("P50") << QObject::tr("P95") << QObject::tr("P99");
+    } else {
+        auto &hop = snapshot.hops.at(row);
+
+        if (row%2) {
+            painter->fillRect(rect, QColor(AlternateRowColour));
+        }
+
+        cells << QString::number(hop.hop);
+
+        if (!hop.valid) {
+            cells << QObject::tr("No reply");
+        } else {
+            cells << hop.address << hop.host <<
+                     latencyText(hop.averageLatency) << latencyText(hop.minimumLatency) <<
+                     latencyText(hop.maximumLatency) << latencyText(hop.currentLatency) <<
+                     ((hop.packetLoss<0) ? QString() : QString("%1").arg(hop.packetLoss, 0, 'f', 2)) <<
+                     latencyText(hop.medianLatency) << latencyText(hop.p95Latency) <<
+                     latencyText(hop.p99Latency);
+        }
+    }
+
+    painter->setFont(font);
+    painter->setPen(Qt::black);
+
+    // the host columns share the width left over once the fixed width columns are placed.
+
+    auto textWidth = std::max(0.0, rect.width()-HopColumnWidth-(ValueColumnWidth*ValueColumns));
+    auto addressWidth = textWidth*AddressColumnFraction;
+    auto fontMetrics = QFontMetricsF(font);
+    auto x = rect.left();
+
+    for (auto column=0;column<cells.count();column++) {
+        auto cellWidth = ValueColumnWidth;
+        int alignment = Qt::AlignRight;
+
+        if (column==0) {
+            cellWidth = HopColumnWidth;
+            alignment = Qt::AlignLeft;
+        } else if (column==1) {
+            cellWidth = addressWidth;
+            alignment = Qt::AlignLeft;
+        } else if (column==2) {
+            cellWidth = textWidth-addressWidth;
+            alignment = Qt::AlignLeft;
+        }
+
+        auto cellRect = QRectF(x+CellPadding, rect.top(), cellWidth-(CellPadding*2), rect.height());
+
+        painter->drawText(
+                cellRect,
+                alignment | Qt::AlignVCenter,
+                fontMetrics.elidedText(cells.at(column), Qt::ElideRight, cellRect.width()) );
+
+        x += cellWidth;
+    }
+
+    painter->setPen(QColor(BorderColour));
+    painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+
+    painter->restore();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteImageRenderer::paintGraph(
+        QPainter *painter,
+        const Snapshot &snapshot,
+        const Hop &hop,
+        const QRectF &rect ) -> void {
+
+    auto font = painter->font();
+    auto boldFont = font;
+    auto title = QString(QObject::tr("Hop %1")).arg(hop.hop);
+    auto span = std::max(snapshot.end-snapshot.start, 1.0);
+
+    if (!hop.address.isEmpty()) {
+        title += QString("   %1").arg(hop.address);
+    }
+
+    if ((!hop.host.isEmpty()) && (hop.host!=hop.address)) {
+        title += QString(" (%1)").arg(hop.host);
+    }
+
+    painter->save();
+
+    boldFont.setBold(true);
+
+    painter->setFont(boldFont);
+    painter->setPen(Qt::black);
+
+    painter->drawText(
+            QRectF(rect.left(), rect.top(), rect.width(), GraphTitleHeight),
+            Qt::AlignLeft | Qt::AlignVCenter,
+            title );
+
+    auto graphRect = QRectF(
+            rect.left()+GraphAxisWidth,
+            rect.top()+GraphTitleHeight,
+            rect.width()-GraphAxisWidth,
+            GraphHeight );
+
+    auto maximumLatency = MinimumGraphLatency;
+
+    for (auto &column : hop.columns) {
+        if (column.replied) {
+            maximumLatency = std::max(maximumLatency, column.maximum*GraphHeadroom);
+        }
+    }
+
+    auto latencyToY = [&](double latency) {
+        return graphRect.bottom()-(std::min(latency, maximumLatency)/maximumLatency)*graphRect.height();
+    };
+
+    // the latency levels are drawn as bands behind the graph, as they are on the live plots.
+
+    auto drawBand = [&](double from, double to, QRgb colour) {
+        if (from>=maximumLatency) {
+            return;
+        }
+
+        auto bandColour = QColor(colour);
+
+        bandColour.setAlpha(BandAlpha);
+
+        painter->fillRect(
+                QRectF(QPointF(graphRect.left(), latencyToY(to)), QPointF(graphRect.right(), latencyToY(from))),
+                bandColour );
+    };
+
+    drawBand(0, snapshot.warningLatency, snapshot.idealColour);
+    drawBand(snapshot.warningLatency, snapshot.criticalLatency, snapshot.warningColour);
+    drawBand(snapshot.criticalLatency, maximumLatency, snapshot.criticalColour);
+
+    painter->setFont(font);
+
+    for (auto fraction : {0.0, 0.5, 1.0}) {
+        auto labelY = graphRect.bottom()-(fraction*graphRect.height());
+
+        painter->drawText(
+                QRectF(rect.left(), labelY-(RowHeight/2), GraphAxisWidth-CellPadding, RowHeight),
+                Qt::AlignRight | Qt::AlignVCenter,
+                QString(QObject::tr("%1 ms")).arg(maximumLatency*fraction*1000.0, 0, 'f', 1) );
+    }
+
+    painter->save();
+    painter->setClipRect(graphRect);
+
+    auto latencyPen = QPen(QColor(LatencyColour), 1);
+    auto lossPen = QPen(QColor(LossColour), 1);
+
+    latencyPen.setCosmetic(true);
+    lossPen.setCosmetic(true);
+
+    for (auto &column : hop.columns) {
+        auto x = graphRect.left()+((column.time-snapshot.start)/span)*graphRect.width();
+
+        if (column.replied) {
+            auto top = latencyToY(column.maximum);
+            auto bottom = std::max(latencyToY(column.minimum), top+1.0);
+
+            painter->setPen(latencyPen);
+            painter->drawLine(QPointF(x, top), QPointF(x, bottom));
+        }
+
+        if (column.lost) {
+            painter->setPen(lossPen);
+            painter->drawLine(QPointF(x, graphRect.bottom()), QPointF(x, graphRect.bottom()-LossTickHeight));
+        }
+    }
+
+    painter->restore();
+
+    painter->setPen(QColor(BorderColour));
+    painter->drawRect(graphRect);
+
+    auto timeRect = QRectF(graphRect.left(), graphRect.bottom(), graphRect.width(), GraphTimeHeight);
+
+    painter->setPen(Qt::black);
+    painter->drawText(timeRect, Qt::AlignLeft | Qt::AlignVCenter, timeText(snapshot.start));
+    painter->drawText(timeRect, Qt::AlignRight | Qt::AlignVCenter, timeText(snapshot.end));
+
+    painter->restore();
+}
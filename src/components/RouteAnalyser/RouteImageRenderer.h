@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEIMAGERENDERER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEIMAGERENDERER_H
+
+#include "HopTimeSeries.h"
+#include "RouteAnalyserSpec.h"
+
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+class QPainter;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The RouteImageRenderer class draws the route table and hop graphs to an image.
+     *
+     * @details     The image is drawn from a snapshot of the route rather than by grabbing the widgets, so every hop
+     *              is included whether or not it is scrolled into view.  The snapshot holds copies of the values and
+     *              the decimated columns of each hop, it is taken on the GUI thread and can then be rendered on any
+     *              thread while the session carries on.  The parts of the image are also drawn individually by
+     *              RouteReportWriter, which lays them out across pages.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RouteImageRenderer {
+        public:
+            /**
+             * @brief       The parts of the route that are drawn.
+             */
+            enum Content {
+                Table = 0x01,
+                Graphs = 0x02
+            };
+
+            /**
+             * @brief       The values and graph of a single hop.
+             */
+            struct Hop {
+                int hop;                                                        //!< the hop number.
+                bool valid;                                                     //!< true if the hop responds.
+                QString address;                                                //!< the address of the hop.
+                QString host;                                                   //!< the host name of the hop.
+                double averageLatency;                                          //!< seconds; -1 if unknown.
+                double minimumLatency;                                          //!< seconds; -1 if unknown.
+                double maximumLatency;                                          //!< seconds; -1 if unknown.
+                double currentLatency;                                          //!< seconds; -1 if unknown.
+                double packetLoss;                                              //!< percent; -1 if unknown.
+                double medianLatency;                                           //!< seconds; -1 if unknown.
+                double p95Latency;                                              //!< seconds; -1 if unknown.
+                double p99Latency;                                              //!< seconds; -1 if unknown.
+                std::vector<Nedrysoft::RouteAnalyser::HopTimeSeries::Column> columns;  //!< the graph columns.
+            };
+
+            /**
+             * @brief       The state of the route at the time of the snapshot.
+             */
+            struct Snapshot {
+                QString target;                     //!< the name of the target.
+                double start;                       //!< the start of the graphs in seconds since the unix epoch.
+                double end;                         //!< the end of the graphs in seconds since the unix epoch.
+                double warningLatency;              //!< the latency in seconds at which the warning level starts.
+                double criticalLatency;             //!< the latency in seconds at which the critical level starts.
+                QRgb idealColour;                   //!< the colour of the ideal level.
+                QRgb warningColour;                 //!< the colour of the warning level.
+                QRgb criticalColour;                //!< the colour of the critical level.
+                int content;                        //!< the parts to draw, a combination of Content.
+                int width;                          //!< the width of the image in device independent pixels.
+                int dpi;                            //!< the resolution of the image in dots per inch.
+                QVector<Hop> hops;                  //!< the hops in hop order.
+            };
+
+        public:
+            /**
+             * @brief       Returns the number of graph columns that a snapshot of the given width should hold.
+             *
+             * @param[in]   width the width of the image in device independent pixels.
+             *
+             * @returns     the number of columns.
+             */
+            static auto graphColumns(int width) -> int;
+
+            /**
+             * @brief       Draws a snapshot to an image.
+             *
+             * @note        This may be called from any thread.
+             *
+             * @param[in]   snapshot the snapshot to draw.
+             *
+             * @returns     the image.
+             */
+            static auto render(const Snapshot &snapshot) -> QImage;
+
+            /**
+             * @brief       Returns the height of the title.
+             *
+             * @returns     the height in device independent pixels.
+             */
+            static auto titleHeight() -> double;
+
+            /**
+             * @brief       Returns the height of a row of the table, including the header row.
+             *
+             * @returns     the height in device independent pixels.
+             */
+            static auto rowHeight() -> double;
+
+            /**
+             * @brief       Returns the height of the graph of a hop, including its title and time labels.
+             *
+             * @returns     the height in device independent pixels.
+             */
+            static auto graphHeight() -> double;
+
+            /**
+             * @brief       Draws the title of a snapshot.
+             *
+             * @param[in]   painter the painter to draw with.
+             * @param[in]   snapshot the snapshot.
+             * @param[in]   rect the area of the title.
+             */
+            static auto paintTitle(QPainter *painter, const Snapshot &snapshot, const QRectF &rect) -> void;
+
+            /**
+             * @brief       Draws a row of the table.
+             *
+             * @param[in]   painter the painter to draw with.
+             * @param[in]   snapshot the snapshot.
+             * @param[in]   row the index of the hop in the snapshot; -1 for the header row.
+             * @param[in]   rect the area of the row.
+             */
+            static auto paintTableRow(QPainter *painter, const Snapshot &snapshot, int row, const QRectF &rect) -> void;
+
+            /**
+             * @brief       Draws the graph of a hop.
+             *
+             * @param[in]   painter the painter to draw with.
+             * @param[in]   snapshot the snapshot.
+             * @param[in]   hop the hop.
+             * @param[in]   rect the area of the graph, including its title and time labels.
+             */
+            static auto paintGraph(
+                QPainter *painter,
+                const Snapshot &snapshot,
+                const Hop &hop,
+                const QRectF &rect
+            ) -> void;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEIMAGERENDERER_H
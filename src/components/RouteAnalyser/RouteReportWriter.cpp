@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteReportWriter.h"
+
+#include <QObject>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <cmath>
+
+constexpr auto StandardDpi = 96.0;
+constexpr auto PointsPerInch = 72.0;
+constexpr auto ReportResolution = 300;
+constexpr auto PageMargin = 10.0;
+constexpr auto SectionSpacing = 12.0;
+constexpr auto FooterHeight = 16.0;
+constexpr auto Creator = "Pingnoo";
+
+Nedrysoft::RouteAnalyser::RouteReportWriter::RouteReportWriter(QIODevice *device) :
+        m_device(device) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::RouteReportWriter::setTitle(const QString &title) -> void {
+    m_title = title;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteReportWriter::pageLayout() -> QPageLayout {
+    return QPageLayout(
+            QPageSize(QPageSize::A4),
+            QPageLayout::Landscape,
+            QMarginsF(PageMargin, PageMargin, PageMargin, PageMargin),
+            QPageLayout::Millimeter );
+}
+
+auto Nedrysoft::RouteAnalyser::RouteReportWriter::pageWidth() -> int {
+    return static_cast<int>(std::floor(pageLayout().paintRect(QPageLayout::Point).width()*StandardDpi/PointsPerInch));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteReportWriter::write(
+        const QVector<Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot> &snapshots) -> bool {
+
+    if ((!m_device) || (!m_device->isWritable())) {
+        return false;
+    }
+
+    QPdfWriter pdfWriter(m_device);
+
+    pdfWriter.setPageLayout(pageLayout());
+    pdfWriter.setResolution(ReportResolution);
+    pdfWriter.setCreator(Creator);
+    pdfWriter.setTitle(m_title);
+
+    QPainter painter;
+
+    if (!painter.begin(&pdfWriter)) {
+        return false;
+    }
+
+    /**
+     * the painter works in device independent pixels so that the parts are laid out at the same sizes as they are
+     * in an image, the origin of each page is the top left of its printable area.
+     */
+
+    auto scale = ReportResolution/StandardDpi;
+
+    painter.scale(scale, scale);
+
+    auto width = pdfWriter.width()/scale;
+    auto bottom = (pdfWriter.height()/scale)-FooterHeight;
+    auto page = 1;
+    auto y = 0.0;
+    auto target = QString();
+
+    auto paintFooter = [&]() {
+        auto footerRect = QRectF(0, bottom, width, FooterHeight);
+
+        painter.setPen(Qt::black);
+        painter.drawText(footerRect, Qt::AlignLeft | Qt::AlignBottom, target);
+        painter.drawText(footerRect, Qt::AlignRight | Qt::AlignBottom, QString(QObject::tr("Page %1")).arg(page));
+    };
+
+    auto newPage = [&]() {
+        paintFooter();
+
+        pdfWriter.newPage();
+
+        page++;
+        y = 0;
+    };
+
+    for (auto index=0;index<snapshots.count();index++) {
+        auto &snapshot = snapshots.at(index);
+
+        if (index) {
+            newPage();
+        }
+
+        target = snapshot.target;
+
+        RouteImageRenderer::paintTitle(&painter, snapshot, QRectF(0, y, width, RouteImageRenderer::titleHeight()));
+
+        y += RouteImageRenderer::titleHeight();
+
+        if (snapshot.content & RouteImageRenderer::Table) {
+            auto rowHeight = RouteImageRenderer::rowHeight();
+
+            RouteImageRenderer::paintTableRow(&painter, snapshot, -1, QRectF(0, y, width, rowHeight));
+
+            y += rowHeight;
+
+            for (auto row=0;row<snapshot.hops.count();row++) {
+                if (y+rowHeight>bottom) {
+                    newPage();
+
+                    RouteImageRenderer::paintTableRow(&painter, snapshot, -1, QRectF(0, y, width, rowHeight));
+
+                    y += rowHeight;
+                }
+
+                RouteImageRenderer::paintTableRow(&painter, snapshot, row, QRectF(0, y, width, rowHeight));
+
+                y += rowHeight;
+            }
+
+            y += SectionSpacing;
+        }
+
+        if ((snapshot.content & RouteImageRenderer::Graphs) && (snapshot.end>snapshot.start)) {
+            auto graphHeight = RouteImageRenderer::graphHeight();
+
+            for (auto &hop : snapshot.hops) {
+                if (!hop.valid) {
+                    continue;
+                }
+
+                if (y+graphHeight>bottom) {
+                    newPage();
+                }
+
+                RouteImageRenderer::paintGraph(&painter, snapshot, hop, QRectF(0, y, width, graphHeight));
+
+                y += graphHeight+SectionSpacing;
+            }
+        }
+    }
+
+    paintFooter();
+
+    return painter.end();
+}
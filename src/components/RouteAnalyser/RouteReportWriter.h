@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEREPORTWRITER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEREPORTWRITER_H
+
+#include "RouteAnalyserSpec.h"
+#include "RouteImageRenderer.h"
+
+#include <QIODevice>
+#include <QPageLayout>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The RouteReportWriter class writes routes to a PDF report.
+     *
+     * @details     The report is laid out page by page from snapshots, each route starts on a new page with its title
+     *              and table (the header is repeated when the table continues onto another page) followed by the
+     *              graph of each hop.  Pages are passed to the PDF writer as they are finished, and the graphs are
+     *              drawn from the decimated columns of the snapshot, so the time taken and the memory used depend on
+     *              the number of hops and the width of the page rather than on the length of the session.
+     *
+     *              No widgets are used, so a report can be written on a worker thread or by the command line tool.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RouteReportWriter {
+        public:
+            /**
+             * @brief       Constructs a RouteReportWriter.
+             *
+             * @param[in]   device the device to write the report to, this must already be open for writing.
+             */
+            explicit RouteReportWriter(QIODevice *device);
+
+            /**
+             * @brief       Sets the title stored in the document information of the report.
+             *
+             * @param[in]   title the title.
+             */
+            auto setTitle(const QString &title) -> void;
+
+            /**
+             * @brief       Writes the report.
+             *
+             * @param[in]   snapshots the routes to include, each snapshot should have been taken with the width
+             *              returned by pageWidth().
+             *
+             * @returns     true if the report was written; otherwise false.
+             */
+            auto write(const QVector<Nedrysoft::RouteAnalyser::RouteImageRenderer::Snapshot> &snapshots) -> bool;
+
+            /**
+             * @brief       Returns the width of the printable area of a page.
+             *
+             * @returns     the width in device independent pixels.
+             */
+            static auto pageWidth() -> int;
+
+        private:
+            /**
+             * @brief       Returns the layout of a page of the report.
+             *
+             * @returns     the page layout.
+             */
+            static auto pageLayout() -> QPageLayout;
+
+        private:
+            //! @cond
+
+            QIODevice *m_device;
+            QString m_title;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTEREPORTWRITER_H
@@ -24,18 +24,23 @@
 #include "RouteTableItemDelegate.h"
 
 #include "ColourManager.h"
+#include "FidelityGovernor.h"
 #include "LatencySettings.h"
 #include "PingData.h"
+#include "RouteTableModel.h"
 
+#include <Diagnostics>
 #include <IHostMaskerManager>
+#include <Profiler>
 #include <QHeaderView>
 #include <QPainter>
 #include <QPainterPath>
-#include <QPropertyAnimation>
-#include <QStandardItemModel>
+#include <QPixmapCache>
+#include <QStaticText>
 #include <QTableView>
 #include <ThemeSupport>
 #include <cassert>
+#include <iterator>
 
 constexpr auto AverageLatencyRadius = 4;
 constexpr auto CurrentLatencyLength = 3;
@@ -64,6 +69,43 @@ constexpr auto LatencyLineBorderAlphaLevel = 32;
 
 constexpr auto DiscoveryBubbleColour = qRgb(0x80, 0x80, 0x80);
 
+constexpr auto GroupLineIndent = 8;
+constexpr auto GroupLineLength = 6;
+
+static auto pingDataAt(const QModelIndex &index) -> Nedrysoft::RouteAnalyser::PingData * {
+    auto model = qobject_cast<const Nedrysoft::RouteAnalyser::RouteTableModel *>(index.model());
+
+    if (model) {
+        return model->hop(index.row());
+    }
+
+    return index.data(Nedrysoft::RouteAnalyser::RouteTableModel::PingDataRole)
+            .value<Nedrysoft::RouteAnalyser::PingData *>();
+}
+
+static auto lossFormat(
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> Nedrysoft::RouteAnalyser::RouteTableItemDelegate::TextFormat {
+
+    // the loss of a hop that rate limits its responses is marked so that it is not mistaken for forwarding loss.
+
+    if (pingData->isRateLimited()) {
+        return Nedrysoft::RouteAnalyser::RouteTableItemDelegate::RateLimitedLossText;
+    }
+
+    return Nedrysoft::RouteAnalyser::RouteTableItemDelegate::LossText;
+}
+
+/**
+ * @brief       Returns the key of a cell in the text cache.
+ *
+ * @param[in]   index the model index of the cell.
+ *
+ * @returns     the key.
+ */
+static auto cellKey(const QModelIndex &index) -> quint64 {
+    return (static_cast<quint64>(static_cast<quint32>(index.row()))<<32) | static_cast<quint32>(index.column());
+}
+
 Nedrysoft::RouteAnalyser::RouteTableItemDelegate::RouteTableItemDelegate(QWidget *parent) :
         QStyledItemDelegate(parent) {
 
@@ -74,6 +116,10 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
         const QStyleOptionViewItem &option,
         const QModelIndex &index ) const -> void {
 
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Route table cell paint (ms)");
+
+    PINGNOO_PROFILE_ZONE("Route table cell paint");
+
     if (!index.isValid()) {
         QStyledItemDelegate::paint(painter, option, index);
 
@@ -86,7 +132,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
         return;
     }
 
-    auto pingData = index.sibling(index.row(), 0).data(Qt::UserRole + 1).value<Nedrysoft::RouteAnalyser::PingData *>();
+    auto pingData = pingDataAt(index);
 
     if (!pingData->hopValid() && ( static_cast<PingData::Fields>(index.column()) != PingData::Fields::Graph )) {
         paintInvalidHop(pingData, painter, option, index);
@@ -119,6 +165,12 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             break;
         }
 
+        case PingData::Fields::AutonomousSystem: {
+            paintAutonomousSystem(pingData, painter, option, index);
+
+            break;
+        }
+
         case PingData::Fields::IP: {
             auto hostMaskerManager = Nedrysoft::Core::IHostMaskerManager::getInstance();
 
@@ -153,8 +205,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             if (pingData->m_minimumLatency==-1) {
                 paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
             } else {
-                paintText(QString("%1").arg(
-                    pingData->m_minimumLatency*1000.0, 2, 'f', 2),
+                paintText(cellText(index, pingData->m_minimumLatency, LatencyText),
                     painter,
                     option,
                     index,
@@ -172,8 +223,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             } else {
                 paintBackground(pingData, painter, option, index);
 
-                paintText(QString("%1").arg(
-                    pingData->m_maximumLatency*1000.0, 0, 'f', 2),
+                paintText(cellText(index, pingData->m_maximumLatency, LatencyText),
                     painter,
                     option,
                     index,
@@ -191,8 +241,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             if (pingData->m_averageLatency==-1) {
                 paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
             } else {
-                paintText(QString("%1").arg(
-                    pingData->m_averageLatency*1000.0, 0, 'f', 2),
+                paintText(cellText(index, pingData->m_averageLatency, LatencyText),
                     painter,
                     option,
                     index,
@@ -210,8 +259,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             if (pingData->m_currentLatency==-1) {
                 paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
             } else {
-                paintText(QString("%1").arg(
-                    pingData->m_currentLatency*1000.0, 0, 'f', 2),
+                paintText(cellText(index, pingData->m_currentLatency, LatencyText),
                     painter,
                     option,
                     index,
@@ -223,6 +271,109 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
             break;
         }
 
+        case PingData::Fields::MedianLatency:
+        case PingData::Fields::P95Latency:
+        case PingData::Fields::P99Latency:
+        case PingData::Fields::StandardDeviation:
+        case PingData::Fields::Jitter:
+        case PingData::Fields::InterPacketDelayVariation:
+        case PingData::Fields::PacketDelayVariation:
+        case PingData::Fields::ForwardDelay:
+        case PingData::Fields::ReverseDelay:
+        case PingData::Fields::ForwardJitter:
+        case PingData::Fields::ReverseJitter: {
+            auto latency = pingData->latency(index.column());
+
+            paintBackground(pingData, painter, option, index);
+
+            if (latency==-1) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                paintText(cellText(index, latency, LatencyText),
+                    painter,
+                    option,
+                    index,
+                    false,
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
+        case PingData::Fields::AddedLatency: {
+            auto latency = pingData->latency(index.column());
+
+            paintBackground(pingData, painter, option, index);
+
+            if (latency==-1) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                paintText(cellText(index, latency, SignedLatencyText),
+                    painter,
+                    option,
+                    index,
+                    false,
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
+        case PingData::Fields::AddedLoss: {
+            auto packetLoss = pingData->addedLoss();
+
+            paintBackground(pingData, painter, option, index);
+
+            if (packetLoss==-1) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                /**
+                 * loss that persists downstream is drawn in bold, loss that the hop shows but which does not
+                 * persist is the hop not answering probes addressed to it and is marked as such.
+                 */
+
+                paintText(
+                    cellText(index, packetLoss, pingData->hasLocalLoss() ? LocalLossText : LossText),
+                    painter,
+                    option,
+                    index,
+                    packetLoss>0,
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
+        case PingData::Fields::BaselineLatency:
+        case PingData::Fields::BaselineDeviation: {
+            auto latency = pingData->latency(index.column());
+            auto isDeviation = (static_cast<PingData::Fields>(index.column())==PingData::Fields::BaselineDeviation);
+
+            paintBackground(pingData, painter, option, index);
+
+            if (latency==-1) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                /**
+                 * the deviation is signed so that a hop that is faster than usual is distinguishable, a hop that
+                 * has regressed is drawn in bold.
+                 */
+
+                paintText(cellText(index, latency, isDeviation ? SignedLatencyText : LatencyText),
+                    painter,
+                    option,
+                    index,
+                    (isDeviation) && (pingData->isRegression()),
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
         case PingData::Fields::PacketLoss: {
             paintBackground(pingData, painter, option, index);
 
@@ -230,7 +381,47 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
                 paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
             } else {
                 paintText(
-                    QString("%1").arg(pingData->packetLoss(), 2, 'f', 2),
+                    cellText(index, pingData->packetLoss(), lossFormat(pingData)),
+                    painter,
+                    option,
+                    index,
+                    false,
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
+        case PingData::Fields::RecentPacketLoss: {
+            auto packetLoss = pingData->lossStatistics().shortWindowLoss();
+
+            paintBackground(pingData, painter, option, index);
+
+            if (packetLoss==-1) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                paintText(
+                    cellText(index, packetLoss, lossFormat(pingData)),
+                    painter,
+                    option,
+                    index,
+                    false,
+                    Qt::AlignRight | Qt::AlignVCenter
+                );
+            }
+
+            break;
+        }
+
+        case PingData::Fields::LossEpisodes: {
+            paintBackground(pingData, painter, option, index);
+
+            if (pingData->count()==0) {
+                paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
+            } else {
+                paintText(
+                    cellText(index, pingData->lossStatistics().episodes(), CountText),
                     painter,
                     option,
                     index,
@@ -249,7 +440,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paint(
                 paintBubble(pingData, painter, option, index, DiscoveryBubbleColour, InvalidHopLineWidth);
             } else {
                 paintText(
-                    QString("%1").arg(pingData->count()),
+                    cellText(index, pingData->count(), CountText),
                     painter,
                     option,
                     index,
@@ -329,13 +520,93 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintText(
 
     painter->setPen(pen);
 
-    auto elidedText = painter->fontMetrics().elidedText(text, Qt::ElideRight, textRect.width());
+    /**
+     * the text is elided and laid out once and kept with the cell, a repaint of a cell whose text, font and width
+     * are unchanged draws the prepared layout rather than measuring and shaping the text again.
+     */
 
-    painter->drawText(textRect, alignment, elidedText);
+    auto &entry = m_textCache[cellKey(index)];
+    auto font = painter->font();
+
+    if ((entry.layoutText!=text) || (entry.layoutWidth!=textRect.width()) || (entry.layoutFont!=font)) {
+        entry.layoutText = text;
+        entry.layoutWidth = textRect.width();
+        entry.layoutFont = font;
+
+        entry.layout.setText(painter->fontMetrics().elidedText(text, Qt::ElideRight, textRect.width()));
+        entry.layout.setTextFormat(Qt::PlainText);
+        entry.layout.prepare(QTransform(), font);
+    }
+
+    auto layoutSize = entry.layout.size();
+    auto position = QPointF(textRect.left(), textRect.top()+(textRect.height()-layoutSize.height())/2.0);
+
+    if (alignment & Qt::AlignRight) {
+        position.setX(textRect.right()+1-layoutSize.width());
+    } else if (alignment & Qt::AlignHCenter) {
+        position.setX(textRect.left()+(textRect.width()-layoutSize.width())/2.0);
+    }
+
+    painter->drawStaticText(position, entry.layout);
 
     painter->restore();
 }
 
+auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::cellText(
+        const QModelIndex &index,
+        double value,
+        TextFormat format ) const -> QString {
+
+    auto &entry = m_textCache[cellKey(index)];
+
+    if ((entry.format==format) && (entry.value==value) && (!entry.text.isNull())) {
+        return entry.text;
+    }
+
+    entry.value = value;
+    entry.format = format;
+
+    switch (format) {
+        case LatencyText: {
+            entry.text = QString::number(value*1000.0, 'f', 2);
+
+            break;
+        }
+
+        case SignedLatencyText: {
+            entry.text = QString((value>0) ? "+" : "")+QString::number(value*1000.0, 'f', 2);
+
+            break;
+        }
+
+        case LossText: {
+            entry.text = QString::number(value, 'f', 2);
+
+            break;
+        }
+
+        case RateLimitedLossText: {
+            entry.text = QString(QObject::tr("%1 (rate limited)")).arg(value, 2, 'f', 2);
+
+            break;
+        }
+
+        case LocalLossText: {
+            entry.text = QString(QObject::tr("%1 (ICMP only)")).arg(value, 2, 'f', 2);
+
+            break;
+        }
+
+        case CountText: {
+            entry.text = QString::number(static_cast<qint64>(value));
+
+            break;
+        }
+    }
+
+    return entry.text;
+}
+
 auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintBackground(
         Nedrysoft::RouteAnalyser::PingData *pingData,
         QPainter *painter,
@@ -395,6 +666,57 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintLocation(
     }
 }
 
+auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintAutonomousSystem(
+        Nedrysoft::RouteAnalyser::PingData *pingData,
+        QPainter *painter,
+        const QStyleOptionViewItem &option,
+        const QModelIndex &index) const -> void {
+
+    paintBackground(pingData, painter, option, index);
+
+    if (!pingData->asNumber()) {
+        return;
+    }
+
+    auto previousIndex = getSibling(index, -1);
+    auto nextIndex = getSibling(index, 1);
+
+    auto groupedWithPrevious =
+            previousIndex.isValid() && (pingDataAt(previousIndex)->asNumber()==pingData->asNumber());
+
+    auto groupedWithNext = nextIndex.isValid() && (pingDataAt(nextIndex)->asNumber()==pingData->asNumber());
+
+    if (!groupedWithPrevious) {
+        paintText(QString("AS%1 %2").arg(pingData->asNumber()).arg(pingData->asOwner()), painter, option, index);
+
+        return;
+    }
+
+    /**
+     * consecutive hops in the same AS are grouped under the first one, rather than repeating the name the
+     * following rows are joined to it by a line.
+     */
+
+    auto textColour = option.palette.color(QPalette::Text);
+
+    if (option.state & QStyle::State_Selected) {
+        textColour = option.palette.color(QPalette::HighlightedText);
+    }
+
+    auto rect = option.rect;
+    auto x = rect.left()+GroupLineIndent;
+    auto y = rect.center().y();
+
+    painter->save();
+
+    painter->setPen(QPen(textColour, 1));
+
+    painter->drawLine(QPoint(x, rect.top()), QPoint(x, groupedWithNext ? rect.bottom() : y));
+    painter->drawLine(QPoint(x, y), QPoint(x+GroupLineLength, y));
+
+    painter->restore();
+}
+
 auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintInvalidHop(
         Nedrysoft::RouteAnalyser::PingData *pingData,
         QPainter *painter,
@@ -474,7 +796,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintInvalidHop(
 
     if (static_cast<PingData::Fields>(index.column()) == PingData::Fields::Hop) {
         paintText(
-            QString("%1").arg(pingData->hop()),
+            cellText(index, pingData->hop(), CountText),
             painter,
             option,
             index,
@@ -569,7 +891,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintHop(
     paintBubble(pingData, painter, option, index, bubbleColour.rgb());
 
     paintText(
-        QString("%1").arg(pingData->hop()),
+        cellText(index, pingData->hop(), CountText),
         painter,
         option,
         index,
@@ -583,29 +905,40 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::getInterpolatedColour(
         const QMap<double, QRgb> &keyFrames,
         double value) const -> QRgb {
 
-    constexpr auto interpolationTime = 1000.0;
-
-    QVariantAnimation colourInterpolator;
-    auto keyFrameKeys = keyFrames.keys();
-
     value = qMin<double>(qMax<double>(value, 0), 1);
 
     if (keyFrames.contains(value)) {
         return keyFrames.value(value);
     }
 
-    colourInterpolator.setEasingCurve(QEasingCurve::Linear);
-    colourInterpolator.setDuration(static_cast<int>(interpolationTime));
+    /**
+     * the colour is linearly interpolated between the key frames either side of the value, this is equivalent to
+     * a linear QVariantAnimation but avoids constructing one for every cell that is painted.
+     */
+
+    auto upper = keyFrames.lowerBound(value);
 
-    for (const auto &key : keyFrameKeys) {
-        colourInterpolator.setKeyValueAt(key, QColor::fromRgb(keyFrames.value(key)));
+    if (upper==keyFrames.constEnd()) {
+        return keyFrames.isEmpty() ? QRgb() : keyFrames.last();
     }
 
-    colourInterpolator.setCurrentTime(static_cast<int>(value * interpolationTime));
+    if (upper==keyFrames.constBegin()) {
+        return upper.value();
+    }
+
+    auto lower = std::prev(upper);
+    auto factor = (value-lower.key())/(upper.key()-lower.key());
 
-    auto colour = colourInterpolator.currentValue().value<QColor>();
+    auto interpolate = [factor](int from, int to) {
+        return static_cast<int>(qRound(from+((to-from)*factor)));
+    };
 
-    return colour.rgb();
+    return qRgba(
+        interpolate(qRed(lower.value()), qRed(upper.value())),
+        interpolate(qGreen(lower.value()), qGreen(upper.value())),
+        interpolate(qBlue(lower.value()), qBlue(upper.value())),
+        interpolate(qAlpha(lower.value()), qAlpha(upper.value()))
+    );
 }
 
 auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintGraph(
@@ -623,7 +956,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintGraph(
 
     assert(latencySettings!=nullptr);
 
-    auto graphMaxLatency = pingData->tableModel()->property("graphMaxLatency").toDouble();
+    auto graphMaxLatency = pingData->tableModel()->graphMaximumLatency();
 
     if (index.row() & 1) {
         colourFactor = NormalColourFactor+AlternateRowFactor;
@@ -677,139 +1010,16 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintGraph(
         painter->fillRect(blankRect, brush);
     }
 
-    auto rect = thisRect;
-
-    QLinearGradient graphGradient = QLinearGradient(QPoint(rect.left(), rect.y()), QPoint(rect.right(), rect.y()));
-
-    if (idealStop > 1) {
-        graphGradient.setColorAt(
-            0,
-            QColor(latencySettings->idealColour()).darker(colourFactor)
-        );
-
-        graphGradient.setColorAt(
-            1,
-            QColor(latencySettings->idealColour()).darker(colourFactor)
-        );
-    } else {
-        if (warningStop > 1) {
-            if (idealStop < 1) {
-                graphGradient.setColorAt(
-                    0,
-                    QColor(latencySettings->idealColour()).darker(colourFactor)
-                );
-
-                graphGradient.setColorAt(
-                    1,
-                    QColor(latencySettings->warningColour()).darker(colourFactor)
-                );
-
-                if (!latencySettings->gradientFill()) {
-                    graphGradient.setColorAt(
-                        idealStop,
-                        QColor(latencySettings->warningColour()).darker(colourFactor)
-                    );
-
-                    graphGradient.setColorAt(
-                        idealStop-TinyNumber,
-                        QColor(latencySettings->idealColour()).darker(colourFactor)
-                    );
-                }
-            }
-        } else {
-            graphGradient.setColorAt(
-                0,
-                QColor(latencySettings->idealColour()).darker(colourFactor)
-            );
-
-            graphGradient.setColorAt(
-                idealStop,
-                QColor(latencySettings->warningColour()).darker(colourFactor)
-            );
-
-            graphGradient.setColorAt(
-                warningStop,
-                QColor(latencySettings->criticalColour()).darker(colourFactor)
-            );
-
-            graphGradient.setColorAt(
-                1,
-                QColor(latencySettings->criticalColour()).darker(colourFactor)
-            );
-
-            if (!latencySettings->gradientFill()) {
-                graphGradient.setColorAt(
-                    idealStop-TinyNumber,
-                    QColor(latencySettings->idealColour()).darker(colourFactor)
-                );
-
-                graphGradient.setColorAt(
-                    warningStop-TinyNumber,
-                    QColor(latencySettings->warningColour()).darker(colourFactor)
-                );
-            }
-        }
-    }
-
-    painter->fillRect(rect, graphGradient);
-
-    auto endRect = rect;
-    auto floatingPointRect = QRectF(rect);
-
-    endRect.setLeft(rect.right());
-    endRect.setRight(option.rect.right());
-
-    painter->fillRect(endRect, QBrush(graphGradient.stops().last().second));
-
-    // draw the warning and critical lines if they are visible
-
-    if (idealStop < 1) {
-        startPoint = QPointF(
-            floatingPointRect.left()+(idealStop*floatingPointRect.width()),
-            floatingPointRect.top()
-        );
-
-        endPoint = QPointF(
-            floatingPointRect.left()+(idealStop*floatingPointRect.width()),
-            floatingPointRect.bottom()
-        );
-    }
-
-    auto pen = QPen(Qt::DashLine);
-
-    auto themeSupport = Nedrysoft::ThemeSupport::ThemeSupport::getInstance();
-
-    if (themeSupport->isDarkMode()) {
-        pen.setColor(Qt::black);
-    } else {
-        pen.setColor(Qt::lightGray);
-    }
-
-    double dashLength = 0;
-
-    for (auto sectionLength : pen.dashPattern()) {
-        dashLength += sectionLength;
-    }
-
-    pen.setDashOffset(fmod(option.rect.top(), dashLength));
-
-    painter->setPen(pen);
-
-    painter->drawLine(startPoint, endPoint);
-
-    if (warningStop < 1) {
-        startPoint = QPointF(
-            floatingPointRect.left()+(warningStop*floatingPointRect.width()),
-            floatingPointRect.top()
-        );
-
-        endPoint = QPointF(
-            floatingPointRect.left()+(warningStop*floatingPointRect.width()),
-            floatingPointRect.bottom()
-        );
-    }
+    auto background = graphBackground(
+        option,
+        thisRect,
+        colourFactor,
+        idealStop,
+        warningStop,
+        painter->device()->devicePixelRatioF()
+    );
 
-    painter->drawLine(startPoint, endPoint);
+    painter->drawPixmap(thisRect.topLeft(), background);
 
     // draw hop graph item
 
@@ -869,7 +1079,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintGraph(
         }
     }
 
-    if (pingData->tableModel()->property("showHistorical").toBool()) {
+    if (pingData->tableModel()->showHistorical()) {
         drawLatencyLine(
             static_cast<int>(PingData::Fields::HistoricalLatency),
             pingData,
@@ -903,6 +1113,181 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::paintGraph(
     painter->restore();
 }
 
+auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::graphBackground(
+        const QStyleOptionViewItem &option,
+        const QRect &graphRect,
+        int colourFactor,
+        double idealStop,
+        double warningStop,
+        qreal devicePixelRatio) const -> QPixmap {
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+
+    assert(latencySettings!=nullptr);
+
+    // gradients are drawn as solid bands while the drawing quality is lowered.
+
+    auto gradientFill = (latencySettings->gradientFill()) &&
+            (Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->gradientsEnabled());
+
+    auto themeSupport = Nedrysoft::ThemeSupport::ThemeSupport::getInstance();
+    auto pen = QPen(Qt::DashLine);
+
+    if (themeSupport->isDarkMode()) {
+        pen.setColor(Qt::black);
+    } else {
+        pen.setColor(Qt::lightGray);
+    }
+
+    double dashLength = 0;
+
+    for (auto sectionLength : pen.dashPattern()) {
+        dashLength += sectionLength;
+    }
+
+    auto dashOffset = fmod(option.rect.top(), dashLength);
+
+    /**
+     * the background extends from the start of the graph to the right hand edge of the cell, everything that
+     * affects how it is drawn forms part of the key, so a cached background is only reused when it would be
+     * identical to a freshly drawn one.
+     */
+
+    auto size = QSize(option.rect.right()-graphRect.left()+1, option.rect.height());
+
+    auto key = QString("pingnoo-graph-%1x%2-%3-%4-%5-%6-%7-%8-%9")
+            .arg(size.width())
+            .arg(size.height())
+            .arg(devicePixelRatio)
+            .arg(colourFactor)
+            .arg(idealStop)
+            .arg(warningStop)
+            .arg(dashOffset)
+            .arg(QString("%1-%2-%3")
+                .arg(latencySettings->idealColour())
+                .arg(latencySettings->warningColour())
+                .arg(latencySettings->criticalColour()))
+            .arg(QString("%1-%2-%3")
+                .arg(gradientFill)
+                .arg(themeSupport->isDarkMode())
+                .arg(graphRect.width()));
+
+    auto pixmap = QPixmap();
+
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    pixmap = QPixmap(size*devicePixelRatio);
+
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+
+    auto rect = QRect(QPoint(0, 0), graphRect.size());
+
+    QLinearGradient graphGradient = QLinearGradient(QPoint(rect.left(), rect.y()), QPoint(rect.right(), rect.y()));
+
+    if (idealStop > 1) {
+        graphGradient.setColorAt(
+            0,
+            QColor(latencySettings->idealColour()).darker(colourFactor)
+        );
+
+        graphGradient.setColorAt(
+            1,
+            QColor(latencySettings->idealColour()).darker(colourFactor)
+        );
+    } else {
+        if (warningStop > 1) {
+            if (idealStop < 1) {
+                graphGradient.setColorAt(
+                    0,
+                    QColor(latencySettings->idealColour()).darker(colourFactor)
+                );
+
+                graphGradient.setColorAt(
+                    1,
+                    QColor(latencySettings->warningColour()).darker(colourFactor)
+                );
+
+                if (!gradientFill) {
+                    graphGradient.setColorAt(
+                        idealStop,
+                        QColor(latencySettings->warningColour()).darker(colourFactor)
+                    );
+
+                    graphGradient.setColorAt(
+                        idealStop-TinyNumber,
+                        QColor(latencySettings->idealColour()).darker(colourFactor)
+                    );
+                }
+            }
+        } else {
+            graphGradient.setColorAt(
+                0,
+                QColor(latencySettings->idealColour()).darker(colourFactor)
+            );
+
+            graphGradient.setColorAt(
+                idealStop,
+                QColor(latencySettings->warningColour()).darker(colourFactor)
+            );
+
+            graphGradient.setColorAt(
+                warningStop,
+                QColor(latencySettings->criticalColour()).darker(colourFactor)
+            );
+
+            graphGradient.setColorAt(
+                1,
+                QColor(latencySettings->criticalColour()).darker(colourFactor)
+            );
+
+            if (!gradientFill) {
+                graphGradient.setColorAt(
+                    idealStop-TinyNumber,
+                    QColor(latencySettings->idealColour()).darker(colourFactor)
+                );
+
+                graphGradient.setColorAt(
+                    warningStop-TinyNumber,
+                    QColor(latencySettings->warningColour()).darker(colourFactor)
+                );
+            }
+        }
+    }
+
+    painter.fillRect(rect, graphGradient);
+
+    auto endRect = QRect(QPoint(rect.right(), 0), QPoint(size.width()-1, rect.bottom()));
+    auto floatingPointRect = QRectF(rect);
+
+    painter.fillRect(endRect, QBrush(graphGradient.stops().last().second));
+
+    // draw the warning and critical lines if they are visible
+
+    pen.setDashOffset(dashOffset);
+
+    painter.setPen(pen);
+
+    for (auto stop : {idealStop, warningStop}) {
+        if (stop < 1) {
+            painter.drawLine(
+                QPointF(floatingPointRect.left()+(stop*floatingPointRect.width()), floatingPointRect.top()),
+                QPointF(floatingPointRect.left()+(stop*floatingPointRect.width()), floatingPointRect.bottom())
+            );
+        }
+    }
+
+    painter.end();
+
+    QPixmapCache::insert(key, pixmap);
+
+    return pixmap;
+}
+
 auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::drawLatencyLine(
         int field,
         Nedrysoft::RouteAnalyser::PingData *pingData,
@@ -917,7 +1302,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::drawLatencyLine(
     auto startPoint = QPointF();
     auto endPoint = QPointF();
 
-    auto graphMaxLatency = pingData->tableModel()->property("graphMaxLatency").toDouble();
+    auto graphMaxLatency = pingData->tableModel()->graphMaximumLatency();
     const auto tableView = qobject_cast<const QTableView *>(option.widget);
 
     auto previousData = getSiblingData(index, -1, tableView, previousRect);
@@ -1002,7 +1387,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::getSibling(
             break;
         }
 
-        auto pingData = modelIndex.sibling(modelIndex.row(), 0).data(Qt::UserRole + 1).value<PingData *>();
+        auto pingData = pingDataAt(modelIndex);
 
         if (pingData->hopValid()) {
             break;
@@ -1023,7 +1408,7 @@ auto Nedrysoft::RouteAnalyser::RouteTableItemDelegate::getSiblingData(
     if (nextModelIndex.isValid()) {
         rect = tableView->visualRect(nextModelIndex);
 
-        return nextModelIndex.sibling(nextModelIndex.row(), 0).data(Qt::UserRole + 1).value<Nedrysoft::RouteAnalyser::PingData *>();
+        return pingDataAt(nextModelIndex);
     }
 
     return nullptr;
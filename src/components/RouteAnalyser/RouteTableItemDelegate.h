@@ -25,11 +25,14 @@
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTETABLEITEMDELEGATE_H
 
 #include "PingData.h"
+#include <QFont>
+#include <QHash>
 #include <QMap>
+#include <QPixmap>
+#include <QStaticText>
 #include <QStyledItemDelegate>
 #include <cmath>
 
-class QStandardItem;
 class QTableView;
 
 namespace Nedrysoft { namespace RouteAnalyser {
@@ -48,6 +51,19 @@ namespace Nedrysoft { namespace RouteAnalyser {
             };
 
 
+        public:
+            /**
+             * @brief       The ways in which a value is formatted for a cell.
+             */
+            enum TextFormat {
+                LatencyText,                        //! a latency in milliseconds.
+                SignedLatencyText,                  //! a latency in milliseconds with a sign when positive.
+                LossText,                           //! a packet loss percentage.
+                RateLimitedLossText,                //! the loss of a hop that rate limits its responses.
+                LocalLossText,                      //! loss that does not persist past the hop.
+                CountText                           //! a whole number.
+            };
+
         public:
             /**
              * @brief       Constructs a new RouteTableItemDelegate instance which is a child of the parent.
@@ -146,6 +162,24 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 const QModelIndex &index
             ) const -> void;
 
+            /**
+             * @brief       Paints the autonomous system column.
+             *
+             * @details     Hops that are in the same AS as the hop above are drawn as part of a group rather than
+             *              repeating the AS.
+             *
+             * @param[in]   pingData the data for the item.
+             * @param[in]   painter the QPainter to draw to.
+             * @param[in]   option the painter options.
+             * @param[in]   index the model index of the cell.
+             */
+            auto paintAutonomousSystem(
+                Nedrysoft::RouteAnalyser::PingData *pingData,
+                QPainter *painter,
+                const QStyleOptionViewItem &option,
+                const QModelIndex &index
+            ) const -> void;
+
             /**
              * @brief       Paints an invalid hop cell.
              *
@@ -244,9 +278,66 @@ namespace Nedrysoft { namespace RouteAnalyser {
                 const QPen &pen
             ) const -> void;
 
+            /**
+             * @brief       Returns the background of the graph column.
+             *
+             * @details     The background (the latency gradient and the warning and critical lines) only changes
+             *              when the cell size, latency thresholds, colours or selection state change, so it is
+             *              rendered once into a pixmap which is kept in the QPixmapCache and reused for every cell
+             *              that would draw an identical background.
+             *
+             * @param[in]   option the painter options.
+             * @param[in]   graphRect the area of the cell that the graph occupies.
+             * @param[in]   colourFactor the factor used to darken the colours for alternate and selected rows.
+             * @param[in]   idealStop the position of the warning threshold as a fraction of the graph width.
+             * @param[in]   warningStop the position of the critical threshold as a fraction of the graph width.
+             * @param[in]   devicePixelRatio the device pixel ratio of the pixmap.
+             *
+             * @returns     the background pixmap.
+             */
+            auto graphBackground(
+                const QStyleOptionViewItem &option,
+                const QRect &graphRect,
+                int colourFactor,
+                double idealStop,
+                double warningStop,
+                qreal devicePixelRatio
+            ) const -> QPixmap;
+
+            /**
+             * @brief       Returns the text of a value in a cell.
+             *
+             * @details     The text is kept with the cell and only formatted again when the value or the format
+             *              changes.
+             *
+             * @param[in]   index the model index of the cell.
+             * @param[in]   value the value.
+             * @param[in]   format the format of the text.
+             *
+             * @returns     the text.
+             */
+            auto cellText(const QModelIndex &index, double value, TextFormat format) const -> QString;
+
         private:
+            //! @cond
+
+            struct TextCacheEntry {
+                double value = 0;
+                int format = -1;
+                QString text;
+
+                QString layoutText;
+                QFont layoutFont;
+                int layoutWidth = -1;
+                QStaticText layout;
+            };
+
             QMap<Nedrysoft::RouteAnalyser::PingData::Fields, QPersistentModelIndex *> m_maximumMap;
 
+            mutable QHash<quint64, TextCacheEntry> m_textCache;
+
+            //! @endcond
+
     };
 }}
 
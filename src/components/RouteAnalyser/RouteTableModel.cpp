@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteTableModel.h"
+
+#include "ModelUpdateScheduler.h"
+#include "PingData.h"
+
+Nedrysoft::RouteAnalyser::RouteTableModel::RouteTableModel(int columnCount, QObject *parent) :
+        QAbstractTableModel(parent),
+        m_columnCount(columnCount),
+        m_graphMaximumLatency(0),
+        m_graphMinimumLatency(0),
+        m_showHistorical(false) {
+
+}
+
+Nedrysoft::RouteAnalyser::RouteTableModel::~RouteTableModel() {
+    qDeleteAll(m_hops);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::appendHop(Nedrysoft::RouteAnalyser::PingData *pingData) -> void {
+    beginInsertRows(QModelIndex(), m_hops.count(), m_hops.count());
+
+    m_hops.append(pingData);
+
+    m_columns.resize(m_hops.count());
+
+    endInsertRows();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::insertHop(
+        int row,
+        Nedrysoft::RouteAnalyser::PingData *pingData ) -> void {
+
+    row = qBound(0, row, m_hops.count());
+
+    beginInsertRows(QModelIndex(), row, row);
+
+    m_hops.insert(row, pingData);
+
+    m_columns.resize(m_hops.count());
+
+    endInsertRows();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::removeHop(int row) -> void {
+    if ((row<0) || (row>=m_hops.count())) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    delete m_hops.takeAt(row);
+
+    m_columns.resize(m_hops.count());
+
+    endRemoveRows();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::moveHop(int from, int to) -> void {
+    if ((from==to) || (from<0) || (from>=m_hops.count()) || (to<0) || (to>=m_hops.count())) {
+        return;
+    }
+
+    // the destination given to beginMoveRows is the row that the hop is placed before, before it is removed.
+
+    if (!beginMoveRows(QModelIndex(), from, from, QModelIndex(), (to>from) ? to+1 : to)) {
+        return;
+    }
+
+    m_hops.move(from, to);
+
+    endMoveRows();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::hop(int row) const -> Nedrysoft::RouteAnalyser::PingData * {
+    if ((row<0) || (row>=m_hops.count())) {
+        return nullptr;
+    }
+
+    return m_hops.at(row);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::columns() -> Nedrysoft::RouteAnalyser::HopColumns * {
+    return &m_columns;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::updateMaximums() -> void {
+    for (auto row : m_columns.updateMaximums()) {
+        Nedrysoft::RouteAnalyser::ModelUpdateScheduler::getInstance()->invalidate(this, row);
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::graphMaximumLatency() const -> double {
+    return m_graphMaximumLatency;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::graphMinimumLatency() const -> double {
+    return m_graphMinimumLatency;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::updateLatencyRange(double minimum, double maximum) -> bool {
+    if (minimum<m_graphMinimumLatency) {
+        m_graphMinimumLatency = minimum;
+    }
+
+    if (maximum>m_graphMaximumLatency) {
+        m_graphMaximumLatency = maximum;
+
+        return true;
+    }
+
+    return false;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::showHistorical() const -> bool {
+    return m_showHistorical;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::setShowHistorical(bool showHistorical) -> void {
+    m_showHistorical = showHistorical;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::invalidate() -> void {
+    if ((m_hops.isEmpty()) || (!m_columnCount)) {
+        return;
+    }
+
+    Q_EMIT dataChanged(index(0, 0), index(m_hops.count()-1, m_columnCount-1));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::rowCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_hops.count();
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::columnCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_columnCount;
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::data(const QModelIndex &index, int role) const -> QVariant {
+    if ((role!=PingDataRole) || (!index.isValid())) {
+        return QVariant();
+    }
+
+    return QVariant::fromValue<Nedrysoft::RouteAnalyser::PingData *>(hop(index.row()));
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::headerData(
+        int section,
+        Qt::Orientation orientation,
+        int role ) const -> QVariant {
+
+    if (orientation!=Qt::Horizontal) {
+        return QVariant();
+    }
+
+    return m_headerData.value(section).value(role);
+}
+
+auto Nedrysoft::RouteAnalyser::RouteTableModel::setHeaderData(
+        int section,
+        Qt::Orientation orientation,
+        const QVariant &value,
+        int role ) -> bool {
+
+    if ((orientation!=Qt::Horizontal) || (section<0) || (section>=m_columnCount)) {
+        return false;
+    }
+
+    if (role==Qt::EditRole) {
+        role = Qt::DisplayRole;
+    }
+
+    m_headerData[section][role] = value;
+
+    Q_EMIT headerDataChanged(orientation, section, section);
+
+    return true;
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTETABLEMODEL_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTETABLEMODEL_H
+
+#include "HopColumns.h"
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class PingData;
+
+    /**
+     * @brief       The RouteTableModel class provides the model for the route table.
+     *
+     * @details     Each row is a hop, the hops are held in an array indexed by row and are owned by the model.
+     *              The table state that the delegate needs on every paint (the latency range of the graphs and
+     *              whether historical values are shown) is held as typed members rather than as properties, the
+     *              delegate reads the hop of a row directly with hop() instead of through a QVariant.
+     */
+    class RouteTableModel :
+            public QAbstractTableModel {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The role that returns the PingData pointer of a row.
+             */
+            static constexpr int PingDataRole = Qt::UserRole+1;
+
+        public:
+            /**
+             * @brief       Constructs a new RouteTableModel.
+             *
+             * @param[in]   columnCount the number of columns.
+             * @param[in]   parent the owner of the model.
+             */
+            explicit RouteTableModel(int columnCount, QObject *parent = nullptr);
+
+            /**
+             * @brief       Destroys the RouteTableModel and the hops that it holds.
+             */
+            ~RouteTableModel() override;
+
+            /**
+             * @brief       Appends a hop to the table.
+             *
+             * @param[in]   pingData the hop, the model takes ownership.
+             */
+            auto appendHop(Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Inserts a hop into the table.
+             *
+             * @param[in]   row the row of the new hop.
+             * @param[in]   pingData the hop, the model takes ownership.
+             */
+            auto insertHop(int row, Nedrysoft::RouteAnalyser::PingData *pingData) -> void;
+
+            /**
+             * @brief       Removes a hop from the table and deletes it.
+             *
+             * @param[in]   row the row of the hop.
+             */
+            auto removeHop(int row) -> void;
+
+            /**
+             * @brief       Moves a hop to a different row.
+             *
+             * @details     The hop keeps its data, the views move the row rather than rebuild the table.
+             *
+             * @param[in]   from the current row of the hop.
+             * @param[in]   to the new row of the hop.
+             */
+            auto moveHop(int from, int to) -> void;
+
+            /**
+             * @brief       Returns the hop shown on a row.
+             *
+             * @param[in]   row the row.
+             *
+             * @returns     the hop; otherwise nullptr if the row does not exist.
+             */
+            auto hop(int row) const -> Nedrysoft::RouteAnalyser::PingData *;
+
+            /**
+             * @brief       Returns the numeric columns of the hops.
+             *
+             * @returns     the columns, with one row for each hop in the table.
+             */
+            auto columns() -> Nedrysoft::RouteAnalyser::HopColumns *;
+
+            /**
+             * @brief       Finds the hop holding the maximum of each latency column and repaints the rows that change.
+             */
+            auto updateMaximums() -> void;
+
+            /**
+             * @brief       Returns the largest latency of any hop.
+             *
+             * @returns     the latency in seconds.
+             */
+            auto graphMaximumLatency() const -> double;
+
+            /**
+             * @brief       Returns the smallest latency of any hop.
+             *
+             * @returns     the latency in seconds.
+             */
+            auto graphMinimumLatency() const -> double;
+
+            /**
+             * @brief       Extends the latency range of the graphs to include the range of a hop.
+             *
+             * @param[in]   minimum the minimum latency of the hop.
+             * @param[in]   maximum the maximum latency of the hop.
+             *
+             * @returns     true if the maximum has increased; otherwise false.
+             */
+            auto updateLatencyRange(double minimum, double maximum) -> bool;
+
+            /**
+             * @brief       Returns whether the historical latency is drawn on the graphs.
+             *
+             * @returns     true if shown; otherwise false.
+             */
+            auto showHistorical() const -> bool;
+
+            /**
+             * @brief       Sets whether the historical latency is drawn on the graphs.
+             *
+             * @param[in]   showHistorical true to show; otherwise false.
+             */
+            auto setShowHistorical(bool showHistorical) -> void;
+
+            /**
+             * @brief       Notifies the views that every row has changed.
+             */
+            auto invalidate() -> void;
+
+        public:
+            /**
+             * @brief       Reimplements: QAbstractItemModel::rowCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of hops.
+             */
+            auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractItemModel::columnCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of columns.
+             */
+            auto columnCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractItemModel::data(const QModelIndex &index, int role).
+             *
+             * @details     The cells are drawn by the delegate, only PingDataRole returns data.
+             *
+             * @param[in]   index the index.
+             * @param[in]   role the role.
+             *
+             * @returns     the data.
+             */
+            auto data(const QModelIndex &index, int role = Qt::DisplayRole) const -> QVariant override;
+
+            /**
+             * @brief       Reimplements: QAbstractItemModel::headerData(int section, Qt::Orientation orientation,
+             *              int role).
+             *
+             * @param[in]   section the section.
+             * @param[in]   orientation the orientation.
+             * @param[in]   role the role.
+             *
+             * @returns     the data.
+             */
+            auto headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const ->
+                    QVariant override;
+
+            /**
+             * @brief       Reimplements: QAbstractItemModel::setHeaderData(int section, Qt::Orientation orientation,
+             *              const QVariant &value, int role).
+             *
+             * @param[in]   section the section.
+             * @param[in]   orientation the orientation.
+             * @param[in]   value the value.
+             * @param[in]   role the role.
+             *
+             * @returns     true if the data was set; otherwise false.
+             */
+            auto setHeaderData(
+                    int section,
+                    Qt::Orientation orientation,
+                    const QVariant &value,
+                    int role = Qt::EditRole
+            ) -> bool override;
+
+        private:
+            //! @cond
+
+            QVector<Nedrysoft::RouteAnalyser::PingData *> m_hops;
+            Nedrysoft::RouteAnalyser::HopColumns m_columns;
+            QHash<int, QHash<int, QVariant> > m_headerData;
+            int m_columnCount;
+            double m_graphMaximumLatency;
+            double m_graphMinimumLatency;
+            bool m_showHistorical;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_ROUTETABLEMODEL_H
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RunningStatistics.h"
+
+#include <cmath>
+
+Nedrysoft::RouteAnalyser::RunningStatistics::RunningStatistics() :
+        m_count(0),
+        m_mean(0),
+        m_squaredDifferences(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::add(double value) -> void {
+    m_count++;
+
+    auto delta = value-m_mean;
+
+    m_mean += delta/static_cast<double>(m_count);
+    m_squaredDifferences += delta*(value-m_mean);
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::merge(const RunningStatistics &other) -> void {
+    if (!other.m_count) {
+        return;
+    }
+
+    if (!m_count) {
+        *this = other;
+
+        return;
+    }
+
+    auto count = m_count+other.m_count;
+    auto delta = other.m_mean-m_mean;
+
+    m_mean += delta*static_cast<double>(other.m_count)/static_cast<double>(count);
+    m_squaredDifferences += other.m_squaredDifferences+
+            delta*delta*static_cast<double>(m_count)*static_cast<double>(other.m_count)/static_cast<double>(count);
+
+    m_count = count;
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::clear() -> void {
+    m_count = 0;
+    m_mean = 0;
+    m_squaredDifferences = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::count() const -> uint64_t {
+    return m_count;
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::mean() const -> double {
+    return m_count ? m_mean : -1;
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::variance() const -> double {
+    if (m_count<2) {
+        return 0;
+    }
+
+    return m_squaredDifferences/static_cast<double>(m_count-1);
+}
+
+auto Nedrysoft::RouteAnalyser::RunningStatistics::standardDeviation() const -> double {
+    if (m_count<2) {
+        return -1;
+    }
+
+    return std::sqrt(variance());
+}
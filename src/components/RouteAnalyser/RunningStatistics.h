@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_RUNNINGSTATISTICS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_RUNNINGSTATISTICS_H
+
+#include "RouteAnalyserSpec.h"
+
+#include <cstdint>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The RunningStatistics class accumulates the mean and variance of a stream of values.
+     *
+     * @details     The accumulator uses Welford's algorithm, which updates the mean and the sum of squared
+     *              differences from the mean for each value rather than summing the values and their squares,
+     *              so precision does not degrade over millions of samples.
+     *
+     *              Accumulators are merged using the parallel form of the algorithm (Chan et al), so the
+     *              statistics of several windows or hops can be combined without storing the values.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC RunningStatistics {
+        public:
+            /**
+             * @brief       Constructs an empty RunningStatistics.
+             */
+            RunningStatistics();
+
+            /**
+             * @brief       Adds a value.
+             *
+             * @param[in]   value the value to add.
+             */
+            auto add(double value) -> void;
+
+            /**
+             * @brief       Adds the values of another accumulator.
+             *
+             * @param[in]   other the accumulator to merge.
+             */
+            auto merge(const RunningStatistics &other) -> void;
+
+            /**
+             * @brief       Removes all values.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns the number of values.
+             *
+             * @returns     the number of values.
+             */
+            auto count() const -> uint64_t;
+
+            /**
+             * @brief       Returns the mean.
+             *
+             * @returns     the mean; otherwise -1 if no values have been added.
+             */
+            auto mean() const -> double;
+
+            /**
+             * @brief       Returns the sample variance.
+             *
+             * @returns     the variance; otherwise 0 if fewer than two values have been added.
+             */
+            auto variance() const -> double;
+
+            /**
+             * @brief       Returns the sample standard deviation.
+             *
+             * @returns     the standard deviation; otherwise -1 if fewer than two values have been added.
+             */
+            auto standardDeviation() const -> double;
+
+        private:
+            //! @cond
+
+            uint64_t m_count;
+            double m_mean;
+            double m_squaredDifferences;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_RUNNINGSTATISTICS_H
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SampleKernels.h"
+
+#include <algorithm>
+#include <bitset>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PINGNOO_SAMPLEKERNELS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PINGNOO_SAMPLEKERNELS_NEON
+#endif
+
+/**
+ * the result codes Ok (0) and TimeExceeded (2) are replies, every other code is a loss, so a code is lost if any bit
+ * other than bit 1 is set.
+ */
+
+constexpr uint8_t ReplyCodeMask = 0xfd;
+
+auto Nedrysoft::RouteAnalyser::SampleKernels::summarise(
+        const float *roundTripTimes,
+        const uint8_t *codes,
+        int count,
+        Nedrysoft::RouteAnalyser::HopTimeSeries::Rollup &summary ) -> void {
+
+    auto minimum = std::numeric_limits<float>::infinity();
+    auto maximum = -std::numeric_limits<float>::infinity();
+    auto sum = 0.0;
+    auto replies = 0;
+    auto lost = 0;
+    auto index = 0;
+
+#if defined(PINGNOO_SAMPLEKERNELS_SSE2)
+    auto minimumVector = _mm_set1_ps(minimum);
+    auto maximumVector = _mm_set1_ps(maximum);
+    auto sumVector = _mm_setzero_pd();
+    auto replyVector = _mm_setzero_si128();
+    auto zero = _mm_setzero_ps();
+    auto positiveInfinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    auto negativeInfinity = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+    for (;index+4<=count;index+=4) {
+        auto values = _mm_loadu_ps(roundTripTimes+index);
+        auto replied = _mm_cmpge_ps(values, zero);
+        auto repliedValues = _mm_and_ps(values, replied);
+
+        // samples without a reply are replaced by the identity of each operation before they are combined.
+
+        minimumVector = _mm_min_ps(minimumVector, _mm_or_ps(repliedValues, _mm_andnot_ps(replied, positiveInfinity)));
+        maximumVector = _mm_max_ps(maximumVector, _mm_or_ps(repliedValues, _mm_andnot_ps(replied, negativeInfinity)));
+
+        sumVector = _mm_add_pd(sumVector, _mm_cvtps_pd(repliedValues));
+        sumVector = _mm_add_pd(sumVector, _mm_cvtps_pd(_mm_movehl_ps(repliedValues, repliedValues)));
+
+        replyVector = _mm_sub_epi32(replyVector, _mm_castps_si128(replied));
+    }
+
+    float minimums[4], maximums[4];
+    double sums[2];
+    int32_t replyCounts[4];
+
+    _mm_storeu_ps(minimums, minimumVector);
+    _mm_storeu_ps(maximums, maximumVector);
+    _mm_storeu_pd(sums, sumVector);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(replyCounts), replyVector);
+
+    for (auto lane=0;lane<4;lane++) {
+        minimum = std::min(minimum, minimums[lane]);
+        maximum = std::max(maximum, maximums[lane]);
+        replies += replyCounts[lane];
+    }
+
+    sum = sums[0]+sums[1];
+
+    auto codeIndex = 0;
+    auto codeMask = _mm_set1_epi8(static_cast<char>(ReplyCodeMask));
+
+    for (;codeIndex+16<=count;codeIndex+=16) {
+        auto values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes+codeIndex));
+        auto answered = _mm_cmpeq_epi8(_mm_and_si128(values, codeMask), _mm_setzero_si128());
+
+        lost += 16-static_cast<int>(std::bitset<16>(static_cast<unsigned>(_mm_movemask_epi8(answered))).count());
+    }
+#elif defined(PINGNOO_SAMPLEKERNELS_NEON)
+    auto minimumVector = vdupq_n_f32(minimum);
+    auto maximumVector = vdupq_n_f32(maximum);
+    auto sumVector = vdupq_n_f64(0);
+    auto replyVector = vdupq_n_u32(0);
+    auto zero = vdupq_n_f32(0);
+    auto positiveInfinity = vdupq_n_f32(std::numeric_limits<float>::infinity());
+    auto negativeInfinity = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+
+    for (;index+4<=count;index+=4) {
+        auto values = vld1q_f32(roundTripTimes+index);
+        auto replied = vcgeq_f32(values, zero);
+
+        // samples without a reply are replaced by the identity of each operation before they are combined.
+
+        minimumVector = vminq_f32(minimumVector, vbslq_f32(replied, values, positiveInfinity));
+        maximumVector = vmaxq_f32(maximumVector, vbslq_f32(replied, values, negativeInfinity));
+
+        auto repliedValues = vbslq_f32(replied, values, zero);
+
+        sumVector = vaddq_f64(sumVector, vcvt_f64_f32(vget_low_f32(repliedValues)));
+        sumVector = vaddq_f64(sumVector, vcvt_high_f64_f32(repliedValues));
+
+        replyVector = vsubq_u32(replyVector, replied);
+    }
+
+    minimum = vminvq_f32(minimumVector);
+    maximum = vmaxvq_f32(maximumVector);
+    sum = vaddvq_f64(sumVector);
+    replies = static_cast<int>(vaddvq_u32(replyVector));
+
+    auto codeIndex = 0;
+    auto codeMask = vdupq_n_u8(ReplyCodeMask);
+
+    for (;codeIndex+16<=count;codeIndex+=16) {
+        auto values = vld1q_u8(codes+codeIndex);
+        auto answered = vceqq_u8(vandq_u8(values, codeMask), vdupq_n_u8(0));
+
+        lost += 16-static_cast<int>(vaddvq_u8(vshrq_n_u8(answered, 7)));
+    }
+#else
+    auto codeIndex = 0;
+#endif
+
+    for (;index<count;index++) {
+        auto value = roundTripTimes[index];
+
+        if (value>=0) {
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+            sum += value;
+            replies++;
+        }
+    }
+
+    for (;codeIndex<count;codeIndex++) {
+        if (codes[codeIndex] & ReplyCodeMask) {
+            lost++;
+        }
+    }
+
+    if (replies) {
+        if (summary.count) {
+            summary.minimum = std::min(summary.minimum, minimum);
+            summary.maximum = std::max(summary.maximum, maximum);
+        } else {
+            summary.minimum = minimum;
+            summary.maximum = maximum;
+        }
+
+        summary.sum += sum;
+        summary.count += replies;
+    }
+
+    summary.lost += lost;
+}
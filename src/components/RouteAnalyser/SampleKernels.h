@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SAMPLEKERNELS_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SAMPLEKERNELS_H
+
+#include "HopTimeSeries.h"
+
+#include <cstdint>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The SampleKernels class provides the aggregation loops that run over the sample arrays of a
+     *              time series.
+     *
+     * @details     The kernels use SSE2 on x86-64 and NEON on 64 bit ARM, both of which are part of the base
+     *              instruction set so no runtime detection is needed, other targets use the scalar loop.  The
+     *              round trip times are processed four at a time and the result codes sixteen at a time.
+     */
+    class SampleKernels {
+        public:
+            /**
+             * @brief       Adds a run of samples to a summary.
+             *
+             * @details     A sample with a round trip time of zero or more counts as a reply, a sample whose
+             *              result code is a loss counts as lost.
+             *
+             * @param[in]   roundTripTimes the round trip times in seconds, negative if there was no reply.
+             * @param[in]   codes the result codes.
+             * @param[in]   count the number of samples.
+             * @param[in,out]   summary the summary to add the samples to.
+             */
+            static auto summarise(
+                    const float *roundTripTimes,
+                    const uint8_t *codes,
+                    int count,
+                    Nedrysoft::RouteAnalyser::HopTimeSeries::Rollup &summary ) -> void;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SAMPLEKERNELS_H
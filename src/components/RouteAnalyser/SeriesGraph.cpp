@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SeriesGraph.h"
+
+#include "FidelityGovernor.h"
+#include "HopTimeSeries.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr auto DecimationFactor = 2;
+
+Nedrysoft::RouteAnalyser::SeriesGraph::SeriesGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
+        QCPGraph(keyAxis, valueAxis),
+        m_series(nullptr) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::SeriesGraph::setSeries(const Nedrysoft::RouteAnalyser::HopTimeSeries *series) -> void {
+    m_series = series;
+}
+
+auto Nedrysoft::RouteAnalyser::SeriesGraph::series() const -> const Nedrysoft::RouteAnalyser::HopTimeSeries * {
+    return m_series;
+}
+
+QCPRange Nedrysoft::RouteAnalyser::SeriesGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const {
+    if (!m_series) {
+        return QCPGraph::getKeyRange(foundRange, inSignDomain);
+    }
+
+    foundRange = (m_series->count()>0) && (inSignDomain!=QCP::sdNegative);
+
+    if (!foundRange) {
+        return QCPRange();
+    }
+
+    return QCPRange(m_series->firstTime(), m_series->lastTime());
+}
+
+QCPRange Nedrysoft::RouteAnalyser::SeriesGraph::getValueRange(
+        bool &foundRange,
+        QCP::SignDomain inSignDomain,
+        const QCPRange &inKeyRange) const {
+
+    if (!m_series) {
+        return QCPGraph::getValueRange(foundRange, inSignDomain, inKeyRange);
+    }
+
+    auto range = QCPRange();
+    auto first = 0;
+    auto last = m_series->count();
+
+    foundRange = false;
+
+    // round trip times are never negative, so only the sign domains that include positive values find a range.
+
+    if (inSignDomain==QCP::sdNegative) {
+        return range;
+    }
+
+    if (inKeyRange!=QCPRange()) {
+        first = m_series->lowerBound(inKeyRange.lower);
+        last = m_series->lowerBound(std::nextafter(inKeyRange.upper, inKeyRange.upper+1));
+    }
+
+    for (auto index=first;index<last;index++) {
+        auto roundTripTime = m_series->roundTripTime(index);
+
+        if (roundTripTime<0) {
+            continue;
+        }
+
+        if (!foundRange) {
+            range = QCPRange(roundTripTime, roundTripTime);
+
+            foundRange = true;
+        } else {
+            range.expand(roundTripTime);
+        }
+    }
+
+    return range;
+}
+
+void Nedrysoft::RouteAnalyser::SeriesGraph::draw(QCPPainter *painter) {
+    if (!m_series) {
+        QCPGraph::draw(painter);
+
+        return;
+    }
+
+    if ((!m_series->count()) || (lineStyle()==lsNone)) {
+        return;
+    }
+
+    auto keyRange = keyAxis()->range();
+    auto width = std::abs(keyAxis()->coordToPixel(keyRange.upper)-keyAxis()->coordToPixel(keyRange.lower));
+    auto columns = std::max(
+            static_cast<int>(width)/Nedrysoft::RouteAnalyser::FidelityGovernor::getInstance()->decimationFactor(),
+            1 );
+
+    /**
+     * the samples either side of the visible range are included so that the line reaches the edges of the plot.
+     */
+
+    auto first = std::max(m_series->lowerBound(keyRange.lower)-1, 0);
+    auto last = std::min(m_series->lowerBound(keyRange.upper)+1, m_series->count());
+
+    QVector<QPointF> lines;
+
+    if (last-first>columns*DecimationFactor) {
+        for (auto &column : m_series->decimate(keyRange.lower, keyRange.upper, columns)) {
+            if (!column.replied) {
+                continue;
+            }
+
+            auto x = keyAxis()->coordToPixel(column.time);
+
+            lines.append(QPointF(x, valueAxis()->coordToPixel(column.minimum)));
+            lines.append(QPointF(x, valueAxis()->coordToPixel(column.maximum)));
+        }
+    } else {
+        auto previousTime = 0.0;
+        auto previousValue = 0.0;
+
+        for (auto index=first;index<last;index++) {
+            auto roundTripTime = m_series->roundTripTime(index);
+
+            if (roundTripTime<0) {
+                continue;
+            }
+
+            auto time = m_series->time(index);
+            auto value = valueAxis()->coordToPixel(roundTripTime);
+
+            // each step is centred between two replies, matching QCPGraph::lsStepCenter.
+
+            if (lines.isEmpty()) {
+                lines.append(QPointF(keyAxis()->coordToPixel(time), value));
+            } else {
+                auto step = keyAxis()->coordToPixel((previousTime+time)/2);
+
+                lines.append(QPointF(step, previousValue));
+                lines.append(QPointF(step, value));
+            }
+
+            previousTime = time;
+            previousValue = value;
+        }
+
+        if (!lines.isEmpty()) {
+            lines.append(QPointF(keyAxis()->coordToPixel(previousTime), previousValue));
+        }
+    }
+
+    painter->setPen(pen());
+    painter->setBrush(Qt::NoBrush);
+
+    drawLinePlot(painter, lines);
+}
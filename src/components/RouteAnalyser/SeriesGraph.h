@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SERIESGRAPH_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SERIESGRAPH_H
+
+#pragma warning(push)
+#pragma warning(disable : 4996)
+
+#include "QCustomPlot/qcustomplot.h"
+
+#pragma warning(pop)
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class HopTimeSeries;
+
+    /**
+     * @brief       The SeriesGraph class is a subclass of QCPGraph which can draw directly from the time series of
+     *              a hop.
+     *
+     * @details     While a series is set the graph is a read only view of it, the samples are located with the
+     *              sorted keys of the series and converted to pixels as they are drawn, so the plot holds no copy of
+     *              the samples.  Samples without a reply are skipped and the remainder are joined with a step
+     *              centred on each sample, if there are more samples than pixels the series is reduced to the
+     *              minimum and maximum of each pixel column instead.
+     *
+     *              Without a series the graph draws its own data container, which is used for the rollups and for
+     *              the medians of multi-probe rounds.
+     */
+    class SeriesGraph :
+            public QCPGraph {
+
+        public:
+            /**
+             * @brief       Constructs a new SeriesGraph and attaches it to the given axis.
+             *
+             * @param[in]   keyAxis the axis for the keys.
+             * @param[in]   valueAxis the axis for the values.
+             */
+            SeriesGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+            // Classes with virtual functions should not have a public non-virtual destructor:
+            virtual ~SeriesGraph() = default;
+
+            /**
+             * @brief       Sets the time series that is drawn.
+             *
+             * @param[in]   series the series, or nullptr to draw the data container of the graph.
+             */
+            auto setSeries(const Nedrysoft::RouteAnalyser::HopTimeSeries *series) -> void;
+
+            /**
+             * @brief       Returns the time series that is drawn.
+             *
+             * @returns     the series; otherwise nullptr if the data container is drawn.
+             */
+            auto series() const -> const Nedrysoft::RouteAnalyser::HopTimeSeries *;
+
+            /**
+             * @brief       Returns the range of keys covered by the graph.
+             *
+             * @param[out]  foundRange true if the graph contains any keys; otherwise false.
+             * @param[in]   inSignDomain the sign of the keys to include.
+             *
+             * @returns     the range of keys.
+             */
+            virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const;
+
+            /**
+             * @brief       Returns the range of values within a range of keys.
+             *
+             * @param[out]  foundRange true if any values were found; otherwise false.
+             * @param[in]   inSignDomain the sign of the values to include.
+             * @param[in]   inKeyRange the range of keys, an empty range includes every key.
+             *
+             * @returns     the range of values.
+             */
+            virtual QCPRange getValueRange(
+                    bool &foundRange,
+                    QCP::SignDomain inSignDomain=QCP::sdBoth,
+                    const QCPRange &inKeyRange=QCPRange()) const;
+
+        protected:
+            /**
+             * @brief       Draws the graph to the given painter.
+             *
+             * @param[in]   painter the QPainter to draw in.
+             */
+            virtual void draw(QCPPainter *painter);
+
+        private:
+            //! @cond
+
+            const Nedrysoft::RouteAnalyser::HopTimeSeries *m_series;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SERIESGRAPH_H
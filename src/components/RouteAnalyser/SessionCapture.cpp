@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SessionCapture.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+constexpr auto CaptureMagic = "PNGCAP01";
+constexpr auto CaptureMagicSize = 8;
+constexpr auto CaptureVersion = 1;
+constexpr auto FileHeaderSize = CaptureMagicSize+16;
+constexpr auto BlockMagic = quint32(0x4b424350);
+constexpr auto BlockHeaderSize = 40;
+constexpr auto IndexMagic = quint32(0x58494350);
+constexpr auto IndexEntrySize = 32;
+constexpr auto FooterSize = 16;
+constexpr auto RecordSize = 12;
+constexpr auto BlockRecords = 4096;
+constexpr auto NoRoundTripTime = quint32(0xffffffff);
+constexpr auto NanosecondsInMicrosecond = 1000ll;
+constexpr auto MaximumDelta = qint64(0x7fffffff)*NanosecondsInMicrosecond;
+constexpr auto MaximumRoundTripTime = qint64(NoRoundTripTime-1)*NanosecondsInMicrosecond;
+constexpr auto MaximumHop = 255;
+
+template <typename T>
+static auto readValue(const uchar *data) -> T {
+    return qFromLittleEndian<T>(data);
+}
+
+template <typename T>
+static auto appendValue(QByteArray &buffer, T value) -> void {
+    uchar data[sizeof(T)];
+
+    qToLittleEndian<T>(value, data);
+
+    buffer.append(reinterpret_cast<const char *>(data), sizeof(T));
+}
+
+Nedrysoft::RouteAnalyser::CaptureWriter::CaptureWriter() :
+        m_recordCount(0),
+        m_blockStartTime(0),
+        m_previousTime(0) {
+
+}
+
+Nedrysoft::RouteAnalyser::CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::open(
+        const QString &filename,
+        const QString &target,
+        Nedrysoft::Core::IPVersion ipVersion,
+        int interval,
+        const QHostAddress &routeHostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> bool {
+
+    close();
+
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    auto routeArray = QJsonArray();
+
+    for (auto &hopAddress : route) {
+        routeArray.append(hopAddress.isNull() ? QString() : hopAddress.toString());
+    }
+
+    auto metadata = QJsonDocument(QJsonObject{
+        {"target", target},
+        {"address", routeHostAddress.toString()},
+        {"route", routeArray}
+    }).toJson(QJsonDocument::Compact);
+
+    auto header = QByteArray(CaptureMagic, CaptureMagicSize);
+
+    appendValue<quint32>(header, CaptureVersion);
+    appendValue<quint32>(header, static_cast<quint32>(ipVersion));
+    appendValue<quint32>(header, static_cast<quint32>(interval));
+    appendValue<quint32>(header, static_cast<quint32>(metadata.size()));
+
+    header.append(metadata);
+
+    if (m_file.write(header)!=header.size()) {
+        m_file.close();
+
+        return false;
+    }
+
+    m_records.reserve(BlockRecords*RecordSize);
+    m_recordCount = 0;
+    m_index.clear();
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::isOpen() const -> bool {
+    return m_file.isOpen();
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::append(
+        int hop,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if ((!m_file.isOpen()) || (hop<1) || (hop>MaximumHop)) {
+        return;
+    }
+
+    auto time = result.requestTimestamp();
+
+    /**
+     * results from different hops do not arrive in strict time order, so the delta is signed, a result that is
+     * too far from the previous one to be represented starts a new block.
+     */
+
+    if ((m_recordCount) && (qAbs(time-m_previousTime)>MaximumDelta)) {
+        writeBlock();
+    }
+
+    if (!m_recordCount) {
+        m_blockStartTime = time;
+        m_previousTime = time;
+
+        m_index.append(BlockIndex{-1, time, time, 0});
+    }
+
+    auto roundTripTime = result.preciseRoundTripTime();
+    auto encodedRoundTripTime = NoRoundTripTime;
+
+    if ((result.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) && (roundTripTime>=0)) {
+        encodedRoundTripTime = static_cast<quint32>(
+                std::min(roundTripTime, MaximumRoundTripTime)/NanosecondsInMicrosecond );
+    }
+
+    auto delta = (time-m_previousTime)/NanosecondsInMicrosecond;
+
+    appendValue<qint32>(m_records, static_cast<qint32>(delta));
+    appendValue<quint32>(m_records, encodedRoundTripTime);
+    appendValue<quint8>(m_records, static_cast<quint8>(hop));
+    appendValue<quint8>(m_records, static_cast<quint8>(result.code()));
+    appendValue<quint16>(m_records, 0);
+
+    /**
+     * the time is advanced by the encoded delta rather than set to the result time, so the rounding to
+     * microseconds does not accumulate.
+     */
+
+    m_previousTime += delta*NanosecondsInMicrosecond;
+
+    auto &block = m_index.last();
+
+    block.startTime = std::min(block.startTime, m_previousTime);
+    block.endTime = std::max(block.endTime, m_previousTime);
+    block.count++;
+
+    m_recordCount++;
+
+    if (m_recordCount==BlockRecords) {
+        writeBlock();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::writeBlock() -> void {
+    if (!m_recordCount) {
+        return;
+    }
+
+    auto &block = m_index.last();
+    auto compressed = qCompress(m_records);
+    auto header = QByteArray();
+
+    appendValue<quint32>(header, BlockMagic);
+    appendValue<quint32>(header, m_recordCount);
+    appendValue<quint32>(header, static_cast<quint32>(compressed.size()));
+    appendValue<quint32>(header, 0);
+    appendValue<qint64>(header, m_blockStartTime);
+    appendValue<qint64>(header, block.startTime);
+    appendValue<qint64>(header, block.endTime);
+
+    block.offset = m_file.pos();
+
+    m_file.write(header);
+    m_file.write(compressed);
+
+    /**
+     * each block is flushed as it is written, a capture that is not closed can still be read up to its last
+     * complete block.
+     */
+
+    m_file.flush();
+
+    m_records.truncate(0);
+    m_recordCount = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::sync() -> bool {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    writeBlock();
+
+    if (!m_file.flush()) {
+        return false;
+    }
+
+    /**
+     * flushing only hands the data to the operating system, it must also be written to the disk for the capture to
+     * survive a power failure or a system crash.
+     */
+
+#if defined(Q_OS_WIN)
+    return _commit(m_file.handle())==0;
+#else
+    return fsync(m_file.handle())==0;
+#endif
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::size() const -> qint64 {
+    return m_file.isOpen() ? m_file.pos() : 0;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureWriter::close() -> void {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    writeBlock();
+
+    auto index = QByteArray();
+    auto indexOffset = m_file.pos();
+
+    for (auto &block : m_index) {
+        appendValue<qint64>(index, block.offset);
+        appendValue<qint64>(index, block.startTime);
+        appendValue<qint64>(index, block.endTime);
+        appendValue<quint32>(index, block.count);
+        appendValue<quint32>(index, 0);
+    }
+
+    appendValue<qint64>(index, indexOffset);
+    appendValue<quint32>(index, static_cast<quint32>(m_index.count()));
+    appendValue<quint32>(index, IndexMagic);
+
+    m_file.write(index);
+    m_file.close();
+
+    m_index.clear();
+}
+
+Nedrysoft::RouteAnalyser::CaptureReader::CaptureReader() :
+        m_data(nullptr),
+        m_size(0),
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_interval(0) {
+
+}
+
+Nedrysoft::RouteAnalyser::CaptureReader::~CaptureReader() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::open(const QString &filename) -> bool {
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+
+    if (m_size<FileHeaderSize) {
+        return false;
+    }
+
+    /**
+     * the samples are never copied out of the file in bulk, the mapping lets the operating system page in only
+     * the blocks that are actually decompressed.
+     */
+
+    m_data = m_file.map(0, m_size);
+
+    if (!m_data) {
+        return false;
+    }
+
+    if ((memcmp(m_data, CaptureMagic, CaptureMagicSize)!=0) ||
+        (readValue<quint32>(m_data+CaptureMagicSize)!=CaptureVersion)) {
+        return false;
+    }
+
+    auto ipVersion = readValue<quint32>(m_data+CaptureMagicSize+4);
+    auto metadataSize = static_cast<qint64>(readValue<quint32>(m_data+CaptureMagicSize+12));
+
+    if ((ipVersion!=static_cast<quint32>(Nedrysoft::Core::IPVersion::V4)) &&
+        (ipVersion!=static_cast<quint32>(Nedrysoft::Core::IPVersion::V6))) {
+        return false;
+    }
+
+    if (FileHeaderSize+metadataSize>m_size) {
+        return false;
+    }
+
+    m_ipVersion = static_cast<Nedrysoft::Core::IPVersion>(ipVersion);
+    m_interval = static_cast<int>(readValue<quint32>(m_data+CaptureMagicSize+8));
+
+    auto metadata = QJsonDocument::fromJson(QByteArray::fromRawData(
+            reinterpret_cast<const char *>(m_data+FileHeaderSize),
+            static_cast<int>(metadataSize) )).object();
+
+    m_target = metadata["target"].toString();
+    m_routeHostAddress = QHostAddress(metadata["address"].toString());
+    m_route.clear();
+
+    for (auto hopAddress : metadata["route"].toArray()) {
+        m_route.append(QHostAddress(hopAddress.toString()));
+    }
+
+    if (m_routeHostAddress.isNull()) {
+        return false;
+    }
+
+    auto dataOffset = FileHeaderSize+metadataSize;
+
+    if (!readIndex(dataOffset)) {
+        scanBlocks(dataOffset);
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::readIndex(qint64 dataOffset) -> bool {
+    m_index.clear();
+
+    if (m_size<dataOffset+FooterSize) {
+        return false;
+    }
+
+    auto footer = m_data+m_size-FooterSize;
+    auto indexOffset = readValue<qint64>(footer);
+    auto blockCount = static_cast<qint64>(readValue<quint32>(footer+8));
+
+    if ((readValue<quint32>(footer+12)!=IndexMagic) ||
+        (indexOffset<dataOffset) ||
+        (indexOffset+(blockCount*IndexEntrySize)+FooterSize!=m_size)) {
+        return false;
+    }
+
+    m_index.reserve(static_cast<int>(blockCount));
+
+    for (auto block=0;block<blockCount;block++) {
+        auto entry = m_data+indexOffset+(block*IndexEntrySize);
+        auto offset = readValue<qint64>(entry);
+
+        if ((offset<dataOffset) || (offset+BlockHeaderSize>indexOffset)) {
+            m_index.clear();
+
+            return false;
+        }
+
+        m_index.append(BlockIndex{
+            offset,
+            readValue<qint64>(entry+8),
+            readValue<qint64>(entry+16),
+            readValue<quint32>(entry+24)
+        });
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::scanBlocks(qint64 dataOffset) -> void {
+    m_index.clear();
+
+    auto offset = dataOffset;
+
+    while (offset+BlockHeaderSize<=m_size) {
+        auto header = m_data+offset;
+
+        if (readValue<quint32>(header)!=BlockMagic) {
+            break;
+        }
+
+        auto compressedSize = static_cast<qint64>(readValue<quint32>(header+8));
+
+        if (offset+BlockHeaderSize+compressedSize>m_size) {
+            break;
+        }
+
+        m_index.append(BlockIndex{
+            offset,
+            readValue<qint64>(header+24),
+            readValue<qint64>(header+32),
+            readValue<quint32>(header+4)
+        });
+
+        offset += BlockHeaderSize+compressedSize;
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::target() const -> QString {
+    return m_target;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::ipVersion() const -> Nedrysoft::Core::IPVersion {
+    return m_ipVersion;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::interval() const -> int {
+    return m_interval;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::routeHostAddress() const -> QHostAddress {
+    return m_routeHostAddress;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::route() const -> Nedrysoft::RouteAnalyser::RouteList {
+    return m_route;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::blockCount() const -> int {
+    return m_index.count();
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::blockStartTime(int block) const -> qint64 {
+    return m_index.at(block).startTime;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::blockEndTime(int block) const -> qint64 {
+    return m_index.at(block).endTime;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::startTime() const -> qint64 {
+    if (m_index.isEmpty()) {
+        return 0;
+    }
+
+    return m_index.first().startTime;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::endTime() const -> qint64 {
+    if (m_index.isEmpty()) {
+        return 0;
+    }
+
+    return m_index.last().endTime;
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::lowerBound(qint64 time) const -> int {
+    auto block = std::lower_bound(m_index.begin(), m_index.end(), time, [](const BlockIndex &entry, qint64 value) {
+        return entry.endTime<value;
+    });
+
+    return static_cast<int>(block-m_index.begin());
+}
+
+auto Nedrysoft::RouteAnalyser::CaptureReader::readBlock(
+        int block,
+        QVector<Nedrysoft::RouteAnalyser::CaptureSample> &samples ) const -> bool {
+
+    samples.clear();
+
+    if ((block<0) || (block>=m_index.count())) {
+        return false;
+    }
+
+    auto header = m_data+m_index.at(block).offset;
+    auto count = static_cast<int>(readValue<quint32>(header+4));
+    auto compressedSize = static_cast<int>(readValue<quint32>(header+8));
+    auto time = readValue<qint64>(header+16);
+
+    auto records = qUncompress(header+BlockHeaderSize, compressedSize);
+
+    if (records.size()!=count*RecordSize) {
+        return false;
+    }
+
+    samples.reserve(count);
+
+    auto record = reinterpret_cast<const uchar *>(records.constData());
+
+    for (auto index=0;index<count;index++, record+=RecordSize) {
+        auto roundTripTime = readValue<quint32>(record+4);
+        auto code = readValue<quint8>(record+9);
+
+        if (code>static_cast<quint8>(Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited)) {
+            return false;
+        }
+
+        time += static_cast<qint64>(readValue<qint32>(record))*NanosecondsInMicrosecond;
+
+        samples.append(CaptureSample{
+            time,
+            (roundTripTime==NoRoundTripTime) ? -1 : static_cast<qint64>(roundTripTime)*NanosecondsInMicrosecond,
+            readValue<quint8>(record+8),
+            static_cast<Nedrysoft::RouteAnalyser::PingResult::ResultCode>(code)
+        });
+    }
+
+    return true;
+}
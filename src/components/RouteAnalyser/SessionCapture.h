@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONCAPTURE_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONCAPTURE_H
+
+#include "IRouteEngine.h"
+#include "PingResult.h"
+#include "RouteAnalyserSpec.h"
+
+#include <ICore>
+#include <QByteArray>
+#include <QFile>
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       A sample read from a session capture.
+     */
+    struct CaptureSample {
+        qint64 requestTimestamp;                                    //! the request time in nanoseconds.
+        qint64 roundTripTime;                                       //! the round trip time in nanoseconds; or -1.
+        int hop;                                                    //! the hop number, starting at 1.
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode code;      //! the result code.
+    };
+
+    /**
+     * @brief       The CaptureWriter class records the results of a route analysis to a session capture file.
+     *
+     * @details     A capture starts with a header holding the target and the route, followed by blocks of fixed
+     *              size sample records.  Each record holds the time since the previous record rather than an
+     *              absolute time, so blocks of records compress well, and each block is compressed as it fills.
+     *              An index of the blocks is written when the capture is closed, which allows a reader to find
+     *              the block holding any point in time without reading the samples.
+     */
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC CaptureWriter {
+        public:
+            /**
+             * @brief       Constructs a CaptureWriter.
+             */
+            CaptureWriter();
+
+            /**
+             * @brief       Destroys the CaptureWriter, closing the capture.
+             */
+            ~CaptureWriter();
+
+            /**
+             * @brief       Creates a capture file and writes the header.
+             *
+             * @param[in]   filename the name of the file to create.
+             * @param[in]   target the target host as entered by the user.
+             * @param[in]   ipVersion the version of ip used by the analysis.
+             * @param[in]   interval the interval between pings in milliseconds.
+             * @param[in]   routeHostAddress the address of the target.
+             * @param[in]   route the address of each hop, a null address for a hop that did not respond.
+             *
+             * @returns     true if the capture was created; otherwise false.
+             */
+            auto open(
+                const QString &filename,
+                const QString &target,
+                Nedrysoft::Core::IPVersion ipVersion,
+                int interval,
+                const QHostAddress &routeHostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList &route
+            ) -> bool;
+
+            /**
+             * @brief       Appends a result to the capture.
+             *
+             * @param[in]   hop the hop number, starting at 1.
+             * @param[in]   result the result.
+             */
+            auto append(int hop, const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Writes the pending samples as a block and waits until the file is on disk.
+             *
+             * @details     A capture that is synced can be read up to this point even if the system stops before
+             *              the capture is closed.  Each sync ends the current block early, so it should only be
+             *              called every few seconds.
+             *
+             * @returns     true if the file was written and synced; otherwise false.
+             */
+            auto sync() -> bool;
+
+            /**
+             * @brief       Writes the remaining samples and the block index and closes the file.
+             */
+            auto close() -> void;
+
+            /**
+             * @brief       Returns the number of bytes written to the capture.
+             *
+             * @returns     the size of the file.
+             */
+            auto size() const -> qint64;
+
+            /**
+             * @brief       Returns whether a capture is open.
+             *
+             * @returns     true if open; otherwise false.
+             */
+            auto isOpen() const -> bool;
+
+        private:
+            /**
+             * @brief       Compresses and writes the pending records as a block.
+             */
+            auto writeBlock() -> void;
+
+        private:
+            //! @cond
+
+            struct BlockIndex {
+                qint64 offset;
+                qint64 startTime;
+                qint64 endTime;
+                quint32 count;
+            };
+
+            QFile m_file;
+            QByteArray m_records;
+            QVector<BlockIndex> m_index;
+            quint32 m_recordCount;
+            qint64 m_blockStartTime;
+            qint64 m_previousTime;
+
+            //! @endcond
+    };
+
+    /**
+     * @brief       The CaptureReader class provides access to the samples of a session capture file.
+     *
+     * @details     The file is memory mapped and only the header and the block index are read when it is opened,
+     *              so the time taken to open a capture does not depend on its size.  Blocks are decompressed on
+     *              request straight from the mapped file.  A capture that was not closed (for example because the
+     *              application exited while recording) has no index, in which case the index is rebuilt from the
+     *              block headers and any incomplete block at the end of the file is ignored.
+     */
+    class CaptureReader {
+        public:
+            /**
+             * @brief       Constructs a CaptureReader.
+             */
+            CaptureReader();
+
+            /**
+             * @brief       Destroys the CaptureReader.
+             */
+            ~CaptureReader();
+
+            /**
+             * @brief       Opens a capture file.
+             *
+             * @param[in]   filename the name of the file.
+             *
+             * @returns     true if the file is a valid capture; otherwise false.
+             */
+            auto open(const QString &filename) -> bool;
+
+            /**
+             * @brief       Returns the target host of the capture.
+             *
+             * @returns     the target.
+             */
+            auto target() const -> QString;
+
+            /**
+             * @brief       Returns the version of ip used by the capture.
+             *
+             * @returns     the ip version.
+             */
+            auto ipVersion() const -> Nedrysoft::Core::IPVersion;
+
+            /**
+             * @brief       Returns the interval between pings.
+             *
+             * @returns     the interval in milliseconds.
+             */
+            auto interval() const -> int;
+
+            /**
+             * @brief       Returns the address of the target.
+             *
+             * @returns     the address.
+             */
+            auto routeHostAddress() const -> QHostAddress;
+
+            /**
+             * @brief       Returns the route that was analysed.
+             *
+             * @returns     the address of each hop, a null address for a hop that did not respond.
+             */
+            auto route() const -> Nedrysoft::RouteAnalyser::RouteList;
+
+            /**
+             * @brief       Returns the number of blocks in the capture.
+             *
+             * @returns     the number of blocks.
+             */
+            auto blockCount() const -> int;
+
+            /**
+             * @brief       Returns the time of the first sample in a block.
+             *
+             * @param[in]   block the index of the block.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            auto blockStartTime(int block) const -> qint64;
+
+            /**
+             * @brief       Returns the time of the last sample in a block.
+             *
+             * @param[in]   block the index of the block.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            auto blockEndTime(int block) const -> qint64;
+
+            /**
+             * @brief       Returns the time of the first sample in the capture.
+             *
+             * @returns     the time in nanoseconds since the unix epoch; or 0 if the capture is empty.
+             */
+            auto startTime() const -> qint64;
+
+            /**
+             * @brief       Returns the time of the last sample in the capture.
+             *
+             * @returns     the time in nanoseconds since the unix epoch; or 0 if the capture is empty.
+             */
+            auto endTime() const -> qint64;
+
+            /**
+             * @brief       Returns the first block which ends at or after the given time.
+             *
+             * @param[in]   time the time in nanoseconds since the unix epoch.
+             *
+             * @returns     the index of the block; or blockCount() if every block ends before the time.
+             */
+            auto lowerBound(qint64 time) const -> int;
+
+            /**
+             * @brief       Decompresses the samples of a block.
+             *
+             * @param[in]   block the index of the block.
+             * @param[out]  samples the samples of the block.
+             *
+             * @returns     true if the block was read; otherwise false.
+             */
+            auto readBlock(int block, QVector<Nedrysoft::RouteAnalyser::CaptureSample> &samples) const -> bool;
+
+        private:
+            /**
+             * @brief       Reads the block index written when the capture was closed.
+             *
+             * @param[in]   dataOffset the offset of the first block.
+             *
+             * @returns     true if the index was read; otherwise false.
+             */
+            auto readIndex(qint64 dataOffset) -> bool;
+
+            /**
+             * @brief       Rebuilds the block index from the block headers.
+             *
+             * @param[in]   dataOffset the offset of the first block.
+             */
+            auto scanBlocks(qint64 dataOffset) -> void;
+
+        private:
+            //! @cond
+
+            struct BlockIndex {
+                qint64 offset;
+                qint64 startTime;
+                qint64 endTime;
+                quint32 count;
+            };
+
+            QFile m_file;
+            const uchar *m_data;
+            qint64 m_size;
+            QString m_target;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            int m_interval;
+            QHostAddress m_routeHostAddress;
+            Nedrysoft::RouteAnalyser::RouteList m_route;
+            QVector<BlockIndex> m_index;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONCAPTURE_H
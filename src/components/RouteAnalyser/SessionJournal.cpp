@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SessionJournal.h"
+
+#include <Clock>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QVector>
+#include <spdlog/spdlog.h>
+
+constexpr auto JournalPath = "Nedrysoft/Pingnoo/Components/RouteAnalyser/Journal";
+constexpr auto RecoveredFolder = "Recovered";
+constexpr auto SegmentFilter = "*.pingcap";
+constexpr auto SegmentSize = 16ll*1024*1024;
+constexpr auto MaximumJournalSize = 256ll*1024*1024;
+constexpr auto SyncInterval = 5000;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+
+static auto routeKey(const Nedrysoft::RouteAnalyser::CaptureReader &reader) -> QString {
+    auto hops = QStringList();
+
+    for (auto &hopAddress : reader.route()) {
+        hops.append(hopAddress.toString());
+    }
+
+    return QString("%1|%2|%3|%4|%5")
+            .arg(reader.target())
+            .arg(reader.routeHostAddress().toString())
+            .arg(static_cast<int>(reader.ipVersion()))
+            .arg(reader.interval())
+            .arg(hops.join(","));
+}
+
+static auto recoveredFilename(const QString &folder, const Nedrysoft::RouteAnalyser::CaptureReader &reader) -> QString {
+    static const auto unsafeCharacters = QRegularExpression(R"([^A-Za-z0-9._-])");
+
+    auto startTime = QDateTime::fromMSecsSinceEpoch(reader.startTime()/NanosecondsInMillisecond);
+    auto baseName = QString("%1 %2")
+            .arg(QString(reader.target()).replace(unsafeCharacters, "_"))
+            .arg(startTime.toString("yyyy-MM-dd HH-mm-ss"));
+
+    auto filename = QString("%1/%2.pingcap").arg(folder).arg(baseName);
+
+    for (auto copy=2; QFileInfo::exists(filename); copy++) {
+        filename = QString("%1/%2 (%3).pingcap").arg(folder).arg(baseName).arg(copy);
+    }
+
+    return filename;
+}
+
+Nedrysoft::RouteAnalyser::SessionJournal::SessionJournal() :
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_interval(0) {
+
+}
+
+Nedrysoft::RouteAnalyser::SessionJournal::~SessionJournal() {
+    close();
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::journalFolder() -> QString {
+    return QDir::cleanPath(QString("%1/%2")
+            .arg(Nedrysoft::Core::ICore::getInstance()->storageFolder())
+            .arg(JournalPath));
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::open(
+        const QString &target,
+        Nedrysoft::Core::IPVersion ipVersion,
+        int interval,
+        const QHostAddress &routeHostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> bool {
+
+    static auto sessionCount = 0;
+
+    if (m_session.isEmpty()) {
+        m_session = QString("%1_%2_%3")
+                .arg(Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc().toString("yyyyMMddHHmmsszzz"))
+                .arg(QCoreApplication::applicationPid())
+                .arg(++sessionCount);
+    }
+
+    m_target = target;
+    m_ipVersion = ipVersion;
+    m_interval = interval;
+    m_routeHostAddress = routeHostAddress;
+    m_route = route;
+
+    m_writer.close();
+
+    return openSegment();
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::openSegment() -> bool {
+    auto folder = journalFolder();
+
+    if (!QDir().mkpath(folder)) {
+        SPDLOG_WARN(QString("Unable to create the session journal folder %1.").arg(folder).toStdString());
+
+        return false;
+    }
+
+    /**
+     * segments are named by session and sequence, so sorting the folder by name orders them oldest first.
+     */
+
+    auto segmentName = QString("%1-%2.pingcap").arg(m_session).arg(m_segments.count(), 4, 10, QChar('0'));
+
+    if (!m_writer.open(
+            QString("%1/%2").arg(folder).arg(segmentName),
+            m_target,
+            m_ipVersion,
+            m_interval,
+            m_routeHostAddress,
+            m_route )) {
+
+        SPDLOG_WARN(QString("Unable to create the session journal %1.").arg(segmentName).toStdString());
+
+        return false;
+    }
+
+    m_segments.append(segmentName);
+
+    m_syncTimer.start();
+
+    enforceLimit();
+
+    return true;
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::append(
+        int hop,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if (!m_writer.isOpen()) {
+        return;
+    }
+
+    m_writer.append(hop, result);
+
+    if (m_writer.size()>=SegmentSize) {
+        m_writer.close();
+
+        openSegment();
+
+        return;
+    }
+
+    /**
+     * syncing ends the current block, so the journal is synced every few seconds rather than for every result, a
+     * crash loses at most the results since the last sync.
+     */
+
+    if (m_syncTimer.hasExpired(SyncInterval)) {
+        if (!m_writer.sync()) {
+            SPDLOG_WARN(QString("Unable to sync the session journal %1.").arg(m_segments.last()).toStdString());
+        }
+
+        m_syncTimer.restart();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::close() -> void {
+    m_writer.close();
+
+    auto folder = QDir(journalFolder());
+
+    for (auto &segmentName : m_segments) {
+        QFile::remove(folder.filePath(segmentName));
+    }
+
+    m_segments.clear();
+    m_session.clear();
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::enforceLimit() -> void {
+    auto folder = QDir(journalFolder());
+    auto segments = folder.entryInfoList(QStringList() << SegmentFilter, QDir::Files, QDir::Name);
+    auto totalSize = qint64(0);
+
+    for (auto &segment : segments) {
+        totalSize += segment.size();
+    }
+
+    for (auto &segment : segments) {
+        if (totalSize<=MaximumJournalSize) {
+            break;
+        }
+
+        if (segment.fileName()==m_segments.last()) {
+            continue;
+        }
+
+        if (QFile::remove(segment.absoluteFilePath())) {
+            totalSize -= segment.size();
+
+            m_segments.removeAll(segment.fileName());
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::SessionJournal::recover() -> QStringList {
+    auto folder = QDir(journalFolder());
+    auto segments = folder.entryList(QStringList() << SegmentFilter, QDir::Files, QDir::Name);
+    auto recoveredCaptures = QStringList();
+
+    if (segments.isEmpty()) {
+        return recoveredCaptures;
+    }
+
+    auto recoveredFolder = folder.filePath(RecoveredFolder);
+
+    if (!QDir().mkpath(recoveredFolder)) {
+        SPDLOG_WARN(QString("Unable to create %1.").arg(recoveredFolder).toStdString());
+
+        return recoveredCaptures;
+    }
+
+    auto writer = Nedrysoft::RouteAnalyser::CaptureWriter();
+    auto writerSession = QString();
+    auto writerKey = QString();
+    auto samples = QVector<Nedrysoft::RouteAnalyser::CaptureSample>();
+
+    for (auto &segmentName : segments) {
+        auto session = segmentName.section('-', 0, -2);
+        auto isRecovered = false;
+
+        {
+            auto reader = Nedrysoft::RouteAnalyser::CaptureReader();
+
+            if ((!reader.open(folder.filePath(segmentName))) || (!reader.blockCount())) {
+                /**
+                 * a segment without a complete block holds nothing that can be recovered.
+                 */
+
+                isRecovered = true;
+            } else {
+                auto key = routeKey(reader);
+
+                /**
+                 * consecutive segments of a session are joined, a new capture is started when the route changed
+                 * between them as the hops of a capture are fixed by its header.
+                 */
+
+                if ((!writer.isOpen()) || (session!=writerSession) || (key!=writerKey)) {
+                    writer.close();
+
+                    auto filename = recoveredFilename(recoveredFolder, reader);
+
+                    if (writer.open(
+                            filename,
+                            reader.target(),
+                            reader.ipVersion(),
+                            reader.interval(),
+                            reader.routeHostAddress(),
+                            reader.route() )) {
+
+                        recoveredCaptures.append(filename);
+                    }
+
+                    writerSession = session;
+                    writerKey = key;
+                }
+
+                if (writer.isOpen()) {
+                    auto route = reader.route();
+
+                    for (auto block=0; block<reader.blockCount(); block++) {
+                        if (!reader.readBlock(block, samples)) {
+                            continue;
+                        }
+
+                        for (auto &sample : samples) {
+                            writer.append(sample.hop, Nedrysoft::RouteAnalyser::PingResult(
+                                0,
+                                sample.code,
+                                route.value(sample.hop-1),
+                                sample.requestTimestamp,
+                                sample.roundTripTime,
+                                nullptr,
+                                sample.hop
+                            ));
+                        }
+                    }
+
+                    isRecovered = true;
+                }
+            }
+        }
+
+        /**
+         * a segment is only removed once its samples are in a recovered capture, one that could not be copied is
+         * tried again at the next startup.
+         */
+
+        if (isRecovered) {
+            QFile::remove(folder.filePath(segmentName));
+        }
+    }
+
+    writer.close();
+
+    return recoveredCaptures;
+}
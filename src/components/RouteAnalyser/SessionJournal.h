@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONJOURNAL_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONJOURNAL_H
+
+#include "IRouteEngine.h"
+#include "PingResult.h"
+#include "SessionCapture.h"
+
+#include <ElapsedTimer>
+#include <ICore>
+#include <QHostAddress>
+#include <QString>
+#include <QStringList>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The SessionJournal class keeps a crash safe journal of the results of a route analysis.
+     *
+     * @details     The journal is a series of session capture segments written to the components data storage
+     *              location, a segment is synced to disk every few seconds so that at most the last few seconds
+     *              are lost if the application or the system stops.  A new segment is started when the current
+     *              one reaches its size limit or the route changes, and the oldest segments are removed when the
+     *              journal folder exceeds its size limit.  A journal that is closed normally is removed, anything
+     *              left in the folder at startup belongs to a session that did not end cleanly and is recovered
+     *              into session captures that can be opened as usual.
+     */
+    class SessionJournal {
+        public:
+            /**
+             * @brief       Constructs a SessionJournal.
+             */
+            SessionJournal();
+
+            /**
+             * @brief       Destroys the SessionJournal, closing and removing the journal.
+             */
+            ~SessionJournal();
+
+            /**
+             * @brief       Starts a new journal segment for a route.
+             *
+             * @details     Called when the route is first discovered and again whenever it changes.
+             *
+             * @param[in]   target the target host as entered by the user.
+             * @param[in]   ipVersion the version of ip used by the analysis.
+             * @param[in]   interval the interval between pings in milliseconds.
+             * @param[in]   routeHostAddress the address of the target.
+             * @param[in]   route the address of each hop, a null address for a hop that did not respond.
+             *
+             * @returns     true if the segment was created; otherwise false.
+             */
+            auto open(
+                const QString &target,
+                Nedrysoft::Core::IPVersion ipVersion,
+                int interval,
+                const QHostAddress &routeHostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList &route
+            ) -> bool;
+
+            /**
+             * @brief       Appends a result to the journal.
+             *
+             * @param[in]   hop the hop number, starting at 1.
+             * @param[in]   result the result.
+             */
+            auto append(int hop, const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Closes the journal and removes its segments.
+             */
+            auto close() -> void;
+
+            /**
+             * @brief       Recovers the journals of sessions that did not end cleanly.
+             *
+             * @details     The segments of each session are joined into session captures, a new capture is
+             *              started where the route changed.  The segments are removed once they have been
+             *              recovered.  Must be called before any journal is opened.
+             *
+             * @returns     the file names of the recovered captures.
+             */
+            static auto recover() -> QStringList;
+
+        private:
+            /**
+             * @brief       Creates the next segment of the journal.
+             *
+             * @returns     true if the segment was created; otherwise false.
+             */
+            auto openSegment() -> bool;
+
+            /**
+             * @brief       Removes the oldest segments until the journal folder is within its size limit.
+             */
+            auto enforceLimit() -> void;
+
+            /**
+             * @brief       Returns the folder that holds the journals.
+             *
+             * @returns     the path of the folder.
+             */
+            static auto journalFolder() -> QString;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::CaptureWriter m_writer;
+            Nedrysoft::Core::ElapsedTimer m_syncTimer;
+            QString m_session;
+            QStringList m_segments;
+
+            QString m_target;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+            int m_interval;
+            QHostAddress m_routeHostAddress;
+            Nedrysoft::RouteAnalyser::RouteList m_route;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SESSIONJOURNAL_H
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SlidingWindowExtrema.h"
+
+Nedrysoft::RouteAnalyser::SlidingWindowExtrema::SlidingWindowExtrema(double window) :
+        m_window(window),
+        m_lastTime(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::setWindow(double window) -> void {
+    m_window = window;
+
+    expire(m_lastTime);
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::window() const -> double {
+    return m_window;
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::add(double time, double value) -> void {
+    // a value can never be the extreme once a newer value at least as extreme has been added.
+
+    while ((!m_minimums.empty()) && (m_minimums.back().value>=value)) {
+        m_minimums.pop_back();
+    }
+
+    while ((!m_maximums.empty()) && (m_maximums.back().value<=value)) {
+        m_maximums.pop_back();
+    }
+
+    m_minimums.push_back(Entry {time, value});
+    m_maximums.push_back(Entry {time, value});
+
+    expire(time);
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::expire(double time) -> void {
+    if (time>m_lastTime) {
+        m_lastTime = time;
+    }
+
+    auto start = m_lastTime-m_window;
+
+    while ((!m_minimums.empty()) && (m_minimums.front().time<start)) {
+        m_minimums.pop_front();
+    }
+
+    while ((!m_maximums.empty()) && (m_maximums.front().time<start)) {
+        m_maximums.pop_front();
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::clear() -> void {
+    m_minimums.clear();
+    m_maximums.clear();
+
+    m_lastTime = 0;
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::isEmpty() const -> bool {
+    return m_maximums.empty();
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::minimum() const -> double {
+    return m_minimums.empty() ? -1 : m_minimums.front().value;
+}
+
+auto Nedrysoft::RouteAnalyser::SlidingWindowExtrema::maximum() const -> double {
+    return m_maximums.empty() ? -1 : m_maximums.front().value;
+}
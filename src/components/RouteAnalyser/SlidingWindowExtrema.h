@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SLIDINGWINDOWEXTREMA_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SLIDINGWINDOWEXTREMA_H
+
+#include <deque>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The SlidingWindowExtrema class tracks the minimum and maximum of the values within a period of
+     *              time ending at the newest value.
+     *
+     * @details     Each extreme is kept in a monotonic queue, a new value removes the values at the back of the
+     *              queue that it supersedes and values leave the front as they fall out of the window, so the
+     *              extremes are available at any time and each value is added and removed at most once.
+     *
+     *              Values are expected to arrive in time order.
+     */
+    class SlidingWindowExtrema {
+        public:
+            /**
+             * @brief       Constructs an empty SlidingWindowExtrema.
+             *
+             * @param[in]   window the length of the window in seconds.
+             */
+            explicit SlidingWindowExtrema(double window = 0);
+
+            /**
+             * @brief       Sets the length of the window.
+             *
+             * @details     Values that are already outside a shorter window are removed, values that were removed
+             *              are not restored by a longer window, the caller should clear and add them again.
+             *
+             * @param[in]   window the length of the window in seconds.
+             */
+            auto setWindow(double window) -> void;
+
+            /**
+             * @brief       Returns the length of the window.
+             *
+             * @returns     the length of the window in seconds.
+             */
+            auto window() const -> double;
+
+            /**
+             * @brief       Adds a value.
+             *
+             * @param[in]   time the time of the value in seconds.
+             * @param[in]   value the value.
+             */
+            auto add(double time, double value) -> void;
+
+            /**
+             * @brief       Removes the values that are outside of the window ending at the given time.
+             *
+             * @param[in]   time the end of the window in seconds.
+             */
+            auto expire(double time) -> void;
+
+            /**
+             * @brief       Removes all values.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Returns whether the window contains any values.
+             *
+             * @returns     true if the window is empty; otherwise false.
+             */
+            auto isEmpty() const -> bool;
+
+            /**
+             * @brief       Returns the minimum value in the window.
+             *
+             * @returns     the minimum; otherwise -1 if the window is empty.
+             */
+            auto minimum() const -> double;
+
+            /**
+             * @brief       Returns the maximum value in the window.
+             *
+             * @returns     the maximum; otherwise -1 if the window is empty.
+             */
+            auto maximum() const -> double;
+
+        private:
+            //! @cond
+
+            struct Entry {
+                double time;
+                double value;
+            };
+
+            std::deque<Entry> m_minimums;
+            std::deque<Entry> m_maximums;
+
+            double m_window;
+            double m_lastTime;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SLIDINGWINDOWEXTREMA_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SmokeChart.h"
+
+#include "HopRoundSeries.h"
+
+#include <algorithm>
+#include <limits>
+
+constexpr auto BandCount = Nedrysoft::RouteAnalyser::HopRoundSeries::QuantileCount/2;
+constexpr auto OuterBandAlpha = 48;
+constexpr auto BandAlphaStep = 40;
+
+Nedrysoft::RouteAnalyser::SmokeChart::SmokeChart(QCPAxis *keyAxis, QCPAxis *valueAxis) :
+        QCPBars(keyAxis, valueAxis),
+        m_series(nullptr) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::SmokeChart::setSeries(const Nedrysoft::RouteAnalyser::HopRoundSeries *series) -> void {
+    m_series = series;
+}
+
+void Nedrysoft::RouteAnalyser::SmokeChart::draw(QCPPainter *painter) {
+    if ((!m_series) || (!m_series->count())) {
+        return;
+    }
+
+    auto keyRange = keyAxis()->range();
+    auto colour = brush().color();
+
+    QBrush bandBrushes[BandCount];
+
+    for (auto band=0;band<BandCount;band++) {
+        colour.setAlpha(OuterBandAlpha+(BandAlphaStep*band));
+
+        bandBrushes[band] = QBrush(colour);
+    }
+
+    painter->save();
+    painter->setClipRect(parentPlot()->axisRect()->rect());
+    painter->setPen(Qt::NoPen);
+
+    applyDefaultAntialiasingHint(painter);
+
+    /**
+     * a round extends until the next one starts, the first round drawn is the one before the visible range so that
+     * its band reaches the left edge.
+     */
+
+    auto index = std::max(0, m_series->lowerBound(keyRange.lower)-1);
+    auto drawnRight = -std::numeric_limits<double>::infinity();
+
+    for (;index<m_series->count();index++) {
+        auto &round = m_series->round(index);
+
+        if (round.time>keyRange.upper) {
+            break;
+        }
+
+        auto end = (index+1<m_series->count()) ? m_series->round(index+1).time : round.time+width();
+        auto left = keyAxis()->coordToPixel(round.time);
+        auto right = keyAxis()->coordToPixel(end);
+
+        if ((!round.replies) || (right<=drawnRight)) {
+            continue;
+        }
+
+        left = std::max(left, drawnRight);
+        drawnRight = std::max(right, left+1);
+
+        for (auto band=0;band<BandCount;band++) {
+            auto top = valueAxis()->coordToPixel(
+                round.quantiles[Nedrysoft::RouteAnalyser::HopRoundSeries::QuantileCount-1-band]);
+
+            auto bottom = valueAxis()->coordToPixel(round.quantiles[band]);
+
+            painter->setBrush(bandBrushes[band]);
+            painter->drawRect(QRectF(QPointF(left, top), QPointF(drawnRight, bottom)).normalized());
+        }
+    }
+
+    painter->restore();
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_SMOKECHART_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_SMOKECHART_H
+
+#pragma warning(push)
+#pragma warning(disable : 4996)
+
+#include "QCustomPlot/qcustomplot.h"
+
+#pragma warning(pop)
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class HopRoundSeries;
+
+    /**
+     * @brief       The SmokeChart class is a subclass of QCPBars which draws the spread of each multi-probe round.
+     *
+     * @details     Each round is drawn as nested bands between its precomputed quantiles, the outer band spans the
+     *              fastest to the slowest reply and each inner band is drawn more opaque, so a round with a wide
+     *              spread shows as a tall pale "smoke" around the median line.  The chart draws directly from the
+     *              round series of the hop, there is no copy of the data to rebuild when the view changes, and when
+     *              several rounds fall in the same pixel column only the first is drawn.
+     *
+     *              The data container of QCPBars is not used, the bar width sets the width of the newest round.
+     */
+    class SmokeChart :
+            public QCPBars {
+
+        public:
+            /**
+             * @brief       Constructs a new SmokeChart and attaches it to the given axis.
+             *
+             * @param[in]   keyAxis the axis for the keys.
+             * @param[in]   valueAxis the axis for the values.
+             */
+            SmokeChart(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+            // Classes with virtual functions should not have a public non-virtual destructor:
+            virtual ~SmokeChart() = default;
+
+            /**
+             * @brief       Sets the round series that is drawn.
+             *
+             * @param[in]   series the series, or nullptr to draw nothing.
+             */
+            auto setSeries(const Nedrysoft::RouteAnalyser::HopRoundSeries *series) -> void;
+
+        protected:
+            /**
+             * @brief       Draws the smoke chart to the given painter.
+             *
+             * @param[in]   painter the QPainter to draw in.
+             */
+            virtual void draw(QCPPainter *painter);
+
+        private:
+            //! @cond
+
+            const Nedrysoft::RouteAnalyser::HopRoundSeries *m_series;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_SMOKECHART_H
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StatisticsWorker.h"
+
+#include "IResultSink.h"
+
+#include <QMutexLocker>
+
+constexpr auto ChannelCapacity = 16384;
+
+Nedrysoft::RouteAnalyser::StatisticsWorker::StatisticsWorker() :
+        Nedrysoft::RouteAnalyser::ResultStage(
+                "Statistics queue depth",
+                "Statistics results dropped",
+                ChannelCapacity,
+                OverflowPolicy::Block ),
+
+        m_statisticsGeneration(0),
+        m_movesPending(false),
+        m_resetPending(false) {
+
+}
+
+Nedrysoft::RouteAnalyser::StatisticsWorker::~StatisticsWorker() {
+    // a queued task still refers to the worker, so it has to have run before the worker goes away.
+
+    stop();
+}
+
+auto Nedrysoft::RouteAnalyser::StatisticsWorker::takeSnapshots() -> QHash<int, Snapshot> {
+    QMutexLocker locker(&m_mutex);
+
+    auto snapshots = QHash<int, Snapshot>();
+
+    snapshots.swap(m_snapshots);
+
+    return snapshots;
+}
+
+auto Nedrysoft::RouteAnalyser::StatisticsWorker::setResultSinks(
+        const QString &target,
+        const QList<Nedrysoft::RouteAnalyser::IResultSink *> &sinks ) -> void {
+
+    QMutexLocker locker(&m_mutex);
+
+    m_target = target;
+    m_resultSinks = sinks;
+}
+
+auto Nedrysoft::RouteAnalyser::StatisticsWorker::reset() -> void {
+    QMutexLocker locker(&m_mutex);
+
+    discard();
+
+    m_snapshots.clear();
+
+    m_movesPending = false;
+    m_resetPending = true;
+}
+
+auto Nedrysoft::RouteAnalyser::StatisticsWorker::moveHops(const QVector<int> &hops) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    discard();
+
+    auto snapshots = QHash<int, Snapshot>();
+
+    for (auto hop=0;hop<hops.count();hop++) {
+        if (m_snapshots.contains(hops.at(hop))) {
+            snapshots[hop] = m_snapshots.value(hops.at(hop));
+        }
+    }
+
+    m_snapshots.swap(snapshots);
+
+    // the aggregates are cleared by a pending reset, otherwise the moves are combined with any not yet applied.
+
+    if (m_resetPending) {
+        return;
+    }
+
+    if (!m_movesPending) {
+        m_hopMoves = hops;
+        m_movesPending = true;
+
+        return;
+    }
+
+    auto hopMoves = QVector<int>(hops.count(), -1);
+
+    for (auto hop=0;hop<hops.count();hop++) {
+        if (hops.at(hop)>=0) {
+            hopMoves[hop] = m_hopMoves.value(hops.at(hop), -1);
+        }
+    }
+
+    m_hopMoves = hopMoves;
+}
+
+auto Nedrysoft::RouteAnalyser::StatisticsWorker::process(
+        const QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry> &batch,
+        quint64 epoch ) -> void {
+
+    /**
+     * the aggregates belong to the task, so a reset or a move is applied here when the first results published after
+     * it are processed.
+     */
+
+    if (epoch!=m_statisticsGeneration) {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_movesPending) {
+            auto statistics = QHash<int, Nedrysoft::RouteAnalyser::HopStatistics>();
+
+            for (auto hop=0;hop<m_hopMoves.count();hop++) {
+                if (m_statistics.contains(m_hopMoves.at(hop))) {
+                    statistics[hop] = m_statistics.value(m_hopMoves.at(hop));
+                }
+            }
+
+            m_statistics.swap(statistics);
+        } else {
+            m_statistics.clear();
+        }
+
+        m_movesPending = false;
+        m_resetPending = false;
+
+        m_statisticsGeneration = epoch;
+    }
+
+    auto results = QHash<int, QVector<Nedrysoft::RouteAnalyser::PingResult> >();
+
+    for (auto &entry : batch) {
+        m_statistics[entry.hop].add(entry.result);
+
+        results[entry.hop].append(entry.result);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (epoch!=this->epoch()) {
+        return;
+    }
+
+    for (auto hop=results.begin();hop!=results.end();hop++) {
+        auto &snapshot = m_snapshots[hop.key()];
+
+        snapshot.statistics = m_statistics[hop.key()];
+        snapshot.results.append(hop.value());
+    }
+
+    auto target = m_target;
+    auto resultSinks = m_resultSinks;
+
+    locker.unlock();
+
+    // the sinks only queue what they are given, the hops that they see are numbered from 1.
+
+    for (auto hop=results.constBegin();hop!=results.constEnd();hop++) {
+        for (auto resultSink : resultSinks) {
+            resultSink->update(target, hop.key()+1, m_statistics[hop.key()], hop.value());
+        }
+    }
+}
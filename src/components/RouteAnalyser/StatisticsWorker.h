@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_STATISTICSWORKER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_STATISTICSWORKER_H
+
+#include "HopStatistics.h"
+#include "PingResult.h"
+#include "ResultStage.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IResultSink;
+
+    /**
+     * @brief       The StatisticsWorker class maintains the statistics of each hop in the background.
+     *
+     * @details     Results are published from the GUI thread, which only queues them, a task on the shared task
+     *              pool adds them to the aggregates of their hop and publishes a copy of the aggregates of every hop
+     *              that has changed.  The GUI takes the published snapshots at its refresh rate, so the cost of
+     *              updating the table and plots does not depend on how fast results arrive.
+     *
+     *              The worker is the statistics stage of the result pipeline, its aggregates have to account for
+     *              every result, so a publisher waits rather than drops a result when the channel is full.  Once a
+     *              batch has been added the result sinks are given the aggregates of each hop that it touched, so
+     *              exporters report the same figures as the table.
+     *
+     *              Hops are identified by an integer chosen by the caller.
+     */
+    class StatisticsWorker :
+            public Nedrysoft::RouteAnalyser::ResultStage {
+        public:
+            /**
+             * @brief       A published snapshot of a hop.
+             */
+            struct Snapshot {
+                Nedrysoft::RouteAnalyser::HopStatistics statistics;         //! the aggregates of the hop.
+                QVector<Nedrysoft::RouteAnalyser::PingResult> results;      //! the results since the last snapshot.
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new StatisticsWorker.
+             */
+            StatisticsWorker();
+
+            /**
+             * @brief       Waits for any running task and destroys the StatisticsWorker.
+             */
+            ~StatisticsWorker();
+
+            /**
+             * @brief       Takes the snapshots published since the previous call.
+             *
+             * @returns     the snapshots keyed by hop.
+             */
+            auto takeSnapshots() -> QHash<int, Snapshot>;
+
+            /**
+             * @brief       Sets the result sinks that are given the aggregates of each hop as they change.
+             *
+             * @note        The sinks are registered components which outlive every target.
+             *
+             * @param[in]   target the name of the target, passed to the sinks.
+             * @param[in]   sinks the result sinks.
+             */
+            auto setResultSinks(const QString &target, const QList<Nedrysoft::RouteAnalyser::IResultSink *> &sinks)
+                    -> void;
+
+            /**
+             * @brief       Discards the queued results, the published snapshots and the aggregates of every hop.
+             *
+             * @details     Results that are being processed when the worker is reset are discarded rather than
+             *              published, results published afterwards start new aggregates.
+             */
+            auto reset() -> void;
+
+            /**
+             * @brief       Moves the aggregates and published snapshots of the hops to new identifiers.
+             *
+             * @details     Used when the hops of a route are rearranged, a hop that is kept continues its
+             *              aggregates under its new identifier.  Results that are queued when the hops are moved
+             *              were published under the previous identifiers, so they are discarded rather than added to
+             *              the wrong hop.
+             *
+             * @param[in]   hops the previous identifier of each hop, -1 for a hop that starts new aggregates.
+             */
+            auto moveHops(const QVector<int> &hops) -> void;
+
+        protected:
+            /**
+             * @brief       Adds a batch of results to the aggregates, called on a task pool thread.
+             *
+             * @see         Nedrysoft::RouteAnalyser::ResultStage::process
+             *
+             * @param[in]   batch the results.
+             * @param[in]   epoch the epoch of the batch.
+             */
+            auto process(const QVector<Nedrysoft::RouteAnalyser::ResultChannel::Entry> &batch,
+                         quint64 epoch) -> void override;
+
+        private:
+            //! @cond
+
+            QMutex m_mutex;
+            QHash<int, Snapshot> m_snapshots;
+
+            QString m_target;
+            QList<Nedrysoft::RouteAnalyser::IResultSink *> m_resultSinks;
+
+            QHash<int, Nedrysoft::RouteAnalyser::HopStatistics> m_statistics;
+            quint64 m_statisticsGeneration;
+
+            QVector<int> m_hopMoves;
+            bool m_movesPending;
+            bool m_resetPending;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_STATISTICSWORKER_H
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TargetCompleter.h"
+
+#include "TargetManager.h"
+
+#include "rapidfuzz/fuzz.hpp"
+
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QSet>
+#include <QTextCursor>
+#include <QTextEdit>
+#include <TaskPool>
+#include <algorithm>
+
+constexpr auto MaximumCompletions = 10;
+constexpr auto MinimumScore = 80.0;
+constexpr auto HostPrefixScore = 300.0;
+constexpr auto NamePrefixScore = 200.0;
+constexpr auto CancellationInterval = 256;
+
+Nedrysoft::RouteAnalyser::TargetCompleter::TargetCompleter(QTextEdit *textEdit) :
+        QObject(textEdit),
+        m_textEdit(textEdit),
+        m_completer(new QCompleter(this)),
+        m_inserting(false),
+        m_candidates(new QVector<Candidate>),
+        m_generation(0),
+        m_rankQueued(false) {
+
+    /**
+     * the model already holds the ranked candidates, so the completer must show it as is rather than apply its
+     * own prefix filter.
+     */
+
+    m_completer->setModel(&m_model);
+    m_completer->setWidget(m_textEdit);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_completer->setCaseSensitivity(Qt::CaseInsensitive);
+
+    connect(m_completer, QOverload<const QString &>::of(&QCompleter::activated), this, [this](const QString &host) {
+        insertCompletion(host);
+    });
+
+    connect(m_textEdit, &QTextEdit::textChanged, this, [this]() {
+        if (!m_inserting) {
+            requestCompletions();
+        }
+    });
+
+    auto targetManager = Nedrysoft::RouteAnalyser::TargetManager::getInstance();
+
+    connect(targetManager, &Nedrysoft::RouteAnalyser::TargetManager::favouritesChanged, this, [this]() {
+        updateCandidates();
+    });
+
+    connect(targetManager, &Nedrysoft::RouteAnalyser::TargetManager::recentsChanged, this, [this]() {
+        updateCandidates();
+    });
+
+    updateCandidates();
+}
+
+Nedrysoft::RouteAnalyser::TargetCompleter::~TargetCompleter() {
+    // a ranking that is already running uses the completer, so it must finish before the completer goes.
+
+    m_cancellationToken.cancelAndWait();
+}
+
+auto Nedrysoft::RouteAnalyser::TargetCompleter::updateCandidates() -> void {
+    auto targetManager = Nedrysoft::RouteAnalyser::TargetManager::getInstance();
+    auto candidates = new QVector<Candidate>;
+    auto hosts = QSet<QString>();
+
+    /**
+     * recent targets are listed first so that they win ties against favourites, a host that is in both is only
+     * offered once.
+     */
+
+    auto appendCandidate = [candidates, &hosts](const QString &host, const QString &name) {
+        auto hostKey = host.toLower();
+
+        if ((hostKey.isEmpty()) || (hosts.contains(hostKey))) {
+            return;
+        }
+
+        hosts.insert(hostKey);
+
+        candidates->append(Candidate{host, hostKey.toStdString(), name.toLower().toStdString()});
+    };
+
+    for (const auto &recent : targetManager->recents()) {
+        appendCandidate(recent["host"].toString(), recent["name"].toString());
+    }
+
+    const auto &favouritesStore = targetManager->favouritesStore();
+
+    for (auto index=0; index<favouritesStore.count(); index++) {
+        appendCandidate(favouritesStore.at(index).host, favouritesStore.at(index).name);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    m_candidates.reset(candidates);
+}
+
+auto Nedrysoft::RouteAnalyser::TargetCompleter::requestCompletions() -> void {
+    auto text = m_textEdit->toPlainText().trimmed();
+
+    if (text.isEmpty()) {
+        m_completer->popup()->hide();
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    m_query = text;
+    m_generation++;
+
+    /**
+     * the worker is woken once for any number of keystrokes made while it is busy, it always ranks the latest
+     * text.
+     */
+
+    if ((text.isEmpty()) || (m_rankQueued)) {
+        return;
+    }
+
+    m_rankQueued = true;
+
+    auto taskPool = Nedrysoft::Core::TaskPool::getInstance();
+
+    taskPool->submit(Nedrysoft::Core::TaskPool::Priority::Interactive, [this]() {
+        rank();
+    }, m_cancellationToken);
+}
+
+auto Nedrysoft::RouteAnalyser::TargetCompleter::rank() -> void {
+    m_mutex.lock();
+
+    auto query = m_query.toLower().toStdString();
+    auto generation = m_generation;
+    auto candidates = m_candidates;
+
+    m_rankQueued = false;
+
+    m_mutex.unlock();
+
+    if (query.empty()) {
+        return;
+    }
+
+    auto isCurrent = [this, generation]() {
+        QMutexLocker locker(&m_mutex);
+
+        return generation==m_generation;
+    };
+
+    auto scores = std::vector<std::pair<double, int> >();
+
+    for (auto index=0; index<candidates->count(); index++) {
+        if (((index % CancellationInterval)==0) && (!isCurrent())) {
+            return;
+        }
+
+        const auto &candidate = candidates->at(index);
+        auto score = 0.0;
+
+        if (candidate.hostKey.compare(0, query.size(), query)==0) {
+            score = HostPrefixScore;
+        } else if (candidate.nameKey.compare(0, query.size(), query)==0) {
+            score = NamePrefixScore;
+        } else {
+            score = std::max<double>(
+                    rapidfuzz::fuzz::partial_ratio(query, candidate.hostKey, MinimumScore),
+                    rapidfuzz::fuzz::partial_ratio(query, candidate.nameKey, MinimumScore) );
+        }
+
+        if (score>=MinimumScore) {
+            scores.emplace_back(-score, index);
+        }
+    }
+
+    auto count = std::min<size_t>(scores.size(), MaximumCompletions);
+
+    std::partial_sort(scores.begin(), scores.begin()+static_cast<std::ptrdiff_t>(count), scores.end());
+
+    auto hosts = QStringList();
+
+    for (size_t rankIndex=0; rankIndex<count; rankIndex++) {
+        hosts.append(candidates->at(scores[rankIndex].second).host);
+    }
+
+    QMetaObject::invokeMethod(this, [this, generation, hosts]() {
+        showCompletions(generation, hosts);
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::RouteAnalyser::TargetCompleter::showCompletions(quint64 generation, const QStringList &hosts) -> void {
+    m_mutex.lock();
+
+    auto isCurrent = (generation==m_generation);
+
+    m_mutex.unlock();
+
+    if (!isCurrent) {
+        return;
+    }
+
+    auto text = m_textEdit->toPlainText().trimmed();
+
+    if ((hosts.isEmpty()) || (!m_textEdit->hasFocus()) ||
+        ((hosts.count()==1) && (hosts.first().compare(text, Qt::CaseInsensitive)==0))) {
+
+        m_completer->popup()->hide();
+
+        return;
+    }
+
+    m_model.setStringList(hosts);
+
+    m_completer->popup()->setCurrentIndex(QModelIndex());
+    m_completer->complete(m_textEdit->rect());
+}
+
+auto Nedrysoft::RouteAnalyser::TargetCompleter::insertCompletion(const QString &host) -> void {
+    m_mutex.lock();
+
+    m_generation++;
+
+    m_mutex.unlock();
+
+    m_inserting = true;
+
+    m_textEdit->setPlainText(host);
+
+    m_inserting = false;
+
+    auto cursor = m_textEdit->textCursor();
+
+    cursor.movePosition(QTextCursor::End);
+
+    m_textEdit->setTextCursor(cursor);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_TARGETCOMPLETER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_TARGETCOMPLETER_H
+
+#include <CancellationToken>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringListModel>
+#include <QVector>
+
+#include <string>
+
+class QCompleter;
+class QTextEdit;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The TargetCompleter class offers ranked completion of recent and favourite targets.
+     *
+     * @details     The candidates are gathered from the TargetManager whenever the recents or favourites change and
+     *              are held with their lower case search keys, so nothing is converted while typing.  Each change
+     *              of the text queues a ranking in the interactive lane of the TaskPool, a ranking that has been
+     *              superseded by further typing is abandoned and only the latest result is shown, the user
+     *              interface thread only ever handles the few best candidates.
+     */
+    class TargetCompleter :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a new TargetCompleter for a target edit.
+             *
+             * @param[in]   textEdit the edit that completions are offered for, the completer is owned by it.
+             */
+            explicit TargetCompleter(QTextEdit *textEdit);
+
+            /**
+             * @brief       Destroys the TargetCompleter.
+             */
+            ~TargetCompleter() override;
+
+        private:
+            /**
+             * @brief       A target that can be offered as a completion.
+             */
+            struct Candidate {
+                QString host;
+                std::string hostKey;
+                std::string nameKey;
+            };
+
+            /**
+             * @brief       Rebuilds the candidates from the recents and favourites.
+             */
+            auto updateCandidates() -> void;
+
+            /**
+             * @brief       Queues a ranking of the candidates for the current text.
+             */
+            auto requestCompletions() -> void;
+
+            /**
+             * @brief       Ranks the candidates for the latest query, called on the worker thread.
+             */
+            auto rank() -> void;
+
+            /**
+             * @brief       Shows the result of a ranking, called on the user interface thread.
+             *
+             * @param[in]   generation the request that the ranking was made for.
+             * @param[in]   hosts the best candidates in rank order.
+             */
+            auto showCompletions(quint64 generation, const QStringList &hosts) -> void;
+
+            /**
+             * @brief       Replaces the text of the edit with a chosen completion.
+             *
+             * @param[in]   host the chosen host.
+             */
+            auto insertCompletion(const QString &host) -> void;
+
+        private:
+            //! @cond
+
+            QTextEdit *m_textEdit;
+            QCompleter *m_completer;
+            QStringListModel m_model;
+            bool m_inserting;
+
+            Nedrysoft::Core::CancellationToken m_cancellationToken;
+
+            QMutex m_mutex;
+            QSharedPointer<const QVector<Candidate> > m_candidates;
+            QString m_query;
+            quint64 m_generation;
+            bool m_rankQueued;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_TARGETCOMPLETER_H
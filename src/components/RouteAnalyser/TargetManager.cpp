@@ -25,6 +25,7 @@
 
 #include "TargetManager.h"
 
+#include <IConfigurationStore>
 #include <ICore>
 #if defined(Q_OS_MACOS)
 #include <MacHelper>
@@ -46,6 +47,7 @@
 
 constexpr auto ConfigurationPath = "Nedrysoft/Pingnoo/Components/RouteAnalyser";
 constexpr auto ConfigurationFilename = "Favourites.json";
+constexpr auto RecentsFilename = "Recents.json";
 
 Nedrysoft::RouteAnalyser::TargetManager::TargetManager() {
     loadFavourites();
@@ -63,45 +65,22 @@ auto Nedrysoft::RouteAnalyser::TargetManager::addFavourite(
         QString description,
         Nedrysoft::Core::IPVersion ipVersion ) -> void {
 
-    QVariantMap newFavourite;
+    auto favourite = Favourite();
 
-    newFavourite["host"] = host;
-    newFavourite["name"] = name;
-    newFavourite["description"] = description;
-#if (QT_VERSION_MAJOR>=6)
-    newFavourite["ipversion"] = QVariant::fromValue(ipVersion);
-#else
-    newFavourite["ipversion"].setValue<Nedrysoft::Core::IPVersion>(ipVersion);
-#endif
-    for (auto favourite : m_favouriteList) {
-        if (favourite["host"]==host) {
-            m_favouriteList.removeFirst();
-            break;
-        }
-    }
+    favourite.host = host;
+    favourite.name = name;
+    favourite.description = description;
+    favourite.ipVersion = ipVersion;
 
-    m_favouriteList.insert(0, newFavourite);
+    m_favourites.prepend(favourite);
 
     Q_EMIT favouritesChanged();
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::addRecent(QVariantMap parameters) -> void {
-    QVariantMap newRecent;
-    QList<int> indices;
+    m_recents.prepend(Favourite::fromMap(parameters));
 
-    for (auto recentIndex=0; recentIndex<m_recentsList.size(); recentIndex++) {
-        if (m_recentsList.at(recentIndex)["host"].toString().compare(parameters["host"].toString(), Qt::CaseInsensitive)==0) {
-            indices.push_front(recentIndex);
-        }
-    }
-
-    for (auto index : indices) {
-        m_recentsList.removeAt(index);
-    }
-
-    m_recentsList.insert(0, parameters);
-
-    saveFavourites();
+    saveRecents();
 
     Q_EMIT recentsChanged();
 }
@@ -126,49 +105,25 @@ auto Nedrysoft::RouteAnalyser::TargetManager::addRecent(
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::favourites() -> QList<QVariantMap> {
-    return m_favouriteList;
+    return m_favourites.toMaps();
+}
+
+auto Nedrysoft::RouteAnalyser::TargetManager::favouritesStore() const ->
+        const Nedrysoft::RouteAnalyser::FavouritesStore & {
+
+    return m_favourites;
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::recents() -> QList<QVariantMap> {
-    return m_recentsList;
+    return m_recents.toMaps();
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::saveConfiguration() -> QJsonObject {
     auto rootObject = QJsonObject();
 
     rootObject.insert("id", this->metaObject()->className());
-
-    auto favouritesArray = QJsonArray();
-
-    for (auto favourite : m_favouriteList) {
-        QJsonObject favouriteObject;
-
-        favouriteObject["host"] = favourite["host"].toString();
-        favouriteObject["name"] = favourite["name"].toString();
-        favouriteObject["description"] = favourite["description"].toString();
-        favouriteObject["interval"] = favourite["interval"].toInt();
-        favouriteObject["ipversion"] = favourite["ipversion"].toInt();
-
-        favouritesArray.append(favouriteObject);
-    }
-
-    rootObject.insert("favourites", favouritesArray);
-
-    auto recentsArray = QJsonArray();
-
-    for (auto recent : m_recentsList) {
-        QJsonObject recentObject;
-
-        recentObject["host"] = recent["host"].toString();
-        recentObject["name"] = recent["name"].toString();
-        recentObject["description"] = recent["description"].toString();
-        recentObject["interval"] = recent["interval"].toInt();
-        recentObject["ipversion"] = recent["ipversion"].toInt();
-
-        recentsArray.append(recentObject);
-    }
-
-    rootObject.insert("recents", recentsArray);
+    rootObject.insert("favourites", m_favourites.toJson());
+    rootObject.insert("recents", m_recents.toJson());
 
     return rootObject;
 }
@@ -179,110 +134,107 @@ auto Nedrysoft::RouteAnalyser::TargetManager::loadConfiguration(QJsonObject conf
     }
 
     if (configuration.contains("favourites")) {
-        auto favourites = configuration["favourites"].toArray();
-
-        for (auto favourite : favourites) {
-            QVariantMap favouriteMap;
-            QJsonObject favouriteObject = favourite.toObject();
-
-            favouriteMap["name"] = favouriteObject["name"].toString();
-            favouriteMap["description"] = favouriteObject["description"].toString();
-            favouriteMap["host"] = favouriteObject["host"].toString();
-            favouriteMap["interval"] = favouriteObject["interval"].toInt();
-            favouriteMap["ipversion"].setValue<Nedrysoft::Core::IPVersion>(
-                    favouriteObject["ipversion"].toVariant().value<Nedrysoft::Core::IPVersion>());
-
-            m_favouriteList.append(favouriteMap);
+        for (auto favourite : configuration["favourites"].toArray()) {
+            m_favourites.append(Favourite::fromJson(favourite.toObject()));
         }
     }
 
     if (configuration.contains("recents")) {
-        auto recents = configuration["recents"].toArray();
-
-        for (auto recent : recents) {
-            QVariantMap recentMap;
-            QJsonObject recentObject = recent.toObject();
-
-            recentMap["name"] = recentObject["name"].toString();
-            recentMap["description"] = recentObject["description"].toString();
-            recentMap["host"] = recentObject["host"].toString();
-            recentMap["interval"] = recentObject["interval"].toInt();
-            recentMap["ipversion"].setValue<Nedrysoft::Core::IPVersion>(
-                    recentObject["ipversion"].toVariant().value<Nedrysoft::Core::IPVersion>());
-
-             m_recentsList.append(recentMap);
+        for (auto recent : configuration["recents"].toArray()) {
+            m_recents.append(Favourite::fromJson(recent.toObject()));
         }
     }
 
     return true;
 }
 
-auto Nedrysoft::RouteAnalyser::TargetManager::loadFavourites(QString filename, bool append) -> bool {
-    auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+auto Nedrysoft::RouteAnalyser::TargetManager::storagePath(const QString &filename) -> QString {
+    return QDir::cleanPath(QString("%1/%2/%3")
+            .arg(Nedrysoft::Core::ICore::getInstance()->storageFolder())
+            .arg(ConfigurationPath)
+            .arg(filename));
+}
 
+auto Nedrysoft::RouteAnalyser::TargetManager::loadFavourites(QString filename, bool append) -> bool {
     QFile configurationFile;
 
     if (filename.isNull()) {
-        auto filePath = QString("%1/%2/%3")
-                .arg(storageLocation)
-                .arg(ConfigurationPath)
-                .arg(QString(ConfigurationFilename));
-
-        configurationFile.setFileName(QDir::cleanPath(filePath));
+        configurationFile.setFileName(storagePath(ConfigurationFilename));
     } else {
         configurationFile.setFileName(filename);
     }
 
-    if (configurationFile.open(QFile::ReadOnly)) {
-        auto jsonDocument = QJsonDocument::fromJson(configurationFile.readAll());
+    if (!configurationFile.open(QFile::ReadOnly)) {
+        return false;
+    }
 
-        if (jsonDocument.isObject()) {
-            if (!append) {
-                m_favouriteList.clear();
-            }
+    auto jsonDocument = QJsonDocument::fromJson(configurationFile.readAll());
+
+    if (!jsonDocument.isObject()) {
+        return false;
+    }
+
+    if (!append) {
+        m_favourites.clear();
+    }
+
+    loadConfiguration(jsonDocument.object());
+
+    /**
+     * the recent targets are stored separately, older configurations kept them in the favourites file so those
+     * are only replaced if the recents file exists.
+     */
+
+    if (filename.isNull()) {
+        QFile recentsFile(storagePath(RecentsFilename));
+
+        if (recentsFile.open(QFile::ReadOnly)) {
+            auto recentsDocument = QJsonDocument::fromJson(recentsFile.readAll());
 
-            loadConfiguration(jsonDocument.object());
+            if ((recentsDocument.isObject()) && (recentsDocument.object()["id"]==this->metaObject()->className())) {
+                m_recents.clear();
 
-            return true;
+                for (auto recent : recentsDocument.object()["recents"].toArray()) {
+                    m_recents.append(Favourite::fromJson(recent.toObject()));
+                }
+            }
         }
     }
 
-    return false;
+    return true;
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::saveFavourites(QString filename) -> bool {
-    auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+    auto configurationStore = Nedrysoft::Core::IConfigurationStore::getInstance();
 
-    QFile configurationFile;
+    /**
+     * the favourites are written in the background, an export is written before returning so that the result
+     * can be reported.
+     */
 
     if (filename.isNull()) {
-        auto filePath = QString("%1/%2/%3")
-                .arg(storageLocation)
-                .arg(ConfigurationPath)
-                .arg(QString(ConfigurationFilename));
+        auto rootObject = QJsonObject();
 
-        configurationFile.setFileName(QDir::cleanPath(filePath));
-    } else {
-        configurationFile.setFileName(filename);
-    }
+        rootObject.insert("id", this->metaObject()->className());
+        rootObject.insert("favourites", m_favourites.toJson());
 
-    QDir dir(QString("%1/%2").arg(storageLocation).arg(ConfigurationPath));
+        configurationStore->save(storagePath(ConfigurationFilename), rootObject);
 
-    if (!dir.exists()) {
-        dir.mkpath(dir.path());
+        return true;
     }
 
-    if (configurationFile.open(QFile::WriteOnly)) {
-        QJsonDocument favouritesDocument;
+    configurationStore->save(filename, saveConfiguration());
 
-        favouritesDocument.setObject(saveConfiguration());
+    return configurationStore->flush();
+}
 
-        configurationFile.write(favouritesDocument.toJson());
+auto Nedrysoft::RouteAnalyser::TargetManager::saveRecents() -> void {
+    auto rootObject = QJsonObject();
 
-        return true;
-    }
+    rootObject.insert("id", this->metaObject()->className());
+    rootObject.insert("recents", m_recents.toJson());
 
-    return false;
+    Nedrysoft::Core::IConfigurationStore::getInstance()->save(storagePath(RecentsFilename), rootObject);
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::importFavourites(QWidget *parent) -> void {
@@ -358,7 +310,15 @@ auto Nedrysoft::RouteAnalyser::TargetManager::exportFavourites(QWidget *parent)
 }
 
 auto Nedrysoft::RouteAnalyser::TargetManager::setFavourites(QList<QVariantMap> favourites) -> void {
-    m_favouriteList = favourites;
+    auto favouriteList = QVector<Favourite>();
+
+    favouriteList.reserve(favourites.count());
+
+    for (const auto &favourite : favourites) {
+        favouriteList.append(Favourite::fromMap(favourite));
+    }
+
+    m_favourites.setFavourites(favouriteList);
 
     saveFavourites();
 }
\ No newline at end of file
@@ -24,6 +24,8 @@
 #ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_TARGETMANAGER_H
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_TARGETMANAGER_H
 
+#include "FavouritesStore.h"
+
 #include <ICore>
 
 #include <QJsonObject>
@@ -107,6 +109,17 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto setFavourites(QList<QVariantMap> favourites) ->void;
 
+            /**
+             * @brief       Returns the indexed store that holds the favourites.
+             *
+             * @details     The positions of the favourites in the store match the order of the list returned by
+             *              favourites(), views use the store to search large favourite lists without converting
+             *              every entry.
+             *
+             * @returns     the favourites store.
+             */
+            auto favouritesStore() const -> const Nedrysoft::RouteAnalyser::FavouritesStore &;
+
             /**
              * @brief       Returns the list of recent targets
              *
@@ -133,6 +146,10 @@ namespace Nedrysoft { namespace RouteAnalyser {
             /**
              * @brief       Saves the current favourites configuration to disk.
              *
+             * @details     When saving to the components data storage location only the favourites are written,
+             *              the recent targets are kept in their own file so that opening a target does not rewrite
+             *              the favourites.  An export writes both to the given file.
+             *
              * @param[in]   filename is the name of the file to be saved, if empty then the components data
              *              storage location is used.
              *
@@ -176,11 +193,26 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             Q_SIGNAL void recentsChanged();
 
+        private:
+            /**
+             * @brief       Saves the recent targets to the components data storage location.
+             */
+            auto saveRecents() -> void;
+
+            /**
+             * @brief       Returns the full path of a file in the components data storage location.
+             *
+             * @param[in]   filename the name of the file.
+             *
+             * @returns     the path of the file.
+             */
+            auto storagePath(const QString &filename) -> QString;
+
         private:
             //! @cond
 
-            QList<QVariantMap> m_favouriteList;
-            QList<QVariantMap> m_recentsList;
+            Nedrysoft::RouteAnalyser::FavouritesStore m_favourites;
+            Nedrysoft::RouteAnalyser::FavouritesStore m_recents;
 
             //! @endcond
     };
@@ -24,7 +24,9 @@
 #include "TargetSettings.h"
 
 #include "IPingEngineFactory.h"
+#include "PingEngineBenchmark.h"
 
+#include <IConfigurationStore>
 #include <QDir>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -124,35 +126,20 @@ auto Nedrysoft::RouteAnalyser::TargetSettings::loadFromFile(QString filename, bo
 }
 
 auto Nedrysoft::RouteAnalyser::TargetSettings::saveToFile(QString filename) -> void {
-    auto storageLocation = Nedrysoft::Core::ICore::getInstance()->storageFolder();
-
-    QFile configurationFile;
+    auto configurationStore = Nedrysoft::Core::IConfigurationStore::getInstance();
+    auto isExport = !filename.isNull();
 
-    if (filename.isNull()) {
-        auto filePath = QString("%1/%2/%3")
-                .arg(storageLocation)
+    if (!isExport) {
+        filename = QDir::cleanPath(QString("%1/%2/%3")
+                .arg(Nedrysoft::Core::ICore::getInstance()->storageFolder())
                 .arg(ConfigurationPath)
-                .arg(QString(ConfigurationFilename));
-
-        configurationFile.setFileName(QDir::cleanPath(filePath));
-    } else {
-        configurationFile.setFileName(filename);
+                .arg(QString(ConfigurationFilename)));
     }
 
-    QDir dir(storageLocation);
+    configurationStore->save(filename, saveConfiguration());
 
-    if (!dir.exists(ConfigurationPath)) {
-        dir.mkpath(ConfigurationPath);
-    }
-
-    if (configurationFile.open(QFile::WriteOnly)) {
-        QJsonObject configuration = saveConfiguration();
-
-        auto jsonDocument = QJsonDocument(configuration);
-
-        if (jsonDocument.isObject()) {
-            configurationFile.write(jsonDocument.toJson());
-        }
+    if (isExport) {
+        configurationStore->flush();
     }
 }
 
@@ -189,17 +176,20 @@ auto Nedrysoft::RouteAnalyser::TargetSettings::defaultPingEngine() -> QString {
     QString selectedPingEngine = m_defaultPingEngine;
 
     if (selectedPingEngine.isEmpty()) {
-        auto pingEngines = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>();
+        auto fastestFactory =
+                Nedrysoft::RouteAnalyser::PingEngineBenchmark::getInstance()->fastestFactory(m_defaultIPVersion);
 
-        if (pingEngines.count()) {
-            int priority = pingEngines.at(0)->priority();
+        if (fastestFactory) {
+            return fastestFactory->metaObject()->className();
+        }
 
-            for (auto pingEngine : pingEngines) {
+        auto pingEngines = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>();
+        auto priority = -1.0;
 
-                if (pingEngine->priority() < priority) {
-                    priority = pingEngine->priority();
-                    selectedPingEngine = pingEngine->metaObject()->className();
-                }
+        for (auto pingEngine : pingEngines) {
+            if ((pingEngine->available()) && (pingEngine->priority() > priority)) {
+                priority = pingEngine->priority();
+                selectedPingEngine = pingEngine->metaObject()->className();
             }
         }
     }
@@ -207,6 +197,10 @@ auto Nedrysoft::RouteAnalyser::TargetSettings::defaultPingEngine() -> QString {
     return selectedPingEngine;
 }
 
+auto Nedrysoft::RouteAnalyser::TargetSettings::automaticPingEngine() -> bool {
+    return m_defaultPingEngine.isEmpty();
+}
+
 auto Nedrysoft::RouteAnalyser::TargetSettings::setDefaultPingInterval(double interval) -> void {
     m_defaultPingInterval = interval;
 }
@@ -99,10 +99,20 @@ namespace Nedrysoft { namespace RouteAnalyser {
             /**
              * @brief       Returns the default ping engine identifier.
              *
+             * @details     If no engine has been chosen then the fastest engine found by the engine benchmark is
+             *              used, until the benchmark has completed the engine with the highest priority is used.
+             *
              * @returns     the identifier of the ping engine.
              */
             auto defaultPingEngine() -> QString;
 
+            /**
+             * @brief       Returns whether the default ping engine is chosen automatically.
+             *
+             * @returns     true if no engine has been chosen; otherwise false.
+             */
+            auto automaticPingEngine() -> bool;
+
             /**
             * @brief       Sets the default interval between pings.
             *
@@ -44,6 +44,10 @@ Nedrysoft::RouteAnalyser::TargetSettingsPageWidget::TargetSettingsPageWidget(QWi
 
     QMultiMap<double, Nedrysoft::RouteAnalyser::IPingEngineFactory *> sortedPingEngines;
 
+    // the automatic entry has no identifier, the engine is then chosen from the benchmark of this host.
+
+    ui->defaultEngineComboBox->addItem(tr("Automatic (fastest on this computer)"), QString());
+
     for (auto factory : engineFactories) {
         ui->defaultEngineComboBox->addItem(factory->description(), factory->metaObject()->className());
 
@@ -60,7 +64,11 @@ Nedrysoft::RouteAnalyser::TargetSettingsPageWidget::TargetSettingsPageWidget(QWi
             ui->ipV4RadioButton->setChecked(true);
         }
 
-        auto selectionIndex = ui->defaultEngineComboBox->findData(targetSettings->defaultPingEngine());
+        auto selectionIndex = 0;
+
+        if (!targetSettings->automaticPingEngine()) {
+            selectionIndex = ui->defaultEngineComboBox->findData(targetSettings->defaultPingEngine());
+        }
 
         if (selectionIndex==-1) {
             if (sortedPingEngines.count()) {
@@ -25,9 +25,14 @@
 
 #include "TrimmerWidget.h"
 
+#include "HopTimeSeries.h"
+#include "LatencySettings.h"
+
+#include <Diagnostics>
 #include <QPainter>
 #include <QPaintEvent>
 #include <ThemeSupport>
+#include <algorithm>
 
 auto constexpr GripInsertWidth = 2;
 auto constexpr GripInsertHeight = 30;
@@ -51,12 +56,27 @@ auto constexpr TrimmerCornerRadius = 8;
 auto constexpr DefaultWidth = 200;
 auto constexpr DefaultHeight = 60;
 
+constexpr auto OverviewMaximumColumns = 1024;
+constexpr auto OverviewHeight = 48;
+constexpr auto OverviewLossHeight = 4;
+constexpr auto OverviewScaleFactor = 1.5;
+constexpr auto OverviewAlpha = 160;
+constexpr auto ChangePointColour = qRgb(0xff, 0x8c, 0x00);
+
 Nedrysoft::RouteAnalyser::TrimmerWidget::TrimmerWidget(QWidget *parent) :
         QWidget(parent),
         m_editingState(State::NotEditing),
         m_viewportPosition(0),
         m_viewportSize(0.5),
-        m_canBeResized(false) {
+        m_canBeResized(false),
+        m_overviewSeries(nullptr),
+        m_overviewLevel(-1),
+        m_overviewOrigin(0),
+        m_overviewScale(0),
+        m_overviewResume(0),
+        m_overviewColumns(0),
+        m_datasetStart(0),
+        m_datasetEnd(0) {
 
 }
 
@@ -65,6 +85,8 @@ Nedrysoft::RouteAnalyser::TrimmerWidget::~TrimmerWidget() {
 }
 
 auto Nedrysoft::RouteAnalyser::TrimmerWidget::paintEvent(QPaintEvent *event) -> void {
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Trimmer paint (ms)");
+
     QWidget::paintEvent(event);
 
     auto contentRect = rect();
@@ -152,6 +174,55 @@ auto Nedrysoft::RouteAnalyser::TrimmerWidget::paintEvent(QPaintEvent *event) ->
 
     painter.fillRect(QRectF(gripperRectLeft.topRight(), gripperRectRight.bottomLeft()), viewportBackgroundBrush);
 
+    /**
+     * the overview is drawn over both the track and the viewport, the columns of the cached image are placed at
+     * the times that they cover within the dataset.
+     */
+
+    if ((m_overviewColumns) && (m_datasetEnd>m_datasetStart)) {
+        auto resolution = Nedrysoft::RouteAnalyser::HopTimeSeries::resolution(m_overviewLevel);
+        auto pixelsPerSecond = (contentWidth-(TrimmerCornerRadius*2))/(m_datasetEnd-m_datasetStart);
+        auto left = TrimmerCornerRadius+((m_overviewOrigin-m_datasetStart)*pixelsPerSecond);
+
+        painter.save();
+
+        painter.resetTransform();
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.setClipRect(contentRect.adjusted(TrimmerCornerRadius, 0, -TrimmerCornerRadius, 0));
+
+        painter.drawImage(
+                QRectF(
+                    left,
+                    contentRect.top()+ViewportGripBorderSize,
+                    m_overviewColumns*resolution*pixelsPerSecond,
+                    contentRect.height()-(ViewportGripBorderSize*2) ),
+
+                m_overview,
+                QRectF(0, 0, m_overviewColumns, OverviewHeight) );
+
+        painter.restore();
+    }
+
+    // the change points are drawn over the overview so that they stay visible inside the viewport.
+
+    if ((!m_changePoints.isEmpty()) && (m_datasetEnd>m_datasetStart)) {
+        auto pixelsPerSecond = (contentWidth-(TrimmerCornerRadius*2))/(m_datasetEnd-m_datasetStart);
+
+        painter.save();
+
+        painter.resetTransform();
+        painter.setClipRect(contentRect.adjusted(TrimmerCornerRadius, 0, -TrimmerCornerRadius, 0));
+        painter.setPen(QPen(QColor(ChangePointColour), 1));
+
+        for (auto time : m_changePoints) {
+            auto x = TrimmerCornerRadius+((time-m_datasetStart)*pixelsPerSecond);
+
+            painter.drawLine(QPointF(x, contentRect.top()), QPointF(x, contentRect.bottom()));
+        }
+
+        painter.restore();
+    }
+
     painter.setBrush(gripBrush);
 
     // draw viewport left (start) grip
@@ -364,4 +435,142 @@ auto Nedrysoft::RouteAnalyser::TrimmerWidget::setFlags(TrimmerWidget::TrimmerFla
 
 auto Nedrysoft::RouteAnalyser::TrimmerWidget::setResizable(bool canBeResized) -> void {
     m_canBeResized = canBeResized;
+}
+
+auto Nedrysoft::RouteAnalyser::TrimmerWidget::setOverview(
+        const Nedrysoft::RouteAnalyser::HopTimeSeries *series,
+        double start,
+        double end ) -> void {
+
+    if (series!=m_overviewSeries) {
+        m_overviewSeries = series;
+        m_overviewLevel = -1;
+    }
+
+    m_datasetStart = start;
+    m_datasetEnd = end;
+
+    updateOverview();
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::TrimmerWidget::setChangePoints(const QVector<double> &times) -> void {
+    if (m_changePoints==times) {
+        return;
+    }
+
+    m_changePoints = times;
+
+    update();
+}
+
+auto Nedrysoft::RouteAnalyser::TrimmerWidget::updateOverview() -> void {
+    Nedrysoft::Core::DiagnosticsScope diagnosticsScope("Trimmer overview (ms)");
+
+    if ((!m_overviewSeries) || (!m_overviewSeries->count())) {
+        m_overview = QImage();
+        m_overviewLevel = -1;
+        m_overviewColumns = 0;
+
+        return;
+    }
+
+    auto latencySettings = Nedrysoft::RouteAnalyser::LatencySettings::getInstance();
+    auto scale = latencySettings->criticalValue()*OverviewScaleFactor;
+    auto levels = Nedrysoft::RouteAnalyser::HopTimeSeries::rollupLevels();
+
+    // the finest resolution whose rollups fit in the image is used, it only becomes coarser as the session grows.
+
+    auto level = std::max(m_overviewLevel, 0);
+
+    while (level<levels-1) {
+        auto resolution = Nedrysoft::RouteAnalyser::HopTimeSeries::resolution(level);
+        auto span = m_overviewSeries->lastTime()-m_overviewSeries->rollup(level, 0).time;
+
+        if (span/resolution<OverviewMaximumColumns) {
+            break;
+        }
+
+        level++;
+    }
+
+    auto resolution = Nedrysoft::RouteAnalyser::HopTimeSeries::resolution(level);
+    auto origin = m_overviewSeries->rollup(level, 0).time;
+
+    // a series that outgrows even the coarsest resolution shows the most recent part that fits.
+
+    if ((m_overviewSeries->lastTime()-origin)/resolution>=OverviewMaximumColumns) {
+        auto first = m_overviewSeries->rollupLowerBound(
+            level,
+            m_overviewSeries->lastTime()-((OverviewMaximumColumns-1)*resolution) );
+
+        origin = m_overviewSeries->rollup(level, std::min(first, m_overviewSeries->rollupCount(level)-1)).time;
+    }
+
+    /**
+     * the image is rebuilt when the resolution changes, when the oldest rollup has been dropped from the series
+     * (which moves every column) or when the latency scale has changed, otherwise drawing resumes from the last
+     * rollup drawn as it may have received more samples since.
+     */
+
+    if ((level!=m_overviewLevel) || (origin!=m_overviewOrigin) || (scale!=m_overviewScale) || (m_overview.isNull())) {
+        m_overview = QImage(OverviewMaximumColumns, OverviewHeight, QImage::Format_ARGB32_Premultiplied);
+
+        m_overview.fill(Qt::transparent);
+
+        m_overviewLevel = level;
+        m_overviewOrigin = origin;
+        m_overviewScale = scale;
+        m_overviewResume = origin;
+        m_overviewColumns = 0;
+    }
+
+    auto rollupCount = m_overviewSeries->rollupCount(level);
+    auto lossColour = QColor(latencySettings->criticalColour()).darker();
+    auto envelopeHeight = OverviewHeight-OverviewLossHeight;
+
+    auto yPosition = [=](double roundTripTime) {
+        return (envelopeHeight-1)-static_cast<int>((std::min(roundTripTime/scale, 1.0))*(envelopeHeight-1));
+    };
+
+    QPainter painter(&m_overview);
+
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    for (auto index=m_overviewSeries->rollupLowerBound(level, m_overviewResume);index<rollupCount;index++) {
+        auto &rollup = m_overviewSeries->rollup(level, index);
+        auto column = static_cast<int>((rollup.time-origin)/resolution);
+
+        if ((column<0) || (column>=OverviewMaximumColumns)) {
+            continue;
+        }
+
+        painter.fillRect(column, 0, 1, OverviewHeight, Qt::transparent);
+
+        if (rollup.count) {
+            auto colour = QColor(latencySettings->idealColour());
+
+            if (rollup.maximum>=latencySettings->criticalValue()) {
+                colour = QColor(latencySettings->criticalColour());
+            } else if (rollup.maximum>=latencySettings->warningValue()) {
+                colour = QColor(latencySettings->warningColour());
+            }
+
+            colour.setAlpha(OverviewAlpha);
+
+            auto top = yPosition(rollup.maximum);
+            auto bottom = yPosition(rollup.minimum);
+
+            painter.fillRect(column, top, 1, (bottom-top)+1, colour);
+        }
+
+        if (rollup.lost) {
+            painter.fillRect(column, envelopeHeight, 1, OverviewLossHeight, lossColour);
+        }
+
+        m_overviewColumns = std::max(m_overviewColumns, column+1);
+    }
+
+    m_overviewResume = m_overviewSeries->rollup(level, rollupCount-1).time;
 }
\ No newline at end of file
@@ -24,15 +24,26 @@
 #ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_TRIMMERWIDGET_H
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_TRIMMERWIDGET_H
 
+#include "RouteAnalyserSpec.h"
+
 #include <QWidget>
 #include <QFlags>
+#include <QImage>
+#include <QVector>
 
 namespace Nedrysoft { namespace RouteAnalyser {
+    class HopTimeSeries;
+
     /**
      * @brief       The TrimmerWidget provides an overview of the dataset along with a viewport for the currently viewed
      *              subset.
+     *
+     * @details     The overview is the latency envelope and loss of a single hop, drawn from the coarse rollups of
+     *              its time series into a cached image with one column per rollup.  Each update only draws the
+     *              rollups that have changed since the last one, the image is rebuilt at the next coarser
+     *              resolution when it fills, so the cost does not grow with the length of the session.
      */
-    class TrimmerWidget :
+    class NEDRYSOFT_ROUTEANALYSER_DLLSPEC TrimmerWidget :
             public QWidget {
 
         private:
@@ -118,6 +129,25 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto setResizable(bool canBeResized) -> void;
 
+            /**
+             * @brief       Sets the series shown as the overview and the span of the dataset.
+             *
+             * @details     Only the rollups added since the previous call are drawn, the overview is rebuilt if the
+             *              series or its oldest rollup has changed.
+             *
+             * @param[in]   series the time series to show; nullptr to remove the overview.
+             * @param[in]   start the start of the dataset in seconds since the unix epoch.
+             * @param[in]   end the end of the dataset in seconds since the unix epoch.
+             */
+            auto setOverview(const Nedrysoft::RouteAnalyser::HopTimeSeries *series, double start, double end) -> void;
+
+            /**
+             * @brief       Sets the times that are marked as change points on the overview.
+             *
+             * @param[in]   times the times in seconds since the unix epoch.
+             */
+            auto setChangePoints(const QVector<double> &times) -> void;
+
         protected:
             /**
              * @brief       Reimplements: QWidget::mousePressEvent(QMouseEvent *event).
@@ -154,6 +184,12 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             QSize sizeHint() const override;
 
+        private:
+            /**
+             * @brief       Draws the rollups of the overview series that have changed since the previous update.
+             */
+            auto updateOverview() -> void;
+
         private:
             //! @cond
 
@@ -165,6 +201,17 @@ namespace Nedrysoft { namespace RouteAnalyser {
             TrimmerFlags m_flags;
             bool m_canBeResized;
 
+            const Nedrysoft::RouteAnalyser::HopTimeSeries *m_overviewSeries;
+            QImage m_overview;
+            int m_overviewLevel;
+            double m_overviewOrigin;
+            double m_overviewScale;
+            double m_overviewResume;
+            int m_overviewColumns;
+            double m_datasetStart;
+            double m_datasetEnd;
+            QVector<double> m_changePoints;
+
             //! @endcond
     };
 }}
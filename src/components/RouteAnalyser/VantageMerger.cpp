@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VantageMerger.h"
+
+#include <algorithm>
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::Aggregate::add(
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    if (Nedrysoft::RouteAnalyser::PingResult::isLost(result.code())) {
+        timeouts++;
+
+        return;
+    }
+
+    currentLatency = result.roundTripTime();
+
+    sketch.add(currentLatency);
+    latency.add(currentLatency);
+
+    replies++;
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::Aggregate::merge(const Aggregate &other) -> void {
+    sketch.merge(other.sketch);
+    latency.merge(other.latency);
+
+    if (other.currentLatency>=0) {
+        currentLatency = other.currentLatency;
+    }
+
+    replies += other.replies;
+    timeouts += other.timeouts;
+}
+
+Nedrysoft::RouteAnalyser::VantageMerger::VantageMerger() :
+        m_layoutGeneration(0) {
+
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::setRoute(
+        int vantage,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> void {
+
+    auto previousRoute = m_routes.value(vantage);
+
+    for (auto hop=1;hop<=previousRoute.count();hop++) {
+        if ((hop>route.count()) || (route.at(hop-1)!=previousRoute.at(hop-1))) {
+            m_hopAggregates.remove(qMakePair(vantage, hop));
+        }
+    }
+
+    m_routes[vantage] = route;
+
+    realign();
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::removeVantage(int vantage) -> void {
+    auto route = m_routes.take(vantage);
+
+    for (auto hop=1;hop<=route.count();hop++) {
+        m_hopAggregates.remove(qMakePair(vantage, hop));
+    }
+
+    realign();
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::add(
+        int vantage,
+        int hop,
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    auto key = qMakePair(vantage, hop);
+    auto row = m_rowIndex.value(key, -1);
+
+    if (row<0) {
+        return;
+    }
+
+    m_hopAggregates[key].add(result);
+    m_rows[row].aggregate.add(result);
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::rows() const -> const QVector<Row> & {
+    return m_rows;
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::layoutGeneration() const -> quint64 {
+    return m_layoutGeneration;
+}
+
+auto Nedrysoft::RouteAnalyser::VantageMerger::realign() -> void {
+    auto rows = QVector<Row>();
+    auto rowOfAddress = QHash<QHostAddress, int>();
+
+    for (auto route=m_routes.begin();route!=m_routes.end();route++) {
+        for (auto hop=1;hop<=route->count();hop++) {
+            auto address = route->at(hop-1);
+            auto distance = static_cast<int>(route->count())-hop;
+
+            /**
+             * a hop that did not answer cannot be matched with the hops of the other routes, it is always a row
+             * of its own.
+             */
+
+            auto row = address.isNull() ? -1 : rowOfAddress.value(address, -1);
+
+            if (row<0) {
+                row = rows.count();
+
+                rows.append(Row());
+
+                rows[row].address = address;
+                rows[row].distance = distance;
+
+                if (!address.isNull()) {
+                    rowOfAddress[address] = row;
+                }
+            }
+
+            auto &mergedRow = rows[row];
+
+            // a route that loops passes the same router twice, the row keeps the first visit.
+
+            if (!mergedRow.hops.contains(route.key())) {
+                mergedRow.hops[route.key()] = hop;
+            }
+
+            mergedRow.distance = std::min(mergedRow.distance, distance);
+        }
+    }
+
+    std::stable_sort(rows.begin(), rows.end(), [](const Row &first, const Row &second) {
+        return first.distance>second.distance;
+    });
+
+    m_rowIndex.clear();
+
+    for (auto row=0;row<rows.count();row++) {
+        for (auto hop=rows[row].hops.begin();hop!=rows[row].hops.end();hop++) {
+            auto key = qMakePair(hop.key(), hop.value());
+
+            m_rowIndex[key] = row;
+
+            if (m_hopAggregates.contains(key)) {
+                rows[row].aggregate.merge(m_hopAggregates[key]);
+            }
+        }
+    }
+
+    m_rows = rows;
+
+    m_layoutGeneration++;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_VANTAGEMERGER_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_VANTAGEMERGER_H
+
+#include "IRouteEngine.h"
+#include "LatencySketch.h"
+#include "PingResult.h"
+#include "RunningStatistics.h"
+
+#include <QHash>
+#include <QHostAddress>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The VantageMerger class combines the routes to one target traced from several vantage points.
+     *
+     * @details     The routes are aligned on the addresses of their hops, a router that appears on the routes of
+     *              several vantage points is a single row (the paths converge there) and the hops before the paths
+     *              meet are rows of their own vantage point.  The rows are ordered by their distance from the
+     *              target, so the shared end of the paths lines up at the bottom.
+     *
+     *              The aggregates of each hop of each vantage point are kept as mergeable sketches.  A result is
+     *              added to the aggregates of its hop and of its row, so an update costs the same however long the
+     *              histories are, and the rows are only rebuilt by merging the sketches of their hops when a route
+     *              changes.
+     *
+     *              Vantage points are identified by an integer chosen by the caller, hops are numbered from 1.
+     */
+    class VantageMerger {
+        public:
+            /**
+             * @brief       The mergeable aggregates of a set of results.
+             */
+            struct Aggregate {
+                Nedrysoft::RouteAnalyser::LatencySketch sketch;             //!< the distribution of latency.
+                Nedrysoft::RouteAnalyser::RunningStatistics latency;        //!< the mean and variance of latency.
+                double currentLatency = -1;                                 //!< the latest latency, -1 if none.
+                unsigned long replies = 0;                                  //!< the number of replies.
+                unsigned long timeouts = 0;                                 //!< the number of lost requests.
+
+                /**
+                 * @brief       Adds a result to the aggregates.
+                 *
+                 * @param[in]   result the result.
+                 */
+                auto add(const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+                /**
+                 * @brief       Adds the aggregates of another set of results.
+                 *
+                 * @param[in]   other the aggregates to merge.
+                 */
+                auto merge(const Aggregate &other) -> void;
+            };
+
+            /**
+             * @brief       A row of the merged route.
+             */
+            struct Row {
+                QHostAddress address;                                       //!< the hop, null if it is silent.
+                QMap<int, int> hops;                                        //!< the hop number per vantage point.
+                int distance = 0;                                           //!< the hops left to the target.
+                Aggregate aggregate;                                        //!< the merged results of the row.
+            };
+
+        public:
+            /**
+             * @brief       Constructs an empty VantageMerger.
+             */
+            VantageMerger();
+
+            /**
+             * @brief       Sets the route traced from a vantage point and realigns the rows.
+             *
+             * @details     The aggregates of hops whose address has changed are discarded, as they describe a
+             *              different router.
+             *
+             * @param[in]   vantage the identifier of the vantage point.
+             * @param[in]   route the route, the last hop is the target.
+             */
+            auto setRoute(int vantage, const Nedrysoft::RouteAnalyser::RouteList &route) -> void;
+
+            /**
+             * @brief       Removes a vantage point and realigns the rows.
+             *
+             * @param[in]   vantage the identifier of the vantage point.
+             */
+            auto removeVantage(int vantage) -> void;
+
+            /**
+             * @brief       Adds a result for a hop of a vantage point.
+             *
+             * @param[in]   vantage the identifier of the vantage point.
+             * @param[in]   hop the hop number.
+             * @param[in]   result the result.
+             */
+            auto add(int vantage, int hop, const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Returns the rows of the merged route.
+             *
+             * @returns     the rows, furthest from the target first.
+             */
+            auto rows() const -> const QVector<Row> &;
+
+            /**
+             * @brief       Returns a number that changes whenever the rows are realigned.
+             *
+             * @returns     the layout generation.
+             */
+            auto layoutGeneration() const -> quint64;
+
+        private:
+            /**
+             * @brief       Rebuilds the rows from the routes and merges the aggregates of their hops.
+             */
+            auto realign() -> void;
+
+        private:
+            //! @cond
+
+            QMap<int, Nedrysoft::RouteAnalyser::RouteList> m_routes;
+            QHash<QPair<int, int>, Aggregate> m_hopAggregates;
+            QHash<QPair<int, int>, int> m_rowIndex;
+            QVector<Row> m_rows;
+            quint64 m_layoutGeneration;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_VANTAGEMERGER_H
@@ -101,3 +101,15 @@ auto Nedrysoft::RouteAnalyser::ViewportRibbonGroup::viewportSize() -> double {
 
     return DefaultViewportSize;
 }
+
+auto Nedrysoft::RouteAnalyser::ViewportRibbonGroup::setOverview(
+        const Nedrysoft::RouteAnalyser::HopTimeSeries *series,
+        double start,
+        double end ) -> void {
+
+    ui->trimmerWidget->setOverview(series, start, end);
+}
+
+auto Nedrysoft::RouteAnalyser::ViewportRibbonGroup::setChangePoints(const QVector<double> &times) -> void {
+    ui->trimmerWidget->setChangePoints(times);
+}
@@ -24,9 +24,12 @@
 #ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_VIEWPORTRIBBONGROUP_H
 #define PINGNOO_COMPONENTS_ROUTEANALYSER_VIEWPORTRIBBONGROUP_H
 
+#include <QVector>
 #include <QWidget>
 
 namespace Nedrysoft { namespace RouteAnalyser {
+    class HopTimeSeries;
+
     namespace Ui {
         class ViewportRibbonGroup;
     }
@@ -90,6 +93,22 @@ namespace Nedrysoft { namespace RouteAnalyser {
              */
             auto viewportSize() -> double;
 
+            /**
+             * @brief       Sets the series drawn as the overview of the dataset in the trimmer.
+             *
+             * @param[in]   series the time series to show; nullptr to remove the overview.
+             * @param[in]   start the start of the dataset in seconds since the unix epoch.
+             * @param[in]   end the end of the dataset in seconds since the unix epoch.
+             */
+            auto setOverview(const Nedrysoft::RouteAnalyser::HopTimeSeries *series, double start, double end) -> void;
+
+            /**
+             * @brief       Sets the times that are marked as change points in the trimmer.
+             *
+             * @param[in]   times the times in seconds since the unix epoch.
+             */
+            auto setChangePoints(const QVector<double> &times) -> void;
+
         public:
             /**
              * @brief       This signal is emitted when the viewport start and/or end has been modified.
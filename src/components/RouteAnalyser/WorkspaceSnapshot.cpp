@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkspaceSnapshot.h"
+
+#include "RouteAnalyserEditor.h"
+
+#include <IComponentManager>
+#include <IConfigurationStore>
+#include <ICore>
+#include <IEditorManager>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+
+constexpr auto WorkspacePath = "Nedrysoft/Pingnoo/Components/RouteAnalyser/Workspace";
+constexpr auto WorkspaceFilename = "Workspace.json";
+constexpr auto HistoryFilter = "*.pingcap";
+constexpr auto HistoryPeriod = 10.0*60.0;
+constexpr auto SaveInterval = 5*60*1000;
+
+Nedrysoft::RouteAnalyser::WorkspaceSnapshot::WorkspaceSnapshot() :
+        m_saveTimer(new QTimer(this)),
+        m_restored(false) {
+
+    m_saveTimer->setInterval(SaveInterval);
+
+    connect(m_saveTimer, &QTimer::timeout, this, [this]() {
+        save();
+    });
+}
+
+Nedrysoft::RouteAnalyser::WorkspaceSnapshot::~WorkspaceSnapshot() {
+}
+
+auto Nedrysoft::RouteAnalyser::WorkspaceSnapshot::getInstance() -> Nedrysoft::RouteAnalyser::WorkspaceSnapshot * {
+    static Nedrysoft::RouteAnalyser::WorkspaceSnapshot instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteAnalyser::WorkspaceSnapshot::workspaceFolder() -> QString {
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+
+    return QDir::cleanPath(QString("%1/%2").arg(storageFolder).arg(WorkspacePath));
+}
+
+auto Nedrysoft::RouteAnalyser::WorkspaceSnapshot::save() -> void {
+    if (!m_restored) {
+        return;
+    }
+
+    auto folder = QDir(workspaceFolder());
+
+    if (!folder.mkpath(".")) {
+        SPDLOG_WARN(QString("Unable to create %1, the workspace was not saved.").arg(folder.path()).toStdString());
+
+        return;
+    }
+
+    /**
+     * each snapshot writes its history under a new name, the captures of the previous snapshot are only removed
+     * once they are no longer referenced, so a snapshot is never left pointing at a half written capture.
+     */
+
+    auto prefix = QString::number(QDateTime::currentMSecsSinceEpoch());
+    auto editors = QJsonArray();
+    auto historyFiles = QSet<QString>();
+
+    auto editorList = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::RouteAnalyserEditor>();
+
+    for (auto index=0;index<editorList.count();index++) {
+        auto historyFile = folder.filePath(QString("%1-%2").arg(prefix).arg(index));
+        auto workspaceObject = editorList.at(index)->saveWorkspace(historyFile, HistoryPeriod);
+
+        if (workspaceObject.isEmpty()) {
+            continue;
+        }
+
+        for (auto filename : workspaceObject.value("history").toArray()) {
+            historyFiles.insert(QFileInfo(filename.toString()).fileName());
+        }
+
+        editors.append(workspaceObject);
+    }
+
+    // editors that are still waiting to be restored keep the state and history of the previous snapshot.
+
+    for (auto pendingEditor : m_pendingEditors) {
+        for (auto filename : pendingEditor.toObject().value("history").toArray()) {
+            historyFiles.insert(QFileInfo(filename.toString()).fileName());
+        }
+
+        editors.append(pendingEditor);
+    }
+
+    auto rootObject = QJsonObject();
+
+    rootObject.insert("editors", editors);
+
+    Nedrysoft::Core::IConfigurationStore::getInstance()->save(folder.filePath(WorkspaceFilename), rootObject);
+
+    for (auto &filename : folder.entryList(QStringList() << HistoryFilter, QDir::Files)) {
+        if (!historyFiles.contains(filename)) {
+            folder.remove(filename);
+        }
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::WorkspaceSnapshot::restore() -> void {
+    QFile workspaceFile(QDir(workspaceFolder()).filePath(WorkspaceFilename));
+
+    if (workspaceFile.open(QFile::ReadOnly)) {
+        auto jsonDocument = QJsonDocument::fromJson(workspaceFile.readAll());
+
+        if (jsonDocument.isObject()) {
+            m_pendingEditors = jsonDocument.object().value("editors").toArray();
+        }
+    }
+
+    m_restored = true;
+
+    m_saveTimer->start();
+
+    if (!m_pendingEditors.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() {
+            restoreNext();
+        });
+    }
+}
+
+auto Nedrysoft::RouteAnalyser::WorkspaceSnapshot::restoreNext() -> void {
+    auto editorManager = Nedrysoft::Core::IEditorManager::getInstance();
+
+    if ((m_pendingEditors.isEmpty()) || (!editorManager)) {
+        return;
+    }
+
+    auto workspaceObject = m_pendingEditors.takeAt(0).toObject();
+    auto editor = new Nedrysoft::RouteAnalyser::RouteAnalyserEditor;
+
+    if (editor->loadWorkspace(workspaceObject)) {
+        editorManager->openEditor(editor);
+    } else {
+        SPDLOG_WARN(QString("Unable to restore the editor for %1.")
+                .arg(workspaceObject.value("target").toString()).toStdString());
+
+        delete editor;
+    }
+
+    if (!m_pendingEditors.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() {
+            restoreNext();
+        });
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEANALYSER_WORKSPACESNAPSHOT_H
+#define PINGNOO_COMPONENTS_ROUTEANALYSER_WORKSPACESNAPSHOT_H
+
+#include <QJsonArray>
+#include <QObject>
+#include <QString>
+
+class QTimer;
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    /**
+     * @brief       The WorkspaceSnapshot class reopens the route analyser editors that were open when the
+     *              application last exited.
+     *
+     * @details     The snapshot holds the settings of every live editor and a capture of the recent history of
+     *              each of its analyses, it is written on exit and every few minutes while editors are open.  The
+     *              routes, host names and locations of the hops are already held by their own persistent caches,
+     *              so a restored editor starts monitoring the cached route straight away and shows the history
+     *              while the route is validated and live probing resumes in the background.
+     *
+     *              Editors are restored one per pass of the event loop, so the main window is responsive while
+     *              the workspace is reopened.
+     */
+    class WorkspaceSnapshot :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        private:
+            /**
+             * @brief       Constructs the WorkspaceSnapshot.
+             */
+            WorkspaceSnapshot();
+
+        public:
+            /**
+             * @brief       Destroys the WorkspaceSnapshot.
+             */
+            ~WorkspaceSnapshot();
+
+            /**
+             * @brief       Returns the process wide instance of the snapshot.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> WorkspaceSnapshot *;
+
+            /**
+             * @brief       Writes the snapshot of the open editors.
+             *
+             * @note        Nothing is written until the previous snapshot has been restored, so that it is not
+             *              replaced by an empty workspace.
+             */
+            auto save() -> void;
+
+            /**
+             * @brief       Reopens the editors of the last snapshot and starts saving periodically.
+             */
+            auto restore() -> void;
+
+        private:
+            /**
+             * @brief       Opens the next editor waiting to be restored.
+             */
+            auto restoreNext() -> void;
+
+            /**
+             * @brief       Returns the folder that holds the snapshot and the history captures.
+             *
+             * @returns     the path of the folder.
+             */
+            static auto workspaceFolder() -> QString;
+
+        private:
+            //! @cond
+
+            QTimer *m_saveTimer;
+            QJsonArray m_pendingEditors;
+            bool m_restored;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEANALYSER_WORKSPACESNAPSHOT_H
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FleetMonitor.h"
+
+#include "RouteEngine.h"
+
+#include <IPingEngine>
+#include <IPingEngineFactory>
+#include <IPingTarget>
+
+constexpr auto DefaultFleetInterval = 5000;
+constexpr auto MaximumConcurrentDiscoveries = 8;
+
+Nedrysoft::RouteEngine::FleetMonitor::FleetMonitor() :
+        m_pingEngineFactory(nullptr),
+        m_pingEngine(nullptr),
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_interval(DefaultFleetInterval),
+        m_nextTarget(0),
+        m_activeDiscoveries(0),
+        m_isRunning(false) {
+
+}
+
+Nedrysoft::RouteEngine::FleetMonitor::~FleetMonitor() {
+    stop();
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::setTargets(const QStringList &hosts) -> void {
+    m_targets.clear();
+
+    for (auto &host : hosts) {
+        auto target = Nedrysoft::RouteAnalyser::FleetTarget();
+
+        target.host = host;
+
+        m_targets.append(target);
+    }
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::setInterval(int interval) -> void {
+    m_interval = interval;
+
+    if (m_pingEngine) {
+        m_pingEngine->setInterval(m_interval);
+    }
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::start(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+        Nedrysoft::Core::IPVersion ipVersion ) -> bool {
+
+    if ((m_isRunning) || (!pingEngineFactory)) {
+        return false;
+    }
+
+    m_pingEngineFactory = pingEngineFactory;
+    m_ipVersion = ipVersion;
+
+    m_pingEngine = m_pingEngineFactory->createEngine(m_ipVersion);
+
+    if (!m_pingEngine) {
+        return false;
+    }
+
+    m_pingEngine->setInterval(m_interval);
+
+    if (m_pingEngine->setResultBatching(true)) {
+        connect(
+            m_pingEngine,
+            &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+            this,
+            [=](QVector<Nedrysoft::RouteAnalyser::PingResult> results) {
+
+            auto changed = false;
+
+            for (auto &result : results) {
+                if (processPingResult(result)) {
+                    changed = true;
+                }
+            }
+
+            if (changed) {
+                Q_EMIT summaryChanged();
+            }
+        });
+    } else {
+        connect(
+            m_pingEngine,
+            &Nedrysoft::RouteAnalyser::IPingEngine::result,
+            this,
+            [=](Nedrysoft::RouteAnalyser::PingResult result) {
+
+            if (processPingResult(result)) {
+                Q_EMIT summaryChanged();
+            }
+        });
+    }
+
+    m_isRunning = true;
+    m_nextTarget = 0;
+
+    m_pingEngine->start();
+
+    discoverNext();
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::stop() -> void {
+    if (!m_isRunning) {
+        return;
+    }
+
+    m_isRunning = false;
+
+    m_pingEngine->stop();
+
+    m_pingEngineFactory->deleteEngine(m_pingEngine);
+
+    m_pingEngine = nullptr;
+
+    m_hopTargets.clear();
+    m_hops.clear();
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::discoverNext() -> void {
+    /**
+     * discovery of several hundred routes at once would flood the first hops with probes, so only a few routes
+     * are traced at a time and the next is started as each one completes.
+     */
+
+    while ((m_isRunning) &&
+           (m_activeDiscoveries<MaximumConcurrentDiscoveries) &&
+           (m_nextTarget<m_targets.count())) {
+
+        auto targetIndex = m_nextTarget++;
+        auto routeEngine = new Nedrysoft::RouteEngine::RouteEngine();
+
+        m_activeDiscoveries++;
+
+        connect(
+            routeEngine,
+            &Nedrysoft::RouteAnalyser::IRouteEngine::result,
+            this,
+            [=](const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const bool completed,
+                const int,
+                const int ) {
+
+            if (!completed) {
+                return;
+            }
+
+            m_activeDiscoveries--;
+
+            routeEngine->deleteLater();
+
+            if (!m_isRunning) {
+                return;
+            }
+
+            addRoute(targetIndex, hostAddress, route);
+
+            discoverNext();
+        });
+
+        routeEngine->findRoute(m_pingEngineFactory, m_targets.at(targetIndex).host, m_ipVersion);
+    }
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::addRoute(
+        int targetIndex,
+        const QHostAddress &hostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> void {
+
+    auto &target = m_targets[targetIndex];
+
+    target.address = hostAddress;
+    target.route = route;
+    target.discovered = true;
+
+    for (auto &hopAddress : route) {
+        if (hopAddress.isNull()) {
+            continue;
+        }
+
+        auto hop = m_hops.find(hopAddress);
+
+        if (hop!=m_hops.end()) {
+            hop->routes++;
+
+            continue;
+        }
+
+        auto newHop = Nedrysoft::RouteAnalyser::FleetHop();
+
+        newHop.address = hopAddress;
+        newHop.routes = 1;
+
+        m_hops[hopAddress] = newHop;
+
+        auto pingTarget = m_pingEngine->addTarget(hopAddress);
+
+        if (pingTarget) {
+            m_hopTargets[pingTarget] = hopAddress;
+        }
+    }
+
+    Q_EMIT summaryChanged();
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::processPingResult(
+        const Nedrysoft::RouteAnalyser::PingResult &result) -> bool {
+
+    auto hopTarget = m_hopTargets.find(result.target());
+
+    if (hopTarget==m_hopTargets.end()) {
+        return false;
+    }
+
+    auto hop = m_hops.find(hopTarget.value());
+
+    if (hop==m_hops.end()) {
+        return false;
+    }
+
+    if (result.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
+        hop->latency = result.roundTripTime();
+        hop->replies++;
+    } else {
+        hop->timeouts++;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::targets() -> QList<Nedrysoft::RouteAnalyser::FleetTarget> {
+    return m_targets;
+}
+
+auto Nedrysoft::RouteEngine::FleetMonitor::hops() -> QList<Nedrysoft::RouteAnalyser::FleetHop> {
+    return m_hops.values();
+}
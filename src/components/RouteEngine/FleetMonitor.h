@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEENGINE_FLEETMONITOR_H
+#define PINGNOO_COMPONENTS_ROUTEENGINE_FLEETMONITOR_H
+
+#include <IFleetMonitor>
+#include <ICore>
+#include <PingResult>
+
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QStringList>
+
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngine;
+    class IPingEngineFactory;
+    class IPingTarget;
+}}
+
+namespace Nedrysoft { namespace RouteEngine {
+    /**
+     * @brief       The FleetMonitor provides an implementation of IFleetMonitor.
+     *
+     * @details     Routes are discovered a few at a time using RouteEngine instances, as each route completes its
+     *              hops are merged into a single table keyed by address and any hop not already monitored is
+     *              added as a target of the one shared ping engine.
+     */
+    class FleetMonitor :
+            public Nedrysoft::RouteAnalyser::IFleetMonitor {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IFleetMonitor)
+
+        public:
+            /**
+             * @brief       Constructs a FleetMonitor.
+             */
+            FleetMonitor();
+
+            /**
+             * @brief       Destroys the FleetMonitor.
+             */
+            ~FleetMonitor();
+
+        public:
+            /**
+             * @brief       Sets the list of targets to monitor.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::setTargets
+             *
+             * @param[in]   hosts the host names or addresses of the targets.
+             */
+            auto setTargets(const QStringList &hosts) -> void override;
+
+            /**
+             * @brief       Sets the interval between requests to each monitored hop.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::setInterval
+             *
+             * @param[in]   interval the interval in milliseconds.
+             */
+            auto setInterval(int interval) -> void override;
+
+            /**
+             * @brief       Starts route discovery and monitoring of the targets.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::start
+             *
+             * @param[in]   pingEngineFactory the factory used to create the shared ping engine.
+             * @param[in]   ipVersion the IP version to monitor.
+             *
+             * @returns     true if monitoring was started; otherwise false.
+             */
+            auto start(
+                    Nedrysoft::RouteAnalyser::IPingEngineFactory *pingEngineFactory,
+                    Nedrysoft::Core::IPVersion ipVersion = Nedrysoft::Core::IPVersion::V4
+            ) -> bool override;
+
+            /**
+             * @brief       Stops monitoring and releases the shared ping engine.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::stop
+             */
+            auto stop() -> void override;
+
+            /**
+             * @brief       Returns the targets and their discovered routes.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::targets
+             *
+             * @returns     the list of targets in the order they were given.
+             */
+            auto targets() -> QList<Nedrysoft::RouteAnalyser::FleetTarget> override;
+
+            /**
+             * @brief       Returns the distinct hops that are being monitored.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IFleetMonitor::hops
+             *
+             * @returns     the list of hops.
+             */
+            auto hops() -> QList<Nedrysoft::RouteAnalyser::FleetHop> override;
+
+        private:
+            /**
+             * @brief       Starts route discovery for queued targets until the concurrency limit is reached.
+             */
+            auto discoverNext() -> void;
+
+            /**
+             * @brief       Records a completed route and monitors any hops that are not already monitored.
+             *
+             * @param[in]   targetIndex the index of the target in the target list.
+             * @param[in]   hostAddress the address that was traced.
+             * @param[in]   route the discovered route.
+             */
+            auto addRoute(
+                    int targetIndex,
+                    const QHostAddress &hostAddress,
+                    const Nedrysoft::RouteAnalyser::RouteList &route
+            ) -> void;
+
+            /**
+             * @brief       Updates the hop that a result belongs to.
+             *
+             * @param[in]   result the ping result.
+             *
+             * @returns     true if the result belonged to a monitored hop; otherwise false.
+             */
+            auto processPingResult(const Nedrysoft::RouteAnalyser::PingResult &result) -> bool;
+
+        private:
+            //! @cond
+
+            Nedrysoft::RouteAnalyser::IPingEngineFactory *m_pingEngineFactory;
+            Nedrysoft::RouteAnalyser::IPingEngine *m_pingEngine;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+
+            QList<Nedrysoft::RouteAnalyser::FleetTarget> m_targets;
+            QHash<QHostAddress, Nedrysoft::RouteAnalyser::FleetHop> m_hops;
+            QHash<Nedrysoft::RouteAnalyser::IPingTarget *, QHostAddress> m_hopTargets;
+
+            int m_interval;
+            int m_nextTarget;
+            int m_activeDiscoveries;
+            bool m_isRunning;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEENGINE_FLEETMONITOR_H
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RouteCache.h"
+
+#include <Clock>
+#include <IConfigurationStore>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+
+constexpr auto ConfigurationPath = "Nedrysoft/Pingnoo/Components/RouteEngine";
+constexpr auto ConfigurationFilename = "RouteCache.json";
+constexpr auto DefaultRouteLifetime = 60*60;
+
+static auto cacheKey(const QString &host, Nedrysoft::Core::IPVersion ipVersion) -> QString {
+    return QString("%1/%2").arg(host.toLower()).arg(static_cast<int>(ipVersion));
+}
+
+Nedrysoft::RouteEngine::RouteCache::RouteCache() :
+        m_lifetime(DefaultRouteLifetime) {
+
+    load();
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::getInstance() -> Nedrysoft::RouteEngine::RouteCache * {
+    static Nedrysoft::RouteEngine::RouteCache instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::setLifetime(int lifetime) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    m_lifetime = lifetime;
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::find(
+        const QString &host,
+        Nedrysoft::Core::IPVersion ipVersion,
+        QHostAddress &hostAddress,
+        Nedrysoft::RouteAnalyser::RouteList &route ) -> bool {
+
+    QMutexLocker locker(&m_mutex);
+
+    auto entry = m_entries.find(cacheKey(host, ipVersion));
+
+    if (entry==m_entries.end()) {
+        return false;
+    }
+
+    if (entry->timestamp.secsTo(Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc())>m_lifetime) {
+        return false;
+    }
+
+    hostAddress = entry->hostAddress;
+    route = entry->route;
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::store(
+        const QString &host,
+        Nedrysoft::Core::IPVersion ipVersion,
+        const QHostAddress &hostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route ) -> void {
+
+    if ((hostAddress.isNull()) || (route.isEmpty())) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto entry = Entry();
+
+    entry.hostAddress = hostAddress;
+    entry.route = route;
+    entry.timestamp = Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc();
+
+    m_entries[cacheKey(host, ipVersion)] = entry;
+
+    save();
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::filePath() -> QString {
+    auto storageFolder = Nedrysoft::Core::ICore::getInstance()->storageFolder();
+
+    return QDir::cleanPath(QString("%1/%2/%3")
+            .arg(storageFolder)
+            .arg(ConfigurationPath)
+            .arg(ConfigurationFilename) );
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::load() -> void {
+    QFile cacheFile(filePath());
+
+    if (!cacheFile.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    auto jsonDocument = QJsonDocument::fromJson(cacheFile.readAll());
+
+    if (!jsonDocument.isObject()) {
+        return;
+    }
+
+    auto routes = jsonDocument.object()["routes"].toObject();
+
+    for (auto key : routes.keys()) {
+        auto routeObject = routes[key].toObject();
+        auto entry = Entry();
+
+        entry.hostAddress = QHostAddress(routeObject["address"].toString());
+        entry.timestamp = QDateTime::fromString(routeObject["timestamp"].toString(), Qt::ISODate);
+
+        for (auto hop : routeObject["hops"].toArray()) {
+            entry.route.append(QHostAddress(hop.toString()));
+        }
+
+        if ((entry.hostAddress.isNull()) || (!entry.timestamp.isValid()) || (entry.route.isEmpty())) {
+            continue;
+        }
+
+        m_entries[key] = entry;
+    }
+}
+
+auto Nedrysoft::RouteEngine::RouteCache::save() -> void {
+    auto routes = QJsonObject();
+    auto now = Nedrysoft::Core::Clock::getInstance()->currentDateTimeUtc();
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->timestamp.secsTo(now)>m_lifetime) {
+            it = m_entries.erase(it);
+
+            continue;
+        }
+
+        auto hops = QJsonArray();
+
+        for (auto &hop : it->route) {
+            hops.append(hop.isNull() ? QString() : hop.toString());
+        }
+
+        auto routeObject = QJsonObject();
+
+        routeObject["address"] = it->hostAddress.toString();
+        routeObject["timestamp"] = it->timestamp.toString(Qt::ISODate);
+        routeObject["hops"] = hops;
+
+        routes[it.key()] = routeObject;
+
+        it++;
+    }
+
+    auto rootObject = QJsonObject();
+
+    rootObject["routes"] = routes;
+
+    Nedrysoft::Core::IConfigurationStore::getInstance()->save(filePath(), rootObject);
+}
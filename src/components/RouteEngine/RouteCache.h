@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_ROUTEENGINE_ROUTECACHE_H
+#define PINGNOO_COMPONENTS_ROUTEENGINE_ROUTECACHE_H
+
+#include <ICore>
+#include <IRouteEngine>
+
+#include <QDateTime>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+
+namespace Nedrysoft { namespace RouteEngine {
+    /**
+     * @brief       The RouteCache class stores the most recently discovered route to each host.
+     *
+     * @details     Routes are keyed by host and IP version and are persisted in the storage folder so that an
+     *              editor opened for a recently traced host can start monitoring the cached hops straight away
+     *              while the route is re-validated in the background.  Entries older than the lifetime are
+     *              ignored.
+     */
+    class RouteCache {
+        private:
+            /**
+             * @brief       Constructs the RouteCache and loads the persisted routes.
+             */
+            RouteCache();
+
+        public:
+            /**
+             * @brief       Returns the process wide instance of the cache.
+             *
+             * @returns     the instance.
+             */
+            static auto getInstance() -> RouteCache *;
+
+            /**
+             * @brief       Sets how long a cached route remains valid.
+             *
+             * @param[in]   lifetime the lifetime in seconds.
+             */
+            auto setLifetime(int lifetime) -> void;
+
+            /**
+             * @brief       Finds a cached route.
+             *
+             * @param[in]   host the host name or address as requested.
+             * @param[in]   ipVersion the IP version of the route.
+             * @param[out]  hostAddress the address that the route was traced to.
+             * @param[out]  route the cached route.
+             *
+             * @returns     true if a route was found and has not expired; otherwise false.
+             */
+            auto find(
+                    const QString &host,
+                    Nedrysoft::Core::IPVersion ipVersion,
+                    QHostAddress &hostAddress,
+                    Nedrysoft::RouteAnalyser::RouteList &route
+            ) -> bool;
+
+            /**
+             * @brief       Stores a discovered route and persists the cache.
+             *
+             * @param[in]   host the host name or address as requested.
+             * @param[in]   ipVersion the IP version of the route.
+             * @param[in]   hostAddress the address that the route was traced to.
+             * @param[in]   route the discovered route.
+             */
+            auto store(
+                    const QString &host,
+                    Nedrysoft::Core::IPVersion ipVersion,
+                    const QHostAddress &hostAddress,
+                    const Nedrysoft::RouteAnalyser::RouteList &route
+            ) -> void;
+
+        private:
+            /**
+             * @brief       Returns the path of the file that the cache is persisted to.
+             *
+             * @returns     the file path.
+             */
+            auto filePath() -> QString;
+
+            /**
+             * @brief       Loads the persisted cache.
+             */
+            auto load() -> void;
+
+            /**
+             * @brief       Persists the cache, expired entries are dropped.
+             */
+            auto save() -> void;
+
+        private:
+            //! @cond
+
+            /**
+             * @brief       A cached route.
+             */
+            struct Entry {
+                QHostAddress hostAddress;
+                Nedrysoft::RouteAnalyser::RouteList route;
+                QDateTime timestamp;
+            };
+
+            QHash<QString, Entry> m_entries;
+            QMutex m_mutex;
+            int m_lifetime;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_ROUTEENGINE_ROUTECACHE_H
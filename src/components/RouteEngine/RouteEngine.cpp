@@ -26,47 +26,286 @@
 #include <IPingEngine>
 #include <IPingEngineFactory>
 #include <IPingTarget>
+#include "RouteCache.h"
 #include "RouteEngineWorker.h"
 
 #include <QThread>
 #include <QTimer>
 
+#include <algorithm>
 #include <cassert>
 
+constexpr auto MillisecondsInSecond = 1000;
+constexpr auto MaximumHops = 64;
+constexpr auto DefaultGapLimit = 5;
+
 Nedrysoft::RouteEngine::RouteEngine::RouteEngine() :
         m_routeWorkerThread(nullptr),
-        m_routeWorker(nullptr) {
+        m_routeWorker(nullptr),
+        m_multipathDiscovery(false),
+        m_traceAllAddresses(false),
+        m_gapLimit(DefaultGapLimit),
+        m_engineFactory(nullptr),
+        m_ipVersion(Nedrysoft::Core::IPVersion::V4),
+        m_routeMonitorTimer(new QTimer(this)),
+        m_routeMonitorInterval(0),
+        m_isRetracing(false) {
+
+    qRegisterMetaType<Nedrysoft::RouteAnalyser::MultipathRoute>("Nedrysoft::RouteAnalyser::MultipathRoute");
 
+    connect(m_routeMonitorTimer, &QTimer::timeout, this, &Nedrysoft::RouteEngine::RouteEngine::retrace);
 }
 
-auto Nedrysoft::RouteEngine::RouteEngine::findRoute(
-        Nedrysoft::RouteAnalyser::IPingEngineFactory *engineFactory,
-        QString host,
-        Nedrysoft::Core::IPVersion ipVersion) -> void {
+auto Nedrysoft::RouteEngine::RouteEngine::setMultipathDiscovery(bool enabled) -> bool {
+    m_multipathDiscovery = enabled;
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::setTraceAllAddresses(bool enabled) -> bool {
+    m_traceAllAddresses = enabled;
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::setGapLimit(int gapLimit) -> bool {
+    m_gapLimit = qMax(gapLimit, 0);
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::setSource(const QString &source) -> bool {
+    m_source = source;
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::setRouteMonitoring(int interval) -> bool {
+    m_routeMonitorInterval = interval;
+
+    if (m_routeMonitorInterval<=0) {
+        m_routeMonitorTimer->stop();
+    } else {
+        m_routeMonitorTimer->setInterval(m_routeMonitorInterval*MillisecondsInSecond);
+
+        if (!m_route.isEmpty()) {
+            m_routeMonitorTimer->start();
+        }
+    }
+
+    return true;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::createWorker(
+        const QString &host,
+        bool multipathDiscovery,
+        bool traceAllAddresses ) -> Nedrysoft::RouteEngine::RouteEngineWorker * {
 
-    m_routeWorker = new Nedrysoft::RouteEngine::RouteEngineWorker(host, engineFactory, ipVersion);
+    auto routeWorker = new Nedrysoft::RouteEngine::RouteEngineWorker(host, m_engineFactory, m_ipVersion);
+    auto routeWorkerThread = new QThread();
 
-    m_routeWorkerThread = new QThread();
+    routeWorker->setMultipathDiscovery(multipathDiscovery);
+    routeWorker->setTraceAllAddresses(traceAllAddresses);
+    routeWorker->setGapLimit(m_gapLimit);
+    routeWorker->setSource(m_source);
 
-    m_routeWorker->moveToThread(m_routeWorkerThread);
+    routeWorker->moveToThread(routeWorkerThread);
 
-    connect(m_routeWorkerThread,
+    connect(routeWorkerThread,
         &QThread::started,
-        m_routeWorker,
+        routeWorker,
         &Nedrysoft::RouteEngine::RouteEngineWorker::doWork
     );
 
     connect(
-        m_routeWorkerThread,
+        routeWorkerThread,
         &QThread::finished,
         [=]() {
-            m_routeWorkerThread->deleteLater();
+            routeWorkerThread->deleteLater();
     });
 
+    return routeWorker;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::findRoute(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *engineFactory,
+        QString host,
+        Nedrysoft::Core::IPVersion ipVersion) -> void {
+
+    m_engineFactory = engineFactory;
+    m_host = host;
+    m_ipVersion = ipVersion;
+
+    m_route.clear();
+    m_routeMonitorTimer->stop();
+
+    auto cachedAddress = QHostAddress();
+    auto cachedRoute = Nedrysoft::RouteAnalyser::RouteList();
+
+    // the route taken depends on the source, so only routes discovered over the default route are cached.
+
+    auto isCached = (m_source.isEmpty()) &&
+                    (Nedrysoft::RouteEngine::RouteCache::getInstance()->find(
+                        m_host,
+                        m_ipVersion,
+                        cachedAddress,
+                        cachedRoute ));
+
+    if (isCached) {
+        /**
+         * a recently discovered route is replayed straight away so that monitoring can start without waiting for
+         * discovery, the route is then re-traced in the background and any difference is reported through
+         * routeChanged.  The replay is deferred as callers connect to result before calling findRoute and may
+         * not be ready to handle it yet.
+         */
+
+        QTimer::singleShot(0, this, [=]() {
+            for (auto hop=1;hop<=cachedRoute.count();hop++) {
+                Q_EMIT result(cachedAddress, cachedRoute.mid(0, hop), false, cachedRoute.count(), MaximumHops);
+            }
+
+            Q_EMIT result(cachedAddress, cachedRoute, true, cachedRoute.count(), MaximumHops);
+
+            m_route = cachedRoute;
+            m_routeAddress = cachedAddress;
+
+            if (m_routeMonitorInterval>0) {
+                m_routeMonitorTimer->start();
+            }
+
+            retrace();
+        });
+
+        return;
+    }
+
+    m_routeWorker = createWorker(m_host, m_multipathDiscovery, m_traceAllAddresses);
+    m_routeWorkerThread = m_routeWorker->thread();
+
     connect(m_routeWorker,
             &Nedrysoft::RouteEngine::RouteEngineWorker::result,
             this,
             &Nedrysoft::RouteEngine::RouteEngine::result );
 
+    connect(m_routeWorker,
+            &Nedrysoft::RouteEngine::RouteEngineWorker::result,
+            this,
+            [=](const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const bool completed,
+                const int,
+                const int ) {
+
+        onRouteResult(hostAddress, route, completed);
+    });
+
+    connect(m_routeWorker,
+            &Nedrysoft::RouteEngine::RouteEngineWorker::multipathResult,
+            this,
+            &Nedrysoft::RouteEngine::RouteEngine::multipathResult );
+
     m_routeWorkerThread->start();
 }
+
+auto Nedrysoft::RouteEngine::RouteEngine::onRouteResult(
+        const QHostAddress &hostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route,
+        bool completed ) -> void {
+
+    if ((!completed) || (hostAddress.isNull()) || (!m_route.isEmpty())) {
+        return;
+    }
+
+    /**
+     * only the first address to complete is monitored, re-traces go to that address rather than the name so that
+     * a DNS answer in a different order is not mistaken for a route change.
+     */
+
+    m_route = route;
+    m_routeAddress = hostAddress;
+
+    if (m_source.isEmpty()) {
+        Nedrysoft::RouteEngine::RouteCache::getInstance()->store(m_host, m_ipVersion, hostAddress, route);
+    }
+
+    if (m_routeMonitorInterval>0) {
+        m_routeMonitorTimer->start();
+    }
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::retrace() -> void {
+    if ((m_isRetracing) || (!m_engineFactory)) {
+        return;
+    }
+
+    m_isRetracing = true;
+
+    auto routeWorker = createWorker(m_routeAddress.toString(), false, false);
+
+    connect(routeWorker,
+            &Nedrysoft::RouteEngine::RouteEngineWorker::result,
+            this,
+            [=](const QHostAddress hostAddress,
+                const Nedrysoft::RouteAnalyser::RouteList route,
+                const bool completed,
+                const int,
+                const int ) {
+
+        onRetraceResult(hostAddress, route, completed);
+    });
+
+    routeWorker->thread()->start();
+}
+
+auto Nedrysoft::RouteEngine::RouteEngine::onRetraceResult(
+        const QHostAddress &hostAddress,
+        const Nedrysoft::RouteAnalyser::RouteList &route,
+        bool completed ) -> void {
+
+    if (!completed) {
+        return;
+    }
+
+    m_isRetracing = false;
+
+    if ((hostAddress.isNull()) || (route.isEmpty())) {
+        return;
+    }
+
+    /**
+     * a hop that did not answer a single re-trace probe is far more likely to be rate limiting than to have
+     * changed, so silent hops keep the address from the current route and are not reported as changes.
+     */
+
+    auto newRoute = route;
+    auto changedHops = QList<int>();
+
+    for (auto hop=0;hop<newRoute.count();hop++) {
+        if ((newRoute.at(hop).isNull()) && (hop<m_route.count())) {
+            newRoute[hop] = m_route.at(hop);
+        }
+    }
+
+    for (auto hop=0;hop<std::max(newRoute.count(), m_route.count());hop++) {
+        auto previousHost = (hop<m_route.count()) ? m_route.at(hop) : QHostAddress();
+        auto newHost = (hop<newRoute.count()) ? newRoute.at(hop) : QHostAddress();
+
+        if ((hop>=m_route.count()) || (hop>=newRoute.count()) || (previousHost!=newHost)) {
+            changedHops.append(hop+1);
+        }
+    }
+
+    if (m_source.isEmpty()) {
+        Nedrysoft::RouteEngine::RouteCache::getInstance()->store(m_host, m_ipVersion, hostAddress, newRoute);
+    }
+
+    if (changedHops.isEmpty()) {
+        return;
+    }
+
+    auto previousRoute = m_route;
+
+    m_route = newRoute;
+
+    Q_EMIT routeChanged(hostAddress, previousRoute, newRoute, changedHops);
+}
@@ -33,6 +33,7 @@
 #include <QList>
 
 class QThread;
+class QTimer;
 
 namespace Nedrysoft { namespace Core {
     class IPingEngineFactory;
@@ -78,12 +79,129 @@ namespace Nedrysoft { namespace RouteEngine {
                     Nedrysoft::Core::IPVersion ipVersion = Nedrysoft::Core::IPVersion::V4
             ) -> void override;
 
+            /**
+             * @brief       Sets whether the parallel paths of the route are enumerated after discovery.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IRouteEngine::setMultipathDiscovery
+             *
+             * @param[in]   enabled true to enable multipath discovery; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setMultipathDiscovery(bool enabled) -> bool override;
+
+            /**
+             * @brief       Sets whether every address of the target is traced rather than only the first.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IRouteEngine::setTraceAllAddresses
+             *
+             * @param[in]   enabled true to trace all addresses; otherwise false.
+             *
+             * @returns     true.
+             */
+            auto setTraceAllAddresses(bool enabled) -> bool override;
+
+            /**
+             * @brief       Sets the number of consecutive silent hops after which discovery gives up.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IRouteEngine::setGapLimit
+             *
+             * @param[in]   gapLimit the number of consecutive hops that may not answer, 0 for no limit.
+             *
+             * @returns     true.
+             */
+            auto setGapLimit(int gapLimit) -> bool override;
+
+            /**
+             * @brief       Sets the source that the route is discovered from.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IRouteEngine::setSource
+             *
+             * @param[in]   source the source address or interface name, empty for the default route.
+             *
+             * @returns     true.
+             */
+            auto setSource(const QString &source) -> bool override;
+
+            /**
+             * @brief       Sets the interval at which the route is re-discovered in the background.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IRouteEngine::setRouteMonitoring
+             *
+             * @param[in]   interval the interval in seconds between re-traces, 0 disables monitoring.
+             *
+             * @returns     true.
+             */
+            auto setRouteMonitoring(int interval) -> bool override;
+
+        private:
+            /**
+             * @brief       Creates a worker on its own thread to trace the route.
+             *
+             * @param[in]   host the host name or address to trace.
+             * @param[in]   multipathDiscovery true if the worker should enumerate parallel paths.
+             * @param[in]   traceAllAddresses true if the worker should trace every address of the host.
+             *
+             * @returns     the worker, the caller connects to its signals and then starts the thread.
+             */
+            auto createWorker(
+                    const QString &host,
+                    bool multipathDiscovery,
+                    bool traceAllAddresses
+            ) -> Nedrysoft::RouteEngine::RouteEngineWorker *;
+
+            /**
+             * @brief       Records the discovered route and starts route monitoring.
+             *
+             * @param[in]   hostAddress the address of the target.
+             * @param[in]   route the route that was discovered.
+             * @param[in]   completed true if discovery has finished.
+             */
+            auto onRouteResult(
+                    const QHostAddress &hostAddress,
+                    const Nedrysoft::RouteAnalyser::RouteList &route,
+                    bool completed
+            ) -> void;
+
+            /**
+             * @brief       Compares a completed background re-trace with the current route.
+             *
+             * @param[in]   hostAddress the address of the target.
+             * @param[in]   route the route found by the re-trace.
+             * @param[in]   completed true if the re-trace has finished.
+             */
+            auto onRetraceResult(
+                    const QHostAddress &hostAddress,
+                    const Nedrysoft::RouteAnalyser::RouteList &route,
+                    bool completed
+            ) -> void;
+
+            /**
+             * @brief       Starts a background re-trace of the route if one is not already running.
+             */
+            auto retrace() -> void;
+
         private:
             //! @cond
 
             Nedrysoft::RouteEngine::RouteEngineWorker *m_routeWorker;
             QThread *m_routeWorkerThread;
 
+            bool m_multipathDiscovery;
+            bool m_traceAllAddresses;
+            int m_gapLimit;
+            QString m_source;
+
+            Nedrysoft::RouteAnalyser::IPingEngineFactory *m_engineFactory;
+            QString m_host;
+            Nedrysoft::Core::IPVersion m_ipVersion;
+
+            Nedrysoft::RouteAnalyser::RouteList m_route;
+            QHostAddress m_routeAddress;
+            QTimer *m_routeMonitorTimer;
+            int m_routeMonitorInterval;
+            bool m_isRetracing;
+
             //! @endcond
     };
 }}
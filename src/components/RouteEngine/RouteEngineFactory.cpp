@@ -25,6 +25,7 @@
 
 #include "RouteEngineFactory.h"
 
+#include "FleetMonitor.h"
 #include "ICMPSocket/ICMPSocket.h"
 #include "RouteEngine.h"
 
@@ -49,6 +50,7 @@ class Nedrysoft::RouteEngine::RouteEngineFactoryData {
         Nedrysoft::RouteEngine::RouteEngineFactory *m_factory;
 
         QList<Nedrysoft::RouteEngine::RouteEngine *> m_engineList;
+        QList<Nedrysoft::RouteEngine::FleetMonitor *> m_fleetMonitorList;
 };
 
 Nedrysoft::RouteEngine::RouteEngineFactory::RouteEngineFactory() :
@@ -60,6 +62,10 @@ Nedrysoft::RouteEngine::RouteEngineFactory::~RouteEngineFactory() {
     for (auto engineInstance : d->m_engineList) {
         delete engineInstance;
     }
+
+    for (auto fleetMonitor : d->m_fleetMonitorList) {
+        delete fleetMonitor;
+    }
 }
 
 auto Nedrysoft::RouteEngine::RouteEngineFactory::createEngine() -> Nedrysoft::RouteAnalyser::IRouteEngine * {
@@ -70,6 +76,14 @@ auto Nedrysoft::RouteEngine::RouteEngineFactory::createEngine() -> Nedrysoft::Ro
     return engineInstance;
 }
 
+auto Nedrysoft::RouteEngine::RouteEngineFactory::createFleetMonitor() -> Nedrysoft::RouteAnalyser::IFleetMonitor * {
+    auto fleetMonitor = new Nedrysoft::RouteEngine::FleetMonitor();
+
+    d->m_fleetMonitorList.append(fleetMonitor);
+
+    return fleetMonitor;
+}
+
 auto Nedrysoft::RouteEngine::RouteEngineFactory::saveConfiguration() -> QJsonObject {
     return QJsonObject();
 }
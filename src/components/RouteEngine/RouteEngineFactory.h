@@ -31,6 +31,7 @@
 namespace Nedrysoft { namespace RouteEngine {
     class RouteEngineFactoryData;
 
+    class FleetMonitor;
     class RouteEngine;
 
     /**
@@ -66,6 +67,16 @@ namespace Nedrysoft { namespace RouteEngine {
              */
             auto createEngine() -> Nedrysoft::RouteAnalyser::IRouteEngine * override;
 
+            /**
+             * @brief       Creates a fleet monitor instance.
+             *
+             * @details     Creates and returns a fleet monitor instance.  The instance is owned by the factory
+             *              and is responsible for its life cycle.
+             *
+             * @returns     the fleet monitor instance.
+             */
+            auto createFleetMonitor() -> Nedrysoft::RouteAnalyser::IFleetMonitor * override;
+
             /**
              * @brief       Returns the descriptive name of the route engine.
              *
@@ -23,14 +23,82 @@
 
 #include "RouteEngineWorker.h"
 
+#include <IGeoIPProvider>
+#include <IHostResolver>
 #include <IPingEngine>
 #include <IPingEngineFactory>
+#include <ObjectRegistry>
 #include "spdlog.h"
 
+#include <QCoreApplication>
 #include <QHostInfo>
+#include <QMetaObject>
+#include <QSet>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <future>
+#include <vector>
 
 constexpr auto DefaultDiscoveryTimeout = 1.0;
 constexpr auto MaxRouteHops = 64;
+constexpr auto DiscoveryWindow = 16;
+constexpr auto DefaultGapLimit = 5;
+constexpr auto MultipathConfidence = 0.95;
+constexpr auto MultipathMaximumProbes = 96;
+constexpr auto MultipathFirstFlow = 1;
+constexpr auto PrefetchInterval = std::chrono::milliseconds(10);
+
+/**
+ * the multipath detection algorithm stopping rule, the number of probes that must be sent to a hop (each on a
+ * different flow) before interfaces+1 evenly balanced next hops can be ruled out with the required confidence.
+ */
+static auto multipathProbes(int interfaces) -> int {
+    interfaces = std::max(interfaces, 1);
+
+    auto probes = std::log((1.0-MultipathConfidence)/(interfaces+1))/std::log(
+            static_cast<double>(interfaces)/(interfaces+1) );
+
+    return std::min(static_cast<int>(std::ceil(probes)), MultipathMaximumProbes);
+}
+
+/**
+ * @brief       Requests the name and location of a hop so that they are cached before the hop is shown.
+ *
+ * @details     The resolver and the geo ip providers belong to the application thread, so the requests are made
+ *              there.  Both merge a request for an address that is already being looked up, so the lookups made
+ *              when the hop is added to the route attach to these rather than being sent again.
+ *
+ * @param[in]   address the address of the hop.
+ */
+static auto prefetchHopDetails(const QHostAddress &address) -> void {
+    QMetaObject::invokeMethod(qApp, [address]() {
+        auto hostResolver = Nedrysoft::Core::IHostResolver::getInstance();
+        auto hostName = QString();
+
+        if ((hostResolver) && (!hostResolver->cachedHostName(address, hostName))) {
+            hostResolver->resolve(address, hostResolver, [](const QHostAddress &, const QString &) {
+                // the name is only wanted in the cache.
+            });
+        }
+
+        auto geoIP = Nedrysoft::Core::ObjectRegistry::getInstance()->object<Nedrysoft::Core::IGeoIPProvider>();
+
+        if (geoIP) {
+            geoIP->lookup(address.toString());
+        }
+    }, Qt::QueuedConnection);
+}
+
+static auto multipathConfidence(int interfaces, int probes) -> double {
+    if (!interfaces) {
+        return 0;
+    }
+
+    auto missed = (interfaces+1)*std::pow(static_cast<double>(interfaces)/(interfaces+1), probes);
+
+    return std::max(0.0, 1.0-missed);
+}
 
 Nedrysoft::RouteEngine::RouteEngineWorker::RouteEngineWorker(
         QString host,
@@ -40,8 +108,27 @@ Nedrysoft::RouteEngine::RouteEngineWorker::RouteEngineWorker(
             m_ipVersion(ipVersion),
             m_pingEngineFactory(pingEngineFactory),
             m_isRunning(false),
-            m_maximumHops(MaxRouteHops) {
+            m_multipathDiscovery(false),
+            m_traceAllAddresses(false),
+            m_maximumHops(MaxRouteHops),
+            m_gapLimit(DefaultGapLimit) {
+
+}
+
+auto Nedrysoft::RouteEngine::RouteEngineWorker::setTraceAllAddresses(bool enabled) -> void {
+    m_traceAllAddresses = enabled;
+}
 
+auto Nedrysoft::RouteEngine::RouteEngineWorker::setGapLimit(int gapLimit) -> void {
+    m_gapLimit = gapLimit;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngineWorker::setSource(const QString &source) -> void {
+    m_source = source;
+}
+
+auto Nedrysoft::RouteEngine::RouteEngineWorker::setMultipathDiscovery(bool enabled) -> void {
+    m_multipathDiscovery = enabled;
 }
 
 Nedrysoft::RouteEngine::RouteEngineWorker::~RouteEngineWorker() {
@@ -53,14 +140,30 @@ Nedrysoft::RouteEngine::RouteEngineWorker::~RouteEngineWorker() {
 }
 
 auto Nedrysoft::RouteEngine::RouteEngineWorker::doWork() -> void {
-    int totalHops = -1;
     m_isRunning = true;
 
-    auto pingEngine = m_pingEngineFactory->createEngine(m_ipVersion);
+    /**
+     * the lookup completes on this thread's event loop, so the thread is not blocked while the name resolves.
+     */
 
-    auto targetAddresses = QHostInfo::fromName(m_host).addresses();
+    QHostInfo::lookupHost(m_host, this, [=](const QHostInfo &hostInfo) {
+        onHostLookup(hostInfo);
+    });
+}
 
-    if (!targetAddresses.count()) {
+auto Nedrysoft::RouteEngine::RouteEngineWorker::onHostLookup(const QHostInfo &hostInfo) -> void {
+    auto protocol = (m_ipVersion==Nedrysoft::Core::IPVersion::V6) ?
+            QAbstractSocket::IPv6Protocol : QAbstractSocket::IPv4Protocol;
+
+    auto targetAddresses = QList<QHostAddress>();
+
+    for (auto &address : hostInfo.addresses()) {
+        if ((address.protocol()==protocol) && (!targetAddresses.contains(address))) {
+            targetAddresses.append(address);
+        }
+    }
+
+    if ((!m_isRunning) || (!targetAddresses.count())) {
         Q_EMIT result(QHostAddress(), Nedrysoft::RouteAnalyser::RouteList(), true, -1, m_maximumHops);
 
         SPDLOG_ERROR(QString("Failed to find address for %1.").arg(m_host).toStdString());
@@ -70,28 +173,163 @@ auto Nedrysoft::RouteEngine::RouteEngineWorker::doWork() -> void {
         return;
     }
 
+    if (!m_traceAllAddresses) {
+        targetAddresses = targetAddresses.mid(0, 1);
+    }
+
+    /**
+     * every address gets its own engine, the engines are created here rather than on the tracing threads as the
+     * factory is not required to be thread safe.
+     */
+
+    auto pingEngines = QList<Nedrysoft::RouteAnalyser::IPingEngine *>();
+
+    for (auto i=0;i<targetAddresses.count();i++) {
+        auto pingEngine = m_pingEngineFactory->createEngine(m_ipVersion);
+
+        /**
+         * every discovery probe is sent on the same flow so that load balancers forward them all along one path,
+         * otherwise consecutive hops may be taken from different paths and the route would contain links that do
+         * not exist.
+         */
+
+        pingEngine->setFlowStable(true);
+
+        if (!m_source.isEmpty()) {
+            pingEngine->setSource(m_source);
+        }
+
+        pingEngines.append(pingEngine);
+    }
+
+    /**
+     * the additional addresses are traced in parallel with the first, each one reports through the result signal
+     * with its own address so that listeners can compare the paths.
+     */
+
+    auto traces = std::vector<std::future<void> >();
+
+    for (auto i=1;i<targetAddresses.count();i++) {
+        traces.push_back(std::async(std::launch::async, [this, pingEngines, targetAddresses, i]() {
+            traceRoute(pingEngines.at(i), targetAddresses.at(i), false);
+        }));
+    }
+
+    traceRoute(pingEngines.at(0), targetAddresses.at(0), m_multipathDiscovery);
+
+    for (auto &trace : traces) {
+        trace.wait();
+    }
+
+    for (auto pingEngine : pingEngines) {
+        m_pingEngineFactory->deleteEngine(pingEngine);
+    }
+
+    this->deleteLater();
+}
+
+auto Nedrysoft::RouteEngine::RouteEngineWorker::traceRoute(
+        Nedrysoft::RouteAnalyser::IPingEngine *pingEngine,
+        const QHostAddress &targetAddress,
+        bool multipathDiscovery ) -> void {
+
+    int totalHops = -1;
+
     auto route = Nedrysoft::RouteAnalyser::RouteList();
+    auto pendingHops = std::deque<std::shared_future<Nedrysoft::RouteAnalyser::PingResult> >();
+    auto prefetchedHops = QSet<QHostAddress>();
+    auto nextHop = 1;
+    auto silentHops = 0;
+
+    /**
+     * probes are sent for a window of hops at once rather than one hop at a time, so a silent hop costs a single
+     * timeout for the whole window instead of one timeout each, the window slides forward as each hop is resolved.
+     */
+
+    auto queueHops = [&](int lastHop) {
+        for (;(nextHop<=lastHop) && (nextHop<MaxRouteHops);nextHop++) {
+            pendingHops.push_back(
+                pingEngine->singleShotAsync(targetAddress, nextHop, DefaultDiscoveryTimeout).share()
+            );
+        }
+    };
 
-    auto pingResult = pingEngine->singleShot(
-        targetAddresses.at(0),
+    auto destinationResult = pingEngine->singleShotAsync(
+        targetAddress,
         m_maximumHops,
         DefaultDiscoveryTimeout
     );
 
+    prefetchedHops.insert(targetAddress);
+
+    prefetchHopDetails(targetAddress);
+
+    queueHops(DiscoveryWindow);
+
+    auto pingResult = destinationResult.get();
+
     if (pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
         totalHops = pingResult.hops();
+
+        queueHops(totalHops);
     }
 
-    for (int hop=1;hop<MaxRouteHops;hop++) {
+    /**
+     * once the destination has given an estimate of its distance every hop up to it is already in flight, so the
+     * window only needs to move on if the estimate was short (the return path can differ in length from the
+     * forward path), and then it moves a hop at a time as the destination is expected to be close.
+     */
+
+    auto windowEnd = [&]() {
+        if (totalHops>0) {
+            return std::max(totalHops, route.count()+1);
+        }
+
+        return route.count()+DiscoveryWindow;
+    };
+
+    while (!pendingHops.empty()) {
         if (!m_isRunning) {
-            m_pingEngineFactory->deleteEngine(pingEngine);
+            for (auto &pendingHop : pendingHops) {
+                pendingHop.wait();
+            }
 
             return;
         }
 
-        pingResult = pingEngine->singleShot(targetAddresses.at(0), hop, DefaultDiscoveryTimeout);
+        /**
+         * replies from further along the route usually arrive while an earlier hop is still waiting to time out,
+         * their details are requested as soon as they arrive rather than when the hop is reached.
+         */
+
+        while (pendingHops.front().wait_for(PrefetchInterval)!=std::future_status::ready) {
+            for (auto &pendingHop : pendingHops) {
+                if (pendingHop.wait_for(std::chrono::seconds::zero())!=std::future_status::ready) {
+                    continue;
+                }
+
+                auto hopAddress = pendingHop.get().hostAddress();
+
+                if ((hopAddress.isNull()) || (prefetchedHops.contains(hopAddress))) {
+                    continue;
+                }
+
+                prefetchedHops.insert(hopAddress);
+
+                prefetchHopDetails(hopAddress);
+            }
+        }
+
+        pingResult = pendingHops.front().get();
+
+        pendingHops.pop_front();
+
+        // a hop that refuses the probe with an error is the furthest that the route can be discovered to.
+
+        if ((pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) ||
+            (pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable) ||
+            (pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited)) {
 
-        if (pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) {
             route.append(pingResult.hostAddress());
             break;
         } else  if (pingResult.code()==Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded) {
@@ -100,12 +338,32 @@ auto Nedrysoft::RouteEngine::RouteEngineWorker::doWork() -> void {
             route.append(QHostAddress());
         }
 
-        Q_EMIT result(targetAddresses[0], route, false, totalHops, m_maximumHops);
+        Q_EMIT result(targetAddress, route, false, totalHops, m_maximumHops);
+
+        // a run of silent hops usually means that the destination filters the probes, rather than waiting for
+        // every hop up to the maximum the route is ended with the gap.
+
+        if (route.last().isNull()) {
+            silentHops++;
+        } else {
+            silentHops = 0;
+        }
+
+        if ((m_gapLimit>0) && (silentHops>=m_gapLimit)) {
+            SPDLOG_TRACE(QString("Route to %1 ended after %2 silent hops.")
+                                 .arg(m_host)
+                                 .arg(silentHops)
+                                 .toStdString() );
+
+            break;
+        }
+
+        queueHops(windowEnd());
     };
 
     SPDLOG_TRACE(QString("Route to %1 (%2) completed, total of %3 hops.")
                          .arg(m_host)
-                         .arg(m_targetAddresses[0].toString())
+                         .arg(m_targetAddress.toString())
                          .arg(route.length())
                          .toStdString() );
 
@@ -115,10 +373,74 @@ auto Nedrysoft::RouteEngine::RouteEngineWorker::doWork() -> void {
      * set to false, without the extra emit the final hop would behave differently.
      */
 
-    Q_EMIT result(targetAddresses[0], route, false, totalHops, m_maximumHops);
-    Q_EMIT result(targetAddresses[0], route, true, totalHops, m_maximumHops);
+    Q_EMIT result(targetAddress, route, false, totalHops, m_maximumHops);
+    Q_EMIT result(targetAddress, route, true, totalHops, m_maximumHops);
 
-    m_pingEngineFactory->deleteEngine(pingEngine);
+    /**
+     * probes beyond the destination are still outstanding, they will be answered by the destination itself
+     * and are discarded, but they must complete before the engine that owns them is deleted.
+     */
 
-    this->deleteLater();
+    for (auto &pendingHop : pendingHops) {
+        pendingHop.wait();
+    }
+
+    if (multipathDiscovery) {
+        discoverMultipath(pingEngine, targetAddress, route.count());
+    }
+}
+
+auto Nedrysoft::RouteEngine::RouteEngineWorker::discoverMultipath(
+        Nedrysoft::RouteAnalyser::IPingEngine *pingEngine,
+        const QHostAddress &targetAddress,
+        int hops ) -> void {
+
+    auto multipathRoute = Nedrysoft::RouteAnalyser::MultipathRoute();
+
+    for (int hop=1;hop<=hops;hop++) {
+        auto multipathHop = Nedrysoft::RouteAnalyser::MultipathHop();
+        uint16_t flowIdentifier = MultipathFirstFlow;
+
+        while (multipathHop.probes<multipathProbes(multipathHop.addresses.count())) {
+            auto requiredProbes = multipathProbes(multipathHop.addresses.count());
+            auto futures = std::vector<std::future<Nedrysoft::RouteAnalyser::PingResult> >();
+
+            for (;multipathHop.probes<requiredProbes;multipathHop.probes++) {
+                futures.push_back(pingEngine->singleShotFlowAsync(
+                        targetAddress,
+                        hop,
+                        DefaultDiscoveryTimeout,
+                        flowIdentifier++ ));
+            }
+
+            for (auto &future : futures) {
+                auto pingResult = future.get();
+
+                if ((pingResult.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok) &&
+                    (pingResult.code()!=Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded)) {
+                    continue;
+                }
+
+                if (!multipathHop.addresses.contains(pingResult.hostAddress())) {
+                    multipathHop.addresses.append(pingResult.hostAddress());
+                }
+            }
+
+            if (!m_isRunning) {
+                return;
+            }
+
+            if (multipathHop.addresses.isEmpty()) {
+                break;
+            }
+        }
+
+        multipathHop.confidence = multipathConfidence(multipathHop.addresses.count(), multipathHop.probes);
+
+        multipathRoute.append(multipathHop);
+
+        Q_EMIT multipathResult(targetAddress, multipathRoute, false);
+    }
+
+    Q_EMIT multipathResult(targetAddress, multipathRoute, true);
 }
@@ -28,6 +28,7 @@
 #include <IRouteEngine>
 
 #include <QHostAddress>
+#include <QHostInfo>
 #include <QObject>
 #include <QThread>
 
@@ -35,6 +36,10 @@ namespace Nedrysoft { namespace Core {
     class IPingEngineFactory;
 }}
 
+namespace Nedrysoft { namespace RouteAnalyser {
+    class IPingEngine;
+}}
+
 namespace Nedrysoft { namespace RouteEngine {
     /**
      * @brief       The worker object for route discovery.
@@ -63,6 +68,34 @@ namespace Nedrysoft { namespace RouteEngine {
          */
         auto doWork() -> void;
 
+        /**
+         * @brief       Sets whether the parallel paths of the route are enumerated after discovery.
+         *
+         * @param[in]   enabled true to enable multipath discovery; otherwise false.
+         */
+        auto setMultipathDiscovery(bool enabled) -> void;
+
+        /**
+         * @brief       Sets whether every address of the host is traced rather than only the first.
+         *
+         * @param[in]   enabled true to trace all addresses in parallel; otherwise false.
+         */
+        auto setTraceAllAddresses(bool enabled) -> void;
+
+        /**
+         * @brief       Sets the number of consecutive silent hops after which discovery gives up.
+         *
+         * @param[in]   gapLimit the number of consecutive hops that may not answer, 0 for no limit.
+         */
+        auto setGapLimit(int gapLimit) -> void;
+
+        /**
+         * @brief       Sets the source that the probes are sent from.
+         *
+         * @param[in]   source the source address or interface name, empty for the default route.
+         */
+        auto setSource(const QString &source) -> void;
+
         /**
          * @brief       This signal is emitted when a route has finished discovery.
          *
@@ -81,6 +114,59 @@ namespace Nedrysoft { namespace RouteEngine {
             const int maximumHops
         );
 
+        /**
+         * @brief       This signal is emitted as each hop is enumerated by multipath discovery.
+         *
+         * @param[in]   hostAddress the target that was requested.
+         * @param[in]   route the hops enumerated so far.
+         * @param[in]   completed true if every hop has been enumerated; otherwise false.
+         */
+        Q_SIGNAL void multipathResult(
+            const QHostAddress hostAddress,
+            const Nedrysoft::RouteAnalyser::MultipathRoute route,
+            const bool completed
+        );
+
+    private:
+        /**
+         * @brief       Called when the name of the target has been resolved.
+         *
+         * @details     Picks the addresses of the requested IP version and traces the route to them.
+         *
+         * @param[in]   hostInfo the result of the lookup.
+         */
+        auto onHostLookup(const QHostInfo &hostInfo) -> void;
+
+        /**
+         * @brief       Discovers the route to an address, emitting result as each hop is found.
+         *
+         * @param[in]   pingEngine the engine to probe with.
+         * @param[in]   targetAddress the address of the target.
+         * @param[in]   multipathDiscovery true if the parallel paths should be enumerated afterwards.
+         */
+        auto traceRoute(
+            Nedrysoft::RouteAnalyser::IPingEngine *pingEngine,
+            const QHostAddress &targetAddress,
+            bool multipathDiscovery
+        ) -> void;
+
+        /**
+         * @brief       Enumerates the next hops at each hop of a discovered route.
+         *
+         * @details     Each hop is probed on a growing number of flows, after each batch the number of probes
+         *              needed to rule out one more next hop is recalculated from the number of distinct
+         *              addresses found, the hop is complete once that many probes have been sent.
+         *
+         * @param[in]   pingEngine the flow capable engine to probe with.
+         * @param[in]   targetAddress the address of the target.
+         * @param[in]   hops the number of hops in the route.
+         */
+        auto discoverMultipath(
+            Nedrysoft::RouteAnalyser::IPingEngine *pingEngine,
+            const QHostAddress &targetAddress,
+            int hops
+        ) -> void;
+
     private:
         //! @cond
 
@@ -90,6 +176,10 @@ namespace Nedrysoft { namespace RouteEngine {
 
         int m_maximumHops;
         bool m_isRunning;
+        bool m_multipathDiscovery;
+        bool m_traceAllAddresses;
+        int m_gapLimit;
+        QString m_source;
 
         //! @endcond
     };
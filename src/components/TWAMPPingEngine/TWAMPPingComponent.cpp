@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPPingComponent.h"
+
+#include "TWAMPPingEngineFactory.h"
+#include "TWAMPReflector.h"
+#include "TWAMPSocket.h"
+
+#include <QProcessEnvironment>
+#include <QThread>
+#include <spdlog/spdlog.h>
+
+constexpr auto ReflectorEnvironmentVariable = "PINGNOO_TWAMP_REFLECTOR";
+
+TWAMPPingComponent::TWAMPPingComponent() :
+        m_engineFactory(nullptr) {
+
+}
+
+TWAMPPingComponent::~TWAMPPingComponent() {
+
+}
+
+auto TWAMPPingComponent::finaliseEvent() -> void {
+    for (auto reflector : m_reflectors) {
+        reflector->stop();
+    }
+
+    for (auto thread : m_reflectorThreads) {
+        thread->quit();
+        thread->wait();
+    }
+
+    qDeleteAll(m_reflectorThreads);
+    qDeleteAll(m_reflectors);
+
+    m_reflectorThreads.clear();
+    m_reflectors.clear();
+
+    if (m_engineFactory) {
+        Nedrysoft::ComponentSystem::removeObject(m_engineFactory);
+
+        delete m_engineFactory;
+
+        m_engineFactory = nullptr;
+    }
+}
+
+auto TWAMPPingComponent::initialiseEvent() -> void {
+    m_engineFactory = new Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory();
+
+    Nedrysoft::ComponentSystem::addObject(m_engineFactory);
+
+    auto environment = QProcessEnvironment::systemEnvironment();
+
+    if (!environment.contains(ReflectorEnvironmentVariable)) {
+        return;
+    }
+
+    auto ok = false;
+    auto port = environment.value(ReflectorEnvironmentVariable).toUShort(&ok);
+
+    if ((!ok) || (!port)) {
+        SPDLOG_ERROR("The TWAMP reflector port is not valid.");
+
+        return;
+    }
+
+    // a host without IPv6 (or IPv4) still reflects on the other version.
+
+    auto started = startReflector(Nedrysoft::Core::IPVersion::V4, port);
+
+    started = startReflector(Nedrysoft::Core::IPVersion::V6, port) || started;
+
+    if (started) {
+        SPDLOG_INFO(QString("TWAMP reflector listening on port %1.").arg(port).toStdString());
+    } else {
+        SPDLOG_ERROR(QString("Unable to start the TWAMP reflector on port %1.").arg(port).toStdString());
+    }
+}
+
+auto TWAMPPingComponent::startReflector(Nedrysoft::Core::IPVersion version, quint16 port) -> bool {
+    auto socket = Nedrysoft::TWAMPPingEngine::TWAMPSocket::create(version, port);
+
+    if (!socket) {
+        return false;
+    }
+
+    auto reflector = new Nedrysoft::TWAMPPingEngine::TWAMPReflector(socket);
+    auto thread = new QThread();
+
+    reflector->moveToThread(thread);
+
+    connect(thread, &QThread::started, reflector, &Nedrysoft::TWAMPPingEngine::TWAMPReflector::doWork);
+
+    thread->start();
+
+    m_reflectors.append(reflector);
+    m_reflectorThreads.append(thread);
+
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGCOMPONENT_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGCOMPONENT_H
+
+#include <IComponent>
+#include <ICore>
+#include "TWAMPPingEngineSpec.h"
+
+#include <QList>
+
+class QThread;
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    class TWAMPPingEngineFactory;
+    class TWAMPReflector;
+}}
+
+/**
+ * @brief       The TWAMPPingComponent class provides a ping engine that measures the delay in each direction to a
+ *              TWAMP reflector, and a reflector for other hosts to measure against.
+ *
+ * @details     The reflector is started when the PINGNOO_TWAMP_REFLECTOR environment variable is set to the port
+ *              to listen on, the agent sets this with its --reflector option.
+ */
+class NEDRYSOFT_TWAMPPINGENGINE_DLLSPEC TWAMPPingComponent :
+        public QObject,
+        public Nedrysoft::ComponentSystem::IComponent {
+
+    private:
+        Q_OBJECT
+
+        Q_PLUGIN_METADATA(IID NedrysoftComponentInterfaceIID FILE "metadata.json")
+
+        Q_INTERFACES(Nedrysoft::ComponentSystem::IComponent)
+
+    public:
+        /**
+         * @brief       Constructs the TWAMPPingComponent.
+         */
+        TWAMPPingComponent();
+
+        /**
+         * @brief       Destroys the TWAMPPingComponent.
+         */
+        ~TWAMPPingComponent();
+
+    public:
+        /**
+         * @brief       The initialiseEvent is called by the component loader to initialise the component.
+         *
+         * @details     Called by the component loader after all components have been loaded, called in load order.
+         *
+         * @see         Nedrysoft::ComponentSystem::IComponent::initialiseEvent
+         */
+        auto initialiseEvent() -> void override;
+
+        /**
+         *  @brief       The finaliseEvent is called by the component loader to de-initialise the component.
+         *
+         *  @details    Called by the component loader in reverse load order to shutdown the component.
+         *
+         *  @see         Nedrysoft::ComponentSystem::IComponent::finaliseEvent
+         */
+        auto finaliseEvent() -> void override;
+
+    private:
+        /**
+         * @brief       Starts a reflector for an IP version.
+         *
+         * @param[in]   version the IP version.
+         * @param[in]   port the port to listen on.
+         *
+         * @returns     true if the reflector was started; otherwise false.
+         */
+        auto startReflector(Nedrysoft::Core::IPVersion version, quint16 port) -> bool;
+
+    private:
+        //! @cond
+
+        Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory *m_engineFactory;
+        QList<Nedrysoft::TWAMPPingEngine::TWAMPReflector *> m_reflectors;
+        QList<QThread *> m_reflectorThreads;
+
+        //! @endcond
+};
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGCOMPONENT_H
@@ -0,0 +1,385 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPPingEngine.h"
+
+#include "TWAMPPingTarget.h"
+#include "TWAMPPingWorker.h"
+#include "TWAMPProtocol.h"
+#include "TWAMPSocket.h"
+
+#include <Clock>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <memory>
+
+constexpr auto DefaultTransmitInterval = 2500;
+constexpr auto DefaultTimeout = 3000;
+constexpr auto DefaultTTL = 64;
+constexpr auto DefaultPayloadSize = 56;
+constexpr auto MaximumPayloadSize = 65507;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::TWAMPPingEngine(
+        Nedrysoft::Core::IPVersion version,
+        quint16 port,
+        bool hardwareTimestamps ) :
+            m_version(version),
+            m_port(port),
+            m_hardwareTimestamps(hardwareTimestamps),
+            m_epoch(Nedrysoft::Core::Clock::getInstance()->currentDateTime()),
+            m_workerThread(nullptr),
+            m_worker(nullptr),
+            m_interval(DefaultTransmitInterval),
+            m_timeout(DefaultTimeout),
+            m_payloadSize(DefaultPayloadSize),
+            m_dontFragment(false),
+            m_packetsSent(0),
+            m_sendErrors(0),
+            m_packetsReceived(0),
+            m_unmatchedReplies(0),
+            m_timedOut(0),
+            m_outstandingRequests(0) {
+
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::~TWAMPPingEngine() {
+    doStop();
+
+    qDeleteAll(m_pingTargets);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::setInterval(int interval) -> bool {
+    if (interval <= 0) {
+        return false;
+    }
+
+    m_interval = interval;
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::interval() -> int {
+    return m_interval;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::setTimeout(int timeout) -> bool {
+    m_timeout = timeout;
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::timeout() -> int {
+    return m_timeout;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::setPayloadSize(int payloadSize) -> bool {
+    if ((payloadSize < 0) || (payloadSize > MaximumPayloadSize)) {
+        return false;
+    }
+
+    m_payloadSize = payloadSize;
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::setDontFragment(bool dontFragment) -> bool {
+    // the flag is applied to the socket when the engine is started.
+
+    m_dontFragment = dontFragment;
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::dontFragment() -> bool {
+    return m_dontFragment;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::start() -> bool {
+    if (m_worker) {
+        return true;
+    }
+
+    auto socket = Nedrysoft::TWAMPPingEngine::TWAMPSocket::create(m_version, 0, m_hardwareTimestamps);
+
+    if (!socket) {
+        return false;
+    }
+
+    socket->setDontFragment(m_dontFragment);
+
+    m_worker = new Nedrysoft::TWAMPPingEngine::TWAMPPingWorker(this, socket);
+
+    m_workerThread = new QThread();
+
+    m_worker->moveToThread(m_workerThread);
+
+    connect(m_workerThread, &QThread::started, m_worker, &TWAMPPingWorker::doWork);
+
+    m_workerThread->start();
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::stop() -> bool {
+    doStop();
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::doStop() -> void {
+    if (m_worker) {
+        m_worker->stop();
+    }
+
+    if (m_workerThread) {
+        m_workerThread->quit();
+
+        m_workerThread->wait();
+
+        delete m_workerThread;
+
+        m_workerThread = nullptr;
+    }
+
+    if (m_worker) {
+        delete m_worker;
+
+        m_worker = nullptr;
+    }
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::addTarget(
+        QHostAddress hostAddress ) -> Nedrysoft::RouteAnalyser::IPingTarget * {
+
+    return addTarget(hostAddress, DefaultTTL);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::addTarget(
+        QHostAddress hostAddress,
+        int ttl ) -> Nedrysoft::RouteAnalyser::IPingTarget * {
+
+    auto pingTarget = new Nedrysoft::TWAMPPingEngine::TWAMPPingTarget(this, hostAddress, ttl);
+
+    QMutexLocker locker(&m_targetsMutex);
+
+    m_pingTargets.append(pingTarget);
+
+    return pingTarget;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::removeTarget(
+        Nedrysoft::RouteAnalyser::IPingTarget *target ) -> bool {
+
+    QMutexLocker locker(&m_targetsMutex);
+
+    for (auto pingTarget : m_pingTargets) {
+        if (static_cast<Nedrysoft::RouteAnalyser::IPingTarget *>(pingTarget) == target) {
+            m_pingTargets.removeOne(pingTarget);
+
+            // results for the target that have already been emitted are delivered before the target is deleted.
+
+            pingTarget->deleteLater();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::dueTargets(
+        unsigned long sampleNumber ) -> QList<Nedrysoft::TWAMPPingEngine::TWAMPPingTarget *> {
+
+    QMutexLocker locker(&m_targetsMutex);
+    QList<Nedrysoft::TWAMPPingEngine::TWAMPPingTarget *> targets;
+
+    for (auto target : m_pingTargets) {
+        if (target->isDue(sampleNumber)) {
+            targets.append(target);
+        }
+    }
+
+    return targets;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::reportResult(
+        const Nedrysoft::RouteAnalyser::PingResult &result ) -> void {
+
+    QMutexLocker locker(&m_targetsMutex);
+
+    for (auto target : m_pingTargets) {
+        if (static_cast<Nedrysoft::RouteAnalyser::IPingTarget *>(target) == result.target()) {
+            Q_EMIT this->result(result);
+
+            return;
+        }
+    }
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::epoch() -> QDateTime {
+    return m_epoch;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> {
+    QMutexLocker locker(&m_targetsMutex);
+    QList<Nedrysoft::RouteAnalyser::IPingTarget *> list;
+
+    for (auto target : m_pingTargets) {
+        list.append(target);
+    }
+
+    return list;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::singleShot(
+        QHostAddress hostAddress,
+        int ttl,
+        double timeout ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::Request request;
+    Nedrysoft::TWAMPPingEngine::TWAMPProtocol::SenderPacket senderPacket;
+
+    auto socket = std::unique_ptr<Nedrysoft::TWAMPPingEngine::TWAMPSocket>(
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket::create(m_version, 0, m_hardwareTimestamps) );
+
+    request.hostAddress = hostAddress;
+    request.ttl = ttl;
+
+    if (!socket) {
+        return Nedrysoft::RouteAnalyser::PingResult();
+    }
+
+    socket->setDontFragment(m_dontFragment);
+
+    senderPacket.sequence = 0;
+    senderPacket.errorEstimate = Nedrysoft::TWAMPPingEngine::TWAMPProtocol::errorEstimate();
+    senderPacket.timestamp = Nedrysoft::TWAMPPingEngine::TWAMPSocket::currentTime();
+
+    request.transmitTimestamp = senderPacket.timestamp;
+
+    auto buffer = Nedrysoft::TWAMPPingEngine::TWAMPProtocol::encodeSender(
+        senderPacket,
+        qMax(static_cast<int>(m_payloadSize), Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorLength) );
+
+    if (!socket->sendTo(buffer, hostAddress, m_port, ttl)) {
+        return Nedrysoft::RouteAnalyser::PingResult();
+    }
+
+    QElapsedTimer timer;
+
+    timer.start();
+
+    auto timeoutPeriod = static_cast<qint64>(timeout * MillisecondsInSecond);
+
+    while (timer.elapsed() < timeoutPeriod) {
+        if (!socket->wait(static_cast<int>(timeoutPeriod - timer.elapsed()))) {
+            continue;
+        }
+
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram datagram;
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error error;
+
+        while (socket->receive(datagram)) {
+            Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorPacket reflectorPacket;
+
+            if ((datagram.port == m_port) &&
+                (datagram.hostAddress.isEqual(hostAddress)) &&
+                (Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeReflector(datagram.buffer, reflectorPacket)) &&
+                (reflectorPacket.senderSequence == senderPacket.sequence)) {
+
+                return Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::replyResult(request, reflectorPacket, datagram);
+            }
+        }
+
+        while (socket->receiveError(error)) {
+            if (error.code != Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) {
+                return Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::errorResult(request, error);
+            }
+        }
+    }
+
+    return Nedrysoft::RouteAnalyser::PingResult(
+        0,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+        hostAddress,
+        request.transmitTimestamp,
+        -1ll,
+        nullptr,
+        -1 );
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+    Nedrysoft::RouteAnalyser::PingEngineStatistics statistics;
+
+    statistics.valid = true;
+    statistics.packetsSent = m_packetsSent;
+    statistics.sendErrors = m_sendErrors;
+    statistics.packetsReceived = m_packetsReceived;
+    statistics.unmatchedReplies = m_unmatchedReplies;
+    statistics.timedOut = m_timedOut;
+    statistics.outstandingRequests = m_outstandingRequests;
+
+    return statistics;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::port() -> quint16 {
+    return m_port;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::recordTransmitted(int sent, int failed) -> void {
+    m_packetsSent.fetch_add(static_cast<quint64>(sent), std::memory_order_relaxed);
+    m_sendErrors.fetch_add(static_cast<quint64>(failed), std::memory_order_relaxed);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::recordReceived() -> void {
+    m_packetsReceived.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::recordUnmatched() -> void {
+    m_unmatchedReplies.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::recordTimedOut() -> void {
+    m_timedOut.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::setOutstandingRequests(int count) -> void {
+    m_outstandingRequests.store(static_cast<quint64>(count), std::memory_order_relaxed);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::saveConfiguration() -> QJsonObject {
+    return QJsonObject();
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngine::loadConfiguration(QJsonObject configuration) -> bool {
+    Q_UNUSED(configuration)
+
+    return true;
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGENGINE_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGENGINE_H
+
+#include <IInterface>
+#include <IPingEngine>
+#include <IPingEngineFactory>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+
+class QThread;
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    class TWAMPPingTarget;
+    class TWAMPPingWorker;
+
+    /**
+     * @brief       The TWAMPPingEngine provides a ping engine that measures the delay in each direction.
+     *
+     * @details     The engine is a TWAMP-light sender (RFC 5357 appendix I), each target is a reflector which
+     *              returns the time it received the test packet and the time it sent the reply.  This splits the
+     *              round trip into the forward and reverse delays, so that congestion in one direction can be told
+     *              apart from congestion in the other.
+     *
+     *              The one way delays are only accurate if the clocks of both hosts are synchronised, the variation
+     *              of the delays (jitter) is accurate regardless.  Targets with a ttl lower than the distance to
+     *              the reflector are reported by the router that discarded the packet (Linux only), these results
+     *              have a round trip time but no one way delays.
+     */
+    class TWAMPPingEngine :
+            public Nedrysoft::RouteAnalyser::IPingEngine {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPingEngine)
+
+        public:
+            /**
+             * @brief       Constructs a TWAMPPingEngine for the given IP version.
+             *
+             * @param[in]   version the IP version of the engine.
+             * @param[in]   port the port that the reflectors listen on.
+             * @param[in]   hardwareTimestamps true if adapter timestamps should be used.
+             */
+            TWAMPPingEngine(Nedrysoft::Core::IPVersion version, quint16 port, bool hardwareTimestamps);
+
+            /**
+             * @brief       Destroys the TWAMPPingEngine.
+             */
+            ~TWAMPPingEngine();
+
+            /**
+             * @brief       Sets the measurement interval for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setInterval
+             *
+             * @param[in]   interval the interval between pings in milliseconds.
+             *
+             * @returns     returns true on success; otherwise false.
+             */
+            auto setInterval(int interval) -> bool override;
+
+            /**
+             * @brief       Returns the measurement interval.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::interval
+             *
+             * @returns     returns the measurement interval.
+             */
+            auto interval() -> int override;
+
+            /**
+             * @brief       Sets the reply timeout for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setTimeout
+             *
+             * @param[in]   timeout the time in milliseconds to wait for a reply.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setTimeout(int timeout) -> bool override;
+
+            /**
+             * @brief       Returns the reply timeout.
+             *
+             * @returns     the time in milliseconds to wait for a reply.
+             */
+            auto timeout() -> int;
+
+            /**
+             * @brief       Sets the default payload size for targets created by this engine instance.
+             *
+             * @details     Test packets are never shorter than a reflector packet, so that the reply is the same
+             *              size as the request.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each test packet.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setPayloadSize(int payloadSize) -> bool override;
+
+            /**
+             * @brief       Returns the default payload size for targets created by this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Sets whether test packets are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::setDontFragment
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool override;
+
+            /**
+             * @brief       Returns whether test packets are sent with the don't fragment flag set.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::dontFragment
+             *
+             * @returns     true if the don't fragment flag is set; otherwise false.
+             */
+            auto dontFragment() -> bool override;
+
+            /**
+             * @brief       Starts ping operations for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::start
+             *
+             * @returns     true on success; otherwise false if the socket could not be created.
+             */
+            auto start() -> bool override;
+
+            /**
+             * @brief       Stops ping operations for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::stop
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto stop() -> bool override;
+
+            /**
+             * @brief       Adds a ping target to this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::addTarget
+             *
+             * @param[in]   hostAddress the host address of the reflector.
+             *
+             * @returns     returns a pointer to the created ping target.
+             */
+            auto addTarget(QHostAddress hostAddress) -> Nedrysoft::RouteAnalyser::IPingTarget * override;
+
+            /**
+             * @brief       Adds a ping target to this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::addTarget
+             *
+             * @param[in]   hostAddress the host address of the reflector.
+             * @param[in]   ttl the time to live to use.
+             *
+             * @returns     returns a pointer to the created ping target.
+             */
+            auto addTarget(QHostAddress hostAddress, int ttl) -> Nedrysoft::RouteAnalyser::IPingTarget * override;
+
+            /**
+             * @brief       Removes a ping target from this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::removeTarget
+             *
+             * @param[in]   target the ping target to remove.
+             *
+             * @returns     true on success; otherwise false.
+             */
+            auto removeTarget(Nedrysoft::RouteAnalyser::IPingTarget *target) -> bool override;
+
+            /**
+             * @brief       Gets the epoch for this engine instance.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::epoch
+             *
+             * @returns     the time epoch.
+             */
+            auto epoch() -> QDateTime override;
+
+            /**
+             * @brief       Returns the list of ping targets for the engine.
+             *
+             * @returns     a QList containing the list of targets.
+             */
+            auto targets() -> QList<Nedrysoft::RouteAnalyser::IPingTarget *> override;
+
+            /**
+             * @brief       Transmits a single test packet.
+             *
+             * @note        This is a blocking function, a separate socket is used so that it may be called while the
+             *              engine is running.
+             *
+             * @param[in]   hostAddress the host address of the reflector.
+             * @param[in]   ttl time to live for this packet.
+             * @param[in]   timeout time in seconds to wait for response.
+             *
+             * @returns     the result of the ping.
+             */
+            auto singleShot(
+                QHostAddress hostAddress,
+                int ttl,
+                double timeout
+            ) -> Nedrysoft::RouteAnalyser::PingResult override;
+
+            /**
+             * @brief       Returns the counters of the engine.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingEngine::statistics
+             *
+             * @returns     the statistics.
+             */
+            auto statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics override;
+
+            /**
+             * @brief       Returns the port that the reflectors listen on.
+             *
+             * @returns     the port.
+             */
+            auto port() -> quint16;
+
+        public:
+            /**
+             * @brief       Saves the configuration to a JSON object.
+             *
+             * @see         Nedrysoft::Core::IConfiguration::saveConfiguration
+             *
+             * @returns     the JSON configuration.
+             */
+            auto saveConfiguration() -> QJsonObject override;
+
+            /**
+             * @brief       Loads the configuration.
+             *
+             * @see         Nedrysoft::Core::IConfiguration::loadConfiguration
+             *
+             * @param[in]   configuration the configuration as JSON object.
+             *
+             * @returns     true if loaded; otherwise false.
+             */
+            auto loadConfiguration(QJsonObject configuration) -> bool override;
+
+        private:
+            /**
+             * @brief       Returns the targets that are due to be sent in a sample round.
+             *
+             * @note        Called from the worker thread.
+             *
+             * @param[in]   sampleNumber the sample round.
+             *
+             * @returns     the targets.
+             */
+            auto dueTargets(unsigned long sampleNumber) -> QList<Nedrysoft::TWAMPPingEngine::TWAMPPingTarget *>;
+
+            /**
+             * @brief       Emits a result, unless the target has been removed since the request was sent.
+             *
+             * @note        Called from the worker thread.
+             *
+             * @param[in]   result the result.
+             */
+            auto reportResult(const Nedrysoft::RouteAnalyser::PingResult &result) -> void;
+
+            /**
+             * @brief       Records the outcome of sending a sample round.
+             *
+             * @param[in]   sent the number of packets sent.
+             * @param[in]   failed the number of packets that could not be sent.
+             */
+            auto recordTransmitted(int sent, int failed) -> void;
+
+            /**
+             * @brief       Records a reply or error that was matched to a request.
+             */
+            auto recordReceived() -> void;
+
+            /**
+             * @brief       Records a reply that did not match an outstanding request.
+             */
+            auto recordUnmatched() -> void;
+
+            /**
+             * @brief       Records a request that expired without a reply.
+             */
+            auto recordTimedOut() -> void;
+
+            /**
+             * @brief       Records the number of requests that are awaiting a reply.
+             *
+             * @param[in]   count the number of requests.
+             */
+            auto setOutstandingRequests(int count) -> void;
+
+            /**
+             * @brief       Stops the worker and waits for its thread to finish.
+             */
+            auto doStop() -> void;
+
+            friend class TWAMPPingWorker;
+
+        private:
+            //! @cond
+
+            Nedrysoft::Core::IPVersion m_version;
+            quint16 m_port;
+            bool m_hardwareTimestamps;
+            QDateTime m_epoch;
+
+            QMutex m_targetsMutex;
+            QList<Nedrysoft::TWAMPPingEngine::TWAMPPingTarget *> m_pingTargets;
+
+            QThread *m_workerThread;
+            Nedrysoft::TWAMPPingEngine::TWAMPPingWorker *m_worker;
+
+            std::atomic<int> m_interval;
+            std::atomic<int> m_timeout;
+            std::atomic<int> m_payloadSize;
+            bool m_dontFragment;
+
+            std::atomic<quint64> m_packetsSent;
+            std::atomic<quint64> m_sendErrors;
+            std::atomic<quint64> m_packetsReceived;
+            std::atomic<quint64> m_unmatchedReplies;
+            std::atomic<quint64> m_timedOut;
+            std::atomic<quint64> m_outstandingRequests;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGENGINE_H
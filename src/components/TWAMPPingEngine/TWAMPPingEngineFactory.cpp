@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPPingEngineFactory.h"
+
+#include "TWAMPPingEngine.h"
+#include "TWAMPProtocol.h"
+
+#include <QMutexLocker>
+#include <QProcessEnvironment>
+
+constexpr auto PortEnvironmentVariable = "PINGNOO_TWAMP_PORT";
+constexpr auto HardwareTimestampsEnvironmentVariable = "PINGNOO_TWAMP_HARDWARE_TIMESTAMPS";
+constexpr auto PortConfigurationKey = "port";
+constexpr auto HardwareTimestampsConfigurationKey = "hardwareTimestamps";
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::TWAMPPingEngineFactory() :
+        m_port(Nedrysoft::TWAMPPingEngine::TWAMPProtocol::DefaultPort),
+        m_hardwareTimestamps(false) {
+
+    auto environment = QProcessEnvironment::systemEnvironment();
+    auto ok = false;
+    auto port = environment.value(PortEnvironmentVariable).toUShort(&ok);
+
+    if (ok && port) {
+        m_port = port;
+    }
+
+    // adapter timestamps are only comparable with the others if the adapter clock is disciplined to the
+    // system clock, so they must be asked for.
+
+    m_hardwareTimestamps = environment.contains(HardwareTimestampsEnvironmentVariable);
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::~TWAMPPingEngineFactory() {
+    qDeleteAll(m_engineList);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::createEngine(
+        Nedrysoft::Core::IPVersion version ) -> Nedrysoft::RouteAnalyser::IPingEngine * {
+
+    auto engineInstance = new Nedrysoft::TWAMPPingEngine::TWAMPPingEngine(version, m_port, m_hardwareTimestamps);
+
+    QMutexLocker locker(&m_engineListMutex);
+
+    m_engineList.append(engineInstance);
+
+    return engineInstance;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::saveConfiguration() -> QJsonObject {
+    return QJsonObject {
+        {PortConfigurationKey, m_port},
+        {HardwareTimestampsConfigurationKey, m_hardwareTimestamps}
+    };
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::loadConfiguration(QJsonObject configuration) -> bool {
+    if (configuration.contains(PortConfigurationKey)) {
+        auto port = configuration[PortConfigurationKey].toInt();
+
+        if ((port > 0) && (port <= UINT16_MAX)) {
+            m_port = static_cast<quint16>(port);
+        }
+    }
+
+    if (configuration.contains(HardwareTimestampsConfigurationKey)) {
+        m_hardwareTimestamps = configuration[HardwareTimestampsConfigurationKey].toBool();
+    }
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::description() -> QString {
+    return tr("TWAMP Light");
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::priority() -> double {
+    return 0;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::available() -> bool {
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::deleteEngine(
+        Nedrysoft::RouteAnalyser::IPingEngine *engine) -> bool {
+
+    auto pingEngine = qobject_cast<Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *>(engine);
+
+    QMutexLocker locker(&m_engineListMutex);
+
+    if (!m_engineList.contains(pingEngine)) {
+        return false;
+    }
+
+    engine->stop();
+
+    m_engineList.removeAll(pingEngine);
+
+    pingEngine->deleteLater();
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingEngineFactory::statistics() -> Nedrysoft::RouteAnalyser::PingEngineStatistics {
+    QMutexLocker locker(&m_engineListMutex);
+
+    Nedrysoft::RouteAnalyser::PingEngineStatistics statistics;
+
+    for (auto engine : m_engineList) {
+        statistics += engine->statistics();
+    }
+
+    return statistics;
+}
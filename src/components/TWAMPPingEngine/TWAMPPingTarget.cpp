@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPPingTarget.h"
+
+#include "TWAMPPingEngine.h"
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::TWAMPPingTarget(
+        Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *engine,
+        QHostAddress hostAddress,
+        int ttl) :
+            m_engine(engine),
+            m_userdata(nullptr),
+            m_ttl(ttl),
+            m_payloadSize(engine->payloadSize()),
+            m_samplingDivisor(1),
+            m_hostAddress(hostAddress) {
+
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::~TWAMPPingTarget() = default;
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::setHostAddress(QHostAddress hostAddress) -> void {
+    m_hostAddress = hostAddress;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::hostAddress() -> QHostAddress {
+    return m_hostAddress;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::engine() -> Nedrysoft::RouteAnalyser::IPingEngine * {
+    return m_engine;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::saveConfiguration() -> QJsonObject {
+    return QJsonObject();
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::loadConfiguration(QJsonObject configuration) -> bool {
+    Q_UNUSED(configuration)
+
+    return false;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::ttl() -> uint16_t {
+    return m_ttl;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::setPayloadSize(int payloadSize) -> void {
+    m_payloadSize = payloadSize;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::payloadSize() -> int {
+    return m_payloadSize;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::probeBackoff() -> int {
+    return m_samplingDivisor;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::setSamplingDivisor(int divisor) -> void {
+    m_samplingDivisor = qMax(divisor, 1);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::isDue(unsigned long sampleNumber) -> bool {
+    // the ttl offsets the rounds so that the hops that are sampled less often are not all sent together.
+
+    return (( sampleNumber + m_ttl ) % static_cast<unsigned long>(m_samplingDivisor)) == 0;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::userData() -> void * {
+    return m_userdata;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingTarget::setUserData(void *data) -> void {
+    m_userdata = data;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGTARGET_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGTARGET_H
+
+#include <IPingTarget>
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    class TWAMPPingEngine;
+
+    /**
+     * @brief       Provides an implementation of IPingTarget for TWAMP reflectors.
+     *
+     * @details     The target is the address of a reflector, when the ttl is lower than the number of hops to the
+     *              reflector the packets expire on the way and the router that discarded the packet is reported.
+     */
+    class TWAMPPingTarget :
+            public Nedrysoft::RouteAnalyser::IPingTarget {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IPingTarget)
+
+        public:
+            /**
+             * @brief       Constructs a TWAMPPingTarget for the given engine with the supplied host and ttl.
+             *
+             * @param[in]   engine the ping engine to be associated with this target.
+             * @param[in]   hostAddress the target of the ping.
+             * @param[in]   ttl the TTL to be used in the ping.
+             */
+            TWAMPPingTarget(
+                Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *engine,
+                QHostAddress hostAddress,
+                int ttl
+            );
+
+            /**
+             * @brief       Destroys the TWAMPPingTarget.
+             */
+            ~TWAMPPingTarget();
+
+            /**
+             * @brief       Sets the target host address.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setHostAddress
+             *
+             * @param[in]   hostAddress the host address to be pinged.
+             */
+            auto setHostAddress(QHostAddress hostAddress) -> void override;
+
+            /**
+             * @brief       Returns the host address for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::hostAddress
+             *
+             * @returns     the host address for this target.
+             */
+            auto hostAddress() -> QHostAddress override;
+
+            /**
+             * @brief       Returns the Nedrysoft::RouteAnalyser::IPingEngine that created this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::engine
+             *
+             * @returns     the Nedrysoft::RouteAnalyser::IPingEngine instance.
+             */
+            auto engine() -> Nedrysoft::RouteAnalyser::IPingEngine * override;
+
+            /**
+             * @brief       Returns the user data attached to this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::userData
+             *
+             * @returns     the user data.
+             */
+            auto userData() -> void * override;
+
+            /**
+             * @brief       Sets the user data attached to this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setUserData
+             *
+             * @param[in]   data the user data.
+             */
+            auto setUserData(void *data) -> void override;
+
+            /**
+             * @brief       Returns the TTL of this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::ttl
+             *
+             * @returns     the ttl value.
+             */
+            auto ttl() -> uint16_t override;
+
+            /**
+             * @brief       Sets the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setPayloadSize
+             *
+             * @param[in]   payloadSize the number of bytes of payload in each echo request.
+             */
+            auto setPayloadSize(int payloadSize) -> void override;
+
+            /**
+             * @brief       Returns the payload size used for this target.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::payloadSize
+             *
+             * @returns     the payload size in bytes.
+             */
+            auto payloadSize() -> int override;
+
+            /**
+             * @brief       Returns how many sample rounds the engine has backed this target off by.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::probeBackoff
+             *
+             * @returns     1 if the target is sent in every round; otherwise the target is sent once every n rounds.
+             */
+            auto probeBackoff() -> int override;
+
+            /**
+             * @brief       Sets how many sample rounds this target is sent in.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IPingTarget::setSamplingDivisor
+             *
+             * @param[in]   divisor the target is sent once every divisor rounds.
+             */
+            auto setSamplingDivisor(int divisor) -> void override;
+
+        public:
+            /**
+             * @brief       Saves the configuration to a JSON object.
+             *
+             * @returns     the JSON configuration.
+             */
+            auto saveConfiguration() -> QJsonObject override;
+
+            /**
+             * @brief       Loads the configuration.
+             *
+             * @param[in]   configuration the configuration as JSON object.
+             *
+             * @returns     true if loaded; otherwise false.
+             */
+            auto loadConfiguration(QJsonObject configuration) -> bool override;
+
+        public:
+            /**
+             * @brief       Returns whether the target is due to be sent in a sample round.
+             *
+             * @param[in]   sampleNumber the sample round.
+             *
+             * @returns     true if the target is sent in the round; otherwise false.
+             */
+            auto isDue(unsigned long sampleNumber) -> bool;
+
+        private:
+            //! @cond
+
+            TWAMPPingEngine *m_engine;
+            void *m_userdata;
+            int m_ttl;
+            int m_payloadSize;
+            int m_samplingDivisor;
+            QHostAddress m_hostAddress;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGTARGET_H
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPPingWorker.h"
+
+#include "TWAMPPingEngine.h"
+#include "TWAMPPingTarget.h"
+
+#include <QElapsedTimer>
+
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto MaximumWait = 100;
+constexpr auto UnknownTtl = 255;
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::TWAMPPingWorker(
+        Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *engine,
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket *socket) :
+            m_engine(engine),
+            m_socket(socket),
+            m_sequence(0),
+            m_sampleNumber(0),
+            m_isRunning(false) {
+
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::~TWAMPPingWorker() {
+    delete m_socket;
+}
+
+void Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::doWork() {
+    QElapsedTimer scheduleTimer;
+
+    // the schedule is kept on the monotonic clock, the wall clock is only used for the timestamps.
+
+    scheduleTimer.start();
+
+    auto nextTransmit = scheduleTimer.nsecsElapsed();
+
+    m_isRunning = true;
+
+    while (m_isRunning) {
+        auto currentTime = scheduleTimer.nsecsElapsed();
+
+        if (currentTime >= nextTransmit) {
+            transmit();
+
+            nextTransmit += m_engine->interval() * NanosecondsInMillisecond;
+
+            // rounds that were missed are skipped rather than sent in a burst.
+
+            if (nextTransmit <= currentTime) {
+                nextTransmit = currentTime + m_engine->interval() * NanosecondsInMillisecond;
+            }
+        }
+
+        expireRequests(Nedrysoft::TWAMPPingEngine::TWAMPSocket::currentTime());
+
+        auto waitTime = static_cast<int>(qBound<qint64>(
+            0,
+            ( nextTransmit - scheduleTimer.nsecsElapsed() ) / NanosecondsInMillisecond,
+            MaximumWait ));
+
+        if (m_socket->wait(waitTime)) {
+            receive();
+        }
+    }
+
+    m_engine->setOutstandingRequests(0);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::stop() -> void {
+    m_isRunning = false;
+
+    m_socket->wakeup();
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::transmit() -> void {
+    auto targets = m_engine->dueTargets(m_sampleNumber);
+    auto errorEstimate = Nedrysoft::TWAMPPingEngine::TWAMPProtocol::errorEstimate();
+    auto sent = 0, failed = 0;
+
+    for (auto target : targets) {
+        Request request;
+        Nedrysoft::TWAMPPingEngine::TWAMPProtocol::SenderPacket packet;
+
+        request.target = target;
+        request.sampleNumber = m_sampleNumber;
+        request.hostAddress = target->hostAddress();
+        request.ttl = target->ttl();
+
+        // the packet is padded to the length of a reflector packet so that the reply is the same size.
+
+        auto length = qMax(target->payloadSize(), Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorLength);
+
+        packet.sequence = m_sequence++;
+        packet.errorEstimate = errorEstimate;
+        packet.timestamp = Nedrysoft::TWAMPPingEngine::TWAMPSocket::currentTime();
+
+        request.transmitTimestamp = packet.timestamp;
+
+        if (m_socket->sendTo(
+                Nedrysoft::TWAMPPingEngine::TWAMPProtocol::encodeSender(packet, length),
+                request.hostAddress,
+                m_engine->port(),
+                request.ttl )) {
+
+            m_requests[packet.sequence] = request;
+
+            sent++;
+        } else {
+            failed++;
+        }
+    }
+
+    m_sampleNumber++;
+
+    m_engine->recordTransmitted(sent, failed);
+    m_engine->setOutstandingRequests(m_requests.count());
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::receive() -> void {
+    Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram datagram;
+    Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error error;
+
+    while (m_socket->receive(datagram)) {
+        Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorPacket packet;
+
+        if ((datagram.port != m_engine->port()) ||
+            (!Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeReflector(datagram.buffer, packet))) {
+            continue;
+        }
+
+        auto request = m_requests.find(packet.senderSequence);
+
+        if ((request == m_requests.end()) || (!request->hostAddress.isEqual(datagram.hostAddress))) {
+            m_engine->recordUnmatched();
+
+            continue;
+        }
+
+        m_engine->recordReceived();
+        m_engine->reportResult(replyResult(*request, packet, datagram));
+
+        m_requests.erase(request);
+    }
+
+    while (m_socket->receiveError(error)) {
+        Nedrysoft::TWAMPPingEngine::TWAMPProtocol::SenderPacket packet;
+
+        // errors that were not returned by a router are left to expire.
+
+        if ((error.code == Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply) ||
+            (!Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeSender(error.buffer, packet))) {
+            continue;
+        }
+
+        auto request = m_requests.find(packet.sequence);
+
+        if (request == m_requests.end()) {
+            continue;
+        }
+
+        m_engine->recordReceived();
+        m_engine->reportResult(errorResult(*request, error));
+
+        m_requests.erase(request);
+    }
+
+    m_engine->setOutstandingRequests(m_requests.count());
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::expireRequests(qint64 currentTime) -> void {
+    auto timeout = m_engine->timeout() * NanosecondsInMillisecond;
+    auto request = m_requests.begin();
+
+    while (request != m_requests.end()) {
+        if (currentTime - request->transmitTimestamp < timeout) {
+            ++request;
+
+            continue;
+        }
+
+        m_engine->recordTimedOut();
+
+        m_engine->reportResult(Nedrysoft::RouteAnalyser::PingResult(
+            request->sampleNumber,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+            request->hostAddress,
+            request->transmitTimestamp,
+            currentTime - request->transmitTimestamp,
+            request->target,
+            -1 ));
+
+        request = m_requests.erase(request);
+    }
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::replyResult(
+        const Request &request,
+        const Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorPacket &packet,
+        const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram &datagram ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    auto forwardDelay = packet.receiveTimestamp - request.transmitTimestamp;
+    auto reverseDelay = datagram.timestamp - packet.timestamp;
+    auto reflectorDelay = packet.timestamp - packet.receiveTimestamp;
+    auto roundTripTime = datagram.timestamp - request.transmitTimestamp;
+
+    // a reflector that reports a negative or implausible processing time is not trusted with the round trip.
+
+    if ((reflectorDelay >= 0) && (reflectorDelay < roundTripTime)) {
+        roundTripTime -= reflectorDelay;
+    }
+
+    auto hops = -1;
+
+    if ((packet.senderTtl != UnknownTtl) && (packet.senderTtl <= request.ttl)) {
+        hops = request.ttl - packet.senderTtl;
+    }
+
+    auto result = Nedrysoft::RouteAnalyser::PingResult(
+        request.sampleNumber,
+        Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
+        datagram.hostAddress,
+        request.transmitTimestamp,
+        roundTripTime,
+        request.target,
+        hops );
+
+    result.setOneWayDelays(forwardDelay, reverseDelay);
+
+    return result;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPPingWorker::errorResult(
+        const Request &request,
+        const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error &error ) -> Nedrysoft::RouteAnalyser::PingResult {
+
+    return Nedrysoft::RouteAnalyser::PingResult(
+        request.sampleNumber,
+        error.code,
+        error.offender,
+        request.transmitTimestamp,
+        error.timestamp - request.transmitTimestamp,
+        request.target,
+        -1 );
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGWORKER_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGWORKER_H
+
+#include "TWAMPProtocol.h"
+#include "TWAMPSocket.h"
+
+#include <PingResult>
+#include <QHostAddress>
+#include <QMap>
+#include <QObject>
+#include <atomic>
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    class TWAMPPingEngine;
+    class TWAMPPingTarget;
+
+    /**
+     * @brief       The TWAMPPingWorker class sends the test packets for an engine and matches the replies.
+     *
+     * @details     The worker is moved to its own thread, it sends a packet to each target that is due at the start
+     *              of every interval and waits for replies and errors until the next interval is due.  Requests
+     *              that are not answered within the timeout are reported as lost.
+     */
+    class TWAMPPingWorker :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       A request that is awaiting a reply.
+             */
+            struct Request {
+                Nedrysoft::TWAMPPingEngine::TWAMPPingTarget *target = nullptr;
+                unsigned long sampleNumber = 0;
+                qint64 transmitTimestamp = -1;
+                QHostAddress hostAddress;
+                int ttl = 0;
+            };
+
+        public:
+            /**
+             * @brief       Constructs a TWAMPPingWorker for an engine.
+             *
+             * @param[in]   engine the engine that owns the worker.
+             * @param[in]   socket the socket to send and receive on, the worker takes ownership of the socket.
+             */
+            TWAMPPingWorker(Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *engine, TWAMPSocket *socket);
+
+            /**
+             * @brief       Destroys the TWAMPPingWorker.
+             */
+            ~TWAMPPingWorker();
+
+            /**
+             * @brief       The worker loop, runs until stop() is called.
+             */
+            Q_SLOT void doWork();
+
+            /**
+             * @brief       Requests that the worker loop exits.
+             *
+             * @note        May be called from any thread.
+             */
+            auto stop() -> void;
+
+            /**
+             * @brief       Creates the result for a reflected packet.
+             *
+             * @details     The round trip time excludes the time that the packet was held by the reflector, the one
+             *              way delays are only meaningful as absolute values if both clocks are synchronised but
+             *              their variation is valid regardless, as the offset between the clocks cancels out.
+             *
+             * @param[in]   request the request that was reflected.
+             * @param[in]   packet the reflected packet.
+             * @param[in]   datagram the received datagram.
+             *
+             * @returns     the result.
+             */
+            static auto replyResult(
+                const Request &request,
+                const Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorPacket &packet,
+                const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram &datagram
+            ) -> Nedrysoft::RouteAnalyser::PingResult;
+
+            /**
+             * @brief       Creates the result for an ICMP error caused by a request.
+             *
+             * @param[in]   request the request that caused the error.
+             * @param[in]   error the error.
+             *
+             * @returns     the result.
+             */
+            static auto errorResult(
+                const Request &request,
+                const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error &error
+            ) -> Nedrysoft::RouteAnalyser::PingResult;
+
+        private:
+            /**
+             * @brief       Sends a packet to each target that is due in the sample round.
+             */
+            auto transmit() -> void;
+
+            /**
+             * @brief       Reads and processes the packets and errors that are waiting on the socket.
+             */
+            auto receive() -> void;
+
+            /**
+             * @brief       Reports the requests that have not been answered within the timeout as lost.
+             *
+             * @param[in]   currentTime the current time in nanoseconds since the unix epoch.
+             */
+            auto expireRequests(qint64 currentTime) -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::TWAMPPingEngine::TWAMPPingEngine *m_engine;
+            Nedrysoft::TWAMPPingEngine::TWAMPSocket *m_socket;
+            QMap<quint32, Request> m_requests;
+            quint32 m_sequence;
+            unsigned long m_sampleNumber;
+            std::atomic<bool> m_isRunning;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPINGWORKER_H
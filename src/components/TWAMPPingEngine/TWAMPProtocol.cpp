@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPProtocol.h"
+
+#include <QDataStream>
+#include <cmath>
+
+#if defined(Q_OS_LINUX)
+#include <sys/timex.h>
+#endif
+
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMicrosecond = 1000ll;
+constexpr auto NtpUnixEpochOffset = 2208988800ll;
+constexpr auto NtpFractionBits = 32;
+constexpr auto SynchronisedFlag = 0x8000;
+constexpr auto ScaleShift = 8;
+constexpr auto MaximumScale = 0x3f;
+constexpr auto MaximumMultiplier = 0xff;
+constexpr auto UnsynchronisedError = NanosecondsInSecond;
+
+/**
+ * @brief       Encodes an error in the format of RFC 4656 section 4.1.2.
+ *
+ * @details     The error is Multiplier * 2^(Scale - 32) seconds, the smallest scale that can hold the error is used
+ *              and the multiplier is rounded up so the error is never understated.
+ *
+ * @param[in]   error the error in nanoseconds.
+ * @param[in]   synchronised true if the clock is synchronised to UTC.
+ *
+ * @returns     the error estimate.
+ */
+static auto encodeErrorEstimate(qint64 error, bool synchronised) -> quint16 {
+    auto multiplier = static_cast<quint64>(std::ceil(
+        std::ldexp(static_cast<double>(qMax(error, 0ll)) / NanosecondsInSecond, NtpFractionBits) ));
+    auto scale = 0;
+
+    while ((multiplier > MaximumMultiplier) && (scale < MaximumScale)) {
+        multiplier = ( multiplier + 1 ) / 2;
+        scale++;
+    }
+
+    // a multiplier of zero is not permitted.
+
+    multiplier = qBound<quint64>(1, multiplier, MaximumMultiplier);
+
+    return static_cast<quint16>(( synchronised ? SynchronisedFlag : 0 ) | ( scale << ScaleShift ) | multiplier);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::encodeSender(const SenderPacket &packet, int length) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << packet.sequence << toNtp(packet.timestamp) << packet.errorEstimate;
+
+    if (buffer.length() < length) {
+        buffer.append(QByteArray(length - buffer.length(), 0));
+    }
+
+    return buffer;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeSender(const QByteArray &buffer, SenderPacket &packet) -> bool {
+    if (buffer.length() < SenderLength) {
+        return false;
+    }
+
+    QDataStream stream(buffer);
+    quint64 timestamp;
+
+    stream >> packet.sequence >> timestamp >> packet.errorEstimate;
+
+    packet.timestamp = fromNtp(timestamp);
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::encodeReflector(
+        const ReflectorPacket &packet,
+        int length ) -> QByteArray {
+
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << packet.sequence
+           << toNtp(packet.timestamp)
+           << packet.errorEstimate
+           << static_cast<quint16>(0)
+           << toNtp(packet.receiveTimestamp)
+           << packet.senderSequence
+           << toNtp(packet.senderTimestamp)
+           << packet.senderErrorEstimate
+           << static_cast<quint16>(0)
+           << packet.senderTtl;
+
+    if (buffer.length() < length) {
+        buffer.append(QByteArray(length - buffer.length(), 0));
+    }
+
+    return buffer;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeReflector(
+        const QByteArray &buffer,
+        ReflectorPacket &packet ) -> bool {
+
+    if (buffer.length() < ReflectorLength) {
+        return false;
+    }
+
+    QDataStream stream(buffer);
+    quint64 timestamp, receiveTimestamp, senderTimestamp;
+    quint16 mbz;
+
+    stream >> packet.sequence
+           >> timestamp
+           >> packet.errorEstimate
+           >> mbz
+           >> receiveTimestamp
+           >> packet.senderSequence
+           >> senderTimestamp
+           >> packet.senderErrorEstimate
+           >> mbz
+           >> packet.senderTtl;
+
+    packet.timestamp = fromNtp(timestamp);
+    packet.receiveTimestamp = fromNtp(receiveTimestamp);
+    packet.senderTimestamp = fromNtp(senderTimestamp);
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::toNtp(qint64 timestamp) -> quint64 {
+    auto seconds = static_cast<quint64>(timestamp / NanosecondsInSecond + NtpUnixEpochOffset);
+    auto nanoseconds = static_cast<quint64>(timestamp % NanosecondsInSecond);
+
+    return ( seconds << NtpFractionBits ) | (( nanoseconds << NtpFractionBits ) / NanosecondsInSecond );
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::fromNtp(quint64 timestamp) -> qint64 {
+    auto seconds = static_cast<qint64>(timestamp >> NtpFractionBits) - NtpUnixEpochOffset;
+    auto fraction = timestamp & 0xffffffffull;
+
+    // the fraction is rounded to the nearest nanosecond so that a timestamp survives a round trip unchanged.
+
+    auto nanoseconds = static_cast<qint64>(
+        ( fraction * NanosecondsInSecond + ( 1ull << ( NtpFractionBits - 1 ))) >> NtpFractionBits );
+
+    return seconds * NanosecondsInSecond + nanoseconds;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::errorEstimate() -> quint16 {
+#if defined(Q_OS_LINUX)
+    struct timex clockState = {};
+
+    auto state = ntp_adjtime(&clockState);
+
+    if ((state != TIME_ERROR) && (!(clockState.status & STA_UNSYNC))) {
+        return encodeErrorEstimate(clockState.esterror * NanosecondsInMicrosecond, true);
+    }
+#endif
+    return encodeErrorEstimate(UnsynchronisedError, false);
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPProtocol::isSynchronised(quint16 errorEstimate) -> bool {
+    return errorEstimate & SynchronisedFlag;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPROTOCOL_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPROTOCOL_H
+
+#include "TWAMPPingEngineSpec.h"
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    /**
+     * @brief       The TWAMPProtocol class provides the unauthenticated TWAMP test packets (RFC 5357 section 4).
+     *
+     * @details     TWAMP-light has no control session, the sender and reflector agree the port out of band and the
+     *              sender's test packets are reflected as they arrive.  A sender packet carries a sequence number,
+     *              the transmit timestamp and an error estimate, the reflector returns these along with the time it
+     *              received the packet, the time it sent the reply and the TTL the packet arrived with.
+     *
+     *              Timestamps are in the 64 bit NTP format on the wire and in nanoseconds since the unix epoch
+     *              here.  The reflector pads its reply to the length of the request so that the test traffic is
+     *              the same size in each direction.
+     */
+    class NEDRYSOFT_TWAMPPINGENGINE_DLLSPEC TWAMPProtocol {
+        public:
+            /**
+             * @brief       The port that TWAMP reflectors listen on by default.
+             */
+            static constexpr quint16 DefaultPort = 862;
+
+            /**
+             * @brief       The length of the fields of a sender test packet.
+             */
+            static constexpr int SenderLength = 14;
+
+            /**
+             * @brief       The length of the fields of a reflector test packet.
+             */
+            static constexpr int ReflectorLength = 41;
+
+            /**
+             * @brief       The contents of a sender test packet.
+             */
+            struct SenderPacket {
+                quint32 sequence;
+                qint64 timestamp;
+                quint16 errorEstimate;
+            };
+
+            /**
+             * @brief       The contents of a reflector test packet.
+             */
+            struct ReflectorPacket {
+                quint32 sequence;
+                qint64 timestamp;
+                quint16 errorEstimate;
+                qint64 receiveTimestamp;
+                quint32 senderSequence;
+                qint64 senderTimestamp;
+                quint16 senderErrorEstimate;
+                quint8 senderTtl;
+            };
+
+        public:
+            /**
+             * @brief       Creates a sender test packet.
+             *
+             * @param[in]   packet the contents of the packet.
+             * @param[in]   length the length of the packet, the packet is zero padded to this length.
+             *
+             * @returns     the raw packet.
+             */
+            static auto encodeSender(const SenderPacket &packet, int length) -> QByteArray;
+
+            /**
+             * @brief       Decodes a sender test packet.
+             *
+             * @param[in]   buffer the raw packet.
+             * @param[out]  packet the decoded packet.
+             *
+             * @returns     true if the packet was decoded; otherwise false if the packet was too short.
+             */
+            static auto decodeSender(const QByteArray &buffer, SenderPacket &packet) -> bool;
+
+            /**
+             * @brief       Creates a reflector test packet.
+             *
+             * @param[in]   packet the contents of the packet.
+             * @param[in]   length the length of the packet, the packet is zero padded to this length.
+             *
+             * @returns     the raw packet.
+             */
+            static auto encodeReflector(const ReflectorPacket &packet, int length) -> QByteArray;
+
+            /**
+             * @brief       Decodes a reflector test packet.
+             *
+             * @param[in]   buffer the raw packet.
+             * @param[out]  packet the decoded packet.
+             *
+             * @returns     true if the packet was decoded; otherwise false if the packet was too short.
+             */
+            static auto decodeReflector(const QByteArray &buffer, ReflectorPacket &packet) -> bool;
+
+            /**
+             * @brief       Converts a timestamp to the NTP format.
+             *
+             * @param[in]   timestamp the time in nanoseconds since the unix epoch.
+             *
+             * @returns     the time as 32 bits of seconds since 1900 and 32 bits of fraction.
+             */
+            static auto toNtp(qint64 timestamp) -> quint64;
+
+            /**
+             * @brief       Converts a timestamp from the NTP format.
+             *
+             * @param[in]   timestamp the time as 32 bits of seconds since 1900 and 32 bits of fraction.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            static auto fromNtp(quint64 timestamp) -> qint64;
+
+            /**
+             * @brief       Returns the error estimate of the local clock.
+             *
+             * @details     On Linux the synchronisation state and estimated error are read from the kernel, on
+             *              other platforms the clock is reported as unsynchronised with an error of one second.
+             *
+             * @returns     the error estimate in the format of RFC 4656 section 4.1.2.
+             */
+            static auto errorEstimate() -> quint16;
+
+            /**
+             * @brief       Returns whether an error estimate reports a synchronised clock.
+             *
+             * @param[in]   errorEstimate the error estimate.
+             *
+             * @returns     true if the clock was synchronised to UTC; otherwise false.
+             */
+            static auto isSynchronised(quint16 errorEstimate) -> bool;
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPPROTOCOL_H
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPReflector.h"
+
+#include "TWAMPProtocol.h"
+
+constexpr auto PollInterval = 100;
+constexpr auto UnknownTtl = 255;
+constexpr auto ReflectorTtl = 255;
+
+Nedrysoft::TWAMPPingEngine::TWAMPReflector::TWAMPReflector(Nedrysoft::TWAMPPingEngine::TWAMPSocket *socket) :
+        m_socket(socket),
+        m_sequence(0),
+        m_isRunning(false) {
+
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPReflector::~TWAMPReflector() {
+    delete m_socket;
+}
+
+void Nedrysoft::TWAMPPingEngine::TWAMPReflector::doWork() {
+    Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram datagram;
+    Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error error;
+
+    m_isRunning = true;
+
+    while (m_isRunning) {
+        if (!m_socket->wait(PollInterval)) {
+            continue;
+        }
+
+        while (m_socket->receive(datagram)) {
+            reflect(datagram);
+        }
+
+        // errors caused by our replies are of no interest, but must be read to clear the queue.
+
+        while (m_socket->receiveError(error)) {
+
+        }
+    }
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPReflector::stop() -> void {
+    m_isRunning = false;
+
+    m_socket->wakeup();
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPReflector::reflect(
+        const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram &datagram ) -> void {
+
+    Nedrysoft::TWAMPPingEngine::TWAMPProtocol::SenderPacket senderPacket;
+    Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorPacket reflectorPacket;
+
+    /**
+     * a sender pads its request to at least the length of the reply (RFC 5357 section 4.1.2), a shorter request is
+     * dropped so that the reflector never sends more than it receives to a possibly spoofed address.
+     */
+
+    if (datagram.buffer.length()<Nedrysoft::TWAMPPingEngine::TWAMPProtocol::ReflectorLength) {
+        return;
+    }
+
+    if (!Nedrysoft::TWAMPPingEngine::TWAMPProtocol::decodeSender(datagram.buffer, senderPacket)) {
+        return;
+    }
+
+    reflectorPacket.sequence = m_sequence++;
+    reflectorPacket.errorEstimate = Nedrysoft::TWAMPPingEngine::TWAMPProtocol::errorEstimate();
+    reflectorPacket.receiveTimestamp = datagram.timestamp;
+    reflectorPacket.senderSequence = senderPacket.sequence;
+    reflectorPacket.senderTimestamp = senderPacket.timestamp;
+    reflectorPacket.senderErrorEstimate = senderPacket.errorEstimate;
+    reflectorPacket.senderTtl = static_cast<quint8>(( datagram.ttl < 0 ) ? UnknownTtl : datagram.ttl);
+
+    // the transmit timestamp is taken as late as possible so that it excludes the time spent building the reply.
+
+    reflectorPacket.timestamp = Nedrysoft::TWAMPPingEngine::TWAMPSocket::currentTime();
+
+    m_socket->sendTo(
+        Nedrysoft::TWAMPPingEngine::TWAMPProtocol::encodeReflector(reflectorPacket, datagram.buffer.length()),
+        datagram.hostAddress,
+        datagram.port,
+        ReflectorTtl );
+}
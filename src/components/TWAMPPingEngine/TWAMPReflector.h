@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPREFLECTOR_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPREFLECTOR_H
+
+#include "TWAMPSocket.h"
+
+#include <QObject>
+#include <atomic>
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+    /**
+     * @brief       The TWAMPReflector class provides a TWAMP-light reflector.
+     *
+     * @details     The reflector returns each test packet that it receives to the sender with the time that the
+     *              packet arrived, the time the reply was sent and the TTL that the packet arrived with.  It has no
+     *              state, so a single reflector serves any number of senders.  Test packets shorter than a reply
+     *              are dropped, so the reply is never larger than the request.
+     *
+     *              The reflector is moved to its own thread and runs until stop() is called.
+     */
+    class TWAMPReflector :
+            public QObject {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       Constructs a TWAMPReflector.
+             *
+             * @param[in]   socket the bound socket to reflect packets on, the reflector takes ownership.
+             */
+            TWAMPReflector(Nedrysoft::TWAMPPingEngine::TWAMPSocket *socket);
+
+            /**
+             * @brief       Destroys the TWAMPReflector.
+             */
+            ~TWAMPReflector();
+
+            /**
+             * @brief       The reflector loop, runs until stop() is called.
+             */
+            Q_SLOT void doWork();
+
+            /**
+             * @brief       Requests that the reflector loop exits.
+             *
+             * @note        May be called from any thread.
+             */
+            auto stop() -> void;
+
+        private:
+            /**
+             * @brief       Reflects a test packet.
+             *
+             * @param[in]   datagram the received test packet.
+             */
+            auto reflect(const Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram &datagram) -> void;
+
+        private:
+            //! @cond
+
+            Nedrysoft::TWAMPPingEngine::TWAMPSocket *m_socket;
+            quint32 m_sequence;
+            std::atomic<bool> m_isRunning;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPREFLECTOR_H
@@ -0,0 +1,673 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TWAMPSocket.h"
+
+#if defined(Q_OS_UNIX)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(Q_OS_LINUX)
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#endif
+
+#elif defined(Q_OS_WIN)
+#include <WS2tcpip.h>
+#include <WinSock2.h>
+#endif
+
+#include <cstring>
+
+constexpr auto MaximumPacketLength = 65536;
+constexpr auto ControlBufferLength = 512;
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMicrosecond = 1000ll;
+constexpr auto DefaultTtl = 64;
+
+#if defined(Q_OS_WIN)
+constexpr auto FileTimeUnixEpochOffset = 116444736000000000ll;
+constexpr auto NanosecondsInFileTimeTick = 100ll;
+#endif
+
+#if defined(Q_OS_LINUX)
+constexpr auto ICMPv4TimeExceeded = 11;
+constexpr auto ICMPv4Unreachable = 3;
+constexpr auto ICMPv4NetProhibited = 9;
+constexpr auto ICMPv4HostProhibited = 10;
+constexpr auto ICMPv4AdminProhibited = 13;
+constexpr auto ICMPv6Unreachable = 1;
+constexpr auto ICMPv6PacketTooBig = 2;
+constexpr auto ICMPv6TimeExceeded = 3;
+constexpr auto ICMPv6AdminProhibited = 1;
+constexpr auto ICMPv6PolicyFailed = 5;
+constexpr auto ICMPv6RejectRoute = 6;
+#endif
+
+#if defined(Q_OS_UNIX)
+/**
+ * @brief       Converts a timespec to nanoseconds.
+ *
+ * @param[in]   time the timespec.
+ *
+ * @returns     the time in nanoseconds; otherwise -1 if the time was not set.
+ */
+static auto toNanoseconds(const struct timespec &time) -> qint64 {
+    if ((time.tv_sec == 0) && (time.tv_nsec == 0)) {
+        return -1;
+    }
+
+    return static_cast<qint64>(time.tv_sec) * NanosecondsInSecond + time.tv_nsec;
+}
+#endif
+
+/**
+ * @brief       Converts a QHostAddress to a socket address.
+ *
+ * @param[in]   hostAddress the address.
+ * @param[in]   port the port.
+ * @param[out]  socketAddress the socket address.
+ *
+ * @returns     the length of the socket address.
+ */
+static auto toSocketAddress(
+        const QHostAddress &hostAddress,
+        quint16 port,
+        struct sockaddr_storage &socketAddress) -> socklen_t {
+
+    memset(&socketAddress, 0, sizeof(socketAddress));
+
+    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        auto address = reinterpret_cast<struct sockaddr_in *>(&socketAddress);
+
+        address->sin_family = AF_INET;
+        address->sin_port = htons(port);
+        address->sin_addr.s_addr = htonl(hostAddress.toIPv4Address());
+
+        return sizeof(struct sockaddr_in);
+    }
+
+    auto address = reinterpret_cast<struct sockaddr_in6 *>(&socketAddress);
+    auto ipv6Address = hostAddress.toIPv6Address();
+
+    address->sin6_family = AF_INET6;
+    address->sin6_port = htons(port);
+
+    memcpy(&address->sin6_addr, &ipv6Address, sizeof(address->sin6_addr));
+
+    return sizeof(struct sockaddr_in6);
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPSocket::TWAMPSocket(socket_t socket, Nedrysoft::Core::IPVersion version) :
+        m_socket(socket),
+        m_version(version),
+        m_hardwareTimestamps(false),
+        m_ttl(-1) {
+
+    /**
+     * a wait is interrupted by making a second descriptor readable, on Windows select only accepts sockets so a
+     * datagram is sent to a loopback socket, elsewhere a byte is written to a pipe.
+     */
+
+#if defined(Q_OS_WIN)
+    int addressLength = sizeof(m_wakeupAddress);
+
+    m_wakeupAddress = {};
+    m_wakeupAddress.sin_family = AF_INET;
+    m_wakeupAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    m_wakeupSocket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (m_wakeupSocket != INVALID_SOCKET) {
+        u_long nonBlocking = 1;
+
+        ioctlsocket(m_wakeupSocket, FIONBIO, &nonBlocking);
+
+        if ((bind(m_wakeupSocket, reinterpret_cast<struct sockaddr *>(&m_wakeupAddress), addressLength) != 0) ||
+            (getsockname(m_wakeupSocket, reinterpret_cast<struct sockaddr *>(&m_wakeupAddress), &addressLength))) {
+            closesocket(m_wakeupSocket);
+
+            m_wakeupSocket = INVALID_SOCKET;
+        }
+    }
+#else
+    if (pipe(m_wakeupDescriptors) == 0) {
+        for (auto descriptor : m_wakeupDescriptors) {
+            fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+        }
+    } else {
+        m_wakeupDescriptors[0] = -1;
+        m_wakeupDescriptors[1] = -1;
+    }
+#endif
+}
+
+Nedrysoft::TWAMPPingEngine::TWAMPSocket::~TWAMPSocket() {
+#if defined(Q_OS_WIN)
+    closesocket(m_socket);
+
+    if (m_wakeupSocket != INVALID_SOCKET) {
+        closesocket(m_wakeupSocket);
+    }
+#else
+    close(m_socket);
+
+    for (auto descriptor : m_wakeupDescriptors) {
+        if (descriptor != -1) {
+            close(descriptor);
+        }
+    }
+#endif
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::create(
+        Nedrysoft::Core::IPVersion version,
+        quint16 port,
+        bool hardwareTimestamps) -> Nedrysoft::TWAMPPingEngine::TWAMPSocket * {
+
+    auto family = ( version == Nedrysoft::Core::IPVersion::V4 ) ? AF_INET : AF_INET6;
+
+#if defined(Q_OS_WIN)
+    static auto initialised = false;
+
+    if (!initialised) {
+        WSADATA wsaData;
+
+        if (WSAStartup(MAKEWORD(2,2), &wsaData)!=0) {
+            return nullptr;
+        }
+
+        initialised = true;
+    }
+
+    auto socketDescriptor = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (socketDescriptor == INVALID_SOCKET) {
+        return nullptr;
+    }
+
+    u_long nonBlocking = 1;
+
+    ioctlsocket(socketDescriptor, FIONBIO, &nonBlocking);
+#else
+    auto socketDescriptor = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (socketDescriptor < 0) {
+        return nullptr;
+    }
+
+    fcntl(socketDescriptor, F_SETFL, fcntl(socketDescriptor, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    auto twampSocket = new TWAMPSocket(socketDescriptor, version);
+
+    int enabled = 1;
+
+    // the IPv4 and IPv6 sockets are separate, so a reflector can listen on the same port with both.
+
+    if (version == Nedrysoft::Core::IPVersion::V6) {
+        setsockopt(
+            socketDescriptor,
+            IPPROTO_IPV6,
+            IPV6_V6ONLY,
+            reinterpret_cast<const char *>(&enabled),
+            sizeof(enabled) );
+    }
+
+    struct sockaddr_storage bindAddress = {};
+
+    auto bindLength = toSocketAddress(
+        ( version == Nedrysoft::Core::IPVersion::V4 ) ? QHostAddress(QHostAddress::AnyIPv4) :
+                                                       QHostAddress(QHostAddress::AnyIPv6),
+        port,
+        bindAddress );
+
+    if (bind(socketDescriptor, reinterpret_cast<struct sockaddr *>(&bindAddress), bindLength) != 0) {
+        delete twampSocket;
+
+        return nullptr;
+    }
+
+    // the arrival ttl is needed by a reflector to fill in the sender ttl and by a sender to find the hop count.
+
+#if defined(Q_OS_UNIX)
+    if (version == Nedrysoft::Core::IPVersion::V4) {
+        setsockopt(socketDescriptor, IPPROTO_IP, IP_RECVTTL, &enabled, sizeof(enabled));
+    } else {
+        setsockopt(socketDescriptor, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &enabled, sizeof(enabled));
+    }
+#endif
+
+#if defined(Q_OS_LINUX)
+    if (version == Nedrysoft::Core::IPVersion::V4) {
+        setsockopt(socketDescriptor, IPPROTO_IP, IP_RECVERR, &enabled, sizeof(enabled));
+    } else {
+        setsockopt(socketDescriptor, IPPROTO_IPV6, IPV6_RECVERR, &enabled, sizeof(enabled));
+    }
+
+    int timestampFlags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+
+    if (hardwareTimestamps) {
+        timestampFlags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+
+    if (setsockopt(socketDescriptor, SOL_SOCKET, SO_TIMESTAMPING, &timestampFlags, sizeof(timestampFlags)) == 0) {
+        twampSocket->m_hardwareTimestamps = hardwareTimestamps;
+    } else {
+        setsockopt(socketDescriptor, SOL_SOCKET, SO_TIMESTAMPNS, &enabled, sizeof(enabled));
+    }
+#elif defined(Q_OS_UNIX)
+    Q_UNUSED(hardwareTimestamps)
+
+    setsockopt(socketDescriptor, SOL_SOCKET, SO_TIMESTAMP, &enabled, sizeof(enabled));
+#else
+    Q_UNUSED(hardwareTimestamps)
+#endif
+
+    return twampSocket;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::currentTime() -> qint64 {
+#if defined(Q_OS_WIN)
+    FILETIME fileTime;
+
+    GetSystemTimePreciseAsFileTime(&fileTime);
+
+    auto ticks = ( static_cast<qint64>(fileTime.dwHighDateTime) << 32 ) | fileTime.dwLowDateTime;
+
+    return ( ticks - FileTimeUnixEpochOffset ) * NanosecondsInFileTimeTick;
+#else
+    struct timespec time = {};
+
+    clock_gettime(CLOCK_REALTIME, &time);
+
+    return static_cast<qint64>(time.tv_sec) * NanosecondsInSecond + time.tv_nsec;
+#endif
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::sendTo(
+        const QByteArray &buffer,
+        const QHostAddress &hostAddress,
+        quint16 port,
+        int ttl) -> bool {
+
+    if (ttl != m_ttl) {
+        int value = ttl;
+
+        if (m_version == Nedrysoft::Core::IPVersion::V4) {
+            setsockopt(m_socket, IPPROTO_IP, IP_TTL, reinterpret_cast<const char *>(&value), sizeof(value));
+        } else {
+            setsockopt(
+                m_socket,
+                IPPROTO_IPV6,
+                IPV6_UNICAST_HOPS,
+                reinterpret_cast<const char *>(&value),
+                sizeof(value) );
+        }
+
+        m_ttl = ttl;
+    }
+
+    struct sockaddr_storage socketAddress = {};
+
+    auto addressLength = toSocketAddress(hostAddress, port, socketAddress);
+
+    auto result = sendto(
+        m_socket,
+        buffer.constData(),
+        static_cast<int>(buffer.length()),
+        0,
+        reinterpret_cast<struct sockaddr *>(&socketAddress),
+        addressLength );
+
+    return result == buffer.length();
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::setDontFragment(bool dontFragment) -> bool {
+#if defined(Q_OS_LINUX)
+    int value;
+
+    if (m_version == Nedrysoft::Core::IPVersion::V4) {
+        value = dontFragment ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+
+        return setsockopt(m_socket, IPPROTO_IP, IP_MTU_DISCOVER, &value, sizeof(value)) == 0;
+    }
+
+    value = dontFragment ? IPV6_PMTUDISC_DO : IPV6_PMTUDISC_DONT;
+
+    return setsockopt(m_socket, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &value, sizeof(value)) == 0;
+#elif defined(Q_OS_WIN)
+    DWORD value = dontFragment ? 1 : 0;
+
+    if (m_version == Nedrysoft::Core::IPVersion::V4) {
+        return setsockopt(
+            m_socket,
+            IPPROTO_IP,
+            IP_DONTFRAGMENT,
+            reinterpret_cast<const char *>(&value),
+            sizeof(value) ) == 0;
+    }
+
+    return setsockopt(
+        m_socket,
+        IPPROTO_IPV6,
+        IPV6_DONTFRAG,
+        reinterpret_cast<const char *>(&value),
+        sizeof(value) ) == 0;
+#else
+    return !dontFragment;
+#endif
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::wait(int timeout) -> bool {
+#if defined(Q_OS_WIN)
+    fd_set readSet;
+    struct timeval waitTime = {};
+    char buffer;
+
+    FD_ZERO(&readSet);
+    FD_SET(m_socket, &readSet);
+
+    if (m_wakeupSocket != INVALID_SOCKET) {
+        FD_SET(m_wakeupSocket, &readSet);
+    }
+
+    waitTime.tv_sec = timeout / 1000;
+    waitTime.tv_usec = ( timeout % 1000 ) * 1000;
+
+    if (select(0, &readSet, nullptr, nullptr, &waitTime) <= 0) {
+        return false;
+    }
+
+    if ((m_wakeupSocket != INVALID_SOCKET) && (FD_ISSET(m_wakeupSocket, &readSet))) {
+        while (recv(m_wakeupSocket, &buffer, sizeof(buffer), 0) >= 0) {
+        }
+    }
+
+    return FD_ISSET(m_socket, &readSet) != 0;
+#else
+    struct pollfd descriptors[2] = {};
+    char buffer[16];
+
+    descriptors[0].fd = m_socket;
+    descriptors[0].events = POLLIN;
+    descriptors[1].fd = m_wakeupDescriptors[0];
+    descriptors[1].events = POLLIN;
+
+    // queued errors are reported as POLLERR, which is always returned.
+
+    if (poll(descriptors, (m_wakeupDescriptors[0] != -1) ? 2 : 1, timeout) <= 0) {
+        return false;
+    }
+
+    if (descriptors[1].revents & POLLIN) {
+        while (read(m_wakeupDescriptors[0], buffer, sizeof(buffer)) > 0) {
+        }
+    }
+
+    return descriptors[0].revents != 0;
+#endif
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::wakeup() -> void {
+#if defined(Q_OS_WIN)
+    char buffer = 0;
+
+    if (m_wakeupSocket != INVALID_SOCKET) {
+        sendto(
+            m_wakeupSocket,
+            &buffer,
+            sizeof(buffer),
+            0,
+            reinterpret_cast<const struct sockaddr *>(&m_wakeupAddress),
+            sizeof(m_wakeupAddress) );
+    }
+#else
+    char buffer = 0;
+
+    if (m_wakeupDescriptors[1] != -1) {
+        auto result = write(m_wakeupDescriptors[1], &buffer, sizeof(buffer));
+
+        Q_UNUSED(result)
+    }
+#endif
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::receive(
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket::Datagram &datagram) -> bool {
+
+    struct sockaddr_storage fromAddress = {};
+
+    datagram.buffer.resize(MaximumPacketLength);
+    datagram.timestamp = -1;
+    datagram.ttl = -1;
+
+#if defined(Q_OS_WIN)
+    int addressLength = sizeof(fromAddress);
+
+    auto result = recvfrom(
+        m_socket,
+        datagram.buffer.data(),
+        static_cast<int>(datagram.buffer.length()),
+        0,
+        reinterpret_cast<struct sockaddr *>(&fromAddress),
+        &addressLength );
+
+    if (result < 0) {
+        return false;
+    }
+
+    // winsock has no receive timestamps for udp, the packet is timestamped as it is read.
+
+    datagram.timestamp = currentTime();
+#else
+    struct iovec ioVector = {};
+    struct msghdr header = {};
+    char controlBuffer[ControlBufferLength];
+
+    ioVector.iov_base = datagram.buffer.data();
+    ioVector.iov_len = static_cast<size_t>(datagram.buffer.length());
+
+    header.msg_name = &fromAddress;
+    header.msg_namelen = sizeof(fromAddress);
+    header.msg_iov = &ioVector;
+    header.msg_iovlen = 1;
+    header.msg_control = controlBuffer;
+    header.msg_controllen = sizeof(controlBuffer);
+
+    auto result = recvmsg(m_socket, &header, 0);
+
+    if (result < 0) {
+        return false;
+    }
+
+    for (auto controlMessage = CMSG_FIRSTHDR(&header);
+         controlMessage != nullptr;
+         controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+
+#if defined(Q_OS_LINUX)
+        if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPING)) {
+            struct scm_timestamping timestamps = {};
+
+            memcpy(&timestamps, CMSG_DATA(controlMessage), sizeof(timestamps));
+
+            // the software time is kept if the adapter did not stamp this packet.
+
+            auto hardwareTimestamp = m_hardwareTimestamps ? toNanoseconds(timestamps.ts[2]) : -1;
+
+            datagram.timestamp = ( hardwareTimestamp >= 0 ) ? hardwareTimestamp : toNanoseconds(timestamps.ts[0]);
+        } else if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPNS)) {
+            struct timespec kernelTime = {};
+
+            memcpy(&kernelTime, CMSG_DATA(controlMessage), sizeof(kernelTime));
+
+            datagram.timestamp = toNanoseconds(kernelTime);
+        } else if ((controlMessage->cmsg_level == IPPROTO_IP) && (controlMessage->cmsg_type == IP_TTL)) {
+            int ttl = 0;
+
+            memcpy(&ttl, CMSG_DATA(controlMessage), sizeof(ttl));
+
+            datagram.ttl = ttl;
+        }
+#else
+        if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMP)) {
+            struct timeval kernelTime = {};
+
+            memcpy(&kernelTime, CMSG_DATA(controlMessage), sizeof(kernelTime));
+
+            datagram.timestamp = static_cast<qint64>(kernelTime.tv_sec) * NanosecondsInSecond +
+                                 static_cast<qint64>(kernelTime.tv_usec) * NanosecondsInMicrosecond;
+        } else if ((controlMessage->cmsg_level == IPPROTO_IP) && (controlMessage->cmsg_type == IP_RECVTTL)) {
+            // the bsd stacks report the ttl as a single byte.
+
+            datagram.ttl = *reinterpret_cast<unsigned char *>(CMSG_DATA(controlMessage));
+        }
+#endif
+        else if ((controlMessage->cmsg_level == IPPROTO_IPV6) && (controlMessage->cmsg_type == IPV6_HOPLIMIT)) {
+            int hopLimit = 0;
+
+            memcpy(&hopLimit, CMSG_DATA(controlMessage), sizeof(hopLimit));
+
+            datagram.ttl = hopLimit;
+        }
+    }
+
+    if (datagram.timestamp < 0) {
+        datagram.timestamp = currentTime();
+    }
+#endif
+
+    datagram.buffer.resize(static_cast<int>(result));
+    datagram.hostAddress = QHostAddress(reinterpret_cast<struct sockaddr *>(&fromAddress));
+    datagram.port = ntohs(
+        ( fromAddress.ss_family == AF_INET ) ? reinterpret_cast<struct sockaddr_in *>(&fromAddress)->sin_port :
+                                               reinterpret_cast<struct sockaddr_in6 *>(&fromAddress)->sin6_port );
+
+    return true;
+}
+
+auto Nedrysoft::TWAMPPingEngine::TWAMPSocket::receiveError(
+        Nedrysoft::TWAMPPingEngine::TWAMPSocket::Error &error) -> bool {
+
+#if defined(Q_OS_LINUX)
+    struct iovec ioVector = {};
+    struct msghdr header = {};
+    char controlBuffer[ControlBufferLength];
+
+    error.buffer.resize(MaximumPacketLength);
+
+    ioVector.iov_base = error.buffer.data();
+    ioVector.iov_len = static_cast<size_t>(error.buffer.length());
+
+    header.msg_iov = &ioVector;
+    header.msg_iovlen = 1;
+    header.msg_control = controlBuffer;
+    header.msg_controllen = sizeof(controlBuffer);
+
+    auto result = recvmsg(m_socket, &header, MSG_ERRQUEUE);
+
+    if (result < 0) {
+        return false;
+    }
+
+    struct sock_extended_err *socketError = nullptr;
+
+    error.timestamp = -1;
+
+    for (auto controlMessage = CMSG_FIRSTHDR(&header);
+         controlMessage != nullptr;
+         controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+
+        if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPING)) {
+            struct scm_timestamping timestamps = {};
+
+            memcpy(&timestamps, CMSG_DATA(controlMessage), sizeof(timestamps));
+
+            error.timestamp = toNanoseconds(timestamps.ts[0]);
+        } else if (((controlMessage->cmsg_level == IPPROTO_IP) && (controlMessage->cmsg_type == IP_RECVERR)) ||
+                   ((controlMessage->cmsg_level == IPPROTO_IPV6) && (controlMessage->cmsg_type == IPV6_RECVERR))) {
+            socketError = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(controlMessage));
+        }
+    }
+
+    if (error.timestamp < 0) {
+        error.timestamp = currentTime();
+    }
+
+    error.buffer.resize(static_cast<int>(result));
+
+    // local errors (i.e. no route) have no offender and are reported as a lost packet.
+
+    if ((!socketError) ||
+        ((socketError->ee_origin != SO_EE_ORIGIN_ICMP) && (socketError->ee_origin != SO_EE_ORIGIN_ICMP6))) {
+
+        error.offender = QHostAddress();
+        error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+
+        return true;
+    }
+
+    error.offender = QHostAddress(SO_EE_OFFENDER(socketError));
+
+    if (socketError->ee_origin == SO_EE_ORIGIN_ICMP) {
+        if (socketError->ee_type == ICMPv4TimeExceeded) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+        } else if ((socketError->ee_type == ICMPv4Unreachable) &&
+                   ((socketError->ee_code == ICMPv4NetProhibited) ||
+                    (socketError->ee_code == ICMPv4HostProhibited) ||
+                    (socketError->ee_code == ICMPv4AdminProhibited))) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited;
+        } else if (socketError->ee_type == ICMPv4Unreachable) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable;
+        } else {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+        }
+    } else {
+        if (socketError->ee_type == ICMPv6TimeExceeded) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+        } else if ((socketError->ee_type == ICMPv6Unreachable) &&
+                   ((socketError->ee_code == ICMPv6AdminProhibited) ||
+                    (socketError->ee_code == ICMPv6PolicyFailed) ||
+                    (socketError->ee_code == ICMPv6RejectRoute))) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited;
+        } else if ((socketError->ee_type == ICMPv6Unreachable) || (socketError->ee_type == ICMPv6PacketTooBig)) {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::Unreachable;
+        } else {
+            error.code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+        }
+    }
+
+    return true;
+#else
+    Q_UNUSED(error)
+
+    return false;
+#endif
+}
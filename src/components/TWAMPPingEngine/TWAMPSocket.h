@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPSOCKET_H
+#define PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPSOCKET_H
+
+#include <ICore>
+#include <PingResult>
+#include <QByteArray>
+#include <QHostAddress>
+
+#if defined(Q_OS_WIN)
+#include <WinSock2.h>
+#endif
+
+namespace Nedrysoft { namespace TWAMPPingEngine {
+#if defined(Q_OS_WIN)
+    using socket_t = SOCKET;
+#else
+    using socket_t = int;
+#endif
+
+    /**
+     * @brief       The TWAMPSocket class provides the UDP socket used by the TWAMP sender and reflector.
+     *
+     * @details     Packets are timestamped by the kernel as they arrive where the platform supports it (Linux),
+     *              otherwise they are timestamped when they are read.  Adapter (hardware) timestamps can be used
+     *              instead, these are only meaningful if the adapter clock is synchronised to the system clock
+     *              (i.e by phc2sys) as the other timestamps are taken from the system clock.
+     *
+     *              On Linux the ICMP errors caused by a packet are also queued on the socket, this allows a
+     *              sender to see the routers that a packet expired at and reflectors that are not listening.
+     *
+     *              All times are nanoseconds since the unix epoch of the system (UTC) clock, they are compared
+     *              with the times of another host so the monotonic clock is not used.
+     */
+    class TWAMPSocket {
+        public:
+            /**
+             * @brief       A received packet.
+             */
+            struct Datagram {
+                QByteArray buffer;
+                QHostAddress hostAddress;
+                quint16 port = 0;
+                qint64 timestamp = -1;
+                int ttl = -1;
+            };
+
+            /**
+             * @brief       An ICMP error caused by a packet sent from this socket.
+             */
+            struct Error {
+                QByteArray buffer;
+                QHostAddress offender;
+                qint64 timestamp = -1;
+                Nedrysoft::RouteAnalyser::PingResult::ResultCode code =
+                        Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+            };
+
+        private:
+            /**
+             * @brief       Constructs a TWAMPSocket for a socket descriptor.
+             *
+             * @param[in]   socket the socket descriptor.
+             * @param[in]   version the IP version of the socket.
+             */
+            TWAMPSocket(socket_t socket, Nedrysoft::Core::IPVersion version);
+
+        public:
+            /**
+             * @brief       Destroys the TWAMPSocket and closes the socket.
+             */
+            ~TWAMPSocket();
+
+            /**
+             * @brief       Creates a socket bound to the given port.
+             *
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   port the port to bind to; otherwise 0 for an ephemeral port.
+             * @param[in]   hardwareTimestamps true to use adapter timestamps if available.
+             *
+             * @returns     the socket if created; otherwise nullptr.
+             */
+            static auto create(
+                Nedrysoft::Core::IPVersion version,
+                quint16 port = 0,
+                bool hardwareTimestamps = false
+            ) -> TWAMPSocket *;
+
+            /**
+             * @brief       Returns the current time of the system clock.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            static auto currentTime() -> qint64;
+
+            /**
+             * @brief       Sends a packet.
+             *
+             * @param[in]   buffer the packet.
+             * @param[in]   hostAddress the destination address.
+             * @param[in]   port the destination port.
+             * @param[in]   ttl the ttl (or hop limit) of the packet.
+             *
+             * @returns     true if the packet was sent; otherwise false.
+             */
+            auto sendTo(const QByteArray &buffer, const QHostAddress &hostAddress, quint16 port, int ttl) -> bool;
+
+            /**
+             * @brief       Sets whether packets are sent with the don't fragment flag set.
+             *
+             * @param[in]   dontFragment true to set the don't fragment flag; otherwise false.
+             *
+             * @returns     true if the flag was set; otherwise false if the platform does not support it.
+             */
+            auto setDontFragment(bool dontFragment) -> bool;
+
+            /**
+             * @brief       Waits for a packet or error to be available.
+             *
+             * @details     The wait returns early if wakeup() is called from another thread.
+             *
+             * @param[in]   timeout the maximum time to wait in milliseconds.
+             *
+             * @returns     true if a packet or error may be read; otherwise false.
+             */
+            auto wait(int timeout) -> bool;
+
+            /**
+             * @brief       Interrupts a wait in progress, or the next wait if none is in progress.
+             *
+             * @note        This may be called from any thread, it is used to stop a worker without waiting for its
+             *              poll to time out.
+             */
+            auto wakeup() -> void;
+
+            /**
+             * @brief       Reads a packet without blocking.
+             *
+             * @param[out]  datagram the packet.
+             *
+             * @returns     true if a packet was read; otherwise false.
+             */
+            auto receive(Datagram &datagram) -> bool;
+
+            /**
+             * @brief       Reads a queued ICMP error without blocking.
+             *
+             * @note        Errors are only reported on Linux.
+             *
+             * @param[out]  error the error.
+             *
+             * @returns     true if an error was read; otherwise false.
+             */
+            auto receiveError(Error &error) -> bool;
+
+        private:
+            //! @cond
+
+            socket_t m_socket;
+#if defined(Q_OS_WIN)
+            socket_t m_wakeupSocket;
+            struct sockaddr_in m_wakeupAddress;
+#else
+            int m_wakeupDescriptors[2];
+#endif
+            Nedrysoft::Core::IPVersion m_version;
+            bool m_hardwareTimestamps;
+            int m_ttl;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TWAMPPINGENGINE_TWAMPSOCKET_H
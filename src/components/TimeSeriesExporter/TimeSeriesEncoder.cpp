@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TimeSeriesEncoder.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QPair>
+
+#include <algorithm>
+#include <array>
+
+constexpr auto InfluxMeasurement = "pingnoo";
+constexpr auto InfluxSinkMeasurement = "pingnoo_sink";
+constexpr auto ServiceName = "pingnoo";
+constexpr auto DeltaTemporality = 1;
+constexpr auto CumulativeTemporality = 2;
+constexpr auto CompressionLevel = 6;
+constexpr auto QtLengthSize = 4;
+constexpr auto ZlibHeaderSize = 2;
+constexpr auto ZlibTrailerSize = 4;
+constexpr auto Crc32Polynomial = 0xedb88320u;
+
+static auto escapeTag(const QString &value) -> QByteArray {
+    auto escaped = value.toUtf8();
+
+    escaped.replace('\\', "\\\\");
+    escaped.replace(',', "\\,");
+    escaped.replace('=', "\\=");
+    escaped.replace(' ', "\\ ");
+    escaped.replace('\n', "\\n");
+
+    return escaped;
+}
+
+static auto attribute(const QString &key, const QString &value) -> QJsonObject {
+    return QJsonObject {
+        {"key", key},
+        {"value", QJsonObject {{"stringValue", value}}}
+    };
+}
+
+static auto hopAttributes(const QString &target, int hop, const QHostAddress &address) -> QJsonArray {
+    auto attributes = QJsonArray {
+        attribute("target", target),
+        QJsonObject {
+            {"key", "hop"},
+            {"value", QJsonObject {{"intValue", QString::number(hop)}}}
+        }
+    };
+
+    if (!address.isNull()) {
+        attributes.append(attribute("address", address.toString()));
+    }
+
+    return attributes;
+}
+
+static auto sum(
+        const QString &name,
+        const QString &description,
+        int temporality,
+        const QJsonArray &dataPoints ) -> QJsonObject {
+
+    return QJsonObject {
+        {"name", name},
+        {"description", description},
+        {"unit", "1"},
+        {"sum", QJsonObject {
+            {"aggregationTemporality", temporality},
+            {"isMonotonic", true},
+            {"dataPoints", dataPoints}
+        }}
+    };
+}
+
+static auto sinkDataPoint(quint64 value, qint64 startTime, qint64 timestamp) -> QJsonArray {
+    return QJsonArray {
+        QJsonObject {
+            {"startTimeUnixNano", QString::number(startTime)},
+            {"timeUnixNano", QString::number(timestamp)},
+            {"asInt", QString::number(value)}
+        }
+    };
+}
+
+static auto crc32(const QByteArray &data) -> quint32 {
+    static const auto table = []() {
+        auto table = std::array<quint32, 256>();
+
+        for (quint32 index=0;index<table.size();index++) {
+            auto value = index;
+
+            for (auto bit=0;bit<8;bit++) {
+                value = (value & 1) ? (Crc32Polynomial ^ (value >> 1)) : (value >> 1);
+            }
+
+            table[index] = value;
+        }
+
+        return table;
+    }();
+
+    auto crc = 0xffffffffu;
+
+    for (auto byte : data) {
+        crc = table[(crc ^ static_cast<quint8>(byte)) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xffffffffu;
+}
+
+static auto appendLittleEndian(QByteArray &data, quint32 value) -> void {
+    for (auto byte=0;byte<4;byte++) {
+        data.append(static_cast<char>((value >> (byte*8)) & 0xff));
+    }
+}
+
+auto Nedrysoft::TimeSeriesExporter::influxLines(
+        const QVector<Point> &points,
+        const Counters &counters,
+        qint64 timestamp ) -> QByteArray {
+
+    auto lines = QByteArray();
+
+    for (auto &point : points) {
+        lines += InfluxMeasurement;
+        lines += ",target="+escapeTag(point.target);
+        lines += ",hop="+QByteArray::number(point.hop);
+
+        if (!point.address.isNull()) {
+            lines += ",address="+escapeTag(point.address.toString());
+        }
+
+        if (point.roundTripTime>=0) {
+            lines += " rtt="+QByteArray::number(point.roundTripTime, 'g', 9)+",lost=false ";
+        } else {
+            lines += " lost=true ";
+        }
+
+        lines += QByteArray::number(point.timestamp)+"\n";
+    }
+
+    lines += InfluxSinkMeasurement;
+    lines += " sent="+QByteArray::number(counters.sent)+"i";
+    lines += ",dropped="+QByteArray::number(counters.dropped)+"i";
+    lines += ",failed="+QByteArray::number(counters.failed)+"i ";
+    lines += QByteArray::number(timestamp)+"\n";
+
+    return lines;
+}
+
+auto Nedrysoft::TimeSeriesExporter::otlpJson(
+        const QVector<Point> &points,
+        const Counters &counters,
+        qint64 startTime,
+        qint64 timestamp ) -> QByteArray {
+
+    struct HopTotals {
+        QHostAddress address;
+        qint64 startTime;
+        qint64 endTime;
+        qint64 replies;
+        qint64 timeouts;
+    };
+
+    auto roundTripTimes = QJsonArray();
+    auto totals = QMap<QPair<QString, int>, HopTotals>();
+
+    for (auto &point : points) {
+        auto key = qMakePair(point.target, point.hop);
+        auto hopTotals = totals.find(key);
+
+        if (hopTotals==totals.end()) {
+            hopTotals = totals.insert(key, HopTotals{point.address, point.timestamp, point.timestamp, 0, 0});
+        }
+
+        hopTotals->startTime = std::min(hopTotals->startTime, point.timestamp);
+        hopTotals->endTime = std::max(hopTotals->endTime, point.timestamp);
+
+        if (point.roundTripTime<0) {
+            hopTotals->timeouts++;
+
+            continue;
+        }
+
+        hopTotals->address = point.address;
+        hopTotals->replies++;
+
+        roundTripTimes.append(QJsonObject {
+            {"attributes", hopAttributes(point.target, point.hop, point.address)},
+            {"timeUnixNano", QString::number(point.timestamp)},
+            {"asDouble", point.roundTripTime}
+        });
+    }
+
+    auto replies = QJsonArray();
+    auto timeouts = QJsonArray();
+
+    for (auto hopTotals=totals.begin();hopTotals!=totals.end();hopTotals++) {
+        auto attributes = hopAttributes(hopTotals.key().first, hopTotals.key().second, hopTotals->address);
+
+        auto dataPoint = [&](qint64 value) -> QJsonObject {
+            return QJsonObject {
+                {"attributes", attributes},
+                {"startTimeUnixNano", QString::number(hopTotals->startTime)},
+                {"timeUnixNano", QString::number(hopTotals->endTime)},
+                {"asInt", QString::number(value)}
+            };
+        };
+
+        replies.append(dataPoint(hopTotals->replies));
+        timeouts.append(dataPoint(hopTotals->timeouts));
+    }
+
+    auto metrics = QJsonArray {
+        QJsonObject {
+            {"name", "pingnoo.hop.rtt"},
+            {"description", "The round trip time of a reply from the hop."},
+            {"unit", "s"},
+            {"gauge", QJsonObject {{"dataPoints", roundTripTimes}}}
+        },
+        sum("pingnoo.hop.replies", "The number of requests that the hop replied to.", DeltaTemporality, replies),
+        sum("pingnoo.hop.timeouts", "The number of requests that the hop did not reply to.", DeltaTemporality,
+            timeouts),
+        sum("pingnoo.sink.sent", "The number of results delivered by the sink.", CumulativeTemporality,
+            sinkDataPoint(counters.sent, startTime, timestamp)),
+        sum("pingnoo.sink.dropped", "The number of results discarded by the sink.", CumulativeTemporality,
+            sinkDataPoint(counters.dropped, startTime, timestamp)),
+        sum("pingnoo.sink.failed", "The number of batches that the sink failed to deliver.", CumulativeTemporality,
+            sinkDataPoint(counters.failed, startTime, timestamp))
+    };
+
+    auto request = QJsonObject {
+        {"resourceMetrics", QJsonArray {
+            QJsonObject {
+                {"resource", QJsonObject {
+                    {"attributes", QJsonArray {attribute("service.name", ServiceName)}}
+                }},
+                {"scopeMetrics", QJsonArray {
+                    QJsonObject {
+                        {"scope", QJsonObject {{"name", ServiceName}}},
+                        {"metrics", metrics}
+                    }
+                }}
+            }
+        }}
+    };
+
+    return QJsonDocument(request).toJson(QJsonDocument::Compact);
+}
+
+auto Nedrysoft::TimeSeriesExporter::gzip(const QByteArray &data) -> QByteArray {
+    /**
+     * qCompress prefixes a zlib stream with the uncompressed length, the deflate stream between the zlib header
+     * and its adler32 trailer is the same as the one a gzip member carries.
+     */
+
+    auto compressed = qCompress(data, CompressionLevel);
+    auto deflateSize = compressed.size()-QtLengthSize-ZlibHeaderSize-ZlibTrailerSize;
+
+    if (deflateSize<0) {
+        return QByteArray();
+    }
+
+    auto gzipData = QByteArray("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+
+    gzipData.append(compressed.constData()+QtLengthSize+ZlibHeaderSize, deflateSize);
+
+    appendLittleEndian(gzipData, crc32(data));
+    appendLittleEndian(gzipData, static_cast<quint32>(data.size()));
+
+    return gzipData;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESENCODER_H
+#define PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESENCODER_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+
+namespace Nedrysoft { namespace TimeSeriesExporter {
+    /**
+     * @brief       A single result waiting to be sent.
+     */
+    struct Point {
+        QString target;                             //!< the name of the target that the hop belongs to.
+        int hop = 0;                                //!< the hop number.
+        QHostAddress address;                       //!< the address that replied, null if there was no reply.
+        qint64 timestamp = 0;                       //!< the time the request was sent in ns since the epoch.
+        double roundTripTime = -1;                  //!< the round trip time in seconds, -1 if there was no reply.
+    };
+
+    /**
+     * @brief       The counters that describe the health of the sink, they are sent alongside the results.
+     */
+    struct Counters {
+        quint64 sent = 0;                           //!< the number of results that have been delivered.
+        quint64 dropped = 0;                        //!< the number of results discarded without being delivered.
+        quint64 failed = 0;                         //!< the number of batches that could not be delivered.
+    };
+
+    /**
+     * @brief       Encodes results as InfluxDB line protocol.
+     *
+     * @details     Each result is a line of the pingnoo measurement tagged with the target, hop and address, the
+     *              counters are a line of the pingnoo_sink measurement.
+     *
+     * @param[in]   points the results.
+     * @param[in]   counters the sink counters.
+     * @param[in]   timestamp the time of the counters in ns since the epoch.
+     *
+     * @returns     the lines.
+     */
+    auto influxLines(const QVector<Point> &points, const Counters &counters, qint64 timestamp) -> QByteArray;
+
+    /**
+     * @brief       Encodes results as an OTLP/HTTP JSON metrics export request.
+     *
+     * @details     Round trip times are gauge data points, replies and timeouts are delta sums per hop over the
+     *              batch, the counters are cumulative sums.
+     *
+     * @param[in]   points the results.
+     * @param[in]   counters the sink counters.
+     * @param[in]   startTime the time the sink was started in ns since the epoch.
+     * @param[in]   timestamp the time of the counters in ns since the epoch.
+     *
+     * @returns     the JSON document.
+     */
+    auto otlpJson(
+            const QVector<Point> &points,
+            const Counters &counters,
+            qint64 startTime,
+            qint64 timestamp ) -> QByteArray;
+
+    /**
+     * @brief       Compresses data into the gzip format.
+     *
+     * @details     The deflate stream produced by qCompress is rewrapped with a gzip header and trailer, so no
+     *              separate compression library is needed.
+     *
+     * @param[in]   data the data to compress.
+     *
+     * @returns     the gzip data.
+     */
+    auto gzip(const QByteArray &data) -> QByteArray;
+}}
+
+#endif // PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESENCODER_H
@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TimeSeriesExporter.h"
+
+#include <Clock>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QThread>
+#include <QTimer>
+#include <QUdpSocket>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+constexpr auto RequestTimeout = 30000;
+constexpr auto MinimumBackoff = 1000;
+constexpr auto MaximumBackoff = 60000;
+constexpr auto MaximumDatagramSize = 1400;
+constexpr auto DefaultDatagramPort = 8089;
+constexpr auto InfluxContentType = "text/plain; charset=utf-8";
+constexpr auto OpenTelemetryContentType = "application/json";
+
+Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::TimeSeriesExporter() :
+        m_thread(new QThread),
+        m_context(new QObject),
+        m_ringStart(0),
+        m_ringCount(0),
+        m_flushQueued(false),
+        m_protocol(Protocol::Influx),
+        m_batchSize(0),
+        m_startTime(0),
+        m_networkAccessManager(nullptr),
+        m_udpSocket(nullptr),
+        m_flushTimer(nullptr),
+        m_batchCount(0),
+        m_requestActive(false),
+        m_retryPending(false),
+        m_backoff(0) {
+
+    m_context->moveToThread(m_thread);
+
+    m_thread->start();
+}
+
+Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::~TimeSeriesExporter() {
+    /**
+     * the network objects belong to the worker thread, so they are destroyed there before it is stopped, an
+     * outstanding request is aborted with them.
+     */
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        delete m_flushTimer;
+        delete m_udpSocket;
+        delete m_networkAccessManager;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+
+    delete m_context;
+    delete m_thread;
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::start(
+        const QUrl &url,
+        Protocol protocol,
+        const QString &authorization,
+        int capacity,
+        int batchSize,
+        int flushInterval ) -> bool {
+
+    auto scheme = url.scheme().toLower();
+    auto isDatagram = (scheme=="udp");
+
+    if ((!url.isValid()) || (url.host().isEmpty()) || ((!isDatagram) && (scheme!="http") && (scheme!="https"))) {
+        SPDLOG_ERROR(QString("Unable to push results to %1, the url is invalid.").arg(url.toString()).toStdString());
+
+        return false;
+    }
+
+    if ((isDatagram) && (protocol!=Protocol::Influx)) {
+        SPDLOG_ERROR("Unable to push results, only the Influx line protocol can be sent over UDP.");
+
+        return false;
+    }
+
+    if ((capacity<=0) || (batchSize<=0) || (flushInterval<=0)) {
+        return false;
+    }
+
+    m_url = url;
+    m_protocol = protocol;
+    m_authorization = authorization.toUtf8();
+    m_batchSize = std::min(batchSize, capacity);
+    m_startTime = Nedrysoft::Core::Clock::getInstance()->now();
+
+    QMetaObject::invokeMethod(m_context, [this, isDatagram, flushInterval]() {
+        if (isDatagram) {
+            m_udpSocket = new QUdpSocket;
+
+            /**
+             * the host is resolved once, here on the worker thread, rather than for every datagram.
+             */
+
+            m_datagramAddress = QHostAddress(m_url.host());
+
+            if (m_datagramAddress.isNull()) {
+                auto addresses = QHostInfo::fromName(m_url.host()).addresses();
+
+                m_datagramAddress = addresses.isEmpty() ? QHostAddress() : addresses.first();
+            }
+        } else {
+            m_networkAccessManager = new QNetworkAccessManager;
+        }
+
+        m_flushTimer = new QTimer;
+
+        connect(m_flushTimer, &QTimer::timeout, m_context, [this]() {
+            flush();
+        });
+
+        m_flushTimer->start(flushInterval);
+    }, Qt::BlockingQueuedConnection);
+
+    QMutexLocker locker(&m_mutex);
+
+    m_ring.resize(capacity);
+
+    return true;
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::update(
+        const QString &target,
+        int hop,
+        const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+        const QVector<Nedrysoft::RouteAnalyser::PingResult> &results ) -> void {
+
+    Q_UNUSED(statistics)
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_ring.isEmpty()) {
+        return;
+    }
+
+    for (auto &result : results) {
+        auto lost = Nedrysoft::RouteAnalyser::PingResult::isLost(result.code());
+
+        /**
+         * when the ring is full the oldest result is dropped to make room, the caller is never made to wait for
+         * the backend.
+         */
+
+        if (m_ringCount==m_ring.count()) {
+            m_ringStart = (m_ringStart+1)%m_ring.count();
+            m_ringCount--;
+
+            m_counters.dropped++;
+        }
+
+        auto &point = m_ring[(m_ringStart+m_ringCount)%m_ring.count()];
+
+        point.target = target;
+        point.hop = hop;
+        point.address = lost ? QHostAddress() : result.hostAddress();
+        point.timestamp = result.requestTimestamp();
+        point.roundTripTime = lost ? -1 : result.roundTripTime();
+
+        m_ringCount++;
+    }
+
+    if (m_ringCount>=m_batchSize) {
+        queueFlush();
+    }
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::removeTarget(const QString &target) -> void {
+    Q_UNUSED(target)
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::queueFlush() -> void {
+    if (m_flushQueued) {
+        return;
+    }
+
+    m_flushQueued = true;
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        flush();
+    }, Qt::QueuedConnection);
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::flush() -> void {
+    m_mutex.lock();
+
+    m_flushQueued = false;
+
+    m_mutex.unlock();
+
+    /**
+     * a batch that is in flight or waiting for its retry applies backpressure, nothing more is taken from the
+     * ring until it has been dealt with.
+     */
+
+    if ((m_requestActive) || (m_retryPending)) {
+        return;
+    }
+
+    if ((m_batch.isEmpty()) && (!takeBatch())) {
+        return;
+    }
+
+    if (m_udpSocket) {
+        sendDatagrams();
+
+        return;
+    }
+
+    QNetworkRequest request(m_url);
+
+    request.setHeader(
+        QNetworkRequest::ContentTypeHeader,
+        (m_protocol==Protocol::Influx) ? InfluxContentType : OpenTelemetryContentType );
+
+    request.setRawHeader("Content-Encoding", "gzip");
+
+    if (!m_authorization.isEmpty()) {
+        request.setRawHeader("Authorization", m_authorization);
+    }
+
+    auto reply = m_networkAccessManager->post(request, m_batch);
+
+    m_requestActive = true;
+
+    QTimer::singleShot(RequestTimeout, reply, [reply]() {
+        reply->abort();
+    });
+
+    connect(reply, &QNetworkReply::finished, m_context, [this, reply]() {
+        finishRequest(reply);
+    });
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::takeBatch() -> bool {
+    auto points = QVector<Nedrysoft::TimeSeriesExporter::Point>();
+    auto counters = Nedrysoft::TimeSeriesExporter::Counters();
+
+    m_mutex.lock();
+
+    auto count = std::min(m_ringCount, m_batchSize);
+
+    points.reserve(count);
+
+    for (auto index=0;index<count;index++) {
+        points.append(m_ring[(m_ringStart+index)%m_ring.count()]);
+    }
+
+    m_ringStart = (m_ringStart+count)%std::max(m_ring.count(), 1);
+    m_ringCount -= count;
+
+    counters = m_counters;
+
+    m_mutex.unlock();
+
+    if (points.isEmpty()) {
+        return false;
+    }
+
+    auto timestamp = Nedrysoft::Core::Clock::getInstance()->now();
+
+    if (m_protocol==Protocol::Influx) {
+        m_batch = influxLines(points, counters, timestamp);
+    } else {
+        m_batch = otlpJson(points, counters, m_startTime, timestamp);
+    }
+
+    /**
+     * datagrams are sent uncompressed, the Influx UDP listener does not accept gzip.
+     */
+
+    if (!m_udpSocket) {
+        m_batch = gzip(m_batch);
+    }
+
+    m_batchCount = points.count();
+
+    return true;
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::sendDatagrams() -> void {
+    auto port = static_cast<quint16>(m_url.port(DefaultDatagramPort));
+    auto delivered = !m_datagramAddress.isNull();
+    auto start = 0;
+
+    while ((delivered) && (start<m_batch.size())) {
+        /**
+         * a datagram holds as many whole lines as fit, a single line that is longer than a datagram is sent on
+         * its own.
+         */
+
+        auto end = start;
+
+        while (end<m_batch.size()) {
+            auto lineEnd = m_batch.indexOf('\n', end);
+
+            lineEnd = (lineEnd<0) ? m_batch.size() : lineEnd+1;
+
+            if ((end!=start) && (lineEnd-start>MaximumDatagramSize)) {
+                break;
+            }
+
+            end = lineEnd;
+        }
+
+        auto written = m_udpSocket->writeDatagram(m_batch.constData()+start, end-start, m_datagramAddress, port);
+
+        delivered = (written>=0);
+
+        start = end;
+    }
+
+    if (!delivered) {
+        SPDLOG_WARN(QString("Unable to push results to %1.").arg(m_url.toString()).toStdString());
+
+        QMutexLocker locker(&m_mutex);
+
+        m_counters.failed++;
+    }
+
+    finishBatch(delivered);
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::finishRequest(QNetworkReply *reply) -> void {
+    auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto error = reply->error();
+
+    reply->deleteLater();
+
+    m_requestActive = false;
+
+    if (error==QNetworkReply::NoError) {
+        m_backoff = 0;
+
+        finishBatch(true);
+
+        /**
+         * the ring may have filled while the batch was in flight, it is drained without waiting for the timer.
+         */
+
+        QMutexLocker locker(&m_mutex);
+
+        if (m_ringCount>=m_batchSize) {
+            queueFlush();
+        }
+
+        return;
+    }
+
+    m_mutex.lock();
+
+    m_counters.failed++;
+
+    m_mutex.unlock();
+
+    /**
+     * a request the backend rejects will never succeed, so the batch is dropped, anything else (an unreachable
+     * or overloaded backend) is retried after a backoff.
+     */
+
+    auto isRejected = (status>=400) && (status<500) && (status!=408) && (status!=429);
+
+    SPDLOG_WARN(QString("Unable to push results to %1. (%2)")
+            .arg(m_url.toString())
+            .arg(reply->errorString()).toStdString());
+
+    if (isRejected) {
+        finishBatch(false);
+
+        return;
+    }
+
+    m_backoff = std::clamp(m_backoff*2, MinimumBackoff, MaximumBackoff);
+    m_retryPending = true;
+
+    QTimer::singleShot(m_backoff, m_context, [this]() {
+        m_retryPending = false;
+
+        flush();
+    });
+}
+
+auto Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::finishBatch(bool delivered) -> void {
+    QMutexLocker locker(&m_mutex);
+
+    if (delivered) {
+        m_counters.sent += static_cast<quint64>(m_batchCount);
+    } else {
+        m_counters.dropped += static_cast<quint64>(m_batchCount);
+    }
+
+    m_batch.clear();
+    m_batchCount = 0;
+}
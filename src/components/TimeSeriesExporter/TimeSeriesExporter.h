@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESEXPORTER_H
+#define PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESEXPORTER_H
+
+#include "TimeSeriesEncoder.h"
+#include "TimeSeriesExporterSpec.h"
+
+#include <IResultSink>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMutex>
+#include <QUrl>
+#include <QVector>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QThread;
+class QTimer;
+class QUdpSocket;
+
+namespace Nedrysoft { namespace TimeSeriesExporter {
+    /**
+     * @brief       The TimeSeriesExporter class pushes results to a time series database.
+     *
+     * @details     Results are copied into a bounded ring on the caller's thread, a worker thread takes them from
+     *              the ring in batches and sends them as InfluxDB line protocol (over HTTP or UDP) or as OTLP/HTTP
+     *              JSON, HTTP batches are gzip compressed.
+     *
+     *              Only one batch is in flight at a time, while the backend is slow or unavailable the ring fills
+     *              and the oldest results are dropped, so an outage costs memory bounded by the ring and never
+     *              holds up the ping engine.  A batch that fails with a transient error is retried with an
+     *              exponential backoff, the number of results sent and dropped and the number of failed batches
+     *              are sent alongside the results.
+     */
+    class NEDRYSOFT_TIMESERIESEXPORTER_DLLSPEC TimeSeriesExporter :
+            public Nedrysoft::RouteAnalyser::IResultSink {
+
+        private:
+            Q_OBJECT
+
+            Q_INTERFACES(Nedrysoft::RouteAnalyser::IResultSink)
+
+        public:
+            /**
+             * @brief       The format that results are sent in.
+             */
+            enum class Protocol {
+                Influx,
+                OpenTelemetry
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new TimeSeriesExporter and starts its thread.
+             */
+            TimeSeriesExporter();
+
+            /**
+             * @brief       Stops the thread and destroys the TimeSeriesExporter.
+             *
+             * @note        Results that have not been sent are discarded.
+             */
+            ~TimeSeriesExporter();
+
+            /**
+             * @brief       Starts sending results.
+             *
+             * @param[in]   url the endpoint, http or https for either protocol, or udp for Influx.
+             * @param[in]   protocol the format to send.
+             * @param[in]   authorization the value of the Authorization header, empty for none.
+             * @param[in]   capacity the maximum number of results held while waiting to be sent.
+             * @param[in]   batchSize the maximum number of results in a batch.
+             * @param[in]   flushInterval the maximum time in milliseconds that a result waits before being sent.
+             *
+             * @returns     true if the endpoint is valid; otherwise false.
+             */
+            auto start(
+                    const QUrl &url,
+                    Protocol protocol,
+                    const QString &authorization,
+                    int capacity,
+                    int batchSize,
+                    int flushInterval
+            ) -> bool;
+
+            /**
+             * @brief       Adds results for a hop to the ring.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::update
+             *
+             * @param[in]   target the name of the target that the hop belongs to.
+             * @param[in]   hop the hop number.
+             * @param[in]   statistics the aggregates of the hop, unused as the raw results are pushed.
+             * @param[in]   results the results received for the hop since the previous update.
+             */
+            auto update(
+                    const QString &target,
+                    int hop,
+                    const Nedrysoft::RouteAnalyser::HopStatistics &statistics,
+                    const QVector<Nedrysoft::RouteAnalyser::PingResult> &results
+            ) -> void override;
+
+            /**
+             * @brief       Does nothing, results that have been pushed are kept by the time series database.
+             *
+             * @see         Nedrysoft::RouteAnalyser::IResultSink::removeTarget
+             *
+             * @param[in]   target the name of the target.
+             */
+            auto removeTarget(const QString &target) -> void override;
+
+        private:
+            /**
+             * @brief       Queues a flush on the worker thread, called with the mutex held.
+             */
+            auto queueFlush() -> void;
+
+            /**
+             * @brief       Sends the next batch unless one is in flight or waiting to be retried.
+             */
+            auto flush() -> void;
+
+            /**
+             * @brief       Takes the next batch from the ring and encodes it.
+             *
+             * @returns     true if there was a batch; otherwise false.
+             */
+            auto takeBatch() -> bool;
+
+            /**
+             * @brief       Sends the current batch as datagrams split on line boundaries.
+             */
+            auto sendDatagrams() -> void;
+
+            /**
+             * @brief       Handles the completion of the request that carried the current batch.
+             *
+             * @param[in]   reply the reply to the request.
+             */
+            auto finishRequest(QNetworkReply *reply) -> void;
+
+            /**
+             * @brief       Discards the current batch, counting its results as dropped if it was not delivered.
+             *
+             * @param[in]   delivered true if the batch was delivered.
+             */
+            auto finishBatch(bool delivered) -> void;
+
+        private:
+            //! @cond
+
+            QThread *m_thread;
+            QObject *m_context;
+
+            QMutex m_mutex;
+            QVector<Nedrysoft::TimeSeriesExporter::Point> m_ring;
+            int m_ringStart;
+            int m_ringCount;
+            bool m_flushQueued;
+            Nedrysoft::TimeSeriesExporter::Counters m_counters;
+
+            QUrl m_url;
+            Protocol m_protocol;
+            QByteArray m_authorization;
+            int m_batchSize;
+            qint64 m_startTime;
+
+            QNetworkAccessManager *m_networkAccessManager;
+            QUdpSocket *m_udpSocket;
+            QHostAddress m_datagramAddress;
+            QTimer *m_flushTimer;
+
+            QByteArray m_batch;
+            int m_batchCount;
+            bool m_requestActive;
+            bool m_retryPending;
+            int m_backoff;
+
+            //! @endcond
+    };
+}}
+
+#endif // PINGNOO_COMPONENTS_TIMESERIESEXPORTER_TIMESERIESEXPORTER_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TimeSeriesExporterComponent.h"
+
+#include "TimeSeriesExporter.h"
+
+#include <QSettings>
+#include <QUrl>
+
+constexpr auto UrlSettingsKey = "TimeSeriesExporter/Url";
+constexpr auto ProtocolSettingsKey = "TimeSeriesExporter/Protocol";
+constexpr auto AuthorizationSettingsKey = "TimeSeriesExporter/Authorization";
+constexpr auto CapacitySettingsKey = "TimeSeriesExporter/Capacity";
+constexpr auto BatchSizeSettingsKey = "TimeSeriesExporter/BatchSize";
+constexpr auto FlushIntervalSettingsKey = "TimeSeriesExporter/FlushInterval";
+constexpr auto OpenTelemetryProtocol = "otlp";
+constexpr auto DefaultCapacity = 100000;
+constexpr auto DefaultBatchSize = 5000;
+constexpr auto DefaultFlushInterval = 10000;
+
+TimeSeriesExporterComponent::TimeSeriesExporterComponent() :
+        m_timeSeriesExporter(nullptr) {
+
+}
+
+TimeSeriesExporterComponent::~TimeSeriesExporterComponent() {
+
+}
+
+auto TimeSeriesExporterComponent::finaliseEvent() -> void {
+    if (m_timeSeriesExporter) {
+        Nedrysoft::ComponentSystem::removeObject(m_timeSeriesExporter);
+
+        delete m_timeSeriesExporter;
+    }
+}
+
+auto TimeSeriesExporterComponent::initialiseEvent() -> void {
+    QSettings settings;
+
+    /**
+     * the sink is only registered once an endpoint has been configured, so results are not buffered for a backend
+     * that does not exist.
+     */
+
+    auto url = QUrl(settings.value(UrlSettingsKey).toString());
+
+    if (url.isEmpty()) {
+        return;
+    }
+
+    auto protocol = Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::Protocol::Influx;
+
+    if (settings.value(ProtocolSettingsKey).toString().compare(OpenTelemetryProtocol, Qt::CaseInsensitive)==0) {
+        protocol = Nedrysoft::TimeSeriesExporter::TimeSeriesExporter::Protocol::OpenTelemetry;
+    }
+
+    auto timeSeriesExporter = new Nedrysoft::TimeSeriesExporter::TimeSeriesExporter();
+
+    auto started = timeSeriesExporter->start(
+        url,
+        protocol,
+        settings.value(AuthorizationSettingsKey).toString(),
+        settings.value(CapacitySettingsKey, DefaultCapacity).toInt(),
+        settings.value(BatchSizeSettingsKey, DefaultBatchSize).toInt(),
+        settings.value(FlushIntervalSettingsKey, DefaultFlushInterval).toInt() );
+
+    if (!started) {
+        delete timeSeriesExporter;
+
+        return;
+    }
+
+    m_timeSeriesExporter = timeSeriesExporter;
+
+    Nedrysoft::ComponentSystem::addObject(m_timeSeriesExporter);
+}
@@ -21,37 +21,392 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <dbus/dbus.h>
-#include <stdio.h>
+/**
+ * The privileged socket helper.
+ *
+ * The helper is installed with the CAP_NET_RAW capability (setcap cap_net_raw+ep pingnoo-helper) and is started by
+ * the application with a sequenced packet socket as descriptor 3.  For each request received it creates a raw
+ * socket, attaches a default receive filter and passes the socket back as SCM_RIGHTS ancillary data, the
+ * application can then use the socket without holding any privileges itself.
+ *
+ * Only raw ICMP, UDP and TCP sockets are created, the helper exits when the application closes the connection.  The
+ * UDP and TCP sockets are needed by the UDP and TCP traceroute probes, which write their own transport headers (so
+ * that the ports and sequence numbers identify the probe) and, for TCP, receive the reset or synchronise
+ * acknowledge that answers them.  Raw UDP sockets are only created for sending and every packet they would receive
+ * is dropped, a raw TCP socket only receives resets and synchronise acknowledges.  Every BPF filter attached by the
+ * helper is locked so that it cannot be removed or widened.
+ *
+ * The capability is only useful to members of PINGNOO_HELPER_GROUP (and root), any other user is refused, the
+ * helper should also be installed so that only that group can execute it (chgrp pingnoo pingnoo-helper, chmod 0750).
+ */
+
+#include "ICMPSocketBrokerProtocol.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <grp.h>
+#include <linux/capability.h>
+#include <linux/filter.h>
+#include <linux/icmp.h>
+#include <memory>
+#include <netinet/icmp6.h>
+#include <netinet/in.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if !defined(PINGNOO_HELPER_GROUP)
+#define PINGNOO_HELPER_GROUP "pingnoo"
+#endif
+
+#if !defined(SO_LOCK_FILTER)
+#define SO_LOCK_FILTER 44
+#endif
+
+constexpr auto ICMPEchoReplyV4 = 0;
+constexpr auto ICMPDestinationUnreachableV4 = 3;
+constexpr auto ICMPTimeExceededV4 = 11;
+constexpr auto ICMPParameterProblemV4 = 12;
+
+constexpr auto IPv4HeaderLengthOffset = 0;
+constexpr auto TCPFlagsOffset = 13;
+constexpr auto TCPFlagReset = 0x04;
+constexpr auto TCPFlagsSynchroniseAcknowledge = 0x12;
+
+constexpr auto FilterAccept = 0xffffffffu;
+constexpr auto FilterDrop = 0u;
+
+using namespace Nedrysoft::ICMPSocket::BrokerProtocol;
+
+/**
+ * @brief       Returns whether the user that started the helper may use it.
+ *
+ * @details     Must be called before the privileges are dropped, as the supplementary groups are cleared.
+ *
+ * @returns     true if the user is root or a member of PINGNOO_HELPER_GROUP; otherwise false.
+ */
+static auto isPermittedUser() -> bool {
+    if (getuid() == 0) {
+        return true;
+    }
+
+    if (strlen(PINGNOO_HELPER_GROUP) == 0) {
+        return true;
+    }
+
+    auto groupEntry = getgrnam(PINGNOO_HELPER_GROUP);
+
+    if (!groupEntry) {
+        return false;
+    }
+
+    if (getgid() == groupEntry->gr_gid) {
+        return true;
+    }
+
+    auto groupCount = getgroups(0, nullptr);
+
+    if (groupCount <= 0) {
+        return false;
+    }
+
+    auto groups = std::make_unique<gid_t[]>(static_cast<size_t>(groupCount));
+
+    groupCount = getgroups(groupCount, groups.get());
+
+    for (auto index = 0; index < groupCount; index++) {
+        if (groups[index] == groupEntry->gr_gid) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief       Drops every privilege except CAP_NET_RAW if the helper has been installed setuid root.
+ *
+ * @returns     true if the helper is running with no more than the capability it needs; otherwise false.
+ */
+static auto dropPrivileges() -> bool {
+    if ((geteuid() != 0) || (getuid() == 0)) {
+        return true;
+    }
+
+    if (prctl(PR_SET_KEEPCAPS, 1, 0, 0, 0) == -1) {
+        return false;
+    }
+
+    if ((setgroups(0, nullptr) == -1) || (setgid(getgid()) == -1) || (setuid(getuid()) == -1)) {
+        return false;
+    }
+
+    struct __user_cap_header_struct header = {};
+    struct __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3] = {};
+
+    header.version = _LINUX_CAPABILITY_VERSION_3;
+    header.pid = 0;
+
+    data[CAP_TO_INDEX(CAP_NET_RAW)].effective = CAP_TO_MASK(CAP_NET_RAW);
+    data[CAP_TO_INDEX(CAP_NET_RAW)].permitted = CAP_TO_MASK(CAP_NET_RAW);
+
+    return syscall(SYS_capset, &header, data) == 0;
+}
+
+/**
+ * @brief       Attaches a classic BPF program to a socket and locks it.
+ *
+ * @param[in]   socketDescriptor the socket.
+ * @param[in]   program the instructions of the program.
+ * @param[in]   length the number of instructions.
+ *
+ * @returns     true if the program was attached and locked; otherwise false.
+ */
+static auto attachFilter(int socketDescriptor, struct sock_filter *program, unsigned short length) -> bool {
+    struct sock_fprog filterProgram = {};
+
+    filterProgram.len = length;
+    filterProgram.filter = program;
+
+    if (setsockopt(socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &filterProgram, sizeof(filterProgram)) == -1) {
+        return false;
+    }
+
+    auto lockFilter = 1;
+
+    return setsockopt(socketDescriptor, SOL_SOCKET, SO_LOCK_FILTER, &lockFilter, sizeof(lockFilter)) == 0;
+}
+
+/**
+ * @brief       Attaches the default receive filter for the protocol of a socket.
+ *
+ * @details     The BPF filters of send only, UDP and TCP sockets are locked.  ICMP receive sockets are restricted
+ *              with the kernel's ICMP type filter instead, the application attaches (and replaces) its own BPF
+ *              filter to select the identifiers of its probes, so one is not locked on to them here.
+ *
+ * @param[in]   socketDescriptor the socket.
+ * @param[in]   addressFamily the address family of the socket.
+ * @param[in]   protocol the IP protocol of the socket.
+ * @param[in]   sendOnly true if the socket is only used to send.
+ *
+ * @returns     true if the filter was attached; otherwise false.
+ */
+static auto attachDefaultFilter(int socketDescriptor, int addressFamily, int protocol, bool sendOnly) -> bool {
+    if ((sendOnly) || (protocol == IPPROTO_UDP)) {
+        // raw UDP sockets are only used to send probes, the errors they cause are received on the ICMP sockets.
+
+        struct sock_filter dropAll[] = {
+            BPF_STMT(BPF_RET | BPF_K, FilterDrop)
+        };
+
+        return attachFilter(socketDescriptor, dropAll, sizeof(dropAll) / sizeof(dropAll[0]));
+    }
+
+    if (protocol == IPPROTO_ICMP) {
+        // only the replies and errors that a probe can receive are queued on the socket.
+
+        struct icmp_filter filter = {};
+
+        filter.data = ~((1u << ICMPEchoReplyV4) |
+                        (1u << ICMPDestinationUnreachableV4) |
+                        (1u << ICMPTimeExceededV4) |
+                        (1u << ICMPParameterProblemV4));
+
+        return setsockopt(socketDescriptor, SOL_RAW, ICMP_FILTER, &filter, sizeof(filter)) == 0;
+    }
+
+    if (protocol == IPPROTO_ICMPV6) {
+        struct icmp6_filter filter = {};
+
+        ICMP6_FILTER_SETBLOCKALL(&filter);
+        ICMP6_FILTER_SETPASS(ICMP6_ECHO_REPLY, &filter);
+        ICMP6_FILTER_SETPASS(ICMP6_DST_UNREACH, &filter);
+        ICMP6_FILTER_SETPASS(ICMP6_PACKET_TOO_BIG, &filter);
+        ICMP6_FILTER_SETPASS(ICMP6_TIME_EXCEEDED, &filter);
+        ICMP6_FILTER_SETPASS(ICMP6_PARAM_PROB, &filter);
+
+        return setsockopt(socketDescriptor, IPPROTO_ICMPV6, ICMP6_FILTER, &filter, sizeof(filter)) == 0;
+    }
+
+    // a TCP probe is answered by either a reset or a synchronise acknowledge, the IPv4 header is included in the
+    // packet seen by the filter of a raw IPv4 socket but an IPv6 raw socket starts at the TCP header.
+
+    struct sock_filter acceptReplies[] = {
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, IPv4HeaderLengthOffset),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, TCPFlagsOffset),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, TCPFlagReset, 3, 0),
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, TCPFlagsSynchroniseAcknowledge),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, TCPFlagsSynchroniseAcknowledge, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, FilterDrop),
+        BPF_STMT(BPF_RET | BPF_K, FilterAccept)
+    };
+
+    if (addressFamily == AF_INET6) {
+        acceptReplies[0] = BPF_STMT(BPF_LDX | BPF_IMM, 0);
+    }
+
+    return attachFilter(socketDescriptor, acceptReplies, sizeof(acceptReplies) / sizeof(acceptReplies[0]));
+}
+
+/**
+ * @brief       Returns whether a request is for a socket that the helper is permitted to create.
+ *
+ * @param[in]   request the request.
+ *
+ * @returns     true if the request is permitted; otherwise false.
+ */
+static auto isPermitted(const Request &request) -> bool {
+    if ((request.flags & ~SendOnly) != 0) {
+        return false;
+    }
+
+    if ((request.protocol == IPPROTO_UDP) && (!(request.flags & SendOnly))) {
+        return false;
+    }
+
+    if ((request.protocol == IPPROTO_UDP) || (request.protocol == IPPROTO_TCP)) {
+        return (request.addressFamily == AF_INET) || (request.addressFamily == AF_INET6);
+    }
+
+    if (request.addressFamily == AF_INET) {
+        return request.protocol == IPPROTO_ICMP;
+    }
+
+    if (request.addressFamily == AF_INET6) {
+        return request.protocol == IPPROTO_ICMPV6;
+    }
+
+    return false;
+}
+
+/**
+ * @brief       Sends a reply, with the socket attached if one was created.
+ *
+ * @param[in]   socketDescriptor the socket to pass; otherwise -1.
+ * @param[in]   error the error that prevented the socket being created; otherwise 0.
+ *
+ * @returns     true if the reply was sent; otherwise false.
+ */
+static auto sendReply(int socketDescriptor, int error) -> bool {
+    Reply reply = {};
+
+    reply.magic = Magic;
+    reply.error = error;
+
+    struct iovec messageVector = {};
+
+    messageVector.iov_base = &reply;
+    messageVector.iov_len = sizeof(reply);
+
+    struct msghdr message = {};
+
+    message.msg_iov = &messageVector;
+    message.msg_iovlen = 1;
+
+    char controlBuffer[CMSG_SPACE(sizeof(int))] = {};
+
+    if (socketDescriptor != -1) {
+        message.msg_control = controlBuffer;
+        message.msg_controllen = sizeof(controlBuffer);
+
+        auto controlMessage = CMSG_FIRSTHDR(&message);
+
+        controlMessage->cmsg_level = SOL_SOCKET;
+        controlMessage->cmsg_type = SCM_RIGHTS;
+        controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+
+        memcpy(CMSG_DATA(controlMessage), &socketDescriptor, sizeof(int));
+    }
+
+    return sendmsg(HelperDescriptor, &message, MSG_NOSIGNAL) == sizeof(reply);
+}
 
 int main(int argc, char *argv[]) {
-    DBusError err;
-    DBusConnection* conn;
-    int ret;
-    // initialise the errors
-    dbus_error_init(&err);
-
-// connect to the bus
-    conn = dbus_bus_get(DBUS_BUS_SESSION, &err);
-    if (dbus_error_is_set(&err)) {
-        fprintf(stderr, "Connection Error (%s)\n", err.message);
-        dbus_error_free(&err);
-    }
-    if (nullptr == conn) {
+    (void) argc;
+    (void) argv;
+
+    // the helper must not outlive the application that started it.
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    auto socketType = 0;
+    socklen_t socketTypeLength = sizeof(socketType);
+
+    if ((getsockopt(HelperDescriptor, SOL_SOCKET, SO_TYPE, &socketType, &socketTypeLength) == -1) ||
+            (socketType != SOCK_SEQPACKET)) {
+
         return 1;
     }
 
-// request a name on the bus
-    ret = dbus_bus_request_name(conn, "test.method.server",
-                                DBUS_NAME_FLAG_REPLACE_EXISTING
-            , &err);
-    if (dbus_error_is_set(&err)) {
-        fprintf(stderr, "Name Error (%s)\n", err.message);
-        dbus_error_free(&err);
+    if (!isPermittedUser()) {
+        return 1;
     }
-    if (DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER != ret) {
+
+    if (!dropPrivileges()) {
         return 1;
     }
 
+    prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+
+    while (true) {
+        Request request = {};
+
+        auto result = recv(HelperDescriptor, &request, sizeof(request), 0);
+
+        if ((result == -1) && (errno == EINTR)) {
+            continue;
+        }
+
+        if (result <= 0) {
+            break;
+        }
+
+        if ((result != sizeof(request)) || (request.magic != Magic)) {
+            return 1;
+        }
+
+        if (!isPermitted(request)) {
+            if (!sendReply(-1, EPERM)) {
+                break;
+            }
+
+            continue;
+        }
+
+        auto socketDescriptor = socket(request.addressFamily, SOCK_RAW | SOCK_CLOEXEC, request.protocol);
+
+        if (socketDescriptor == -1) {
+            if (!sendReply(-1, errno)) {
+                break;
+            }
+
+            continue;
+        }
+
+        auto sendOnly = (request.flags & SendOnly) != 0;
+
+        if (!attachDefaultFilter(socketDescriptor, request.addressFamily, request.protocol, sendOnly)) {
+            auto error = errno;
+
+            close(socketDescriptor);
+
+            if (!sendReply(-1, error)) {
+                break;
+            }
+
+            continue;
+        }
+
+        auto sent = sendReply(socketDescriptor, 0);
+
+        close(socketDescriptor);
+
+        if (!sent) {
+            break;
+        }
+    }
+
     return 0;
 }
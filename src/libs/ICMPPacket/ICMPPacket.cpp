@@ -23,6 +23,7 @@
 
 #include "ICMPPacket.h"
 
+#include "ICMPPacketCodec.h"
 #include "Utils.h"
 
 #include <array>
@@ -40,33 +41,16 @@
 #include <WS2tcpip.h>
 #endif
 
-#include <QDataStream>
 #include <QtEndian>
-#include <gsl/gsl>
-
-/**
- * @private
- */
-struct ipv6_header {
-    unsigned int version: 4;
-    unsigned int trafficClass: 8;
-    unsigned int flowLabel: 20;
-    uint16_t payloadLength;
-    uint8_t nextHeader;
-    uint8_t hopLimit;
-    uint8_t sourceAddress[16];
-    uint8_t destinationAddress[16];
-};
-
-/**
- * @private
- */
-struct icmp_header {
-    uint8_t type;
-    uint8_t code;
-    uint16_t checksum;
-    uint32_t reserved;
-};
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && ( _M_IX86_FP >= 2 ))
+#define PINGNOO_CHECKSUM_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PINGNOO_CHECKSUM_NEON
+#include <arm_neon.h>
+#endif
 
 /**
  * @private
@@ -88,146 +72,262 @@ struct icmp_v6 {
 };
 
 constexpr auto ICMP6_ECHO = 128;
-constexpr auto ICMP6_ECHO_REPLY = 129;
 
-Nedrysoft::ICMPPacket::ICMPPacket::ICMPPacket() :
-        m_resultCode(Invalid),
-        m_id(0),
-        m_sequence(0),
-        m_ipVersion(Unknown),
-        m_ttl(-1) {
+/**
+ * @private
+ */
+using ChecksumKernel = uint64_t (*)(const uint8_t *data, int length);
+
+/**
+ * @private
+ *
+ * @brief       Adds two partial sums with end around carry.
+ */
+static inline auto addWithCarry(uint64_t sum, uint64_t value) -> uint64_t {
+    sum += value;
+
+    if (sum < value) {
+        sum++;
+    }
 
+    return sum;
 }
 
-Nedrysoft::ICMPPacket::ICMPPacket::ICMPPacket(
-        uint16_t id,
-        uint16_t sequence,
-        ResultCode resultCode,
-        IPVersion ipVersion,
-        int ttl ) :
-            m_resultCode(resultCode),
-            m_id(id),
-            m_sequence(sequence),
-            m_ipVersion(ipVersion),
-            m_ttl(ttl) {
+/**
+ * @private
+ *
+ * @brief       Folds a 64 bit partial sum into the final 16 bit ones complement checksum.
+ */
+static inline auto foldChecksum(uint64_t sum) -> uint16_t {
+    while (sum >> ( sizeof(uint16_t) * CHAR_BIT )) {
+        sum = ( sum >> ( sizeof(uint16_t) * CHAR_BIT )) + ( sum & UINT16_MAX );
+    }
 
+    return static_cast<uint16_t>(~sum);
 }
 
-auto Nedrysoft::ICMPPacket::ICMPPacket::fromData(
-        const QByteArray &dataBuffer,
-        Nedrysoft::ICMPPacket::IPVersion version) -> Nedrysoft::ICMPPacket::ICMPPacket {
+/**
+ * @private
+ *
+ * @brief       Portable kernel, sums 64 bit words with end around carry.
+ *
+ * @details     A trailing odd byte is summed as a word with a zero pad byte after it (RFC 1071), so it is the high
+ *              byte in network order.  The vector kernels finish with this kernel, so they do the same.
+ */
+static auto scalarChecksum(const uint8_t *data, int length) -> uint64_t {
+    uint64_t sum = 0;
 
-    if (version == Nedrysoft::ICMPPacket::V4) {
-        return fromData_v4(dataBuffer);
-    } else if (version == Nedrysoft::ICMPPacket::V6) {
-        return fromData_v6(dataBuffer);
-    } else {
-        return ICMPPacket();
+    while (length >= static_cast<int>(sizeof(uint64_t))) {
+        uint64_t word;
+
+        memcpy(&word, data, sizeof(word));
+
+        sum = addWithCarry(sum, word);
+
+        data += sizeof(uint64_t);
+        length -= sizeof(uint64_t);
     }
-}
 
-auto Nedrysoft::ICMPPacket::ICMPPacket::fromData_v4(const QByteArray &dataBuffer) -> Nedrysoft::ICMPPacket::ICMPPacket {
-    unsigned char ip_vhl;
-    unsigned char ip_vhl_tx;
-    unsigned char ip_header_size;
-    unsigned char ip_header_size_tx;
-    uint16_t received_id;
-    uint16_t received_sequence;
-    constexpr unsigned int IP_HEADER_LENGTH_MASK = 0x0F;
+    while (length >= static_cast<int>(sizeof(uint16_t))) {
+        uint16_t word;
 
-    auto mainSpan = gsl::span<const unsigned char>(
-            reinterpret_cast<const unsigned char *>(dataBuffer.data()),
-            dataBuffer.length() );
+        memcpy(&word, data, sizeof(word));
 
-    ip_vhl = mainSpan[0];
-    ip_header_size = ( ip_vhl & IP_HEADER_LENGTH_MASK ) * sizeof(uint32_t);
+        sum = addWithCarry(sum, word);
 
-    auto responseSpan = mainSpan.subspan(ip_header_size);
+        data += sizeof(uint16_t);
+        length -= sizeof(uint16_t);
+    }
+
+    if (length) {
+        const uint8_t padded[sizeof(uint16_t)] = {*data, 0};
+        uint16_t word;
 
-    auto icmp_response = reinterpret_cast<const struct icmp *>(responseSpan.data());
+        memcpy(&word, padded, sizeof(word));
 
-    if (icmp_response->icmp_code == ICMP_ECHOREPLY) {
-        if (icmp_response->icmp_type == ICMP_ECHOREPLY) {
-            auto ip_response = reinterpret_cast<const struct ip *>(dataBuffer.data());
+        sum = addWithCarry(sum, word);
+    }
 
-            received_id = qFromBigEndian<uint16_t>(icmp_response->icmp_hun.ih_idseq.icd_id);
-            received_sequence = qFromBigEndian<uint16_t>(icmp_response->icmp_hun.ih_idseq.icd_seq);
+    return sum;
+}
 
-            return ICMPPacket(received_id, received_sequence, EchoReply, V4, ip_response->ip_ttl);
+#if defined(PINGNOO_CHECKSUM_SSE2) || defined(PINGNOO_CHECKSUM_NEON)
+/**
+ * @private
+ *
+ * @brief       The number of 16 byte blocks that can be accumulated into 32 bit lanes without overflow.
+ */
+constexpr auto MaximumVectorBlocks = 16384;
+constexpr auto VectorBlockSize = 16;
+#endif
+
+#if defined(PINGNOO_CHECKSUM_SSE2)
+/**
+ * @private
+ *
+ * @brief       SSE2 kernel, widens 16 bit words into four 32 bit accumulators.
+ */
+static auto sse2Checksum(const uint8_t *data, int length) -> uint64_t {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t sum = 0;
+
+    while (length >= VectorBlockSize) {
+        auto blocks = qMin(length / VectorBlockSize, MaximumVectorBlocks);
+        __m128i accumulator = zero;
+
+        for (auto block = 0; block < blocks; block++) {
+            auto words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+
+            accumulator = _mm_add_epi32(accumulator, _mm_unpacklo_epi16(words, zero));
+            accumulator = _mm_add_epi32(accumulator, _mm_unpackhi_epi16(words, zero));
+
+            data += VectorBlockSize;
         }
 
-        if (icmp_response->icmp_type == ICMP_TIMXCEED) {
-            constexpr unsigned int IP_HEADER_OFFSET = 0x08;
+        length -= blocks * VectorBlockSize;
 
-            ip_vhl_tx = mainSpan[ip_header_size + IP_HEADER_OFFSET];
-            ip_header_size_tx = ( ip_vhl_tx & IP_HEADER_LENGTH_MASK ) * sizeof(uint32_t);
+        uint32_t lanes[4];
 
-            auto receivedRequestSpan = mainSpan.subspan(ip_header_size + IP_HEADER_OFFSET + ip_header_size_tx);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), accumulator);
 
-            auto received_icmp_request = reinterpret_cast<const struct icmp *>(receivedRequestSpan.data());
+        sum += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
 
-            received_id = qFromBigEndian<uint16_t>(received_icmp_request->icmp_hun.ih_idseq.icd_id);
+    return addWithCarry(sum, scalarChecksum(data, length));
+}
+#endif
 
-            received_sequence = qFromBigEndian<uint16_t>(received_icmp_request->icmp_hun.ih_idseq.icd_seq);
+#if defined(PINGNOO_CHECKSUM_NEON)
+/**
+ * @private
+ *
+ * @brief       NEON kernel, pairwise accumulates 16 bit words into four 32 bit accumulators.
+ */
+static auto neonChecksum(const uint8_t *data, int length) -> uint64_t {
+    uint64_t sum = 0;
 
-            return ICMPPacket(received_id, received_sequence, TimeExceeded, V4, -1);
+    while (length >= VectorBlockSize) {
+        auto blocks = qMin(length / VectorBlockSize, MaximumVectorBlocks);
+        uint32x4_t accumulator = vdupq_n_u32(0);
+
+        for (auto block = 0; block < blocks; block++) {
+            accumulator = vpadalq_u16(accumulator, vreinterpretq_u16_u8(vld1q_u8(data)));
+
+            data += VectorBlockSize;
         }
+
+        length -= blocks * VectorBlockSize;
+
+        sum += static_cast<uint64_t>(vgetq_lane_u32(accumulator, 0)) +
+               vgetq_lane_u32(accumulator, 1) +
+               vgetq_lane_u32(accumulator, 2) +
+               vgetq_lane_u32(accumulator, 3);
     }
 
-    return ICMPPacket();
+    return addWithCarry(sum, scalarChecksum(data, length));
 }
+#endif
 
-auto Nedrysoft::ICMPPacket::ICMPPacket::fromData_v6(const QByteArray &dataBuffer) -> Nedrysoft::ICMPPacket::ICMPPacket {
-    uint16_t received_id;
-    uint16_t received_sequence;
+/**
+ * @private
+ *
+ * @brief       Selects the fastest checksum kernel supported by the processor.
+ */
+static auto selectChecksumKernel() -> ChecksumKernel {
+#if defined(PINGNOO_CHECKSUM_SSE2)
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+    if (__builtin_cpu_supports("sse2")) {
+        return sse2Checksum;
+    }
+#else
+    return sse2Checksum;
+#endif
+#elif defined(PINGNOO_CHECKSUM_NEON)
+    return neonChecksum;
+#endif
+    return scalarChecksum;
+}
 
-    auto responseSpan = gsl::span<const unsigned char>(
-            reinterpret_cast<const unsigned char *>(dataBuffer.data()),
-            dataBuffer.length() );
+Nedrysoft::ICMPPacket::ICMPPacket::ICMPPacket() :
+        m_resultCode(Invalid),
+        m_id(0),
+        m_sequence(0),
+        m_ipVersion(Unknown),
+        m_ttl(-1),
+        m_transmitTimestamp(-1),
+        m_sampleNumber(0),
+        m_protocol(ICMP) {
 
-    auto icmp_response = reinterpret_cast<const struct icmp *>(responseSpan.data());
+}
 
-    if (icmp_response->icmp_code == 0) {
-        if (icmp_response->icmp_type == ICMP6_ECHO_REPLY) {
-            received_id = qFromBigEndian<uint16_t>(icmp_response->icmp_hun.ih_idseq.icd_id);
-            received_sequence = qFromBigEndian<uint16_t>(icmp_response->icmp_hun.ih_idseq.icd_seq);
+Nedrysoft::ICMPPacket::ICMPPacket::ICMPPacket(
+        uint16_t id,
+        uint16_t sequence,
+        ResultCode resultCode,
+        IPVersion ipVersion,
+        int ttl ) :
+            m_resultCode(resultCode),
+            m_id(id),
+            m_sequence(sequence),
+            m_ipVersion(ipVersion),
+            m_ttl(ttl),
+            m_transmitTimestamp(-1),
+            m_sampleNumber(0),
+            m_protocol(ICMP) {
 
-            return ICMPPacket(received_id, received_sequence, EchoReply, V6, -1);
-        }
+}
 
-        if (icmp_response->icmp_type == 3) {
-            auto ip_response = reinterpret_cast<const struct ipv6_header *>(dataBuffer.data());
-            auto request_icmp_header = responseSpan.subspan(sizeof(icmp_header) + sizeof(ipv6_header));
+auto Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+        const QByteArray &dataBuffer,
+        Nedrysoft::ICMPPacket::IPVersion version,
+        Nedrysoft::ICMPPacket::Protocol protocol) -> Nedrysoft::ICMPPacket::ICMPPacket {
+
+    return fromData(
+        reinterpret_cast<const uint8_t *>(dataBuffer.constData()),
+        static_cast<int>(dataBuffer.length()),
+        version,
+        protocol
+    );
+}
 
-            auto rx_icmp_request = reinterpret_cast<const struct icmp *>(request_icmp_header.data());
+auto Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+        const uint8_t *data,
+        int length,
+        Nedrysoft::ICMPPacket::IPVersion version,
+        Nedrysoft::ICMPPacket::Protocol protocol) -> Nedrysoft::ICMPPacket::ICMPPacket {
 
-            received_id = qFromBigEndian<uint16_t>(rx_icmp_request->icmp_hun.ih_idseq.icd_id);
-            received_sequence = qFromBigEndian<uint16_t>(rx_icmp_request->icmp_hun.ih_idseq.icd_seq);
+    // callers that know the address family up front should use the codec directly, this is the runtime dispatch.
 
-            return ICMPPacket(received_id, received_sequence, TimeExceeded, V6, ip_response->hopLimit);
-        }
+    if (version == Nedrysoft::ICMPPacket::V4) {
+        return Nedrysoft::ICMPPacket::ICMPv4Codec::decode(data, length, protocol);
+    } else if (version == Nedrysoft::ICMPPacket::V6) {
+        return Nedrysoft::ICMPPacket::ICMPv6Codec::decode(data, length, protocol);
+    } else {
+        return ICMPPacket();
     }
-
-    return ICMPPacket();
 }
 
 auto Nedrysoft::ICMPPacket::ICMPPacket::checksum(void *buffer, int length) -> uint16_t {
-    QByteArray dataArray(reinterpret_cast<char *>(buffer), length);
-    QDataStream dataStream(dataArray);
-    uint32_t checksum = 0;
+    static const auto kernel = selectChecksumKernel();
 
-    dataStream.setByteOrder(QDataStream::LittleEndian);
+    if ((!buffer) || (length <= 0)) {
+        return static_cast<uint16_t>(~0);
+    }
 
-    while (!dataStream.atEnd()) {
-        checksum += read<uint16_t>(dataStream);
+    return foldChecksum(kernel(reinterpret_cast<const uint8_t *>(buffer), length));
+}
 
-        length -= 2;
-    }
+auto Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(
+        uint16_t checksum,
+        uint16_t oldValue,
+        uint16_t newValue) -> uint16_t {
+
+    uint64_t sum = static_cast<uint16_t>(~checksum);
 
-    checksum = ( checksum >> ( sizeof(uint16_t) * CHAR_BIT )) + ( checksum & UINT16_MAX );
-    checksum += ( checksum >> ( sizeof(uint16_t) * CHAR_BIT ));
+    sum += static_cast<uint16_t>(~oldValue);
+    sum += newValue;
 
-    return static_cast<uint16_t>(~checksum);
+    return foldChecksum(sum);
 }
 
 auto Nedrysoft::ICMPPacket::ICMPPacket::resultCode() -> Nedrysoft::ICMPPacket::ResultCode {
@@ -250,9 +350,9 @@ auto Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
         Nedrysoft::ICMPPacket::IPVersion version) -> QByteArray {
 
     if (version == Nedrysoft::ICMPPacket::V4) {
-        return pingPacket_v4(id, sequence, payloadLength, destinationAddress);
+        return Nedrysoft::ICMPPacket::ICMPv4Codec::encode(id, sequence, payloadLength, destinationAddress);
     } else if (version == Nedrysoft::ICMPPacket::V6) {
-        return pingPacket_v6(id, sequence, payloadLength, destinationAddress);
+        return Nedrysoft::ICMPPacket::ICMPv6Codec::encode(id, sequence, payloadLength, destinationAddress);
     } else {
         return QByteArray();
     }
@@ -349,6 +449,14 @@ Nedrysoft::ICMPPacket::ICMPPacket::operator std::string() {
             resultCodeString = "Time Exceeded";
             break;
         }
+        case PortUnreachable: {
+            resultCodeString = "Port Unreachable";
+            break;
+        }
+        case ProbeReply: {
+            resultCodeString = "Probe Reply";
+            break;
+        }
 
         default: {
             resultCodeString = QString("Unknown (%1)").arg(m_resultCode);
@@ -367,4 +475,16 @@ Nedrysoft::ICMPPacket::ICMPPacket::operator std::string() {
 
 auto Nedrysoft::ICMPPacket::ICMPPacket::ttl() -> int {
     return m_ttl;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacket::transmitTimestamp() -> qint64 {
+    return m_transmitTimestamp;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacket::sampleNumber() -> uint32_t {
+    return m_sampleNumber;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacket::protocol() -> Nedrysoft::ICMPPacket::Protocol {
+    return m_protocol;
 }
\ No newline at end of file
@@ -26,7 +26,6 @@
 
 #include <QtGlobal>
 
-#include <QDataStream>
 #include <QHostAddress>
 #include <cstdint>
 #include <vector>
@@ -48,12 +47,45 @@ namespace Nedrysoft { namespace ICMPPacket {
         V6 = 6
     };
 
+    /**
+     * @brief       The type of packet that was decoded.
+     *
+     * @details     Every ICMP error quotes the request that caused it, the id and sequence of an error are those of
+     *              the quoted request.
+     */
     enum ResultCode {
         Invalid = 0,
         EchoReply = 1,
-        TimeExceeded = 2
+        TimeExceeded = 2,
+        PortUnreachable = 3,
+        ProbeReply = 4,
+        DestinationUnreachable = 5,
+        AdministrativelyProhibited = 6,
+        PacketTooBig = 7,
+        ParameterProblem = 8
     };
 
+    /**
+     * @brief       The transport protocol of a probe, the values are the IP protocol numbers.
+     */
+    enum Protocol {
+        ICMP = 1,
+        TCP = 6,
+        UDP = 17
+    };
+
+    /**
+     * @brief       The layout of the transmit timestamp that may be embedded at the start of the echo payload.
+     *
+     * @details     The block is a 32 bit magic value, a 32 bit sample number and a 64 bit timestamp in
+     *              nanoseconds, all in network byte order.
+     */
+    constexpr uint32_t EmbeddedTimestampMagic = 0x504e474f;
+    constexpr int EmbeddedTimestampLength = 16;
+
+    template <IPVersion Version>
+    class ICMPPacketCodec;
+
     /**
      * @brief       THe ICMPPacket class provides functions to decode and encode ICMP packets.
      */
@@ -64,14 +96,47 @@ namespace Nedrysoft { namespace ICMPPacket {
              *
              * @param[in]   dataBuffer the raw icmp packet.
              * @param[in]   version version of ICMP packet we are expecting.
+             * @param[in]   protocol the protocol of the socket that the packet was received on.
+             *
+             * @returns     the decoded packet.
+             */
+            static auto fromData(
+                const QByteArray &dataBuffer,
+                IPVersion version,
+                Protocol protocol = ICMP
+            ) -> ICMPPacket;
+
+            /**
+             * @brief       Creates an ICMP packet from a non-owning view of raw data.
+             *
+             * @details     The headers are decoded in place, only the id, sequence, type and ttl are extracted, no
+             *              copies or allocations are made.  Truncated packets are reported as Invalid.
+             *
+             *              ICMP errors that quote a UDP or TCP probe are decoded with the source port as the id, for
+             *              UDP the sequence is carried in the checksum and for TCP in the low 16 bits of the
+             *              sequence number.  Packets received on a TCP socket are decoded as probe replies.
+             *
+             * @param[in]   data a pointer to the raw icmp packet.
+             * @param[in]   length the number of bytes available at data.
+             * @param[in]   version version of ICMP packet we are expecting.
+             * @param[in]   protocol the protocol of the socket that the packet was received on.
              *
              * @returns     the decoded packet.
              */
-            static auto fromData(const QByteArray &dataBuffer, IPVersion version) -> ICMPPacket;
+            static auto fromData(
+                const uint8_t *data,
+                int length,
+                IPVersion version,
+                Protocol protocol = ICMP
+            ) -> ICMPPacket;
 
             /**
              * @brief       Calculate ICMP crc16 from raw data.
              *
+             * @details     The sum is computed 64 bits at a time, an SSE2 or NEON kernel is selected at runtime when
+             *              the processor supports it.  A trailing odd byte is padded with a zero byte to make
+             *              the last word, as RFC 1071 requires.
+             *
              * @param[in]   buffer the raw icmp packet.
              * @param[in]   length the length of the packet.
              *
@@ -79,6 +144,21 @@ namespace Nedrysoft { namespace ICMPPacket {
              */
             static auto checksum(void *buffer, int length) -> uint16_t;
 
+            /**
+             * @brief       Incrementally updates a checksum after a 16 bit field of the packet has changed.
+             *
+             * @details     Implements RFC 1624, this allows a prebuilt packet to be reused with a new id or sequence
+             *              without recalculating the checksum over the whole packet.  The values must be given
+             *              exactly as they are stored in the packet (i.e in network byte order).
+             *
+             * @param[in]   checksum the current checksum of the packet.
+             * @param[in]   oldValue the previous value of the field.
+             * @param[in]   newValue the new value of the field.
+             *
+             * @returns     the updated checksum.
+             */
+            static auto updateChecksum(uint16_t checksum, uint16_t oldValue, uint16_t newValue) -> uint16_t;
+
             /**
              * @brief       Create a ping request packet.
              *
@@ -128,6 +208,30 @@ namespace Nedrysoft { namespace ICMPPacket {
              */
             auto ttl() -> int;
 
+            /**
+             * @brief       The transmit timestamp embedded in the echo payload.
+             *
+             * @details     For echo replies the payload is echoed back, for time exceeded messages the timestamp is
+             *              only available if the router quoted enough of the original request.
+             *
+             * @returns     the timestamp in nanoseconds if present; otherwise -1.
+             */
+            auto transmitTimestamp() -> qint64;
+
+            /**
+             * @brief       The sample number embedded in the echo payload.
+             *
+             * @returns     the sample number, only valid if transmitTimestamp() is not -1.
+             */
+            auto sampleNumber() -> uint32_t;
+
+            /**
+             * @brief       The protocol of the request that this packet is a response to.
+             *
+             * @returns     the protocol of the request.
+             */
+            auto protocol() -> Protocol;
+
             /**
              * @brief       Cast to std::string operator.
              *
@@ -152,24 +256,6 @@ namespace Nedrysoft { namespace ICMPPacket {
              */
             ICMPPacket(uint16_t id, uint16_t sequence, ResultCode resultCode, IPVersion ipVersion, int ttl);
 
-            /**
-             * @brief       Decodes an ipv4 icmp packet for from raw data.
-             *
-             * @param[in]   dataBuffer the raw data.
-             *
-             * @returns     the decoded icmp packet.
-             */
-            static auto fromData_v4(const QByteArray &dataBuffer) -> ICMPPacket;
-
-            /**
-             * @brief       Decodes a ipv6 icmp packet for from raw data.
-             *
-             * @param[in]   dataBuffer the raw data.
-             *
-             * @returns     the decoded icmp packet.
-             */
-            static auto fromData_v6(const QByteArray &dataBuffer) -> ICMPPacket;
-
             /**
              * @brief       Creates an ipv6 icmp packet.
              *
@@ -204,26 +290,20 @@ namespace Nedrysoft { namespace ICMPPacket {
                 const QHostAddress &destinationAddress
             ) -> QByteArray;
 
-            /**
-             * @brief       Template to read raw data from a data stream.
-             */
-            template<class T>
-            static auto read(QDataStream &dataStream) -> T {
-                T data;
-
-                dataStream >> data;
-
-                return data;
-            }
-
         private:
             //! @cond
 
+            template <IPVersion Version>
+            friend class ICMPPacketCodec;
+
             ResultCode m_resultCode;
             uint16_t m_id;
             uint16_t m_sequence;
             IPVersion m_ipVersion;
             int m_ttl;
+            qint64 m_transmitTimestamp;
+            uint32_t m_sampleNumber;
+            Protocol m_protocol;
 
             //! @endcond
     };
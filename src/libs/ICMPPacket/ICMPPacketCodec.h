@@ -0,0 +1,496 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPPACKET_ICMPPACKETCODEC_H
+#define NEDRYSOFT_ICMPPACKET_ICMPPACKETCODEC_H
+
+#include "ICMPPacket.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <climits>
+#include <cstdint>
+
+namespace Nedrysoft { namespace ICMPPacket {
+    /**
+     * @brief       The wire layout of the packets received on a raw socket of the given address family.
+     */
+    template <IPVersion Version>
+    struct ICMPPacketLayout;
+
+    /**
+     * @brief       The ICMPv4 layout, raw IPv4 sockets deliver the IP header in front of the ICMP header.
+     */
+    template <>
+    struct ICMPPacketLayout<V4> {
+        static constexpr bool hasIPHeader = true;
+        static constexpr int minimumIPHeaderLength = 20;
+        static constexpr int ttlOffset = 8;
+        static constexpr int protocolOffset = 9;
+        static constexpr uint8_t echoReply = 0;
+        static constexpr uint8_t destinationUnreachable = 3;
+        static constexpr uint8_t timeExceeded = 11;
+        static constexpr uint8_t parameterProblem = 12;
+        static constexpr uint8_t portUnreachable = 3;
+        static constexpr uint8_t fragmentationNeeded = 4;
+        static constexpr uint8_t networkProhibited = 9;
+        static constexpr uint8_t hostProhibited = 10;
+        static constexpr uint8_t communicationProhibited = 13;
+    };
+
+    /**
+     * @brief       The ICMPv6 layout, raw IPv6 sockets start at the ICMPv6 header so the hop limit is not available.
+     */
+    template <>
+    struct ICMPPacketLayout<V6> {
+        static constexpr bool hasIPHeader = false;
+        static constexpr int quotedIPHeaderLength = 40;
+        static constexpr int nextHeaderOffset = 6;
+        static constexpr uint8_t echoReply = 129;
+        static constexpr uint8_t destinationUnreachable = 1;
+        static constexpr uint8_t packetTooBig = 2;
+        static constexpr uint8_t timeExceeded = 3;
+        static constexpr uint8_t parameterProblem = 4;
+        static constexpr uint8_t administrativelyProhibited = 1;
+        static constexpr uint8_t portUnreachable = 4;
+        static constexpr uint8_t policyFailed = 5;
+        static constexpr uint8_t rejectRoute = 6;
+    };
+
+    /**
+     * @brief       The ICMPPacketCodec class provides an ICMP encoder/decoder specialised on the address family.
+     *
+     * @details     The header layouts are compile time constants and the byte swaps are built from shifts the
+     *              compiler folds into a single load, so the decoder has no branches on the address family and
+     *              can be inlined into the receive loop.  ICMPPacket::fromData() and ICMPPacket::pingPacket()
+     *              dispatch to the same code for callers that only know the version at runtime.
+     */
+    template <IPVersion Version>
+    class ICMPPacketCodec {
+        static_assert(( Version == V4 ) || ( Version == V6 ), "the codec is only available for IPv4 and IPv6.");
+
+        using Layout = ICMPPacketLayout<Version>;
+
+        public:
+            static constexpr IPVersion version = Version;
+
+            /**
+             * @brief       Decodes a packet received on a raw socket of this address family.
+             *
+             * @param[in]   data a pointer to the raw packet.
+             * @param[in]   length the number of bytes available at data.
+             * @param[in]   protocol the protocol of the socket that the packet was received on.
+             *
+             * @returns     the decoded packet.
+             */
+            static inline auto decode(const uint8_t *data, int length, Protocol protocol = ICMP) -> ICMPPacket {
+                if ((!data) || (length <= 0)) {
+                    return ICMPPacket();
+                }
+
+                if (protocol == TCP) {
+                    return decodeTcp(data, length);
+                }
+
+                if (protocol != ICMP) {
+                    return ICMPPacket();
+                }
+
+                return decodeIcmp(data, length);
+            }
+
+            /**
+             * @brief       Decodes a packet received on a raw socket of this address family.
+             *
+             * @param[in]   dataBuffer the raw packet.
+             * @param[in]   protocol the protocol of the socket that the packet was received on.
+             *
+             * @returns     the decoded packet.
+             */
+            static inline auto decode(const QByteArray &dataBuffer, Protocol protocol = ICMP) -> ICMPPacket {
+                return decode(
+                    reinterpret_cast<const uint8_t *>(dataBuffer.constData()),
+                    static_cast<int>(dataBuffer.length()),
+                    protocol
+                );
+            }
+
+            /**
+             * @brief       Creates an echo request for this address family.
+             *
+             * @param[in]   id the packet id.
+             * @param[in]   sequence the packet sequence.
+             * @param[in]   payloadLength the length of the payload.
+             * @param[in]   destinationAddress the address of the target.
+             *
+             * @returns     a QByteArray containing the created raw packet.
+             */
+            static inline auto encode(
+                    uint16_t id,
+                    uint16_t sequence,
+                    int payloadLength,
+                    const QHostAddress &destinationAddress ) -> QByteArray {
+
+                if constexpr (Version == V4) {
+                    return ICMPPacket::pingPacket_v4(id, sequence, payloadLength, destinationAddress);
+                } else {
+                    return ICMPPacket::pingPacket_v6(id, sequence, payloadLength, destinationAddress);
+                }
+            }
+
+        private:
+            //! @cond
+
+            static constexpr int ICMPHeaderLength = 8;
+            static constexpr int ICMPTypeOffset = 0;
+            static constexpr int ICMPCodeOffset = 1;
+            static constexpr int ICMPIdOffset = 4;
+            static constexpr int ICMPSequenceOffset = 6;
+            static constexpr int IPHeaderLengthMask = 0x0F;
+            static constexpr int TransportSourcePortOffset = 0;
+            static constexpr int TransportDestinationPortOffset = 2;
+            static constexpr int TransportQuotedLength = 8;
+            static constexpr int UDPChecksumOffset = 6;
+            static constexpr int TCPSequenceLowOffset = 6;
+            static constexpr int TCPAcknowledgementOffset = 8;
+            static constexpr int TCPFlagsOffset = 13;
+            static constexpr int TCPMinimumHeaderLength = 20;
+            static constexpr uint8_t TCPFlagSyn = 0x02;
+            static constexpr uint8_t TCPFlagRst = 0x04;
+            static constexpr uint8_t TCPFlagAck = 0x10;
+            static constexpr int EmbeddedMagicOffset = 0;
+            static constexpr int EmbeddedSampleNumberOffset = 4;
+            static constexpr int EmbeddedTimestampOffset = 8;
+
+            //! @endcond
+
+            /**
+             * @brief       Reads a 16 bit big endian value.
+             */
+            static constexpr auto read16(const uint8_t *data) -> uint16_t {
+                return static_cast<uint16_t>(( data[0] << CHAR_BIT ) | data[1]);
+            }
+
+            /**
+             * @brief       Reads a 32 bit big endian value.
+             */
+            static constexpr auto read32(const uint8_t *data) -> uint32_t {
+                return ( static_cast<uint32_t>(read16(data)) << ( sizeof(uint16_t) * CHAR_BIT )) | read16(data + 2);
+            }
+
+            /**
+             * @brief       Reads a 64 bit big endian value.
+             */
+            static constexpr auto read64(const uint8_t *data) -> uint64_t {
+                return ( static_cast<uint64_t>(read32(data)) << ( sizeof(uint32_t) * CHAR_BIT )) | read32(data + 4);
+            }
+
+            /**
+             * @brief       Returns the length of the IP header at the start of the packet, 0 if there is none.
+             */
+            static constexpr auto ipHeaderLength(const uint8_t *data) -> int {
+                if constexpr (Layout::hasIPHeader) {
+                    return ( data[0] & IPHeaderLengthMask ) * static_cast<int>(sizeof(uint32_t));
+                } else {
+                    return 0;
+                }
+            }
+
+            /**
+             * @brief       Returns the ttl of the packet if the IP header was delivered; otherwise -1.
+             */
+            static constexpr auto ttl(const uint8_t *data) -> int {
+                if constexpr (Layout::hasIPHeader) {
+                    return data[Layout::ttlOffset];
+                } else {
+                    return -1;
+                }
+            }
+
+            /**
+             * @brief       Maps the type and code of an ICMP error to a result code, Invalid if not an error.
+             */
+            static constexpr auto errorCode(uint8_t type, uint8_t code) -> ResultCode {
+                if ((type == Layout::timeExceeded) && (code == 0)) {
+                    return TimeExceeded;
+                }
+
+                if (type == Layout::parameterProblem) {
+                    return ParameterProblem;
+                }
+
+                if constexpr (Version == V4) {
+                    if (type == Layout::destinationUnreachable) {
+                        switch (code) {
+                            case Layout::portUnreachable: {
+                                return PortUnreachable;
+                            }
+
+                            case Layout::fragmentationNeeded: {
+                                return PacketTooBig;
+                            }
+
+                            case Layout::networkProhibited:
+                            case Layout::hostProhibited:
+                            case Layout::communicationProhibited: {
+                                return AdministrativelyProhibited;
+                            }
+
+                            default: {
+                                return DestinationUnreachable;
+                            }
+                        }
+                    }
+                } else {
+                    if (type == Layout::destinationUnreachable) {
+                        switch (code) {
+                            case Layout::portUnreachable: {
+                                return PortUnreachable;
+                            }
+
+                            case Layout::administrativelyProhibited:
+                            case Layout::policyFailed:
+                            case Layout::rejectRoute: {
+                                return AdministrativelyProhibited;
+                            }
+
+                            default: {
+                                return DestinationUnreachable;
+                            }
+                        }
+                    }
+
+                    if (type == Layout::packetTooBig) {
+                        return PacketTooBig;
+                    }
+                }
+
+                return Invalid;
+            }
+
+            /**
+             * @brief       Decodes the embedded transmit timestamp from an echo payload if present.
+             */
+            static inline auto decodeEmbeddedTimestamp(ICMPPacket &packet, const uint8_t *payload, int length) -> void {
+                if (length < EmbeddedTimestampLength) {
+                    return;
+                }
+
+                if (read32(payload + EmbeddedMagicOffset) != EmbeddedTimestampMagic) {
+                    return;
+                }
+
+                packet.m_sampleNumber = read32(payload + EmbeddedSampleNumberOffset);
+                packet.m_transmitTimestamp = static_cast<qint64>(read64(payload + EmbeddedTimestampOffset));
+            }
+
+            /**
+             * @brief       Decodes an echo reply or ICMP error.
+             */
+            static inline auto decodeIcmp(const uint8_t *data, int length) -> ICMPPacket {
+                if constexpr (Layout::hasIPHeader) {
+                    if (length < Layout::minimumIPHeaderLength) {
+                        return ICMPPacket();
+                    }
+                }
+
+                auto headerLength = ipHeaderLength(data);
+
+                if (length < headerLength + ICMPHeaderLength) {
+                    return ICMPPacket();
+                }
+
+                auto icmpHeader = data + headerLength;
+                auto icmpType = icmpHeader[ICMPTypeOffset];
+                auto icmpCode = icmpHeader[ICMPCodeOffset];
+
+                if ((icmpType == Layout::echoReply) && (icmpCode == 0)) {
+                    auto packet = ICMPPacket(
+                        read16(icmpHeader + ICMPIdOffset),
+                        read16(icmpHeader + ICMPSequenceOffset),
+                        EchoReply,
+                        Version,
+                        ttl(data)
+                    );
+
+                    decodeEmbeddedTimestamp(
+                        packet,
+                        icmpHeader + ICMPHeaderLength,
+                        length - headerLength - ICMPHeaderLength
+                    );
+
+                    return packet;
+                }
+
+                // every error quotes the request in the same place, so they are all matched to the request that
+                // caused them.
+
+                auto resultCode = errorCode(icmpType, icmpCode);
+
+                if (resultCode == Invalid) {
+                    return ICMPPacket();
+                }
+
+                auto requestIpHeader = icmpHeader + ICMPHeaderLength;
+                auto requestOffset = headerLength + ICMPHeaderLength;
+                auto requestProtocol = ICMP;
+
+                if constexpr (Layout::hasIPHeader) {
+                    if (length < requestOffset + Layout::minimumIPHeaderLength) {
+                        return ICMPPacket();
+                    }
+
+                    requestOffset += ipHeaderLength(requestIpHeader);
+                    requestProtocol = static_cast<Protocol>(requestIpHeader[Layout::protocolOffset]);
+                } else {
+                    requestOffset += Layout::quotedIPHeaderLength;
+                }
+
+                if (length < requestOffset + TransportQuotedLength) {
+                    return ICMPPacket();
+                }
+
+                if constexpr (!Layout::hasIPHeader) {
+                    requestProtocol = static_cast<Protocol>(requestIpHeader[Layout::nextHeaderOffset]);
+                }
+
+                return decodeRequest(data + requestOffset, length - requestOffset, requestProtocol, resultCode);
+            }
+
+            /**
+             * @brief       Decodes the request quoted in an ICMP error message.
+             */
+            static inline auto decodeRequest(
+                    const uint8_t *request,
+                    int length,
+                    Protocol protocol,
+                    ResultCode resultCode ) -> ICMPPacket {
+
+                // routers are only required to quote the first 8 bytes of the request, which is enough to hold the
+                // id and sequence of an echo request and the ports and checksum (or sequence number) of a UDP or
+                // TCP probe.
+
+                ICMPPacket packet;
+
+                switch (protocol) {
+                    case ICMP: {
+                        if (resultCode == PortUnreachable) {
+                            return ICMPPacket();
+                        }
+
+                        packet = ICMPPacket(
+                            read16(request + ICMPIdOffset),
+                            read16(request + ICMPSequenceOffset),
+                            resultCode,
+                            Version,
+                            -1
+                        );
+
+                        decodeEmbeddedTimestamp(packet, request + ICMPHeaderLength, length - ICMPHeaderLength);
+
+                        break;
+                    }
+
+                    case UDP: {
+                        packet = ICMPPacket(
+                            read16(request + TransportSourcePortOffset),
+                            read16(request + UDPChecksumOffset),
+                            resultCode,
+                            Version,
+                            -1
+                        );
+
+                        break;
+                    }
+
+                    case TCP: {
+                        if (resultCode == PortUnreachable) {
+                            return ICMPPacket();
+                        }
+
+                        packet = ICMPPacket(
+                            read16(request + TransportSourcePortOffset),
+                            read16(request + TCPSequenceLowOffset),
+                            resultCode,
+                            Version,
+                            -1
+                        );
+
+                        break;
+                    }
+
+                    default: {
+                        return ICMPPacket();
+                    }
+                }
+
+                packet.m_protocol = protocol;
+
+                return packet;
+            }
+
+            /**
+             * @brief       Decodes a TCP response to a SYN probe.
+             */
+            static inline auto decodeTcp(const uint8_t *data, int length) -> ICMPPacket {
+                if constexpr (Layout::hasIPHeader) {
+                    if (length < Layout::minimumIPHeaderLength) {
+                        return ICMPPacket();
+                    }
+                }
+
+                auto headerLength = ipHeaderLength(data);
+
+                if (length < headerLength + TCPMinimumHeaderLength) {
+                    return ICMPPacket();
+                }
+
+                auto tcpHeader = data + headerLength;
+                auto flags = tcpHeader[TCPFlagsOffset];
+
+                // a SYN-ACK means the port is open and a RST-ACK that it is closed, either way the destination
+                // answered the SYN, which is acknowledged with the probe's sequence number plus one.
+
+                if ((!(flags & TCPFlagAck)) || (!(flags & (TCPFlagSyn | TCPFlagRst)))) {
+                    return ICMPPacket();
+                }
+
+                auto packet = ICMPPacket(
+                    read16(tcpHeader + TransportDestinationPortOffset),
+                    static_cast<uint16_t>(read32(tcpHeader + TCPAcknowledgementOffset) - 1),
+                    ProbeReply,
+                    Version,
+                    ttl(data)
+                );
+
+                packet.m_protocol = TCP;
+
+                return packet;
+            }
+    };
+
+    using ICMPv4Codec = ICMPPacketCodec<V4>;
+    using ICMPv6Codec = ICMPPacketCodec<V6>;
+}}
+
+#endif // NEDRYSOFT_ICMPPACKET_ICMPPACKETCODEC_H
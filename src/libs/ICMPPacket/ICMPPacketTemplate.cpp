@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPPacketTemplate.h"
+
+#include <QtEndian>
+#include <cstring>
+
+constexpr auto ICMPChecksumOffset = 2;
+constexpr auto ICMPIdOffset = 4;
+constexpr auto ICMPSequenceOffset = 6;
+constexpr auto ICMPHeaderLength = 8;
+
+Nedrysoft::ICMPPacket::ICMPPacketTemplate::ICMPPacketTemplate() :
+        m_flowChecksum(-1) {
+
+}
+
+Nedrysoft::ICMPPacket::ICMPPacketTemplate::ICMPPacketTemplate(
+        uint16_t id,
+        int payloadLength,
+        const QHostAddress &destinationAddress,
+        Nedrysoft::ICMPPacket::IPVersion version) :
+
+            m_packet(Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+                id,
+                0,
+                payloadLength,
+                destinationAddress,
+                version )),
+            m_flowChecksum(-1) {
+
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::isValid() const -> bool {
+    return m_packet.length() >= ICMPHeaderLength;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::setFlowChecksum(int checksum) -> void {
+    m_flowChecksum = checksum;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::flowChecksum() const -> int {
+    return m_flowChecksum;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::packet(uint16_t id, uint16_t sequence) const -> QByteArray {
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    auto buffer = m_packet;
+
+    stamp(buffer, id, sequence);
+
+    if (m_flowChecksum != -1) {
+        balance(buffer, static_cast<uint16_t>(m_flowChecksum));
+    }
+
+    return buffer;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::packet(
+        uint16_t id,
+        uint16_t sequence,
+        qint64 timestamp,
+        uint32_t sampleNumber) const -> QByteArray {
+
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    auto buffer = m_packet;
+
+    stamp(buffer, id, sequence);
+    stampTimestamp(buffer, timestamp, sampleNumber);
+
+    if (m_flowChecksum != -1) {
+        balance(buffer, static_cast<uint16_t>(m_flowChecksum));
+    }
+
+    return buffer;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::stamp(QByteArray &buffer, uint16_t id, uint16_t sequence) -> void {
+    if (buffer.length() < ICMPHeaderLength) {
+        return;
+    }
+
+    auto data = buffer.data();
+
+    uint16_t checksum, oldValue;
+    uint16_t newId = qToBigEndian<uint16_t>(id);
+    uint16_t newSequence = qToBigEndian<uint16_t>(sequence);
+
+    memcpy(&checksum, data + ICMPChecksumOffset, sizeof(checksum));
+
+    memcpy(&oldValue, data + ICMPIdOffset, sizeof(oldValue));
+    checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, newId);
+
+    memcpy(&oldValue, data + ICMPSequenceOffset, sizeof(oldValue));
+    checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, newSequence);
+
+    memcpy(data + ICMPIdOffset, &newId, sizeof(newId));
+    memcpy(data + ICMPSequenceOffset, &newSequence, sizeof(newSequence));
+    memcpy(data + ICMPChecksumOffset, &checksum, sizeof(checksum));
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::stampTimestamp(
+        QByteArray &buffer,
+        qint64 timestamp,
+        uint32_t sampleNumber) -> bool {
+
+    if (buffer.length() < ICMPHeaderLength + Nedrysoft::ICMPPacket::EmbeddedTimestampLength) {
+        return false;
+    }
+
+    auto data = buffer.data();
+
+    uint8_t block[Nedrysoft::ICMPPacket::EmbeddedTimestampLength];
+    uint16_t checksum;
+
+    qToBigEndian<uint32_t>(Nedrysoft::ICMPPacket::EmbeddedTimestampMagic, block);
+    qToBigEndian<uint32_t>(sampleNumber, block + sizeof(uint32_t));
+    qToBigEndian<qint64>(timestamp, block + sizeof(uint32_t) * 2);
+
+    memcpy(&checksum, data + ICMPChecksumOffset, sizeof(checksum));
+
+    for (auto offset = 0; offset < Nedrysoft::ICMPPacket::EmbeddedTimestampLength; offset += sizeof(uint16_t)) {
+        uint16_t oldValue, newValue;
+
+        memcpy(&oldValue, data + ICMPHeaderLength + offset, sizeof(oldValue));
+        memcpy(&newValue, block + offset, sizeof(newValue));
+
+        checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, newValue);
+    }
+
+    memcpy(data + ICMPHeaderLength, block, sizeof(block));
+    memcpy(data + ICMPChecksumOffset, &checksum, sizeof(checksum));
+
+    return true;
+}
+
+auto Nedrysoft::ICMPPacket::ICMPPacketTemplate::balance(QByteArray &buffer, uint16_t checksum) -> bool {
+    auto offset = ICMPHeaderLength + Nedrysoft::ICMPPacket::EmbeddedTimestampLength;
+
+    if (buffer.length() < offset) {
+        offset = ICMPHeaderLength;
+    }
+
+    if (buffer.length() < offset + static_cast<int>(sizeof(uint16_t))) {
+        return false;
+    }
+
+    auto data = buffer.data();
+
+    uint16_t currentChecksum, oldValue;
+    uint16_t newChecksum = qToBigEndian<uint16_t>(checksum);
+
+    memcpy(&currentChecksum, data + ICMPChecksumOffset, sizeof(currentChecksum));
+    memcpy(&oldValue, data + offset, sizeof(oldValue));
+
+    // from RFC 1624, changing a word from m to m' gives ~HC' = ~HC + ~m + m', so to reach the wanted checksum the
+    // word becomes m' = ~HC' - ~HC + m, which in one's complement arithmetic is ~HC' + HC + m.
+
+    uint32_t sum = static_cast<uint16_t>(~newChecksum);
+
+    sum += currentChecksum;
+    sum += oldValue;
+
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    auto newValue = static_cast<uint16_t>(sum);
+
+    memcpy(data + offset, &newValue, sizeof(newValue));
+    memcpy(data + ICMPChecksumOffset, &newChecksum, sizeof(newChecksum));
+
+    return true;
+}
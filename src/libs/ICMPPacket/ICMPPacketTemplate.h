@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPPACKET_ICMPPACKETTEMPLATE_H
+#define NEDRYSOFT_ICMPPACKET_ICMPPACKETTEMPLATE_H
+
+#include "ICMPPacket.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <cstdint>
+
+namespace Nedrysoft { namespace ICMPPacket {
+    /**
+     * @brief       The ICMPPacketTemplate class provides a prebuilt echo request.
+     *
+     * @details     The echo request (including payload and checksum) is built once, each packet generated from
+     *              the template is a copy of the prebuilt packet with the id and sequence fields stamped in and
+     *              the checksum adjusted incrementally.
+     *
+     *              If a flow checksum is set then a word of the payload is adjusted so that every packet created
+     *              has the same checksum, routers that balance ICMP across equal cost paths hash on the first
+     *              4 bytes of the header, so all packets from the template then follow the same path.
+     */
+    class NEDRYSOFT_ICMPPACKET_DLLSPEC ICMPPacketTemplate {
+        public:
+            /**
+             * @brief       Constructs an empty (invalid) ICMPPacketTemplate.
+             */
+            ICMPPacketTemplate();
+
+            /**
+             * @brief       Constructs an ICMPPacketTemplate for the given destination.
+             *
+             * @param[in]   id the initial id of the packet.
+             * @param[in]   payloadLength the length of the payload.
+             * @param[in]   destinationAddress the address of the target.
+             * @param[in]   version the ip version of the icmp packet.
+             */
+            ICMPPacketTemplate(
+                uint16_t id,
+                int payloadLength,
+                const QHostAddress &destinationAddress,
+                Nedrysoft::ICMPPacket::IPVersion version
+            );
+
+            /**
+             * @brief       Returns whether the template contains a packet.
+             *
+             * @returns     true if valid; otherwise false.
+             */
+            auto isValid() const -> bool;
+
+            /**
+             * @brief       Sets the checksum that every packet created from the template will carry.
+             *
+             * @param[in]   checksum the flow checksum; otherwise -1 to allow the checksum to vary.
+             */
+            auto setFlowChecksum(int checksum) -> void;
+
+            /**
+             * @brief       Returns the flow checksum.
+             *
+             * @returns     the flow checksum; otherwise -1 if not set.
+             */
+            auto flowChecksum() const -> int;
+
+            /**
+             * @brief       Creates an echo request from the template.
+             *
+             * @param[in]   id the id to stamp into the packet.
+             * @param[in]   sequence the sequence to stamp into the packet.
+             *
+             * @returns     a QByteArray containing the raw packet.
+             */
+            auto packet(uint16_t id, uint16_t sequence) const -> QByteArray;
+
+            /**
+             * @brief       Creates an echo request from the template with an embedded transmit timestamp.
+             *
+             * @details     If the payload is too small to hold the timestamp block then the packet is created
+             *              without it.
+             *
+             * @param[in]   id the id to stamp into the packet.
+             * @param[in]   sequence the sequence to stamp into the packet.
+             * @param[in]   timestamp the transmit timestamp in nanoseconds.
+             * @param[in]   sampleNumber the sample number of the request.
+             *
+             * @returns     a QByteArray containing the raw packet.
+             */
+            auto packet(uint16_t id, uint16_t sequence, qint64 timestamp, uint32_t sampleNumber) const -> QByteArray;
+
+            /**
+             * @brief       Stamps the id and sequence into a packet created from this template.
+             *
+             * @details     The buffer must already contain a packet created from this template, the checksum is
+             *              adjusted incrementally for the new values.
+             *
+             * @param[in,out]   buffer the packet to modify.
+             * @param[in]       id the id to stamp into the packet.
+             * @param[in]       sequence the sequence to stamp into the packet.
+             */
+            static auto stamp(QByteArray &buffer, uint16_t id, uint16_t sequence) -> void;
+
+            /**
+             * @brief       Stamps the transmit timestamp and sample number into the payload of a packet.
+             *
+             * @details     The timestamp block is written at the start of the payload and the checksum is adjusted
+             *              incrementally for each modified word.
+             *
+             * @param[in,out]   buffer the packet to modify.
+             * @param[in]       timestamp the transmit timestamp in nanoseconds.
+             * @param[in]       sampleNumber the sample number of the request.
+             *
+             * @returns     true if the payload was large enough to hold the timestamp; otherwise false.
+             */
+            static auto stampTimestamp(QByteArray &buffer, qint64 timestamp, uint32_t sampleNumber) -> bool;
+
+            /**
+             * @brief       Adjusts the payload of a packet so that it carries the given checksum.
+             *
+             * @details     The word following the embedded timestamp block (or the first word of a payload too
+             *              small to hold the block) is modified, this must be the last change made to the packet.
+             *
+             * @param[in,out]   buffer the packet to modify.
+             * @param[in]       checksum the checksum that the packet should carry.
+             *
+             * @returns     true if the payload was large enough to be adjusted; otherwise false.
+             */
+            static auto balance(QByteArray &buffer, uint16_t checksum) -> bool;
+
+        private:
+            //! @cond
+
+            QByteArray m_packet;
+            int m_flowChecksum;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPPACKET_ICMPPACKETTEMPLATE_H
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProbePacketTemplate.h"
+
+#include <QtEndian>
+#include <cstring>
+
+constexpr auto UDPHeaderLength = 8;
+constexpr auto UDPLengthOffset = 4;
+constexpr auto UDPChecksumOffset = 6;
+constexpr auto TCPHeaderLength = 20;
+constexpr auto TCPSequenceLowOffset = 6;
+constexpr auto TCPDataOffsetOffset = 12;
+constexpr auto TCPFlagsOffset = 13;
+constexpr auto TCPWindowOffset = 14;
+constexpr auto TCPChecksumOffset = 16;
+constexpr auto TCPFlagSyn = 0x02;
+constexpr auto TCPWindowSize = 65535;
+constexpr auto IPv4AddressLength = 4;
+constexpr auto IPv6AddressLength = 16;
+
+/**
+ * @brief       Folds a 32 bit one's complement sum to 16 bits.
+ *
+ * @param[in]   sum the sum to fold.
+ *
+ * @returns     the folded sum.
+ */
+static auto fold(uint32_t sum) -> uint16_t {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return static_cast<uint16_t>(sum);
+}
+
+/**
+ * @brief       Builds the pseudo header that is included in the UDP and TCP checksums.
+ *
+ * @param[in]   protocol the transport protocol.
+ * @param[in]   length the length of the transport packet.
+ * @param[in]   sourceAddress the address of the sender.
+ * @param[in]   destinationAddress the address of the target.
+ * @param[in]   version the ip version.
+ *
+ * @returns     the pseudo header in network byte order.
+ */
+static auto pseudoHeader(
+        Nedrysoft::ICMPPacket::Protocol protocol,
+        int length,
+        const QHostAddress &sourceAddress,
+        const QHostAddress &destinationAddress,
+        Nedrysoft::ICMPPacket::IPVersion version) -> QByteArray {
+
+    QByteArray header;
+
+    if (version == Nedrysoft::ICMPPacket::V4) {
+        uint8_t address[IPv4AddressLength];
+
+        qToBigEndian<quint32>(sourceAddress.toIPv4Address(), address);
+        header.append(reinterpret_cast<const char *>(address), IPv4AddressLength);
+
+        qToBigEndian<quint32>(destinationAddress.toIPv4Address(), address);
+        header.append(reinterpret_cast<const char *>(address), IPv4AddressLength);
+
+        uint8_t trailer[4] = {0, static_cast<uint8_t>(protocol), 0, 0};
+
+        qToBigEndian<uint16_t>(static_cast<uint16_t>(length), trailer + 2);
+        header.append(reinterpret_cast<const char *>(trailer), sizeof(trailer));
+    } else {
+        auto source = sourceAddress.toIPv6Address();
+        auto destination = destinationAddress.toIPv6Address();
+
+        header.append(reinterpret_cast<const char *>(source.c), IPv6AddressLength);
+        header.append(reinterpret_cast<const char *>(destination.c), IPv6AddressLength);
+
+        uint8_t trailer[8] = {0, 0, 0, 0, 0, 0, 0, static_cast<uint8_t>(protocol)};
+
+        qToBigEndian<uint32_t>(static_cast<uint32_t>(length), trailer);
+        header.append(reinterpret_cast<const char *>(trailer), sizeof(trailer));
+    }
+
+    return header;
+}
+
+Nedrysoft::ICMPPacket::ProbePacketTemplate::ProbePacketTemplate() :
+        m_protocol(Nedrysoft::ICMPPacket::UDP),
+        m_partialSum(0) {
+
+}
+
+Nedrysoft::ICMPPacket::ProbePacketTemplate::ProbePacketTemplate(
+        Nedrysoft::ICMPPacket::Protocol protocol,
+        uint16_t sourcePort,
+        uint16_t destinationPort,
+        int payloadLength,
+        const QHostAddress &sourceAddress,
+        const QHostAddress &destinationAddress,
+        Nedrysoft::ICMPPacket::IPVersion version) :
+
+            m_protocol(protocol),
+            m_partialSum(0) {
+
+    if ((version != Nedrysoft::ICMPPacket::V4) && (version != Nedrysoft::ICMPPacket::V6)) {
+        return;
+    }
+
+    QByteArray probe;
+
+    if (protocol == Nedrysoft::ICMPPacket::UDP) {
+        // the payload must be able to hold the adjustment word and is kept even so that it is fully summed.
+
+        auto length = UDPHeaderLength + qMax(static_cast<int>(sizeof(uint16_t)), ( payloadLength + 1 ) & ~1);
+
+        probe = QByteArray(length, 0);
+
+        auto data = reinterpret_cast<uint8_t *>(probe.data());
+
+        qToBigEndian<uint16_t>(sourcePort, data);
+        qToBigEndian<uint16_t>(destinationPort, data + sizeof(uint16_t));
+        qToBigEndian<uint16_t>(static_cast<uint16_t>(length), data + UDPLengthOffset);
+    } else if (protocol == Nedrysoft::ICMPPacket::TCP) {
+        probe = QByteArray(TCPHeaderLength, 0);
+
+        auto data = reinterpret_cast<uint8_t *>(probe.data());
+
+        qToBigEndian<uint16_t>(sourcePort, data);
+        qToBigEndian<uint16_t>(destinationPort, data + sizeof(uint16_t));
+        data[TCPDataOffsetOffset] = ( TCPHeaderLength / sizeof(uint32_t) ) << 4;
+        data[TCPFlagsOffset] = TCPFlagSyn;
+        qToBigEndian<uint16_t>(TCPWindowSize, data + TCPWindowOffset);
+    } else {
+        return;
+    }
+
+    auto buffer = pseudoHeader(protocol, probe.length(), sourceAddress, destinationAddress, version) + probe;
+
+    // ICMPPacket::checksum returns the complement of the folded sum, the sum itself is kept for the UDP adjustment.
+
+    auto sum = static_cast<uint16_t>(~Nedrysoft::ICMPPacket::ICMPPacket::checksum(buffer.data(), buffer.length()));
+
+    if (protocol == Nedrysoft::ICMPPacket::TCP) {
+        uint16_t checksum = static_cast<uint16_t>(~sum);
+
+        memcpy(probe.data() + TCPChecksumOffset, &checksum, sizeof(checksum));
+    }
+
+    m_partialSum = sum;
+    m_packet = probe;
+}
+
+auto Nedrysoft::ICMPPacket::ProbePacketTemplate::isValid() const -> bool {
+    return !m_packet.isEmpty();
+}
+
+auto Nedrysoft::ICMPPacket::ProbePacketTemplate::protocol() const -> Nedrysoft::ICMPPacket::Protocol {
+    return m_protocol;
+}
+
+auto Nedrysoft::ICMPPacket::ProbePacketTemplate::packet(uint16_t sequence) const -> QByteArray {
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    auto buffer = m_packet;
+    auto data = buffer.data();
+
+    uint16_t value = qToBigEndian<uint16_t>(sequence);
+
+    if (m_protocol == Nedrysoft::ICMPPacket::UDP) {
+        // the checksum field is set to the sequence and the first payload word is chosen so that the sum over
+        // the whole datagram is 0xffff, which makes the sequence the correct checksum.  A sequence of 0 is sent
+        // as "no checksum", which is still quoted by routers but is discarded by IPv6 destinations.
+
+        uint16_t adjustment = static_cast<uint16_t>(~fold(m_partialSum + value));
+
+        memcpy(data + UDPChecksumOffset, &value, sizeof(value));
+        memcpy(data + UDPHeaderLength, &adjustment, sizeof(adjustment));
+    } else {
+        uint16_t checksum, oldValue;
+
+        memcpy(&checksum, data + TCPChecksumOffset, sizeof(checksum));
+        memcpy(&oldValue, data + TCPSequenceLowOffset, sizeof(oldValue));
+
+        checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, value);
+
+        memcpy(data + TCPSequenceLowOffset, &value, sizeof(value));
+        memcpy(data + TCPChecksumOffset, &checksum, sizeof(checksum));
+    }
+
+    return buffer;
+}
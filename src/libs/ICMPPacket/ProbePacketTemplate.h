@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPPACKET_PROBEPACKETTEMPLATE_H
+#define NEDRYSOFT_ICMPPACKET_PROBEPACKETTEMPLATE_H
+
+#include "ICMPPacket.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <cstdint>
+
+namespace Nedrysoft { namespace ICMPPacket {
+    /**
+     * @brief       The ProbePacketTemplate class provides a prebuilt UDP or TCP SYN probe.
+     *
+     * @details     The probe is built once for a fixed source port, destination port and address, each packet
+     *              generated from the template only differs in the field that carries the sequence, so the flow
+     *              identifier that load balancers hash on stays the same for every probe of a target.
+     *
+     *              UDP probes carry the sequence in the checksum field (as paris-traceroute does), a 16 bit
+     *              word at the start of the payload is adjusted so that the checksum remains valid.  TCP SYN
+     *              probes carry the sequence in the low 16 bits of the TCP sequence number.
+     */
+    class NEDRYSOFT_ICMPPACKET_DLLSPEC ProbePacketTemplate {
+        public:
+            /**
+             * @brief       Constructs an empty (invalid) ProbePacketTemplate.
+             */
+            ProbePacketTemplate();
+
+            /**
+             * @brief       Constructs a ProbePacketTemplate for the given flow.
+             *
+             * @note        The source address is required to calculate the transport checksum, it must be the
+             *              address that the operating system will send the probe from.
+             *
+             * @param[in]   protocol the transport protocol of the probe, either UDP or TCP.
+             * @param[in]   sourcePort the source port of the probe.
+             * @param[in]   destinationPort the destination port of the probe.
+             * @param[in]   payloadLength the length of the payload, ignored for TCP SYN probes.
+             * @param[in]   sourceAddress the address of the sender.
+             * @param[in]   destinationAddress the address of the target.
+             * @param[in]   version the ip version of the probe.
+             */
+            ProbePacketTemplate(
+                Nedrysoft::ICMPPacket::Protocol protocol,
+                uint16_t sourcePort,
+                uint16_t destinationPort,
+                int payloadLength,
+                const QHostAddress &sourceAddress,
+                const QHostAddress &destinationAddress,
+                Nedrysoft::ICMPPacket::IPVersion version
+            );
+
+            /**
+             * @brief       Returns whether the template contains a packet.
+             *
+             * @returns     true if valid; otherwise false.
+             */
+            auto isValid() const -> bool;
+
+            /**
+             * @brief       Returns the protocol of the probe.
+             *
+             * @returns     the protocol.
+             */
+            auto protocol() const -> Nedrysoft::ICMPPacket::Protocol;
+
+            /**
+             * @brief       Creates a probe from the template.
+             *
+             * @param[in]   sequence the sequence to stamp into the packet.
+             *
+             * @returns     a QByteArray containing the raw transport packet.
+             */
+            auto packet(uint16_t sequence) const -> QByteArray;
+
+        private:
+            //! @cond
+
+            QByteArray m_packet;
+            Nedrysoft::ICMPPacket::Protocol m_protocol;
+            uint32_t m_partialSum;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPPACKET_PROBEPACKETTEMPLATE_H
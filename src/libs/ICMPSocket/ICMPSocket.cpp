@@ -22,20 +22,43 @@
  */
 
 #include "ICMPSocket.h"
+#include "ICMPSocketBroker.h"
+#include "ICMPSocketClock.h"
+
+#include "ICMPSocketSimulator.h"
 
 #if defined(Q_OS_UNIX)
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#if defined(Q_OS_LINUX)
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <netinet/icmp6.h>
+#endif
+
+#if defined(Q_OS_MACOS)
+#include <net/if.h>
+#endif
+
 #elif defined(Q_OS_WIN)
 #include <WS2tcpip.h>
 #include <WinSock2.h>
 #endif
 
+#include <QDateTime>
+#include <QFile>
+#include <QNetworkInterface>
 #include <QtEndian>
+#include <algorithm>
+#include <cerrno>
+#include <vector>
 
 #if defined(Q_OS_WIN)
 constexpr int SocketError = SOCKET_ERROR;
@@ -44,18 +67,361 @@ constexpr int SocketError = -1;
 #endif
 
 constexpr auto ReceiveBufferSize = 4096;
+constexpr auto ControlBufferSize = 256;
+constexpr auto SequenceMapSize = 65536;
+constexpr auto SequenceBits = 16;
+constexpr auto SequenceMask = 0xffffu;
+
+constexpr auto ICMPHeaderLength = 8;
+constexpr auto ICMPIdOffset = 4;
+constexpr auto ICMPSequenceOffset = 6;
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv4VersionAndHeaderLength = 0x45;
+constexpr auto IPv4TTLOffset = 8;
+constexpr auto IPv4ProtocolOffset = 9;
+constexpr auto IPv4SourceOffset = 12;
+constexpr auto IPv4AddressLength = 4;
+constexpr auto IPv6HeaderLength = 40;
+constexpr auto IPv6AddressLength = 16;
+constexpr auto IPv6Version = 0x60;
+constexpr auto IPv6NextHeaderOffset = 6;
+constexpr auto ICMPTimeExceededV4 = 11;
+constexpr auto ICMPTimeExceededV6 = 3;
+constexpr auto ICMPEchoReplyV4 = 0;
+constexpr auto ICMPEchoReplyV6 = 129;
+constexpr auto ICMPDestinationUnreachableV4 = 3;
+constexpr auto ICMPDestinationUnreachableV6 = 1;
+constexpr auto ICMPPacketTooBigV6 = 2;
+constexpr auto ICMPParameterProblemV4 = 12;
+constexpr auto ICMPParameterProblemV6 = 4;
+
+constexpr auto FilterAccept = 0xffffffffu;
+constexpr auto FilterDrop = 0u;
+constexpr auto MaximumFilterIdentifiers = 512;
+
+constexpr auto PingGroupRangePath = "/proc/sys/net/ipv4/ping_group_range";
+
+static std::atomic<Nedrysoft::ICMPSocket::ICMPSocketSimulator *> socketSimulator(nullptr);
+
+/**
+ * @brief       Builds a minimal IPv4 header for an ICMP packet received on a datagram socket.
+ *
+ * @param[in]   sourceAddress the address the packet was received from.
+ * @param[in]   ttl the received TTL.
+ *
+ * @returns     the IPv4 header.
+ */
+static auto ipv4Header(const Nedrysoft::ICMPSocket::SocketAddress &sourceAddress, int ttl) -> QByteArray {
+    QByteArray header(IPv4HeaderLength, 0);
+
+    header[0] = static_cast<char>(IPv4VersionAndHeaderLength);
+    header[IPv4TTLOffset] = static_cast<char>(qMax(ttl, 0));
+    header[IPv4ProtocolOffset] = static_cast<char>(IPPROTO_ICMP);
+
+    memcpy(header.data() + IPv4SourceOffset, sourceAddress.address, IPv4AddressLength);
+
+    return header;
+}
+
+#if defined(Q_OS_LINUX)
+/**
+ * @brief       Returns the id and sequence number of an ICMP request as a single key.
+ *
+ * @param[in]   buffer the ICMP request.
+ *
+ * @returns     the id in the upper 16 bits and the sequence number in the lower 16 bits.
+ */
+static auto requestKey(const QByteArray &buffer) -> uint32_t {
+    if (buffer.length() < ICMPHeaderLength) {
+        return 0;
+    }
+
+    auto header = reinterpret_cast<const uint8_t *>(buffer.constData());
+
+    return (static_cast<uint32_t>(qFromBigEndian<uint16_t>(header + ICMPIdOffset)) << SequenceBits) |
+           qFromBigEndian<uint16_t>(header + ICMPSequenceOffset);
+}
+
+/**
+ * @brief       Converts a kernel timestamp to nanoseconds since the unix epoch.
+ *
+ * @param[in]   time the timestamp.
+ *
+ * @returns     the time in nanoseconds; or -1 if the timestamp was not set.
+ */
+static auto toNanoseconds(const struct timespec &time) -> qint64 {
+    if ((!time.tv_sec) && (!time.tv_nsec)) {
+        return -1;
+    }
+
+    return static_cast<qint64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * @brief       Requests adapter receive timestamps on a socket.
+ *
+ * @details     The adapter only stamps packets if hardware timestamping has been enabled on it, otherwise no
+ *              timestamp is delivered and the kernel receive time is used.
+ *
+ * @param[in]   socket the socket descriptor.
+ */
+static auto enableHardwareReceiveTimestamps(int socket) -> void {
+    int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+    if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == SocketError) {
+        qWarning() << QObject::tr("Error enabling hardware receive timestamps on socket");
+    }
+}
+
+/**
+ * @brief       Appends a search of a sorted list of identifiers to a filter program.
+ *
+ * @details     The identifier to find is in the accumulator, the packet is accepted if it is found.  The search is a
+ *              balanced tree of comparisons so a packet is matched in log2(n) steps, the branches to the right of
+ *              each comparison are unconditional jumps as conditional jumps can only skip 255 instructions.
+ *
+ * @param[in,out]   program the filter program.
+ * @param[in]       identifiers the sorted identifiers.
+ * @param[in]       first the index of the first identifier to search.
+ * @param[in]       last the index of the last identifier to search.
+ */
+static auto addIdentifierSearch(
+        std::vector<struct sock_filter> &program,
+        const std::vector<uint16_t> &identifiers,
+        int first,
+        int last) -> void {
+
+    if (first > last) {
+        program.push_back(BPF_STMT(BPF_RET | BPF_K, FilterDrop));
+
+        return;
+    }
+
+    auto middle = (first + last) / 2;
+
+    program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, identifiers[middle], 0, 1));
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, FilterAccept));
+    program.push_back(BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, identifiers[middle], 0, 1));
+
+    auto rightJump = program.size();
+
+    program.push_back(BPF_STMT(BPF_JMP | BPF_JA, 0));
+
+    addIdentifierSearch(program, identifiers, first, middle - 1);
+
+    program[rightJump].k = static_cast<uint32_t>(program.size() - rightJump - 1);
+
+    addIdentifierSearch(program, identifiers, middle + 1, last);
+}
+
+/**
+ * @brief       Builds the filter program for a raw ICMP read socket.
+ *
+ * @details     Echo replies are matched on their id.  Errors (time exceeded, destination unreachable, packet too
+ *              big and parameter problem) are matched on the id of the echo request they quote, or on the source
+ *              port of a quoted UDP or TCP probe.  Every other packet is dropped.
+ *
+ *              An IPv4 raw socket sees the IP header, an IPv6 raw socket starts at the ICMPv6 header.  The quoted
+ *              IPv6 header is assumed to have no extension headers, which is the case for the packets we send.
+ *
+ * @param[in]   version the IP version of the socket.
+ * @param[in]   identifiers the identifiers to accept; if there are too many only the packet type is checked.
+ *
+ * @returns     the filter program.
+ */
+static auto identifierFilter(
+        Nedrysoft::ICMPSocket::IPVersion version,
+        std::vector<uint16_t> identifiers) -> std::vector<struct sock_filter> {
+
+    std::vector<struct sock_filter> program;
+
+    auto isV4 = (version == Nedrysoft::ICMPSocket::V4);
+
+    // the X register holds the offset of the ICMP header.
+
+    if (isV4) {
+        program.push_back(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0));
+    } else {
+        program.push_back(BPF_STMT(BPF_LDX | BPF_IMM, 0));
+    }
+
+    auto errorTypes = isV4 ?
+        std::vector<uint8_t>{ICMPTimeExceededV4, ICMPDestinationUnreachableV4, ICMPParameterProblemV4} :
+        std::vector<uint8_t>{
+            ICMPTimeExceededV6,
+            ICMPDestinationUnreachableV6,
+            ICMPPacketTooBigV6,
+            ICMPParameterProblemV6
+        };
+
+    auto errorCount = static_cast<uint8_t>(errorTypes.size());
 
-Nedrysoft::ICMPSocket::ICMPSocket::ICMPSocket(Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket, IPVersion version) :
-        m_socketDescriptor(socket),
-        m_version(version),
-        m_ttl(64) {
+    // the echo reply check skips the error checks and the drop, each error check skips to the quoted request.
 
+    program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0));
+    program.push_back(BPF_JUMP(
+        BPF_JMP | BPF_JEQ | BPF_K,
+        static_cast<uint32_t>(isV4 ? ICMPEchoReplyV4 : ICMPEchoReplyV6), static_cast<uint8_t>(errorCount + 1), 0 ));
+
+    for (uint8_t index = 0; index < errorCount; index++) {
+        program.push_back(BPF_JUMP(
+            BPF_JMP | BPF_JEQ | BPF_K,
+            errorTypes[index], static_cast<uint8_t>(errorCount - index + 2), 0 ));
+    }
+
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, FilterDrop));
+
+    // an echo reply carries the id directly.
+
+    program.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, ICMPIdOffset));
+
+    auto searchJump = program.size();
+
+    program.push_back(BPF_STMT(BPF_JMP | BPF_JA, 0));
+
+    // an error quotes the request, X is moved on by the length of the quoted IP header and A holds its protocol.
+
+    if (isV4) {
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, ICMPHeaderLength + IPv4ProtocolOffset));
+        program.push_back(BPF_STMT(BPF_ST, 0));
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, ICMPHeaderLength));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x0f));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 2));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0));
+        program.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+        program.push_back(BPF_STMT(BPF_LD | BPF_MEM, 0));
+    } else {
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, ICMPHeaderLength + IPv6NextHeaderOffset));
+        program.push_back(BPF_STMT(BPF_LDX | BPF_IMM, IPv6HeaderLength));
+    }
+
+    program.push_back(BPF_JUMP(
+        BPF_JMP | BPF_JEQ | BPF_K,
+        static_cast<uint32_t>(isV4 ? IPPROTO_ICMP : IPPROTO_ICMPV6), 2, 0 ));
+    program.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, ICMPHeaderLength));
+    program.push_back(BPF_STMT(BPF_JMP | BPF_JA, 1));
+    program.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, ICMPHeaderLength + ICMPIdOffset));
+
+    program[searchJump].k = static_cast<uint32_t>(program.size() - searchJump - 1);
+
+    std::sort(identifiers.begin(), identifiers.end());
+
+    identifiers.erase(std::unique(identifiers.begin(), identifiers.end()), identifiers.end());
+
+    if (static_cast<int>(identifiers.size()) > MaximumFilterIdentifiers) {
+        program.push_back(BPF_STMT(BPF_RET | BPF_K, FilterAccept));
+
+        return program;
+    }
+
+    addIdentifierSearch(program, identifiers, 0, static_cast<int>(identifiers.size()) - 1);
+
+    return program;
+}
+#endif
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+/**
+ * @brief       Creates a non blocking raw socket.
+ *
+ * @details     If the process does not have the privilege to create a raw socket the socket is requested from the
+ *              privileged helper instead.
+ *
+ *              A raw socket receives a copy of every packet of its protocol, a send only socket drops everything in
+ *              the kernel rather than queuing it on a socket nobody reads.  The helper locks that filter.
+ *
+ * @param[in]   addressFamily the address family of the socket.
+ * @param[in]   protocol the IP protocol of the socket.
+ * @param[in]   sendOnly true if the socket is only used to send.
+ *
+ * @returns     the socket descriptor; otherwise -1 on error.
+ */
+static auto rawSocket(int addressFamily, int protocol, bool sendOnly = false) -> int {
+    auto socketDescriptor = socket(addressFamily, SOCK_RAW | SOCK_NONBLOCK, protocol);
+
+#if defined(Q_OS_LINUX)
+    if ((socketDescriptor != -1) && (sendOnly)) {
+        struct sock_filter dropAll[] = {
+            BPF_STMT(BPF_RET | BPF_K, 0)
+        };
+
+        struct sock_fprog filterProgram = {};
+
+        filterProgram.len = sizeof(dropAll) / sizeof(dropAll[0]);
+        filterProgram.filter = dropAll;
+
+        if (setsockopt(socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &filterProgram, sizeof(filterProgram)) == -1) {
+            qWarning() << QObject::tr("Error attaching receive filter to probe socket");
+        }
+    }
+
+    if ((socketDescriptor != -1) || ((errno != EPERM) && (errno != EACCES))) {
+        return socketDescriptor;
+    }
+
+    socketDescriptor = Nedrysoft::ICMPSocket::ICMPSocketBroker::getInstance()->requestSocket(
+        addressFamily,
+        protocol,
+        sendOnly
+    );
+
+    if (socketDescriptor == -1) {
+        return -1;
+    }
+
+    if (fcntl(socketDescriptor, F_SETFL, fcntl(socketDescriptor, F_GETFL) | O_NONBLOCK) == -1) {
+        close(socketDescriptor);
+
+        return -1;
+    }
+#endif
+
+    return socketDescriptor;
+}
+#endif
+
+Nedrysoft::ICMPSocket::ICMPSocket::ICMPSocket(
+        Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket,
+        IPVersion version,
+        bool isDatagram,
+        Protocol protocol) :
+
+            m_socketDescriptor(socket),
+            m_version(version),
+            m_ttl(64),
+            m_isDatagram(isDatagram),
+            m_protocol(protocol),
+            m_datagramSequence(0),
+            m_receiveDrops(0),
+            m_transmitTimestamps(false),
+            m_transmitKey(0),
+            m_isSimulated(false),
+            m_simulatorDescriptor(static_cast<ICMPSocket::socket_t>(-1)),
+            m_simulatedSignalled(false) {
+
+    if (m_isDatagram) {
+        m_datagramSequenceMap.reset(new std::atomic<uint32_t>[SequenceMapSize]);
+
+        for (auto index = 0; index < SequenceMapSize; index++) {
+            m_datagramSequenceMap[index].store(0, std::memory_order_relaxed);
+        }
+    }
 }
 
 Nedrysoft::ICMPSocket::ICMPSocket::~ICMPSocket() {
 #if defined(Q_OS_WIN)
     closesocket(m_socketDescriptor);
 #else
+    if (m_isSimulated) {
+        auto simulator = socketSimulator.load();
+
+        if (simulator) {
+            simulator->removeSocket(this);
+        }
+
+        close(m_simulatorDescriptor);
+    }
+
     close(m_socketDescriptor);
 #endif
 }
@@ -65,6 +431,18 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(
 
     Nedrysoft::ICMPSocket::ICMPSocket::socket_t socketDescriptor;
 
+    auto simulator = socketSimulator.load();
+
+    if (simulator) {
+        auto socketInstance = createSimulatedSocket(version, Nedrysoft::ICMPSocket::ICMP);
+
+        if (socketInstance) {
+            simulator->addReadSocket(socketInstance);
+        }
+
+        return socketInstance;
+    }
+
     initialiseSockets();
 
 #if defined(Q_OS_MACOS)
@@ -87,20 +465,90 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(
         }
     }
 #elif defined(Q_OS_UNIX)
+    auto socketType = usesDatagramSockets() ? SOCK_DGRAM : SOCK_RAW;
+
     if (version==Nedrysoft::ICMPSocket::V4) {
-        socketDescriptor = socket(AF_INET, SOCK_RAW | SOCK_NONBLOCK, IPPROTO_ICMP);
+        socketDescriptor = (socketType == SOCK_RAW) ?
+            rawSocket(AF_INET, IPPROTO_ICMP) :
+            socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMP);
     } else if (version==Nedrysoft::ICMPSocket::V6) {
-        socketDescriptor = socket(AF_INET6, SOCK_RAW | SOCK_NONBLOCK, IPPROTO_ICMPV6);
+        socketDescriptor = (socketType == SOCK_RAW) ?
+            rawSocket(AF_INET6, IPPROTO_ICMPV6) :
+            socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMPV6);
     } else {
         qWarning() << QObject::tr("Unknown IP version");
 
         return nullptr;
     }
+
+#if defined(Q_OS_LINUX)
+    if ((isValid(socketDescriptor)) && (usesDatagramSockets())) {
+        enableDatagramOptions(socketDescriptor, version);
+    } else if (isValid(socketDescriptor)) {
+        int enableTimestamps = 1;
+
+        auto result = setsockopt(
+            socketDescriptor,
+            SOL_SOCKET,
+            SO_TIMESTAMPNS,
+            &enableTimestamps,
+            sizeof(enableTimestamps)
+        );
+
+        if (result == SocketError) {
+            qWarning() << QObject::tr("Error enabling kernel receive timestamps on socket");
+        }
+
+        /**
+         * the kernel reports the number of datagrams dropped because the receive buffer was full with each read,
+         * which separates loss in our own receive path from loss on the network.
+         */
+
+        result = setsockopt(
+            socketDescriptor,
+            SOL_SOCKET,
+            SO_RXQ_OVFL,
+            &enableTimestamps,
+            sizeof(enableTimestamps)
+        );
+
+        if (result == SocketError) {
+            qWarning() << QObject::tr("Error enabling receive queue overflow reporting on socket");
+        }
+
+        enableHardwareReceiveTimestamps(socketDescriptor);
+
+        if (version == Nedrysoft::ICMPSocket::V6) {
+            // the type filter is applied before the identifier filter, so echo requests and neighbour discovery
+            // are dropped without running it.
+
+            struct icmp6_filter typeFilter = {};
+
+            ICMP6_FILTER_SETBLOCKALL(&typeFilter);
+            ICMP6_FILTER_SETPASS(ICMPEchoReplyV6, &typeFilter);
+            ICMP6_FILTER_SETPASS(ICMPTimeExceededV6, &typeFilter);
+            ICMP6_FILTER_SETPASS(ICMPDestinationUnreachableV6, &typeFilter);
+            ICMP6_FILTER_SETPASS(ICMPPacketTooBigV6, &typeFilter);
+            ICMP6_FILTER_SETPASS(ICMPParameterProblemV6, &typeFilter);
+
+            result = setsockopt(socketDescriptor, IPPROTO_ICMPV6, ICMP6_FILTER, &typeFilter, sizeof(typeFilter));
+
+            if (result == SocketError) {
+                qWarning() << QObject::tr("Error setting ICMPv6 type filter on socket");
+            }
+        }
+    }
+#endif
 #elif defined(Q_OS_WIN)
+    // the read sockets are created for registered I/O so that the ICMPSocketRing can receive from them, the flag
+    // does not prevent the socket from being used with the normal socket functions.
+
+    constexpr DWORD registeredFlags = WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO;
+
     if (version==Nedrysoft::ICMPSocket::V4) {
-        socketDescriptor = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+        socketDescriptor = WSASocket(AF_INET, SOCK_RAW, IPPROTO_ICMP, nullptr, 0, registeredFlags);
     } else if (version==Nedrysoft::ICMPSocket::V6) {
-        socketDescriptor = socket(AF_INET6, SOCK_RAW, IPPROTO_ICMPV6);
+        socketDescriptor = WSASocket(AF_INET6, SOCK_RAW, IPPROTO_ICMPV6, nullptr, 0, registeredFlags);
     } else {
         qWarning() << QObject::tr("Unknown IP version");
 
@@ -150,7 +598,7 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createReadSocket(
     }
 #endif
 
-    return new Nedrysoft::ICMPSocket::ICMPSocket(socketDescriptor, version);
+    return new Nedrysoft::ICMPSocket::ICMPSocket(socketDescriptor, version, usesDatagramSockets());
 }
 
 auto Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
@@ -159,6 +607,16 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
 
     Nedrysoft::ICMPSocket::ICMPSocket::socket_t socketDescriptor;
 
+    if (socketSimulator.load()) {
+        auto socketInstance = createSimulatedSocket(version, Nedrysoft::ICMPSocket::ICMP);
+
+        if ((socketInstance) && (ttl)) {
+            socketInstance->m_ttl = ttl;
+        }
+
+        return socketInstance;
+    }
+
     initialiseSockets();
 
 #if defined(Q_OS_MACOS)
@@ -181,15 +639,27 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
         }
     }
 #elif defined(Q_OS_UNIX)
+    auto socketType = usesDatagramSockets() ? SOCK_DGRAM : SOCK_RAW;
+
     if (version==Nedrysoft::ICMPSocket::V4) {
-        socketDescriptor = socket(AF_INET, SOCK_RAW | SOCK_NONBLOCK, IPPROTO_ICMP);
+        socketDescriptor = (socketType == SOCK_RAW) ?
+            rawSocket(AF_INET, IPPROTO_ICMP) :
+            socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMP);
     } else if (version==Nedrysoft::ICMPSocket::V6) {
-        socketDescriptor = socket(AF_INET6, SOCK_RAW | SOCK_NONBLOCK, IPPROTO_ICMPV6);
+        socketDescriptor = (socketType == SOCK_RAW) ?
+            rawSocket(AF_INET6, IPPROTO_ICMPV6) :
+            socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMPV6);
     } else {
         qWarning() << QObject::tr("Unknown IP version");
 
         return nullptr;
     }
+
+    // a datagram socket only receives the replies to its own requests, so it must be able to read as well.
+
+    if ((isValid(socketDescriptor)) && (usesDatagramSockets())) {
+        enableDatagramOptions(socketDescriptor, version);
+    }
 #elif defined(Q_OS_WIN)
     if (version==Nedrysoft::ICMPSocket::V4) {
         socketDescriptor = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
@@ -214,7 +684,7 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
     Nedrysoft::ICMPSocket::ICMPSocket *socketInstance = nullptr;
 
     if (isValid(socketDescriptor)) {
-        socketInstance = new Nedrysoft::ICMPSocket::ICMPSocket(socketDescriptor, version);
+        socketInstance = new Nedrysoft::ICMPSocket::ICMPSocket(socketDescriptor, version, usesDatagramSockets());
 
         if (ttl) {
             if (version == V4) {
@@ -230,140 +700,1546 @@ auto Nedrysoft::ICMPSocket::ICMPSocket::createWriteSocket(
     return socketInstance;
 }
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::recvfrom(
-        QByteArray &buffer,
-        QHostAddress &receiveAddress,
-        int timeout) -> int {
-
-#if defined(Q_OS_UNIX)
-    socklen_t addressLength;
-    unsigned int socketErrorLength;
-#elif defined(Q_OS_WIN)
-    int addressLength;
-    int socketErrorLength;
-
-    int (WSAAPI *poll)(struct pollfd *, ulong , int ) = WSAPoll;
-#endif
-    int socketError;
-    struct sockaddr_storage fromAddress = {};
-    struct pollfd descriptorSet = {};
-
-    descriptorSet.fd = m_socketDescriptor;
-    descriptorSet.events = POLLIN;
+auto Nedrysoft::ICMPSocket::ICMPSocket::sharedWriteSocket(
+        Nedrysoft::ICMPSocket::IPVersion version,
+        bool dontFragment,
+        const QString &source) -> Nedrysoft::ICMPSocket::ICMPSocket * {
 
-    auto numberOfReadyDescriptors = poll(&descriptorSet, 1, timeout);
+    static QMutex sharedSocketMutex;
+    static Nedrysoft::ICMPSocket::ICMPSocket *sharedSockets[4] = {nullptr, nullptr, nullptr, nullptr};
+    static QHash<QString, Nedrysoft::ICMPSocket::ICMPSocket *> boundSockets;
 
-    if (numberOfReadyDescriptors > 0) {
-        if (descriptorSet.events & POLLIN) {
-            socketErrorLength = sizeof(socketError);
+    QMutexLocker locker(&sharedSocketMutex);
 
-            getsockopt(
-                m_socketDescriptor,
-                SOL_SOCKET, SO_ERROR,
-                reinterpret_cast<char *>(&socketError),
-                &socketErrorLength
-            );
+    auto index = ((version == V4) ? 0 : 2) + (dontFragment ? 1 : 0);
+    auto sharedSocket = &sharedSockets[index];
 
-            memset(&fromAddress, 0, sizeof(fromAddress));
+    // a socket bound to a source is shared by every engine that sends from that source.
 
-            addressLength = sizeof(fromAddress);
+    if (!source.isEmpty()) {
+        sharedSocket = &boundSockets[QString("%1/%2").arg(source).arg(index)];
+    }
 
-            buffer.resize(ReceiveBufferSize);
+    if (!*sharedSocket) {
+        *sharedSocket = createWriteSocket(0, version);
 
-            auto result = ::recvfrom(
-                m_socketDescriptor,
-                buffer.data(),
-                buffer.length(),
-                0,
-                reinterpret_cast<sockaddr *>(&fromAddress),
-                &addressLength
-            );
+        if ((*sharedSocket) && (!source.isEmpty()) && (!(*sharedSocket)->bindToSource(source))) {
+            delete *sharedSocket;
 
-            if (result >= 0) {
-                receiveAddress = QHostAddress(reinterpret_cast<sockaddr *>(&fromAddress));
+            *sharedSocket = nullptr;
 
-                buffer.resize(result);
-            }
+            return nullptr;
+        }
 
-            return result;
+        if ((*sharedSocket) && (dontFragment)) {
+            (*sharedSocket)->setDontFragment(true);
         }
     }
 
-    return -1;
+    return *sharedSocket;
 }
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::sendto(QByteArray &buffer, const QHostAddress &hostAddress) -> int {
-    if (m_version == V4) {
-        struct sockaddr_in toAddress = {};
-
-        memset(&toAddress, 0, sizeof(toAddress));
+auto Nedrysoft::ICMPSocket::ICMPSocket::createProbeSocket(
+        Nedrysoft::ICMPSocket::Protocol protocol,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        bool sendOnly) -> Nedrysoft::ICMPSocket::ICMPSocket * {
 
-        toAddress.sin_family = AF_INET;
-        toAddress.sin_addr.s_addr = qToBigEndian<uint32_t>(hostAddress.toIPv4Address());
+    Nedrysoft::ICMPSocket::ICMPSocket::socket_t socketDescriptor;
 
-        return ::sendto(m_socketDescriptor, buffer.data(), buffer.length(), 0,
-                        reinterpret_cast<struct sockaddr *>(&toAddress), sizeof(toAddress));
-    } else if (m_version == V6) {
-        struct sockaddr_in6 toAddress = {};
+    initialiseSockets();
 
-        auto destinationAddress = hostAddress.toIPv6Address();
+    int socketProtocol;
 
-        toAddress.sin6_family = AF_INET6;
-        memcpy(toAddress.sin6_addr.s6_addr, &destinationAddress, 16);
+    if (protocol == Nedrysoft::ICMPSocket::UDP) {
+        socketProtocol = IPPROTO_UDP;
+    } else if (protocol == Nedrysoft::ICMPSocket::TCP) {
+        socketProtocol = IPPROTO_TCP;
+    } else {
+        return nullptr;
+    }
 
-        return ::sendto(m_socketDescriptor, buffer.data(), buffer.length(), 0,
-                        reinterpret_cast<struct sockaddr *>(&toAddress), sizeof(toAddress));
+    if (socketSimulator.load()) {
+        return createSimulatedSocket(version, protocol);
     }
 
-    return -1;
-}
+    int addressFamily;
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::isValid(Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket) -> bool {
-#if defined(Q_OS_WIN)
-    return socket!=INVALID_SOCKET;
-#else
-    return socket != -1;
-#endif
-}
+    if (version == Nedrysoft::ICMPSocket::V4) {
+        addressFamily = AF_INET;
+    } else if (version == Nedrysoft::ICMPSocket::V6) {
+        addressFamily = AF_INET6;
+    } else {
+        qWarning() << QObject::tr("Unknown IP version");
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::initialiseSockets() -> void {
-    static auto initialised = false;
+        return nullptr;
+    }
 
-    if (!initialised) {
-#if defined(Q_OS_WIN)
-        WSADATA wsaData;
+#if defined(Q_OS_LINUX)
+    socketDescriptor = rawSocket(addressFamily, socketProtocol, sendOnly);
 
-        if (WSAStartup(MAKEWORD(2,2), &wsaData)!=0) {
-            qDebug() << "error initialising winsock";
-        }
-#endif
-        initialised = true;
+    if (!isValid(socketDescriptor)) {
+        return nullptr;
     }
-}
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::setTTL(int ttl) -> void {
-    auto result = setsockopt(m_socketDescriptor, IPPROTO_IP, IP_TTL, reinterpret_cast<char *>(&ttl), sizeof(ttl));
+    int enableTimestamps = 1;
 
-    m_ttl = ttl;
+    auto result = setsockopt(
+        socketDescriptor,
+        SOL_SOCKET,
+        SO_TIMESTAMPNS,
+        &enableTimestamps,
+        sizeof(enableTimestamps)
+    );
 
     if (result == SocketError) {
-        qWarning() << QObject::tr("Error setting TTL.");
+        qWarning() << QObject::tr("Error enabling kernel receive timestamps on socket");
+    }
+#elif defined(Q_OS_WIN)
+    if (protocol == Nedrysoft::ICMPSocket::TCP) {
+        return nullptr;
     }
-}
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::setHopLimit(int hopLimit) -> void {
-    auto result = setsockopt(m_socketDescriptor, IPPROTO_IPV6, IPV6_UNICAST_HOPS, reinterpret_cast<char *>(&hopLimit),
-                             sizeof(hopLimit));
+    socketDescriptor = socket(addressFamily, SOCK_RAW, socketProtocol);
 
-    if (result == SocketError) {
-        qWarning() << QObject::tr("Error setting Hop Limit.");
+    if (!isValid(socketDescriptor)) {
+        return nullptr;
     }
-}
 
-auto  Nedrysoft::ICMPSocket::ICMPSocket::version() -> Nedrysoft::ICMPSocket::IPVersion {
-    return m_version;
+    int socketFlags = 1;
+
+    auto result = ioctlsocket(socketDescriptor, static_cast<long>(FIONBIO), reinterpret_cast<u_long *>(&socketFlags));
+
+    if (result==SocketError) {
+        qWarning() << QObject::tr("Error setting non blocking on socket");
+    }
+#else
+    Q_UNUSED(addressFamily)
+    Q_UNUSED(socketProtocol)
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(sendOnly)
+
+    // macOS only permits datagram ICMP sockets, which do not receive the ICMP errors that probes rely on.
+
+    return nullptr;
+#endif
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_WIN)
+    return new Nedrysoft::ICMPSocket::ICMPSocket(socketDescriptor, version, false, protocol);
+#endif
 }
 
-auto Nedrysoft::ICMPSocket::ICMPSocket::ttl() -> int {
+auto Nedrysoft::ICMPSocket::ICMPSocket::sharedProbeSocket(
+        Nedrysoft::ICMPSocket::Protocol protocol,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        bool dontFragment,
+        const QString &source) -> Nedrysoft::ICMPSocket::ICMPSocket * {
+
+    if (protocol == Nedrysoft::ICMPSocket::ICMP) {
+        return sharedWriteSocket(version, dontFragment, source);
+    }
+
+    static QMutex sharedSocketMutex;
+    static Nedrysoft::ICMPSocket::ICMPSocket *sharedSockets[8] = {};
+    static QHash<QString, Nedrysoft::ICMPSocket::ICMPSocket *> boundSockets;
+
+    QMutexLocker locker(&sharedSocketMutex);
+
+    auto index = ((protocol == UDP) ? 0 : 4) + ((version == V4) ? 0 : 2) + (dontFragment ? 1 : 0);
+    auto sharedSocket = &sharedSockets[index];
+
+    if (!source.isEmpty()) {
+        sharedSocket = &boundSockets[QString("%1/%2").arg(source).arg(index)];
+    }
+
+    if (!*sharedSocket) {
+        *sharedSocket = createProbeSocket(protocol, version, true);
+
+        if ((*sharedSocket) && (!source.isEmpty()) && (!(*sharedSocket)->bindToSource(source))) {
+            delete *sharedSocket;
+
+            *sharedSocket = nullptr;
+
+            return nullptr;
+        }
+
+        if ((*sharedSocket) && (dontFragment)) {
+            (*sharedSocket)->setDontFragment(true);
+        }
+    }
+
+    return *sharedSocket;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::sourceAddress(
+        const QHostAddress &destinationAddress,
+        const QString &source) -> QHostAddress {
+
+    // connecting a UDP socket selects the route and source address without sending anything, the port is arbitrary.
+
+    constexpr auto DiscardPort = 9;
+
+    Nedrysoft::ICMPSocket::IPVersion version;
+
+    if (destinationAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        version = V4;
+    } else if (destinationAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        version = V6;
+    } else {
+        return QHostAddress();
+    }
+
+    initialiseSockets();
+
+    auto socketDescriptor = socket((version == V4) ? AF_INET : AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (!isValid(socketDescriptor)) {
+        return QHostAddress();
+    }
+
+    // the route is chosen as it would be for a socket bound to the same source.
+
+    if ((!source.isEmpty()) && (!bindSocket(socketDescriptor, version, source))) {
+#if defined(Q_OS_WIN)
+        closesocket(socketDescriptor);
+#else
+        close(socketDescriptor);
+#endif
+        return QHostAddress();
+    }
+
+    sockaddr_storage socketAddress;
+
+    auto addressLength = toSocketAddress(destinationAddress, version, socketAddress);
+
+    if (version == V4) {
+        reinterpret_cast<struct sockaddr_in *>(&socketAddress)->sin_port = qToBigEndian<uint16_t>(DiscardPort);
+    } else {
+        reinterpret_cast<struct sockaddr_in6 *>(&socketAddress)->sin6_port = qToBigEndian<uint16_t>(DiscardPort);
+    }
+
+    QHostAddress localAddress;
+
+    if (::connect(socketDescriptor, reinterpret_cast<sockaddr *>(&socketAddress), addressLength) != SocketError) {
+#if defined(Q_OS_WIN)
+        int localAddressLength = sizeof(socketAddress);
+#else
+        socklen_t localAddressLength = sizeof(socketAddress);
+#endif
+        memset(&socketAddress, 0, sizeof(socketAddress));
+
+        auto result = getsockname(
+            socketDescriptor,
+            reinterpret_cast<sockaddr *>(&socketAddress),
+            &localAddressLength
+        );
+
+        if (result != SocketError) {
+            localAddress = QHostAddress(reinterpret_cast<sockaddr *>(&socketAddress));
+        }
+    }
+
+#if defined(Q_OS_WIN)
+    closesocket(socketDescriptor);
+#else
+    close(socketDescriptor);
+#endif
+
+    return localAddress;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::recvfrom(
+        QByteArray &buffer,
+        QHostAddress &receiveAddress,
+        int timeout) -> int {
+
+    if (m_isSimulated) {
+        QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+
+        if (receiveSimulated(datagrams, 1, timeout) <= 0) {
+            return -1;
+        }
+
+        buffer = datagrams.first().buffer;
+        receiveAddress = datagrams.first().socketAddress.toHostAddress();
+
+        return buffer.length();
+    }
+
+#if defined(Q_OS_UNIX)
+    socklen_t addressLength;
+#elif defined(Q_OS_WIN)
+    int addressLength;
+
+    int (WSAAPI *poll)(struct pollfd *, ulong , int ) = WSAPoll;
+#endif
+    struct sockaddr_storage fromAddress = {};
+    struct pollfd descriptorSet = {};
+
+    descriptorSet.fd = m_socketDescriptor;
+    descriptorSet.events = POLLIN;
+
+    auto numberOfReadyDescriptors = poll(&descriptorSet, 1, timeout);
+
+    if (numberOfReadyDescriptors > 0) {
+        if (descriptorSet.revents & POLLIN) {
+            memset(&fromAddress, 0, sizeof(fromAddress));
+
+            addressLength = sizeof(fromAddress);
+
+            buffer.resize(ReceiveBufferSize);
+
+            auto result = ::recvfrom(
+                m_socketDescriptor,
+                buffer.data(),
+                buffer.length(),
+                0,
+                reinterpret_cast<sockaddr *>(&fromAddress),
+                &addressLength
+            );
+
+            if (result >= 0) {
+                receiveAddress = QHostAddress(reinterpret_cast<sockaddr *>(&fromAddress));
+
+                buffer.resize(result);
+            }
+
+            return result;
+        }
+    }
+
+    return -1;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::waitForRead(
+        const QList<Nedrysoft::ICMPSocket::ICMPSocket *> &sockets,
+        int timeout) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *> {
+
+#if defined(Q_OS_WIN)
+    int (WSAAPI *poll)(struct pollfd *, ulong , int ) = WSAPoll;
+#endif
+    QList<Nedrysoft::ICMPSocket::ICMPSocket *> readySockets;
+    std::vector<struct pollfd> descriptorSet(sockets.count());
+
+    for (auto index = 0; index < sockets.count(); index++) {
+        descriptorSet[index].fd = sockets.at(index)->m_socketDescriptor;
+        descriptorSet[index].events = POLLIN;
+        descriptorSet[index].revents = 0;
+    }
+
+    auto numberOfReadyDescriptors = poll(descriptorSet.data(), static_cast<int>(descriptorSet.size()), timeout);
+
+    if (numberOfReadyDescriptors > 0) {
+        for (auto index = 0; index < sockets.count(); index++) {
+            if (descriptorSet[index].revents & POLLIN) {
+                readySockets.append(sockets.at(index));
+            }
+        }
+    }
+
+    return readySockets;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::recvmmsg(
+        QList<Nedrysoft::ICMPSocket::Datagram> &datagrams,
+        int maximumDatagrams,
+        int timeout) -> int {
+
+    if (m_isSimulated) {
+        return receiveSimulated(datagrams, maximumDatagrams, timeout);
+    }
+
+#if defined(Q_OS_LINUX)
+    struct pollfd descriptorSet = {};
+
+    descriptorSet.fd = m_socketDescriptor;
+    descriptorSet.events = POLLIN;
+
+    auto numberOfReadyDescriptors = poll(&descriptorSet, 1, timeout);
+
+    if (numberOfReadyDescriptors <= 0) {
+        return -1;
+    }
+
+    auto errorCount = 0;
+
+    if ((m_isDatagram) && (descriptorSet.revents & POLLERR)) {
+        errorCount = receiveErrors(datagrams, maximumDatagrams);
+    }
+
+    if ((!(descriptorSet.revents & POLLIN)) || (errorCount == maximumDatagrams)) {
+        return errorCount ? errorCount : -1;
+    }
+
+    maximumDatagrams -= errorCount;
+
+    std::vector<struct mmsghdr> messages(maximumDatagrams);
+    std::vector<struct iovec> vectors(maximumDatagrams);
+    std::vector<struct sockaddr_storage> addresses(maximumDatagrams);
+    std::vector<char> receiveBuffers(static_cast<size_t>(maximumDatagrams) * ReceiveBufferSize);
+    std::vector<char> controlBuffers(static_cast<size_t>(maximumDatagrams) * ControlBufferSize);
+
+    for (auto index = 0; index < maximumDatagrams; index++) {
+        memset(&messages[index], 0, sizeof(struct mmsghdr));
+
+        vectors[index].iov_base = &receiveBuffers[static_cast<size_t>(index) * ReceiveBufferSize];
+        vectors[index].iov_len = ReceiveBufferSize;
+
+        messages[index].msg_hdr.msg_name = &addresses[index];
+        messages[index].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        messages[index].msg_hdr.msg_iov = &vectors[index];
+        messages[index].msg_hdr.msg_iovlen = 1;
+        messages[index].msg_hdr.msg_control = &controlBuffers[static_cast<size_t>(index) * ControlBufferSize];
+        messages[index].msg_hdr.msg_controllen = ControlBufferSize;
+    }
+
+    auto result = ::recvmmsg(m_socketDescriptor, messages.data(), maximumDatagrams, MSG_DONTWAIT, nullptr);
+
+    if (result <= 0) {
+        return errorCount ? errorCount : -1;
+    }
+
+    auto fallbackTimestamp = currentTimestamp();
+
+    for (auto index = 0; index < result; index++) {
+        Nedrysoft::ICMPSocket::Datagram datagram;
+
+        auto &header = messages[index].msg_hdr;
+
+        datagram.buffer = QByteArray(
+            static_cast<const char *>(vectors[index].iov_base),
+            static_cast<int>(messages[index].msg_len)
+        );
+
+        datagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(
+            reinterpret_cast<sockaddr *>(&addresses[index]) );
+        datagram.result = static_cast<int>(messages[index].msg_len);
+        datagram.timestamp = fallbackTimestamp;
+
+        readControlMessages(header, datagram);
+
+        datagrams.append(datagram);
+    }
+
+    return result + errorCount;
+#else
+    auto receivedCount = 0;
+
+    while (receivedCount < maximumDatagrams) {
+        Nedrysoft::ICMPSocket::Datagram datagram;
+
+        datagram.result = recvfrom(datagram.buffer, datagram.hostAddress, receivedCount ? 0 : timeout);
+
+        if (datagram.result < 0) {
+            break;
+        }
+
+        datagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(datagram.hostAddress);
+
+        datagram.timestamp = currentTimestamp();
+
+        datagrams.append(datagram);
+
+        receivedCount++;
+    }
+
+    return receivedCount ? receivedCount : -1;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp() -> qint64 {
+    return Nedrysoft::ICMPSocket::ICMPSocketClock::now();
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::sendto(QByteArray &buffer, const QHostAddress &hostAddress) -> int {
+    return sendto(buffer, Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(hostAddress));
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::sendto(
+        QByteArray &buffer,
+        const Nedrysoft::ICMPSocket::SocketAddress &socketAddress) -> int {
+
+    if (m_isSimulated) {
+        auto simulator = socketSimulator.load();
+
+        Nedrysoft::ICMPSocket::Datagram datagram;
+
+        datagram.buffer = buffer;
+        datagram.hostAddress = socketAddress.toHostAddress();
+        datagram.socketAddress = socketAddress;
+        datagram.ttl = m_ttl;
+
+        return simulator ? simulator->send(this, datagram) : -1;
+    }
+
+    struct sockaddr_storage toAddress;
+
+    auto addressLength = socketAddress.toSocketAddress(toAddress);
+
+    if (!addressLength) {
+        return -1;
+    }
+
+#if defined(Q_OS_LINUX)
+    QMutexLocker transmitLocker(&m_transmitMutex);
+
+    auto transmitKey = requestKey(buffer);
+#endif
+
+    if (m_isDatagram) {
+        mapSequence(buffer);
+    }
+
+    auto result = ::sendto(m_socketDescriptor, buffer.data(), buffer.length(), 0,
+                           reinterpret_cast<struct sockaddr *>(&toAddress), addressLength);
+
+#if defined(Q_OS_LINUX)
+    if ((m_transmitTimestamps) && (result != SocketError)) {
+        m_transmitKeyMap[m_transmitKey++ & SequenceMask] = transmitKey;
+    }
+#endif
+
+    return static_cast<int>(result);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::sendmmsg(QList<Nedrysoft::ICMPSocket::Datagram> &datagrams) -> int {
+    auto sentCount = 0;
+
+    if (m_isSimulated) {
+        auto simulator = socketSimulator.load();
+
+        for (auto &datagram : datagrams) {
+            if (!datagram.ttl) {
+                datagram.ttl = m_ttl;
+            }
+
+            datagram.result = simulator ? simulator->send(this, datagram) : -1;
+
+            if (datagram.result != SocketError) {
+                sentCount++;
+            }
+        }
+
+        return sentCount;
+    }
+
+#if defined(Q_OS_LINUX)
+    auto datagramCount = static_cast<int>(datagrams.count());
+
+    std::vector<struct mmsghdr> messages(datagramCount);
+    std::vector<struct iovec> vectors(datagramCount);
+    std::vector<struct sockaddr_storage> addresses(datagramCount);
+    std::vector<char> controlBuffers(static_cast<size_t>(datagramCount) * CMSG_SPACE(sizeof(int)));
+    std::vector<uint32_t> transmitKeys;
+
+    /**
+     * the kernel numbers transmit timestamps in the order the datagrams were sent, the lock is held for every send
+     * so that the numbering cannot change while timestamps are being enabled or while another thread is sending.
+     */
+
+    QMutexLocker transmitLocker(&m_transmitMutex);
+
+    if (m_transmitTimestamps) {
+        transmitKeys.resize(static_cast<size_t>(datagramCount));
+    }
+
+    for (auto index = 0; index < datagramCount; index++) {
+        auto &datagram = datagrams[index];
+
+        datagram.result = -1;
+
+        if (m_transmitTimestamps) {
+            transmitKeys[static_cast<size_t>(index)] = requestKey(datagram.buffer);
+        }
+
+        if (m_isDatagram) {
+            mapSequence(datagram.buffer);
+        }
+
+        vectors[index].iov_base = datagram.buffer.data();
+        vectors[index].iov_len = static_cast<size_t>(datagram.buffer.length());
+
+        memset(&messages[index], 0, sizeof(struct mmsghdr));
+
+        auto &header = messages[index].msg_hdr;
+
+        // a datagram addressed with a socket address is sent without converting a QHostAddress.
+
+        auto addressLength = datagram.socketAddress.isNull() ?
+            toSocketAddress(datagram.hostAddress, m_version, addresses[index]) :
+            datagram.socketAddress.toSocketAddress(addresses[index]);
+
+        header.msg_name = &addresses[index];
+        header.msg_namelen = static_cast<socklen_t>(addressLength);
+        header.msg_iov = &vectors[index];
+        header.msg_iovlen = 1;
+
+        if (datagram.ttl) {
+            header.msg_control = &controlBuffers[static_cast<size_t>(index) * CMSG_SPACE(sizeof(int))];
+            header.msg_controllen = CMSG_SPACE(sizeof(int));
+
+            auto controlMessage = CMSG_FIRSTHDR(&header);
+
+            if (m_version == V4) {
+                controlMessage->cmsg_level = IPPROTO_IP;
+                controlMessage->cmsg_type = IP_TTL;
+            } else {
+                controlMessage->cmsg_level = IPPROTO_IPV6;
+                controlMessage->cmsg_type = IPV6_HOPLIMIT;
+            }
+
+            controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+
+            memcpy(CMSG_DATA(controlMessage), &datagram.ttl, sizeof(int));
+        }
+    }
+
+    auto nextIndex = 0;
+
+    while (nextIndex < datagramCount) {
+        auto batchSize = qMin(datagramCount - nextIndex, static_cast<int>(UIO_MAXIOV));
+
+        auto result = ::sendmmsg(m_socketDescriptor, &messages[nextIndex], batchSize, 0);
+
+        if (result <= 0) {
+            if ((result == SocketError) && (errno == EINTR)) {
+                continue;
+            }
+
+            /**
+             * the kernel stops a batch at the first datagram that fails (for example an unreachable destination or
+             * a datagram too big to send unfragmented), it is left marked as failed and the rest are still sent.
+             */
+
+            nextIndex++;
+
+            continue;
+        }
+
+        for (auto index = nextIndex; index < nextIndex + result; index++) {
+            datagrams[index].result = static_cast<int>(messages[index].msg_len);
+
+            if (!transmitKeys.empty()) {
+                m_transmitKeyMap[m_transmitKey++ & SequenceMask] = transmitKeys[static_cast<size_t>(index)];
+            }
+        }
+
+        nextIndex += result;
+        sentCount += result;
+    }
+#else
+    QMutexLocker locker(&m_sendMutex);
+
+    for (auto &datagram : datagrams) {
+        if ((datagram.ttl) && (datagram.ttl != m_ttl)) {
+            if (m_version == V4) {
+                setTTL(datagram.ttl);
+            } else {
+                setHopLimit(datagram.ttl);
+            }
+        }
+
+        if (datagram.socketAddress.isNull()) {
+            datagram.result = sendto(datagram.buffer, datagram.hostAddress);
+        } else {
+            datagram.result = sendto(datagram.buffer, datagram.socketAddress);
+        }
+
+        if (datagram.result != SocketError) {
+            sentCount++;
+        }
+    }
+#endif
+
+    return sentCount;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::toSocketAddress(
+        const QHostAddress &hostAddress,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        sockaddr_storage &socketAddress) -> int {
+
+    memset(&socketAddress, 0, sizeof(socketAddress));
+
+    if (version == V4) {
+        auto toAddress = reinterpret_cast<struct sockaddr_in *>(&socketAddress);
+
+        toAddress->sin_family = AF_INET;
+        toAddress->sin_addr.s_addr = qToBigEndian<uint32_t>(hostAddress.toIPv4Address());
+
+        return sizeof(struct sockaddr_in);
+    } else if (version == V6) {
+        auto toAddress = reinterpret_cast<struct sockaddr_in6 *>(&socketAddress);
+
+        auto destinationAddress = hostAddress.toIPv6Address();
+
+        toAddress->sin6_family = AF_INET6;
+        memcpy(toAddress->sin6_addr.s6_addr, &destinationAddress, 16);
+
+        return sizeof(struct sockaddr_in6);
+    }
+
+    return 0;
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(
+        const QHostAddress &hostAddress) -> Nedrysoft::ICMPSocket::SocketAddress {
+
+    Nedrysoft::ICMPSocket::SocketAddress socketAddress;
+
+    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        socketAddress.version = V4;
+
+        qToBigEndian<uint32_t>(hostAddress.toIPv4Address(), socketAddress.address);
+    } else if (hostAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto ipv6Address = hostAddress.toIPv6Address();
+
+        socketAddress.version = V6;
+
+        memcpy(socketAddress.address, &ipv6Address, IPv6AddressLength);
+    }
+
+    return socketAddress;
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(
+        const sockaddr *socketAddress) -> Nedrysoft::ICMPSocket::SocketAddress {
+
+    Nedrysoft::ICMPSocket::SocketAddress address;
+
+    if (socketAddress->sa_family == AF_INET) {
+        address.version = V4;
+
+        memcpy(
+            address.address,
+            &reinterpret_cast<const struct sockaddr_in *>(socketAddress)->sin_addr,
+            IPv4AddressLength );
+    } else if (socketAddress->sa_family == AF_INET6) {
+        address.version = V6;
+
+        memcpy(
+            address.address,
+            &reinterpret_cast<const struct sockaddr_in6 *>(socketAddress)->sin6_addr,
+            IPv6AddressLength );
+    }
+
+    return address;
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::isNull() const -> bool {
+    return !version;
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::toHostAddress() const -> QHostAddress {
+    if (version == V4) {
+        return QHostAddress(qFromBigEndian<uint32_t>(address));
+    } else if (version == V6) {
+        return QHostAddress(address);
+    }
+
+    return QHostAddress();
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::toSocketAddress(sockaddr_storage &socketAddress) const -> int {
+    memset(&socketAddress, 0, sizeof(socketAddress));
+
+    if (version == V4) {
+        auto toAddress = reinterpret_cast<struct sockaddr_in *>(&socketAddress);
+
+        toAddress->sin_family = AF_INET;
+
+        memcpy(&toAddress->sin_addr, address, IPv4AddressLength);
+
+        return sizeof(struct sockaddr_in);
+    } else if (version == V6) {
+        auto toAddress = reinterpret_cast<struct sockaddr_in6 *>(&socketAddress);
+
+        toAddress->sin6_family = AF_INET6;
+
+        memcpy(&toAddress->sin6_addr, address, IPv6AddressLength);
+
+        return sizeof(struct sockaddr_in6);
+    }
+
+    return 0;
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::operator==(const Nedrysoft::ICMPSocket::SocketAddress &other) const -> bool {
+    return (version == other.version) && (!memcmp(address, other.address, sizeof(address)));
+}
+
+auto Nedrysoft::ICMPSocket::SocketAddress::operator!=(const Nedrysoft::ICMPSocket::SocketAddress &other) const -> bool {
+    return !(*this == other);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::isValid(Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket) -> bool {
+#if defined(Q_OS_WIN)
+    return socket!=INVALID_SOCKET;
+#else
+    return socket != -1;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::initialiseSockets() -> void {
+    static auto initialised = false;
+
+    if (!initialised) {
+#if defined(Q_OS_WIN)
+        WSADATA wsaData;
+
+        if (WSAStartup(MAKEWORD(2,2), &wsaData)!=0) {
+            qDebug() << "error initialising winsock";
+        }
+#endif
+        initialised = true;
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::setTTL(int ttl) -> void {
+    if (m_isSimulated) {
+        m_ttl = ttl;
+
+        return;
+    }
+
+    auto result = setsockopt(m_socketDescriptor, IPPROTO_IP, IP_TTL, reinterpret_cast<char *>(&ttl), sizeof(ttl));
+
+    m_ttl = ttl;
+
+    if (result == SocketError) {
+        qWarning() << QObject::tr("Error setting TTL.");
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::setHopLimit(int hopLimit) -> void {
+    if (m_isSimulated) {
+        m_ttl = hopLimit;
+
+        return;
+    }
+
+    auto result = setsockopt(m_socketDescriptor, IPPROTO_IPV6, IPV6_UNICAST_HOPS, reinterpret_cast<char *>(&hopLimit),
+                             sizeof(hopLimit));
+
+    m_ttl = hopLimit;
+
+    if (result == SocketError) {
+        qWarning() << QObject::tr("Error setting Hop Limit.");
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::setDontFragment(bool dontFragment) -> bool {
+    int result = SocketError;
+
+    if (m_isSimulated) {
+        return true;
+    }
+
+    if (m_version == V4) {
+#if defined(Q_OS_LINUX)
+        int value = dontFragment ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+
+        result = setsockopt(m_socketDescriptor, IPPROTO_IP, IP_MTU_DISCOVER, &value, sizeof(value));
+#elif defined(Q_OS_WIN)
+        DWORD value = dontFragment ? TRUE : FALSE;
+
+        result = setsockopt(m_socketDescriptor, IPPROTO_IP, IP_DONTFRAGMENT, reinterpret_cast<char *>(&value),
+                            sizeof(value));
+#elif defined(IP_DONTFRAG)
+        int value = dontFragment ? 1 : 0;
+
+        result = setsockopt(m_socketDescriptor, IPPROTO_IP, IP_DONTFRAG, &value, sizeof(value));
+#endif
+    } else {
+#if defined(IPV6_DONTFRAG)
+        int value = dontFragment ? 1 : 0;
+
+        result = setsockopt(m_socketDescriptor, IPPROTO_IPV6, IPV6_DONTFRAG, reinterpret_cast<char *>(&value),
+                            sizeof(value));
+#endif
+    }
+
+    if (result == SocketError) {
+        qWarning() << QObject::tr("Error setting don't fragment.");
+
+        return false;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::bindToSource(const QString &source) -> bool {
+    if (m_isSimulated) {
+        return true;
+    }
+
+    if (!bindSocket(m_socketDescriptor, m_version, source)) {
+        qWarning() << QObject::tr("Error binding socket to %1.").arg(source);
+
+        return false;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::bindSocket(
+        Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket,
+        Nedrysoft::ICMPSocket::IPVersion version,
+        const QString &source) -> bool {
+
+    auto address = QHostAddress(source);
+
+    if (address.isNull()) {
+#if defined(Q_OS_LINUX)
+        auto interfaceName = source.toLocal8Bit();
+
+        auto result = setsockopt(
+            socket,
+            SOL_SOCKET,
+            SO_BINDTODEVICE,
+            interfaceName.constData(),
+            static_cast<socklen_t>(interfaceName.length())
+        );
+
+        return result != SocketError;
+#elif defined(Q_OS_MACOS)
+        auto interfaceIndex = if_nametoindex(source.toLocal8Bit().constData());
+
+        if (!interfaceIndex) {
+            return false;
+        }
+
+        int result;
+
+        if (version == V4) {
+            result = setsockopt(socket, IPPROTO_IP, IP_BOUND_IF, &interfaceIndex, sizeof(interfaceIndex));
+        } else {
+            result = setsockopt(socket, IPPROTO_IPV6, IPV6_BOUND_IF, &interfaceIndex, sizeof(interfaceIndex));
+        }
+
+        return result != SocketError;
+#else
+        // without a way to bind to the device the socket is bound to an address of the interface instead.
+
+        auto addressProtocol = (version == V4) ? QAbstractSocket::IPv4Protocol : QAbstractSocket::IPv6Protocol;
+
+        for (auto &entry : QNetworkInterface::interfaceFromName(source).addressEntries()) {
+            if ((entry.ip().protocol() == addressProtocol) && (!entry.ip().isLinkLocal())) {
+                address = entry.ip();
+
+                break;
+            }
+        }
+
+        if (address.isNull()) {
+            return false;
+        }
+#endif
+    }
+
+    sockaddr_storage socketAddress;
+
+    auto addressLength = toSocketAddress(address, version, socketAddress);
+
+    if (!addressLength) {
+        return false;
+    }
+
+    return ::bind(socket, reinterpret_cast<sockaddr *>(&socketAddress), addressLength) != SocketError;
+}
+
+auto  Nedrysoft::ICMPSocket::ICMPSocket::version() -> Nedrysoft::ICMPSocket::IPVersion {
+    return m_version;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::ttl() -> int {
     return m_ttl;
-}
\ No newline at end of file
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::isDatagram() -> bool {
+    return m_isDatagram;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::protocol() -> Nedrysoft::ICMPSocket::Protocol {
+    return m_protocol;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::usesDatagramSockets() -> bool {
+    if (socketSimulator.load()) {
+        return false;
+    }
+
+#if defined(Q_OS_LINUX)
+    static const auto useDatagramSockets = []() {
+        // a raw socket from the privileged helper is preferred, datagram sockets do not receive every error.
+
+        auto socketDescriptor = rawSocket(AF_INET, IPPROTO_ICMP);
+
+        if (socketDescriptor != -1) {
+            close(socketDescriptor);
+
+            return false;
+        }
+
+        return datagramSocketsPermitted();
+    }();
+
+    return useDatagramSockets;
+#else
+    return false;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::datagramSocketsPermitted() -> bool {
+#if defined(Q_OS_LINUX)
+    QFile rangeFile(PingGroupRangePath);
+
+    if (!rangeFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    auto range = QString::fromLatin1(rangeFile.readAll()).simplified().split(' ');
+
+    if (range.count() != 2) {
+        return false;
+    }
+
+    auto minimumGroup = range.at(0).toULongLong();
+    auto maximumGroup = range.at(1).toULongLong();
+
+    auto inRange = [minimumGroup, maximumGroup](gid_t group) {
+        return (group >= minimumGroup) && (group <= maximumGroup);
+    };
+
+    if (inRange(getegid())) {
+        return true;
+    }
+
+    auto groupCount = getgroups(0, nullptr);
+
+    if (groupCount <= 0) {
+        return false;
+    }
+
+    std::vector<gid_t> groups(static_cast<size_t>(groupCount));
+
+    groupCount = getgroups(groupCount, groups.data());
+
+    for (auto index = 0; index < groupCount; index++) {
+        if (inRange(groups[index])) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::receiveDrops() -> quint32 {
+    return m_receiveDrops;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::enableTransmitTimestamps() -> bool {
+    if ((m_isSimulated) || (m_protocol != Nedrysoft::ICMPSocket::ICMP)) {
+        return false;
+    }
+
+#if defined(Q_OS_LINUX)
+    QMutexLocker transmitLocker(&m_transmitMutex);
+
+    if (m_transmitTimestamps) {
+        return true;
+    }
+
+    if (!m_isDatagram) {
+        // the error queue is charged against the receive buffer, a raw write socket would otherwise fill it with
+        // copies of every ICMP packet and the timestamps would be dropped, so everything else is dropped instead.
+
+        struct sock_filter dropAll[] = {
+            BPF_STMT(BPF_RET | BPF_K, 0)
+        };
+
+        struct sock_fprog filterProgram = {};
+
+        filterProgram.len = sizeof(dropAll) / sizeof(dropAll[0]);
+        filterProgram.filter = dropAll;
+
+        auto result = setsockopt(m_socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &filterProgram, sizeof(filterProgram));
+
+        if (result == SocketError) {
+            qWarning() << QObject::tr("Error attaching receive filter to write socket");
+        }
+    }
+
+    int flags =
+        SOF_TIMESTAMPING_TX_SOFTWARE |
+        SOF_TIMESTAMPING_TX_HARDWARE |
+        SOF_TIMESTAMPING_SOFTWARE |
+        SOF_TIMESTAMPING_RX_HARDWARE |
+        SOF_TIMESTAMPING_RAW_HARDWARE |
+        SOF_TIMESTAMPING_OPT_ID |
+        SOF_TIMESTAMPING_OPT_TSONLY;
+
+    if (setsockopt(m_socketDescriptor, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == SocketError) {
+        qWarning() << QObject::tr("Error enabling transmit timestamps on socket");
+
+        return false;
+    }
+
+    m_transmitKeyMap.reset(new uint32_t[SequenceMapSize]());
+    m_transmitKey = 0;
+    m_transmitTimestamps = true;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::transmitTimestampsEnabled() -> bool {
+    return m_transmitTimestamps;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::setIdentifierFilter(const QList<uint16_t> &identifiers) -> bool {
+#if defined(Q_OS_LINUX)
+    if ((m_isSimulated) || (m_isDatagram) || (m_protocol != Nedrysoft::ICMPSocket::ICMP)) {
+        return false;
+    }
+
+    auto program = identifierFilter(m_version, std::vector<uint16_t>(identifiers.begin(), identifiers.end()));
+
+    struct sock_fprog filterProgram = {};
+
+    filterProgram.len = static_cast<unsigned short>(program.size());
+    filterProgram.filter = program.data();
+
+    // attaching a filter replaces the previous one atomically, so no packet is seen unfiltered while it changes.
+
+    auto result = setsockopt(m_socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &filterProgram, sizeof(filterProgram));
+
+    if (result == SocketError) {
+        qWarning() << QObject::tr("Error attaching identifier filter to socket");
+
+        return false;
+    }
+
+    return true;
+#else
+    Q_UNUSED(identifiers)
+
+    return false;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::receiveTransmitTimestamps(
+        QList<Nedrysoft::ICMPSocket::TransmitTimestamp> &timestamps) -> int {
+
+    if (!m_transmitTimestamps) {
+        return 0;
+    }
+
+    if (!m_isDatagram) {
+        // a raw socket does not queue ICMP errors, so the error queue only holds timestamps.
+
+        QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+
+        receiveErrors(datagrams, 1);
+    }
+
+    QMutexLocker transmitLocker(&m_transmitMutex);
+
+    auto count = static_cast<int>(m_pendingTransmitTimestamps.count());
+
+    timestamps.append(m_pendingTransmitTimestamps);
+
+    m_pendingTransmitTimestamps.clear();
+
+    return count;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::enableDatagramOptions(
+        Nedrysoft::ICMPSocket::ICMPSocket::socket_t socket,
+        IPVersion version) -> void {
+
+#if defined(Q_OS_LINUX)
+    int enable = 1;
+
+    if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == SocketError) {
+        qWarning() << QObject::tr("Error enabling kernel receive timestamps on socket");
+    }
+
+    if (setsockopt(socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == SocketError) {
+        qWarning() << QObject::tr("Error enabling receive queue overflow reporting on socket");
+    }
+
+    enableHardwareReceiveTimestamps(socket);
+
+    auto result = 0;
+
+    if (version == V4) {
+        result = setsockopt(socket, IPPROTO_IP, IP_RECVERR, &enable, sizeof(enable));
+
+        if (result != SocketError) {
+            result = setsockopt(socket, IPPROTO_IP, IP_RECVTTL, &enable, sizeof(enable));
+        }
+    } else {
+        result = setsockopt(socket, IPPROTO_IPV6, IPV6_RECVERR, &enable, sizeof(enable));
+    }
+
+    if (result == SocketError) {
+        qWarning() << QObject::tr("Error enabling ICMP error reporting on socket");
+    }
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(version)
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::mapSequence(QByteArray &buffer) -> void {
+    if (buffer.length() < ICMPHeaderLength) {
+        return;
+    }
+
+    auto header = reinterpret_cast<uint8_t *>(buffer.data());
+
+    auto sequence = m_datagramSequence.fetch_add(1, std::memory_order_relaxed);
+
+    m_datagramSequenceMap[sequence].store(
+        (static_cast<uint32_t>(qFromBigEndian<uint16_t>(header + ICMPIdOffset)) << SequenceBits) |
+        qFromBigEndian<uint16_t>(header + ICMPSequenceOffset),
+        std::memory_order_release
+    );
+
+    // the kernel replaces the id and calculates the checksum itself, so only the sequence needs to be written.
+
+    qToBigEndian<uint16_t>(sequence, header + ICMPSequenceOffset);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::restoreSequence(uint8_t *icmpHeader, int length) -> void {
+    if (length < ICMPHeaderLength) {
+        return;
+    }
+
+    auto original = m_datagramSequenceMap[qFromBigEndian<uint16_t>(icmpHeader + ICMPSequenceOffset)].load(
+        std::memory_order_acquire
+    );
+
+    qToBigEndian<uint16_t>(static_cast<uint16_t>(original >> SequenceBits), icmpHeader + ICMPIdOffset);
+    qToBigEndian<uint16_t>(static_cast<uint16_t>(original & SequenceMask), icmpHeader + ICMPSequenceOffset);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::normaliseReply(Nedrysoft::ICMPSocket::Datagram &datagram, int ttl) -> void {
+    restoreSequence(reinterpret_cast<uint8_t *>(datagram.buffer.data()), datagram.buffer.length());
+
+    if (m_version == V4) {
+        datagram.buffer.prepend(ipv4Header(datagram.socketAddress, ttl));
+
+        datagram.result = datagram.buffer.length();
+    }
+}
+
+#if defined(Q_OS_LINUX)
+auto Nedrysoft::ICMPSocket::ICMPSocket::readControlMessages(
+        struct msghdr &header,
+        Nedrysoft::ICMPSocket::Datagram &datagram) -> void {
+
+    auto receivedTtl = -1;
+
+    for (auto controlMessage = CMSG_FIRSTHDR(&header);
+         controlMessage != nullptr;
+         controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+
+        if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPNS)) {
+            struct timespec kernelTime = {};
+
+            memcpy(&kernelTime, CMSG_DATA(controlMessage), sizeof(kernelTime));
+
+            // the kernel stamps packets with the system clock, which may have been stepped since we started.
+
+            datagram.timestamp = Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(
+                static_cast<qint64>(kernelTime.tv_sec) * 1000000000 + kernelTime.tv_nsec
+            );
+        } else if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SO_RXQ_OVFL)) {
+            uint32_t receiveDrops = 0;
+
+            memcpy(&receiveDrops, CMSG_DATA(controlMessage), sizeof(receiveDrops));
+
+            m_receiveDrops = receiveDrops;
+        } else if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPING)) {
+            struct scm_timestamping timestamps = {};
+
+            memcpy(&timestamps, CMSG_DATA(controlMessage), sizeof(timestamps));
+
+            datagram.hardwareTimestamp = toNanoseconds(timestamps.ts[2]);
+        } else if ((controlMessage->cmsg_level == IPPROTO_IP) && (controlMessage->cmsg_type == IP_TTL)) {
+            memcpy(&receivedTtl, CMSG_DATA(controlMessage), sizeof(receivedTtl));
+        }
+    }
+
+    if (m_isDatagram) {
+        normaliseReply(datagram, receivedTtl);
+    }
+}
+#endif
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::receiveErrors(
+        QList<Nedrysoft::ICMPSocket::Datagram> &datagrams,
+        int maximumDatagrams) -> int {
+
+    auto receivedCount = 0;
+
+#if defined(Q_OS_LINUX)
+    char receiveBuffer[ReceiveBufferSize];
+    char controlBuffer[ControlBufferSize];
+
+    while (receivedCount < maximumDatagrams) {
+        struct sockaddr_storage address = {};
+        struct iovec vector = {receiveBuffer, sizeof(receiveBuffer)};
+        struct msghdr header = {};
+
+        header.msg_name = &address;
+        header.msg_namelen = sizeof(address);
+        header.msg_iov = &vector;
+        header.msg_iovlen = 1;
+        header.msg_control = controlBuffer;
+        header.msg_controllen = sizeof(controlBuffer);
+
+        auto result = ::recvmsg(m_socketDescriptor, &header, MSG_ERRQUEUE | MSG_DONTWAIT);
+
+        if (result < 0) {
+            break;
+        }
+
+        struct sock_extended_err *socketError = nullptr;
+        struct scm_timestamping transmitTimes = {};
+        auto timestamp = currentTimestamp();
+
+        for (auto controlMessage = CMSG_FIRSTHDR(&header);
+             controlMessage != nullptr;
+             controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+
+            if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPNS)) {
+                struct timespec kernelTime = {};
+
+                memcpy(&kernelTime, CMSG_DATA(controlMessage), sizeof(kernelTime));
+
+                timestamp = Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(
+                    static_cast<qint64>(kernelTime.tv_sec) * 1000000000 + kernelTime.tv_nsec
+                );
+            } else if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_TIMESTAMPING)) {
+                memcpy(&transmitTimes, CMSG_DATA(controlMessage), sizeof(transmitTimes));
+            } else if (((controlMessage->cmsg_level == IPPROTO_IP) && (controlMessage->cmsg_type == IP_RECVERR)) ||
+                       ((controlMessage->cmsg_level == IPPROTO_IPV6) && (controlMessage->cmsg_type == IPV6_RECVERR))) {
+
+                socketError = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(controlMessage));
+            }
+        }
+
+        if ((socketError) && (socketError->ee_origin == SO_EE_ORIGIN_TIMESTAMPING)) {
+            if ((m_transmitTimestamps) && (socketError->ee_info == SCM_TSTAMP_SND)) {
+                Nedrysoft::ICMPSocket::TransmitTimestamp transmitTimestamp;
+
+                transmitTimestamp.timestamp = Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(
+                    toNanoseconds(transmitTimes.ts[0])
+                );
+                transmitTimestamp.hardwareTimestamp = toNanoseconds(transmitTimes.ts[2]);
+
+                QMutexLocker transmitLocker(&m_transmitMutex);
+
+                auto key = m_transmitKeyMap[socketError->ee_data & SequenceMask];
+
+                transmitTimestamp.id = static_cast<uint16_t>(key >> SequenceBits);
+                transmitTimestamp.sequence = static_cast<uint16_t>(key & SequenceMask);
+
+                m_pendingTransmitTimestamps.append(transmitTimestamp);
+            }
+
+            continue;
+        }
+
+        // errors raised by the local stack rather than by an ICMP message from the network are not replies.
+
+        if ((!socketError) || (result < ICMPHeaderLength)) {
+            continue;
+        }
+
+        if ((socketError->ee_origin != SO_EE_ORIGIN_ICMP) && (socketError->ee_origin != SO_EE_ORIGIN_ICMP6)) {
+            continue;
+        }
+
+        // the queued data is the echo request as it was sent, it is wrapped in an error of the reported type and
+        // code laid out as it would have been received on a raw socket.
+
+        auto request = QByteArray(receiveBuffer, static_cast<int>(result));
+
+        restoreSequence(reinterpret_cast<uint8_t *>(request.data()), request.length());
+
+        Nedrysoft::ICMPSocket::Datagram datagram;
+
+        datagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(SO_EE_OFFENDER(socketError));
+        datagram.timestamp = timestamp;
+
+        QByteArray icmpHeader(ICMPHeaderLength, 0);
+
+        if (m_version == V4) {
+            QByteArray requestHeader(IPv4HeaderLength, 0);
+
+            icmpHeader[0] = static_cast<char>(socketError->ee_type);
+            icmpHeader[1] = static_cast<char>(socketError->ee_code);
+
+            requestHeader[0] = static_cast<char>(IPv4VersionAndHeaderLength);
+            requestHeader[IPv4ProtocolOffset] = static_cast<char>(IPPROTO_ICMP);
+
+            datagram.buffer = ipv4Header(datagram.socketAddress, -1) + icmpHeader + requestHeader + request;
+        } else {
+            QByteArray requestHeader(IPv6HeaderLength, 0);
+
+            icmpHeader[0] = static_cast<char>(socketError->ee_type);
+            icmpHeader[1] = static_cast<char>(socketError->ee_code);
+
+            requestHeader[0] = static_cast<char>(IPv6Version);
+            requestHeader[IPv6NextHeaderOffset] = static_cast<char>(IPPROTO_ICMPV6);
+
+            datagram.buffer = icmpHeader + requestHeader + request;
+        }
+
+        datagram.result = datagram.buffer.length();
+
+        datagrams.append(datagram);
+
+        receivedCount++;
+    }
+#else
+    Q_UNUSED(datagrams)
+    Q_UNUSED(maximumDatagrams)
+#endif
+
+    return receivedCount;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(Nedrysoft::ICMPSocket::ICMPSocketSimulator *simulator) -> void {
+    socketSimulator.store(simulator);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::simulator() -> Nedrysoft::ICMPSocket::ICMPSocketSimulator * {
+    return socketSimulator.load();
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::isSimulated() -> bool {
+    return m_isSimulated;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::createSimulatedSocket(
+        Nedrysoft::ICMPSocket::IPVersion version,
+        Nedrysoft::ICMPSocket::Protocol protocol) -> Nedrysoft::ICMPSocket::ICMPSocket * {
+
+#if defined(Q_OS_UNIX)
+    int descriptors[2];
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, descriptors) == SocketError) {
+        qWarning() << QObject::tr("Error creating simulated socket.");
+
+        return nullptr;
+    }
+
+    for (auto descriptor : descriptors) {
+        fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL, 0) | O_NONBLOCK); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    }
+
+    auto socketInstance = new Nedrysoft::ICMPSocket::ICMPSocket(descriptors[0], version, false, protocol);
+
+    socketInstance->m_isSimulated = true;
+    socketInstance->m_simulatorDescriptor = descriptors[1];
+
+    return socketInstance;
+#else
+    Q_UNUSED(version)
+    Q_UNUSED(protocol)
+
+    qWarning() << QObject::tr("Simulated sockets are not supported on this platform.");
+
+    return nullptr;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::deliver(const Nedrysoft::ICMPSocket::Datagram &datagram) -> void {
+#if defined(Q_OS_UNIX)
+    QMutexLocker locker(&m_simulatedMutex);
+
+    m_simulatedDatagrams.append(datagram);
+
+    auto &simulatedDatagram = m_simulatedDatagrams.last();
+
+    if (simulatedDatagram.result < 0) {
+        simulatedDatagram.result = datagram.buffer.length();
+    }
+
+    // a received datagram always carries the socket address, simulators may give either form.
+
+    if (simulatedDatagram.socketAddress.isNull()) {
+        simulatedDatagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(datagram.hostAddress);
+    } else if (simulatedDatagram.hostAddress.isNull()) {
+        simulatedDatagram.hostAddress = simulatedDatagram.socketAddress.toHostAddress();
+    }
+
+    // a single byte marks the socket as readable however many datagrams are queued behind it.
+
+    if (!m_simulatedSignalled) {
+        char marker = 0;
+
+        ::send(m_simulatorDescriptor, &marker, sizeof(marker), 0);
+
+        m_simulatedSignalled = true;
+    }
+#else
+    Q_UNUSED(datagram)
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocket::receiveSimulated(
+        QList<Nedrysoft::ICMPSocket::Datagram> &datagrams,
+        int maximumDatagrams,
+        int timeout) -> int {
+
+#if defined(Q_OS_UNIX)
+    if (timeout) {
+        struct pollfd descriptorSet = {};
+
+        descriptorSet.fd = m_socketDescriptor;
+        descriptorSet.events = POLLIN;
+
+        if (poll(&descriptorSet, 1, timeout) <= 0) {
+            return -1;
+        }
+    }
+
+    QMutexLocker locker(&m_simulatedMutex);
+
+    char marker;
+
+    while (::recv(m_socketDescriptor, &marker, sizeof(marker), 0) > 0) {
+    }
+
+    m_simulatedSignalled = false;
+
+    auto receivedCount = qMin(maximumDatagrams, static_cast<int>(m_simulatedDatagrams.count()));
+
+    for (auto index = 0; index < receivedCount; index++) {
+        datagrams.append(m_simulatedDatagrams.takeFirst());
+    }
+
+    if (!m_simulatedDatagrams.isEmpty()) {
+        marker = 0;
+
+        ::send(m_simulatorDescriptor, &marker, sizeof(marker), 0);
+
+        m_simulatedSignalled = true;
+    }
+
+    return receivedCount ? receivedCount : -1;
+#else
+    Q_UNUSED(datagrams)
+    Q_UNUSED(maximumDatagrams)
+    Q_UNUSED(timeout)
+
+    return -1;
+#endif
+}
@@ -45,7 +45,12 @@
 #endif
 
 #include <QByteArray>
+#include <QHash>
 #include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include <memory>
 
 #if ( defined(NEDRYSOFT_LIBRARY_ICMPSOCKET_EXPORT))
 #define NEDRYSOFT_ICMPSOCKET_DLLSPEC Q_DECL_EXPORT
@@ -54,11 +59,143 @@
 #endif
 
 namespace Nedrysoft { namespace ICMPSocket {
+    class ICMPSocketSimulator;
+
     enum IPVersion {
         V4 = 4,
         V6 = 6
     };
 
+    /**
+     * @brief           The protocol of the packets carried by a socket, the values are the IP protocol numbers.
+     */
+    enum Protocol {
+        ICMP = 1,
+        TCP = 6,
+        UDP = 17
+    };
+
+    /**
+     * @brief           The SocketAddress structure holds an IPv4 or IPv6 address in a compact form.
+     *
+     * @details         The structure is trivially copyable and is converted to and from a platform socket address
+     *                  by copying the address bytes, so the send and receive paths can carry addresses without the
+     *                  conversions and allocations of a QHostAddress.  A QHostAddress is only built when the address
+     *                  is reported.
+     */
+    struct NEDRYSOFT_ICMPSOCKET_DLLSPEC SocketAddress {
+        uint8_t address[16] = {};                   //!< the address in network byte order, IPv4 uses 4 bytes.
+        uint8_t version = 0;                        //!< the IPVersion of the address; or 0 if it is null.
+
+        /**
+         * @brief       Creates a socket address from a host address.
+         *
+         * @param[in]   hostAddress the host address.
+         *
+         * @returns     the socket address; or a null address if the host address is not IPv4 or IPv6.
+         */
+        static auto fromHostAddress(const QHostAddress &hostAddress) -> SocketAddress;
+
+        /**
+         * @brief       Creates a socket address from a platform socket address.
+         *
+         * @param[in]   socketAddress the platform socket address.
+         *
+         * @returns     the socket address; or a null address if the family is not IPv4 or IPv6.
+         */
+        static auto fromSocketAddress(const sockaddr *socketAddress) -> SocketAddress;
+
+        /**
+         * @brief       Returns whether the address is null.
+         *
+         * @returns     true if the address is null; otherwise false.
+         */
+        auto isNull() const -> bool;
+
+        /**
+         * @brief       Converts the address into a host address.
+         *
+         * @returns     the host address.
+         */
+        auto toHostAddress() const -> QHostAddress;
+
+        /**
+         * @brief       Converts the address into a platform socket address.
+         *
+         * @param[out]  socketAddress the platform socket address.
+         *
+         * @returns     the length of the socket address; otherwise 0 if the address is null.
+         */
+        auto toSocketAddress(sockaddr_storage &socketAddress) const -> int;
+
+        /**
+         * @brief       Compares two addresses.
+         *
+         * @param[in]   other the address to compare with.
+         *
+         * @returns     true if the addresses are the same; otherwise false.
+         */
+        auto operator==(const SocketAddress &other) const -> bool;
+
+        /**
+         * @brief       Compares two addresses.
+         *
+         * @param[in]   other the address to compare with.
+         *
+         * @returns     true if the addresses differ; otherwise false.
+         */
+        auto operator!=(const SocketAddress &other) const -> bool;
+    };
+
+    /**
+     * @brief           Returns the hash of a socket address for use as a QHash key.
+     *
+     * @param[in]       address the address.
+     * @param[in]       seed the seed of the hash.
+     *
+     * @returns         the hash.
+     */
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    inline auto qHash(const SocketAddress &address, size_t seed = 0) -> size_t {
+        return qHashBits(address.address, sizeof(address.address), seed ^ address.version);
+    }
+#else
+    inline auto qHash(const SocketAddress &address, uint seed = 0) -> uint {
+        return qHashBits(address.address, sizeof(address.address), seed ^ address.version);
+    }
+#endif
+
+    /**
+     * @brief           The Datagram structure describes a single packet in a batched send or receive.
+     *
+     * @details         A datagram to send may be addressed with either the socketAddress or the hostAddress, the
+     *                  socketAddress is used if it is not null.  A received datagram always has the socketAddress
+     *                  set, the hostAddress is not set by the receive paths that are batched.
+     */
+    struct Datagram {
+        QByteArray buffer;                          //!< the raw packet data.
+        QHostAddress hostAddress;                   //!< the destination (send) or source (receive) address.
+        SocketAddress socketAddress;                //!< the destination or source address in compact form.
+        int result = -1;                            //!< the number of bytes transferred; otherwise -1 on error.
+        int ttl = 0;                                //!< the ttl (or hop limit) to send with, 0 uses the socket ttl.
+        qint64 timestamp = -1;                      //!< the receive time in nanoseconds since the unix epoch.
+        qint64 hardwareTimestamp = -1;              //!< the receive time taken by the network adapter; or -1.
+    };
+
+    /**
+     * @brief           The TransmitTimestamp structure holds the time a request left the host.
+     *
+     * @details         The kernel stamps a request as it is handed to the network adapter, and an adapter with
+     *                  timestamping enabled stamps it again as it goes onto the wire.  The hardware time is taken
+     *                  from the clock of the adapter, so it can only be compared with a hardware receive time.
+     */
+    struct TransmitTimestamp {
+        uint16_t id = 0;                            //!< the id of the request.
+        uint16_t sequence = 0;                      //!< the sequence number of the request.
+        qint64 timestamp = -1;                      //!< the kernel transmit time in nanoseconds; or -1.
+        qint64 hardwareTimestamp = -1;              //!< the adapter transmit time in nanoseconds; or -1.
+    };
+
     /**
      * @brief           The ICMPSocket class abstracts the platform specific code for ICMP sockets.
      */
@@ -78,8 +215,15 @@ namespace Nedrysoft { namespace ICMPSocket {
              *
              * @param[in]   socket platform socket handle.
              * @param[in]   version version of IP of the socket to open.
+             * @param[in]   isDatagram true if the socket is a datagram ICMP socket.
+             * @param[in]   protocol the protocol of the socket.
              */
-            ICMPSocket(ICMPSocket::socket_t socket, IPVersion version = Nedrysoft::ICMPSocket::V4);
+            ICMPSocket(
+                ICMPSocket::socket_t socket,
+                IPVersion version = Nedrysoft::ICMPSocket::V4,
+                bool isDatagram = false,
+                Protocol protocol = Nedrysoft::ICMPSocket::ICMP
+            );
 
             /**
              * @brief       Checks whether the given platform socket is valid.
@@ -95,6 +239,146 @@ namespace Nedrysoft { namespace ICMPSocket {
              */
             static auto initialiseSockets() -> void;
 
+            /**
+             * @brief       Converts a host address into a platform socket address for the given IP version.
+             *
+             * @param[in]   hostAddress the address to convert.
+             * @param[in]   version the IP version of the socket.
+             * @param[out]  socketAddress the platform socket address.
+             *
+             * @returns     the length of the socket address; otherwise 0 if the version is invalid.
+             */
+            static auto toSocketAddress(
+                const QHostAddress &hostAddress,
+                Nedrysoft::ICMPSocket::IPVersion version,
+                sockaddr_storage &socketAddress
+            ) -> int;
+
+            /**
+             * @brief       Returns whether the system allows this process to create datagram ICMP sockets.
+             *
+             * @details     On Linux unprivileged ICMP sockets are only permitted for the groups listed in the
+             *              net.ipv4.ping_group_range sysctl, the effective and supplementary groups of the process
+             *              are checked against it.
+             *
+             * @returns     true if datagram ICMP sockets are permitted; otherwise false.
+             */
+            static auto datagramSocketsPermitted() -> bool;
+
+            /**
+             * @brief       Enables the socket options required to receive on a datagram ICMP socket.
+             *
+             * @param[in]   socket platform socket handle.
+             * @param[in]   version the IP version of the socket.
+             */
+            static auto enableDatagramOptions(ICMPSocket::socket_t socket, IPVersion version) -> void;
+
+            /**
+             * @brief       Binds a platform socket to a source address or network interface.
+             *
+             * @details     If the source is an address the socket is bound to it, otherwise the source is taken as
+             *              the name of an interface.  On Linux the socket is bound to the device (which on older
+             *              kernels requires CAP_NET_RAW), on macOS to the interface index and elsewhere to the
+             *              first address of the interface that matches the IP version.
+             *
+             * @param[in]   socket platform socket handle.
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   source the source address or interface name.
+             *
+             * @returns     true if the socket was bound; otherwise false.
+             */
+            static auto bindSocket(ICMPSocket::socket_t socket, IPVersion version, const QString &source) -> bool;
+
+            /**
+             * @brief       Replaces the sequence number of an outgoing echo request with a socket unique one.
+             *
+             * @details     Datagram sockets overwrite the ICMP id with one assigned by the kernel, so the id and
+             *              sequence number chosen by the caller are recorded against a sequence number that is
+             *              unique to this socket and restored when the reply (or error) is received.
+             *
+             * @param[in]   buffer the echo request.
+             */
+            auto mapSequence(QByteArray &buffer) -> void;
+
+            /**
+             * @brief       Restores the caller chosen id and sequence number in a received ICMP header.
+             *
+             * @param[in]   icmpHeader the ICMP header to update.
+             * @param[in]   length the number of bytes available from the start of the header.
+             */
+            auto restoreSequence(uint8_t *icmpHeader, int length) -> void;
+
+            /**
+             * @brief       Rewrites a datagram received on a datagram socket into the layout of a raw socket.
+             *
+             * @details     Datagram sockets deliver IPv4 replies without the IP header, a minimal header carrying
+             *              the received TTL is added so that replies can be parsed the same way regardless of the
+             *              socket type.
+             *
+             * @param[in]   datagram the received datagram.
+             * @param[in]   ttl the received TTL; otherwise -1 if unknown.
+             */
+            auto normaliseReply(Nedrysoft::ICMPSocket::Datagram &datagram, int ttl) -> void;
+
+#if defined(Q_OS_LINUX)
+            /**
+             * @brief       Reads the ancillary data of a received message into the datagram.
+             *
+             * @details     The kernel and adapter receive times, the receive queue drop count and the received TTL
+             *              are read, a reply received on a datagram socket is then normalised.
+             *
+             * @param[in]   header the message header holding the ancillary data.
+             * @param[in]   datagram the received datagram.
+             */
+            auto readControlMessages(struct msghdr &header, Nedrysoft::ICMPSocket::Datagram &datagram) -> void;
+#endif
+
+            /**
+             * @brief       Reads the queued errors from a datagram socket.
+             *
+             * @details     Time exceeded responses are not delivered to datagram sockets as packets, they are
+             *              queued as socket errors (IP_RECVERR) and are converted here into time exceeded packets
+             *              in the same layout as a raw socket would have received them.  Transmit timestamps are
+             *              queued on the same error queue, they are held for receiveTransmitTimestamps().
+             *
+             * @param[out]  datagrams the list to append the time exceeded packets to.
+             * @param[in]   maximumDatagrams the maximum number of errors to read.
+             *
+             * @returns     the number of datagrams appended.
+             */
+            auto receiveErrors(QList<Nedrysoft::ICMPSocket::Datagram> &datagrams, int maximumDatagrams) -> int;
+
+            /**
+             * @brief       Creates an in-process socket for the installed simulator.
+             *
+             * @details     The socket descriptor is one end of a local socket pair, a byte is written to the other
+             *              end while datagrams are queued so that the socket can be waited on like any other.
+             *
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   protocol the protocol of the socket.
+             *
+             * @returns     the socket instance; otherwise nullptr if it could not be created.
+             */
+            static auto createSimulatedSocket(
+                Nedrysoft::ICMPSocket::IPVersion version,
+                Nedrysoft::ICMPSocket::Protocol protocol
+            ) -> ICMPSocket *;
+
+            /**
+             * @brief       Reads the datagrams queued on a simulated socket.
+             *
+             * @param[out]  datagrams the list to append the datagrams to.
+             * @param[in]   maximumDatagrams the maximum number of datagrams to read.
+             * @param[in]   timeout the time to wait in milliseconds for a datagram, -1 waits forever.
+             *
+             * @returns     the number of datagrams read; otherwise -1 if none were available.
+             */
+            auto receiveSimulated(
+                QList<Nedrysoft::ICMPSocket::Datagram> &datagrams,
+                int maximumDatagrams,
+                int timeout
+            ) -> int;
+
         public:
             /**
              * @brief       Destroys the ICMPSocket.
@@ -104,6 +388,9 @@ namespace Nedrysoft { namespace ICMPSocket {
             /**
              * @brief       Creates a socket for reading ALL incoming ICMP packets.
              *
+             * @note        If usesDatagramSockets() is true the socket only receives replies to requests sent
+             *              from itself.
+             *
              * @param[in]   version the ip version of the socket to create.
              *
              * @returns      an instance of this class.
@@ -123,6 +410,83 @@ namespace Nedrysoft { namespace ICMPSocket {
                 Nedrysoft::ICMPSocket::IPVersion version = Nedrysoft::ICMPSocket::V4
              ) -> ICMPSocket *;
 
+            /**
+             * @brief       Returns the shared write socket for the given IP version.
+             *
+             * @details     The shared socket is created on first use and is owned by the library, it must not be
+             *              deleted by the caller.  The TTL is supplied per datagram when sending with sendmmsg,
+             *              so a single socket per address family can serve every target in every engine.
+             *
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   dontFragment true if the socket should send packets with the don't fragment flag set.
+             * @param[in]   source the source address or interface to bind the socket to, empty for the default.
+             *
+             * @returns     the shared write socket instance; otherwise nullptr if it could not be created.
+             */
+            static auto sharedWriteSocket(
+                Nedrysoft::ICMPSocket::IPVersion version = Nedrysoft::ICMPSocket::V4,
+                bool dontFragment = false,
+                const QString &source = QString()
+            ) -> ICMPSocket *;
+
+            /**
+             * @brief       Creates a raw socket for sending or receiving UDP or TCP probes.
+             *
+             * @details     The transport header is supplied by the caller, the IP header is added by the operating
+             *              system.  Probe sockets always require raw socket privileges, TCP probes are not
+             *              supported on Windows or macOS as neither deliver TCP packets to raw sockets.
+             *
+             * @param[in]   protocol the protocol of the socket, either UDP or TCP.
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   sendOnly true if the socket is only used to send, on Linux everything it would receive is
+             *              dropped.  UDP sockets from the privileged helper are always send only.
+             *
+             * @returns     the socket instance; otherwise nullptr if it could not be created.
+             */
+            static auto createProbeSocket(
+                Nedrysoft::ICMPSocket::Protocol protocol,
+                Nedrysoft::ICMPSocket::IPVersion version = Nedrysoft::ICMPSocket::V4,
+                bool sendOnly = false
+            ) -> ICMPSocket *;
+
+            /**
+             * @brief       Returns the shared socket for sending probes of the given protocol.
+             *
+             * @details     For ICMP this is the shared write socket, UDP and TCP probe sockets are created on first
+             *              use and are owned by the library.  On Linux the shared probe sockets are send only, the
+             *              replies are read from the receiver sockets.
+             *
+             * @param[in]   protocol the protocol of the probes.
+             * @param[in]   version the IP version of the socket.
+             * @param[in]   dontFragment true if the socket should send packets with the don't fragment flag set.
+             * @param[in]   source the source address or interface to bind the socket to, empty for the default.
+             *
+             * @returns     the shared socket instance; otherwise nullptr if it could not be created.
+             */
+            static auto sharedProbeSocket(
+                Nedrysoft::ICMPSocket::Protocol protocol,
+                Nedrysoft::ICMPSocket::IPVersion version = Nedrysoft::ICMPSocket::V4,
+                bool dontFragment = false,
+                const QString &source = QString()
+            ) -> ICMPSocket *;
+
+            /**
+             * @brief       Returns the local address that the operating system would use to reach a destination.
+             *
+             * @details     The address is required to calculate the checksum of UDP and TCP probes, no packets
+             *              are sent to determine it.
+             *
+             * @param[in]   destinationAddress the address of the destination.
+             * @param[in]   source the source address or interface that the packets are sent from, empty for the
+             *              default route.
+             *
+             * @returns     the source address; otherwise a null address if the destination is unreachable.
+             */
+            static auto sourceAddress(
+                const QHostAddress &destinationAddress,
+                const QString &source = QString()
+            ) -> QHostAddress;
+
             /**
              * @brief       Receives data from a read or write socket.
              *
@@ -134,6 +498,39 @@ namespace Nedrysoft { namespace ICMPSocket {
              */
             auto recvfrom(QByteArray &buffer, QHostAddress &receiveAddress, int timeout) -> int;
 
+            /**
+             * @brief       Waits for any of the given sockets to become readable.
+             *
+             * @details     Allows a single thread to service several sockets (for example an IPv4 and an IPv6
+             *              read socket) from one wait.
+             *
+             * @param[in]   sockets the sockets to wait on.
+             * @param[in]   timeout the maximum time to wait in milliseconds.
+             *
+             * @returns     the list of sockets that are readable, empty on timeout or error.
+             */
+            static auto waitForRead(
+                const QList<Nedrysoft::ICMPSocket::ICMPSocket *> &sockets,
+                int timeout
+            ) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *>;
+
+            /**
+             * @brief       Receives a batch of datagrams from a read socket.
+             *
+             * @details     Waits up to timeout milliseconds for the socket to become readable and then drains as
+             *              many datagrams as are available (up to maximumDatagrams) in a single wakeup.  On Linux
+             *              this uses recvmmsg and the receive time of each datagram is taken from the kernel
+             *              timestamp (SO_TIMESTAMPNS), on other platforms the datagrams are read individually and
+             *              time stamped as soon as the read returns.
+             *
+             * @param[out]  datagrams the list that received datagrams are appended to.
+             * @param[in]   maximumDatagrams the maximum number of datagrams to read.
+             * @param[in]   timeout read timeout in milliseconds.
+             *
+             * @returns     the number of datagrams received; otherwise -1 on timeout or error.
+             */
+            auto recvmmsg(QList<Nedrysoft::ICMPSocket::Datagram> &datagrams, int maximumDatagrams, int timeout) -> int;
+
             /**
              * @brief       Sends data to a write socket.
              *
@@ -144,6 +541,36 @@ namespace Nedrysoft { namespace ICMPSocket {
              */
             auto sendto(QByteArray &buffer, const QHostAddress &hostAddress) -> int;
 
+            /**
+             * @brief       Sends data to a write socket.
+             *
+             * @param[in]   buffer the data to send.
+             * @param[in]   socketAddress the address to send the packet to.
+             *
+             * @returns     -1 on error; otherwise the number of bytes written.
+             */
+            auto sendto(QByteArray &buffer, const Nedrysoft::ICMPSocket::SocketAddress &socketAddress) -> int;
+
+            /**
+             * @brief       Sends a batch of datagrams to a write socket.
+             *
+             * @details     On Linux the batch is submitted to the kernel using sendmmsg so that a complete set of
+             *              pings can be sent with a single system call, on other platforms this falls back to
+             *              calling sendto for each datagram.
+             *
+             *              If a datagram has a non zero ttl it is sent with that TTL (or hop limit), on Linux this
+             *              is passed as ancillary data with the datagram, on other platforms the socket option is
+             *              changed before the datagram is sent.
+             *
+             *              The result field of each datagram is updated with the number of bytes that were sent,
+             *              or -1 if the datagram could not be sent.
+             *
+             * @param[in,out]   datagrams the list of datagrams to send.
+             *
+             * @returns     the number of datagrams that were sent.
+             */
+            auto sendmmsg(QList<Nedrysoft::ICMPSocket::Datagram> &datagrams) -> int;
+
             /**
              * @brief       Sets the TTL on a write socket.
              *
@@ -165,6 +592,32 @@ namespace Nedrysoft { namespace ICMPSocket {
              */
             auto setHopLimit(int hopLimit) -> void;
 
+            /**
+             * @brief       Sets whether packets are sent with the don't fragment flag.
+             *
+             * @details     When set, packets larger than the path MTU are dropped rather than fragmented, this
+             *              allows MTU black holes to be detected.  For IPv6 the local stack will not fragment
+             *              the packet.
+             *
+             * @param[in]   dontFragment true to prevent fragmentation; otherwise false.
+             *
+             * @returns     true if the option was applied; otherwise false.
+             */
+            auto setDontFragment(bool dontFragment) -> bool;
+
+            /**
+             * @brief       Binds the socket to a source address or network interface.
+             *
+             * @details     Packets sent from a bound socket leave through the given interface (or the interface
+             *              that owns the address), which allows the same destination to be probed over different
+             *              uplinks at the same time.
+             *
+             * @param[in]   source the source address or interface name.
+             *
+             * @returns     true if the socket was bound; otherwise false.
+             */
+            auto bindToSource(const QString &source) -> bool;
+
             /**
              * @brief       Returns the IP version of the socket.
              *
@@ -172,12 +625,173 @@ namespace Nedrysoft { namespace ICMPSocket {
              */
             auto version() -> Nedrysoft::ICMPSocket::IPVersion;
 
+            /**
+             * @brief       Returns whether sockets are created as unprivileged datagram ICMP sockets.
+             *
+             * @details     On Linux raw sockets require elevated privileges, if they cannot be created and the
+             *              system permits it then datagram ICMP sockets are used instead.  A datagram socket only
+             *              receives replies to the requests that were sent from it, so the sockets used to send
+             *              must also be read from.
+             *
+             * @returns     true if datagram sockets are used; otherwise false.
+             */
+            static auto usesDatagramSockets() -> bool;
+
+            /**
+             * @brief       Returns whether this socket is a datagram ICMP socket.
+             *
+             * @returns     true if it is a datagram socket; otherwise false.
+             */
+            auto isDatagram() -> bool;
+
+            /**
+             * @brief       Returns the protocol of the socket.
+             *
+             * @returns     ICMP, UDP or TCP.
+             */
+            auto protocol() -> Nedrysoft::ICMPSocket::Protocol;
+
+            /**
+             * @brief       Returns the current time in the same time base as the datagram receive timestamps.
+             *
+             * @see         Nedrysoft::ICMPSocket::ICMPSocketClock::now
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            static auto currentTimestamp() -> qint64;
+
+            /**
+             * @brief       Returns the number of datagrams the kernel has dropped because the receive buffer was full.
+             *
+             * @details     The count is reported by the kernel (SO_RXQ_OVFL) with each datagram read by recvmmsg and
+             *              is cumulative for the lifetime of the socket, it is always 0 on platforms without the
+             *              option.
+             *
+             * @returns     the number of dropped datagrams.
+             */
+            auto receiveDrops() -> quint32;
+
+            /**
+             * @brief       Enables transmit timestamps on a write socket.
+             *
+             * @details     The kernel reports the time each datagram was handed to the network adapter (and, if
+             *              the adapter has hardware timestamping enabled, the time it was sent) on the error queue
+             *              of the socket, this removes the time spent in the send system call and the scheduling
+             *              delay before it from the round trip time.  The timestamps are read with
+             *              receiveTransmitTimestamps(), an error (POLLERR) is signalled on the socket when any are
+             *              waiting.
+             *
+             *              Hardware timestamping is configured on the adapter by the system (for example by a PTP
+             *              daemon), it is not changed here.  Transmit timestamps are only available on Linux.
+             *
+             * @returns     true if transmit timestamps were enabled; otherwise false.
+             */
+            auto enableTransmitTimestamps() -> bool;
+
+            /**
+             * @brief       Returns whether transmit timestamps are enabled.
+             *
+             * @returns     true if enabled; otherwise false.
+             */
+            auto transmitTimestampsEnabled() -> bool;
+
+            /**
+             * @brief       Restricts a raw read socket to the replies and errors for the given identifiers.
+             *
+             * @details     A raw ICMP socket receives every ICMP packet that arrives at the host.  A filter is run
+             *              in the kernel that drops everything other than echo replies, time exceeded and
+             *              destination unreachable packets that carry (or quote a request that carries) one of the
+             *              identifiers, the identifier of a UDP or TCP probe is its source port.  The filter
+             *              replaces any previous one, if there are too many identifiers only the packet type is
+             *              checked.
+             *
+             *              Datagram sockets are already matched to their requests by the kernel and are not
+             *              filtered.  Filters are only available on Linux.
+             *
+             * @param[in]   identifiers the identifiers to receive.
+             *
+             * @returns     true if the filter was attached; otherwise false.
+             */
+            auto setIdentifierFilter(const QList<uint16_t> &identifiers) -> bool;
+
+            /**
+             * @brief       Reads the transmit timestamps that the kernel has reported.
+             *
+             * @details     On a datagram socket the error queue is shared with ICMP errors and is read by
+             *              recvmmsg(), the timestamps found there are held until this is called.
+             *
+             * @param[out]  timestamps the list that the timestamps are appended to.
+             *
+             * @returns     the number of timestamps read.
+             */
+            auto receiveTransmitTimestamps(QList<Nedrysoft::ICMPSocket::TransmitTimestamp> &timestamps) -> int;
+
+            /**
+             * @brief       Installs a simulated network in place of the operating system sockets.
+             *
+             * @details     While a simulator is installed every socket the library creates is an in-process
+             *              socket and datagram sockets are not used.  Sockets that already exist are unaffected and
+             *              the shared sockets are created once, so the simulator must be installed before the first
+             *              engine is created.  Simulated sockets are only available on unix platforms.
+             *
+             * @param[in]   simulator the simulator; nullptr to use the operating system sockets.
+             */
+            static auto setSimulator(Nedrysoft::ICMPSocket::ICMPSocketSimulator *simulator) -> void;
+
+            /**
+             * @brief       Returns the installed simulator.
+             *
+             * @returns     the simulator; otherwise nullptr if the operating system sockets are in use.
+             */
+            static auto simulator() -> Nedrysoft::ICMPSocket::ICMPSocketSimulator *;
+
+            /**
+             * @brief       Returns whether this is an in-process socket created for a simulator.
+             *
+             * @returns     true if simulated; otherwise false.
+             */
+            auto isSimulated() -> bool;
+
+            /**
+             * @brief       Queues a datagram to be received on a simulated socket.
+             *
+             * @details     May be called from any thread.  The timestamp of the datagram is used as the receive
+             *              time, so a simulator can deliver a reply with the latency it modelled rather than the
+             *              time at which it got round to delivering it.
+             *
+             * @param[in]   datagram the datagram.
+             */
+            auto deliver(const Nedrysoft::ICMPSocket::Datagram &datagram) -> void;
+
+            friend class ICMPSocketReactor;
+            friend class ICMPSocketRing;
+
         private:
             //! @cond
 
             ICMPSocket::socket_t m_socketDescriptor;
             Nedrysoft::ICMPSocket::IPVersion m_version;
             int m_ttl;
+            bool m_isDatagram;
+            Nedrysoft::ICMPSocket::Protocol m_protocol;
+
+            QMutex m_sendMutex;
+
+            std::atomic<uint16_t> m_datagramSequence;
+            std::unique_ptr<std::atomic<uint32_t>[]> m_datagramSequenceMap;
+            std::atomic<uint32_t> m_receiveDrops;
+
+            std::atomic<bool> m_transmitTimestamps;
+            QMutex m_transmitMutex;
+            uint32_t m_transmitKey;
+            std::unique_ptr<uint32_t[]> m_transmitKeyMap;
+            QList<Nedrysoft::ICMPSocket::TransmitTimestamp> m_pendingTransmitTimestamps;
+
+            bool m_isSimulated;
+            ICMPSocket::socket_t m_simulatorDescriptor;
+            QMutex m_simulatedMutex;
+            QList<Nedrysoft::ICMPSocket::Datagram> m_simulatedDatagrams;
+            bool m_simulatedSignalled;
 
             //! @endcond
     };
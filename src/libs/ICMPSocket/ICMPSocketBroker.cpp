@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPSocketBroker.h"
+
+#include "ICMPSocketBrokerProtocol.h"
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QObject>
+#include <cerrno>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+constexpr auto HelperName = "pingnoo-helper";
+constexpr auto ReplyTimeout = 2;
+#endif
+
+Nedrysoft::ICMPSocket::ICMPSocketBroker::ICMPSocketBroker() :
+        m_socketDescriptor(-1),
+        m_helperProcess(-1),
+        m_failed(false) {
+
+}
+
+Nedrysoft::ICMPSocket::ICMPSocketBroker::~ICMPSocketBroker() {
+#if defined(Q_OS_LINUX)
+    QMutexLocker locker(&m_mutex);
+
+    stopHelper();
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketBroker::getInstance() -> Nedrysoft::ICMPSocket::ICMPSocketBroker * {
+    static Nedrysoft::ICMPSocket::ICMPSocketBroker instance;
+
+    return &instance;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketBroker::requestSocket(int addressFamily, int protocol, bool sendOnly) -> int {
+#if defined(Q_OS_LINUX)
+    QMutexLocker locker(&m_mutex);
+
+    if (m_failed) {
+        return -1;
+    }
+
+    if ((m_socketDescriptor == -1) && (!startHelper())) {
+        m_failed = true;
+
+        return -1;
+    }
+
+    Nedrysoft::ICMPSocket::BrokerProtocol::Request request = {};
+
+    request.magic = Nedrysoft::ICMPSocket::BrokerProtocol::Magic;
+    request.addressFamily = addressFamily;
+    request.protocol = protocol;
+    request.flags = sendOnly ? Nedrysoft::ICMPSocket::BrokerProtocol::SendOnly : 0;
+
+    if (send(m_socketDescriptor, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request)) {
+        qWarning() << QObject::tr("Unable to send a request to the socket helper");
+
+        stopHelper();
+
+        m_failed = true;
+
+        return -1;
+    }
+
+    Nedrysoft::ICMPSocket::BrokerProtocol::Reply reply = {};
+
+    char controlBuffer[CMSG_SPACE(sizeof(int))] = {};
+
+    struct iovec messageVector = {};
+
+    messageVector.iov_base = &reply;
+    messageVector.iov_len = sizeof(reply);
+
+    struct msghdr message = {};
+
+    message.msg_iov = &messageVector;
+    message.msg_iovlen = 1;
+    message.msg_control = controlBuffer;
+    message.msg_controllen = sizeof(controlBuffer);
+
+    auto result = recvmsg(m_socketDescriptor, &message, MSG_CMSG_CLOEXEC);
+
+    auto socketDescriptor = -1;
+
+    for (auto controlMessage = CMSG_FIRSTHDR(&message);
+            controlMessage;
+            controlMessage = CMSG_NXTHDR(&message, controlMessage)) {
+
+        if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_RIGHTS) &&
+                (controlMessage->cmsg_len == CMSG_LEN(sizeof(int)))) {
+
+            memcpy(&socketDescriptor, CMSG_DATA(controlMessage), sizeof(int));
+        }
+    }
+
+    if ((result != sizeof(reply)) || (reply.magic != Nedrysoft::ICMPSocket::BrokerProtocol::Magic)) {
+        qWarning() << QObject::tr("The socket helper did not reply");
+
+        if (socketDescriptor != -1) {
+            close(socketDescriptor);
+        }
+
+        stopHelper();
+
+        m_failed = true;
+
+        return -1;
+    }
+
+    if (reply.error) {
+        qWarning() << QObject::tr("The socket helper was unable to create a socket: %1").arg(strerror(reply.error));
+
+        if (socketDescriptor != -1) {
+            close(socketDescriptor);
+        }
+
+        return -1;
+    }
+
+    return socketDescriptor;
+#else
+    Q_UNUSED(addressFamily)
+    Q_UNUSED(protocol)
+    Q_UNUSED(sendOnly)
+
+    return -1;
+#endif
+}
+
+#if defined(Q_OS_LINUX)
+auto Nedrysoft::ICMPSocket::ICMPSocketBroker::startHelper() -> bool {
+    auto helperPath = QCoreApplication::applicationDirPath() + "/" + HelperName;
+
+    if (!QFile::exists(helperPath)) {
+        return false;
+    }
+
+    int socketDescriptors[2];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socketDescriptors) == -1) {
+        return false;
+    }
+
+    // dup2 clears the close on exec flag of the new descriptor, except when both descriptors are the same.
+
+    auto helperDescriptor = socketDescriptors[1];
+
+    if (helperDescriptor == Nedrysoft::ICMPSocket::BrokerProtocol::HelperDescriptor) {
+        helperDescriptor = fcntl(socketDescriptors[1], F_DUPFD_CLOEXEC, helperDescriptor + 1);
+
+        close(socketDescriptors[1]);
+
+        if (helperDescriptor == -1) {
+            close(socketDescriptors[0]);
+
+            return false;
+        }
+    }
+
+    posix_spawn_file_actions_t fileActions;
+
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(
+        &fileActions,
+        helperDescriptor,
+        Nedrysoft::ICMPSocket::BrokerProtocol::HelperDescriptor
+    );
+
+    auto helperFilename = helperPath.toLocal8Bit();
+
+    char *arguments[] = {helperFilename.data(), nullptr};
+
+    pid_t processId;
+
+    auto result = posix_spawn(&processId, helperFilename.constData(), &fileActions, nullptr, arguments, environ);
+
+    posix_spawn_file_actions_destroy(&fileActions);
+
+    close(helperDescriptor);
+
+    if (result != 0) {
+        qWarning() << QObject::tr("Unable to start the socket helper: %1").arg(strerror(result));
+
+        close(socketDescriptors[0]);
+
+        return false;
+    }
+
+    // a helper that is not able to create sockets would otherwise leave every request waiting forever.
+
+    struct timeval timeout = {};
+
+    timeout.tv_sec = ReplyTimeout;
+
+    setsockopt(socketDescriptors[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    m_socketDescriptor = socketDescriptors[0];
+    m_helperProcess = processId;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketBroker::stopHelper() -> void {
+    if (m_socketDescriptor != -1) {
+        close(m_socketDescriptor);
+
+        m_socketDescriptor = -1;
+    }
+
+    if (m_helperProcess != -1) {
+        waitpid(m_helperProcess, nullptr, 0);
+
+        m_helperProcess = -1;
+    }
+}
+#endif
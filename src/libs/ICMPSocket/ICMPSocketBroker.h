@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKER_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKER_H
+
+#include "ICMPSocket.h"
+
+#include <QMutex>
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketBroker class obtains raw sockets from the privileged helper.
+     *
+     * @details     Creating a raw socket requires the CAP_NET_RAW capability, rather than running the application
+     *              with elevated privileges the capability is given to the small helper executable that is installed
+     *              alongside it (setcap cap_net_raw+ep pingnoo-helper).  The helper is started the first time a
+     *              socket is requested and creates each socket on behalf of the application, attaching a default
+     *              receive filter, before passing the descriptor back over a unix domain socket.
+     *
+     *              Once received the socket belongs to the application and is used exactly as if it had been
+     *              created locally, so there is no cost after it has been handed over.  The helper exits when the
+     *              application closes its end of the connection or terminates.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketBroker {
+        private:
+            /**
+             * @brief       Constructs the broker, the helper is not started until a socket is requested.
+             */
+            ICMPSocketBroker();
+
+        public:
+            /**
+             * @brief       Destroys the ICMPSocketBroker, closing the connection and waiting for the helper to exit.
+             */
+            ~ICMPSocketBroker();
+
+            /**
+             * @brief       Returns the broker instance.
+             *
+             * @returns     the singleton instance.
+             */
+            static auto getInstance() -> Nedrysoft::ICMPSocket::ICMPSocketBroker *;
+
+            /**
+             * @brief       Requests a raw socket from the helper.
+             *
+             * @details     Only ICMP sockets of the matching version, UDP and TCP sockets are created by the helper,
+             *              UDP sockets must be send only.  The receive filter of a send only, UDP or TCP socket is
+             *              locked by the helper and cannot be replaced.  If the helper cannot be started, or has
+             *              failed, no further attempt is made to use it.
+             *
+             * @param[in]   addressFamily either AF_INET or AF_INET6.
+             * @param[in]   protocol the IP protocol of the socket.
+             * @param[in]   sendOnly true if every packet received by the socket should be dropped.
+             *
+             * @returns     the blocking socket descriptor, owned by the caller; otherwise -1 on error.
+             */
+            auto requestSocket(int addressFamily, int protocol, bool sendOnly = false) -> int;
+
+        private:
+            //! @cond
+
+#if defined(Q_OS_LINUX)
+            /**
+             * @brief       Starts the helper connected to one end of a new socket pair.
+             *
+             * @note        Must be called with the mutex held.
+             *
+             * @returns     true if the helper was started; otherwise false.
+             */
+            auto startHelper() -> bool;
+
+            /**
+             * @brief       Closes the connection and reaps the helper.
+             *
+             * @note        Must be called with the mutex held.
+             */
+            auto stopHelper() -> void;
+#endif
+
+            QMutex m_mutex;
+
+            int m_socketDescriptor;
+            int m_helperProcess;
+            bool m_failed;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKER_H
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKERPROTOCOL_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKERPROTOCOL_H
+
+#include <cstdint>
+
+/**
+ * @brief       The messages exchanged between the application and the privileged helper.
+ *
+ * @details     The helper is started with one end of a sequenced packet socket pair as descriptor HelperDescriptor,
+ *              the application sends a Request for each raw socket it needs and the helper answers with a Reply,
+ *              if the error is zero the new socket is attached to the reply as SCM_RIGHTS ancillary data.
+ *
+ *              A request with the SendOnly flag is given a socket that drops every packet it would receive, raw UDP
+ *              sockets are only created for sending.
+ *
+ *              This header is shared with the helper, which does not link against Qt.
+ */
+namespace Nedrysoft { namespace ICMPSocket { namespace BrokerProtocol {
+    constexpr uint32_t Magic = 0x504e4252;
+    constexpr int HelperDescriptor = 3;
+    constexpr uint32_t SendOnly = 0x01;
+
+    struct Request {
+        uint32_t magic;
+        int32_t addressFamily;
+        int32_t protocol;
+        uint32_t flags;
+    };
+
+    struct Reply {
+        uint32_t magic;
+        int32_t error;
+    };
+}}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETBROKERPROTOCOL_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ICMPSocketClock.h"
+
+#if defined(Q_OS_UNIX)
+#include <time.h>
+#else
+#include <QElapsedTimer>
+#endif
+
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+
+/**
+ * @private
+ *
+ * @brief       Returns the time of the monotonic clock.
+ */
+static auto monotonicTime() -> qint64 {
+#if defined(Q_OS_UNIX)
+    struct timespec currentTime = {};
+
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return static_cast<qint64>(currentTime.tv_sec) * NanosecondsInSecond + currentTime.tv_nsec;
+#else
+    static const QElapsedTimer monotonicTimer = []() {
+        QElapsedTimer timer;
+
+        timer.start();
+
+        return timer;
+    }();
+
+    return monotonicTimer.nsecsElapsed();
+#endif
+}
+
+/**
+ * @private
+ *
+ * @brief       Returns the time of the system clock in nanoseconds since the unix epoch.
+ */
+static auto systemTime() -> qint64 {
+#if defined(Q_OS_UNIX)
+    struct timespec currentTime = {};
+
+    clock_gettime(CLOCK_REALTIME, &currentTime);
+
+    return static_cast<qint64>(currentTime.tv_sec) * NanosecondsInSecond + currentTime.tv_nsec;
+#else
+    return QDateTime::currentMSecsSinceEpoch() * NanosecondsInMillisecond;
+#endif
+}
+
+/**
+ * @private
+ *
+ * @brief       Returns the value that is added to the monotonic clock to give the time since the unix epoch.
+ */
+static auto anchor() -> qint64 {
+    static const qint64 sessionAnchor = []() {
+        // the system clock is read between two readings of the monotonic clock and paired with their midpoint.
+
+        auto before = monotonicTime();
+        auto system = systemTime();
+        auto after = monotonicTime();
+
+        return system - ( before + ( after - before ) / 2 );
+    }();
+
+    return sessionAnchor;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketClock::now() -> qint64 {
+    return anchor() + monotonicTime();
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(qint64 systemTimestamp) -> qint64 {
+    if (systemTimestamp < 0) {
+        return systemTimestamp;
+    }
+
+    return systemTimestamp - ( systemTime() - now() );
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketClock::toDateTime(qint64 timestamp) -> QDateTime {
+    return QDateTime::fromMSecsSinceEpoch(timestamp / NanosecondsInMillisecond);
+}
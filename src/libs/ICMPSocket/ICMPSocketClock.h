@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETCLOCK_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETCLOCK_H
+
+#include "ICMPSocket.h"
+
+#include <QDateTime>
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketClock class provides the time base used for every probe and reply.
+     *
+     * @details     Times are read from the monotonic clock, which is never stepped, and are offset by a single
+     *              reading of the system clock taken the first time the clock is used.  A timestamp is therefore
+     *              a number of nanoseconds since the unix epoch that can be shown as a wall clock time, but the
+     *              difference between two timestamps is unaffected by the system clock being changed or stepped by
+     *              NTP while the application is running.
+     *
+     *              The kernel stamps received packets with the system clock, those timestamps are moved into this
+     *              time base with fromSystemTime() as they are read.
+     *
+     * @note        All functions are thread safe.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketClock {
+        public:
+            /**
+             * @brief       Returns the current time.
+             *
+             * @returns     the time in nanoseconds since the unix epoch.
+             */
+            static auto now() -> qint64;
+
+            /**
+             * @brief       Converts a time read from the system clock to this time base.
+             *
+             * @details     The offset between the system clock and the monotonic clock is measured at the time of
+             *              the call, so the timestamp should be converted soon after it was taken.
+             *
+             * @param[in]   systemTimestamp the system clock time in nanoseconds since the unix epoch; or -1.
+             *
+             * @returns     the time in nanoseconds since the unix epoch; or -1 if the timestamp was -1.
+             */
+            static auto fromSystemTime(qint64 systemTimestamp) -> qint64;
+
+            /**
+             * @brief       Converts a timestamp to a date and time for display.
+             *
+             * @param[in]   timestamp the time in nanoseconds since the unix epoch.
+             *
+             * @returns     the date and time in the local time zone.
+             */
+            static auto toDateTime(qint64 timestamp) -> QDateTime;
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETCLOCK_H
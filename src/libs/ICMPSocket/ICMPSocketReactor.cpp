@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPSocketReactor.h"
+
+#if defined(Q_OS_LINUX)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/event.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <QObject>
+#include <vector>
+
+constexpr auto MaximumReadyEvents = 16;
+
+#if !defined(Q_OS_LINUX) && !defined(Q_OS_MACOS)
+constexpr auto WakeupCheckInterval = 250;
+#endif
+
+Nedrysoft::ICMPSocket::ICMPSocketReactor::ICMPSocketReactor() {
+#if defined(Q_OS_LINUX)
+    m_epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeupDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if ((m_epollDescriptor != -1) && (m_wakeupDescriptor != -1)) {
+        struct epoll_event event = {};
+
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+
+        epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, m_wakeupDescriptor, &event);
+    } else {
+        qWarning() << QObject::tr("Error creating socket reactor.");
+    }
+#elif defined(Q_OS_MACOS)
+    m_kqueueDescriptor = kqueue();
+
+    if (m_kqueueDescriptor != -1) {
+        struct kevent event = {};
+
+        EV_SET(&event, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+
+        kevent(m_kqueueDescriptor, &event, 1, nullptr, 0, nullptr);
+    } else {
+        qWarning() << QObject::tr("Error creating socket reactor.");
+    }
+#else
+    m_wakeupRequested = false;
+#endif
+}
+
+Nedrysoft::ICMPSocket::ICMPSocketReactor::~ICMPSocketReactor() {
+#if defined(Q_OS_LINUX)
+    if (m_wakeupDescriptor != -1) {
+        close(m_wakeupDescriptor);
+    }
+
+    if (m_epollDescriptor != -1) {
+        close(m_epollDescriptor);
+    }
+#elif defined(Q_OS_MACOS)
+    if (m_kqueueDescriptor != -1) {
+        close(m_kqueueDescriptor);
+    }
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketReactor::isValid() -> bool {
+#if defined(Q_OS_LINUX)
+    return (m_epollDescriptor != -1) && (m_wakeupDescriptor != -1);
+#elif defined(Q_OS_MACOS)
+    return m_kqueueDescriptor != -1;
+#else
+    return true;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketReactor::addSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool {
+    if (!socket) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (m_sockets.contains(socket)) {
+        return true;
+    }
+
+#if defined(Q_OS_LINUX)
+    struct epoll_event event = {};
+
+    event.events = EPOLLIN;
+    event.data.ptr = socket;
+
+    if (epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, socket->m_socketDescriptor, &event) == -1) {
+        return false;
+    }
+#elif defined(Q_OS_MACOS)
+    struct kevent event = {};
+
+    EV_SET(&event, socket->m_socketDescriptor, EVFILT_READ, EV_ADD, 0, 0, socket);
+
+    if (kevent(m_kqueueDescriptor, &event, 1, nullptr, 0, nullptr) == -1) {
+        return false;
+    }
+#endif
+
+    m_sockets.append(socket);
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketReactor::removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool {
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (!m_sockets.contains(socket)) {
+        return false;
+    }
+
+#if defined(Q_OS_LINUX)
+    epoll_ctl(m_epollDescriptor, EPOLL_CTL_DEL, socket->m_socketDescriptor, nullptr);
+#elif defined(Q_OS_MACOS)
+    struct kevent event = {};
+
+    EV_SET(&event, socket->m_socketDescriptor, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+
+    kevent(m_kqueueDescriptor, &event, 1, nullptr, 0, nullptr);
+#endif
+
+    m_sockets.removeAll(socket);
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketReactor::wakeup() -> void {
+#if defined(Q_OS_LINUX)
+    uint64_t value = 1;
+
+    auto result = write(m_wakeupDescriptor, &value, sizeof(value));
+
+    Q_UNUSED(result)
+#elif defined(Q_OS_MACOS)
+    struct kevent event = {};
+
+    EV_SET(&event, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+
+    kevent(m_kqueueDescriptor, &event, 1, nullptr, 0, nullptr);
+#else
+    m_wakeupRequested = true;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketReactor::wait(int timeout) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *> {
+    QList<Nedrysoft::ICMPSocket::ICMPSocket *> readySockets;
+
+#if defined(Q_OS_LINUX)
+    struct epoll_event events[MaximumReadyEvents];
+
+    auto eventCount = epoll_wait(m_epollDescriptor, events, MaximumReadyEvents, timeout);
+
+    for (auto index = 0; index < eventCount; index++) {
+        if (events[index].data.ptr == nullptr) {
+            uint64_t value;
+
+            auto result = read(m_wakeupDescriptor, &value, sizeof(value));
+
+            Q_UNUSED(result)
+
+            continue;
+        }
+
+        readySockets.append(static_cast<Nedrysoft::ICMPSocket::ICMPSocket *>(events[index].data.ptr));
+    }
+#elif defined(Q_OS_MACOS)
+    struct kevent events[MaximumReadyEvents];
+    struct timespec timeoutSpec = {};
+    struct timespec *timeoutPointer = nullptr;
+
+    if (timeout >= 0) {
+        timeoutSpec.tv_sec = timeout / 1000;
+        timeoutSpec.tv_nsec = ( timeout % 1000 ) * 1000000;
+
+        timeoutPointer = &timeoutSpec;
+    }
+
+    auto eventCount = kevent(m_kqueueDescriptor, nullptr, 0, events, MaximumReadyEvents, timeoutPointer);
+
+    for (auto index = 0; index < eventCount; index++) {
+        if (events[index].filter == EVFILT_USER) {
+            continue;
+        }
+
+        readySockets.append(static_cast<Nedrysoft::ICMPSocket::ICMPSocket *>(events[index].udata));
+    }
+#else
+    /**
+     * WSAPoll cannot wait on an event object, so the wait is performed in slices and the wakeup flag is
+     * checked between slices.
+     */
+
+    m_socketsMutex.lock();
+    auto sockets = m_sockets;
+    m_socketsMutex.unlock();
+
+    auto remaining = timeout;
+
+    while (!m_wakeupRequested.exchange(false)) {
+        auto slice = WakeupCheckInterval;
+
+        if (timeout >= 0) {
+            slice = qMin(remaining, WakeupCheckInterval);
+        }
+
+        readySockets = Nedrysoft::ICMPSocket::ICMPSocket::waitForRead(sockets, slice);
+
+        if (!readySockets.isEmpty()) {
+            break;
+        }
+
+        if (timeout >= 0) {
+            remaining -= slice;
+
+            if (remaining <= 0) {
+                break;
+            }
+        }
+    }
+#endif
+
+    return readySockets;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETREACTOR_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETREACTOR_H
+
+#include "ICMPSocket.h"
+
+#include <QList>
+#include <QMutex>
+#include <atomic>
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketReactor class provides a readiness loop for a set of ICMP sockets.
+     *
+     * @details     Sockets are registered once with the reactor and a single wait then reports every socket that
+     *              has data available.  The platform specific mechanism is hidden, epoll is used on Linux, kqueue
+     *              on macOS and WSAPoll on Windows.
+     *
+     *              A wait may block indefinitely, another thread can call wakeup() to interrupt it (for example
+     *              when a worker is being shut down), this means an idle receiver costs no periodic wakeups.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketReactor {
+        public:
+            /**
+             * @brief       Constructs a new ICMPSocketReactor.
+             */
+            ICMPSocketReactor();
+
+            /**
+             * @brief       Destroys the ICMPSocketReactor.
+             *
+             * @note        The registered sockets are not owned by the reactor and are not deleted.
+             */
+            ~ICMPSocketReactor();
+
+            /**
+             * @brief       Registers a socket with the reactor.
+             *
+             * @param[in]   socket the socket to watch for incoming data.
+             *
+             * @returns     true if the socket was registered; otherwise false.
+             */
+            auto addSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool;
+
+            /**
+             * @brief       Removes a socket from the reactor.
+             *
+             * @param[in]   socket the socket to remove.
+             *
+             * @returns     true if the socket was removed; otherwise false.
+             */
+            auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool;
+
+            /**
+             * @brief       Waits for registered sockets to become readable.
+             *
+             * @param[in]   timeout the maximum time to wait in milliseconds, -1 waits until data arrives or
+             *              wakeup() is called.
+             *
+             * @returns     the list of sockets that are readable, empty on timeout, wakeup or error.
+             */
+            auto wait(int timeout = -1) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *>;
+
+            /**
+             * @brief       Interrupts a thread that is blocked in wait().
+             *
+             * @note        This function is thread safe.
+             */
+            auto wakeup() -> void;
+
+            /**
+             * @brief       Returns whether the reactor was created successfully.
+             *
+             * @returns     true if the reactor is usable; otherwise false.
+             */
+            auto isValid() -> bool;
+
+        private:
+            //! @cond
+
+            QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_sockets;
+            QMutex m_socketsMutex;
+
+#if defined(Q_OS_LINUX)
+            int m_epollDescriptor;
+            int m_wakeupDescriptor;
+#elif defined(Q_OS_MACOS)
+            int m_kqueueDescriptor;
+#else
+            std::atomic<bool> m_wakeupRequested;
+#endif
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETREACTOR_H
@@ -0,0 +1,997 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPSocketRing.h"
+
+#if defined(Q_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// multishot receives were added to the kernel headers in 6.0, older headers build without the ring.
+
+#if defined(IORING_RECV_MULTISHOT)
+#define NEDRYSOFT_ICMPSOCKET_RING
+#endif
+#elif defined(Q_OS_WIN)
+#define NEDRYSOFT_ICMPSOCKET_RIO
+#endif
+
+#include <QObject>
+#include <cerrno>
+#include <cstring>
+
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+constexpr auto SubmissionEntries = 64;
+constexpr auto CompletionEntries = 4096;
+constexpr auto BufferCount = 256;
+constexpr auto BufferGroup = 0;
+constexpr auto ReceiveBufferSize = 4096;
+constexpr auto ControlBufferSize = 256;
+constexpr auto BufferSize = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_storage) +
+                            ControlBufferSize + ReceiveBufferSize;
+constexpr auto MaximumErrorBatch = 64;
+
+/**
+ * the first feature flag reported by 6.3, multishot recvmsg with ring provided buffers was complete by then and
+ * the flag is not defined by older headers.
+ */
+
+constexpr auto RequiredFeature = 1U << 13;
+
+constexpr uint64_t OperationMask = 3;
+constexpr uint64_t WakeupOperation = 0;
+constexpr uint64_t ReceiveOperation = 1;
+constexpr uint64_t ErrorOperation = 2;
+constexpr uint64_t CancelOperation = 3;
+
+/**
+ * @brief       Returns the user data that identifies an operation posted for a socket entry.
+ *
+ * @param[in]   entry the socket entry, entries are allocated so the low bits of the pointer are free.
+ * @param[in]   operation the operation.
+ *
+ * @returns     the user data.
+ */
+static auto userData(void *entry, uint64_t operation) -> uint64_t {
+    return reinterpret_cast<uint64_t>(entry) | operation;
+}
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+constexpr auto CompletionEntries = 4096;
+constexpr auto CompletionBatch = 256;
+constexpr auto ReceivesPerSocket = 64;
+constexpr auto ReceiveBufferSize = 4096;
+constexpr auto SlotSize = sizeof(SOCKADDR_INET) + ReceiveBufferSize;
+#endif
+
+Nedrysoft::ICMPSocket::ICMPSocketRing::ICMPSocketRing()
+#if defined(Q_OS_LINUX)
+        :
+            m_ringDescriptor(-1),
+            m_wakeupDescriptor(-1),
+            m_wakeupPosted(false),
+            m_submissionRing(nullptr),
+            m_submissionRingSize(0),
+            m_submissions(nullptr),
+            m_submissionsSize(0),
+            m_submissionHead(nullptr),
+            m_submissionTail(nullptr),
+            m_submissionMask(0),
+            m_submissionEntries(0),
+            m_submissionArray(nullptr),
+            m_completionHead(nullptr),
+            m_completionTail(nullptr),
+            m_completionMask(0),
+            m_completions(nullptr),
+            m_pendingSubmissions(0),
+            m_bufferRing(nullptr),
+            m_bufferRingSize(0),
+            m_bufferTail(0),
+            m_receiveHeader()
+#elif defined(Q_OS_WIN)
+        :
+            m_functions(),
+            m_completionQueue(RIO_INVALID_CQ),
+            m_completionEvent(nullptr)
+#endif
+{
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+    struct io_uring_params parameters = {};
+
+    parameters.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP | IORING_SETUP_COOP_TASKRUN;
+    parameters.cq_entries = CompletionEntries;
+
+    auto ringDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, SubmissionEntries, &parameters));
+
+    if (ringDescriptor < 0) {
+        return;
+    }
+
+    if ((!(parameters.features & IORING_FEAT_SINGLE_MMAP)) || (!(parameters.features & RequiredFeature))) {
+        close(ringDescriptor);
+
+        return;
+    }
+
+    m_ringDescriptor = ringDescriptor;
+
+    m_submissionRingSize = qMax(
+        parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned),
+        parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe)
+    );
+
+    m_submissionRing = mmap(
+        nullptr,
+        m_submissionRingSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_ringDescriptor,
+        IORING_OFF_SQ_RING
+    );
+
+    m_submissionsSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+
+    m_submissions = mmap(
+        nullptr,
+        m_submissionsSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_ringDescriptor,
+        IORING_OFF_SQES
+    );
+
+    if ((m_submissionRing == MAP_FAILED) || (m_submissions == MAP_FAILED)) {
+        qWarning() << QObject::tr("Error mapping io_uring queues.");
+
+        return;
+    }
+
+    // with a single mapping the completion queue shares the submission queue mapping.
+
+    auto submissionRing = static_cast<char *>(m_submissionRing);
+
+    m_submissionHead = reinterpret_cast<unsigned *>(submissionRing + parameters.sq_off.head);
+    m_submissionTail = reinterpret_cast<unsigned *>(submissionRing + parameters.sq_off.tail);
+    m_submissionMask = *reinterpret_cast<unsigned *>(submissionRing + parameters.sq_off.ring_mask);
+    m_submissionEntries = parameters.sq_entries;
+    m_submissionArray = reinterpret_cast<unsigned *>(submissionRing + parameters.sq_off.array);
+    m_completionHead = reinterpret_cast<unsigned *>(submissionRing + parameters.cq_off.head);
+    m_completionTail = reinterpret_cast<unsigned *>(submissionRing + parameters.cq_off.tail);
+    m_completionMask = *reinterpret_cast<unsigned *>(submissionRing + parameters.cq_off.ring_mask);
+    m_completions = submissionRing + parameters.cq_off.cqes;
+
+    /**
+     * the buffers are handed to the kernel through a ring that is registered once, the kernel takes a buffer for
+     * each packet and the id of the buffer is returned in the completion, which is then put back on the ring.
+     */
+
+    m_bufferRingSize = BufferCount * sizeof(struct io_uring_buf);
+
+    m_bufferRing = mmap(
+        nullptr,
+        m_bufferRingSize,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,
+        -1,
+        0
+    );
+
+    if (m_bufferRing == MAP_FAILED) {
+        m_bufferRing = nullptr;
+
+        qWarning() << QObject::tr("Error allocating io_uring buffer ring.");
+
+        return;
+    }
+
+    m_buffers.resize(static_cast<size_t>(BufferCount) * BufferSize);
+
+    for (auto bufferId = 0; bufferId < BufferCount; bufferId++) {
+        recycleBuffer(static_cast<uint16_t>(bufferId));
+    }
+
+    struct io_uring_buf_reg bufferRegistration = {};
+
+    bufferRegistration.ring_addr = reinterpret_cast<uint64_t>(m_bufferRing);
+    bufferRegistration.ring_entries = BufferCount;
+    bufferRegistration.bgid = BufferGroup;
+
+    if (syscall(__NR_io_uring_register, m_ringDescriptor, IORING_REGISTER_PBUF_RING, &bufferRegistration, 1) < 0) {
+        qWarning() << QObject::tr("Error registering io_uring buffer ring.");
+
+        munmap(m_bufferRing, m_bufferRingSize);
+
+        m_bufferRing = nullptr;
+
+        return;
+    }
+
+    // the kernel copies the header when a receive is posted, only the name and control lengths are used.
+
+    m_receiveHeader.msg_namelen = sizeof(struct sockaddr_storage);
+    m_receiveHeader.msg_controllen = ControlBufferSize;
+
+    m_wakeupDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (m_wakeupDescriptor == -1) {
+        qWarning() << QObject::tr("Error creating io_uring wakeup.");
+    }
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    Nedrysoft::ICMPSocket::ICMPSocket::initialiseSockets();
+
+    /**
+     * the functions are looked up through a socket, a raw socket is used so that creating a request queue on it
+     * also confirms that this version of Windows supports registered I/O on raw sockets.
+     */
+
+    auto probeSocket = WSASocket(
+        AF_INET,
+        SOCK_RAW,
+        IPPROTO_ICMP,
+        nullptr,
+        0,
+        WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO );
+
+    if (probeSocket == INVALID_SOCKET) {
+        return;
+    }
+
+    GUID functionTableId = WSAID_MULTIPLE_RIO;
+    DWORD bytesReturned = 0;
+
+    m_functions.cbSize = sizeof(m_functions);
+
+    auto result = WSAIoctl(
+        probeSocket,
+        SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER,
+        &functionTableId,
+        sizeof(functionTableId),
+        &m_functions,
+        sizeof(m_functions),
+        &bytesReturned,
+        nullptr,
+        nullptr );
+
+    if (result == SOCKET_ERROR) {
+        closesocket(probeSocket);
+
+        return;
+    }
+
+    // the event is set when a completion arrives after RIONotify(), wakeup() sets it directly.
+
+    m_completionEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+    if (!m_completionEvent) {
+        closesocket(probeSocket);
+
+        return;
+    }
+
+    RIO_NOTIFICATION_COMPLETION notification = {};
+
+    notification.Type = RIO_EVENT_COMPLETION;
+    notification.Event.EventHandle = m_completionEvent;
+    notification.Event.NotifyReset = FALSE;
+
+    m_completionQueue = m_functions.RIOCreateCompletionQueue(CompletionEntries, &notification);
+
+    if (m_completionQueue == RIO_INVALID_CQ) {
+        qWarning() << QObject::tr("Error creating registered I/O completion queue.");
+
+        closesocket(probeSocket);
+
+        return;
+    }
+
+    auto requestQueue = m_functions.RIOCreateRequestQueue(
+        probeSocket,
+        1,
+        1,
+        1,
+        1,
+        m_completionQueue,
+        m_completionQueue,
+        nullptr );
+
+    if (requestQueue == RIO_INVALID_RQ) {
+        m_functions.RIOCloseCompletionQueue(m_completionQueue);
+
+        m_completionQueue = RIO_INVALID_CQ;
+    }
+
+    // the request queue is freed when the socket is closed.
+
+    closesocket(probeSocket);
+#endif
+}
+
+Nedrysoft::ICMPSocket::ICMPSocketRing::~ICMPSocketRing() {
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+    // closing the ring cancels the posted operations, so no completion can refer to an entry after this.
+
+    if (m_ringDescriptor != -1) {
+        close(m_ringDescriptor);
+    }
+
+    if ((m_submissionRing) && (m_submissionRing != MAP_FAILED)) {
+        munmap(m_submissionRing, m_submissionRingSize);
+    }
+
+    if ((m_submissions) && (m_submissions != MAP_FAILED)) {
+        munmap(m_submissions, m_submissionsSize);
+    }
+
+    if (m_bufferRing) {
+        munmap(m_bufferRing, m_bufferRingSize);
+    }
+
+    if (m_wakeupDescriptor != -1) {
+        close(m_wakeupDescriptor);
+    }
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    // the receives posted on a socket are only ended by closing it, so the sockets must be closed before this.
+
+    for (auto entry : m_entries) {
+        if (entry->bufferId != RIO_INVALID_BUFFERID) {
+            m_functions.RIODeregisterBuffer(entry->bufferId);
+        }
+    }
+
+    if (m_completionQueue != RIO_INVALID_CQ) {
+        m_functions.RIOCloseCompletionQueue(m_completionQueue);
+    }
+
+    if (m_completionEvent) {
+        CloseHandle(m_completionEvent);
+    }
+#endif
+
+    qDeleteAll(m_entries);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::isValid() -> bool {
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+    return (m_ringDescriptor != -1) && (m_completions) && (m_bufferRing) && (m_wakeupDescriptor != -1);
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    return m_completionQueue != RIO_INVALID_CQ;
+#else
+    return false;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::addSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool {
+#if defined(NEDRYSOFT_ICMPSOCKET_RING) || defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    if ((!socket) || (socket->isSimulated()) || (!isValid())) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_submitMutex);
+
+    for (auto entry : m_entries) {
+        if ((entry->socket == socket) && (!entry->isRemoved)) {
+            return true;
+        }
+    }
+
+    auto entry = new Entry;
+
+    entry->socket = socket;
+
+    m_entries.append(entry);
+
+    locker.unlock();
+
+    wakeup();
+
+    return true;
+#else
+    Q_UNUSED(socket)
+
+    return false;
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool {
+#if defined(NEDRYSOFT_ICMPSOCKET_RING) || defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    QMutexLocker locker(&m_submitMutex);
+
+    for (auto entry : m_entries) {
+        if ((entry->socket != socket) || (entry->isRemoved)) {
+            continue;
+        }
+
+        // the operations are cancelled by the waiting thread, the entry is freed once they have all completed.
+
+        entry->isRemoved = true;
+        entry->datagrams.clear();
+
+        locker.unlock();
+
+        wakeup();
+
+        return true;
+    }
+#else
+    Q_UNUSED(socket)
+#endif
+
+    return false;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::wait(int timeout) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *> {
+    QList<Nedrysoft::ICMPSocket::ICMPSocket *> readySockets;
+
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+    if (!isValid()) {
+        return readySockets;
+    }
+
+    m_submitMutex.lock();
+
+    postChanges();
+
+    m_submitMutex.unlock();
+
+    auto completionHead = *m_completionHead;
+
+    if ((completionHead == __atomic_load_n(m_completionTail, __ATOMIC_ACQUIRE)) && (timeout != 0)) {
+        struct io_uring_getevents_arg arguments = {};
+        struct __kernel_timespec timeoutTime = {};
+
+        if (timeout > 0) {
+            timeoutTime.tv_sec = timeout / 1000;
+            timeoutTime.tv_nsec = static_cast<long long>(timeout % 1000) * 1000000;
+
+            arguments.ts = reinterpret_cast<uint64_t>(&timeoutTime);
+        }
+
+        syscall(
+            __NR_io_uring_enter,
+            m_ringDescriptor,
+            0,
+            1,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+            &arguments,
+            sizeof(arguments)
+        );
+    }
+
+    QMutexLocker locker(&m_submitMutex);
+
+    auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    auto completionTail = __atomic_load_n(m_completionTail, __ATOMIC_ACQUIRE);
+    auto completions = static_cast<struct io_uring_cqe *>(m_completions);
+
+    for (; completionHead != completionTail; completionHead++) {
+        auto &completion = completions[completionHead & m_completionMask];
+        auto operation = completion.user_data & OperationMask;
+        auto entry = reinterpret_cast<Entry *>(completion.user_data & ~OperationMask);
+        auto isPosted = (completion.flags & IORING_CQE_F_MORE) != 0;
+
+        if (operation == CancelOperation) {
+            continue;
+        }
+
+        if (!entry) {
+            uint64_t value;
+
+            auto result = read(m_wakeupDescriptor, &value, sizeof(value));
+
+            Q_UNUSED(result)
+
+            if (!isPosted) {
+                m_wakeupPosted = postWakeupPoll();
+            }
+
+            continue;
+        }
+
+        if (operation == ReceiveOperation) {
+            completeReceive(entry, completion.res, completion.flags, timestamp);
+        } else if ((operation == ErrorOperation) && (completion.res > 0) && (!entry->isRemoved)) {
+            // the poll only completes when the queue goes from empty to not empty, so the queue is emptied.
+
+            while (entry->socket->receiveErrors(entry->datagrams, MaximumErrorBatch) == MaximumErrorBatch) {
+            }
+
+            entry->isReady = true;
+        }
+
+        if (isPosted) {
+            continue;
+        }
+
+        // the kernel ends a multishot operation if it runs out of buffers or completion space, it is reposted.
+
+        entry->postedOperations--;
+
+        if (entry->isRemoved) {
+            if (!entry->postedOperations) {
+                m_entries.removeAll(entry);
+
+                delete entry;
+            }
+        } else if (operation == ReceiveOperation) {
+            postReceive(entry);
+        } else {
+            postErrorPoll(entry);
+        }
+    }
+
+    __atomic_store_n(m_completionHead, completionHead, __ATOMIC_RELEASE);
+
+    submit();
+
+    for (auto entry : m_entries) {
+        if ((entry->isReady) && (!entry->isRemoved)) {
+            readySockets.append(entry->socket);
+        }
+    }
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    if (!isValid()) {
+        return readySockets;
+    }
+
+    QMutexLocker locker(&m_submitMutex);
+
+    postChanges();
+
+    std::vector<RIORESULT> results(CompletionBatch);
+
+    auto count = m_functions.RIODequeueCompletion(m_completionQueue, results.data(), CompletionBatch);
+
+    if ((!count) && (timeout != 0)) {
+        // an armed notification that has not fired yet is reported as already armed, which is not an error.
+
+        m_functions.RIONotify(m_completionQueue);
+
+        locker.unlock();
+
+        WaitForSingleObject(m_completionEvent, (timeout < 0) ? INFINITE : static_cast<DWORD>(timeout));
+
+        locker.relock();
+
+        postChanges();
+
+        count = m_functions.RIODequeueCompletion(m_completionQueue, results.data(), CompletionBatch);
+    }
+
+    if (count == RIO_CORRUPT_CQ) {
+        return readySockets;
+    }
+
+    auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+    for (auto index = 0ul; index < count; index++) {
+        auto &result = results[index];
+        auto entry = reinterpret_cast<Entry *>(result.SocketContext);
+        auto slot = static_cast<int>(result.RequestContext);
+
+        entry->postedOperations--;
+
+        if (entry->isRemoved) {
+            if (!entry->postedOperations) {
+                deleteEntry(entry);
+            }
+
+            continue;
+        }
+
+        auto buffer = &entry->buffers[static_cast<size_t>(slot) * SlotSize];
+
+        if (result.Status == NO_ERROR) {
+            Nedrysoft::ICMPSocket::Datagram datagram;
+
+            // a raw socket receives the IPv4 header ahead of the ICMP message, in the same way as recvfrom().
+
+            datagram.buffer = QByteArray(buffer + sizeof(SOCKADDR_INET), static_cast<int>(result.BytesTransferred));
+            datagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(
+                reinterpret_cast<sockaddr *>(buffer) );
+            datagram.result = static_cast<int>(result.BytesTransferred);
+            datagram.timestamp = timestamp;
+
+            entry->datagrams.append(datagram);
+            entry->isReady = true;
+        }
+
+        // a receive that was aborted belongs to a socket that has been closed.
+
+        if (result.Status != WSA_OPERATION_ABORTED) {
+            postReceive(entry, slot);
+        }
+    }
+
+    for (auto entry : m_entries) {
+        if ((entry->isReady) && (!entry->isRemoved)) {
+            readySockets.append(entry->socket);
+        }
+    }
+#else
+    Q_UNUSED(timeout)
+#endif
+
+    return readySockets;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::receive(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket,
+        QList<Nedrysoft::ICMPSocket::Datagram> &datagrams) -> int {
+
+    QMutexLocker locker(&m_submitMutex);
+
+    for (auto entry : m_entries) {
+        if ((entry->socket != socket) || (entry->isRemoved)) {
+            continue;
+        }
+
+        auto count = static_cast<int>(entry->datagrams.count());
+
+        entry->isReady = false;
+
+        if (!count) {
+            return -1;
+        }
+
+        datagrams.append(entry->datagrams);
+
+        entry->datagrams.clear();
+
+        return count;
+    }
+
+    return -1;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::wakeup() -> void {
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+    if (m_wakeupDescriptor == -1) {
+        return;
+    }
+
+    uint64_t value = 1;
+
+    auto result = write(m_wakeupDescriptor, &value, sizeof(value));
+
+    Q_UNUSED(result)
+#elif defined(NEDRYSOFT_ICMPSOCKET_RIO)
+    if (m_completionEvent) {
+        SetEvent(m_completionEvent);
+    }
+#endif
+}
+
+#if defined(NEDRYSOFT_ICMPSOCKET_RING)
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postChanges() -> void {
+    if (!m_wakeupPosted) {
+        m_wakeupPosted = postWakeupPoll();
+    }
+
+    for (auto entry : QList<Entry *>(m_entries)) {
+        if ((entry->isRemoved) && (!entry->isPosted)) {
+            m_entries.removeAll(entry);
+
+            delete entry;
+        } else if ((entry->isRemoved) && (!entry->isCancelled)) {
+            for (auto operation : {ReceiveOperation, ErrorOperation}) {
+                auto submission = static_cast<struct io_uring_sqe *>(nextSubmission());
+
+                if (!submission) {
+                    break;
+                }
+
+                submission->opcode = IORING_OP_ASYNC_CANCEL;
+                submission->fd = -1;
+                submission->addr = userData(entry, operation);
+                submission->user_data = userData(nullptr, CancelOperation);
+
+                queueSubmission();
+            }
+
+            entry->isCancelled = true;
+        } else if (!entry->isPosted) {
+            /**
+             * the error poll is posted for every socket, a raw read socket rarely has anything queued but a datagram
+             * socket receives time exceeded messages and a write socket receives transmit timestamps this way.
+             */
+
+            if ((!postReceive(entry)) || (!postErrorPoll(entry))) {
+                qWarning() << QObject::tr("Error posting io_uring receive for socket.");
+            }
+
+            entry->isPosted = true;
+        }
+    }
+
+    submit();
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postReceive(Entry *entry) -> bool {
+    auto submission = static_cast<struct io_uring_sqe *>(nextSubmission());
+
+    if (!submission) {
+        return false;
+    }
+
+    submission->opcode = IORING_OP_RECVMSG;
+    submission->fd = entry->socket->m_socketDescriptor;
+    submission->addr = reinterpret_cast<uint64_t>(&m_receiveHeader);
+    submission->ioprio = IORING_RECV_MULTISHOT;
+    submission->flags = IOSQE_BUFFER_SELECT;
+    submission->buf_group = BufferGroup;
+    submission->user_data = userData(entry, ReceiveOperation);
+
+    queueSubmission();
+
+    entry->postedOperations++;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postErrorPoll(Entry *entry) -> bool {
+    auto submission = static_cast<struct io_uring_sqe *>(nextSubmission());
+
+    if (!submission) {
+        return false;
+    }
+
+    submission->opcode = IORING_OP_POLL_ADD;
+    submission->fd = entry->socket->m_socketDescriptor;
+    submission->poll32_events = POLLERR;
+    submission->len = IORING_POLL_ADD_MULTI;
+    submission->user_data = userData(entry, ErrorOperation);
+
+    queueSubmission();
+
+    entry->postedOperations++;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postWakeupPoll() -> bool {
+    auto submission = static_cast<struct io_uring_sqe *>(nextSubmission());
+
+    if (!submission) {
+        return false;
+    }
+
+    submission->opcode = IORING_OP_POLL_ADD;
+    submission->fd = m_wakeupDescriptor;
+    submission->poll32_events = POLLIN;
+    submission->len = IORING_POLL_ADD_MULTI;
+    submission->user_data = userData(nullptr, WakeupOperation);
+
+    queueSubmission();
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::nextSubmission() -> void * {
+    auto tail = *m_submissionTail;
+
+    if (tail - __atomic_load_n(m_submissionHead, __ATOMIC_ACQUIRE) >= m_submissionEntries) {
+        submit();
+
+        if (tail - __atomic_load_n(m_submissionHead, __ATOMIC_ACQUIRE) >= m_submissionEntries) {
+            return nullptr;
+        }
+    }
+
+    auto index = tail & m_submissionMask;
+    auto submission = &static_cast<struct io_uring_sqe *>(m_submissions)[index];
+
+    memset(submission, 0, sizeof(struct io_uring_sqe));
+
+    m_submissionArray[index] = index;
+
+    return submission;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::queueSubmission() -> void {
+    __atomic_store_n(m_submissionTail, *m_submissionTail + 1, __ATOMIC_RELEASE);
+
+    m_pendingSubmissions++;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::submit() -> void {
+    while (m_pendingSubmissions) {
+        auto result = syscall(__NR_io_uring_enter, m_ringDescriptor, m_pendingSubmissions, 0, 0, nullptr, 0);
+
+        if (result <= 0) {
+            // the queue is left as it is and submitted again on the next call.
+
+            if ((result < 0) && (errno == EINTR)) {
+                continue;
+            }
+
+            break;
+        }
+
+        m_pendingSubmissions -= static_cast<unsigned>(result);
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::completeReceive(
+        Entry *entry,
+        int result,
+        uint32_t flags,
+        qint64 timestamp) -> void {
+
+    if (!(flags & IORING_CQE_F_BUFFER)) {
+        return;
+    }
+
+    auto bufferId = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+    auto buffer = &m_buffers[static_cast<size_t>(bufferId) * BufferSize];
+    auto headerLength = static_cast<int>(
+        sizeof(struct io_uring_recvmsg_out) + m_receiveHeader.msg_namelen + m_receiveHeader.msg_controllen
+    );
+
+    if ((result < headerLength) || (entry->isRemoved)) {
+        recycleBuffer(bufferId);
+
+        return;
+    }
+
+    /**
+     * the buffer holds a header giving the lengths the kernel wrote, followed by space for the address and the
+     * ancillary data of the sizes in the posted message header and then the packet itself.
+     */
+
+    auto receiveHeader = reinterpret_cast<struct io_uring_recvmsg_out *>(buffer);
+    auto payloadLength = qMin(static_cast<int>(receiveHeader->payloadlen), result - headerLength);
+
+    struct sockaddr_storage address = {};
+
+    memcpy(
+        &address,
+        buffer + sizeof(struct io_uring_recvmsg_out),
+        qMin(static_cast<size_t>(receiveHeader->namelen), sizeof(address))
+    );
+
+    Nedrysoft::ICMPSocket::Datagram datagram;
+
+    datagram.buffer = QByteArray(buffer + headerLength, payloadLength);
+    datagram.socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(
+        reinterpret_cast<sockaddr *>(&address) );
+    datagram.result = payloadLength;
+    datagram.timestamp = timestamp;
+
+    struct msghdr header = {};
+
+    header.msg_control = buffer + sizeof(struct io_uring_recvmsg_out) + m_receiveHeader.msg_namelen;
+    header.msg_controllen = receiveHeader->controllen;
+
+    entry->socket->readControlMessages(header, datagram);
+
+    recycleBuffer(bufferId);
+
+    entry->datagrams.append(datagram);
+    entry->isReady = true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::recycleBuffer(uint16_t bufferId) -> void {
+    // the buffers overlay the ring header, they are indexed directly as the flexible array is not valid C++.
+
+    auto &buffer = reinterpret_cast<struct io_uring_buf *>(m_bufferRing)[m_bufferTail & (BufferCount - 1)];
+
+    buffer.addr = reinterpret_cast<uint64_t>(&m_buffers[static_cast<size_t>(bufferId) * BufferSize]);
+    buffer.len = static_cast<uint32_t>(BufferSize);
+    buffer.bid = bufferId;
+
+    m_bufferTail++;
+
+    __atomic_store_n(&reinterpret_cast<struct io_uring_buf_ring *>(m_bufferRing)->tail, m_bufferTail, __ATOMIC_RELEASE);
+}
+#endif
+
+#if defined(NEDRYSOFT_ICMPSOCKET_RIO)
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postChanges() -> void {
+    for (auto entry : QList<Entry *>(m_entries)) {
+        if ((entry->isRemoved) && (!entry->postedOperations)) {
+            deleteEntry(entry);
+        } else if ((!entry->isRemoved) && (!entry->isPosted)) {
+            entry->isPosted = true;
+
+            // each slot holds the address of the sender followed by the packet.
+
+            entry->buffers.resize(static_cast<size_t>(ReceivesPerSocket) * SlotSize);
+
+            entry->bufferId = m_functions.RIORegisterBuffer(
+                entry->buffers.data(),
+                static_cast<DWORD>(entry->buffers.size()) );
+
+            if (entry->bufferId != RIO_INVALID_BUFFERID) {
+                entry->requestQueue = m_functions.RIOCreateRequestQueue(
+                    entry->socket->m_socketDescriptor,
+                    ReceivesPerSocket,
+                    1,
+                    1,
+                    1,
+                    m_completionQueue,
+                    m_completionQueue,
+                    entry );
+            }
+
+            if (entry->requestQueue == RIO_INVALID_RQ) {
+                qWarning() << QObject::tr("Error creating registered I/O request queue for socket.");
+
+                continue;
+            }
+
+            for (auto slot = 0; slot < ReceivesPerSocket; slot++) {
+                if (!postReceive(entry, slot)) {
+                    qWarning() << QObject::tr("Error posting registered I/O receive for socket.");
+
+                    break;
+                }
+            }
+        }
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::postReceive(Entry *entry, int slot) -> bool {
+    RIO_BUF addressBuffer = {};
+    RIO_BUF dataBuffer = {};
+
+    addressBuffer.BufferId = entry->bufferId;
+    addressBuffer.Offset = static_cast<ULONG>(static_cast<size_t>(slot) * SlotSize);
+    addressBuffer.Length = sizeof(SOCKADDR_INET);
+
+    dataBuffer.BufferId = entry->bufferId;
+    dataBuffer.Offset = addressBuffer.Offset + sizeof(SOCKADDR_INET);
+    dataBuffer.Length = ReceiveBufferSize;
+
+    auto result = m_functions.RIOReceiveEx(
+        entry->requestQueue,
+        &dataBuffer,
+        1,
+        nullptr,
+        &addressBuffer,
+        nullptr,
+        nullptr,
+        0,
+        reinterpret_cast<PVOID>(static_cast<intptr_t>(slot)) );
+
+    if (!result) {
+        return false;
+    }
+
+    entry->postedOperations++;
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketRing::deleteEntry(Entry *entry) -> void {
+    if (entry->bufferId != RIO_INVALID_BUFFERID) {
+        m_functions.RIODeregisterBuffer(entry->bufferId);
+    }
+
+    m_entries.removeAll(entry);
+
+    delete entry;
+}
+#endif
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETRING_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETRING_H
+
+#include "ICMPSocket.h"
+
+#include <QList>
+#include <QMutex>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <MSWSock.h>
+#endif
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketRing class receives from a set of ICMP sockets through an io_uring on Linux or
+     *              registered I/O on Windows.
+     *
+     * @details     On Linux a multishot receive is kept posted on each registered socket, the kernel writes each
+     *              packet into a buffer taken from a ring of buffers shared with the process and posts a
+     *              completion.  A single wait therefore both sleeps and collects every packet that has arrived,
+     *              where the ICMPSocketReactor needs a wait followed by a receive call for each ready socket.
+     *
+     *              Sockets that use the error queue (datagram sockets and sockets with transmit timestamps) also
+     *              have a multishot poll for errors posted, the error queue is read when it completes.
+     *
+     *              On Windows each socket is given a request queue with a set of receives posted into buffers that
+     *              are registered once, the completions of every socket are dequeued in a batch from a single
+     *              completion queue and each receive is posted again as it completes.
+     *
+     *              The ring is only available on Linux 6.3 or later and Windows 8 or later and may be disabled by
+     *              the system, isValid() must be checked and the ICMPSocketReactor used instead if it fails.  The
+     *              interface otherwise mirrors the reactor, wait() returns the sockets with packets and receive()
+     *              collects them.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketRing {
+        public:
+            /**
+             * @brief       Constructs a new ICMPSocketRing.
+             */
+            ICMPSocketRing();
+
+            /**
+             * @brief       Destroys the ICMPSocketRing.
+             *
+             * @note        The registered sockets are not owned by the ring and are not deleted.
+             */
+            ~ICMPSocketRing();
+
+            /**
+             * @brief       Returns whether the ring was created successfully.
+             *
+             * @returns     true if the ring is usable; otherwise false.
+             */
+            auto isValid() -> bool;
+
+            /**
+             * @brief       Registers a socket with the ring and posts its receive.
+             *
+             * @param[in]   socket the socket, simulated sockets are not supported.
+             *
+             * @returns     true if the socket was registered; otherwise false.
+             */
+            auto addSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool;
+
+            /**
+             * @brief       Removes a socket from the ring.
+             *
+             * @details     The posted operations are cancelled, packets already collected for the socket are
+             *              discarded.
+             *
+             * @param[in]   socket the socket to remove.
+             *
+             * @returns     true if the socket was removed; otherwise false.
+             */
+            auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> bool;
+
+            /**
+             * @brief       Waits for packets to arrive on the registered sockets.
+             *
+             * @note        Must only be called from a single thread.
+             *
+             * @param[in]   timeout the maximum time to wait in milliseconds, -1 waits until data arrives or
+             *              wakeup() is called.
+             *
+             * @returns     the list of sockets that have packets, empty on timeout, wakeup or error.
+             */
+            auto wait(int timeout = -1) -> QList<Nedrysoft::ICMPSocket::ICMPSocket *>;
+
+            /**
+             * @brief       Collects the packets that the last wait received for a socket.
+             *
+             * @note        Must be called from the thread that calls wait().
+             *
+             * @param[out]  datagrams the list that the packets are appended to.
+             * @param[in]   socket the socket.
+             *
+             * @returns     the number of packets; otherwise -1 if there were none.
+             */
+            auto receive(
+                Nedrysoft::ICMPSocket::ICMPSocket *socket,
+                QList<Nedrysoft::ICMPSocket::Datagram> &datagrams ) -> int;
+
+            /**
+             * @brief       Interrupts a thread that is blocked in wait().
+             *
+             * @note        This function is thread safe.
+             */
+            auto wakeup() -> void;
+
+        private:
+            //! @cond
+
+            struct Entry {
+                Nedrysoft::ICMPSocket::ICMPSocket *socket = nullptr;
+                QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+                int postedOperations = 0;
+                bool isPosted = false;
+                bool isRemoved = false;
+                bool isCancelled = false;
+                bool isReady = false;
+#if defined(Q_OS_WIN)
+                RIO_RQ requestQueue = RIO_INVALID_RQ;
+                RIO_BUFFERID bufferId = RIO_INVALID_BUFFERID;
+                std::vector<char> buffers;
+#endif
+            };
+
+#if defined(Q_OS_LINUX)
+            /**
+             * @brief       Posts the operations for added sockets and cancels those of removed sockets.
+             *
+             * @details     The kernel completes an operation on the thread that posted it, so operations are only
+             *              posted from the thread that waits, addSocket() and removeSocket() wake it to do so.
+             *
+             * @note        Must be called with the submit mutex held.
+             */
+            auto postChanges() -> void;
+
+            /**
+             * @brief       Posts the multishot receive for a socket.
+             *
+             * @note        Must be called with the submit mutex held.
+             *
+             * @param[in]   entry the socket entry.
+             *
+             * @returns     true if the receive was queued; otherwise false.
+             */
+            auto postReceive(Entry *entry) -> bool;
+
+            /**
+             * @brief       Posts the multishot error poll for a socket.
+             *
+             * @note        Must be called with the submit mutex held.
+             *
+             * @param[in]   entry the socket entry.
+             *
+             * @returns     true if the poll was queued; otherwise false.
+             */
+            auto postErrorPoll(Entry *entry) -> bool;
+
+            /**
+             * @brief       Posts the poll on the wakeup descriptor.
+             *
+             * @note        Must be called with the submit mutex held.
+             *
+             * @returns     true if the poll was queued; otherwise false.
+             */
+            auto postWakeupPoll() -> bool;
+
+            /**
+             * @brief       Returns the next free submission queue entry.
+             *
+             * @note        Must be called with the submit mutex held.
+             *
+             * @returns     the entry; otherwise nullptr if the queue is full.
+             */
+            auto nextSubmission() -> void *;
+
+            /**
+             * @brief       Hands the entry returned by nextSubmission() to the kernel on the next submit().
+             *
+             * @note        Must be called with the submit mutex held.
+             */
+            auto queueSubmission() -> void;
+
+            /**
+             * @brief       Submits the queued entries to the kernel.
+             *
+             * @note        Must be called with the submit mutex held.
+             */
+            auto submit() -> void;
+
+            /**
+             * @brief       Converts a completed receive into a datagram and returns the buffer to the ring.
+             *
+             * @param[in]   entry the socket entry.
+             * @param[in]   result the result of the completion.
+             * @param[in]   flags the flags of the completion.
+             * @param[in]   timestamp the receive time to use if the kernel did not provide one.
+             */
+            auto completeReceive(Entry *entry, int result, uint32_t flags, qint64 timestamp) -> void;
+
+            /**
+             * @brief       Returns a receive buffer to the ring.
+             *
+             * @param[in]   bufferId the id of the buffer.
+             */
+            auto recycleBuffer(uint16_t bufferId) -> void;
+#elif defined(Q_OS_WIN)
+            /**
+             * @brief       Creates the request queues of added sockets and frees the entries of removed sockets.
+             *
+             * @details     Registered I/O is not thread safe, so the queues are only used from the thread that
+             *              waits, addSocket() and removeSocket() wake it to do so.
+             *
+             * @note        Must be called with the submit mutex held.
+             */
+            auto postChanges() -> void;
+
+            /**
+             * @brief       Posts a receive into one of the buffers of a socket.
+             *
+             * @note        Must be called with the submit mutex held.
+             *
+             * @param[in]   entry the socket entry.
+             * @param[in]   slot the index of the buffer.
+             *
+             * @returns     true if the receive was posted; otherwise false.
+             */
+            auto postReceive(Entry *entry, int slot) -> bool;
+
+            /**
+             * @brief       Deregisters the buffers of a socket entry and deletes it.
+             *
+             * @note        Must be called with the submit mutex held and no receives posted.
+             *
+             * @param[in]   entry the socket entry.
+             */
+            auto deleteEntry(Entry *entry) -> void;
+#endif
+
+            QList<Entry *> m_entries;
+            QMutex m_submitMutex;
+
+#if defined(Q_OS_LINUX)
+            int m_ringDescriptor;
+            int m_wakeupDescriptor;
+
+            bool m_wakeupPosted;
+
+            void *m_submissionRing;
+            size_t m_submissionRingSize;
+            void *m_submissions;
+            size_t m_submissionsSize;
+
+            unsigned *m_submissionHead;
+            unsigned *m_submissionTail;
+            unsigned m_submissionMask;
+            unsigned m_submissionEntries;
+            unsigned *m_submissionArray;
+            unsigned *m_completionHead;
+            unsigned *m_completionTail;
+            unsigned m_completionMask;
+            void *m_completions;
+            unsigned m_pendingSubmissions;
+
+            void *m_bufferRing;
+            size_t m_bufferRingSize;
+            uint16_t m_bufferTail;
+            std::vector<char> m_buffers;
+
+            struct msghdr m_receiveHeader;
+#elif defined(Q_OS_WIN)
+            RIO_EXTENSION_FUNCTION_TABLE m_functions;
+            RIO_CQ m_completionQueue;
+            HANDLE m_completionEvent;
+#endif
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETRING_H
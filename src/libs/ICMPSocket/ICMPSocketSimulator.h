@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETSIMULATOR_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETSIMULATOR_H
+
+#include "ICMPSocket.h"
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketSimulator interface replaces the operating system network with an in-process model.
+     *
+     * @details     When a simulator is installed with ICMPSocket::setSimulator the sockets created by the library
+     *              are in-process sockets.  Datagrams sent through them are passed to the simulator, which decides
+     *              what the network would return and queues it on the read sockets with ICMPSocket::deliver.  The
+     *              engines above the socket layer are unchanged, so the scheduler, request tables and receiver are
+     *              exercised exactly as they are against a real network.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketSimulator {
+        public:
+            /**
+             * @brief       Destroys the ICMPSocketSimulator.
+             */
+            virtual ~ICMPSocketSimulator() = default;
+
+            /**
+             * @brief       Called when a read socket has been created.
+             *
+             * @details     A raw read socket receives every packet of its IP version, so replies should be delivered
+             *              to each read socket of the matching version.
+             *
+             * @param[in]   socket the read socket.
+             */
+            virtual auto addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void = 0;
+
+            /**
+             * @brief       Called when a simulated socket is being destroyed.
+             *
+             * @param[in]   socket the socket.
+             */
+            virtual auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void = 0;
+
+            /**
+             * @brief       Called when a datagram is sent through a simulated socket.
+             *
+             * @details     Called on the sending thread, which is usually the ping scheduler, so it must not block.
+             *
+             * @param[in]   socket the socket the datagram was sent through.
+             * @param[in]   datagram the datagram, the ttl is always set.
+             *
+             * @returns     the number of bytes sent; otherwise -1 to report a send error.
+             */
+            virtual auto send(
+                Nedrysoft::ICMPSocket::ICMPSocket *socket,
+                const Nedrysoft::ICMPSocket::Datagram &datagram
+            ) -> int = 0;
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETSIMULATOR_H
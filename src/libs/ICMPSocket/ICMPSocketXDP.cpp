@@ -0,0 +1,934 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ICMPSocketXDP.h"
+
+#if defined(Q_OS_LINUX) && __has_include(<linux/if_xdp.h>)
+#include <linux/bpf.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// programs are attached with a bpf link, which was added to the kernel headers in 5.9 alongside the sleepable flag.
+
+#if defined(XDP_USE_NEED_WAKEUP) && defined(BPF_F_SLEEPABLE)
+#define NEDRYSOFT_ICMPSOCKET_XDP
+#endif
+#endif
+
+#include <QFile>
+#include <QHostAddress>
+#include <QObject>
+#include <QtEndian>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#if defined(NEDRYSOFT_ICMPSOCKET_XDP)
+constexpr auto FrameSize = 2048u;
+constexpr auto RingSize = 2048u;
+constexpr auto FrameCount = RingSize * 2;
+constexpr auto SocketMapEntries = 64;
+constexpr auto IdentifierCount = 65536;
+constexpr auto ReceivePollTimeout = 100;
+constexpr auto NeighbourRefreshInterval = 100000000ll;
+constexpr auto NeighbourProbePort = 9;
+constexpr auto DefaultTTL = 64;
+constexpr auto ProgramLogSize = 65536;
+
+constexpr auto HardwareAddressLength = 6;
+constexpr auto EthernetHeaderLength = 14;
+constexpr auto EthernetTypeOffset = 12;
+constexpr auto EthernetTypeIPv4 = 0x0800;
+
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv4VersionAndHeaderLength = 0x45;
+constexpr auto IPv4TotalLengthOffset = 2;
+constexpr auto IPv4IdOffset = 4;
+constexpr auto IPv4TTLOffset = 8;
+constexpr auto IPv4ProtocolOffset = 9;
+constexpr auto IPv4ChecksumOffset = 10;
+constexpr auto IPv4SourceOffset = 12;
+constexpr auto IPv4DestinationOffset = 16;
+constexpr auto IPv4AddressLength = 4;
+
+constexpr auto ICMPHeaderLength = 8;
+constexpr auto ICMPIdOffset = 4;
+constexpr auto ICMPEchoRequestV4 = 8;
+constexpr auto ICMPEchoReplyV4 = 0;
+constexpr auto ICMPDestinationUnreachableV4 = 3;
+constexpr auto ICMPTimeExceededV4 = 11;
+constexpr auto ICMPParameterProblemV4 = 12;
+
+constexpr auto RouteGatewayFlag = 0x2;
+constexpr auto NeighbourCompleteFlag = 0x2;
+
+constexpr auto RoutePath = "/proc/net/route";
+constexpr auto NeighbourPath = "/proc/net/arp";
+
+// offsets of the fields that the XDP program reads, from the start of the ethernet frame.
+
+constexpr auto FrameIPv4Offset = EthernetHeaderLength;
+constexpr auto FrameICMPOffset = FrameIPv4Offset + IPv4HeaderLength;
+constexpr auto FrameQuotedIPv4Offset = FrameICMPOffset + ICMPHeaderLength;
+constexpr auto FrameQuotedICMPOffset = FrameQuotedIPv4Offset + IPv4HeaderLength;
+
+/**
+ * @brief       Builds an eBPF instruction.
+ *
+ * @param[in]   code the operation.
+ * @param[in]   destination the destination register.
+ * @param[in]   source the source register.
+ * @param[in]   offset the offset or jump distance.
+ * @param[in]   immediate the immediate value.
+ *
+ * @returns     the instruction.
+ */
+static auto instruction(
+        uint8_t code,
+        uint8_t destination,
+        uint8_t source,
+        int16_t offset,
+        int32_t immediate) -> struct bpf_insn {
+
+    struct bpf_insn programInstruction = {};
+
+    programInstruction.code = code;
+    programInstruction.dst_reg = destination;
+    programInstruction.src_reg = source;
+    programInstruction.off = offset;
+    programInstruction.imm = immediate;
+
+    return programInstruction;
+}
+
+/**
+ * @brief       Calls the bpf system call.
+ *
+ * @param[in]   command the command.
+ * @param[in]   attributes the attributes of the command.
+ *
+ * @returns     the result of the command; otherwise -1 on error.
+ */
+static auto bpf(int command, union bpf_attr &attributes) -> int {
+    return static_cast<int>(syscall(__NR_bpf, command, &attributes, sizeof(attributes)));
+}
+
+/**
+ * @brief       Calculates the internet checksum of a buffer.
+ *
+ * @param[in]   data the buffer.
+ * @param[in]   length the length of the buffer, which must be even.
+ *
+ * @returns     the checksum, in the byte order it is stored in the packet.
+ */
+static auto checksum(const uint8_t *data, int length) -> uint16_t {
+    uint32_t sum = 0;
+
+    for (auto index = 0; index < length; index += 2) {
+        uint16_t word;
+
+        memcpy(&word, data + index, sizeof(word));
+
+        sum += word;
+    }
+
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return static_cast<uint16_t>(~sum);
+}
+#endif
+
+Nedrysoft::ICMPSocket::ICMPSocketXDP::ICMPSocketXDP(const QString &interfaceName, int queue) :
+        m_socketDescriptor(-1),
+        m_programDescriptor(-1),
+        m_linkDescriptor(-1),
+        m_socketMapDescriptor(-1),
+        m_identifierMapDescriptor(-1),
+        m_interfaceIndex(0),
+        m_queue(queue),
+        m_interfaceAddress(0),
+        m_interfaceNetmask(0),
+        m_gatewayAddress(0),
+        m_frames(nullptr),
+        m_framesSize(0),
+        m_neighboursTimestamp(0),
+        m_packetId(0),
+        m_stopping(false) {
+
+#if defined(NEDRYSOFT_ICMPSOCKET_XDP)
+    if (!readInterface(interfaceName)) {
+        return;
+    }
+
+    m_socketDescriptor = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+
+    if (m_socketDescriptor < 0) {
+        qWarning() << QObject::tr("Error creating AF_XDP socket.");
+
+        return;
+    }
+
+    // the first half of the frames are given to the driver to receive into, the second half are sent from.
+
+    m_framesSize = static_cast<size_t>(FrameCount) * FrameSize;
+
+    m_frames = mmap(nullptr, m_framesSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (m_frames == MAP_FAILED) {
+        m_frames = nullptr;
+
+        qWarning() << QObject::tr("Error allocating AF_XDP frames.");
+
+        return;
+    }
+
+    struct xdp_umem_reg frameRegion = {};
+
+    frameRegion.addr = reinterpret_cast<uint64_t>(m_frames);
+    frameRegion.len = m_framesSize;
+    frameRegion.chunk_size = FrameSize;
+
+    if (setsockopt(m_socketDescriptor, SOL_XDP, XDP_UMEM_REG, &frameRegion, sizeof(frameRegion)) < 0) {
+        qWarning() << QObject::tr("Error registering AF_XDP frames.");
+
+        return;
+    }
+
+    auto ringSize = static_cast<int>(RingSize);
+
+    for (auto option : {XDP_UMEM_FILL_RING, XDP_UMEM_COMPLETION_RING, XDP_RX_RING, XDP_TX_RING}) {
+        if (setsockopt(m_socketDescriptor, SOL_XDP, option, &ringSize, sizeof(ringSize)) < 0) {
+            qWarning() << QObject::tr("Error creating AF_XDP rings.");
+
+            return;
+        }
+    }
+
+    struct xdp_mmap_offsets offsets = {};
+    socklen_t offsetsLength = sizeof(offsets);
+
+    if (getsockopt(m_socketDescriptor, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsetsLength) < 0) {
+        qWarning() << QObject::tr("Error reading AF_XDP ring offsets.");
+
+        return;
+    }
+
+    auto mapRing = [this](Ring &ring, const struct xdp_ring_offset &offset, size_t descriptorSize, off_t page) {
+        ring.mapSize = offset.desc + RingSize * descriptorSize;
+
+        ring.map = mmap(
+            nullptr,
+            ring.mapSize,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            m_socketDescriptor,
+            page
+        );
+
+        if (ring.map == MAP_FAILED) {
+            ring.map = nullptr;
+
+            return false;
+        }
+
+        auto base = static_cast<char *>(ring.map);
+
+        ring.producer = reinterpret_cast<uint32_t *>(base + offset.producer);
+        ring.consumer = reinterpret_cast<uint32_t *>(base + offset.consumer);
+        ring.flags = reinterpret_cast<uint32_t *>(base + offset.flags);
+        ring.descriptors = base + offset.desc;
+        ring.mask = RingSize - 1;
+
+        return true;
+    };
+
+    if ((!mapRing(m_fillRing, offsets.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)) ||
+        (!mapRing(m_completionRing, offsets.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING)) ||
+        (!mapRing(m_receiveRing, offsets.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING)) ||
+        (!mapRing(m_transmitRing, offsets.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING))) {
+
+        qWarning() << QObject::tr("Error mapping AF_XDP rings.");
+
+        return;
+    }
+
+    auto fillDescriptors = static_cast<uint64_t *>(m_fillRing.descriptors);
+
+    for (auto frame = 0u; frame < RingSize; frame++) {
+        fillDescriptors[frame] = static_cast<uint64_t>(frame) * FrameSize;
+    }
+
+    __atomic_store_n(m_fillRing.producer, RingSize, __ATOMIC_RELEASE);
+
+    for (auto frame = RingSize; frame < FrameCount; frame++) {
+        m_freeFrames.push_back(static_cast<uint64_t>(frame) * FrameSize);
+    }
+
+    m_identifiers.resize(IdentifierCount / 64, 0);
+
+    // the driver decides whether zero copy mode can be used, otherwise frames are copied.
+
+    struct sockaddr_xdp socketAddress = {};
+
+    socketAddress.sxdp_family = AF_XDP;
+    socketAddress.sxdp_ifindex = static_cast<uint32_t>(m_interfaceIndex);
+    socketAddress.sxdp_queue_id = static_cast<uint32_t>(m_queue);
+    socketAddress.sxdp_flags = XDP_USE_NEED_WAKEUP;
+
+    if (bind(m_socketDescriptor, reinterpret_cast<struct sockaddr *>(&socketAddress), sizeof(socketAddress)) < 0) {
+        qWarning() << QObject::tr("Error binding AF_XDP socket to %1 queue %2.").arg(interfaceName).arg(m_queue);
+
+        return;
+    }
+
+    if (!attachProgram()) {
+        return;
+    }
+
+    m_receiveThread = std::thread([this]() {
+        receiveLoop();
+    });
+#else
+    Q_UNUSED(interfaceName)
+#endif
+}
+
+Nedrysoft::ICMPSocket::ICMPSocketXDP::~ICMPSocketXDP() {
+    m_stopping = true;
+
+    if (m_receiveThread.joinable()) {
+        m_receiveThread.join();
+    }
+
+#if defined(NEDRYSOFT_ICMPSOCKET_XDP)
+    // closing the link detaches the program from the interface.
+
+    for (auto descriptor : {
+            m_linkDescriptor,
+            m_programDescriptor,
+            m_socketMapDescriptor,
+            m_identifierMapDescriptor,
+            m_socketDescriptor }) {
+
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+    }
+
+    for (auto ring : {&m_fillRing, &m_completionRing, &m_receiveRing, &m_transmitRing}) {
+        if (ring->map) {
+            munmap(ring->map, ring->mapSize);
+        }
+    }
+
+    if (m_frames) {
+        munmap(m_frames, m_framesSize);
+    }
+#endif
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::isValid() -> bool {
+    return m_receiveThread.joinable();
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    QMutexLocker locker(&m_socketsMutex);
+
+    if (socket->version() == Nedrysoft::ICMPSocket::V4) {
+        m_readSockets.append(socket);
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    QMutexLocker locker(&m_socketsMutex);
+
+    m_readSockets.removeAll(socket);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::send(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket,
+        const Nedrysoft::ICMPSocket::Datagram &datagram) -> int {
+
+#if defined(NEDRYSOFT_ICMPSOCKET_XDP)
+    auto length = datagram.buffer.length();
+    auto frameLength = EthernetHeaderLength + IPv4HeaderLength + length;
+    auto destinationAddress = datagram.socketAddress;
+
+    if (destinationAddress.isNull()) {
+        destinationAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(datagram.hostAddress);
+    }
+
+    if ((socket->version() != Nedrysoft::ICMPSocket::V4) ||
+        (socket->protocol() != Nedrysoft::ICMPSocket::ICMP) ||
+        (destinationAddress.version != Nedrysoft::ICMPSocket::V4) ||
+        (length < ICMPHeaderLength) ||
+        (frameLength > static_cast<int>(FrameSize))) {
+
+        return -1;
+    }
+
+    auto request = reinterpret_cast<const uint8_t *>(datagram.buffer.constData());
+    auto destination = qFromBigEndian<quint32>(destinationAddress.address);
+
+    QMutexLocker locker(&m_transmitMutex);
+
+    auto hardwareAddress = neighbourAddress(destination);
+
+    if (hardwareAddress.isEmpty()) {
+        return -1;
+    }
+
+    reclaimFrames();
+
+    if (m_freeFrames.empty()) {
+        return -1;
+    }
+
+    auto frameAddress = m_freeFrames.back();
+
+    m_freeFrames.pop_back();
+
+    auto frame = static_cast<uint8_t *>(m_frames) + frameAddress;
+
+    memcpy(frame, hardwareAddress.constData(), HardwareAddressLength);
+    memcpy(frame + HardwareAddressLength, m_interfaceHardwareAddress.constData(), HardwareAddressLength);
+
+    qToBigEndian<uint16_t>(EthernetTypeIPv4, frame + EthernetTypeOffset);
+
+    auto header = frame + EthernetHeaderLength;
+
+    memset(header, 0, IPv4HeaderLength);
+
+    header[0] = IPv4VersionAndHeaderLength;
+    header[IPv4TTLOffset] = static_cast<uint8_t>(datagram.ttl ? datagram.ttl : DefaultTTL);
+    header[IPv4ProtocolOffset] = IPPROTO_ICMP;
+
+    qToBigEndian<uint16_t>(static_cast<uint16_t>(IPv4HeaderLength + length), header + IPv4TotalLengthOffset);
+    qToBigEndian<uint16_t>(m_packetId++, header + IPv4IdOffset);
+    qToBigEndian<uint32_t>(m_interfaceAddress, header + IPv4SourceOffset);
+    qToBigEndian<uint32_t>(destination, header + IPv4DestinationOffset);
+
+    auto headerChecksum = checksum(header, IPv4HeaderLength);
+
+    memcpy(header + IPv4ChecksumOffset, &headerChecksum, sizeof(headerChecksum));
+    memcpy(header + IPv4HeaderLength, request, static_cast<size_t>(length));
+
+    // the program only redirects replies to ids that have been sent with, the id is kept in packet byte order
+    // as that is how the program reads it.
+
+    if (request[0] == ICMPEchoRequestV4) {
+        uint16_t identifier;
+
+        memcpy(&identifier, request + ICMPIdOffset, sizeof(identifier));
+
+        auto &word = m_identifiers[identifier / 64];
+        auto bit = 1ull << (identifier % 64);
+
+        if (!(word & bit)) {
+            uint32_t key = identifier;
+            uint32_t value = 1;
+
+            union bpf_attr attributes = {};
+
+            attributes.map_fd = static_cast<uint32_t>(m_identifierMapDescriptor);
+            attributes.key = reinterpret_cast<uint64_t>(&key);
+            attributes.value = reinterpret_cast<uint64_t>(&value);
+
+            if (bpf(BPF_MAP_UPDATE_ELEM, attributes) == 0) {
+                word |= bit;
+            }
+        }
+    }
+
+    auto producer = *m_transmitRing.producer;
+    auto &descriptor = static_cast<struct xdp_desc *>(m_transmitRing.descriptors)[producer & m_transmitRing.mask];
+
+    descriptor.addr = frameAddress;
+    descriptor.len = static_cast<uint32_t>(frameLength);
+    descriptor.options = 0;
+
+    __atomic_store_n(m_transmitRing.producer, producer + 1, __ATOMIC_RELEASE);
+
+    // the driver only needs to be told about new frames when it has gone idle.
+
+    if (__atomic_load_n(m_transmitRing.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP) {
+        ::sendto(m_socketDescriptor, nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+    }
+
+    return length;
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(datagram)
+
+    return -1;
+#endif
+}
+
+#if defined(NEDRYSOFT_ICMPSOCKET_XDP)
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::readInterface(const QString &interfaceName) -> bool {
+    auto name = interfaceName.toLocal8Bit();
+
+    if (name.length() >= IFNAMSIZ) {
+        return false;
+    }
+
+    m_interfaceIndex = static_cast<int>(if_nametoindex(name.constData()));
+
+    if (!m_interfaceIndex) {
+        qWarning() << QObject::tr("Network interface %1 not found.").arg(interfaceName);
+
+        return false;
+    }
+
+    auto controlSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (controlSocket < 0) {
+        return false;
+    }
+
+    struct ifreq request = {};
+
+    memcpy(request.ifr_name, name.constData(), static_cast<size_t>(name.length()));
+
+    auto interfaceAddress = [&request](unsigned long command, int socket) -> quint32 {
+        if (ioctl(socket, command, &request) < 0) {
+            return 0;
+        }
+
+        return qFromBigEndian<quint32>(reinterpret_cast<struct sockaddr_in *>(&request.ifr_addr)->sin_addr.s_addr);
+    };
+
+    m_interfaceAddress = interfaceAddress(SIOCGIFADDR, controlSocket);
+    m_interfaceNetmask = interfaceAddress(SIOCGIFNETMASK, controlSocket);
+
+    if (ioctl(controlSocket, SIOCGIFHWADDR, &request) == 0) {
+        m_interfaceHardwareAddress = QByteArray(request.ifr_hwaddr.sa_data, HardwareAddressLength);
+    }
+
+    close(controlSocket);
+
+    if ((!m_interfaceAddress) || (m_interfaceHardwareAddress.isEmpty())) {
+        qWarning() << QObject::tr("Network interface %1 has no IPv4 address.").arg(interfaceName);
+
+        return false;
+    }
+
+    // the route table shows addresses as hexadecimal in network byte order.
+
+    QFile routeFile(RoutePath);
+
+    if (routeFile.open(QIODevice::ReadOnly)) {
+        auto routes = QString::fromLatin1(routeFile.readAll()).split('\n');
+
+        for (auto index = 1; index < routes.count(); index++) {
+            auto fields = routes.at(index).simplified().split(' ');
+
+            if ((fields.count() < 8) || (fields.at(0) != interfaceName)) {
+                continue;
+            }
+
+            auto flags = fields.at(3).toUInt(nullptr, 16);
+
+            if ((fields.at(1).toUInt(nullptr, 16)) || (fields.at(7).toUInt(nullptr, 16)) ||
+                (!(flags & RouteGatewayFlag))) {
+
+                continue;
+            }
+
+            m_gatewayAddress = qFromBigEndian<quint32>(fields.at(2).toUInt(nullptr, 16));
+
+            break;
+        }
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::attachProgram() -> bool {
+    union bpf_attr attributes = {};
+
+    attributes.map_type = BPF_MAP_TYPE_XSKMAP;
+    attributes.key_size = sizeof(uint32_t);
+    attributes.value_size = sizeof(uint32_t);
+    attributes.max_entries = SocketMapEntries;
+
+    m_socketMapDescriptor = bpf(BPF_MAP_CREATE, attributes);
+
+    attributes = {};
+
+    attributes.map_type = BPF_MAP_TYPE_ARRAY;
+    attributes.key_size = sizeof(uint32_t);
+    attributes.value_size = sizeof(uint32_t);
+    attributes.max_entries = IdentifierCount;
+
+    m_identifierMapDescriptor = bpf(BPF_MAP_CREATE, attributes);
+
+    if ((m_socketMapDescriptor < 0) || (m_identifierMapDescriptor < 0)) {
+        qWarning() << QObject::tr("Error creating XDP maps, the CAP_BPF capability is required.");
+
+        return false;
+    }
+
+    /**
+     * r2 and r3 hold the start and end of the frame, r6 the context and r7 the id.  Every check that fails jumps
+     * to the end of the program, which passes the frame on to the kernel.  The verifier requires the length of
+     * the frame to be checked before each read.
+     */
+
+    std::vector<struct bpf_insn> program;
+    std::vector<size_t> passJumps;
+
+    auto passIf = [&program, &passJumps](uint8_t operation, uint8_t reg, int32_t value) {
+        passJumps.push_back(program.size());
+        program.push_back(instruction(BPF_JMP | operation | BPF_K, reg, 0, 0, value));
+    };
+
+    auto passIfShorterThan = [&program, &passJumps](int32_t length) {
+        program.push_back(instruction(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0));
+        program.push_back(instruction(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, length));
+
+        passJumps.push_back(program.size());
+        program.push_back(instruction(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+    };
+
+    auto loadByte = [&program](int16_t offset) {
+        program.push_back(instruction(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, offset, 0));
+    };
+
+    program.push_back(instruction(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0));
+    program.push_back(instruction(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, data), 0));
+    program.push_back(instruction(
+        BPF_LDX | BPF_MEM | BPF_W,
+        BPF_REG_3,
+        BPF_REG_1,
+        offsetof(struct xdp_md, data_end),
+        0 ));
+
+    passIfShorterThan(FrameQuotedIPv4Offset);
+
+    program.push_back(instruction(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, EthernetTypeOffset, 0));
+
+    passIf(BPF_JNE, BPF_REG_5, qToBigEndian<uint16_t>(EthernetTypeIPv4));
+
+    loadByte(FrameIPv4Offset);
+    passIf(BPF_JNE, BPF_REG_5, IPv4VersionAndHeaderLength);
+
+    loadByte(FrameIPv4Offset + IPv4ProtocolOffset);
+    passIf(BPF_JNE, BPF_REG_5, IPPROTO_ICMP);
+
+    // an echo reply carries the id directly.
+
+    loadByte(FrameICMPOffset);
+
+    program.push_back(instruction(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 2, ICMPEchoReplyV4));
+    program.push_back(instruction(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_7, BPF_REG_2, FrameICMPOffset + ICMPIdOffset, 0));
+
+    auto lookupJump = program.size();
+
+    program.push_back(instruction(BPF_JMP | BPF_JA, 0, 0, 0, 0));
+
+    // an error quotes the echo request that caused it.
+
+    program.push_back(instruction(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_5, 0, 2, ICMPTimeExceededV4));
+    program.push_back(instruction(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_5, 0, 1, ICMPDestinationUnreachableV4));
+
+    passIf(BPF_JNE, BPF_REG_5, ICMPParameterProblemV4);
+    passIfShorterThan(FrameQuotedICMPOffset + ICMPHeaderLength);
+
+    loadByte(FrameQuotedIPv4Offset);
+    passIf(BPF_JNE, BPF_REG_5, IPv4VersionAndHeaderLength);
+
+    loadByte(FrameQuotedIPv4Offset + IPv4ProtocolOffset);
+    passIf(BPF_JNE, BPF_REG_5, IPPROTO_ICMP);
+
+    loadByte(FrameQuotedICMPOffset);
+    passIf(BPF_JNE, BPF_REG_5, ICMPEchoRequestV4);
+
+    program.push_back(instruction(
+        BPF_LDX | BPF_MEM | BPF_H,
+        BPF_REG_7,
+        BPF_REG_2,
+        FrameQuotedICMPOffset + ICMPIdOffset,
+        0 ));
+
+    program[lookupJump].off = static_cast<int16_t>(program.size() - lookupJump - 1);
+
+    // the id is looked up in the map of ids that have been sent with.
+
+    program.push_back(instruction(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_7, -4, 0));
+    program.push_back(instruction(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_identifierMapDescriptor));
+    program.push_back(instruction(0, 0, 0, 0, 0));
+    program.push_back(instruction(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0));
+    program.push_back(instruction(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4));
+    program.push_back(instruction(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem));
+
+    passIf(BPF_JEQ, BPF_REG_0, 0);
+
+    program.push_back(instruction(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_0, 0, 0));
+
+    passIf(BPF_JEQ, BPF_REG_1, 0);
+
+    // the frame is redirected to the socket bound to the queue it arrived on, if there is none it is passed.
+
+    program.push_back(instruction(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_socketMapDescriptor));
+    program.push_back(instruction(0, 0, 0, 0, 0));
+    program.push_back(instruction(
+        BPF_LDX | BPF_MEM | BPF_W,
+        BPF_REG_2,
+        BPF_REG_6,
+        offsetof(struct xdp_md, rx_queue_index),
+        0 ));
+    program.push_back(instruction(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS));
+    program.push_back(instruction(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+    program.push_back(instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+    for (auto jump : passJumps) {
+        program[jump].off = static_cast<int16_t>(program.size() - jump - 1);
+    }
+
+    program.push_back(instruction(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS));
+    program.push_back(instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+    std::vector<char> log(ProgramLogSize, 0);
+
+    attributes = {};
+
+    attributes.prog_type = BPF_PROG_TYPE_XDP;
+    attributes.insns = reinterpret_cast<uint64_t>(program.data());
+    attributes.insn_cnt = static_cast<uint32_t>(program.size());
+    attributes.license = reinterpret_cast<uint64_t>("GPL");
+    attributes.log_buf = reinterpret_cast<uint64_t>(log.data());
+    attributes.log_size = static_cast<uint32_t>(log.size());
+    attributes.log_level = 1;
+
+    m_programDescriptor = bpf(BPF_PROG_LOAD, attributes);
+
+    if (m_programDescriptor < 0) {
+        qWarning() << QObject::tr("Error loading XDP program: %1").arg(QString::fromLatin1(log.data()));
+
+        return false;
+    }
+
+    attributes = {};
+
+    attributes.link_create.prog_fd = static_cast<uint32_t>(m_programDescriptor);
+    attributes.link_create.target_ifindex = static_cast<uint32_t>(m_interfaceIndex);
+    attributes.link_create.attach_type = BPF_XDP;
+
+    m_linkDescriptor = bpf(BPF_LINK_CREATE, attributes);
+
+    if (m_linkDescriptor < 0) {
+        qWarning() << QObject::tr("Error attaching XDP program, another program may already be attached.");
+
+        return false;
+    }
+
+    auto key = static_cast<uint32_t>(m_queue);
+    auto value = static_cast<uint32_t>(m_socketDescriptor);
+
+    attributes = {};
+
+    attributes.map_fd = static_cast<uint32_t>(m_socketMapDescriptor);
+    attributes.key = reinterpret_cast<uint64_t>(&key);
+    attributes.value = reinterpret_cast<uint64_t>(&value);
+
+    if (bpf(BPF_MAP_UPDATE_ELEM, attributes) < 0) {
+        qWarning() << QObject::tr("Error adding AF_XDP socket to the XDP program.");
+
+        return false;
+    }
+
+    return true;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::neighbourAddress(quint32 destination) -> QByteArray {
+    auto nextHop = destination;
+
+    if (((destination ^ m_interfaceAddress) & m_interfaceNetmask) && (m_gatewayAddress)) {
+        nextHop = m_gatewayAddress;
+    }
+
+    auto hardwareAddress = m_neighbours.value(nextHop);
+
+    if (!hardwareAddress.isEmpty()) {
+        return hardwareAddress;
+    }
+
+    auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+    if (timestamp - m_neighboursTimestamp < NeighbourRefreshInterval) {
+        return hardwareAddress;
+    }
+
+    m_neighboursTimestamp = timestamp;
+
+    readNeighbours();
+
+    hardwareAddress = m_neighbours.value(nextHop);
+
+    if (!hardwareAddress.isEmpty()) {
+        return hardwareAddress;
+    }
+
+    // a datagram sent through the kernel makes it resolve the address, the request is dropped until it has.
+
+    auto probeSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (probeSocket >= 0) {
+        struct sockaddr_in probeAddress = {};
+
+        probeAddress.sin_family = AF_INET;
+        probeAddress.sin_port = qToBigEndian<uint16_t>(NeighbourProbePort);
+        probeAddress.sin_addr.s_addr = qToBigEndian<uint32_t>(nextHop);
+
+        ::sendto(
+            probeSocket,
+            nullptr,
+            0,
+            MSG_DONTWAIT,
+            reinterpret_cast<struct sockaddr *>(&probeAddress),
+            sizeof(probeAddress) );
+
+        close(probeSocket);
+    }
+
+    return hardwareAddress;
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::readNeighbours() -> void {
+    QFile neighbourFile(NeighbourPath);
+
+    if (!neighbourFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    auto neighbours = QString::fromLatin1(neighbourFile.readAll()).split('\n');
+
+    for (auto index = 1; index < neighbours.count(); index++) {
+        auto fields = neighbours.at(index).simplified().split(' ');
+
+        if ((fields.count() < 6) || (!(fields.at(2).toUInt(nullptr, 16) & NeighbourCompleteFlag))) {
+            continue;
+        }
+
+        auto address = QHostAddress(fields.at(0));
+        auto hardwareAddress = QByteArray::fromHex(fields.at(3).toLatin1().replace(':', ""));
+
+        if ((address.protocol() == QAbstractSocket::IPv4Protocol) &&
+            (hardwareAddress.length() == HardwareAddressLength)) {
+
+            m_neighbours[address.toIPv4Address()] = hardwareAddress;
+        }
+    }
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::reclaimFrames() -> void {
+    auto consumer = *m_completionRing.consumer;
+    auto producer = __atomic_load_n(m_completionRing.producer, __ATOMIC_ACQUIRE);
+    auto descriptors = static_cast<uint64_t *>(m_completionRing.descriptors);
+
+    if (consumer == producer) {
+        return;
+    }
+
+    for (; consumer != producer; consumer++) {
+        m_freeFrames.push_back(descriptors[consumer & m_completionRing.mask]);
+    }
+
+    __atomic_store_n(m_completionRing.consumer, consumer, __ATOMIC_RELEASE);
+}
+
+auto Nedrysoft::ICMPSocket::ICMPSocketXDP::receiveLoop() -> void {
+    auto receiveDescriptors = static_cast<struct xdp_desc *>(m_receiveRing.descriptors);
+    auto fillDescriptors = static_cast<uint64_t *>(m_fillRing.descriptors);
+
+    while (!m_stopping) {
+        struct pollfd descriptorSet = {};
+
+        descriptorSet.fd = m_socketDescriptor;
+        descriptorSet.events = POLLIN;
+
+        // polling also wakes the driver to refill its receive queue from the fill ring.
+
+        poll(&descriptorSet, 1, ReceivePollTimeout);
+
+        auto consumer = *m_receiveRing.consumer;
+        auto producer = __atomic_load_n(m_receiveRing.producer, __ATOMIC_ACQUIRE);
+
+        if (consumer == producer) {
+            continue;
+        }
+
+        auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+        auto fillProducer = *m_fillRing.producer;
+
+        QList<Nedrysoft::ICMPSocket::Datagram> datagrams;
+
+        for (; consumer != producer; consumer++) {
+            auto &descriptor = receiveDescriptors[consumer & m_receiveRing.mask];
+            auto frame = static_cast<uint8_t *>(m_frames) + descriptor.addr;
+
+            // a read socket of the kernel receives the IPv4 packet without the ethernet header.
+
+            if (descriptor.len > static_cast<uint32_t>(FrameICMPOffset)) {
+                Nedrysoft::ICMPSocket::Datagram datagram;
+
+                datagram.buffer = QByteArray(
+                    reinterpret_cast<const char *>(frame + FrameIPv4Offset),
+                    static_cast<int>(descriptor.len) - FrameIPv4Offset );
+
+                datagram.socketAddress.version = Nedrysoft::ICMPSocket::V4;
+
+                memcpy(datagram.socketAddress.address, frame + FrameIPv4Offset + IPv4SourceOffset, IPv4AddressLength);
+
+                datagram.result = datagram.buffer.length();
+                datagram.timestamp = timestamp;
+
+                datagrams.append(datagram);
+            }
+
+            fillDescriptors[fillProducer++ & m_fillRing.mask] = descriptor.addr - (descriptor.addr % FrameSize);
+        }
+
+        __atomic_store_n(m_receiveRing.consumer, consumer, __ATOMIC_RELEASE);
+        __atomic_store_n(m_fillRing.producer, fillProducer, __ATOMIC_RELEASE);
+
+        QMutexLocker locker(&m_socketsMutex);
+
+        for (auto socket : m_readSockets) {
+            for (auto &datagram : datagrams) {
+                socket->deliver(datagram);
+            }
+        }
+    }
+}
+#endif
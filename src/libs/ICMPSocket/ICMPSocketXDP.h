@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_ICMPSOCKET_ICMPSOCKETXDP_H
+#define NEDRYSOFT_ICMPSOCKET_ICMPSOCKETXDP_H
+
+#include "ICMPSocket.h"
+#include "ICMPSocketSimulator.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Nedrysoft { namespace ICMPSocket {
+    /**
+     * @brief       The ICMPSocketXDP class sends and receives ICMP packets through an AF_XDP socket, bypassing the
+     *              network stack of the kernel.
+     *
+     * @details     Frames are built in a region of memory (the UMEM) that is shared with the network driver and are
+     *              handed to it through the transmit ring, replies are written by the driver into the same region
+     *              and collected from the receive ring, so a packet is never copied by the kernel when the driver
+     *              supports zero copy mode.
+     *
+     *              An XDP program attached to the interface redirects replies to the socket; echo replies, and
+     *              errors quoting an echo request, are matched on an id that the socket has sent with, every other
+     *              packet is passed on to the kernel as normal.  The ids are learnt from the requests as they are
+     *              sent.
+     *
+     *              The socket is installed through the ICMPSocketSimulator interface, which replaces the sockets of
+     *              the operating system with in-process sockets, so the engines above the socket layer are used
+     *              unchanged.  Only IPv4 echo requests are supported, each frame is addressed to the gateway of the
+     *              interface unless the destination is on the local network.
+     *
+     *              Only the replies that arrive on the bound queue of the interface can be redirected, so the
+     *              interface should either have a single queue or steer ICMP to that queue.
+     */
+    class NEDRYSOFT_ICMPSOCKET_DLLSPEC ICMPSocketXDP :
+            public Nedrysoft::ICMPSocket::ICMPSocketSimulator {
+
+        public:
+            /**
+             * @brief       Constructs a new ICMPSocketXDP bound to a queue of an interface.
+             *
+             * @note        Attaching the XDP program requires the CAP_NET_ADMIN and CAP_BPF capabilities.
+             *
+             * @param[in]   interfaceName the name of the network interface.
+             * @param[in]   queue the receive and transmit queue of the interface to bind to.
+             */
+            explicit ICMPSocketXDP(const QString &interfaceName, int queue = 0);
+
+            /**
+             * @brief       Destroys the ICMPSocketXDP, detaching the XDP program from the interface.
+             *
+             * @note        The socket must have been removed with ICMPSocket::setSimulator before it is destroyed.
+             */
+            ~ICMPSocketXDP() override;
+
+            /**
+             * @brief       Returns whether the socket was created and the XDP program attached.
+             *
+             * @returns     true if the socket is usable; otherwise false.
+             */
+            auto isValid() -> bool;
+
+            /**
+             * @brief       Records a new read socket, replies are delivered to every IPv4 read socket.
+             *
+             * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::addReadSocket
+             *
+             * @param[in]   socket the read socket.
+             */
+            auto addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+            /**
+             * @brief       Forgets a socket that is being destroyed.
+             *
+             * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::removeSocket
+             *
+             * @param[in]   socket the socket.
+             */
+            auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+            /**
+             * @brief       Builds the frame for a request and places it on the transmit ring.
+             *
+             * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::send
+             *
+             * @param[in]   socket the socket the request was sent through.
+             * @param[in]   datagram the ICMP echo request.
+             *
+             * @returns     the number of bytes sent; otherwise -1 if the request could not be sent.
+             */
+            auto send(
+                Nedrysoft::ICMPSocket::ICMPSocket *socket,
+                const Nedrysoft::ICMPSocket::Datagram &datagram
+            ) -> int override;
+
+        private:
+            //! @cond
+
+            struct Ring {
+                uint32_t *producer = nullptr;
+                uint32_t *consumer = nullptr;
+                uint32_t *flags = nullptr;
+                void *descriptors = nullptr;
+                uint32_t mask = 0;
+                void *map = nullptr;
+                size_t mapSize = 0;
+            };
+
+#if defined(Q_OS_LINUX)
+            /**
+             * @brief       Reads the addresses of the interface and its gateway.
+             *
+             * @param[in]   interfaceName the name of the network interface.
+             *
+             * @returns     true if the interface has an IPv4 address; otherwise false.
+             */
+            auto readInterface(const QString &interfaceName) -> bool;
+
+            /**
+             * @brief       Creates the maps, loads the XDP program and attaches it to the interface.
+             *
+             * @returns     true if the program was attached; otherwise false.
+             */
+            auto attachProgram() -> bool;
+
+            /**
+             * @brief       Returns the hardware address that a frame to a destination is sent to.
+             *
+             * @details     If the address of the next hop is not in the neighbour table a packet is sent to it
+             *              through the kernel so that it is resolved for later requests.
+             *
+             * @note        Must be called with the transmit mutex held.
+             *
+             * @param[in]   destination the IPv4 destination address.
+             *
+             * @returns     the hardware address; otherwise an empty array if it is not known yet.
+             */
+            auto neighbourAddress(quint32 destination) -> QByteArray;
+
+            /**
+             * @brief       Reloads the neighbour table of the kernel.
+             *
+             * @note        Must be called with the transmit mutex held.
+             */
+            auto readNeighbours() -> void;
+
+            /**
+             * @brief       Returns the frames that the driver has finished transmitting to the free list.
+             *
+             * @note        Must be called with the transmit mutex held.
+             */
+            auto reclaimFrames() -> void;
+
+            /**
+             * @brief       Collects replies from the receive ring and delivers them to the read sockets.
+             */
+            auto receiveLoop() -> void;
+#endif
+
+            int m_socketDescriptor;
+            int m_programDescriptor;
+            int m_linkDescriptor;
+            int m_socketMapDescriptor;
+            int m_identifierMapDescriptor;
+
+            int m_interfaceIndex;
+            int m_queue;
+
+            QByteArray m_interfaceHardwareAddress;
+            quint32 m_interfaceAddress;
+            quint32 m_interfaceNetmask;
+            quint32 m_gatewayAddress;
+
+            void *m_frames;
+            size_t m_framesSize;
+
+            Ring m_fillRing;
+            Ring m_completionRing;
+            Ring m_receiveRing;
+            Ring m_transmitRing;
+
+            QMutex m_transmitMutex;
+            std::vector<uint64_t> m_freeFrames;
+            std::vector<uint64_t> m_identifiers;
+            QHash<quint32, QByteArray> m_neighbours;
+            qint64 m_neighboursTimestamp;
+            uint16_t m_packetId;
+
+            QMutex m_socketsMutex;
+            QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_readSockets;
+
+            std::atomic<bool> m_stopping;
+            std::thread m_receiveThread;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_ICMPSOCKET_ICMPSOCKETXDP_H
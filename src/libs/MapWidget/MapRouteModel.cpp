@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapRouteModel.h"
+
+#include <QTimer>
+#include <algorithm>
+
+constexpr auto FrameInterval = 16;
+
+Nedrysoft::MapWidget::MapRouteModel::MapRouteModel(QObject *parent) :
+        QAbstractListModel(parent),
+        m_publishedCount(0),
+        m_frameTimer(new QTimer(this)) {
+
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setInterval(FrameInterval);
+
+    connect(m_frameTimer, &QTimer::timeout, this, [=]() {
+        flush();
+    });
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::hopIndex(int route, int hop) -> int {
+    auto key = qMakePair(route, hop);
+    auto existing = m_hopIndexes.find(key);
+
+    if (existing!=m_hopIndexes.end()) {
+        return existing.value();
+    }
+
+    // new hops are added to the end of the list and are published as a block by the next flush.
+
+    auto newHop = Hop();
+
+    newHop.route = route;
+    newHop.hop = hop;
+    newHop.located = false;
+    newHop.latitude = 0;
+    newHop.longitude = 0;
+    newHop.hasSegment = false;
+    newHop.previousLatitude = 0;
+    newHop.previousLongitude = 0;
+
+    auto index = m_hops.count();
+
+    m_hops.append(newHop);
+    m_hopIndexes[key] = index;
+
+    auto &routeHops = m_routes[route];
+
+    if (routeHops.count()<=hop) {
+        auto previousCount = routeHops.count();
+
+        routeHops.resize(hop+1);
+
+        std::fill(routeHops.begin()+previousCount, routeHops.end(), -1);
+    }
+
+    routeHops[hop] = index;
+
+    return index;
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::setHop(int route, int hop, const QString &label) -> void {
+    if ((route<0) || (hop<0)) {
+        return;
+    }
+
+    auto count = m_hops.count();
+    auto index = hopIndex(route, hop);
+
+    if ((index<count) && (m_hops.at(index).label==label)) {
+        return;
+    }
+
+    m_hops[index].label = label;
+
+    m_changedHops.insert(index);
+
+    scheduleFlush();
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::setLocation(int route, int hop, double latitude, double longitude) -> void {
+    if ((route<0) || (hop<0)) {
+        return;
+    }
+
+    auto index = hopIndex(route, hop);
+    auto &entry = m_hops[index];
+
+    if ((entry.located) && (entry.latitude==latitude) && (entry.longitude==longitude)) {
+        return;
+    }
+
+    entry.located = true;
+    entry.latitude = latitude;
+    entry.longitude = longitude;
+
+    m_changedHops.insert(index);
+
+    scheduleFlush();
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::clear() -> void {
+    m_frameTimer->stop();
+
+    beginResetModel();
+
+    m_hops.clear();
+    m_hopIndexes.clear();
+    m_routes.clear();
+    m_changedHops.clear();
+    m_publishedCount = 0;
+
+    endResetModel();
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::scheduleFlush() -> void {
+    if (!m_frameTimer->isActive()) {
+        m_frameTimer->start();
+    }
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::updateSegment(int index) -> bool {
+    auto &entry = m_hops[index];
+    auto &routeHops = m_routes[entry.route];
+    auto hasSegment = false;
+    auto previousLatitude = 0.0;
+    auto previousLongitude = 0.0;
+
+    if (entry.located) {
+        for (auto hop=entry.hop-1;hop>=0;hop--) {
+            auto previous = routeHops.at(hop);
+
+            if ((previous>=0) && (m_hops.at(previous).located)) {
+                hasSegment = true;
+                previousLatitude = m_hops.at(previous).latitude;
+                previousLongitude = m_hops.at(previous).longitude;
+
+                break;
+            }
+        }
+    }
+
+    if ((hasSegment==entry.hasSegment) &&
+        (previousLatitude==entry.previousLatitude) &&
+        (previousLongitude==entry.previousLongitude)) {
+
+        return false;
+    }
+
+    entry.hasSegment = hasSegment;
+    entry.previousLatitude = previousLatitude;
+    entry.previousLongitude = previousLongitude;
+
+    return true;
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::flush() -> void {
+    m_frameTimer->stop();
+
+    /**
+     * a change to a hop also moves the start of the segment of the next located hop in the same route (and of any
+     * unlocated hops in between), those hops are added to the set before the segments are recalculated.
+     */
+
+    auto changedHops = m_changedHops;
+
+    for (auto index : m_changedHops) {
+        auto &entry = m_hops.at(index);
+        auto &routeHops = m_routes[entry.route];
+
+        for (auto hop=entry.hop+1;hop<routeHops.count();hop++) {
+            auto next = routeHops.at(hop);
+
+            if (next<0) {
+                continue;
+            }
+
+            changedHops.insert(next);
+
+            if (m_hops.at(next).located) {
+                break;
+            }
+        }
+    }
+
+    m_changedHops.clear();
+
+    auto firstChanged = m_hops.count();
+    auto lastChanged = -1;
+
+    for (auto index : changedHops) {
+        updateSegment(index);
+
+        if (index<m_publishedCount) {
+            firstChanged = std::min(firstChanged, index);
+            lastChanged = std::max(lastChanged, index);
+        }
+    }
+
+    if (m_hops.count()>m_publishedCount) {
+        beginInsertRows(QModelIndex(), m_publishedCount, m_hops.count()-1);
+
+        m_publishedCount = m_hops.count();
+
+        endInsertRows();
+    }
+
+    if (lastChanged>=0) {
+        Q_EMIT dataChanged(index(firstChanged), index(lastChanged));
+    }
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::rowCount(const QModelIndex &parent) const -> int {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_publishedCount;
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::data(const QModelIndex &index, int role) const -> QVariant {
+    if ((!index.isValid()) || (index.row()>=m_publishedCount)) {
+        return QVariant();
+    }
+
+    auto &entry = m_hops.at(index.row());
+
+    switch (role) {
+        case RouteRole: {
+            return entry.route;
+        }
+
+        case HopRole: {
+            return entry.hop;
+        }
+
+        case Qt::DisplayRole:
+        case LabelRole: {
+            return entry.label;
+        }
+
+        case LocatedRole: {
+            return entry.located;
+        }
+
+        case LatitudeRole: {
+            return entry.latitude;
+        }
+
+        case LongitudeRole: {
+            return entry.longitude;
+        }
+
+        case HasSegmentRole: {
+            return entry.hasSegment;
+        }
+
+        case PreviousLatitudeRole: {
+            return entry.previousLatitude;
+        }
+
+        case PreviousLongitudeRole: {
+            return entry.previousLongitude;
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return QVariant();
+}
+
+auto Nedrysoft::MapWidget::MapRouteModel::roleNames() const -> QHash<int, QByteArray> {
+    return QHash<int, QByteArray>{
+        {RouteRole, "route"},
+        {HopRole, "hop"},
+        {LabelRole, "label"},
+        {LocatedRole, "located"},
+        {LatitudeRole, "latitude"},
+        {LongitudeRole, "longitude"},
+        {HasSegmentRole, "hasSegment"},
+        {PreviousLatitudeRole, "previousLatitude"},
+        {PreviousLongitudeRole, "previousLongitude"}
+    };
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NEDRYSOFT_MAPWIDGET_MAPROUTEMODEL_H
+#define NEDRYSOFT_MAPWIDGET_MAPROUTEMODEL_H
+
+#include "MapWidget.h"
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
+class QTimer;
+
+namespace Nedrysoft { namespace MapWidget {
+    /**
+     * @brief       The MapRouteModel class provides the hops of one or more routes to the QML map.
+     *
+     * @details     Each row is a hop of a route, it carries the location of the hop and the location of the
+     *              previous hop of the same route that has been located, so the map draws a marker and the
+     *              segment that leads to it from the same row.
+     *
+     *              Hops and locations arrive one at a time while routes are being discovered, they are held
+     *              until the next frame and then applied together, new hops are inserted as one block at the end
+     *              and the rows that changed are signalled as one range.  The map therefore only creates items for
+     *              new hops and updates the properties of the existing ones, it never rebuilds them.
+     */
+    class NEDRYSOFT_MAPWIDGET_DLLSPEC MapRouteModel :
+            public QAbstractListModel {
+
+        private:
+            Q_OBJECT
+
+        public:
+            /**
+             * @brief       The roles provided to the QML delegates.
+             */
+            enum Role {
+                RouteRole = Qt::UserRole+1,
+                HopRole,
+                LabelRole,
+                LocatedRole,
+                LatitudeRole,
+                LongitudeRole,
+                HasSegmentRole,
+                PreviousLatitudeRole,
+                PreviousLongitudeRole
+            };
+
+        public:
+            /**
+             * @brief       Constructs a new MapRouteModel.
+             *
+             * @param[in]   parent the owner of the model.
+             */
+            explicit MapRouteModel(QObject *parent = nullptr);
+
+            /**
+             * @brief       Adds a hop to a route, or changes the label of an existing hop.
+             *
+             * @param[in]   route the identifier of the route.
+             * @param[in]   hop the index of the hop in the route, 0 is the first hop.
+             * @param[in]   label the text shown for the hop.
+             */
+            auto setHop(int route, int hop, const QString &label) -> void;
+
+            /**
+             * @brief       Sets the location of a hop, the hop is added if it is not already in the model.
+             *
+             * @param[in]   route the identifier of the route.
+             * @param[in]   hop the index of the hop in the route, 0 is the first hop.
+             * @param[in]   latitude the latitude of the hop in degrees.
+             * @param[in]   longitude the longitude of the hop in degrees.
+             */
+            auto setLocation(int route, int hop, double latitude, double longitude) -> void;
+
+            /**
+             * @brief       Removes every route.
+             */
+            auto clear() -> void;
+
+            /**
+             * @brief       Applies the changes that are waiting for the next frame immediately.
+             */
+            auto flush() -> void;
+
+            /**
+             * @brief       Reimplements: QAbstractListModel::rowCount(const QModelIndex &parent).
+             *
+             * @param[in]   parent the parent index.
+             *
+             * @returns     the number of hops.
+             */
+            auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int override;
+
+            /**
+             * @brief       Reimplements: QAbstractListModel::data(const QModelIndex &index, int role).
+             *
+             * @param[in]   index the index of the hop.
+             * @param[in]   role the role.
+             *
+             * @returns     the data for the role.
+             */
+            auto data(const QModelIndex &index, int role = Qt::DisplayRole) const -> QVariant override;
+
+            /**
+             * @brief       Reimplements: QAbstractListModel::roleNames().
+             *
+             * @returns     the names of the roles used by the QML delegates.
+             */
+            auto roleNames() const -> QHash<int, QByteArray> override;
+
+        private:
+            /**
+             * @brief       The state of a hop.
+             */
+            struct Hop {
+                int route;
+                int hop;
+                QString label;
+                bool located;
+                double latitude;
+                double longitude;
+                bool hasSegment;
+                double previousLatitude;
+                double previousLongitude;
+            };
+
+            /**
+             * @brief       Returns the row of a hop, creating the pending hop if needed.
+             *
+             * @param[in]   route the identifier of the route.
+             * @param[in]   hop the index of the hop in the route.
+             *
+             * @returns     the index of the hop in the hop list.
+             */
+            auto hopIndex(int route, int hop) -> int;
+
+            /**
+             * @brief       Starts the frame timer if it is not already running.
+             */
+            auto scheduleFlush() -> void;
+
+            /**
+             * @brief       Updates the segment of a hop from the nearest located hop before it in the route.
+             *
+             * @param[in]   index the index of the hop in the hop list.
+             *
+             * @returns     true if the segment changed; otherwise false.
+             */
+            auto updateSegment(int index) -> bool;
+
+        private:
+            //! @cond
+
+            QVector<Hop> m_hops;
+            QHash<QPair<int, int>, int> m_hopIndexes;
+            QHash<int, QVector<int> > m_routes;
+            int m_publishedCount;
+            QSet<int> m_changedHops;
+            QTimer *m_frameTimer;
+
+            //! @endcond
+    };
+}}
+
+#endif // NEDRYSOFT_MAPWIDGET_MAPROUTEMODEL_H
@@ -23,12 +23,20 @@
 
 #include "MapWidget.h"
 
+#include "MapRouteModel.h"
+
+#include <QQmlContext>
 #include <QQuickWidget>
 
 Nedrysoft::MapWidget::MapWidget::MapWidget(QWidget *parent) :
         QWidget(parent),
         m_mapWidget(new QQuickWidget()),
-        m_mapLayout(new QGridLayout()) {
+        m_mapLayout(new QGridLayout()),
+        m_routeModel(new Nedrysoft::MapWidget::MapRouteModel(this)) {
+
+    // the model must be in the context before the source is loaded as the map items bind to it.
+
+    m_mapWidget->rootContext()->setContextProperty("routeModel", m_routeModel);
 
     m_mapWidget->setSource(QUrl(QString::fromUtf8("qrc:/Nedrysoft/MapWidget/map.qml")));
     m_mapWidget->setResizeMode(QQuickWidget::SizeRootObjectToView);
@@ -44,3 +52,7 @@ Nedrysoft::MapWidget::MapWidget::MapWidget(QWidget *parent) :
 }
 
 Nedrysoft::MapWidget::MapWidget::~MapWidget() = default;
+
+auto Nedrysoft::MapWidget::MapWidget::routeModel() -> Nedrysoft::MapWidget::MapRouteModel * {
+    return m_routeModel;
+}
@@ -36,8 +36,13 @@
 class QQuickWidget;
 
 namespace Nedrysoft { namespace MapWidget {
+    class MapRouteModel;
+
     /**
      * @brief       THe MapWidget is a bridge from the QML map widget to a QWidget.
+     *
+     * @details     The routes shown on the map are provided by the route model, the hops are added and located
+     *              through the model and the map updates its markers and segments as the model changes.
      */
     class NEDRYSOFT_MAPWIDGET_DLLSPEC MapWidget :
             public QWidget {
@@ -55,11 +60,19 @@ namespace Nedrysoft { namespace MapWidget {
              */
             ~MapWidget();
 
+            /**
+             * @brief       Returns the model of the routes drawn on the map.
+             *
+             * @returns     the route model, owned by the widget.
+             */
+            auto routeModel() -> Nedrysoft::MapWidget::MapRouteModel *;
+
         private:
             //! @cond
 
             QQuickWidget *m_mapWidget;
             QGridLayout *m_mapLayout;
+            Nedrysoft::MapWidget::MapRouteModel *m_routeModel;
 
             //! @endcond
     };
@@ -6,6 +6,10 @@ import QtPositioning 5.6
 Item {
     objectName: "mainObject"
 
+    // the colours used to tell routes apart, a route takes the colour at its identifier modulo the count.
+
+    property var routeColours: ["#e6194b", "#3cb44b", "#4363d8", "#f58231", "#911eb4", "#42d4f4", "#f032e6", "#469990"]
+
     Plugin {
         id: mapPlugin
         name: "osm"
@@ -19,6 +23,44 @@ Item {
         plugin: mapPlugin
         center: QtPositioning.coordinate(59.91, 10.75) // Oslo
         zoomLevel: 14
+
+        // each row of the route model draws the segment from the previous located hop of its route.
+
+        MapItemView {
+            model: routeModel
+
+            delegate: MapPolyline {
+                visible: hasSegment
+                line.width: 2
+                line.color: routeColours[route % routeColours.length]
+                path: [
+                    QtPositioning.coordinate(previousLatitude, previousLongitude),
+                    QtPositioning.coordinate(latitude, longitude)
+                ]
+            }
+        }
+
+        MapItemView {
+            model: routeModel
+
+            delegate: MapQuickItem {
+                visible: located
+                coordinate: QtPositioning.coordinate(latitude, longitude)
+                anchorPoint.x: marker.width/2
+                anchorPoint.y: marker.height/2
+
+                sourceItem: Rectangle {
+                    id: marker
+
+                    width: 10
+                    height: 10
+                    radius: 5
+                    color: routeColours[route % routeColours.length]
+                    border.color: "white"
+                    border.width: 1
+                }
+            }
+        }
     }
 
     function setCentre(lat,lng) {
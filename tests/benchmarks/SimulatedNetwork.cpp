@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulatedNetwork.h"
+
+#if defined(Q_OS_UNIX)
+
+#include "ICMPPacket/ICMPPacket.h"
+
+#include <QtEndian>
+#include <chrono>
+#include <cstring>
+#include <time.h>
+
+constexpr auto NanosecondsInSecond = 1000000000.0;
+constexpr auto ReplyTTL = 64;
+
+constexpr auto ICMPHeaderLength = 8;
+constexpr auto ICMPChecksumOffset = 2;
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv4VersionAndHeaderLength = 0x45;
+constexpr auto IPv4TTLOffset = 8;
+constexpr auto IPv4ProtocolOffset = 9;
+constexpr auto IPv4SourceOffset = 12;
+constexpr auto IPv4DestinationOffset = 16;
+constexpr auto IPv6HeaderLength = 40;
+constexpr auto IPv6Version = 0x60;
+constexpr auto IPv6NextHeaderOffset = 6;
+constexpr auto IPv6HopLimitOffset = 7;
+constexpr auto IPv6DestinationOffset = 24;
+constexpr auto IPv6AddressLength = 16;
+
+constexpr auto ICMPEchoRequestV4 = 8;
+constexpr auto ICMPEchoReplyV4 = 0;
+constexpr auto ICMPTimeExceededV4 = 11;
+constexpr auto ICMPEchoRequestV6 = 128;
+constexpr auto ICMPEchoReplyV6 = 129;
+constexpr auto ICMPTimeExceededV6 = 3;
+constexpr auto ICMPProtocolV4 = 1;
+constexpr auto ICMPProtocolV6 = 58;
+
+/**
+ * @brief       Returns the CPU time used by the calling thread.
+ *
+ * @returns     the time in nanoseconds.
+ */
+static auto threadTime() -> qint64 {
+    struct timespec time = {};
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+    return static_cast<qint64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * @brief       Builds an echo reply from an echo request.
+ *
+ * @details     The type is changed and the checksum is updated to match, a reply received on a raw IPv4 socket
+ *              carries the IPv4 header in front of it.
+ *
+ * @param[in]   request the ICMP echo request.
+ * @param[in]   source the address of the destination.
+ * @param[in]   hops the number of hops to the destination.
+ * @param[in]   version the IP version.
+ *
+ * @returns     the reply as it would be read from a raw socket.
+ */
+static auto echoReply(
+        const QByteArray &request,
+        const QHostAddress &source,
+        int hops,
+        Nedrysoft::ICMPSocket::IPVersion version) -> QByteArray {
+
+    auto reply = request;
+    auto data = reply.data();
+
+    uint16_t checksum, oldValue, newValue;
+
+    memcpy(&checksum, data + ICMPChecksumOffset, sizeof(checksum));
+    memcpy(&oldValue, data, sizeof(oldValue));
+
+    data[0] = static_cast<char>((version == Nedrysoft::ICMPSocket::V4) ? ICMPEchoReplyV4 : ICMPEchoReplyV6);
+
+    memcpy(&newValue, data, sizeof(newValue));
+
+    checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, newValue);
+
+    memcpy(data + ICMPChecksumOffset, &checksum, sizeof(checksum));
+
+    if (version == Nedrysoft::ICMPSocket::V6) {
+        return reply;
+    }
+
+    auto header = QByteArray(IPv4HeaderLength, 0);
+
+    header[0] = static_cast<char>(IPv4VersionAndHeaderLength);
+    header[IPv4TTLOffset] = static_cast<char>(ReplyTTL - hops + 1);
+    header[IPv4ProtocolOffset] = static_cast<char>(ICMPProtocolV4);
+
+    qToBigEndian<uint32_t>(source.toIPv4Address(), header.data() + IPv4SourceOffset);
+
+    return header + reply;
+}
+
+/**
+ * @brief       Builds the time exceeded message a router sends when a request expires.
+ *
+ * @param[in]   request the ICMP echo request, which is quoted in full.
+ * @param[in]   router the address of the router.
+ * @param[in]   destination the destination of the request.
+ * @param[in]   hop the hop number of the router.
+ * @param[in]   version the IP version.
+ *
+ * @returns     the message as it would be read from a raw socket.
+ */
+static auto timeExceeded(
+        const QByteArray &request,
+        const QHostAddress &router,
+        const QHostAddress &destination,
+        int hop,
+        Nedrysoft::ICMPSocket::IPVersion version) -> QByteArray {
+
+    auto message = QByteArray(ICMPHeaderLength, 0);
+    QByteArray quotedHeader;
+
+    if (version == Nedrysoft::ICMPSocket::V4) {
+        message[0] = static_cast<char>(ICMPTimeExceededV4);
+
+        quotedHeader = QByteArray(IPv4HeaderLength, 0);
+
+        quotedHeader[0] = static_cast<char>(IPv4VersionAndHeaderLength);
+        quotedHeader[IPv4TTLOffset] = 1;
+        quotedHeader[IPv4ProtocolOffset] = static_cast<char>(ICMPProtocolV4);
+
+        qToBigEndian<uint32_t>(destination.toIPv4Address(), quotedHeader.data() + IPv4DestinationOffset);
+    } else {
+        message[0] = static_cast<char>(ICMPTimeExceededV6);
+
+        quotedHeader = QByteArray(IPv6HeaderLength, 0);
+
+        quotedHeader[0] = static_cast<char>(IPv6Version);
+        quotedHeader[IPv6NextHeaderOffset] = static_cast<char>(ICMPProtocolV6);
+        quotedHeader[IPv6HopLimitOffset] = 1;
+
+        auto address = destination.toIPv6Address();
+
+        memcpy(quotedHeader.data() + IPv6DestinationOffset, &address, IPv6AddressLength);
+    }
+
+    message.append(quotedHeader);
+    message.append(request);
+
+    auto checksum = Nedrysoft::ICMPPacket::ICMPPacket::checksum(message.data(), message.length());
+
+    memcpy(message.data() + ICMPChecksumOffset, &checksum, sizeof(checksum));
+
+    if (version == Nedrysoft::ICMPSocket::V6) {
+        return message;
+    }
+
+    auto header = QByteArray(IPv4HeaderLength, 0);
+
+    header[0] = static_cast<char>(IPv4VersionAndHeaderLength);
+    header[IPv4TTLOffset] = static_cast<char>(ReplyTTL - hop + 1);
+    header[IPv4ProtocolOffset] = static_cast<char>(ICMPProtocolV4);
+
+    qToBigEndian<uint32_t>(router.toIPv4Address(), header.data() + IPv4SourceOffset);
+
+    return header + message;
+}
+
+SimulatedNetwork::SimulatedNetwork() :
+        m_deliveryTime(0),
+        m_stopping(false) {
+
+    setConfiguration(Configuration());
+
+    m_deliveryThread = std::thread(&SimulatedNetwork::deliveryLoop, this);
+}
+
+SimulatedNetwork::~SimulatedNetwork() {
+    // sockets that outlive the network must not call back into it.
+
+    if (Nedrysoft::ICMPSocket::ICMPSocket::simulator() == this) {
+        Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(nullptr);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    m_deliveryThread.join();
+}
+
+auto SimulatedNetwork::getInstance() -> SimulatedNetwork * {
+    static SimulatedNetwork network;
+
+    return &network;
+}
+
+auto SimulatedNetwork::setConfiguration(const SimulatedNetwork::Configuration &configuration) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_configuration = configuration;
+    m_configuration.hopCount = qMax(configuration.hopCount, 1);
+
+    m_counters = Counters();
+    m_random.seed(configuration.seed);
+
+    m_tokens.fill(m_configuration.rateLimitBurst, m_configuration.hopCount+1);
+    m_tokenTimestamps.fill(Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp(), m_configuration.hopCount+1);
+}
+
+auto SimulatedNetwork::configuration() -> SimulatedNetwork::Configuration {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_configuration;
+}
+
+auto SimulatedNetwork::counters() -> SimulatedNetwork::Counters {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_counters;
+}
+
+auto SimulatedNetwork::deliveryTime() -> double {
+    return static_cast<double>(m_deliveryTime.load())/NanosecondsInSecond;
+}
+
+auto SimulatedNetwork::routerAddress(int hop, Nedrysoft::ICMPSocket::IPVersion version) -> QHostAddress {
+    if (version == Nedrysoft::ICMPSocket::V4) {
+        return QHostAddress(QString("10.255.%1.1").arg(hop));
+    }
+
+    return QHostAddress(QString("fd00:ffff::%1").arg(hop, 0, 16));
+}
+
+auto SimulatedNetwork::addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_readSockets.append(socket);
+}
+
+auto SimulatedNetwork::removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_readSockets.removeAll(socket);
+}
+
+auto SimulatedNetwork::send(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket,
+        const Nedrysoft::ICMPSocket::Datagram &datagram) -> int {
+
+    auto version = socket->version();
+    auto requestType = (version == Nedrysoft::ICMPSocket::V4) ? ICMPEchoRequestV4 : ICMPEchoRequestV6;
+
+    // only echo requests are modelled, UDP and TCP probes are accepted and never answered.
+
+    if ((socket->protocol() != Nedrysoft::ICMPSocket::ICMP) ||
+        (datagram.buffer.length() < ICMPHeaderLength) ||
+        (static_cast<uint8_t>(datagram.buffer.at(0)) != requestType)) {
+
+        return datagram.buffer.length();
+    }
+
+    auto timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_counters.requests++;
+
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    if (uniform(m_random) < m_configuration.lossProbability) {
+        m_counters.lost++;
+
+        return datagram.buffer.length();
+    }
+
+    auto hop = qBound(1, datagram.ttl, m_configuration.hopCount);
+
+    PendingReply reply;
+
+    reply.version = version;
+    reply.datagram.timestamp = -1;
+
+    if (hop < m_configuration.hopCount) {
+        if (!takeToken(hop, timestamp)) {
+            m_counters.rateLimited++;
+
+            return datagram.buffer.length();
+        }
+
+        reply.datagram.hostAddress = routerAddress(hop, version);
+        reply.datagram.buffer = timeExceeded(
+            datagram.buffer,
+            reply.datagram.hostAddress,
+            datagram.hostAddress,
+            hop,
+            version );
+    } else {
+        reply.datagram.hostAddress = datagram.hostAddress;
+        reply.datagram.buffer = echoReply(datagram.buffer, datagram.hostAddress, hop, version);
+    }
+
+    reply.due = timestamp + latency(hop);
+
+    if (uniform(m_random) < m_configuration.reorderProbability) {
+        reply.due += static_cast<qint64>(m_configuration.reorderDelay * NanosecondsInSecond);
+
+        m_counters.reordered++;
+    }
+
+    auto wakeDelivery = (m_pendingReplies.empty()) || (reply.due < m_pendingReplies.top().due);
+
+    m_pendingReplies.push(std::move(reply));
+
+    m_counters.replies++;
+
+    lock.unlock();
+
+    if (wakeDelivery) {
+        m_condition.notify_one();
+    }
+
+    return datagram.buffer.length();
+}
+
+auto SimulatedNetwork::latency(int hop) -> qint64 {
+    auto variation = 0.0;
+
+    switch (m_configuration.distribution) {
+        case LatencyDistribution::Constant: {
+            break;
+        }
+
+        case LatencyDistribution::Normal: {
+            std::normal_distribution<double> normal(0, m_configuration.latencyDeviation);
+
+            variation = normal(m_random);
+
+            break;
+        }
+
+        case LatencyDistribution::Exponential: {
+            if (m_configuration.latencyDeviation > 0) {
+                std::exponential_distribution<double> exponential(1.0 / m_configuration.latencyDeviation);
+
+                variation = exponential(m_random);
+            }
+
+            break;
+        }
+    }
+
+    auto roundTripTime = qMax(0.0, (static_cast<double>(hop) * m_configuration.hopLatency) + variation);
+
+    return static_cast<qint64>(roundTripTime * NanosecondsInSecond);
+}
+
+auto SimulatedNetwork::takeToken(int hop, qint64 timestamp) -> bool {
+    if (m_configuration.rateLimit <= 0) {
+        return true;
+    }
+
+    auto elapsed = static_cast<double>(timestamp - m_tokenTimestamps[hop]) / NanosecondsInSecond;
+
+    m_tokenTimestamps[hop] = timestamp;
+    m_tokens[hop] = qMin(m_configuration.rateLimitBurst, m_tokens[hop] + (elapsed * m_configuration.rateLimit));
+
+    if (m_tokens[hop] < 1) {
+        return false;
+    }
+
+    m_tokens[hop] -= 1;
+
+    return true;
+}
+
+auto SimulatedNetwork::deliveryLoop() -> void {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto startTime = threadTime();
+
+    while (!m_stopping) {
+        if (m_pendingReplies.empty()) {
+            m_deliveryTime = threadTime() - startTime;
+
+            m_condition.wait(lock);
+
+            continue;
+        }
+
+        auto remaining = m_pendingReplies.top().due - Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+        if (remaining > 0) {
+            m_deliveryTime = threadTime() - startTime;
+
+            m_condition.wait_for(lock, std::chrono::nanoseconds(remaining));
+
+            continue;
+        }
+
+        /**
+         * the reply is delivered with the mutex held, so a socket cannot be destroyed while a reply is being
+         * queued on it.
+         */
+
+        auto reply = m_pendingReplies.top();
+
+        m_pendingReplies.pop();
+
+        reply.datagram.timestamp = reply.due;
+
+        for (auto socket : m_readSockets) {
+            if (socket->version() == reply.version) {
+                socket->deliver(reply.datagram);
+            }
+        }
+    }
+}
+
+#endif // defined(Q_OS_UNIX)
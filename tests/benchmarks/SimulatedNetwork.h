@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMULATEDNETWORK_H
+#define SIMULATEDNETWORK_H
+
+#include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketSimulator.h"
+
+#include <QHostAddress>
+#include <QList>
+#include <QVector>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief       The SimulatedNetwork class is an in-process network that answers the requests of the ping engines.
+ *
+ * @details     Every destination is the same number of hops away and each hop adds the same latency, the route to
+ *              every destination passes through the same routers so their ICMP rate limits are shared between all
+ *              targets, as they would be for the first hops of a real network.  A request with a TTL smaller than
+ *              the hop count is answered with a time exceeded message from the router at that hop, otherwise the
+ *              destination replies.  Replies are delivered to the read sockets by a delivery thread at the time
+ *              the modelled latency says they would arrive.
+ *
+ *              The random number generator is seeded from the configuration, so for a given configuration and
+ *              sequence of requests the same replies are lost, limited and reordered on every run.
+ */
+class SimulatedNetwork :
+        public Nedrysoft::ICMPSocket::ICMPSocketSimulator {
+
+    public:
+        /**
+         * @brief       The distribution of the latency added to the fixed latency of each hop.
+         */
+        enum class LatencyDistribution {
+            Constant,                           /**< no variation. */
+            Normal,                             /**< normally distributed, clamped at zero. */
+            Exponential                         /**< exponentially distributed, a long tail of slow replies. */
+        };
+
+        /**
+         * @brief       The configuration of the network.
+         */
+        struct Configuration {
+            int hopCount = 8;                   //!< the number of hops to each destination, including it.
+            double hopLatency = 0.001;          //!< the round trip time added by each hop in seconds.
+            double latencyDeviation = 0.0002;   //!< the standard deviation (or mean) of the variation in seconds.
+            LatencyDistribution distribution = LatencyDistribution::Normal;
+            double lossProbability = 0;         //!< the probability that a request or its reply is lost.
+            double rateLimit = 0;               //!< the time exceeded messages each router sends per second, 0 is unlimited.
+            double rateLimitBurst = 10;         //!< the number of messages a router can send in a burst.
+            double reorderProbability = 0;      //!< the probability that a reply is held back.
+            double reorderDelay = 0.002;        //!< the time in seconds that a held back reply is delayed.
+            quint32 seed = 1;                   //!< the seed of the random number generator.
+        };
+
+        /**
+         * @brief       The counters of what the network has done with the requests it was sent.
+         */
+        struct Counters {
+            quint64 requests = 0;
+            quint64 replies = 0;
+            quint64 lost = 0;
+            quint64 rateLimited = 0;
+            quint64 reordered = 0;
+        };
+
+    private:
+        /**
+         * @brief       Constructs the SimulatedNetwork and starts the delivery thread.
+         */
+        SimulatedNetwork();
+
+    public:
+        /**
+         * @brief       Stops the delivery thread and destroys the SimulatedNetwork.
+         */
+        ~SimulatedNetwork() override;
+
+        /**
+         * @brief       Returns the SimulatedNetwork instance.
+         *
+         * @returns     the network.
+         */
+        static auto getInstance() -> SimulatedNetwork *;
+
+        /**
+         * @brief       Replaces the configuration.
+         *
+         * @details     The random number generator is reseeded, the routers are given a full burst allowance and
+         *              the counters are reset.  Replies that are already in flight are still delivered.
+         *
+         * @param[in]   configuration the configuration.
+         */
+        auto setConfiguration(const Configuration &configuration) -> void;
+
+        /**
+         * @brief       Returns the configuration.
+         *
+         * @returns     the configuration.
+         */
+        auto configuration() -> Configuration;
+
+        /**
+         * @brief       Returns the counters since the configuration was last set.
+         *
+         * @returns     the counters.
+         */
+        auto counters() -> Counters;
+
+        /**
+         * @brief       Returns the CPU time used by the delivery thread.
+         *
+         * @details     The delivery thread stands in for the operating system, so its time can be subtracted from
+         *              the time used by the process to leave the cost of the engine.
+         *
+         * @returns     the CPU time in seconds.
+         */
+        auto deliveryTime() -> double;
+
+        /**
+         * @brief       Returns the address of the router at a hop.
+         *
+         * @param[in]   hop the hop number, starting at 1.
+         * @param[in]   version the IP version.
+         *
+         * @returns     the router address.
+         */
+        static auto routerAddress(int hop, Nedrysoft::ICMPSocket::IPVersion version) -> QHostAddress;
+
+        /**
+         * @brief       Records a new read socket.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::addReadSocket
+         *
+         * @param[in]   socket the read socket.
+         */
+        auto addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+        /**
+         * @brief       Forgets a socket that is being destroyed.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::removeSocket
+         *
+         * @param[in]   socket the socket.
+         */
+        auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+        /**
+         * @brief       Works out the fate of a request and schedules its reply.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::send
+         *
+         * @param[in]   socket the socket the request was sent through.
+         * @param[in]   datagram the request.
+         *
+         * @returns     the number of bytes sent.
+         */
+        auto send(
+            Nedrysoft::ICMPSocket::ICMPSocket *socket,
+            const Nedrysoft::ICMPSocket::Datagram &datagram
+        ) -> int override;
+
+    private:
+        /**
+         * @brief       Returns the round trip time to a hop.
+         *
+         * @note        Must be called with the mutex held.
+         *
+         * @param[in]   hop the hop number.
+         *
+         * @returns     the latency in nanoseconds.
+         */
+        auto latency(int hop) -> qint64;
+
+        /**
+         * @brief       Takes a token from a router's rate limit.
+         *
+         * @note        Must be called with the mutex held.
+         *
+         * @param[in]   hop the hop number of the router.
+         * @param[in]   timestamp the current time in nanoseconds.
+         *
+         * @returns     true if the router may reply; otherwise false.
+         */
+        auto takeToken(int hop, qint64 timestamp) -> bool;
+
+        /**
+         * @brief       Delivers replies to the read sockets as they become due.
+         */
+        auto deliveryLoop() -> void;
+
+    private:
+        //! @cond
+
+        struct PendingReply {
+            qint64 due;
+            Nedrysoft::ICMPSocket::IPVersion version;
+            Nedrysoft::ICMPSocket::Datagram datagram;
+
+            auto operator>(const PendingReply &other) const -> bool {
+                return due > other.due;
+            }
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+
+        Configuration m_configuration;
+        Counters m_counters;
+        std::mt19937 m_random;
+        QVector<double> m_tokens;
+        QVector<qint64> m_tokenTimestamps;
+
+        QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_readSockets;
+        std::priority_queue<PendingReply, std::vector<PendingReply>, std::greater<PendingReply> > m_pendingReplies;
+
+        std::atomic<qint64> m_deliveryTime;
+        bool m_stopping;
+        std::thread m_deliveryThread;
+
+        //! @endcond
+};
+
+#endif // SIMULATEDNETWORK_H
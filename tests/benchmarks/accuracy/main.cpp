@@ -0,0 +1,565 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+
+#if defined(Q_OS_LINUX)
+
+#include <ComponentLoader>
+#include <IComponentManager>
+#include <IPingEngine.h>
+#include <IPingEngineFactory.h>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <vector>
+
+constexpr auto NamespaceName = "pingnoo-accuracy";
+constexpr auto HostInterface = "pingnoo-acc0";
+constexpr auto PeerInterface = "pingnoo-acc1";
+constexpr auto HostAddress = "10.213.0.1/30";
+constexpr auto PeerAddress = "10.213.0.2";
+constexpr auto PeerAddressPrefix = "10.213.0.2/30";
+constexpr auto DefaultEngines = "Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory,"
+                                "Nedrysoft::ICMPPingEngine::UDPPingEngineFactory,"
+                                "Nedrysoft::ICMPPingEngine::TCPPingEngineFactory,"
+                                "Nedrysoft::PingCommandPingEngine::PingCommandPingEngineFactory";
+constexpr auto DefaultDuration = 20;
+constexpr auto DefaultInterval = 100;
+constexpr auto DefaultBiasTolerance = 1.0;
+constexpr auto DefaultErrorTolerance = 2.0;
+constexpr auto DefaultLossTolerance = 5.0;
+constexpr auto BaselineCount = 50;
+constexpr auto MinimumTimeout = 1000;
+constexpr auto TimeoutFactor = 4;
+constexpr auto ErrorPercentile = 99.0;
+constexpr auto CommandTimeout = 30000;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+/**
+ * @brief       A set of network conditions applied with netem.
+ */
+struct Scenario {
+    const char *name;                           //!< the name of the scenario.
+    double delay;                               //!< the delay added to each request in milliseconds.
+    double jitter;                              //!< the delay is spread uniformly by plus or minus this in ms.
+    double loss;                                //!< the percentage of requests that are dropped.
+};
+
+/**
+ * @brief       The scenarios that each engine is run against.
+ */
+static const Scenario Scenarios[] = {
+    {"delay", 20, 0, 0},
+    {"delay and loss", 50, 0, 5},
+    {"jitter", 30, 10, 0},
+    {"jitter and loss", 80, 20, 2}
+};
+
+/**
+ * @brief       Runs a command and waits for it to finish.
+ *
+ * @param[in]   program the program to run.
+ * @param[in]   arguments the arguments of the program.
+ * @param[out]  output if not nullptr, receives the standard output of the program.
+ *
+ * @returns     true if the program ran and exited with a zero status; otherwise false.
+ */
+static auto runCommand(const QString &program, const QStringList &arguments, QByteArray *output = nullptr) -> bool {
+    QProcess process;
+
+    process.setProcessChannelMode(QProcess::SeparateChannels);
+
+    process.start(program, arguments);
+
+    if ((!process.waitForStarted()) || (!process.waitForFinished(CommandTimeout))) {
+        SPDLOG_ERROR(QString("Unable to run %1 %2.").arg(program).arg(arguments.join(" ")).toStdString());
+
+        return false;
+    }
+
+    if (output) {
+        *output = process.readAllStandardOutput();
+    }
+
+    return (process.exitStatus()==QProcess::NormalExit) && (process.exitCode()==0);
+}
+
+/**
+ * @brief       Runs a command inside the network namespace of the peer.
+ *
+ * @param[in]   arguments the program and its arguments.
+ *
+ * @returns     true if the program exited with a zero status; otherwise false.
+ */
+static auto runInNamespace(const QStringList &arguments) -> bool {
+    return runCommand("ip", QStringList{"netns", "exec", NamespaceName}+arguments);
+}
+
+/**
+ * @brief       Removes the network namespace and the veth pair, ignoring anything that does not exist.
+ */
+static auto tearDownNetwork() -> void {
+    runCommand("ip", {"link", "del", HostInterface});
+    runCommand("ip", {"netns", "del", NamespaceName});
+}
+
+/**
+ * @brief       Creates the peer in its own network namespace, reached from this host over a veth pair.
+ *
+ * @details     The requests leave through the host end of the pair, so the netem discipline on that end delays
+ *              and drops the requests and the replies come back unaltered.  The peer answers echo requests, UDP
+ *              probes with port unreachable and TCP probes with a reset, the rate limit on the ICMP errors is
+ *              removed so that the UDP probes are not lost to it.
+ *
+ * @returns     true if the network was created; otherwise false.
+ */
+static auto setUpNetwork() -> bool {
+    tearDownNetwork();
+
+    return runCommand("ip", {"netns", "add", NamespaceName}) &&
+           runCommand("ip", {"link", "add", HostInterface, "type", "veth", "peer", "name", PeerInterface}) &&
+           runCommand("ip", {"link", "set", PeerInterface, "netns", NamespaceName}) &&
+           runCommand("ip", {"addr", "add", HostAddress, "dev", HostInterface}) &&
+           runCommand("ip", {"link", "set", HostInterface, "up"}) &&
+           runInNamespace({"ip", "addr", "add", PeerAddressPrefix, "dev", PeerInterface}) &&
+           runInNamespace({"ip", "link", "set", PeerInterface, "up"}) &&
+           runInNamespace({"ip", "link", "set", "lo", "up"}) &&
+           runInNamespace({"sysctl", "-q", "-w", "net.ipv4.icmp_ratelimit=0"});
+}
+
+/**
+ * @brief       Applies the network conditions of a scenario to the requests sent to the peer.
+ *
+ * @param[in]   scenario the scenario, or nullptr to remove any conditions.
+ *
+ * @returns     true if the conditions were applied; otherwise false.
+ */
+static auto applyScenario(const Scenario *scenario) -> bool {
+    if (!scenario) {
+        runCommand("tc", {"qdisc", "del", "dev", HostInterface, "root"});
+
+        return true;
+    }
+
+    auto arguments = QStringList{"qdisc", "replace", "dev", HostInterface, "root", "netem", "delay"};
+
+    arguments.append(QString("%1ms").arg(scenario->delay));
+
+    if (scenario->jitter>0) {
+        arguments.append(QString("%1ms").arg(scenario->jitter));
+    }
+
+    if (scenario->loss>0) {
+        arguments.append({"loss", QString("%1%").arg(scenario->loss)});
+    }
+
+    return runCommand("tc", arguments);
+}
+
+/**
+ * @brief       Measures the round trip time of the veth pair without any added conditions.
+ *
+ * @details     The system ping command is used so that the baseline does not depend on any of the engines that
+ *              are being measured.
+ *
+ * @returns     the mean round trip time in milliseconds; 0 if it could not be measured.
+ */
+static auto baselineRoundTrip() -> double {
+    QByteArray output;
+
+    if (!runCommand("ping", {"-q", "-n", "-c", QString::number(BaselineCount), "-i", "0.01", PeerAddress}, &output)) {
+        return 0;
+    }
+
+    // the summary line is "rtt min/avg/max/mdev = 0.021/0.034/0.088/0.010 ms".
+
+    auto match = QRegularExpression("= [0-9.]+/([0-9.]+)/").match(QString::fromLatin1(output));
+
+    return match.hasMatch() ? match.captured(1).toDouble() : 0;
+}
+
+/**
+ * @brief       Returns a percentile of a sorted set of values.
+ *
+ * @param[in]   values the values in ascending order.
+ * @param[in]   percentile the percentile.
+ *
+ * @returns     the value at the percentile; 0 if there are no values.
+ */
+static auto percentile(const std::vector<double> &values, double percentile) -> double {
+    if (values.empty()) {
+        return 0;
+    }
+
+    return values.at(static_cast<size_t>((percentile/100.0)*static_cast<double>(values.size()-1)));
+}
+
+/**
+ * @brief       Runs the processing of the main thread for a time.
+ *
+ * @param[in]   milliseconds the time to run for.
+ */
+static auto runEventLoop(int milliseconds) -> void {
+    QEventLoop eventLoop;
+
+    QTimer::singleShot(milliseconds, &eventLoop, &QEventLoop::quit);
+
+    eventLoop.exec();
+}
+
+/**
+ * @brief       Runs an engine against the peer under a scenario and compares what it reports with the conditions.
+ *
+ * @details     The delay of each request is not known, but netem spreads it uniformly across the jitter, so the
+ *              sorted round trip times are compared with the quantiles of that distribution.  With no jitter this
+ *              is the difference of every sample from the delay.  The baseline of the veth pair is subtracted.
+ *
+ * @param[in]   factory the factory of the engine.
+ * @param[in]   scenario the conditions that are applied.
+ * @param[in]   duration the time to run for in seconds.
+ * @param[in]   interval the interval between requests in milliseconds.
+ * @param[in]   baseline the round trip time of the veth pair in milliseconds.
+ *
+ * @returns     the results.
+ */
+static auto measure(
+        Nedrysoft::RouteAnalyser::IPingEngineFactory *factory,
+        const Scenario &scenario,
+        int duration,
+        int interval,
+        double baseline ) -> QJsonObject {
+
+    auto engine = factory->createEngine(Nedrysoft::Core::IPVersion::V4);
+
+    if (!engine) {
+        return QJsonObject{{"working", false}};
+    }
+
+    auto timeout = std::max(static_cast<int>((scenario.delay+scenario.jitter)*TimeoutFactor), MinimumTimeout);
+
+    engine->setInterval(interval);
+    engine->setTimeout(timeout);
+
+    engine->addTarget(QHostAddress(PeerAddress));
+
+    auto roundTripTimes = std::vector<double>();
+    quint64 lost = 0;
+
+    QObject context;
+
+    QObject::connect(
+        engine,
+        &Nedrysoft::RouteAnalyser::IPingEngine::result,
+        &context,
+        [&](Nedrysoft::RouteAnalyser::PingResult pingResult) {
+
+            if (Nedrysoft::RouteAnalyser::PingResult::isLost(pingResult.code())) {
+                lost++;
+
+                return;
+            }
+
+            roundTripTimes.push_back(pingResult.roundTripTime()*MillisecondsInSecond);
+        } );
+
+    QElapsedTimer runClock;
+
+    runClock.start();
+
+    engine->start();
+
+    runEventLoop(duration*static_cast<int>(MillisecondsInSecond));
+
+    engine->stop();
+
+    auto elapsed = static_cast<double>(runClock.elapsed())/MillisecondsInSecond;
+
+    // the requests still in flight are given the time to be answered or to time out.
+
+    runEventLoop(timeout*2);
+
+    factory->deleteEngine(engine);
+
+    auto replies = roundTripTimes.size();
+    auto total = static_cast<double>(replies+lost);
+
+    if (!replies) {
+        return QJsonObject{{"working", false}, {"lost", static_cast<qint64>(lost)}};
+    }
+
+    std::sort(roundTripTimes.begin(), roundTripTimes.end());
+
+    auto errors = std::vector<double>();
+    auto sum = 0.0;
+
+    for (auto index=static_cast<size_t>(0);index<replies;index++) {
+        auto quantile = (static_cast<double>(index)+0.5)/static_cast<double>(replies);
+        auto expected = scenario.delay-scenario.jitter+(2*scenario.jitter*quantile);
+        auto measured = roundTripTimes.at(index)-baseline;
+
+        errors.push_back(std::fabs(measured-expected));
+
+        sum += measured;
+    }
+
+    std::sort(errors.begin(), errors.end());
+
+    auto loss = (total>0) ? (static_cast<double>(lost)*100.0)/total : 0;
+
+    return QJsonObject{
+        {"working", true},
+        {"replies", static_cast<qint64>(replies)},
+        {"lost", static_cast<qint64>(lost)},
+        {"bias", (sum/static_cast<double>(replies))-scenario.delay},
+        {"p99Error", percentile(errors, ErrorPercentile)},
+        {"maximumError", errors.back()},
+        {"medianRoundTrip", percentile(roundTripTimes, 50)},
+        {"loss", loss},
+        {"lossError", loss-scenario.loss},
+        {"throughput", total/elapsed}
+    };
+}
+
+int main(int argc, char *argv[]) {
+    QApplication application(argc, argv);
+
+    spdlog::set_level(spdlog::level::info);
+
+    QCommandLineParser commandLineParser;
+
+    commandLineParser.setApplicationDescription(
+            "Runs the ping engines against a peer in a network namespace with delay, jitter and loss added by "
+            "netem, and compares the round trip times and loss that they report with the conditions applied." );
+
+    commandLineParser.addHelpOption();
+
+    commandLineParser.addOptions({
+        {"engines", "The class names of the engine factories to measure, separated by commas.", "names",
+                DefaultEngines},
+        {"duration", "The time to run each engine under each scenario in seconds.", "seconds",
+                QString::number(DefaultDuration)},
+        {"interval", "The interval between probes in milliseconds.", "milliseconds", QString::number(DefaultInterval)},
+        {"bias-tolerance", "The allowed mean error of the round trip times in milliseconds.", "milliseconds",
+                QString::number(DefaultBiasTolerance)},
+        {"error-tolerance", "The allowed 99th percentile error of the round trip times in milliseconds.",
+                "milliseconds", QString::number(DefaultErrorTolerance)},
+        {"loss-tolerance", "The allowed difference from the configured loss in percent.", "percent",
+                QString::number(DefaultLossTolerance)},
+        {"output", "The file to write the results to, the console is used if not given.", "filename"}
+    });
+
+    commandLineParser.process(application);
+
+    auto engineNames = commandLineParser.value("engines").split(",");
+    auto duration = std::max(commandLineParser.value("duration").toInt(), 1);
+    auto interval = std::max(commandLineParser.value("interval").toInt(), 1);
+    auto biasTolerance = std::max(commandLineParser.value("bias-tolerance").toDouble(), 0.0);
+    auto errorTolerance = std::max(commandLineParser.value("error-tolerance").toDouble(), 0.0);
+    auto lossTolerance = std::max(commandLineParser.value("loss-tolerance").toDouble(), 0.0);
+
+    auto results = QJsonObject{
+        {"duration", duration},
+        {"interval", interval}
+    };
+
+    auto failures = QStringList();
+
+    // creating namespaces and changing queueing disciplines needs root, without it the run is skipped.
+
+    if (geteuid()!=0) {
+        SPDLOG_WARN("The accuracy test must be run as root to create the network namespace, skipping.");
+
+        results.insert("skipped", true);
+    } else if (!setUpNetwork()) {
+        tearDownNetwork();
+
+        failures.append("Unable to create the network namespace, ip, tc and sysctl are required.");
+    } else {
+        Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+        componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+        componentLoader.loadComponents();
+
+        applyScenario(nullptr);
+
+        auto baseline = baselineRoundTrip();
+
+        results.insert("baseline", baseline);
+
+        QJsonArray engineArray;
+
+        auto factories = Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>();
+
+        for (auto &engineName : engineNames) {
+            if (engineName.isEmpty()) {
+                continue;
+            }
+
+            auto factory = static_cast<Nedrysoft::RouteAnalyser::IPingEngineFactory *>(nullptr);
+
+            for (auto engineFactory : factories) {
+                if (QString::fromLatin1(engineFactory->metaObject()->className())==engineName) {
+                    factory = engineFactory;
+                }
+            }
+
+            if ((!factory) || (!factory->available())) {
+                SPDLOG_WARN(QString("%1 is not available, skipping.").arg(engineName).toStdString());
+
+                engineArray.append(QJsonObject{{"engine", engineName}, {"available", false}});
+
+                continue;
+            }
+
+            QJsonArray scenarioArray;
+
+            for (auto &scenario : Scenarios) {
+                if (!applyScenario(&scenario)) {
+                    failures.append(QString("Unable to apply the %1 scenario with tc netem.").arg(scenario.name));
+
+                    break;
+                }
+
+                auto result = measure(factory, scenario, duration, interval, baseline);
+
+                result.insert("scenario", scenario.name);
+                result.insert("delay", scenario.delay);
+                result.insert("jitter", scenario.jitter);
+                result.insert("configuredLoss", scenario.loss);
+
+                scenarioArray.append(result);
+
+                if (!result.value("working").toBool()) {
+                    failures.append(QString("%1 received no replies in the %2 scenario.")
+                            .arg(engineName)
+                            .arg(scenario.name));
+
+                    continue;
+                }
+
+                auto bias = result.value("bias").toDouble();
+                auto error = result.value("p99Error").toDouble();
+                auto lossError = result.value("lossError").toDouble();
+
+                SPDLOG_INFO(QString("%1, %2: bias %3 ms, p99 error %4 ms, loss error %5%, %6 requests/s")
+                        .arg(engineName)
+                        .arg(scenario.name)
+                        .arg(bias, 0, 'f', 3)
+                        .arg(error, 0, 'f', 3)
+                        .arg(lossError, 0, 'f', 1)
+                        .arg(result.value("throughput").toDouble(), 0, 'f', 1).toStdString());
+
+                if (std::fabs(bias)>biasTolerance) {
+                    failures.append(QString("%1 had a bias of %2 ms in the %3 scenario (allowed %4 ms).")
+                            .arg(engineName)
+                            .arg(bias, 0, 'f', 3)
+                            .arg(scenario.name)
+                            .arg(biasTolerance, 0, 'f', 3));
+                }
+
+                if (error>errorTolerance) {
+                    failures.append(QString("%1 had a p99 error of %2 ms in the %3 scenario (allowed %4 ms).")
+                            .arg(engineName)
+                            .arg(error, 0, 'f', 3)
+                            .arg(scenario.name)
+                            .arg(errorTolerance, 0, 'f', 3));
+                }
+
+                if (std::fabs(lossError)>lossTolerance) {
+                    failures.append(QString("%1 reported %2% loss in the %3 scenario, %4% was configured.")
+                            .arg(engineName)
+                            .arg(result.value("loss").toDouble(), 0, 'f', 1)
+                            .arg(scenario.name)
+                            .arg(scenario.loss, 0, 'f', 1));
+                }
+            }
+
+            engineArray.append(QJsonObject{
+                {"engine", engineName},
+                {"available", true},
+                {"scenarios", scenarioArray}
+            });
+        }
+
+        applyScenario(nullptr);
+
+        tearDownNetwork();
+
+        results.insert("engines", engineArray);
+    }
+
+    results.insert("passed", failures.isEmpty());
+    results.insert("failures", QJsonArray::fromStringList(failures));
+
+    auto json = QJsonDocument(results).toJson();
+
+    if (commandLineParser.isSet("output")) {
+        QFile outputFile(commandLineParser.value("output"));
+
+        if (!outputFile.open(QFile::WriteOnly)) {
+            SPDLOG_ERROR(QString("Unable to write results to %1.").arg(outputFile.fileName()).toStdString());
+
+            return 1;
+        }
+
+        outputFile.write(json);
+    } else {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    for (auto &failure : failures) {
+        SPDLOG_ERROR(failure.toStdString());
+    }
+
+    return failures.isEmpty() ? 0 : 1;
+}
+
+#else
+
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    std::fputs("The accuracy test uses network namespaces and netem, which are only available on Linux.\n", stderr);
+
+    return 0;
+}
+
+#endif // defined(Q_OS_LINUX)
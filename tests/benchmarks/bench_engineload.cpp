@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+
+#if defined(Q_OS_UNIX)
+
+#include "catch.hpp"
+#include "PingData.h"
+#include "SimulatedNetwork.h"
+
+#include <ComponentLoader>
+#include <IComponentManager>
+#include <IPingEngine.h>
+#include <IPingEngineFactory.h>
+#include <IPingTarget.h>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <memory>
+#include <time.h>
+#include <vector>
+
+constexpr auto EngineFactoryClassName = "Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory";
+constexpr auto DurationEnvironmentVariable = "PINGNOO_ENGINE_LOAD_DURATION";
+constexpr auto ResultsEnvironmentVariable = "PINGNOO_ENGINE_LOAD_RESULTS";
+constexpr auto DefaultDuration = 5000;
+constexpr auto PingInterval = 1000;
+constexpr auto PingTimeout = 1000;
+constexpr auto DrainTime = 2*PingTimeout;
+constexpr auto NanosecondsInSecond = 1000000000.0;
+constexpr auto MicrosecondsInSecond = 1000000.0;
+
+/**
+ * @brief       A load scenario, a number of destinations each traced over the simulated network.
+ */
+struct EngineLoadScenario {
+    const char *name;
+    int destinations;
+    SimulatedNetwork::Configuration network;
+};
+
+/**
+ * @brief       Returns the CPU time used by the process.
+ *
+ * @returns     the time in seconds.
+ */
+static auto processTime() -> double {
+    struct timespec time = {};
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+
+    return static_cast<double>(time.tv_sec) + (static_cast<double>(time.tv_nsec) / NanosecondsInSecond);
+}
+
+/**
+ * @brief       Returns the address of a simulated destination.
+ *
+ * @param[in]   index the destination number.
+ *
+ * @returns     the address, which is outside the range used for the simulated routers.
+ */
+static auto destinationAddress(int index) -> QHostAddress {
+    return QHostAddress(static_cast<quint32>((10u << 24) | static_cast<quint32>(index+1)));
+}
+
+/**
+ * @brief       Runs the processing of the main thread for a time.
+ *
+ * @param[in]   milliseconds the time to run for.
+ */
+static auto runEventLoop(int milliseconds) -> void {
+    QEventLoop eventLoop;
+
+    QTimer::singleShot(milliseconds, &eventLoop, &QEventLoop::quit);
+
+    eventLoop.exec();
+}
+
+/**
+ * @brief       Returns the real ICMP ping engine factory, loading the components if required.
+ *
+ * @param[in]   componentLoader the loader to use if the components have not been loaded.
+ *
+ * @returns     the factory if found; otherwise nullptr.
+ */
+static auto engineFactory(
+        Nedrysoft::ComponentSystem::ComponentLoader &componentLoader) -> Nedrysoft::RouteAnalyser::IPingEngineFactory * {
+
+    for (auto pass=0;pass<2;pass++) {
+        for (auto factory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+            if (QString::fromLatin1(factory->metaObject()->className())==EngineFactoryClassName) {
+                return factory;
+            }
+        }
+
+        componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+        componentLoader.loadComponents();
+    }
+
+    return nullptr;
+}
+
+TEST_CASE("Engine Load Benchmarks", "[!benchmark][components][engine]") {
+    /**
+     * the engine is the real ICMP engine running on simulated sockets, so the scheduler, transmitter, request
+     * table and receiver are all exercised and every result is folded into the hop statistics on the main thread
+     * as the route table would.  The delivery thread of the simulated network stands in for the kernel, its
+     * CPU time is taken away from that of the process so what remains is the cost of the engine and statistics.
+     */
+
+    REQUIRE_MESSAGE(
+        Nedrysoft::ICMPSocket::ICMPSocket::simulator()==SimulatedNetwork::getInstance(),
+        "The simulated network must be installed before any socket is created." );
+
+    Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+    auto factory = engineFactory(componentLoader);
+
+    REQUIRE_MESSAGE(factory!=nullptr, "Unable to find Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory");
+
+    auto duration = qEnvironmentVariableIntValue(DurationEnvironmentVariable);
+
+    if (duration<=0) {
+        duration = DefaultDuration;
+    }
+
+    auto impaired = SimulatedNetwork::Configuration();
+
+    impaired.distribution = SimulatedNetwork::LatencyDistribution::Exponential;
+    impaired.lossProbability = 0.02;
+    impaired.rateLimit = 100;
+    impaired.reorderProbability = 0.05;
+
+    auto scenarios = std::vector<EngineLoadScenario>{
+        {"clean", 10, SimulatedNetwork::Configuration()},
+        {"clean", 100, SimulatedNetwork::Configuration()},
+        {"clean", 500, SimulatedNetwork::Configuration()},
+        {"clean", 1000, SimulatedNetwork::Configuration()},
+        {"impaired", 1000, impaired}
+    };
+
+    QJsonArray results;
+
+    for (auto &scenario : scenarios) {
+        auto network = SimulatedNetwork::getInstance();
+        auto hopCount = scenario.network.hopCount;
+        auto targetCount = scenario.destinations*hopCount;
+
+        network->setConfiguration(scenario.network);
+
+        auto engine = factory->createEngine(Nedrysoft::Core::IPVersion::V4);
+
+        engine->setInterval(PingInterval);
+        engine->setTimeout(PingTimeout);
+        engine->setResultBatching(true);
+
+        std::vector<std::unique_ptr<Nedrysoft::RouteAnalyser::PingData> > hops;
+        quint64 resultCount = 0;
+
+        for (auto destination=0;destination<scenario.destinations;destination++) {
+            for (auto hop=1;hop<=hopCount;hop++) {
+                auto target = engine->addTarget(destinationAddress(destination), hop);
+
+                hops.push_back(std::make_unique<Nedrysoft::RouteAnalyser::PingData>(nullptr, hop, true));
+
+                target->setUserData(hops.back().get());
+            }
+        }
+
+        QObject context;
+
+        QObject::connect(
+            engine,
+            &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+            &context,
+            [&resultCount](QVector<Nedrysoft::RouteAnalyser::PingResult> pingResults) {
+
+                for (auto &pingResult : pingResults) {
+                    auto pingData = static_cast<Nedrysoft::RouteAnalyser::PingData *>(pingResult.target()->userData());
+
+                    pingData->updateItem(pingResult);
+                }
+
+                resultCount += static_cast<quint64>(pingResults.count());
+            } );
+
+        auto startProcessTime = processTime();
+        auto startDeliveryTime = network->deliveryTime();
+
+        QElapsedTimer wallClock;
+
+        wallClock.start();
+
+        engine->start();
+
+        runEventLoop(duration);
+
+        engine->stop();
+
+        auto wallTime = static_cast<double>(wallClock.nsecsElapsed())/NanosecondsInSecond;
+        auto engineTime = (processTime()-startProcessTime)-(network->deliveryTime()-startDeliveryTime);
+
+        // outstanding requests are left to time out so that the counters balance.
+
+        runEventLoop(DrainTime);
+
+        auto statistics = engine->statistics();
+        auto counters = network->counters();
+
+        factory->deleteEngine(engine);
+
+        auto packetsSent = qMax<quint64>(statistics.packetsSent, 1);
+        auto coresUsed = engineTime/wallTime;
+
+        auto result = QJsonObject{
+            {"scenario", scenario.name},
+            {"destinations", scenario.destinations},
+            {"targets", targetCount},
+            {"seconds", wallTime},
+            {"packetsSent", static_cast<qint64>(statistics.packetsSent)},
+            {"packetsReceived", static_cast<qint64>(statistics.packetsReceived)},
+            {"timedOut", static_cast<qint64>(statistics.timedOut)},
+            {"results", static_cast<qint64>(resultCount)},
+            {"networkLost", static_cast<qint64>(counters.lost)},
+            {"networkRateLimited", static_cast<qint64>(counters.rateLimited)},
+            {"networkReordered", static_cast<qint64>(counters.reordered)},
+            {"cpuSeconds", engineTime},
+            {"cpuMicrosecondsPerProbe", (engineTime*MicrosecondsInSecond)/static_cast<double>(packetsSent)},
+            {"targetsPerCore", (coresUsed>0) ? static_cast<double>(targetCount)/coresUsed : 0.0},
+            {"schedulingLagMaximum", statistics.schedulingLagMaximum}
+        };
+
+        results.append(result);
+
+        WARN(QJsonDocument(result).toJson(QJsonDocument::Compact).toStdString());
+
+        REQUIRE_MESSAGE(statistics.packetsSent>0, "No requests were sent to the simulated network.");
+        REQUIRE_MESSAGE(statistics.packetsReceived>0, "No replies were received from the simulated network.");
+    }
+
+    auto resultsFilename = qEnvironmentVariable(ResultsEnvironmentVariable);
+
+    if (!resultsFilename.isEmpty()) {
+        QFile resultsFile(resultsFilename);
+
+        if (resultsFile.open(QFile::WriteOnly)) {
+            resultsFile.write(QJsonDocument(results).toJson());
+        }
+    }
+}
+
+#endif // defined(Q_OS_UNIX)
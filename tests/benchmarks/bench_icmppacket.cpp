@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "ICMPPacket/ICMPPacket.h"
+
+#include <QHostAddress>
+
+constexpr auto BenchmarkId = 0x1234;
+constexpr auto BenchmarkSequence = 1;
+constexpr auto BenchmarkPayloadLength = 52;
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv4TTL = 64;
+constexpr auto ICMPEchoReply = 0;
+
+TEST_CASE("ICMPPacket Benchmarks", "[!benchmark][libs][network]") {
+    auto requestPacket = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+        BenchmarkId,
+        BenchmarkSequence,
+        BenchmarkPayloadLength,
+        QHostAddress(),
+        Nedrysoft::ICMPPacket::V4
+    );
+
+    /**
+     * a raw socket delivers the ip header in front of the reply, so the reply is built from the request with
+     * a minimal ipv4 header prepended and the type changed to echo reply.
+     */
+
+    auto replyPacket = QByteArray(IPv4HeaderLength, 0);
+
+    replyPacket[0] = 0x45;
+    replyPacket[8] = static_cast<char>(IPv4TTL);
+    replyPacket.append(requestPacket);
+    replyPacket[IPv4HeaderLength] = static_cast<char>(ICMPEchoReply);
+
+    REQUIRE_MESSAGE(
+        Nedrysoft::ICMPPacket::ICMPPacket::fromData(replyPacket, Nedrysoft::ICMPPacket::V4).resultCode()==
+                Nedrysoft::ICMPPacket::EchoReply,
+        "The benchmark reply packet did not decode as an echo reply." );
+
+    BENCHMARK("pingPacket") {
+        return Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            BenchmarkId,
+            BenchmarkSequence,
+            BenchmarkPayloadLength,
+            QHostAddress(),
+            Nedrysoft::ICMPPacket::V4
+        );
+    };
+
+    BENCHMARK("fromData") {
+        return Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+            reinterpret_cast<const uint8_t *>(replyPacket.constData()),
+            replyPacket.length(),
+            Nedrysoft::ICMPPacket::V4
+        );
+    };
+
+    BENCHMARK("checksum") {
+        return Nedrysoft::ICMPPacket::ICMPPacket::checksum(requestPacket.data(), requestPacket.length());
+    };
+}
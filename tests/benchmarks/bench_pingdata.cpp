@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "PingData.h"
+#include "PingResult.h"
+
+#include <QHostAddress>
+
+constexpr auto BenchmarkHop = 5;
+constexpr auto BenchmarkRequestTime = 1600000000000000000ll;
+constexpr auto BenchmarkRoundTripTime = 12000000ll;
+constexpr auto BenchmarkJitter = 250000ll;
+constexpr auto NanosecondsInSecond = 1000000000ll;
+
+TEST_CASE("PingData Benchmarks", "[!benchmark][components][routeanalyser]") {
+    /**
+     * without a table model or plots this measures the statistics update that every result goes through before
+     * anything is drawn.
+     */
+
+    Nedrysoft::RouteAnalyser::PingData pingData(nullptr, BenchmarkHop, true);
+    auto hostAddress = QHostAddress("192.168.1.1");
+    unsigned long sampleNumber = 0;
+
+    BENCHMARK("updateItem reply") {
+        sampleNumber++;
+
+        pingData.updateItem(Nedrysoft::RouteAnalyser::PingResult(
+            sampleNumber,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
+            hostAddress,
+            BenchmarkRequestTime+static_cast<qint64>(sampleNumber)*NanosecondsInSecond,
+            BenchmarkRoundTripTime+((sampleNumber & 1) ? BenchmarkJitter : -BenchmarkJitter),
+            nullptr,
+            BenchmarkHop ));
+    };
+
+    BENCHMARK("updateItem timeout") {
+        sampleNumber++;
+
+        pingData.updateItem(Nedrysoft::RouteAnalyser::PingResult(
+            sampleNumber,
+            Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+            QHostAddress(),
+            BenchmarkRequestTime+static_cast<qint64>(sampleNumber)*NanosecondsInSecond,
+            -1,
+            nullptr,
+            BenchmarkHop ));
+    };
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <ComponentLoader>
+#include <IComponentManager>
+#include <IHostMasker.h>
+#include <QFile>
+#include <QJsonDocument>
+
+static auto resourceContent(const QString &filename) -> QByteArray {
+    QFile file(filename);
+
+    if (file.open(QFile::ReadOnly)) {
+        return file.readAll();
+    }
+
+    return QByteArray();
+}
+
+TEST_CASE("RegExHostMasker Benchmarks", "[!benchmark][components][network]") {
+    Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+    componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+    componentLoader.loadComponents();
+
+    Nedrysoft::Core::IHostMasker *regExHostMasker = nullptr;
+
+    for (auto hostMasker : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::Core::IHostMasker>()) {
+        if (QString::fromLatin1(hostMasker->metaObject()->className())=="Nedrysoft::RegExHostMasker::RegExHostMasker") {
+            regExHostMasker = hostMasker;
+            break;
+        }
+    }
+
+    REQUIRE_MESSAGE(regExHostMasker!=nullptr, "Unable to find Nedrysoft::RegExHostMasker::RegExHostMasker");
+
+    regExHostMasker->loadConfiguration(
+        QJsonDocument::fromJson(resourceContent(":/test_regexhostmasker_host.json")).object() );
+
+    QString maskedHostName, maskedHostAddress;
+
+    /**
+     * mask() is a thin wrapper around applyMask(), a matching and a non matching host are measured as a miss
+     * has to try every expression in the list.
+     */
+
+    BENCHMARK("applyMask match") {
+        return regExHostMasker->mask(
+            0,
+            "1.123-123-123.static.test.co.uk",
+            "1.123.123.123",
+            maskedHostName,
+            maskedHostAddress );
+    };
+
+    BENCHMARK("applyMask no match") {
+        return regExHostMasker->mask(
+            0,
+            "1.123-123-123.static.test2.co.uk",
+            "1.123.123.123",
+            maskedHostName,
+            maskedHostAddress );
+    };
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "ICMPPingItem.h"
+#include "ICMPPingItemPool.h"
+#include "ICMPPingRequestTable.h"
+
+#include <limits>
+
+constexpr auto BenchmarkId = 0x1234;
+constexpr auto ExpiryBatchSize = 1024;
+
+TEST_CASE("ICMPPingRequestTable Benchmarks", "[!benchmark][components][network]") {
+    Nedrysoft::ICMPPingEngine::ICMPPingItemPool pool;
+    Nedrysoft::ICMPPingEngine::ICMPPingRequestTable requestTable(&pool);
+    uint16_t sequence = 0;
+
+    auto insertRequest = [&]() {
+        auto pingItem = pool.acquire();
+
+        pingItem->setId(BenchmarkId);
+        pingItem->setSequenceId(sequence++);
+        pingItem->startTimer();
+
+        requestTable.insert(pingItem, pingItem->transmitTimestamp());
+    };
+
+    BENCHMARK("insert and take") {
+        auto requestSequence = sequence;
+
+        insertRequest();
+
+        auto pingItem = requestTable.take(BenchmarkId, requestSequence);
+
+        pool.release(pingItem);
+
+        return pingItem;
+    };
+
+    BENCHMARK("take unknown request") {
+        return requestTable.take(BenchmarkId+1, sequence);
+    };
+
+    BENCHMARK("insert and expire batch") {
+        for (auto request=0;request<ExpiryBatchSize;request++) {
+            insertRequest();
+        }
+
+        auto expiredList = requestTable.takeExpired(std::numeric_limits<qint64>::max(), 0);
+
+        for (auto pingItem : expiredList) {
+            pool.release(pingItem);
+        }
+
+        return expiredList.count();
+    };
+
+    for (auto request=0;request<ExpiryBatchSize;request++) {
+        insertRequest();
+    }
+
+    BENCHMARK("expiry sweep with nothing expired") {
+        return requestTable.takeExpired(0, 0).count();
+    };
+
+    requestTable.clear();
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define CATCH_CONFIG_RUNNER
+
+#include "catch.hpp"
+#include "SimulatedNetwork.h"
+
+#include <QApplication>
+#include <spdlog/spdlog.h>
+
+int main(int argc, char *argv[]) {
+    QApplication a(argc, argv);
+
+    spdlog::set_level(spdlog::level::warn);
+
+    Catch::Session session;
+
+    auto result = session.applyCommandLine(argc, argv);
+
+    if (result!=0) {
+        return result;
+    }
+
+    /**
+     * the results are written as xml unless another reporter was asked for, so that a CI job can compare them
+     * against a previous run without scraping the console output.
+     */
+
+    auto reporterGiven = false;
+
+    for (auto argument=1;argument<argc;argument++) {
+        auto option = std::string(argv[argument]);
+
+        if ((option=="-r") || (option.rfind("--reporter", 0)==0)) {
+            reporterGiven = true;
+        }
+    }
+
+    if (!reporterGiven) {
+        session.configData().reporterName = "xml";
+    }
+
+#if defined(Q_OS_UNIX)
+    /**
+     * the engine creates its sockets when the first engine is created, the simulated network must be installed
+     * before then or the engine would open real sockets and ping the addresses used by the load scenarios.
+     */
+
+    Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(SimulatedNetwork::getInstance());
+#endif
+
+    result = session.run();
+
+    return ( result < 0xff ? result : 0xff );
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<quint64> allocationCount(0);
+    std::atomic<quint64> allocationBytes(0);
+
+    auto count(size_t size) -> void {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+auto AllocationCounter::counters() -> AllocationCounter::Counters {
+    Counters counters;
+
+    counters.allocations = allocationCount.load(std::memory_order_relaxed);
+    counters.bytes = allocationBytes.load(std::memory_order_relaxed);
+
+    return counters;
+}
+
+#if defined(__GLIBC__)
+
+/**
+ * glibc exports its allocator under a second name, the replacements forward to it rather than looking up the next
+ * definition with dlsym, which itself allocates.  operator new is implemented with malloc so it is counted as well.
+ */
+
+extern "C" {
+    extern void *__libc_malloc(size_t size);
+    extern void *__libc_calloc(size_t count, size_t size);
+    extern void *__libc_realloc(void *pointer, size_t size);
+
+    void *malloc(size_t size) {
+        count(size);
+
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t elements, size_t size) {
+        count(elements*size);
+
+        return __libc_calloc(elements, size);
+    }
+
+    void *realloc(void *pointer, size_t size) {
+        count(size);
+
+        return __libc_realloc(pointer, size);
+    }
+}
+
+auto AllocationCounter::countsMalloc() -> bool {
+    return true;
+}
+
+#else
+
+auto operator new(size_t size) -> void * {
+    count(size);
+
+    auto pointer = std::malloc(size ? size : 1);
+
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+auto operator new[](size_t size) -> void * {
+    return operator new(size);
+}
+
+auto operator new(size_t size, const std::nothrow_t &) noexcept -> void * {
+    count(size);
+
+    return std::malloc(size ? size : 1);
+}
+
+auto operator new[](size_t size, const std::nothrow_t &nothrow) noexcept -> void * {
+    return operator new(size, nothrow);
+}
+
+auto operator delete(void *pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete[](void *pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete(void *pointer, size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete[](void *pointer, size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+auto AllocationCounter::countsMalloc() -> bool {
+    return false;
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * @brief       The AllocationCounter class counts the heap allocations made by the process.
+ *
+ * @details     With glibc the malloc family is replaced, so allocations made by Qt containers and by every shared
+ *              library are counted.  On other platforms only the global operator new is replaced, allocations
+ *              that Qt makes with malloc directly are not counted there and figures are only comparable between
+ *              runs on the same platform.
+ */
+class AllocationCounter {
+    public:
+        /**
+         * @brief       A snapshot of the counters.
+         */
+        struct Counters {
+            quint64 allocations = 0;            //!< the number of allocations made.
+            quint64 bytes = 0;                  //!< the number of bytes requested.
+        };
+
+        /**
+         * @brief       Returns the allocations made by all threads since the process started.
+         *
+         * @returns     the counters.
+         */
+        static auto counters() -> Counters;
+
+        /**
+         * @brief       Returns whether allocations made with malloc are counted.
+         *
+         * @returns     true if the malloc family is replaced; otherwise false.
+         */
+        static auto countsMalloc() -> bool;
+};
+
+#endif // ALLOCATIONCOUNTER_H
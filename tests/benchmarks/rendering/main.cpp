@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AllocationCounter.h"
+#include "RouteAnalyserWidget.h"
+#include "SessionCapture.h"
+#include "TrimmerWidget.h"
+
+#include <ComponentLoader>
+#include <Diagnostics>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <spdlog/spdlog.h>
+
+constexpr auto DefaultHops = 30;
+constexpr auto DefaultSamples = 3600;
+constexpr auto DefaultFrames = 200;
+constexpr auto PingInterval = 1000;
+constexpr auto HopLatency = 0.002;
+constexpr auto LatencyDeviation = 0.0005;
+constexpr auto LossProbability = 0.01;
+constexpr auto WidgetWidth = 1280;
+constexpr auto WidgetHeight = 960;
+constexpr auto ResizedWidth = 1024;
+constexpr auto ResizedHeight = 768;
+constexpr auto TrimmerHeight = 48;
+constexpr auto SettleQuietTime = 250;
+constexpr auto SettleTimeout = 30000;
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMillisecond = 1000000.0;
+
+/**
+ * @brief       The measurements taken for each frame of a scenario.
+ */
+struct FrameSample {
+    double time;                                //!< the time taken in milliseconds.
+    quint64 allocations;                        //!< the number of allocations made.
+    quint64 bytes;                              //!< the number of bytes allocated.
+};
+
+/**
+ * @brief       Writes a session capture holding synthetic results for a route.
+ *
+ * @details     Every hop replies to every sample after a latency that grows with the hop number, a small fraction
+ *              of the samples are lost so that the plots and table have gaps to draw.
+ *
+ * @param[in]   filename the name of the capture to create.
+ * @param[in]   hops the number of hops in the route, including the target.
+ * @param[in]   samples the number of samples of each hop.
+ *
+ * @returns     true if the capture was written; otherwise false.
+ */
+static auto writeCapture(const QString &filename, int hops, int samples) -> bool {
+    auto route = Nedrysoft::RouteAnalyser::RouteList();
+
+    for (auto hop=1;hop<hops;hop++) {
+        route.append(QHostAddress(QString("10.255.%1.1").arg(hop)));
+    }
+
+    auto target = QHostAddress("10.0.0.1");
+
+    route.append(target);
+
+    Nedrysoft::RouteAnalyser::CaptureWriter captureWriter;
+
+    if (!captureWriter.open(filename, target.toString(), Nedrysoft::Core::IPVersion::V4, PingInterval, target, route)) {
+        return false;
+    }
+
+    std::mt19937 generator(1);
+    std::normal_distribution<double> latency(0, LatencyDeviation);
+    std::bernoulli_distribution loss(LossProbability);
+
+    auto intervalTime = static_cast<qint64>(PingInterval)*(NanosecondsInSecond/1000);
+    auto startTime = (QDateTime::currentMSecsSinceEpoch()*(NanosecondsInSecond/1000))-(samples*intervalTime);
+
+    for (auto sample=0;sample<samples;sample++) {
+        auto requestTime = startTime+(sample*intervalTime);
+
+        for (auto hop=1;hop<=hops;hop++) {
+            auto code = (hop==hops) ?
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok :
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode::TimeExceeded;
+
+            auto roundTripTime = qint64(-1);
+
+            if (loss(generator)) {
+                code = Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply;
+            } else {
+                auto seconds = std::max((hop*HopLatency)+latency(generator), 0.0);
+
+                roundTripTime = static_cast<qint64>(seconds*NanosecondsInSecond);
+            }
+
+            captureWriter.append(hop, Nedrysoft::RouteAnalyser::PingResult(
+                static_cast<unsigned long>(sample),
+                code,
+                route.at(hop-1),
+                requestTime,
+                roundTripTime,
+                nullptr,
+                hop
+            ));
+        }
+    }
+
+    captureWriter.close();
+
+    return true;
+}
+
+/**
+ * @brief       Runs the event loop until the widget has stopped updating its data set.
+ *
+ * @param[in]   routeAnalyserWidget the widget to wait for.
+ */
+static auto settle(Nedrysoft::RouteAnalyser::RouteAnalyserWidget *routeAnalyserWidget) -> void {
+    QElapsedTimer totalTime, quietTime;
+
+    totalTime.start();
+    quietTime.start();
+
+    auto connection = QObject::connect(
+        routeAnalyserWidget,
+        &Nedrysoft::RouteAnalyser::RouteAnalyserWidget::datasetChanged,
+        [&quietTime](double, double) {
+            quietTime.restart();
+        } );
+
+    while ((quietTime.elapsed()<SettleQuietTime) && (totalTime.elapsed()<SettleTimeout)) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, SettleQuietTime/10);
+    }
+
+    QObject::disconnect(connection);
+}
+
+/**
+ * @brief       Returns the value at a percentile of a sorted list of values.
+ *
+ * @param[in]   values the sorted values.
+ * @param[in]   percentile the percentile (0 to 100).
+ *
+ * @returns     the value.
+ */
+static auto percentile(const std::vector<double> &values, double percentile) -> double {
+    if (values.empty()) {
+        return 0;
+    }
+
+    auto index = static_cast<size_t>((percentile/100.0)*static_cast<double>(values.size()-1));
+
+    return values.at(index);
+}
+
+/**
+ * @brief       Measures a number of frames of a scenario.
+ *
+ * @details     Each frame performs the action, processes the events it caused (queued replots, layout changes) and
+ *              then repaints the widget, so the time is that of a frame the user would see.  The diagnostics probes
+ *              are reset first so that the paint times of the individual layers are reported per scenario.
+ *
+ * @param[in]   name the name of the scenario.
+ * @param[in]   widget the widget to repaint.
+ * @param[in]   frames the number of frames to measure.
+ * @param[in]   action the function to call at the start of each frame with the frame number.
+ *
+ * @returns     the results of the scenario.
+ */
+static auto measure(
+        const QString &name,
+        QWidget *widget,
+        int frames,
+        const std::function<void(int)> &action) -> QJsonObject {
+
+    auto diagnostics = Nedrysoft::Core::Diagnostics::getInstance();
+    auto samples = std::vector<FrameSample>();
+
+    // one unmeasured frame so that the buffers and caches the scenario needs are already in place.
+
+    action(0);
+
+    QCoreApplication::processEvents();
+
+    widget->repaint();
+
+    diagnostics->reset();
+
+    for (auto frame=1;frame<=frames;frame++) {
+        auto startAllocations = AllocationCounter::counters();
+
+        QElapsedTimer frameTime;
+
+        frameTime.start();
+
+        action(frame);
+
+        QCoreApplication::processEvents();
+
+        widget->repaint();
+
+        auto time = static_cast<double>(frameTime.nsecsElapsed())/NanosecondsInMillisecond;
+        auto endAllocations = AllocationCounter::counters();
+
+        samples.push_back(FrameSample{
+            time,
+            endAllocations.allocations-startAllocations.allocations,
+            endAllocations.bytes-startAllocations.bytes
+        });
+    }
+
+    auto times = std::vector<double>();
+    auto totalTime = 0.0;
+    auto totalAllocations = quint64(0);
+    auto totalBytes = quint64(0);
+
+    for (auto &sample : samples) {
+        times.push_back(sample.time);
+
+        totalTime += sample.time;
+        totalAllocations += sample.allocations;
+        totalBytes += sample.bytes;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    auto frameCount = static_cast<double>(std::max<size_t>(samples.size(), 1));
+
+    QJsonObject probes;
+
+    auto histograms = diagnostics->histograms();
+
+    for (auto it=histograms.constBegin();it!=histograms.constEnd();it++) {
+        auto &histogram = it.value();
+
+        probes[it.key()] = QJsonObject{
+            {"count", static_cast<qint64>(histogram.count)},
+            {"mean", histogram.count ? histogram.sum/static_cast<double>(histogram.count) : 0.0},
+            {"p95", histogram.percentile(95)},
+            {"maximum", histogram.maximum}
+        };
+    }
+
+    return QJsonObject{
+        {"name", name},
+        {"frames", static_cast<int>(samples.size())},
+        {"mean", totalTime/frameCount},
+        {"p50", percentile(times, 50)},
+        {"p95", percentile(times, 95)},
+        {"p99", percentile(times, 99)},
+        {"maximum", times.empty() ? 0.0 : times.back()},
+        {"allocationsPerFrame", static_cast<double>(totalAllocations)/frameCount},
+        {"bytesPerFrame", static_cast<double>(totalBytes)/frameCount},
+        {"probes", probes}
+    };
+}
+
+/**
+ * @brief       Returns the plots that are currently visible in the widget.
+ *
+ * @param[in]   widget the widget to search.
+ *
+ * @returns     the plot widgets.
+ */
+static auto visiblePlots(QWidget *widget) -> QList<QWidget *> {
+    auto plots = QList<QWidget *>();
+
+    for (auto child : widget->findChildren<QWidget *>()) {
+        if ((child->inherits("QCustomPlot")) && (child->isVisible()) && (!child->visibleRegion().isEmpty())) {
+            plots.append(child);
+        }
+    }
+
+    return plots;
+}
+
+int main(int argc, char *argv[]) {
+    /**
+     * the widgets are drawn to memory by the offscreen platform unless another platform was asked for, so the
+     * benchmark runs without a display and the figures do not depend on the compositor.
+     */
+
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication application(argc, argv);
+
+    spdlog::set_level(spdlog::level::warn);
+
+    QCommandLineParser commandLineParser;
+
+    commandLineParser.setApplicationDescription("Measures the frame times and allocations of the route analyser.");
+    commandLineParser.addHelpOption();
+
+    commandLineParser.addOptions({
+        {"hops", "The number of hops in the route.", "count", QString::number(DefaultHops)},
+        {"samples", "The number of samples of each hop.", "count", QString::number(DefaultSamples)},
+        {"frames", "The number of frames to measure in each scenario.", "count", QString::number(DefaultFrames)},
+        {"output", "The file to write the results to, the console is used if not given.", "filename"}
+    });
+
+    commandLineParser.process(application);
+
+    auto hops = std::max(commandLineParser.value("hops").toInt(), 1);
+    auto samples = std::max(commandLineParser.value("samples").toInt(), 1);
+    auto frames = std::max(commandLineParser.value("frames").toInt(), 1);
+
+    Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+    componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+    componentLoader.loadComponents();
+
+    QTemporaryDir temporaryDir;
+
+    auto captureFilename = temporaryDir.filePath("rendering.capture");
+
+    if ((!temporaryDir.isValid()) || (!writeCapture(captureFilename, hops, samples))) {
+        SPDLOG_ERROR("Unable to write the synthetic session capture.");
+
+        return 1;
+    }
+
+    /**
+     * the widget is populated from a capture rather than a ping engine, so the data is the same on every run and
+     * is in place before the first frame is measured.
+     */
+
+    auto routeAnalyserWidget = new Nedrysoft::RouteAnalyser::RouteAnalyserWidget(
+        QString(),
+        Nedrysoft::Core::IPVersion::V4,
+        PingInterval,
+        nullptr,
+        0,
+        false
+    );
+
+    routeAnalyserWidget->resize(WidgetWidth, WidgetHeight);
+    routeAnalyserWidget->show();
+
+    if (!routeAnalyserWidget->openCapture(captureFilename)) {
+        SPDLOG_ERROR("Unable to open the synthetic session capture.");
+
+        delete routeAnalyserWidget;
+
+        return 1;
+    }
+
+    routeAnalyserWidget->setViewportSize((static_cast<double>(samples)*PingInterval)/1000.0);
+    routeAnalyserWidget->setViewportPosition(1);
+
+    settle(routeAnalyserWidget);
+
+    Nedrysoft::Core::Diagnostics::getInstance()->setEnabled(true);
+
+    QJsonArray scenarios;
+
+    scenarios.append(measure("repaint", routeAnalyserWidget, frames, [](int) {}));
+
+    auto scrollArea = routeAnalyserWidget->findChild<QScrollArea *>();
+
+    if (scrollArea) {
+        auto scrollBar = scrollArea->verticalScrollBar();
+
+        scenarios.append(measure("scroll", routeAnalyserWidget, frames, [scrollBar](int frame) {
+            // the plots are scrolled down and back up again so that plots are bound and released along the way.
+
+            auto range = std::max(scrollBar->maximum(), 1);
+            auto step = std::max(scrollBar->pageStep()/4, 1);
+            auto position = (frame*step)%(2*range);
+
+            scrollBar->setValue((position<=range) ? position : (2*range)-position);
+        }));
+
+        scrollBar->setValue(0);
+
+        settle(routeAnalyserWidget);
+    }
+
+    scenarios.append(measure("resize", routeAnalyserWidget, frames, [routeAnalyserWidget](int frame) {
+        if (frame%2) {
+            routeAnalyserWidget->resize(ResizedWidth, ResizedHeight);
+        } else {
+            routeAnalyserWidget->resize(WidgetWidth, WidgetHeight);
+        }
+    }));
+
+    routeAnalyserWidget->resize(WidgetWidth, WidgetHeight);
+
+    settle(routeAnalyserWidget);
+
+    auto plots = visiblePlots(routeAnalyserWidget);
+
+    if (!plots.isEmpty()) {
+        auto plot = plots.first();
+        auto enterPosition = QPointF(plot->width()/2, plot->height()/2);
+
+        QEnterEvent enterEvent(enterPosition, enterPosition, plot->mapToGlobal(enterPosition.toPoint()));
+
+        QCoreApplication::sendEvent(plot, &enterEvent);
+
+        scenarios.append(measure("crosshair", routeAnalyserWidget, frames, [plot](int frame) {
+            auto position = QPointF((frame*7)%std::max(plot->width(), 1), plot->height()/2);
+
+            QMouseEvent mouseEvent(QEvent::MouseMove, position, Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+
+            QCoreApplication::sendEvent(plot, &mouseEvent);
+        }));
+
+        QEvent leaveEvent(QEvent::Leave);
+
+        QCoreApplication::sendEvent(plot, &leaveEvent);
+    } else {
+        SPDLOG_WARN("No plots are visible, the crosshair scenario was skipped.");
+    }
+
+    auto trimmerWidget = new Nedrysoft::RouteAnalyser::TrimmerWidget;
+
+    trimmerWidget->resize(WidgetWidth, TrimmerHeight);
+    trimmerWidget->show();
+
+    scenarios.append(measure("trimmer", trimmerWidget, frames, [trimmerWidget, frames](int frame) {
+        auto start = (static_cast<double>(frame%frames)/frames)*0.5;
+
+        trimmerWidget->setViewport(start, start+0.5);
+    }));
+
+    delete trimmerWidget;
+    delete routeAnalyserWidget;
+
+    auto results = QJsonObject{
+        {"hops", hops},
+        {"samples", samples},
+        {"platform", QGuiApplication::platformName()},
+        {"qtVersion", qVersion()},
+        {"mallocCounted", AllocationCounter::countsMalloc()},
+        {"scenarios", scenarios}
+    };
+
+    auto json = QJsonDocument(results).toJson();
+
+    if (commandLineParser.isSet("output")) {
+        QFile outputFile(commandLineParser.value("output"));
+
+        if (!outputFile.open(QFile::WriteOnly)) {
+            SPDLOG_ERROR(QString("Unable to write results to %1.").arg(outputFile.fileName()).toStdString());
+
+            return 1;
+        }
+
+        outputFile.write(json);
+    } else {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    return 0;
+}
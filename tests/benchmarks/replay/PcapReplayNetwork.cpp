@@ -0,0 +1,711 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PcapReplayNetwork.h"
+
+#if defined(Q_OS_UNIX)
+
+#include "ICMPPacket/ICMPPacket.h"
+
+#include <QFile>
+#include <QHostAddress>
+#include <QtEndian>
+#include <chrono>
+#include <cstring>
+
+constexpr auto NanosecondsInSecond = 1000000000ll;
+constexpr auto NanosecondsInMillisecond = 1000000ll;
+constexpr auto LateTolerance = NanosecondsInMillisecond;
+constexpr auto MaximumPendingRequests = 65536u;
+
+constexpr uint32_t PcapMagic = 0xa1b2c3d4;
+constexpr uint32_t PcapNanosecondMagic = 0xa1b23c4d;
+constexpr auto PcapHeaderLength = 24;
+constexpr auto PcapLinkTypeOffset = 20;
+constexpr uint32_t PcapLinkTypeMask = 0x0fffffff;
+constexpr auto PcapRecordHeaderLength = 16;
+
+constexpr uint32_t SectionHeaderBlock = 0x0a0d0d0a;
+constexpr uint32_t InterfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t EnhancedPacketBlock = 0x00000006;
+constexpr uint32_t ByteOrderMagic = 0x1a2b3c4d;
+constexpr auto BlockHeaderLength = 8;
+constexpr auto BlockTrailerLength = 4;
+constexpr auto InterfaceOptionsOffset = 8;
+constexpr auto EnhancedPacketDataOffset = 20;
+constexpr uint16_t OptionEnd = 0;
+constexpr uint16_t OptionTimestampResolution = 9;
+constexpr uint8_t MicrosecondResolution = 6;
+constexpr uint8_t NanosecondResolution = 9;
+constexpr uint8_t BinaryResolutionFlag = 0x80;
+
+constexpr auto LinkTypeNull = 0;
+constexpr auto LinkTypeEthernet = 1;
+constexpr auto LinkTypeRaw = 101;
+constexpr auto LinkTypeLinuxCooked = 113;
+constexpr auto LinkTypeIPv4 = 228;
+constexpr auto LinkTypeIPv6 = 229;
+constexpr auto LinkTypeLinuxCookedV2 = 276;
+constexpr auto NullHeaderLength = 4;
+constexpr auto EthernetHeaderLength = 14;
+constexpr auto EthernetTypeOffset = 12;
+constexpr auto VLANTagLength = 4;
+constexpr auto LinuxCookedHeaderLength = 16;
+constexpr auto LinuxCookedProtocolOffset = 14;
+constexpr auto LinuxCookedV2HeaderLength = 20;
+constexpr uint16_t EtherTypeIPv4 = 0x0800;
+constexpr uint16_t EtherTypeIPv6 = 0x86dd;
+constexpr uint16_t EtherTypeVLAN = 0x8100;
+constexpr uint16_t EtherTypeQinQ = 0x88a8;
+
+constexpr auto ICMPHeaderLength = 8;
+constexpr auto ICMPChecksumOffset = 2;
+constexpr auto ICMPIdentifierOffset = 4;
+constexpr auto ICMPSequenceOffset = 6;
+constexpr auto IPv4HeaderLength = 20;
+constexpr auto IPv4ProtocolOffset = 9;
+constexpr auto IPv4SourceOffset = 12;
+constexpr auto IPv6HeaderLength = 40;
+constexpr auto IPv6NextHeaderOffset = 6;
+constexpr auto IPv6SourceOffset = 8;
+constexpr auto ICMPProtocolV4 = 1;
+constexpr auto ICMPProtocolV6 = 58;
+
+constexpr auto ICMPEchoRequestV4 = 8;
+constexpr auto ICMPEchoReplyV4 = 0;
+constexpr auto ICMPDestinationUnreachableV4 = 3;
+constexpr auto ICMPTimeExceededV4 = 11;
+constexpr auto ICMPParameterProblemV4 = 12;
+constexpr auto ICMPEchoRequestV6 = 128;
+constexpr auto ICMPEchoReplyV6 = 129;
+constexpr auto ICMPDestinationUnreachableV6 = 1;
+constexpr auto ICMPParameterProblemV6 = 4;
+
+/**
+ * @brief       Reads a value from a capture in the byte order of the file.
+ *
+ * @param[in]   data the location of the value.
+ * @param[in]   swapped true if the file was written on a host of the other byte order; otherwise false.
+ *
+ * @returns     the value.
+ */
+template <typename T>
+static auto readValue(const char *data, bool swapped) -> T {
+    T value;
+
+    memcpy(&value, data, sizeof(value));
+
+    return swapped ? qbswap(value) : value;
+}
+
+/**
+ * @brief       Converts a pcapng timestamp to nanoseconds.
+ *
+ * @param[in]   value the timestamp in the units of the interface.
+ * @param[in]   resolution the if_tsresol option of the interface.
+ *
+ * @returns     the timestamp in nanoseconds.
+ */
+static auto toNanoseconds(uint64_t value, uint8_t resolution) -> qint64 {
+    if (resolution & BinaryResolutionFlag) {
+        auto shift = qMin(resolution & ~BinaryResolutionFlag, 63);
+        auto fraction = value & ((1ull << shift) - 1);
+
+        return static_cast<qint64>(((value >> shift) * NanosecondsInSecond) +
+                                   ((fraction * NanosecondsInSecond) >> shift));
+    }
+
+    auto scale = 1ull;
+
+    for (auto digit = qMin(resolution, NanosecondResolution); digit < NanosecondResolution; digit++) {
+        scale *= 10;
+    }
+
+    for (auto digit = NanosecondResolution; digit < resolution; digit++) {
+        value /= 10;
+    }
+
+    return static_cast<qint64>(value * scale);
+}
+
+/**
+ * @brief       Returns where the IP header starts in a captured frame.
+ *
+ * @param[in]   linkType the link type of the capture.
+ * @param[in]   data the frame.
+ * @param[in]   length the number of bytes captured.
+ *
+ * @returns     the offset of the IP header; or -1 if the frame does not carry IP.
+ */
+static auto networkOffset(uint32_t linkType, const uint8_t *data, int length) -> int {
+    auto etherType = [data, length](int offset) -> int {
+        return (offset + 2 <= length) ? qFromBigEndian<uint16_t>(data + offset) : -1;
+    };
+
+    auto offset = -1;
+    auto type = -1;
+
+    switch (linkType) {
+        case LinkTypeRaw:
+        case LinkTypeIPv4:
+        case LinkTypeIPv6: {
+            return 0;
+        }
+
+        // the family of a loopback frame is in the byte order of the capturing host, the IP header says the same.
+
+        case LinkTypeNull: {
+            return (length > NullHeaderLength) ? NullHeaderLength : -1;
+        }
+
+        case LinkTypeEthernet: {
+            offset = EthernetHeaderLength;
+            type = etherType(EthernetTypeOffset);
+
+            while ((type == EtherTypeVLAN) || (type == EtherTypeQinQ)) {
+                offset += VLANTagLength;
+                type = etherType(offset - 2);
+            }
+
+            break;
+        }
+
+        case LinkTypeLinuxCooked: {
+            offset = LinuxCookedHeaderLength;
+            type = etherType(LinuxCookedProtocolOffset);
+
+            break;
+        }
+
+        case LinkTypeLinuxCookedV2: {
+            offset = LinuxCookedV2HeaderLength;
+            type = etherType(0);
+
+            break;
+        }
+
+        default: {
+            return -1;
+        }
+    }
+
+    if (((type != EtherTypeIPv4) && (type != EtherTypeIPv6)) || (offset >= length)) {
+        return -1;
+    }
+
+    return offset;
+}
+
+PcapReplayNetwork::PcapReplayNetwork() :
+        m_version(Nedrysoft::ICMPSocket::V4),
+        m_timing(Timing::Immediate),
+        m_speed(1),
+        m_running(false) {
+
+}
+
+PcapReplayNetwork::~PcapReplayNetwork() {
+    // sockets that outlive the network must not call back into it.
+
+    if (Nedrysoft::ICMPSocket::ICMPSocket::simulator() == this) {
+        Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(nullptr);
+    }
+
+    stop();
+}
+
+auto PcapReplayNetwork::getInstance() -> PcapReplayNetwork * {
+    static PcapReplayNetwork network;
+
+    return &network;
+}
+
+auto PcapReplayNetwork::load(const QString &filename, Nedrysoft::ICMPSocket::IPVersion version) -> bool {
+    QFile file(filename);
+
+    m_packets.clear();
+    m_version = version;
+
+    if (!file.open(QFile::ReadOnly)) {
+        m_errorString = QString("Unable to open %1.").arg(filename);
+
+        return false;
+    }
+
+    auto contents = file.readAll();
+    auto data = contents.constData();
+    auto size = contents.size();
+
+    if (size < PcapHeaderLength) {
+        m_errorString = QString("%1 is not a pcap or pcapng file.").arg(filename);
+
+        return false;
+    }
+
+    auto magic = readValue<uint32_t>(data, false);
+
+    if (magic == SectionHeaderBlock) {
+        struct Interface {
+            uint32_t linkType;
+            uint8_t resolution;
+        };
+
+        auto interfaces = QVector<Interface>();
+        auto swapped = false;
+        auto offset = 0;
+
+        // a capture that was cut off part of the way through a block is read up to the last complete block.
+
+        while (offset + BlockHeaderLength + BlockTrailerLength <= size) {
+            auto type = readValue<uint32_t>(data + offset, swapped);
+
+            if (type == SectionHeaderBlock) {
+                auto byteOrder = readValue<uint32_t>(data + offset + BlockHeaderLength, false);
+
+                if ((byteOrder != ByteOrderMagic) && (qbswap(byteOrder) != ByteOrderMagic)) {
+                    m_errorString = QString("%1 has an unknown byte order.").arg(filename);
+
+                    return false;
+                }
+
+                swapped = (byteOrder != ByteOrderMagic);
+
+                interfaces.clear();
+            }
+
+            auto blockLength = static_cast<int>(readValue<uint32_t>(data + offset + 4, swapped));
+
+            if ((blockLength < BlockHeaderLength + BlockTrailerLength) || (blockLength > size - offset)) {
+                break;
+            }
+
+            auto body = data + offset + BlockHeaderLength;
+            auto bodyLength = blockLength - BlockHeaderLength - BlockTrailerLength;
+
+            if ((type == InterfaceDescriptionBlock) && (bodyLength >= InterfaceOptionsOffset)) {
+                auto interface = Interface{readValue<uint16_t>(body, swapped), MicrosecondResolution};
+                auto option = InterfaceOptionsOffset;
+
+                while (option + 4 <= bodyLength) {
+                    auto code = readValue<uint16_t>(body + option, swapped);
+                    auto length = readValue<uint16_t>(body + option + 2, swapped);
+
+                    if ((code == OptionEnd) || (option + 4 + length > bodyLength)) {
+                        break;
+                    }
+
+                    if ((code == OptionTimestampResolution) && (length == 1)) {
+                        interface.resolution = static_cast<uint8_t>(body[option + 4]);
+                    }
+
+                    option += 4 + ((length + 3) & ~3);
+                }
+
+                interfaces.append(interface);
+            } else if ((type == EnhancedPacketBlock) && (bodyLength >= EnhancedPacketDataOffset)) {
+                auto interfaceId = static_cast<int>(readValue<uint32_t>(body, swapped));
+                auto timestamp = (static_cast<uint64_t>(readValue<uint32_t>(body + 4, swapped)) << 32) |
+                                 readValue<uint32_t>(body + 8, swapped);
+                auto capturedLength = static_cast<int>(readValue<uint32_t>(body + 12, swapped));
+
+                if ((interfaceId >= 0) && (interfaceId < interfaces.size()) &&
+                    (capturedLength >= 0) && (capturedLength <= bodyLength - EnhancedPacketDataOffset)) {
+
+                    auto &interface = interfaces.at(interfaceId);
+                    auto frame = reinterpret_cast<const uint8_t *>(body + EnhancedPacketDataOffset);
+                    auto ipOffset = networkOffset(interface.linkType, frame, capturedLength);
+
+                    if (ipOffset >= 0) {
+                        addPacket(
+                            toNanoseconds(timestamp, interface.resolution),
+                            frame + ipOffset,
+                            capturedLength - ipOffset );
+                    }
+                }
+            }
+
+            offset += blockLength;
+        }
+    } else {
+        auto swapped = false;
+        auto nanoseconds = false;
+
+        if ((magic == PcapMagic) || (qbswap(magic) == PcapMagic)) {
+            swapped = (magic != PcapMagic);
+        } else if ((magic == PcapNanosecondMagic) || (qbswap(magic) == PcapNanosecondMagic)) {
+            swapped = (magic != PcapNanosecondMagic);
+            nanoseconds = true;
+        } else {
+            m_errorString = QString("%1 is not a pcap or pcapng file.").arg(filename);
+
+            return false;
+        }
+
+        // the upper bits of the link type hold the frame check sequence length, which is not part of the type.
+
+        auto linkType = readValue<uint32_t>(data + PcapLinkTypeOffset, swapped) & PcapLinkTypeMask;
+        auto offset = PcapHeaderLength;
+
+        while (offset + PcapRecordHeaderLength <= size) {
+            auto seconds = static_cast<qint64>(readValue<uint32_t>(data + offset, swapped));
+            auto fraction = static_cast<qint64>(readValue<uint32_t>(data + offset + 4, swapped));
+            auto capturedLength = static_cast<int>(readValue<uint32_t>(data + offset + 8, swapped));
+
+            offset += PcapRecordHeaderLength;
+
+            if ((capturedLength < 0) || (capturedLength > size - offset)) {
+                break;
+            }
+
+            auto frame = reinterpret_cast<const uint8_t *>(data + offset);
+            auto ipOffset = networkOffset(linkType, frame, capturedLength);
+
+            if (ipOffset >= 0) {
+                addPacket(
+                    (seconds * NanosecondsInSecond) + (nanoseconds ? fraction : fraction * 1000),
+                    frame + ipOffset,
+                    capturedLength - ipOffset );
+            }
+
+            offset += capturedLength;
+        }
+    }
+
+    if (m_packets.isEmpty()) {
+        m_errorString = QString("%1 holds no %2 replies to echo requests.")
+                .arg(filename)
+                .arg((version == Nedrysoft::ICMPSocket::V4) ? "ICMPv4" : "ICMPv6");
+
+        return false;
+    }
+
+    return true;
+}
+
+auto PcapReplayNetwork::addPacket(qint64 timestamp, const uint8_t *data, int length) -> void {
+    auto packet = Packet();
+    auto icmpOffset = 0;
+    auto replyType = 0;
+    auto requestType = 0;
+    auto isError = false;
+
+    packet.timestamp = timestamp;
+
+    if (m_version == Nedrysoft::ICMPSocket::V4) {
+        if ((length < IPv4HeaderLength) || ((data[0] >> 4) != 4) || (data[IPv4ProtocolOffset] != ICMPProtocolV4)) {
+            return;
+        }
+
+        // a raw IPv4 socket reads the IP header along with the ICMP message.
+
+        icmpOffset = (data[0] & 0x0f) * 4;
+
+        if (icmpOffset < IPv4HeaderLength) {
+            return;
+        }
+
+        packet.buffer = QByteArray(reinterpret_cast<const char *>(data), length);
+        packet.source = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(
+                QHostAddress(qFromBigEndian<quint32>(data + IPv4SourceOffset)));
+
+        replyType = ICMPEchoReplyV4;
+        requestType = ICMPEchoRequestV4;
+    } else {
+        if ((length < IPv6HeaderLength) || ((data[0] >> 4) != 6) || (data[IPv6NextHeaderOffset] != ICMPProtocolV6)) {
+            return;
+        }
+
+        // a raw IPv6 socket reads the ICMP message without the IP header.
+
+        packet.buffer = QByteArray(reinterpret_cast<const char *>(data) + IPv6HeaderLength, length - IPv6HeaderLength);
+        packet.source = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(
+                QHostAddress(data + IPv6SourceOffset));
+
+        replyType = ICMPEchoReplyV6;
+        requestType = ICMPEchoRequestV6;
+    }
+
+    auto buffer = reinterpret_cast<const uint8_t *>(packet.buffer.constData());
+    auto size = packet.buffer.size();
+
+    if (icmpOffset + ICMPHeaderLength > size) {
+        return;
+    }
+
+    auto type = buffer[icmpOffset];
+
+    if (m_version == Nedrysoft::ICMPSocket::V4) {
+        isError = (type == ICMPDestinationUnreachableV4) ||
+                  (type == ICMPTimeExceededV4) ||
+                  (type == ICMPParameterProblemV4);
+    } else {
+        isError = (type >= ICMPDestinationUnreachableV6) && (type <= ICMPParameterProblemV6);
+    }
+
+    if (type == replyType) {
+        packet.identifierOffset = icmpOffset + ICMPIdentifierOffset;
+    } else if (isError) {
+        // an error is matched by the echo request that it quotes.
+
+        auto quotedOffset = icmpOffset + ICMPHeaderLength;
+        auto quotedIcmpOffset = 0;
+
+        if (m_version == Nedrysoft::ICMPSocket::V4) {
+            if ((quotedOffset + IPv4HeaderLength > size) ||
+                (buffer[quotedOffset + IPv4ProtocolOffset] != ICMPProtocolV4)) {
+
+                return;
+            }
+
+            quotedIcmpOffset = quotedOffset + ((buffer[quotedOffset] & 0x0f) * 4);
+        } else {
+            if ((quotedOffset + IPv6HeaderLength > size) ||
+                (buffer[quotedOffset + IPv6NextHeaderOffset] != ICMPProtocolV6)) {
+
+                return;
+            }
+
+            quotedIcmpOffset = quotedOffset + IPv6HeaderLength;
+        }
+
+        if ((quotedIcmpOffset + ICMPHeaderLength > size) || (buffer[quotedIcmpOffset] != requestType)) {
+            return;
+        }
+
+        packet.identifierOffset = quotedIcmpOffset + ICMPIdentifierOffset;
+    } else {
+        return;
+    }
+
+    packet.checksumOffset = icmpOffset + ICMPChecksumOffset;
+
+    m_packets.append(packet);
+}
+
+auto PcapReplayNetwork::errorString() -> QString {
+    return m_errorString;
+}
+
+auto PcapReplayNetwork::packets() -> const QVector<PcapReplayNetwork::Packet> & {
+    return m_packets;
+}
+
+auto PcapReplayNetwork::start(PcapReplayNetwork::Timing timing, double speed) -> void {
+    stop();
+
+    if (m_packets.isEmpty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_timing = timing;
+        m_speed = (speed > 0) ? speed : 1;
+        m_counters = Counters();
+        m_running = true;
+    }
+
+    m_replayThread = std::thread(&PcapReplayNetwork::replayLoop, this);
+}
+
+auto PcapReplayNetwork::stop() -> void {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_running = false;
+    }
+
+    m_condition.notify_all();
+
+    if (m_replayThread.joinable()) {
+        m_replayThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_requests.clear();
+}
+
+auto PcapReplayNetwork::counters() -> PcapReplayNetwork::Counters {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_counters;
+}
+
+auto PcapReplayNetwork::addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_readSockets.append(socket);
+}
+
+auto PcapReplayNetwork::removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_readSockets.removeAll(socket);
+}
+
+auto PcapReplayNetwork::send(
+        Nedrysoft::ICMPSocket::ICMPSocket *socket,
+        const Nedrysoft::ICMPSocket::Datagram &datagram) -> int {
+
+    auto requestType = (m_version == Nedrysoft::ICMPSocket::V4) ? ICMPEchoRequestV4 : ICMPEchoRequestV6;
+
+    // only echo requests of the loaded version are answered, anything else is accepted and never answered.
+
+    if ((socket->protocol() != Nedrysoft::ICMPSocket::ICMP) ||
+        (socket->version() != m_version) ||
+        (datagram.buffer.length() < ICMPHeaderLength) ||
+        (static_cast<uint8_t>(datagram.buffer.at(0)) != requestType)) {
+
+        return datagram.buffer.length();
+    }
+
+    // the identifier and sequence are kept in network byte order, they are copied into the reply as they are.
+
+    auto request = Request();
+
+    memcpy(&request.identifier, datagram.buffer.constData() + ICMPIdentifierOffset, sizeof(request.identifier));
+    memcpy(&request.sequence, datagram.buffer.constData() + ICMPSequenceOffset, sizeof(request.sequence));
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_running) {
+        return datagram.buffer.length();
+    }
+
+    m_counters.requests++;
+
+    /**
+     * when requests are sent faster than the recorded replies arrive the oldest requests are left unanswered, they
+     * time out in the engine just as they would if their replies had been lost.
+     */
+
+    if (m_requests.size() >= MaximumPendingRequests) {
+        m_requests.pop_front();
+    }
+
+    auto wakeReplay = m_requests.empty();
+
+    m_requests.push_back(request);
+
+    lock.unlock();
+
+    if (wakeReplay) {
+        m_condition.notify_one();
+    }
+
+    return datagram.buffer.length();
+}
+
+auto PcapReplayNetwork::replayLoop() -> void {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto index = 0;
+    auto firstTimestamp = m_packets.first().timestamp;
+    auto recordedLength = m_packets.last().timestamp - firstTimestamp;
+
+    // the capture repeats after a gap of the average time between its replies, so the rate is kept across loops.
+
+    if (m_packets.size() > 1) {
+        recordedLength += recordedLength / (m_packets.size() - 1);
+    } else {
+        recordedLength = NanosecondsInMillisecond;
+    }
+
+    auto startTimestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+    auto loopOffset = 0ll;
+
+    while (m_running) {
+        if (m_requests.empty()) {
+            m_condition.wait(lock);
+
+            continue;
+        }
+
+        auto &packet = m_packets.at(index);
+        auto now = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+        if (m_timing == Timing::Recorded) {
+            auto due = startTimestamp + static_cast<qint64>(
+                    static_cast<double>(packet.timestamp - firstTimestamp + loopOffset) / m_speed);
+
+            if (due > now) {
+                m_condition.wait_for(lock, std::chrono::nanoseconds(due - now));
+
+                continue;
+            }
+
+            if (now - due > LateTolerance) {
+                m_counters.late++;
+                m_counters.lateness += now - due;
+            }
+        }
+
+        auto request = m_requests.front();
+
+        m_requests.pop_front();
+
+        auto datagram = Nedrysoft::ICMPSocket::Datagram();
+
+        datagram.buffer = packet.buffer;
+
+        auto data = datagram.buffer.data();
+        uint16_t checksum, oldValue;
+
+        memcpy(&checksum, data + packet.checksumOffset, sizeof(checksum));
+
+        memcpy(&oldValue, data + packet.identifierOffset, sizeof(oldValue));
+        checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, request.identifier);
+        memcpy(data + packet.identifierOffset, &request.identifier, sizeof(request.identifier));
+
+        memcpy(&oldValue, data + packet.identifierOffset + 2, sizeof(oldValue));
+        checksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldValue, request.sequence);
+        memcpy(data + packet.identifierOffset + 2, &request.sequence, sizeof(request.sequence));
+
+        memcpy(data + packet.checksumOffset, &checksum, sizeof(checksum));
+
+        datagram.socketAddress = packet.source;
+        datagram.timestamp = Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp();
+
+        /**
+         * the reply is delivered with the mutex held, so a socket cannot be destroyed while a reply is being
+         * queued on it.
+         */
+
+        for (auto socket : m_readSockets) {
+            if (socket->version() == m_version) {
+                socket->deliver(datagram);
+            }
+        }
+
+        m_counters.delivered++;
+
+        if (++index == m_packets.size()) {
+            index = 0;
+            loopOffset += recordedLength;
+        }
+    }
+}
+
+#endif // defined(Q_OS_UNIX)
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCAPREPLAYNETWORK_H
+#define PCAPREPLAYNETWORK_H
+
+#include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketSimulator.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief       The PcapReplayNetwork class answers the requests of the ping engines with replies read from a capture.
+ *
+ * @details     The ICMP replies in a pcap or pcapng file are loaded into memory, echo replies and the errors that
+ *              quote an echo request.  Each echo request sent by an engine is answered by the next reply from the
+ *              capture, with its identifier and sequence rewritten to those of the request so that the lookup in
+ *              the request table finds it, the checksum is updated to match.  The replies are delivered to the read
+ *              sockets as the kernel would deliver them, so the receiver and the engine decode and dispatch them
+ *              with exactly the code that handles replies from a real network.
+ *
+ *              Replies are either delivered the moment a request is sent, so the receive path runs as fast as the
+ *              engine can send, or at the times they were recorded in the capture.
+ */
+class PcapReplayNetwork :
+        public Nedrysoft::ICMPSocket::ICMPSocketSimulator {
+
+    public:
+        /**
+         * @brief       When the replies are delivered.
+         */
+        enum class Timing {
+            Immediate,                          /**< as soon as there is a request to answer. */
+            Recorded                            /**< at the time recorded in the capture. */
+        };
+
+        /**
+         * @brief       A reply loaded from the capture.
+         */
+        struct Packet {
+            qint64 timestamp = 0;               //!< the time it was captured in nanoseconds.
+            QByteArray buffer;                  //!< the packet as a raw socket would read it.
+            Nedrysoft::ICMPSocket::SocketAddress source;
+            int checksumOffset = 0;             //!< the offset of the ICMP checksum.
+            int identifierOffset = 0;           //!< the offset of the identifier, the sequence follows it.
+        };
+
+        /**
+         * @brief       The counters of what has been replayed.
+         */
+        struct Counters {
+            quint64 requests = 0;               //!< the number of echo requests that the engines sent.
+            quint64 delivered = 0;              //!< the number of replies delivered to the read sockets.
+            quint64 late = 0;                   //!< the number of replies delivered after their recorded time.
+            qint64 lateness = 0;                //!< the total time in nanoseconds the late replies were behind.
+        };
+
+    private:
+        /**
+         * @brief       Constructs the PcapReplayNetwork.
+         */
+        PcapReplayNetwork();
+
+    public:
+        /**
+         * @brief       Stops the replay and destroys the PcapReplayNetwork.
+         */
+        ~PcapReplayNetwork() override;
+
+        /**
+         * @brief       Returns the PcapReplayNetwork instance.
+         *
+         * @returns     the network.
+         */
+        static auto getInstance() -> PcapReplayNetwork *;
+
+        /**
+         * @brief       Loads the replies from a capture.
+         *
+         * @details     Classic pcap files (either byte order, microsecond or nanosecond timestamps) and pcapng
+         *              files are read, with raw IP, Ethernet or Linux cooked framing.  Only the replies of one IP
+         *              version are kept, so that every reply can be delivered to the engine under test.
+         *
+         * @param[in]   filename the capture file.
+         * @param[in]   version the IP version of the replies to keep.
+         *
+         * @returns     true if the capture was read and held at least one reply; otherwise false.
+         */
+        auto load(const QString &filename, Nedrysoft::ICMPSocket::IPVersion version) -> bool;
+
+        /**
+         * @brief       Returns the reason that the last load failed.
+         *
+         * @returns     the error.
+         */
+        auto errorString() -> QString;
+
+        /**
+         * @brief       Returns the replies that were loaded.
+         *
+         * @returns     the replies in the order they were captured.
+         */
+        auto packets() -> const QVector<Packet> &;
+
+        /**
+         * @brief       Starts answering requests.
+         *
+         * @param[in]   timing when the replies are delivered.
+         * @param[in]   speed the factor that the recorded times are divided by.
+         */
+        auto start(Timing timing, double speed) -> void;
+
+        /**
+         * @brief       Stops answering requests, requests that have not been answered are discarded.
+         */
+        auto stop() -> void;
+
+        /**
+         * @brief       Returns the counters since the replay was started.
+         *
+         * @returns     the counters.
+         */
+        auto counters() -> Counters;
+
+        /**
+         * @brief       Records a new read socket.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::addReadSocket
+         *
+         * @param[in]   socket the read socket.
+         */
+        auto addReadSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+        /**
+         * @brief       Forgets a socket that is being destroyed.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::removeSocket
+         *
+         * @param[in]   socket the socket.
+         */
+        auto removeSocket(Nedrysoft::ICMPSocket::ICMPSocket *socket) -> void override;
+
+        /**
+         * @brief       Queues an echo request to be answered.
+         *
+         * @see         Nedrysoft::ICMPSocket::ICMPSocketSimulator::send
+         *
+         * @param[in]   socket the socket the request was sent through.
+         * @param[in]   datagram the request.
+         *
+         * @returns     the number of bytes sent.
+         */
+        auto send(
+            Nedrysoft::ICMPSocket::ICMPSocket *socket,
+            const Nedrysoft::ICMPSocket::Datagram &datagram
+        ) -> int override;
+
+    private:
+        /**
+         * @brief       Adds a packet from the capture if it is a reply of the loaded version.
+         *
+         * @param[in]   timestamp the time the packet was captured in nanoseconds.
+         * @param[in]   data the packet, starting at the IP header.
+         * @param[in]   length the number of bytes captured.
+         */
+        auto addPacket(qint64 timestamp, const uint8_t *data, int length) -> void;
+
+        /**
+         * @brief       Answers the queued requests with the loaded replies.
+         */
+        auto replayLoop() -> void;
+
+    private:
+        //! @cond
+
+        struct Request {
+            uint16_t identifier;
+            uint16_t sequence;
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+
+        Nedrysoft::ICMPSocket::IPVersion m_version;
+        QVector<Packet> m_packets;
+        QString m_errorString;
+
+        Timing m_timing;
+        double m_speed;
+        Counters m_counters;
+
+        QList<Nedrysoft::ICMPSocket::ICMPSocket *> m_readSockets;
+        std::deque<Request> m_requests;
+
+        bool m_running;
+        std::thread m_replayThread;
+
+        //! @endcond
+};
+
+#endif // PCAPREPLAYNETWORK_H
@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+
+#if defined(Q_OS_UNIX)
+
+#include "ICMPPacket/ICMPPacketCodec.h"
+#include "PcapReplayNetwork.h"
+
+#include <ComponentLoader>
+#include <IComponentManager>
+#include <IPingEngine.h>
+#include <IPingEngineFactory.h>
+#include <IPingTarget.h>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+constexpr auto EngineFactoryClassName = "Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory";
+constexpr auto DefaultDuration = 10;
+constexpr auto DefaultInterval = 1;
+constexpr auto DefaultTargets = 256;
+constexpr auto DefaultTimeout = 1000;
+constexpr auto DefaultSpeed = 1.0;
+constexpr auto DecodeDuration = 1.0;
+constexpr auto DecodeBatch = 1024;
+constexpr auto DrainFactor = 2;
+constexpr auto NanosecondsInSecond = 1000000000.0;
+constexpr auto NanosecondsInMicrosecond = 1000.0;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+/**
+ * @brief       Returns the address of a replay destination.
+ *
+ * @details     The requests never leave the process, the addresses only need to be distinct.
+ *
+ * @param[in]   index the destination number.
+ * @param[in]   version the IP version.
+ *
+ * @returns     the address.
+ */
+static auto destinationAddress(int index, Nedrysoft::ICMPSocket::IPVersion version) -> QHostAddress {
+    if (version == Nedrysoft::ICMPSocket::V4) {
+        return QHostAddress(static_cast<quint32>((10u << 24) | static_cast<quint32>(index+1)));
+    }
+
+    return QHostAddress(QString("fd00::%1").arg(index+1, 0, 16));
+}
+
+/**
+ * @brief       Runs the processing of the main thread for a time.
+ *
+ * @param[in]   milliseconds the time to run for.
+ */
+static auto runEventLoop(int milliseconds) -> void {
+    QEventLoop eventLoop;
+
+    QTimer::singleShot(milliseconds, &eventLoop, &QEventLoop::quit);
+
+    eventLoop.exec();
+}
+
+/**
+ * @brief       Measures the time taken to decode the replies on their own.
+ *
+ * @details     The replies are decoded with the codec that the receiver uses, repeatedly for a fixed time, which
+ *              gives the cost of the parsing stage without the cost of waking threads and moving the results.
+ *
+ * @param[in]   packets the replies.
+ *
+ * @returns     the mean time to decode a reply in nanoseconds.
+ */
+template <Nedrysoft::ICMPPacket::IPVersion Version>
+static auto decodeTime(const QVector<PcapReplayNetwork::Packet> &packets) -> double {
+    QElapsedTimer timer;
+    quint64 decoded = 0;
+    volatile uint16_t sink = 0;
+
+    timer.start();
+
+    while (static_cast<double>(timer.nsecsElapsed())<DecodeDuration*NanosecondsInSecond) {
+        for (auto count=0;count<DecodeBatch;count++) {
+            auto packet = Nedrysoft::ICMPPacket::ICMPPacketCodec<Version>::decode(
+                    packets.at(static_cast<int>(decoded%static_cast<quint64>(packets.size()))).buffer);
+
+            sink = sink + packet.sequence();
+
+            decoded++;
+        }
+    }
+
+    return static_cast<double>(timer.nsecsElapsed())/static_cast<double>(decoded);
+}
+
+/**
+ * @brief       Returns a percentile of a sorted list of values.
+ *
+ * @param[in]   values the sorted values.
+ * @param[in]   rank the percentile.
+ *
+ * @returns     the value at the percentile; or 0 if there are no values.
+ */
+static auto percentile(const std::vector<double> &values, double rank) -> double {
+    if (values.empty()) {
+        return 0;
+    }
+
+    return values.at(static_cast<size_t>((rank/100.0)*static_cast<double>(values.size()-1)));
+}
+
+int main(int argc, char *argv[]) {
+    QApplication application(argc, argv);
+
+    spdlog::set_level(spdlog::level::info);
+
+    QCommandLineParser commandLineParser;
+
+    commandLineParser.setApplicationDescription(
+            "Replays the ICMP replies in a capture through the receive path of the ICMP ping engine and reports "
+            "the packets per second and the time spent in each stage." );
+
+    commandLineParser.addHelpOption();
+
+    commandLineParser.addPositionalArgument("capture", "The pcap or pcapng file to replay.");
+
+    commandLineParser.addOptions({
+        {"ip-version", "The IP version of the replies to replay, 4 or 6.", "version", "4"},
+        {"duration", "The time to run for in seconds.", "seconds", QString::number(DefaultDuration)},
+        {"interval", "The interval between probes in milliseconds.", "milliseconds", QString::number(DefaultInterval)},
+        {"targets", "The number of targets to ping.", "count", QString::number(DefaultTargets)},
+        {"timeout", "The time before a request is timed out in milliseconds.", "milliseconds",
+                QString::number(DefaultTimeout)},
+        {"recorded-timing", "Deliver the replies at the times they were captured rather than as fast as possible."},
+        {"speed", "The factor that the recorded times are divided by.", "factor", QString::number(DefaultSpeed)},
+        {"output", "The file to write the results to, the console is used if not given.", "filename"}
+    });
+
+    commandLineParser.process(application);
+
+    if (commandLineParser.positionalArguments().size()!=1) {
+        commandLineParser.showHelp(1);
+    }
+
+    auto filename = commandLineParser.positionalArguments().first();
+    auto duration = std::max(commandLineParser.value("duration").toInt(), 1);
+    auto interval = std::max(commandLineParser.value("interval").toInt(), 1);
+    auto targets = std::max(commandLineParser.value("targets").toInt(), 1);
+    auto timeout = std::max(commandLineParser.value("timeout").toInt(), interval);
+    auto recordedTiming = commandLineParser.isSet("recorded-timing");
+    auto speed = std::max(commandLineParser.value("speed").toDouble(), 0.0);
+
+    auto version = (commandLineParser.value("ip-version")=="6") ? Nedrysoft::ICMPSocket::V6 :
+                                                                  Nedrysoft::ICMPSocket::V4;
+
+    auto network = PcapReplayNetwork::getInstance();
+
+    if (!network->load(filename, version)) {
+        SPDLOG_ERROR(network->errorString().toStdString());
+
+        return 1;
+    }
+
+    auto &packets = network->packets();
+
+    SPDLOG_INFO(QString("Loaded %1 replies from %2.").arg(packets.size()).arg(filename).toStdString());
+
+    auto decodeNanoseconds = (version==Nedrysoft::ICMPSocket::V4) ?
+            decodeTime<Nedrysoft::ICMPPacket::V4>(packets) :
+            decodeTime<Nedrysoft::ICMPPacket::V6>(packets);
+
+    /**
+     * the replay network must be installed before the engine creates its sockets, otherwise the engine would open
+     * real sockets and ping the addresses used by the run.
+     */
+
+    Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(network);
+
+    Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+    componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+    componentLoader.loadComponents();
+
+    Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;
+
+    for (auto engineFactory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if (QString::fromLatin1(engineFactory->metaObject()->className())==EngineFactoryClassName) {
+            factory = engineFactory;
+        }
+    }
+
+    if (!factory) {
+        SPDLOG_ERROR("Unable to find Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory.");
+
+        return 1;
+    }
+
+    auto engine = factory->createEngine((version==Nedrysoft::ICMPSocket::V4) ? Nedrysoft::Core::IPVersion::V4 :
+                                                                             Nedrysoft::Core::IPVersion::V6);
+
+    engine->setInterval(interval);
+    engine->setTimeout(timeout);
+    engine->setResultBatching(true);
+
+    for (auto target=0;target<targets;target++) {
+        engine->addTarget(destinationAddress(target, version));
+    }
+
+    QObject context;
+
+    /**
+     * a result is complete once it reaches the main thread, the time since its reply was delivered covers the wake
+     * of the receiver, the decode, the request table lookup, the statistics and the hand over to the main thread.
+     */
+
+    auto dispatchTimes = std::vector<double>();
+    quint64 resultCount = 0;
+
+    QObject::connect(
+        engine,
+        &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+        &context,
+        [&](QVector<Nedrysoft::RouteAnalyser::PingResult> pingResults) {
+
+            auto now = static_cast<double>(Nedrysoft::ICMPSocket::ICMPSocket::currentTimestamp());
+
+            for (auto &pingResult : pingResults) {
+                if (Nedrysoft::RouteAnalyser::PingResult::isLost(pingResult.code())) {
+                    continue;
+                }
+
+                auto receiveTimestamp = static_cast<double>(pingResult.requestTimestamp()) +
+                                        (pingResult.roundTripTime()*NanosecondsInSecond);
+
+                dispatchTimes.push_back(std::max(now-receiveTimestamp, 0.0)/NanosecondsInMicrosecond);
+
+                resultCount++;
+            }
+        } );
+
+    QElapsedTimer runClock;
+
+    network->start(recordedTiming ? PcapReplayNetwork::Timing::Recorded : PcapReplayNetwork::Timing::Immediate, speed);
+
+    runClock.start();
+
+    engine->start();
+
+    runEventLoop(duration*static_cast<int>(MillisecondsInSecond));
+
+    auto elapsed = static_cast<double>(runClock.nsecsElapsed())/NanosecondsInSecond;
+    auto counters = network->counters();
+    auto completed = resultCount;
+
+    engine->stop();
+
+    runEventLoop(timeout*DrainFactor);
+
+    network->stop();
+
+    auto statistics = engine->statistics();
+
+    factory->deleteEngine(engine);
+
+    Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(nullptr);
+
+    std::sort(dispatchTimes.begin(), dispatchTimes.end());
+
+    auto failures = QStringList();
+
+    if (!counters.delivered) {
+        failures.append("No replies were delivered, the engine did not send any echo requests.");
+    } else if (!completed) {
+        failures.append(QString("%1 replies were delivered but no results reached the main thread.")
+                .arg(counters.delivered));
+    }
+
+    auto results = QJsonObject{
+        {"capture", filename},
+        {"ipVersion", (version==Nedrysoft::ICMPSocket::V4) ? 4 : 6},
+        {"timing", recordedTiming ? "recorded" : "immediate"},
+        {"speed", speed},
+        {"duration", elapsed},
+        {"interval", interval},
+        {"targets", targets},
+        {"capturedReplies", packets.size()},
+        {"requests", static_cast<qint64>(counters.requests)},
+        {"delivered", static_cast<qint64>(counters.delivered)},
+        {"deliveredLate", static_cast<qint64>(counters.late)},
+        {"meanLateness", counters.late ?
+                static_cast<double>(counters.lateness)/static_cast<double>(counters.late)/NanosecondsInMicrosecond :
+                0.0},
+        {"packetsPerSecond", static_cast<double>(counters.delivered)/elapsed},
+        {"resultsPerSecond", static_cast<double>(completed)/elapsed},
+        {"stages", QJsonObject{
+            {"decode", QJsonObject{
+                {"mean", decodeNanoseconds/NanosecondsInMicrosecond},
+                {"packetsPerSecond", NanosecondsInSecond/decodeNanoseconds}
+            }},
+            {"dispatch", QJsonObject{
+                {"p50", percentile(dispatchTimes, 50)},
+                {"p90", percentile(dispatchTimes, 90)},
+                {"p99", percentile(dispatchTimes, 99)},
+                {"maximum", dispatchTimes.empty() ? 0.0 : dispatchTimes.back()}
+            }}
+        }},
+        {"packetsSent", static_cast<qint64>(statistics.packetsSent)},
+        {"packetsReceived", static_cast<qint64>(statistics.packetsReceived)},
+        {"unmatchedReplies", static_cast<qint64>(statistics.unmatchedReplies)},
+        {"duplicateReplies", static_cast<qint64>(statistics.duplicateReplies)},
+        {"lateReplies", static_cast<qint64>(statistics.lateReplies)},
+        {"timedOut", static_cast<qint64>(statistics.timedOut)},
+        {"receiveDrops", static_cast<qint64>(statistics.receiveDrops)},
+        {"passed", failures.isEmpty()},
+        {"failures", QJsonArray::fromStringList(failures)}
+    };
+
+    SPDLOG_INFO(QString("%1 packets/s delivered, %2 results/s, decode %3 us, dispatch p50 %4 us, p99 %5 us")
+            .arg(static_cast<double>(counters.delivered)/elapsed, 0, 'f', 0)
+            .arg(static_cast<double>(completed)/elapsed, 0, 'f', 0)
+            .arg(decodeNanoseconds/NanosecondsInMicrosecond, 0, 'f', 3)
+            .arg(percentile(dispatchTimes, 50), 0, 'f', 1)
+            .arg(percentile(dispatchTimes, 99), 0, 'f', 1).toStdString());
+
+    auto json = QJsonDocument(results).toJson();
+
+    if (commandLineParser.isSet("output")) {
+        QFile outputFile(commandLineParser.value("output"));
+
+        if (!outputFile.open(QFile::WriteOnly)) {
+            SPDLOG_ERROR(QString("Unable to write results to %1.").arg(outputFile.fileName()).toStdString());
+
+            return 1;
+        }
+
+        outputFile.write(json);
+    } else {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    for (auto &failure : failures) {
+        SPDLOG_ERROR(failure.toStdString());
+    }
+
+    return failures.isEmpty() ? 0 : 1;
+}
+
+#else
+
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    std::fputs("The replay benchmark uses the simulated sockets, which are only available on Linux and macOS.\n",
+               stderr);
+
+    return 0;
+}
+
+#endif // defined(Q_OS_UNIX)
@@ -0,0 +1,608 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+
+#if defined(Q_OS_UNIX)
+
+#include "HopTimeSeries.h"
+#include "MemoryGovernor.h"
+#include "PingData.h"
+#include "SimulatedNetwork.h"
+
+#include <ComponentLoader>
+#include <Diagnostics>
+#include <IComponentManager>
+#include <IPingEngine.h>
+#include <IPingEngineFactory.h>
+#include <IPingTarget.h>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#endif
+
+constexpr auto EngineFactoryClassName = "Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory";
+constexpr auto PingItemsSubsystem = "ICMP ping items";
+constexpr auto DefaultDuration = 600;
+constexpr auto DefaultInterval = 10;
+constexpr auto DefaultDestinations = 20;
+constexpr auto DefaultWindow = 10;
+constexpr auto DefaultWarmup = 60;
+constexpr auto DefaultHistoryBudget = 64;
+constexpr auto DefaultRoundTripTolerance = 0.5;
+constexpr auto FrameInterval = 16;
+constexpr auto MinimumWindows = 6;
+constexpr auto ResidentGrowthFraction = 0.10;
+constexpr auto ResidentGrowthSlack = 16.0*1024*1024;
+constexpr auto RequestGrowthFraction = 0.5;
+constexpr auto HistoryBudgetSlack = 1.10;
+constexpr auto FrameGrowthFactor = 2.0;
+constexpr auto FrameGrowthSlack = 5.0;
+constexpr auto FramePercentile = 99.0;
+constexpr auto DrainFactor = 2;
+constexpr auto BytesPerMegabyte = 1024*1024;
+constexpr auto NanosecondsInSecond = 1000000000.0;
+constexpr auto NanosecondsInMillisecond = 1000000.0;
+constexpr auto MillisecondsInSecond = 1000.0;
+
+/**
+ * @brief       The measurements taken over one window of the run.
+ */
+struct SoakWindow {
+    double time = 0;                            //!< the time since the start of the run in seconds.
+    qint64 residentSize = 0;                    //!< the resident set size of the process in bytes.
+    quint64 outstandingRequests = 0;            //!< the number of requests in the engine request table.
+    qint64 pingItems = 0;                       //!< the number of ping items in use.
+    qint64 historyBytes = 0;                    //!< the memory used by the time series of the hops.
+    qint64 accountedBytes = 0;                  //!< the memory accounted by all of the memory counters.
+    double frameTime = 0;                       //!< the percentile of the frame times in milliseconds.
+    double roundTripError = 0;                  //!< the largest difference from the modelled round trip time in ms.
+    quint64 replies = 0;                        //!< the number of replies received during the window.
+};
+
+/**
+ * @brief       Returns the resident set size of the process.
+ *
+ * @returns     the size in bytes, or the peak size where the current size is not available.
+ */
+static auto residentSize() -> qint64 {
+#if defined(Q_OS_LINUX)
+    auto statm = std::fopen("/proc/self/statm", "r");
+
+    if (statm) {
+        long pages = 0, residentPages = 0;
+
+        auto fields = std::fscanf(statm, "%ld %ld", &pages, &residentPages);
+
+        std::fclose(statm);
+
+        if (fields==2) {
+            return static_cast<qint64>(residentPages)*sysconf(_SC_PAGESIZE);
+        }
+    }
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info_data_t info = {};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)==KERN_SUCCESS) {
+        return static_cast<qint64>(info.resident_size);
+    }
+#endif
+    struct rusage usage = {};
+
+    getrusage(RUSAGE_SELF, &usage);
+
+#if defined(Q_OS_MACOS)
+    return static_cast<qint64>(usage.ru_maxrss);
+#else
+    return static_cast<qint64>(usage.ru_maxrss)*1024;
+#endif
+}
+
+/**
+ * @brief       Returns the address of a simulated destination.
+ *
+ * @param[in]   index the destination number.
+ *
+ * @returns     the address, which is outside the range used for the simulated routers.
+ */
+static auto destinationAddress(int index) -> QHostAddress {
+    return QHostAddress(static_cast<quint32>((10u << 24) | static_cast<quint32>(index+1)));
+}
+
+/**
+ * @brief       Runs the processing of the main thread for a time.
+ *
+ * @param[in]   milliseconds the time to run for.
+ */
+static auto runEventLoop(int milliseconds) -> void {
+    QEventLoop eventLoop;
+
+    QTimer::singleShot(milliseconds, &eventLoop, &QEventLoop::quit);
+
+    eventLoop.exec();
+}
+
+/**
+ * @brief       Returns the mean of a range of windows.
+ *
+ * @param[in]   windows the windows.
+ * @param[in]   first the index of the first window.
+ * @param[in]   last the index after the last window.
+ * @param[in]   value the function that returns the value of a window.
+ *
+ * @returns     the mean.
+ */
+template <typename T>
+static auto mean(const std::vector<SoakWindow> &windows, size_t first, size_t last, T value) -> double {
+    auto total = 0.0;
+
+    for (auto index=first;index<last;index++) {
+        total += static_cast<double>(value(windows.at(index)));
+    }
+
+    return (last>first) ? total/static_cast<double>(last-first) : 0.0;
+}
+
+int main(int argc, char *argv[]) {
+    QApplication application(argc, argv);
+
+    // the measurements of each window are logged as the run progresses, a run normally lasts for some time.
+
+    spdlog::set_level(spdlog::level::info);
+
+    QCommandLineParser commandLineParser;
+
+    commandLineParser.setApplicationDescription(
+            "Runs the ICMP ping engine against a simulated network for a long period and checks that memory, the "
+            "request table and the frame times stay bounded and that the round trip times do not drift." );
+
+    commandLineParser.addHelpOption();
+
+    commandLineParser.addOptions({
+        {"duration", "The time to run for in seconds.", "seconds", QString::number(DefaultDuration)},
+        {"interval", "The interval between probes in milliseconds.", "milliseconds", QString::number(DefaultInterval)},
+        {"destinations", "The number of destinations to trace.", "count", QString::number(DefaultDestinations)},
+        {"window", "The time over which each measurement is taken in seconds.", "seconds",
+                QString::number(DefaultWindow)},
+        {"warmup", "The time before growth is measured in seconds.", "seconds", QString::number(DefaultWarmup)},
+        {"history-budget", "The memory budget of the hop history in megabytes.", "megabytes",
+                QString::number(DefaultHistoryBudget)},
+        {"tolerance", "The allowed difference from the modelled round trip time in milliseconds.", "milliseconds",
+                QString::number(DefaultRoundTripTolerance)},
+        {"output", "The file to write the results to, the console is used if not given.", "filename"}
+    });
+
+    commandLineParser.process(application);
+
+    auto duration = std::max(commandLineParser.value("duration").toInt(), 1);
+    auto interval = std::max(commandLineParser.value("interval").toInt(), 1);
+    auto destinations = std::max(commandLineParser.value("destinations").toInt(), 1);
+    auto windowLength = std::max(commandLineParser.value("window").toInt(), 1);
+    auto warmup = std::max(commandLineParser.value("warmup").toInt(), 0);
+    auto historyBudget = static_cast<qint64>(std::max(commandLineParser.value("history-budget").toInt(), 1));
+    auto tolerance = std::max(commandLineParser.value("tolerance").toDouble(), 0.0);
+
+    historyBudget *= BytesPerMegabyte;
+
+    /**
+     * the simulated network must be installed before the engine creates its sockets, otherwise the engine would
+     * open real sockets and ping the addresses used by the run.
+     */
+
+    auto network = SimulatedNetwork::getInstance();
+
+    Nedrysoft::ICMPSocket::ICMPSocket::setSimulator(network);
+
+    Nedrysoft::ComponentSystem::ComponentLoader componentLoader;
+
+    componentLoader.addComponents(PINGNOO_TEST_COMPONENTS_DIR);
+
+    componentLoader.loadComponents();
+
+    Nedrysoft::RouteAnalyser::IPingEngineFactory *factory = nullptr;
+
+    for (auto engineFactory : Nedrysoft::ComponentSystem::getObjects<Nedrysoft::RouteAnalyser::IPingEngineFactory>()) {
+        if (QString::fromLatin1(engineFactory->metaObject()->className())==EngineFactoryClassName) {
+            factory = engineFactory;
+        }
+    }
+
+    if (!factory) {
+        SPDLOG_ERROR("Unable to find Nedrysoft::ICMPPingEngine::ICMPPingEngineFactory.");
+
+        return 1;
+    }
+
+    auto configuration = SimulatedNetwork::Configuration();
+
+    network->setConfiguration(configuration);
+
+    auto engine = factory->createEngine(Nedrysoft::Core::IPVersion::V4);
+
+    /**
+     * the timeout is a multiple of the interval so that the request table is exercised at the accelerated rate, the
+     * modelled route is far shorter than the timeout so only the simulated loss (none by default) times out.
+     */
+
+    auto timeout = std::max(interval*DrainFactor, static_cast<int>(configuration.hopCount*configuration.hopLatency*
+                                                                   MillisecondsInSecond*DrainFactor));
+
+    engine->setInterval(interval);
+    engine->setTimeout(timeout);
+    engine->setResultBatching(true);
+
+    auto hopCount = configuration.hopCount;
+    auto hops = std::vector<std::unique_ptr<Nedrysoft::RouteAnalyser::PingData> >();
+
+    for (auto destination=0;destination<destinations;destination++) {
+        for (auto hop=1;hop<=hopCount;hop++) {
+            auto target = engine->addTarget(destinationAddress(destination), hop);
+
+            hops.push_back(std::make_unique<Nedrysoft::RouteAnalyser::PingData>(nullptr, hop, true));
+
+            target->setUserData(hops.back().get());
+        }
+    }
+
+    QObject context;
+
+    // the history of the hops is kept within a budget by the memory governor, exactly as it is for the editors.
+
+    auto memoryGovernor = Nedrysoft::RouteAnalyser::MemoryGovernor::getInstance();
+
+    memoryGovernor->setBudget(historyBudget);
+
+    memoryGovernor->addOwner(
+        &context,
+        interval,
+        [&hops]() {
+            QVector<Nedrysoft::RouteAnalyser::HopTimeSeries *> seriesList;
+
+            for (auto &pingData : hops) {
+                seriesList.append(pingData->timeSeries());
+            }
+
+            return seriesList;
+        },
+        nullptr );
+
+    auto roundTripSums = std::vector<double>(static_cast<size_t>(hopCount), 0);
+    auto roundTripCounts = std::vector<quint64>(static_cast<size_t>(hopCount), 0);
+    quint64 replies = 0;
+
+    QObject::connect(
+        engine,
+        &Nedrysoft::RouteAnalyser::IPingEngine::resultsReady,
+        &context,
+        [&](QVector<Nedrysoft::RouteAnalyser::PingResult> pingResults) {
+
+            for (auto &pingResult : pingResults) {
+                auto pingData = static_cast<Nedrysoft::RouteAnalyser::PingData *>(pingResult.target()->userData());
+
+                pingData->updateItem(pingResult);
+
+                pingData->timeSeries()->append(
+                        static_cast<double>(pingResult.requestTimestamp())/NanosecondsInSecond,
+                        pingResult.roundTripTime(),
+                        pingResult.code() );
+
+                if (Nedrysoft::RouteAnalyser::PingResult::isLost(pingResult.code())) {
+                    continue;
+                }
+
+                auto hop = static_cast<size_t>(pingData->hop()-1);
+
+                roundTripSums[hop] += pingResult.roundTripTime();
+                roundTripCounts[hop]++;
+                replies++;
+            }
+        } );
+
+    /**
+     * the frame timer stands in for the repaints of the user interface, how late it fires is how long a frame
+     * would have been held up by the processing of the results on the main thread.
+     */
+
+    auto frameTimes = std::vector<double>();
+    QElapsedTimer frameClock;
+    QTimer frameTimer;
+
+    frameTimer.setTimerType(Qt::PreciseTimer);
+    frameTimer.setInterval(FrameInterval);
+
+    QObject::connect(&frameTimer, &QTimer::timeout, &context, [&]() {
+        auto elapsed = static_cast<double>(frameClock.nsecsElapsed())/NanosecondsInMillisecond;
+
+        frameClock.restart();
+
+        frameTimes.push_back(std::max(elapsed-FrameInterval, 0.0));
+    });
+
+    auto windows = std::vector<SoakWindow>();
+    QElapsedTimer runClock;
+    QTimer windowTimer;
+
+    windowTimer.setInterval(windowLength*static_cast<int>(MillisecondsInSecond));
+
+    QObject::connect(&windowTimer, &QTimer::timeout, &context, [&]() {
+        auto window = SoakWindow();
+
+        window.time = static_cast<double>(runClock.elapsed())/MillisecondsInSecond;
+        window.residentSize = residentSize();
+        window.outstandingRequests = engine->statistics().outstandingRequests;
+        window.replies = replies;
+
+        for (auto &usage : Nedrysoft::Core::Diagnostics::getInstance()->memoryUsage()) {
+            window.accountedBytes += usage.bytes;
+
+            if (usage.subsystem==PingItemsSubsystem) {
+                window.pingItems += usage.allocations;
+            }
+        }
+
+        for (auto &pingData : hops) {
+            window.historyBytes += static_cast<qint64>(pingData->timeSeries()->memoryUsage());
+        }
+
+        std::sort(frameTimes.begin(), frameTimes.end());
+
+        if (!frameTimes.empty()) {
+            auto index = static_cast<size_t>((FramePercentile/100.0)*static_cast<double>(frameTimes.size()-1));
+
+            window.frameTime = frameTimes.at(index);
+        }
+
+        // the modelled latency of a hop is the same for every destination, so the hops are compared by number.
+
+        for (auto hop=0;hop<hopCount;hop++) {
+            if (!roundTripCounts[hop]) {
+                continue;
+            }
+
+            auto measured = roundTripSums[hop]/static_cast<double>(roundTripCounts[hop]);
+            auto modelled = (hop+1)*configuration.hopLatency;
+
+            window.roundTripError = std::max(window.roundTripError, std::fabs(measured-modelled)*MillisecondsInSecond);
+        }
+
+        std::fill(roundTripSums.begin(), roundTripSums.end(), 0);
+        std::fill(roundTripCounts.begin(), roundTripCounts.end(), 0);
+
+        frameTimes.clear();
+        replies = 0;
+
+        windows.push_back(window);
+
+        SPDLOG_INFO(QString("%1s rss %2 MB, %3 requests, %4 items, history %5 MB, frame %6 ms, rtt error %7 ms")
+                .arg(window.time, 0, 'f', 0)
+                .arg(static_cast<double>(window.residentSize)/BytesPerMegabyte, 0, 'f', 1)
+                .arg(window.outstandingRequests)
+                .arg(window.pingItems)
+                .arg(static_cast<double>(window.historyBytes)/BytesPerMegabyte, 0, 'f', 1)
+                .arg(window.frameTime, 0, 'f', 2)
+                .arg(window.roundTripError, 0, 'f', 3).toStdString());
+    });
+
+    runClock.start();
+    frameClock.start();
+
+    engine->start();
+
+    frameTimer.start();
+    windowTimer.start();
+
+    runEventLoop(duration*static_cast<int>(MillisecondsInSecond));
+
+    windowTimer.stop();
+    frameTimer.stop();
+
+    engine->stop();
+
+    runEventLoop(timeout*DrainFactor);
+
+    auto statistics = engine->statistics();
+
+    memoryGovernor->removeOwner(&context);
+
+    factory->deleteEngine(engine);
+
+    /**
+     * growth is judged by comparing the first and last thirds of the windows after the warm up, a quantity that is
+     * bounded levels off during the warm up while one that leaks keeps on rising through both.
+     */
+
+    auto failures = QStringList();
+    auto first = static_cast<size_t>(std::count_if(windows.begin(), windows.end(), [warmup](const SoakWindow &window) {
+        return window.time<warmup;
+    }));
+
+    auto measured = windows.size()-first;
+
+    if (measured<MinimumWindows) {
+        failures.append(QString("Only %1 windows were measured after the warm up, at least %2 are needed.")
+                .arg(measured)
+                .arg(MinimumWindows));
+    } else {
+        auto third = measured/3;
+        auto earlyEnd = first+third;
+        auto lateStart = windows.size()-third;
+
+        auto bounded = [&](const QString &name, double early, double late, double allowed) {
+            if (late>allowed) {
+                failures.append(QString("%1 grew from %2 to %3 (allowed %4).")
+                        .arg(name)
+                        .arg(early, 0, 'f', 2)
+                        .arg(late, 0, 'f', 2)
+                        .arg(allowed, 0, 'f', 2));
+            }
+        };
+
+        auto early = mean(windows, first, earlyEnd, [](const SoakWindow &window) { return window.residentSize; });
+        auto late = mean(windows, lateStart, windows.size(), [](const SoakWindow &window) {
+            return window.residentSize;
+        });
+
+        bounded("Resident set size (bytes)", early, late, (early*(1+ResidentGrowthFraction))+ResidentGrowthSlack);
+
+        auto targetCount = static_cast<double>(destinations*hopCount);
+
+        early = mean(windows, first, earlyEnd, [](const SoakWindow &window) { return window.outstandingRequests; });
+        late = mean(windows, lateStart, windows.size(), [](const SoakWindow &window) {
+            return window.outstandingRequests;
+        });
+
+        bounded("Outstanding requests", early, late, (early*(1+RequestGrowthFraction))+targetCount);
+
+        early = mean(windows, first, earlyEnd, [](const SoakWindow &window) { return window.pingItems; });
+        late = mean(windows, lateStart, windows.size(), [](const SoakWindow &window) { return window.pingItems; });
+
+        bounded("Ping items in use", early, late, (early*(1+RequestGrowthFraction))+targetCount);
+
+        early = mean(windows, first, earlyEnd, [](const SoakWindow &window) { return window.frameTime; });
+        late = mean(windows, lateStart, windows.size(), [](const SoakWindow &window) { return window.frameTime; });
+
+        bounded("Frame delay (ms)", early, late, (early*FrameGrowthFactor)+FrameGrowthSlack);
+
+        for (auto index=first;index<windows.size();index++) {
+            auto &window = windows.at(index);
+
+            if (static_cast<double>(window.historyBytes)>static_cast<double>(historyBudget)*HistoryBudgetSlack) {
+                failures.append(QString("The hop history used %1 MB at %2s, over the %3 MB budget.")
+                        .arg(static_cast<double>(window.historyBytes)/BytesPerMegabyte, 0, 'f', 1)
+                        .arg(window.time, 0, 'f', 0)
+                        .arg(historyBudget/BytesPerMegabyte));
+
+                break;
+            }
+        }
+
+        for (auto index=first;index<windows.size();index++) {
+            auto &window = windows.at(index);
+
+            if (!window.replies) {
+                failures.append(QString("No replies were received in the window ending at %1s.").arg(window.time));
+
+                break;
+            }
+
+            if (window.roundTripError>tolerance) {
+                failures.append(QString("The round trip times were %1 ms from the modelled latency at %2s.")
+                        .arg(window.roundTripError, 0, 'f', 3)
+                        .arg(window.time, 0, 'f', 0));
+
+                break;
+            }
+        }
+    }
+
+    // once stopped and drained every request has been answered or timed out, anything left has been leaked.
+
+    if (statistics.outstandingRequests) {
+        failures.append(QString("%1 requests were still outstanding after the engine was stopped.")
+                .arg(statistics.outstandingRequests));
+    }
+
+    QJsonArray windowArray;
+
+    for (auto &window : windows) {
+        windowArray.append(QJsonObject{
+            {"time", window.time},
+            {"residentSize", window.residentSize},
+            {"outstandingRequests", static_cast<qint64>(window.outstandingRequests)},
+            {"pingItems", window.pingItems},
+            {"historyBytes", window.historyBytes},
+            {"accountedBytes", window.accountedBytes},
+            {"frameDelay", window.frameTime},
+            {"roundTripError", window.roundTripError},
+            {"replies", static_cast<qint64>(window.replies)}
+        });
+    }
+
+    auto results = QJsonObject{
+        {"duration", duration},
+        {"interval", interval},
+        {"destinations", destinations},
+        {"targets", destinations*hopCount},
+        {"packetsSent", static_cast<qint64>(statistics.packetsSent)},
+        {"packetsReceived", static_cast<qint64>(statistics.packetsReceived)},
+        {"timedOut", static_cast<qint64>(statistics.timedOut)},
+        {"passed", failures.isEmpty()},
+        {"failures", QJsonArray::fromStringList(failures)},
+        {"windows", windowArray}
+    };
+
+    auto json = QJsonDocument(results).toJson();
+
+    if (commandLineParser.isSet("output")) {
+        QFile outputFile(commandLineParser.value("output"));
+
+        if (!outputFile.open(QFile::WriteOnly)) {
+            SPDLOG_ERROR(QString("Unable to write results to %1.").arg(outputFile.fileName()).toStdString());
+
+            return 1;
+        }
+
+        outputFile.write(json);
+    } else {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    for (auto &failure : failures) {
+        SPDLOG_ERROR(failure.toStdString());
+    }
+
+    return failures.isEmpty() ? 0 : 1;
+}
+
+#else
+
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    std::fputs("The soak test uses the simulated network, which is only available on Linux and macOS.\n", stderr);
+
+    return 0;
+}
+
+#endif // defined(Q_OS_UNIX)
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "CompressedSeries.h"
+
+using ResultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode;
+
+constexpr auto SeriesStart = 1000.0;
+constexpr auto SeriesInterval = 0.5;
+
+static auto sampleCode(int index) -> ResultCode {
+    if ((index%10)==3) {
+        return ResultCode::NoReply;
+    }
+
+    if ((index%25)==7) {
+        return ResultCode::TimeExceeded;
+    }
+
+    return ResultCode::Ok;
+}
+
+static auto sampleRoundTripTime(int index) -> double {
+    return (10000+(index*37)%5000)/1000000.0;
+}
+
+static auto fillSeries(Nedrysoft::RouteAnalyser::CompressedSeries &series, int count) -> void {
+    for (auto index=0;index<count;index++) {
+        series.append(SeriesStart+index*SeriesInterval, sampleRoundTripTime(index), sampleCode(index));
+    }
+}
+
+TEST_CASE("CompressedSeries Tests", "[app][components][compressedseries]") {
+    SECTION("empty series has no samples") {
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        REQUIRE(series.count()==0);
+        REQUIRE(series.blockCount()==0);
+        REQUIRE(series.encodedSize()==0);
+        REQUIRE(series.begin()==series.end());
+        REQUIRE(series.lowerBound(SeriesStart)==series.end());
+        REQUIRE(series.decode(0).times.empty());
+        REQUIRE(series.decode(-1).times.empty());
+    }
+
+    SECTION("samples round trip across blocks") {
+        constexpr auto sampleCount = Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples*2+500;
+
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        fillSeries(series, sampleCount);
+
+        REQUIRE(series.count()==sampleCount);
+        REQUIRE(series.blockCount()==3);
+
+        auto index = 0;
+
+        for (auto &sample : series) {
+            REQUIRE(sample.time==Approx(SeriesStart+index*SeriesInterval));
+            REQUIRE(sample.code==sampleCode(index));
+
+            if (Nedrysoft::RouteAnalyser::PingResult::isLost(sample.code)) {
+                REQUIRE(sample.roundTripTime==-1);
+            } else {
+                REQUIRE(sample.roundTripTime==Approx(sampleRoundTripTime(index)));
+            }
+
+            index++;
+        }
+
+        REQUIRE(index==sampleCount);
+    }
+
+    SECTION("decoded blocks match the iterated samples") {
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        fillSeries(series, Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples+10);
+
+        auto first = series.decode(0);
+        auto last = series.decode(1);
+
+        REQUIRE(first.times.size()==Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples);
+        REQUIRE(first.roundTripTimes.size()==first.times.size());
+        REQUIRE(first.codes.size()==first.times.size());
+        REQUIRE(last.times.size()==10);
+        REQUIRE(series.decode(2).times.empty());
+
+        auto index = Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples;
+
+        for (auto sample=0;sample<10;sample++,index++) {
+            REQUIRE(last.times[sample]==Approx(SeriesStart+index*SeriesInterval));
+            REQUIRE(last.codes[sample]==static_cast<uint8_t>(sampleCode(index)));
+
+            if (!Nedrysoft::RouteAnalyser::PingResult::isLost(sampleCode(index))) {
+                REQUIRE(last.roundTripTimes[sample]==Approx(sampleRoundTripTime(index)));
+            }
+        }
+    }
+
+    SECTION("irregular intervals and negative round trip deltas are preserved") {
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        series.append(1.0, 0.250, ResultCode::Ok);
+        series.append(1.5, 0.001, ResultCode::Ok);
+        series.append(4.000001, 0.100, ResultCode::Unreachable);
+        series.append(4.25, 0.000001, ResultCode::Prohibited);
+        series.append(100.0, 2.5, ResultCode::Ok);
+
+        auto sample = series.begin();
+
+        REQUIRE(sample->time==Approx(1.0));
+        REQUIRE(sample->roundTripTime==Approx(0.250));
+
+        ++sample;
+
+        REQUIRE(sample->time==Approx(1.5));
+        REQUIRE(sample->roundTripTime==Approx(0.001));
+
+        ++sample;
+
+        REQUIRE(sample->time==Approx(4.000001));
+        REQUIRE(sample->code==ResultCode::Unreachable);
+        REQUIRE(sample->roundTripTime==-1);
+
+        ++sample;
+
+        REQUIRE(sample->time==Approx(4.25));
+        REQUIRE(sample->code==ResultCode::Prohibited);
+
+        ++sample;
+
+        REQUIRE(sample->time==Approx(100.0));
+        REQUIRE(sample->code==ResultCode::Ok);
+        REQUIRE(sample->roundTripTime==Approx(2.5));
+
+        ++sample;
+
+        REQUIRE(sample==series.end());
+    }
+
+    SECTION("oldest blocks are dropped when the maximum is reached") {
+        constexpr auto blockSamples = Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples;
+
+        Nedrysoft::RouteAnalyser::CompressedSeries series(2);
+
+        fillSeries(series, blockSamples*3+1);
+
+        REQUIRE(series.blockCount()==2);
+        REQUIRE(series.count()==blockSamples+1);
+        REQUIRE(series.begin()->time==Approx(SeriesStart+blockSamples*2*SeriesInterval));
+
+        series.setMaximumBlocks(0);
+
+        REQUIRE(series.maximumBlocks()==1);
+        REQUIRE(series.blockCount()==1);
+        REQUIRE(series.count()==1);
+        REQUIRE(series.begin()->time==Approx(SeriesStart+blockSamples*3*SeriesInterval));
+
+        REQUIRE(Nedrysoft::RouteAnalyser::CompressedSeries(-5).maximumBlocks()==1);
+    }
+
+    SECTION("lower bound finds the first sample at or after a time") {
+        constexpr auto blockSamples = Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples;
+
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        fillSeries(series, blockSamples*2);
+
+        REQUIRE(series.lowerBound(0)==series.begin());
+        REQUIRE(series.lowerBound(SeriesStart)->time==Approx(SeriesStart));
+        REQUIRE(series.lowerBound(SeriesStart+0.25)->time==Approx(SeriesStart+SeriesInterval));
+
+        auto blockStart = SeriesStart+blockSamples*SeriesInterval;
+
+        REQUIRE(series.lowerBound(blockStart)->time==Approx(blockStart));
+        REQUIRE(series.lowerBound(blockStart-0.25)->time==Approx(blockStart));
+        REQUIRE(series.lowerBound(SeriesStart+blockSamples*2*SeriesInterval)==series.end());
+    }
+
+    SECTION("steady samples encode smaller than the raw values") {
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        for (auto index=0;index<Nedrysoft::RouteAnalyser::CompressedSeries::BlockSamples;index++) {
+            series.append(SeriesStart+index*SeriesInterval, 0.020, ResultCode::Ok);
+        }
+
+        REQUIRE(series.encodedSize()<series.count()*(sizeof(double)*2+1)/4);
+    }
+
+    SECTION("clear removes all samples") {
+        Nedrysoft::RouteAnalyser::CompressedSeries series;
+
+        fillSeries(series, 100);
+
+        series.clear();
+
+        REQUIRE(series.count()==0);
+        REQUIRE(series.blockCount()==0);
+        REQUIRE(series.begin()==series.end());
+
+        fillSeries(series, 1);
+
+        REQUIRE(series.count()==1);
+        REQUIRE(series.begin()->time==Approx(SeriesStart));
+    }
+}
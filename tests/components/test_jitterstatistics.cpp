@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "JitterStatistics.h"
+
+#include <cmath>
+#include <iterator>
+
+constexpr auto SketchAccuracy = 0.01;
+
+TEST_CASE("JitterStatistics Tests", "[app][components][statistics]") {
+    SECTION("no replies gives no measures") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        REQUIRE(statistics.jitter()==-1);
+        REQUIRE(statistics.ipdv()==-1);
+        REQUIRE(statistics.pdv(0.5)==-1);
+    }
+
+    SECTION("a single reply has no variation between replies") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        statistics.add(0.050);
+
+        REQUIRE(statistics.jitter()==-1);
+        REQUIRE(statistics.ipdv()==-1);
+        REQUIRE(statistics.pdv(0.5)==0);
+    }
+
+    SECTION("a constant delay has no variation") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        for (auto reply=0;reply<10;reply++) {
+            statistics.add(0.025);
+        }
+
+        REQUIRE(statistics.jitter()==0);
+        REQUIRE(statistics.ipdv()==0);
+        REQUIRE(statistics.pdv(1)==0);
+    }
+
+    SECTION("jitter follows RFC 3550 and ipdv is the last difference") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+        double delays[] = {0.020, 0.030, 0.025, 0.045, 0.040};
+        auto expectedJitter = -1.0;
+
+        for (auto index=0;index<static_cast<int>(std::size(delays));index++) {
+            statistics.add(delays[index]);
+
+            if (index) {
+                auto difference = std::abs(delays[index]-delays[index-1]);
+
+                if (expectedJitter<0) {
+                    expectedJitter = difference;
+                } else {
+                    expectedJitter += (difference-expectedJitter)/16.0;
+                }
+            }
+        }
+
+        REQUIRE(statistics.jitter()==Approx(expectedJitter));
+        REQUIRE(statistics.ipdv()==Approx(0.005));
+    }
+
+    SECTION("pdv is measured against the minimum of all the replies") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        // the minimum falls after the first replies, which must then be measured against the new minimum.
+
+        statistics.add(0.050);
+        statistics.add(0.060);
+        statistics.add(0.020);
+        statistics.add(0.030);
+
+        REQUIRE(statistics.pdv(0)==0);
+        REQUIRE(statistics.pdv(1)==Approx(0.040).epsilon(2*SketchAccuracy));
+
+        auto median = statistics.pdv(0.5);
+
+        REQUIRE(median>=0.010*(1-2*SketchAccuracy));
+        REQUIRE(median<=0.030*(1+2*SketchAccuracy));
+    }
+
+    SECTION("negative one way delays do not affect the variation") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        statistics.add(-0.010);
+        statistics.add(-0.005);
+        statistics.add(-0.015);
+
+        REQUIRE(statistics.ipdv()==Approx(0.010));
+        REQUIRE(statistics.pdv(1)==Approx(0.010).epsilon(2*SketchAccuracy));
+    }
+
+    SECTION("clear removes all measurements") {
+        Nedrysoft::RouteAnalyser::JitterStatistics statistics;
+
+        statistics.add(0.010);
+        statistics.add(0.020);
+        statistics.clear();
+
+        REQUIRE(statistics.jitter()==-1);
+        REQUIRE(statistics.ipdv()==-1);
+        REQUIRE(statistics.pdv(0.5)==-1);
+
+        statistics.add(0.100);
+
+        REQUIRE(statistics.pdv(0.5)==0);
+    }
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "LatencySketch.h"
+
+#include <QDataStream>
+
+constexpr auto SketchAccuracy = 0.01;
+
+TEST_CASE("LatencySketch Tests", "[app][components][statistics]") {
+    SECTION("empty sketch has no quantiles") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch;
+
+        REQUIRE(sketch.isEmpty());
+        REQUIRE(sketch.count()==0);
+        REQUIRE(sketch.quantile(0.5)==-1);
+
+        sketch.add(0.010);
+        sketch.clear();
+
+        REQUIRE(sketch.isEmpty());
+        REQUIRE(sketch.quantile(0.5)==-1);
+    }
+
+    SECTION("quantiles are within the relative accuracy") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch;
+
+        for (auto value=1;value<=1000;value++) {
+            sketch.add(value/1000.0);
+        }
+
+        REQUIRE(sketch.count()==1000);
+
+        REQUIRE(sketch.quantile(0)==Approx(0.001).epsilon(SketchAccuracy));
+        REQUIRE(sketch.quantile(0.5)==Approx(0.500).epsilon(SketchAccuracy));
+        REQUIRE(sketch.quantile(0.95)==Approx(0.950).epsilon(SketchAccuracy));
+        REQUIRE(sketch.quantile(1)==Approx(1.000).epsilon(SketchAccuracy));
+    }
+
+    SECTION("quantiles outside 0 to 1 are clamped") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch;
+
+        sketch.add(0.010);
+        sketch.add(0.100);
+
+        REQUIRE(sketch.quantile(-1)==sketch.quantile(0));
+        REQUIRE(sketch.quantile(2)==sketch.quantile(1));
+    }
+
+    SECTION("values below a microsecond are counted as zero") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch;
+
+        sketch.add(0);
+        sketch.add(1e-9);
+        sketch.add(0.010);
+
+        REQUIRE(sketch.count()==3);
+        REQUIRE(sketch.quantile(0.5)==0);
+        REQUIRE(sketch.quantile(1)==Approx(0.010).epsilon(SketchAccuracy));
+    }
+
+    SECTION("merged sketches match a single sketch of all the values") {
+        Nedrysoft::RouteAnalyser::LatencySketch first, second, combined;
+
+        for (auto value=1;value<=500;value++) {
+            first.add(value/1000.0);
+            combined.add(value/1000.0);
+        }
+
+        for (auto value=0;value<200;value++) {
+            second.add(2.0+value/100.0);
+            combined.add(2.0+value/100.0);
+        }
+
+        first.merge(second);
+
+        REQUIRE(first.count()==combined.count());
+
+        for (auto quantile : {0.0, 0.25, 0.5, 0.75, 0.99, 1.0}) {
+            REQUIRE(first.quantile(quantile)==combined.quantile(quantile));
+        }
+    }
+
+    SECTION("merging an empty sketch changes nothing") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch, empty;
+
+        sketch.add(0.020);
+        sketch.merge(empty);
+
+        REQUIRE(sketch.count()==1);
+        REQUIRE(sketch.quantile(0.5)==Approx(0.020).epsilon(SketchAccuracy));
+
+        empty.merge(sketch);
+
+        REQUIRE(empty.quantile(0.5)==sketch.quantile(0.5));
+    }
+
+    SECTION("shift adds an offset to every value") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch;
+
+        sketch.add(0);
+        sketch.add(0.010);
+        sketch.add(0.020);
+
+        sketch.shift(0.005);
+
+        REQUIRE(sketch.count()==3);
+        REQUIRE(sketch.quantile(0)==Approx(0.005).epsilon(SketchAccuracy));
+        REQUIRE(sketch.quantile(0.5)==Approx(0.015).epsilon(2*SketchAccuracy));
+        REQUIRE(sketch.quantile(1)==Approx(0.025).epsilon(2*SketchAccuracy));
+
+        auto before = sketch.quantile(0.5);
+
+        sketch.shift(0);
+        sketch.shift(-1);
+
+        REQUIRE(sketch.quantile(0.5)==before);
+    }
+
+    SECTION("save and load round trip") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch, loaded;
+        QByteArray data;
+
+        for (auto value=1;value<=100;value++) {
+            sketch.add(value/100.0);
+        }
+
+        sketch.add(0);
+
+        {
+            QDataStream stream(&data, QIODevice::WriteOnly);
+
+            sketch.save(stream);
+        }
+
+        QDataStream stream(data);
+
+        REQUIRE(loaded.load(stream));
+        REQUIRE(loaded.count()==sketch.count());
+
+        for (auto quantile : {0.0, 0.5, 0.9, 1.0}) {
+            REQUIRE(loaded.quantile(quantile)==sketch.quantile(quantile));
+        }
+    }
+
+    SECTION("loading a truncated sketch fails and leaves it unchanged") {
+        Nedrysoft::RouteAnalyser::LatencySketch sketch, loaded;
+        QByteArray data;
+
+        sketch.add(0.010);
+        sketch.add(0.020);
+
+        {
+            QDataStream stream(&data, QIODevice::WriteOnly);
+
+            sketch.save(stream);
+        }
+
+        data.chop(2);
+
+        loaded.add(0.500);
+
+        QDataStream stream(data);
+
+        REQUIRE_FALSE(loaded.load(stream));
+        REQUIRE(loaded.count()==1);
+        REQUIRE(loaded.quantile(0.5)==Approx(0.500).epsilon(SketchAccuracy));
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "LiteralMatcher.h"
+
+#include <QString>
+#include <QVector>
+#include <algorithm>
+
+using LiteralMatcher = Nedrysoft::RegExHostMasker::LiteralMatcher;
+
+static auto sorted(QVector<int> identifiers) -> QVector<int> {
+    std::sort(identifiers.begin(), identifiers.end());
+
+    return identifiers;
+}
+
+TEST_CASE("LiteralMatcher Tests", "[app][components][network]") {
+    SECTION("an empty matcher finds nothing") {
+        LiteralMatcher matcher;
+
+        matcher.build();
+
+        REQUIRE(matcher.match("").isEmpty());
+        REQUIRE(matcher.match("host.example.com").isEmpty());
+    }
+
+    SECTION("empty text and empty literals match nothing") {
+        LiteralMatcher matcher;
+
+        matcher.add("", 1);
+        matcher.add("example", 2);
+        matcher.build();
+
+        REQUIRE(matcher.match("").isEmpty());
+        REQUIRE(matcher.match("example")==QVector<int>({2}));
+    }
+
+    SECTION("each occurrence of a literal is reported") {
+        LiteralMatcher matcher;
+
+        matcher.add("aa", 1);
+        matcher.build();
+
+        REQUIRE(matcher.match("aaaa")==QVector<int>({1, 1, 1}));
+        REQUIRE(matcher.match("abab").isEmpty());
+    }
+
+    SECTION("overlapping literals and suffixes are all found") {
+        LiteralMatcher matcher;
+
+        matcher.add("he", 1);
+        matcher.add("she", 2);
+        matcher.add("his", 3);
+        matcher.add("hers", 4);
+        matcher.build();
+
+        REQUIRE(sorted(matcher.match("ushers"))==QVector<int>({1, 2, 4}));
+        REQUIRE(sorted(matcher.match("this"))==QVector<int>({3}));
+        REQUIRE(matcher.match("hx").isEmpty());
+    }
+
+    SECTION("literals are found at the start and end of the text") {
+        LiteralMatcher matcher;
+
+        matcher.add("static", 1);
+        matcher.add(".co.uk", 2);
+        matcher.build();
+
+        REQUIRE(sorted(matcher.match("static.test.co.uk"))==QVector<int>({1, 2}));
+        REQUIRE(matcher.match("Static.test.co").isEmpty());
+    }
+
+    SECTION("a literal shared by several rules reports each of them") {
+        LiteralMatcher matcher;
+
+        matcher.add("isp", 1);
+        matcher.add("isp", 2);
+        matcher.build();
+
+        REQUIRE(sorted(matcher.match("host.isp.net"))==QVector<int>({1, 2}));
+    }
+
+    SECTION("clear removes all of the literals") {
+        LiteralMatcher matcher;
+
+        matcher.add("example", 1);
+        matcher.build();
+        matcher.clear();
+        matcher.build();
+
+        REQUIRE(matcher.match("example").isEmpty());
+    }
+
+    SECTION("required literals are extracted from simple patterns") {
+        REQUIRE(LiteralMatcher::requiredLiteral("")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("example")==QString("example"));
+        REQUIRE(LiteralMatcher::requiredLiteral("^(?<host>.*)\\.static\\.test\\.co\\.uk$")==
+                QString(".static.test.co.uk"));
+        REQUIRE(LiteralMatcher::requiredLiteral("[0-9]+-[0-9]+\\.dsl\\.isp\\.net")==QString(".dsl.isp.net"));
+    }
+
+    SECTION("optional atoms are not required") {
+        REQUIRE(LiteralMatcher::requiredLiteral("(abcdef)?xyz")==QString("xyz"));
+        REQUIRE(LiteralMatcher::requiredLiteral("(abcdef)+xyz")==QString("abcdef"));
+        REQUIRE(LiteralMatcher::requiredLiteral("abc+d")==QString("abc"));
+        REQUIRE(LiteralMatcher::requiredLiteral("ab*cd")==QString("cd"));
+        REQUIRE(LiteralMatcher::requiredLiteral("a{0,3}bc")==QString("bc"));
+        REQUIRE(LiteralMatcher::requiredLiteral("(?=abcdef)xy")==QString("xy"));
+    }
+
+    SECTION("patterns that cannot be proven to need a literal give none") {
+        REQUIRE(LiteralMatcher::requiredLiteral("abc|def")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("\\p{L}+example")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("\\Q(example\\E")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("[abc")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("(example")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("*example")==QString());
+        REQUIRE(LiteralMatcher::requiredLiteral("(?i)example")==QString());
+    }
+}
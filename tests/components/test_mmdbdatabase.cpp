@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "Database.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QTemporaryFile>
+
+#include <cstring>
+
+using Database = Nedrysoft::MMDBGeoIPProvider::Database;
+using Type = Nedrysoft::MMDBGeoIPProvider::Database::Type;
+
+constexpr auto MetadataMarker = "\xAB\xCD\xEFMaxMind.com";
+constexpr auto MetadataMarkerLength = 14;
+constexpr auto DataSectionSeparator = 16;
+constexpr auto NodeCount = 1u;
+constexpr auto FirstRecord = NodeCount+DataSectionSeparator;
+constexpr auto MaximumDepth = 64;
+
+static auto control(Type type, int size) -> QByteArray {
+    auto value = static_cast<int>(type);
+    auto sizeBits = (size<29) ? size : 29;
+    auto bytes = QByteArray();
+
+    if (value>7) {
+        bytes.append(static_cast<char>(sizeBits));
+        bytes.append(static_cast<char>(value-7));
+    } else {
+        bytes.append(static_cast<char>((value << 5) | sizeBits));
+    }
+
+    if (size>=29) {
+        bytes.append(static_cast<char>(size-29));
+    }
+
+    return bytes;
+}
+
+static auto string(const QByteArray &value) -> QByteArray {
+    return control(Type::String, value.length())+value;
+}
+
+static auto unsignedValue(Type type, uint64_t value, int length) -> QByteArray {
+    auto bytes = control(type, length);
+
+    for (auto byte=length-1;byte>=0;byte--) {
+        bytes.append(static_cast<char>(value >> (byte*8)));
+    }
+
+    return bytes;
+}
+
+static auto doubleValue(double value) -> QByteArray {
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return unsignedValue(Type::Double, bits, sizeof(bits));
+}
+
+static auto pointer(uint32_t offset) -> QByteArray {
+    auto bytes = QByteArray();
+
+    bytes.append(static_cast<char>((static_cast<int>(Type::Pointer) << 5) | ((offset >> 8) & 7)));
+    bytes.append(static_cast<char>(offset));
+
+    return bytes;
+}
+
+static auto nested(int depth, const QByteArray &value) -> QByteArray {
+    auto bytes = QByteArray();
+
+    for (auto level=0;level<depth;level++) {
+        bytes += control(Type::Array, 1);
+    }
+
+    return bytes+value;
+}
+
+/**
+ * builds an IPv4 database with 24 bit records and a single node, addresses in 0.0.0.0/1 have no data and addresses
+ * in 128.0.0.0/1 use the given record.
+ */
+
+static auto buildDatabase(
+        const QByteArray &data,
+        uint32_t dataRecord = FirstRecord,
+        int recordSize = 24 ) -> QByteArray {
+
+    auto bytes = QByteArray();
+
+    for (auto record : {NodeCount, dataRecord}) {
+        bytes.append(static_cast<char>(record >> 16));
+        bytes.append(static_cast<char>(record >> 8));
+        bytes.append(static_cast<char>(record));
+    }
+
+    bytes += QByteArray(DataSectionSeparator, 0);
+    bytes += data;
+    bytes += QByteArray(MetadataMarker, MetadataMarkerLength);
+    bytes += control(Type::Map, 3);
+    bytes += string("node_count")+unsignedValue(Type::UInt32, NodeCount, 4);
+    bytes += string("record_size")+unsignedValue(Type::UInt16, static_cast<uint64_t>(recordSize), 2);
+    bytes += string("ip_version")+unsignedValue(Type::UInt16, 4, 2);
+
+    return bytes;
+}
+
+static auto openDatabase(Database &database, QTemporaryFile &file, const QByteArray &contents) -> bool {
+    if ((!file.open()) || (file.write(contents)!=contents.length()) || (!file.flush())) {
+        return false;
+    }
+
+    return database.open(file.fileName());
+}
+
+/**
+ * the record holds a country, a location, a list and a pointer back to the country's iso code, which is at
+ * offset 19 of the data section.
+ */
+
+static auto cityRecord() -> QByteArray {
+    return control(Type::Map, 4)+
+           string("country")+control(Type::Map, 1)+string("iso_code")+string("GB")+
+           string("location")+control(Type::Map, 1)+string("latitude")+doubleValue(51.5)+
+           string("list")+control(Type::Array, 2)+string("a")+string("b")+
+           string("ref")+pointer(19);
+}
+
+TEST_CASE("MMDB Database Tests", "[app][components][geoip]") {
+    SECTION("a record is found and its values are read") {
+        QTemporaryFile file;
+        Database database;
+        uint32_t offset, valueOffset;
+        QString value;
+        double number;
+
+        REQUIRE(openDatabase(database, file, buildDatabase(cityRecord())));
+        REQUIRE(database.isOpen());
+
+        REQUIRE_FALSE(database.lookup(QHostAddress("10.0.0.1"), offset));
+        REQUIRE_FALSE(database.lookup(QHostAddress("2001:db8::1"), offset));
+        REQUIRE(database.lookup(QHostAddress("192.0.2.1"), offset));
+        REQUIRE(offset==0);
+
+        REQUIRE(database.find(offset, {"country", "iso_code"}, valueOffset));
+        REQUIRE(database.string(valueOffset, value));
+        REQUIRE(value==QString("GB"));
+
+        REQUIRE(database.find(offset, {"location", "latitude"}, valueOffset));
+        REQUIRE(database.number(valueOffset, number));
+        REQUIRE(number==51.5);
+        REQUIRE_FALSE(database.string(valueOffset, value));
+
+        REQUIRE(database.find(offset, {"list", "1"}, valueOffset));
+        REQUIRE(database.string(valueOffset, value));
+        REQUIRE(value==QString("b"));
+
+        REQUIRE(database.find(offset, {"ref"}, valueOffset));
+        REQUIRE(database.string(valueOffset, value));
+        REQUIRE(value==QString("GB"));
+
+        REQUIRE_FALSE(database.find(offset, {"list", "2"}, valueOffset));
+        REQUIRE_FALSE(database.find(offset, {"list", "x"}, valueOffset));
+        REQUIRE_FALSE(database.find(offset, {"city"}, valueOffset));
+        REQUIRE_FALSE(database.find(offset, {"country", "iso_code", "en"}, valueOffset));
+    }
+
+    SECTION("a truncated file is rejected") {
+        auto contents = buildDatabase(cityRecord());
+
+        for (auto length=0;length<contents.length();length++) {
+            QTemporaryFile file;
+            Database database;
+
+            REQUIRE_FALSE(openDatabase(database, file, contents.left(length)));
+            REQUIRE_FALSE(database.isOpen());
+        }
+    }
+
+    SECTION("metadata describing an unusable tree is rejected") {
+        QTemporaryFile recordSizeFile, markerFile;
+        Database database;
+
+        REQUIRE_FALSE(openDatabase(database, recordSizeFile, buildDatabase(cityRecord(), FirstRecord, 20)));
+
+        auto contents = buildDatabase(cityRecord());
+
+        contents[contents.indexOf("MaxMind.com")] = 'm';
+
+        REQUIRE_FALSE(openDatabase(database, markerFile, contents));
+    }
+
+    SECTION("a record beyond the data section is not found") {
+        QTemporaryFile file;
+        Database database;
+        uint32_t offset;
+
+        REQUIRE(openDatabase(database, file, buildDatabase(cityRecord(), FirstRecord+1000)));
+        REQUIRE_FALSE(database.lookup(QHostAddress("192.0.2.1"), offset));
+    }
+
+    SECTION("values that overrun the data section are rejected") {
+        /**
+         * a map cannot be read past a corrupt value, so each value is the only entry of its record.  The pointers
+         * lead outside the data section and to another pointer (at offset 9), the double is too short and the
+         * strings claim more bytes than remain.
+         */
+
+        auto values = {
+            pointer(0x7ff),
+            pointer(9)+pointer(0),
+            control(Type::Double, 4)+QByteArray(4, 0),
+            control(Type::String, 60)+QByteArray("abc"),
+            control(Type::String, 60).left(1)
+        };
+
+        for (auto &badValue : values) {
+            QTemporaryFile file;
+            Database database;
+            uint32_t offset, valueOffset;
+            QString value;
+            double number;
+
+            REQUIRE(openDatabase(database, file, buildDatabase(control(Type::Map, 1)+string("value")+badValue)));
+            REQUIRE(database.lookup(QHostAddress("192.0.2.1"), offset));
+
+            REQUIRE(database.find(offset, {"value"}, valueOffset));
+            REQUIRE_FALSE(database.string(valueOffset, value));
+            REQUIRE_FALSE(database.number(valueOffset, number));
+            REQUIRE_FALSE(database.find(offset, {"value", "name"}, valueOffset));
+
+            REQUIRE(database.isOpen());
+        }
+    }
+
+    SECTION("values nested up to the limit are skipped") {
+        QTemporaryFile file;
+        Database database;
+        uint32_t offset, valueOffset;
+        QString value;
+
+        auto data = control(Type::Map, 2)+
+                    string("deep")+nested(MaximumDepth, string("x"))+
+                    string("after")+string("y");
+
+        REQUIRE(openDatabase(database, file, buildDatabase(data)));
+        REQUIRE(database.lookup(QHostAddress("192.0.2.1"), offset));
+        REQUIRE(database.find(offset, {"after"}, valueOffset));
+        REQUIRE(database.string(valueOffset, value));
+        REQUIRE(value==QString("y"));
+        REQUIRE(database.isOpen());
+    }
+
+    SECTION("a database that nests values too deeply is closed") {
+        QTemporaryFile file;
+        Database database;
+        uint32_t offset, valueOffset;
+
+        auto data = control(Type::Map, 2)+
+                    string("deep")+nested(MaximumDepth+1, string("x"))+
+                    string("after")+string("y");
+
+        REQUIRE(openDatabase(database, file, buildDatabase(data)));
+        REQUIRE(database.lookup(QHostAddress("192.0.2.1"), offset));
+        REQUIRE_FALSE(database.find(offset, {"after"}, valueOffset));
+        REQUIRE_FALSE(database.isOpen());
+        REQUIRE_FALSE(database.lookup(QHostAddress("192.0.2.1"), offset));
+    }
+}
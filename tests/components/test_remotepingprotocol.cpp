@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "RemotePingProtocol.h"
+
+#include <QDataStream>
+#include <QHostAddress>
+
+using Protocol = Nedrysoft::RemotePingEngine::RemotePingProtocol;
+
+constexpr auto MaximumFrameLength = 1024*1024;
+constexpr auto MaximumSharedRingCapacity = 1<<20;
+constexpr auto Secret = "a shared secret";
+
+static auto header(quint32 length, Protocol::MessageType type) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << length << static_cast<quint8>(type);
+
+    return buffer;
+}
+
+static auto subscriptionPayload(quint32 interval, quint32 timeout, quint16 payloadSize) -> QByteArray {
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << static_cast<quint8>(Nedrysoft::Core::IPVersion::V4) << interval << timeout << payloadSize
+           << static_cast<quint8>(0);
+
+    return buffer;
+}
+
+static auto singleShotPayload(quint8 ttl, quint32 timeout, qint32 flowIdentifier) -> QByteArray {
+    return Protocol::encodeSingleShot(Protocol::SingleShotRequest {
+        7,
+        QHostAddress("192.0.2.1"),
+        ttl,
+        static_cast<int>(timeout),
+        flowIdentifier
+    });
+}
+
+TEST_CASE("RemotePingProtocol Frame Tests", "[app][components][remoteping]") {
+    SECTION("a frame is taken whole and removed from the buffer") {
+        auto buffer = Protocol::frame(Protocol::MessageType::AddTarget, "payload");
+        auto type = Protocol::MessageType::Stop;
+        auto payload = QByteArray();
+
+        buffer += Protocol::frame(Protocol::MessageType::Start);
+
+        REQUIRE(Protocol::takeFrame(buffer, type, payload)==Protocol::FrameStatus::Complete);
+        REQUIRE(type==Protocol::MessageType::AddTarget);
+        REQUIRE(payload==QByteArray("payload"));
+
+        REQUIRE(Protocol::takeFrame(buffer, type, payload)==Protocol::FrameStatus::Complete);
+        REQUIRE(type==Protocol::MessageType::Start);
+        REQUIRE(payload.isEmpty());
+        REQUIRE(buffer.isEmpty());
+    }
+
+    SECTION("a truncated frame is left in the buffer until it is complete") {
+        auto frame = Protocol::frame(Protocol::MessageType::AddTarget, "payload");
+        auto type = Protocol::MessageType::Stop;
+        auto payload = QByteArray();
+
+        for (auto length=0;length<frame.length();length++) {
+            auto buffer = frame.left(length);
+
+            REQUIRE(Protocol::takeFrame(buffer, type, payload)==Protocol::FrameStatus::Incomplete);
+            REQUIRE(buffer==frame.left(length));
+        }
+    }
+
+    SECTION("a frame with no type is invalid") {
+        auto buffer = header(0, Protocol::MessageType::Start);
+        auto type = Protocol::MessageType::Stop;
+        auto payload = QByteArray();
+
+        REQUIRE(Protocol::takeFrame(buffer, type, payload)==Protocol::FrameStatus::Invalid);
+    }
+
+    SECTION("an oversize length is invalid before the payload arrives") {
+        auto type = Protocol::MessageType::Stop;
+        auto payload = QByteArray();
+
+        auto largest = header(MaximumFrameLength, Protocol::MessageType::Results);
+        auto oversize = header(MaximumFrameLength+1, Protocol::MessageType::Results);
+        auto maximum = header(0xffffffff, Protocol::MessageType::Results);
+
+        REQUIRE(Protocol::takeFrame(largest, type, payload)==Protocol::FrameStatus::Incomplete);
+        REQUIRE(Protocol::takeFrame(oversize, type, payload)==Protocol::FrameStatus::Invalid);
+        REQUIRE(Protocol::takeFrame(maximum, type, payload)==Protocol::FrameStatus::Invalid);
+    }
+}
+
+TEST_CASE("RemotePingProtocol Message Tests", "[app][components][remoteping]") {
+    SECTION("hello carries a challenge from the authentication version") {
+        auto challenge = Protocol::createChallenge();
+        auto version = quint16(0);
+        auto decodedChallenge = QByteArray();
+
+        REQUIRE(Protocol::decodeHello(Protocol::encodeHello(challenge), version, decodedChallenge));
+        REQUIRE(version==Protocol::Version);
+        REQUIRE(decodedChallenge==challenge);
+
+        QByteArray oldHello;
+        QDataStream stream(&oldHello, QIODevice::WriteOnly);
+
+        stream << static_cast<quint16>(Protocol::AuthenticationVersion-1);
+
+        REQUIRE(Protocol::decodeHello(oldHello, version, decodedChallenge));
+        REQUIRE(decodedChallenge.isEmpty());
+
+        REQUIRE_FALSE(Protocol::decodeHello(QByteArray(1, 0), version, decodedChallenge));
+        REQUIRE_FALSE(Protocol::decodeHello(Protocol::encodeHello(challenge).left(10), version, decodedChallenge));
+    }
+
+    SECTION("a subscription is decoded within the protocol limits") {
+        auto subscription = Protocol::Subscription {Nedrysoft::Core::IPVersion::V6, 1000, 2000, 64, true, true};
+        auto decoded = Protocol::Subscription();
+
+        REQUIRE(Protocol::decodeSubscription(Protocol::encodeSubscription(subscription), decoded));
+        REQUIRE(decoded.ipVersion==Nedrysoft::Core::IPVersion::V6);
+        REQUIRE(decoded.interval==1000);
+        REQUIRE(decoded.timeout==2000);
+        REQUIRE(decoded.payloadSize==64);
+        REQUIRE(decoded.dontFragment);
+        REQUIRE(decoded.flowStable);
+
+        REQUIRE(Protocol::decodeSubscription(subscriptionPayload(24*60*60*1000, 60*60*1000, 65507), decoded));
+    }
+
+    SECTION("a subscription outside the protocol limits is rejected") {
+        auto decoded = Protocol::Subscription();
+
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(0, 1000, 64), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(24*60*60*1000+1, 1000, 64), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(1000, 0, 64), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(1000, 60*60*1000+1, 64), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(1000, 1000, 65508), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(subscriptionPayload(1000, 1000, 64).chopped(1), decoded));
+        REQUIRE_FALSE(Protocol::decodeSubscription(QByteArray(), decoded));
+    }
+
+    SECTION("targets are decoded for each address family") {
+        auto addresses = {QHostAddress("192.0.2.1"), QHostAddress("2001:db8::1"), QHostAddress()};
+
+        for (auto &address : addresses) {
+            auto decoded = Protocol::Target();
+
+            REQUIRE(Protocol::decodeTarget(Protocol::encodeTarget(Protocol::Target {42, address, 5, 128}), decoded));
+            REQUIRE(decoded.id==42u);
+            REQUIRE(decoded.hostAddress==address);
+            REQUIRE(decoded.ttl==5);
+            REQUIRE(decoded.payloadSize==128);
+        }
+    }
+
+    SECTION("a target with a bad or truncated address is rejected") {
+        auto decoded = Protocol::Target();
+        auto payload = Protocol::encodeTarget(Protocol::Target {42, QHostAddress("2001:db8::1"), 5, 128});
+        auto familyOffset = static_cast<int>(sizeof(quint32)+sizeof(quint8)+sizeof(quint16));
+
+        for (auto length=0;length<payload.length();length++) {
+            REQUIRE_FALSE(Protocol::decodeTarget(payload.left(length), decoded));
+        }
+
+        for (auto family : {1, 5, 255}) {
+            auto badFamily = payload;
+
+            badFamily[familyOffset] = static_cast<char>(family);
+
+            REQUIRE_FALSE(Protocol::decodeTarget(badFamily, decoded));
+        }
+    }
+
+    SECTION("a target id must be complete") {
+        auto id = quint32(0);
+
+        REQUIRE(Protocol::decodeTargetId(Protocol::encodeTargetId(0xdeadbeef), id));
+        REQUIRE(id==0xdeadbeef);
+        REQUIRE_FALSE(Protocol::decodeTargetId(Protocol::encodeTargetId(1).left(3), id));
+    }
+
+    SECTION("a single shot request is decoded within the protocol limits") {
+        auto decoded = Protocol::SingleShotRequest();
+
+        REQUIRE(Protocol::decodeSingleShot(singleShotPayload(3, 1000, -1), decoded));
+        REQUIRE(decoded.id==7u);
+        REQUIRE(decoded.hostAddress==QHostAddress("192.0.2.1"));
+        REQUIRE(decoded.ttl==3);
+        REQUIRE(decoded.timeout==1000);
+        REQUIRE(decoded.flowIdentifier==-1);
+
+        REQUIRE(Protocol::decodeSingleShot(singleShotPayload(255, 60*60*1000, 0xffff), decoded));
+
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(0, 1000, 0), decoded));
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(3, 0, 0), decoded));
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(3, 60*60*1000+1, 0), decoded));
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(3, 1000, -2), decoded));
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(3, 1000, 0x10000), decoded));
+        REQUIRE_FALSE(Protocol::decodeSingleShot(singleShotPayload(3, 1000, 0).chopped(1), decoded));
+    }
+
+    SECTION("results are decoded and appended") {
+        auto records = QVector<Protocol::ResultRecord> {
+            {1, Nedrysoft::RouteAnalyser::PingResult(
+                    10,
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
+                    QHostAddress("192.0.2.1"),
+                    qint64(1600000000000000000),
+                    qint64(25000000),
+                    nullptr,
+                    3 )},
+            {2, Nedrysoft::RouteAnalyser::PingResult(
+                    11,
+                    Nedrysoft::RouteAnalyser::PingResult::ResultCode::NoReply,
+                    QHostAddress(),
+                    qint64(1600000001000000000),
+                    qint64(-1),
+                    nullptr,
+                    0 )}
+        };
+
+        auto decoded = QVector<Protocol::ResultRecord> {records.first()};
+
+        REQUIRE(Protocol::decodeResults(Protocol::encodeResults(records), decoded));
+        REQUIRE(decoded.count()==3);
+
+        for (auto index=0;index<records.count();index++) {
+            auto &expected = records.at(index).result;
+            auto &result = decoded.at(index+1).result;
+
+            REQUIRE(decoded.at(index+1).id==records.at(index).id);
+            REQUIRE(result.sampleNumber()==expected.sampleNumber());
+            REQUIRE(result.code()==expected.code());
+            REQUIRE(result.hostAddress()==expected.hostAddress());
+            REQUIRE(result.requestTimestamp()==expected.requestTimestamp());
+            REQUIRE(result.preciseRoundTripTime()==expected.preciseRoundTripTime());
+            REQUIRE(result.hops()==expected.hops());
+            REQUIRE(result.target()==nullptr);
+        }
+    }
+
+    SECTION("malformed results are rejected") {
+        auto payload = Protocol::encodeResults({{1, Nedrysoft::RouteAnalyser::PingResult(
+                10,
+                Nedrysoft::RouteAnalyser::PingResult::ResultCode::Ok,
+                QHostAddress("192.0.2.1"),
+                qint64(1600000000000000000),
+                qint64(25000000),
+                nullptr,
+                3 )}});
+
+        auto codeOffset = static_cast<int>(sizeof(quint32)*3);
+        auto decoded = QVector<Protocol::ResultRecord>();
+
+        REQUIRE_FALSE(Protocol::decodeResults(payload.chopped(1), decoded));
+
+        // a count larger than the payload could hold is refused before anything is reserved.
+
+        auto overcount = payload;
+
+        overcount[0] = static_cast<char>(0x7f);
+
+        REQUIRE_FALSE(Protocol::decodeResults(overcount, decoded));
+
+        auto badCode = payload;
+
+        badCode[codeOffset] = static_cast<char>(
+                static_cast<quint8>(Nedrysoft::RouteAnalyser::PingResult::ResultCode::Prohibited)+1);
+
+        REQUIRE_FALSE(Protocol::decodeResults(badCode, decoded));
+    }
+
+    SECTION("a shared ring capacity must be in range") {
+        auto capacity = 0;
+
+        REQUIRE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(4096), capacity));
+        REQUIRE(capacity==4096);
+
+        REQUIRE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(MaximumSharedRingCapacity), capacity));
+        REQUIRE(capacity==MaximumSharedRingCapacity);
+
+        REQUIRE_FALSE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(0), capacity));
+        REQUIRE_FALSE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(MaximumSharedRingCapacity+1), capacity));
+        REQUIRE_FALSE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(-1), capacity));
+        REQUIRE_FALSE(Protocol::decodeSharedRing(Protocol::encodeSharedRing(4096).left(3), capacity));
+    }
+
+    SECTION("the shared ring status must be present") {
+        auto attached = false;
+
+        REQUIRE(Protocol::decodeSharedRingStatus(Protocol::encodeSharedRingStatus(true), attached));
+        REQUIRE(attached);
+        REQUIRE(Protocol::decodeSharedRingStatus(Protocol::encodeSharedRingStatus(false), attached));
+        REQUIRE_FALSE(attached);
+        REQUIRE_FALSE(Protocol::decodeSharedRingStatus(QByteArray(), attached));
+    }
+}
+
+TEST_CASE("RemotePingProtocol Authentication Tests", "[app][components][remoteping]") {
+    auto challenge = Protocol::createChallenge();
+    auto answer = Protocol::encodeAuthentication(Secret, challenge);
+
+    SECTION("the answer of a client that knows the secret is accepted") {
+        REQUIRE(answer.length()==32);
+        REQUIRE(Protocol::verifyAuthentication(answer, Secret, challenge));
+    }
+
+    SECTION("challenges are not repeated") {
+        REQUIRE(challenge.length()==32);
+        REQUIRE(Protocol::createChallenge()!=challenge);
+    }
+
+    SECTION("a wrong answer is rejected") {
+        REQUIRE_FALSE(Protocol::verifyAuthentication(
+                Protocol::encodeAuthentication("another secret", challenge),
+                Secret,
+                challenge ));
+
+        REQUIRE_FALSE(Protocol::verifyAuthentication(answer, Secret, Protocol::createChallenge()));
+
+        for (auto index=0;index<answer.length();index++) {
+            auto wrong = answer;
+
+            wrong[index] = static_cast<char>(wrong.at(index)^0x01);
+
+            REQUIRE_FALSE(Protocol::verifyAuthentication(wrong, Secret, challenge));
+        }
+    }
+
+    SECTION("a short or long answer is rejected") {
+        REQUIRE_FALSE(Protocol::verifyAuthentication(QByteArray(), Secret, challenge));
+        REQUIRE_FALSE(Protocol::verifyAuthentication(answer.left(answer.length()-1), Secret, challenge));
+        REQUIRE_FALSE(Protocol::verifyAuthentication(answer.left(1), Secret, challenge));
+        REQUIRE_FALSE(Protocol::verifyAuthentication(answer+'\0', Secret, challenge));
+    }
+
+    SECTION("an empty secret or challenge never authenticates") {
+        REQUIRE_FALSE(Protocol::verifyAuthentication(Protocol::encodeAuthentication("", challenge), "", challenge));
+        REQUIRE_FALSE(Protocol::verifyAuthentication(
+                Protocol::encodeAuthentication(Secret, QByteArray()),
+                Secret,
+                QByteArray() ));
+    }
+}
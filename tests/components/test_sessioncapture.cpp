@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2020 Adrian Carpenter
+ *
+ * This file is part of Pingnoo (https://github.com/nedrysoft/pingnoo)
+ *
+ * An open-source cross-platform traceroute analyser.
+ *
+ * Created by Adrian Carpenter on 27/03/2020.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+#include "PingResult.h"
+#include "SessionCapture.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+using CaptureReader = Nedrysoft::RouteAnalyser::CaptureReader;
+using CaptureSample = Nedrysoft::RouteAnalyser::CaptureSample;
+using CaptureWriter = Nedrysoft::RouteAnalyser::CaptureWriter;
+using PingResult = Nedrysoft::RouteAnalyser::PingResult;
+using ResultCode = Nedrysoft::RouteAnalyser::PingResult::ResultCode;
+
+constexpr auto StartTime = qint64(1600000000)*1000000000;
+constexpr auto SampleInterval = qint64(1000000);
+constexpr auto HopCount = 3;
+constexpr auto BlockRecords = 4096;
+
+/**
+ * returns the result that the capture is expected to hold for a sample, the times are whole microseconds as
+ * that is the resolution of the capture.
+ */
+static auto testSample(int index) -> CaptureSample {
+    auto hop = (index%HopCount)+1;
+    auto code = (index%7) ? ((hop==HopCount) ? ResultCode::Ok : ResultCode::TimeExceeded) : ResultCode::NoReply;
+    auto roundTripTime = (code==ResultCode::NoReply) ? qint64(-1) : qint64(1000)*(1000+(index%500));
+
+    return CaptureSample{StartTime+(index*SampleInterval), roundTripTime, hop, code};
+}
+
+static auto testResult(const CaptureSample &sample) -> PingResult {
+    return PingResult(
+        0,
+        sample.code,
+        QHostAddress("192.0.2.1"),
+        sample.requestTimestamp,
+        sample.roundTripTime,
+        nullptr,
+        sample.hop );
+}
+
+static auto openCapture(CaptureWriter &writer, const QString &filename) -> bool {
+    return writer.open(
+        filename,
+        "example.com",
+        Nedrysoft::Core::IPVersion::V4,
+        1000,
+        QHostAddress("192.0.2.1"),
+        {QHostAddress("198.51.100.1"), QHostAddress(), QHostAddress("192.0.2.1")} );
+}
+
+static auto readSamples(const CaptureReader &reader) -> QVector<CaptureSample> {
+    auto samples = QVector<CaptureSample>();
+
+    for (auto block=0;block<reader.blockCount();block++) {
+        auto blockSamples = QVector<CaptureSample>();
+
+        REQUIRE(reader.readBlock(block, blockSamples));
+
+        samples.append(blockSamples);
+    }
+
+    return samples;
+}
+
+static auto sameSample(const CaptureSample &first, const CaptureSample &second) -> bool {
+    return (first.requestTimestamp==second.requestTimestamp) &&
+           (first.roundTripTime==second.roundTripTime) &&
+           (first.hop==second.hop) &&
+           (first.code==second.code);
+}
+
+TEST_CASE("SessionCapture Tests", "[app][components][storage]") {
+    QTemporaryDir directory;
+
+    REQUIRE(directory.isValid());
+
+    auto filename = directory.filePath("session.pngcap");
+
+    SECTION("header and samples round trip across blocks") {
+        constexpr auto SampleCount = BlockRecords+100;
+
+        {
+            CaptureWriter writer;
+
+            REQUIRE(openCapture(writer, filename));
+
+            for (auto index=0;index<SampleCount;index++) {
+                writer.append(testSample(index).hop, testResult(testSample(index)));
+            }
+
+            writer.close();
+
+            REQUIRE_FALSE(writer.isOpen());
+        }
+
+        CaptureReader reader;
+
+        REQUIRE(reader.open(filename));
+        REQUIRE(reader.target()==QString("example.com"));
+        REQUIRE(reader.ipVersion()==Nedrysoft::Core::IPVersion::V4);
+        REQUIRE(reader.interval()==1000);
+        REQUIRE(reader.routeHostAddress()==QHostAddress("192.0.2.1"));
+        REQUIRE(reader.route().count()==3);
+        REQUIRE(reader.route().at(0)==QHostAddress("198.51.100.1"));
+        REQUIRE(reader.route().at(1).isNull());
+
+        REQUIRE(reader.blockCount()==2);
+        REQUIRE(reader.startTime()==testSample(0).requestTimestamp);
+        REQUIRE(reader.endTime()==testSample(SampleCount-1).requestTimestamp);
+
+        auto samples = readSamples(reader);
+
+        REQUIRE(samples.count()==SampleCount);
+
+        for (auto index=0;index<SampleCount;index++) {
+            REQUIRE(sameSample(samples.at(index), testSample(index)));
+        }
+    }
+
+    SECTION("a capture without samples has no blocks") {
+        {
+            CaptureWriter writer;
+
+            REQUIRE(openCapture(writer, filename));
+
+            writer.close();
+        }
+
+        CaptureReader reader;
+        QVector<CaptureSample> samples;
+
+        REQUIRE(reader.open(filename));
+        REQUIRE(reader.blockCount()==0);
+        REQUIRE(reader.startTime()==0);
+        REQUIRE(reader.endTime()==0);
+        REQUIRE(reader.lowerBound(StartTime)==0);
+        REQUIRE_FALSE(reader.readBlock(0, samples));
+        REQUIRE(samples.isEmpty());
+    }
+
+    SECTION("results for hops outside the capture range are ignored") {
+        {
+            CaptureWriter writer;
+
+            REQUIRE(openCapture(writer, filename));
+
+            writer.append(0, testResult(testSample(0)));
+            writer.append(256, testResult(testSample(1)));
+            writer.append(255, testResult(testSample(2)));
+
+            writer.close();
+        }
+
+        CaptureReader reader;
+
+        REQUIRE(reader.open(filename));
+
+        auto samples = readSamples(reader);
+
+        REQUIRE(samples.count()==1);
+        REQUIRE(samples.at(0).hop==255);
+    }
+
+    SECTION("out of order results and large gaps are kept") {
+        auto first = testSample(10);
+        auto earlier = testSample(5);
+        auto later = testSample(20);
+
+        // a gap larger than a record can hold starts a new block.
+
+        later.requestTimestamp += qint64(3600)*1000000000;
+
+        {
+            CaptureWriter writer;
+
+            REQUIRE(openCapture(writer, filename));
+
+            writer.append(first.hop, testResult(first));
+            writer.append(earlier.hop, testResult(earlier));
+            writer.append(later.hop, testResult(later));
+
+            writer.close();
+        }
+
+        CaptureReader reader;
+
+        REQUIRE(reader.open(filename));
+        REQUIRE(reader.blockCount()==2);
+        REQUIRE(reader.blockStartTime(0)==earlier.requestTimestamp);
+        REQUIRE(reader.blockEndTime(0)==first.requestTimestamp);
+
+        auto samples = readSamples(reader);
+
+        REQUIRE(samples.count()==3);
+        REQUIRE(sameSample(samples.at(0), first));
+        REQUIRE(sameSample(samples.at(1), earlier));
+        REQUIRE(sameSample(samples.at(2), later));
+
+        REQUIRE(reader.lowerBound(0)==0);
+        REQUIRE(reader.lowerBound(first.requestTimestamp)==0);
+        REQUIRE(reader.lowerBound(first.requestTimestamp+1)==1);
+        REQUIRE(reader.lowerBound(later.requestTimestamp+1)==reader.blockCount());
+    }
+
+    SECTION("a capture that was not closed is read up to its last synced block") {
+        CaptureWriter writer;
+
+        REQUIRE(openCapture(writer, filename));
+
+        for (auto index=0;index<10;index++) {
+            writer.append(testSample(index).hop, testResult(testSample(index)));
+        }
+
+        REQUIRE(writer.sync());
+
+        // the records after the sync have not been written as a block.
+
+        writer.append(testSample(10).hop, testResult(testSample(10)));
+
+        CaptureReader reader;
+
+        REQUIRE(reader.open(filename));
+        REQUIRE(reader.blockCount()==1);
+
+        auto samples = readSamples(reader);
+
+        REQUIRE(samples.count()==10);
+        REQUIRE(sameSample(samples.last(), testSample(9)));
+    }
+
+    SECTION("files that are not captures are rejected") {
+        CaptureReader missingReader;
+
+        REQUIRE_FALSE(missingReader.open(directory.filePath("missing.pngcap")));
+
+        QFile file(filename);
+
+        REQUIRE(file.open(QIODevice::WriteOnly));
+
+        file.write("PNGCAP01");
+        file.close();
+
+        CaptureReader truncatedReader;
+
+        REQUIRE_FALSE(truncatedReader.open(filename));
+
+        REQUIRE(file.open(QIODevice::WriteOnly));
+
+        file.write(QByteArray(64, 'x'));
+        file.close();
+
+        CaptureReader invalidReader;
+
+        REQUIRE_FALSE(invalidReader.open(filename));
+    }
+}
@@ -23,9 +23,14 @@
 
 #include "catch.hpp"
 #include "ICMPPacket/ICMPPacket.h"
+#include "ICMPPacket/ICMPPacketCodec.h"
+#include "ICMPPacket/ICMPPacketTemplate.h"
+#include "ICMPPacket/ProbePacketTemplate.h"
 
 #include <QString>
 #include <QHostAddress>
+#include <QtEndian>
+#include <cstring>
 
 TEST_CASE("ICMPPacket Tests", "[app][libs][network]") {
     QByteArray testData = QString("This Is A Test Of The ICMP Checksum Routine").toLatin1();
@@ -33,6 +38,283 @@ TEST_CASE("ICMPPacket Tests", "[app][libs][network]") {
     SECTION("checksum produces correct result") {
         auto checksum = Nedrysoft::ICMPPacket::ICMPPacket::checksum(testData.data(), testData.length());
 
-        REQUIRE_MESSAGE(checksum==0x38D1, "ICMP checksum was calculated incorrectly.");
+        REQUIRE_MESSAGE(checksum==0x386C, "ICMP checksum was calculated incorrectly.");
+    }
+
+    SECTION("checksum pads a trailing odd byte with zero") {
+        constexpr auto ChecksumOffset = 2;
+
+        for (auto length : {1, 3, 15, 17, 33, 1023}) {
+            auto oddData = QByteArray(length, 0);
+
+            for (auto index=0;index<length;index++) {
+                oddData[index] = static_cast<char>(0xa5 ^ (index * 7));
+            }
+
+            auto paddedData = oddData + QByteArray(1, 0);
+
+            REQUIRE(Nedrysoft::ICMPPacket::ICMPPacket::checksum(oddData.data(), oddData.length()) ==
+                    Nedrysoft::ICMPPacket::ICMPPacket::checksum(paddedData.data(), paddedData.length()));
+        }
+
+        auto packet = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            0x1234,
+            1,
+            53,
+            QHostAddress(),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        REQUIRE(packet.length()%2==1);
+
+        packet[packet.length()-1] = static_cast<char>(0xff);
+
+        memset(packet.data()+ChecksumOffset, 0, sizeof(uint16_t));
+
+        auto checksum = Nedrysoft::ICMPPacket::ICMPPacket::checksum(packet.data(), packet.length());
+
+        memcpy(packet.data()+ChecksumOffset, &checksum, sizeof(checksum));
+
+        REQUIRE_MESSAGE(Nedrysoft::ICMPPacket::ICMPPacket::checksum(packet.data(), packet.length())==0,
+                        "odd length packet does not verify.");
+    }
+
+    SECTION("incremental checksum update matches a full recalculation") {
+        constexpr auto ChecksumOffset = 2;
+        constexpr auto SequenceOffset = 6;
+
+        auto firstPacket = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            0x1234,
+            1,
+            52,
+            QHostAddress(),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        auto secondPacket = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            0x1234,
+            0xabcd,
+            52,
+            QHostAddress(),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        uint16_t checksum, oldSequence, newSequence, expectedChecksum;
+
+        memcpy(&checksum, firstPacket.constData()+ChecksumOffset, sizeof(checksum));
+        memcpy(&oldSequence, firstPacket.constData()+SequenceOffset, sizeof(oldSequence));
+        memcpy(&newSequence, secondPacket.constData()+SequenceOffset, sizeof(newSequence));
+        memcpy(&expectedChecksum, secondPacket.constData()+ChecksumOffset, sizeof(expectedChecksum));
+
+        auto updatedChecksum = Nedrysoft::ICMPPacket::ICMPPacket::updateChecksum(checksum, oldSequence, newSequence);
+
+        REQUIRE_MESSAGE(updatedChecksum==expectedChecksum, "ICMP checksum was updated incorrectly.");
+    }
+
+    SECTION("balanced echo requests keep the flow checksum and remain valid") {
+        constexpr auto ChecksumOffset = 2;
+        constexpr uint16_t FlowChecksum = 0x5041;
+
+        for (uint16_t sequence : {1, 0x7fff, 0xfffe}) {
+            auto packet = Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+                0x1234,
+                sequence,
+                52,
+                QHostAddress(),
+                Nedrysoft::ICMPPacket::V4
+            );
+
+            REQUIRE(Nedrysoft::ICMPPacket::ICMPPacketTemplate::balance(packet, FlowChecksum));
+
+            uint16_t checksum;
+
+            memcpy(&checksum, packet.constData()+ChecksumOffset, sizeof(checksum));
+
+            REQUIRE_MESSAGE(qFromBigEndian<uint16_t>(checksum)==FlowChecksum, "flow checksum was not applied.");
+
+            REQUIRE_MESSAGE(Nedrysoft::ICMPPacket::ICMPPacket::checksum(packet.data(), packet.length())==0,
+                            "balanced packet does not verify.");
+        }
+    }
+
+    SECTION("view decoder extracts id and sequence from an echo reply") {
+        const uint8_t echoReply[] = {
+            0x45, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x37, 0x01, 0x00, 0x00,
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01,
+            0x00, 0x00, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78
+        };
+
+        auto packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+            echoReply,
+            sizeof(echoReply),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::EchoReply);
+        REQUIRE(packet.id()==0x1234);
+        REQUIRE(packet.sequence()==0x5678);
+        REQUIRE(packet.ttl()==0x37);
+
+        auto truncatedPacket = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+            echoReply,
+            sizeof(echoReply)-1,
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        REQUIRE(truncatedPacket.resultCode()==Nedrysoft::ICMPPacket::Invalid);
+    }
+
+    SECTION("udp probe carries the sequence as a valid checksum and is matched from a port unreachable") {
+        constexpr auto UDPChecksumOffset = 6;
+
+        auto probeTemplate = Nedrysoft::ICMPPacket::ProbePacketTemplate(
+            Nedrysoft::ICMPPacket::UDP,
+            0x8123,
+            33434,
+            20,
+            QHostAddress("127.0.0.1"),
+            QHostAddress("127.0.0.1"),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        auto probe = probeTemplate.packet(0x5678);
+
+        REQUIRE(probe.length()==28);
+        REQUIRE(static_cast<uint8_t>(probe.at(UDPChecksumOffset))==0x56);
+        REQUIRE(static_cast<uint8_t>(probe.at(UDPChecksumOffset+1))==0x78);
+
+        const uint8_t pseudoHeader[] = {
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0x00, 0x11, 0x00, 0x1c
+        };
+
+        auto checksumBuffer = QByteArray(reinterpret_cast<const char *>(pseudoHeader), sizeof(pseudoHeader)) + probe;
+
+        REQUIRE_MESSAGE(
+            Nedrysoft::ICMPPacket::ICMPPacket::checksum(checksumBuffer.data(), checksumBuffer.length())==0,
+            "UDP probe checksum is invalid."
+        );
+
+        const uint8_t portUnreachable[] = {
+            0x45, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00,
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01,
+            0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x45, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x01, 0x11, 0x00, 0x00,
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01
+        };
+
+        auto reply = QByteArray(reinterpret_cast<const char *>(portUnreachable), sizeof(portUnreachable)) + probe.left(8);
+
+        auto packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(reply, Nedrysoft::ICMPPacket::V4);
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::PortUnreachable);
+        REQUIRE(packet.protocol()==Nedrysoft::ICMPPacket::UDP);
+        REQUIRE(packet.id()==0x8123);
+        REQUIRE(packet.sequence()==0x5678);
+    }
+
+    SECTION("icmp errors are matched to the echo request they quote") {
+        const uint8_t hostUnreachable[] = {
+            0x45, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00,
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01,
+            0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x45, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00,
+            0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01,
+            0x08, 0x00, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78
+        };
+
+        auto packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+            hostUnreachable,
+            sizeof(hostUnreachable),
+            Nedrysoft::ICMPPacket::V4
+        );
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::DestinationUnreachable);
+        REQUIRE(packet.id()==0x1234);
+        REQUIRE(packet.sequence()==0x5678);
+
+        uint8_t prohibited[sizeof(hostUnreachable)];
+
+        memcpy(prohibited, hostUnreachable, sizeof(prohibited));
+
+        prohibited[21] = 13;
+
+        packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(prohibited, sizeof(prohibited), Nedrysoft::ICMPPacket::V4);
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::AdministrativelyProhibited);
+        REQUIRE(packet.id()==0x1234);
+
+        // an echo request cannot be answered with a port unreachable.
+
+        prohibited[21] = 3;
+
+        packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(prohibited, sizeof(prohibited), Nedrysoft::ICMPPacket::V4);
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::Invalid);
+
+        uint8_t packetTooBig[8+40+8] = {
+            0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0xdc
+        };
+
+        packetTooBig[8] = 0x60;
+        packetTooBig[8+6] = 58;
+        packetTooBig[8+40] = 128;
+        packetTooBig[8+40+4] = 0x12;
+        packetTooBig[8+40+5] = 0x34;
+        packetTooBig[8+40+6] = 0x56;
+        packetTooBig[8+40+7] = 0x78;
+
+        packet = Nedrysoft::ICMPPacket::ICMPPacket::fromData(
+            packetTooBig,
+            sizeof(packetTooBig),
+            Nedrysoft::ICMPPacket::V6
+        );
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::PacketTooBig);
+        REQUIRE(packet.id()==0x1234);
+        REQUIRE(packet.sequence()==0x5678);
+    }
+
+    SECTION("the specialised codecs decode what they encode") {
+        constexpr auto IPv4HeaderLength = 20;
+
+        auto request = Nedrysoft::ICMPPacket::ICMPv4Codec::encode(0x1234, 0x5678, 16, QHostAddress("127.0.0.1"));
+
+        REQUIRE(request==Nedrysoft::ICMPPacket::ICMPPacket::pingPacket(
+            0x1234,
+            0x5678,
+            16,
+            QHostAddress("127.0.0.1"),
+            Nedrysoft::ICMPPacket::V4 ));
+
+        auto reply = QByteArray(IPv4HeaderLength, 0) + request;
+
+        reply[0] = 0x45;
+        reply[8] = 64;
+        reply[IPv4HeaderLength] = 0;
+
+        auto packet = Nedrysoft::ICMPPacket::ICMPv4Codec::decode(reply);
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::EchoReply);
+        REQUIRE(packet.id()==0x1234);
+        REQUIRE(packet.sequence()==0x5678);
+        REQUIRE(packet.ttl()==64);
+
+        // raw ICMPv6 sockets do not deliver the ip header, so the reply starts at the ICMPv6 header.
+
+        reply = Nedrysoft::ICMPPacket::ICMPv6Codec::encode(0x1234, 0x5678, 16, QHostAddress("::1"));
+
+        reply[0] = static_cast<char>(129);
+
+        packet = Nedrysoft::ICMPPacket::ICMPv6Codec::decode(reply);
+
+        REQUIRE(packet.resultCode()==Nedrysoft::ICMPPacket::EchoReply);
+        REQUIRE(packet.id()==0x1234);
+        REQUIRE(packet.sequence()==0x5678);
+        REQUIRE(packet.ttl()==-1);
+
+        // a truncated ipv4 header is rejected rather than read past the end of the buffer.
+
+        REQUIRE(Nedrysoft::ICMPPacket::ICMPv4Codec::decode(reply.left(8)).resultCode()==
+                Nedrysoft::ICMPPacket::Invalid);
     }
 }
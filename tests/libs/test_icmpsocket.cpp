@@ -23,7 +23,10 @@
 
 #include "catch.hpp"
 #include "ICMPSocket/ICMPSocket.h"
+#include "ICMPSocket/ICMPSocketClock.h"
 
+#include <QDateTime>
+#include <QHostAddress>
 #include <QString>
 
 TEST_CASE("ICMPSocket Tests", "[app][libs][network]") {
@@ -41,4 +44,42 @@ TEST_CASE("ICMPSocket Tests", "[app][libs][network]") {
 
         REQUIRE_MESSAGE(writeSocket!=nullptr, "Unable to create a IPv4 ICMP write socket.");
     }
+
+    SECTION("check the clock is monotonic and anchored to the system clock") {
+        auto firstTime = Nedrysoft::ICMPSocket::ICMPSocketClock::now();
+        auto secondTime = Nedrysoft::ICMPSocket::ICMPSocketClock::now();
+
+        REQUIRE(secondTime>=firstTime);
+
+        auto systemTime = QDateTime::currentMSecsSinceEpoch()*1000000;
+
+        REQUIRE(qAbs(Nedrysoft::ICMPSocket::ICMPSocketClock::now()-systemTime)<1000000000);
+        REQUIRE(qAbs(Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(systemTime)-secondTime)<1000000000);
+        REQUIRE(Nedrysoft::ICMPSocket::ICMPSocketClock::fromSystemTime(-1)==-1);
+    }
+
+    SECTION("check socket addresses convert without loss") {
+        for (auto address : {QString("192.0.2.1"), QString("2001:db8::1")}) {
+            auto hostAddress = QHostAddress(address);
+            auto socketAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(hostAddress);
+
+            REQUIRE(socketAddress.toHostAddress()==hostAddress);
+
+            sockaddr_storage platformAddress;
+
+            REQUIRE(socketAddress.toSocketAddress(platformAddress)>0);
+
+            auto convertedAddress = Nedrysoft::ICMPSocket::SocketAddress::fromSocketAddress(
+                reinterpret_cast<sockaddr *>(&platformAddress) );
+
+            REQUIRE(convertedAddress==socketAddress);
+            REQUIRE(qHash(convertedAddress)==qHash(socketAddress));
+        }
+
+        auto firstAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(QHostAddress("192.0.2.1"));
+        auto secondAddress = Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(QHostAddress("192.0.2.2"));
+
+        REQUIRE(firstAddress!=secondAddress);
+        REQUIRE(Nedrysoft::ICMPSocket::SocketAddress::fromHostAddress(QHostAddress()).isNull());
+    }
 }